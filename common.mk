@@ -17,6 +17,18 @@ if USE_POSTGRES
 AM_CPPFLAGS += -DUSE_POSTGRES=1 $(libpq_CFLAGS)
 endif # USE_POSTGRES
 
+if USE_ZSTD
+AM_CPPFLAGS += -DUSE_ZSTD=1 $(libzstd_CFLAGS)
+endif # USE_ZSTD
+
+if USE_CURL
+AM_CPPFLAGS += -DUSE_CURL=1 $(libcurl_CFLAGS)
+endif # USE_CURL
+
+if USE_ZLIB
+AM_CPPFLAGS += -DUSE_ZLIB=1 $(zlib_CFLAGS)
+endif # USE_ZLIB
+
 if ENABLE_NEXT_PROTOCOL_VERSION_UNSAFE_FOR_PRODUCTION
 AM_CPPFLAGS += -I"$(top_builddir)/src/protocol-next"
 else
@@ -454,6 +454,8 @@ class bloom_filter
             {
                 bit_table_[i] |= f.bit_table_[i];
             }
+
+            inserted_element_count_ += f.inserted_element_count_;
         }
 
         return *this;
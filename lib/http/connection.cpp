@@ -64,8 +64,17 @@ connection::do_read()
             }
             else if (result == request_parser::good)
             {
-                request_handler_.handle_request(request_, reply_);
-                do_write();
+                // The reply may be ready on another thread, and is written
+                // from the thread running the socket
+                request_handler_.handle_request_async(
+                    request_, [this, self](reply rep) {
+                        asio::post(socket_.get_executor(),
+                                   [this, self,
+                                    rep = std::move(rep)]() mutable {
+                                       reply_ = std::move(rep);
+                                       do_write();
+                                   });
+                    });
             }
             else
             {
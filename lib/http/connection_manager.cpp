@@ -22,23 +22,33 @@ connection_manager::connection_manager()
 void
 connection_manager::start(connection_ptr c)
 {
-    connections_.insert(c);
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        connections_.insert(c);
+    }
     c->start();
 }
 
 void
 connection_manager::stop(connection_ptr c)
 {
-    connections_.erase(c);
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        connections_.erase(c);
+    }
     c->stop();
 }
 
 void
 connection_manager::stop_all()
 {
-    for (auto c : connections_)
+    std::set<connection_ptr> connections;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        connections.swap(connections_);
+    }
+    for (auto c : connections)
         c->stop();
-    connections_.clear();
 }
 
 } // namespace server
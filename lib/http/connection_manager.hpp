@@ -11,6 +11,7 @@
 #ifndef HTTP_CONNECTION_MANAGER_HPP
 #define HTTP_CONNECTION_MANAGER_HPP
 
+#include <mutex>
 #include <set>
 #include "connection.hpp"
 
@@ -38,7 +39,9 @@ public:
   void stop_all();
 
 private:
-  /// The managed connections.
+  /// The managed connections, which connections of a server run by several
+  /// threads add and remove concurrently.
+  std::mutex mutex_;
   std::set<connection_ptr> connections_;
 };
 
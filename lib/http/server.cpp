@@ -8,6 +8,7 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "server.hpp"
+#include <future>
 #include <signal.h>
 #include <utility>
 #include <sstream>
@@ -57,6 +58,19 @@ server::addRoute(const std::string& routeName, routeHandler callback)
     mRoutes[routeName] = callback;
 }
 
+void
+server::addAsyncRoute(const std::string& routeName, asyncRouteHandler callback)
+{
+    mAsyncRoutes[routeName] = callback;
+}
+
+void
+server::setContentType(const std::string& routeName,
+                       const std::string& contentType)
+{
+    mContentTypes[routeName] = contentType;
+}
+
 void
 server::do_accept()
 {
@@ -87,12 +101,24 @@ server::~server()
 
 void
 server::handle_request(const request& req, reply& rep)
+{
+    // Async routes may complete on another thread
+    std::promise<reply> done;
+    auto res = done.get_future();
+    handle_request_async(req,
+                         [&done](reply r) { done.set_value(std::move(r)); });
+    rep = res.get();
+}
+
+void
+server::handle_request_async(const request& req,
+                             std::function<void(reply)> done)
 {
     // Decode url to path.
     std::string request_path;
     if (!url_decode(req.uri, request_path))
     {
-        rep = reply::stock_reply(reply::bad_request);
+        done(reply::stock_reply(reply::bad_request));
         return;
     }
 
@@ -110,36 +136,55 @@ server::handle_request(const request& req, reply& rep)
         params = request_path.substr(pos);
     }
 
+    auto type = mContentTypes.find(command);
+    std::string contentType =
+        type != mContentTypes.end() ? type->second : "application/json";
+    auto okReply = [contentType](std::string content) {
+        reply rep;
+        rep.content = std::move(content);
+        rep.status = reply::ok;
+        rep.headers.resize(2);
+        rep.headers[0].name = "Content-Length";
+        rep.headers[0].value = std::to_string(rep.content.size());
+        rep.headers[1].name = "Content-Type";
+        rep.headers[1].value = contentType;
+        return rep;
+    };
+
     auto it = mRoutes.find(command);
     if (it != mRoutes.end())
     {
+        std::string content;
+        it->second(params, content);
+        done(okReply(std::move(content)));
+        return;
+    }
+
+    auto asyncIt = mAsyncRoutes.find(command);
+    if (asyncIt != mAsyncRoutes.end())
+    {
+        asyncIt->second(params, [okReply, done](const std::string& content) {
+            done(okReply(content));
+        });
+        return;
+    }
+
+    it = mRoutes.find("404");
+    if (it != mRoutes.end())
+    {
+        reply rep;
         it->second(params, rep.content);
 
-        rep.status = reply::ok;
+        rep.status = reply::not_found;
         rep.headers.resize(2);
         rep.headers[0].name = "Content-Length";
         rep.headers[0].value = std::to_string(rep.content.size());
         rep.headers[1].name = "Content-Type";
-        rep.headers[1].value = "application/json";
-    }
-    else
+        rep.headers[1].value = "text/html";
+        done(std::move(rep));
+    } else
     {
-        it = mRoutes.find("404");
-        if (it != mRoutes.end())
-        {
-            it->second(params, rep.content);
-
-            rep.status = reply::not_found;
-            rep.headers.resize(2);
-            rep.headers[0].name = "Content-Length";
-            rep.headers[0].value = std::to_string(rep.content.size());
-            rep.headers[1].name = "Content-Type";
-            rep.headers[1].value = "text/html";
-        } else
-        {
-            rep = reply::stock_reply(reply::not_found);
-            return;
-        }
+        done(reply::stock_reply(reply::not_found));
     }
 }
 
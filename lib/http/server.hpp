@@ -30,6 +30,11 @@ class server
 
 public:
     typedef std::function<void(const std::string&, std::string&)> routeHandler;
+    /// Async routes reply by calling the callback they are given with the
+    /// content, from any thread, once done.
+    typedef std::function<void(const std::string&)> replyCallback;
+    typedef std::function<void(const std::string&, replyCallback)>
+        asyncRouteHandler;
     server(const server&) = delete;
     server& operator=(const server&) = delete;
 
@@ -43,9 +48,20 @@ public:
 
     void addRoute(const std::string& routeName, routeHandler callback);
     void add404(routeHandler callback);
+    void addAsyncRoute(const std::string& routeName,
+                       asyncRouteHandler callback);
 
+    /// Content type of the replies of a route, JSON by default.
+    void setContentType(const std::string& routeName,
+                        const std::string& contentType);
+
+    /// Blocks until the reply is ready, even for async routes.
     void handle_request(const request& req, reply& rep);
 
+    /// Calls `done` with the reply, from the thread completing the route.
+    void handle_request_async(const request& req,
+                              std::function<void(reply)> done);
+
     static void parseParams(const std::string& params, std::map<std::string, std::string>& retMap);
 
 private:
@@ -72,6 +88,8 @@ private:
     asio::ip::tcp::socket socket_;
 
     std::map<std::string, routeHandler> mRoutes;
+    std::map<std::string, asyncRouteHandler> mAsyncRoutes;
+    std::map<std::string, std::string> mContentTypes;
 };
 
 } // namespace server
@@ -0,0 +1,422 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BlockCompressedBucket.h"
+#include "crypto/SHA.h"
+#include "util/GlobalChecks.h"
+#include "util/Tracing.h"
+#include "util/XDRStream.h"
+#include "util/types.h"
+#include "xdrpp/marshal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fmt/format.h>
+#include <memory>
+#include <stdexcept>
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace stellar
+{
+
+namespace
+{
+constexpr char MAGIC[] = {'S', 'B', 'K', 'C'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr uint32_t CODEC_NONE = 0;
+constexpr uint32_t CODEC_ZSTD = 1;
+constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 4 + 4;
+constexpr size_t INDEX_ENTRY_SIZE = 8 + 8 + 4 + 4;
+constexpr size_t FOOTER_SIZE = 8 + 4 + 8 + sizeof(MAGIC);
+
+#ifdef USE_ZSTD
+constexpr uint32_t WRITE_CODEC = CODEC_ZSTD;
+
+struct CCtxDeleter
+{
+    void
+    operator()(ZSTD_CCtx* ctx) const
+    {
+        ZSTD_freeCCtx(ctx);
+    }
+};
+
+struct DCtxDeleter
+{
+    void
+    operator()(ZSTD_DCtx* ctx) const
+    {
+        ZSTD_freeDCtx(ctx);
+    }
+};
+
+ZSTD_CCtx*
+getCCtx()
+{
+    thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> ctx(ZSTD_createCCtx());
+    return ctx.get();
+}
+
+ZSTD_DCtx*
+getDCtx()
+{
+    thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx(ZSTD_createDCtx());
+    return ctx.get();
+}
+#else
+constexpr uint32_t WRITE_CODEC = CODEC_NONE;
+#endif
+
+void
+putUint(std::ostream& out, uint64_t v, size_t bytes)
+{
+    for (size_t i = bytes; i > 0; --i)
+    {
+        out.put(static_cast<char>((v >> ((i - 1) * 8)) & 0xff));
+    }
+}
+
+uint64_t
+getUint(char const* buf, size_t bytes)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        v = (v << 8) | static_cast<uint8_t>(buf[i]);
+    }
+    return v;
+}
+
+// Returns the compressed block, or nothing if compressing doesn't make it
+// smaller, in which case the block is stored as is
+std::vector<char>
+compressBlock(std::vector<char> const& block)
+{
+    ZoneScoped;
+#ifdef USE_ZSTD
+    std::vector<char> out(ZSTD_compressBound(block.size()));
+    size_t res = ZSTD_compressCCtx(getCCtx(), out.data(), out.size(),
+                                   block.data(), block.size(),
+                                   ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(res))
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("bucket block compression failed: {}"),
+            ZSTD_getErrorName(res)));
+    }
+    if (res < block.size())
+    {
+        out.resize(res);
+        return out;
+    }
+#endif
+    return {};
+}
+
+void
+decompressBlock(uint32_t codec, char const* data, size_t size,
+                std::vector<char>& out)
+{
+    ZoneScoped;
+    if (codec != CODEC_ZSTD)
+    {
+        throw std::runtime_error("bad block-compressed bucket codec");
+    }
+#ifdef USE_ZSTD
+    size_t res = ZSTD_decompressDCtx(getDCtx(), out.data(), out.size(), data,
+                                     size);
+    if (ZSTD_isError(res) || res != out.size())
+    {
+        throw std::runtime_error("corrupt block-compressed bucket block");
+    }
+#else
+    throw std::runtime_error(
+        "block-compressed bucket needs stellar-core built with zstd");
+#endif
+}
+
+// Decodes the record at `pos` of `data`, returning the offset past it
+size_t
+readRecord(std::vector<char> const& data, size_t pos, BucketEntry& out)
+{
+    if (pos + 4 > data.size())
+    {
+        throw std::runtime_error("malformed block-compressed bucket block");
+    }
+    char szBuf[4];
+    std::memcpy(szBuf, data.data() + pos, 4);
+    size_t end = pos + 4 + XDRInputFileStream::getXDRSize(szBuf);
+    if (end > data.size())
+    {
+        throw std::runtime_error("malformed block-compressed bucket block");
+    }
+    xdr::xdr_get g(data.data() + pos + 4, data.data() + end);
+    xdr::xdr_argpack_archive(g, out);
+    return end;
+}
+}
+
+BlockCompressedBucketStats
+writeBlockCompressedBucket(std::filesystem::path const& rawFilename,
+                           std::filesystem::path const& filename,
+                           size_t blockSize)
+{
+    ZoneScoped;
+    releaseAssert(blockSize > 0);
+    std::ifstream in(rawFilename, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("unable to open bucket file {}"), rawFilename.string()));
+    }
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("unable to open {}"), filename.string()));
+    }
+    out.exceptions(std::ios::failbit | std::ios::badbit);
+
+    out.write(MAGIC, sizeof(MAGIC));
+    putUint(out, FORMAT_VERSION, 4);
+    putUint(out, WRITE_CODEC, 4);
+
+    SHA256 hasher;
+    std::vector<BlockCompressedBucketBlock> blocks;
+    std::vector<char> block;
+    uint64_t blockRawOffset = 0;
+    uint64_t rawOffset = 0;
+    uint64_t fileOffset = HEADER_SIZE;
+    auto flush = [&]() {
+        if (block.empty())
+        {
+            return;
+        }
+        auto compressed = compressBlock(block);
+        auto const& stored = compressed.empty() ? block : compressed;
+        out.write(stored.data(), stored.size());
+        blocks.emplace_back(BlockCompressedBucketBlock{
+            blockRawOffset, fileOffset, static_cast<uint32_t>(block.size()),
+            static_cast<uint32_t>(stored.size())});
+        fileOffset += stored.size();
+        blockRawOffset = rawOffset;
+        block.clear();
+    };
+
+    char szBuf[4];
+    while (in.read(szBuf, sizeof(szBuf)))
+    {
+        // Same rule as the pages of BucketIndex
+        if (rawOffset >= (blockRawOffset / blockSize + 1) * blockSize)
+        {
+            flush();
+        }
+        auto start = block.size();
+        auto recordSize = 4 + XDRInputFileStream::getXDRSize(szBuf);
+        block.resize(start + recordSize);
+        std::memcpy(block.data() + start, szBuf, 4);
+        if (!in.read(block.data() + start + 4, recordSize - 4))
+        {
+            throw std::runtime_error(
+                fmt::format(FMT_STRING("malformed bucket file {}"),
+                            rawFilename.string()));
+        }
+        hasher.add(ByteSlice(block.data() + start, recordSize));
+        rawOffset += recordSize;
+    }
+    if (in.gcount() != 0 || !in.eof())
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("malformed bucket file {}"), rawFilename.string()));
+    }
+    flush();
+
+    auto indexOffset = fileOffset;
+    for (auto const& b : blocks)
+    {
+        putUint(out, b.mRawOffset, 8);
+        putUint(out, b.mFileOffset, 8);
+        putUint(out, b.mRawSize, 4);
+        putUint(out, b.mStoredSize, 4);
+    }
+    putUint(out, indexOffset, 8);
+    putUint(out, blocks.size(), 4);
+    putUint(out, rawOffset, 8);
+    out.write(MAGIC, sizeof(MAGIC));
+    out.close();
+
+    BlockCompressedBucketStats stats;
+    stats.mRawBytes = rawOffset;
+    stats.mCompressedBytes =
+        indexOffset + blocks.size() * INDEX_ENTRY_SIZE + FOOTER_SIZE;
+    stats.mBlocks = blocks.size();
+    stats.mRawHash = hasher.finish();
+    return stats;
+}
+
+BlockCompressedBucketReader::BlockCompressedBucketReader(
+    std::filesystem::path const& filename)
+    : mIn(filename, std::ios::binary)
+{
+    auto bad = [&]() {
+        return std::runtime_error(
+            fmt::format(FMT_STRING("bad block-compressed bucket {}"),
+                        filename.string()));
+    };
+    char header[HEADER_SIZE];
+    if (!mIn.read(header, sizeof(header)) ||
+        std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 ||
+        getUint(header + 4, 4) != FORMAT_VERSION)
+    {
+        throw bad();
+    }
+    mCodec = static_cast<uint32_t>(getUint(header + 8, 4));
+
+    char footer[FOOTER_SIZE];
+    mIn.seekg(-static_cast<std::streamoff>(FOOTER_SIZE), std::ios::end);
+    auto footerOffset = static_cast<uint64_t>(mIn.tellg());
+    if (!mIn.read(footer, sizeof(footer)) ||
+        std::memcmp(footer + 20, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        throw bad();
+    }
+    auto indexOffset = getUint(footer, 8);
+    auto blockCount = getUint(footer + 8, 4);
+    mRawSize = getUint(footer + 12, 8);
+    if (indexOffset < HEADER_SIZE ||
+        indexOffset + blockCount * INDEX_ENTRY_SIZE != footerOffset)
+    {
+        throw bad();
+    }
+
+    std::vector<char> index(blockCount * INDEX_ENTRY_SIZE);
+    mIn.seekg(indexOffset);
+    if (!mIn.read(index.data(), index.size()))
+    {
+        throw bad();
+    }
+    uint64_t rawOffset = 0;
+    uint64_t fileOffset = HEADER_SIZE;
+    for (size_t i = 0; i < blockCount; ++i)
+    {
+        auto entry = index.data() + i * INDEX_ENTRY_SIZE;
+        BlockCompressedBucketBlock b{
+            getUint(entry, 8), getUint(entry + 8, 8),
+            static_cast<uint32_t>(getUint(entry + 16, 4)),
+            static_cast<uint32_t>(getUint(entry + 20, 4))};
+        if (b.mRawOffset != rawOffset || b.mFileOffset != fileOffset ||
+            b.mRawSize == 0)
+        {
+            throw bad();
+        }
+        rawOffset += b.mRawSize;
+        fileOffset += b.mStoredSize;
+        mBlocks.emplace_back(b);
+    }
+    if (rawOffset != mRawSize || fileOffset != indexOffset)
+    {
+        throw bad();
+    }
+}
+
+size_t
+BlockCompressedBucketReader::findBlock(uint64_t pos) const
+{
+    auto it = std::upper_bound(mBlocks.begin(), mBlocks.end(), pos,
+                               [](uint64_t p, auto const& b) {
+                                   return p < b.mRawOffset;
+                               });
+    releaseAssert(it != mBlocks.begin());
+    return std::distance(mBlocks.begin(), it) - 1;
+}
+
+std::vector<char> const&
+BlockCompressedBucketReader::loadBlock(size_t i)
+{
+    ZoneScoped;
+    if (mCachedBlock == i)
+    {
+        return mCachedData;
+    }
+    auto const& b = mBlocks.at(i);
+    std::vector<char> stored(b.mStoredSize);
+    mIn.clear();
+    mIn.seekg(b.mFileOffset);
+    if (!mIn.read(stored.data(), stored.size()))
+    {
+        throw std::runtime_error("IO failure reading block-compressed bucket");
+    }
+    mCachedBlock.reset();
+    if (b.mStoredSize == b.mRawSize)
+    {
+        mCachedData = std::move(stored);
+    }
+    else
+    {
+        mCachedData.resize(b.mRawSize);
+        decompressBlock(mCodec, stored.data(), stored.size(), mCachedData);
+    }
+    mCachedBlock = i;
+    return mCachedData;
+}
+
+bool
+BlockCompressedBucketReader::readOneAt(std::streamoff pos, BucketEntry& out)
+{
+    ZoneScoped;
+    if (pos < 0 || static_cast<uint64_t>(pos) >= mRawSize)
+    {
+        return false;
+    }
+    auto i = findBlock(pos);
+    auto const& data = loadBlock(i);
+    readRecord(data, pos - mBlocks[i].mRawOffset, out);
+    return true;
+}
+
+bool
+BlockCompressedBucketReader::readPageAt(std::streamoff pos, BucketEntry& out,
+                                        LedgerKey const& key, size_t pageSize)
+{
+    ZoneScoped;
+    if (pos < 0)
+    {
+        return false;
+    }
+    uint64_t cur = pos;
+    uint64_t end = std::min<uint64_t>(cur + pageSize, mRawSize);
+    while (cur < end)
+    {
+        auto i = findBlock(cur);
+        auto const& data = loadBlock(i);
+        auto blockStart = mBlocks[i].mRawOffset;
+        cur = blockStart + readRecord(data, cur - blockStart, out);
+        if (out.type() != METAENTRY && getBucketLedgerKey(out) == key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+BlockCompressedBucketReader::forEach(
+    std::function<void(BucketEntry const&)> const& f)
+{
+    ZoneScoped;
+    BucketEntry be;
+    for (size_t i = 0; i < mBlocks.size(); ++i)
+    {
+        auto const& data = loadBlock(i);
+        for (size_t pos = 0; pos < data.size();)
+        {
+            pos = readRecord(data, pos, be);
+            f(be);
+        }
+    }
+}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include "xdr/Stellar-ledger.h"
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace stellar
+{
+
+// A block-compressed form of a bucket file. The records of the bucket are cut
+// into blocks that are compressed independently, with zstd when stellar-core
+// is built with it, followed by an index of the blocks. Offsets are always
+// those of the uncompressed bucket file, so the offsets of a BucketIndex can be
+// used as they are, and reading one record only decompresses one block.
+//
+// Blocks start at the first record at or after each multiple of the block
+// size, the same rule that starts the pages of a BucketIndex: when the block
+// size is a multiple of the index page size, every page is within one block.
+//
+// The hash of a bucket stays that of its uncompressed content.
+//
+// Layout, with integers big-endian:
+//   magic "SBKC", uint32 format version, uint32 codec
+//   blocks
+//   per block: uint64 raw offset, uint64 file offset, uint32 raw size,
+//              uint32 stored size (equal to the raw size if stored as is)
+//   uint64 index offset, uint32 block count, uint64 raw size, magic "SBKC"
+
+struct BlockCompressedBucketStats
+{
+    uint64_t mRawBytes{0};
+    uint64_t mCompressedBytes{0};
+    size_t mBlocks{0};
+    // Hash of the uncompressed content, i.e. the bucket hash
+    Hash mRawHash;
+};
+
+// Writes the bucket file `rawFilename` to `filename` in blocks of about
+// `blockSize` uncompressed bytes. Throws if `rawFilename` isn't a sequence of
+// XDR records.
+BlockCompressedBucketStats
+writeBlockCompressedBucket(std::filesystem::path const& rawFilename,
+                           std::filesystem::path const& filename,
+                           size_t blockSize);
+
+struct BlockCompressedBucketBlock
+{
+    uint64_t mRawOffset;
+    uint64_t mFileOffset;
+    uint32_t mRawSize;
+    uint32_t mStoredSize;
+};
+
+class BlockCompressedBucketReader : public NonMovableOrCopyable
+{
+    std::ifstream mIn;
+    uint32_t mCodec;
+    uint64_t mRawSize;
+    std::vector<BlockCompressedBucketBlock> mBlocks;
+
+    // The last block decompressed, as consecutive reads often hit the same one
+    std::optional<size_t> mCachedBlock;
+    std::vector<char> mCachedData;
+
+    std::vector<char> const& loadBlock(size_t i);
+
+    // Index of the block holding raw offset `pos`
+    size_t findBlock(uint64_t pos) const;
+
+  public:
+    // Throws if `filename` isn't a block-compressed bucket
+    explicit BlockCompressedBucketReader(std::filesystem::path const& filename);
+
+    uint64_t
+    getRawSize() const
+    {
+        return mRawSize;
+    }
+
+    size_t
+    getBlockCount() const
+    {
+        return mBlocks.size();
+    }
+
+    // Reads the record starting at raw offset `pos`. Returns false at the end
+    // of the bucket.
+    bool readOneAt(std::streamoff pos, BucketEntry& out);
+
+    // Same as XDRInputFileStream::readPage after seeking to raw offset `pos`:
+    // looks for `key` among the records starting before `pos + pageSize`.
+    bool readPageAt(std::streamoff pos, BucketEntry& out, LedgerKey const& key,
+                    size_t pageSize);
+
+    // Calls `f` on every record in order, decompressing one block at a time
+    void forEach(std::function<void(BucketEntry const&)> const& f);
+};
+}
@@ -20,13 +20,19 @@
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTypeUtils.h"
 #include "main/Application.h"
+#include "medida/histogram.h"
+#include "medida/meter.h"
 #include "medida/timer.h"
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/XDRStream.h"
 #include "util/types.h"
-#include <Tracy.hpp>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <thread>
 
 #include "medida/counter.h"
 
@@ -54,6 +60,12 @@ Bucket::getOfferRange() const
     return getIndex().getOfferRange();
 }
 
+std::optional<std::pair<std::streamoff, std::streamoff>>
+Bucket::getTypeRange(LedgerEntryType type) const
+{
+    return getIndex().getTypeRange(type);
+}
+
 void
 Bucket::setIndex(std::unique_ptr<BucketIndex const>&& index)
 {
@@ -61,6 +73,63 @@ Bucket::setIndex(std::unique_ptr<BucketIndex const>&& index)
     mIndex = std::move(index);
 }
 
+bool
+Bucket::hasInMemoryEntries() const
+{
+    return mInMemoryEntries.has_value();
+}
+
+std::vector<BucketEntry> const&
+Bucket::getInMemoryEntries() const
+{
+    releaseAssert(mInMemoryEntries);
+    return *mInMemoryEntries;
+}
+
+void
+Bucket::setInMemoryEntries(std::vector<BucketEntry>&& entries)
+{
+    mInMemoryEntries = std::move(entries);
+}
+
+std::shared_ptr<std::vector<BucketEntry> const>
+Bucket::getSnapshotEntries()
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    if (!mSnapshotEntries && !isEmpty())
+    {
+        auto entries = std::make_shared<std::vector<BucketEntry>>();
+        if (hasInMemoryEntries())
+        {
+            entries->reserve(mInMemoryEntries->size());
+            for (auto const& be : *mInMemoryEntries)
+            {
+                if (be.type() != METAENTRY)
+                {
+                    entries->emplace_back(be);
+                }
+            }
+        }
+        else
+        {
+            for (BucketInputIterator in(shared_from_this()); in; ++in)
+            {
+                entries->emplace_back(*in);
+            }
+        }
+        mSnapshotEntries = entries;
+    }
+    return mSnapshotEntries;
+}
+
+void
+Bucket::freeSnapshotEntries()
+{
+    releaseAssert(threadIsMain());
+    mSnapshotEntries.reset();
+}
+
 Bucket::Bucket(std::string const& filename, Hash const& hash,
                std::unique_ptr<BucketIndex const>&& index)
     : mFilename(filename), mHash(hash), mIndex(std::move(index))
@@ -153,6 +222,52 @@ Bucket::apply(Application& app) const
 }
 #endif // BUILD_TESTS
 
+// Below this many entries per thread, sorting in parallel isn't worth it
+static size_t const MIN_ENTRIES_PER_SORT_THREAD = 4096;
+
+// Sorts runs of `entries` on separate threads, then merges them
+static void
+sortBucketEntries(std::vector<BucketEntry>& entries)
+{
+    ZoneScoped;
+    BucketEntryIdCmp cmp;
+    size_t threads = std::min<size_t>(std::thread::hardware_concurrency(),
+                                      entries.size() /
+                                          MIN_ENTRIES_PER_SORT_THREAD);
+    if (threads < 2)
+    {
+        std::sort(entries.begin(), entries.end(), cmp);
+        return;
+    }
+
+    std::vector<size_t> bounds;
+    for (size_t i = 0; i <= threads; ++i)
+    {
+        bounds.emplace_back(entries.size() * i / threads);
+    }
+    auto begin = entries.begin();
+    std::vector<std::future<void>> sorts;
+    for (size_t i = 0; i < threads; ++i)
+    {
+        sorts.emplace_back(std::async(std::launch::async, [&, i]() {
+            std::sort(begin + bounds[i], begin + bounds[i + 1], cmp);
+        }));
+    }
+    for (auto& sort : sorts)
+    {
+        sort.get();
+    }
+    for (size_t width = 1; width < threads; width *= 2)
+    {
+        for (size_t i = 0; i + width < threads; i += 2 * width)
+        {
+            std::inplace_merge(begin + bounds[i], begin + bounds[i + width],
+                               begin + bounds[std::min(i + 2 * width, threads)],
+                               cmp);
+        }
+    }
+}
+
 std::vector<BucketEntry>
 Bucket::convertToBucketEntry(bool useInit,
                              std::vector<LedgerEntry> const& initEntries,
@@ -160,6 +275,8 @@ Bucket::convertToBucketEntry(bool useInit,
                              std::vector<LedgerKey> const& deadEntries)
 {
     std::vector<BucketEntry> bucket;
+    bucket.reserve(initEntries.size() + liveEntries.size() +
+                   deadEntries.size());
     for (auto const& e : initEntries)
     {
         BucketEntry ce;
@@ -183,7 +300,7 @@ Bucket::convertToBucketEntry(bool useInit,
     }
 
     BucketEntryIdCmp cmp;
-    std::sort(bucket.begin(), bucket.end(), cmp);
+    sortBucketEntries(bucket);
     releaseAssert(std::adjacent_find(
                       bucket.begin(), bucket.end(),
                       [&cmp](BucketEntry const& lhs, BucketEntry const& rhs) {
@@ -225,7 +342,7 @@ Bucket::fresh(BucketManager& bucketManager, uint32_t protocolVersion,
               std::vector<LedgerEntry> const& initEntries,
               std::vector<LedgerEntry> const& liveEntries,
               std::vector<LedgerKey> const& deadEntries, bool countMergeEvents,
-              asio::io_context& ctx, bool doFsync)
+              asio::io_context& ctx, bool doFsync, bool storeInMemory)
 {
     ZoneScoped;
     // When building fresh buckets after protocol version 10 (i.e. version
@@ -240,8 +357,10 @@ Bucket::fresh(BucketManager& bucketManager, uint32_t protocolVersion,
         convertToBucketEntry(useInit, initEntries, liveEntries, deadEntries);
 
     MergeCounters mc;
+    std::vector<BucketEntry> inMemoryEntries;
     BucketOutputIterator out(bucketManager.getTmpDir(), true, meta, mc, ctx,
-                             doFsync);
+                             doFsync, /*postHashing=*/nullptr,
+                             storeInMemory ? &inMemoryEntries : nullptr);
     for (auto const& e : entries)
     {
         out.put(e);
@@ -252,8 +371,13 @@ Bucket::fresh(BucketManager& bucketManager, uint32_t protocolVersion,
         bucketManager.incrMergeCounters(mc);
     }
 
-    return out.getBucket(bucketManager,
-                         bucketManager.getConfig().isUsingBucketListDB());
+    auto bucket = out.getBucket(
+        bucketManager, bucketManager.getConfig().isUsingBucketListDB());
+    if (storeInMemory && !bucket->isEmpty() && !bucket->hasInMemoryEntries())
+    {
+        bucket->setInMemoryEntries(std::move(inMemoryEntries));
+    }
+    return bucket;
 }
 
 static void
@@ -438,10 +562,11 @@ countNewEntryType(MergeCounters& mc, BucketEntry const& e)
 // and shadowing protocol simultaneously, the moment the first new-protocol
 // bucket enters the youngest level. At least one new bucket is in every merge's
 // shadows from then on in, so they all upgrade (and preserve lifecycle events).
+template <typename InputIterator>
 static void
 calculateMergeProtocolVersion(
-    MergeCounters& mc, uint32_t maxProtocolVersion,
-    BucketInputIterator const& oi, BucketInputIterator const& ni,
+    MergeCounters& mc, uint32_t maxProtocolVersion, InputIterator const& oi,
+    InputIterator const& ni,
     std::vector<BucketInputIterator> const& shadowIterators,
     uint32& protocolVersion, bool& keepShadowedLifecycleEntries)
 {
@@ -510,10 +635,11 @@ calculateMergeProtocolVersion(
 // side, or entries that compare non-equal. In all these cases we just
 // take the lesser (or existing) entry and advance only one iterator,
 // not scrutinizing the entry type further.
+template <typename InputIterator>
 static bool
 mergeCasesWithDefaultAcceptance(
-    BucketEntryIdCmp const& cmp, MergeCounters& mc, BucketInputIterator& oi,
-    BucketInputIterator& ni, BucketOutputIterator& out,
+    BucketEntryIdCmp const& cmp, MergeCounters& mc, InputIterator& oi,
+    InputIterator& ni, BucketOutputIterator& out,
     std::vector<BucketInputIterator>& shadowIterators, uint32_t protocolVersion,
     bool keepShadowedLifecycleEntries)
 {
@@ -552,9 +678,10 @@ mergeCasesWithDefaultAcceptance(
 
 // The remaining cases happen when keys are equal and we have to reason
 // through the relationships of their bucket lifecycle states. Trickier.
+template <typename InputIterator>
 static void
-mergeCasesWithEqualKeys(MergeCounters& mc, BucketInputIterator& oi,
-                        BucketInputIterator& ni, BucketOutputIterator& out,
+mergeCasesWithEqualKeys(MergeCounters& mc, InputIterator& oi,
+                        InputIterator& ni, BucketOutputIterator& out,
                         std::vector<BucketInputIterator>& shadowIterators,
                         uint32_t protocolVersion,
                         bool keepShadowedLifecycleEntries)
@@ -784,11 +911,32 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
     releaseAssert(oldBucket);
     releaseAssert(newBucket);
 
+    // Pages of the inputs that were cached before the merge, to leave cached
+    bool dropPageCache =
+        bucketManager.getConfig().BUCKET_MERGE_DROP_PAGE_CACHE;
+    std::vector<bool> oldResidency;
+    std::vector<bool> newResidency;
+    if (dropPageCache)
+    {
+        oldResidency =
+            fs::getPageCacheResidency(oldBucket->getFilename().string());
+        newResidency =
+            fs::getPageCacheResidency(newBucket->getFilename().string());
+    }
+
+    // Merges scan every input sequentially, so read them through large
+    // buffers to reduce the number of reads on deep levels
     MergeCounters mc;
-    BucketInputIterator oi(oldBucket);
-    BucketInputIterator ni(newBucket);
-    std::vector<BucketInputIterator> shadowIterators(shadows.begin(),
-                                                     shadows.end());
+    auto readBufferSize =
+        bucketManager.getConfig().BUCKET_MERGE_READ_BUFFER_SIZE * 1024;
+    BucketInputIterator oi(oldBucket, readBufferSize);
+    BucketInputIterator ni(newBucket, readBufferSize);
+    std::vector<BucketInputIterator> shadowIterators;
+    shadowIterators.reserve(shadows.size());
+    for (auto const& shadow : shadows)
+    {
+        shadowIterators.emplace_back(shadow, readBufferSize);
+    }
 
     uint32_t protocolVersion;
     bool keepShadowedLifecycleEntries;
@@ -797,10 +945,20 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
                                   keepShadowedLifecycleEntries);
 
     auto timer = bucketManager.getMergeTimer().TimeScope();
+    auto start = std::chrono::steady_clock::now();
     BucketMetadata meta;
     meta.ledgerVersion = protocolVersion;
+    PipelinedSHA256::PostJob postHashing;
+    if (bucketManager.getConfig().BUCKET_MERGE_PIPELINED_HASHING)
+    {
+        postHashing = [&bucketManager](std::function<void()>&& f) {
+            bucketManager.postOnBackgroundThread(std::move(f),
+                                                 "Bucket: merge hashing",
+                                                 BackgroundPriority::HIGH);
+        };
+    }
     BucketOutputIterator out(bucketManager.getTmpDir(), keepDeadEntries, meta,
-                             mc, ctx, doFsync);
+                             mc, ctx, doFsync, postHashing);
 
     BucketEntryIdCmp cmp;
     size_t iter = 0;
@@ -835,8 +993,179 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
         bucketManager.incrMergeCounters(mc);
     }
     MergeKey mk{keepDeadEntries, oldBucket, newBucket, shadows};
-    return out.getBucket(bucketManager,
-                         bucketManager.getConfig().isUsingBucketListDB(), &mk);
+    auto bucket = out.getBucket(
+        bucketManager, bucketManager.getConfig().isUsingBucketListDB(), &mk);
+
+    if (dropPageCache)
+    {
+        size_t dropped = 0;
+        if (!oldBucket->isEmpty())
+        {
+            dropped += fs::dropFromPageCache(
+                oldBucket->getFilename().string(), oldResidency);
+        }
+        if (!newBucket->isEmpty())
+        {
+            dropped += fs::dropFromPageCache(
+                newBucket->getFilename().string(), newResidency);
+        }
+        if (!bucket->isEmpty())
+        {
+            dropped += fs::dropFromPageCache(bucket->getFilename().string());
+        }
+        bucketManager.getMergePageCacheDropMeter().Mark(dropped);
+    }
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (!bucket->isEmpty() && elapsed.count() > 0)
+    {
+        bucketManager.getMergeThroughputHistogram().Update(
+            static_cast<int64_t>(bucket->getSize() / elapsed.count()));
+    }
+    return bucket;
+}
+
+namespace
+{
+// Iterates over in-memory bucket entries the way BucketInputIterator does
+// over a bucket file: the METAENTRY, if any, is only exposed as metadata.
+class MemoryBucketInputIterator
+{
+    std::vector<BucketEntry> const& mEntries;
+    size_t mIndex{0};
+    BucketMetadata mMetadata;
+
+  public:
+    explicit MemoryBucketInputIterator(std::vector<BucketEntry> const& entries)
+        : mEntries(entries)
+    {
+        mMetadata.ledgerVersion = 0;
+        if (!mEntries.empty() && mEntries.front().type() == METAENTRY)
+        {
+            mMetadata = mEntries.front().metaEntry();
+            ++mIndex;
+        }
+    }
+
+    explicit operator bool() const
+    {
+        return mIndex < mEntries.size();
+    }
+
+    BucketEntry const&
+    operator*() const
+    {
+        return mEntries[mIndex];
+    }
+
+    MemoryBucketInputIterator&
+    operator++()
+    {
+        ++mIndex;
+        return *this;
+    }
+
+    BucketMetadata const&
+    getMetadata() const
+    {
+        return mMetadata;
+    }
+};
+
+// Reads all the entries of `bucket`, METAENTRY included
+std::vector<BucketEntry>
+loadBucketEntries(std::shared_ptr<Bucket> const& bucket)
+{
+    std::vector<BucketEntry> entries;
+    if (bucket->isEmpty())
+    {
+        return entries;
+    }
+    BucketInputIterator in(bucket);
+    if (in.seenMetadata())
+    {
+        auto& meta = entries.emplace_back();
+        meta.type(METAENTRY);
+        meta.metaEntry() = in.getMetadata();
+    }
+    for (; in; ++in)
+    {
+        entries.emplace_back(*in);
+    }
+    return entries;
+}
+}
+
+std::shared_ptr<Bucket>
+Bucket::mergeInMemory(BucketManager& bucketManager,
+                      uint32_t maxProtocolVersion,
+                      std::shared_ptr<Bucket> const& oldBucket,
+                      std::shared_ptr<Bucket> const& newBucket,
+                      bool keepDeadEntries, bool countMergeEvents,
+                      asio::io_context& ctx, bool doFsync)
+{
+    ZoneScoped;
+    releaseAssert(oldBucket);
+    releaseAssert(newBucket);
+
+    std::vector<BucketEntry> loadedOld;
+    std::vector<BucketEntry> loadedNew;
+    if (!oldBucket->hasInMemoryEntries())
+    {
+        loadedOld = loadBucketEntries(oldBucket);
+    }
+    if (!newBucket->hasInMemoryEntries())
+    {
+        loadedNew = loadBucketEntries(newBucket);
+    }
+    MemoryBucketInputIterator oi(oldBucket->hasInMemoryEntries()
+                                     ? oldBucket->getInMemoryEntries()
+                                     : loadedOld);
+    MemoryBucketInputIterator ni(newBucket->hasInMemoryEntries()
+                                     ? newBucket->getInMemoryEntries()
+                                     : loadedNew);
+    std::vector<BucketInputIterator> noShadows;
+
+    MergeCounters mc;
+    uint32_t protocolVersion;
+    bool keepShadowedLifecycleEntries;
+    calculateMergeProtocolVersion(mc, maxProtocolVersion, oi, ni, noShadows,
+                                  protocolVersion,
+                                  keepShadowedLifecycleEntries);
+
+    auto timer = bucketManager.getMergeTimer().TimeScope();
+    BucketMetadata meta;
+    meta.ledgerVersion = protocolVersion;
+    std::vector<BucketEntry> inMemoryEntries;
+    BucketOutputIterator out(bucketManager.getTmpDir(), keepDeadEntries, meta,
+                             mc, ctx, doFsync, /*postHashing=*/nullptr,
+                             &inMemoryEntries);
+
+    BucketEntryIdCmp cmp;
+    while (oi || ni)
+    {
+        if (!mergeCasesWithDefaultAcceptance(cmp, mc, oi, ni, out, noShadows,
+                                             protocolVersion,
+                                             keepShadowedLifecycleEntries))
+        {
+            mergeCasesWithEqualKeys(mc, oi, ni, out, noShadows,
+                                    protocolVersion,
+                                    keepShadowedLifecycleEntries);
+        }
+    }
+    if (countMergeEvents)
+    {
+        bucketManager.incrMergeCounters(mc);
+    }
+    MergeKey mk{keepDeadEntries, oldBucket, newBucket, {}};
+    auto bucket = out.getBucket(
+        bucketManager, bucketManager.getConfig().isUsingBucketListDB(), &mk);
+    if (!bucket->isEmpty() && !bucket->hasInMemoryEntries())
+    {
+        bucket->setInMemoryEntries(std::move(inMemoryEntries));
+    }
+    return bucket;
 }
 
 uint32_t
@@ -11,6 +11,7 @@
 #include <list>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace asio
 {
@@ -53,6 +54,18 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
 
     std::unique_ptr<BucketIndex const> mIndex{};
 
+    // All the entries of the bucket, METAENTRY included, for the fresh and
+    // merged buckets of level 0 only. Level 0 merges every ledger, and keeping
+    // its buckets in memory spares reading them back from disk to do so. Only
+    // accessed by the thread adding batches to the bucket list.
+    std::optional<std::vector<BucketEntry>> mInMemoryEntries;
+
+    // The entries of the bucket without METAENTRY, shared by the BucketListDB
+    // snapshots of the levels kept in memory (see
+    // BUCKETLIST_DB_IN_MEMORY_LEVELS). Only accessed by the main thread;
+    // snapshots hold their own reference.
+    std::shared_ptr<std::vector<BucketEntry> const> mSnapshotEntries;
+
     // Returns index, throws if index not yet initialized
     BucketIndex const& getIndex() const;
 
@@ -91,9 +104,31 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     std::optional<std::pair<std::streamoff, std::streamoff>>
     getOfferRange() const;
 
+    // Returns [lowerBound, upperBound) of file offsets for all entries of the
+    // given type in the bucket, or std::nullopt if there are none. See
+    // BucketIndex::getTypeRange.
+    std::optional<std::pair<std::streamoff, std::streamoff>>
+    getTypeRange(LedgerEntryType type) const;
+
     // Sets index, throws if index is already set
     void setIndex(std::unique_ptr<BucketIndex const>&& index);
 
+    bool hasInMemoryEntries() const;
+
+    // Precondition: hasInMemoryEntries()
+    std::vector<BucketEntry> const& getInMemoryEntries() const;
+
+    // Keeps `entries`, which must be the bucket's entries, in memory
+    void setInMemoryEntries(std::vector<BucketEntry>&& entries);
+
+    // Returns the entries of the bucket without METAENTRY, in bucket order,
+    // loading them the first time from the in-memory entries or the bucket
+    // file. Returns nullptr for the empty bucket. Main thread only.
+    std::shared_ptr<std::vector<BucketEntry> const> getSnapshotEntries();
+
+    // Drops the reference getSnapshotEntries keeps. Main thread only.
+    void freeSnapshotEntries();
+
     // At version 11, we added support for INITENTRY and METAENTRY. Before this
     // we were only supporting LIVEENTRY and DEADENTRY.
     static constexpr ProtocolVersion
@@ -149,13 +184,14 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
 
     // Create a fresh bucket from given vectors of init (created) and live
     // (updated) LedgerEntries, and dead LedgerEntryKeys. The bucket will
-    // be sorted, hashed, and adopted in the provided BucketManager.
+    // be sorted, hashed, and adopted in the provided BucketManager. If
+    // `storeInMemory`, the bucket also keeps its entries in memory.
     static std::shared_ptr<Bucket>
     fresh(BucketManager& bucketManager, uint32_t protocolVersion,
           std::vector<LedgerEntry> const& initEntries,
           std::vector<LedgerEntry> const& liveEntries,
           std::vector<LedgerKey> const& deadEntries, bool countMergeEvents,
-          asio::io_context& ctx, bool doFsync);
+          asio::io_context& ctx, bool doFsync, bool storeInMemory = false);
 
     // Merge two buckets together, producing a fresh one. Entries in `oldBucket`
     // are overridden in the fresh bucket by keywise-equal entries in
@@ -176,6 +212,17 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
           bool keepDeadEntries, bool countMergeEvents, asio::io_context& ctx,
           bool doFsync);
 
+    // Same as `merge` without shadows, for protocols that no longer have them,
+    // but reading the inputs from memory when they have their entries there
+    // (or else loading them), and keeping the output's entries in memory.
+    // Meant for level 0, whose buckets are small.
+    static std::shared_ptr<Bucket>
+    mergeInMemory(BucketManager& bucketManager, uint32_t maxProtocolVersion,
+                  std::shared_ptr<Bucket> const& oldBucket,
+                  std::shared_ptr<Bucket> const& newBucket,
+                  bool keepDeadEntries, bool countMergeEvents,
+                  asio::io_context& ctx, bool doFsync);
+
     static uint32_t getBucketVersion(std::shared_ptr<Bucket> const& bucket);
     static uint32_t
     getBucketVersion(std::shared_ptr<Bucket const> const& bucket);
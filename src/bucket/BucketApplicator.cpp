@@ -97,8 +97,64 @@ shouldApplyEntry(std::function<bool(LedgerEntryType)> const& filter,
     return filter(e.deadEntry().type());
 }
 
+std::streamoff
+BucketApplicator::resumeOffset() const
+{
+    return mResumeOffset;
+}
+
+void
+BucketApplicator::skipTo(std::streamoff offset)
+{
+    ZoneScoped;
+    if (!*this)
+    {
+        return;
+    }
+
+    auto isUsingBucketListDB = mApp.getConfig().isUsingBucketListDB();
+    if (!isUsingBucketListDB)
+    {
+        // Without BucketListDB no seen keys are tracked, so the skipped
+        // entries have no effect on the rest of the apply
+        mBucketIter.seek(offset);
+        mResumeOffset = offset;
+        return;
+    }
+
+    for (; mBucketIter && mBucketIter.pos() <= offset; ++mBucketIter)
+    {
+        if (mBucketIter.pos() > mUpperBoundOffset)
+        {
+            mOffersRemaining = false;
+            break;
+        }
+
+        BucketEntry const& e = *mBucketIter;
+        if (shouldApplyEntry(mEntryTypeFilter, e))
+        {
+            if (e.type() == LIVEENTRY || e.type() == INITENTRY)
+            {
+                mSeenKeys.emplace(LedgerEntryKey(e.liveEntry()));
+            }
+            else
+            {
+                mSeenKeys.emplace(e.deadEntry());
+            }
+        }
+    }
+    mResumeOffset = offset;
+}
+
 size_t
 BucketApplicator::advance(BucketApplicator::Counters& counters)
+{
+    return advance(counters, LEDGER_ENTRY_BATCH_COMMIT_SIZE);
+}
+
+size_t
+BucketApplicator::advance(BucketApplicator::Counters& counters,
+                          size_t batchSize)
 {
     size_t count = 0;
 
@@ -118,7 +174,7 @@ BucketApplicator::advance(BucketApplicator::Counters& counters)
     {
         innerLtx = std::make_unique<LedgerTxn>(root, false);
         ltx = innerLtx.get();
-        ltx->prepareNewObjects(LEDGER_ENTRY_BATCH_COMMIT_SIZE);
+        ltx->prepareNewObjects(batchSize);
     }
 
     for (; mBucketIter; ++mBucketIter)
@@ -134,6 +190,8 @@ BucketApplicator::advance(BucketApplicator::Counters& counters)
             break;
         }
 
+        // Offset at which the entry following this one starts
+        auto nextOffset = mBucketIter.pos();
         BucketEntry const& e = *mBucketIter;
         Bucket::checkProtocolLegality(e, mMaxProtocolVersion);
 
@@ -223,8 +281,9 @@ BucketApplicator::advance(BucketApplicator::Counters& counters)
                 }
             }
 
-            if ((++count > LEDGER_ENTRY_BATCH_COMMIT_SIZE))
+            if ((++count > batchSize))
             {
+                mResumeOffset = nextOffset;
                 ++mBucketIter;
                 break;
             }
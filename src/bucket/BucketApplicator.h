@@ -29,6 +29,7 @@ class BucketApplicator
     std::function<bool(LedgerEntryType)> mEntryTypeFilter;
     std::unordered_set<LedgerKey>& mSeenKeys;
     std::streamoff mUpperBoundOffset;
+    std::streamoff mResumeOffset{0};
     bool mOffersRemaining{true};
 
   public:
@@ -78,6 +79,18 @@ class BucketApplicator
     operator bool() const;
     size_t advance(Counters& counters);
 
+    // Applies at most batchSize entries in a single commit.
+    size_t advance(Counters& counters, size_t batchSize);
+
+    // Moves past every entry ending at or before offset without writing it to
+    // the database, recording seen keys exactly as advance would. offset must
+    // be a value previously returned by resumeOffset().
+    void skipTo(std::streamoff offset);
+
+    // File offset of the first entry that has not been applied yet. Only
+    // meaningful while (bool) *this == true.
+    std::streamoff resumeOffset() const;
+
     size_t pos();
     size_t size() const;
 };
@@ -8,6 +8,7 @@
 #include "util/NonCopyable.h"
 #include "util/XDROperators.h" // IWYU pragma: keep
 #include "xdr/Stellar-ledger-entries.h"
+#include <chrono>
 #include <filesystem>
 #include <memory>
 #include <optional>
@@ -38,16 +39,23 @@ class BucketManager;
 class BucketIndex : public NonMovableOrCopyable
 {
   public:
+    // Returns an order preserving 64 bit prefix of k, i.e. for any keys
+    // a < b, getKeyPrefix(a) <= getKeyPrefix(b). The high byte is the key type
+    // and the remaining bytes are the leading bytes of the first field the key
+    // type is ordered by.
+    static uint64_t getKeyPrefix(LedgerKey const& k);
+
     // maps smallest and largest LedgerKey on a given page inclusively
-    // [lowerBound, upperbound]
+    // [lowerBound, upperbound]. Only the prefix of lowerBound is stored, since
+    // the previous page's upperBound already bounds the page from below.
     struct RangeEntry
     {
-        LedgerKey lowerBound;
+        uint64_t lowerBoundPrefix{};
         LedgerKey upperBound;
 
         RangeEntry() = default;
-        RangeEntry(LedgerKey low, LedgerKey high)
-            : lowerBound(low), upperBound(high)
+        RangeEntry(LedgerKey const& low, LedgerKey const& high)
+            : lowerBoundPrefix(getKeyPrefix(low)), upperBound(high)
         {
             releaseAssert(low < high || low == high);
         }
@@ -55,14 +63,15 @@ class BucketIndex : public NonMovableOrCopyable
         inline bool
         operator==(RangeEntry const& in) const
         {
-            return lowerBound == in.lowerBound && upperBound == in.upperBound;
+            return lowerBoundPrefix == in.lowerBoundPrefix &&
+                   upperBound == in.upperBound;
         }
 
         template <class Archive>
         void
         serialize(Archive& ar)
         {
-            ar(lowerBound, upperBound);
+            ar(lowerBoundPrefix, upperBound);
         }
     };
 
@@ -74,7 +83,7 @@ class BucketIndex : public NonMovableOrCopyable
                                   IndividualIndex::const_iterator>;
 
     inline static const std::string DB_BACKEND_STATE = "bl";
-    inline static const uint32_t BUCKET_INDEX_VERSION = 2;
+    inline static const uint32_t BUCKET_INDEX_VERSION = 4;
 
     // Returns true if LedgerEntryType not supported by BucketListDB
     static bool typeNotSupported(LedgerEntryType t);
@@ -123,15 +132,68 @@ class BucketIndex : public NonMovableOrCopyable
     virtual std::optional<std::pair<std::streamoff, std::streamoff>>
     getOfferRange() const = 0;
 
+    // Returns lower bound and upper bound for the positions of entries of the
+    // given type in the given bucket, or std::nullopt if there are none. The
+    // upper bound is the largest streamoff if the entries run to the end of
+    // the file. With a range index the bounds are page offsets, so entries of
+    // the neighbouring types may be found within them. Lets scans that only
+    // want some types (i.e. the eviction scan, which only wants contract
+    // data) skip the rest of the file.
+    virtual std::optional<std::pair<std::streamoff, std::streamoff>>
+    getTypeRange(LedgerEntryType type) const = 0;
+
+    // Same as getTypeRange, for the contract data entries of the given
+    // contract. Contract data keys are ordered by contract first, so these
+    // entries are contiguous.
+    virtual std::optional<std::pair<std::streamoff, std::streamoff>>
+    getContractDataRange(SCAddress const& contract) const = 0;
+
+    // Returns the sorted, disjoint ranges of positions holding the trustline
+    // entries (including DEADENTRY) of the given asset, or std::nullopt if
+    // the index was built without BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET.
+    // Trustline keys are ordered by account first, so these entries are
+    // spread over the whole trustline range. As for getTypeRange, ranges of a
+    // range index are pages that may hold other entries too.
+    virtual std::optional<
+        std::vector<std::pair<std::streamoff, std::streamoff>>>
+    getTrustlineRangesByAsset(TrustLineAsset const& asset) const = 0;
+
     // Returns page size for index. InidividualIndex returns 0 for page size
     virtual std::streamoff getPageSize() const = 0;
 
+    // Returns the estimated bytes of memory held by the index
+    virtual size_t getEstimatedBytes() const = 0;
+
     virtual Iterator begin() const = 0;
 
     virtual Iterator end() const = 0;
 
+    // Bloom filter metrics. A lookup is any key checked against the filter, a
+    // skip is a lookup the filter rejected (so no disk read was required) and
+    // a miss is a false positive that required a page read to discover that
+    // the key is not in the bucket.
     virtual void markBloomMiss() const = 0;
     virtual void markBloomLookup() const = 0;
+    virtual void markBloomSkip() const = 0;
+
+    // Records bytes of the bucket file read and page faults taken while
+    // loading an entry at an offset returned by this index. Page faults are
+    // only sampled for reads through the memory mapping of the bucket file
+    // (see useMmapReads), and are 0 otherwise.
+    virtual void markRead(size_t bytesTouched, uint64_t pageFaults) const = 0;
+
+    // Returns true if entries should be read through a memory mapping of the
+    // bucket file rather than a file stream
+    virtual bool useMmapReads() const = 0;
+
+    // Returns true if bulk loads should submit the reads of all the pages
+    // they need at once before decoding them (see BUCKETLIST_DB_BATCH_READS)
+    virtual bool useBatchReads() const = 0;
+
+    // Records the number of page reads a bulk load submitted together and the
+    // time it took to load all of their entries
+    virtual void markBatchRead(size_t depth,
+                               std::chrono::nanoseconds duration) const = 0;
 
 #ifdef BUILD_TESTS
     virtual bool operator==(BucketIndex const& inRaw) const = 0;
@@ -5,16 +5,21 @@
 #include "bucket/BucketIndexImpl.h"
 #include "bucket/Bucket.h"
 #include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
+#include "bucket/SharedBucketStore.h"
 #include "crypto/ShortHash.h"
 #include "main/Config.h"
 #include "util/Fs.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/MappedFile.h"
+#include "util/MemoryFootprint.h"
+#include "util/ParallelFor.h"
 #include "util/XDRCereal.h"
 #include "util/XDRStream.h"
 
 #include "lib/bloom_filter.hpp"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <cereal/archives/binary.hpp>
 #include <cereal/types/memory.hpp>
 #include <cereal/types/utility.hpp>
@@ -22,6 +27,7 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 
+#include <climits>
 #include <thread>
 
 namespace stellar
@@ -62,13 +68,93 @@ BucketIndex::typeNotSupported(LedgerEntryType t)
     return t == OFFER;
 }
 
+// Returns the first n bytes of bytes as a big endian integer
+template <typename T>
+static uint64_t
+bytesPrefix(T const& bytes, size_t n)
+{
+    releaseAssert(n <= sizeof(uint64_t) && n <= bytes.size());
+    uint64_t res = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        res = (res << 8) | static_cast<uint8_t>(bytes[i]);
+    }
+    return res;
+}
+
+uint64_t
+BucketIndex::getKeyPrefix(LedgerKey const& k)
+{
+    // Every key type is ordered by a fixed size, bytewise compared field
+    // first, so the leading bytes of that field preserve key order
+    size_t const bodyBytes = 7;
+    uint64_t body = 0;
+    switch (k.type())
+    {
+    case ACCOUNT:
+        body = bytesPrefix(k.account().accountID.ed25519(), bodyBytes);
+        break;
+    case TRUSTLINE:
+        body = bytesPrefix(k.trustLine().accountID.ed25519(), bodyBytes);
+        break;
+    case OFFER:
+        body = bytesPrefix(k.offer().sellerID.ed25519(), bodyBytes);
+        break;
+    case DATA:
+        body = bytesPrefix(k.data().accountID.ed25519(), bodyBytes);
+        break;
+    case CLAIMABLE_BALANCE:
+        body = bytesPrefix(k.claimableBalance().balanceID.v0(), bodyBytes);
+        break;
+    case LIQUIDITY_POOL:
+        body = bytesPrefix(k.liquidityPool().liquidityPoolID, bodyBytes);
+        break;
+    case CONTRACT_DATA:
+    {
+        // SCAddress is ordered by address type first, so use one byte of
+        // address type followed by the leading bytes of the address
+        auto const& addr = k.contractData().contract;
+        if (addr.type() == SC_ADDRESS_TYPE_ACCOUNT)
+        {
+            body = bytesPrefix(addr.accountId().ed25519(), bodyBytes - 1);
+        }
+        else if (addr.type() == SC_ADDRESS_TYPE_CONTRACT)
+        {
+            body = bytesPrefix(addr.contractId(), bodyBytes - 1);
+        }
+        body |= static_cast<uint64_t>(addr.type() & 0xFF)
+                << ((bodyBytes - 1) * 8);
+        break;
+    }
+    case CONTRACT_CODE:
+        body = bytesPrefix(k.contractCode().hash, bodyBytes);
+        break;
+    case CONFIG_SETTING:
+        body = static_cast<uint32_t>(k.configSetting().configSettingID);
+        break;
+    case TTL:
+        body = bytesPrefix(k.ttl().keyHash, bodyBytes);
+        break;
+    }
+
+    return (static_cast<uint64_t>(k.type() & 0xFF) << (bodyBytes * 8)) | body;
+}
+
 template <class IndexT>
 BucketIndexImpl<IndexT>::BucketIndexImpl(BucketManager& bm,
                                          std::filesystem::path const& filename,
                                          std::streamoff pageSize,
                                          Hash const& hash)
-    : mBloomMissMeter(bm.getBloomMissMeter())
-    , mBloomLookupMeter(bm.getBloomLookupMeter())
+    : mBloomMisses(bm.getBloomMissCounter())
+    , mBloomLookups(bm.getBloomLookupCounter())
+    , mBloomSkips(bm.getBloomSkipCounter())
+    , mReadBytes(bm.getReadBytesCounter())
+    , mReadPageFaultsMeter(bm.getReadPageFaultsMeter())
+    , mBatchReadDepth(bm.getBatchReadDepthHistogram())
+    , mBatchReadTimer(bm.getBatchReadTimer())
+    , mUseMmapReads(bm.getConfig().BUCKETLIST_DB_MMAP_READS &&
+                    MappedFile::isSupported())
+    , mUseBatchReads(bm.getConfig().BUCKETLIST_DB_BATCH_READS)
 {
     ZoneScoped;
     releaseAssert(!filename.empty());
@@ -76,6 +162,8 @@ BucketIndexImpl<IndexT>::BucketIndexImpl(BucketManager& bm,
     {
         auto timer = LogSlowExecution("Indexing bucket");
         mData.pageSize = pageSize;
+        mData.indexesTrustlinesByAsset =
+            bm.getConfig().BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET;
 
         size_t const estimatedLedgerEntrySize =
             xdr::xdr_traits<BucketEntry>::serial_size(BucketEntry{});
@@ -119,95 +207,302 @@ BucketIndexImpl<IndexT>::BucketIndexImpl(BucketManager& bm,
             mData.keysToOffset.reserve(estimatedIndexEntries);
         }
 
-        XDRInputFileStream in;
-        in.open(filename.string());
-        std::streamoff pos = 0;
-        std::streamoff pageUpperBound = 0;
-        BucketEntry be;
-        size_t iter = 0;
         size_t count = 0;
-        while (in && in.readOne(be))
+        bool sharded = false;
+        if constexpr (std::is_same<IndexT, RangeIndex>::value)
         {
-            // peridocially check if bucket manager is exiting to stop indexing
-            // gracefully
-            if (++iter >= 1000)
+            // Convert cfg param from MB to bytes
+            auto shardSize =
+                bm.getConfig().BUCKETLIST_DB_INDEX_SHARD_SIZE * 1000000;
+            if (shardSize != 0 && fileSize > shardSize)
             {
-                iter = 0;
-                if (bm.isShutdown())
+                auto shards = getShards(filename, shardSize);
+                if (shards.size() > 1)
                 {
-                    throw std::runtime_error("Incomplete bucket index due to "
-                                             "BucketManager shutdown");
+                    count = indexShardsParallel(bm, filename,
+                                                std::move(shards));
+                    sharded = true;
                 }
             }
+        }
+
+        if (!sharded)
+        {
+            IndexShard shard;
+            shard.end = fileSize;
+            indexShard(bm, filename, shard, mData.filter.get());
+            count = stitchShard(shard);
+        }
+
+        buildUpperBoundPrefixes();
+        CLOG_DEBUG(Bucket, "Indexed {} positions in {}",
+                   mData.keysToOffset.size(), filename.filename());
+        ZoneValue(static_cast<int64_t>(count));
+    }
 
-            if (be.type() != METAENTRY)
+    if (bm.getConfig().isPersistingBucketListDBIndexes())
+    {
+        saveToDisk(bm, hash);
+    }
+}
+
+template <class IndexT>
+void
+BucketIndexImpl<IndexT>::indexShard(BucketManager const& bm,
+                                    std::filesystem::path const& filename,
+                                    IndexShard& shard,
+                                    bloom_filter* filter) const
+{
+    ZoneScoped;
+    if constexpr (std::is_same<IndexT, RangeIndex>::value)
+    {
+        releaseAssert(filter);
+    }
+
+    XDRInputFileStream in;
+    in.open(filename.string());
+    in.seek(shard.begin);
+    std::streamoff pos = shard.begin;
+    std::streamoff pageUpperBound =
+        shard.prevEntryPos
+            ? roundDown(*shard.prevEntryPos, mData.pageSize) +
+                  mData.pageSize
+            : 0;
+    BucketEntry be;
+    size_t iter = 0;
+    while (pos < shard.end && in && in.readOne(be))
+    {
+        // peridocially check if bucket manager is exiting to stop indexing
+        // gracefully
+        if (++iter >= 1000)
+        {
+            iter = 0;
+            if (bm.isShutdown())
+            {
+                throw std::runtime_error("Incomplete bucket index due to "
+                                         "BucketManager shutdown");
+            }
+        }
+
+        if (be.type() != METAENTRY)
+        {
+            ++shard.count;
+            LedgerKey key = getBucketLedgerKey(be);
+
+            // We need an asset to poolID mapping for
+            // loadPoolshareTrustlineByAccountAndAsset queries. For this
+            // query, we only need to index INIT entries because:
+            // 1. PoolID is the hash of the Assets it refers to, so this
+            //    index cannot be invalidated by newer LIVEENTRY updates
+            // 2. We do a join over all bucket indexes so we avoid storing
+            //    multiple redundant index entries (i.e. LIVEENTRY updates)
+            // 3. We only use this index to collect the possible set of
+            //    Trustline keys, then we load those keys. This means that
+            //    we don't need to keep track of DEADENTRY. Even if a given
+            //    INITENTRY has been deleted by a newer DEADENTRY, the
+            //    trustline load will not return deleted trustlines, so the
+            //    load result is still correct even if the index has a few
+            //    deleted mappings.
+            if (be.type() == INITENTRY && key.type() == LIQUIDITY_POOL)
             {
-                ++count;
-                LedgerKey key = getBucketLedgerKey(be);
-
-                // We need an asset to poolID mapping for
-                // loadPoolshareTrustlineByAccountAndAsset queries. For this
-                // query, we only need to index INIT entries because:
-                // 1. PoolID is the hash of the Assets it refers to, so this
-                //    index cannot be invalidated by newer LIVEENTRY updates
-                // 2. We do a join over all bucket indexes so we avoid storing
-                //    multiple redundant index entries (i.e. LIVEENTRY updates)
-                // 3. We only use this index to collect the possible set of
-                //    Trustline keys, then we load those keys. This means that
-                //    we don't need to keep track of DEADENTRY. Even if a given
-                //    INITENTRY has been deleted by a newer DEADENTRY, the
-                //    trustline load will not return deleted trustlines, so the
-                //    load result is still correct even if the index has a few
-                //    deleted mappings.
-                if (be.type() == INITENTRY && key.type() == LIQUIDITY_POOL)
+                auto const& poolParams = be.liveEntry()
+                                             .data.liquidityPool()
+                                             .body.constantProduct()
+                                             .params;
+                shard.assetToPoolID[poolParams.assetA].emplace_back(
+                    key.liquidityPool().liquidityPoolID);
+                shard.assetToPoolID[poolParams.assetB].emplace_back(
+                    key.liquidityPool().liquidityPoolID);
+            }
+
+            // Unlike assetToPoolID, every TRUSTLINE record is indexed by
+            // asset: scans over the offsets must see DEADENTRY records to
+            // leave out trustlines deleted by newer buckets.
+            if (mData.indexesTrustlinesByAsset && key.type() == TRUSTLINE)
+            {
+                auto& offsets =
+                    shard.assetToTrustlineOffsets[key.trustLine().asset];
+                if (offsets.empty() || getPageEnd(offsets.back()) <= pos)
                 {
-                    auto const& poolParams = be.liveEntry()
-                                                 .data.liquidityPool()
-                                                 .body.constantProduct()
-                                                 .params;
-                    mData.assetToPoolID[poolParams.assetA].emplace_back(
-                        key.liquidityPool().liquidityPoolID);
-                    mData.assetToPoolID[poolParams.assetB].emplace_back(
-                        key.liquidityPool().liquidityPoolID);
+                    offsets.emplace_back(pos);
                 }
+            }
 
-                if constexpr (std::is_same<IndexT, RangeIndex>::value)
+            if constexpr (std::is_same<IndexT, RangeIndex>::value)
+            {
+                if (pos >= pageUpperBound)
                 {
-                    if (pos >= pageUpperBound)
-                    {
-                        pageUpperBound =
-                            roundDown(pos, mData.pageSize) + mData.pageSize;
-                        mData.keysToOffset.emplace_back(RangeEntry(key, key),
-                                                        pos);
-                    }
-                    else
-                    {
-                        auto& rangeEntry = mData.keysToOffset.back().first;
-                        releaseAssert(rangeEntry.upperBound < key);
-                        rangeEntry.upperBound = key;
-                    }
-
-                    auto keybuf = xdr::xdr_to_opaque(key);
-                    mData.filter->insert(keybuf.data(), keybuf.size());
+                    pageUpperBound =
+                        roundDown(pos, mData.pageSize) + mData.pageSize;
+                    shard.keysToOffset.emplace_back(RangeEntry(key, key),
+                                                    pos);
+                }
+                else if (shard.keysToOffset.empty())
+                {
+                    // Record belongs to a page from a previous shard
+                    releaseAssert(!shard.continuedUpperBound ||
+                                  *shard.continuedUpperBound < key);
+                    shard.continuedUpperBound = key;
                 }
                 else
                 {
-                    mData.keysToOffset.emplace_back(key, pos);
+                    auto& rangeEntry = shard.keysToOffset.back().first;
+                    releaseAssert(rangeEntry.upperBound < key);
+                    rangeEntry.upperBound = key;
                 }
+
+                auto keybuf = xdr::xdr_to_opaque(key);
+                filter->insert(keybuf.data(), keybuf.size());
             }
+            else
+            {
+                shard.keysToOffset.emplace_back(key, pos);
+            }
+        }
 
-            pos = in.pos();
+        pos = in.pos();
+    }
+}
+
+template <class IndexT>
+std::vector<typename BucketIndexImpl<IndexT>::IndexShard>
+BucketIndexImpl<IndexT>::getShards(std::filesystem::path const& filename,
+                                   size_t shardSize)
+{
+    ZoneScoped;
+    releaseAssert(shardSize > 0);
+
+    XDRInputFileStream in;
+    in.open(filename.string());
+    std::vector<IndexShard> shards(1);
+
+    // Only the first record may be a METAENTRY, so decode it to find out
+    // whether it counts towards page boundaries and skip over the rest
+    std::optional<std::streamoff> prevEntryPos;
+    BucketEntry be;
+    if (in.readOne(be) && be.type() != METAENTRY)
+    {
+        prevEntryPos = 0;
+    }
+
+    std::streamoff pos = in.pos();
+    while (in)
+    {
+        if (static_cast<size_t>(pos) >= shards.size() * shardSize)
+        {
+            shards.back().end = pos;
+            auto& shard = shards.emplace_back();
+            shard.begin = pos;
+            shard.prevEntryPos = prevEntryPos;
         }
 
-        CLOG_DEBUG(Bucket, "Indexed {} positions in {}",
-                   mData.keysToOffset.size(), filename.filename());
-        ZoneValue(static_cast<int64_t>(count));
+        if (!in.skipOne())
+        {
+            break;
+        }
+
+        prevEntryPos = pos;
+        pos = in.pos();
     }
 
-    if (bm.getConfig().isPersistingBucketListDBIndexes())
+    // If the file ends exactly at a shard boundary the last shard is empty
+    if (shards.size() > 1 && shards.back().begin == pos)
     {
-        saveToDisk(bm, hash);
+        shards.pop_back();
+    }
+
+    shards.back().end = pos;
+    return shards;
+}
+
+template <class IndexT>
+size_t
+BucketIndexImpl<IndexT>::indexShardsParallel(
+    BucketManager& bm, std::filesystem::path const& filename,
+    std::vector<IndexShard>&& shards)
+{
+    ZoneScoped;
+    releaseAssert(mData.filter);
+
+    // Each helper gets its own copy of the still empty bloom filter, so that
+    // every filter has the same parameters and can be merged
+    auto& snapshotManager = bm.getBucketSnapshotManager();
+    auto numHelpers = std::min(snapshotManager.getNumBackgroundThreads(),
+                               shards.size() - 1);
+    std::vector<std::unique_ptr<bloom_filter>> filters;
+    for (size_t i = 0; i < numHelpers; ++i)
+    {
+        filters.emplace_back(std::make_unique<bloom_filter>(*mData.filter));
+    }
+
+    parallelForBatches(
+        shards.size(), 1, numHelpers,
+        [&](std::function<void()>&& f) {
+            snapshotManager.postOnBackgroundThread(std::move(f),
+                                                   "BucketIndex: index shard");
+        },
+        [&](size_t worker, size_t i, size_t) {
+            auto filter =
+                worker == 0 ? mData.filter.get() : filters[worker - 1].get();
+            indexShard(bm, filename, shards[i], filter);
+        });
+
+    CLOG_DEBUG(Bucket, "Indexed {} in {} shards with {} helpers",
+               filename.filename(), shards.size(), numHelpers);
+
+    size_t count = 0;
+    for (auto& shard : shards)
+    {
+        count += stitchShard(shard);
+    }
+
+    // Helpers that did not claim a shard never touch their filter, so every
+    // filter is complete once all shards are
+    for (auto const& filter : filters)
+    {
+        *mData.filter |= *filter;
+    }
+
+    return count;
+}
+
+template <class IndexT>
+size_t
+BucketIndexImpl<IndexT>::stitchShard(IndexShard& shard)
+{
+    if (shard.continuedUpperBound)
+    {
+        releaseAssert(!mData.keysToOffset.empty());
+        if constexpr (std::is_same<IndexT, RangeIndex>::value)
+        {
+            auto& rangeEntry = mData.keysToOffset.back().first;
+            releaseAssert(rangeEntry.upperBound < *shard.continuedUpperBound);
+            rangeEntry.upperBound = *shard.continuedUpperBound;
+        }
+    }
+
+    mData.keysToOffset.insert(
+        mData.keysToOffset.end(),
+        std::make_move_iterator(shard.keysToOffset.begin()),
+        std::make_move_iterator(shard.keysToOffset.end()));
+    for (auto& [asset, poolIDs] : shard.assetToPoolID)
+    {
+        auto& allPoolIDs = mData.assetToPoolID[asset];
+        allPoolIDs.insert(allPoolIDs.end(), poolIDs.begin(), poolIDs.end());
+    }
+    for (auto const& [asset, offsets] : shard.assetToTrustlineOffsets)
+    {
+        // The first offset may be on the last page of the previous shard
+        auto& allOffsets = mData.assetToTrustlineOffsets[asset];
+        auto begin = offsets.begin();
+        if (!allOffsets.empty() && getPageEnd(allOffsets.back()) > *begin)
+        {
+            ++begin;
+        }
+        allOffsets.insert(allOffsets.end(), begin, offsets.end());
     }
+
+    return shard.count;
 }
 
 // Individual indexes are associated with small buckets, so it's more efficient
@@ -259,21 +554,55 @@ BucketIndexImpl<BucketIndex::RangeIndex>::saveToDisk(BucketManager& bm,
             throw std::runtime_error(err);
         }
     }
+
+    if (auto store = bm.getSharedBucketStore())
+    {
+        store->addIndex(hash, canonicalName.string());
+    }
 }
 
 template <class IndexT>
 template <class Archive>
 BucketIndexImpl<IndexT>::BucketIndexImpl(BucketManager const& bm, Archive& ar,
-                                         std::streamoff pageSize)
-    : mBloomMissMeter(bm.getBloomMissMeter())
-    , mBloomLookupMeter(bm.getBloomLookupMeter())
+                                         std::streamoff pageSize,
+                                         bool indexesTrustlinesByAsset)
+    : mBloomMisses(bm.getBloomMissCounter())
+    , mBloomLookups(bm.getBloomLookupCounter())
+    , mBloomSkips(bm.getBloomSkipCounter())
+    , mReadBytes(bm.getReadBytesCounter())
+    , mReadPageFaultsMeter(bm.getReadPageFaultsMeter())
+    , mBatchReadDepth(bm.getBatchReadDepthHistogram())
+    , mBatchReadTimer(bm.getBatchReadTimer())
+    , mUseMmapReads(bm.getConfig().BUCKETLIST_DB_MMAP_READS &&
+                    MappedFile::isSupported())
+    , mUseBatchReads(bm.getConfig().BUCKETLIST_DB_BATCH_READS)
 {
     mData.pageSize = pageSize;
+    mData.indexesTrustlinesByAsset = indexesTrustlinesByAsset;
     ar(mData);
+    buildUpperBoundPrefixes();
+}
+
+template <class IndexT>
+void
+BucketIndexImpl<IndexT>::buildUpperBoundPrefixes()
+{
+    if constexpr (std::is_same<IndexT, RangeIndex>::value)
+    {
+        mData.upperBoundPrefixes.clear();
+        mData.upperBoundPrefixes.reserve(mData.keysToOffset.size());
+        for (auto const& [rangeEntry, _] : mData.keysToOffset)
+        {
+            mData.upperBoundPrefixes.emplace_back(
+                getKeyPrefix(rangeEntry.upperBound));
+        }
+    }
 }
 
 // Returns true if the key is not contained within the given IndexEntry.
-// Range index: check if key is outside range of indexEntry
+// Range index: check if key is outside range of indexEntry. Only the lower
+// bound's prefix is stored, so keys sharing that prefix are conservatively
+// treated as in range and left to the bloom filter and disk read.
 // Individual index: check if key does not match indexEntry key
 template <class IndexEntryT>
 static bool
@@ -281,7 +610,8 @@ keyNotInIndexEntry(LedgerKey const& key, IndexEntryT const& indexEntry)
 {
     if constexpr (std::is_same<IndexEntryT, BucketIndex::RangeEntry>::value)
     {
-        return key < indexEntry.lowerBound || indexEntry.upperBound < key;
+        return BucketIndex::getKeyPrefix(key) < indexEntry.lowerBoundPrefix ||
+               indexEntry.upperBound < key;
     }
     else
     {
@@ -314,6 +644,7 @@ lower_bound_pred(IndexEntryT const& indexEntry, LedgerKey const& key)
 // If key is too small for indexEntry bounds: return true
 // If key is contained within indexEntry bounds: return false
 // If key is too large for indexEntry bounds: return false
+// As above, range entries are compared against the lower bound's prefix only.
 template <class IndexEntryT>
 static bool
 upper_bound_pred(LedgerKey const& key, IndexEntryT const& indexEntry)
@@ -321,7 +652,8 @@ upper_bound_pred(LedgerKey const& key, IndexEntryT const& indexEntry)
     if constexpr (std::is_same<IndexEntryT,
                                BucketIndex::RangeIndex::value_type>::value)
     {
-        return key < indexEntry.first.lowerBound;
+        return BucketIndex::getKeyPrefix(key) <
+               indexEntry.first.lowerBoundPrefix;
     }
     else
     {
@@ -394,16 +726,74 @@ BucketIndex::load(BucketManager const& bm,
         return {};
     }
 
+    bool indexesTrustlinesByAsset;
+    ar(indexesTrustlinesByAsset);
+    if (indexesTrustlinesByAsset !=
+        bm.getConfig().BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET)
+    {
+        return {};
+    }
+
     if (pageSize == 0)
     {
         return std::unique_ptr<BucketIndexImpl<IndividualIndex> const>(
-            new BucketIndexImpl<IndividualIndex>(bm, ar, pageSize));
+            new BucketIndexImpl<IndividualIndex>(bm, ar, pageSize,
+                                                 indexesTrustlinesByAsset));
     }
     else
     {
         return std::unique_ptr<BucketIndexImpl<RangeIndex> const>(
-            new BucketIndexImpl<RangeIndex>(bm, ar, pageSize));
+            new BucketIndexImpl<RangeIndex>(bm, ar, pageSize,
+                                            indexesTrustlinesByAsset));
+    }
+}
+
+template <class IndexT>
+typename IndexT::const_iterator
+BucketIndexImpl<IndexT>::findIndexEntry(typename IndexT::const_iterator start,
+                                        LedgerKey const& k) const
+{
+    if constexpr (std::is_same<IndexT, RangeIndex>::value)
+    {
+        // Entries with a smaller upperBound prefix end before k and entries
+        // with a larger one end after k, so full keys only need to be
+        // compared within the run of entries sharing k's prefix
+        auto const& prefixes = mData.upperBoundPrefixes;
+        releaseAssert(prefixes.size() == mData.keysToOffset.size());
+        auto begin = mData.keysToOffset.begin();
+        auto [lowPrefix, highPrefix] =
+            std::equal_range(prefixes.begin() + std::distance(begin, start),
+                             prefixes.end(), getKeyPrefix(k));
+        return std::lower_bound(
+            begin + std::distance(prefixes.begin(), lowPrefix),
+            begin + std::distance(prefixes.begin(), highPrefix), k,
+            lower_bound_pred<typename IndexT::value_type>);
+    }
+    else
+    {
+        return std::lower_bound(start, mData.keysToOffset.end(), k,
+                                lower_bound_pred<typename IndexT::value_type>);
+    }
+}
+
+template <class IndexT>
+bool
+BucketIndexImpl<IndexT>::bloomFilterRejects(LedgerKey const& k) const
+{
+    if (!mData.filter)
+    {
+        return false;
+    }
+
+    markBloomLookup();
+    auto keybuf = xdr::xdr_to_opaque(k);
+    if (!mData.filter->contains(keybuf.data(), keybuf.size()))
+    {
+        markBloomSkip();
+        return true;
     }
+
+    return false;
 }
 
 template <class IndexT>
@@ -411,7 +801,22 @@ std::optional<std::streamoff>
 BucketIndexImpl<IndexT>::lookup(LedgerKey const& k) const
 {
     ZoneScoped;
-    return scan(begin(), k).first;
+
+    // Point lookups don't need the index iterator, so check the bloom filter
+    // first and skip the index search entirely for negative lookups.
+    if (bloomFilterRejects(k))
+    {
+        return std::nullopt;
+    }
+
+    auto keyIter = findIndexEntry(mData.keysToOffset.begin(), k);
+    if (keyIter == mData.keysToOffset.end() ||
+        keyNotInIndexEntry(k, keyIter->first))
+    {
+        return std::nullopt;
+    }
+
+    return keyIter->second;
 }
 
 template <class IndexT>
@@ -426,18 +831,12 @@ BucketIndexImpl<IndexT>::scan(Iterator start, LedgerKey const& k) const
     // effecient then checking the bloom filter first, but the filter's primary
     // purpose is to avoid disk lookups, not to avoid in-memory index search.
     auto internalStart = std::get<typename IndexT::const_iterator>(start);
-    auto keyIter =
-        std::lower_bound(internalStart, mData.keysToOffset.end(), k,
-                         lower_bound_pred<typename IndexT::value_type>);
+    auto keyIter = findIndexEntry(internalStart, k);
 
-    // If the key is not in the bloom filter or in the lower bounded index
-    // entry, return nullopt
-    markBloomLookup();
-    auto keybuf = xdr::xdr_to_opaque(k);
-    if ((mData.filter &&
-         !mData.filter->contains(keybuf.data(), keybuf.size())) ||
-        keyIter == mData.keysToOffset.end() ||
-        keyNotInIndexEntry(k, keyIter->first))
+    // If the key is not in the lower bounded index entry or in the bloom
+    // filter, return nullopt
+    if (keyIter == mData.keysToOffset.end() ||
+        keyNotInIndexEntry(k, keyIter->first) || bloomFilterRejects(k))
     {
         return {std::nullopt, keyIter};
     }
@@ -453,9 +852,7 @@ BucketIndexImpl<IndexT>::getOffsetBounds(LedgerKey const& lowerBound,
                                          LedgerKey const& upperBound) const
 {
     // Get the index iterators for the bounds
-    auto startIter = std::lower_bound(
-        mData.keysToOffset.begin(), mData.keysToOffset.end(), lowerBound,
-        lower_bound_pred<typename IndexT::value_type>);
+    auto startIter = findIndexEntry(mData.keysToOffset.begin(), lowerBound);
     if (startIter == mData.keysToOffset.end())
     {
         return std::nullopt;
@@ -526,6 +923,180 @@ BucketIndexImpl<IndexT>::getOfferRange() const
     return getOffsetBounds(lowerBound, upperBound);
 }
 
+template <class IndexT>
+size_t
+BucketIndexImpl<IndexT>::getEstimatedBytes() const
+{
+    using AssetToPoolIDEntry =
+        typename decltype(mData.assetToPoolID)::value_type;
+    using AssetToTrustlineOffsetsEntry =
+        typename decltype(mData.assetToTrustlineOffsets)::value_type;
+    size_t bytes =
+        sizeof(*this) +
+        mData.keysToOffset.capacity() *
+            sizeof(typename IndexT::value_type) +
+        mData.upperBoundPrefixes.capacity() * sizeof(uint64_t) +
+        mData.assetToPoolID.size() * nodeBytes<AssetToPoolIDEntry>() +
+        mData.assetToTrustlineOffsets.size() *
+            nodeBytes<AssetToTrustlineOffsetsEntry>();
+    for (auto const& [asset, offsets] : mData.assetToTrustlineOffsets)
+    {
+        bytes += offsets.capacity() * sizeof(std::streamoff);
+    }
+    if (mData.filter)
+    {
+        bytes += mData.filter->size() / CHAR_BIT;
+    }
+    return bytes;
+}
+
+template <class IndexT>
+std::optional<std::pair<std::streamoff, std::streamoff>>
+BucketIndexImpl<IndexT>::getTypeRange(LedgerEntryType type) const
+{
+    // Every field of a default key is the smallest value of its type, except
+    // for the signed offer ID
+    LedgerKey lowerBound(type);
+    if (type == OFFER)
+    {
+        lowerBound.offer().offerID = std::numeric_limits<int64_t>::min();
+    }
+
+    // Returns true if every key of the index entry is past the type. Key
+    // prefixes start with the key type, so keys of later types have prefixes
+    // of at least nextTypePrefix.
+    auto const nextTypePrefix = (static_cast<uint64_t>(type) + 1) << 56;
+    auto pastType = [&](typename IndexT::value_type const& indexEntry) {
+        if constexpr (std::is_same<IndexT, RangeIndex>::value)
+        {
+            return indexEntry.first.lowerBoundPrefix >= nextTypePrefix;
+        }
+        else
+        {
+            return indexEntry.first.type() > type;
+        }
+    };
+
+    auto startIter = findIndexEntry(mData.keysToOffset.begin(), lowerBound);
+    if (startIter == mData.keysToOffset.end() || pastType(*startIter))
+    {
+        return std::nullopt;
+    }
+
+    auto endIter = std::partition_point(
+        std::next(startIter), mData.keysToOffset.end(),
+        [&](auto const& e) { return !pastType(e); });
+
+    std::streamoff startOff = startIter->second;
+    std::streamoff endOff = std::numeric_limits<std::streamoff>::max();
+    if (endIter != mData.keysToOffset.end())
+    {
+        endOff = endIter->second;
+    }
+
+    return std::make_pair(startOff, endOff);
+}
+
+template <class IndexT>
+std::optional<std::pair<std::streamoff, std::streamoff>>
+BucketIndexImpl<IndexT>::getContractDataRange(SCAddress const& contract) const
+{
+    // Every field of a default key after the contract is the smallest value
+    // of its type
+    LedgerKey lowerBound(CONTRACT_DATA);
+    lowerBound.contractData().contract = contract;
+
+    // Returns true if k comes after every key of the contract
+    auto pastContract = [&](LedgerKey const& k) {
+        if (k.type() != CONTRACT_DATA)
+        {
+            return k.type() > CONTRACT_DATA;
+        }
+        return contract < k.contractData().contract;
+    };
+
+    auto startIter = findIndexEntry(mData.keysToOffset.begin(), lowerBound);
+    if (startIter == mData.keysToOffset.end())
+    {
+        return std::nullopt;
+    }
+
+    // A page starts past the contract if its lower bound has a larger prefix
+    // than the keys of the contract, which all share a prefix. Pages after
+    // the first one ending past the contract start past it.
+    typename IndexT::const_iterator endIter;
+    if constexpr (std::is_same<IndexT, RangeIndex>::value)
+    {
+        if (startIter->first.lowerBoundPrefix > getKeyPrefix(lowerBound))
+        {
+            return std::nullopt;
+        }
+        endIter = std::partition_point(
+            startIter, mData.keysToOffset.end(),
+            [&](auto const& e) { return !pastContract(e.first.upperBound); });
+        if (endIter != mData.keysToOffset.end())
+        {
+            ++endIter;
+        }
+    }
+    else
+    {
+        if (pastContract(startIter->first))
+        {
+            return std::nullopt;
+        }
+        endIter = std::partition_point(
+            startIter, mData.keysToOffset.end(),
+            [&](auto const& e) { return !pastContract(e.first); });
+    }
+
+    std::streamoff startOff = startIter->second;
+    std::streamoff endOff = std::numeric_limits<std::streamoff>::max();
+    if (endIter != mData.keysToOffset.end())
+    {
+        endOff = endIter->second;
+    }
+
+    return std::make_pair(startOff, endOff);
+}
+
+template <class IndexT>
+std::streamoff
+BucketIndexImpl<IndexT>::getPageEnd(std::streamoff pos) const
+{
+    if constexpr (std::is_same<IndexT, RangeIndex>::value)
+    {
+        return roundDown(pos, mData.pageSize) + mData.pageSize;
+    }
+    else
+    {
+        return pos + 1;
+    }
+}
+
+template <class IndexT>
+std::optional<std::vector<std::pair<std::streamoff, std::streamoff>>>
+BucketIndexImpl<IndexT>::getTrustlineRangesByAsset(
+    TrustLineAsset const& asset) const
+{
+    if (!mData.indexesTrustlinesByAsset)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<std::pair<std::streamoff, std::streamoff>> ranges;
+    auto iter = mData.assetToTrustlineOffsets.find(asset);
+    if (iter != mData.assetToTrustlineOffsets.end())
+    {
+        ranges.reserve(iter->second.size());
+        for (auto pos : iter->second)
+        {
+            ranges.emplace_back(pos, getPageEnd(pos));
+        }
+    }
+    return ranges;
+}
+
 #ifdef BUILD_TESTS
 template <class IndexT>
 bool
@@ -537,7 +1108,8 @@ BucketIndexImpl<IndexT>::operator==(BucketIndex const& inRaw) const
     }
 
     auto const& in = dynamic_cast<BucketIndexImpl<IndexT> const&>(inRaw);
-    if (mData.keysToOffset.size() != in.mData.keysToOffset.size())
+    if (mData.keysToOffset.size() != in.mData.keysToOffset.size() ||
+        mData.assetToTrustlineOffsets != in.mData.assetToTrustlineOffsets)
     {
         return false;
     }
@@ -581,7 +1153,7 @@ template <>
 void
 BucketIndexImpl<BucketIndex::RangeIndex>::markBloomMiss() const
 {
-    mBloomMissMeter.Mark();
+    mBloomMisses.add();
 }
 
 template <class IndexT>
@@ -594,6 +1166,40 @@ template <>
 void
 BucketIndexImpl<BucketIndex::RangeIndex>::markBloomLookup() const
 {
-    mBloomLookupMeter.Mark();
+    mBloomLookups.add();
+}
+
+template <class IndexT>
+void
+BucketIndexImpl<IndexT>::markBloomSkip() const
+{
+}
+
+template <>
+void
+BucketIndexImpl<BucketIndex::RangeIndex>::markBloomSkip() const
+{
+    mBloomSkips.add();
+}
+
+template <class IndexT>
+void
+BucketIndexImpl<IndexT>::markRead(size_t bytesTouched,
+                                  uint64_t pageFaults) const
+{
+    mReadBytes.add(bytesTouched);
+    if (pageFaults != 0)
+    {
+        mReadPageFaultsMeter.Mark(pageFaults);
+    }
+}
+
+template <class IndexT>
+void
+BucketIndexImpl<IndexT>::markBatchRead(size_t depth,
+                                       std::chrono::nanoseconds duration) const
+{
+    mBatchReadDepth.Update(depth);
+    mBatchReadTimer.Update(duration);
+}
 }
-}
\ No newline at end of file
@@ -5,10 +5,14 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "bucket/BucketIndex.h"
+#include "medida/histogram.h"
 #include "medida/meter.h"
+#include "medida/timer.h"
+#include "util/ShardedCounter.h"
 
 #include <cereal/types/map.hpp>
 #include <map>
+#include <optional>
 
 class bloom_filter;
 
@@ -33,45 +37,129 @@ template <class IndexT> class BucketIndexImpl : public BucketIndex
         std::unique_ptr<bloom_filter> filter{};
         std::map<Asset, std::vector<PoolID>> assetToPoolID{};
 
+        // Set if built with BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET, in which
+        // case assetToTrustlineOffsets maps the asset of every TRUSTLINE
+        // record to the offset of its first record on each page (or of every
+        // record for IndividualIndex)
+        bool indexesTrustlinesByAsset{};
+        std::map<TrustLineAsset, std::vector<std::streamoff>>
+            assetToTrustlineOffsets{};
+
+        // RangeIndex only: getKeyPrefix() of each upperBound in keysToOffset,
+        // stored contiguously so index search mostly touches this array
+        // instead of full keys. Derived from keysToOffset, so not serialized.
+        std::vector<uint64_t> upperBoundPrefixes{};
+
         template <class Archive>
         void
         save(Archive& ar) const
         {
             auto version = BUCKET_INDEX_VERSION;
-            ar(version, pageSize, assetToPoolID, keysToOffset, filter);
+            ar(version, pageSize, indexesTrustlinesByAsset, assetToPoolID,
+               assetToTrustlineOffsets, keysToOffset, filter);
         }
 
-        // Note: version and pageSize must be loaded before this function is
-        // called. pageSize determines template type, so pageSize should be
-        // loaded, checked, and then call this function with the appropriate
-        // template type
+        // Note: version, pageSize and indexesTrustlinesByAsset must be loaded
+        // before this function is called. pageSize determines template type,
+        // so pageSize should be loaded, checked, and then call this function
+        // with the appropriate template type
         template <class Archive>
         void
         load(Archive& ar)
         {
-            ar(assetToPoolID, keysToOffset, filter);
+            ar(assetToPoolID, assetToTrustlineOffsets, keysToOffset, filter);
         }
     } mData;
 
-    medida::Meter& mBloomMissMeter;
-    medida::Meter& mBloomLookupMeter;
+    // Partial index over a record aligned byte range [begin, end) of a bucket
+    // file. Shards are indexed independently and then stitched in file order.
+    struct IndexShard
+    {
+        std::streamoff begin{};
+        std::streamoff end{};
+
+        // Offset of the last non-METAENTRY record before begin, if any. Page
+        // boundaries only depend on the offset of the previous record.
+        std::optional<std::streamoff> prevEntryPos{};
+
+        IndexT keysToOffset{};
+        std::map<Asset, std::vector<PoolID>> assetToPoolID{};
+        std::map<TrustLineAsset, std::vector<std::streamoff>>
+            assetToTrustlineOffsets{};
+
+        // RangeIndex only: largest key of the leading records that belong to
+        // a page started by a previous shard
+        std::optional<LedgerKey> continuedUpperBound{};
+
+        size_t count{};
+    };
+
+    ShardedCounter& mBloomMisses;
+    ShardedCounter& mBloomLookups;
+    ShardedCounter& mBloomSkips;
+    ShardedCounter& mReadBytes;
+    medida::Meter& mReadPageFaultsMeter;
+    medida::Histogram& mBatchReadDepth;
+    medida::Timer& mBatchReadTimer;
+    bool const mUseMmapReads;
+    bool const mUseBatchReads;
+
+    // Returns true if the bloom filter guarantees k is not in the bucket.
+    // Individual indexes have no filter and always return false.
+    bool bloomFilterRejects(LedgerKey const& k) const;
 
     BucketIndexImpl(BucketManager& bm, std::filesystem::path const& filename,
                     std::streamoff pageSize, Hash const& hash);
 
     template <class Archive>
     BucketIndexImpl(BucketManager const& bm, Archive& ar,
-                    std::streamoff pageSize);
+                    std::streamoff pageSize, bool indexesTrustlinesByAsset);
+
+    // Indexes every record in shard, inserting keys into filter if non-null.
+    // Safe to call concurrently on different shards and filters.
+    void indexShard(BucketManager const& bm,
+                    std::filesystem::path const& filename, IndexShard& shard,
+                    bloom_filter* filter) const;
+
+    // Splits filename into shards of roughly shardSize bytes at record
+    // boundaries, without decoding records past the first
+    static std::vector<IndexShard>
+    getShards(std::filesystem::path const& filename, size_t shardSize);
+
+    // Indexes shards concurrently on the worker thread pool, then stitches
+    // the results into mData. Returns the number of entries indexed.
+    size_t indexShardsParallel(BucketManager& bm,
+                               std::filesystem::path const& filename,
+                               std::vector<IndexShard>&& shards);
+
+    // Appends shard to mData. Shards must be stitched in file order. Returns
+    // the number of entries in shard.
+    size_t stitchShard(IndexShard& shard);
 
     // Saves index to disk, overwriting any preexisting file for this index
     void saveToDisk(BucketManager& bm, Hash const& hash) const;
 
+    // Populates mData.upperBoundPrefixes from mData.keysToOffset
+    void buildUpperBoundPrefixes();
+
+    // Returns the first index entry at or after start that does not come
+    // before k, equivalent to std::lower_bound with lower_bound_pred. For
+    // RangeIndex, only entries whose upperBound prefix equals k's prefix are
+    // compared with full keys.
+    typename IndexT::const_iterator
+    findIndexEntry(typename IndexT::const_iterator start,
+                   LedgerKey const& k) const;
+
     // Returns [lowFileOffset, highFileOffset) that contain the key ranges
     // [lowerBound, upperBound]. If no file offsets exist, returns [0, 0]
     std::optional<std::pair<std::streamoff, std::streamoff>>
     getOffsetBounds(LedgerKey const& lowerBound,
                     LedgerKey const& upperBound) const;
 
+    // Returns the end of the page holding the record starting at pos, or just
+    // past pos for IndividualIndex. Every record of the page starts before it.
+    std::streamoff getPageEnd(std::streamoff pos) const;
+
     friend BucketIndex;
 
   public:
@@ -90,12 +178,24 @@ template <class IndexT> class BucketIndexImpl : public BucketIndex
     virtual std::optional<std::pair<std::streamoff, std::streamoff>>
     getOfferRange() const override;
 
+    virtual std::optional<std::pair<std::streamoff, std::streamoff>>
+    getTypeRange(LedgerEntryType type) const override;
+
+    virtual std::optional<std::pair<std::streamoff, std::streamoff>>
+    getContractDataRange(SCAddress const& contract) const override;
+
+    virtual std::optional<
+        std::vector<std::pair<std::streamoff, std::streamoff>>>
+    getTrustlineRangesByAsset(TrustLineAsset const& asset) const override;
+
     virtual std::streamoff
     getPageSize() const override
     {
         return mData.pageSize;
     }
 
+    virtual size_t getEstimatedBytes() const override;
+
     virtual Iterator
     begin() const override
     {
@@ -110,6 +210,25 @@ template <class IndexT> class BucketIndexImpl : public BucketIndex
 
     virtual void markBloomMiss() const override;
     virtual void markBloomLookup() const override;
+    virtual void markBloomSkip() const override;
+    virtual void markRead(size_t bytesTouched,
+                          uint64_t pageFaults) const override;
+
+    virtual bool
+    useMmapReads() const override
+    {
+        return mUseMmapReads;
+    }
+
+    virtual bool
+    useBatchReads() const override
+    {
+        return mUseBatchReads;
+    }
+
+    virtual void
+    markBatchRead(size_t depth,
+                  std::chrono::nanoseconds duration) const override;
 
 #ifdef BUILD_TESTS
     virtual bool operator==(BucketIndex const& inRaw) const override;
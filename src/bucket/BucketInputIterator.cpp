@@ -4,7 +4,7 @@
 
 #include "bucket/BucketInputIterator.h"
 #include "bucket/Bucket.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
@@ -87,7 +87,8 @@ BucketInputIterator::getMetadata() const
     return mMetadata;
 }
 
-BucketInputIterator::BucketInputIterator(std::shared_ptr<Bucket const> bucket)
+BucketInputIterator::BucketInputIterator(std::shared_ptr<Bucket const> bucket,
+                                         size_t readBufferSize)
     : mBucket(bucket), mEntryPtr(nullptr), mSeenMetadata(false)
 {
     // In absence of metadata, we treat every bucket as though it is from ledger
@@ -101,6 +102,12 @@ BucketInputIterator::BucketInputIterator(std::shared_ptr<Bucket const> bucket)
     {
         CLOG_TRACE(Bucket, "BucketInputIterator opening file to read: {}",
                    mBucket->getFilename());
+        if (readBufferSize != 0)
+        {
+            // No need for a buffer larger than the file itself
+            mIn.setReadBufferSize(
+                std::min(readBufferSize, mBucket->getSize()));
+        }
         mIn.open(mBucket->getFilename().string());
         loadEntry();
     }
@@ -45,7 +45,10 @@ class BucketInputIterator
 
     BucketEntry const& operator*();
 
-    BucketInputIterator(std::shared_ptr<Bucket const> bucket);
+    // If readBufferSize is non-zero, the bucket file is read through a buffer
+    // of up to readBufferSize bytes instead of the default stream buffer
+    BucketInputIterator(std::shared_ptr<Bucket const> bucket,
+                        size_t readBufferSize = 0);
 
     ~BucketInputIterator();
 
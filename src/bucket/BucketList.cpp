@@ -17,8 +17,10 @@
 #include "util/types.h"
 
 #include "medida/counter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -181,6 +183,38 @@ BucketLevel::prepare(Application& app, uint32_t currLedger,
     releaseAssert(mNextCurr.isMerging());
 }
 
+void
+BucketLevel::prepareFirstLevel(Application& app, uint32_t currLedger,
+                               uint32_t currLedgerProtocol,
+                               std::shared_ptr<Bucket> snap,
+                               bool countMergeEvents)
+{
+    ZoneScoped;
+    releaseAssert(mLevel == 0);
+    releaseAssert(!mNextCurr.isMerging());
+    if (protocolVersionIsBefore(currLedgerProtocol,
+                                Bucket::FIRST_PROTOCOL_SHADOWS_REMOVED))
+    {
+        prepare(app, currLedger, currLedgerProtocol, snap, {},
+                countMergeEvents);
+        commit();
+        return;
+    }
+
+    auto curr = BucketList::shouldMergeWithEmptyCurr(currLedger, mLevel)
+                    ? std::make_shared<Bucket>()
+                    : mCurr;
+    auto& bm = app.getBucketManager();
+    auto timeScope = app.getMetrics()
+                         .NewTimer({"bucket", "merge-time",
+                                    "level-" + std::to_string(mLevel)})
+                         .TimeScope();
+    setCurr(Bucket::mergeInMemory(
+        bm, currLedgerProtocol, curr, snap,
+        BucketList::keepDeadEntries(mLevel), countMergeEvents,
+        app.getClock().getIOContext(), !app.getConfig().DISABLE_XDR_FSYNC));
+}
+
 std::shared_ptr<Bucket>
 BucketLevel::snap()
 {
@@ -509,6 +543,12 @@ BucketList::getSize() const
     return sum;
 }
 
+std::chrono::nanoseconds
+BucketList::getMergeWaitTime() const
+{
+    return mMergeWaitTime;
+}
+
 void
 BucketList::addBatch(Application& app, uint32_t currLedger,
                      uint32_t currLedgerProtocol,
@@ -596,7 +636,9 @@ BucketList::addBatch(Application& app, uint32_t currLedger,
              */
 
             auto snap = mLevels[i - 1].snap();
+            auto waitStart = std::chrono::steady_clock::now();
             mLevels[i].commit();
+            mMergeWaitTime += std::chrono::steady_clock::now() - waitStart;
             mLevels[i].prepare(app, currLedger, currLedgerProtocol, snap,
                                shadows, /*countMergeEvents=*/true);
         }
@@ -609,13 +651,13 @@ BucketList::addBatch(Application& app, uint32_t currLedger,
         !app.getConfig().ARTIFICIALLY_REDUCE_MERGE_COUNTS_FOR_TESTING;
     bool doFsync = !app.getConfig().DISABLE_XDR_FSYNC;
     releaseAssert(shadows.size() == 0);
-    mLevels[0].prepare(app, currLedger, currLedgerProtocol,
-                       Bucket::fresh(app.getBucketManager(), currLedgerProtocol,
-                                     initEntries, liveEntries, deadEntries,
-                                     countMergeEvents,
-                                     app.getClock().getIOContext(), doFsync),
-                       shadows, countMergeEvents);
-    mLevels[0].commit();
+    mLevels[0].prepareFirstLevel(
+        app, currLedger, currLedgerProtocol,
+        Bucket::fresh(app.getBucketManager(), currLedgerProtocol, initEntries,
+                      liveEntries, deadEntries, countMergeEvents,
+                      app.getClock().getIOContext(), doFsync,
+                      /*storeInMemory=*/true),
+        countMergeEvents);
 
     // We almost always want to try to resolve completed merges to single
     // buckets, as it makes restarts less fragile: fewer saved/restored shadows,
@@ -6,6 +6,7 @@
 
 #include "bucket/Bucket.h"
 #include "bucket/FutureBucket.h"
+#include <chrono>
 
 namespace medida
 {
@@ -376,6 +377,13 @@ class BucketLevel
                  uint32_t currLedgerProtocol, std::shared_ptr<Bucket> snap,
                  std::vector<std::shared_ptr<Bucket>> const& shadows,
                  bool countMergeEvents);
+    // Level 0 counterpart of prepare followed by commit: merges `snap`, the
+    // fresh bucket of the ledger, into mCurr in memory, or falls back to
+    // prepare for protocols that still have shadows.
+    void prepareFirstLevel(Application& app, uint32_t currLedger,
+                           uint32_t currLedgerProtocol,
+                           std::shared_ptr<Bucket> snap,
+                           bool countMergeEvents);
     std::shared_ptr<Bucket> snap();
 };
 
@@ -400,6 +408,7 @@ class BucketListDepth
 class BucketList
 {
     std::vector<BucketLevel> mLevels;
+    std::chrono::nanoseconds mMergeWaitTime{0};
 
   public:
     // Number of bucket levels in the bucketlist. Every bucketlist in the system
@@ -511,6 +520,10 @@ class BucketList
     // FutureBuckets
     uint64_t getSize() const;
 
+    // Returns the total time addBatch waited for the merges of the levels it
+    // committed to finish
+    std::chrono::nanoseconds getMergeWaitTime() const;
+
     // Add a batch of initial (created), live (updated) and dead entries to the
     // bucketlist, representing the entries effected by closing
     // `currLedger`. The bucketlist will incorporate these into the smallest
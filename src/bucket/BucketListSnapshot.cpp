@@ -3,16 +3,21 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "bucket/BucketListSnapshot.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketInputIterator.h"
 #include "crypto/SecretKey.h" // IWYU pragma: keep
 #include "ledger/LedgerTxn.h"
+#include "util/ParallelFor.h"
 
 #include "medida/timer.h"
 
+#include <limits>
+
 namespace stellar
 {
 
-BucketListSnapshot::BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq)
+BucketListSnapshot::BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq,
+                                       uint32_t inMemoryLevels)
     : mLedgerSeq(ledgerSeq)
 {
     releaseAssert(threadIsMain());
@@ -20,7 +25,7 @@ BucketListSnapshot::BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq)
     for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
     {
         auto const& level = bl.getLevel(i);
-        mLevels.emplace_back(BucketLevelSnapshot(level));
+        mLevels.emplace_back(BucketLevelSnapshot(level, i < inMemoryLevels));
     }
 }
 
@@ -85,21 +90,57 @@ SearchableBucketListSnapshot::scanForEviction(
     BucketList::updateStartingEvictionIterator(
         evictionIter, sas.startingEvictionScanLevel, ledgerSeq);
 
-    EvictionResult result(sas);
+    // The part of one bucket the scan region covers. Each segment has a
+    // private copy of its bucket, as in loadKeysParallel.
+    struct Segment
+    {
+        std::unique_ptr<BucketSnapshot const> bucket;
+        EvictionIterator iter;
+        uint32_t bytesToScan;
+        std::list<EvictionResultEntry> eligibleKeys;
+    };
+    std::vector<Segment> segments;
+
+    // The scan region only depends on the size of the buckets, so plan which
+    // part of which bucket it covers first, moving the iterator and recording
+    // statistics exactly as a scan going through it bucket by bucket does.
     auto startIter = evictionIter;
     auto scanSize = sas.evictionScanSize;
-
+    bool regionEndsInSegment = false;
     for (;;)
     {
         auto const& b = getBucketFromIter(evictionIter);
         BucketList::checkIfEvictionScanIsStuck(
             evictionIter, sas.evictionScanSize, b.getRawBucket(), counters);
 
-        // If we scan scanSize before hitting bucket EOF, exit early
-        if (b.scanForEviction(evictionIter, scanSize, ledgerSeq,
-                              result.eligibleKeys, *this))
+        if (!b.isSkippedByEvictionScan())
         {
-            break;
+            // Scan region is empty
+            if (scanSize == 0)
+            {
+                break;
+            }
+
+            auto size = b.getRawBucket()->getSize();
+            auto left = size > evictionIter.bucketFileOffset
+                            ? size - evictionIter.bucketFileOffset
+                            : 0;
+            regionEndsInSegment = left >= scanSize;
+            if (left != 0)
+            {
+                auto bytesToScan = regionEndsInSegment
+                                       ? scanSize
+                                       : static_cast<uint32_t>(left);
+                segments.push_back(
+                    {std::unique_ptr<BucketSnapshot const>(
+                         new BucketSnapshot(b)),
+                     evictionIter, bytesToScan});
+                scanSize -= bytesToScan;
+            }
+            if (regionEndsInSegment)
+            {
+                break;
+            }
         }
 
         // If we return back to the Bucket we started at, exit
@@ -111,7 +152,40 @@ SearchableBucketListSnapshot::scanForEviction(
         }
     }
 
-    result.endOfRegionIterator = evictionIter;
+    // TTLs are loaded through a snapshot of each worker's own. The calling
+    // thread is worker 0 and uses this one.
+    auto maxHelpers = mSnapshotManager.getNumBackgroundThreads();
+    std::vector<std::shared_ptr<SearchableBucketListSnapshot>> snapshots(
+        maxHelpers + 1);
+    parallelForBatches(
+        segments.size(), 1, maxHelpers,
+        [&](std::function<void()>&& f) {
+            mSnapshotManager.postOnBackgroundThread(
+                std::move(f), "SearchableBucketListSnapshot: eviction scan",
+                BackgroundPriority::HIGH);
+        },
+        [&](size_t worker, size_t i, size_t) {
+            auto& bl = snapshots.at(worker);
+            if (worker != 0 && !bl)
+            {
+                bl = mSnapshotManager.getSearchableBucketListSnapshot();
+            }
+            auto& segment = segments.at(i);
+            segment.bucket->scanForEviction(
+                segment.iter, segment.bytesToScan, ledgerSeq,
+                segment.eligibleKeys, worker == 0 ? *this : *bl);
+        });
+
+    // Segments are in scan order, so their candidates are too
+    EvictionResult result(sas);
+    for (auto& segment : segments)
+    {
+        result.eligibleKeys.splice(result.eligibleKeys.end(),
+                                   segment.eligibleKeys);
+    }
+    result.endOfRegionIterator = regionEndsInSegment
+                                     ? segments.back().iter
+                                     : evictionIter;
     result.initialLedger = ledgerSeq;
     return result;
 }
@@ -136,9 +210,24 @@ SearchableBucketListSnapshot::getLedgerEntry(LedgerKey const& k)
     }
 }
 
+uint32_t
+SearchableBucketListSnapshot::getLedgerSeq() const
+{
+    releaseAssert(mSnapshot);
+    return mSnapshot->getLedgerSeq();
+}
+
 std::pair<std::shared_ptr<LedgerEntry>, bool>
 SearchableBucketListSnapshot::getLedgerEntryInternal(LedgerKey const& k)
 {
+    auto ledgerSeq = mSnapshot->getLedgerSeq();
+    if (auto cached = mSnapshotManager.getCachedEntry(k, ledgerSeq))
+    {
+        // Return a copy so callers can't modify the shared cached entry
+        return {*cached ? std::make_shared<LedgerEntry>(**cached) : nullptr,
+                false};
+    }
+
     std::shared_ptr<LedgerEntry> result{};
     auto sawBloomMiss = false;
 
@@ -161,6 +250,7 @@ SearchableBucketListSnapshot::getLedgerEntryInternal(LedgerKey const& k)
     };
 
     loopAllBuckets(f);
+    mSnapshotManager.cacheEntry(k, result, ledgerSeq);
     return {result, sawBloomMiss};
 }
 
@@ -168,6 +258,39 @@ std::vector<LedgerEntry>
 SearchableBucketListSnapshot::loadKeysInternal(
     std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys)
 {
+    if (mSnapshotManager.isEntryCacheEnabled())
+    {
+        auto ledgerSeq = mSnapshot->getLedgerSeq();
+        std::vector<LedgerEntry> entries;
+        auto keysToLoad = inKeys;
+        mSnapshotManager.getCachedEntries(keysToLoad, entries, ledgerSeq);
+        if (!keysToLoad.empty())
+        {
+            auto loaded = loadKeysFromBuckets(keysToLoad);
+            mSnapshotManager.cacheEntries(keysToLoad, loaded, ledgerSeq);
+            entries.insert(entries.end(),
+                           std::make_move_iterator(loaded.begin()),
+                           std::make_move_iterator(loaded.end()));
+        }
+        return entries;
+    }
+
+    return loadKeysFromBuckets(inKeys);
+}
+
+std::vector<LedgerEntry>
+SearchableBucketListSnapshot::loadKeysFromBuckets(
+    std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys)
+{
+    // Only fan out loads from the main thread so background callers (i.e. the
+    // eviction scan) don't compete with ledger close for the worker pool
+    if (auto minKeys = mSnapshotManager.getParallelLoadMinKeys();
+        minKeys != 0 && inKeys.size() >= minKeys && threadIsMain() &&
+        mSnapshotManager.getNumBackgroundThreads() != 0)
+    {
+        return loadKeysParallel(inKeys);
+    }
+
     std::vector<LedgerEntry> entries;
 
     // Make a copy of the key set, this loop is destructive
@@ -181,6 +304,58 @@ SearchableBucketListSnapshot::loadKeysInternal(
     return entries;
 }
 
+std::vector<LedgerEntry>
+SearchableBucketListSnapshot::loadKeysParallel(
+    std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys)
+{
+    ZoneScoped;
+
+    std::vector<LedgerKey> keys(inKeys.begin(), inKeys.end());
+
+    // Private copies of every non-empty bucket in level order. Each
+    // BucketSnapshot owns its own file stream, so a copy must only be used by
+    // one thread at a time.
+    std::vector<std::unique_ptr<BucketSnapshot const>> buckets;
+    loopAllBuckets([&](BucketSnapshot const& b) {
+        buckets.emplace_back(new BucketSnapshot(b));
+        return false;
+    });
+    std::vector<std::vector<std::pair<size_t, BucketEntry>>> results(
+        buckets.size());
+
+    parallelForBatches(
+        buckets.size(), 1, mSnapshotManager.getNumBackgroundThreads(),
+        [&](std::function<void()>&& f) {
+            mSnapshotManager.postOnBackgroundThread(
+                std::move(f), "SearchableBucketListSnapshot: parallel load",
+                BackgroundPriority::HIGH);
+        },
+        [&](size_t, size_t i, size_t) {
+            buckets[i]->lookupKeys(keys, results[i]);
+        });
+
+    // Resolve shadowing: the first bucket in level order that contains a key
+    // determines its state
+    std::vector<bool> resolved(keys.size(), false);
+    std::vector<LedgerEntry> entries;
+    for (auto& bucketResult : results)
+    {
+        for (auto& [keyIndex, be] : bucketResult)
+        {
+            if (!resolved.at(keyIndex))
+            {
+                resolved[keyIndex] = true;
+                if (be.type() != DEADENTRY)
+                {
+                    entries.emplace_back(std::move(be.liveEntry()));
+                }
+            }
+        }
+    }
+
+    return entries;
+}
+
 std::vector<LedgerEntry>
 SearchableBucketListSnapshot::loadKeys(
     std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys)
@@ -201,6 +376,47 @@ SearchableBucketListSnapshot::loadKeys(
     }
 }
 
+std::optional<std::vector<LedgerEntry>>
+SearchableBucketListSnapshot::loadKeysFromLedger(
+    std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys, uint32_t ledgerSeq)
+{
+    ZoneScoped;
+    mSnapshotManager.maybeUpdateSnapshot(mSnapshot);
+    if (ledgerSeq == mSnapshot->getLedgerSeq())
+    {
+        return loadKeysInternal(inKeys);
+    }
+
+    if (!mHistoricalSnapshot ||
+        mHistoricalSnapshot->getLedgerSeq() != ledgerSeq)
+    {
+        mHistoricalSnapshot = mSnapshotManager.copyRetainedSnapshot(ledgerSeq);
+        if (!mHistoricalSnapshot)
+        {
+            return std::nullopt;
+        }
+    }
+
+    // The entry cache only holds entries of the current ledger
+    std::vector<LedgerEntry> entries;
+    auto keys = inKeys;
+    for (auto const& lev : mHistoricalSnapshot->getLevels())
+    {
+        for (auto const* b : {&lev.curr, &lev.snap})
+        {
+            if (!b->isEmpty())
+            {
+                b->loadKeys(keys, entries);
+            }
+        }
+        if (keys.empty())
+        {
+            break;
+        }
+    }
+    return entries;
+}
+
 // This query has two steps:
 //  1. For each bucket, determine what PoolIDs contain the target asset via the
 //     assetToPoolID index
@@ -240,6 +456,102 @@ SearchableBucketListSnapshot::loadPoolShareTrustLinesByAccountAndAsset(
     return loadKeysInternal(trustlinesToLoad);
 }
 
+std::vector<LedgerEntry>
+SearchableBucketListSnapshot::loadMatchingEntries(
+    std::function<std::vector<std::pair<std::streamoff, std::streamoff>>(
+        BucketIndex const&)> const& getRanges,
+    std::function<bool(LedgerKey const&)> const& matches, size_t limit,
+    bool& truncated)
+{
+    ZoneScoped;
+    mSnapshotManager.maybeUpdateSnapshot(mSnapshot);
+
+    std::vector<LedgerEntry> entries;
+    LedgerKeySet seenKeys;
+    truncated = false;
+    loopAllBuckets([&](BucketSnapshot const& b) {
+        auto ranges = getRanges(b.getRawBucket()->getIndex());
+        b.scanRanges(ranges, [&](BucketEntry const& be) {
+            auto key = getBucketLedgerKey(be);
+            if (!matches(key) || !seenKeys.emplace(key).second ||
+                be.type() == DEADENTRY)
+            {
+                return true;
+            }
+            if (entries.size() == limit)
+            {
+                truncated = true;
+                return false;
+            }
+            entries.emplace_back(be.liveEntry());
+            return true;
+        });
+        return truncated;
+    });
+    return entries;
+}
+
+std::vector<LedgerEntry>
+SearchableBucketListSnapshot::loadContractData(SCAddress const& contract,
+                                               size_t limit, bool& truncated)
+{
+    ZoneScoped;
+    return loadMatchingEntries(
+        [&](BucketIndex const& index) {
+            std::vector<std::pair<std::streamoff, std::streamoff>> ranges;
+            if (auto range = index.getContractDataRange(contract))
+            {
+                ranges.emplace_back(*range);
+            }
+            return ranges;
+        },
+        [&](LedgerKey const& k) {
+            return k.type() == CONTRACT_DATA &&
+                   k.contractData().contract == contract;
+        },
+        limit, truncated);
+}
+
+std::vector<LedgerEntry>
+SearchableBucketListSnapshot::loadTrustlinesByAsset(
+    TrustLineAsset const& asset, size_t limit, bool& truncated)
+{
+    ZoneScoped;
+    return loadMatchingEntries(
+        [&](BucketIndex const& index) {
+            auto ranges = index.getTrustlineRangesByAsset(asset);
+            if (!ranges)
+            {
+                throw std::runtime_error(
+                    "Trustlines are only indexed by asset with "
+                    "BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET");
+            }
+            return *ranges;
+        },
+        [&](LedgerKey const& k) {
+            return k.type() == TRUSTLINE && k.trustLine().asset == asset;
+        },
+        limit, truncated);
+}
+
+std::vector<LedgerEntry>
+SearchableBucketListSnapshot::loadAllOffers()
+{
+    ZoneScoped;
+    bool truncated;
+    return loadMatchingEntries(
+        [](BucketIndex const& index) {
+            std::vector<std::pair<std::streamoff, std::streamoff>> ranges;
+            if (auto range = index.getOfferRange())
+            {
+                ranges.emplace_back(*range);
+            }
+            return ranges;
+        },
+        [](LedgerKey const& k) { return k.type() == OFFER; },
+        std::numeric_limits<size_t>::max(), truncated);
+}
+
 std::vector<InflationWinner>
 SearchableBucketListSnapshot::loadInflationWinners(size_t maxWinners,
                                                    int64_t minBalance)
@@ -332,9 +644,20 @@ SearchableBucketListSnapshot::loadInflationWinners(size_t maxWinners,
     return winners;
 }
 
-BucketLevelSnapshot::BucketLevelSnapshot(BucketLevel const& level)
-    : curr(level.getCurr()), snap(level.getSnap())
+BucketLevelSnapshot::BucketLevelSnapshot(BucketLevel const& level,
+                                         bool inMemory)
+    : curr(level.getCurr(),
+           inMemory ? level.getCurr()->getSnapshotEntries() : nullptr)
+    , snap(level.getSnap(),
+           inMemory ? level.getSnap()->getSnapshotEntries() : nullptr)
 {
+    if (!inMemory)
+    {
+        // Buckets that went down past the levels kept in memory no longer
+        // need their entries
+        level.getCurr()->freeSnapshotEntries();
+        level.getSnap()->freeSnapshotEntries();
+    }
 }
 
 SearchableBucketListSnapshot::SearchableBucketListSnapshot(
@@ -22,7 +22,9 @@ struct BucketLevelSnapshot
     BucketSnapshot curr;
     BucketSnapshot snap;
 
-    BucketLevelSnapshot(BucketLevel const& level);
+    // With `inMemory`, lookups are served from the entries of the buckets
+    // kept in memory rather than from the bucket files
+    BucketLevelSnapshot(BucketLevel const& level, bool inMemory);
 };
 
 class BucketListSnapshot : public NonMovable
@@ -34,7 +36,10 @@ class BucketListSnapshot : public NonMovable
     uint32_t mLedgerSeq;
 
   public:
-    BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq);
+    // The buckets of the top `inMemoryLevels` levels are kept in memory, see
+    // BUCKETLIST_DB_IN_MEMORY_LEVELS
+    BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq,
+                       uint32_t inMemoryLevels = 0);
 
     // Only allow copies via constructor
     BucketListSnapshot(BucketListSnapshot const& snapshot);
@@ -60,19 +65,43 @@ class SearchableBucketListSnapshot : public NonMovableOrCopyable
     // Snapshot managed by SnapshotManager
     std::unique_ptr<BucketListSnapshot const> mSnapshot{};
 
+    // Retained snapshot the last historical load read from
+    std::unique_ptr<BucketListSnapshot const> mHistoricalSnapshot{};
+
     // Loops through all buckets, starting with curr at level 0, then snap at
     // level 0, etc. Calls f on each bucket. Exits early if function
     // returns true
     void loopAllBuckets(std::function<bool(BucketSnapshot const&)> f) const;
 
+    // Loads keys, serving them from the BucketSnapshotManager entry cache when
+    // possible
     std::vector<LedgerEntry>
     loadKeysInternal(std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys);
 
+    // Loads keys by searching the buckets of mSnapshot, bypassing the cache
+    std::vector<LedgerEntry>
+    loadKeysFromBuckets(std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys);
+
+    // Equivalent to loadKeysInternal, but searches every bucket concurrently
+    // on the worker thread pool and then resolves shadowing in level order.
+    std::vector<LedgerEntry>
+    loadKeysParallel(std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys);
+
     // Loads bucket entry for LedgerKey k. Returns <LedgerEntry, bloomMiss>,
     // where bloomMiss is true if a bloom miss occurred during the load.
     std::pair<std::shared_ptr<LedgerEntry>, bool>
     getLedgerEntryInternal(LedgerKey const& k);
 
+    // Reads the ranges getRanges returns for each bucket, newest first, and
+    // returns the live entries whose keys pass matches and aren't shadowed by
+    // a newer bucket. Returns at most limit entries, setting truncated if
+    // there are more.
+    std::vector<LedgerEntry> loadMatchingEntries(
+        std::function<std::vector<std::pair<std::streamoff, std::streamoff>>(
+            BucketIndex const&)> const& getRanges,
+        std::function<bool(LedgerKey const&)> const& matches, size_t limit,
+        bool& truncated);
+
     SearchableBucketListSnapshot(BucketSnapshotManager const& snapshotManager);
 
     friend std::shared_ptr<SearchableBucketListSnapshot>
@@ -82,6 +111,13 @@ class SearchableBucketListSnapshot : public NonMovableOrCopyable
     std::vector<LedgerEntry>
     loadKeys(std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys);
 
+    // Loads keys as of the close of ledgerSeq, which must be the current
+    // ledger or one of the last BUCKETLIST_DB_RETAINED_SNAPSHOTS before it.
+    // Returns nullopt if that ledger is not retained.
+    std::optional<std::vector<LedgerEntry>>
+    loadKeysFromLedger(std::set<LedgerKey, LedgerEntryIdCmp> const& inKeys,
+                       uint32_t ledgerSeq);
+
     std::vector<LedgerEntry>
     loadPoolShareTrustLinesByAccountAndAsset(AccountID const& accountID,
                                              Asset const& asset);
@@ -89,8 +125,26 @@ class SearchableBucketListSnapshot : public NonMovableOrCopyable
     std::vector<InflationWinner> loadInflationWinners(size_t maxWinners,
                                                       int64_t minBalance);
 
+    // Loads up to limit live contract data entries of contract, setting
+    // truncated if there are more. Only reads the contract data of contract.
+    std::vector<LedgerEntry> loadContractData(SCAddress const& contract,
+                                              size_t limit, bool& truncated);
+
+    // Loads up to limit live trustlines of asset, setting truncated if there
+    // are more. Only reads the pages holding trustlines of asset, so throws
+    // unless BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET is set.
+    std::vector<LedgerEntry>
+    loadTrustlinesByAsset(TrustLineAsset const& asset, size_t limit,
+                          bool& truncated);
+
+    // Loads every live offer, only reading the offer range of each bucket
+    std::vector<LedgerEntry> loadAllOffers();
+
     std::shared_ptr<LedgerEntry> getLedgerEntry(LedgerKey const& k);
 
+    // Ledger of the snapshot the last load read from
+    uint32_t getLedgerSeq() const;
+
     EvictionResult scanForEviction(uint32_t ledgerSeq,
                                    EvictionCounters& counters,
                                    EvictionIterator evictionIter,
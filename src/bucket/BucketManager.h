@@ -5,18 +5,25 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "bucket/Bucket.h"
+#include "util/BackgroundPriority.h"
+#include "util/MemoryFootprint.h"
 #include "util/NonCopyable.h"
+#include "util/ShardedCounter.h"
 #include "util/types.h"
+#include <chrono>
+#include <functional>
 #include <future>
 #include <map>
 #include <memory>
 #include <optional>
 #include <set>
+#include <string>
 
 #include "medida/timer_context.h"
 
 namespace medida
 {
+class Histogram;
 class Meter;
 }
 
@@ -30,6 +37,7 @@ class BucketList;
 class BucketSnapshotManager;
 class Config;
 class SearchableBucketListSnapshot;
+class SharedBucketStore;
 class TmpDirManager;
 struct HistoryArchiveState;
 struct InflationWinner;
@@ -136,6 +144,25 @@ struct EvictionCounters
     EvictionCounters(Application& app);
 };
 
+// The entries a visitLedgerEntries call is narrowed to. Every field that is
+// set leaves out the entries it doesn't allow, and lets the bucket indexes
+// skip the parts of the buckets that can only hold such entries.
+struct LedgerEntryScanScope
+{
+    // Entries of these types
+    std::optional<std::set<LedgerEntryType>> mEntryTypes;
+
+    // Contract data entries of these contracts. Other types are not affected.
+    std::optional<std::set<SCAddress>> mContracts;
+
+    // Trustlines of these assets. Other types are not affected. Only narrows
+    // the scanned ranges with BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET.
+    std::optional<std::set<TrustLineAsset>> mTrustlineAssets;
+
+    bool contains(LedgerKey const& key) const;
+    bool contains(LedgerEntry const& entry) const;
+};
+
 class EvictionStatistics
 {
   private:
@@ -199,6 +226,24 @@ class BucketManager : NonMovableOrCopyable
 
     virtual medida::Timer& getMergeTimer() = 0;
 
+    // Per-merge output throughput, in bytes per second. Safe to update from
+    // any thread.
+    virtual medida::Histogram& getMergeThroughputHistogram() = 0;
+
+    // Bytes of merge inputs and outputs dropped from the page cache, see
+    // BUCKET_MERGE_DROP_PAGE_CACHE. Safe to mark from any thread.
+    virtual medida::Meter& getMergePageCacheDropMeter() = 0;
+
+    // Runs the merge `merge` for `level` on a worker thread once the merge
+    // budgets allow it, see BUCKET_MERGE_IO_BUDGET_MB. Pending merges start
+    // in order of `deadline`, the time by which the level needs their output,
+    // and the time left when each finishes is recorded as its slack.
+    // `inputBytes` is the total size of the merge inputs.
+    virtual void
+    scheduleMerge(std::function<void()> merge, uint64_t inputBytes,
+                  uint32_t level,
+                  std::chrono::steady_clock::time_point deadline) = 0;
+
     // Reading and writing the merge counters is done in bulk, and takes a lock
     // briefly; this can be done from any thread.
     virtual MergeCounters readMergeCounters() = 0;
@@ -228,6 +273,17 @@ class BucketManager : NonMovableOrCopyable
     // inputs to be GC'ed.
     virtual void noteEmptyMergeOutput(MergeKey const& mergeKey) = 0;
 
+    // Shared bucket directory of the instances on this host (see
+    // SHARED_BUCKET_DIR_PATH), or nullptr if none is configured.
+    virtual SharedBucketStore const* getSharedBucketStore() const = 0;
+
+    // Takes the bucket named by `hash`, and its persisted index if any, from
+    // the shared bucket directory into the bucket directory and adopts it, as
+    // if it had been downloaded. Returns nullptr if the shared bucket
+    // directory does not have it.
+    virtual std::shared_ptr<Bucket>
+    adoptBucketFromSharedStore(uint256 const& hash) = 0;
+
     // Returns a bucket by hash if it exists and is currently managed by the
     // bucket list.
     virtual std::shared_ptr<Bucket> getBucketIfExists(uint256 const& hash) = 0;
@@ -252,6 +308,17 @@ class BucketManager : NonMovableOrCopyable
     putMergeFuture(MergeKey const& key,
                    std::shared_future<std::shared_ptr<Bucket>>) = 0;
 
+    // Writes the map of finished merges, if it changed, to the bucket
+    // directory. This lets merges restarted after a restart or a catchup
+    // reattach to the outputs of the merges finished before it rather than
+    // run again. Called when unreferenced buckets are forgotten.
+    virtual void persistFinishedMerges() = 0;
+
+    // Loads the persisted finished merges whose outputs are still in the
+    // bucket directory and returns these outputs, which have to be indexed
+    // before merges are restarted.
+    virtual std::vector<std::shared_ptr<Bucket>> loadFinishedMerges() = 0;
+
 #ifdef BUILD_TESTS
     // Drop all references to merge futures in progress.
     virtual void clearMergeFuturesForTesting() = 0;
@@ -298,6 +365,21 @@ class BucketManager : NonMovableOrCopyable
 
     virtual medida::Meter& getBloomMissMeter() const = 0;
     virtual medida::Meter& getBloomLookupMeter() const = 0;
+    virtual medida::Meter& getBloomSkipMeter() const = 0;
+    virtual medida::Meter& getReadBytesMeter() const = 0;
+    virtual medida::Meter& getReadPageFaultsMeter() const = 0;
+    // Number of page reads submitted together by a batched bulk load of a
+    // bucket, and time to load its entries (see BUCKETLIST_DB_BATCH_READS)
+    virtual medida::Histogram& getBatchReadDepthHistogram() const = 0;
+    virtual medida::Timer& getBatchReadTimer() const = 0;
+
+    // Counts of BucketList reads, updated by every thread reading the
+    // BucketList and marked on the matching meters above by syncMetrics
+    virtual ShardedCounter& getBloomMissCounter() const = 0;
+    virtual ShardedCounter& getBloomLookupCounter() const = 0;
+    virtual ShardedCounter& getBloomSkipCounter() const = 0;
+    virtual ShardedCounter& getReadBytesCounter() const = 0;
+    virtual void syncMetrics() = 0;
 
 #ifdef BUILD_TESTS
     // Install a fake/assumed ledger version and bucket list hash to use in next
@@ -317,6 +399,10 @@ class BucketManager : NonMovableOrCopyable
     // Return the set of buckets referenced by the BucketList
     virtual std::set<Hash> getBucketListReferencedBuckets() const = 0;
 
+    // Adds the estimated memory held by the indexes of each BucketList level,
+    // the finished merge map and live merges to `footprint`
+    virtual void addMemoryFootprint(MemoryFootprint& footprint) const = 0;
+
     // Return the set of buckets referenced by the BucketList, LCL HAS,
     // and publish queue.
     virtual std::set<Hash> getAllReferencedBuckets() const = 0;
@@ -358,22 +444,34 @@ class BucketManager : NonMovableOrCopyable
     // The order in which the entries are visited is not defined, but roughly
     // goes from more fresh entries to the older ones.
     //
-    // This accepts two visitors. `filterEntry` has to return `true`
-    // if the ledger entry can *potentially* be accepted. The passed entry isn't
-    // necessarily fresh or even alive. `acceptEntry` will only get the fresh
-    // alive entries that have passed the filter. If it returns `false` the
-    // iteration will immediately finish.
+    // This accepts two visitors. `makeFilter` returns filters that have to
+    // return `true` if the ledger entry can *potentially* be accepted. The
+    // passed entry isn't necessarily fresh or even alive. Each filter is only
+    // called from one thread. `acceptEntry` will only get the fresh alive
+    // entries that have passed the filter, always on the calling thread. If
+    // it returns `false` the iteration will immediately finish.
     //
     // When `minLedger` is specified, only entries that have been modified at
     // `minLedger` or later are visited.
     //
-    // When `filterEntry` and `acceptEntry` always return `true`, this is
+    // Only entries within `scope` are visited, and the parts of the buckets
+    // that can't hold them are skipped
+    // using the bucket indexes (or the persisted ones).
+    //
+    // With more than one of `threads`, up to that many buckets are scanned
+    // on background threads ahead of the one being visited, and the entries
+    // that pass their filter are buffered.
+    //
+    // When the filters and `acceptEntry` always return `true`, this is
     // equivalent to iterating over `loadCompleteLedgerState`, so the same
     // memory/runtime implications apply.
     virtual void visitLedgerEntries(
         HistoryArchiveState const& has, std::optional<int64_t> minLedger,
-        std::function<bool(LedgerEntry const&)> const& filterEntry,
-        std::function<bool(LedgerEntry const&)> const& acceptEntry) = 0;
+        LedgerEntryScanScope const& scope,
+        std::function<std::function<bool(LedgerEntry const&)>()> const&
+            makeFilter,
+        std::function<bool(LedgerEntry const&)> const& acceptEntry,
+        size_t threads) = 0;
 
     // Schedule a Work class that verifies the hashes of all referenced buckets
     // on background threads.
@@ -381,5 +479,11 @@ class BucketManager : NonMovableOrCopyable
     scheduleVerifyReferencedBucketsWork() = 0;
 
     virtual Config const& getConfig() const = 0;
+
+    // Posts f to the worker threads of the application, i.e. for work a merge
+    // hands off
+    virtual void postOnBackgroundThread(std::function<void()>&& f,
+                                        std::string jobName,
+                                        BackgroundPriority priority) const = 0;
 };
 }
@@ -4,11 +4,13 @@
 
 #include "bucket/BucketManagerImpl.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketInputIterator.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketListSnapshot.h"
 #include "bucket/BucketOutputIterator.h"
 #include "bucket/BucketSnapshotManager.h"
+#include "bucket/SharedBucketStore.h"
 #include "crypto/BLAKE2.h"
 #include "crypto/Hex.h"
 #include "history/HistoryManager.h"
@@ -16,6 +18,7 @@
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTypeUtils.h"
+#include "lib/json/json.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "util/Fs.h"
@@ -25,21 +28,25 @@
 #include "util/TmpDir.h"
 #include "util/types.h"
 #include "xdr/Stellar-ledger.h"
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
 #include <fmt/chrono.h>
 #include <fmt/format.h>
+#include <fstream>
 #include <map>
 #include <regex>
 #include <set>
 #include <thread>
 
 #include "medida/counter.h"
+#include "medida/histogram.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
+#include "util/Tracing.h"
 #include "work/WorkScheduler.h"
 #include "xdrpp/printer.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -120,6 +127,13 @@ BucketManagerImpl::initialize()
     mLockedBucketDir = std::make_unique<std::string>(d);
     mTmpDirManager = std::make_unique<TmpDirManager>(d + "/tmp");
 
+    auto const& sharedDir = mApp.getConfig().SHARED_BUCKET_DIR_PATH;
+    if (!sharedDir.empty() && mApp.getConfig().MODE_ENABLES_BUCKETLIST)
+    {
+        mSharedBucketStore = std::make_unique<SharedBucketStore>(sharedDir);
+        mSharedBucketStore->collectGarbage();
+    }
+
     if (mApp.getConfig().MODE_ENABLES_BUCKETLIST)
     {
         mBucketList = std::make_unique<BucketList>();
@@ -127,7 +141,9 @@ BucketManagerImpl::initialize()
         if (mApp.getConfig().isUsingBucketListDB())
         {
             mSnapshotManager = std::make_unique<BucketSnapshotManager>(
-                mApp, std::make_unique<BucketListSnapshot>(*mBucketList, 0));
+                mApp, std::make_unique<BucketListSnapshot>(
+                          *mBucketList, 0,
+                          mApp.getConfig().BUCKETLIST_DB_IN_MEMORY_LEVELS));
         }
     }
 }
@@ -171,12 +187,32 @@ BucketManagerImpl::BucketManagerImpl(Application& app)
           {"bucket", "batch", "objectsadded"}, "object"))
     , mBucketAddBatch(app.getMetrics().NewTimer({"bucket", "batch", "addtime"}))
     , mBucketSnapMerge(app.getMetrics().NewTimer({"bucket", "snap", "merge"}))
+    , mBucketMergeThroughput(
+          app.getMetrics().NewHistogram({"bucket", "merge", "throughput"}))
+    , mBucketMergePageCacheDrops(app.getMetrics().NewMeter(
+          {"bucket", "merge", "page-cache-dropped"}, "byte"))
+    , mPendingMergesCounter(
+          app.getMetrics().NewCounter({"bucket", "merge", "pending"}))
     , mSharedBucketsSize(
           app.getMetrics().NewCounter({"bucket", "memory", "shared"}))
+    , mForgetUnreferencedTime(
+          app.getMetrics().NewTimer({"bucket", "gc", "forget"}))
+    , mSharedStoreHits(app.getMetrics().NewMeter(
+          {"bucket", "shared-store", "hit"}, "bucket"))
     , mBucketListDBBloomMisses(app.getMetrics().NewMeter(
           {"bucketlistDB", "bloom", "misses"}, "bloom"))
     , mBucketListDBBloomLookups(app.getMetrics().NewMeter(
           {"bucketlistDB", "bloom", "lookups"}, "bloom"))
+    , mBucketListDBBloomSkips(app.getMetrics().NewMeter(
+          {"bucketlistDB", "bloom", "skips"}, "bloom"))
+    , mBucketListDBReadBytes(app.getMetrics().NewMeter(
+          {"bucketlistDB", "read", "bytes"}, "byte"))
+    , mBucketListDBReadPageFaults(app.getMetrics().NewMeter(
+          {"bucketlistDB", "read", "page-faults"}, "fault"))
+    , mBucketListDBBatchReadDepth(app.getMetrics().NewHistogram(
+          {"bucketlistDB", "batch-read", "depth"}))
+    , mBucketListDBBatchReadTime(
+          app.getMetrics().NewTimer({"bucketlistDB", "batch-read", "time"}))
     , mBucketListSizeCounter(
           app.getMetrics().NewCounter({"bucketlist", "size", "bytes"}))
     , mBucketListEvictionCounters(app)
@@ -331,6 +367,77 @@ BucketManagerImpl::getMergeTimer()
     return mBucketSnapMerge;
 }
 
+medida::Histogram&
+BucketManagerImpl::getMergeThroughputHistogram()
+{
+    return mBucketMergeThroughput;
+}
+
+medida::Meter&
+BucketManagerImpl::getMergePageCacheDropMeter()
+{
+    return mBucketMergePageCacheDrops;
+}
+
+void
+BucketManagerImpl::scheduleMerge(std::function<void()> merge,
+                                 uint64_t inputBytes, uint32_t level,
+                                 std::chrono::steady_clock::time_point deadline)
+{
+    ZoneScoped;
+    auto& slack = mApp.getMetrics().NewHistogram(
+        {"bucket", "merge-slack", "level-" + std::to_string(level)});
+    std::lock_guard<std::mutex> lock(mMergeQueueMutex);
+    mPendingMerges.emplace(deadline,
+                           PendingMerge{std::move(merge), inputBytes, &slack});
+    startPendingMerges();
+}
+
+void
+BucketManagerImpl::startPendingMerges()
+{
+    auto const& cfg = mApp.getConfig();
+    uint64_t const budgetBytes =
+        static_cast<uint64_t>(cfg.BUCKET_MERGE_IO_BUDGET_MB) * 1024 * 1024;
+    uint32_t const maxMerges = cfg.BUCKET_MERGE_MAX_CONCURRENCY;
+
+    // Merges start strictly in order of their deadlines: a smaller merge
+    // never overtakes a more urgent one that doesn't fit yet.
+    while (!mPendingMerges.empty())
+    {
+        auto it = mPendingMerges.begin();
+        uint64_t inputBytes = it->second.mInputBytes;
+        if (mRunningMerges != 0 &&
+            ((maxMerges != 0 && mRunningMerges >= maxMerges) ||
+             (budgetBytes != 0 &&
+              mRunningMergeBytes + inputBytes > budgetBytes)))
+        {
+            break;
+        }
+        auto deadline = it->first;
+        auto pending = std::move(it->second);
+        mPendingMerges.erase(it);
+        ++mRunningMerges;
+        mRunningMergeBytes += inputBytes;
+
+        mApp.postOnBackgroundThread(
+            [this, pending = std::move(pending), deadline]() {
+                pending.mMerge();
+                using namespace std::chrono;
+                auto slack = duration_cast<milliseconds>(deadline -
+                                                         steady_clock::now());
+                pending.mSlack->Update(slack.count());
+
+                std::lock_guard<std::mutex> lock(mMergeQueueMutex);
+                --mRunningMerges;
+                mRunningMergeBytes -= pending.mInputBytes;
+                startPendingMerges();
+            },
+            "FutureBucket: merge", BackgroundPriority::HIGH);
+    }
+    mPendingMergesCounter.set_count(mPendingMerges.size());
+}
+
 MergeCounters
 BucketManagerImpl::readMergeCounters()
 {
@@ -351,6 +458,39 @@ EvictionResult::isValid(uint32_t currLedger,
                currSas.startingEvictionScanLevel;
 }
 
+// Checks a LedgerKey or the data of a LedgerEntry, which have the same
+// fields for the types a scope narrows
+template <typename T>
+static bool
+scopeContains(LedgerEntryScanScope const& scope, T const& k)
+{
+    if (scope.mEntryTypes && scope.mEntryTypes->count(k.type()) == 0)
+    {
+        return false;
+    }
+    if (k.type() == CONTRACT_DATA && scope.mContracts)
+    {
+        return scope.mContracts->count(k.contractData().contract) != 0;
+    }
+    if (k.type() == TRUSTLINE && scope.mTrustlineAssets)
+    {
+        return scope.mTrustlineAssets->count(k.trustLine().asset) != 0;
+    }
+    return true;
+}
+
+bool
+LedgerEntryScanScope::contains(LedgerKey const& key) const
+{
+    return scopeContains(*this, key);
+}
+
+bool
+LedgerEntryScanScope::contains(LedgerEntry const& entry) const
+{
+    return scopeContains(*this, entry.data);
+}
+
 MergeCounters&
 MergeCounters::operator+=(MergeCounters const& delta)
 {
@@ -452,7 +592,10 @@ BucketManagerImpl::renameBucketDirFile(std::filesystem::path const& src,
     }
     else
     {
-        return fs::durableRename(src.string(), dst.string(), getBucketDir());
+        // The bucket directory is synced once for all the buckets adopted
+        // since the last time, before the next HAS naming them is stored
+        return fs::deferredDurableRename(src.string(), dst.string(),
+                                         getBucketDir());
     }
 }
 
@@ -517,10 +660,16 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
             }
         }
 
+        if (mSharedBucketStore)
+        {
+            mSharedBucketStore->addBucket(hash, canonicalName);
+        }
+
         b = std::make_shared<Bucket>(canonicalName, hash, std::move(index));
         {
             mSharedBuckets.emplace(hash, b);
             mSharedBucketsSize.set_count(mSharedBuckets.size());
+            mGCCandidates.emplace(hash);
         }
     }
     releaseAssert(b);
@@ -529,10 +678,51 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
         // Second half of the mergeKey record-keeping, above: if we successfully
         // adopted (no throw), then (weakly) record the preimage of the hash.
         mFinishedMerges.recordMerge(*mergeKey, hash);
+        mFinishedMergesDirty = true;
     }
     return b;
 }
 
+SharedBucketStore const*
+BucketManagerImpl::getSharedBucketStore() const
+{
+    return mSharedBucketStore.get();
+}
+
+std::shared_ptr<Bucket>
+BucketManagerImpl::adoptBucketFromSharedStore(uint256 const& hash)
+{
+    ZoneScoped;
+    releaseAssertOrThrow(mApp.getConfig().MODE_ENABLES_BUCKETLIST);
+    if (!mSharedBucketStore)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    auto tmpName = Bucket::randomBucketName(getTmpDir());
+    if (!mSharedBucketStore->getBucket(hash, tmpName))
+    {
+        return nullptr;
+    }
+
+    // Bring the index along too, IndexBucketsWork loads it instead of
+    // indexing the bucket again
+    if (mApp.getConfig().isPersistingBucketListDBIndexes())
+    {
+        auto tmpIndexName = Bucket::randomBucketIndexName(getTmpDir());
+        if (mSharedBucketStore->getIndex(hash, tmpIndexName) &&
+            !renameBucketDirFile(tmpIndexName, bucketIndexFilename(hash)))
+        {
+            std::remove(tmpIndexName.c_str());
+        }
+    }
+
+    mSharedStoreHits.Mark();
+    return adoptFileAsBucket(tmpName, hash, /*mergeKey=*/nullptr,
+                             /*index=*/nullptr);
+}
+
 void
 BucketManagerImpl::noteEmptyMergeOutput(MergeKey const& mergeKey)
 {
@@ -597,6 +787,7 @@ BucketManagerImpl::getBucketByHash(uint256 const& hash)
             std::make_shared<Bucket>(canonicalName, hash, /*index=*/nullptr);
         mSharedBuckets.emplace(hash, p);
         mSharedBucketsSize.set_count(mSharedBuckets.size());
+        mGCCandidates.emplace(hash);
         return p;
     }
     return std::shared_ptr<Bucket>();
@@ -660,6 +851,117 @@ BucketManagerImpl::putMergeFuture(
     mLiveFutures.emplace(key, wp);
 }
 
+// Version of the merge map file, to bump when its format changes
+static uint32_t const MERGE_MAP_VERSION = 1;
+
+static std::string
+mergeMapFilename(std::string const& bucketDir)
+{
+    return bucketDir + "/merge-map.json";
+}
+
+void
+BucketManagerImpl::persistFinishedMerges()
+{
+    ZoneScoped;
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    if (!mFinishedMergesDirty)
+    {
+        return;
+    }
+
+    Json::Value root;
+    root["version"] = MERGE_MAP_VERSION;
+    Json::Value& merges = root["merges"];
+    merges = Json::arrayValue;
+    for (auto const& [key, output] : mFinishedMerges.getAllMerges())
+    {
+        Json::Value merge;
+        merge["keepDeadEntries"] = key.mKeepDeadEntries;
+        merge["curr"] = binToHex(key.mInputCurrBucket);
+        merge["snap"] = binToHex(key.mInputSnapBucket);
+        merge["shadows"] = Json::arrayValue;
+        for (auto const& shadow : key.mInputShadowBuckets)
+        {
+            merge["shadows"].append(binToHex(shadow));
+        }
+        merge["output"] = binToHex(output);
+        merges.append(merge);
+    }
+
+    // Write to a temporary file first so that a crash can't leave a
+    // truncated file behind. The file isn't synced: losing it only costs
+    // merges.
+    auto filename = mergeMapFilename(getBucketDir());
+    auto tmpFilename = filename + ".tmp";
+    try
+    {
+        {
+            std::ofstream out;
+            out.exceptions(std::ios::failbit | std::ios::badbit);
+            out.open(tmpFilename);
+            out << Json::FastWriter().write(root);
+        }
+        std::filesystem::rename(tmpFilename, filename);
+        mFinishedMergesDirty = false;
+        CLOG_DEBUG(Bucket, "Persisted {} finished merges", merges.size());
+    }
+    catch (std::exception const& e)
+    {
+        CLOG_WARNING(Bucket, "Failed to persist finished merges to {}: {}",
+                     filename, e.what());
+    }
+}
+
+std::vector<std::shared_ptr<Bucket>>
+BucketManagerImpl::loadFinishedMerges()
+{
+    ZoneScoped;
+    std::vector<std::shared_ptr<Bucket>> outputs;
+    auto filename = mergeMapFilename(getBucketDir());
+    std::ifstream in(filename);
+    if (!in)
+    {
+        return outputs;
+    }
+
+    Json::Value root;
+    if (!Json::Reader().parse(in, root) ||
+        root["version"].asUInt() != MERGE_MAP_VERSION)
+    {
+        CLOG_WARNING(Bucket, "Ignoring malformed merge map file {}", filename);
+        return outputs;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    for (auto const& merge : root["merges"])
+    {
+        // Outputs that are gone are merged again
+        auto output = getBucketByHash(hexToBin256(merge["output"].asString()));
+        if (!output)
+        {
+            continue;
+        }
+        std::vector<Hash> shadows;
+        for (auto const& shadow : merge["shadows"])
+        {
+            shadows.emplace_back(hexToBin256(shadow.asString()));
+        }
+        MergeKey key(merge["keepDeadEntries"].asBool(),
+                     hexToBin256(merge["curr"].asString()),
+                     hexToBin256(merge["snap"].asString()), shadows);
+        Hash existing;
+        if (!mFinishedMerges.findMergeFor(key, existing))
+        {
+            mFinishedMerges.recordMerge(key, output->getHash());
+            outputs.emplace_back(output);
+        }
+    }
+    CLOG_INFO(Bucket, "Loaded {} finished merges from {}", outputs.size(),
+              filename);
+    return outputs;
+}
+
 #ifdef BUILD_TESTS
 void
 BucketManagerImpl::clearMergeFuturesForTesting()
@@ -669,6 +971,33 @@ BucketManagerImpl::clearMergeFuturesForTesting()
 }
 #endif
 
+void
+BucketManagerImpl::addMemoryFootprint(MemoryFootprint& footprint) const
+{
+    if (mApp.getConfig().MODE_ENABLES_BUCKETLIST && mBucketList)
+    {
+        for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
+        {
+            auto const& level = mBucketList->getLevel(i);
+            size_t bytes = 0;
+            for (auto const& b : {level.getCurr(), level.getSnap()})
+            {
+                if (b->isIndexed())
+                {
+                    bytes += b->getIndex().getEstimatedBytes();
+                }
+            }
+            footprint[fmt::format(FMT_STRING("bucket.index-level-{}"), i)] =
+                bytes;
+        }
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    footprint["bucket.merge-map"] = mFinishedMerges.getEstimatedBytes();
+    footprint["bucket.live-futures"] =
+        mLiveFutures.size() * nodeBytes<decltype(mLiveFutures)::value_type>();
+}
+
 std::set<Hash>
 BucketManagerImpl::getBucketListReferencedBuckets() const
 {
@@ -785,6 +1114,11 @@ BucketManagerImpl::cleanupStaleFiles()
             // GC index as well
             auto indexFilename = bucketIndexFilename(hash);
             std::remove(indexFilename.c_str());
+
+            if (mSharedBucketStore)
+            {
+                mSharedBucketStore->release(hash);
+            }
         }
     }
 }
@@ -793,16 +1127,29 @@ void
 BucketManagerImpl::forgetUnreferencedBuckets()
 {
     ZoneScoped;
+    auto timer = mForgetUnreferencedTime.TimeScope();
     std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
     auto referenced = getAllReferencedBuckets();
     auto blReferenced = getBucketListReferencedBuckets();
 
-    for (auto i = mSharedBuckets.begin(); i != mSharedBuckets.end();)
+    // Besides the buckets already in mGCCandidates, only buckets that left
+    // either reference set since the last pass can have become collectable.
+    std::set_difference(mLastReferenced.begin(), mLastReferenced.end(),
+                        referenced.begin(), referenced.end(),
+                        std::inserter(mGCCandidates, mGCCandidates.end()));
+    std::set_difference(
+        mLastBucketListReferenced.begin(), mLastBucketListReferenced.end(),
+        blReferenced.begin(), blReferenced.end(),
+        std::inserter(mGCCandidates, mGCCandidates.end()));
+
+    for (auto c = mGCCandidates.begin(); c != mGCCandidates.end();)
     {
-        // Standard says map iterators other than the one you're erasing
-        // remain valid.
-        auto j = i;
-        ++i;
+        auto j = mSharedBuckets.find(*c);
+        if (j == mSharedBuckets.end())
+        {
+            c = mGCCandidates.erase(c);
+            continue;
+        }
 
         // Delete indexes for buckets no longer in bucketlist. There is a race
         // condition on startup where future buckets for a level will be
@@ -845,6 +1192,10 @@ BucketManagerImpl::forgetUnreferencedBuckets()
                 std::remove(gzfilename.c_str());
                 auto indexFilename = bucketIndexFilename(j->second->getHash());
                 std::remove(indexFilename.c_str());
+                if (mSharedBucketStore)
+                {
+                    mSharedBucketStore->release(j->second->getHash());
+                }
             }
 
             // Dropping this bucket means we'll no longer be able to
@@ -855,6 +1206,7 @@ BucketManagerImpl::forgetUnreferencedBuckets()
             for (auto const& forgottenMergeKey :
                  mFinishedMerges.forgetAllMergesProducing(j->first))
             {
+                mFinishedMergesDirty = true;
                 // There should be no futures alive with this output: we
                 // switched to storing only weak input/output mappings
                 // when any merge producing the bucket completed (in
@@ -870,16 +1222,38 @@ BucketManagerImpl::forgetUnreferencedBuckets()
                     CLOG_WARNING(Bucket,
                                  "Unexpected live future for unreferenced "
                                  "bucket: {}",
-                                 binToHex(i->first));
+                                 binToHex(j->first));
                     mLiveFutures.erase(f);
                 }
             }
 
             // All done, delete the bucket from the shared map.
             mSharedBuckets.erase(j);
+            c = mGCCandidates.erase(c);
+            continue;
+        }
+
+        // A bucket we kept needs another look on the next pass only if it, or
+        // its index, was kept because another holder still had it.
+        bool keptForHolder =
+            referenced.find(j->first) == referenced.end() ||
+            (j->second->isIndexed() &&
+             blReferenced.find(j->first) == blReferenced.end());
+        if (j->second.use_count() > 1 && keptForHolder)
+        {
+            ++c;
+        }
+        else
+        {
+            c = mGCCandidates.erase(c);
         }
     }
+    mLastReferenced = std::move(referenced);
+    mLastBucketListReferenced = std::move(blReferenced);
     mSharedBucketsSize.set_count(mSharedBuckets.size());
+
+    // Now that merges with dropped outputs are forgotten
+    persistFinishedMerges();
 }
 
 void
@@ -907,7 +1281,10 @@ BucketManagerImpl::addBatch(Application& app, uint32_t currLedger,
     if (app.getConfig().isUsingBucketListDB())
     {
         mSnapshotManager->updateCurrentSnapshot(
-            std::make_unique<BucketListSnapshot>(*mBucketList, currLedger));
+            std::make_unique<BucketListSnapshot>(
+                *mBucketList, currLedger,
+                app.getConfig().BUCKETLIST_DB_IN_MEMORY_LEVELS),
+            initEntries, liveEntries, deadEntries);
     }
 }
 
@@ -1100,6 +1477,69 @@ BucketManagerImpl::getBloomLookupMeter() const
     return mBucketListDBBloomLookups;
 }
 
+medida::Meter&
+BucketManagerImpl::getBloomSkipMeter() const
+{
+    return mBucketListDBBloomSkips;
+}
+
+medida::Meter&
+BucketManagerImpl::getReadBytesMeter() const
+{
+    return mBucketListDBReadBytes;
+}
+
+medida::Meter&
+BucketManagerImpl::getReadPageFaultsMeter() const
+{
+    return mBucketListDBReadPageFaults;
+}
+
+medida::Histogram&
+BucketManagerImpl::getBatchReadDepthHistogram() const
+{
+    return mBucketListDBBatchReadDepth;
+}
+
+medida::Timer&
+BucketManagerImpl::getBatchReadTimer() const
+{
+    return mBucketListDBBatchReadTime;
+}
+
+ShardedCounter&
+BucketManagerImpl::getBloomMissCounter() const
+{
+    return mBloomMisses;
+}
+
+ShardedCounter&
+BucketManagerImpl::getBloomLookupCounter() const
+{
+    return mBloomLookups;
+}
+
+ShardedCounter&
+BucketManagerImpl::getBloomSkipCounter() const
+{
+    return mBloomSkips;
+}
+
+ShardedCounter&
+BucketManagerImpl::getReadBytesCounter() const
+{
+    return mReadBytes;
+}
+
+void
+BucketManagerImpl::syncMetrics()
+{
+    mBucketListDBBloomMisses.Mark(mBloomMisses.flush());
+    mBucketListDBBloomLookups.Mark(mBloomLookups.flush());
+    mBucketListDBBloomSkips.Mark(mBloomSkips.flush());
+    mBucketListDBReadBytes.Mark(mReadBytes.flush());
+}
+
 void
 BucketManagerImpl::calculateSkipValues(LedgerHeader& currentHeader)
 {
@@ -1196,8 +1636,9 @@ BucketManagerImpl::assumeState(HistoryArchiveState const& has,
     if (mApp.getConfig().isUsingBucketListDB())
     {
         mSnapshotManager->updateCurrentSnapshot(
-            std::make_unique<BucketListSnapshot>(*mBucketList,
-                                                 has.currentLedger));
+            std::make_unique<BucketListSnapshot>(
+                *mBucketList, has.currentLedger,
+                mApp.getConfig().BUCKETLIST_DB_IN_MEMORY_LEVELS));
     }
     cleanupStaleFiles();
 }
@@ -1318,57 +1759,185 @@ BucketManagerImpl::mergeBuckets(HistoryArchiveState const& has)
     return out.getBucket(*this, /*shouldSynchronouslyIndex=*/false);
 }
 
-static bool
-visitEntriesInBucket(std::shared_ptr<Bucket const> b, std::string const& name,
-                     std::optional<int64_t> minLedger,
-                     std::function<bool(LedgerEntry const&)> const& filterEntry,
-                     std::function<bool(LedgerEntry const&)> const& acceptEntry,
-                     UnorderedSet<Hash>& processedEntries)
+namespace
 {
-    ZoneScoped;
+// Sorted [begin, end) file offset ranges of a bucket to scan, or std::nullopt
+// to scan the whole file
+using ScanRanges =
+    std::optional<std::vector<std::pair<std::streamoff, std::streamoff>>>;
 
-    using namespace std::chrono;
-    medida::Timer timer;
+// The entries one bucket contributes to a parallel visit, in file order
+struct BucketVisit
+{
+    std::vector<std::pair<Hash, LedgerEntry>> mLive;
+    std::vector<Hash> mDead;
+    bool mHasOldEntries{false};
+};
+}
 
-    bool stopIteration = false;
-    timer.Time([&]() {
-        for (BucketInputIterator in(b); in; ++in)
+// Returns the ranges of `b` that may hold entries within `scope`, from the
+// index of the bucket or, when it isn't indexed (i.e. in offline commands),
+// from its persisted index.
+static ScanRanges
+getScanRanges(BucketManager const& bm, std::shared_ptr<Bucket const> const& b,
+              LedgerEntryScanScope const& scope)
+{
+    if (!scope.mEntryTypes)
+    {
+        return std::nullopt;
+    }
+
+    std::unique_ptr<BucketIndex const> index;
+    if (!b->isIndexed())
+    {
+        auto indexFilename = bm.bucketIndexFilename(b->getHash());
+        if (bm.getConfig().isPersistingBucketListDBIndexes() &&
+            fs::exists(indexFilename))
         {
-            BucketEntry const& e = *in;
-            if (e.type() == LIVEENTRY || e.type() == INITENTRY)
+            index = BucketIndex::load(bm, indexFilename, b->getSize());
+        }
+        if (!index)
+        {
+            return std::nullopt;
+        }
+    }
+
+    auto const& bucketIndex = index ? *index : b->getIndex();
+    std::vector<std::pair<std::streamoff, std::streamoff>> ranges;
+    for (auto type : *scope.mEntryTypes)
+    {
+        if (type == CONTRACT_DATA && scope.mContracts)
+        {
+            for (auto const& contract : *scope.mContracts)
             {
-                auto const& liveEntry = e.liveEntry();
-                if (minLedger && liveEntry.lastModifiedLedgerSeq < *minLedger)
-                {
-                    stopIteration = true;
-                    continue;
-                }
-                if (!filterEntry(liveEntry))
+                if (auto range = bucketIndex.getContractDataRange(contract))
                 {
-                    continue;
+                    ranges.emplace_back(*range);
                 }
-                if (!processedEntries
-                         .insert(xdrBlake2(LedgerEntryKey(liveEntry)))
-                         .second)
-                {
-                    continue;
-                }
-                if (!acceptEntry(liveEntry))
+            }
+            continue;
+        }
+        if (type == TRUSTLINE && scope.mTrustlineAssets)
+        {
+            bool indexed = true;
+            for (auto const& asset : *scope.mTrustlineAssets)
+            {
+                auto assetRanges = bucketIndex.getTrustlineRangesByAsset(asset);
+                if (!assetRanges)
                 {
-                    stopIteration = true;
+                    indexed = false;
                     break;
                 }
+                ranges.insert(ranges.end(), assetRanges->begin(),
+                              assetRanges->end());
             }
-            else
+            if (indexed)
             {
-                if (e.type() != DEADENTRY)
-                {
-                    std::string err = "Malformed bucket: unexpected "
-                                      "non-INIT/LIVE/DEAD entry.";
-                    CLOG_ERROR(Bucket, "{}", err);
-                    throw std::runtime_error(err);
-                }
-                processedEntries.insert(xdrBlake2(e.deadEntry()));
+                continue;
+            }
+        }
+        if (auto range = bucketIndex.getTypeRange(type))
+        {
+            ranges.emplace_back(*range);
+        }
+    }
+
+    // Page ranges of neighbouring types (or contracts, or assets) may overlap
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<std::streamoff, std::streamoff>> merged;
+    for (auto const& range : ranges)
+    {
+        if (!merged.empty() && range.first <= merged.back().second)
+        {
+            merged.back().second = std::max(merged.back().second, range.second);
+        }
+        else
+        {
+            merged.emplace_back(range);
+        }
+    }
+    return merged;
+}
+
+// Scans the entries of `b` within `ranges`. Live entries within `scope` that
+// pass `filterEntry` go to `onLive`, which returns false to stop the scan, and
+// the keys of dead entries within `scope` go to `onDead`. Sets
+// `hasOldEntries` if the bucket has live entries older than `minLedger`.
+// Returns false if `onLive` stopped the scan.
+static bool
+scanBucket(std::shared_ptr<Bucket const> const& b, std::string const& name,
+           ScanRanges const& ranges, std::optional<int64_t> minLedger,
+           LedgerEntryScanScope const& scope,
+           std::function<bool(LedgerEntry const&)> const& filterEntry,
+           std::function<bool(LedgerEntry const&)> const& onLive,
+           std::function<void(LedgerKey const&)> const& onDead,
+           bool& hasOldEntries)
+{
+    ZoneScoped;
+
+    using namespace std::chrono;
+    medida::Timer timer;
+
+    // Returns false if `onLive` stopped the scan
+    auto visitEntry = [&](BucketEntry const& e) {
+        if (e.type() == LIVEENTRY || e.type() == INITENTRY)
+        {
+            auto const& liveEntry = e.liveEntry();
+            if (minLedger && liveEntry.lastModifiedLedgerSeq < *minLedger)
+            {
+                hasOldEntries = true;
+                return true;
+            }
+            if (!scope.contains(liveEntry))
+            {
+                return true;
+            }
+            return !filterEntry(liveEntry) || onLive(liveEntry);
+        }
+        if (e.type() != DEADENTRY)
+        {
+            std::string err = "Malformed bucket: unexpected "
+                              "non-INIT/LIVE/DEAD entry.";
+            CLOG_ERROR(Bucket, "{}", err);
+            throw std::runtime_error(err);
+        }
+        if (scope.contains(e.deadEntry()))
+        {
+            onDead(e.deadEntry());
+        }
+        return true;
+    };
+
+    bool stopped = false;
+    timer.Time([&]() {
+        BucketInputIterator in(b);
+        if (!ranges)
+        {
+            for (; in && !stopped; ++in)
+            {
+                stopped = !visitEntry(*in);
+            }
+            return;
+        }
+        for (auto const& [begin, end] : *ranges)
+        {
+            // The iterator starts past the METAENTRY, which seeking to 0 would
+            // read again
+            if (begin > 0)
+            {
+                in.seek(begin);
+            }
+            // Offset of the current entry, or before it for the first one
+            std::streamoff pos = begin;
+            while (in && !stopped && pos < end)
+            {
+                stopped = !visitEntry(*in);
+                pos = in.pos();
+                ++in;
+            }
+            if (stopped || !in)
+            {
+                break;
             }
         }
     });
@@ -1378,18 +1947,18 @@ visitEntriesInBucket(std::shared_ptr<Bucket const> b, std::string const& name,
     size_t bytesPerSec = (b->getSize() * 1000 / (1 + ms.count()));
     CLOG_INFO(Bucket, "Processed {}-byte bucket file '{}' in {} ({}/s)",
               b->getSize(), name, ms, formatSize(bytesPerSec));
-    return !stopIteration;
+    return !stopped;
 }
 
 void
 BucketManagerImpl::visitLedgerEntries(
     HistoryArchiveState const& has, std::optional<int64_t> minLedger,
-    std::function<bool(LedgerEntry const&)> const& filterEntry,
-    std::function<bool(LedgerEntry const&)> const& acceptEntry)
+    LedgerEntryScanScope const& scope,
+    std::function<std::function<bool(LedgerEntry const&)>()> const& makeFilter,
+    std::function<bool(LedgerEntry const&)> const& acceptEntry, size_t threads)
 {
     ZoneScoped;
 
-    UnorderedSet<Hash> deletedEntries;
     std::vector<std::pair<Hash, std::string>> hashes;
     for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
     {
@@ -1399,26 +1968,167 @@ BucketManagerImpl::visitLedgerEntries(
         hashes.emplace_back(hexToBin256(hsb.snap),
                             fmt::format(FMT_STRING("snap {:d}"), i));
     }
+    std::vector<std::pair<std::shared_ptr<Bucket const>, std::string>> buckets;
+    for (auto const& pair : hashes)
+    {
+        if (isZero(pair.first))
+        {
+            continue;
+        }
+        auto b = getBucketByHash(pair.first);
+        if (!b)
+        {
+            throw std::runtime_error(std::string("missing bucket: ") +
+                                     binToHex(pair.first));
+        }
+        buckets.emplace_back(b, pair.second);
+    }
+
+    // Skipping entries by type would miss the old entries that end the visit
+    // when minLedger is set
+    auto scanRanges = [&](std::shared_ptr<Bucket const> const& b) {
+        return minLedger ? ScanRanges{}
+                         : getScanRanges(*this, b, scope);
+    };
+
+    // Hashes of the keys of the entries visited or deleted in fresher buckets
+    UnorderedSet<Hash> processedEntries;
     medida::Timer timer;
     timer.Time([&]() {
-        for (auto const& pair : hashes)
+        if (threads <= 1)
         {
-            if (isZero(pair.first))
+            auto filterEntry = makeFilter();
+            for (auto const& [b, name] : buckets)
             {
-                continue;
+                bool hasOldEntries = false;
+                bool finished = scanBucket(
+                    b, name, scanRanges(b), minLedger, scope, filterEntry,
+                    [&](LedgerEntry const& entry) {
+                        return !processedEntries
+                                    .insert(xdrBlake2(LedgerEntryKey(entry)))
+                                    .second ||
+                               acceptEntry(entry);
+                    },
+                    [&](LedgerKey const& key) {
+                        processedEntries.insert(xdrBlake2(key));
+                    },
+                    hasOldEntries);
+                if (!finished || hasOldEntries)
+                {
+                    break;
+                }
             }
-            auto b = getBucketByHash(pair.first);
-            if (!b)
+            return;
+        }
+
+        // Up to `threads` buckets are scanned on background threads ahead of
+        // the one being merged. Merging in bucket order keeps the fresher
+        // version of every entry, as in the sequential visit.
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<std::optional<BucketVisit>> visits(buckets.size());
+        std::vector<std::exception_ptr> errors(buckets.size());
+        size_t posted = 0;
+        size_t inFlight = 0;
+        std::atomic<bool> stopping{false};
+
+        auto postScans = [&](size_t merged) {
+            while (posted < buckets.size() && posted < merged + threads)
             {
-                throw std::runtime_error(std::string("missing bucket: ") +
-                                         binToHex(pair.first));
+                size_t i = posted++;
+                auto filterEntry = makeFilter();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++inFlight;
+                }
+                mApp.postOnBackgroundThread(
+                    [&, i, filterEntry]() {
+                        BucketVisit visit;
+                        std::exception_ptr error;
+                        try
+                        {
+                            if (!stopping)
+                            {
+                                auto const& [b, name] = buckets[i];
+                                scanBucket(
+                                    b, name, scanRanges(b), minLedger,
+                                    scope, filterEntry,
+                                    [&](LedgerEntry const& entry) {
+                                        visit.mLive.emplace_back(
+                                            xdrBlake2(LedgerEntryKey(entry)),
+                                            entry);
+                                        return true;
+                                    },
+                                    [&](LedgerKey const& key) {
+                                        visit.mDead.emplace_back(
+                                            xdrBlake2(key));
+                                    },
+                                    visit.mHasOldEntries);
+                            }
+                        }
+                        catch (...)
+                        {
+                            error = std::current_exception();
+                        }
+                        std::lock_guard<std::mutex> lock(mutex);
+                        visits[i] = std::move(visit);
+                        errors[i] = error;
+                        --inFlight;
+                        cv.notify_all();
+                    },
+                    "visitLedgerEntries");
             }
-            if (!visitEntriesInBucket(b, pair.second, minLedger, filterEntry,
-                                      acceptEntry, deletedEntries))
+        };
+
+        std::exception_ptr error;
+        try
+        {
+            for (size_t i = 0; i < buckets.size(); ++i)
             {
-                break;
+                postScans(i);
+                BucketVisit visit;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() { return visits[i].has_value(); });
+                    if (errors[i])
+                    {
+                        std::rethrow_exception(errors[i]);
+                    }
+                    visit = std::move(*visits[i]);
+                    visits[i].reset();
+                }
+
+                bool stopped = false;
+                for (auto const& [hash, entry] : visit.mLive)
+                {
+                    if (processedEntries.insert(hash).second &&
+                        !acceptEntry(entry))
+                    {
+                        stopped = true;
+                        break;
+                    }
+                }
+                if (stopped || visit.mHasOldEntries)
+                {
+                    break;
+                }
+                processedEntries.insert(visit.mDead.begin(),
+                                        visit.mDead.end());
             }
         }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        // The scans still running reference this frame
+        stopping = true;
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return inFlight == 0; });
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
     });
     auto ns = timer.duration_unit() *
               static_cast<std::chrono::nanoseconds::rep>(timer.max());
@@ -1455,4 +2165,12 @@ BucketManagerImpl::getConfig() const
 {
     return mApp.getConfig();
 }
+
+void
+BucketManagerImpl::postOnBackgroundThread(std::function<void()>&& f,
+                                          std::string jobName,
+                                          BackgroundPriority priority) const
+{
+    mApp.postOnBackgroundThread(std::move(f), std::move(jobName), priority);
+}
 }
@@ -5,6 +5,8 @@
 #include "bucket/BucketMergeMap.h"
 #include "xdr/Stellar-ledger.h"
 
+#include <chrono>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -17,6 +19,7 @@
 
 namespace medida
 {
+class Histogram;
 class Timer;
 class Meter;
 class Counter;
@@ -31,6 +34,7 @@ class Application;
 class Bucket;
 class BucketList;
 class BucketSnapshotManager;
+class SharedBucketStore;
 struct HistoryArchiveState;
 
 class BucketManagerImpl : public BucketManager
@@ -49,13 +53,28 @@ class BucketManagerImpl : public BucketManager
     // the BucketList (i.e. addBatch).
     mutable std::recursive_mutex mBucketMutex;
     std::unique_ptr<std::string> mLockedBucketDir;
+    std::unique_ptr<SharedBucketStore> mSharedBucketStore;
     medida::Meter& mBucketObjectInsertBatch;
     medida::Timer& mBucketAddBatch;
     medida::Timer& mBucketSnapMerge;
+    medida::Histogram& mBucketMergeThroughput;
+    medida::Meter& mBucketMergePageCacheDrops;
+    medida::Counter& mPendingMergesCounter;
     medida::Counter& mSharedBucketsSize;
+    medida::Timer& mForgetUnreferencedTime;
+    medida::Meter& mSharedStoreHits;
     medida::Meter& mBucketListDBBloomMisses;
     medida::Meter& mBucketListDBBloomLookups;
+    medida::Meter& mBucketListDBBloomSkips;
+    medida::Meter& mBucketListDBReadBytes;
+    medida::Meter& mBucketListDBReadPageFaults;
+    medida::Histogram& mBucketListDBBatchReadDepth;
+    medida::Timer& mBucketListDBBatchReadTime;
     medida::Counter& mBucketListSizeCounter;
+    mutable ShardedCounter mBloomMisses;
+    mutable ShardedCounter mBloomLookups;
+    mutable ShardedCounter mBloomSkips;
+    mutable ShardedCounter mReadBytes;
     EvictionCounters mBucketListEvictionCounters;
     MergeCounters mMergeCounters;
     std::shared_ptr<EvictionStatistics> mEvictionStatistics{};
@@ -78,9 +97,39 @@ class BucketManagerImpl : public BucketManager
     // not keep either the output bucket or any of its input buckets
     // alive. Needs to be queried and updated on mSharedBuckets GC events.
     BucketMergeMap mFinishedMerges;
+    // Whether mFinishedMerges changed since it was last persisted
+    bool mFinishedMergesDirty{false};
+
+    // Buckets forgetUnreferencedBuckets has to look at on its next pass: the
+    // ones added to mSharedBuckets since its last pass, and the ones it kept
+    // only because another holder still had them. Along with the buckets that
+    // left the reference sets of its last pass, these are the only buckets
+    // that can have become collectable, so a pass is O(changes) rather than
+    // O(mSharedBuckets).
+    std::set<Hash> mGCCandidates;
+    std::set<Hash> mLastReferenced;
+    std::set<Hash> mLastBucketListReferenced;
 
     std::atomic<bool> mIsShutdown{false};
 
+    // Merges waiting for the merge budgets, see scheduleMerge, keyed by their
+    // deadlines. Merges with the same deadline keep the order they came in.
+    struct PendingMerge
+    {
+        std::function<void()> mMerge;
+        uint64_t mInputBytes;
+        medida::Histogram* mSlack;
+    };
+    std::mutex mMergeQueueMutex;
+    std::multimap<std::chrono::steady_clock::time_point, PendingMerge>
+        mPendingMerges;
+    uint64_t mRunningMergeBytes{0};
+    uint32_t mRunningMerges{0};
+
+    // Posts the most urgent pending merges that fit in the budgets to the
+    // worker threads. Called with mMergeQueueMutex held.
+    void startPendingMerges();
+
     void cleanupStaleFiles();
     void deleteTmpDirAndUnlockBucketDir();
     void deleteEntireBucketDir();
@@ -111,6 +160,11 @@ class BucketManagerImpl : public BucketManager
     BucketList& getBucketList() override;
     BucketSnapshotManager& getBucketSnapshotManager() const override;
     medida::Timer& getMergeTimer() override;
+    medida::Histogram& getMergeThroughputHistogram() override;
+    medida::Meter& getMergePageCacheDropMeter() override;
+    void scheduleMerge(std::function<void()> merge, uint64_t inputBytes,
+                       uint32_t level,
+                       std::chrono::steady_clock::time_point deadline) override;
     MergeCounters readMergeCounters() override;
     void incrMergeCounters(MergeCounters const&) override;
     TmpDirManager& getTmpDirManager() override;
@@ -121,6 +175,9 @@ class BucketManagerImpl : public BucketManager
                       MergeKey* mergeKey,
                       std::unique_ptr<BucketIndex const> index) override;
     void noteEmptyMergeOutput(MergeKey const& mergeKey) override;
+    SharedBucketStore const* getSharedBucketStore() const override;
+    std::shared_ptr<Bucket>
+    adoptBucketFromSharedStore(uint256 const& hash) override;
     std::shared_ptr<Bucket> getBucketIfExists(uint256 const& hash) override;
     std::shared_ptr<Bucket> getBucketByHash(uint256 const& hash) override;
 
@@ -128,6 +185,8 @@ class BucketManagerImpl : public BucketManager
     getMergeFuture(MergeKey const& key) override;
     void putMergeFuture(MergeKey const& key,
                         std::shared_future<std::shared_ptr<Bucket>>) override;
+    void persistFinishedMerges() override;
+    std::vector<std::shared_ptr<Bucket>> loadFinishedMerges() override;
 #ifdef BUILD_TESTS
     void clearMergeFuturesForTesting() override;
 #endif
@@ -150,6 +209,16 @@ class BucketManagerImpl : public BucketManager
 
     medida::Meter& getBloomMissMeter() const override;
     medida::Meter& getBloomLookupMeter() const override;
+    medida::Meter& getBloomSkipMeter() const override;
+    medida::Meter& getReadBytesMeter() const override;
+    medida::Meter& getReadPageFaultsMeter() const override;
+    medida::Histogram& getBatchReadDepthHistogram() const override;
+    medida::Timer& getBatchReadTimer() const override;
+    ShardedCounter& getBloomMissCounter() const override;
+    ShardedCounter& getBloomLookupCounter() const override;
+    ShardedCounter& getBloomSkipCounter() const override;
+    ShardedCounter& getReadBytesCounter() const override;
+    void syncMetrics() override;
 
 #ifdef BUILD_TESTS
     // Install a fake/assumed ledger version and bucket list hash to use in next
@@ -164,6 +233,7 @@ class BucketManagerImpl : public BucketManager
 #endif
 
     std::set<Hash> getBucketListReferencedBuckets() const override;
+    void addMemoryFootprint(MemoryFootprint& footprint) const override;
     std::set<Hash> getAllReferencedBuckets() const override;
     std::vector<std::string>
     checkForMissingBucketsFiles(HistoryArchiveState const& has) override;
@@ -181,12 +251,18 @@ class BucketManagerImpl : public BucketManager
 
     void visitLedgerEntries(
         HistoryArchiveState const& has, std::optional<int64_t> minLedger,
-        std::function<bool(LedgerEntry const&)> const& filterEntry,
-        std::function<bool(LedgerEntry const&)> const& acceptEntry) override;
+        LedgerEntryScanScope const& scope,
+        std::function<std::function<bool(LedgerEntry const&)>()> const&
+            makeFilter,
+        std::function<bool(LedgerEntry const&)> const& acceptEntry,
+        size_t threads) override;
 
     std::shared_ptr<BasicWork> scheduleVerifyReferencedBucketsWork() override;
 
     Config const& getConfig() const override;
+    void postOnBackgroundThread(std::function<void()>&& f,
+                                std::string jobName,
+                                BackgroundPriority priority) const override;
 };
 
 #define SKIP_1 50
@@ -6,7 +6,8 @@
 #include "crypto/Hex.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/MemoryFootprint.h"
+#include "util/Tracing.h"
 
 namespace
 {
@@ -129,4 +130,21 @@ BucketMergeMap::getOutputsUsingInput(Hash const& input,
                    hexAbbrev(i->second), hexAbbrev(input));
     }
 }
+
+UnorderedMap<MergeKey, Hash> const&
+BucketMergeMap::getAllMerges() const
+{
+    return mMergeKeyToOutput;
+}
+
+size_t
+BucketMergeMap::getEstimatedBytes() const
+{
+    return mMergeKeyToOutput.size() *
+               nodeBytes<decltype(mMergeKeyToOutput)::value_type>() +
+           mInputToOutput.size() *
+               nodeBytes<decltype(mInputToOutput)::value_type>() +
+           mOutputToMergeKey.size() *
+               nodeBytes<decltype(mOutputToMergeKey)::value_type>();
+}
 }
@@ -45,5 +45,7 @@ class BucketMergeMap
     UnorderedSet<MergeKey> forgetAllMergesProducing(Hash const& output);
     bool findMergeFor(MergeKey const& input, Hash& output);
     void getOutputsUsingInput(Hash const& input, std::set<Hash>& outputs) const;
+    UnorderedMap<MergeKey, Hash> const& getAllMerges() const;
+    size_t getEstimatedBytes() const;
 };
 }
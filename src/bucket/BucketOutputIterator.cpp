@@ -7,12 +7,15 @@
 #include "bucket/BucketIndex.h"
 #include "bucket/BucketManager.h"
 #include "util/GlobalChecks.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <filesystem>
 
 namespace stellar
 {
 
+// Bytes handed to a hashing job at a time when hashing is pipelined
+static size_t const PIPELINED_HASH_BATCH_SIZE = 1024 * 1024;
+
 /**
  * Helper class that points to an output tempfile. Absorbs BucketEntries and
  * hashes them while writing to either destination. Produces a Bucket when done.
@@ -21,13 +24,21 @@ BucketOutputIterator::BucketOutputIterator(std::string const& tmpDir,
                                            bool keepDeadEntries,
                                            BucketMetadata const& meta,
                                            MergeCounters& mc,
-                                           asio::io_context& ctx, bool doFsync)
+                                           asio::io_context& ctx, bool doFsync,
+                                           PipelinedSHA256::PostJob
+                                               postHashing,
+                                           std::vector<BucketEntry>*
+                                               inMemoryOutput)
     : mFilename(Bucket::randomBucketName(tmpDir))
     , mOut(ctx, doFsync)
     , mBuf(nullptr)
+    , mPipelinedHasher(postHashing ? std::make_unique<PipelinedSHA256>(
+                                         PIPELINED_HASH_BATCH_SIZE, postHashing)
+                                   : nullptr)
     , mKeepDeadEntries(keepDeadEntries)
     , mMeta(meta)
     , mMergeCounters(mc)
+    , mInMemoryOutput(inMemoryOutput)
 {
     ZoneScoped;
     CLOG_TRACE(Bucket, "BucketOutputIterator opening file to write: {}",
@@ -47,6 +58,24 @@ BucketOutputIterator::BucketOutputIterator(std::string const& tmpDir,
     }
 }
 
+void
+BucketOutputIterator::writeBuf()
+{
+    if (mPipelinedHasher)
+    {
+        mOut.writeOne(*mBuf, *mPipelinedHasher, &mBytesPut);
+    }
+    else
+    {
+        mOut.writeOne(*mBuf, &mHasher, &mBytesPut);
+    }
+    if (mInMemoryOutput)
+    {
+        mInMemoryOutput->emplace_back(*mBuf);
+    }
+    mObjectsPut++;
+}
+
 void
 BucketOutputIterator::put(BucketEntry const& e)
 {
@@ -79,8 +108,7 @@ BucketOutputIterator::put(BucketEntry const& e)
         if (mCmp(*mBuf, e))
         {
             ++mMergeCounters.mOutputIteratorActualWrites;
-            mOut.writeOne(*mBuf, &mHasher, &mBytesPut);
-            mObjectsPut++;
+            writeBuf();
         }
     }
     else
@@ -101,8 +129,7 @@ BucketOutputIterator::getBucket(BucketManager& bucketManager,
     ZoneScoped;
     if (mBuf)
     {
-        mOut.writeOne(*mBuf, &mHasher, &mBytesPut);
-        mObjectsPut++;
+        writeBuf();
         mBuf.reset();
     }
 
@@ -120,7 +147,8 @@ BucketOutputIterator::getBucket(BucketManager& bucketManager,
         return std::make_shared<Bucket>();
     }
 
-    auto hash = mHasher.finish();
+    auto hash =
+        mPipelinedHasher ? mPipelinedHasher->finish() : mHasher.finish();
     std::unique_ptr<BucketIndex const> index{};
 
     // If this bucket needs to be indexed and is not already indexed
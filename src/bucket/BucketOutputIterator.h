@@ -6,11 +6,13 @@
 
 #include "bucket/BucketManager.h"
 #include "bucket/LedgerCmp.h"
+#include "crypto/PipelinedSHA256.h"
 #include "util/XDRStream.h"
 #include "xdr/Stellar-ledger.h"
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace stellar
 {
@@ -28,12 +30,17 @@ class BucketOutputIterator
     BucketEntryIdCmp mCmp;
     std::unique_ptr<BucketEntry> mBuf;
     SHA256 mHasher;
+    std::unique_ptr<PipelinedSHA256> mPipelinedHasher;
     size_t mBytesPut{0};
     size_t mObjectsPut{0};
     bool mKeepDeadEntries{true};
     BucketMetadata mMeta;
     bool mPutMeta{false};
     MergeCounters& mMergeCounters;
+    std::vector<BucketEntry>* mInMemoryOutput{nullptr};
+
+    // Writes *mBuf to the output file and hashes it
+    void writeBuf();
 
   public:
     // BucketOutputIterators must _always_ be constructed with BucketMetadata,
@@ -43,9 +50,15 @@ class BucketOutputIterator
     // version new enough that it should _write_ the metadata to the stream in
     // the form of a METAENTRY; but that's not a thing the caller gets to decide
     // (or forget to do), it's handled automatically.
+    //
+    // If postHashing is set, the bucket hash is computed by jobs it posts,
+    // overlapping with serializing and writing entries. If
+    // inMemoryOutput is set, every entry written is also appended to it.
     BucketOutputIterator(std::string const& tmpDir, bool keepDeadEntries,
                          BucketMetadata const& meta, MergeCounters& mc,
-                         asio::io_context& ctx, bool doFsync);
+                         asio::io_context& ctx, bool doFsync,
+                         PipelinedSHA256::PostJob postHashing = nullptr,
+                         std::vector<BucketEntry>* inMemoryOutput = nullptr);
 
     void put(BucketEntry const& e);
 
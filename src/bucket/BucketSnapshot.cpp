@@ -7,22 +7,62 @@
 #include "bucket/BucketListSnapshot.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTypeUtils.h"
+#include "util/Fs.h"
+#include "util/MappedFile.h"
 #include "util/XDRStream.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace stellar
 {
-BucketSnapshot::BucketSnapshot(std::shared_ptr<Bucket const> const b)
-    : mBucket(b)
+namespace
+{
+// Bytes read ahead for each entry of a batched read when the index has no
+// page size
+size_t const BATCH_READ_MIN_BYTES = 4096;
+}
+
+BucketSnapshot::BucketSnapshot(
+    std::shared_ptr<Bucket const> const b,
+    std::shared_ptr<std::vector<BucketEntry> const> inMemoryEntries)
+    : mBucket(b), mInMemoryEntries(std::move(inMemoryEntries))
 {
     releaseAssert(mBucket);
 }
 
 BucketSnapshot::BucketSnapshot(BucketSnapshot const& b)
-    : mBucket(b.mBucket), mStream(nullptr)
+    : mBucket(b.mBucket)
+    , mInMemoryEntries(b.mInMemoryEntries)
+    , mStream(nullptr)
+    , mMappedFile(nullptr)
 {
     releaseAssert(mBucket);
 }
 
+BucketEntry const*
+BucketSnapshot::findInMemory(LedgerKey const& k) const
+{
+    auto entryLess = [](BucketEntry const& be, LedgerKey const& key) {
+        return be.type() == DEADENTRY
+                   ? LedgerEntryIdCmp{}(be.deadEntry(), key)
+                   : LedgerEntryIdCmp{}(be.liveEntry().data, key);
+    };
+    auto keyLess = [](LedgerKey const& key, BucketEntry const& be) {
+        return be.type() == DEADENTRY
+                   ? LedgerEntryIdCmp{}(key, be.deadEntry())
+                   : LedgerEntryIdCmp{}(key, be.liveEntry().data);
+    };
+
+    auto const& entries = *mInMemoryEntries;
+    auto it = std::lower_bound(entries.begin(), entries.end(), k, entryLess);
+    if (it == entries.end() || keyLess(k, *it))
+    {
+        return nullptr;
+    }
+    return &*it;
+}
+
 bool
 BucketSnapshot::isEmpty() const
 {
@@ -40,27 +80,74 @@ BucketSnapshot::getEntryAtOffset(LedgerKey const& k, std::streamoff pos,
         return {std::nullopt, false};
     }
 
-    auto& stream = getStream();
-    stream.seek(pos);
+    auto const& index = mBucket->getIndex();
+    bool found = false;
 
     BucketEntry be;
-    if (pageSize == 0)
+    if (index.useMmapReads())
     {
-        if (stream.readOne(be))
-        {
-            return {std::make_optional(be), false};
-        }
+        // Sampling page faults costs syscalls, so they are only measured on
+        // the mmap path, whose faults are the reads
+        auto faultsBefore = MappedFile::getThreadPageFaults();
+        size_t bytesTouched = 0;
+        auto const& mapped = getMappedFile();
+        found = pageSize == 0 ? mapped.readOneAt(pos, be, bytesTouched)
+                              : mapped.readPageAt(pos, be, k, pageSize,
+                                                  bytesTouched);
+        index.markRead(bytesTouched,
+                       MappedFile::getThreadPageFaults() - faultsBefore);
+    }
+    else
+    {
+        auto& stream = getStream();
+        stream.seek(pos);
+        auto bytesBefore = stream.bytesRead();
+        found = pageSize == 0 ? stream.readOne(be)
+                              : stream.readPage(be, k, pageSize);
+        index.markRead(stream.bytesRead() - bytesBefore, 0);
     }
-    else if (stream.readPage(be, k, pageSize))
+
+    if (found)
     {
         return {std::make_optional(be), false};
     }
 
     // Mark entry miss for metrics
-    mBucket->getIndex().markBloomMiss();
+    index.markBloomMiss();
     return {std::nullopt, true};
 }
 
+size_t
+BucketSnapshot::startBatchRead(std::vector<std::streamoff> const& offsets) const
+{
+    auto const& index = mBucket->getIndex();
+    if (!index.useBatchReads() || offsets.size() < 2)
+    {
+        return 0;
+    }
+
+    ZoneScoped;
+    // Individually indexed entries are given one OS page, which holds most
+    // of them
+    auto len = std::max<size_t>(static_cast<size_t>(index.getPageSize()),
+                                BATCH_READ_MIN_BYTES);
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (auto off : offsets)
+    {
+        auto begin = static_cast<size_t>(off);
+        if (!ranges.empty() &&
+            begin <= ranges.back().first + ranges.back().second)
+        {
+            ranges.back().second = begin + len - ranges.back().first;
+        }
+        else
+        {
+            ranges.emplace_back(begin, len);
+        }
+    }
+    return fs::adviseWillNeed(mBucket->getFilename().string(), ranges);
+}
+
 std::pair<std::optional<BucketEntry>, bool>
 BucketSnapshot::getBucketEntry(LedgerKey const& k) const
 {
@@ -70,6 +157,12 @@ BucketSnapshot::getBucketEntry(LedgerKey const& k) const
         return {std::nullopt, false};
     }
 
+    if (mInMemoryEntries)
+    {
+        auto be = findInMemory(k);
+        return {be ? std::make_optional(*be) : std::nullopt, false};
+    }
+
     auto pos = mBucket->getIndex().lookup(k);
     if (pos.has_value())
     {
@@ -95,30 +188,117 @@ BucketSnapshot::loadKeys(std::set<LedgerKey, LedgerEntryIdCmp>& keys,
         return;
     }
 
-    auto currKeyIt = keys.begin();
+    if (mInMemoryEntries)
+    {
+        for (auto it = keys.begin(); it != keys.end();)
+        {
+            auto be = findInMemory(*it);
+            if (!be)
+            {
+                ++it;
+                continue;
+            }
+            if (be->type() != DEADENTRY)
+            {
+                result.push_back(be->liveEntry());
+            }
+            it = keys.erase(it);
+        }
+        return;
+    }
+
+    // Resolve the offsets of all the keys first, so that their reads can be
+    // submitted together
     auto const& index = mBucket->getIndex();
+    std::vector<std::set<LedgerKey, LedgerEntryIdCmp>::iterator> toRead;
+    std::vector<std::streamoff> offsets;
     auto indexIter = index.begin();
-    while (currKeyIt != keys.end() && indexIter != index.end())
+    for (auto it = keys.begin(); it != keys.end() && indexIter != index.end();
+         ++it)
     {
-        auto [offOp, newIndexIter] = index.scan(indexIter, *currKeyIt);
+        auto [offOp, newIndexIter] = index.scan(indexIter, *it);
         indexIter = newIndexIter;
         if (offOp)
         {
-            auto [entryOp, bloomMiss] = getEntryAtOffset(
-                *currKeyIt, *offOp, mBucket->getIndex().getPageSize());
-            if (entryOp)
+            toRead.emplace_back(it);
+            offsets.emplace_back(*offOp);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto depth = startBatchRead(offsets);
+    for (size_t i = 0; i < toRead.size(); ++i)
+    {
+        auto [entryOp, bloomMiss] =
+            getEntryAtOffset(*toRead[i], offsets[i], index.getPageSize());
+        if (entryOp)
+        {
+            if (entryOp->type() != DEADENTRY)
             {
-                if (entryOp->type() != DEADENTRY)
-                {
-                    result.push_back(entryOp->liveEntry());
-                }
+                result.push_back(entryOp->liveEntry());
+            }
+            keys.erase(toRead[i]);
+        }
+    }
+    if (depth != 0)
+    {
+        index.markBatchRead(depth, std::chrono::steady_clock::now() - start);
+    }
+}
 
-                currKeyIt = keys.erase(currKeyIt);
-                continue;
+void
+BucketSnapshot::lookupKeys(
+    std::vector<LedgerKey> const& keys,
+    std::vector<std::pair<size_t, BucketEntry>>& result) const
+{
+    ZoneScoped;
+    if (isEmpty())
+    {
+        return;
+    }
+
+    if (mInMemoryEntries)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (auto be = findInMemory(keys[i]))
+            {
+                result.emplace_back(i, *be);
             }
         }
+        return;
+    }
 
-        ++currKeyIt;
+    auto const& index = mBucket->getIndex();
+    std::vector<size_t> toRead;
+    std::vector<std::streamoff> offsets;
+    auto indexIter = index.begin();
+    for (size_t i = 0; i < keys.size() && indexIter != index.end(); ++i)
+    {
+        auto [offOp, newIndexIter] = index.scan(indexIter, keys[i]);
+        indexIter = newIndexIter;
+        if (offOp)
+        {
+            toRead.emplace_back(i);
+            offsets.emplace_back(*offOp);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto depth = startBatchRead(offsets);
+    for (size_t j = 0; j < toRead.size(); ++j)
+    {
+        auto i = toRead[j];
+        auto [entryOp, bloomMiss] =
+            getEntryAtOffset(keys[i], offsets[j], index.getPageSize());
+        if (entryOp)
+        {
+            result.emplace_back(i, std::move(*entryOp));
+        }
+    }
+    if (depth != 0)
+    {
+        index.markBatchRead(depth, std::chrono::steady_clock::now() - start);
     }
 }
 
@@ -134,6 +314,45 @@ BucketSnapshot::getPoolIDsByAsset(Asset const& asset) const
     return mBucket->getIndex().getPoolIDsByAsset(asset);
 }
 
+void
+BucketSnapshot::scanRanges(
+    std::vector<std::pair<std::streamoff, std::streamoff>> const& ranges,
+    std::function<bool(BucketEntry const&)> const& f) const
+{
+    ZoneScoped;
+    if (isEmpty())
+    {
+        return;
+    }
+
+    auto& stream = getStream();
+    BucketEntry be;
+    for (auto const& [begin, end] : ranges)
+    {
+        stream.seek(begin);
+        while (stream.pos() < end)
+        {
+            if (!stream.readOne(be))
+            {
+                // Hit eof
+                return;
+            }
+            if (be.type() != METAENTRY && !f(be))
+            {
+                return;
+            }
+        }
+    }
+}
+
+bool
+BucketSnapshot::isSkippedByEvictionScan() const
+{
+    return isEmpty() || protocolVersionIsBefore(
+                            Bucket::getBucketVersion(mBucket),
+                            SOROBAN_PROTOCOL_VERSION);
+}
+
 bool
 BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
                                 uint32_t ledgerSeq,
@@ -141,8 +360,7 @@ BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
                                 SearchableBucketListSnapshot& bl) const
 {
     ZoneScoped;
-    if (isEmpty() || protocolVersionIsBefore(Bucket::getBucketVersion(mBucket),
-                                             SOROBAN_PROTOCOL_VERSION))
+    if (isSkippedByEvictionScan())
     {
         // EOF, skip to next bucket
         return false;
@@ -178,6 +396,40 @@ BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
         }
     };
 
+    // Only contract data entries can be evicted, so the bytes before and after
+    // them are skipped without being read. Skipped bytes still count against
+    // bytesToScan so the scan region ends at the same entry as if they had
+    // been read; if the region ends within them they are read to find that
+    // entry.
+    uint64_t const fileSize = mBucket->getSize();
+    uint64_t dataStart = fileSize;
+    uint64_t dataEnd = fileSize;
+    if (auto dataRange = mBucket->getIndex().getTypeRange(CONTRACT_DATA))
+    {
+        dataStart = static_cast<uint64_t>(dataRange->first);
+        dataEnd = std::min(static_cast<uint64_t>(dataRange->second), fileSize);
+    }
+    auto skipTo = [&](uint64_t target) {
+        if (iter.bucketFileOffset < target &&
+            target - iter.bucketFileOffset < bytesToScan)
+        {
+            bytesToScan -=
+                static_cast<uint32_t>(target - iter.bucketFileOffset);
+            iter.bucketFileOffset = target;
+        }
+    };
+
+    skipTo(dataStart);
+    if (iter.bucketFileOffset >= dataEnd)
+    {
+        skipTo(fileSize);
+    }
+    if (iter.bucketFileOffset >= fileSize)
+    {
+        // Hit eof
+        return false;
+    }
+
     // Open new stream for eviction scan to not interfere with BucketListDB load
     // streams
     XDRInputFileStream stream{};
@@ -219,6 +471,15 @@ BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
         }
 
         bytesToScan -= bytesRead;
+
+        if (iter.bucketFileOffset >= dataEnd)
+        {
+            skipTo(fileSize);
+            if (iter.bucketFileOffset >= fileSize)
+            {
+                break;
+            }
+        }
     }
 
     // Hit eof
@@ -238,6 +499,18 @@ BucketSnapshot::getStream() const
     return *mStream;
 }
 
+XDRInputMappedFile&
+BucketSnapshot::getMappedFile() const
+{
+    releaseAssertOrThrow(!isEmpty());
+    if (!mMappedFile)
+    {
+        mMappedFile =
+            std::make_unique<XDRInputMappedFile>(mBucket->getFilename());
+    }
+    return *mMappedFile;
+}
+
 std::shared_ptr<Bucket const>
 BucketSnapshot::getRawBucket() const
 {
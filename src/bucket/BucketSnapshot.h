@@ -6,8 +6,11 @@
 
 #include "bucket/LedgerCmp.h"
 #include "util/NonCopyable.h"
+#include <functional>
 #include <list>
+#include <memory>
 #include <set>
+#include <vector>
 
 #include <optional>
 
@@ -16,6 +19,7 @@ namespace stellar
 
 class Bucket;
 class XDRInputFileStream;
+class XDRInputMappedFile;
 class SearchableBucketListSnapshot;
 struct EvictionResultEntry;
 
@@ -24,6 +28,14 @@ class BucketSnapshot : public NonMovable
 {
     std::shared_ptr<Bucket const> const mBucket;
 
+    // Entries of the bucket when its level is kept in memory (see
+    // BUCKETLIST_DB_IN_MEMORY_LEVELS), searched by lookups instead of the
+    // bucket file. Shared by all copies of the snapshot.
+    std::shared_ptr<std::vector<BucketEntry> const> const mInMemoryEntries;
+
+    // Returns the entry of mInMemoryEntries for LedgerKey k, or nullptr
+    BucketEntry const* findInMemory(LedgerKey const& k) const;
+
     // Lazily-constructed and retained for read path.
     mutable std::unique_ptr<XDRInputFileStream> mStream{};
 
@@ -32,6 +44,12 @@ class BucketSnapshot : public NonMovable
     // must be seek()'ed before use.
     XDRInputFileStream& getStream() const;
 
+    // Lazily-constructed memory mapping of the bucket file, used instead of
+    // mStream when BUCKETLIST_DB_MMAP_READS is enabled.
+    mutable std::unique_ptr<XDRInputMappedFile> mMappedFile{};
+
+    XDRInputMappedFile& getMappedFile() const;
+
     // Loads the bucket entry for LedgerKey k. Starts at file offset pos and
     // reads until key is found or the end of the page. Returns <BucketEntry,
     // bloomMiss>, where bloomMiss is true if a bloomMiss occurred during the
@@ -40,7 +58,15 @@ class BucketSnapshot : public NonMovable
     getEntryAtOffset(LedgerKey const& k, std::streamoff pos,
                      size_t pageSize) const;
 
-    BucketSnapshot(std::shared_ptr<Bucket const> const b);
+    // If the index uses batched reads, asks the OS to read the pages at
+    // offsets, in file order, all at once before they are loaded by
+    // getEntryAtOffset. Returns the number of reads submitted, 0 if none.
+    size_t startBatchRead(std::vector<std::streamoff> const& offsets) const;
+
+    BucketSnapshot(
+        std::shared_ptr<Bucket const> const b,
+        std::shared_ptr<std::vector<BucketEntry> const> inMemoryEntries =
+            nullptr);
 
     // Only allow copy constructor, is threadsafe
     BucketSnapshot(BucketSnapshot const& b);
@@ -50,6 +76,9 @@ class BucketSnapshot : public NonMovable
     bool isEmpty() const;
     std::shared_ptr<Bucket const> getRawBucket() const;
 
+    // True if eviction scans go past this bucket without scanning it
+    bool isSkippedByEvictionScan() const;
+
     // Loads bucket entry for LedgerKey k. Returns <BucketEntry, bloomMiss>,
     // where bloomMiss is true if a bloomMiss occurred during the load.
     std::pair<std::optional<BucketEntry>, bool>
@@ -60,15 +89,32 @@ class BucketSnapshot : public NonMovable
     void loadKeys(std::set<LedgerKey, LedgerEntryIdCmp>& keys,
                   std::vector<LedgerEntry>& result) const;
 
+    // Looks up every key in keys, which must be sorted by LedgerEntryIdCmp.
+    // For every key found in this bucket (including DEADENTRY), appends
+    // <index of key in keys, BucketEntry> to result. Unlike loadKeys, keys is
+    // not modified and shadowing is left to the caller, so every bucket can be
+    // searched concurrently via separate BucketSnapshot copies.
+    void lookupKeys(std::vector<LedgerKey> const& keys,
+                    std::vector<std::pair<size_t, BucketEntry>>& result) const;
+
     // Return all PoolIDs that contain the given asset on either side of the
     // pool
     std::vector<PoolID> const& getPoolIDsByAsset(Asset const& asset) const;
 
+    // Calls f on every entry starting within ranges, which must be sorted and
+    // disjoint (i.e. from BucketIndex::getTrustlineRangesByAsset), in file
+    // order. Stops early if f returns false.
+    void
+    scanRanges(std::vector<std::pair<std::streamoff, std::streamoff>> const&
+                   ranges,
+               std::function<bool(BucketEntry const&)> const& f) const;
+
     bool scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
                          uint32_t ledgerSeq,
                          std::list<EvictionResultEntry>& evictableKeys,
                          SearchableBucketListSnapshot& bl) const;
 
     friend struct BucketLevelSnapshot;
+    friend class SearchableBucketListSnapshot;
 };
 }
\ No newline at end of file
@@ -3,13 +3,20 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "bucket/BucketSnapshotManager.h"
+#include "bucket/Bucket.h"
 #include "bucket/BucketListSnapshot.h"
 #include "main/Application.h"
+#include "main/Config.h"
+#include "util/Logging.h"
+#include "util/UnorderedSet.h"
 #include "util/XDRStream.h" // IWYU pragma: keep
 
+#include "medida/counter.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 
+#include <set>
+
 namespace stellar
 {
 
@@ -17,14 +24,45 @@ BucketSnapshotManager::BucketSnapshotManager(
     Application& app, std::unique_ptr<BucketListSnapshot const>&& snapshot)
     : mApp(app)
     , mCurrentSnapshot(std::move(snapshot))
+    , mRetainedSnapshotsCounter(app.getMetrics().NewCounter(
+          {"bucketlistDB", "retained-snapshots", "count"}))
+    , mRetainedBucketsCounter(app.getMetrics().NewCounter(
+          {"bucketlistDB", "retained-snapshots", "buckets"}))
+    , mRetainedBytesCounter(app.getMetrics().NewCounter(
+          {"bucketlistDB", "retained-snapshots", "bytes"}))
     , mBulkLoadMeter(app.getMetrics().NewMeter(
           {"bucketlistDB", "query", "loads"}, "query"))
     , mBloomMisses(app.getMetrics().NewMeter(
           {"bucketlistDB", "bloom", "misses"}, "bloom"))
     , mBloomLookups(app.getMetrics().NewMeter(
           {"bucketlistDB", "bloom", "lookups"}, "bloom"))
+    , mAsyncPrefetchMeter(app.getMetrics().NewMeter(
+          {"bucketlistDB", "prefetch", "async"}, "entry"))
 {
     releaseAssert(threadIsMain());
+    releaseAssert(mCurrentSnapshot);
+
+    if (auto cacheSize = app.getConfig().BUCKETLIST_DB_CACHED_ENTRIES;
+        cacheSize != 0)
+    {
+        mEntryCache = std::make_unique<EntryCache>(cacheSize);
+        mCacheLedgerSeq = mCurrentSnapshot->getLedgerSeq();
+
+        // Meters are registered up front so that they can be marked from any
+        // thread without mutating the maps
+        for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+        {
+            auto type = static_cast<LedgerEntryType>(let);
+            std::string label =
+                xdr::xdr_traits<LedgerEntryType>::enum_name(type);
+            mCacheHitMeters.emplace(
+                type, app.getMetrics().NewMeter(
+                          {"bucketlistDB", "cache-hit", label}, "entry"));
+            mCacheMissMeters.emplace(
+                type, app.getMetrics().NewMeter(
+                          {"bucketlistDB", "cache-miss", label}, "entry"));
+        }
+    }
 }
 
 std::shared_ptr<SearchableBucketListSnapshot>
@@ -59,6 +97,75 @@ BucketSnapshotManager::recordBulkLoadMetrics(std::string const& label,
     return iter->second;
 }
 
+bool
+BucketSnapshotManager::prefetchAsync(LedgerKeySet keys) const
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+
+    // Without the cache there is nowhere to keep the loaded entries
+    if (!mEntryCache || keys.empty())
+    {
+        return false;
+    }
+
+    // Bound the number of queued warm-up loads so that a burst of
+    // nominations can't starve merges and eviction scans of worker threads
+    auto maxPending = getNumBackgroundThreads();
+    if (mPendingPrefetches.load() >= maxPending)
+    {
+        return false;
+    }
+
+    ++mPendingPrefetches;
+    mAsyncPrefetchMeter.Mark(keys.size());
+
+    // If a ledger closes while the load runs, the cache rejects the results
+    // read from the older snapshot, so stale entries are never cached
+    postOnBackgroundThread(
+        [this, keys = std::move(keys)]() {
+            try
+            {
+                getSearchableBucketListSnapshot()->loadKeys(keys);
+            }
+            catch (std::exception const& e)
+            {
+                // Warm-up is best effort, apply will load the keys itself
+                CLOG_WARNING(Bucket, "Async prefetch failed: {}", e.what());
+            }
+            --mPendingPrefetches;
+        },
+        "BucketSnapshotManager: async prefetch", BackgroundPriority::HIGH);
+    return true;
+}
+
+size_t
+BucketSnapshotManager::getParallelLoadMinKeys() const
+{
+    return mApp.getConfig().BUCKETLIST_DB_PARALLEL_LOAD_MIN_KEYS;
+}
+
+size_t
+BucketSnapshotManager::getNumBackgroundThreads() const
+{
+    auto const& cfg = mApp.getConfig();
+    auto threads = cfg.WORKER_THREADS;
+    if (cfg.EXPERIMENTAL_BACKGROUND_EVICTION_SCAN)
+    {
+        // One worker is reserved for the eviction scan
+        --threads;
+    }
+    return threads > 0 ? static_cast<size_t>(threads) : 0;
+}
+
+void
+BucketSnapshotManager::postOnBackgroundThread(
+    std::function<void()>&& f, std::string jobName,
+    BackgroundPriority priority) const
+{
+    mApp.postOnBackgroundThread(std::move(f), std::move(jobName), priority);
+}
+
 void
 BucketSnapshotManager::maybeUpdateSnapshot(
     std::unique_ptr<BucketListSnapshot const>& snapshot) const
@@ -83,7 +190,245 @@ BucketSnapshotManager::updateCurrentSnapshot(
     std::lock_guard<std::recursive_mutex> lock(mSnapshotMutex);
     releaseAssert(!mCurrentSnapshot || newSnapshot->getLedgerSeq() >=
                                            mCurrentSnapshot->getLedgerSeq());
+
+    if (mEntryCache)
+    {
+        std::lock_guard<std::mutex> cacheLock(mCacheMutex);
+        mEntryCache->clear();
+        mCacheLedgerSeq = newSnapshot->getLedgerSeq();
+    }
+
+    mCurrentSnapshot.swap(newSnapshot);
+    retainSnapshot(std::move(newSnapshot));
+}
+
+void
+BucketSnapshotManager::updateCurrentSnapshot(
+    std::unique_ptr<BucketListSnapshot const>&& newSnapshot,
+    std::vector<LedgerEntry> const& initEntries,
+    std::vector<LedgerEntry> const& liveEntries,
+    std::vector<LedgerKey> const& deadEntries)
+{
+    releaseAssert(newSnapshot);
+    releaseAssert(threadIsMain());
+    std::lock_guard<std::recursive_mutex> lock(mSnapshotMutex);
+    releaseAssert(!mCurrentSnapshot || newSnapshot->getLedgerSeq() >=
+                                           mCurrentSnapshot->getLedgerSeq());
+
+    if (mEntryCache)
+    {
+        ZoneNamedN(invalidateZone, "invalidate entry cache", true);
+        std::lock_guard<std::mutex> cacheLock(mCacheMutex);
+        for (auto const& e : initEntries)
+        {
+            mEntryCache->erase(LedgerEntryKey(e));
+        }
+        for (auto const& e : liveEntries)
+        {
+            mEntryCache->erase(LedgerEntryKey(e));
+        }
+        for (auto const& k : deadEntries)
+        {
+            mEntryCache->erase(k);
+        }
+
+        // Every remaining entry is unchanged between the old and new snapshot
+        mCacheLedgerSeq = newSnapshot->getLedgerSeq();
+    }
+
     mCurrentSnapshot.swap(newSnapshot);
+    retainSnapshot(std::move(newSnapshot));
+}
+
+void
+BucketSnapshotManager::retainSnapshot(
+    std::unique_ptr<BucketListSnapshot const>&& oldSnapshot)
+{
+    ZoneScoped;
+    std::lock_guard<std::recursive_mutex> lock(mSnapshotMutex);
+    auto const maxRetained = mApp.getConfig().BUCKETLIST_DB_RETAINED_SNAPSHOTS;
+    if (maxRetained == 0)
+    {
+        return;
+    }
+    if (oldSnapshot &&
+        oldSnapshot->getLedgerSeq() < mCurrentSnapshot->getLedgerSeq())
+    {
+        auto seq = oldSnapshot->getLedgerSeq();
+        mRetainedSnapshots[seq] = std::move(oldSnapshot);
+    }
+    while (mRetainedSnapshots.size() > maxRetained)
+    {
+        mRetainedSnapshots.erase(mRetainedSnapshots.begin());
+    }
+
+    // Retained snapshots only cost the buckets the current one no longer has,
+    // which stay on disk along with their indexes
+    std::set<Bucket const*> current;
+    for (auto const& level : mCurrentSnapshot->getLevels())
+    {
+        current.emplace(level.curr.getRawBucket().get());
+        current.emplace(level.snap.getRawBucket().get());
+    }
+    std::set<Bucket const*> retainedOnly;
+    int64_t bytes = 0;
+    for (auto const& [seq, snapshot] : mRetainedSnapshots)
+    {
+        for (auto const& level : snapshot->getLevels())
+        {
+            for (auto const* b : {&level.curr, &level.snap})
+            {
+                auto const* bucket = b->getRawBucket().get();
+                if (current.count(bucket) == 0 &&
+                    retainedOnly.emplace(bucket).second)
+                {
+                    bytes += bucket->getSize();
+                }
+            }
+        }
+    }
+    mRetainedSnapshotsCounter.set_count(mRetainedSnapshots.size());
+    mRetainedBucketsCounter.set_count(retainedOnly.size());
+    mRetainedBytesCounter.set_count(bytes);
+}
+
+std::unique_ptr<BucketListSnapshot const>
+BucketSnapshotManager::copyRetainedSnapshot(uint32_t ledgerSeq) const
+{
+    std::lock_guard<std::recursive_mutex> lock(mSnapshotMutex);
+    auto it = mRetainedSnapshots.find(ledgerSeq);
+    if (it == mRetainedSnapshots.end())
+    {
+        return nullptr;
+    }
+    return std::make_unique<BucketListSnapshot>(*it->second);
+}
+
+bool
+BucketSnapshotManager::isEntryCacheEnabled() const
+{
+    return static_cast<bool>(mEntryCache);
+}
+
+void
+BucketSnapshotManager::setEntryCacheSize(size_t size) const
+{
+    if (!mEntryCache)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    mEntryCache->setMaxSize(size);
+}
+
+std::optional<std::shared_ptr<LedgerEntry const>>
+BucketSnapshotManager::getCachedEntry(LedgerKey const& k,
+                                      uint32_t ledgerSeq) const
+{
+    if (!mEntryCache)
+    {
+        return std::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    if (ledgerSeq != mCacheLedgerSeq)
+    {
+        return std::nullopt;
+    }
+
+    if (auto cached = mEntryCache->maybeGet(k))
+    {
+        mCacheHitMeters.at(k.type()).Mark();
+        return *cached;
+    }
+
+    mCacheMissMeters.at(k.type()).Mark();
+    return std::nullopt;
+}
+
+void
+BucketSnapshotManager::getCachedEntries(
+    std::set<LedgerKey, LedgerEntryIdCmp>& keys,
+    std::vector<LedgerEntry>& result, uint32_t ledgerSeq) const
+{
+    if (!mEntryCache)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    if (ledgerSeq != mCacheLedgerSeq)
+    {
+        return;
+    }
+
+    for (auto iter = keys.begin(); iter != keys.end();)
+    {
+        if (auto cached = mEntryCache->maybeGet(*iter))
+        {
+            mCacheHitMeters.at(iter->type()).Mark();
+            if (*cached)
+            {
+                result.emplace_back(**cached);
+            }
+            iter = keys.erase(iter);
+        }
+        else
+        {
+            mCacheMissMeters.at(iter->type()).Mark();
+            ++iter;
+        }
+    }
+}
+
+void
+BucketSnapshotManager::cacheEntry(
+    LedgerKey const& k, std::shared_ptr<LedgerEntry const> const& entry,
+    uint32_t ledgerSeq) const
+{
+    if (!mEntryCache)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    if (ledgerSeq == mCacheLedgerSeq)
+    {
+        mEntryCache->put(k, entry);
+    }
+}
+
+void
+BucketSnapshotManager::cacheEntries(
+    std::set<LedgerKey, LedgerEntryIdCmp> const& keys,
+    std::vector<LedgerEntry> const& result, uint32_t ledgerSeq) const
+{
+    if (!mEntryCache)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    if (ledgerSeq != mCacheLedgerSeq)
+    {
+        return;
+    }
+
+    UnorderedSet<LedgerKey> found;
+    for (auto const& le : result)
+    {
+        auto k = LedgerEntryKey(le);
+        mEntryCache->put(k, std::make_shared<LedgerEntry const>(le));
+        found.emplace(std::move(k));
+    }
+
+    for (auto const& k : keys)
+    {
+        if (found.find(k) == found.end())
+        {
+            mEntryCache->put(k, nullptr);
+        }
+    }
 }
 
 void
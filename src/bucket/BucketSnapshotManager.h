@@ -5,14 +5,21 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "bucket/BucketManagerImpl.h"
+#include "bucket/LedgerCmp.h"
+#include "ledger/LedgerHashUtils.h"
+#include "util/BackgroundPriority.h"
 #include "util/NonCopyable.h"
+#include "util/RandomEvictionCache.h"
 #include "util/UnorderedMap.h"
 
+#include <atomic>
+#include <map>
 #include <memory>
 #include <mutex>
 
 namespace medida
 {
+class Counter;
 class Meter;
 class MetricsRegistry;
 class Timer;
@@ -38,9 +45,19 @@ class BucketSnapshotManager : NonMovableOrCopyable
     // snapshot, they will copy this snapshot.
     std::unique_ptr<BucketListSnapshot const> mCurrentSnapshot{};
 
-    // Lock must be held when accessing mCurrentSnapshot
+    // The snapshots mCurrentSnapshot replaced, by ledger, up to
+    // BUCKETLIST_DB_RETAINED_SNAPSHOTS of the latest ones. They share most of
+    // their buckets with each other and with mCurrentSnapshot.
+    std::map<uint32_t, std::unique_ptr<BucketListSnapshot const>>
+        mRetainedSnapshots;
+
+    // Lock must be held when accessing mCurrentSnapshot or mRetainedSnapshots
     mutable std::recursive_mutex mSnapshotMutex;
 
+    medida::Counter& mRetainedSnapshotsCounter;
+    medida::Counter& mRetainedBucketsCounter;
+    medida::Counter& mRetainedBytesCounter;
+
     mutable UnorderedMap<LedgerEntryType, medida::Timer&> mPointTimers{};
     mutable UnorderedMap<std::string, medida::Timer&> mBulkTimers{};
 
@@ -50,11 +67,46 @@ class BucketSnapshotManager : NonMovableOrCopyable
 
     mutable std::optional<VirtualClock::time_point> mTimerStart;
 
+    // Cache of BucketListDB lookup results shared by every
+    // SearchableBucketListSnapshot, so hot entries stay in memory across
+    // snapshot generations. A null value records that a key does not exist.
+    // Cached values are valid for the snapshot of mCacheLedgerSeq. When a new
+    // snapshot is installed, only the keys modified by that ledger are
+    // invalidated. Null if BUCKETLIST_DB_CACHED_ENTRIES == 0.
+    using EntryCache =
+        RandomEvictionCache<LedgerKey, std::shared_ptr<LedgerEntry const>>;
+    mutable std::unique_ptr<EntryCache> mEntryCache;
+    uint32_t mCacheLedgerSeq{0};
+
+    // Lock must be held when accessing mEntryCache or mCacheLedgerSeq
+    mutable std::mutex mCacheMutex;
+
+    UnorderedMap<LedgerEntryType, medida::Meter&> mCacheHitMeters;
+    UnorderedMap<LedgerEntryType, medida::Meter&> mCacheMissMeters;
+
+    // Number of prefetchAsync loads posted to the worker pool that have not
+    // finished yet
+    mutable std::atomic<size_t> mPendingPrefetches{0};
+    medida::Meter& mAsyncPrefetchMeter;
+
     // Called by main thread to update mCurrentSnapshot whenever the BucketList
-    // is updated
+    // is updated. Drops the entire entry cache.
     void updateCurrentSnapshot(
         std::unique_ptr<BucketListSnapshot const>&& newSnapshot);
 
+    // Called by main thread when the BucketList is updated by addBatch.
+    // Only the cached entries for keys modified by the batch are invalidated.
+    void updateCurrentSnapshot(
+        std::unique_ptr<BucketListSnapshot const>&& newSnapshot,
+        std::vector<LedgerEntry> const& initEntries,
+        std::vector<LedgerEntry> const& liveEntries,
+        std::vector<LedgerKey> const& deadEntries);
+
+    // Keeps `oldSnapshot`, just replaced by mCurrentSnapshot, if snapshots
+    // are retained, and updates the retained snapshot metrics
+    void
+    retainSnapshot(std::unique_ptr<BucketListSnapshot const>&& oldSnapshot);
+
     friend void
     BucketManagerImpl::addBatch(Application& app, uint32_t currLedger,
                                 uint32_t currLedgerProtocol,
@@ -77,10 +129,75 @@ class BucketSnapshotManager : NonMovableOrCopyable
     void maybeUpdateSnapshot(
         std::unique_ptr<BucketListSnapshot const>& snapshot) const;
 
+    // Returns a copy of the retained snapshot of ledger `ledgerSeq`, or null
+    // if it is not retained
+    std::unique_ptr<BucketListSnapshot const>
+    copyRetainedSnapshot(uint32_t ledgerSeq) const;
+
     // All metric recording functions must only be called by the main thread
     void startPointLoadTimer() const;
     void endPointLoadTimer(LedgerEntryType t, bool bloomMiss) const;
     medida::Timer& recordBulkLoadMetrics(std::string const& label,
                                          size_t numEntries) const;
+
+    // Entry cache interface, safe to call from any thread. Lookups and inserts
+    // are no-ops if the cache is disabled or if the caller's snapshot
+    // (ledgerSeq) is not the snapshot the cache currently reflects.
+    bool isEntryCacheEnabled() const;
+
+    // Returns the cached lookup result for k. A populated optional holding a
+    // null pointer means k is known not to exist.
+    std::optional<std::shared_ptr<LedgerEntry const>>
+    getCachedEntry(LedgerKey const& k, uint32_t ledgerSeq) const;
+
+    // Removes every cached key from keys and adds the cached entries that
+    // exist to result.
+    void getCachedEntries(std::set<LedgerKey, LedgerEntryIdCmp>& keys,
+                          std::vector<LedgerEntry>& result,
+                          uint32_t ledgerSeq) const;
+
+    // Caches the lookup result of k. A null entry records that k does not
+    // exist.
+    void cacheEntry(LedgerKey const& k,
+                    std::shared_ptr<LedgerEntry const> const& entry,
+                    uint32_t ledgerSeq) const;
+
+    // Caches the result of a bulk load: every entry in result, and every key
+    // in keys that is missing from result as nonexistent.
+    void cacheEntries(std::set<LedgerKey, LedgerEntryIdCmp> const& keys,
+                      std::vector<LedgerEntry> const& result,
+                      uint32_t ledgerSeq) const;
+
+    // Resizes the entry cache, evicting entries if it shrinks. No-op if the
+    // cache is disabled.
+    void setEntryCacheSize(size_t size) const;
+
+    // Schedules a load of keys from the current snapshot on the worker pool,
+    // populating the entry cache so that later lookups of keys are served
+    // from memory. Returns false without scheduling anything if the entry
+    // cache is disabled, there are no background threads, or every
+    // background thread already has a prefetch in flight. Must be called from
+    // the main thread.
+    bool prefetchAsync(LedgerKeySet keys) const;
+
+#ifdef BUILD_TESTS
+    size_t
+    getPendingPrefetchesForTesting() const
+    {
+        return mPendingPrefetches.load();
+    }
+#endif
+
+    // Returns the minimum bulk load size for which per-bucket lookups are
+    // parallelized, or 0 if parallel loads are disabled
+    size_t getParallelLoadMinKeys() const;
+
+    // Returns the number of threads in the worker pool used by
+    // postOnBackgroundThread
+    size_t getNumBackgroundThreads() const;
+
+    void postOnBackgroundThread(
+        std::function<void()>&& f, std::string jobName,
+        BackgroundPriority priority = BackgroundPriority::NORMAL) const;
 };
 }
\ No newline at end of file
@@ -19,7 +19,7 @@
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
 #include "util/Thread.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 #include "medida/metrics_registry.h"
@@ -396,8 +396,9 @@ FutureBucket::startMerge(Application& app, uint32_t maxProtocolVersion,
 
     mOutputBucketFuture = task->get_future().share();
     bm.putMergeFuture(mk, mOutputBucketFuture);
-    app.postOnBackgroundThread(bind(&task_t::operator(), task),
-                               "FutureBucket: merge");
+    bm.scheduleMerge(bind(&task_t::operator(), task),
+                     curr->getSize() + snap->getSize(), level,
+                     std::chrono::steady_clock::now() + availableTime);
     checkState();
 }
 
@@ -0,0 +1,192 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/SharedBucketStore.h"
+#include "crypto/Hex.h"
+#include "crypto/Random.h"
+#include "util/Fs.h"
+#include "util/Logging.h"
+#include "util/Tracing.h"
+#include <cstring>
+#include <filesystem>
+#include <fmt/format.h>
+#include <regex>
+
+namespace stellar
+{
+
+namespace
+{
+// Hard link where possible, so the file takes no extra space; copy across
+// filesystems
+bool
+linkOrCopy(std::string const& src, std::string const& dst)
+{
+    std::error_code ec;
+    std::filesystem::create_hard_link(src, dst, ec);
+    if (ec)
+    {
+        ec.clear();
+        std::filesystem::copy_file(src, dst, ec);
+    }
+    return !ec;
+}
+
+// Whether only the store still links to a file. Copies are never linked to,
+// so they count as unreferenced once any instance releases them.
+bool
+isUnreferenced(std::string const& path)
+{
+    std::error_code ec;
+    auto links = std::filesystem::hard_link_count(path, ec);
+    return !ec && links <= 1;
+}
+}
+
+SharedBucketStore::SharedBucketStore(std::string const& dir) : mDir(dir)
+{
+    if (!fs::exists(mDir) && !fs::mkpath(mDir))
+    {
+        throw std::runtime_error("Unable to create shared bucket directory: " +
+                                 mDir);
+    }
+}
+
+std::string
+SharedBucketStore::bucketPath(Hash const& hash) const
+{
+    return mDir + "/bucket-" + binToHex(hash) + ".xdr";
+}
+
+std::string
+SharedBucketStore::indexPath(Hash const& hash) const
+{
+    return mDir + "/bucket-" + binToHex(hash) + ".index";
+}
+
+void
+SharedBucketStore::add(std::string const& localFile,
+                       std::string const& storeFile) const
+{
+    ZoneScoped;
+    if (fs::exists(storeFile))
+    {
+        return;
+    }
+
+    // Link under a temporary name first so that other instances only ever
+    // see complete files
+    auto tmp = fmt::format(FMT_STRING("{}.tmp-{}"), storeFile,
+                           binToHex(randomBytes(8)));
+    if (!linkOrCopy(localFile, tmp))
+    {
+        CLOG_WARNING(Bucket, "Could not add {} to shared bucket directory {}",
+                     localFile, mDir);
+        std::remove(tmp.c_str());
+        return;
+    }
+    if (std::rename(tmp.c_str(), storeFile.c_str()) != 0)
+    {
+        CLOG_WARNING(Bucket, "Could not rename {} to {}: {}", tmp, storeFile,
+                     strerror(errno));
+        std::remove(tmp.c_str());
+        return;
+    }
+    CLOG_DEBUG(Bucket, "Added {} to shared bucket directory as {}", localFile,
+               storeFile);
+}
+
+bool
+SharedBucketStore::get(std::string const& storeFile,
+                       std::string const& localFile) const
+{
+    ZoneScoped;
+    if (!fs::exists(storeFile))
+    {
+        return false;
+    }
+    if (!linkOrCopy(storeFile, localFile))
+    {
+        // Most likely removed by another instance in the meantime
+        std::remove(localFile.c_str());
+        return false;
+    }
+    CLOG_DEBUG(Bucket, "Took {} from shared bucket directory as {}", storeFile,
+               localFile);
+    return true;
+}
+
+bool
+SharedBucketStore::hasBucket(Hash const& hash) const
+{
+    return fs::exists(bucketPath(hash));
+}
+
+void
+SharedBucketStore::addBucket(Hash const& hash,
+                             std::string const& localFile) const
+{
+    add(localFile, bucketPath(hash));
+}
+
+void
+SharedBucketStore::addIndex(Hash const& hash,
+                            std::string const& localFile) const
+{
+    add(localFile, indexPath(hash));
+}
+
+bool
+SharedBucketStore::getBucket(Hash const& hash,
+                             std::string const& localFile) const
+{
+    return get(bucketPath(hash), localFile);
+}
+
+bool
+SharedBucketStore::getIndex(Hash const& hash,
+                            std::string const& localFile) const
+{
+    return get(indexPath(hash), localFile);
+}
+
+void
+SharedBucketStore::release(Hash const& hash) const
+{
+    ZoneScoped;
+    auto bucket = bucketPath(hash);
+    if (isUnreferenced(bucket))
+    {
+        CLOG_TRACE(Bucket, "Removing {} from shared bucket directory", bucket);
+        std::remove(bucket.c_str());
+        auto index = indexPath(hash);
+        std::remove(index.c_str());
+    }
+}
+
+void
+SharedBucketStore::collectGarbage() const
+{
+    ZoneScoped;
+    std::regex entry("bucket-[a-z0-9]{64}\\.(xdr|index)");
+    size_t removed = 0;
+    for (auto const& f : fs::findfiles(mDir, [&](std::string const& name) {
+             return std::regex_match(name, entry);
+         }))
+    {
+        auto path = mDir + "/" + f;
+        if (isUnreferenced(path))
+        {
+            std::remove(path.c_str());
+            ++removed;
+        }
+    }
+    if (removed > 0)
+    {
+        CLOG_INFO(Bucket,
+                  "Removed {} unused files from shared bucket directory {}",
+                  removed, mDir);
+    }
+}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "xdr/Stellar-types.h"
+#include <string>
+
+namespace stellar
+{
+
+// A directory of bucket files and persisted bucket indexes, named by bucket
+// hash, that several stellar-core instances on the same host share (see
+// SHARED_BUCKET_DIR_PATH). Each instance adds the buckets it adopts and the
+// indexes it saves, and takes buckets it is missing from here rather than
+// downloading and indexing them again.
+//
+// Entries are hard links to the instances' own bucket files where the store is
+// on the same filesystem, so a bucket takes the disk space once however many
+// instances hold it; elsewhere they are copies. Bucket files never change once
+// adopted and every entry appears by an atomic rename, so instances need no
+// lock between them: at worst one misses an entry another is removing and
+// downloads it instead.
+//
+// All methods only touch the filesystem and are safe to call from any thread.
+// Failures are logged and otherwise ignored, as the store is only a cache.
+class SharedBucketStore
+{
+    std::string const mDir;
+
+    std::string bucketPath(Hash const& hash) const;
+    std::string indexPath(Hash const& hash) const;
+
+    void add(std::string const& localFile, std::string const& storeFile) const;
+    bool get(std::string const& storeFile, std::string const& localFile) const;
+
+  public:
+    explicit SharedBucketStore(std::string const& dir);
+
+    std::string const&
+    getDir() const
+    {
+        return mDir;
+    }
+
+    bool hasBucket(Hash const& hash) const;
+
+    // Adds a bucket file (or its index) from the local bucket directory,
+    // unless the store has it already.
+    void addBucket(Hash const& hash, std::string const& localFile) const;
+    void addIndex(Hash const& hash, std::string const& localFile) const;
+
+    // Links (or copies) the bucket file (or its index) to `localFile`, which
+    // should be a fresh name on the local bucket directory's filesystem.
+    // Returns false if the store does not have it.
+    bool getBucket(Hash const& hash, std::string const& localFile) const;
+    bool getIndex(Hash const& hash, std::string const& localFile) const;
+
+    // Called when this instance drops its own copy of a bucket: removes the
+    // bucket and its index from the store if no other instance links to them.
+    void release(Hash const& hash) const;
+
+    // Removes every bucket and index that no instance links to any more, for
+    // example after an instance deleted its whole bucket directory.
+    void collectGarbage() const;
+};
+}
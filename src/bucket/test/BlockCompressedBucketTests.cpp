@@ -0,0 +1,103 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BlockCompressedBucket.h"
+#include "bucket/Bucket.h"
+#include "bucket/BucketInputIterator.h"
+#include "bucket/BucketManager.h"
+#include "bucket/test/BucketTestUtils.h"
+#include "ledger/test/LedgerTestUtils.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "test/TestUtils.h"
+#include "test/test.h"
+#include "util/types.h"
+
+using namespace stellar;
+using namespace BucketTestUtils;
+
+TEST_CASE("block-compressed buckets", "[bucket]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    auto app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+
+    auto live = LedgerTestUtils::generateValidUniqueLedgerEntries(2000);
+    auto bucket = Bucket::fresh(bm, getAppLedgerVersion(app), {}, live, {},
+                                /*countMergeEvents=*/true,
+                                clock.getIOContext(), /*doFsync=*/true);
+
+    size_t const blockSize = 4096;
+    auto filename = Bucket::randomBucketName(bm.getTmpDir());
+    auto stats =
+        writeBlockCompressedBucket(bucket->getFilename(), filename, blockSize);
+    REQUIRE(stats.mRawHash == bucket->getHash());
+    REQUIRE(stats.mRawBytes == bucket->getSize());
+    REQUIRE(stats.mBlocks > 1);
+
+    // Entries of the bucket file with their offsets
+    std::vector<std::pair<std::streamoff, BucketEntry>> entries;
+    {
+        std::streamoff pos = 0;
+        BucketInputIterator in(bucket);
+        if (in.seenMetadata())
+        {
+            BucketEntry meta;
+            meta.type(METAENTRY);
+            meta.metaEntry() = in.getMetadata();
+            entries.emplace_back(pos, meta);
+            pos += xdr::xdr_size(meta) + 4;
+        }
+        for (; in; ++in)
+        {
+            entries.emplace_back(pos, *in);
+            pos += xdr::xdr_size(*in) + 4;
+        }
+    }
+
+    BlockCompressedBucketReader reader(filename);
+    REQUIRE(reader.getRawSize() == bucket->getSize());
+    REQUIRE(reader.getBlockCount() == stats.mBlocks);
+
+    SECTION("streaming")
+    {
+        std::vector<BucketEntry> read;
+        reader.forEach([&](BucketEntry const& be) { read.emplace_back(be); });
+        REQUIRE(read.size() == entries.size());
+        for (size_t i = 0; i < read.size(); ++i)
+        {
+            REQUIRE(read[i] == entries[i].second);
+        }
+    }
+
+    SECTION("point lookups")
+    {
+        for (auto const& [pos, be] : entries)
+        {
+            BucketEntry out;
+            REQUIRE(reader.readOneAt(pos, out));
+            REQUIRE(out == be);
+            if (be.type() != METAENTRY)
+            {
+                REQUIRE(reader.readPageAt(pos, out, getBucketLedgerKey(be),
+                                          blockSize));
+                REQUIRE(out == be);
+            }
+        }
+        BucketEntry out;
+        REQUIRE(!reader.readOneAt(bucket->getSize(), out));
+
+        auto missing =
+            LedgerTestUtils::generateValidLedgerEntryKeysWithExclusions(
+                {CONFIG_SETTING}, 1);
+        REQUIRE(!reader.readPageAt(entries.back().first, out, missing.front(),
+                                   blockSize));
+    }
+
+    SECTION("bad files are rejected")
+    {
+        REQUIRE_THROWS(BlockCompressedBucketReader(bucket->getFilename()));
+    }
+}
@@ -14,11 +14,16 @@
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
 #include "test/test.h"
 
 #include "lib/bloom_filter.hpp"
 
 #include "util/XDRCereal.h"
+#include "util/XDRStream.h"
+#include <thread>
 
 using namespace stellar;
 using namespace BucketTestUtils;
@@ -90,6 +95,12 @@ class BucketIndexTest
         return mApp->getBucketManager();
     }
 
+    Application&
+    getApp() const
+    {
+        return *mApp;
+    }
+
     virtual void
     buildGeneralTest()
     {
@@ -220,6 +231,19 @@ class BucketIndexTest
         validateResults(mTestEntries, loadResult);
     }
 
+    // Schedules a background warm-up load of every searched key and waits for
+    // it to finish
+    void
+    prefetchAsyncAndWait()
+    {
+        auto& bsm = getBM().getBucketSnapshotManager();
+        REQUIRE(bsm.prefetchAsync(mKeysToSearch));
+        while (bsm.getPendingPrefetchesForTesting() != 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
     // Do many lookups with subsets of sampled entries
     virtual void
     runPerf(size_t n)
@@ -284,6 +308,62 @@ class BucketIndexTest
         }
     }
 
+    // Modifies or deletes every entry that run() searches for in a single
+    // ledger
+    void
+    modifyAllTestEntries()
+    {
+        std::vector<LedgerEntry> toUpdate;
+        std::vector<LedgerKey> toDestroy;
+        for (auto iter = mTestEntries.begin(); iter != mTestEntries.end();)
+        {
+            if (iter->second.data.type() == ACCOUNT)
+            {
+                iter->second.data.account().balance += 1;
+                toUpdate.emplace_back(iter->second);
+                ++iter;
+            }
+            else
+            {
+                toDestroy.emplace_back(iter->first);
+                iter = mTestEntries.erase(iter);
+            }
+        }
+
+        mApp->getLedgerManager().setNextLedgerEntryBatchForBucketTesting(
+            {}, toUpdate, toDestroy);
+        closeLedger(*mApp);
+    }
+
+    void
+    testBloomFilterSkips()
+    {
+        auto searchableBL = getBM()
+                                .getBucketSnapshotManager()
+                                .getSearchableBucketListSnapshot();
+        auto& skipMeter = getBM().getBloomSkipMeter();
+        auto& lookupMeter = getBM().getBloomLookupMeter();
+        auto& missMeter = getBM().getBloomMissMeter();
+        getBM().syncMetrics();
+        auto skipsBefore = skipMeter.count();
+        auto lookupsBefore = lookupMeter.count();
+
+        auto keysNotInBL =
+            LedgerTestUtils::generateValidLedgerEntryKeysWithExclusions(
+                {CONFIG_SETTING}, 100);
+        for (auto const& key : keysNotInBL)
+        {
+            REQUIRE(!searchableBL->getLedgerEntry(key));
+        }
+
+        // Every range indexed bucket should reject almost all of these keys
+        // via the bloom filter without a disk read
+        getBM().syncMetrics();
+        REQUIRE(lookupMeter.count() > lookupsBefore);
+        REQUIRE(skipMeter.count() > skipsBefore);
+        REQUIRE(skipMeter.count() + missMeter.count() <= lookupMeter.count());
+    }
+
     void
     restartWithConfig(Config const& cfg)
     {
@@ -491,6 +571,211 @@ TEST_CASE("key-value lookup", "[bucket][bucketindex]")
     testAllIndexTypes(f);
 }
 
+TEST_CASE("entry cache", "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_CACHED_ENTRIES = 10000;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+
+        // First run populates the cache, second run is served from it
+        test.run();
+        auto cacheHits = [&]() {
+            uint64_t hits = 0;
+            for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+            {
+                auto label = xdr::xdr_traits<LedgerEntryType>::enum_name(
+                    static_cast<LedgerEntryType>(let));
+                hits += test.getApp()
+                            .getMetrics()
+                            .NewMeter({"bucketlistDB", "cache-hit", label},
+                                      "entry")
+                            .count();
+            }
+            return hits;
+        };
+        auto hitsBefore = cacheHits();
+        test.run();
+        REQUIRE(cacheHits() > hitsBefore);
+
+        // Cached values must be invalidated when entries are modified
+        test.modifyAllTestEntries();
+        test.run();
+        test.testInvalidKeys();
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("async prefetch warms entry cache", "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_CACHED_ENTRIES = 10000;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+
+        auto cacheMisses = [&]() {
+            uint64_t misses = 0;
+            for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+            {
+                auto label = xdr::xdr_traits<LedgerEntryType>::enum_name(
+                    static_cast<LedgerEntryType>(let));
+                misses += test.getApp()
+                              .getMetrics()
+                              .NewMeter({"bucketlistDB", "cache-miss", label},
+                                        "entry")
+                              .count();
+            }
+            return misses;
+        };
+
+        // Every lookup after the warm-up is served from the cache
+        test.prefetchAsyncAndWait();
+        auto missesBefore = cacheMisses();
+        test.run();
+        REQUIRE(cacheMisses() == missesBefore);
+
+        // Warmed entries are invalidated like any other cached entry
+        test.modifyAllTestEntries();
+        test.prefetchAsyncAndWait();
+        test.run();
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("async prefetch is a no-op without entry cache",
+          "[bucket][bucketindex]")
+{
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    auto test = BucketIndexTest(cfg);
+    test.buildGeneralTest();
+
+    LedgerKeySet keys;
+    keys.emplace(LedgerEntryKey(LedgerTestUtils::generateValidLedgerEntry()));
+    auto& bsm = test.getBM().getBucketSnapshotManager();
+    REQUIRE(!bsm.prefetchAsync(keys));
+    REQUIRE(bsm.getPendingPrefetchesForTesting() == 0);
+}
+
+TEST_CASE("historical snapshot lookups", "[bucket][bucketindex]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.BUCKETLIST_DB_RETAINED_SNAPSHOTS = 3;
+    auto app = createTestApplication<BucketTestApplication>(clock, cfg);
+    auto& lm = app->getLedgerManager();
+
+    // Writes a new version of entry every ledger, tagged by the ledger
+    auto entry = LedgerTestUtils::generateValidLedgerEntryOfType(ACCOUNT);
+    std::map<uint32_t, int64_t> balanceAtLedger;
+    for (int i = 0; i < 5; ++i)
+    {
+        entry.data.account().balance = i + 1;
+        lm.setNextLedgerEntryBatchForBucketTesting({}, {entry}, {});
+        closeLedger(*app);
+        balanceAtLedger[lm.getLastClosedLedgerNum()] = i + 1;
+    }
+
+    auto searchableBL = app->getBucketManager()
+                            .getBucketSnapshotManager()
+                            .getSearchableBucketListSnapshot();
+    std::set<LedgerKey, LedgerEntryIdCmp> keys{LedgerEntryKey(entry)};
+    auto lcl = lm.getLastClosedLedgerNum();
+    for (auto const& [seq, balance] : balanceAtLedger)
+    {
+        auto entries = searchableBL->loadKeysFromLedger(keys, seq);
+        if (seq + cfg.BUCKETLIST_DB_RETAINED_SNAPSHOTS < lcl)
+        {
+            REQUIRE(!entries);
+            continue;
+        }
+        REQUIRE(entries);
+        REQUIRE(entries->size() == 1);
+        REQUIRE(entries->at(0).data.account().balance == balance);
+    }
+
+    // Historical lookups leave the current snapshot untouched
+    auto current = searchableBL->loadKeys(keys);
+    REQUIRE(current.size() == 1);
+    REQUIRE(current.at(0).data.account().balance == balanceAtLedger[lcl]);
+    REQUIRE(app->getMetrics()
+                .NewCounter({"bucketlistDB", "retained-snapshots", "count"})
+                .count() == cfg.BUCKETLIST_DB_RETAINED_SNAPSHOTS);
+}
+
+TEST_CASE("parallel bulk load", "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_PARALLEL_LOAD_MIN_KEYS = 1;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+        test.run();
+        test.testInvalidKeys();
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("key-value lookup with mmap reads", "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_MMAP_READS = true;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+        test.run();
+        test.testInvalidKeys();
+        test.getBM().syncMetrics();
+        REQUIRE(test.getBM().getReadBytesMeter().count() > 0);
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("key-value lookup with batched reads", "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_BATCH_READS = true;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+        test.run();
+        test.testInvalidKeys();
+#ifndef _WIN32
+        REQUIRE(test.getBM().getBatchReadDepthHistogram().count() > 0);
+        REQUIRE(test.getBM().getBatchReadTimer().count() ==
+                test.getBM().getBatchReadDepthHistogram().count());
+#endif
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("key-value lookup with in-memory levels", "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_IN_MEMORY_LEVELS = 2;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+        test.run();
+        test.testInvalidKeys();
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("bloom filter skips negative lookups", "[bucket][bucketindex]")
+{
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.BUCKETLIST_DB_INDEX_CUTOFF = 0;
+
+    auto test = BucketIndexTest(cfg);
+    test.buildGeneralTest();
+    test.testBloomFilterSkips();
+}
+
 TEST_CASE("do not load outdated values", "[bucket][bucketindex]")
 {
     auto f = [&](Config& cfg) {
@@ -538,6 +823,318 @@ TEST_CASE("ContractData key with same ScVal", "[bucket][bucketindex]")
     testAllIndexTypes(f);
 }
 
+TEST_CASE("range index key prefixes preserve key order",
+          "[bucket][bucketindex]")
+{
+    auto keys =
+        LedgerTestUtils::generateValidLedgerEntryKeysWithExclusions({}, 1000);
+    std::sort(keys.begin(), keys.end());
+    for (size_t i = 1; i < keys.size(); ++i)
+    {
+        REQUIRE(BucketIndex::getKeyPrefix(keys[i - 1]) <=
+                BucketIndex::getKeyPrefix(keys[i]));
+    }
+}
+
+TEST_CASE("type ranges bound the entries of each type",
+          "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        // Small pages so that the range index has several pages of each type
+        if (cfg.BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT != 0)
+        {
+            cfg.BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT = 10;
+        }
+        cfg.BUCKETLIST_DB_INDEX_CUTOFF = 0;
+        VirtualClock clock;
+        auto app = createTestApplication(clock, cfg);
+
+        auto entries =
+            LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+                {ACCOUNT, CONTRACT_DATA, CONTRACT_CODE, TTL}, 1000);
+        auto b = Bucket::fresh(app->getBucketManager(),
+                               getAppLedgerVersion(app), {}, entries, {},
+                               /*countMergeEvents=*/true, clock.getIOContext(),
+                               /*doFsync=*/true);
+        REQUIRE(b->isIndexed());
+        auto const& index = b->getIndexForTesting();
+
+        XDRInputFileStream in;
+        in.open(b->getFilename().string());
+        BucketEntry be;
+        std::map<LedgerEntryType, size_t> counts;
+        auto pos = in.pos();
+        while (in.readOne(be))
+        {
+            if (be.type() != METAENTRY)
+            {
+                auto type = getBucketLedgerKey(be).type();
+                auto range = index.getTypeRange(type);
+                REQUIRE(range);
+                REQUIRE(pos >= range->first);
+                REQUIRE(pos < range->second);
+                ++counts[type];
+            }
+            pos = in.pos();
+        }
+        REQUIRE(counts.size() == 4);
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("contract and asset ranges bound their entries",
+          "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        // Small pages so that every contract and asset spans several pages
+        if (cfg.BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT != 0)
+        {
+            cfg.BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT = 10;
+        }
+        cfg.BUCKETLIST_DB_INDEX_CUTOFF = 0;
+        cfg.BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET = true;
+        VirtualClock clock;
+        auto app = createTestApplication(clock, cfg);
+
+        // Spread the entries over a few contracts and assets
+        auto generated =
+            LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+                {ACCOUNT, TRUSTLINE, CONTRACT_DATA}, 1000);
+        std::vector<SCAddress> contracts;
+        std::vector<TrustLineAsset> assets;
+        for (auto const& le : generated)
+        {
+            if (le.data.type() == CONTRACT_DATA && contracts.size() < 3)
+            {
+                contracts.emplace_back(le.data.contractData().contract);
+            }
+            else if (le.data.type() == TRUSTLINE && assets.size() < 3)
+            {
+                assets.emplace_back(le.data.trustLine().asset);
+            }
+        }
+        REQUIRE(contracts.size() == 3);
+        REQUIRE(assets.size() == 3);
+
+        UnorderedMap<LedgerKey, LedgerEntry> entryMap;
+        for (size_t i = 0; i < generated.size(); ++i)
+        {
+            auto le = generated[i];
+            if (le.data.type() == CONTRACT_DATA)
+            {
+                le.data.contractData().contract = contracts[i % 3];
+            }
+            else if (le.data.type() == TRUSTLINE)
+            {
+                le.data.trustLine().asset = assets[i % 3];
+            }
+            entryMap.emplace(LedgerEntryKey(le), le);
+        }
+        std::vector<LedgerEntry> entries;
+        for (auto const& [_, le] : entryMap)
+        {
+            entries.emplace_back(le);
+        }
+
+        auto b = Bucket::fresh(app->getBucketManager(),
+                               getAppLedgerVersion(app), {}, entries, {},
+                               /*countMergeEvents=*/true, clock.getIOContext(),
+                               /*doFsync=*/true);
+        REQUIRE(b->isIndexed());
+        auto const& index = b->getIndexForTesting();
+
+        XDRInputFileStream in;
+        in.open(b->getFilename().string());
+        BucketEntry be;
+        auto pos = in.pos();
+        while (in.readOne(be))
+        {
+            if (be.type() != METAENTRY)
+            {
+                auto key = getBucketLedgerKey(be);
+                if (key.type() == CONTRACT_DATA)
+                {
+                    auto range = index.getContractDataRange(
+                        key.contractData().contract);
+                    REQUIRE(range);
+                    REQUIRE(pos >= range->first);
+                    REQUIRE(pos < range->second);
+                }
+                else if (key.type() == TRUSTLINE)
+                {
+                    auto ranges =
+                        index.getTrustlineRangesByAsset(key.trustLine().asset);
+                    REQUIRE(ranges);
+                    REQUIRE(std::is_sorted(ranges->begin(), ranges->end()));
+                    REQUIRE(std::any_of(ranges->begin(), ranges->end(),
+                                        [&](auto const& range) {
+                                            return pos >= range.first &&
+                                                   pos < range.second;
+                                        }));
+                }
+            }
+            pos = in.pos();
+        }
+
+        TrustLineAsset missingAsset(ASSET_TYPE_POOL_SHARE);
+        missingAsset.liquidityPoolID().fill(0xFF);
+        auto missingRanges = index.getTrustlineRangesByAsset(missingAsset);
+        REQUIRE(missingRanges);
+        REQUIRE(missingRanges->empty());
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("load entries by contract and asset", "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET = true;
+        VirtualClock clock;
+        auto app = createTestApplication<BucketTestApplication>(clock, cfg);
+        auto& lm = app->getLedgerManager();
+
+        auto contract =
+            LedgerTestUtils::generateValidLedgerEntryOfType(CONTRACT_DATA)
+                .data.contractData()
+                .contract;
+        auto asset = LedgerTestUtils::generateValidLedgerEntryOfType(TRUSTLINE)
+                         .data.trustLine()
+                         .asset;
+
+        // Entries of the contract and asset are created over several ledgers
+        // among other entries, then some are updated or deleted
+        UnorderedMap<LedgerKey, LedgerEntry> contractEntries;
+        UnorderedMap<LedgerKey, LedgerEntry> assetEntries;
+        for (uint32_t ledger = 0; ledger < 16; ++ledger)
+        {
+            auto entries =
+                LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+                    {TRUSTLINE, CONTRACT_DATA}, 20);
+            for (size_t i = 0; i < entries.size(); i += 2)
+            {
+                auto& le = entries[i];
+                if (le.data.type() == CONTRACT_DATA)
+                {
+                    le.data.contractData().contract = contract;
+                    contractEntries.emplace(LedgerEntryKey(le), le);
+                }
+                else
+                {
+                    le.data.trustLine().asset = asset;
+                    assetEntries.emplace(LedgerEntryKey(le), le);
+                }
+            }
+            lm.setNextLedgerEntryBatchForBucketTesting(entries, {}, {});
+            closeLedger(*app);
+        }
+
+        std::vector<LedgerEntry> updated;
+        std::vector<LedgerKey> deleted;
+        for (auto* entries : {&contractEntries, &assetEntries})
+        {
+            auto iter = entries->begin();
+            deleted.emplace_back(iter->first);
+            iter = entries->erase(iter);
+            auto& le = iter->second;
+            if (le.data.type() == CONTRACT_DATA)
+            {
+                le.data.contractData().val.type(SCV_U32);
+                le.data.contractData().val.u32() += 1;
+            }
+            else
+            {
+                le.data.trustLine().balance += 1;
+            }
+            updated.emplace_back(le);
+        }
+        lm.setNextLedgerEntryBatchForBucketTesting({}, updated, deleted);
+        closeLedger(*app);
+
+        auto check = [](UnorderedMap<LedgerKey, LedgerEntry> const& expected,
+                        std::vector<LedgerEntry> const& loaded) {
+            REQUIRE(loaded.size() == expected.size());
+            for (auto const& le : loaded)
+            {
+                auto iter = expected.find(LedgerEntryKey(le));
+                REQUIRE(iter != expected.end());
+                REQUIRE(iter->second == le);
+            }
+        };
+
+        auto snapshot = app->getBucketManager()
+                            .getBucketSnapshotManager()
+                            .getSearchableBucketListSnapshot();
+        bool truncated = false;
+        auto loaded = snapshot->loadContractData(contract, 1000, truncated);
+        REQUIRE(!truncated);
+        check(contractEntries, loaded);
+
+        loaded = snapshot->loadTrustlinesByAsset(asset, 1000, truncated);
+        REQUIRE(!truncated);
+        check(assetEntries, loaded);
+
+        loaded = snapshot->loadContractData(contract, 1, truncated);
+        REQUIRE(truncated);
+        REQUIRE(loaded.size() == 1);
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("sharded index matches sequential index", "[bucket][bucketindex]")
+{
+    auto getConfig = [](int instance) {
+        Config cfg(getTestConfig(instance, Config::TESTDB_ON_DISK_SQLITE));
+        cfg.BUCKETLIST_DB_INDEX_CUTOFF = 0;
+        cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+        cfg.BUCKETLIST_DB_PERSIST_INDEX = false;
+        cfg.BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET = true;
+        return cfg;
+    };
+
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getConfig(0));
+
+    // Sharded index is built by a second app, with 1 MB shards
+    VirtualClock shardedClock;
+    auto shardedCfg = getConfig(1);
+    shardedCfg.BUCKETLIST_DB_INDEX_SHARD_SIZE = 1;
+    auto shardedApp = createTestApplication(shardedClock, shardedCfg);
+
+    // Generate enough entries for the bucket to span several shards
+    UnorderedMap<LedgerKey, LedgerEntry> entryMap;
+    size_t bytes = 0;
+    while (bytes < 3 * 1000000)
+    {
+        for (auto const& le :
+             LedgerTestUtils::generateValidUniqueLedgerEntries(1000))
+        {
+            if (entryMap.emplace(LedgerEntryKey(le), le).second)
+            {
+                bytes += xdr::xdr_size(le);
+            }
+        }
+    }
+
+    std::vector<LedgerEntry> entries;
+    for (auto const& [_, le] : entryMap)
+    {
+        entries.emplace_back(le);
+    }
+
+    auto b = Bucket::fresh(app->getBucketManager(), getAppLedgerVersion(app),
+                           {}, entries, {}, /*countMergeEvents=*/true,
+                           clock.getIOContext(), /*doFsync=*/true);
+    REQUIRE(b->isIndexed());
+    REQUIRE(b->getSize() > 2 * 1000000);
+
+    auto shardedIndex = BucketIndex::createIndex(
+        shardedApp->getBucketManager(), b->getFilename(), b->getHash());
+    REQUIRE((b->getIndexForTesting() == *shardedIndex));
+}
+
 TEST_CASE("serialize bucket indexes", "[bucket][bucketindex][!hide]")
 {
     Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
@@ -14,7 +14,9 @@
 #include "bucket/BucketInputIterator.h"
 #include "bucket/BucketManager.h"
 #include "bucket/BucketManagerImpl.h"
+#include "bucket/SharedBucketStore.h"
 #include "bucket/test/BucketTestUtils.h"
+#include "history/HistoryArchive.h"
 #include "history/HistoryArchiveManager.h"
 #include "history/test/HistoryTestsUtils.h"
 #include "ledger/LedgerTxn.h"
@@ -28,6 +30,7 @@
 #include "util/Math.h"
 #include "util/Timer.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <optional>
 #include <thread>
@@ -291,6 +294,43 @@ TEST_CASE_VERSIONS("bucketmanager ownership", "[bucket][bucketmanager]")
     }
 }
 
+TEST_CASE("bucketmanager shares buckets between instances",
+          "[bucket][bucketmanager]")
+{
+    VirtualClock clock;
+    Config cfg0(getTestConfig(0));
+    Config cfg1(getTestConfig(1));
+    cfg0.SHARED_BUCKET_DIR_PATH = cfg0.BUCKET_DIR_PATH + "-shared";
+    cfg1.SHARED_BUCKET_DIR_PATH = cfg0.SHARED_BUCKET_DIR_PATH;
+    auto app0 = createTestApplication(clock, cfg0);
+    auto app1 = createTestApplication(clock, cfg1);
+    auto& bm0 = app0->getBucketManager();
+    auto& bm1 = app1->getBucketManager();
+
+    auto b0 = Bucket::fresh(
+        bm0, getAppLedgerVersion(app0), {},
+        LedgerTestUtils::generateValidUniqueLedgerEntries(10), {},
+        /*countMergeEvents=*/true, clock.getIOContext(), /*doFsync=*/true);
+    auto hash = b0->getHash();
+    REQUIRE(bm0.getSharedBucketStore()->hasBucket(hash));
+    REQUIRE(!bm1.getBucketByHash(hash));
+
+    auto b1 = bm1.adoptBucketFromSharedStore(hash);
+    REQUIRE(b1);
+    REQUIRE(b1->getHash() == hash);
+    REQUIRE(b1->getFilename() != b0->getFilename());
+    // Both instances and the store link to the same file
+    REQUIRE(std::filesystem::hard_link_count(b1->getFilename()) == 3);
+
+    // Dropped by one instance, the bucket stays around for the other
+    b0.reset();
+    bm0.forgetUnreferencedBuckets();
+    REQUIRE(bm1.getSharedBucketStore()->hasBucket(hash));
+    b1.reset();
+    bm1.forgetUnreferencedBuckets();
+    REQUIRE(!bm1.getSharedBucketStore()->hasBucket(hash));
+}
+
 TEST_CASE("bucketmanager missing buckets fail", "[bucket][bucketmanager]")
 {
     Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
@@ -389,6 +429,56 @@ TEST_CASE_VERSIONS("bucketmanager reattach to finished merge",
     });
 }
 
+TEST_CASE("bucketmanager reattach to merge finished before restart",
+          "[bucket][bucketmanager]")
+{
+    Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+    cfg.ARTIFICIALLY_PESSIMIZE_MERGES_FOR_TESTING = true;
+    cfg.MANUAL_CLOSE = false;
+    // The restarted instance doesn't reference the buckets of the first one
+    cfg.DISABLE_BUCKET_GC = true;
+
+    uint32_t level = 3;
+    std::string serialHas;
+    {
+        VirtualClock clock;
+        Application::pointer app = createTestApplication(clock, cfg);
+        BucketManager& bm = app->getBucketManager();
+        BucketList& bl = bm.getBucketList();
+        auto vers = getAppLedgerVersion(app);
+
+        uint32_t ledger = 0;
+        do
+        {
+            ++ledger;
+            bl.addBatch(*app, ledger, vers, {},
+                        LedgerTestUtils::generateValidUniqueLedgerEntries(10),
+                        {});
+        } while (!BucketList::levelShouldSpill(ledger, level - 1));
+        REQUIRE(bl.getLevel(level).getNext().isMerging());
+
+        // Finish the merge on level and persist it
+        HistoryArchiveState has(ledger, bl,
+                                app->getConfig().NETWORK_PASSPHRASE);
+        serialHas = has.toString();
+        bl.getLevel(level).commit();
+        bm.persistFinishedMerges();
+    }
+
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg, false);
+    BucketManager& bm = app->getBucketManager();
+    bm.loadFinishedMerges();
+
+    // Restarting the merge reattaches to its persisted output
+    HistoryArchiveState has;
+    has.fromString(serialHas);
+    has.currentBuckets[level].next.makeLive(*app, getAppLedgerVersion(app),
+                                            level);
+    has.currentBuckets[level].next.resolve();
+    REQUIRE(bm.readMergeCounters().mFinishedMergeReattachments != 0);
+}
+
 TEST_CASE_VERSIONS("bucketmanager reattach to running merge",
                    "[bucket][bucketmanager]")
 {
@@ -535,6 +625,100 @@ TEST_CASE("bucketmanager do not leak empty-merge futures",
     REQUIRE(bmRefBuckets.size() == bmDirBuckets.size());
 }
 
+TEST_CASE("bucketmanager forgets buckets once their last holder lets go",
+          "[bucket][bucketmanager]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    auto app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+
+    auto live = LedgerTestUtils::generateValidUniqueLedgerEntries(10);
+    auto b = Bucket::fresh(bm, getAppLedgerVersion(app), {}, live, {},
+                           /*countMergeEvents=*/true, clock.getIOContext(),
+                           /*doFsync=*/true);
+    auto filename = b->getFilename();
+    auto hash = b->getHash();
+
+    // Nothing references the bucket but we still hold it, so it's kept and
+    // looked at again on the next pass, with the reference sets unchanged.
+    bm.forgetUnreferencedBuckets();
+    REQUIRE(std::filesystem::exists(filename));
+    REQUIRE(bm.getBucketByHash(hash) == b);
+
+    b.reset();
+    bm.forgetUnreferencedBuckets();
+    REQUIRE(!std::filesystem::exists(filename));
+    REQUIRE(!bm.getBucketByHash(hash));
+}
+
+TEST_CASE("bucketmanager runs merges by deadline within budgets",
+          "[bucket][bucketmanager]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.WORKER_THREADS = 4;
+    cfg.BUCKET_MERGE_IO_BUDGET_MB = 3;
+    SECTION("one at a time")
+    {
+        cfg.BUCKET_MERGE_MAX_CONCURRENCY = 1;
+    }
+    SECTION("within the I/O budget")
+    {
+    }
+    auto app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+    auto& pending =
+        app->getMetrics().NewCounter({"bucket", "merge", "pending"});
+
+    std::mutex mutex;
+    std::vector<int> started;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::vector<std::future<void>> done;
+    auto schedule = [&](int id, uint64_t mb, std::chrono::seconds slack) {
+        auto finished = std::make_shared<std::promise<void>>();
+        done.emplace_back(finished->get_future());
+        bm.scheduleMerge(
+            [&, id, finished]() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    started.emplace_back(id);
+                }
+                released.wait();
+                finished->set_value();
+            },
+            mb * 1024 * 1024, 0, std::chrono::steady_clock::now() + slack);
+    };
+
+    // The first merge takes 2MB of the 3MB budget. The next most urgent one
+    // needs 2MB too, so it waits, and the 1MB ones wait behind it.
+    schedule(0, 2, std::chrono::seconds(100));
+    schedule(1, 2, std::chrono::seconds(50));
+    schedule(2, 1, std::chrono::seconds(10));
+    schedule(3, 1, std::chrono::seconds(20));
+    schedule(4, 2, std::chrono::seconds(5));
+    REQUIRE(pending.count() == 4);
+
+    release.set_value();
+    for (auto& f : done)
+    {
+        f.get();
+    }
+    REQUIRE(pending.count() == 0);
+    REQUIRE(started.front() == 0);
+    if (cfg.BUCKET_MERGE_MAX_CONCURRENCY == 1)
+    {
+        REQUIRE(started == std::vector<int>{0, 4, 2, 3, 1});
+    }
+    else
+    {
+        // Merges that run together may record their start in any order
+        std::sort(started.begin() + 1, started.end());
+        REQUIRE(started == std::vector<int>{0, 1, 2, 3, 4});
+    }
+}
+
 TEST_CASE_VERSIONS(
     "bucketmanager reattach HAS from publish queue to finished merge",
     "[bucket][bucketmanager]")
@@ -21,6 +21,7 @@
 #include "lib/catch.hpp"
 #include "lib/util/stdrandom.h"
 #include "main/Application.h"
+#include "medida/histogram.h"
 #include "test/TestUtils.h"
 #include "test/test.h"
 #include "util/Fs.h"
@@ -322,6 +323,137 @@ generateDifferentAccount(std::vector<LedgerEntry> const& others)
     }
 }
 
+TEST_CASE("merges with large read buffers and pipelined hashing", "[bucket]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0));
+    auto app = createTestApplication(clock, cfg);
+
+    // Buffer that is smaller than the buckets, so reads need to refill it
+    VirtualClock bufferedClock;
+    Config bufferedCfg(getTestConfig(1));
+    bufferedCfg.BUCKET_MERGE_READ_BUFFER_SIZE = 16;
+    auto bufferedApp = createTestApplication(bufferedClock, bufferedCfg);
+
+    auto live = LedgerTestUtils::generateValidUniqueLedgerEntries(1000);
+    auto dead = LedgerTestUtils::generateValidLedgerEntryKeysWithExclusions(
+        {CONFIG_SETTING}, 100);
+    auto newLive = LedgerTestUtils::generateValidUniqueLedgerEntries(1000);
+
+    auto merge = [&](Application::pointer mergeApp, VirtualClock& mergeClock) {
+        auto& bm = mergeApp->getBucketManager();
+        auto vers = getAppLedgerVersion(mergeApp);
+        auto b1 = Bucket::fresh(bm, vers, {}, live, {},
+                                /*countMergeEvents=*/true,
+                                mergeClock.getIOContext(), /*doFsync=*/true);
+        auto b2 = Bucket::fresh(bm, vers, {}, newLive, dead,
+                                /*countMergeEvents=*/true,
+                                mergeClock.getIOContext(), /*doFsync=*/true);
+        REQUIRE(b1->getSize() > 16 * 1024);
+        auto merged = Bucket::merge(
+            bm, vers, b1, b2, /*shadows=*/{}, /*keepDeadEntries=*/true,
+            /*countMergeEvents=*/true, mergeClock.getIOContext(),
+            /*doFsync=*/true);
+        return merged->getHash();
+    };
+
+    REQUIRE(merge(app, clock) == merge(bufferedApp, bufferedClock));
+
+    SECTION("with pipelined hashing")
+    {
+        VirtualClock pipelinedClock;
+        Config pipelinedCfg(getTestConfig(2));
+        pipelinedCfg.BUCKET_MERGE_PIPELINED_HASHING = true;
+        auto pipelinedApp =
+            createTestApplication(pipelinedClock, pipelinedCfg);
+        REQUIRE(merge(app, clock) == merge(pipelinedApp, pipelinedClock));
+        REQUIRE(pipelinedApp->getBucketManager()
+                    .getMergeThroughputHistogram()
+                    .count() == 1);
+    }
+}
+
+TEST_CASE("in-memory merges match file merges", "[bucket]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    auto app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+    auto vers = getAppLedgerVersion(app);
+
+    // Enough entries to sort on several threads
+    auto init = LedgerTestUtils::generateValidUniqueLedgerEntries(10100);
+    std::vector<LedgerEntry> newInit(init.end() - 100, init.end());
+    init.resize(10000);
+    std::vector<LedgerEntry> live(init.begin(), init.begin() + 1000);
+    for (auto& e : live)
+    {
+        ++e.lastModifiedLedgerSeq;
+    }
+    std::vector<LedgerKey> dead;
+    for (auto it = init.begin() + 1000; it != init.begin() + 1500; ++it)
+    {
+        dead.emplace_back(LedgerEntryKey(*it));
+    }
+
+    auto fresh = [&](std::vector<LedgerEntry> const& initEntries,
+                     std::vector<LedgerEntry> const& liveEntries,
+                     std::vector<LedgerKey> const& deadEntries,
+                     bool storeInMemory) {
+        return Bucket::fresh(bm, vers, initEntries, liveEntries, deadEntries,
+                             /*countMergeEvents=*/true, clock.getIOContext(),
+                             /*doFsync=*/true, storeInMemory);
+    };
+    auto oldBucket = fresh(init, {}, {}, true);
+    auto newBucket = fresh(newInit, live, dead, true);
+    REQUIRE(oldBucket->hasInMemoryEntries());
+    REQUIRE(newBucket->hasInMemoryEntries());
+
+    auto merged = Bucket::merge(bm, vers, oldBucket, newBucket, {},
+                                /*keepDeadEntries=*/true,
+                                /*countMergeEvents=*/true,
+                                clock.getIOContext(), /*doFsync=*/true);
+    auto mergedInMemory = Bucket::mergeInMemory(
+        bm, vers, oldBucket, newBucket, /*keepDeadEntries=*/true,
+        /*countMergeEvents=*/true, clock.getIOContext(), /*doFsync=*/true);
+    REQUIRE(mergedInMemory->getHash() == merged->getHash());
+    REQUIRE(mergedInMemory->hasInMemoryEntries());
+
+    std::vector<BucketEntry> fileEntries;
+    for (BucketInputIterator in(merged); in; ++in)
+    {
+        fileEntries.emplace_back(*in);
+    }
+    auto const& memEntries = mergedInMemory->getInMemoryEntries();
+    REQUIRE(memEntries.front().type() == METAENTRY);
+    REQUIRE(std::vector<BucketEntry>(memEntries.begin() + 1,
+                                     memEntries.end()) == fileEntries);
+
+    SECTION("inputs without in-memory entries are loaded")
+    {
+        auto onDisk = fresh(newInit, live, dead, false);
+        REQUIRE(!onDisk->hasInMemoryEntries());
+        auto res = Bucket::mergeInMemory(
+            bm, vers, oldBucket, onDisk, /*keepDeadEntries=*/true,
+            /*countMergeEvents=*/true, clock.getIOContext(),
+            /*doFsync=*/true);
+        REQUIRE(res->getHash() == merged->getHash());
+    }
+
+    SECTION("empty old bucket")
+    {
+        auto res = Bucket::mergeInMemory(
+            bm, vers, std::make_shared<Bucket>(), newBucket,
+            /*keepDeadEntries=*/false, /*countMergeEvents=*/true,
+            clock.getIOContext(), /*doFsync=*/true);
+        auto expected = Bucket::merge(
+            bm, vers, std::make_shared<Bucket>(), newBucket, {},
+            /*keepDeadEntries=*/false, /*countMergeEvents=*/true,
+            clock.getIOContext(), /*doFsync=*/true);
+        REQUIRE(res->getHash() == expected->getHash());
+    }
+}
+
 TEST_CASE("merges proceed old-style despite newer shadows",
           "[bucket][bucketmaxprotocol]")
 {
@@ -17,10 +17,16 @@
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
 #include "main/Application.h"
+#include "main/PersistentState.h"
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+#include <algorithm>
+#include <cereal/archives/json.hpp>
 #include <fmt/format.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <sstream>
 
 namespace stellar
 {
@@ -51,6 +57,26 @@ class TempLedgerVersionSetter : NonMovableOrCopyable
     }
 };
 
+// Bounds on the number of entries committed per batch when the batch size
+// adapts to BUCKET_APPLY_TARGET_BATCH_LATENCY_MS
+static size_t const MIN_APPLY_BATCH_SIZE = 0xff;
+static size_t const MAX_APPLY_BATCH_SIZE = 0xffff;
+
+static uint32_t
+getEntryTypeMask(std::function<bool(LedgerEntryType)> const& filter)
+{
+    uint32_t mask = 0;
+    for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+    {
+        releaseAssert(let >= 0 && let < 32);
+        if (filter(static_cast<LedgerEntryType>(let)))
+        {
+            mask |= 1u << let;
+        }
+    }
+    return mask;
+}
+
 uint32_t
 ApplyBucketsWork::startingLevel()
 {
@@ -90,6 +116,7 @@ ApplyBucketsWork::ApplyBucketsWork(
     , mTotalSize(0)
     , mLevel(startingLevel())
     , mMaxProtocolVersion(maxProtocolVersion)
+    , mBatchSize(LEDGER_ENTRY_BATCH_COMMIT_SIZE)
     , mCounters(app.getClock().now())
 {
 }
@@ -120,6 +147,23 @@ ApplyBucketsWork::getBucket(std::string const& hash)
     return b;
 }
 
+void
+ApplyBucketsWork::endBulkPopulate()
+{
+    if (mBulkPopulating)
+    {
+        mApp.getLedgerTxnRoot().endBulkPopulate();
+        mBulkPopulating = false;
+    }
+}
+
+void
+ApplyBucketsWork::onFailureRaise()
+{
+    endBulkPopulate();
+    Work::onFailureRaise();
+}
+
 void
 ApplyBucketsWork::doReset()
 {
@@ -136,9 +180,32 @@ ApplyBucketsWork::doReset()
     mMinProtocolVersionSeen = UINT32_MAX;
     mSeenKeys.clear();
     mBucketsToIndex.clear();
+    mResumeProgress.reset();
+    endBulkPopulate();
 
     if (!isAborting())
     {
+        mBucketListHash = binToHex(mApplyState.getBucketListHash());
+        mResumeProgress = loadProgress(mApp, mApplyState, mEntryTypeFilter);
+        if (mResumeProgress)
+        {
+            CLOG_INFO(History,
+                      "Resuming interrupted bucket apply at level {} bucket {} "
+                      "offset {}",
+                      mResumeProgress->level, mResumeProgress->bucketHash,
+                      mResumeProgress->offset);
+        }
+        else
+        {
+            clearProgress();
+        }
+
+        // With BucketListDB, only the newest version of each entry is applied,
+        // so unless resuming, no entry is written twice
+        mApp.getLedgerTxnRoot().beginBulkPopulate(
+            mApp.getConfig().isUsingBucketListDB() && !mResumeProgress);
+        mBulkPopulating = true;
+
         if (mApp.getConfig().isUsingBucketListDB())
         {
             // The current size of this set is 1.6 million during BucketApply
@@ -150,7 +217,9 @@ ApplyBucketsWork::doReset()
         // When applying buckets with accounts, we have to make sure that the
         // root account has been removed. This comes into play, for example,
         // when applying buckets from genesis the root account already exists.
-        if (mEntryTypeFilter(ACCOUNT))
+        // A resumed apply already did this before it was interrupted, and may
+        // since have applied the root account from the buckets.
+        if (mEntryTypeFilter(ACCOUNT) && !mResumeProgress)
         {
             TempLedgerVersionSetter tlvs(mApp, mMaxProtocolVersion);
             {
@@ -347,14 +416,20 @@ ApplyBucketsWork::doWork()
             // curr. If BucketListDB is not enabled, we iterate in reverse
             // starting with snap.
             bool isCurr = isUsingBucketListDB;
-            if (*mFirstBucketApplicator)
+            bool skipped = skipToResumePoint(*mFirstBucketApplicator,
+                                             mFirstBucket, false);
+            if (!skipped && *mFirstBucketApplicator)
             {
-                advance(isCurr ? "curr" : "snap", *mFirstBucketApplicator);
+                advance(isCurr ? "curr" : "snap", *mFirstBucketApplicator,
+                        mFirstBucket, false);
                 return State::WORK_RUNNING;
             }
-            mApp.getInvariantManager().checkOnBucketApply(
-                mFirstBucket, mApplyState.currentLedger, mLevel, isCurr,
-                mEntryTypeFilter);
+            if (!skipped)
+            {
+                mApp.getInvariantManager().checkOnBucketApply(
+                    mFirstBucket, mApplyState.currentLedger, mLevel, isCurr,
+                    mEntryTypeFilter);
+            }
             mFirstBucketApplicator.reset();
             mFirstBucket.reset();
             mApp.getCatchupManager().bucketsApplied();
@@ -363,14 +438,20 @@ ApplyBucketsWork::doWork()
         {
             bool isCurr = !isUsingBucketListDB;
             TempLedgerVersionSetter tlvs(mApp, mMaxProtocolVersion);
-            if (*mSecondBucketApplicator)
+            bool skipped = skipToResumePoint(*mSecondBucketApplicator,
+                                             mSecondBucket, true);
+            if (!skipped && *mSecondBucketApplicator)
             {
-                advance(isCurr ? "curr" : "snap", *mSecondBucketApplicator);
+                advance(isCurr ? "curr" : "snap", *mSecondBucketApplicator,
+                        mSecondBucket, true);
                 return State::WORK_RUNNING;
             }
-            mApp.getInvariantManager().checkOnBucketApply(
-                mSecondBucket, mApplyState.currentLedger, mLevel, isCurr,
-                mEntryTypeFilter);
+            if (!skipped)
+            {
+                mApp.getInvariantManager().checkOnBucketApply(
+                    mSecondBucket, mApplyState.currentLedger, mLevel, isCurr,
+                    mEntryTypeFilter);
+            }
             mSecondBucketApplicator.reset();
             mSecondBucket.reset();
             mApp.getCatchupManager().bucketsApplied();
@@ -384,6 +465,17 @@ ApplyBucketsWork::doWork()
             return State::WORK_RUNNING;
         }
 
+        if (mResumeProgress)
+        {
+            // The checkpointed bucket was never reached, so nothing after it
+            // was applied. Drop the checkpoint so the next attempt starts over.
+            clearProgress();
+            throw std::runtime_error(
+                "ApplyBuckets: resume checkpoint does not match bucket list");
+        }
+        clearProgress();
+        endBulkPopulate();
+
         CLOG_INFO(History, "ApplyBuckets : done, assuming state");
 
         // After all buckets applied, spawn assumeState work
@@ -397,13 +489,24 @@ ApplyBucketsWork::doWork()
 
 void
 ApplyBucketsWork::advance(std::string const& bucketName,
-                          BucketApplicator& applicator)
+                          BucketApplicator& applicator,
+                          std::shared_ptr<Bucket const> const& bucket,
+                          bool secondBucket)
 {
     ZoneScoped;
     releaseAssert(applicator);
     releaseAssert(mTotalSize != 0);
-    auto sz = applicator.advance(mCounters);
+    auto start = std::chrono::steady_clock::now();
+    auto sz = applicator.advance(mCounters, mBatchSize);
+    adaptBatchSize(std::chrono::steady_clock::now() - start, sz);
     mAppliedEntries += sz;
+    mApp.getMetrics()
+        .NewMeter({"catchup", "apply-buckets", "entries"}, "entry")
+        .Mark(sz);
+    if (applicator)
+    {
+        saveProgress(applicator, bucket, secondBucket);
+    }
     mCounters.logDebug(bucketName, mLevel, mApp.getClock().now());
 
     auto log = false;
@@ -438,6 +541,171 @@ ApplyBucketsWork::advance(std::string const& bucketName,
     }
 }
 
+bool
+ApplyBucketsWork::skipToResumePoint(BucketApplicator& applicator,
+                                    std::shared_ptr<Bucket const> const& bucket,
+                                    bool secondBucket)
+{
+    ZoneScoped;
+    if (!mResumeProgress)
+    {
+        return false;
+    }
+
+    // Buckets are visited in the same order as by the interrupted apply, so
+    // every bucket reached before the checkpointed one was fully applied. Its
+    // entries are skipped, only rebuilding the seen keys set.
+    auto const& progress = *mResumeProgress;
+    if (mLevel != progress.level || secondBucket != progress.secondBucket)
+    {
+        applicator.skipTo(bucket->getSize());
+        mAppliedSize += bucket->getSize();
+        mAppliedBuckets++;
+        return true;
+    }
+
+    if (binToHex(bucket->getHash()) != progress.bucketHash)
+    {
+        clearProgress();
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("ApplyBuckets: resume checkpoint expected bucket {} at "
+                       "level {}, found {}"),
+            progress.bucketHash, mLevel, binToHex(bucket->getHash())));
+    }
+
+    applicator.skipTo(progress.offset);
+    mAppliedSize += progress.offset;
+    mLastPos = progress.offset;
+    mResumeProgress.reset();
+    CLOG_INFO(History, "ApplyBuckets : resumed level {} at offset {}", mLevel,
+              progress.offset);
+    return false;
+}
+
+void
+ApplyBucketsWork::saveProgress(BucketApplicator const& applicator,
+                               std::shared_ptr<Bucket const> const& bucket,
+                               bool secondBucket)
+{
+    ZoneScoped;
+    // The in-memory ledger does not survive a restart
+    if (mApp.getConfig().MODE_USES_IN_MEMORY_LEDGER)
+    {
+        return;
+    }
+
+    Progress progress;
+    progress.currentLedger = mApplyState.currentLedger;
+    progress.bucketListHash = mBucketListHash;
+    progress.entryTypes = getEntryTypeMask(mEntryTypeFilter);
+    progress.level = mLevel;
+    progress.secondBucket = secondBucket;
+    progress.bucketHash = binToHex(bucket->getHash());
+    progress.offset = applicator.resumeOffset();
+
+    std::ostringstream out;
+    {
+        cereal::JSONOutputArchive ar(out);
+        progress.serialize(ar);
+    }
+    mApp.getPersistentState().setState(PersistentState::kBucketApplyProgress,
+                                       out.str());
+}
+
+void
+ApplyBucketsWork::clearProgress()
+{
+    if (!mApp.getConfig().MODE_USES_IN_MEMORY_LEDGER)
+    {
+        mApp.getPersistentState().setState(
+            PersistentState::kBucketApplyProgress, "");
+    }
+}
+
+std::optional<ApplyBucketsWork::Progress>
+ApplyBucketsWork::loadProgress(
+    Application& app, HistoryArchiveState const& applyState,
+    std::function<bool(LedgerEntryType)> const& filter)
+{
+    ZoneScoped;
+    if (app.getConfig().MODE_USES_IN_MEMORY_LEDGER)
+    {
+        return std::nullopt;
+    }
+
+    auto& ps = app.getPersistentState();
+    auto str = ps.getState(PersistentState::kBucketApplyProgress);
+    if (str.empty())
+    {
+        return std::nullopt;
+    }
+
+    Progress progress;
+    try
+    {
+        std::istringstream in(str);
+        cereal::JSONInputArchive ar(in);
+        progress.serialize(ar);
+    }
+    catch (cereal::Exception const& e)
+    {
+        CLOG_WARNING(History, "Ignoring malformed bucket apply progress: {}",
+                     e.what());
+        return std::nullopt;
+    }
+
+    // Only resume an apply of the exact same state and entry types
+    if (progress.currentLedger != applyState.currentLedger ||
+        progress.bucketListHash != binToHex(applyState.getBucketListHash()) ||
+        progress.entryTypes != getEntryTypeMask(filter))
+    {
+        return std::nullopt;
+    }
+    return progress;
+}
+
+bool
+ApplyBucketsWork::hasResumableProgress(
+    Application& app, HistoryArchiveState const& applyState,
+    std::function<bool(LedgerEntryType)> const& filter)
+{
+    return loadProgress(app, applyState, filter).has_value();
+}
+
+void
+ApplyBucketsWork::adaptBatchSize(std::chrono::nanoseconds elapsed,
+                                 size_t applied)
+{
+    auto targetMs = mApp.getConfig().BUCKET_APPLY_TARGET_BATCH_LATENCY_MS;
+
+    // A batch cut short by the end of its bucket says little about how long a
+    // full batch takes to commit
+    if (targetMs == 0 || applied <= mBatchSize)
+    {
+        return;
+    }
+
+    // Scale towards the target, at most doubling or halving per batch to
+    // damp the effect of outliers
+    auto target = std::chrono::nanoseconds(std::chrono::milliseconds(targetMs));
+    double ratio = static_cast<double>(target.count()) /
+                   std::max<int64_t>(elapsed.count(), 1);
+    ratio = std::clamp(ratio, 0.5, 2.0);
+    auto newSize = std::clamp(static_cast<size_t>(mBatchSize * ratio),
+                              MIN_APPLY_BATCH_SIZE, MAX_APPLY_BATCH_SIZE);
+    if (newSize != mBatchSize)
+    {
+        CLOG_DEBUG(History,
+                   "ApplyBuckets : batch of {} took {}ms, batch size now {}",
+                   applied,
+                   std::chrono::duration_cast<std::chrono::milliseconds>(
+                       elapsed)
+                       .count(),
+                   newSize);
+        mBatchSize = newSize;
+    }
+}
+
 bool
 ApplyBucketsWork::isLevelComplete()
 {
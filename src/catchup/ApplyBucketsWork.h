@@ -7,6 +7,8 @@
 #include "bucket/BucketApplicator.h"
 #include "ledger/LedgerHashUtils.h"
 #include "work/Work.h"
+#include <cereal/cereal.hpp>
+#include <optional>
 
 namespace stellar
 {
@@ -21,6 +23,31 @@ struct LedgerHeaderHistoryEntry;
 
 class ApplyBucketsWork : public Work
 {
+    // Checkpoint persisted in PersistentState after every committed batch, so
+    // that a restarted apply of the same state resumes mid-bucket rather than
+    // starting over. A resumed apply upserts every entry, so re-applying the
+    // entries committed after the last checkpoint is harmless.
+    struct Progress
+    {
+        uint32_t currentLedger{0};
+        std::string bucketListHash;
+        uint32_t entryTypes{0};
+        uint32_t level{0};
+        bool secondBucket{false};
+        std::string bucketHash;
+        int64_t offset{0};
+
+        template <class Archive>
+        void
+        serialize(Archive& ar)
+        {
+            ar(CEREAL_NVP(currentLedger), CEREAL_NVP(bucketListHash),
+               CEREAL_NVP(entryTypes), CEREAL_NVP(level),
+               CEREAL_NVP(secondBucket), CEREAL_NVP(bucketHash),
+               CEREAL_NVP(offset));
+        }
+    };
+
     std::map<std::string, std::shared_ptr<Bucket>> const& mBuckets;
     HistoryArchiveState const& mApplyState;
     std::function<bool(LedgerEntryType)> mEntryTypeFilter;
@@ -45,10 +72,28 @@ class ApplyBucketsWork : public Work
     std::unique_ptr<BucketApplicator> mSecondBucketApplicator;
     std::unordered_set<LedgerKey> mSeenKeys;
     std::vector<std::shared_ptr<Bucket>> mBucketsToIndex;
+    std::string mBucketListHash;
+    std::optional<Progress> mResumeProgress;
+    size_t mBatchSize;
+    bool mBulkPopulating{false};
 
     BucketApplicator::Counters mCounters;
 
-    void advance(std::string const& name, BucketApplicator& applicator);
+    void advance(std::string const& name, BucketApplicator& applicator,
+                 std::shared_ptr<Bucket const> const& bucket,
+                 bool secondBucket);
+    bool skipToResumePoint(BucketApplicator& applicator,
+                           std::shared_ptr<Bucket const> const& bucket,
+                           bool secondBucket);
+    void saveProgress(BucketApplicator const& applicator,
+                      std::shared_ptr<Bucket const> const& bucket,
+                      bool secondBucket);
+    void clearProgress();
+    void endBulkPopulate();
+    void adaptBatchSize(std::chrono::nanoseconds elapsed, size_t applied);
+    static std::optional<Progress>
+    loadProgress(Application& app, HistoryArchiveState const& applyState,
+                 std::function<bool(LedgerEntryType)> const& filter);
     std::shared_ptr<Bucket> getBucket(std::string const& bucketHash);
     BucketLevel& getBucketLevel(uint32_t level);
     void startLevel();
@@ -74,8 +119,25 @@ class ApplyBucketsWork : public Work
 
     std::string getStatus() const override;
 
+    // Returns true if an interrupted apply of applyState, restricted to the
+    // same entry types, left a checkpoint that a new ApplyBucketsWork would
+    // resume from. The entries it already committed must then be kept.
+    static bool
+    hasResumableProgress(Application& app,
+                         HistoryArchiveState const& applyState,
+                         std::function<bool(LedgerEntryType)> const& filter);
+
+#ifdef BUILD_TESTS
+    void
+    setBatchSizeForTesting(size_t batchSize)
+    {
+        mBatchSize = batchSize;
+    }
+#endif
+
   protected:
     void doReset() override;
     BasicWork::State doWork() override;
+    void onFailureRaise() override;
 };
 }
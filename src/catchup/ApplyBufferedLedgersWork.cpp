@@ -9,7 +9,7 @@
 #include "crypto/Hex.h"
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -25,6 +25,59 @@ ApplyBufferedLedgersWork::onReset()
     mConditionalWork.reset();
 }
 
+bool
+ApplyBufferedLedgersWork::mergesReady(Application& app)
+{
+    auto& bl = app.getBucketManager().getBucketList();
+    auto& lm = app.getLedgerManager();
+    bl.resolveAnyReadyFutures();
+    return bl.futuresAllResolved(
+        bl.getMaxMergeLevel(lm.getLastClosedLedgerNum() + 1));
+}
+
+bool
+ApplyBufferedLedgersWork::applyReadyLedgers()
+{
+    ZoneScoped;
+    auto& cm = mApp.getCatchupManager();
+    auto& lm = mApp.getLedgerManager();
+    auto const start = mApp.getClock().now();
+    size_t applied = 0;
+    bool outOfTime = false;
+
+    auto maybeLcd = cm.maybeGetNextBufferedLedgerToApply();
+    if (!maybeLcd || !mergesReady(mApp))
+    {
+        return false;
+    }
+
+    lm.beginLedgerCloseBatch();
+    try
+    {
+        do
+        {
+            lm.closeLedger(*maybeLcd);
+            ++applied;
+            if (mApp.getClock().now() - start >= FAST_APPLY_TIME_PER_CRANK)
+            {
+                outOfTime = true;
+                break;
+            }
+            maybeLcd = cm.maybeGetNextBufferedLedgerToApply();
+        } while (maybeLcd && mergesReady(mApp));
+    }
+    catch (...)
+    {
+        lm.endLedgerCloseBatch();
+        throw;
+    }
+    lm.endLedgerCloseBatch();
+
+    CLOG_INFO(History, "Applied {} buffered ledgers, up to ledger {}", applied,
+              lm.getLastClosedLedgerNum());
+    return outOfTime;
+}
+
 BasicWork::State
 ApplyBufferedLedgersWork::onRun()
 {
@@ -38,6 +91,13 @@ ApplyBufferedLedgersWork::onRun()
         }
     }
 
+    mConditionalWork.reset();
+    if (applyReadyLedgers())
+    {
+        // Out of time for this crank, the next one carries on
+        return State::WORK_RUNNING;
+    }
+
     std::optional<LedgerCloseData> maybeLcd =
         mApp.getCatchupManager().maybeGetNextBufferedLedgerToApply();
 
@@ -58,20 +118,12 @@ ApplyBufferedLedgersWork::onRun()
 
     auto applyLedger = std::make_shared<ApplyLedgerWork>(mApp, lcd);
 
-    auto predicate = [](Application& app) {
-        auto& bl = app.getBucketManager().getBucketList();
-        auto& lm = app.getLedgerManager();
-        bl.resolveAnyReadyFutures();
-        return bl.futuresAllResolved(
-            bl.getMaxMergeLevel(lm.getLastClosedLedgerNum() + 1));
-    };
-
     mConditionalWork = std::make_shared<ConditionalWork>(
         mApp,
         fmt::format(
             FMT_STRING("apply-buffered-ledger-conditional ledger({:d})"),
             lcd.getLedgerSeq()),
-        predicate, applyLedger, std::chrono::milliseconds(500));
+        mergesReady, applyLedger, std::chrono::milliseconds(500));
 
     mConditionalWork->startWork(wakeSelfUpCallback());
 
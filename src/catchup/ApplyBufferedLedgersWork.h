@@ -8,13 +8,29 @@
 #include "work/BasicWork.h"
 #include "work/ConditionalWork.h"
 
+#include <chrono>
+
 namespace stellar
 {
 
+// Applies the ledgers buffered by the CatchupManager once catchup has reached
+// them. As long as the bucket merges the next ledger needs are resolved,
+// ledgers are applied back to back, as one ledger close batch, for up to
+// FAST_APPLY_TIME_PER_CRANK per crank. Otherwise the next ledger waits for the
+// merges in a ConditionalWork.
 class ApplyBufferedLedgersWork : public BasicWork
 {
+    static constexpr std::chrono::milliseconds FAST_APPLY_TIME_PER_CRANK{
+        500};
+
     std::shared_ptr<ConditionalWork> mConditionalWork;
 
+    static bool mergesReady(Application& app);
+
+    // Applies buffered ledgers while their merges are ready, returning true
+    // if it stopped for lack of time
+    bool applyReadyLedgers();
+
   public:
     ApplyBufferedLedgersWork(Application& app);
 
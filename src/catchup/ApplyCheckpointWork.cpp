@@ -6,6 +6,8 @@
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "catchup/ApplyLedgerWork.h"
+#include "catchup/PreloadCheckpointTxsWork.h"
+#include "crypto/SHA.h"
 #include "history/FileTransferInfo.h"
 #include "history/HistoryManager.h"
 #include "historywork/Progress.h"
@@ -16,8 +18,8 @@
 #include "main/ErrorMessages.h"
 #include "util/FileSystemException.h"
 #include "util/GlobalChecks.h"
+#include "util/Tracing.h"
 #include "util/XDRCereal.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 #include <optional>
 
@@ -27,7 +29,9 @@ namespace stellar
 ApplyCheckpointWork::ApplyCheckpointWork(Application& app,
                                          TmpDir const& downloadDir,
                                          LedgerRange const& range,
-                                         OnFailureCallback cb)
+                                         OnFailureCallback cb,
+                                         std::shared_ptr<PreloadedCheckpointTxs>
+                                             preloaded)
     : BasicWork(app,
                 "apply-ledgers-" + fmt::format(FMT_STRING("{}-{}"),
                                                range.mFirst, range.limit()),
@@ -37,6 +41,7 @@ ApplyCheckpointWork::ApplyCheckpointWork(Application& app,
     , mCheckpoint(
           app.getHistoryManager().checkpointContainingLedger(range.mFirst))
     , mOnFailure(cb)
+    , mPreloaded(preloaded)
 {
     // Ledger range check to enforce application of a single checkpoint
     auto const& hm = mApp.getHistoryManager();
@@ -88,11 +93,24 @@ ApplyCheckpointWork::openInputFiles()
     FileTransferInfo hi(mDownloadDir, HISTORY_FILE_TYPE_LEDGER, mCheckpoint);
     FileTransferInfo ti(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
                         mCheckpoint);
-    CLOG_DEBUG(History, "Replaying ledger headers from {}",
-               hi.localPath_nogz());
-    CLOG_DEBUG(History, "Replaying transactions from {}", ti.localPath_nogz());
-    mHdrIn.open(hi.localPath_nogz());
-    mTxIn.open(ti.localPath_nogz());
+    if (mPreloaded)
+    {
+        releaseAssert(mPreloaded->mReady);
+        CLOG_DEBUG(History, "Replaying preloaded ledger headers of {}",
+                   hi.localPath_nogz());
+        CLOG_DEBUG(History, "Replaying preloaded transactions of {}",
+                   ti.localPath_nogz());
+        mPreloaded->mApplyStarted = true;
+    }
+    else
+    {
+        CLOG_DEBUG(History, "Replaying ledger headers from {}",
+                   hi.localPath_nogz());
+        mHdrIn.open(hi.localPath_nogz());
+        CLOG_DEBUG(History, "Replaying transactions from {}",
+                   ti.localPath_nogz());
+        mTxIn.open(ti.localPath_nogz());
+    }
     mTxHistoryEntry = TransactionHistoryEntry();
     mHeaderHistoryEntry = LedgerHeaderHistoryEntry();
     mFilesOpen = true;
@@ -105,6 +123,25 @@ ApplyCheckpointWork::getCurrentTxSet()
     auto& lm = mApp.getLedgerManager();
     auto seq = lm.getLastClosedLedgerNum() + 1;
 
+    if (mPreloaded)
+    {
+        // Drop the tx sets of this and any skipped ledgers as we go, so that
+        // memory use shrinks while the checkpoint is applied
+        auto& txSets = mPreloaded->mTxSets;
+        auto it = txSets.upper_bound(seq);
+        auto found = txSets.find(seq);
+        TxSetXDRFrameConstPtr txSet =
+            found == txSets.end() ? nullptr : found->second;
+        txSets.erase(txSets.begin(), it);
+        if (txSet)
+        {
+            CLOG_DEBUG(History, "Loaded txset for ledger {}", seq);
+            return txSet;
+        }
+        CLOG_DEBUG(History, "Using empty txset for ledger {}", seq);
+        return TxSetXDRFrame::makeEmpty(lm.getLastClosedLedgerHeader());
+    }
+
     // Check mTxHistoryEntry prior to loading next history entry.
     // This order is important because it accounts for ledger "gaps"
     // in the history archives (which are caused by ledgers with empty tx
@@ -140,11 +177,28 @@ ApplyCheckpointWork::getCurrentTxSet()
     return TxSetXDRFrame::makeEmpty(lm.getLastClosedLedgerHeader());
 }
 
+bool
+ApplyCheckpointWork::readNextHeader()
+{
+    if (mPreloaded)
+    {
+        auto& headers = mPreloaded->mHeaders;
+        if (headers.empty())
+        {
+            return false;
+        }
+        mHeaderHistoryEntry = std::move(headers.front());
+        headers.pop_front();
+        return true;
+    }
+    return mHdrIn && mHdrIn.readOne(mHeaderHistoryEntry);
+}
+
 std::shared_ptr<LedgerCloseData>
 ApplyCheckpointWork::getNextLedgerCloseData()
 {
     ZoneScoped;
-    if (!mHdrIn || !mHdrIn.readOne(mHeaderHistoryEntry))
+    if (!readNextHeader())
     {
         throw std::runtime_error("No more ledgers to replay!");
     }
@@ -248,7 +302,39 @@ ApplyCheckpointWork::getNextLedgerCloseData()
 
     return std::make_shared<LedgerCloseData>(
         header.ledgerSeq, txset, header.scpValue,
-        std::make_optional<Hash>(mHeaderHistoryEntry.hash));
+        std::make_optional<Hash>(mHeaderHistoryEntry.hash),
+        getTrustedResults(header));
+}
+
+std::optional<TransactionResultSet>
+ApplyCheckpointWork::getTrustedResults(LedgerHeader const& header)
+{
+    ZoneScoped;
+    if (!mPreloaded || mPreloaded->mResults.empty())
+    {
+        return std::nullopt;
+    }
+
+    auto& results = mPreloaded->mResults;
+    std::optional<TransactionResultSet> res;
+    auto found = results.find(header.ledgerSeq);
+    if (found != results.end())
+    {
+        // The results are only as trusted as the ledger header they hash to
+        if (xdrSha256(found->second) == header.txSetResultHash)
+        {
+            res = std::move(found->second);
+        }
+        else
+        {
+            CLOG_WARNING(History,
+                         "Results of ledger {} do not match its header, "
+                         "verifying all its signatures",
+                         header.ledgerSeq);
+        }
+    }
+    results.erase(results.begin(), results.upper_bound(header.ledgerSeq));
+    return res;
 }
 
 BasicWork::State
@@ -294,6 +380,15 @@ ApplyCheckpointWork::onRun()
     if (done)
     {
         closeFiles();
+        if (mPreloaded)
+        {
+            // Also unblocks preloading the next checkpoint if there was
+            // nothing to apply here
+            mPreloaded->mApplyStarted = true;
+            mPreloaded->mHeaders.clear();
+            mPreloaded->mTxSets.clear();
+            mPreloaded->mResults.clear();
+        }
         return State::WORK_SUCCESS;
     }
 
@@ -19,6 +19,7 @@ namespace stellar
 
 class TmpDir;
 struct LedgerHeaderHistoryEntry;
+struct PreloadedCheckpointTxs;
 
 /**
  * This class is responsible for applying transactions stored in files on
@@ -38,6 +39,9 @@ struct LedgerHeaderHistoryEntry;
  * * downloadDir - directory containing ledger and transaction files
  * * range - LedgerRange to apply, must be checkpoint-aligned,
  * and cover at most one checkpoint.
+ * * preloaded - if set, ledger headers and transaction sets already read from
+ * the checkpoint's files by PreloadCheckpointTxsWork, used instead of reading
+ * the files.
  */
 
 class ApplyCheckpointWork : public BasicWork
@@ -51,21 +55,27 @@ class ApplyCheckpointWork : public BasicWork
     TransactionHistoryEntry mTxHistoryEntry;
     LedgerHeaderHistoryEntry mHeaderHistoryEntry;
     OnFailureCallback mOnFailure;
+    std::shared_ptr<PreloadedCheckpointTxs> mPreloaded;
 
     bool mFilesOpen{false};
 
     std::shared_ptr<ConditionalWork> mConditionalWork;
 
     TxSetXDRFrameConstPtr getCurrentTxSet();
+    bool readNextHeader();
     void openInputFiles();
 
     std::shared_ptr<LedgerCloseData> getNextLedgerCloseData();
+    std::optional<TransactionResultSet>
+    getTrustedResults(LedgerHeader const& header);
 
     void closeFiles();
 
   public:
     ApplyCheckpointWork(Application& app, TmpDir const& downloadDir,
-                        LedgerRange const& range, OnFailureCallback cb);
+                        LedgerRange const& range, OnFailureCallback cb,
+                        std::shared_ptr<PreloadedCheckpointTxs> preloaded =
+                            nullptr);
     ~ApplyCheckpointWork() = default;
     std::string getStatus() const override;
     void onFailureRaise() override;
@@ -5,7 +5,7 @@
 #include "catchup/ApplyLedgerWork.h"
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -8,6 +8,8 @@
 #include "catchup/IndexBucketsWork.h"
 #include "crypto/Hex.h"
 #include "history/HistoryArchive.h"
+#include "ledger/LedgerTxn.h"
+#include "main/Application.h"
 #include "work/WorkSequence.h"
 #include "work/WorkWithCallback.h"
 
@@ -53,6 +55,14 @@ AssumeStateWork::AssumeStateWork(Application& app,
             mBuckets.emplace_back(nextBucket);
         }
     }
+
+    // Outputs of merges that finished before a restart, which the restarted
+    // merges may reattach to
+    if (mRestartMerges)
+    {
+        auto outputs = bm.loadFinishedMerges();
+        mBuckets.insert(mBuckets.end(), outputs.begin(), outputs.end());
+    }
 }
 
 BasicWork::State
@@ -76,6 +86,13 @@ AssumeStateWork::doWork()
             app.getBucketManager().assumeState(has, maxProtocolVersion,
                                                restartMerges);
 
+            // With IN_MEMORY_OFFERS, LedgerTxnRoot holds the offers of the
+            // previous BucketList: drop them so they are reloaded from this one
+            if (app.getConfig().isUsingInMemoryOffers())
+            {
+                app.getLedgerTxnRoot().dropOffers(false);
+            }
+
             // Drop bucket references once assume state complete since buckets
             // now referenced by BucketList
             buckets.clear();
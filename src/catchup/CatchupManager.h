@@ -68,6 +68,10 @@ class CatchupManager
     // Return status of catchup for or empty string, if no catchup in progress
     virtual std::string getStatus() const = 0;
 
+    // Return structured progress of the running catchup (see
+    // CatchupWork::getJsonProgress), or null if no catchup in progress
+    virtual Json::Value getJsonProgress() const = 0;
+
     // Return state of the CatchupWork object
     virtual BasicWork::State getCatchupWorkState() const = 0;
     virtual bool catchupWorkIsDone() const = 0;
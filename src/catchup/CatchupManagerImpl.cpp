@@ -17,7 +17,7 @@
 #include "util/Logging.h"
 #include "util/StatusManager.h"
 #include "work/WorkScheduler.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -87,6 +87,8 @@ CatchupManagerImpl::CatchupManagerImpl(Application& app)
     , mCatchupWork(nullptr)
     , mSyncingLedgersSize(
           app.getMetrics().NewCounter({"ledger", "memory", "queued-ledgers"}))
+    , mLedgersReplayed(app.getMetrics().NewMeter(
+          {"catchup", "replay", "ledgers"}, "ledger"))
     , mLargestLedgerSeqHeard(0)
 {
 }
@@ -276,6 +278,14 @@ CatchupManagerImpl::getStatus() const
     return mCatchupWork ? mCatchupWork->getStatus() : std::string{};
 }
 
+Json::Value
+CatchupManagerImpl::getJsonProgress() const
+{
+    return mCatchupWork && !mCatchupWork->isDone()
+               ? mCatchupWork->getJsonProgress()
+               : Json::Value{};
+}
+
 BasicWork::State
 CatchupManagerImpl::getCatchupWorkState() const
 {
@@ -443,24 +453,42 @@ CatchupManagerImpl::tryApplySyncingLedgers()
         mApp.getLedgerManager().getLastClosedLedgerHeader();
 
     // We can apply multiple ledgers here, which might be slow. This is a rare
-    // occurrence so we should be fine.
+    // occurrence so we should be fine. They're applied as one batch, doing the
+    // per-ledger housekeeping once at the end.
     auto it = mSyncingLedgers.cbegin();
-    while (it != mSyncingLedgers.cend())
+    if (it == mSyncingLedgers.cend() ||
+        it->first != ledgerHeader.header.ledgerSeq + 1)
     {
-        auto const& lcd = it->second;
+        return;
+    }
 
-        // we still have a missing ledger
-        if (ledgerHeader.header.ledgerSeq + 1 != lcd.getLedgerSeq())
+    auto& lm = mApp.getLedgerManager();
+    lm.beginLedgerCloseBatch();
+    try
+    {
+        while (it != mSyncingLedgers.cend())
         {
-            break;
-        }
+            auto const& lcd = it->second;
+
+            // we still have a missing ledger
+            if (ledgerHeader.header.ledgerSeq + 1 != lcd.getLedgerSeq())
+            {
+                break;
+            }
 
-        mApp.getLedgerManager().closeLedger(lcd);
-        CLOG_INFO(History, "Closed buffered ledger: {}",
-                  LedgerManager::ledgerAbbrev(ledgerHeader));
+            lm.closeLedger(lcd);
+            CLOG_INFO(History, "Closed buffered ledger: {}",
+                      LedgerManager::ledgerAbbrev(ledgerHeader));
 
-        ++it;
+            ++it;
+        }
+    }
+    catch (...)
+    {
+        lm.endLedgerCloseBatch();
+        throw;
     }
+    lm.endLedgerCloseBatch();
 
     mSyncingLedgers.erase(mSyncingLedgers.cbegin(), it);
 }
@@ -492,6 +520,7 @@ void
 CatchupManagerImpl::txSetsApplied(uint32_t num)
 {
     mMetrics.mTxSetsApplied += num;
+    mLedgersReplayed.Mark(num);
 }
 
 void
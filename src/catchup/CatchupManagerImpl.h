@@ -43,6 +43,7 @@ class CatchupManagerImpl : public CatchupManager
     // maintain the invariants above.
     std::map<uint32_t, LedgerCloseData> mSyncingLedgers;
     medida::Counter& mSyncingLedgersSize;
+    medida::Meter& mLedgersReplayed;
 
     void addAndTrimSyncingLedgers(LedgerCloseData const& ledgerData);
     void startOnlineCatchup();
@@ -68,6 +69,7 @@ class CatchupManagerImpl : public CatchupManager
                  std::set<std::shared_ptr<Bucket>> bucketsToRetain) override;
 
     std::string getStatus() const override;
+    Json::Value getJsonProgress() const override;
 
     BasicWork::State getCatchupWorkState() const override;
     bool catchupWorkIsDone() const override;
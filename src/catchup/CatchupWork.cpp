@@ -14,6 +14,7 @@
 #include "catchup/VerifyLedgerChainWork.h"
 #include "herder/Herder.h"
 #include "history/FileTransferInfo.h"
+#include "history/HistoryArchiveManager.h"
 #include "history/HistoryManager.h"
 #include "historywork/BatchDownloadWork.h"
 #include "historywork/DownloadBucketsWork.h"
@@ -26,9 +27,12 @@
 #include "main/PersistentState.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "work/WorkWithCallback.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
 
 namespace stellar
 {
@@ -85,6 +89,8 @@ CatchupWork::CatchupWork(Application& app,
           mApp.getTmpDirManager().tmpDir(getName()))}
     , mCatchupConfiguration{catchupConfiguration}
     , mArchive{archive}
+    , mStartTime{app.getClock().now()}
+    , mPhaseStart{mStartTime}
     , mRetainedBuckets{bucketsToRetain}
 {
     if (mArchive)
@@ -147,6 +153,8 @@ CatchupWork::doReset()
     mVerifyLedgers.reset();
     mLastApplied = mApp.getLedgerManager().getLastClosedLedgerHeader();
     mCurrentWork.reset();
+    mDownloadLedgers.reset();
+    mDownloadBuckets.reset();
     mHAS.reset();
     mBucketHAS.reset();
     mRetainedBuckets.clear();
@@ -168,6 +176,7 @@ CatchupWork::downloadVerifyLedgerChain(CatchupRange const& catchupRange,
     auto getLedgers = std::make_shared<BatchDownloadWork>(
         mApp, checkpointRange, HISTORY_FILE_TYPE_LEDGER, *mDownloadDir,
         mArchive);
+    mDownloadLedgers = getLedgers;
     mRangeEndPromise = std::promise<LedgerNumHashPair>();
     mRangeEndFuture = mRangeEndPromise.get_future().share();
     mRangeEndPromise.set_value(rangeEnd);
@@ -230,6 +239,7 @@ CatchupWork::downloadApplyBuckets()
         auto getBuckets = std::make_shared<DownloadBucketsWork>(
             mApp, mBuckets, hashes, *mDownloadDir, mArchive);
         seq.push_back(getBuckets);
+        mDownloadBuckets = getBuckets;
 
         auto verifyHASCallback = [has = *mBucketHAS](Application& app) {
             if (!has.containsValidBuckets(app))
@@ -246,7 +256,15 @@ CatchupWork::downloadApplyBuckets()
     }
 
     std::shared_ptr<ApplyBucketsWork> applyBuckets;
-    if (mApp.getConfig().isUsingBucketListDB())
+    if (mApp.getConfig().isUsingInMemoryOffers())
+    {
+        // Nothing is left in SQL: the buckets are only indexed, and the
+        // offers are loaded from them into memory once they are assumed
+        applyBuckets = std::make_shared<ApplyBucketsWork>(
+            mApp, mBuckets, *mBucketHAS, version,
+            [](LedgerEntryType) { return false; });
+    }
+    else if (mApp.getConfig().isUsingBucketListDB())
     {
         // Only apply unsupported BucketListDB types to SQL DB when BucketList
         // lookup is enabled
@@ -652,6 +670,158 @@ CatchupWork::runCatchupStep()
     return State::WORK_RUNNING;
 }
 
+std::string
+CatchupWork::getPhaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::GET_ARCHIVE_STATE:
+        return "get-archive-state";
+    case Phase::DOWNLOAD_LEDGERS:
+        return "download-ledgers";
+    case Phase::VERIFY_LEDGERS:
+        return "verify-ledgers";
+    case Phase::VERIFY_TX_RESULTS:
+        return "verify-tx-results";
+    case Phase::DOWNLOAD_BUCKETS:
+        return "download-buckets";
+    case Phase::APPLY_BUCKETS:
+        return "apply-buckets";
+    case Phase::REPLAY:
+        return "replay";
+    case Phase::APPLY_BUFFERED_LEDGERS:
+        return "apply-buffered-ledgers";
+    default:
+        throw std::runtime_error("Unknown catchup phase");
+    }
+}
+
+CatchupWork::Phase
+CatchupWork::getCurrentPhase() const
+{
+    // Each step's work is only created once the one before is done, and the
+    // catchup sequence runs its steps in this order
+    if (mApplyBufferedLedgersWork)
+    {
+        return Phase::APPLY_BUFFERED_LEDGERS;
+    }
+    if (mCatchupSeq)
+    {
+        if (mVerifyTxResults && !mVerifyTxResults->isDone())
+        {
+            return Phase::VERIFY_TX_RESULTS;
+        }
+        if (mBucketVerifyApplySeq && !mBucketVerifyApplySeq->isDone())
+        {
+            return mDownloadBuckets && !mDownloadBuckets->isDone()
+                       ? Phase::DOWNLOAD_BUCKETS
+                       : Phase::APPLY_BUCKETS;
+        }
+        if (mTransactionsVerifyApplySeq)
+        {
+            return mTransactionsVerifyApplySeq->isDone()
+                       ? Phase::APPLY_BUFFERED_LEDGERS
+                       : Phase::REPLAY;
+        }
+        return mCatchupSeq->isDone() ? Phase::APPLY_BUFFERED_LEDGERS
+                                     : Phase::APPLY_BUCKETS;
+    }
+    if (mDownloadVerifyLedgersSeq)
+    {
+        return mDownloadLedgers && !mDownloadLedgers->isDone()
+                   ? Phase::DOWNLOAD_LEDGERS
+                   : Phase::VERIFY_LEDGERS;
+    }
+    return Phase::GET_ARCHIVE_STATE;
+}
+
+void
+CatchupWork::switchPhase(Phase next)
+{
+    auto now = mApp.getClock().now();
+    auto elapsed = now - mPhaseStart;
+    auto name = getPhaseName(mPhase);
+    mPhaseTimes[static_cast<size_t>(mPhase)] += elapsed;
+    mApp.getMetrics().NewTimer({"catchup", "phase", name}).Update(elapsed);
+    CLOG_INFO(History, "Catchup phase {} took {:.3f}s", name,
+              std::chrono::duration<double>(elapsed).count());
+
+    mPhase = next;
+    mPhaseStart = now;
+    mPhaseStartLedgersApplied =
+        mApp.getCatchupManager().getCatchupMetrics().mTxSetsApplied;
+    mPhaseStartBucketEntriesApplied =
+        mApp.getMetrics()
+            .NewMeter({"catchup", "apply-buckets", "entries"}, "entry")
+            .count();
+}
+
+Json::Value
+CatchupWork::getJsonProgress() const
+{
+    Json::Value res;
+    auto now = mApp.getClock().now();
+    auto seconds = [](VirtualClock::duration d) {
+        return std::chrono::duration<double>(d).count();
+    };
+
+    res["phase"] = getPhaseName(mPhase);
+    res["elapsed_seconds"] = seconds(now - mStartTime);
+    auto& phases = res["phase_seconds"];
+    for (size_t i = 0; i < mPhaseTimes.size(); ++i)
+    {
+        auto t = mPhaseTimes[i];
+        if (i == static_cast<size_t>(mPhase))
+        {
+            t += now - mPhaseStart;
+        }
+        if (t.count() > 0)
+        {
+            phases[getPhaseName(static_cast<Phase>(i))] = seconds(t);
+        }
+    }
+
+    auto lcl = mApp.getLedgerManager().getLastClosedLedgerNum();
+    res["last_closed_ledger"] = lcl;
+    uint32_t target = 0;
+    if (mHAS)
+    {
+        target =
+            mCatchupConfiguration.resolve(mHAS->currentLedger).toLedger();
+        res["target_ledger"] = target;
+    }
+
+    auto const& metrics = mApp.getCatchupManager().getCatchupMetrics();
+    res["ledgers_verified"] = (Json::UInt64)metrics.mLedgersVerified;
+    res["buckets_applied"] = (Json::UInt64)metrics.mBucketsApplied;
+    res["ledgers_applied"] = (Json::UInt64)metrics.mTxSetsApplied;
+
+    // Rates are over the current phase only, so that they describe what the
+    // catchup is limited by right now
+    auto phaseSeconds = seconds(now - mPhaseStart);
+    if (phaseSeconds > 0 && mPhase == Phase::APPLY_BUCKETS)
+    {
+        auto entries =
+            mApp.getMetrics()
+                .NewMeter({"catchup", "apply-buckets", "entries"}, "entry")
+                .count() -
+            mPhaseStartBucketEntriesApplied;
+        res["bucket_entries_applied_per_second"] = entries / phaseSeconds;
+    }
+    if (phaseSeconds > 0 && mPhase == Phase::REPLAY)
+    {
+        auto rate = (metrics.mTxSetsApplied - mPhaseStartLedgersApplied) /
+                    phaseSeconds;
+        res["ledgers_applied_per_second"] = rate;
+        if (rate > 0 && target > lcl)
+        {
+            res["eta_seconds"] = (target - lcl) / rate;
+        }
+    }
+    res["downloads"] = mApp.getHistoryArchiveManager().getJsonDownloadInfo();
+    return res;
+}
+
 BasicWork::State
 CatchupWork::doWork()
 {
@@ -659,6 +829,12 @@ CatchupWork::doWork()
     auto nextState = runCatchupStep();
     auto& cm = mApp.getCatchupManager();
 
+    auto phase = getCurrentPhase();
+    if (phase != mPhase)
+    {
+        switchPhase(phase);
+    }
+
     if (nextState == BasicWork::State::WORK_SUCCESS)
     {
         releaseAssert(!cm.maybeGetNextBufferedLedgerToApply());
@@ -672,6 +848,7 @@ void
 CatchupWork::onFailureRaise()
 {
     CLOG_WARNING(History, "Catchup failed");
+    switchPhase(mPhase);
     Work::onFailureRaise();
     if (mCatchupConfiguration.localBucketsOnly())
     {
@@ -683,6 +860,7 @@ void
 CatchupWork::onSuccess()
 {
     CLOG_INFO(History, "Catchup finished");
+    switchPhase(mPhase);
     Work::onSuccess();
 }
 }
@@ -8,9 +8,12 @@
 #include "catchup/VerifyLedgerChainWork.h"
 #include "history/HistoryArchive.h"
 #include "historywork/GetHistoryArchiveStateWork.h"
+#include "lib/json/json.h"
 #include "util/Thread.h"
+#include "util/Timer.h"
 #include "work/Work.h"
 #include "work/WorkSequence.h"
+#include <array>
 
 namespace stellar
 {
@@ -64,12 +67,33 @@ class CatchupWork : public Work
     // enough snapshots were published, and unblock itself.
     static uint32_t const PUBLISH_QUEUE_MAX_SIZE;
 
+    // Stages of a catchup, in the order they run. Replay includes downloading
+    // transactions, which is pipelined with applying them.
+    enum class Phase
+    {
+        GET_ARCHIVE_STATE,
+        DOWNLOAD_LEDGERS,
+        VERIFY_LEDGERS,
+        VERIFY_TX_RESULTS,
+        DOWNLOAD_BUCKETS,
+        APPLY_BUCKETS,
+        REPLAY,
+        APPLY_BUFFERED_LEDGERS,
+        NUM_PHASES
+    };
+    static std::string getPhaseName(Phase phase);
+
     CatchupWork(Application& app, CatchupConfiguration catchupConfiguration,
                 std::set<std::shared_ptr<Bucket>> bucketsToRetain,
                 std::shared_ptr<HistoryArchive> archive = nullptr);
     virtual ~CatchupWork();
     std::string getStatus() const override;
 
+    // Structured progress for the `info` endpoint: current phase, time spent
+    // in each phase so far, download and apply rates and, while replaying, an
+    // estimate of the time left.
+    Json::Value getJsonProgress() const;
+
     CatchupConfiguration const&
     getCatchupConfiguration() const
     {
@@ -109,9 +133,25 @@ class CatchupWork : public Work
     WorkSeqPtr mCatchupSeq;
 
     std::shared_ptr<BasicWork> mCurrentWork;
+    std::shared_ptr<BasicWork> mDownloadLedgers;
+    std::shared_ptr<BasicWork> mDownloadBuckets;
 
     std::shared_future<bool> mFatalFailureFuture;
 
+    // Time accounting for getJsonProgress, and the counts the rates of the
+    // current phase are relative to
+    VirtualClock::time_point const mStartTime;
+    Phase mPhase{Phase::GET_ARCHIVE_STATE};
+    VirtualClock::time_point mPhaseStart;
+    std::array<VirtualClock::duration,
+               static_cast<size_t>(Phase::NUM_PHASES)>
+        mPhaseTimes{};
+    uint64_t mPhaseStartLedgersApplied{0};
+    uint64_t mPhaseStartBucketEntriesApplied{0};
+
+    Phase getCurrentPhase() const;
+    void switchPhase(Phase next);
+
     bool alreadyHaveBucketsHistoryArchiveState(uint32_t atCheckpoint) const;
     void assertBucketState();
 
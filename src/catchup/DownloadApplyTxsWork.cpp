@@ -6,15 +6,18 @@
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "catchup/ApplyCheckpointWork.h"
+#include "catchup/PreloadCheckpointTxsWork.h"
 #include "history/FileTransferInfo.h"
 #include "history/HistoryManager.h"
 #include "historywork/GetAndUnzipRemoteFileWork.h"
 #include "ledger/LedgerManager.h"
+#include "main/Application.h"
+#include "main/Config.h"
 #include "work/ConditionalWork.h"
 #include "work/WorkSequence.h"
 #include "work/WorkWithCallback.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -75,10 +78,40 @@ DownloadApplyTxsWork::yieldMoreWork()
         }
     };
 
+    // Transactions are read and decoded in the background once downloaded,
+    // but only one checkpoint ahead of the one being applied, which bounds
+    // the memory they take while later downloads keep going
+    auto txs = std::make_shared<PreloadedCheckpointTxs>();
+    auto preload = std::make_shared<PreloadCheckpointTxsWork>(
+        mApp, mDownloadDir, mCheckpointToQueue, txs);
     auto apply = std::make_shared<ApplyCheckpointWork>(
-        mApp, mDownloadDir, LedgerRange::inclusive(low, high), cb);
+        mApp, mDownloadDir, LedgerRange::inclusive(low, high), cb, txs);
 
     std::vector<std::shared_ptr<BasicWork>> seq{getAndUnzip};
+    std::vector<FileTransferInfo> toDelete{ft};
+    if (mApp.getConfig().CATCHUP_TRUSTED_REPLAY)
+    {
+        // Trusted replay takes the archived results to know which
+        // transactions' signatures it can skip
+        FileTransferInfo rt(mDownloadDir, HISTORY_FILE_TYPE_RESULTS,
+                            mCheckpointToQueue);
+        seq.push_back(
+            std::make_shared<GetAndUnzipRemoteFileWork>(mApp, rt, mArchive));
+        toDelete.push_back(rt);
+    }
+    if (mLastPreloadedTxs)
+    {
+        auto prevTxs = mLastPreloadedTxs;
+        seq.push_back(std::make_shared<ConditionalWork>(
+            mApp, "conditional-" + preload->getName(),
+            [prevTxs](Application&) { return prevTxs->mApplyStarted; },
+            preload));
+    }
+    else
+    {
+        seq.push_back(preload);
+    }
+    mLastPreloadedTxs = txs;
 
     auto maybeWaitForMerges = [](Application& app) {
         if (app.getConfig().CATCHUP_WAIT_MERGES_TX_APPLY_FOR_TESTING)
@@ -140,21 +173,23 @@ DownloadApplyTxsWork::yieldMoreWork()
 
     seq.push_back(std::make_shared<WorkWithCallback>(
         mApp, "delete-transactions-" + std::to_string(mCheckpointToQueue),
-        [ft](Application& app) {
-            try
+        [toDelete](Application& app) {
+            for (auto const& ft : toDelete)
             {
-                std::filesystem::remove(
-                    std::filesystem::path(ft.localPath_nogz()));
-                CLOG_DEBUG(History, "Deleted transactions {}",
-                           ft.localPath_nogz());
-                return true;
-            }
-            catch (std::filesystem::filesystem_error const& e)
-            {
-                CLOG_ERROR(History, "Could not delete transactions {}: {}",
-                           ft.localPath_nogz(), e.what());
-                return false;
+                try
+                {
+                    std::filesystem::remove(
+                        std::filesystem::path(ft.localPath_nogz()));
+                    CLOG_DEBUG(History, "Deleted {}", ft.localPath_nogz());
+                }
+                catch (std::filesystem::filesystem_error const& e)
+                {
+                    CLOG_ERROR(History, "Could not delete {}: {}",
+                               ft.localPath_nogz(), e.what());
+                    return false;
+                }
             }
+            return true;
         }));
 
     auto nextWork = std::make_shared<WorkSequence>(
@@ -171,6 +206,7 @@ DownloadApplyTxsWork::resetIter()
     mCheckpointToQueue =
         mApp.getHistoryManager().checkpointContainingLedger(mRange.mFirst);
     mLastYieldedWork.reset();
+    mLastPreloadedTxs.reset();
     mLastApplied = mApp.getLedgerManager().getLastClosedLedgerHeader();
 }
 
@@ -20,6 +20,7 @@ namespace stellar
 class TmpDir;
 class HistoryArchive;
 struct LedgerHeaderHistoryEntry;
+struct PreloadedCheckpointTxs;
 
 class DownloadApplyTxsWork : public BatchWork
 {
@@ -28,6 +29,7 @@ class DownloadApplyTxsWork : public BatchWork
     LedgerHeaderHistoryEntry& mLastApplied;
     uint32_t mCheckpointToQueue;
     std::shared_ptr<BasicWork> mLastYieldedWork;
+    std::shared_ptr<PreloadedCheckpointTxs> mLastPreloadedTxs;
     bool const mWaitForPublish;
     std::shared_ptr<HistoryArchive> mArchive;
 
@@ -6,11 +6,11 @@
 #include "bucket/BucketIndex.h"
 #include "bucket/BucketManager.h"
 #include "util/HashOfHash.h"
+#include "util/Tracing.h"
 #include "util/UnorderedSet.h"
 #include "util/XDRStream.h"
 #include "util/types.h"
 #include "work/WorkWithCallback.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -95,7 +95,7 @@ IndexBucketsWork::IndexWork::postWork()
                             self->mApp.getBucketManager().maybeSetIndex(
                                 self->mBucket, std::move(self->mIndex));
                         }
-                        self->wakeUp();
+                        self->wakeUpAndRun();
                     }
                 },
                 "IndexWork: finished");
@@ -0,0 +1,181 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "catchup/ParallelCatchupWork.h"
+#include "crypto/Hex.h"
+#include "historywork/WriteVerifiedCheckpointHashesWork.h"
+#include "lib/json/json.h"
+#include "main/Application.h"
+#include "util/Fs.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/Tracing.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <fstream>
+
+namespace stellar
+{
+
+std::vector<CatchupSegment>
+splitCatchupIntoSegments(uint32_t destination, uint32_t count,
+                         uint32_t segmentSize, uint32_t checkpointFrequency)
+{
+    releaseAssert(checkpointFrequency > 0);
+    uint32_t size =
+        std::max(1u, (segmentSize + checkpointFrequency - 1) /
+                         checkpointFrequency) *
+        checkpointFrequency;
+    uint32_t first = destination > count ? destination - count : 0;
+
+    // Cut from the destination down so that every segment but the first
+    // starts and ends on a checkpoint
+    std::vector<CatchupSegment> segments;
+    for (uint32_t last = destination; last > first;)
+    {
+        uint32_t segmentCount = std::min(size, last - first);
+        segments.push_back({last, segmentCount});
+        last -= segmentCount;
+    }
+    std::reverse(segments.begin(), segments.end());
+    return segments;
+}
+
+CatchupSegmentWork::CatchupSegmentWork(Application& app,
+                                       CatchupSegment const& segment,
+                                       ParallelCatchupOptions const& options)
+    : RunCommandWork(app,
+                     fmt::format(FMT_STRING("catchup-segment-{}/{}"),
+                                 segment.mLast, segment.mCount),
+                     BasicWork::RETRY_NEVER)
+    , mSegment(segment)
+    , mOptions(options)
+    , mDir(fmt::format(FMT_STRING("{}/segment-{}"), options.mWorkDir,
+                       segment.mLast))
+{
+}
+
+CommandInfo
+CatchupSegmentWork::getCommand()
+{
+    if (!fs::mkpath(mDir))
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Could not create directory {}"), mDir));
+    }
+    std::remove((mDir + "/info.json").c_str());
+
+    auto cmd = fmt::format(
+        FMT_STRING("{} catchup {}/{} --conf {} --console --in-memory "
+                   "--work-dir {} --output-file {}/info.json"),
+        mOptions.mExe, mSegment.mLast, mSegment.mCount, mOptions.mConfigFile,
+        mDir, mDir);
+    if (!mOptions.mArchive.empty())
+    {
+        cmd += " --archive " + mOptions.mArchive;
+    }
+    if (mOptions.mTrustedCheckpointHashesFile.empty())
+    {
+        cmd += " --force-untrusted-catchup";
+    }
+    else
+    {
+        cmd += " --trusted-checkpoint-hashes " +
+               mOptions.mTrustedCheckpointHashesFile;
+    }
+    CLOG_INFO(History, "Starting catchup of segment {}/{}: {}", mSegment.mLast,
+              mSegment.mCount, cmd);
+    return CommandInfo{cmd, mDir + "/catchup.log"};
+}
+
+bool
+CatchupSegmentWork::checkResult() const
+{
+    auto infoFile = mDir + "/info.json";
+    std::ifstream in(infoFile);
+    Json::Value root;
+    Json::Reader rdr;
+    if (!in || !rdr.parse(in, root))
+    {
+        CLOG_ERROR(History, "Could not read result of segment {}/{} from {}",
+                   mSegment.mLast, mSegment.mCount, infoFile);
+        return false;
+    }
+
+    auto const& ledger = root["info"]["ledger"];
+    if (ledger["num"].asUInt() != mSegment.mLast)
+    {
+        CLOG_ERROR(History, "Segment {}/{} ended at ledger {}", mSegment.mLast,
+                   mSegment.mCount, ledger["num"].asUInt());
+        return false;
+    }
+    if (!mOptions.mTrustedCheckpointHashesFile.empty())
+    {
+        auto expected = WriteVerifiedCheckpointHashesWork::
+            loadHashFromJsonOutput(mSegment.mLast,
+                                   mOptions.mTrustedCheckpointHashesFile);
+        if (ledger["hash"].asString() != binToHex(expected))
+        {
+            CLOG_ERROR(History,
+                       "Segment {}/{} ended with hash {}, trusted hash is {}",
+                       mSegment.mLast, mSegment.mCount,
+                       ledger["hash"].asString(), binToHex(expected));
+            return false;
+        }
+    }
+    CLOG_INFO(History, "Segment {}/{} verified: ledger {} hash {}",
+              mSegment.mLast, mSegment.mCount, mSegment.mLast,
+              ledger["hash"].asString());
+    return true;
+}
+
+BasicWork::State
+CatchupSegmentWork::onRun()
+{
+    ZoneScoped;
+    auto state = RunCommandWork::onRun();
+    if (state == State::WORK_FAILURE)
+    {
+        CLOG_ERROR(History, "Catchup of segment {}/{} failed, see {}/{}",
+                   mSegment.mLast, mSegment.mCount, mDir, "catchup.log");
+    }
+    else if (state == State::WORK_SUCCESS && !checkResult())
+    {
+        return State::WORK_FAILURE;
+    }
+    return state;
+}
+
+ParallelCatchupWork::ParallelCatchupWork(Application& app,
+                                         ParallelCatchupOptions options,
+                                         std::vector<CatchupSegment> segments)
+    : BatchWork(app, "parallel-catchup")
+    , mOptions(std::move(options))
+    , mSegments(std::move(segments))
+{
+}
+
+bool
+ParallelCatchupWork::hasNext() const
+{
+    return mNext < mSegments.size();
+}
+
+std::shared_ptr<BasicWork>
+ParallelCatchupWork::yieldMoreWork()
+{
+    if (!hasNext())
+    {
+        throw std::runtime_error("Work has no more children to iterate over!");
+    }
+    return std::make_shared<CatchupSegmentWork>(mApp, mSegments[mNext++],
+                                                mOptions);
+}
+
+void
+ParallelCatchupWork::resetIter()
+{
+    mNext = 0;
+}
+}
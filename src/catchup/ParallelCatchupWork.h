@@ -0,0 +1,85 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "historywork/RunCommandWork.h"
+#include "work/BatchWork.h"
+#include <vector>
+
+namespace stellar
+{
+
+// One segment of a parallel catchup: the `catchup <mLast>/<mCount>` a child
+// process runs, which applies buckets at checkpoint mLast - mCount (or starts
+// from genesis for the first segment) and replays up to mLast.
+struct CatchupSegment
+{
+    uint32_t mLast;
+    uint32_t mCount;
+};
+
+// Splits a replay of `count` ledgers up to the checkpoint `destination` into
+// consecutive segments of at most `segmentSize` ledgers (rounded up to whole
+// checkpoints), each ending on a checkpoint, in ledger order.
+std::vector<CatchupSegment>
+splitCatchupIntoSegments(uint32_t destination, uint32_t count,
+                         uint32_t segmentSize, uint32_t checkpointFrequency);
+
+struct ParallelCatchupOptions
+{
+    // stellar-core executable and config file the segments run with
+    std::string mExe;
+    std::string mConfigFile;
+    // Each segment gets its own subdirectory for its buckets and output
+    std::string mWorkDir;
+    // Passed through to every segment's catchup
+    std::string mArchive;
+    std::string mTrustedCheckpointHashesFile;
+};
+
+// Runs `catchup` for one segment in a child process, with in-memory state and
+// its own work directory, then checks that it ended on the expected ledger
+// and, given trusted checkpoint hashes, with the expected hash.
+class CatchupSegmentWork : public RunCommandWork
+{
+    CatchupSegment const mSegment;
+    ParallelCatchupOptions const& mOptions;
+    std::string const mDir;
+
+    CommandInfo getCommand() override;
+    bool checkResult() const;
+
+  public:
+    CatchupSegmentWork(Application& app, CatchupSegment const& segment,
+                       ParallelCatchupOptions const& options);
+    ~CatchupSegmentWork() = default;
+
+  protected:
+    State onRun() override;
+};
+
+// Replays a long range of history as independent segments, each starting from
+// the bucket state archived at its first checkpoint, on up to
+// MAX_CONCURRENT_SUBPROCESSES child processes at once. Each segment verifies
+// its replayed ledgers against the archived headers, which commit to the
+// bucket list hash, so consecutive segments agree on the state at the
+// checkpoint between them.
+class ParallelCatchupWork : public BatchWork
+{
+    ParallelCatchupOptions const mOptions;
+    std::vector<CatchupSegment> const mSegments;
+    size_t mNext{0};
+
+  public:
+    ParallelCatchupWork(Application& app, ParallelCatchupOptions options,
+                        std::vector<CatchupSegment> segments);
+    ~ParallelCatchupWork() = default;
+
+  protected:
+    bool hasNext() const override;
+    std::shared_ptr<BasicWork> yieldMoreWork() override;
+    void resetIter() override;
+};
+}
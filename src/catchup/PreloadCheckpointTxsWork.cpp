@@ -0,0 +1,117 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "catchup/PreloadCheckpointTxsWork.h"
+#include "history/FileTransferInfo.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/Tracing.h"
+#include "util/XDRStream.h"
+#include <fmt/format.h>
+
+namespace stellar
+{
+
+PreloadCheckpointTxsWork::PreloadCheckpointTxsWork(
+    Application& app, TmpDir const& downloadDir, uint32_t checkpoint,
+    std::shared_ptr<PreloadedCheckpointTxs> txs)
+    : BackgroundWork(
+          app, fmt::format(FMT_STRING("preload-transactions-{}"), checkpoint),
+          BasicWork::RETRY_NEVER)
+    , mDownloadDir(downloadDir)
+    , mCheckpoint(checkpoint)
+    , mTxs(txs)
+{
+    releaseAssert(mTxs);
+}
+
+BasicWork::State
+PreloadCheckpointTxsWork::runInBackground()
+{
+    ZoneScoped;
+    FileTransferInfo hi(mDownloadDir, HISTORY_FILE_TYPE_LEDGER, mCheckpoint);
+    FileTransferInfo ti(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
+                        mCheckpoint);
+    try
+    {
+        XDRInputFileStream hdrIn;
+        hdrIn.open(hi.localPath_nogz());
+        LedgerHeaderHistoryEntry header;
+        while (hdrIn && hdrIn.readOne(header))
+        {
+            mLoaded.mHeaders.emplace_back(header);
+        }
+
+        XDRInputFileStream in;
+        in.open(ti.localPath_nogz());
+        TransactionHistoryEntry entry;
+        while (in && in.readOne(entry))
+        {
+            // Like ApplyCheckpointWork reading the file directly, use the
+            // first entry for a ledger if there are several
+            if (entry.ext.v() == 0)
+            {
+                mLoaded.mTxSets.emplace(
+                    entry.ledgerSeq, TxSetXDRFrame::makeFromWire(entry.txSet));
+            }
+            else
+            {
+                mLoaded.mTxSets.emplace(entry.ledgerSeq,
+                                        TxSetXDRFrame::makeFromWire(
+                                            entry.ext.generalizedTxSet()));
+            }
+        }
+
+        if (mApp.getConfig().CATCHUP_TRUSTED_REPLAY)
+        {
+            FileTransferInfo ri(mDownloadDir, HISTORY_FILE_TYPE_RESULTS,
+                                mCheckpoint);
+            XDRInputFileStream resIn;
+            resIn.open(ri.localPath_nogz());
+            TransactionHistoryResultEntry res;
+            while (resIn && resIn.readOne(res))
+            {
+                mLoaded.mResults.emplace(res.ledgerSeq,
+                                         std::move(res.txResultSet));
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        CLOG_ERROR(History, "Could not preload checkpoint {}: {}",
+                   ti.localPath_nogz(), e.what());
+        return State::WORK_FAILURE;
+    }
+    return State::WORK_SUCCESS;
+}
+
+BasicWork::State
+PreloadCheckpointTxsWork::onBackgroundStepDone(State result)
+{
+    // mTxs is shared with ApplyCheckpointWork on the main thread, so it is
+    // only filled in here
+    if (result == State::WORK_SUCCESS)
+    {
+        mTxs->mHeaders = std::move(mLoaded.mHeaders);
+        mTxs->mTxSets = std::move(mLoaded.mTxSets);
+        mTxs->mResults = std::move(mLoaded.mResults);
+        mTxs->mReady = true;
+    }
+    return result;
+}
+
+void
+PreloadCheckpointTxsWork::onReset()
+{
+    BackgroundWork::onReset();
+    mLoaded = PreloadedCheckpointTxs();
+    mTxs->mHeaders.clear();
+    mTxs->mTxSets.clear();
+    mTxs->mResults.clear();
+    mTxs->mReady = false;
+    mTxs->mApplyStarted = false;
+}
+}
@@ -0,0 +1,58 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "herder/TxSetFrame.h"
+#include "work/BackgroundWork.h"
+#include "xdr/Stellar-ledger.h"
+#include <deque>
+#include <map>
+
+namespace stellar
+{
+
+class TmpDir;
+
+// Ledger headers and transaction sets of one checkpoint, the latter keyed by
+// ledger sequence, plus its transaction results for trusted replay (see
+// CATCHUP_TRUSTED_REPLAY). They are filled in by PreloadCheckpointTxsWork and
+// handed out, in ledger order, by ApplyCheckpointWork, which drops each one
+// as it is applied. Only touched from the main thread.
+struct PreloadedCheckpointTxs
+{
+    std::deque<LedgerHeaderHistoryEntry> mHeaders;
+    std::map<uint32_t, TxSetXDRFrameConstPtr> mTxSets;
+    std::map<uint32_t, TransactionResultSet> mResults;
+    bool mReady{false};
+    bool mApplyStarted{false};
+};
+
+// Reads the ledger headers and transactions files of a checkpoint from the
+// download directory on a background thread, decoding the headers and decoding
+// and hashing the transaction sets, so that ApplyCheckpointWork does no XDR
+// decoding of its own. The hashes are still checked against the ledger headers
+// as each ledger is applied. With CATCHUP_TRUSTED_REPLAY, also reads the
+// checkpoint's results file, which must have been downloaded beforehand.
+class PreloadCheckpointTxsWork : public BackgroundWork
+{
+    TmpDir const& mDownloadDir;
+    uint32_t const mCheckpoint;
+    std::shared_ptr<PreloadedCheckpointTxs> const mTxs;
+
+    // Filled in on the background thread, then moved to mTxs
+    PreloadedCheckpointTxs mLoaded;
+
+  public:
+    PreloadCheckpointTxsWork(Application& app, TmpDir const& downloadDir,
+                             uint32_t checkpoint,
+                             std::shared_ptr<PreloadedCheckpointTxs> txs);
+    ~PreloadCheckpointTxsWork() = default;
+
+  protected:
+    State runInBackground() override;
+    State onBackgroundStepDone(State result) override;
+    void onReset() override;
+};
+}
@@ -27,15 +27,98 @@ class ApplyLedgersFromMetaWork : public Work
     bool mFileOpen{false};
     std::shared_ptr<ApplyLedgerWork> mApplyLedgerWork;
     uint32_t const mTargetLedger;
+    bool const mApplyChanges;
+
+    // Number of ledgers applied from their changes per crank
+    static constexpr uint32_t APPLY_CHANGES_BATCH_SIZE = 256;
+
+    // Reads the next ledger to apply into `lcm`, skipping the ledgers at or
+    // before the LCL; returns WORK_RUNNING if there is one
+    State
+    readNextLedger(LedgerCloseMeta& lcm)
+    {
+        auto& lm = mApp.getLedgerManager();
+        while (true)
+        {
+            if (mTargetLedger != 0 &&
+                lm.getLastClosedLedgerNum() >= mTargetLedger)
+            {
+                CLOG_INFO(Work, "LCL is at or past the target ledger {}",
+                          mTargetLedger);
+                return BasicWork::State::WORK_SUCCESS;
+            }
+
+            // Invariant: ledger close meta can't have gaps, so here reading
+            // should always yield the next ledger
+            if (!mMetaIn.readOne(lcm))
+            {
+                // Reached the end of the stream, success
+                return BasicWork::State::WORK_SUCCESS;
+            }
+
+            auto const& lh =
+                lcm.v() == 0 ? lcm.v0().ledgerHeader : lcm.v1().ledgerHeader;
+            auto ledgerSeqToApply = lh.header.ledgerSeq;
+            auto lcl = lm.getLastClosedLedgerNum();
+            if (ledgerSeqToApply <= lcl)
+            {
+                // Old ledger, skipping
+                CLOG_INFO(Work, "LCL {} is more recent than ledger {}", lcl,
+                          ledgerSeqToApply);
+                continue;
+            }
+            else if (ledgerSeqToApply > lcl + 1)
+            {
+                CLOG_FATAL(Work,
+                           "Ledger {} is too far (lcl={}), can't apply. Please "
+                           "run catchup {}/0` first.",
+                           ledgerSeqToApply, lcl, ledgerSeqToApply - 1);
+                return BasicWork::State::WORK_FAILURE;
+            }
+            return BasicWork::State::WORK_RUNNING;
+        }
+    }
+
+    // Applies up to APPLY_CHANGES_BATCH_SIZE ledgers from the changes in
+    // their meta, without running their transactions
+    State
+    applyChanges()
+    {
+        auto& lm = mApp.getLedgerManager();
+        lm.beginLedgerCloseBatch();
+        State state = BasicWork::State::WORK_RUNNING;
+        try
+        {
+            for (uint32_t i = 0; i < APPLY_CHANGES_BATCH_SIZE &&
+                                 state == BasicWork::State::WORK_RUNNING;
+                 ++i)
+            {
+                LedgerCloseMeta lcm;
+                state = readNextLedger(lcm);
+                if (state == BasicWork::State::WORK_RUNNING)
+                {
+                    lm.closeLedgerFromMeta(lcm);
+                }
+            }
+        }
+        catch (std::exception const& e)
+        {
+            CLOG_ERROR(Work, "Failed to apply ledger from meta: {}", e.what());
+            state = BasicWork::State::WORK_FAILURE;
+        }
+        lm.endLedgerCloseBatch();
+        return state;
+    }
 
   public:
     ApplyLedgersFromMetaWork(Application& app,
                              std::filesystem::path const& unzippedMetaFile,
-                             uint32_t targetLedger)
+                             uint32_t targetLedger, bool applyChanges)
         : Work(app, fmt::format("apply-ledgers-from-{}", unzippedMetaFile),
                BasicWork::RETRY_NEVER)
         , mFilename(unzippedMetaFile)
         , mTargetLedger(targetLedger)
+        , mApplyChanges(applyChanges)
     {
     }
 
@@ -59,6 +142,11 @@ class ApplyLedgersFromMetaWork : public Work
             mFileOpen = true;
         }
 
+        if (mApplyChanges)
+        {
+            return applyChanges();
+        }
+
         if (mApplyLedgerWork)
         {
             if (mApplyLedgerWork->getState() == BasicWork::State::WORK_SUCCESS)
@@ -71,42 +159,16 @@ class ApplyLedgersFromMetaWork : public Work
             }
         }
 
-        if (mTargetLedger != 0 &&
-            mApp.getLedgerManager().getLastClosedLedgerNum() >= mTargetLedger)
-        {
-            CLOG_INFO(Work, "LCL is at or past the target ledger {}",
-                      mTargetLedger);
-            return BasicWork::State::WORK_SUCCESS;
-        }
-
-        // Invariant: ledger close meta can't have gaps, so here reading should
-        // always yield the next ledger
         LedgerCloseMeta lcm;
-        if (!mMetaIn.readOne(lcm))
+        auto state = readNextLedger(lcm);
+        if (state != BasicWork::State::WORK_RUNNING)
         {
-            // Reached the end of the stream, success
-            return BasicWork::State::WORK_SUCCESS;
+            return state;
         }
 
-        auto lh = lcm.v() == 0 ? lcm.v0().ledgerHeader : lcm.v1().ledgerHeader;
-
+        auto const& lh =
+            lcm.v() == 0 ? lcm.v0().ledgerHeader : lcm.v1().ledgerHeader;
         auto ledgerSeqToApply = lh.header.ledgerSeq;
-        auto lcl = mApp.getLedgerManager().getLastClosedLedgerNum();
-        if (ledgerSeqToApply <= lcl)
-        {
-            // Old ledger, skipping
-            CLOG_INFO(Work, "LCL {} is more recent than ledger {}", lcl,
-                      ledgerSeqToApply);
-            return BasicWork::State::WORK_RUNNING;
-        }
-        else if (ledgerSeqToApply > lcl + 1)
-        {
-            CLOG_FATAL(Work,
-                       "Ledger {} is too far (lcl={}), can't apply. Please run "
-                       "catchup {}/0` first.",
-                       ledgerSeqToApply, lcl, ledgerSeqToApply - 1);
-            return BasicWork::State::WORK_FAILURE;
-        }
 
         TxSetXDRFrameConstPtr txSet;
         if (lcm.v() == 0)
@@ -137,9 +199,11 @@ class ApplyLedgersFromMetaWork : public Work
 
 ReplayDebugMetaWork::ReplayDebugMetaWork(Application& app,
                                          uint32_t targetLedger,
-                                         std::filesystem::path metaDir)
+                                         std::filesystem::path metaDir,
+                                         bool applyChanges)
     : Work(app, "replay-debug-meta", BasicWork::RETRY_NEVER)
     , mTargetLedger(targetLedger)
+    , mApplyChanges(applyChanges)
     , mFiles(metautils::listMetaDebugFiles(metaDir))
     , mMetaDir(metaDir)
 {
@@ -227,8 +291,8 @@ ReplayDebugMetaWork::doWork()
         unzipped.replace_extension();
     }
 
-    seq.emplace_back(std::make_shared<ApplyLedgersFromMetaWork>(mApp, unzipped,
-                                                                mTargetLedger));
+    seq.emplace_back(std::make_shared<ApplyLedgersFromMetaWork>(
+        mApp, unzipped, mTargetLedger, mApplyChanges));
     auto removeUnzipped = [isZipped, unzipped](Application& app) {
         if (isZipped)
         {
@@ -19,6 +19,10 @@ class ReplayDebugMetaWork : public Work
     // Target replay ledger
     uint32_t const mTargetLedger;
 
+    // Whether ledgers are applied from the ledger entry changes in their meta
+    // rather than by running their transactions
+    bool const mApplyChanges;
+
     // Debug meta files sorted in ascending order
     std::vector<std::filesystem::path> const mFiles;
 
@@ -34,7 +38,8 @@ class ReplayDebugMetaWork : public Work
 
   public:
     ReplayDebugMetaWork(Application& app, uint32_t targetLedger,
-                        std::filesystem::path metaDir);
+                        std::filesystem::path metaDir,
+                        bool applyChanges = false);
     virtual ~ReplayDebugMetaWork() = default;
 
   protected:
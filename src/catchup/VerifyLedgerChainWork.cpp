@@ -11,9 +11,9 @@
 #include "util/FileSystemException.h"
 #include "util/GlobalChecks.h"
 #include "util/Thread.h"
+#include "util/Tracing.h"
 #include "util/XDRStream.h"
 #include "util/types.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 #include <fstream>
 
@@ -24,7 +24,7 @@ static HistoryManager::LedgerVerificationStatus
 verifyLedgerHistoryEntry(LedgerHeaderHistoryEntry const& hhe)
 {
     ZoneScoped;
-    Hash calculated = sha256(xdr::xdr_to_opaque(hhe.header));
+    Hash calculated = xdrSha256(hhe.header);
     if (calculated != hhe.hash)
     {
         CLOG_ERROR(
@@ -154,22 +154,37 @@ VerifyLedgerChainWork::onReset()
                                 mRange.last());
     mChainDisagreesWithLocalState.reset();
     mHasTrustedHash = false;
+
+    // Drop the results of scans from a previous run, including ones still
+    // running
+    ++mScanGeneration;
+    mScans.clear();
+    mScansInFlight = 0;
+    mNextCheckpointToScan = mCurrCheckpoint;
+    mAllScansSpawned = mRange.mCount == 0;
 }
 
-HistoryManager::LedgerVerificationStatus
-VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
+VerifyLedgerChainWork::CheckpointScan
+VerifyLedgerChainWork::scanCheckpoint(std::string const& path,
+                                      uint32_t checkpoint, uint32_t rangeLast,
+                                      LedgerNumHashPair const& lastClosed,
+                                      uint32_t maxLedgerVersion)
 {
     ZoneScoped;
-    // When verifying a checkpoint, we rely on the fact that the next checkpoint
-    // has been verified (unless there's 1 checkpoint).
-    // Once the end of the range is reached, ensure that the chain agrees with
-    // trusted hash passed in. If LCL is reached, verify that it agrees with
-    // the chain.
+    // This checks everything that only depends on the checkpoint's own file,
+    // and runs on a background thread: it must not touch the Application.
 
-    FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_LEDGER,
-                        mCurrCheckpoint);
+    CheckpointScan scan;
     XDRInputFileStream hdrIn;
-    hdrIn.open(ft.localPath_nogz());
+    try
+    {
+        hdrIn.open(path);
+    }
+    catch (FileSystemException&)
+    {
+        scan.mFileError = true;
+        return scan;
+    }
 
     bool beginCheckpoint = true;
 
@@ -178,12 +193,12 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
     // stream; `first` will be set to `curr` only on the first iteration, and
     // `prev` will be set to `curr` at the end of the loop to make the previous
     // iteration's `curr` available during the loop.
-    LedgerHeaderHistoryEntry curr;
-    LedgerHeaderHistoryEntry first;
+    LedgerHeaderHistoryEntry& curr = scan.mLast;
+    LedgerHeaderHistoryEntry& first = scan.mFirst;
     LedgerHeaderHistoryEntry prev;
 
     CLOG_DEBUG(History, "Verifying ledger headers from {} for checkpoint {}",
-               ft.localPath_nogz(), mCurrCheckpoint);
+               path, checkpoint);
 
     while (hdrIn)
     {
@@ -196,48 +211,48 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
         }
         catch (xdr::xdr_bad_message_size&)
         {
-            return HistoryManager::VERIFY_STATUS_ERR_BAD_LEDGER_VERSION;
+            scan.mStatus = HistoryManager::VERIFY_STATUS_ERR_BAD_LEDGER_VERSION;
+            return scan;
         }
 
-        if (curr.header.ledgerVersion >
-            mApp.getConfig().LEDGER_PROTOCOL_VERSION)
+        if (curr.header.ledgerVersion > maxLedgerVersion)
         {
             // Note that local state does not agree with the archives; depending
             // on the presence of trusted hash
-            mChainDisagreesWithLocalState =
+            scan.mDisagreesWithLocalState =
                 HistoryManager::VERIFY_STATUS_ERR_BAD_LEDGER_VERSION;
         }
 
         // Verify ledger with local state by comparing to LCL
         // When checking against LCL, see it the local node is in the bad state,
         // or if the archive is in a bad state (in which case, retry)
-        if (curr.header.ledgerSeq == mLastClosed.first)
+        if (curr.header.ledgerSeq == lastClosed.first)
         {
-            if (sha256(xdr::xdr_to_opaque(curr.header)) != *mLastClosed.second)
+            if (xdrSha256(curr.header) != *lastClosed.second)
             {
                 CLOG_ERROR(History,
                            "Bad ledger-header history entry: claimed ledger {} "
                            "does not agree with LCL {}",
                            LedgerManager::ledgerAbbrev(curr),
-                           LedgerManager::ledgerAbbrev(mLastClosed.first,
-                                                       *mLastClosed.second));
-                mChainDisagreesWithLocalState =
+                           LedgerManager::ledgerAbbrev(lastClosed.first,
+                                                       *lastClosed.second));
+                scan.mDisagreesWithLocalState =
                     HistoryManager::VERIFY_STATUS_ERR_BAD_HASH;
             }
         }
         // Verify LCL that is just before the first ledger in range
-        else if (curr.header.ledgerSeq == mLastClosed.first + 1)
+        else if (curr.header.ledgerSeq == lastClosed.first + 1)
         {
-            auto lclResult = verifyLedgerHistoryLink(*mLastClosed.second, curr);
+            auto lclResult = verifyLedgerHistoryLink(*lastClosed.second, curr);
             if (lclResult != HistoryManager::VERIFY_STATUS_OK)
             {
                 CLOG_ERROR(History,
                            "Bad ledger-header history entry: claimed ledger {} "
                            "previous hash does not agree with LCL: {}",
                            LedgerManager::ledgerAbbrev(curr),
-                           LedgerManager::ledgerAbbrev(mLastClosed.first,
-                                                       *mLastClosed.second));
-                mChainDisagreesWithLocalState = lclResult;
+                           LedgerManager::ledgerAbbrev(lastClosed.first,
+                                                       *lastClosed.second));
+                scan.mDisagreesWithLocalState = lclResult;
             }
         }
 
@@ -249,7 +264,8 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
             auto hashResult = verifyLedgerHistoryEntry(curr);
             if (hashResult != HistoryManager::VERIFY_STATUS_OK)
             {
-                return hashResult;
+                scan.mStatus = hashResult;
+                return scan;
             }
 
             // Save first ledger in the checkpoint, in case we use it below in
@@ -267,7 +283,8 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
                     "History chain undershot expected ledger seq {}, got "
                     "{} instead",
                     expectedSeq, curr.header.ledgerSeq);
-                return HistoryManager::VERIFY_STATUS_ERR_UNDERSHOT;
+                scan.mStatus = HistoryManager::VERIFY_STATUS_ERR_UNDERSHOT;
+                return scan;
             }
             else if (curr.header.ledgerSeq > expectedSeq)
             {
@@ -275,36 +292,131 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
                            "History chain overshot expected ledger seq {}, got "
                            "{} instead",
                            expectedSeq, curr.header.ledgerSeq);
-                return HistoryManager::VERIFY_STATUS_ERR_OVERSHOT;
+                scan.mStatus = HistoryManager::VERIFY_STATUS_ERR_OVERSHOT;
+                return scan;
             }
             auto linkResult = verifyLedgerHistoryLink(prev.hash, curr);
             if (linkResult != HistoryManager::VERIFY_STATUS_OK)
             {
-                return linkResult;
+                scan.mStatus = linkResult;
+                return scan;
             }
         }
 
-        mApp.getCatchupManager().ledgersVerified();
+        ++scan.mLedgersVerified;
         prev = curr;
 
         // No need to keep verifying if the range is covered
-        if (curr.header.ledgerSeq == mRange.last())
+        if (curr.header.ledgerSeq == rangeLast)
         {
             break;
         }
     }
 
-    if (curr.header.ledgerSeq != mCurrCheckpoint &&
-        curr.header.ledgerSeq != mRange.last())
+    if (curr.header.ledgerSeq != checkpoint &&
+        curr.header.ledgerSeq != rangeLast)
     {
-        // We can end at mCurrCheckpoint if checkpoint was valid
-        // or at mRange.last() if history chain file was valid and we
+        // We can end at checkpoint if checkpoint was valid
+        // or at rangeLast if history chain file was valid and we
         // reached last ledger in the range. Any other ledger here means
         // that file is corrupted.
         CLOG_ERROR(History, "History chain did not end with {} or {}",
-                   mCurrCheckpoint, mRange.last());
-        return HistoryManager::VERIFY_STATUS_ERR_MISSING_ENTRIES;
+                   checkpoint, rangeLast);
+        scan.mStatus = HistoryManager::VERIFY_STATUS_ERR_MISSING_ENTRIES;
     }
+    return scan;
+}
+
+void
+VerifyLedgerChainWork::spawnScans()
+{
+    auto const& hm = mApp.getHistoryManager();
+    auto minCheckpoint = hm.checkpointContainingLedger(mRange.mFirst);
+    // Keep the worker threads busy, but leave later checkpoints unscanned if
+    // verification fails early
+    auto maxInFlight =
+        static_cast<size_t>(std::max(1, mApp.getConfig().WORKER_THREADS));
+
+    while (!mAllScansSpawned && mScansInFlight < maxInFlight)
+    {
+        uint32_t checkpoint = mNextCheckpointToScan;
+        FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_LEDGER,
+                            checkpoint);
+        auto path = ft.localPath_nogz();
+        auto rangeLast = mRange.last();
+        auto lastClosed = mLastClosed;
+        auto maxLedgerVersion = mApp.getConfig().LEDGER_PROTOCOL_VERSION;
+        auto generation = mScanGeneration;
+        Application& app = mApp;
+        std::weak_ptr<VerifyLedgerChainWork> weak(
+            std::static_pointer_cast<VerifyLedgerChainWork>(
+                shared_from_this()));
+
+        ++mScansInFlight;
+        app.postOnBackgroundThread(
+            [&app, weak, path, checkpoint, rangeLast, lastClosed,
+             maxLedgerVersion, generation]() {
+                CheckpointScan scan;
+                try
+                {
+                    scan = scanCheckpoint(path, checkpoint, rangeLast,
+                                          lastClosed, maxLedgerVersion);
+                }
+                catch (...)
+                {
+                    scan.mException = std::current_exception();
+                }
+
+                // BasicWork's state is only touched from the main thread
+                app.postOnMainThread(
+                    [weak, checkpoint, generation, scan]() {
+                        auto self = weak.lock();
+                        if (self && self->mScanGeneration == generation)
+                        {
+                            --self->mScansInFlight;
+                            self->mScans.emplace(checkpoint, scan);
+                            self->wakeUpAndRun();
+                        }
+                    },
+                    "VerifyLedgerChain: scan done");
+            },
+            "VerifyLedgerChain: scan checkpoint");
+
+        if (checkpoint == minCheckpoint)
+        {
+            mAllScansSpawned = true;
+        }
+        else
+        {
+            mNextCheckpointToScan -= hm.getCheckpointFrequency();
+        }
+    }
+}
+
+HistoryManager::LedgerVerificationStatus
+VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint(
+    CheckpointScan const& scan)
+{
+    ZoneScoped;
+    // When verifying a checkpoint, we rely on the fact that the next checkpoint
+    // has been verified (unless there's 1 checkpoint).
+    // Once the end of the range is reached, ensure that the chain agrees with
+    // trusted hash passed in. If LCL is reached, verify that it agrees with
+    // the chain. The checkpoint's own hash chain was already checked by
+    // scanCheckpoint; what's left are the links to other checkpoints.
+
+    if (scan.mDisagreesWithLocalState)
+    {
+        mChainDisagreesWithLocalState = scan.mDisagreesWithLocalState;
+    }
+    mApp.getCatchupManager().ledgersVerified(scan.mLedgersVerified);
+    if (scan.mStatus != HistoryManager::VERIFY_STATUS_OK)
+    {
+        return scan.mStatus;
+    }
+
+    auto const& curr = scan.mLast;
+    auto const& first = scan.mFirst;
 
     // We just finished scanning a checkpoint. We first grab the _incoming_
     // hash-link our caller (or previous call to this method) saved for us.
@@ -439,14 +551,23 @@ VerifyLedgerChainWork::onRun()
             "Verification undershot first ledger in the range.");
     }
 
-    HistoryManager::LedgerVerificationStatus result;
+    // Checkpoints are scanned on their own in parallel, then linked up here
+    // one at a time from the highest down
+    spawnScans();
+    auto it = mScans.find(mCurrCheckpoint);
+    if (it == mScans.end())
+    {
+        return BasicWork::State::WORK_WAITING;
+    }
+    auto scan = std::move(it->second);
+    mScans.erase(it);
 
-    // Catch FS-related errors to gracefully fail Work instead of crashing
-    try
+    if (scan.mException)
     {
-        result = verifyHistoryOfSingleCheckpoint();
+        std::rethrow_exception(scan.mException);
     }
-    catch (FileSystemException&)
+    // Fail the Work gracefully on FS-related errors instead of crashing
+    if (scan.mFileError)
     {
         CLOG_ERROR(History, "Catchup material failed verification");
         CLOG_ERROR(History, "{}", POSSIBLY_CORRUPTED_LOCAL_FS);
@@ -454,6 +575,8 @@ VerifyLedgerChainWork::onRun()
         return BasicWork::State::WORK_FAILURE;
     }
 
+    auto result = verifyHistoryOfSingleCheckpoint(scan);
+
     // If we verified ledger chain against trusted SCP hash, but observed a
     // failure related to local state (bad LCL, bad local ledger version, etc),
     // then there is no point retrying catchup - core will never be able to
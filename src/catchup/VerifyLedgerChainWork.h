@@ -7,8 +7,10 @@
 #include "history/HistoryManager.h"
 #include "ledger/LedgerRange.h"
 #include "work/Work.h"
+#include <exception>
 #include <future>
 #include <iosfwd>
+#include <map>
 #include <vector>
 
 namespace stellar
@@ -19,7 +21,9 @@ struct LedgerHeaderHistoryEntry;
 
 // This class verifies ledger chain of a given range by checking the hashes.
 // Note that verification is done starting with the latest checkpoint in the
-// range, and working its way backwards to the beginning of the range.
+// range, and working its way backwards to the beginning of the range. The
+// checkpoints' ledger files are read and hash-chained on background threads
+// ahead of that, and only the links between checkpoints are checked in order.
 class VerifyLedgerChainWork : public BasicWork
 {
     TmpDir const& mDownloadDir;
@@ -72,7 +76,39 @@ class VerifyLedgerChainWork : public BasicWork
     std::vector<LedgerNumHashPair> mVerifiedLedgers;
     std::shared_ptr<std::ofstream> mOutputStream;
 
-    HistoryManager::LedgerVerificationStatus verifyHistoryOfSingleCheckpoint();
+    // What scanning a single checkpoint's ledger file, on its own, found.
+    struct CheckpointScan
+    {
+        HistoryManager::LedgerVerificationStatus mStatus{
+            HistoryManager::VERIFY_STATUS_OK};
+        std::optional<HistoryManager::LedgerVerificationStatus>
+            mDisagreesWithLocalState;
+        bool mFileError{false};
+        std::exception_ptr mException;
+        LedgerHeaderHistoryEntry mFirst{};
+        LedgerHeaderHistoryEntry mLast{};
+        uint32_t mLedgersVerified{0};
+    };
+
+    // Finished scans not yet linked up, by checkpoint, and the bookkeeping of
+    // the ones running. Results from before a reset are told apart by
+    // mScanGeneration and dropped.
+    std::map<uint32_t, CheckpointScan> mScans;
+    uint32_t mNextCheckpointToScan{0};
+    bool mAllScansSpawned{false};
+    size_t mScansInFlight{0};
+    uint64_t mScanGeneration{0};
+
+    // Runs on a background thread, so only looks at its arguments.
+    static CheckpointScan scanCheckpoint(std::string const& path,
+                                         uint32_t checkpoint,
+                                         uint32_t rangeLast,
+                                         LedgerNumHashPair const& lastClosed,
+                                         uint32_t maxLedgerVersion);
+    void spawnScans();
+
+    HistoryManager::LedgerVerificationStatus
+    verifyHistoryOfSingleCheckpoint(CheckpointScan const& scan);
 
   public:
     VerifyLedgerChainWork(
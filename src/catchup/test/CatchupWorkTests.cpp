@@ -6,6 +6,7 @@
 #include "catchup/CatchupConfiguration.h"
 #include "catchup/CatchupRange.h"
 #include "catchup/CatchupWork.h"
+#include "catchup/ParallelCatchupWork.h"
 #include "ledger/CheckpointRange.h"
 #include "test/TestUtils.h"
 #include "test/test.h"
@@ -235,4 +236,51 @@ TEST_CASE("CatchupRange starting on checkpoint boundary still replays it",
     REQUIRE(crange2.getBucketApplyLedger() == 63);
     REQUIRE(crange2.getReplayFirst() == 64);
     REQUIRE(crange2.getReplayCount() == 3);
-}
\ No newline at end of file
+}
+TEST_CASE("parallel catchup segments cover the range back to back",
+          "[catchup]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto& historyManager = app->getHistoryManager();
+    auto freq = historyManager.getCheckpointFrequency();
+
+    auto check = [&](uint32_t destination, uint32_t count,
+                     uint32_t segmentSize) {
+        auto segments = splitCatchupIntoSegments(destination, count,
+                                                 segmentSize, freq);
+        REQUIRE(!segments.empty());
+        REQUIRE(segments.back().mLast == destination);
+
+        uint32_t replayed = 0;
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            auto const& segment = segments[i];
+            REQUIRE(historyManager.isLastLedgerInCheckpoint(segment.mLast));
+            REQUIRE(segment.mCount <=
+                    std::max(segmentSize + freq - 1, freq));
+            replayed += segment.mCount;
+            if (i > 0)
+            {
+                // Each segment starts from the buckets at the checkpoint
+                // the previous one ends on, and replays from right after it
+                CatchupConfiguration cc{
+                    segment.mLast, segment.mCount,
+                    CatchupConfiguration::Mode::OFFLINE_BASIC};
+                CatchupRange range{1, cc, historyManager};
+                REQUIRE(range.applyBuckets());
+                REQUIRE(range.getBucketApplyLedger() ==
+                        segments[i - 1].mLast);
+                REQUIRE(range.getReplayFirst() == segments[i - 1].mLast + 1);
+                REQUIRE(range.getReplayCount() == segment.mCount);
+            }
+        }
+        REQUIRE(replayed == std::min(count, destination));
+    };
+
+    check(freq * 10 - 1, freq * 10 - 1, freq * 3);
+    check(freq * 10 - 1, freq * 10 - 1, 1);
+    check(freq * 10 - 1, freq * 4 + 5, freq * 2 - 1);
+    check(freq * 10 - 1, freq * 100, freq * 4);
+    check(freq * 2 - 1, 10, freq * 4);
+}
@@ -6,7 +6,7 @@
 #include "crypto/ByteSlice.h"
 #include "crypto/CryptoError.h"
 #include "util/NonCopyable.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <sodium.h>
 
 namespace stellar
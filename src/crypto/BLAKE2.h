@@ -40,18 +40,18 @@ struct XDRBLAKE2 : XDRHasher<XDRBLAKE2>
     }
 };
 
-// Equivalent to `blake2(xdr_to_opaque(t))` on any XDR object `t` but
+// Equivalent to `blake2(xdr_to_opaque(args...))` on any XDR objects but
 // without allocating a temporary buffer.
 //
 // NB: This is not an overload of `blake2` to avoid ambiguity when called
 // with xdrpp-provided types like opaque_vec, which will convert to a ByteSlice
 // if demanded, but can also be passed to XDRBLAKE2.
-template <typename T>
+template <typename... Args>
 uint256
-xdrBlake2(T const& t)
+xdrBlake2(Args const&... args)
 {
     XDRBLAKE2 xb;
-    xdr::archive(xb, t);
+    xdr::xdr_argpack_archive(xb, args...);
     xb.flush();
     return xb.state.finish();
 }
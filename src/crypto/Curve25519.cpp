@@ -6,7 +6,7 @@
 #include "crypto/CryptoError.h"
 #include "crypto/SHA.h"
 #include "util/HashOfHash.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <functional>
 
 #ifdef MSAN_ENABLED
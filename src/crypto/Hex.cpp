@@ -11,19 +11,18 @@ namespace stellar
 std::string
 binToHex(ByteSlice const& bin)
 {
-    // NB: C++ standard says we can't go modifying the contents of a std::string
-    // just by const_cast'ing away const on .data(), so we use a vector<char> to
-    // write to.
     if (bin.empty())
         return "";
-    std::vector<char> hex(bin.size() * 2 + 1, '\0');
-    if (sodium_bin2hex(hex.data(), hex.size(), bin.data(), bin.size()) !=
+    // Written in place: sodium_bin2hex also writes a NUL terminator, which
+    // std::string has room for and may be overwritten with NUL.
+    std::string hex(bin.size() * 2, '\0');
+    if (sodium_bin2hex(hex.data(), hex.size() + 1, bin.data(), bin.size()) !=
         hex.data())
     {
         throw std::runtime_error(
             "error in stellar::binToHex(std::vector<uint8_t>)");
     }
-    return std::string(hex.begin(), hex.end() - 1);
+    return hex;
 }
 
 std::string
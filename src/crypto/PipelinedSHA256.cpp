@@ -0,0 +1,140 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/PipelinedSHA256.h"
+#include "crypto/SHA.h"
+#include "util/GlobalChecks.h"
+#include "util/Tracing.h"
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+namespace stellar
+{
+
+struct PipelinedSHA256::State
+{
+    SHA256 hasher;
+    std::vector<unsigned char> batch;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    // batch is waiting for its job or the caller to claim it
+    bool pending{false};
+    bool hashing{false};
+    std::exception_ptr error{};
+};
+
+PipelinedSHA256::PipelinedSHA256(size_t batchSize, PostJob postJob)
+    : mPostJob(std::move(postJob))
+    , mBatchSize(batchSize)
+    , mState(std::make_shared<State>())
+{
+    releaseAssert(mBatchSize > 0);
+    releaseAssert(mPostJob);
+    mFilling.reserve(mBatchSize);
+}
+
+PipelinedSHA256::~PipelinedSHA256()
+{
+    // Spare a job that has yet to start the work of an abandoned hash
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    mState->pending = false;
+}
+
+void
+PipelinedSHA256::hashBatch(State& s)
+{
+    ZoneScoped;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (!s.pending)
+        {
+            return;
+        }
+        s.pending = false;
+        s.hashing = true;
+    }
+
+    std::exception_ptr error{};
+    try
+    {
+        s.hasher.add(ByteSlice(s.batch.data(), s.batch.size()));
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (error && !s.error)
+        {
+            s.error = error;
+        }
+        s.hashing = false;
+    }
+    s.cv.notify_all();
+}
+
+void
+PipelinedSHA256::waitForBatch()
+{
+    hashBatch(*mState);
+    std::unique_lock<std::mutex> lock(mState->mutex);
+    mState->cv.wait(lock, [&] { return !mState->hashing; });
+    if (mState->error)
+    {
+        std::rethrow_exception(mState->error);
+    }
+}
+
+void
+PipelinedSHA256::submitBatch()
+{
+    ZoneScoped;
+    waitForBatch();
+    {
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        std::swap(mFilling, mState->batch);
+        mState->pending = true;
+    }
+    mFilling.clear();
+    mPostJob([state = mState]() { hashBatch(*state); });
+}
+
+void
+PipelinedSHA256::add(ByteSlice const& bin)
+{
+    if (mFinished)
+    {
+        throw std::runtime_error("adding bytes to finished PipelinedSHA256");
+    }
+
+    mFilling.insert(mFilling.end(), bin.begin(), bin.end());
+    if (mFilling.size() >= mBatchSize)
+    {
+        submitBatch();
+    }
+}
+
+uint256
+PipelinedSHA256::finish()
+{
+    ZoneScoped;
+    if (mFinished)
+    {
+        throw std::runtime_error("finishing already-finished PipelinedSHA256");
+    }
+    mFinished = true;
+
+    if (!mFilling.empty())
+    {
+        submitBatch();
+    }
+    waitForBatch();
+    return mState->hasher.finish();
+}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/ByteSlice.h"
+#include "util/NonCopyable.h"
+#include "xdr/Stellar-types.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace stellar
+{
+
+// SHA256 in incremental mode, for callers producing a large sequential input
+// (i.e. bucket merges) that overlap hashing with their own work. Input is
+// copied into batches of batchSize bytes, and each full batch is hashed by a
+// job handed to postJob (i.e. one posting to the worker threads) while the
+// next one fills. Only one batch is in flight at a time, so an instance never
+// keeps more than one job busy.
+//
+// If the job of the previous batch has not started by the time the next batch
+// is full, the caller hashes it itself: callers running on the same threads
+// as the jobs never wait on a job queued behind them.
+class PipelinedSHA256 : public NonMovableOrCopyable
+{
+  public:
+    using PostJob = std::function<void(std::function<void()>&&)>;
+
+  private:
+    struct State;
+
+    PostJob const mPostJob;
+    size_t const mBatchSize;
+    std::vector<unsigned char> mFilling;
+    // Shared with the posted jobs, which may run after this is destroyed
+    std::shared_ptr<State> mState;
+    bool mFinished{false};
+
+    // Hashes the batch in flight unless a job already claimed it
+    static void hashBatch(State& s);
+
+    // Waits for the batch in flight to be hashed, hashing it here if its job
+    // has not started yet
+    void waitForBatch();
+
+    // Waits for the previous batch, then hands off mFilling
+    void submitBatch();
+
+  public:
+    PipelinedSHA256(size_t batchSize, PostJob postJob);
+    ~PipelinedSHA256();
+    void add(ByteSlice const& bin);
+    uint256 finish();
+};
+}
@@ -7,7 +7,7 @@
 #include "crypto/CryptoError.h"
 #include "crypto/Curve25519.h"
 #include "util/NonCopyable.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <sodium.h>
 
 namespace stellar
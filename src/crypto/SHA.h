@@ -40,18 +40,18 @@ struct XDRSHA256 : XDRHasher<XDRSHA256>
     }
 };
 
-// Equivalent to `sha256(xdr_to_opaque(t))` on any XDR object `t` but
+// Equivalent to `sha256(xdr_to_opaque(args...))` on any XDR objects but
 // without allocating a temporary buffer.
 //
 // NB: This is not an overload of `sha256` to avoid ambiguity when called
 // with xdrpp-provided types like opaque_vec, which will convert to a ByteSlice
 // if demanded, but can also be passed to XDRSHA256.
-template <typename T>
+template <typename... Args>
 uint256
-xdrSha256(T const& t)
+xdrSha256(Args const&... args)
 {
     XDRSHA256 xs;
-    xdr::archive(xs, t);
+    xdr::xdr_argpack_archive(xs, args...);
     xs.flush();
     return xs.state.finish();
 }
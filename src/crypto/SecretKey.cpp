@@ -16,10 +16,13 @@
 #include "util/HashOfHash.h"
 #include "util/Math.h"
 #include "util/RandomEvictionCache.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <sodium.h>
 #include <type_traits>
 
@@ -40,12 +43,40 @@ namespace stellar
 // to the state of the process; caching its results centrally
 // makes all signature-verification in the program faster and
 // has no effect on correctness.
+//
+// Signatures are checked on the main, overlay and worker threads at once, so
+// the cache is split into shards with a lock each. Cache keys are BLAKE2
+// hashes, so their first byte picks a shard uniformly.
+
+namespace
+{
+struct VerifySigCacheShard
+{
+    std::mutex mMutex;
+    std::unique_ptr<RandomEvictionCache<Hash, bool>> mCache;
+    std::optional<unsigned int> mSeed;
+    uint64_t mHits{0};
+    uint64_t mMisses{0};
+
+    VerifySigCacheShard()
+        : mCache(std::make_unique<RandomEvictionCache<Hash, bool>>(
+              PubKeyUtils::DEFAULT_VERIFY_SIG_CACHE_SIZE /
+                  PubKeyUtils::VERIFY_SIG_CACHE_SHARDS,
+              /* separatePRNG */ true))
+    {
+    }
+};
 
-static std::mutex gVerifySigCacheMutex;
-static RandomEvictionCache<Hash, bool> gVerifySigCache(0xffff,
-                                                       /* separatePRNG */ true);
-static uint64_t gVerifyCacheHit = 0;
-static uint64_t gVerifyCacheMiss = 0;
+std::array<VerifySigCacheShard, PubKeyUtils::VERIFY_SIG_CACHE_SHARDS>
+    gVerifySigCacheShards;
+
+VerifySigCacheShard&
+verifySigCacheShard(Hash const& cacheKey)
+{
+    return gVerifySigCacheShards[cacheKey[0] %
+                                 PubKeyUtils::VERIFY_SIG_CACHE_SHARDS];
+}
+}
 
 static Hash
 verifySigCacheKey(PublicKey const& key, Signature const& signature,
@@ -191,7 +222,8 @@ struct SignVerifyTestcase
 
 void
 SecretKey::benchmarkOpsPerSecond(size_t& sign, size_t& verify,
-                                 size_t iterations, size_t cachedVerifyPasses)
+                                 size_t iterations, size_t cachedVerifyPasses,
+                                 size_t verifyBatchSize)
 {
     namespace ch = std::chrono;
     using clock = ch::high_resolution_clock;
@@ -219,9 +251,28 @@ SecretKey::benchmarkOpsPerSecond(size_t& sign, size_t& verify,
             // first so we are only measuring cache-hits.
             verifyStart = clock::now();
         }
-        for (auto& c : cases)
+        if (verifyBatchSize <= 1)
         {
-            c.verify();
+            for (auto& c : cases)
+            {
+                c.verify();
+            }
+            continue;
+        }
+        for (size_t i = 0; i < cases.size(); i += verifyBatchSize)
+        {
+            std::vector<PubKeyUtils::SignatureToVerify> batch;
+            auto end = std::min(cases.size(), i + verifyBatchSize);
+            for (auto j = i; j < end; ++j)
+            {
+                batch.push_back({cases[j].key.getPublicKey(), cases[j].sig,
+                                 cases[j].msg});
+            }
+            auto res = PubKeyUtils::verifySigs(batch);
+            if (std::find(res.begin(), res.end(), false) != res.end())
+            {
+                throw std::runtime_error("verify failed");
+            }
         }
     }
     auto verifyEnd = clock::now();
@@ -317,25 +368,87 @@ SecretKey::fromStrKeySeed(std::string const& strKeySeed)
 void
 PubKeyUtils::clearVerifySigCache()
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-    gVerifySigCache.clear();
+    for (auto& shard : gVerifySigCacheShards)
+    {
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        shard.mCache->clear();
+    }
 }
 
 void
 PubKeyUtils::maybeSeedVerifySigCache(unsigned int seed)
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-    gVerifySigCache.maybeSeed(seed);
+    for (auto& shard : gVerifySigCacheShards)
+    {
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        shard.mCache->maybeSeed(seed);
+        shard.mSeed = seed;
+    }
+}
+
+void
+PubKeyUtils::setVerifySigCacheSize(size_t size)
+{
+    size_t perShard = std::max<size_t>(
+        1, (size + VERIFY_SIG_CACHE_SHARDS - 1) / VERIFY_SIG_CACHE_SHARDS);
+    for (auto& shard : gVerifySigCacheShards)
+    {
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        if (shard.mCache->maxSize() == perShard)
+        {
+            continue;
+        }
+        // Resizing drops the cached results, as clearVerifySigCache would
+        shard.mCache = std::make_unique<RandomEvictionCache<Hash, bool>>(
+            perShard, /* separatePRNG */ true);
+        if (shard.mSeed)
+        {
+            shard.mCache->maybeSeed(*shard.mSeed);
+        }
+    }
+}
+
+size_t
+PubKeyUtils::getVerifySigCacheBytes()
+{
+    size_t bytes = 0;
+    for (auto& shard : gVerifySigCacheShards)
+    {
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        bytes += shard.mCache->estimatedBytes();
+    }
+    return bytes;
 }
 
 void
 PubKeyUtils::flushVerifySigCacheCounts(uint64_t& hits, uint64_t& misses)
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-    hits = gVerifyCacheHit;
-    misses = gVerifyCacheMiss;
-    gVerifyCacheHit = 0;
-    gVerifyCacheMiss = 0;
+    std::vector<uint64_t> shardHits, shardMisses;
+    flushVerifySigCacheShardCounts(shardHits, shardMisses);
+    hits = 0;
+    misses = 0;
+    for (size_t i = 0; i < VERIFY_SIG_CACHE_SHARDS; ++i)
+    {
+        hits += shardHits[i];
+        misses += shardMisses[i];
+    }
+}
+
+void
+PubKeyUtils::flushVerifySigCacheShardCounts(std::vector<uint64_t>& hits,
+                                            std::vector<uint64_t>& misses)
+{
+    hits.assign(VERIFY_SIG_CACHE_SHARDS, 0);
+    misses.assign(VERIFY_SIG_CACHE_SHARDS, 0);
+    for (size_t i = 0; i < VERIFY_SIG_CACHE_SHARDS; ++i)
+    {
+        auto& shard = gVerifySigCacheShards[i];
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        hits[i] = shard.mHits;
+        misses[i] = shard.mMisses;
+        shard.mHits = 0;
+        shard.mMisses = 0;
+    }
 }
 
 std::string
@@ -432,6 +545,14 @@ KeyFunctions<PublicKey>::setKeyValue(PublicKey& key,
     }
 }
 
+static bool
+verifySigUncached(PublicKey const& key, Signature const& signature,
+                  ByteSlice const& bin)
+{
+    return crypto_sign_verify_detached(signature.data(), bin.data(),
+                                       bin.size(), key.ed25519().data()) == 0;
+}
+
 bool
 PubKeyUtils::verifySig(PublicKey const& key, Signature const& signature,
                        ByteSlice const& bin)
@@ -444,29 +565,104 @@ PubKeyUtils::verifySig(PublicKey const& key, Signature const& signature,
     }
 
     auto cacheKey = verifySigCacheKey(key, signature, bin);
+    auto& shard = verifySigCacheShard(cacheKey);
 
     {
-        std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-        if (gVerifySigCache.exists(cacheKey))
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        if (shard.mCache->exists(cacheKey))
         {
-            ++gVerifyCacheHit;
+            ++shard.mHits;
             std::string hitStr("hit");
             ZoneText(hitStr.c_str(), hitStr.size());
-            return gVerifySigCache.get(cacheKey);
+            return shard.mCache->get(cacheKey);
         }
     }
 
     std::string missStr("miss");
     ZoneText(missStr.c_str(), missStr.size());
-    bool ok =
-        (crypto_sign_verify_detached(signature.data(), bin.data(), bin.size(),
-                                     key.ed25519().data()) == 0);
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-    ++gVerifyCacheMiss;
-    gVerifySigCache.put(cacheKey, ok);
+    bool ok = verifySigUncached(key, signature, bin);
+    std::lock_guard<std::mutex> guard(shard.mMutex);
+    ++shard.mMisses;
+    shard.mCache->put(cacheKey, ok);
     return ok;
 }
 
+std::vector<bool>
+PubKeyUtils::verifySigs(std::vector<SignatureToVerify> const& sigs)
+{
+    ZoneScoped;
+    std::vector<bool> res(sigs.size(), false);
+    // Candidates grouped by shard, so each shard is locked once per pass
+    std::array<std::vector<std::pair<size_t, Hash>>, VERIFY_SIG_CACHE_SHARDS>
+        candidates;
+    for (size_t i = 0; i < sigs.size(); ++i)
+    {
+        auto const& s = sigs[i];
+        releaseAssert(s.mKey.type() == PUBLIC_KEY_TYPE_ED25519);
+        if (s.mSignature.size() == 64)
+        {
+            auto cacheKey = verifySigCacheKey(s.mKey, s.mSignature, s.mBin);
+            candidates[cacheKey[0] % VERIFY_SIG_CACHE_SHARDS].emplace_back(
+                i, cacheKey);
+        }
+    }
+
+    std::array<std::vector<std::pair<size_t, Hash>>, VERIFY_SIG_CACHE_SHARDS>
+        misses;
+    bool anyMiss = false;
+    for (size_t i = 0; i < VERIFY_SIG_CACHE_SHARDS; ++i)
+    {
+        if (candidates[i].empty())
+        {
+            continue;
+        }
+        auto& shard = gVerifySigCacheShards[i];
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        for (auto& c : candidates[i])
+        {
+            if (shard.mCache->exists(c.second))
+            {
+                ++shard.mHits;
+                res[c.first] = shard.mCache->get(c.second);
+            }
+            else
+            {
+                misses[i].emplace_back(std::move(c));
+                anyMiss = true;
+            }
+        }
+    }
+    if (!anyMiss)
+    {
+        return res;
+    }
+
+    for (auto const& shardMisses : misses)
+    {
+        for (auto const& m : shardMisses)
+        {
+            auto const& s = sigs[m.first];
+            res[m.first] = verifySigUncached(s.mKey, s.mSignature, s.mBin);
+        }
+    }
+
+    for (size_t i = 0; i < VERIFY_SIG_CACHE_SHARDS; ++i)
+    {
+        if (misses[i].empty())
+        {
+            continue;
+        }
+        auto& shard = gVerifySigCacheShards[i];
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        for (auto const& m : misses[i])
+        {
+            ++shard.mMisses;
+            shard.mCache->put(m.second, res[m.first]);
+        }
+    }
+    return res;
+}
+
 PublicKey
 PubKeyUtils::random()
 {
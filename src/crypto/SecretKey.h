@@ -4,6 +4,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/ByteSlice.h"
 #include "crypto/KeyUtils.h"
 #include "util/XDROperators.h"
 #include "xdr/Stellar-types.h"
@@ -11,11 +12,11 @@
 #include <array>
 #include <functional>
 #include <ostream>
+#include <vector>
 
 namespace stellar
 {
 
-class ByteSlice;
 struct SecretValue;
 struct SignerKey;
 
@@ -58,10 +59,13 @@ class SecretKey
     // Create a new, random secret key.
     static SecretKey random();
 
-    // Measure the speed of sign-and-verify ops.
+    // Measure the speed of sign-and-verify ops. If verifyBatchSize is more
+    // than 1, signatures are verified that many at a time with
+    // PubKeyUtils::verifySigs.
     static void benchmarkOpsPerSecond(size_t& sign, size_t& verify,
                                       size_t iterations,
-                                      size_t cachedVerifyPasses = 1);
+                                      size_t cachedVerifyPasses = 1,
+                                      size_t verifyBatchSize = 1);
 
 #ifdef BUILD_TESTS
     // Create a new, pseudo-random secret key drawn from the global weak
@@ -139,9 +143,35 @@ namespace PubKeyUtils
 bool verifySig(PublicKey const& key, Signature const& signature,
                ByteSlice const& bin);
 
+// A signature to check with verifySigs. The bytes `bin` refers to must stay
+// alive until verifySigs returns.
+struct SignatureToVerify
+{
+    PublicKey mKey;
+    Signature mSignature;
+    ByteSlice mBin;
+};
+
+// Equivalent to calling verifySig on every element of `sigs`, returning the
+// results in order, but only takes the lock of each verification cache shard
+// twice for the whole batch.
+std::vector<bool> verifySigs(std::vector<SignatureToVerify> const& sigs);
+
+// The verification cache is split into this many shards, each with its own
+// lock, sharing the capacity set with setVerifySigCacheSize equally.
+size_t constexpr VERIFY_SIG_CACHE_SHARDS = 16;
+size_t constexpr DEFAULT_VERIFY_SIG_CACHE_SIZE = 0xffff;
+
 void clearVerifySigCache();
 void maybeSeedVerifySigCache(unsigned int seed);
+// Clears the cache if its size changes
+void setVerifySigCacheSize(size_t size);
 void flushVerifySigCacheCounts(uint64_t& hits, uint64_t& misses);
+// Same as flushVerifySigCacheCounts, with one count per shard
+void flushVerifySigCacheShardCounts(std::vector<uint64_t>& hits,
+                                    std::vector<uint64_t>& misses);
+// Estimated bytes held by the verification cache
+size_t getVerifySigCacheBytes();
 
 PublicKey random();
 #ifdef BUILD_TESTS
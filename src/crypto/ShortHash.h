@@ -32,7 +32,7 @@ struct XDRShortHasher : XDRHasher<XDRShortHasher>
     void hashBytes(unsigned char const*, size_t);
 };
 
-// Equivalent to `computeHash(xdr_to_opaque(t))` on any XDR object `t` but
+// Equivalent to `computeHash(xdr_to_opaque(args...))` on any XDR objects but
 // without allocating a temporary buffer. Runs the same (SipHash2,4) short-hash
 // function, randomized with the same per-process key as `computeHash`. Uses
 // a different implementation, but results are (unit-tested to be) identical.
@@ -44,12 +44,12 @@ struct XDRShortHasher : XDRHasher<XDRShortHasher>
 // (ByteSlice case). This difference isn't a security feature or anything
 // (SipHash integrates length into the hash) but it's a source of potential
 // bugs, so we avoid it by using a different function name.
-template <typename T>
+template <typename... Args>
 uint64_t
-xdrComputeHash(T const& t)
+xdrComputeHash(Args const&... args)
 {
     XDRShortHasher xsh;
-    xdr::archive(xsh, t);
+    xdr::xdr_argpack_archive(xsh, args...);
     xsh.flush();
     return xsh.state.digest();
 }
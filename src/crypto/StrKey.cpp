@@ -5,8 +5,8 @@
 #include "StrKey.h"
 #include "util/Decoder.h"
 #include "util/SecretValue.h"
+#include "util/Tracing.h"
 #include "util/crc16.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -4,9 +4,12 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "util/XDRMarshal.h"
 #include <xdrpp/endian.h>
 #include <xdrpp/marshal.h>
 
+#include <algorithm>
+
 namespace stellar
 {
 
@@ -94,9 +97,34 @@ template <typename Derived> struct XDRHasher
         }
     }
 
+    template <typename T>
+    typename std::enable_if<IsXDRIntegerContainer<T>::value>::type
+    operator()(const T& t)
+    {
+        if (xdr::xdr_traits<T>::variable_nelem)
+        {
+            (*this)(static_cast<uint32_t>(t.size()));
+        }
+        // Byte-swap as many integers as fit in the buffer at a time
+        size_t const width = sizeof(typename T::value_type);
+        size_t done = 0;
+        while (done < t.size())
+        {
+            if (available() < width)
+            {
+                flush();
+            }
+            size_t n = std::min(t.size() - done, available() / width);
+            xdrPutIntegers(t.data() + done, n, mBuf + mLen);
+            mLen += n * width;
+            done += n;
+        }
+    }
+
     template <typename T>
     typename std::enable_if<xdr::xdr_traits<T>::is_class ||
-                            xdr::xdr_traits<T>::is_container>::type
+                            (xdr::xdr_traits<T>::is_container &&
+                             !IsXDRIntegerContainer<T>::value)>::type
     operator()(const T& t)
     {
         xdr::xdr_traits<T>::save(*this, t);
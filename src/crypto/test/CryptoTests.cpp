@@ -5,6 +5,7 @@
 #include "crypto/BLAKE2.h"
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
+#include "crypto/PipelinedSHA256.h"
 #include "crypto/Random.h"
 #include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
@@ -16,11 +17,14 @@
 #include "test/test.h"
 #include "util/Logging.h"
 #include "xdr/Stellar-types.h"
+#include <atomic>
 #include <autocheck/autocheck.hpp>
+#include <chrono>
 #include <map>
 #include <regex>
 #include <sodium.h>
 #include <stdexcept>
+#include <thread>
 
 using namespace stellar;
 
@@ -109,6 +113,54 @@ TEST_CASE("Stateful SHA256 tests", "[crypto]")
     }
 }
 
+TEST_CASE("PipelinedSHA256 is identical to stateful SHA256", "[crypto]")
+{
+    auto check = [](PipelinedSHA256::PostJob const& postJob) {
+        // Batch sizes smaller than, equal to and larger than the inputs
+        for (size_t batchSize : {1, 7, 64, 100000})
+        {
+            SHA256 h;
+            PipelinedSHA256 ph(batchSize, postJob);
+            for (size_t i = 0; i < 100; ++i)
+            {
+                auto entry = LedgerTestUtils::generateValidLedgerEntry(100);
+                auto bytes = xdr::xdr_to_opaque(entry);
+                h.add(bytes);
+                ph.add(bytes);
+            }
+            CHECK(h.finish() == ph.finish());
+            CHECK_THROWS(ph.finish());
+        }
+    };
+
+    SECTION("jobs run on other threads")
+    {
+        std::vector<std::thread> threads;
+        check([&](std::function<void()>&& f) {
+            threads.emplace_back(std::move(f));
+        });
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    SECTION("jobs never run")
+    {
+        // The caller hashes every batch itself rather than wait on them
+        std::vector<std::function<void()>> jobs;
+        check([&](std::function<void()>&& f) {
+            jobs.emplace_back(std::move(f));
+        });
+        CHECK(!jobs.empty());
+        // Jobs running late find nothing left to hash
+        for (auto& job : jobs)
+        {
+            job();
+        }
+    }
+}
+
 TEST_CASE("XDRSHA256 is identical to byte SHA256", "[crypto]")
 {
     for (size_t i = 0; i < 1000; ++i)
@@ -120,6 +172,61 @@ TEST_CASE("XDRSHA256 is identical to byte SHA256", "[crypto]")
     }
 }
 
+TEST_CASE("XDR hashing of several values is identical to byte hashing",
+          "[crypto]")
+{
+    shortHash::initialize();
+    Hash networkID = sha256("network");
+    for (size_t i = 0; i < 100; ++i)
+    {
+        auto entry = LedgerTestUtils::generateValidLedgerEntry(100);
+        auto bytes =
+            xdr::xdr_to_opaque(networkID, ENVELOPE_TYPE_TX, uint64_t(i), entry);
+        CHECK(sha256(bytes) ==
+              xdrSha256(networkID, ENVELOPE_TYPE_TX, uint64_t(i), entry));
+        CHECK(blake2(bytes) ==
+              xdrBlake2(networkID, ENVELOPE_TYPE_TX, uint64_t(i), entry));
+        CHECK(shortHash::computeHash(bytes) ==
+              shortHash::xdrComputeHash(networkID, ENVELOPE_TYPE_TX,
+                                        uint64_t(i), entry));
+    }
+}
+
+TEST_CASE("transaction contents hash bench", "[crypto-bench][bench][!hide]")
+{
+    autocheck::rng().seed(11111);
+    Hash networkID = sha256("network");
+    std::vector<LedgerEntry> entries;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        entries.emplace_back(LedgerTestUtils::generateValidLedgerEntry(100));
+    }
+
+    // The shape of TransactionFrame::getContentsHash, before and after
+    // hashing without serializing first
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 100; ++i)
+    {
+        for (auto const& e : entries)
+        {
+            sha256(xdr::xdr_to_opaque(networkID, ENVELOPE_TYPE_TX, e));
+        }
+    }
+    auto serialized = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 100; ++i)
+    {
+        for (auto const& e : entries)
+        {
+            xdrSha256(networkID, ENVELOPE_TYPE_TX, e);
+        }
+    }
+    auto streamed = std::chrono::steady_clock::now() - start;
+    LOG_INFO(DEFAULT_LOG, "Serialize then hash: {}, streaming hash: {}",
+             serialized / (100 * entries.size()),
+             streamed / (100 * entries.size()));
+}
+
 TEST_CASE("SHA256 bytes bench", "[!hide][sha-bytes-bench]")
 {
     shortHash::initialize();
@@ -296,6 +403,130 @@ TEST_CASE("sign tests", "[crypto]")
     CHECK(!PubKeyUtils::verifySig(pk, sig, msg));
 }
 
+TEST_CASE("batch signature verification", "[crypto]")
+{
+    PubKeyUtils::clearVerifySigCache();
+    std::vector<SecretKey> keys;
+    std::vector<std::string> msgs;
+    std::vector<Signature> sigs;
+    for (int i = 0; i < 10; ++i)
+    {
+        keys.emplace_back(SecretKey::pseudoRandomForTesting());
+        msgs.emplace_back("message " + std::to_string(i));
+        sigs.emplace_back(keys.back().sign(msgs.back()));
+    }
+    // Wrong message, wrong key, corrupted and truncated signatures
+    sigs[1] = keys[1].sign(msgs[2]);
+    sigs[3] = keys[4].sign(msgs[3]);
+    sigs[5][4] ^= 1;
+    sigs[7].resize(10);
+
+    std::vector<PubKeyUtils::SignatureToVerify> batch;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        batch.push_back({keys[i].getPublicKey(), sigs[i], msgs[i]});
+    }
+
+    uint64_t hits, misses;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+    // Verify some signatures on their own first, so that the batch mixes
+    // cache hits and misses
+    for (size_t i = 0; i < 4; ++i)
+    {
+        PubKeyUtils::verifySig(keys[i].getPublicKey(), sigs[i], msgs[i]);
+    }
+    auto res = PubKeyUtils::verifySigs(batch);
+    REQUIRE(res.size() == batch.size());
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        REQUIRE(res[i] ==
+                PubKeyUtils::verifySig(keys[i].getPublicKey(), sigs[i],
+                                       msgs[i]));
+    }
+    REQUIRE(res == std::vector<bool>{true, false, true, false, true, false,
+                                     true, false, true, true});
+
+    // The truncated signature is never looked up
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(misses == 9);
+    REQUIRE(hits == 4 + 9);
+}
+
+TEST_CASE("sharded signature verification cache", "[crypto]")
+{
+    PubKeyUtils::clearVerifySigCache();
+    uint64_t hits, misses;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+    std::vector<SecretKey> keys;
+    std::vector<std::string> msgs;
+    std::vector<Signature> sigs;
+    for (int i = 0; i < 64; ++i)
+    {
+        keys.emplace_back(SecretKey::pseudoRandomForTesting());
+        msgs.emplace_back("message " + std::to_string(i));
+        sigs.emplace_back(keys.back().sign(msgs.back()));
+    }
+
+    // Every thread verifies every signature, each missing the cache at most
+    // once overall
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                if (!PubKeyUtils::verifySig(keys[i].getPublicKey(), sigs[i],
+                                            msgs[i]))
+                {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    REQUIRE(failures == 0);
+
+    std::vector<uint64_t> shardHits, shardMisses;
+    PubKeyUtils::flushVerifySigCacheShardCounts(shardHits, shardMisses);
+    REQUIRE(shardHits.size() == PubKeyUtils::VERIFY_SIG_CACHE_SHARDS);
+    uint64_t totalHits = 0, totalMisses = 0;
+    size_t usedShards = 0;
+    for (size_t i = 0; i < shardHits.size(); ++i)
+    {
+        totalHits += shardHits[i];
+        totalMisses += shardMisses[i];
+        usedShards += (shardHits[i] + shardMisses[i]) != 0;
+    }
+    REQUIRE(totalHits + totalMisses == 4 * keys.size());
+    REQUIRE(totalMisses >= keys.size());
+    REQUIRE(usedShards > 1);
+
+    SECTION("resizing clears the cache")
+    {
+        PubKeyUtils::setVerifySigCacheSize(
+            PubKeyUtils::VERIFY_SIG_CACHE_SHARDS);
+        PubKeyUtils::verifySig(keys[0].getPublicKey(), sigs[0], msgs[0]);
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        REQUIRE(misses == 1);
+
+        // One entry per shard: verifying everything again evicts
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            PubKeyUtils::verifySig(keys[i].getPublicKey(), sigs[i], msgs[i]);
+        }
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        REQUIRE(misses >= keys.size() - PubKeyUtils::VERIFY_SIG_CACHE_SHARDS);
+        PubKeyUtils::setVerifySigCacheSize(
+            PubKeyUtils::DEFAULT_VERIFY_SIG_CACHE_SIZE);
+    }
+}
+
 TEST_CASE("sign and verify benchmarking", "[crypto-bench][bench][!hide]")
 {
     size_t signPerSec = 0, verifyPerSec = 0;
@@ -305,6 +536,16 @@ TEST_CASE("sign and verify benchmarking", "[crypto-bench][bench][!hide]")
     LOG_INFO(DEFAULT_LOG, "Benchmarked {} verifications / sec", verifyPerSec);
 }
 
+TEST_CASE("batch verify benchmarking", "[crypto-bench][bench][!hide]")
+{
+    size_t signPerSec = 0, verifyPerSec = 0;
+    LOG_INFO(DEFAULT_LOG, "Benchmarking signatures and batch verifications");
+    SecretKey::benchmarkOpsPerSecond(signPerSec, verifyPerSec, 10000, 1, 64);
+    LOG_INFO(DEFAULT_LOG, "Benchmarked {} signatures / sec", signPerSec);
+    LOG_INFO(DEFAULT_LOG, "Benchmarked {} batch verifications / sec",
+             verifyPerSec);
+}
+
 TEST_CASE("verify-hit benchmarking", "[crypto-bench][bench][!hide]")
 {
     size_t signPerSec = 0, verifyPerSec = 0;
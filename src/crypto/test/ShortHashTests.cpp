@@ -4,9 +4,15 @@
 
 #include "crypto/Random.h"
 #include "crypto/ShortHash.h"
+#include "ledger/LedgerHashUtils.h"
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
+#include "util/Logging.h"
+#include "util/UnorderedMap.h"
+#include "util/UnorderedSet.h"
+#include <algorithm>
 #include <autocheck/generator.hpp>
+#include <chrono>
 
 // Confirms that the incremental, non-allocating `xdrComputeHash(...)` produces
 // the same output as `computeHash(xdr_to_opaque(...))`.
@@ -61,3 +67,127 @@ TEST_CASE("shorthash XDR bench", "[!hide][sh-xdr-bench]")
         }
     }
 }
+
+namespace
+{
+struct LedgerKeyFieldHasher
+{
+    size_t
+    operator()(LedgerKey const& lk) const
+    {
+        return getLedgerKeyFieldHash(lk);
+    }
+};
+
+struct LedgerKeyShortHasher
+{
+    size_t
+    operator()(LedgerKey const& lk) const
+    {
+        return getLedgerKeyShortHash(lk);
+    }
+};
+
+// Number of keys that share their bucket of `map` with a previous key
+template <typename Map>
+size_t
+countBucketCollisions(Map const& map)
+{
+    size_t collisions = 0;
+    for (size_t b = 0; b < map.bucket_count(); ++b)
+    {
+        collisions += std::max<size_t>(map.bucket_size(b), 1) - 1;
+    }
+    return collisions;
+}
+
+template <typename Hasher>
+void
+benchLedgerKeyLookups(std::string const& name,
+                      std::vector<LedgerKey> const& keys)
+{
+    UnorderedMap<LedgerKey, size_t, Hasher> map;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        map.emplace(keys[i], i);
+    }
+
+    size_t const rounds = 1000;
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        for (auto const& k : keys)
+        {
+            found += map.count(k);
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    REQUIRE(found == rounds * keys.size());
+    CLOG_INFO(Ledger,
+              "{} hash: {} lookups/us, {} bucket collisions for {} keys in "
+              "{} buckets",
+              name,
+              static_cast<double>(found) /
+                  std::max<int64_t>(elapsed.count(), 1),
+              countBucketCollisions(map), keys.size(), map.bucket_count());
+}
+}
+
+TEST_CASE("LedgerKey short hash", "[shorthash][crypto]")
+{
+    shortHash::initialize();
+    auto keys =
+        LedgerTestUtils::generateValidUniqueLedgerEntryKeysWithExclusions({},
+                                                                         2000);
+    UnorderedSet<uint64_t> shortHashes;
+    UnorderedSet<uint64_t> fieldHashes;
+    for (auto const& k : keys)
+    {
+        // Equal keys hash the same whichever way they were built
+        LedgerKey copy;
+        xdr::xdr_from_opaque(xdr::xdr_to_opaque(k), copy);
+        REQUIRE(getLedgerKeyShortHash(copy) == getLedgerKeyShortHash(k));
+        REQUIRE(std::hash<LedgerKey>()(copy) == std::hash<LedgerKey>()(k));
+
+        shortHashes.emplace(getLedgerKeyShortHash(k));
+        fieldHashes.emplace(getLedgerKeyFieldHash(k));
+    }
+
+    // Offers are told apart by their ID only, so some random offer keys may
+    // collide with either hash; nothing else should
+    size_t offers = std::count_if(keys.begin(), keys.end(), [](auto const& k) {
+        return k.type() == OFFER;
+    });
+    REQUIRE(shortHashes.size() + offers >= keys.size());
+    REQUIRE(fieldHashes.size() + offers >= keys.size());
+}
+
+TEST_CASE("LedgerKey hash bench", "[!hide][ledger-key-hash-bench]")
+{
+    shortHash::initialize();
+    autocheck::rng().seed(11111);
+    auto keys =
+        LedgerTestUtils::generateValidUniqueLedgerEntryKeysWithExclusions({},
+                                                                         10000);
+    benchLedgerKeyLookups<LedgerKeyFieldHasher>("field", keys);
+    benchLedgerKeyLookups<LedgerKeyShortHasher>("short", keys);
+
+    for (auto t : {ACCOUNT, TRUSTLINE, CONTRACT_DATA})
+    {
+        std::vector<LedgerKey> typeKeys;
+        for (auto const& k : keys)
+        {
+            if (k.type() == t)
+            {
+                typeKeys.emplace_back(k);
+            }
+        }
+        auto name = xdr::xdr_traits<LedgerEntryType>::enum_name(t);
+        benchLedgerKeyLookups<LedgerKeyFieldHasher>(
+            fmt::format("{} field", name), typeKeys);
+        benchLedgerKeyLookups<LedgerKeyShortHasher>(
+            fmt::format("{} short", name), typeKeys);
+    }
+}
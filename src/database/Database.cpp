@@ -32,6 +32,8 @@
 #include "transactions/TransactionSQL.h"
 
 #include "medida/counter.h"
+#include "medida/histogram.h"
+#include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
 #include "xdr/Stellar-ledger-entries.h"
@@ -41,6 +43,9 @@
 #ifdef USE_POSTGRES
 #include <lib/soci/src/backends/postgresql/soci-postgresql.h>
 #endif
+#include <algorithm>
+#include <cctype>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <thread>
@@ -130,9 +135,15 @@ Database::registerDrivers()
 class DatabaseConfigureSessionOp : public DatabaseTypeSpecificOperation<void>
 {
     soci::session& mSession;
+    Config const& mConfig;
+    bool mManagedCheckpoints;
 
   public:
-    DatabaseConfigureSessionOp(soci::session& sess) : mSession(sess)
+    DatabaseConfigureSessionOp(soci::session& sess, Config const& cfg,
+                               bool managedCheckpoints)
+        : mSession(sess)
+        , mConfig(cfg)
+        , mManagedCheckpoints(managedCheckpoints)
     {
     }
     void
@@ -149,18 +160,25 @@ class DatabaseConfigureSessionOp : public DatabaseTypeSpecificOperation<void>
         // NORMAL is enough for non validating nodes
         // mSession << "PRAGMA synchronous = NORMAL";
 
-        // number of pages in WAL file
-        mSession << "PRAGMA wal_autocheckpoint=10000";
+        // number of pages in WAL file, or none when Database checkpoints it
+        // in the background
+        if (mManagedCheckpoints)
+        {
+            mSession << "PRAGMA wal_autocheckpoint=0";
+        }
+        else
+        {
+            mSession << "PRAGMA wal_autocheckpoint=10000";
+        }
 
         // busy_timeout gives room for external processes
         // that may lock the database for some time
         mSession << "PRAGMA busy_timeout = 10000";
 
-        // adjust caches
-        // 20000 pages
-        mSession << "PRAGMA cache_size=-20000";
-        // 100 MB map
-        mSession << "PRAGMA mmap_size=104857600";
+        // adjust caches, a negative cache_size being in KiB
+        mSession << "PRAGMA cache_size=-" << mConfig.SQLITE_CACHE_SIZE_KB;
+        mSession << "PRAGMA mmap_size="
+                 << uint64_t(mConfig.SQLITE_MMAP_SIZE_MB) * 1024 * 1024;
 
         // Register the sqlite carray() extension we use for bulk operations.
         sqlite3_carray_init(sq->conn_, nullptr, nullptr);
@@ -185,8 +203,20 @@ Database::Database(Application& app)
     : mApp(app)
     , mQueryMeter(
           app.getMetrics().NewMeter({"database", "query", "exec"}, "query"))
+    , mPoolWait(app.getMetrics().NewTimer({"database", "pool", "wait"}))
+    , mPoolBorrowed(
+          app.getMetrics().NewCounter({"database", "pool", "borrowed"}))
     , mStatementsSize(
           app.getMetrics().NewCounter({"database", "memory", "statements"}))
+    , mStatementCacheHits(app.getMetrics().NewMeter(
+          {"database", "statement-cache", "hit"}, "statement"))
+    , mStatementCacheMisses(app.getMetrics().NewMeter(
+          {"database", "statement-cache", "miss"}, "statement"))
+    , mManagedCheckpoints(app.getConfig().SQLITE_MANAGED_CHECKPOINTS &&
+                          isSqlite() && canUsePool())
+    , mCheckpointTime(
+          app.getMetrics().NewTimer({"database", "wal", "checkpoint"}))
+    , mWalSize(app.getMetrics().NewCounter({"database", "wal", "size"}))
 {
     registerDrivers();
 
@@ -200,10 +230,62 @@ void
 Database::open()
 {
     mSession.open(mApp.getConfig().DATABASE.value);
-    DatabaseConfigureSessionOp op(mSession);
+    DatabaseConfigureSessionOp op(mSession, mApp.getConfig(),
+                                  mManagedCheckpoints);
     doDatabaseTypeSpecificOperation(op);
 }
 
+void
+Database::checkpointWALInBackground()
+{
+    if (!mManagedCheckpoints || mCheckpointRunning.exchange(true))
+    {
+        return;
+    }
+    mApp.postOnBackgroundThread(
+        [this]() {
+            try
+            {
+                checkpointWAL();
+            }
+            catch (std::exception& e)
+            {
+                CLOG_WARNING(Database, "Failed to checkpoint the WAL: {}",
+                             e.what());
+            }
+            mCheckpointRunning = false;
+        },
+        "Database: checkpoint WAL");
+}
+
+void
+Database::checkpointWAL()
+{
+    if (!mCheckpointSession)
+    {
+        mCheckpointSession =
+            std::make_unique<soci::session>(mApp.getConfig().DATABASE.value);
+        DatabaseConfigureSessionOp op(*mCheckpointSession, mApp.getConfig(),
+                                      mManagedCheckpoints);
+        stellar::doDatabaseTypeSpecificOperation(*mCheckpointSession, op);
+    }
+
+    // A passive checkpoint copies what it can of the WAL to the database
+    // without waiting for readers or blocking the writer. walFrames is the
+    // number of frames in the WAL, each holding a page.
+    int busy = 0;
+    int walFrames = 0;
+    int checkpointed = 0;
+    int64_t pageSize = 0;
+    {
+        auto timer = mCheckpointTime.TimeScope();
+        *mCheckpointSession << "PRAGMA wal_checkpoint(PASSIVE)",
+            soci::into(busy), soci::into(walFrames), soci::into(checkpointed);
+    }
+    *mCheckpointSession << "PRAGMA page_size", soci::into(pageSize);
+    mWalSize.set_count(std::max(walFrames, 0) * pageSize);
+}
+
 void
 Database::applySchemaUpgrade(unsigned long vers)
 {
@@ -506,7 +588,11 @@ Database::getPool()
             s += removePasswordFromConnectionString(c.value);
             throw std::runtime_error(s);
         }
-        size_t n = std::thread::hardware_concurrency();
+        size_t n = mApp.getConfig().DATABASE_POOL_SIZE;
+        if (n == 0)
+        {
+            n = std::thread::hardware_concurrency();
+        }
         LOG_INFO(DEFAULT_LOG, "Establishing {}-entry connection pool to: {}", n,
                  removePasswordFromConnectionString(c.value));
         mPool = std::make_unique<soci::connection_pool>(n);
@@ -515,7 +601,8 @@ Database::getPool()
             LOG_DEBUG(DEFAULT_LOG, "Opening pool entry {}", i);
             soci::session& sess = mPool->at(i);
             sess.open(c.value);
-            DatabaseConfigureSessionOp op(sess);
+            DatabaseConfigureSessionOp op(sess, mApp.getConfig(),
+                                          mManagedCheckpoints);
             stellar::doDatabaseTypeSpecificOperation(sess, op);
         }
     }
@@ -523,6 +610,29 @@ Database::getPool()
     return *mPool;
 }
 
+PooledSession::PooledSession(Database& db) : mDatabase(db)
+{
+    auto& pool = db.getPool();
+    auto timer = db.mPoolWait.TimeScope();
+    mSession.emplace(pool);
+    db.mPoolBorrowed.inc();
+}
+
+PooledSession::~PooledSession()
+{
+    mSession.reset();
+    mDatabase.mPoolBorrowed.dec();
+}
+
+void
+PooledSession::setCurrentTransactionReadOnly()
+{
+    if (!mDatabase.isSqlite())
+    {
+        *mSession << "SET TRANSACTION READ ONLY";
+    }
+}
+
 class SQLLogContext : NonCopyable
 {
     std::string mName;
@@ -559,6 +669,286 @@ class SQLLogContext : NonCopyable
     }
 };
 
+struct StatementMetrics
+{
+    Database* const mDB;
+    std::string const mQuery;
+    std::string const mLabel;
+    // Whether get_affected_rows is meaningful for the statement: SQLite only
+    // counts rows changed, not rows selected
+    bool const mCountRows;
+    // Only set when SQL_STATEMENT_METRICS is enabled
+    medida::Timer* const mTimer;
+    medida::Histogram* const mRows;
+    std::optional<std::chrono::steady_clock::time_point> mLastExplain;
+};
+
+// Builds a short, stable metric name for query out of its verb, the first
+// table it names and a hash of the full text, e.g. "select-accounts-1a2b3c4d"
+static std::string
+statementLabel(std::string const& query)
+{
+    auto lower = [](std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        return s;
+    };
+
+    std::istringstream words(query);
+    std::string verb, prev, word, table;
+    words >> verb;
+    verb = lower(verb);
+    prev = verb;
+    while (table.empty() && words >> word)
+    {
+        word = lower(word);
+        if (prev == "from" || prev == "into" || prev == "update")
+        {
+            for (char c : word)
+            {
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_')
+                {
+                    break;
+                }
+                table.push_back(c);
+            }
+        }
+        prev = word;
+    }
+
+    auto h = static_cast<uint32_t>(std::hash<std::string>{}(query));
+    return fmt::format(FMT_STRING("{}-{}-{:08x}"), verb,
+                       table.empty() ? "none" : table, h);
+}
+
+std::shared_ptr<StatementMetrics>
+Database::getStatementMetrics(std::string const& query)
+{
+    auto const& cfg = mApp.getConfig();
+    if (!cfg.SQL_STATEMENT_METRICS &&
+        cfg.SQL_SLOW_STATEMENT_EXPLAIN_MS.count() == 0)
+    {
+        return nullptr;
+    }
+
+    auto i = mStatementMetrics.find(query);
+    if (i != mStatementMetrics.end())
+    {
+        return i->second;
+    }
+
+    auto label = statementLabel(query);
+    auto verb = label.substr(0, label.find('-'));
+    bool countRows = verb == "insert" || verb == "update" ||
+                     verb == "delete" || (verb == "select" && !isSqlite());
+    medida::Timer* timer = nullptr;
+    medida::Histogram* rows = nullptr;
+    if (cfg.SQL_STATEMENT_METRICS)
+    {
+        timer = &mApp.getMetrics().NewTimer({"database", "statement", label});
+        rows = &mApp.getMetrics().NewHistogram(
+            {"database", "statement-rows", label});
+        CLOG_INFO(Database, "Recording metrics of statement {}: {}", label,
+                  query);
+    }
+    auto metrics = std::make_shared<StatementMetrics>(
+        StatementMetrics{this, query, label, countRows, timer, rows,
+                         std::nullopt});
+    mStatementMetrics.emplace(query, metrics);
+    return metrics;
+}
+
+void
+StatementContext::recordMetrics() noexcept
+{
+    // A statement abandoned by an exception may not have run at all
+    if (std::uncaught_exceptions() > mUncaughtExceptions)
+    {
+        return;
+    }
+
+    try
+    {
+        auto elapsed = std::chrono::steady_clock::now() - mStart;
+        if (mMetrics->mTimer)
+        {
+            mMetrics->mTimer->Update(elapsed);
+            long long rows = mMetrics->mCountRows ? mStmt->get_affected_rows()
+                                                  : -1;
+            if (rows >= 0)
+            {
+                mMetrics->mRows->Update(rows);
+            }
+        }
+
+        auto& db = *mMetrics->mDB;
+        auto threshold = db.mApp.getConfig().SQL_SLOW_STATEMENT_EXPLAIN_MS;
+        auto ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+        if (threshold.count() != 0 && ms >= threshold)
+        {
+            db.explainSlowStatement(*mMetrics, ms);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        CLOG_DEBUG(Database, "Could not record statement metrics: {}",
+                   e.what());
+    }
+    catch (...)
+    {
+    }
+}
+
+// Asks the database how it would run a query, without running it or binding
+// its parameters. Returns nothing if the database cannot tell.
+class ExplainStatementOp
+    : public DatabaseTypeSpecificOperation<std::vector<std::string>>
+{
+    std::string const& mQuery;
+
+  public:
+    ExplainStatementOp(std::string const& query) : mQuery(query)
+    {
+    }
+
+    std::vector<std::string>
+    doSqliteSpecificOperation(soci::sqlite3_session_backend* sq) override
+    {
+        std::vector<std::string> plan;
+        auto sql = "EXPLAIN QUERY PLAN " + mQuery;
+        sqlite_api::sqlite3_stmt* stmt = nullptr;
+        if (sqlite_api::sqlite3_prepare_v2(sq->conn_, sql.c_str(), -1, &stmt,
+                                           nullptr) != SQLITE_OK)
+        {
+            sqlite_api::sqlite3_finalize(stmt);
+            return plan;
+        }
+        // Unbound parameters are NULL, which is fine for planning
+        while (sqlite_api::sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            auto n = sqlite_api::sqlite3_column_count(stmt);
+            auto text = sqlite_api::sqlite3_column_text(stmt, n - 1);
+            if (text)
+            {
+                plan.emplace_back(reinterpret_cast<char const*>(text));
+            }
+        }
+        sqlite_api::sqlite3_finalize(stmt);
+        return plan;
+    }
+
+#ifdef USE_POSTGRES
+    std::vector<std::string>
+    doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override
+    {
+        std::vector<std::string> plan;
+        // GENERIC_PLAN plans a query with parameters left unbound, and only
+        // exists from Postgres 16
+        if (PQserverVersion(pg->conn_) < 160000)
+        {
+            return plan;
+        }
+
+        // A failed statement would abort the ledger's transaction, so the
+        // plan is asked for inside a savepoint, and never in a transaction
+        // that has already failed
+        auto status = PQtransactionStatus(pg->conn_);
+        bool inTx = status == PQTRANS_INTRANS;
+        if (!inTx && status != PQTRANS_IDLE)
+        {
+            return plan;
+        }
+        auto exec = [&](std::string const& sql) {
+            return std::unique_ptr<PGresult, decltype(&PQclear)>(
+                PQexec(pg->conn_, sql.c_str()), &PQclear);
+        };
+        if (inTx && PQresultStatus(exec("SAVEPOINT explain_slow").get()) !=
+                        PGRES_COMMAND_OK)
+        {
+            return plan;
+        }
+
+        auto res = exec("EXPLAIN (GENERIC_PLAN) " + toPostgresParameters());
+        if (PQresultStatus(res.get()) == PGRES_TUPLES_OK)
+        {
+            for (int i = 0; i < PQntuples(res.get()); ++i)
+            {
+                plan.emplace_back(PQgetvalue(res.get(), i, 0));
+            }
+        }
+        if (inTx)
+        {
+            exec(plan.empty() ? "ROLLBACK TO SAVEPOINT explain_slow"
+                              : "RELEASE SAVEPOINT explain_slow");
+        }
+        return plan;
+    }
+
+    // soci rewrites :name placeholders into Postgres' $n ones; as the plan is
+    // asked for directly through libpq, do the same here
+    std::string
+    toPostgresParameters() const
+    {
+        std::string res;
+        std::map<std::string, size_t> params;
+        for (size_t i = 0; i < mQuery.size(); ++i)
+        {
+            char c = mQuery[i];
+            bool isCast = (i > 0 && mQuery[i - 1] == ':') ||
+                          (i + 1 < mQuery.size() && mQuery[i + 1] == ':');
+            if (c != ':' || isCast)
+            {
+                res.push_back(c);
+                continue;
+            }
+            size_t end = i + 1;
+            while (end < mQuery.size() &&
+                   (std::isalnum(static_cast<unsigned char>(mQuery[end])) ||
+                    mQuery[end] == '_'))
+            {
+                ++end;
+            }
+            if (end == i + 1)
+            {
+                res.push_back(c);
+                continue;
+            }
+            auto name = mQuery.substr(i + 1, end - i - 1);
+            auto it = params.emplace(name, params.size() + 1).first;
+            res += "$" + std::to_string(it->second);
+            i = end - 1;
+        }
+        return res;
+    }
+#endif
+};
+
+void
+Database::explainSlowStatement(StatementMetrics& metrics,
+                               std::chrono::milliseconds elapsed)
+{
+    CLOG_WARNING(Database, "Slow SQL statement {} took {} ms: {}",
+                 metrics.mLabel, elapsed.count(), metrics.mQuery);
+
+    // Plans are only logged once a minute per statement, to keep a slow
+    // database from flooding the log
+    auto now = std::chrono::steady_clock::now();
+    if (metrics.mLastExplain &&
+        now - *metrics.mLastExplain < std::chrono::minutes(1))
+    {
+        return;
+    }
+    metrics.mLastExplain = now;
+
+    ExplainStatementOp op(metrics.mQuery);
+    for (auto const& line : doDatabaseTypeSpecificOperation(op))
+    {
+        CLOG_WARNING(Database, "[plan {}] {}", metrics.mLabel, line);
+    }
+}
+
 StatementContext
 Database::getPreparedStatement(std::string const& query)
 {
@@ -566,6 +956,7 @@ Database::getPreparedStatement(std::string const& query)
     std::shared_ptr<soci::statement> p;
     if (i == mStatements.end())
     {
+        mStatementCacheMisses.Mark();
         p = std::make_shared<soci::statement>(mSession);
         p->alloc();
         p->prepare(query);
@@ -574,9 +965,10 @@ Database::getPreparedStatement(std::string const& query)
     }
     else
     {
+        mStatementCacheHits.Mark();
         p = i->second;
     }
-    StatementContext sc(p);
+    StatementContext sc(p, getStatementMetrics(query));
     return sc;
 }
 
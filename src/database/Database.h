@@ -10,7 +10,12 @@
 #include "util/Decoder.h"
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <set>
 #include <soci.h>
 #include <string>
@@ -20,24 +25,41 @@ namespace medida
 {
 class Meter;
 class Counter;
+class Histogram;
+class Timer;
 }
 
 namespace stellar
 {
 class Application;
 class SQLLogContext;
+struct StatementMetrics;
 
 /**
  * Helper class for borrowing a SOCI prepared statement handle into a local
  * scope and cleaning it up once done with it. Returned by
  * Database::getPreparedStatement below.
+ *
+ * When per-statement instrumentation is enabled (see SQL_STATEMENT_METRICS and
+ * SQL_SLOW_STATEMENT_EXPLAIN_MS), the time the statement is borrowed for is
+ * recorded when it is returned, unless an exception is unwinding the scope.
  */
 class StatementContext : NonCopyable
 {
     std::shared_ptr<soci::statement> mStmt;
+    std::shared_ptr<StatementMetrics> mMetrics;
+    std::chrono::steady_clock::time_point mStart;
+    int mUncaughtExceptions{0};
+
+    void recordMetrics() noexcept;
 
   public:
-    StatementContext(std::shared_ptr<soci::statement> stmt) : mStmt(stmt)
+    StatementContext(std::shared_ptr<soci::statement> stmt,
+                     std::shared_ptr<StatementMetrics> metrics = nullptr)
+        : mStmt(stmt)
+        , mMetrics(std::move(metrics))
+        , mStart(std::chrono::steady_clock::now())
+        , mUncaughtExceptions(std::uncaught_exceptions())
     {
         mStmt->clean_up(false);
     }
@@ -45,11 +67,18 @@ class StatementContext : NonCopyable
     {
         mStmt = other.mStmt;
         other.mStmt.reset();
+        mMetrics = std::move(other.mMetrics);
+        mStart = other.mStart;
+        mUncaughtExceptions = other.mUncaughtExceptions;
     }
     ~StatementContext()
     {
         if (mStmt)
         {
+            if (mMetrics)
+            {
+                recordMetrics();
+            }
             mStmt->clean_up(false);
         }
     }
@@ -90,16 +119,45 @@ class Database : NonMovableOrCopyable
     medida::Meter& mQueryMeter;
     soci::session mSession;
     std::unique_ptr<soci::connection_pool> mPool;
+    medida::Timer& mPoolWait;
+    medida::Counter& mPoolBorrowed;
 
     std::map<std::string, std::shared_ptr<soci::statement>> mStatements;
     medida::Counter& mStatementsSize;
+    medida::Meter& mStatementCacheHits;
+    medida::Meter& mStatementCacheMisses;
+
+    // Instrumentation of every prepared statement, keyed by query. Kept when
+    // the statement cache is cleared so that metrics are not registered
+    // again.
+    std::map<std::string, std::shared_ptr<StatementMetrics>>
+        mStatementMetrics;
 
     std::set<std::string> mEntityTypes;
 
+    // With SQLITE_MANAGED_CHECKPOINTS, the WAL is checkpointed through
+    // mCheckpointSession, which only the background checkpoint uses
+    bool const mManagedCheckpoints;
+    std::unique_ptr<soci::session> mCheckpointSession;
+    std::atomic<bool> mCheckpointRunning{false};
+    medida::Timer& mCheckpointTime;
+    medida::Counter& mWalSize;
+
     static bool gDriversRegistered;
     static void registerDrivers();
     void applySchemaUpgrade(unsigned long vers);
     void open();
+    void checkpointWAL();
+
+    std::shared_ptr<StatementMetrics>
+    getStatementMetrics(std::string const& query);
+
+    friend class PooledSession;
+    // Logs a statement that took longer than SQL_SLOW_STATEMENT_EXPLAIN_MS,
+    // along with its query plan where the database can provide one
+    void explainSlowStatement(StatementMetrics& metrics,
+                              std::chrono::milliseconds elapsed);
+    friend class StatementContext;
 
   public:
     // Instantiate object and connect to app.getConfig().DATABASE;
@@ -125,6 +183,11 @@ class Database : NonMovableOrCopyable
     // database.
     void clearPreparedStatementCache();
 
+    // With SQLITE_MANAGED_CHECKPOINTS, starts a passive checkpoint of the WAL
+    // on a background thread, unless one is still running. Otherwise does
+    // nothing, as commits checkpoint the WAL themselves.
+    void checkpointWALInBackground();
+
     // Return metric-gathering timers for various families of SQL operation.
     // These timers automatically count the time they are alive for,
     // so only acquire them immediately before executing an SQL statement.
@@ -179,10 +242,37 @@ class Database : NonMovableOrCopyable
     soci::session& getSession();
 
     // Access the optional SOCI connection pool available for worker
-    // threads. Throws an error if !canUsePool().
+    // threads. Throws an error if !canUsePool(). Prefer borrowing from it
+    // through PooledSession, which instruments the pool.
     soci::connection_pool& getPool();
 };
 
+/**
+ * Session borrowed from Database::getPool for the lifetime of this object, for
+ * a worker thread to read the database through. The time spent waiting for a
+ * free connection and the number of connections borrowed are recorded in the
+ * database.pool metrics.
+ */
+class PooledSession : NonMovableOrCopyable
+{
+    Database& mDatabase;
+    std::optional<soci::session> mSession;
+
+  public:
+    explicit PooledSession(Database& db);
+    ~PooledSession();
+
+    soci::session&
+    session()
+    {
+        return *mSession;
+    }
+
+    // Marks the transaction open on this session as read-only, where the
+    // database supports it (i.e. on postgres)
+    void setCurrentTransactionReadOnly();
+};
+
 template <typename T>
 T
 doDatabaseTypeSpecificOperation(soci::session& session,
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <optional>
 #include <random>
+#include <thread>
 
 using namespace stellar;
 
@@ -207,6 +208,81 @@ TEST_CASE("sqlite MVCC test", "[db]")
     checkMVCCIsolation(app);
 }
 
+TEST_CASE("pooled sessions", "[db]")
+{
+    Config cfg = getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE);
+    cfg.DATABASE_POOL_SIZE = 2;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg, true, false);
+    auto& db = app->getDatabase();
+    REQUIRE(db.canUsePool());
+
+    db.getSession() << "CREATE TABLE test (x INTEGER)";
+    db.getSession() << "INSERT INTO test (x) VALUES (7)";
+
+    auto& borrowed =
+        app->getMetrics().NewCounter({"database", "pool", "borrowed"});
+    auto& wait = app->getMetrics().NewTimer({"database", "pool", "wait"});
+    auto waitsBefore = wait.count();
+    {
+        PooledSession s1(db);
+        PooledSession s2(db);
+        REQUIRE(borrowed.count() == 2);
+        // Both connections of the pool are taken
+        size_t pos;
+        REQUIRE(!db.getPool().try_lease(pos, 0));
+
+        soci::transaction tx(s1.session());
+        s1.setCurrentTransactionReadOnly();
+        int x = 0;
+        s1.session() << "SELECT x FROM test", soci::into(x);
+        REQUIRE(x == 7);
+    }
+    REQUIRE(borrowed.count() == 0);
+    REQUIRE(wait.count() == waitsBefore + 2);
+}
+
+TEST_CASE("sqlite managed checkpoints", "[db]")
+{
+    Config cfg = getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE);
+    cfg.SQLITE_MANAGED_CHECKPOINTS = true;
+    cfg.SQLITE_CACHE_SIZE_KB = 1000;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg, true, false);
+    auto& db = app->getDatabase();
+    auto& sess = db.getSession();
+
+    int autoCheckpoint = -1;
+    sess << "PRAGMA wal_autocheckpoint", soci::into(autoCheckpoint);
+    REQUIRE(autoCheckpoint == 0);
+    int cacheSize = 0;
+    sess << "PRAGMA cache_size", soci::into(cacheSize);
+    REQUIRE(cacheSize == -1000);
+
+    sess << "CREATE TABLE test (x INTEGER)";
+    for (int i = 0; i < 100; ++i)
+    {
+        sess << "INSERT INTO test (x) VALUES (:v)", soci::use(i);
+    }
+
+    auto& checkpoints =
+        app->getMetrics().NewTimer({"database", "wal", "checkpoint"});
+    auto& walSize = app->getMetrics().NewCounter({"database", "wal", "size"});
+    auto checkpointsBefore = checkpoints.count();
+    db.checkpointWALInBackground();
+    while (walSize.count() == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(checkpoints.count() == checkpointsBefore + 1);
+
+    // The checkpoint left the data in place
+    int count = 0;
+    sess << "SELECT COUNT(*) FROM test", soci::into(count);
+    REQUIRE(count == 100);
+    sess << "DROP TABLE test";
+}
+
 #ifdef USE_POSTGRES
 TEST_CASE("postgres smoketest", "[db]")
 {
@@ -347,6 +423,106 @@ TEST_CASE("postgres performance", "[db][pgperf][!hide]")
 
 #endif
 
+TEST_CASE("prepared statement metrics", "[db]")
+{
+    Config cfg = getTestConfig(0, Config::TESTDB_IN_MEMORY_SQLITE);
+    cfg.SQL_STATEMENT_METRICS = true;
+
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& db = app->getDatabase();
+    auto& metrics = app->getMetrics();
+    db.getSession() << "CREATE TABLE test (x INTEGER)";
+
+    auto& hits = metrics.NewMeter({"database", "statement-cache", "hit"},
+                                  "statement");
+    auto& misses = metrics.NewMeter({"database", "statement-cache", "miss"},
+                                    "statement");
+    auto hitsBefore = hits.count();
+    auto missesBefore = misses.count();
+
+    std::string const insert = "INSERT INTO test (x) VALUES (:v)";
+    auto insertRow = [&](int x) {
+        auto prep = db.getPreparedStatement(insert);
+        auto& st = prep.statement();
+        st.exchange(soci::use(x));
+        st.define_and_bind();
+        st.execute(true);
+    };
+    for (int i = 0; i < 3; ++i)
+    {
+        insertRow(i);
+    }
+    REQUIRE(misses.count() == missesBefore + 1);
+    REQUIRE(hits.count() == hitsBefore + 2);
+
+    std::optional<std::string> label;
+    for (auto const& kv : metrics.GetAllMetrics())
+    {
+        auto const& name = kv.first;
+        if (name.domain() == "database" && name.type() == "statement" &&
+            name.name().rfind("insert-test-", 0) == 0)
+        {
+            label = name.name();
+        }
+    }
+    REQUIRE(label);
+    REQUIRE(metrics.NewTimer({"database", "statement", *label}).count() == 3);
+    auto& rows = metrics.NewHistogram({"database", "statement-rows", *label});
+    REQUIRE(rows.count() == 3);
+    REQUIRE(rows.max() == 1);
+}
+
+TEST_CASE("slow statements are explained without disturbing the session",
+          "[db]")
+{
+    auto runTest = [](Config::TestDbMode mode) {
+        Config cfg = getTestConfig(0, mode);
+        cfg.SQL_SLOW_STATEMENT_EXPLAIN_MS = std::chrono::milliseconds(1);
+
+        VirtualClock clock;
+        Application::pointer app = createTestApplication(clock, cfg);
+        auto& db = app->getDatabase();
+        db.getSession() << "DROP TABLE IF EXISTS test";
+        db.getSession() << "CREATE TABLE test (x INTEGER)";
+
+        soci::transaction tx(db.getSession());
+        for (int i = 0; i < 2; ++i)
+        {
+            auto prep = db.getPreparedStatement(
+                "SELECT COUNT(*) FROM test WHERE x > :v");
+            auto& st = prep.statement();
+            int count = -1;
+            st.exchange(soci::use(i));
+            st.exchange(soci::into(count));
+            st.define_and_bind();
+            st.execute(true);
+            REQUIRE(count == 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        // The transaction is still usable
+        db.getSession() << "INSERT INTO test (x) VALUES (1)";
+        tx.commit();
+        int count = 0;
+        db.getSession() << "SELECT COUNT(*) FROM test", soci::into(count);
+        REQUIRE(count == 1);
+        db.getSession() << "DROP TABLE test";
+    };
+
+    SECTION("sqlite")
+    {
+        runTest(Config::TESTDB_IN_MEMORY_SQLITE);
+    }
+
+#ifdef USE_POSTGRES
+    SECTION("postgresql")
+    {
+        runTest(Config::TESTDB_POSTGRESQL);
+    }
+#endif
+}
+
 TEST_CASE("schema test", "[db]")
 {
     Config const& cfg = getTestConfig(0, Config::TESTDB_IN_MEMORY_SQLITE);
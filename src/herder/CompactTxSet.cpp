@@ -0,0 +1,111 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/CompactTxSet.h"
+#include "crypto/SHA.h"
+#include "util/Tracing.h"
+
+namespace stellar
+{
+
+namespace
+{
+template <typename F>
+bool
+forEachComponent(GeneralizedTransactionSet& txSet, F f)
+{
+    if (txSet.v() != 1)
+    {
+        return false;
+    }
+    for (auto& phase : txSet.v1TxSet().phases)
+    {
+        if (phase.v() != 0)
+        {
+            return false;
+        }
+        for (auto& component : phase.v0Components())
+        {
+            if (component.type() != TXSET_COMP_TXS_MAYBE_DISCOUNTED_FEE)
+            {
+                return false;
+            }
+            f(component.txsMaybeDiscountedFee().txs);
+        }
+    }
+    return true;
+}
+}
+
+std::optional<CompactTxSet>
+makeCompactTxSet(GeneralizedTransactionSet const& txSet)
+{
+    ZoneScoped;
+    CompactTxSet compact;
+    compact.mTxSetHash = xdrSha256(txSet);
+    compact.mSkeleton = txSet;
+    bool ok = forEachComponent(
+        compact.mSkeleton, [&](xdr::xvector<TransactionEnvelope>& txs) {
+            auto& hashes = compact.mTxHashes.emplace_back();
+            hashes.reserve(txs.size());
+            for (auto const& tx : txs)
+            {
+                // Same as TransactionFrameBase::getFullHash
+                hashes.emplace_back(xdrSha256(tx));
+            }
+            txs.clear();
+        });
+    if (!ok)
+    {
+        return std::nullopt;
+    }
+    return compact;
+}
+
+CompactTxSetReconstruction
+reconstructTxSet(CompactTxSet const& compact, TxLookup const& lookup)
+{
+    ZoneScoped;
+    CompactTxSetReconstruction res;
+    auto txSet = compact.mSkeleton;
+    size_t component = 0;
+    bool fits = true;
+    bool ok = forEachComponent(
+        txSet, [&](xdr::xvector<TransactionEnvelope>& txs) {
+            if (component >= compact.mTxHashes.size() || !txs.empty())
+            {
+                fits = false;
+                return;
+            }
+            for (auto const& hash : compact.mTxHashes[component])
+            {
+                if (auto tx = lookup(hash))
+                {
+                    txs.emplace_back(tx->getEnvelope());
+                }
+                else
+                {
+                    res.mMissingTxs.emplace_back(hash);
+                }
+            }
+            ++component;
+        });
+    if (!ok || !fits || component != compact.mTxHashes.size())
+    {
+        res.mMissingTxs.clear();
+        return res;
+    }
+    if (!res.mMissingTxs.empty())
+    {
+        return res;
+    }
+
+    auto frame = TxSetXDRFrame::makeFromWire(txSet);
+    if (frame->getContentsHash() == compact.mTxSetHash)
+    {
+        res.mTxSet = frame;
+    }
+    return res;
+}
+}
@@ -0,0 +1,55 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "herder/TxSetFrame.h"
+#include "overlay/StellarXDR.h"
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace stellar
+{
+
+// A compact form of a generalized tx set, for peers that already hold most
+// of its transactions in their queues because of flooding: the tx set with
+// its transactions stripped (the "skeleton") and the full hash of each
+// transaction, component by component. A few hundred bytes per transaction
+// become 32.
+//
+// Full hashes rather than short IDs are used as they are what the
+// transaction queues are keyed by, and what pull mode demands (FLOOD_DEMAND)
+// take, so the transactions that are missing locally can be fetched with the
+// existing demand path.
+struct CompactTxSet
+{
+    Hash mTxSetHash;
+    GeneralizedTransactionSet mSkeleton;
+    // One list per component, phase by phase
+    std::vector<std::vector<Hash>> mTxHashes;
+};
+
+// Returns nullopt if `txSet` isn't a structurally valid v1 generalized tx set
+std::optional<CompactTxSet>
+makeCompactTxSet(GeneralizedTransactionSet const& txSet);
+
+struct CompactTxSetReconstruction
+{
+    // Set when all the transactions were found and they make up the tx set
+    // with the expected hash
+    TxSetXDRFrameConstPtr mTxSet;
+    // Hashes of the transactions that were not found, in tx set order
+    std::vector<Hash> mMissingTxs;
+};
+
+using TxLookup = std::function<TransactionFrameBaseConstPtr(Hash const&)>;
+
+// Rebuilds the tx set of `compact` from the transactions `lookup` finds by
+// full hash. Returns neither a tx set nor missing transactions if the
+// rebuilt tx set doesn't have the expected hash, i.e. `compact` was bad.
+CompactTxSetReconstruction reconstructTxSet(CompactTxSet const& compact,
+                                            TxLookup const& lookup);
+}
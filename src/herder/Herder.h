@@ -8,10 +8,12 @@
 #include "Upgrades.h"
 #include "herder/QuorumTracker.h"
 #include "herder/TransactionQueue.h"
+#include "herder/TxValidationService.h"
 #include "lib/json/json-forwards.h"
 #include "overlay/Peer.h"
 #include "overlay/StellarXDR.h"
 #include "scp/SCP.h"
+#include "util/MemoryFootprint.h"
 #include "util/Timer.h"
 #include <functional>
 #include <memory>
@@ -114,6 +116,11 @@ class Herder
     // restores Herder's state from disk
     virtual void start() = 0;
 
+    // Reads the persisted SCP state and tx sets and starts decoding them on a
+    // background thread, for start() to pick up. Lets startup decode them
+    // while the bucket list is being restored.
+    virtual void prefetchPersistedState() = 0;
+
     virtual void lastClosedLedgerIncreased(bool latest) = 0;
 
     // Setup Herder's state to fully participate in consensus
@@ -126,8 +133,15 @@ class Herder
     // We are learning about a new transaction.
     virtual TransactionQueue::AddResult
     recvTransaction(TransactionFrameBasePtr tx, bool submittedFromSelf) = 0;
+    // Same as recvTransaction on each of `txs` in order, but loads the
+    // accounts they are validated against in one batch first.
+    virtual std::vector<TransactionQueue::AddResult>
+    recvTransactions(std::vector<TransactionFrameBasePtr> const& txs,
+                     bool submittedFromSelf) = 0;
     virtual void peerDoesntHave(stellar::MessageType type,
                                 uint256 const& itemID, Peer::pointer peer) = 0;
+    // Validates batches of transactions off the main thread
+    virtual TxValidationService& getTxValidationService() = 0;
     virtual TxSetXDRFrameConstPtr getTxSet(Hash const& hash) = 0;
     virtual SCPQuorumSetPtr getQSet(Hash const& qSetHash) = 0;
 
@@ -207,6 +221,7 @@ class Herder
     }
 
     virtual Json::Value getJsonInfo(size_t limit, bool fullKeys = false) = 0;
+    virtual Json::Value getJsonSCPTimingInfo(size_t limit) = 0;
     virtual Json::Value getJsonQuorumInfo(NodeID const& id, bool summary,
                                           bool fullKeys, uint64 index) = 0;
     virtual Json::Value getJsonTransitiveQuorumInfo(NodeID const& id,
@@ -214,9 +229,17 @@ class Herder
                                                     bool fullKeys) = 0;
     virtual QuorumTracker::QuorumMap const&
     getCurrentlyTrackedQuorum() const = 0;
+    // Thread-safe. Distances of the nodes of the tracked quorum as of its last
+    // change, or nullptr before the quorum is first tracked.
+    virtual std::shared_ptr<QuorumTracker::NodeDistances const>
+    getQuorumDistances() const = 0;
 
     virtual size_t getMaxQueueSizeOps() const = 0;
     virtual size_t getMaxQueueSizeSorobanOps() const = 0;
+
+    // Adds the estimated memory held by the transaction queues, pending
+    // envelopes and fetched tx sets to `footprint`
+    virtual void addMemoryFootprint(MemoryFootprint& footprint) const = 0;
     virtual void maybeHandleUpgrade() = 0;
 
     virtual bool isBannedTx(Hash const& hash) const = 0;
@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "herder/HerderImpl.h"
+#include "crypto/BLAKE2.h"
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
 #include "crypto/SHA.h"
@@ -36,12 +37,13 @@
 #include "medida/counter.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
+#include "medida/timer.h"
 #include "util/Decoder.h"
+#include "util/Tracing.h"
 #include "util/XDRStream.h"
 #include "xdr/Stellar-internal.h"
 #include "xdrpp/marshal.h"
 #include "xdrpp/types.h"
-#include <Tracy.hpp>
 
 #include "util/GlobalChecks.h"
 #include <algorithm>
@@ -75,6 +77,12 @@ HerderImpl::SCPMetrics::SCPMetrics(Application& app)
           {"scp", "envelope", "validsig"}, "envelope"))
     , mEnvelopeInvalidSig(app.getMetrics().NewMeter(
           {"scp", "envelope", "invalidsig"}, "envelope"))
+    , mEnvelopeDuplicate(app.getMetrics().NewMeter(
+          {"scp", "envelope", "duplicate"}, "envelope"))
+    , mQuorumIntersectionCheck(
+          app.getMetrics().NewTimer({"scp", "qic", "check"}))
+    , mQuorumIntersectionCachedSearch(app.getMetrics().NewMeter(
+          {"scp", "qic", "cached-search"}, "search"))
 {
 }
 
@@ -82,6 +90,7 @@ HerderImpl::HerderImpl(Application& app)
     : mTransactionQueue(app, TRANSACTION_QUEUE_TIMEOUT_LEDGERS,
                         TRANSACTION_QUEUE_BAN_LEDGERS,
                         TRANSACTION_QUEUE_SIZE_MULTIPLIER)
+    , mTxValidationService(app)
     , mPendingEnvelopes(app, *this)
     , mHerderSCPDriver(app, *this, mUpgrades, mPendingEnvelopes)
     , mLastSlotSaved(0)
@@ -255,6 +264,9 @@ HerderImpl::newSlotExternalized(bool synchronous, StellarValue const& value)
     {
         eraseBelow(minSlotToRemember);
     }
+    // Slots remembered for peers only keep what is needed to respond to them,
+    // except for the one that just externalized
+    getSCP().compactSlots(trackingConsensusLedgerIndex());
     mPendingEnvelopes.forceRebuildQuorum();
 
     // Process new ready messages for the next slot
@@ -275,6 +287,10 @@ HerderImpl::shutdown()
                    "Shutdown interrupting quorum transitive closure analysis.");
         mLastQuorumMapIntersectionState.mInterruptFlag = true;
     }
+    if (mApp.getConfig().PERSIST_TRANSACTION_QUEUE)
+    {
+        persistTransactionQueues();
+    }
     mTransactionQueue.shutdown();
     if (mSorobanTransactionQueue)
     {
@@ -590,6 +606,43 @@ HerderImpl::recvTransaction(TransactionFrameBasePtr tx, bool submittedFromSelf)
     return result;
 }
 
+std::vector<TransactionQueue::AddResult>
+HerderImpl::recvTransactions(std::vector<TransactionFrameBasePtr> const& txs,
+                             bool submittedFromSelf)
+{
+    ZoneScoped;
+    // Every tryAdd loads the source and fee source accounts of its tx: bulk
+    // load those of the whole batch into the LedgerTxnRoot cache first.
+    if (mApp.getConfig().PREFETCH_BATCH_SIZE > 0)
+    {
+        UnorderedSet<LedgerKey> keys;
+        for (auto const& tx : txs)
+        {
+            tx->insertKeysForFeeProcessing(keys);
+        }
+        mApp.getLedgerTxnRoot().prefetch(keys);
+    }
+
+    // Large batches are validated on the worker pool first, after which
+    // admission only confirms that the accounts they were validated against
+    // did not change in between (see TxValidationService)
+    if (txs.size() >= TxValidationService::MIN_TXS_FOR_PARALLEL_VALIDATION)
+    {
+        auto const& lcl = mLedgerManager.getLastClosedLedgerHeader().header;
+        mTxValidationService.validate(
+            txs, 0,
+            getUpperBoundCloseTimeOffset(mApp, lcl.scpValue.closeTime));
+    }
+
+    std::vector<TransactionQueue::AddResult> results;
+    results.reserve(txs.size());
+    for (auto const& tx : txs)
+    {
+        results.emplace_back(recvTransaction(tx, submittedFromSelf));
+    }
+    return results;
+}
+
 bool
 HerderImpl::checkCloseTime(SCPEnvelope const& envelope, bool enforceRecent)
 {
@@ -780,6 +833,18 @@ HerderImpl::recvSCPEnvelope(SCPEnvelope const& envelope)
         return Herder::ENVELOPE_STATUS_DISCARDED;
     }
 
+    // Envelopes are flooded, so the same one usually arrives from many peers.
+    // Copies of an envelope that was already processed skip the signature
+    // check and the rest of the pipeline.
+    auto envelopeHash = xdrBlake2(envelope);
+    if (mPendingEnvelopes.isProcessed(envelope, envelopeHash))
+    {
+        mSCPMetrics.mEnvelopeDuplicate.Mark();
+        std::string txt("PROCESSED - duplicate");
+        ZoneText(txt.c_str(), txt.size());
+        return Herder::ENVELOPE_STATUS_PROCESSED;
+    }
+
     // **** from this point, we have to check signatures
     if (!verifyEnvelope(envelope))
     {
@@ -1212,6 +1277,12 @@ HerderImpl::peerDoesntHave(MessageType type, uint256 const& itemID,
     mPendingEnvelopes.peerDoesntHave(type, itemID, peer);
 }
 
+TxValidationService&
+HerderImpl::getTxValidationService()
+{
+    return mTxValidationService;
+}
+
 TxSetXDRFrameConstPtr
 HerderImpl::getTxSet(Hash const& hash)
 {
@@ -1350,9 +1421,22 @@ HerderImpl::triggerNextLedger(uint32_t ledgerSeqToTrigger,
     TxSetPhaseTransactions invalidTxPhases;
     invalidTxPhases.resize(txPhases.size());
 
-    auto [proposedSet, applicableProposedSet] =
-        makeTxSetFromTransactions(txPhases, mApp, lowerBoundCloseTimeOffset,
-                                  upperBoundCloseTimeOffset, invalidTxPhases);
+    // Most of the queue has already been validated against this ledger when
+    // the transactions were received or when the queue was updated after the
+    // ledger closed: only the fees of those transactions need checking again.
+    std::vector<UnorderedSet<Hash>> validatedTxPhases;
+    validatedTxPhases.emplace_back(mTransactionQueue.getValidatedTxHashes(
+        lcl.header, upperBoundCloseTimeOffset));
+    if (txPhases.size() > static_cast<size_t>(TxSetPhase::SOROBAN))
+    {
+        validatedTxPhases.emplace_back(
+            mSorobanTransactionQueue->getValidatedTxHashes(
+                lcl.header, upperBoundCloseTimeOffset));
+    }
+
+    auto [proposedSet, applicableProposedSet] = makeTxSetFromTransactions(
+        txPhases, mApp, lowerBoundCloseTimeOffset, upperBoundCloseTimeOffset,
+        invalidTxPhases, &validatedTxPhases);
 
     if (protocolVersionStartsFrom(lcl.header.ledgerVersion,
                                   SOROBAN_PROTOCOL_VERSION))
@@ -1365,6 +1449,9 @@ HerderImpl::triggerNextLedger(uint32_t ledgerSeqToTrigger,
     mTransactionQueue.ban(
         invalidTxPhases[static_cast<size_t>(TxSetPhase::CLASSIC)]);
 
+    // Warm up the entries our proposal reads before it is nominated
+    mApp.getLedgerManager().prefetchTxSetAsync(*applicableProposedSet);
+
     auto txSetHash = proposedSet->getContentsHash();
 
     // use the slot index from ledger manager here as our vote is based off
@@ -1513,6 +1600,12 @@ HerderImpl::getJsonInfo(size_t limit, bool fullKeys)
     return ret;
 }
 
+Json::Value
+HerderImpl::getJsonSCPTimingInfo(size_t limit)
+{
+    return mHerderSCPDriver.getSCPTimingJson(limit);
+}
+
 Json::Value
 HerderImpl::getJsonTransitiveQuorumIntersectionInfo(bool fullKeys) const
 {
@@ -1718,6 +1811,12 @@ HerderImpl::getCurrentlyTrackedQuorum() const
     return mPendingEnvelopes.getCurrentlyTrackedQuorum();
 }
 
+std::shared_ptr<QuorumTracker::NodeDistances const>
+HerderImpl::getQuorumDistances() const
+{
+    return mPendingEnvelopes.getQuorumDistances();
+}
+
 static Hash
 getQmapHash(QuorumTracker::QuorumMap const& qmap)
 {
@@ -1790,16 +1889,21 @@ HerderImpl::checkAndMaybeReanalyzeQuorumMap()
         releaseAssert(threadIsMain());
         auto seed = gRandomEngine();
         auto qic = QuorumIntersectionChecker::create(
-            qmap, cfg, mLastQuorumMapIntersectionState.mInterruptFlag, seed);
+            qmap, cfg, mLastQuorumMapIntersectionState.mInterruptFlag, seed,
+            /*quiet=*/false, mLastQuorumMapIntersectionState.mSearchCache);
         auto ledger = trackingConsensusLedgerIndex();
         auto nNodes = qmap.size();
         auto& hState = mLastQuorumMapIntersectionState;
         auto& app = mApp;
-        auto worker = [curr, ledger, nNodes, qic, qmap, cfg, seed, &app,
-                       &hState] {
+        auto& metrics = mSCPMetrics;
+        auto searchCache = hState.mSearchCache;
+        auto worker = [curr, ledger, nNodes, qic, qmap, cfg, seed, searchCache,
+                       &app, &hState, &metrics] {
             try
             {
                 ZoneScoped;
+                auto timer = metrics.mQuorumIntersectionCheck.TimeScope();
+                auto hitsBefore = searchCache->getHits();
                 bool ok = qic->networkEnjoysQuorumIntersection();
                 auto split = qic->getPotentialSplit();
                 std::set<std::set<PublicKey>> critical;
@@ -1809,9 +1913,12 @@ HerderImpl::checkAndMaybeReanalyzeQuorumMap()
                     // intersecting; if not intersecting we should finish ASAP
                     // and raise an alarm.
                     critical = QuorumIntersectionChecker::
-                        getIntersectionCriticalGroups(
-                            qmap, cfg, hState.mInterruptFlag, seed);
+                        getIntersectionCriticalGroups(qmap, cfg,
+                                                      hState.mInterruptFlag,
+                                                      seed, searchCache);
                 }
+                metrics.mQuorumIntersectionCachedSearch.Mark(
+                    searchCache->getHits() - hitsBefore);
                 app.postOnMainThread(
                     [ok, curr, ledger, nNodes, split, critical, &hState] {
                         hState.mRecalculating = false;
@@ -1842,7 +1949,8 @@ HerderImpl::checkAndMaybeReanalyzeQuorumMap()
                     "QuorumIntersectionChecker interrupted");
             }
         };
-        mApp.postOnBackgroundThread(worker, "QuorumIntersectionChecker");
+        mApp.postOnBackgroundThread(worker, "QuorumIntersectionChecker",
+                                    BackgroundPriority::LOW);
     }
 }
 
@@ -1896,10 +2004,8 @@ HerderImpl::persistSCPState(uint64 slot)
     std::unordered_map<Hash, std::string> txSetsToPersist;
     for (auto it : txSets)
     {
-        StoredTransactionSet tempTxSet;
-        it.second->storeXDR(tempTxSet);
         txSetsToPersist.emplace(
-            it.first, decoder::encode_b64(xdr::xdr_to_opaque(tempTxSet)));
+            it.first, decoder::encode_b64(it.second->encodeStored()));
     }
 
     latestSCPData = xdr::xdr_to_opaque(scpState);
@@ -1910,17 +2016,13 @@ HerderImpl::persistSCPState(uint64 slot)
                                                    txSetsToPersist);
 }
 
-void
-HerderImpl::restoreSCPState()
+HerderImpl::DecodedPersistedState
+HerderImpl::decodePersistedState(std::vector<std::string> const& txSets,
+                                 std::vector<std::string> const& scpStates)
 {
     ZoneScoped;
-
-    // Delete any old tx sets
-    purgeOldPersistedTxSets();
-
-    // Load all known tx sets
-    auto latestTxSets = mApp.getPersistentState().getTxSetsForAllSlots();
-    for (auto const& txSet : latestTxSets)
+    DecodedPersistedState decoded;
+    for (auto const& txSet : txSets)
     {
         try
         {
@@ -1929,10 +2031,8 @@ HerderImpl::restoreSCPState()
 
             StoredTransactionSet storedSet;
             xdr::xdr_from_opaque(buffer, storedSet);
-            TxSetXDRFrameConstPtr cur =
-                TxSetXDRFrame::makeFromStoredTxSet(storedSet);
-            Hash h = cur->getContentsHash();
-            mPendingEnvelopes.addTxSet(h, 0, cur);
+            decoded.mTxSets.emplace_back(
+                TxSetXDRFrame::makeFromStoredTxSet(storedSet));
         }
         catch (std::exception& e)
         {
@@ -1946,10 +2046,7 @@ HerderImpl::restoreSCPState()
         }
     }
 
-    // load saved state from database
-    auto latest64 = mApp.getPersistentState().getSCPStateAllSlots();
-
-    for (auto const& state : latest64)
+    for (auto const& state : scpStates)
     {
         try
         {
@@ -1958,6 +2055,75 @@ HerderImpl::restoreSCPState()
 
             PersistedSCPState scpState;
             xdr::xdr_from_opaque(buffer, scpState);
+            decoded.mSCPStates.emplace_back(std::move(scpState));
+        }
+        catch (std::exception& e)
+        {
+            // we may have exceptions when upgrading the protocol
+            // this should be the only time we get exceptions decoding old
+            // messages.
+            CLOG_INFO(Herder,
+                      "Error while restoring old scp messages, "
+                      "proceeding without them : {}",
+                      e.what());
+        }
+    }
+    return decoded;
+}
+
+void
+HerderImpl::prefetchPersistedState()
+{
+    ZoneScoped;
+
+    // Delete any old tx sets
+    purgeOldPersistedTxSets();
+
+    // The database is only read on the main thread
+    auto& ps = mApp.getPersistentState();
+    using task_t = std::packaged_task<DecodedPersistedState()>;
+    auto task = std::make_shared<task_t>(
+        [txSets = ps.getTxSetsForAllSlots(),
+         scpStates = ps.getSCPStateAllSlots()]() {
+            return decodePersistedState(txSets, scpStates);
+        });
+    mPrefetchedPersistedState = task->get_future();
+    mApp.postOnBackgroundThread([task]() { (*task)(); },
+                                "HerderImpl: decode persisted state");
+}
+
+void
+HerderImpl::restoreSCPState()
+{
+    ZoneScoped;
+
+    DecodedPersistedState decoded;
+    if (mPrefetchedPersistedState.valid())
+    {
+        decoded = mPrefetchedPersistedState.get();
+    }
+    else
+    {
+        // Delete any old tx sets
+        purgeOldPersistedTxSets();
+
+        auto& ps = mApp.getPersistentState();
+        decoded = decodePersistedState(ps.getTxSetsForAllSlots(),
+                                       ps.getSCPStateAllSlots());
+    }
+
+    // Load all known tx sets
+    for (auto const& cur : decoded.mTxSets)
+    {
+        Hash h = cur->getContentsHash();
+        mPendingEnvelopes.addTxSet(h, 0, cur);
+    }
+
+    // load saved state from database
+    for (auto const& scpState : decoded.mSCPStates)
+    {
+        try
+        {
             for (auto const& qset : scpState.v1().quorumSets)
             {
                 Hash hash = xdrSha256(qset);
@@ -2018,6 +2184,88 @@ HerderImpl::restoreUpgrades()
     }
 }
 
+void
+HerderImpl::persistTransactionQueues()
+{
+    ZoneScoped;
+    auto txs = mTransactionQueue.getQueuedTransactions();
+    if (mSorobanTransactionQueue)
+    {
+        auto sorobanTxs = mSorobanTransactionQueue->getQueuedTransactions();
+        txs.insert(txs.end(), sorobanTxs.begin(), sorobanTxs.end());
+    }
+
+    Json::Value root(Json::arrayValue);
+    for (auto const& tx : txs)
+    {
+        Json::Value entry;
+        entry["tx"] = decoder::encode_b64(
+            xdr::xdr_to_opaque(tx.mTx->getEnvelope()));
+        entry["self"] = tx.mSubmittedFromSelf;
+        root.append(entry);
+    }
+    mApp.getPersistentState().setState(PersistentState::kTransactionQueue,
+                                       Json::FastWriter().write(root));
+    CLOG_INFO(Herder, "Saved {} queued transactions", txs.size());
+}
+
+void
+HerderImpl::restoreTransactionQueues()
+{
+    ZoneScoped;
+    auto& ps = mApp.getPersistentState();
+    auto s = ps.getState(PersistentState::kTransactionQueue);
+    if (s.empty())
+    {
+        return;
+    }
+    // Saved transactions are only submitted once
+    ps.setState(PersistentState::kTransactionQueue, "");
+
+    Json::Value root;
+    if (!Json::Reader().parse(s, root) || !root.isArray())
+    {
+        CLOG_WARNING(Herder, "Ignoring invalid saved transaction queue");
+        return;
+    }
+
+    // Oldest first, split by origin as recvTransactions takes one
+    std::vector<TransactionFrameBasePtr> txs[2];
+    for (auto const& entry : root)
+    {
+        try
+        {
+            TransactionEnvelope env;
+            std::vector<uint8_t> buffer;
+            decoder::decode_b64(entry["tx"].asString(), buffer);
+            xdr::xdr_from_opaque(buffer, env);
+            txs[entry["self"].asBool()].emplace_back(
+                TransactionFrameBase::makeTransactionFromWire(
+                    mApp.getNetworkID(), env));
+        }
+        catch (std::exception& e)
+        {
+            CLOG_INFO(Herder, "Error while restoring saved transaction: {}",
+                      e.what());
+        }
+    }
+
+    size_t pending = 0;
+    size_t total = 0;
+    for (bool self : {false, true})
+    {
+        for (auto res : recvTransactions(txs[self], self))
+        {
+            if (res == TransactionQueue::AddResult::ADD_STATUS_PENDING)
+            {
+                ++pending;
+            }
+        }
+        total += txs[self].size();
+    }
+    CLOG_INFO(Herder, "Restored {} of {} saved transactions", pending, total);
+}
+
 void
 HerderImpl::maybeHandleUpgrade()
 {
@@ -2136,6 +2384,10 @@ HerderImpl::start()
     }
 
     restoreUpgrades();
+    if (mApp.getConfig().PERSIST_TRANSACTION_QUEUE)
+    {
+        restoreTransactionQueues();
+    }
     startTxSetGCTimer();
 }
 
@@ -2228,11 +2480,14 @@ HerderImpl::updateTransactionQueue(TxSetXDRFrameConstPtr externalizedTxSet)
 
         auto txs = queue.getTransactions(lhhe.header);
 
+        auto upperBoundCloseTimeOffset =
+            getUpperBoundCloseTimeOffset(mApp, lhhe.header.scpValue.closeTime);
         auto invalidTxs = TxSetUtils::getInvalidTxList(
-            txs, mApp, 0,
-            getUpperBoundCloseTimeOffset(mApp, lhhe.header.scpValue.closeTime),
-            false);
+            txs, mApp, 0, upperBoundCloseTimeOffset, false);
         queue.ban(invalidTxs);
+        // Banned transactions have left the queue, so this only marks the
+        // valid ones
+        queue.markValidated(txs, lhhe.header, upperBoundCloseTimeOffset);
 
         queue.rebroadcast();
     };
@@ -2368,6 +2623,20 @@ HerderImpl::getMaxQueueSizeSorobanOps() const
                : 0;
 }
 
+void
+HerderImpl::addMemoryFootprint(MemoryFootprint& footprint) const
+{
+    size_t txQueueBytes = mTransactionQueue.getEstimatedBytes();
+    if (mSorobanTransactionQueue)
+    {
+        txQueueBytes += mSorobanTransactionQueue->getEstimatedBytes();
+    }
+    footprint["herder.tx-queue"] = txQueueBytes;
+    footprint["herder.scp-slots"] =
+        mHerderSCPDriver.getSCP().getEstimatedBytes();
+    mPendingEnvelopes.addMemoryFootprint(footprint);
+}
+
 bool
 HerderImpl::isBannedTx(Hash const& hash) const
 {
@@ -7,12 +7,14 @@
 #include "herder/Herder.h"
 #include "herder/HerderSCPDriver.h"
 #include "herder/PendingEnvelopes.h"
+#include "herder/QuorumIntersectionChecker.h"
 #include "herder/TransactionQueue.h"
 #include "herder/Upgrades.h"
 #include "util/Timer.h"
 #include "util/UnorderedMap.h"
 #include "util/XDROperators.h"
 #include <deque>
+#include <future>
 #include <memory>
 #include <vector>
 
@@ -72,6 +74,7 @@ class HerderImpl : public Herder
     void shutdown() override;
 
     void start() override;
+    void prefetchPersistedState() override;
 
     void lastClosedLedgerIncreased(bool latest) override;
 
@@ -97,6 +100,9 @@ class HerderImpl : public Herder
     TransactionQueue::AddResult
     recvTransaction(TransactionFrameBasePtr tx,
                     bool submittedFromSelf) override;
+    std::vector<TransactionQueue::AddResult>
+    recvTransactions(std::vector<TransactionFrameBasePtr> const& txs,
+                     bool submittedFromSelf) override;
 
     EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope) override;
 #ifdef BUILD_TESTS
@@ -139,6 +145,7 @@ class HerderImpl : public Herder
     bool recvTxSet(Hash const& hash, TxSetXDRFrameConstPtr txset) override;
     void peerDoesntHave(MessageType type, uint256 const& itemID,
                         Peer::pointer peer) override;
+    TxValidationService& getTxValidationService() override;
     TxSetXDRFrameConstPtr getTxSet(Hash const& hash) override;
     SCPQuorumSetPtr getQSet(Hash const& qSetHash) override;
 
@@ -175,6 +182,7 @@ class HerderImpl : public Herder
     bool resolveNodeID(std::string const& s, PublicKey& retKey) override;
 
     Json::Value getJsonInfo(size_t limit, bool fullKeys = false) override;
+    Json::Value getJsonSCPTimingInfo(size_t limit) override;
     Json::Value getJsonQuorumInfo(NodeID const& id, bool summary, bool fullKeys,
                                   uint64 index) override;
     Json::Value getJsonTransitiveQuorumIntersectionInfo(bool fullKeys) const;
@@ -182,6 +190,8 @@ class HerderImpl : public Herder
                                                     bool summary,
                                                     bool fullKeys) override;
     QuorumTracker::QuorumMap const& getCurrentlyTrackedQuorum() const override;
+    std::shared_ptr<QuorumTracker::NodeDistances const>
+    getQuorumDistances() const override;
 
     virtual StellarValue
     makeStellarValue(Hash const& txSetHash, uint64_t closeTime,
@@ -209,6 +219,7 @@ class HerderImpl : public Herder
 
     size_t getMaxQueueSizeOps() const override;
     size_t getMaxQueueSizeSorobanOps() const override;
+    void addMemoryFootprint(MemoryFootprint& footprint) const override;
     void maybeHandleUpgrade() override;
 
     bool isBannedTx(Hash const& hash) const override;
@@ -240,6 +251,7 @@ class HerderImpl : public Herder
 
     ClassicTransactionQueue mTransactionQueue;
     std::unique_ptr<SorobanTransactionQueue> mSorobanTransactionQueue;
+    TxValidationService mTxValidationService;
 
     void updateTransactionQueue(TxSetXDRFrameConstPtr txSet);
     void maybeSetupSorobanQueue(uint32_t protocolVersion);
@@ -268,10 +280,28 @@ class HerderImpl : public Herder
     // restores SCP state based on the last messages saved on disk
     void restoreSCPState();
 
+    // Persisted tx sets and SCP state, decoded. Entries that fail to decode
+    // are logged and left out.
+    struct DecodedPersistedState
+    {
+        std::vector<TxSetXDRFrameConstPtr> mTxSets;
+        std::vector<PersistedSCPState> mSCPStates;
+    };
+    static DecodedPersistedState
+    decodePersistedState(std::vector<std::string> const& txSets,
+                         std::vector<std::string> const& scpStates);
+    // Set by prefetchPersistedState until restoreSCPState uses it
+    std::future<DecodedPersistedState> mPrefetchedPersistedState;
+
     // saves upgrade parameters
     void persistUpgrades();
     void restoreUpgrades();
 
+    // saves the queued transactions on shutdown and submits them again on
+    // startup, with PERSIST_TRANSACTION_QUEUE
+    void persistTransactionQueues();
+    void restoreTransactionQueues();
+
     // called every time we get ledger externalized
     // ensures that if we don't hear from the network, we throw the herder into
     // indeterminate mode
@@ -301,6 +331,14 @@ class HerderImpl : public Herder
         medida::Meter& mEnvelopeValidSig;
         medida::Meter& mEnvelopeInvalidSig;
 
+        // copies of envelopes that were already processed
+        medida::Meter& mEnvelopeDuplicate;
+
+        // quorum intersection checks, and the searches they skipped thanks
+        // to the results of previous checks
+        medida::Timer& mQuorumIntersectionCheck;
+        medida::Meter& mQuorumIntersectionCachedSearch;
+
         SCPMetrics(Application& app);
     };
 
@@ -328,6 +366,15 @@ class HerderImpl : public Herder
             mPotentialSplit{};
         std::set<std::set<PublicKey>> mIntersectionCriticalNodes{};
 
+        // Search results of previous checks, reused by the next ones when
+        // their quorum sets changed outside of the SCC that is searched. Each
+        // check looks up one entry, plus one per intersection-critical group
+        // candidate.
+        static constexpr size_t SEARCH_CACHE_SIZE = 1000;
+        QuorumIntersectionChecker::SearchCachePtr mSearchCache{
+            std::make_shared<QuorumIntersectionChecker::SearchCache>(
+                SEARCH_CACHE_SIZE)};
+
         bool
         hasAnyResults() const
         {
@@ -47,7 +47,7 @@ class HerderPersistence
                                         Hash const& qSetHash);
 
     static void dropAll(Database& db);
-    static void deleteOldEntries(Database& db, uint32_t ledgerSeq,
+    static void deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
                                  uint32_t count);
     static void deleteNewerEntries(Database& db, uint32_t ledgerSeq);
 
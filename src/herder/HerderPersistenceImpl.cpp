@@ -10,8 +10,8 @@
 #include "main/Application.h"
 #include "scp/Slot.h"
 #include "util/Decoder.h"
+#include "util/Tracing.h"
 #include "util/XDRStream.h"
-#include <Tracy.hpp>
 
 #include <optional>
 #include <soci.h>
@@ -108,7 +108,10 @@ HerderPersistenceImpl::saveSCPHistory(uint32_t seq,
         }
     }
 
-    // save quorum information
+    // save quorum information, replacing the rows of every node in qmap with
+    // one bulk delete and one bulk insert
+    std::vector<std::string> qNodeIDs;
+    std::vector<std::string> qSetHashes;
     for (auto const& p : qmap)
     {
         auto const& nodeID = p.first;
@@ -120,35 +123,34 @@ HerderPersistenceImpl::saveSCPHistory(uint32_t seq,
         auto qSetH = xdrSha256(*(p.second.mQuorumSet));
         usedQSets.insert(std::make_pair(qSetH, p.second.mQuorumSet));
 
-        std::string nodeIDStrKey = KeyUtils::toStrKey(nodeID);
-        std::string qSetHHex(binToHex(qSetH));
+        qNodeIDs.emplace_back(KeyUtils::toStrKey(nodeID));
+        qSetHashes.emplace_back(binToHex(qSetH));
+    }
+    if (!qNodeIDs.empty())
+    {
+        auto prepDel = db.getPreparedStatement(
+            "DELETE FROM quoruminfo WHERE nodeid = :id");
+        auto& stDel = prepDel.statement();
+        stDel.exchange(soci::use(qNodeIDs, "id"));
+        stDel.define_and_bind();
+        {
+            ZoneNamedN(deleteQsetZone, "delete quoruminfo", true);
+            stDel.execute(true);
+        }
 
-        auto prep = db.getPreparedStatement(
-            "UPDATE quoruminfo SET qsethash = :h WHERE nodeid = :id");
-        auto& st = prep.statement();
-        st.exchange(soci::use(qSetHHex));
-        st.exchange(soci::use(nodeIDStrKey));
-        st.define_and_bind();
+        auto prepIns = db.getPreparedStatement(
+            "INSERT INTO quoruminfo (nodeid, qsethash) VALUES (:id, :h)");
+        auto& stIns = prepIns.statement();
+        stIns.exchange(soci::use(qNodeIDs, "id"));
+        stIns.exchange(soci::use(qSetHashes, "h"));
+        stIns.define_and_bind();
         {
-            ZoneNamedN(updateQsetZone, "update quoruminfo", true);
-            st.execute(true);
+            ZoneNamedN(insertQsetZone, "insert quoruminfo", true);
+            stIns.execute(true);
         }
-        if (st.get_affected_rows() != 1)
+        if (stIns.get_affected_rows() != qNodeIDs.size())
         {
-            auto prepI = db.getPreparedStatement(
-                "INSERT INTO quoruminfo (nodeid, qsethash) VALUES (:id, :h)");
-            auto& stI = prepI.statement();
-            stI.exchange(soci::use(nodeIDStrKey));
-            stI.exchange(soci::use(qSetHHex));
-            stI.define_and_bind();
-            {
-                ZoneNamedN(insertQsetZone, "insert quoruminfo", true);
-                stI.execute(true);
-            }
-            if (stI.get_affected_rows() != 1)
-            {
-                throw std::runtime_error("Could not update data in SQL");
-            }
+            throw std::runtime_error("Could not update data in SQL");
         }
     }
     // save quorum sets
@@ -407,13 +409,13 @@ HerderPersistence::createQuorumTrackingTable(soci::session& sess)
 }
 
 void
-HerderPersistence::deleteOldEntries(Database& db, uint32_t ledgerSeq,
+HerderPersistence::deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
                                     uint32_t count)
 {
     ZoneScoped;
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "scphistory", "ledgerseq");
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
+    DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count, "scphistory",
+                                          "ledgerseq");
+    DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
                                           "scpquorums", "lastledgerseq");
 }
 
@@ -20,10 +20,10 @@
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "xdr/Stellar-SCP.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include "xdr/Stellar-ledger.h"
-#include <Tracy.hpp>
 #include <algorithm>
 #include <fmt/format.h>
 #include <medida/metrics_registry.h>
@@ -64,6 +64,14 @@ HerderSCPDriver::SCPMetrics::SCPMetrics(Application& app)
           {"scp", "timing", "first-to-self-externalize-lag"}))
     , mSelfToOthersExternalizeLag(app.getMetrics().NewTimer(
           {"scp", "timing", "self-to-others-externalize-lag"}))
+    , mTimerDrivenAdvance(
+          app.getMetrics().NewMeter({"scp", "advance", "timer"}, "advance"))
+    , mMessageDrivenAdvance(
+          app.getMetrics().NewMeter({"scp", "advance", "message"}, "advance"))
+    , mSpeculativeHit(
+          app.getMetrics().NewMeter({"scp", "speculative", "hit"}, "ledger"))
+    , mSpeculativeMiss(
+          app.getMetrics().NewMeter({"scp", "speculative", "miss"}, "ledger"))
 {
 }
 
@@ -84,6 +92,12 @@ HerderSCPDriver::HerderSCPDriver(Application& app, HerderImpl& herder,
           {"scp", "timeout", "prepare"})}
     , mUniqueValues{mApp.getMetrics().NewHistogram(
           {"scp", "slot", "values-referenced"})}
+    , mNominateToConfirmPrepare{mApp.getMetrics().NewHistogram(
+          {"scp", "phase", "confirm-prepare"})}
+    , mNominateToAcceptCommit{mApp.getMetrics().NewHistogram(
+          {"scp", "phase", "accept-commit"})}
+    , mNominateToExternalize{mApp.getMetrics().NewHistogram(
+          {"scp", "phase", "externalize"})}
     , mLedgerSeqNominating(0)
     , mTxSetValidCache(TXSETVALID_CACHE_SIZE)
 {
@@ -506,7 +520,9 @@ HerderSCPDriver::timerCallbackWrapper(uint64_t slotIndex, int timerID,
             }
         }
 
+        mInTimerCallback = true;
         cb();
+        mInTimerCallback = false;
     }
 }
 
@@ -734,6 +750,10 @@ HerderSCPDriver::combineCandidates(uint64_t slotIndex,
                 "No highest candidate transaction set found");
         }
         comp = *highest;
+
+        // The composite tx set is the one most likely to externalize, so
+        // start loading the entries it reads while balloting runs
+        mApp.getLedgerManager().prefetchTxSetAsync(*highestApplicableTxSet);
     }
     comp.upgrades.clear();
     for (auto const& upgrade : upgrades)
@@ -827,6 +847,19 @@ HerderSCPDriver::valueExternalized(uint64_t slotIndex, Value const& value)
 
         recordSCPExecutionMetrics(slotIndex);
 
+        if (mSpeculativeTxSet && mSpeculativeTxSet->first == slotIndex)
+        {
+            if (mSpeculativeTxSet->second == b.txSetHash)
+            {
+                mSCPMetrics.mSpeculativeHit.Mark();
+            }
+            else
+            {
+                mSCPMetrics.mSpeculativeMiss.Mark();
+            }
+            mSpeculativeTxSet.reset();
+        }
+
         mHerder.valueExternalized(slotIndex, b, isLatestSlot);
 
         // update externalize time so that we don't include the time spent in
@@ -924,17 +957,121 @@ void
 HerderSCPDriver::acceptedBallotPrepared(uint64_t slotIndex,
                                         SCPBallot const& ballot)
 {
+    recordBallotAdvance(slotIndex);
 }
 
 void
 HerderSCPDriver::confirmedBallotPrepared(uint64_t slotIndex,
                                          SCPBallot const& ballot)
 {
+    auto& timing = recordBallotAdvance(slotIndex);
+    if (!timing.mConfirmPrepared)
+    {
+        timing.mConfirmPrepared = mApp.getClock().now();
+    }
+    if (mApp.getConfig().EXPERIMENTAL_SPECULATIVE_TX_SET_PREPARATION)
+    {
+        prepareTxSetSpeculatively(slotIndex, ballot.value);
+    }
+}
+
+void
+HerderSCPDriver::prepareTxSetSpeculatively(uint64_t slotIndex,
+                                           Value const& value)
+{
+    ZoneScoped;
+    StellarValue sv;
+    if (!toStellarValue(value, sv) ||
+        (mSpeculativeTxSet && mSpeculativeTxSet->first == slotIndex &&
+         mSpeculativeTxSet->second == sv.txSetHash))
+    {
+        return;
+    }
+    // Only the next ledger can be prepared against the current state
+    auto const& lcl = mLedgerManager.getLastClosedLedgerHeader();
+    auto txSet = mPendingEnvelopes.getTxSet(sv.txSetHash);
+    if (slotIndex != lcl.header.ledgerSeq + 1 || !txSet ||
+        txSet->previousLedgerHash() != lcl.hash)
+    {
+        return;
+    }
+    auto applicableTxSet = txSet->prepareForApply(mApp);
+    if (!applicableTxSet)
+    {
+        return;
+    }
+
+    CLOG_DEBUG(Herder, "Speculatively preparing tx set {} for slot {}",
+               hexAbbrev(sv.txSetHash), slotIndex);
+    mSpeculativeTxSet = std::make_pair(slotIndex, sv.txSetHash);
+    mLedgerManager.prefetchTxSetAsync(*applicableTxSet);
+    mLedgerManager.verifyTxSetSignaturesAsync(*applicableTxSet);
 }
 
 void
 HerderSCPDriver::acceptedCommit(uint64_t slotIndex, SCPBallot const& ballot)
 {
+    auto& timing = recordBallotAdvance(slotIndex);
+    if (!timing.mAcceptCommit)
+    {
+        timing.mAcceptCommit = mApp.getClock().now();
+    }
+}
+
+HerderSCPDriver::SCPTiming&
+HerderSCPDriver::recordBallotAdvance(uint64_t slotIndex)
+{
+    auto& timing = mSCPExecutionTimes[slotIndex];
+    if (mInTimerCallback)
+    {
+        ++timing.mTimerDrivenAdvanceCount;
+        mSCPMetrics.mTimerDrivenAdvance.Mark();
+    }
+    else
+    {
+        ++timing.mMessageDrivenAdvanceCount;
+        mSCPMetrics.mMessageDrivenAdvance.Mark();
+    }
+    return timing;
+}
+
+Json::Value
+HerderSCPDriver::getSCPTimingJson(size_t limit) const
+{
+    Json::Value ret(Json::objectValue);
+    for (auto it = mSCPExecutionTimes.rbegin();
+         it != mSCPExecutionTimes.rend() && limit > 0; ++it, --limit)
+    {
+        auto const& timing = it->second;
+        auto& slot = ret[std::to_string(it->first)];
+
+        // Phases are reported in milliseconds since nomination started, so
+        // only on nodes that nominate.
+        auto phase = [&](char const* name,
+                         std::optional<VirtualClock::time_point> const& t) {
+            if (timing.mNominationStart && t)
+            {
+                slot[name] = static_cast<Json::Int64>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        *t - *timing.mNominationStart)
+                        .count());
+            }
+        };
+        phase("prepare_start_ms", timing.mPrepareStart);
+        phase("confirm_prepare_ms", timing.mConfirmPrepared);
+        phase("accept_commit_ms", timing.mAcceptCommit);
+        phase("externalize_ms", timing.mExternalize);
+
+        slot["nomination_timeouts"] =
+            static_cast<Json::Int64>(timing.mNominationTimeoutCount);
+        slot["prepare_timeouts"] =
+            static_cast<Json::Int64>(timing.mPrepareTimeoutCount);
+        slot["timer_driven_advances"] =
+            static_cast<Json::Int64>(timing.mTimerDrivenAdvanceCount);
+        slot["message_driven_advances"] =
+            static_cast<Json::Int64>(timing.mMessageDrivenAdvanceCount);
+    }
+    return ret;
 }
 
 std::optional<VirtualClock::time_point>
@@ -1038,10 +1175,12 @@ HerderSCPDriver::recordSCPExternalizeEvent(uint64_t slotIndex, NodeID const& id,
                             std::chrono::nanoseconds::zero(), slotIndex);
             mApp.getOverlayManager().getSurveyManager().modifyNodeData(
                 [&](CollectingNodeData& nd) {
-                    nd.mSCPFirstToSelfLatencyMsHistogram.Update(
+                    auto ms =
                         std::chrono::duration_cast<std::chrono::milliseconds>(
                             now - *timing.mFirstExternalize)
-                            .count());
+                            .count();
+                    nd.mSCPFirstToSelfLatencyMsHistogram.Update(ms);
+                    nd.mHistograms.mSCPFirstToSelfLatencyMs.update(ms);
                 });
         }
         if (!timing.mSelfExternalize || forceUpdateSelf)
@@ -1117,7 +1256,8 @@ HerderSCPDriver::recordSCPExecutionMetrics(uint64_t slotIndex)
         return;
     }
 
-    auto& SCPTiming = SCPTimingIt->second;
+    auto& SCPTiming = recordBallotAdvance(slotIndex);
+    SCPTiming.mExternalize = externalizeStart;
 
     mNominateTimeout.Update(SCPTiming.mNominationTimeoutCount);
     mPrepareTimeout.Update(SCPTiming.mPrepareTimeoutCount);
@@ -1154,6 +1294,31 @@ HerderSCPDriver::recordSCPExecutionMetrics(uint64_t slotIndex)
                         mSCPMetrics.mPrepareToExternalize, "Prepare", threshold,
                         slotIndex);
     }
+
+    // Compute time from nomination to each ballot protocol phase, subject to
+    // the same threshold
+    if (SCPTiming.mNominationStart)
+    {
+        auto recordPhase =
+            [&](std::optional<VirtualClock::time_point> const& end,
+                medida::Histogram& histogram) {
+                if (!end)
+                {
+                    return;
+                }
+                auto delta = *end - *SCPTiming.mNominationStart;
+                if (delta >= threshold)
+                {
+                    histogram.Update(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(
+                            delta)
+                            .count());
+                }
+            };
+        recordPhase(SCPTiming.mConfirmPrepared, mNominateToConfirmPrepare);
+        recordPhase(SCPTiming.mAcceptCommit, mNominateToAcceptCommit);
+        recordPhase(SCPTiming.mExternalize, mNominateToExternalize);
+    }
 }
 
 void
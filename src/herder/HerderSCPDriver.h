@@ -48,12 +48,20 @@ class HerderSCPDriver : public SCPDriver
     {
         return mSCP;
     }
+    SCP const&
+    getSCP() const
+    {
+        return mSCP;
+    }
 
     void recordSCPExecutionMetrics(uint64_t slotIndex);
     void recordSCPEvent(uint64_t slotIndex, bool isNomination);
     void recordSCPExternalizeEvent(uint64_t slotIndex, NodeID const& id,
                                    bool forceUpdateSelf);
 
+    // Phase timings of the last `limit` slots
+    Json::Value getSCPTimingJson(size_t limit) const;
+
     // envelope handling
     SCPEnvelopeWrapperPtr wrapEnvelope(SCPEnvelope const& envelope) override;
     void signEnvelope(SCPEnvelope& envelope) override;
@@ -155,6 +163,15 @@ class HerderSCPDriver : public SCPDriver
         medida::Timer& mFirstToSelfExternalizeLag;
         medida::Timer& mSelfToOthersExternalizeLag;
 
+        // Ballot protocol advances caused by a timeout or by messages
+        medida::Meter& mTimerDrivenAdvance;
+        medida::Meter& mMessageDrivenAdvance;
+
+        // Externalized tx sets that were, or were not, the one prepared
+        // speculatively
+        medida::Meter& mSpeculativeHit;
+        medida::Meter& mSpeculativeMiss;
+
         SCPMetrics(Application& app);
     };
 
@@ -166,6 +183,11 @@ class HerderSCPDriver : public SCPDriver
     medida::Histogram& mPrepareTimeout;
     // Unique values referenced per ledger
     medida::Histogram& mUniqueValues;
+    // Time from nomination to the first confirmed prepared ballot, the first
+    // accepted commit and externalize per ledger, in milliseconds
+    medida::Histogram& mNominateToConfirmPrepare;
+    medida::Histogram& mNominateToAcceptCommit;
+    medida::Histogram& mNominateToExternalize;
 
     // Externalize lag tracking for nodes in qset
     UnorderedMap<NodeID, medida::Timer> mQSetLag;
@@ -180,6 +202,17 @@ class HerderSCPDriver : public SCPDriver
         // Prepare timeouts before externalize
         int64_t mPrepareTimeoutCount{0};
 
+        // ballot protocol phases
+        std::optional<VirtualClock::time_point> mConfirmPrepared;
+        std::optional<VirtualClock::time_point> mAcceptCommit;
+        std::optional<VirtualClock::time_point> mExternalize;
+
+        // Ballot protocol advances (accept prepared, confirm prepared, accept
+        // commit, externalize) that happened while handling a timeout or
+        // while handling messages
+        int64_t mTimerDrivenAdvanceCount{0};
+        int64_t mMessageDrivenAdvanceCount{0};
+
         // externalize timing information
         std::optional<VirtualClock::time_point> mFirstExternalize;
         std::optional<VirtualClock::time_point> mSelfExternalize;
@@ -188,8 +221,20 @@ class HerderSCPDriver : public SCPDriver
     // Map of time points for each slot to measure key protocol metrics:
     // * nomination to first prepare
     // * first prepare to externalize
+    // * nomination to each ballot protocol phase
     std::map<uint64_t, SCPTiming> mSCPExecutionTimes;
 
+    // Set while SCP handles a timeout
+    bool mInTimerCallback{false};
+
+    // Slot and tx set hash last prepared by prepareTxSetSpeculatively
+    std::optional<std::pair<uint64_t, Hash>> mSpeculativeTxSet;
+
+    // With EXPERIMENTAL_SPECULATIVE_TX_SET_PREPARATION, starts loading the
+    // entries and verifying the signatures of the tx set of a confirmed
+    // prepared ballot, which most likely externalizes
+    void prepareTxSetSpeculatively(uint64_t slotIndex, Value const& value);
+
     uint32_t mLedgerSeqNominating;
     ValueWrapperPtr mCurrentValue;
 
@@ -220,6 +265,8 @@ class HerderSCPDriver : public SCPDriver
     void timerCallbackWrapper(uint64_t slotIndex, int timerID,
                               std::function<void()> cb);
 
+    SCPTiming& recordBallotAdvance(uint64_t slotIndex);
+
     void recordLogTiming(VirtualClock::time_point start,
                          VirtualClock::time_point end, medida::Timer& timer,
                          std::string const& logStr,
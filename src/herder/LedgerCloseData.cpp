@@ -17,11 +17,14 @@ namespace stellar
 LedgerCloseData::LedgerCloseData(uint32_t ledgerSeq,
                                  TxSetXDRFrameConstPtr txSet,
                                  StellarValue const& v,
-                                 std::optional<Hash> const& expectedLedgerHash)
+                                 std::optional<Hash> const& expectedLedgerHash,
+                                 std::optional<TransactionResultSet> const&
+                                     expectedResults)
     : mLedgerSeq(ledgerSeq)
     , mTxSet(txSet)
     , mValue(v)
     , mExpectedLedgerHash(expectedLedgerHash)
+    , mExpectedResults(expectedResults)
 {
     releaseAssert(txSet->getContentsHash() == mValue.txSetHash);
 }
@@ -1,10 +1,12 @@
 ﻿#include "PendingEnvelopes.h"
+#include "crypto/BLAKE2.h"
 #include "crypto/Hex.h"
 #include "crypto/SHA.h"
 #include "herder/HerderImpl.h"
 #include "herder/HerderPersistence.h"
 #include "herder/HerderUtils.h"
 #include "herder/TxSetFrame.h"
+#include "ledger/LedgerManager.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "overlay/OverlayManager.h"
@@ -12,14 +14,15 @@
 #include "scp/Slot.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/UnorderedSet.h"
-#include <Tracy.hpp>
 #include <xdrpp/marshal.h>
 
 using namespace std;
 
 #define QSET_CACHE_SIZE 10000
 #define TXSET_CACHE_SIZE 10000
+#define PROCESSED_ENVELOPE_CACHE_SIZE 10000
 
 namespace stellar
 {
@@ -34,6 +37,7 @@ PendingEnvelopes::PendingEnvelopes(Application& app, HerderImpl& herder)
                                 Hash hash) { peer->sendGetQuorumSet(hash); })
     , mTxSetCache(TXSET_CACHE_SIZE)
     , mValueSizeCache(TXSET_CACHE_SIZE + QSET_CACHE_SIZE)
+    , mProcessedEnvelopeHashes(PROCESSED_ENVELOPE_CACHE_SIZE)
     , mRebuildQuorum(true)
     , mQuorumTracker(mApp.getConfig().NODE_SEED.getPublicKey())
     , mProcessedCount(
@@ -233,8 +237,15 @@ PendingEnvelopes::addTxSet(Hash const& hash, uint64 lastSeenSlotIndex,
     ZoneScoped;
     CLOG_TRACE(Herder, "Add TxSet {}", hexAbbrev(hash));
 
-    putTxSet(hash, lastSeenSlotIndex, txset);
+    auto res = putTxSet(hash, lastSeenSlotIndex, txset);
     mTxSetFetcher.recv(hash, mFetchTxSetTimer);
+
+    // Tx sets for ledgers already closed won't be needed for apply
+    if (mApp.getConfig().EXPERIMENTAL_BACKGROUND_TX_SET_PREPARATION &&
+        lastSeenSlotIndex > mApp.getLedgerManager().getLastClosedLedgerNum())
+    {
+        TxSetXDRFrame::prepareForApplyInBackground(res, mApp);
+    }
 }
 
 bool
@@ -253,6 +264,30 @@ PendingEnvelopes::recvTxSet(Hash const& hash, TxSetXDRFrameConstPtr txset)
     return true;
 }
 
+bool
+PendingEnvelopes::recvCompactTxSet(CompactTxSet const& compact,
+                                   std::vector<Hash>& missingTxs)
+{
+    ZoneScoped;
+    missingTxs.clear();
+    if (mTxSetFetcher.getLastSeenSlotIndex(compact.mTxSetHash) == 0)
+    {
+        return false;
+    }
+
+    auto res = reconstructTxSet(compact, [&](Hash const& hash) {
+        return mApp.getHerder().getTx(hash);
+    });
+    if (!res.mTxSet)
+    {
+        CLOG_TRACE(Herder, "Compact TxSet {}: {} txs missing",
+                   hexAbbrev(compact.mTxSetHash), res.mMissingTxs.size());
+        missingTxs = std::move(res.mMissingTxs);
+        return false;
+    }
+    return recvTxSet(compact.mTxSetHash, res.mTxSet);
+}
+
 bool
 PendingEnvelopes::isNodeDefinitelyInQuorum(NodeID const& node)
 {
@@ -334,6 +369,8 @@ PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope)
             else
             {
                 // we already have this one
+                mProcessedEnvelopeHashes.put(xdrBlake2(envelope),
+                                              envelope.statement.slotIndex);
                 return Herder::ENVELOPE_STATUS_PROCESSED;
             }
         }
@@ -357,6 +394,8 @@ PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope)
             // move the item from fetching to processed
             processed.emplace(envelope);
             fetching.erase(fetchIt);
+            mProcessedEnvelopeHashes.put(xdrBlake2(envelope),
+                                         envelope.statement.slotIndex);
 
             envelopeReady(envelope);
             updateMetrics();
@@ -380,6 +419,16 @@ PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope)
     }
 }
 
+bool
+PendingEnvelopes::isProcessed(SCPEnvelope const& envelope,
+                              Hash const& envelopeHash)
+{
+    // Same as the first check of recvSCPEnvelope, as a node may have left the
+    // quorum since
+    return mProcessedEnvelopeHashes.exists(envelopeHash, false) &&
+           isNodeDefinitelyInQuorum(envelope.statement.nodeID);
+}
+
 void
 PendingEnvelopes::discardSCPEnvelope(SCPEnvelope const& envelope)
 {
@@ -394,6 +443,8 @@ PendingEnvelopes::discardSCPEnvelope(SCPEnvelope const& envelope)
             return;
         }
 
+        mProcessedEnvelopeHashes.erase(xdrBlake2(envelope));
+
         envs.mFetchingEnvelopes.erase(envelope);
 
         stopFetch(envelope);
@@ -687,6 +738,9 @@ PendingEnvelopes::eraseBelow(uint64 slotIndex, uint64 slotToKeep)
     mTxSetCache.erase_if([&](TxSetFramCacheItem const& i) {
         return i.first != 0 && i.first < slotIndex && i.first != slotToKeep;
     });
+    mProcessedEnvelopeHashes.erase_if([&](uint64 const& envSlot) {
+        return envSlot < slotIndex && envSlot != slotToKeep;
+    });
 
     cleanKnownData();
     updateMetrics();
@@ -754,6 +808,42 @@ PendingEnvelopes::getQSet(Hash const& hash)
     return qset;
 }
 
+void
+PendingEnvelopes::addMemoryFootprint(MemoryFootprint& footprint) const
+{
+    // Only the slots that are still remembered are kept, so this visits a
+    // handful of slots
+    size_t envelopes = 0;
+    for (auto const& kv : mEnvelopes)
+    {
+        auto const& se = kv.second;
+        envelopes += se.mDiscardedEnvelopes.size() +
+                     se.mProcessedEnvelopes.size() +
+                     se.mFetchingEnvelopes.size() + se.mReadyEnvelopes.size();
+    }
+    footprint["herder.pending-envelopes"] =
+        mEnvelopes.size() * nodeBytes<decltype(mEnvelopes)::value_type>() +
+        envelopes * nodeBytes<SCPEnvelope>() + mQsetCache.estimatedBytes() +
+        mProcessedEnvelopeHashes.estimatedBytes();
+
+    // Tx sets keep both their XDR and its encoding
+    size_t txSetBytes = 0;
+    for (auto const& kv : mKnownTxSets)
+    {
+        if (auto txSet = kv.second.lock())
+        {
+            txSetBytes += 2 * txSet->encodedSize();
+        }
+    }
+    footprint["herder.tx-sets"] =
+        txSetBytes +
+        mKnownTxSets.size() * nodeBytes<decltype(mKnownTxSets)::value_type>() +
+        mTxSetCache.estimatedBytes() + mValueSizeCache.estimatedBytes();
+
+    footprint["herder.item-fetchers"] = mTxSetFetcher.getEstimatedBytes() +
+                                        mQuorumSetFetcher.getEstimatedBytes();
+}
+
 Json::Value
 PendingEnvelopes::getJsonInfo(size_t limit)
 {
@@ -823,6 +913,27 @@ PendingEnvelopes::rebuildQuorumTrackerState()
         }
         return res;
     });
+    publishQuorumDistances();
+}
+
+void
+PendingEnvelopes::publishQuorumDistances()
+{
+    ZoneScoped;
+    auto distances = std::make_shared<QuorumTracker::NodeDistances>();
+    for (auto const& [id, info] : mQuorumTracker.getQuorum())
+    {
+        distances->emplace(id, info.mDistance);
+    }
+    std::lock_guard<std::mutex> guard(mQuorumDistancesMutex);
+    mQuorumDistances = std::move(distances);
+}
+
+std::shared_ptr<QuorumTracker::NodeDistances const>
+PendingEnvelopes::getQuorumDistances() const
+{
+    std::lock_guard<std::mutex> guard(mQuorumDistancesMutex);
+    return mQuorumDistances;
 }
 
 QuorumTracker::QuorumMap const&
@@ -840,11 +951,18 @@ PendingEnvelopes::envelopeProcessed(SCPEnvelope const& env)
     auto h = Slot::getCompanionQuorumSetHashFromStatement(st);
 
     SCPQuorumSetPtr qset = getQSet(h);
+    auto quorumSize = mQuorumTracker.getQuorum().size();
     if (!mQuorumTracker.expand(id, qset))
     {
         // could not expand quorum, queue up a rebuild
         mRebuildQuorum = true;
     }
+    else if (mQuorumTracker.getQuorum().size() != quorumSize)
+    {
+        // Expanding may also shorten distances beyond the local quorum set,
+        // which readers don't tell apart, so only new nodes are published
+        publishQuorumDistances();
+    }
 }
 
 UnorderedMap<NodeID, size_t>
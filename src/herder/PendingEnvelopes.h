@@ -1,14 +1,17 @@
 ﻿#pragma once
 #include "crypto/SecretKey.h"
+#include "herder/CompactTxSet.h"
 #include "herder/Herder.h"
 #include "herder/QuorumTracker.h"
 #include "lib/json/json.h"
 #include "overlay/ItemFetcher.h"
+#include "util/MemoryFootprint.h"
 #include "util/RandomEvictionCache.h"
 #include <autocheck/function.hpp>
 #include <chrono>
 #include <map>
 #include <medida/medida.h>
+#include <mutex>
 #include <optional>
 #include <queue>
 #include <set>
@@ -69,8 +72,16 @@ class PendingEnvelopes
     // keep track of txset/qset hash -> size pairs for quick access
     RandomEvictionCache<Hash, size_t> mValueSizeCache;
 
+    // hashes of recently processed envelopes, so that the copies flooded by
+    // other peers can be recognized without being verified again (envelope
+    // hash -> slot index)
+    RandomEvictionCache<Hash, uint64> mProcessedEnvelopeHashes;
+
     bool mRebuildQuorum;
     QuorumTracker mQuorumTracker;
+    // Copy of the distances of mQuorumTracker for other threads
+    mutable std::mutex mQuorumDistancesMutex;
+    std::shared_ptr<QuorumTracker::NodeDistances const> mQuorumDistances;
 
     medida::Counter& mProcessedCount;
     medida::Counter& mDiscardedCount;
@@ -88,6 +99,8 @@ class PendingEnvelopes
 
     void updateMetrics();
 
+    void publishQuorumDistances();
+
     void envelopeReady(SCPEnvelope const& envelope);
     void discardSCPEnvelope(SCPEnvelope const& envelope);
     bool isFullyFetched(SCPEnvelope const& envelope);
@@ -131,6 +144,13 @@ class PendingEnvelopes
      */
     Herder::EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope);
 
+    /**
+     * Check whether @p envelope, with hash @p envelopeHash, is known to have
+     * been processed (and not discarded since). recvSCPEnvelope would return
+     * ENVELOPE_STATUS_PROCESSED for such an envelope.
+     */
+    bool isProcessed(SCPEnvelope const& envelope, Hash const& envelopeHash);
+
     /**
      * Add @p qset identified by @p hash to local cache. Notifies
      * @see ItemFetcher about that event - it may cause calls to Herder's
@@ -174,6 +194,16 @@ class PendingEnvelopes
      */
     bool recvTxSet(Hash const& hash, TxSetXDRFrameConstPtr txset);
 
+    /**
+     * Rebuilds the tx set announced by @p compact from the transactions in
+     * the queues. If it was requested and could be rebuilt, it is handled as
+     * by @see recvTxSet and this returns true. Otherwise @p missingTxs is
+     * filled with the transactions to demand from peers before trying again
+     * (empty if @p compact was bad or the tx set isn't wanted).
+     */
+    bool recvCompactTxSet(CompactTxSet const& compact,
+                          std::vector<Hash>& missingTxs);
+
     void peerDoesntHave(MessageType type, Hash const& itemID,
                         Peer::pointer peer);
 
@@ -189,6 +219,10 @@ class PendingEnvelopes
 
     Json::Value getJsonInfo(size_t limit);
 
+    // Adds the estimated memory held by envelopes, fetched tx sets and the
+    // item fetchers to `footprint`
+    void addMemoryFootprint(MemoryFootprint& footprint) const;
+
     TxSetXDRFrameConstPtr getTxSet(Hash const& hash);
     SCPQuorumSetPtr getQSet(Hash const& hash);
 
@@ -198,6 +232,9 @@ class PendingEnvelopes
 
     void rebuildQuorumTrackerState();
     QuorumTracker::QuorumMap const& getCurrentlyTrackedQuorum() const;
+    // Thread-safe
+    std::shared_ptr<QuorumTracker::NodeDistances const>
+    getQuorumDistances() const;
 
     // updates internal state when an envelope was successfully processed
     void envelopeProcessed(SCPEnvelope const& env);
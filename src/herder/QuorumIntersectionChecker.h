@@ -5,8 +5,10 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "herder/QuorumTracker.h"
+#include "util/RandomEvictionCache.h"
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
 
 namespace stellar
@@ -20,27 +22,58 @@ class QuorumIntersectionChecker
     using QuorumSetMap =
         stellar::UnorderedMap<stellar::NodeID, stellar::SCPQuorumSetPtr>;
 
+    // Outcome of the exhaustive search for disjoint quorums within the SCC
+    // that contains quorums.
+    struct SearchResult
+    {
+        bool mFoundDisjoint{false};
+        std::pair<std::vector<NodeID>, std::vector<NodeID>> mPotentialSplit;
+    };
+
+    // The search only depends on the quorum sets of the nodes of the SCC it
+    // scans, so its results can be reused by later checks of networks that
+    // differ only outside of that SCC. A SearchCache keeps such results, keyed
+    // by a hash of the scanned quorum sets, and can be shared by successive
+    // checks.
+    class SearchCache
+    {
+        std::mutex mMutex;
+        RandomEvictionCache<Hash, SearchResult> mResults;
+        uint64_t mHits{0};
+
+      public:
+        explicit SearchCache(size_t maxSize);
+        std::optional<SearchResult> get(Hash const& sccHash);
+        void put(Hash const& sccHash, SearchResult const& result);
+        uint64_t getHits();
+    };
+    using SearchCachePtr = std::shared_ptr<SearchCache>;
+
     static std::shared_ptr<QuorumIntersectionChecker>
     create(QuorumTracker::QuorumMap const& qmap,
            std::optional<stellar::Config> const& cfg,
            std::atomic<bool>& interruptFlag,
-           stellar_default_random_engine::result_type seed, bool quiet = false);
+           stellar_default_random_engine::result_type seed, bool quiet = false,
+           SearchCachePtr searchCache = nullptr);
 
     static std::shared_ptr<QuorumIntersectionChecker>
     create(QuorumSetMap const& qmap, std::optional<stellar::Config> const& cfg,
            std::atomic<bool>& interruptFlag,
-           stellar_default_random_engine::result_type seed, bool quiet = false);
+           stellar_default_random_engine::result_type seed, bool quiet = false,
+           SearchCachePtr searchCache = nullptr);
 
     static std::set<std::set<NodeID>> getIntersectionCriticalGroups(
         QuorumTracker::QuorumMap const& qmap,
         std::optional<stellar::Config> const& cfg,
         std::atomic<bool>& interruptFlag,
-        stellar_default_random_engine::result_type seed);
+        stellar_default_random_engine::result_type seed,
+        SearchCachePtr searchCache = nullptr);
 
     static std::set<std::set<NodeID>> getIntersectionCriticalGroups(
         QuorumSetMap const& qmap, std::optional<stellar::Config> const& cfg,
         std::atomic<bool>& interruptFlag,
-        stellar_default_random_engine::result_type seed);
+        stellar_default_random_engine::result_type seed,
+        SearchCachePtr searchCache = nullptr);
 
     virtual ~QuorumIntersectionChecker(){};
     virtual bool networkEnjoysQuorumIntersection() const = 0;
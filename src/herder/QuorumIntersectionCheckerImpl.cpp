@@ -5,9 +5,16 @@
 #include "QuorumIntersectionCheckerImpl.h"
 #include "QuorumIntersectionChecker.h"
 
+#include "crypto/SHA.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
+#include <algorithm>
+#include <exception>
+#include <map>
+#include <memory>
+#include <thread>
+#include <xdrpp/marshal.h>
 
 namespace
 {
@@ -112,12 +119,15 @@ MinQuorumEnumerator::maxCommit() const
 
 MinQuorumEnumerator::MinQuorumEnumerator(
     BitSet const& committed, BitSet const& remaining, BitSet const& scanSCC,
-    QuorumIntersectionCheckerImpl const& qic)
+    QuorumIntersectionCheckerImpl const& qic,
+    std::vector<std::pair<BitSet, BitSet>>* frontier, size_t frontierDepth)
     : mCommitted(committed)
     , mRemaining(remaining)
     , mPerimeter(committed | remaining)
     , mScanSCC(scanSCC)
     , mQic(qic)
+    , mFrontier(frontier)
+    , mFrontierDepth(frontierDepth)
 {
 }
 
@@ -128,6 +138,11 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
     {
         throw QuorumIntersectionChecker::InterruptedException();
     }
+    if (mQic.mSearchDone && *mQic.mSearchDone)
+    {
+        // Another thread has already found disjoint quorums.
+        return false;
+    }
 
     mQic.mStats.mCallsStarted++;
 
@@ -236,6 +251,14 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
         return false;
     }
 
+    // When expanding the frontier for a parallel search, this is as deep as
+    // we go: leave the subproblem to be enumerated later.
+    if (mFrontier && mFrontierDepth == 0)
+    {
+        mFrontier->emplace_back(mCommitted, mRemaining);
+        return false;
+    }
+
     // Phase two: recurse into subproblems.
     size_t split = pickSplitNode(mQic.mRand);
     if (mQic.mLogTrace)
@@ -243,8 +266,10 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
         CLOG_TRACE(SCP, "recursing into subproblems, split={}", split);
     }
     mRemaining.unset(split);
+    size_t childFrontierDepth = mFrontier ? mFrontierDepth - 1 : 0;
     MinQuorumEnumerator childExcludingSplit(mCommitted, mRemaining, mScanSCC,
-                                            mQic);
+                                            mQic, mFrontier,
+                                            childFrontierDepth);
     mQic.mStats.mFirstRecursionsTaken++;
     if (childExcludingSplit.anyMinQuorumHasDisjointQuorum())
     {
@@ -257,7 +282,8 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
     }
     mCommitted.set(split);
     MinQuorumEnumerator childIncludingSplit(mCommitted, mRemaining, mScanSCC,
-                                            mQic);
+                                            mQic, mFrontier,
+                                            childFrontierDepth);
     mQic.mStats.mSecondRecursionsTaken++;
     return childIncludingSplit.anyMinQuorumHasDisjointQuorum();
 }
@@ -269,12 +295,20 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
 QuorumIntersectionCheckerImpl::QuorumIntersectionCheckerImpl(
     QuorumIntersectionChecker::QuorumSetMap const& qmap,
     std::optional<Config> const& cfg, std::atomic<bool>& interruptFlag,
-    stellar_default_random_engine::result_type seed, bool quiet)
+    stellar_default_random_engine::result_type seed, bool quiet,
+    QuorumIntersectionChecker::SearchCachePtr searchCache)
     : mCfg(cfg)
     , mLogTrace(Logging::logTrace("SCP"))
     , mQuiet(quiet)
+    , mSearchCache(searchCache)
+    , mNumThreads(cfg ? std::max<size_t>(
+                            static_cast<size_t>(
+                                cfg->QUORUM_INTERSECTION_CHECKER_THREADS),
+                            1)
+                      : 1)
     , mTSC()
     , mInterruptFlag(interruptFlag)
+    , mSearchDone(nullptr)
     , mCachedQuorums(MAX_CACHED_QUORUMS_SIZE)
     , mRand(seed)
 {
@@ -284,6 +318,26 @@ QuorumIntersectionCheckerImpl::QuorumIntersectionCheckerImpl(
     buildSCCs();
 }
 
+QuorumIntersectionCheckerImpl::QuorumIntersectionCheckerImpl(
+    QuorumIntersectionCheckerImpl const& parent,
+    std::atomic<bool> const& searchDone,
+    stellar_default_random_engine::result_type seed)
+    : mCfg(parent.mCfg)
+    , mLogTrace(parent.mLogTrace)
+    , mQuiet(parent.mQuiet)
+    , mBitNumPubKeys(parent.mBitNumPubKeys)
+    , mPubKeyBitNums(parent.mPubKeyBitNums)
+    , mGraph(parent.mGraph)
+    , mNumThreads(1)
+    , mTSC()
+    , mInterruptFlag(parent.mInterruptFlag)
+    , mSearchDone(&searchDone)
+    , mCachedQuorums(MAX_CACHED_QUORUMS_SIZE)
+    , mRand(seed)
+{
+    mStats.mTotalNodes = parent.mStats.mTotalNodes;
+}
+
 std::pair<std::vector<NodeID>, std::vector<NodeID>>
 QuorumIntersectionCheckerImpl::getPotentialSplit() const
 {
@@ -310,6 +364,26 @@ QuorumIntersectionCheckerImpl::Stats::log() const
     CLOG_DEBUG(SCP, "Detailed exit stats:");
     CLOG_DEBUG(SCP, "[X1:{}, X2.1:{}, X2.2:{}, X3.1:{}, X3.2:{}]", mEarlyExit1s,
                mEarlyExit21s, mEarlyExit22s, mEarlyExit31s, mEarlyExit32s);
+    if (mSubproblems != 0)
+    {
+        CLOG_DEBUG(SCP, "Parallel subproblems: {}", mSubproblems);
+    }
+}
+
+void
+QuorumIntersectionCheckerImpl::Stats::add(Stats const& other)
+{
+    mCallsStarted += other.mCallsStarted;
+    mFirstRecursionsTaken += other.mFirstRecursionsTaken;
+    mSecondRecursionsTaken += other.mSecondRecursionsTaken;
+    mMaxQuorumsSeen += other.mMaxQuorumsSeen;
+    mMinQuorumsSeen += other.mMinQuorumsSeen;
+    mTerminations += other.mTerminations;
+    mEarlyExit1s += other.mEarlyExit1s;
+    mEarlyExit21s += other.mEarlyExit21s;
+    mEarlyExit22s += other.mEarlyExit22s;
+    mEarlyExit31s += other.mEarlyExit31s;
+    mEarlyExit32s += other.mEarlyExit32s;
 }
 
 // This function is the innermost call in the checker and must be as fast
@@ -604,6 +678,7 @@ QuorumIntersectionCheckerImpl::buildGraph(
 {
     mPubKeyBitNums.clear();
     mBitNumPubKeys.clear();
+    mBitNumQSets.clear();
     mGraph.clear();
 
     for (auto const& pair : qmap)
@@ -613,6 +688,7 @@ QuorumIntersectionCheckerImpl::buildGraph(
             size_t n = mBitNumPubKeys.size();
             mPubKeyBitNums.insert(std::make_pair(pair.first, n));
             mBitNumPubKeys.emplace_back(pair.first);
+            mBitNumQSets.emplace_back(pair.second);
         }
         else
         {
@@ -655,6 +731,136 @@ QuorumIntersectionCheckerImpl::nodeName(size_t node) const
     return toShortString(mCfg, mBitNumPubKeys.at(node));
 }
 
+Hash
+QuorumIntersectionCheckerImpl::hashQSets(BitSet const& nodes) const
+{
+    // Node numbers depend on the iteration order of the qmap, so hash in
+    // order of public keys to get the same hash for the same qsets.
+    std::map<NodeID, size_t> sorted;
+    for (size_t i = 0; nodes.nextSet(i); ++i)
+    {
+        sorted.emplace(mBitNumPubKeys.at(i), i);
+    }
+    SHA256 hasher;
+    for (auto const& pair : sorted)
+    {
+        hasher.add(xdr::xdr_to_opaque(pair.first));
+        hasher.add(xdr::xdr_to_opaque(*mBitNumQSets.at(pair.second)));
+    }
+    return hasher.finish();
+}
+
+bool
+QuorumIntersectionCheckerImpl::anyMinQuorumHasDisjointQuorum(
+    BitSet const& scanSCC) const
+{
+    if (mNumThreads > 1)
+    {
+        return anyMinQuorumHasDisjointQuorumParallel(scanSCC);
+    }
+    BitSet committed;
+    BitSet remaining = scanSCC;
+    MinQuorumEnumerator mqe(committed, remaining, scanSCC, *this);
+    return mqe.anyMinQuorumHasDisjointQuorum();
+}
+
+bool
+QuorumIntersectionCheckerImpl::anyMinQuorumHasDisjointQuorumParallel(
+    BitSet const& scanSCC) const
+{
+    // Expand the top of the recursion into a frontier of subproblems, enough
+    // to give each thread several of them as their sizes vary a lot.
+    size_t frontierDepth = 0;
+    while ((size_t(1) << frontierDepth) < mNumThreads * 8)
+    {
+        ++frontierDepth;
+    }
+    std::vector<std::pair<BitSet, BitSet>> frontier;
+    BitSet committed;
+    BitSet remaining = scanSCC;
+    MinQuorumEnumerator root(committed, remaining, scanSCC, *this, &frontier,
+                             frontierDepth);
+    if (root.anyMinQuorumHasDisjointQuorum())
+    {
+        return true;
+    }
+    if (frontier.empty())
+    {
+        return false;
+    }
+    mStats.mSubproblems = frontier.size();
+
+    // Subproblems are claimed one at a time by this thread and the helper
+    // threads, each using its own copy of the checker.
+    size_t const numWorkers = std::min(mNumThreads, frontier.size());
+    std::atomic<bool> searchDone{false};
+    std::atomic<size_t> nextToClaim{0};
+    std::atomic<size_t> numDone{0};
+    std::vector<std::unique_ptr<QuorumIntersectionCheckerImpl>> workers;
+    std::vector<std::exception_ptr> errors(numWorkers);
+    std::vector<uint8_t> found(numWorkers, 0);
+    for (size_t w = 0; w < numWorkers; ++w)
+    {
+        workers.emplace_back(std::make_unique<QuorumIntersectionCheckerImpl>(
+            *this, searchDone, mRand()));
+    }
+
+    auto work = [&](size_t w) {
+        try
+        {
+            for (size_t i = nextToClaim++; i < frontier.size() && !searchDone;
+                 i = nextToClaim++)
+            {
+                MinQuorumEnumerator mqe(frontier[i].first, frontier[i].second,
+                                        scanSCC, *workers[w]);
+                if (mqe.anyMinQuorumHasDisjointQuorum())
+                {
+                    found[w] = 1;
+                    searchDone = true;
+                }
+                size_t done = ++numDone;
+                CLOG_DEBUG(SCP, "Enumerated {}/{} subproblems", done,
+                           frontier.size());
+            }
+        }
+        catch (...)
+        {
+            errors[w] = std::current_exception();
+            searchDone = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t w = 1; w < numWorkers; ++w)
+    {
+        threads.emplace_back(work, w);
+    }
+    work(0);
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    for (auto const& e : errors)
+    {
+        if (e)
+        {
+            std::rethrow_exception(e);
+        }
+    }
+
+    bool foundDisjoint = false;
+    for (size_t w = 0; w < numWorkers; ++w)
+    {
+        mStats.add(workers[w]->mStats);
+        if (found[w] && !foundDisjoint)
+        {
+            mPotentialSplit = workers[w]->mPotentialSplit;
+            foundDisjoint = true;
+        }
+    }
+    return foundDisjoint;
+}
+
 bool
 QuorumIntersectionCheckerImpl::networkEnjoysQuorumIntersection() const
 {
@@ -721,14 +927,41 @@ QuorumIntersectionCheckerImpl::networkEnjoysQuorumIntersection() const
         return true;
     }
 
-    // Second stage: scan the scan-SCC powerset, potentially expensive.
+    // Second stage: scan the scan-SCC powerset, potentially expensive. Skip it
+    // if the scan SCC is unchanged since a previous check.
     if (!foundDisjoint)
     {
-        BitSet committed;
-        BitSet remaining = scanSCC;
-        MinQuorumEnumerator mqe(committed, remaining, scanSCC, *this);
-        foundDisjoint = mqe.anyMinQuorumHasDisjointQuorum();
+        std::optional<Hash> sccHash;
+        if (mSearchCache)
+        {
+            sccHash = hashQSets(scanSCC);
+            auto cached = mSearchCache->get(*sccHash);
+            if (cached)
+            {
+                CLOG_DEBUG(SCP, "Scan SCC unchanged, reusing previous result");
+                if (cached->mFoundDisjoint)
+                {
+                    mPotentialSplit = cached->mPotentialSplit;
+                    if (!mQuiet)
+                    {
+                        CLOG_ERROR(SCP,
+                                   "Found potential disjoint quorums in "
+                                   "previous check of the same scan SCC");
+                    }
+                }
+                return !cached->mFoundDisjoint;
+            }
+        }
+
+        foundDisjoint = anyMinQuorumHasDisjointQuorum(scanSCC);
         mStats.log();
+        if (sccHash)
+        {
+            QuorumIntersectionChecker::SearchResult result;
+            result.mFoundDisjoint = foundDisjoint;
+            result.mPotentialSplit = mPotentialSplit;
+            mSearchCache->put(*sccHash, result);
+        }
     }
     return !foundDisjoint;
 }
@@ -816,41 +1049,78 @@ toQuorumIntersectionMap(QuorumTracker::QuorumMap const& qmap)
 
 namespace stellar
 {
+QuorumIntersectionChecker::SearchCache::SearchCache(size_t maxSize)
+    : mResults(maxSize)
+{
+}
+
+std::optional<QuorumIntersectionChecker::SearchResult>
+QuorumIntersectionChecker::SearchCache::get(Hash const& sccHash)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto res = mResults.maybeGet(sccHash);
+    if (!res)
+    {
+        return std::nullopt;
+    }
+    ++mHits;
+    return *res;
+}
+
+void
+QuorumIntersectionChecker::SearchCache::put(Hash const& sccHash,
+                                            SearchResult const& result)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mResults.put(sccHash, result);
+}
+
+uint64_t
+QuorumIntersectionChecker::SearchCache::getHits()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mHits;
+}
+
 std::shared_ptr<QuorumIntersectionChecker>
 QuorumIntersectionChecker::create(
     QuorumTracker::QuorumMap const& qmap, std::optional<Config> const& cfg,
     std::atomic<bool>& interruptFlag,
-    stellar_default_random_engine::result_type seed, bool quiet)
+    stellar_default_random_engine::result_type seed, bool quiet,
+    SearchCachePtr searchCache)
 {
     return create(toQuorumIntersectionMap(qmap), cfg, interruptFlag, seed,
-                  quiet);
+                  quiet, searchCache);
 }
 
 std::shared_ptr<QuorumIntersectionChecker>
 QuorumIntersectionChecker::create(
     QuorumSetMap const& qmap, std::optional<Config> const& cfg,
     std::atomic<bool>& interruptFlag,
-    stellar_default_random_engine::result_type seed, bool quiet)
+    stellar_default_random_engine::result_type seed, bool quiet,
+    SearchCachePtr searchCache)
 {
     return std::make_shared<QuorumIntersectionCheckerImpl>(
-        qmap, cfg, interruptFlag, seed, quiet);
+        qmap, cfg, interruptFlag, seed, quiet, searchCache);
 }
 
 std::set<std::set<NodeID>>
 QuorumIntersectionChecker::getIntersectionCriticalGroups(
     QuorumTracker::QuorumMap const& qmap, std::optional<Config> const& cfg,
     std::atomic<bool>& interruptFlag,
-    stellar_default_random_engine::result_type seed)
+    stellar_default_random_engine::result_type seed,
+    SearchCachePtr searchCache)
 {
     return getIntersectionCriticalGroups(toQuorumIntersectionMap(qmap), cfg,
-                                         interruptFlag, seed);
+                                         interruptFlag, seed, searchCache);
 }
 
 std::set<std::set<NodeID>>
 QuorumIntersectionChecker::getIntersectionCriticalGroups(
     QuorumSetMap const& qmap, std::optional<Config> const& cfg,
     std::atomic<bool>& interruptFlag,
-    stellar_default_random_engine::result_type seed)
+    stellar_default_random_engine::result_type seed,
+    SearchCachePtr searchCache)
 {
     // We're going to search for "intersection-critical" groups, by considering
     // each SCPQuorumSet S that (a) has no innerSets of its own and (b) occurs
@@ -936,9 +1206,9 @@ QuorumIntersectionChecker::getIntersectionCriticalGroups(
         }
 
         // Check to see if this modified config is vulnerable to splitting.
-        auto checker = QuorumIntersectionChecker::create(test_qmap, cfg,
-                                                         interruptFlag, seed,
-                                                         /*quiet=*/true);
+        auto checker = QuorumIntersectionChecker::create(
+            test_qmap, cfg, interruptFlag, seed,
+            /*quiet=*/true, searchCache);
         if (checker->networkEnjoysQuorumIntersection())
         {
             CLOG_DEBUG(SCP,
@@ -349,6 +349,27 @@
 //
 // Remaining details of the implementation are noted as we go, but the above
 // explanation ought to give you a good idea what you're looking at.
+//
+//
+// Postscript: reuse and parallelism
+// =================================
+//
+// Two further measures keep the enumeration affordable when the checker runs
+// over and over on a slowly changing network:
+//
+//     1. The enumeration only ever looks at the qsets of the nodes in the scan
+//        SCC, so its outcome is a function of those qsets alone. When a
+//        SearchCache is supplied, the outcome is stored under a hash of them
+//        and a later check whose scan SCC has the same qsets (because the
+//        changes happened elsewhere in the network) skips the enumeration.
+//        The SCC decomposition itself is cheap and is always recalculated.
+//
+//     2. The branches of the recursion are independent of one another, so
+//        with more than one thread the top of the recursion tree is expanded
+//        into a frontier of (committed, remaining) subproblems, which are
+//        then enumerated concurrently, each thread using its own copy of the
+//        checker state. The first thread to find a disjoint pair of quorums
+//        stops the others.
 
 #include "QuorumIntersectionChecker.h"
 #include "main/Config.h"
@@ -359,6 +380,8 @@
 #include "xdr/Stellar-types.h"
 #include <functional>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace
 {
@@ -426,6 +449,12 @@ class MinQuorumEnumerator
     // Checker that owns us, contains state of stats, graph, etc.
     QuorumIntersectionCheckerImpl const& mQic;
 
+    // When set, subproblems reached after mFrontierDepth more levels of
+    // recursion are recorded here rather than enumerated, to be enumerated
+    // later (typically in parallel).
+    std::vector<std::pair<BitSet, BitSet>>* mFrontier;
+    size_t mFrontierDepth;
+
     // Select the next node in mRemaining to split recursive cases between.
     size_t
     pickSplitNode(stellar::stellar_default_random_engine& randEngine) const;
@@ -434,9 +463,11 @@ class MinQuorumEnumerator
     size_t maxCommit() const;
 
   public:
-    MinQuorumEnumerator(BitSet const& committed, BitSet const& remaining,
-                        BitSet const& scanSCC,
-                        QuorumIntersectionCheckerImpl const& qic);
+    MinQuorumEnumerator(
+        BitSet const& committed, BitSet const& remaining,
+        BitSet const& scanSCC, QuorumIntersectionCheckerImpl const& qic,
+        std::vector<std::pair<BitSet, BitSet>>* frontier = nullptr,
+        size_t frontierDepth = 0);
 
     bool hasDisjointQuorum(BitSet const& nodes) const;
     bool anyMinQuorumHasDisjointQuorum();
@@ -468,7 +499,10 @@ class QuorumIntersectionCheckerImpl : public stellar::QuorumIntersectionChecker
         size_t mEarlyExit22s = {0};
         size_t mEarlyExit31s = {0};
         size_t mEarlyExit32s = {0};
+        size_t mSubproblems = {0};
+        size_t mSubproblemsDone = {0};
         void log() const;
+        void add(Stats const& other);
     };
 
     // We use our own stats and a local cached flag to control tracing because
@@ -493,6 +527,14 @@ class QuorumIntersectionCheckerImpl : public stellar::QuorumIntersectionChecker
     std::unordered_map<stellar::NodeID, size_t> mPubKeyBitNums;
     QGraph mGraph;
 
+    // The qsets the graph was built from, by node number, to identify the
+    // scan SCC in mSearchCache.
+    std::vector<stellar::SCPQuorumSetPtr> mBitNumQSets;
+    stellar::QuorumIntersectionChecker::SearchCachePtr mSearchCache;
+
+    // Number of threads enumerating the scan SCC powerset.
+    size_t mNumThreads;
+
     // This is a temporary structure that's reused very often within the
     // MinQuorumEnumerators, but never reentrantly / simultaneously. So we
     // allocate it once here and let the MQEs use it to avoid hammering
@@ -508,10 +550,17 @@ class QuorumIntersectionCheckerImpl : public stellar::QuorumIntersectionChecker
     // InterruptedException at the nearest convenient moment.
     std::atomic<bool>& mInterruptFlag;
 
+    // Set in the copies of the checker that enumerate subproblems in parallel,
+    // to stop them once any of them found disjoint quorums.
+    std::atomic<bool> const* mSearchDone;
+
     QBitSet convertSCPQuorumSet(stellar::SCPQuorumSet const& sqs);
     void
     buildGraph(stellar::QuorumIntersectionChecker::QuorumSetMap const& qmap);
     void buildSCCs();
+    stellar::Hash hashQSets(BitSet const& nodes) const;
+    bool anyMinQuorumHasDisjointQuorum(BitSet const& scanSCC) const;
+    bool anyMinQuorumHasDisjointQuorumParallel(BitSet const& scanSCC) const;
 
     bool containsQuorumSlice(BitSet const& bs, QBitSet const& qbs) const;
     bool containsQuorumSliceForNode(BitSet const& bs, size_t node) const;
@@ -536,7 +585,17 @@ class QuorumIntersectionCheckerImpl : public stellar::QuorumIntersectionChecker
         std::optional<stellar::Config> const& cfg,
         std::atomic<bool>& interruptFlag,
         stellar::stellar_default_random_engine::result_type seed,
-        bool quiet = false);
+        bool quiet = false,
+        stellar::QuorumIntersectionChecker::SearchCachePtr searchCache =
+            nullptr);
+
+    // Copy of the graph of `parent`, with fresh stats, caches and random
+    // engine, used to enumerate subproblems on another thread.
+    QuorumIntersectionCheckerImpl(
+        QuorumIntersectionCheckerImpl const& parent,
+        std::atomic<bool> const& searchDone,
+        stellar::stellar_default_random_engine::result_type seed);
+
     bool networkEnjoysQuorumIntersection() const override;
 
     std::pair<std::vector<stellar::NodeID>, std::vector<stellar::NodeID>>
@@ -6,7 +6,7 @@
 #include "crypto/SecretKey.h"
 #include "scp/LocalNode.h"
 #include "util/GlobalChecks.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
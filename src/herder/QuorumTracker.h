@@ -41,6 +41,8 @@ class QuorumTracker : public NonMovableOrCopyable
     };
 
     using QuorumMap = UnorderedMap<NodeID, NodeInfo>;
+    // NodeInfo::mDistance of every node in the quorum
+    using NodeDistances = UnorderedMap<NodeID, int>;
 
   private:
     NodeID const mLocalNodeID;
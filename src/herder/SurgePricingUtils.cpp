@@ -5,27 +5,14 @@
 #include "herder/SurgePricingUtils.h"
 #include "crypto/SecretKey.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/numeric128.h"
 #include "util/types.h"
-#include <Tracy.hpp>
+#include <algorithm>
 #include <numeric>
 
 namespace stellar
 {
-namespace
-{
-
-// Use _inclusion_ fee to order transactions
-int
-feeRate3WayCompare(TransactionFrameBase const& l, TransactionFrameBase const& r)
-{
-    return stellar::feeRate3WayCompare(
-        l.getInclusionFee(), l.getNumOperations(), r.getInclusionFee(),
-        r.getNumOperations());
-}
-
-} // namespace
-
 int
 feeRate3WayCompare(int64_t lFeeBid, uint32_t lNbOps, int64_t rFeeBid,
                    uint32_t rNbOps)
@@ -70,6 +57,16 @@ computeBetterFee(TransactionFrameBase const& tx, int64_t refFeeBid,
     return minFee;
 }
 
+SurgePricingPriorityQueue::TxStackEntry::TxStackEntry(TxStackPtr txStack)
+    : mTxStack(std::move(txStack)), mResources(mTxStack->getResources())
+{
+    // Use _inclusion_ fee to order transactions
+    auto tx = mTxStack->getTopTx();
+    mFeeBid = tx->getInclusionFee();
+    mNumOps = tx->getNumOperations();
+    mTxAddress = reinterpret_cast<size_t>(tx.get());
+}
+
 SurgePricingPriorityQueue::TxStackComparator::TxStackComparator(bool isGreater,
                                                                 size_t seed)
     : mIsGreater(isGreater), mSeed(seed)
@@ -78,17 +75,18 @@ SurgePricingPriorityQueue::TxStackComparator::TxStackComparator(bool isGreater,
 
 bool
 SurgePricingPriorityQueue::TxStackComparator::operator()(
-    TxStackPtr const& txStack1, TxStackPtr const& txStack2) const
+    TxStackEntry const& entry1, TxStackEntry const& entry2) const
 {
-    return txStackLessThan(*txStack1, *txStack2) ^ mIsGreater;
-}
-
-bool
-SurgePricingPriorityQueue::TxStackComparator::compareFeeOnly(
-    TransactionFrameBase const& tx1, TransactionFrameBase const& tx2) const
-{
-    return compareFeeOnly(tx1.getInclusionFee(), tx1.getNumOperations(),
-                          tx2.getInclusionFee(), tx2.getNumOperations());
+    auto cmp3 = feeRate3WayCompare(entry1.mFeeBid, entry1.mNumOps,
+                                   entry2.mFeeBid, entry2.mNumOps);
+    if (cmp3 != 0)
+    {
+        return (cmp3 < 0) ^ mIsGreater;
+    }
+    // break tie with pointer arithmetic
+    auto lx = entry1.mTxAddress ^ mSeed;
+    auto rx = entry2.mTxAddress ^ mSeed;
+    return (lx < rx) ^ mIsGreater;
 }
 
 bool
@@ -105,38 +103,6 @@ SurgePricingPriorityQueue::TxStackComparator::isGreater() const
     return mIsGreater;
 }
 
-bool
-SurgePricingPriorityQueue::TxStackComparator::txStackLessThan(
-    TxStack const& txStack1, TxStack const& txStack2) const
-{
-    if (txStack1.empty())
-    {
-        return !txStack2.empty();
-    }
-    if (txStack2.empty())
-    {
-        return false;
-    }
-    return txLessThan(txStack1.getTopTx(), txStack2.getTopTx(), true);
-}
-
-bool
-SurgePricingPriorityQueue::TxStackComparator::txLessThan(
-    TransactionFrameBaseConstPtr const& tx1,
-    TransactionFrameBaseConstPtr const& tx2, bool breakTiesWithHash) const
-{
-    auto cmp3 = feeRate3WayCompare(*tx1, *tx2);
-
-    if (cmp3 != 0 || !breakTiesWithHash)
-    {
-        return cmp3 < 0;
-    }
-    // break tie with pointer arithmetic
-    auto lx = reinterpret_cast<size_t>(tx1.get()) ^ mSeed;
-    auto rx = reinterpret_cast<size_t>(tx2.get()) ^ mSeed;
-    return lx < rx;
-}
-
 SurgePricingPriorityQueue::SurgePricingPriorityQueue(
     bool isHighestPriority, std::shared_ptr<SurgePricingLaneConfig> settings,
     size_t comparisonSeed)
@@ -172,8 +138,8 @@ SurgePricingPriorityQueue::getMostTopTxsWithinLimits(
         return VisitTxStackResult::TX_PROCESSED;
     };
     std::vector<Resource> laneLeftUntilLimit;
-    queue.popTopTxs(/* allowGaps */ true, visitor, laneLeftUntilLimit,
-                    hadTxNotFittingLane);
+    queue.popTopTxs(/* allowGaps */ true, queue.mLaneLimits, visitor,
+                    laneLeftUntilLimit, hadTxNotFittingLane);
     return txs;
 }
 
@@ -190,19 +156,46 @@ SurgePricingPriorityQueue::visitTopTxs(
         add(txStack);
     }
     std::vector<bool> hadTxNotFittingLane;
-    popTopTxs(/* allowGaps */ false, visitor, laneLeftUntilLimit,
+    popTopTxs(/* allowGaps */ false, mLaneLimits, visitor, laneLeftUntilLimit,
+              hadTxNotFittingLane);
+}
+
+void
+SurgePricingPriorityQueue::visitTopTxs(
+    std::function<VisitTxStackResult(TxStack const&)> const& visitor,
+    std::vector<Resource> const& laneLimits,
+    std::vector<Resource>& laneLeftUntilLimit)
+{
+    ZoneScoped;
+
+    releaseAssert(laneLimits.size() == mLaneLimits.size());
+    std::vector<bool> hadTxNotFittingLane;
+    popTopTxs(/* allowGaps */ false, laneLimits, visitor, laneLeftUntilLimit,
               hadTxNotFittingLane);
 }
 
+bool
+SurgePricingPriorityQueue::empty() const
+{
+    return std::all_of(mTxStackSets.begin(), mTxStackSets.end(),
+                       [](TxStackSet const& s) { return s.empty(); });
+}
+
+size_t
+SurgePricingPriorityQueue::getNumLanes() const
+{
+    return mLaneLimits.size();
+}
+
 void
 SurgePricingPriorityQueue::add(TxStackPtr txStack)
 {
     releaseAssert(txStack != nullptr);
     auto lane = mLaneConfig->getLane(*txStack->getTopTx());
-    bool inserted = mTxStackSets[lane].insert(txStack).second;
-    if (inserted)
+    auto res = mTxStackSets[lane].emplace(std::move(txStack));
+    if (res.second)
     {
-        mLaneCurrentCount[lane] += txStack->getResources();
+        mLaneCurrentCount[lane] += res.first->mResources;
     }
 }
 
@@ -211,7 +204,7 @@ SurgePricingPriorityQueue::erase(TxStackPtr txStack)
 {
     releaseAssert(txStack != nullptr);
     auto lane = mLaneConfig->getLane(*txStack->getTopTx());
-    auto it = mTxStackSets[lane].find(txStack);
+    auto it = mTxStackSets[lane].find(TxStackEntry(txStack));
     if (it != mTxStackSets[lane].end())
     {
         erase(lane, it);
@@ -229,7 +222,7 @@ void
 SurgePricingPriorityQueue::erase(
     size_t lane, SurgePricingPriorityQueue::TxStackSet::iterator iter)
 {
-    auto res = (*iter)->getResources();
+    auto const& res = iter->mResources;
     releaseAssert(res <= mLaneCurrentCount[lane]);
     mLaneCurrentCount[lane] -= res;
     mTxStackSets[lane].erase(iter);
@@ -237,15 +230,15 @@ SurgePricingPriorityQueue::erase(
 
 void
 SurgePricingPriorityQueue::popTopTxs(
-    bool allowGaps,
+    bool allowGaps, std::vector<Resource> const& laneLimits,
     std::function<VisitTxStackResult(TxStack const&)> const& visitor,
     std::vector<Resource>& laneLeftUntilLimit,
     std::vector<bool>& hadTxNotFittingLane)
 {
     ZoneScoped;
 
-    laneLeftUntilLimit = mLaneLimits;
-    hadTxNotFittingLane.assign(mLaneLimits.size(), false);
+    laneLeftUntilLimit = laneLimits;
+    hadTxNotFittingLane.assign(laneLimits.size(), false);
     while (true)
     {
         auto currIt = getTop();
@@ -396,6 +389,8 @@ SurgePricingPriorityQueue::canFitWithEviction(
         return std::make_pair(true, 0ll);
     }
     auto iter = getTop();
+    auto txFeeBid = tx.getInclusionFee();
+    auto txNumOps = tx.getNumOperations();
 
     Resource neededTotal =
         subtractNonNegative(newTotalResources, mLaneLimits[GENERIC_LANE]);
@@ -411,9 +406,7 @@ SurgePricingPriorityQueue::canFitWithEviction(
         while (!iter.isEnd())
         {
             // This is the cheapest transaction
-            auto const& evictTxStack = *iter;
-            auto const& evictTx = *evictTxStack->getTopTx();
-            auto evictLane = mLaneConfig->getLane(evictTx);
+            auto evictLane = iter.getInnerIter().first;
             bool canEvict = false;
             // Check if it makes sense to evict the current top tx stack.
             //
@@ -449,10 +442,10 @@ SurgePricingPriorityQueue::canFitWithEviction(
         // The preconditions are ensured above that we should be able to fit
         // the transaction by evicting some transactions.
         releaseAssert(!iter.isEnd());
-        auto const& evictTxStack = *iter;
+        auto [evictLane, evictIt] = iter.getInnerIter();
+        auto const& evictTxStack = evictIt->mTxStack;
         auto const& evictTx = *evictTxStack->getTopTx();
-        auto evict = evictTxStack->getResources();
-        auto evictLane = mLaneConfig->getLane(evictTx);
+        auto const& evict = evictIt->mResources;
         // Only support this for single tx stacks (eventually we should only
         // have such stacks and share this invariant across all the queue
         // operations).
@@ -462,10 +455,11 @@ SurgePricingPriorityQueue::canFitWithEviction(
         // NB: this logic works with properly with Soroban transactions as well,
         // since those are guaranteed to contain 1 op, therefore fee-per-op
         // computation is a no-op.
-        if (!mComparator.compareFeeOnly(evictTx, tx))
+        if (!mComparator.compareFeeOnly(evictIt->mFeeBid, evictIt->mNumOps,
+                                        txFeeBid, txNumOps))
         {
-            auto minFee = computeBetterFee(tx, evictTx.getInclusionFee(),
-                                           evictTx.getNumOperations());
+            auto minFee =
+                computeBetterFee(tx, evictIt->mFeeBid, evictIt->mNumOps);
             return std::make_pair(
                 false, minFee + (tx.getFullFee() - tx.getInclusionFee()));
         }
@@ -565,7 +559,7 @@ SurgePricingPriorityQueue::Iterator::getMutableInnerIter() const
 TxStackPtr
 SurgePricingPriorityQueue::Iterator::operator*() const
 {
-    return *getMutableInnerIter()->second;
+    return getMutableInnerIter()->second->mTxStack;
 }
 
 SurgePricingPriorityQueue::LaneIter
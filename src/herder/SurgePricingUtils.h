@@ -185,6 +185,22 @@ class SurgePricingPriorityQueue
         std::function<VisitTxStackResult(TxStack const&)> const& visitor,
         std::vector<Resource>& laneResourcesLeftUntilLimit);
 
+    // Same as the helper above, but visits the stacks already in this queue
+    // and stops at `laneLimits` instead of the limits of the lane
+    // configuration, so that a queue kept across calls can be visited with
+    // new limits each time. Stacks that are not visited stay in the queue.
+    // `laneLimits` must have one limit per lane of the configuration.
+    void visitTopTxs(
+        std::function<VisitTxStackResult(TxStack const&)> const& visitor,
+        std::vector<Resource> const& laneLimits,
+        std::vector<Resource>& laneResourcesLeftUntilLimit);
+
+    // Returns whether there are no stacks in this queue.
+    bool empty() const;
+
+    // Returns the number of lanes of the lane configuration.
+    size_t getNumLanes() const;
+
     // Creates a `SurgePricingPriorityQueue` for the provided lane
     // configuration.
     // `isHighestPriority` defines the comparison order: when it's `true` the
@@ -217,33 +233,41 @@ class SurgePricingPriorityQueue
         std::vector<std::pair<TxStackPtr, bool>>& txStacksToEvict) const;
 
   private:
+    // Element of the per-lane sets. The fee bid, operation count and
+    // resources of a stack are captured when it is added, so that ordering the
+    // set and walking it for evictions don't go back to the stack's top
+    // transaction every time. Stacks only change while they are out of the
+    // queue (see `popTopTx`), which keeps these values current.
+    struct TxStackEntry
+    {
+        TxStackEntry(TxStackPtr txStack);
+
+        TxStackPtr mTxStack;
+        int64_t mFeeBid;
+        uint32_t mNumOps;
+        // Address of the top transaction, used to break ties
+        size_t mTxAddress;
+        Resource mResources;
+    };
+
     class TxStackComparator
     {
       public:
         TxStackComparator(bool isGreater, size_t seed);
 
-        bool operator()(TxStackPtr const& txStack1,
-                        TxStackPtr const& txStack2) const;
+        bool operator()(TxStackEntry const& entry1,
+                        TxStackEntry const& entry2) const;
 
-        bool compareFeeOnly(TransactionFrameBase const& tx1,
-                            TransactionFrameBase const& tx2) const;
         bool compareFeeOnly(int64_t tx1Bid, uint32_t tx1Ops, int64_t tx2Bid,
                             uint32_t tx2Ops) const;
         bool isGreater() const;
 
       private:
-        bool txStackLessThan(TxStack const& txStack1,
-                             TxStack const& txStack2) const;
-
-        bool txLessThan(TransactionFrameBaseConstPtr const& tx1,
-                        TransactionFrameBaseConstPtr const& tx2,
-                        bool breakTiesWithHash) const;
-
         bool const mIsGreater;
         size_t mSeed;
     };
 
-    using TxStackSet = std::set<TxStackPtr, TxStackComparator>;
+    using TxStackSet = std::set<TxStackEntry, TxStackComparator>;
     using LaneIter = std::pair<size_t, TxStackSet::iterator>;
 
     // Iterator for walking the queue from top to bottom, possibly restricted
@@ -273,11 +297,10 @@ class SurgePricingPriorityQueue
     };
 
     // Generalized method for visiting and popping the top transactions in the
-    // queue until the lane limits are reached.
-    // This leaves the queue empty (when `allowGaps` is `true`) and hence is
-    // only used from the helper methods that don't expose the queue at all.
+    // queue until `laneLimits` are reached.
+    // This leaves the queue empty when `allowGaps` is `true`.
     void
-    popTopTxs(bool allowGaps,
+    popTopTxs(bool allowGaps, std::vector<Resource> const& laneLimits,
               std::function<VisitTxStackResult(TxStack const&)> const& visitor,
               std::vector<Resource>& laneResourcesLeftUntilLimit,
               std::vector<bool>& hadTxNotFittingLane);
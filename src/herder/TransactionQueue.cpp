@@ -21,12 +21,14 @@
 #include "util/GlobalChecks.h"
 #include "util/HashOfHash.h"
 #include "util/Math.h"
+#include "util/MemoryFootprint.h"
 #include "util/ProtocolVersion.h"
 #include "util/TarjanSCCCalculator.h"
 #include "util/XDROperators.h"
 #include "util/numeric128.h"
+#include "xdrpp/marshal.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <algorithm>
 #include <fmt/format.h>
 #include <functional>
@@ -234,7 +236,8 @@ TransactionQueue::sourceAccountPending(AccountID const& accountID) const
 TransactionQueue::AddResult
 TransactionQueue::canAdd(TransactionFrameBasePtr tx,
                          AccountStates::iterator& stateIter,
-                         std::vector<std::pair<TxStackPtr, bool>>& txsToEvict)
+                         std::vector<std::pair<TxStackPtr, bool>>& txsToEvict,
+                         uint64_t upperBoundCloseTimeOffset)
 {
     ZoneScoped;
     if (isBanned(tx->getFullHash()))
@@ -344,9 +347,6 @@ TransactionQueue::canAdd(TransactionFrameBasePtr tx,
         return TransactionQueue::AddResult::ADD_STATUS_TRY_AGAIN_LATER;
     }
 
-    auto closeTime = mApp.getLedgerManager()
-                         .getLastClosedLedgerHeader()
-                         .header.scpValue.closeTime;
     if (protocolVersionStartsFrom(ledgerVersion, ProtocolVersion::V_19))
     {
         // This is done so minSeqLedgerGap is validated against the next
@@ -355,8 +355,7 @@ TransactionQueue::canAdd(TransactionFrameBasePtr tx,
             mApp.getLedgerManager().getLastClosedLedgerNum() + 1;
     }
 
-    if (!tx->checkValid(mApp, ltx, 0, 0,
-                        getUpperBoundCloseTimeOffset(mApp, closeTime)))
+    if (!tx->checkValid(mApp, ltx, 0, 0, upperBoundCloseTimeOffset))
     {
         return TransactionQueue::AddResult::ADD_STATUS_ERROR;
     }
@@ -398,6 +397,7 @@ TransactionQueue::prepareDropTransaction(AccountState& as)
     releaseAssert(as.mTransaction);
     mTxQueueLimiter->removeTransaction(as.mTransaction->mTx);
     mKnownTxHashes.erase(as.mTransaction->mTx->getFullHash());
+    mKnownTxBytes -= xdr::xdr_size(as.mTransaction->mTx->getEnvelope());
     CLOG_DEBUG(Tx, "Dropping {} transaction",
                hexAbbrev(as.mTransaction->mTx->getFullHash()));
     releaseFeeMaybeEraseAccountState(as.mTransaction->mTx);
@@ -536,7 +536,12 @@ TransactionQueue::tryAdd(TransactionFrameBasePtr tx, bool submittedFromSelf)
     AccountStates::iterator stateIter;
 
     std::vector<std::pair<TxStackPtr, bool>> txsToEvict;
-    auto const res = canAdd(tx, stateIter, txsToEvict);
+    auto const& lcl = mApp.getLedgerManager().getLastClosedLedgerHeader();
+    auto closeTime = lcl.header.scpValue.closeTime;
+    auto upperBoundCloseTimeOffset =
+        getUpperBoundCloseTimeOffset(mApp, closeTime);
+    auto const res =
+        canAdd(tx, stateIter, txsToEvict, upperBoundCloseTimeOffset);
     if (res != TransactionQueue::AddResult::ADD_STATUS_PENDING)
     {
         return res;
@@ -556,6 +561,7 @@ TransactionQueue::tryAdd(TransactionFrameBasePtr tx, bool submittedFromSelf)
         // Drop current transaction associated with this account, replace
         // with `tx`
         prepareDropTransaction(stateIter->second);
+        eraseFromBroadcastQueue(stateIter->second);
         *oldTx = {tx, false, mApp.getClock().now(), submittedFromSelf};
     }
     else
@@ -565,6 +571,13 @@ TransactionQueue::tryAdd(TransactionFrameBasePtr tx, bool submittedFromSelf)
                                           submittedFromSelf};
         mQueueMetrics->mSizeByAge[stateIter->second.mAge]->inc();
     }
+    addToBroadcastQueue(stateIter->second);
+
+    // canAdd has just checked tx against the last closed ledger, so the
+    // next nomination does not need to do it again
+    stateIter->second.mTransaction->mValidatedLedgerSeq = lcl.header.ledgerSeq;
+    stateIter->second.mTransaction->mValidUntilCloseTime =
+        closeTime + upperBoundCloseTimeOffset;
 
     // Update fee accounting
     auto& thisAccountState = mAccountStates[tx->getFeeSourceID()];
@@ -577,6 +590,7 @@ TransactionQueue::tryAdd(TransactionFrameBasePtr tx, bool submittedFromSelf)
         [&](TransactionFrameBasePtr const& txToEvict) { ban({txToEvict}); });
     mTxQueueLimiter->addTransaction(tx);
     mKnownTxHashes[tx->getFullHash()] = tx;
+    mKnownTxBytes += xdr::xdr_size(tx->getEnvelope());
 
     broadcast(false);
 
@@ -594,6 +608,7 @@ TransactionQueue::dropTransaction(AccountStates::iterator stateIter)
     releaseAssert(stateIter->second.mTransaction);
 
     prepareDropTransaction(stateIter->second);
+    eraseFromBroadcastQueue(stateIter->second);
 
     // Actually erase the transaction to be dropped.
     stateIter->second.mTransaction.reset();
@@ -775,6 +790,7 @@ TransactionQueue::shift()
                     hexAbbrev(it->second.mTransaction->mTx->getFullHash()));
                 bannedFront.insert(it->second.mTransaction->mTx->getFullHash());
                 mQueueMetrics->mBannedTransactionsCounter.inc();
+                eraseFromBroadcastQueue(it->second);
                 it->second.mTransaction.reset();
             }
             if (it->second.mTotalFees == 0)
@@ -802,6 +818,7 @@ TransactionQueue::shift()
     // pick a new randomizing seed for tie breaking
     mBroadcastSeed =
         rand_uniform<uint64>(0, std::numeric_limits<uint64>::max());
+    mBroadcastQueue.reset();
 }
 
 bool
@@ -834,6 +851,65 @@ TransactionQueue::getTransactions(LedgerHeader const& lcl) const
     return txs;
 }
 
+std::vector<TransactionQueue::TimestampedTx>
+TransactionQueue::getQueuedTransactions() const
+{
+    ZoneScoped;
+    std::vector<TimestampedTx> txs;
+    for (auto const& m : mAccountStates)
+    {
+        if (m.second.mTransaction)
+        {
+            txs.emplace_back(*m.second.mTransaction);
+        }
+    }
+    std::stable_sort(txs.begin(), txs.end(),
+                     [](TimestampedTx const& a, TimestampedTx const& b) {
+                         return a.mInsertionTime < b.mInsertionTime;
+                     });
+    return txs;
+}
+
+void
+TransactionQueue::markValidated(Transactions const& txs,
+                                LedgerHeader const& lcl,
+                                uint64_t upperBoundCloseTimeOffset)
+{
+    ZoneScoped;
+    for (auto const& tx : txs)
+    {
+        auto it = mAccountStates.find(tx->getSourceID());
+        if (it == mAccountStates.end() || !it->second.mTransaction ||
+            it->second.mTransaction->mTx->getFullHash() != tx->getFullHash())
+        {
+            continue;
+        }
+        auto& timestamped = *it->second.mTransaction;
+        timestamped.mValidatedLedgerSeq = lcl.ledgerSeq;
+        timestamped.mValidUntilCloseTime =
+            lcl.scpValue.closeTime + upperBoundCloseTimeOffset;
+    }
+}
+
+UnorderedSet<Hash>
+TransactionQueue::getValidatedTxHashes(LedgerHeader const& lcl,
+                                       uint64_t upperBoundCloseTimeOffset) const
+{
+    ZoneScoped;
+    UnorderedSet<Hash> res;
+    auto closeTime = lcl.scpValue.closeTime + upperBoundCloseTimeOffset;
+    for (auto const& m : mAccountStates)
+    {
+        auto const& timestamped = m.second.mTransaction;
+        if (timestamped && timestamped->mValidatedLedgerSeq == lcl.ledgerSeq &&
+            timestamped->mValidUntilCloseTime >= closeTime)
+        {
+            res.emplace(timestamped->mTx->getFullHash());
+        }
+    }
+    return res;
+}
+
 TransactionFrameBaseConstPtr
 TransactionQueue::getTx(Hash const& hash) const
 {
@@ -852,6 +928,7 @@ TransactionQueue::getTx(Hash const& hash) const
 void
 TransactionQueue::clearAll()
 {
+    mBroadcastQueue.reset();
     mAccountStates.clear();
     for (auto& b : mBannedTransactions)
     {
@@ -862,6 +939,22 @@ TransactionQueue::clearAll()
                   TransactionMode::READ_ONLY_WITHOUT_SQL_TXN);
     mTxQueueLimiter->reset(ltx.loadHeader().current().ledgerVersion);
     mKnownTxHashes.clear();
+    mKnownTxBytes = 0;
+}
+
+size_t
+TransactionQueue::getEstimatedBytes() const
+{
+    size_t banned = 0;
+    for (auto const& b : mBannedTransactions)
+    {
+        banned += b.size();
+    }
+    return mKnownTxBytes +
+           mKnownTxHashes.size() *
+               nodeBytes<decltype(mKnownTxHashes)::value_type>() +
+           mAccountStates.size() * nodeBytes<AccountStates::value_type>() +
+           banned * nodeBytes<Hash>();
 }
 
 std::pair<Resource, std::optional<Resource>>
@@ -948,8 +1041,9 @@ TransactionQueue::broadcastTx(TimestampedTx& tx)
 
 class TxQueueTracker : public TxStack
 {
-    // TxQueueTracker is used in _synchronous_ `broadcastSome` calls and is
-    // thrown away immediately after, so it is safe to store a
+    // TxQueueTracker is kept in mBroadcastQueue only while the transaction of
+    // its account is queued and not broadcast, and AccountStates is erased
+    // from only once the transaction is gone, so it is safe to store a
     // TransactionQueue::AccountState reference
   public:
     TxQueueTracker(TransactionQueue::AccountState& accountState)
@@ -998,6 +1092,44 @@ class TxQueueTracker : public TxStack
     bool mProcessed;
 };
 
+SurgePricingPriorityQueue&
+TransactionQueue::getBroadcastQueue(
+    std::shared_ptr<SurgePricingLaneConfig> laneConfig)
+{
+    // The DEX lane comes and goes with its ledger limit
+    if (!mBroadcastQueue ||
+        mBroadcastQueue->getNumLanes() != laneConfig->getLaneLimits().size())
+    {
+        mBroadcastQueue = std::make_unique<SurgePricingPriorityQueue>(
+            /* isHighestPriority */ true, laneConfig, mBroadcastSeed);
+        for (auto& [_, accountState] : mAccountStates)
+        {
+            addToBroadcastQueue(accountState);
+        }
+    }
+    return *mBroadcastQueue;
+}
+
+void
+TransactionQueue::addToBroadcastQueue(AccountState& as)
+{
+    if (mBroadcastQueue && as.mTransaction && !as.mTransaction->mBroadcasted)
+    {
+        mBroadcastQueue->add(std::make_shared<TxQueueTracker>(as));
+    }
+}
+
+void
+TransactionQueue::eraseFromBroadcastQueue(AccountState& as)
+{
+    // Trackers are found by their top transaction, so a new one finds the
+    // tracker added for the same transaction
+    if (mBroadcastQueue && as.mTransaction && !as.mTransaction->mBroadcasted)
+    {
+        mBroadcastQueue->erase(std::make_shared<TxQueueTracker>(as));
+    }
+}
+
 SorobanTransactionQueue::SorobanTransactionQueue(Application& app,
                                                  uint32 pendingDepth,
                                                  uint32 banDepth,
@@ -1049,26 +1181,15 @@ SorobanTransactionQueue::broadcastSome()
     // This broadcasts from account queues in order as to maximize chances
     // of propagation.
     auto resToFlood = getMaxResourcesToFloodThisPeriod().first;
+    auto laneConfig = std::make_shared<SorobanGenericLaneConfig>(resToFlood);
+    auto& queue = getBroadcastQueue(laneConfig);
 
-    auto totalResToFlood = Resource::makeEmptySoroban();
-    std::vector<TxStackPtr> trackersToBroadcast;
-    for (auto& [_, accountState] : mAccountStates)
-    {
-        if (accountState.mTransaction &&
-            !accountState.mTransaction->mBroadcasted)
-        {
-            trackersToBroadcast.emplace_back(
-                std::make_shared<TxQueueTracker>(accountState));
-            totalResToFlood += accountState.mTransaction->mTx->getResources(
-                /* useByteLimitInClassic */ false);
-        }
-    }
-
-    auto visitor = [this, &totalResToFlood](TxStack const& txStack) {
+    // Transactions visited but not flooded still count as left to flood
+    bool visitedNotFlooded = false;
+    auto visitor = [this, &visitedNotFlooded](TxStack const& txStack) {
         auto const& curTracker = static_cast<TxQueueTracker const&>(txStack);
         // look at the next candidate transaction for that account
         auto& cur = curTracker.getCurrentTimestampedTx();
-        auto tx = curTracker.getTopTx();
         // by construction, cur points to non broadcasted transactions
         releaseAssert(!cur.mBroadcasted);
         auto bStatus = broadcastTx(cur);
@@ -1076,22 +1197,19 @@ SorobanTransactionQueue::broadcastSome()
         releaseAssert(bStatus != BroadcastStatus::BROADCAST_STATUS_SKIPPED);
         if (bStatus == BroadcastStatus::BROADCAST_STATUS_SUCCESS)
         {
-            totalResToFlood -=
-                tx->getResources(/* useByteLimitInClassic */ false);
             return SurgePricingPriorityQueue::VisitTxStackResult::TX_PROCESSED;
         }
         else
         {
             // Already broadcasted; don't invalidate the stack but also
             // don't count transaction as processed.
+            visitedNotFlooded = true;
             return SurgePricingPriorityQueue::VisitTxStackResult::TX_SKIPPED;
         }
     };
 
-    SurgePricingPriorityQueue queue(
-        /* isHighestPriority */ true,
-        std::make_shared<SorobanGenericLaneConfig>(resToFlood), mBroadcastSeed);
-    queue.visitTopTxs(trackersToBroadcast, visitor, mBroadcastOpCarryover);
+    queue.visitTopTxs(visitor, laneConfig->getLaneLimits(),
+                      mBroadcastOpCarryover);
 
     Resource maxPerTx =
         mApp.getLedgerManager().maxSorobanTransactionResources();
@@ -1100,7 +1218,7 @@ SorobanTransactionQueue::broadcastSome()
         // Limit carry-over to 1 maximum resource transaction
         resLeft = limitTo(resLeft, maxPerTx);
     }
-    return !totalResToFlood.isZero();
+    return visitedNotFlooded || !queue.empty();
 }
 
 size_t
@@ -1137,22 +1255,15 @@ ClassicTransactionQueue::broadcastSome()
         releaseAssert(dexOpsToFlood->size() == NUM_CLASSIC_TX_RESOURCES);
     }
 
-    auto totalToFlood = Resource::makeEmpty(NUM_CLASSIC_TX_RESOURCES);
-    std::vector<TxStackPtr> trackersToBroadcast;
-    for (auto& [_, accountState] : mAccountStates)
-    {
-        if (accountState.mTransaction &&
-            !accountState.mTransaction->mBroadcasted)
-        {
-            trackersToBroadcast.emplace_back(
-                std::make_shared<TxQueueTracker>(accountState));
-            totalToFlood +=
-                Resource(accountState.mTransaction->mTx->getNumOperations());
-        }
-    }
+    auto laneConfig =
+        std::make_shared<DexLimitingLaneConfig>(opsToFlood, dexOpsToFlood);
+    auto& queue = getBroadcastQueue(laneConfig);
 
+    // Transactions visited but not flooded still count as left to flood
+    bool visitedNotFlooded = false;
     std::vector<TransactionFrameBasePtr> banningTxs;
-    auto visitor = [this, &totalToFlood, &banningTxs](TxStack const& txStack) {
+    auto visitor = [this, &visitedNotFlooded,
+                    &banningTxs](TxStack const& txStack) {
         auto const& curTracker = static_cast<TxQueueTracker const&>(txStack);
         // look at the next candidate transaction for that account
         auto& cur = curTracker.getCurrentTimestampedTx();
@@ -1162,10 +1273,10 @@ ClassicTransactionQueue::broadcastSome()
         auto bStatus = broadcastTx(cur);
         if (bStatus == BroadcastStatus::BROADCAST_STATUS_SUCCESS)
         {
-            totalToFlood -= tx->getResources(/* useByteLimitInClassic */ false);
             return SurgePricingPriorityQueue::VisitTxStackResult::TX_PROCESSED;
         }
-        else if (bStatus == BroadcastStatus::BROADCAST_STATUS_SKIPPED)
+        visitedNotFlooded = true;
+        if (bStatus == BroadcastStatus::BROADCAST_STATUS_SKIPPED)
         {
             // When skipping, we ban the transaction and skip the remainder
             // of the stack.
@@ -1181,11 +1292,8 @@ ClassicTransactionQueue::broadcastSome()
         }
     };
 
-    SurgePricingPriorityQueue queue(
-        /* isHighestPriority */ true,
-        std::make_shared<DexLimitingLaneConfig>(opsToFlood, dexOpsToFlood),
-        mBroadcastSeed);
-    queue.visitTopTxs(trackersToBroadcast, visitor, mBroadcastOpCarryover);
+    queue.visitTopTxs(visitor, laneConfig->getLaneLimits(),
+                      mBroadcastOpCarryover);
     ban(banningTxs);
     // carry over remainder, up to MAX_OPS_PER_TX ops
     // reason is that if we add 1 next round, we can flood a "worst case fee
@@ -1195,7 +1303,7 @@ ClassicTransactionQueue::broadcastSome()
         releaseAssert(opsLeft.size() == NUM_CLASSIC_TX_RESOURCES);
         opsLeft = limitTo(opsLeft, Resource(MAX_OPS_PER_TX + 1));
     }
-    return !totalToFlood.isZero();
+    return visitedNotFlooded || !queue.empty();
 }
 
 void
@@ -1240,6 +1348,7 @@ TransactionQueue::rebroadcast()
             as.mTransaction->mBroadcasted = false;
         }
     }
+    mBroadcastQueue.reset();
     broadcast(false);
 }
 
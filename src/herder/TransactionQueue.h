@@ -82,6 +82,12 @@ class TransactionQueue
      *   mTransactions is empty
      * - mTransactions: the list of transactions for which this account is the
      *   sequence-number-source, ordered by sequence number
+     *
+     * TimestampedTx also records the last closed ledger its transaction was
+     * last found valid against (mValidatedLedgerSeq), and the latest close
+     * time it was checked for (mValidUntilCloseTime). Such a transaction is
+     * valid for any close time between that of the ledger and
+     * mValidUntilCloseTime.
      */
 
     struct TimestampedTx
@@ -90,6 +96,8 @@ class TransactionQueue
         bool mBroadcasted;
         VirtualClock::time_point mInsertionTime;
         bool mSubmittedFromSelf;
+        uint32_t mValidatedLedgerSeq{0};
+        TimePoint mValidUntilCloseTime{0};
     };
     using Transactions = std::vector<TransactionFrameBasePtr>;
     struct AccountState
@@ -126,8 +134,27 @@ class TransactionQueue
     bool isBanned(Hash const& hash) const;
     TransactionFrameBaseConstPtr getTx(Hash const& hash) const;
     TxSetTransactions getTransactions(LedgerHeader const& lcl) const;
+    // Every queued transaction, oldest first
+    std::vector<TimestampedTx> getQueuedTransactions() const;
+
+    // Records that txs have been found valid against lcl, the last closed
+    // ledger, with close time offsets from 0 to upperBoundCloseTimeOffset.
+    // Transactions that are not in the queue are ignored.
+    void markValidated(Transactions const& txs, LedgerHeader const& lcl,
+                       uint64_t upperBoundCloseTimeOffset);
+    // Returns the hashes of the transactions in the queue that are known to
+    // be valid against lcl for every close time offset up to
+    // upperBoundCloseTimeOffset, so that building a tx set from them only
+    // needs to check their fees
+    UnorderedSet<Hash>
+    getValidatedTxHashes(LedgerHeader const& lcl,
+                         uint64_t upperBoundCloseTimeOffset) const;
     bool sourceAccountPending(AccountID const& accountID) const;
 
+    // Returns the estimated bytes of memory held by queued and banned
+    // transactions
+    size_t getEstimatedBytes() const;
+
     virtual size_t getMaxQueueSizeOps() const = 0;
 
 #ifdef BUILD_TESTS
@@ -202,7 +229,8 @@ class TransactionQueue
     BroadcastStatus broadcastTx(TimestampedTx& tx);
     AddResult canAdd(TransactionFrameBasePtr tx,
                      AccountStates::iterator& stateIter,
-                     std::vector<std::pair<TxStackPtr, bool>>& txsToEvict);
+                     std::vector<std::pair<TxStackPtr, bool>>& txsToEvict,
+                     uint64_t upperBoundCloseTimeOffset);
 
     void releaseFeeMaybeEraseAccountState(TransactionFrameBasePtr tx);
 
@@ -217,9 +245,24 @@ class TransactionQueue
     UnorderedMap<AssetPair, uint32_t, AssetPairHash> mArbitrageFloodDamping;
 
     UnorderedMap<Hash, TransactionFrameBasePtr> mKnownTxHashes;
+    // Encoded size of the transactions in mKnownTxHashes
+    size_t mKnownTxBytes{0};
 
     size_t mBroadcastSeed;
 
+    // Unbroadcast transactions in the order broadcastSome floods them, kept
+    // across flood periods so that each period only pops what it floods.
+    // Built by getBroadcastQueue when null, then updated as transactions are
+    // added and dropped. Reset when the tie-breaking seed changes and when
+    // transactions become unbroadcast again.
+    std::unique_ptr<SurgePricingPriorityQueue> mBroadcastQueue;
+
+    SurgePricingPriorityQueue&
+    getBroadcastQueue(std::shared_ptr<SurgePricingLaneConfig> laneConfig);
+    // Add or erase the transaction of `as`, if it is not broadcast yet
+    void addToBroadcastQueue(AccountState& as);
+    void eraseFromBroadcastQueue(AccountState& as);
+
 #ifdef BUILD_TESTS
   public:
     size_t getQueueSizeOps() const;
@@ -0,0 +1,220 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/TxSetChunks.h"
+#include "crypto/SHA.h"
+#include "util/GlobalChecks.h"
+#include "util/Tracing.h"
+#include "xdrpp/marshal.h"
+
+#include <stdexcept>
+
+namespace stellar
+{
+
+namespace
+{
+bool
+hasChunkableStructure(GeneralizedTransactionSet const& txSet)
+{
+    if (txSet.v() != 1)
+    {
+        return false;
+    }
+    for (auto const& phase : txSet.v1TxSet().phases)
+    {
+        if (phase.v() != 0)
+        {
+            return false;
+        }
+        for (auto const& component : phase.v0Components())
+        {
+            if (component.type() != TXSET_COMP_TXS_MAYBE_DISCOUNTED_FEE)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TxSetChunkTxs&
+componentTxs(GeneralizedTransactionSet& txSet, uint32_t phase,
+             uint32_t component)
+{
+    return txSet.v1TxSet()
+        .phases.at(phase)
+        .v0Components()
+        .at(component)
+        .txsMaybeDiscountedFee()
+        .txs;
+}
+
+TxSetChunkTxs const&
+componentTxs(GeneralizedTransactionSet const& txSet, uint32_t phase,
+             uint32_t component)
+{
+    return txSet.v1TxSet()
+        .phases.at(phase)
+        .v0Components()
+        .at(component)
+        .txsMaybeDiscountedFee()
+        .txs;
+}
+}
+
+std::optional<TxSetChunkManifest>
+makeTxSetChunkManifest(GeneralizedTransactionSet const& txSet,
+                       size_t maxChunkBytes)
+{
+    ZoneScoped;
+    if (!hasChunkableStructure(txSet))
+    {
+        return std::nullopt;
+    }
+
+    TxSetChunkManifest manifest;
+    manifest.mTxSetHash = xdrSha256(txSet);
+    manifest.mSkeleton = txSet;
+    auto const& phases = txSet.v1TxSet().phases;
+    for (uint32_t p = 0; p < phases.size(); ++p)
+    {
+        auto const& components = phases[p].v0Components();
+        for (uint32_t c = 0; c < components.size(); ++c)
+        {
+            auto const& txs = components[c].txsMaybeDiscountedFee().txs;
+            componentTxs(manifest.mSkeleton, p, c).clear();
+
+            uint32_t first = 0;
+            size_t chunkBytes = 0;
+            auto closeChunk = [&](uint32_t end) {
+                TxSetChunkInfo chunk{p, c, first, end - first, {}};
+                chunk.mHash = xdrSha256(getTxSetChunk(txSet, chunk));
+                manifest.mChunks.emplace_back(chunk);
+                first = end;
+                chunkBytes = 0;
+            };
+            for (uint32_t i = 0; i < txs.size(); ++i)
+            {
+                auto size = xdr::xdr_argpack_size(txs[i]);
+                if (i > first && chunkBytes + size > maxChunkBytes)
+                {
+                    closeChunk(i);
+                }
+                chunkBytes += size;
+            }
+            if (first < txs.size())
+            {
+                closeChunk(static_cast<uint32_t>(txs.size()));
+            }
+        }
+    }
+    return manifest;
+}
+
+TxSetChunkTxs
+getTxSetChunk(GeneralizedTransactionSet const& txSet,
+              TxSetChunkInfo const& chunk)
+{
+    auto const& txs = componentTxs(txSet, chunk.mPhase, chunk.mComponent);
+    releaseAssert(uint64_t(chunk.mFirstTx) + chunk.mTxCount <= txs.size());
+    auto begin = txs.begin() + chunk.mFirstTx;
+    return TxSetChunkTxs(begin, begin + chunk.mTxCount);
+}
+
+TxSetChunkAssembler::TxSetChunkAssembler(TxSetChunkManifest manifest)
+    : mManifest(std::move(manifest))
+    , mChunks(mManifest.mChunks.size())
+    , mMissing(mManifest.mChunks.size())
+{
+    auto const& skeleton = mManifest.mSkeleton;
+    if (!hasChunkableStructure(skeleton))
+    {
+        throw std::invalid_argument("unsupported tx set chunk manifest");
+    }
+
+    // Chunks must cover each component in order, with no gap
+    auto const& phases = skeleton.v1TxSet().phases;
+    std::optional<std::pair<uint32_t, uint32_t>> lastComponent;
+    uint32_t nextTx = 0;
+    for (auto const& chunk : mManifest.mChunks)
+    {
+        if (chunk.mPhase >= phases.size() ||
+            chunk.mComponent >= phases[chunk.mPhase].v0Components().size() ||
+            !componentTxs(skeleton, chunk.mPhase, chunk.mComponent).empty() ||
+            chunk.mTxCount == 0)
+        {
+            throw std::invalid_argument("bad tx set chunk manifest");
+        }
+        std::pair<uint32_t, uint32_t> component{chunk.mPhase,
+                                                chunk.mComponent};
+        if (lastComponent != component)
+        {
+            if (lastComponent && component < *lastComponent)
+            {
+                throw std::invalid_argument("bad tx set chunk manifest");
+            }
+            lastComponent = component;
+            nextTx = 0;
+        }
+        if (chunk.mFirstTx != nextTx)
+        {
+            throw std::invalid_argument("bad tx set chunk manifest");
+        }
+        nextTx += chunk.mTxCount;
+    }
+}
+
+bool
+TxSetChunkAssembler::addChunk(size_t index, TxSetChunkTxs txs)
+{
+    ZoneScoped;
+    if (index >= mChunks.size() || mChunks[index])
+    {
+        return false;
+    }
+    auto const& chunk = mManifest.mChunks[index];
+    if (txs.size() != chunk.mTxCount || xdrSha256(txs) != chunk.mHash)
+    {
+        return false;
+    }
+    mChunks[index] = std::move(txs);
+    --mMissing;
+    return true;
+}
+
+std::vector<size_t>
+TxSetChunkAssembler::getMissingChunks() const
+{
+    std::vector<size_t> res;
+    for (size_t i = 0; i < mChunks.size(); ++i)
+    {
+        if (!mChunks[i])
+        {
+            res.emplace_back(i);
+        }
+    }
+    return res;
+}
+
+TxSetXDRFrameConstPtr
+TxSetChunkAssembler::assemble() const
+{
+    ZoneScoped;
+    releaseAssert(isComplete());
+    auto txSet = mManifest.mSkeleton;
+    for (size_t i = 0; i < mChunks.size(); ++i)
+    {
+        auto const& chunk = mManifest.mChunks[i];
+        auto& txs = componentTxs(txSet, chunk.mPhase, chunk.mComponent);
+        txs.insert(txs.end(), mChunks[i]->begin(), mChunks[i]->end());
+    }
+    auto frame = TxSetXDRFrame::makeFromWire(txSet);
+    if (frame->getContentsHash() != mManifest.mTxSetHash)
+    {
+        return nullptr;
+    }
+    return frame;
+}
+}
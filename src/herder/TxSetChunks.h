@@ -0,0 +1,97 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "herder/TxSetFrame.h"
+#include "overlay/StellarXDR.h"
+
+#include <optional>
+#include <vector>
+
+namespace stellar
+{
+
+// Splitting of generalized tx sets into chunks that can be fetched from
+// different peers at the same time, and their reassembly.
+//
+// A chunk is a contiguous range of the transactions of one component of one
+// phase. The manifest of a tx set lists its chunks with the hash of each one,
+// along with the tx set stripped of its transactions (the "skeleton"), so
+// that a chunk can be checked as soon as it arrives and a peer that sends a
+// bad one can be told apart from the others.
+//
+// The manifest itself can't be checked before the tx set is reassembled, as
+// the tx set hash covers the whole XDR: a manifest from a bad peer yields a
+// tx set that doesn't hash to the expected value, and the fetch has to start
+// over with a manifest from another peer.
+
+struct TxSetChunkInfo
+{
+    uint32_t mPhase;
+    uint32_t mComponent;
+    uint32_t mFirstTx;
+    uint32_t mTxCount;
+    // xdrSha256 of the transactions of the chunk
+    Hash mHash;
+};
+
+struct TxSetChunkManifest
+{
+    Hash mTxSetHash;
+    GeneralizedTransactionSet mSkeleton;
+    std::vector<TxSetChunkInfo> mChunks;
+};
+
+using TxSetChunkTxs = xdr::xvector<TransactionEnvelope>;
+
+// Splits `txSet` into chunks of at most `maxChunkBytes` of transactions, or
+// a single transaction when it is bigger than that. Returns nullopt if
+// `txSet` isn't a structurally valid v1 generalized tx set.
+std::optional<TxSetChunkManifest>
+makeTxSetChunkManifest(GeneralizedTransactionSet const& txSet,
+                       size_t maxChunkBytes);
+
+// Returns the transactions of `chunk` in `txSet`, which must be the tx set
+// the manifest was made from.
+TxSetChunkTxs getTxSetChunk(GeneralizedTransactionSet const& txSet,
+                            TxSetChunkInfo const& chunk);
+
+// Collects the chunks of a tx set, in any order, and rebuilds it once all of
+// them have arrived.
+class TxSetChunkAssembler
+{
+  public:
+    // Throws if the chunks of `manifest` don't fit its skeleton
+    explicit TxSetChunkAssembler(TxSetChunkManifest manifest);
+
+    TxSetChunkManifest const&
+    getManifest() const
+    {
+        return mManifest;
+    }
+
+    // Takes the transactions of chunk `index`. Returns false, keeping
+    // nothing, if they don't match the chunk's hash.
+    bool addChunk(size_t index, TxSetChunkTxs txs);
+
+    // Indices of the chunks that haven't arrived yet, in order
+    std::vector<size_t> getMissingChunks() const;
+
+    bool
+    isComplete() const
+    {
+        return mMissing == 0;
+    }
+
+    // Once complete, returns the tx set, or nullptr if it doesn't hash to the
+    // manifest's tx set hash (i.e. the manifest was bad).
+    TxSetXDRFrameConstPtr assemble() const;
+
+  private:
+    TxSetChunkManifest mManifest;
+    std::vector<std::optional<TxSetChunkTxs>> mChunks;
+    size_t mMissing;
+};
+}
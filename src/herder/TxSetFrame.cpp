@@ -25,9 +25,12 @@
 #include "util/XDROperators.h"
 #include "xdrpp/marshal.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <algorithm>
+#include <chrono>
 #include <list>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
 #include <numeric>
 #include <variant>
 
@@ -133,13 +136,16 @@ Hash
 computeNonGenericTxSetContentsHash(TransactionSet const& xdrTxSet)
 {
     ZoneScoped;
-    SHA256 hasher;
-    hasher.add(xdrTxSet.previousLedgerHash);
+    // A Hash is its own XDR, so this streams the same bytes as hashing the
+    // previous ledger hash followed by each serialized transaction
+    XDRSHA256 hasher;
+    xdr::archive(hasher, xdrTxSet.previousLedgerHash);
     for (auto const& tx : xdrTxSet.txs)
     {
-        hasher.add(xdr::xdr_to_opaque(tx));
+        xdr::archive(hasher, tx);
     }
-    return hasher.finish();
+    hasher.flush();
+    return hasher.state.finish();
 }
 
 // Note: Soroban txs also use this functionality for simplicity, as it's a no-op
@@ -226,15 +232,16 @@ transactionsToGeneralizedTransactionSetXDR(
 
 TxSetXDRFrame::TxSetXDRFrame(TransactionSet const& xdrTxSet)
     : mXDRTxSet(xdrTxSet)
-    , mEncodedSize(xdr::xdr_argpack_size(xdrTxSet))
+    , mEncoded(xdr::xdr_to_opaque(xdrTxSet))
     , mHash(computeNonGenericTxSetContentsHash(xdrTxSet))
 {
 }
 
 TxSetXDRFrame::TxSetXDRFrame(GeneralizedTransactionSet const& xdrTxSet)
     : mXDRTxSet(xdrTxSet)
-    , mEncodedSize(xdr::xdr_argpack_size(xdrTxSet))
-    , mHash(xdrSha256(xdrTxSet))
+    , mEncoded(xdr::xdr_to_opaque(xdrTxSet))
+    // Same as xdrSha256(xdrTxSet), without encoding the tx set again
+    , mHash(sha256(mEncoded))
 {
 }
 
@@ -277,7 +284,8 @@ makeTxSetFromTransactions(TxSetPhaseTransactions const& txPhases,
     TxSetPhaseTransactions invalidTxs;
     invalidTxs.resize(txPhases.size());
     return makeTxSetFromTransactions(txPhases, app, lowerBoundCloseTimeOffset,
-                                     upperBoundCloseTimeOffset, invalidTxs
+                                     upperBoundCloseTimeOffset, invalidTxs,
+                                     nullptr
 #ifdef BUILD_TESTS
                                      ,
                                      skipValidation
@@ -289,7 +297,9 @@ std::pair<TxSetXDRFrameConstPtr, ApplicableTxSetFrameConstPtr>
 makeTxSetFromTransactions(TxSetPhaseTransactions const& txPhases,
                           Application& app, uint64_t lowerBoundCloseTimeOffset,
                           uint64_t upperBoundCloseTimeOffset,
-                          TxSetPhaseTransactions& invalidTxs
+                          TxSetPhaseTransactions& invalidTxs,
+                          std::vector<UnorderedSet<Hash>> const*
+                              validatedTxsPerPhase
 #ifdef BUILD_TESTS
                           ,
                           bool skipValidation
@@ -297,6 +307,8 @@ makeTxSetFromTransactions(TxSetPhaseTransactions const& txPhases,
 )
 {
     releaseAssert(txPhases.size() == invalidTxs.size());
+    releaseAssert(!validatedTxsPerPhase ||
+                  validatedTxsPerPhase->size() == txPhases.size());
     releaseAssert(txPhases.size() <=
                   static_cast<size_t>(TxSetPhase::PHASE_COUNT));
 
@@ -323,8 +335,11 @@ makeTxSetFromTransactions(TxSetPhaseTransactions const& txPhases,
         {
 #endif
             validatedPhases.emplace_back(
-                TxSetUtils::trimInvalid(txs, app, lowerBoundCloseTimeOffset,
-                                        upperBoundCloseTimeOffset, invalid));
+                TxSetUtils::trimInvalid(
+                    txs, app, lowerBoundCloseTimeOffset,
+                    upperBoundCloseTimeOffset, invalid,
+                    validatedTxsPerPhase ? &validatedTxsPerPhase->at(i)
+                                         : nullptr));
 #ifdef BUILD_TESTS
         }
 #endif
@@ -458,7 +473,7 @@ makeTxSetFromTransactions(TxSetTransactions txs, Application& app,
     invalid.resize(phases.size());
     auto res = makeTxSetFromTransactions(phases, app, lowerBoundCloseTimeOffset,
                                          upperBoundCloseTimeOffset, invalid,
-                                         enforceTxsApplyOrder);
+                                         nullptr, enforceTxsApplyOrder);
     if (enforceTxsApplyOrder)
     {
         res.second->mApplyOrderOverride = txs;
@@ -497,6 +512,87 @@ TxSetXDRFrame::prepareForApply(Application& app) const
             new ApplicableTxSetFrame(*mApplicableTxSetOverride));
     }
 #endif
+    ZoneScoped;
+    releaseAssert(previousLedgerHash() ==
+                  app.getLedgerManager().getLastClosedLedgerHeader().hash);
+
+    std::shared_future<std::shared_ptr<ApplicableTxSetFrame const>> prepared;
+    {
+        std::lock_guard<std::mutex> guard(mPreparedMutex);
+        prepared = mPrepared;
+    }
+    if (prepared.valid())
+    {
+        // Interpreting again is quicker than waiting for a busy worker
+        if (prepared.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready)
+        {
+            app.getMetrics()
+                .NewMeter({"herder", "txset", "prepared-hit"}, "txset")
+                .Mark();
+            auto txSet = prepared.get();
+            if (!txSet)
+            {
+                return nullptr;
+            }
+            return ApplicableTxSetFrameConstPtr(
+                new ApplicableTxSetFrame(*txSet));
+        }
+        app.getMetrics()
+            .NewMeter({"herder", "txset", "prepared-miss"}, "txset")
+            .Mark();
+    }
+    return interpretTransactions(app.getNetworkID());
+}
+
+void
+TxSetXDRFrame::prepareForApplyInBackground(TxSetXDRFrameConstPtr const& txSet,
+                                           Application& app)
+{
+    ZoneScoped;
+    auto promise = std::make_shared<
+        std::promise<std::shared_ptr<ApplicableTxSetFrame const>>>();
+    {
+        std::lock_guard<std::mutex> guard(txSet->mPreparedMutex);
+        if (txSet->mPrepared.valid())
+        {
+            return;
+        }
+        txSet->mPrepared = promise->get_future().share();
+    }
+
+    app.postOnBackgroundThread(
+        [txSet, promise, networkID = app.getNetworkID()]() {
+            try
+            {
+                std::shared_ptr<ApplicableTxSetFrame const> res =
+                    txSet->interpretTransactions(networkID);
+                if (res)
+                {
+                    // Hashes are cached in the frames on first use, which
+                    // must not race with the main thread
+                    for (auto const& phase : res->mTxPhases)
+                    {
+                        for (auto const& tx : phase)
+                        {
+                            tx->getContentsHash();
+                            tx->getFullHash();
+                        }
+                    }
+                }
+                promise->set_value(res);
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        },
+        "prepareForApplyInBackground");
+}
+
+std::unique_ptr<ApplicableTxSetFrame>
+TxSetXDRFrame::interpretTransactions(Hash const& networkID) const
+{
     ZoneScoped;
     std::unique_ptr<ApplicableTxSetFrame> txSet{};
     if (isGeneralizedTxSet())
@@ -513,7 +609,7 @@ TxSetXDRFrame::prepareForApply(Application& app) const
         defaultPhases.resize(phases.size());
 
         txSet = std::unique_ptr<ApplicableTxSetFrame>(new ApplicableTxSetFrame(
-            app, true, previousLedgerHash(), defaultPhases, mHash));
+            true, previousLedgerHash(), defaultPhases, mHash));
         // Mark fees as already computed as we read them from the XDR.
         for (int i = 0; i < txSet->mFeesComputed.size(); i++)
         {
@@ -537,9 +633,8 @@ TxSetXDRFrame::prepareForApply(Application& app) const
                         baseFee = *component.txsMaybeDiscountedFee().baseFee;
                     }
                     if (!txSet->addTxsFromXdr(
-                            app.getNetworkID(),
-                            component.txsMaybeDiscountedFee().txs, true,
-                            baseFee, static_cast<TxSetPhase>(phaseId)))
+                            networkID, component.txsMaybeDiscountedFee().txs,
+                            true, baseFee, static_cast<TxSetPhase>(phaseId)))
                     {
                         CLOG_DEBUG(Herder,
                                    "Got bad generalized txSet: transactions "
@@ -556,8 +651,8 @@ TxSetXDRFrame::prepareForApply(Application& app) const
     {
         auto const& xdrTxSet = std::get<TransactionSet>(mXDRTxSet);
         txSet = std::unique_ptr<ApplicableTxSetFrame>(new ApplicableTxSetFrame(
-            app, false, previousLedgerHash(), {TxSetTransactions{}}, mHash));
-        if (!txSet->addTxsFromXdr(app.getNetworkID(), xdrTxSet.txs, false,
+            false, previousLedgerHash(), {TxSetTransactions{}}, mHash));
+        if (!txSet->addTxsFromXdr(networkID, xdrTxSet.txs, false,
                                   std::nullopt, TxSetPhase::CLASSIC))
         {
             CLOG_DEBUG(Herder,
@@ -699,7 +794,7 @@ TxSetXDRFrame::createTransactionFrames(Hash const& networkID) const
 size_t
 TxSetXDRFrame::encodedSize() const
 {
-    return mEncodedSize;
+    return mEncoded.size();
 }
 
 void
@@ -732,7 +827,24 @@ TxSetXDRFrame::storeXDR(StoredTransactionSet& txSet) const
     }
 }
 
-ApplicableTxSetFrame::ApplicableTxSetFrame(Application& app, bool isGeneralized,
+xdr::opaque_vec<> const&
+TxSetXDRFrame::getEncoded() const
+{
+    return mEncoded;
+}
+
+xdr::opaque_vec<>
+TxSetXDRFrame::encodeStored() const
+{
+    // The encoding of a union is the encoding of its discriminant followed by
+    // the encoding of the active arm
+    int32_t v = isGeneralizedTxSet() ? 1 : 0;
+    auto res = xdr::xdr_to_opaque(v);
+    res.insert(res.end(), mEncoded.begin(), mEncoded.end());
+    return res;
+}
+
+ApplicableTxSetFrame::ApplicableTxSetFrame(bool isGeneralized,
                                            Hash const& previousLedgerHash,
                                            TxSetPhaseTransactions const& txs,
                                            std::optional<Hash> contentsHash)
@@ -742,6 +854,14 @@ ApplicableTxSetFrame::ApplicableTxSetFrame(Application& app, bool isGeneralized,
     , mFeesComputed(mTxPhases.size(), false)
     , mPhaseInclusionFeeMap(mTxPhases.size())
     , mContentsHash(contentsHash)
+{
+}
+
+ApplicableTxSetFrame::ApplicableTxSetFrame(Application& app, bool isGeneralized,
+                                           Hash const& previousLedgerHash,
+                                           TxSetPhaseTransactions const& txs,
+                                           std::optional<Hash> contentsHash)
+    : ApplicableTxSetFrame(isGeneralized, previousLedgerHash, txs, contentsHash)
 {
     releaseAssert(previousLedgerHash ==
                   app.getLedgerManager().getLastClosedLedgerHeader().hash);
@@ -1148,6 +1268,10 @@ std::optional<int64_t>
 ApplicableTxSetFrame::getTxBaseFee(TransactionFrameBaseConstPtr const& tx,
                                    LedgerHeader const& lclHeader) const
 {
+    if (mApplyFeesHeader)
+    {
+        return getTxApplyFees(tx).mBaseFee;
+    }
     if (std::any_of(mFeesComputed.begin(), mFeesComputed.end(),
                     [](bool comp) { return !comp; }))
     {
@@ -1165,6 +1289,52 @@ ApplicableTxSetFrame::getTxBaseFee(TransactionFrameBaseConstPtr const& tx,
     return std::nullopt;
 }
 
+void
+ApplicableTxSetFrame::prepareApplyFees(Application& app,
+                                       LedgerHeader const& lclHeader) const
+{
+    ZoneScoped;
+    mApplyFeesHeader.reset();
+    mApplyFees.clear();
+    mApplyFeeIndex.clear();
+    mApplyFees.reserve(sizeTxTotal());
+    mApplyFeeIndex.reserve(sizeTxTotal());
+    bool sorobanEnabled = protocolVersionStartsFrom(lclHeader.ledgerVersion,
+                                                    SOROBAN_PROTOCOL_VERSION);
+    for (auto const& phase : mTxPhases)
+    {
+        for (auto const& tx : phase)
+        {
+            auto& fees = mApplyFees.emplace_back();
+            fees.mBaseFee = getTxBaseFee(tx, lclHeader);
+            fees.mFee = tx->getFee(lclHeader, fees.mBaseFee, true);
+            if (sorobanEnabled && tx->isSoroban())
+            {
+                fees.mSorobanResourceFee =
+                    tx->computePreApplySorobanResourceFee(
+                        lclHeader.ledgerVersion,
+                        app.getLedgerManager().getSorobanNetworkConfig(),
+                        app.getConfig());
+            }
+            mApplyFeeIndex.emplace(tx.get(), mApplyFees.size() - 1);
+        }
+    }
+    mApplyFeesHeader.emplace(lclHeader.ledgerVersion, lclHeader.baseFee);
+}
+
+ApplicableTxSetFrame::TxApplyFees const&
+ApplicableTxSetFrame::getTxApplyFees(
+    TransactionFrameBaseConstPtr const& tx) const
+{
+    releaseAssert(mApplyFeesHeader);
+    auto it = mApplyFeeIndex.find(tx.get());
+    if (it == mApplyFeeIndex.end())
+    {
+        throw std::runtime_error("Transaction not found in tx set");
+    }
+    return mApplyFees[it->second];
+}
+
 std::optional<Resource>
 ApplicableTxSetFrame::getTxSetSorobanResource() const
 {
@@ -1189,6 +1359,15 @@ ApplicableTxSetFrame::getTotalFees(LedgerHeader const& lh) const
 {
     ZoneScoped;
     int64_t total{0};
+    if (mApplyFeesHeader &&
+        *mApplyFeesHeader == std::make_pair(lh.ledgerVersion, lh.baseFee))
+    {
+        for (auto const& fees : mApplyFees)
+        {
+            total += fees.mFee;
+        }
+        return total;
+    }
     std::for_each(mTxPhases.begin(), mTxPhases.end(),
                   [&](TxSetTransactions const& phase) {
                       total += std::accumulate(
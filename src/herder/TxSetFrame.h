@@ -13,6 +13,8 @@
 
 #include <deque>
 #include <functional>
+#include <future>
+#include <mutex>
 #include <optional>
 #include <unordered_map>
 #include <variant>
@@ -36,6 +38,12 @@ enum class TxSetPhase
 using TxSetTransactions = std::vector<TransactionFrameBasePtr>;
 using TxSetPhaseTransactions = std::vector<TxSetTransactions>;
 
+// Indices of transactions in the apply order of a tx set (see
+// `TxSetUtils::buildApplyStages`), in increasing order.
+using TxApplyCluster = std::vector<size_t>;
+// Clusters that can be applied concurrently, ordered by their first index.
+using TxApplyStage = std::vector<TxApplyCluster>;
+
 std::string getTxSetPhaseName(TxSetPhase phase);
 
 // Creates a valid ApplicableTxSetFrame and corresponding TxSetXDRFrame
@@ -62,11 +70,15 @@ makeTxSetFromTransactions(
     bool skipValidation = false
 #endif
 );
+// `validatedTxsPerPhase`, if set, has the hashes of the transactions of every
+// phase that are already known to be valid (see
+// `TxSetUtils::getInvalidTxList`).
 std::pair<TxSetXDRFrameConstPtr, ApplicableTxSetFrameConstPtr>
 makeTxSetFromTransactions(
     TxSetPhaseTransactions const& txPhases, Application& app,
     uint64_t lowerBoundCloseTimeOffset, uint64_t upperBoundCloseTimeOffset,
-    TxSetPhaseTransactions& invalidTxsPerPhase
+    TxSetPhaseTransactions& invalidTxsPerPhase,
+    std::vector<UnorderedSet<Hash>> const* validatedTxsPerPhase = nullptr
 #ifdef BUILD_TESTS
     // Skips the tx set validation and preserves the pointers
     // to the passed-in transactions - use in conjunction with
@@ -130,6 +142,13 @@ class TxSetXDRFrame : public NonMovableOrCopyable
     void toXDR(GeneralizedTransactionSet& generalizedTxSet) const;
     void storeXDR(StoredTransactionSet& txSet) const;
 
+    // Returns the XDR encoding of this tx set. It is computed once when the
+    // frame is created, so this never re-encodes the tx set.
+    xdr::opaque_vec<> const& getEncoded() const;
+    // Returns the XDR encoding of the `StoredTransactionSet` that `storeXDR`
+    // would produce, built from `getEncoded()`.
+    xdr::opaque_vec<> encodeStored() const;
+
     ~TxSetXDRFrame() = default;
 
     // Interprets this transaction set using the current ledger state and
@@ -145,8 +164,18 @@ class TxSetXDRFrame : public NonMovableOrCopyable
     // This may *only* be called when LCL hash matches the `previousLedgerHash`
     // of this `TxSetFrame` - tx sets with a wrong ledger hash shouldn't even
     // be attempted to be interpreted.
+    //
+    // If `prepareForApplyInBackground` has finished interpreting this tx set,
+    // this returns a copy of its result, which shares the transaction frames.
     ApplicableTxSetFrameConstPtr prepareForApply(Application& app) const;
 
+    // Starts interpreting `txSet` on a background thread: building its
+    // transaction frames, hashing them and checking their order. Unlike
+    // `prepareForApply` this doesn't depend on the LCL, so it can start as
+    // soon as the tx set is received. Does nothing if already started.
+    static void prepareForApplyInBackground(TxSetXDRFrameConstPtr const& txSet,
+                                            Application& app);
+
     bool isGeneralizedTxSet() const;
 
     // Returns the hash of this tx set.
@@ -182,9 +211,18 @@ class TxSetXDRFrame : public NonMovableOrCopyable
     TxSetXDRFrame(TransactionSet const& xdrTxSet);
     TxSetXDRFrame(GeneralizedTransactionSet const& xdrTxSet);
 
+    // The part of `prepareForApply` that doesn't depend on the LCL
+    std::unique_ptr<ApplicableTxSetFrame>
+    interpretTransactions(Hash const& networkID) const;
+
     std::variant<TransactionSet, GeneralizedTransactionSet> mXDRTxSet;
-    size_t mEncodedSize{};
+    xdr::opaque_vec<> const mEncoded;
     Hash mHash;
+
+    // Set by `prepareForApplyInBackground`; holds nullptr for malformed sets
+    mutable std::mutex mPreparedMutex;
+    mutable std::shared_future<std::shared_ptr<ApplicableTxSetFrame const>>
+        mPrepared;
 };
 
 // Transaction set that is suitable for being applied to the ledger.
@@ -199,11 +237,31 @@ class TxSetXDRFrame : public NonMovableOrCopyable
 class ApplicableTxSetFrame
 {
   public:
+    // Fees of a transaction when applying the set
+    struct TxApplyFees
+    {
+        // std::nullopt when the transaction is not discounted
+        std::optional<int64_t> mBaseFee;
+        // Fee charged before any refund
+        int64_t mFee;
+        // Set for Soroban transactions
+        std::optional<FeePair> mSorobanResourceFee;
+    };
+
     // Returns the base fee for the transaction or std::nullopt when the
     // transaction is not discounted.
     std::optional<int64_t> getTxBaseFee(TransactionFrameBaseConstPtr const& tx,
                                         LedgerHeader const& lclHeader) const;
 
+    // Computes the fees of all the transactions for applying the set on top
+    // of `lclHeader` with the current network config, once, into a table
+    // that `getTxApplyFees`, `getTxBaseFee` and `getTotalFees` then read.
+    void prepareApplyFees(Application& app,
+                          LedgerHeader const& lclHeader) const;
+    // Requires `prepareApplyFees`
+    TxApplyFees const&
+    getTxApplyFees(TransactionFrameBaseConstPtr const& tx) const;
+
     // Gets all the transactions belonging to this frame in arbitrary order.
     TxSetTransactions const& getTxsForPhase(TxSetPhase phase) const;
 
@@ -276,7 +334,9 @@ class ApplicableTxSetFrame
                               Application& app,
                               uint64_t lowerBoundCloseTimeOffset,
                               uint64_t upperBoundCloseTimeOffset,
-                              TxSetPhaseTransactions& invalidTxsPerPhase
+                              TxSetPhaseTransactions& invalidTxsPerPhase,
+                              std::vector<UnorderedSet<Hash>> const*
+                                  validatedTxsPerPhase
 #ifdef BUILD_TESTS
                               ,
                               bool skipValidation
@@ -299,6 +359,11 @@ class ApplicableTxSetFrame
                          Hash const& previousLedgerHash,
                          TxSetPhaseTransactions const& txs,
                          std::optional<Hash> contentsHash);
+    // Doesn't check `previousLedgerHash` against the LCL, so that tx sets can
+    // be interpreted off the main thread
+    ApplicableTxSetFrame(bool isGeneralized, Hash const& previousLedgerHash,
+                         TxSetPhaseTransactions const& txs,
+                         std::optional<Hash> contentsHash);
     ApplicableTxSetFrame(ApplicableTxSetFrame const&) = default;
     ApplicableTxSetFrame(ApplicableTxSetFrame&&) = default;
     // Computes the fees for transactions in this set based on information from
@@ -349,6 +414,13 @@ class ApplicableTxSetFrame
         mPhaseInclusionFeeMap;
 
     std::optional<Hash> mContentsHash;
+
+    // Set by `prepareApplyFees`, along with the ledger version and base fee
+    // the fees were computed for
+    mutable std::vector<TxApplyFees> mApplyFees;
+    mutable std::unordered_map<TransactionFrameBase const*, size_t>
+        mApplyFeeIndex;
+    mutable std::optional<std::pair<uint32_t, uint32_t>> mApplyFeesHeader;
 #ifdef BUILD_TESTS
     mutable std::optional<TxSetTransactions> mApplyOrderOverride;
 #endif
@@ -4,10 +4,14 @@
 
 #include "util/asio.h"
 #include "TxSetUtils.h"
+#include "bucket/BucketListSnapshot.h"
+#include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
 #include "crypto/Hex.h"
 #include "crypto/Random.h"
 #include "crypto/SHA.h"
 #include "database/Database.h"
+#include "herder/Herder.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
@@ -17,13 +21,14 @@
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/ParallelFor.h"
 #include "util/ProtocolVersion.h"
 #include "util/UnorderedSet.h"
 #include "util/XDRCereal.h"
 #include "util/XDROperators.h"
 #include "xdrpp/marshal.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <algorithm>
 #include <list>
 #include <numeric>
@@ -32,6 +37,82 @@ namespace stellar
 {
 namespace
 {
+// Smallest number of transactions for which verifySignaturesInParallel is
+// worth the overhead of dispatching to the worker threads
+size_t const MIN_TXS_FOR_PARALLEL_SIGNATURES = 64;
+
+// Number of envelopes a thread claims at a time in
+// verifySignaturesInParallel
+size_t const PARALLEL_SIGNATURES_BATCH_SIZE = 32;
+
+// Splits the Soroban transactions txs[begin, end) into clusters of
+// transactions that access common ledger entries, directly or through other
+// transactions of the cluster
+TxApplyStage
+buildSorobanApplyClusters(TxSetTransactions const& txs, size_t begin,
+                          size_t end)
+{
+    // Union-find over the transactions, rooted at the first transaction of
+    // every cluster
+    std::vector<size_t> parent(end - begin);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](size_t i) {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    // Joins every transaction with the last transaction that accessed the
+    // same entry
+    UnorderedMap<LedgerKey, size_t> lastAccess;
+    auto access = [&](LedgerKey const& key, size_t i) {
+        auto res = lastAccess.emplace(key, i);
+        if (!res.second)
+        {
+            auto a = find(res.first->second);
+            auto b = find(i);
+            parent[std::max(a, b)] = std::min(a, b);
+            res.first->second = i;
+        }
+    };
+
+    for (size_t i = 0; i < end - begin; ++i)
+    {
+        auto const& tx = txs[begin + i];
+        releaseAssert(tx->isSoroban());
+        UnorderedSet<LedgerKey> keys;
+        keys.emplace(accountKey(tx->getSourceID()));
+        tx->insertKeysForFeeProcessing(keys);
+        tx->insertKeysForTxApply(keys);
+        auto const& footprint = tx->sorobanResources().footprint;
+        keys.insert(footprint.readOnly.begin(), footprint.readOnly.end());
+        keys.insert(footprint.readWrite.begin(), footprint.readWrite.end());
+        for (auto const& key : keys)
+        {
+            access(key, i);
+        }
+    }
+
+    // Roots are the smallest index of their cluster, so clusters come out
+    // ordered by their first transaction
+    TxApplyStage clusters;
+    std::vector<size_t> clusterOfRoot(end - begin);
+    for (size_t i = 0; i < end - begin; ++i)
+    {
+        auto root = find(i);
+        if (root == i)
+        {
+            clusterOfRoot[i] = clusters.size();
+            clusters.emplace_back();
+        }
+        clusters[clusterOfRoot[root]].emplace_back(begin + i);
+    }
+    return clusters;
+}
+
 // Target use case is to remove a subset of invalid transactions from a TxSet.
 // I.e. txSet.size() >= txsToRemove.size()
 TxSetTransactions
@@ -58,6 +139,48 @@ removeTxs(TxSetTransactions const& txs, TxSetTransactions const& txsToRemove)
 }
 } // namespace
 
+void
+TxSetUtils::verifySignaturesInParallel(TxSetTransactions const& txs,
+                                       Application& app)
+{
+    ZoneScoped;
+
+    // Copied out of the transactions, which are not thread safe
+    std::vector<EnvelopeSignatures> envelopes;
+    for (auto const& tx : txs)
+    {
+        tx->insertSignaturesToVerify(envelopes);
+    }
+    bool loadSigners = app.getConfig().isUsingBucketListDB();
+
+    parallelForBatches(
+        app, envelopes.size(), PARALLEL_SIGNATURES_BATCH_SIZE,
+        [&](size_t, size_t begin, size_t end) {
+            try
+            {
+                std::shared_ptr<SearchableBucketListSnapshot> snapshot;
+                if (loadSigners)
+                {
+                    snapshot = app.getBucketManager()
+                                   .getBucketSnapshotManager()
+                                   .getSearchableBucketListSnapshot();
+                }
+                preVerifySignatures(envelopes, begin, end, snapshot.get());
+            }
+            catch (std::exception const& e)
+            {
+                // checkValid verifies whatever could not be verified here
+                CLOG_WARNING(Herder, "Signature verification failed: {}",
+                             e.what());
+            }
+            catch (...)
+            {
+                CLOG_WARNING(Herder, "Signature verification failed");
+            }
+        },
+        "TxSetUtils: verify signatures", BackgroundPriority::HIGH);
+}
+
 AccountTransactionQueue::AccountTransactionQueue(
     std::vector<TransactionFrameBasePtr> const& accountTxs)
     : mTxs(accountTxs.begin(), accountTxs.end())
@@ -158,7 +281,8 @@ TxSetTransactions
 TxSetUtils::getInvalidTxList(TxSetTransactions const& txs, Application& app,
                              uint64_t lowerBoundCloseTimeOffset,
                              uint64_t upperBoundCloseTimeOffset,
-                             bool returnEarlyOnFirstInvalidTx)
+                             bool returnEarlyOnFirstInvalidTx,
+                             UnorderedSet<Hash> const* validatedTxs)
 {
     ZoneScoped;
     LedgerTxn ltx(app.getLedgerTxnRoot(), /* shouldUpdateLastModified */ true,
@@ -172,6 +296,27 @@ TxSetUtils::getInvalidTxList(TxSetTransactions const& txs, Application& app,
             app.getLedgerManager().getLastClosedLedgerNum() + 1;
     }
 
+    if (app.getConfig().EXPERIMENTAL_PARALLEL_TX_SET_VALIDATION)
+    {
+        TxSetTransactions toVerify;
+        for (auto const& tx : txs)
+        {
+            if (!validatedTxs || validatedTxs->count(tx->getFullHash()) == 0)
+            {
+                toVerify.emplace_back(tx);
+            }
+        }
+        if (toVerify.size() >= MIN_TXS_FOR_PARALLEL_SIGNATURES)
+        {
+            // Validated against the current sequence numbers of their
+            // accounts, which checkValid below then only confirms for the
+            // first transaction of each account; the others still have their
+            // signatures verified ahead of time
+            app.getHerder().getTxValidationService().validate(
+                toVerify, lowerBoundCloseTimeOffset, upperBoundCloseTimeOffset);
+        }
+    }
+
     UnorderedMap<AccountID, int64_t> accountFeeMap;
     TxSetTransactions invalidTxs;
 
@@ -189,9 +334,16 @@ TxSetUtils::getInvalidTxList(TxSetTransactions const& txs, Application& app,
             bool minSeqCheckIsInvalid =
                 iter != accountQueue->mTxs.begin() &&
                 (tx->getMinSeqAge() != 0 || tx->getMinSeqLedgerGap() != 0);
+            // A validated transaction was checked against the current
+            // sequence number of its account, so this only holds for the
+            // first transaction of the account
+            bool knownValid = validatedTxs &&
+                              iter == accountQueue->mTxs.begin() &&
+                              validatedTxs->count(tx->getFullHash()) != 0;
             if (minSeqCheckIsInvalid ||
-                !tx->checkValid(app, ltx, lastSeq, lowerBoundCloseTimeOffset,
-                                upperBoundCloseTimeOffset))
+                (!knownValid &&
+                 !tx->checkValid(app, ltx, lastSeq, lowerBoundCloseTimeOffset,
+                                 upperBoundCloseTimeOffset)))
             {
                 invalidTxs.emplace_back(tx);
                 iter = accountQueue->mTxs.erase(iter);
@@ -271,14 +423,48 @@ TxSetUtils::getInvalidTxList(TxSetTransactions const& txs, Application& app,
     return invalidTxs;
 }
 
+std::vector<TxApplyStage>
+TxSetUtils::buildApplyStages(TxSetTransactions const& txsInApplyOrder)
+{
+    ZoneScoped;
+    std::vector<TxApplyStage> stages;
+    size_t begin = 0;
+    while (begin < txsInApplyOrder.size())
+    {
+        bool isSoroban = txsInApplyOrder[begin]->isSoroban();
+        auto end = begin + 1;
+        while (end < txsInApplyOrder.size() &&
+               txsInApplyOrder[end]->isSoroban() == isSoroban)
+        {
+            ++end;
+        }
+
+        if (isSoroban)
+        {
+            stages.emplace_back(
+                buildSorobanApplyClusters(txsInApplyOrder, begin, end));
+        }
+        else
+        {
+            TxApplyCluster cluster(end - begin);
+            std::iota(cluster.begin(), cluster.end(), begin);
+            stages.emplace_back(TxApplyStage{std::move(cluster)});
+        }
+        begin = end;
+    }
+    return stages;
+}
+
 TxSetTransactions
 TxSetUtils::trimInvalid(TxSetTransactions const& txs, Application& app,
                         uint64_t lowerBoundCloseTimeOffset,
                         uint64_t upperBoundCloseTimeOffset,
-                        TxSetTransactions& invalidTxs)
+                        TxSetTransactions& invalidTxs,
+                        UnorderedSet<Hash> const* validatedTxs)
 {
     invalidTxs = getInvalidTxList(txs, app, lowerBoundCloseTimeOffset,
-                                  upperBoundCloseTimeOffset, false);
+                                  upperBoundCloseTimeOffset, false,
+                                  validatedTxs);
     return removeTxs(txs, invalidTxs);
 }
 
@@ -6,6 +6,7 @@
 
 #include "herder/TxSetFrame.h"
 #include "util/UnorderedMap.h"
+#include "util/UnorderedSet.h"
 #include "xdr/Stellar-types.h"
 #include <ledger/LedgerHashUtils.h>
 #include <tuple>
@@ -47,16 +48,51 @@ class TxSetUtils
     // returnEarlyOnFirstInvalidTx is true, return immediately if an invalid
     // transaction is found (instead of finding all of them), this is useful for
     // checking if a TxSet is valid.
+    //
+    // Transactions whose hashes are in validatedTxs are known to pass
+    // checkValid against the last closed ledger with these close time offsets
+    // (see TransactionQueue::getValidatedTxHashes): unless other transactions
+    // of their source account precede them, only their fees are checked.
     static TxSetTransactions
     getInvalidTxList(TxSetTransactions const& txs, Application& app,
                      uint64_t lowerBoundCloseTimeOffset,
                      uint64_t upperBoundCloseTimeOffset,
-                     bool returnEarlyOnFirstInvalidTx);
+                     bool returnEarlyOnFirstInvalidTx,
+                     UnorderedSet<Hash> const* validatedTxs = nullptr);
 
-    static TxSetTransactions trimInvalid(TxSetTransactions const& txs,
-                                         Application& app,
-                                         uint64_t lowerBoundCloseTimeOffset,
-                                         uint64_t upperBoundCloseTimeOffset,
-                                         TxSetTransactions& invalidTxs);
+    // Verifies the signatures of txs on the worker threads and on the calling
+    // thread, which fills the signature verification cache for the checkValid
+    // calls that follow. Each signature is tried against the master keys of
+    // the accounts it may belong to and, if BucketListDB is in use, against
+    // their other ed25519 signers as loaded from a bucket list snapshot.
+    // Verification results are only cached, so any signature missed here is
+    // simply verified again by checkValid.
+    static void verifySignaturesInParallel(TxSetTransactions const& txs,
+                                           Application& app);
+
+    static TxSetTransactions
+    trimInvalid(TxSetTransactions const& txs, Application& app,
+                uint64_t lowerBoundCloseTimeOffset,
+                uint64_t upperBoundCloseTimeOffset,
+                TxSetTransactions& invalidTxs,
+                UnorderedSet<Hash> const* validatedTxs = nullptr);
+
+    // Splits `txsInApplyOrder` (as returned by
+    // `ApplicableTxSetFrame::getTxsInApplyOrder`) into stages that have to be
+    // applied one after the other. The clusters of a stage can be applied
+    // concurrently, as no two transactions from different clusters access the
+    // same ledger entry; transactions of a cluster have to be applied in order.
+    // Results and meta can then be emitted by transaction index to match the
+    // serial apply order.
+    //
+    // Only Soroban transactions declare every entry they may access: their
+    // footprint, and their source accounts for fees and refunds. Read-only
+    // footprint entries count as accessed too, as their TTL may be extended.
+    // Classic transactions may update entries that appear nowhere in them
+    // (e.g. the sponsors of removed entries or the offers crossed by path
+    // payments), so every run of classic transactions is a stage made of a
+    // single cluster.
+    static std::vector<TxApplyStage>
+    buildApplyStages(TxSetTransactions const& txsInApplyOrder);
 }; // class TxSetUtils
 } // namespace stellar
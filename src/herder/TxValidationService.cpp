@@ -0,0 +1,144 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/TxValidationService.h"
+#include "bucket/BucketListSnapshot.h"
+#include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
+#include "herder/TxSetUtils.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnHeader.h"
+#include "ledger/SnapshotLedgerTxnRoot.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/ParallelFor.h"
+#include "util/ProtocolVersion.h"
+
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "util/Tracing.h"
+#include <atomic>
+#include <optional>
+
+namespace stellar
+{
+namespace
+{
+// Number of transactions a worker claims at once
+size_t const PARALLEL_VALIDATION_BATCH_SIZE = 16;
+}
+
+size_t const TxValidationService::MIN_TXS_FOR_PARALLEL_VALIDATION = 32;
+
+TxValidationService::TxValidationService(Application& app)
+    : mApp(app)
+    , mValidated(app.getMetrics().NewMeter(
+          {"herder", "tx-validation", "validated"}, "transaction"))
+    , mSkipped(app.getMetrics().NewMeter({"herder", "tx-validation", "skipped"},
+                                         "transaction"))
+{
+}
+
+std::vector<bool>
+TxValidationService::validate(TxSetTransactions const& txs,
+                              uint64_t lowerBoundCloseTimeOffset,
+                              uint64_t upperBoundCloseTimeOffset)
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+
+    if (!mApp.getConfig().isUsingBucketListDB())
+    {
+        // Without BucketListDB ledger entries can only be loaded from the
+        // database on the main thread: only verify signatures ahead of time
+        TxSetUtils::verifySignaturesInParallel(txs, mApp);
+        mSkipped.Mark(txs.size());
+        return std::vector<bool>(txs.size(), false);
+    }
+
+    auto lclHeader = mApp.getLedgerManager().getLastClosedLedgerHeader().header;
+    auto ledgerSeq = lclHeader.ledgerSeq;
+    if (protocolVersionStartsFrom(lclHeader.ledgerVersion,
+                                  ProtocolVersion::V_19))
+    {
+        // As TransactionQueue does, so minSeqLedgerGap is validated against
+        // the next ledgerSeq, which is what will be used at apply time
+        ++ledgerSeq;
+    }
+    auto sorobanConfig =
+        mApp.getLedgerManager().getSorobanNetworkConfigSnapshot();
+    // Not std::vector<bool>, as workers write it concurrently
+    std::vector<uint8_t> valid(txs.size(), 0);
+    std::atomic<size_t> skipped{0};
+
+    auto validateBatch = [&](size_t begin, size_t end) {
+        auto snapshot = mApp.getBucketManager()
+                            .getBucketSnapshotManager()
+                            .getSearchableBucketListSnapshot();
+        SnapshotLedgerTxnRoot root(*snapshot, lclHeader);
+        std::optional<ScopedSorobanNetworkConfig> scopedConfig;
+        if (sorobanConfig)
+        {
+            scopedConfig.emplace(sorobanConfig);
+        }
+
+        for (auto i = begin; i < end; ++i)
+        {
+            auto const& tx = txs[i];
+            if (tx->isSoroban() && !sorobanConfig)
+            {
+                ++skipped;
+                continue;
+            }
+            try
+            {
+                LedgerTxn ltx(root, /* shouldUpdateLastModified */ true,
+                              TransactionMode::READ_ONLY_WITHOUT_SQL_TXN);
+                ltx.loadHeader().current().ledgerSeq = ledgerSeq;
+                valid[i] = tx->checkValid(mApp, ltx, 0,
+                                          lowerBoundCloseTimeOffset,
+                                          upperBoundCloseTimeOffset);
+            }
+            catch (SnapshotLedgerTxnRoot::StaleSnapshot const&)
+            {
+                // A ledger closed in the meantime: the main thread validates
+                // the rest against the new one
+                skipped += end - i;
+                return;
+            }
+            catch (std::exception const& e)
+            {
+                // checkValid on the main thread validates it again
+                CLOG_WARNING(Herder, "Transaction validation failed: {}",
+                             e.what());
+                ++skipped;
+            }
+        }
+    };
+
+    parallelForBatches(
+        mApp, txs.size(), PARALLEL_VALIDATION_BATCH_SIZE,
+        [&](size_t, size_t begin, size_t end) {
+            try
+            {
+                validateBatch(begin, end);
+            }
+            catch (std::exception const& e)
+            {
+                // checkValid on the main thread validates whatever could not
+                // be validated here
+                CLOG_WARNING(Herder, "Transaction validation failed: {}",
+                             e.what());
+            }
+        },
+        "TxValidationService: validate", BackgroundPriority::HIGH);
+
+    mSkipped.Mark(skipped);
+    mValidated.Mark(txs.size() - skipped);
+    return std::vector<bool>(valid.begin(), valid.end());
+}
+}
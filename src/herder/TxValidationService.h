@@ -0,0 +1,54 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/TxSetFrame.h"
+#include "util/NonCopyable.h"
+#include <cstdint>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+class Application;
+
+// Validates batches of transactions on the worker pool, each against a bucket
+// list snapshot of the last closed ledger (see SnapshotLedgerTxnRoot) and the
+// Soroban network config of that ledger, instead of one by one against
+// LedgerTxnRoot on the main thread.
+//
+// A transaction validated this way keeps the digest of the state it was
+// validated against (see TransactionFrame::checkValid), so validating it again
+// on the main thread against the same ledger state only checks that its
+// accounts did not change in between, e.g. that nothing else used its
+// sequence number first, and otherwise validates it in full. Callers
+// therefore still validate every transaction on the main thread, cheaply.
+class TxValidationService : public NonMovableOrCopyable
+{
+    Application& mApp;
+    medida::Meter& mValidated;
+    medida::Meter& mSkipped;
+
+  public:
+    // Smallest batch worth handing to the worker pool
+    static size_t const MIN_TXS_FOR_PARALLEL_VALIDATION;
+
+    explicit TxValidationService(Application& app);
+
+    // Validates each of `txs` as TransactionQueue does, i.e. against the
+    // current sequence number of its source account, on the worker pool and
+    // the calling thread, which must be the main thread. Returns whether each
+    // transaction was found valid; transactions that could not be validated
+    // off the main thread (without BucketListDB, or once the snapshot is
+    // stale) are reported invalid and only have their signatures verified.
+    std::vector<bool> validate(TxSetTransactions const& txs,
+                               uint64_t lowerBoundCloseTimeOffset,
+                               uint64_t upperBoundCloseTimeOffset);
+};
+}
@@ -7,6 +7,7 @@
 #include "herder/test/TestTxSetUtils.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "main/PersistentState.h"
 #include "scp/SCP.h"
 #include "simulation/Simulation.h"
 #include "simulation/Topologies.h"
@@ -1637,6 +1638,65 @@ TEST_CASE("tx set hits overlay byte limit during construction",
     }
 }
 
+TEST_CASE("txset signatures verified in parallel", "[herder][txset]")
+{
+    auto test = [](bool useBucketListDB) {
+        VirtualClock clock;
+        Config cfg(getTestConfig());
+        cfg.EXPERIMENTAL_PARALLEL_TX_SET_VALIDATION = true;
+        cfg.DEPRECATED_SQL_LEDGER_STATE = !useBucketListDB;
+        Application::pointer app = createTestApplication(clock, cfg);
+        auto& lm = app->getLedgerManager();
+        auto root = TestAccount::createRoot(*app);
+
+        int const nbAccounts = 100;
+        std::vector<TestAccount> accs;
+        for (int i = 0; i < nbAccounts; ++i)
+        {
+            accs.emplace_back(root.create(fmt::format("A{}", i),
+                                          lm.getLastMinBalance(2)));
+        }
+
+        // The first transaction is only signed by an extra signer of its
+        // source account, which can only be found with BucketListDB
+        auto signer = getAccount("signer");
+        accs[0].setOptions(setSigner(makeSigner(signer, 1)));
+
+        TxSetTransactions txs;
+        for (auto& acc : accs)
+        {
+            auto tx = acc.tx({payment(root, 1)});
+            if (txs.empty())
+            {
+                getSignatures(tx).clear();
+                tx->addSignature(signer);
+            }
+            txs.emplace_back(tx);
+        }
+
+        uint64_t hits, misses;
+        PubKeyUtils::clearVerifySigCache();
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+        REQUIRE(TxSetUtils::getInvalidTxList(txs, *app, 0, 0, false).empty());
+
+        // Every signature was verified once, and validation found the ones
+        // verified in parallel in the cache
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        REQUIRE(misses == nbAccounts);
+        REQUIRE(hits >= (useBucketListDB ? nbAccounts : nbAccounts - 1));
+    };
+
+    SECTION("SQL")
+    {
+        test(false);
+    }
+    SECTION("BucketListDB")
+    {
+        test(true);
+    }
+}
+
 TEST_CASE("surge pricing", "[herder][txset][soroban]")
 {
     SECTION("protocol 19")
@@ -3933,6 +3993,35 @@ TEST_CASE("overlay parallel processing")
     REQUIRE(secondLoadGenFailed.count() == 0);
 }
 
+TEST_CASE("tx sets prepared speculatively", "[herder]")
+{
+    auto networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto simulation =
+        Topologies::core(4, 1, Simulation::OVER_LOOPBACK, networkID, [](int i) {
+            auto cfg = getTestConfig(i);
+            cfg.EXPERIMENTAL_SPECULATIVE_TX_SET_PREPARATION = true;
+            return cfg;
+        });
+    simulation->startAllNodes();
+    auto nodes = simulation->getNodes();
+
+    // Some load so the tx sets aren't empty
+    auto& loadGen = nodes[0]->getLoadGenerator();
+    auto& loadGenDone =
+        nodes[0]->getMetrics().NewMeter({"loadgen", "run", "complete"}, "run");
+    loadGen.generateLoad(GeneratedLoadConfig::createAccountsLoad(50, 5));
+    simulation->crankUntil([&]() { return loadGenDone.count() > 0; },
+                           20 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+    // Every node prepared the tx set it then externalized, at least once
+    for (auto const& node : nodes)
+    {
+        auto& hit = node->getMetrics().NewMeter(
+            {"scp", "speculative", "hit"}, "ledger");
+        REQUIRE(hit.count() > 0);
+    }
+}
+
 TEST_CASE("soroban txs accepted by the network",
           "[herder][soroban][transactionqueue]")
 {
@@ -4659,6 +4748,48 @@ TEST_CASE("herder externalizes values", "[herder]")
     }
 }
 
+TEST_CASE("SCP phase timing", "[herder]")
+{
+    auto networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto simulation =
+        Topologies::core(4, 1, Simulation::OVER_LOOPBACK, networkID,
+                         [](int i) { return getTestConfig(i); });
+    simulation->startAllNodes();
+    auto nodes = simulation->getNodes();
+    auto lcl = nodes[0]->getLedgerManager().getLastClosedLedgerNum();
+    simulation->crankUntil(
+        [&]() { return simulation->haveAllExternalized(lcl + 3, 1); },
+        5 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+    auto slot = std::to_string(lcl + 2);
+    bool anyNominated = false;
+    for (auto const& node : nodes)
+    {
+        auto timing = node->getHerder().getJsonSCPTimingInfo(5);
+        REQUIRE(timing.isMember(slot));
+        auto const& t = timing[slot];
+        REQUIRE(t["timer_driven_advances"].asInt64() +
+                    t["message_driven_advances"].asInt64() >
+                0);
+        if (t.isMember("externalize_ms"))
+        {
+            // Phases may be skipped when messages from others get the node
+            // further at once
+            anyNominated = true;
+            for (auto const& phase : {"confirm_prepare_ms", "accept_commit_ms"})
+            {
+                if (t.isMember(phase))
+                {
+                    REQUIRE(t[phase].asInt64() <=
+                            t["externalize_ms"].asInt64());
+                }
+            }
+        }
+    }
+    REQUIRE(anyNominated);
+    REQUIRE(nodes[0]->getHerder().getJsonSCPTimingInfo(1).size() == 1);
+}
+
 TEST_CASE("quick restart", "[herder][quickRestart]")
 {
     auto mode = Simulation::OVER_LOOPBACK;
@@ -6064,4 +6195,93 @@ TEST_CASE("SCP message capture from previous ledger", "[herder]")
     // check ensures that C does not double count messages from ledger 2 when
     // closing ledger 3.
     REQUIRE(checkSCPHistoryEntries(C, 2, expectedTypes));
-}
\ No newline at end of file
+}
+TEST_CASE("transaction queue persisted across restarts",
+          "[herder][transactionqueue]")
+{
+    auto cfg = getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE);
+    cfg.PERSIST_TRANSACTION_QUEUE = true;
+
+    Hash queuedHash;
+    {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, cfg);
+        auto root = TestAccount::createRoot(*app);
+        auto a1 = TestAccount{*app, getAccount("A")};
+        auto tx = root.tx({createAccount(a1, app->getLedgerManager()
+                                                 .getLastMinBalance(0))});
+        REQUIRE(app->getHerder().recvTransaction(tx, true) ==
+                TransactionQueue::AddResult::ADD_STATUS_PENDING);
+        queuedHash = tx->getFullHash();
+
+        app->gracefulStop();
+        while (clock.crank(false))
+            ;
+    }
+
+    SECTION("restored")
+    {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, cfg, false);
+        REQUIRE(app->getHerder().getTx(queuedHash));
+        REQUIRE(app->getPersistentState()
+                    .getState(PersistentState::kTransactionQueue)
+                    .empty());
+    }
+    SECTION("not restored without the option")
+    {
+        VirtualClock clock;
+        cfg.PERSIST_TRANSACTION_QUEUE = false;
+        auto app = createTestApplication(clock, cfg, false);
+        REQUIRE(!app->getHerder().getTx(queuedHash));
+    }
+}
+
+TEST_CASE("transactions validated off the main thread", "[herder]")
+{
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    VirtualClock clock;
+    auto app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    auto minBalance = app->getLedgerManager().getLastMinBalance(2);
+    auto a1 = root.create("A", minBalance);
+    auto a2 = root.create("B", minBalance);
+    auto missing = TestAccount{*app, getAccount("C")};
+
+    TxSetTransactions txs;
+    txs.emplace_back(a1.tx({payment(root, 1)}));
+    // Skips a sequence number
+    txs.emplace_back(
+        a2.tx({payment(root, 1)}, a2.getLastSequenceNumber() + 2));
+    txs.emplace_back(missing.tx({payment(root, 1)}, 1));
+
+    auto& validated = app->getMetrics().NewMeter(
+        {"herder", "tx-validation", "validated"}, "transaction");
+    auto validatedBefore = validated.count();
+    auto results =
+        app->getHerder().getTxValidationService().validate(txs, 0, 0);
+    REQUIRE(results == std::vector<bool>{true, false, false});
+    REQUIRE(validated.count() == validatedBefore + txs.size());
+
+    auto checkValidOnMainThread = [&](TransactionFrameBasePtr const& tx) {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        ltx.loadHeader().current().ledgerSeq =
+            app->getLedgerManager().getLastClosedLedgerNum() + 1;
+        return tx->checkValid(*app, ltx, 0, 0, 0);
+    };
+    SECTION("results confirmed on the main thread")
+    {
+        REQUIRE(checkValidOnMainThread(txs[0]));
+        REQUIRE(!checkValidOnMainThread(txs[1]));
+        REQUIRE(!checkValidOnMainThread(txs[2]));
+    }
+    SECTION("sequence number used in between")
+    {
+        // Reloaded, as txs[0] took the next sequence number
+        a1.setSequenceNumber(0);
+        a1.pay(root, 1);
+        REQUIRE(!checkValidOnMainThread(txs[0]));
+    }
+}
@@ -2,6 +2,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/BLAKE2.h"
 #include "crypto/SHA.h"
 #include "herder/HerderImpl.h"
 #include "herder/PendingEnvelopes.h"
@@ -138,6 +139,9 @@ TEST_CASE("PendingEnvelopes recvSCPEnvelope", "[herder]")
                     Herder::ENVELOPE_STATUS_FETCHING);
 
             REQUIRE(herder.getSCP().getLatestMessage(pk) == nullptr);
+            auto saneEnvelopeHash = xdrBlake2(saneEnvelope);
+            REQUIRE(!pendingEnvelopes.isProcessed(saneEnvelope,
+                                                  saneEnvelopeHash));
             // -> processes saneEnvelope
             REQUIRE(pendingEnvelopes.recvTxSet(p.second->getContentsHash(),
                                                p.second));
@@ -147,6 +151,13 @@ TEST_CASE("PendingEnvelopes recvSCPEnvelope", "[herder]")
             auto m = herder.getSCP().getLatestMessage(pk);
             REQUIRE(m);
             REQUIRE(*m == saneEnvelope);
+            REQUIRE(pendingEnvelopes.isProcessed(saneEnvelope,
+                                                 saneEnvelopeHash));
+
+            // duplicates are recognized by herder without going through
+            // PendingEnvelopes again
+            REQUIRE(herder.recvSCPEnvelope(saneEnvelope) ==
+                    Herder::ENVELOPE_STATUS_PROCESSED);
 
             REQUIRE(pendingEnvelopes.recvSCPEnvelope(saneEnvelope) ==
                     Herder::ENVELOPE_STATUS_PROCESSED);
@@ -157,6 +168,11 @@ TEST_CASE("PendingEnvelopes recvSCPEnvelope", "[herder]")
 
             REQUIRE(pendingEnvelopes.recvSCPEnvelope(saneEnvelope) ==
                     Herder::ENVELOPE_STATUS_PROCESSED);
+
+            // purging the slot forgets about the envelope
+            pendingEnvelopes.eraseBelow(lcl.header.ledgerSeq + 2, 0);
+            REQUIRE(!pendingEnvelopes.isProcessed(saneEnvelope,
+                                                  saneEnvelopeHash));
         }
 
         SECTION("process when all data came (tx set first)")
@@ -860,6 +860,88 @@ TEST_CASE("quorum intersection 6-org 3-node fully-connected",
     REQUIRE(qic->networkEnjoysQuorumIntersection());
 }
 
+TEST_CASE("quorum intersection parallel search",
+          "[herder][quorumintersection]")
+{
+    Config cfg(getTestConfig());
+    cfg.QUORUM_INTERSECTION_CHECKER_THREADS = 4;
+    std::atomic<bool> flag{false};
+
+    SECTION("6-org 3-node fully-connected")
+    {
+        auto orgs = generateOrgs(6, {3});
+        auto qm =
+            interconnectOrgs(orgs, [](size_t i, size_t j) { return true; });
+        cfg = configureShortNames(cfg, orgs);
+        auto qic =
+            QuorumIntersectionChecker::create(qm, cfg, flag, gRandomEngine());
+        REQUIRE(qic->networkEnjoysQuorumIntersection());
+    }
+
+    SECTION("3-org 3-node open line")
+    {
+        auto orgs = generateOrgs(3, {3});
+        auto qm = interconnectOrgsBidir(orgs, {{0, 1}, {1, 2}});
+        cfg = configureShortNames(cfg, orgs);
+        auto qic =
+            QuorumIntersectionChecker::create(qm, cfg, flag, gRandomEngine());
+        REQUIRE(!qic->networkEnjoysQuorumIntersection());
+        auto split = qic->getPotentialSplit();
+        REQUIRE(!split.first.empty());
+        REQUIRE(!split.second.empty());
+        for (auto const& n : split.first)
+        {
+            REQUIRE(std::find(split.second.begin(), split.second.end(), n) ==
+                    split.second.end());
+        }
+    }
+}
+
+TEST_CASE("quorum intersection reuses search of unchanged scan SCC",
+          "[herder][quorumintersection]")
+{
+    // Network: org0 <--> org1 <--> org2, plus a node outside of the SCC that
+    // depends on org0.
+    auto orgs = generateOrgs(3, {3});
+    auto qm = interconnectOrgsBidir(orgs, {{0, 1}, {1, 2}});
+    auto outsider = SecretKey::pseudoRandomForTesting().getPublicKey();
+    auto outsiderQSet = std::make_shared<SCPQuorumSet>();
+    outsiderQSet->threshold = 1;
+    outsiderQSet->validators = orgs[0];
+    qm[outsider] = QuorumTracker::NodeInfo{outsiderQSet, 0};
+
+    Config cfg(getTestConfig());
+    cfg = configureShortNames(cfg, orgs);
+    std::atomic<bool> flag{false};
+    auto cache = std::make_shared<QuorumIntersectionChecker::SearchCache>(10);
+    auto check = [&]() {
+        auto qic = QuorumIntersectionChecker::create(
+            qm, cfg, flag, gRandomEngine(), /*quiet=*/false, cache);
+        bool res = qic->networkEnjoysQuorumIntersection();
+        REQUIRE(!res);
+        REQUIRE(!qic->getPotentialSplit().first.empty());
+        REQUIRE(!qic->getPotentialSplit().second.empty());
+    };
+
+    check();
+    REQUIRE(cache->getHits() == 0);
+
+    // Change the qset of the outsider: the search is reused.
+    auto newOutsiderQSet = std::make_shared<SCPQuorumSet>(*outsiderQSet);
+    newOutsiderQSet->threshold = 2;
+    qm[outsider] = QuorumTracker::NodeInfo{newOutsiderQSet, 0};
+    check();
+    REQUIRE(cache->getHits() == 1);
+
+    // Change the qset of a node of the SCC: the search runs again.
+    auto newQSet =
+        std::make_shared<SCPQuorumSet>(*qm[orgs[2][0]].mQuorumSet);
+    newQSet->threshold++;
+    qm[orgs[2][0]] = QuorumTracker::NodeInfo{newQSet, 0};
+    check();
+    REQUIRE(cache->getHits() == 1);
+}
+
 TEST_CASE("quorum intersection scaling test",
           "[herder][quorumintersectionbench][!hide]")
 {
@@ -128,6 +128,15 @@ testQuorumTracker()
             REQUIRE(penEnvs->isNodeDefinitelyInQuorum(
                         otherKeys[j].getPublicKey()) == inQuorum);
         }
+        // the copy published for other threads has the same nodes
+        auto distances = herder->getQuorumDistances();
+        REQUIRE(distances);
+        REQUIRE(distances->size() == ids.size() + 1);
+        REQUIRE(distances->at(cfg.NODE_SEED.getPublicKey()) == 0);
+        for (auto j : ids)
+        {
+            REQUIRE(distances->count(otherKeys[j].getPublicKey()) == 1);
+        }
     };
     SECTION("Receive self")
     {
@@ -18,6 +18,7 @@
 #include "transactions/SignatureUtils.h"
 #include "transactions/TransactionBridge.h"
 #include "transactions/TransactionUtils.h"
+#include "util/Math.h"
 #include "util/Timer.h"
 #include "util/numeric128.h"
 #include "xdr/Stellar-transaction.h"
@@ -2617,6 +2618,84 @@ TEST_CASE("remove applied", "[herder][transactionqueue]")
     REQUIRE(tq.getTransactions({}).size() == 2);
 }
 
+TEST_CASE("transaction queue tracks validated transactions",
+          "[herder][transactionqueue]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    auto app = createTestApplication(clock, cfg);
+
+    auto& lm = app->getLedgerManager();
+    auto& herder = static_cast<HerderImpl&>(app->getHerder());
+    auto& tq = herder.getTransactionQueue();
+
+    auto root = TestAccount::createRoot(*app);
+    auto acc = root.create("A", lm.getLastMinBalance(2));
+    auto acc2 = root.create("B", lm.getLastMinBalance(2));
+
+    auto tx1 = acc.tx({payment(root, 1)});
+    auto tx2 = acc2.tx({payment(root, 1)});
+    REQUIRE(herder.recvTransaction(tx1, false) ==
+            TransactionQueue::AddResult::ADD_STATUS_PENDING);
+    REQUIRE(herder.recvTransaction(tx2, false) ==
+            TransactionQueue::AddResult::ADD_STATUS_PENDING);
+
+    auto lcl = lm.getLastClosedLedgerHeader().header;
+    auto upperBound =
+        getUpperBoundCloseTimeOffset(*app, lcl.scpValue.closeTime);
+
+    SECTION("within the checked close times")
+    {
+        auto validated = tq.getValidatedTxHashes(lcl, upperBound);
+        REQUIRE(validated.size() == 2);
+        REQUIRE(validated.count(tx1->getFullHash()) == 1);
+        REQUIRE(validated.count(tx2->getFullHash()) == 1);
+        REQUIRE(tq.getValidatedTxHashes(lcl, upperBound + 1).empty());
+    }
+
+    SECTION("validated transactions only have their fees checked")
+    {
+        // Wrong sequence number
+        auto badSeq =
+            acc.tx({payment(root, 1)}, acc.getLastSequenceNumber() + 5);
+        auto poor = root.create("C", lm.getLastMinBalance(0));
+        auto cantPay = poor.tx({payment(root, 1)});
+
+        TxSetTransactions txs{badSeq, cantPay};
+        UnorderedSet<Hash> validated{badSeq->getFullHash(),
+                                     cantPay->getFullHash()};
+        auto invalid = TxSetUtils::getInvalidTxList(txs, *app, 0, 0, false);
+        REQUIRE(invalid.size() == 2);
+
+        invalid =
+            TxSetUtils::getInvalidTxList(txs, *app, 0, 0, false, &validated);
+        REQUIRE(invalid.size() == 1);
+        REQUIRE(invalid[0] == cantPay);
+    }
+
+    SECTION("marks are reset when a ledger closes")
+    {
+        auto ledgerSeq = lcl.ledgerSeq + 1;
+        auto [txSet, _] = makeTxSetFromTransactions({tx2}, *app, 0, 0);
+        herder.getPendingEnvelopes().putTxSet(txSet->getContentsHash(),
+                                              ledgerSeq, txSet);
+        StellarValue sv = herder.makeStellarValue(
+            txSet->getContentsHash(), lcl.scpValue.closeTime,
+            emptyUpgradeSteps, app->getConfig().NODE_SEED);
+        herder.getHerderSCPDriver().valueExternalized(ledgerSeq,
+                                                      xdr::xdr_to_opaque(sv));
+
+        auto newLcl = lm.getLastClosedLedgerHeader().header;
+        REQUIRE(newLcl.ledgerSeq == ledgerSeq);
+        REQUIRE(tq.getValidatedTxHashes(lcl, 0).empty());
+
+        // The transaction left in the queue was checked again after the close
+        auto validated = tq.getValidatedTxHashes(newLcl, 0);
+        REQUIRE(validated.size() == 1);
+        REQUIRE(validated.count(tx1->getFullHash()) == 1);
+    }
+}
+
 static UnorderedSet<AssetPair, AssetPairHash>
 apVecToSet(std::vector<AssetPair> const& v)
 {
@@ -2837,3 +2916,85 @@ TEST_CASE("arbitrage tx identification benchmark",
     LOG_INFO(DEFAULT_LOG, "executed 100 loop-checks of 600-op tx loop in {}",
              ch::duration_cast<ch::milliseconds>(end - start));
 }
+
+TEST_CASE("TxQueueLimiter eviction benchmark",
+          "[herder][transactionqueue][bench][!hide]")
+{
+    // Fills a limiter with 100k single-op transactions of random fees, then
+    // times admitting higher fee transactions (each evicting the cheapest one)
+    // and rejecting transactions that bid too little, as happens with a full
+    // queue during fee spikes.
+    size_t const queueSize = 100000;
+    size_t const numRounds = 10000;
+
+    VirtualClock vclock;
+    auto cfg = getTestConfig();
+    cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = static_cast<uint32>(queueSize);
+    auto app = createTestApplication(vclock, cfg);
+    auto ledgerVersion = app->getLedgerManager()
+                             .getLastClosedLedgerHeader()
+                             .header.ledgerVersion;
+    TxQueueLimiter limiter(1, *app, false);
+
+    auto dest = PubKeyUtils::pseudoRandomForTesting();
+    auto makeTx = [&](uint32_t fee) {
+        TransactionEnvelope env(ENVELOPE_TYPE_TX);
+        env.v1().tx.sourceAccount =
+            toMuxedAccount(PubKeyUtils::pseudoRandomForTesting());
+        env.v1().tx.fee = fee;
+        env.v1().tx.seqNum = 1;
+        env.v1().tx.operations.emplace_back(txtest::payment(dest, 1));
+        return std::static_pointer_cast<TransactionFrameBase>(
+            std::make_shared<TransactionFrame>(app->getNetworkID(), env));
+    };
+
+    TransactionFrameBasePtr noTx;
+    std::vector<std::pair<TxStackPtr, bool>> txsToEvict;
+    for (size_t i = 0; i < queueSize; ++i)
+    {
+        auto tx = makeTx(rand_uniform<uint32_t>(100, 1000));
+        txsToEvict.clear();
+        REQUIRE(limiter.canAddTx(tx, noTx, txsToEvict, ledgerVersion).first);
+        limiter.addTransaction(tx);
+    }
+
+    std::vector<TransactionFrameBasePtr> expensiveTxs;
+    std::vector<TransactionFrameBasePtr> cheapTxs;
+    for (size_t i = 0; i < numRounds; ++i)
+    {
+        expensiveTxs.emplace_back(makeTx(rand_uniform<uint32_t>(1001, 2000)));
+        cheapTxs.emplace_back(makeTx(100));
+    }
+
+    namespace ch = std::chrono;
+    using clock = ch::high_resolution_clock;
+    auto start = clock::now();
+    for (auto const& tx : expensiveTxs)
+    {
+        txsToEvict.clear();
+        REQUIRE(limiter.canAddTx(tx, noTx, txsToEvict, ledgerVersion).first);
+        limiter.evictTransactions(
+            txsToEvict, *tx, [&](TransactionFrameBasePtr const& evicted) {
+                limiter.removeTransaction(evicted);
+            });
+        limiter.addTransaction(tx);
+    }
+    auto mid = clock::now();
+    // Make the cheap txs go through the eviction candidates rather than
+    // fail against the highest evicted bid
+    limiter.resetEvictionState();
+    for (auto const& tx : cheapTxs)
+    {
+        txsToEvict.clear();
+        REQUIRE(!limiter.canAddTx(tx, noTx, txsToEvict, ledgerVersion).first);
+    }
+    auto end = clock::now();
+
+    REQUIRE(limiter.size() == queueSize);
+    LOG_INFO(DEFAULT_LOG,
+             "admitted {} txs with eviction in {}, rejected {} txs in {} "
+             "(queue of {} txs)",
+             numRounds, ch::duration_cast<ch::milliseconds>(mid - start),
+             numRounds, ch::duration_cast<ch::milliseconds>(end - mid),
+             queueSize);
+}
@@ -3,6 +3,10 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "herder/TxSetFrame.h"
+#include "crypto/SHA.h"
+#include "herder/CompactTxSet.h"
+#include "herder/TxSetChunks.h"
+#include "herder/TxSetUtils.h"
 #include "herder/test/TestTxSetUtils.h"
 #include "ledger/LedgerManager.h"
 #include "lib/catch.hpp"
@@ -13,6 +17,10 @@
 #include "test/TxTests.h"
 #include "test/test.h"
 #include "util/ProtocolVersion.h"
+#include "xdrpp/marshal.h"
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <thread>
 
 namespace stellar
 {
@@ -517,6 +525,13 @@ TEST_CASE("generalized tx set XDR conversion", "[txset]")
 
     auto checkXdrRoundtrip = [&](GeneralizedTransactionSet const& txSetXdr) {
         auto txSetFrame = TxSetXDRFrame::makeFromWire(txSetXdr);
+        REQUIRE(txSetFrame->getEncoded() == xdr::xdr_to_opaque(txSetXdr));
+        REQUIRE(txSetFrame->encodedSize() == xdr::xdr_argpack_size(txSetXdr));
+        REQUIRE(txSetFrame->getContentsHash() == xdrSha256(txSetXdr));
+        StoredTransactionSet storedSet;
+        txSetFrame->storeXDR(storedSet);
+        REQUIRE(txSetFrame->encodeStored() == xdr::xdr_to_opaque(storedSet));
+
         ApplicableTxSetFrameConstPtr applicableFrame;
         {
             LedgerTxn ltx(app->getLedgerTxnRoot(), false,
@@ -810,6 +825,257 @@ TEST_CASE("generalized tx set with multiple txs per source account",
     }
 }
 
+TEST_CASE("tx set prepared for apply in background", "[txset]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    cfg.TESTING_UPGRADE_LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto root = TestAccount::createRoot(*app);
+    auto& hit = app->getMetrics().NewMeter(
+        {"herder", "txset", "prepared-hit"}, "txset");
+    auto const& lclHash =
+        app->getLedgerManager().getLastClosedLedgerHeader().hash;
+
+    // Polls until the background result is used
+    auto prepareWhenReady = [&](TxSetXDRFrameConstPtr const& txSet) {
+        auto hits = hit.count();
+        auto res = txSet->prepareForApply(*app);
+        for (int i = 0; i < 1000 && hit.count() == hits; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            res = txSet->prepareForApply(*app);
+        }
+        REQUIRE(hit.count() == hits + 1);
+        return res;
+    };
+
+    SECTION("valid set")
+    {
+        std::vector<TransactionFrameBasePtr> txs;
+        for (int i = 0; i < 3; ++i)
+        {
+            auto source =
+                root.create("source " + std::to_string(i),
+                            app->getLedgerManager().getLastMinBalance(2));
+            txs.emplace_back(transactionFromOperations(
+                *app, source.getSecretKey(), source.nextSequenceNumber(),
+                {createAccount(getAccount(std::to_string(i)).getPublicKey(),
+                               1)},
+                200));
+        }
+        auto [_, applicable] = testtxset::makeNonValidatedGeneralizedTxSet(
+            {{std::make_pair(100LL, txs)}, {}}, *app, lclHash);
+        GeneralizedTransactionSet txSetXdr;
+        applicable->toWireTxSetFrame()->toXDR(txSetXdr);
+        auto txSet = TxSetXDRFrame::makeFromWire(txSetXdr);
+
+        TxSetXDRFrame::prepareForApplyInBackground(txSet, *app);
+        auto prepared = prepareWhenReady(txSet);
+        REQUIRE(prepared->checkValid(*app, 0, 0));
+        GeneralizedTransactionSet preparedXdr;
+        prepared->toWireTxSetFrame()->toXDR(preparedXdr);
+        REQUIRE(preparedXdr == txSetXdr);
+
+        // Later calls get their own frame over the same transactions
+        auto again = txSet->prepareForApply(*app);
+        REQUIRE(again.get() != prepared.get());
+        REQUIRE(again->getTxsForPhase(TxSetPhase::CLASSIC) ==
+                prepared->getTxsForPhase(TxSetPhase::CLASSIC));
+        REQUIRE(hit.count() == 2);
+    }
+    SECTION("malformed set")
+    {
+        GeneralizedTransactionSet txSetXdr(1);
+        txSetXdr.v1TxSet().previousLedgerHash = lclHash;
+        auto txSet = TxSetXDRFrame::makeFromWire(txSetXdr);
+        TxSetXDRFrame::prepareForApplyInBackground(txSet, *app);
+        REQUIRE(prepareWhenReady(txSet) == nullptr);
+    }
+}
+
+TEST_CASE("tx set chunks", "[txset]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    cfg.TESTING_UPGRADE_LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto root = TestAccount::createRoot(*app);
+
+    auto createTxs = [&](int cnt, std::string const& prefix) {
+        std::vector<TransactionFrameBasePtr> txs;
+        for (int i = 0; i < cnt; ++i)
+        {
+            auto source =
+                root.create(prefix + std::to_string(i),
+                            app->getLedgerManager().getLastMinBalance(2));
+            txs.emplace_back(transactionFromOperations(
+                *app, source.getSecretKey(), source.nextSequenceNumber(),
+                {createAccount(getAccount(std::to_string(i)).getPublicKey(),
+                               1)},
+                200));
+        }
+        return txs;
+    };
+    auto [_, applicable] = testtxset::makeNonValidatedGeneralizedTxSet(
+        {{std::make_pair(100LL, createTxs(5, "a")),
+          std::make_pair(200LL, createTxs(2, "b"))},
+         {}},
+        *app, app->getLedgerManager().getLastClosedLedgerHeader().hash);
+    GeneralizedTransactionSet txSet;
+    applicable->toWireTxSetFrame()->toXDR(txSet);
+    auto txSize = xdr::xdr_argpack_size(txSet.v1TxSet()
+                                            .phases[0]
+                                            .v0Components()[0]
+                                            .txsMaybeDiscountedFee()
+                                            .txs[0]);
+
+    SECTION("one chunk per component when they fit")
+    {
+        auto manifest = makeTxSetChunkManifest(txSet, 100 * txSize);
+        REQUIRE(manifest);
+        REQUIRE(manifest->mChunks.size() == 2);
+        REQUIRE(manifest->mTxSetHash == xdrSha256(txSet));
+    }
+    SECTION("oversized transactions get a chunk each")
+    {
+        auto manifest = makeTxSetChunkManifest(txSet, 1);
+        REQUIRE(manifest);
+        REQUIRE(manifest->mChunks.size() == 7);
+    }
+    SECTION("reassembly")
+    {
+        // Two transactions per chunk: 3 chunks, then 1
+        auto manifest = makeTxSetChunkManifest(txSet, 2 * txSize + 10);
+        REQUIRE(manifest);
+        REQUIRE(manifest->mChunks.size() == 4);
+        auto const& chunks = manifest->mChunks;
+
+        SECTION("from chunks in any order")
+        {
+            TxSetChunkAssembler assembler(*manifest);
+            for (size_t i = chunks.size(); i-- > 0;)
+            {
+                REQUIRE(!assembler.isComplete());
+                REQUIRE(assembler.addChunk(i, getTxSetChunk(txSet, chunks[i])));
+                // Duplicates are ignored
+                REQUIRE(
+                    !assembler.addChunk(i, getTxSetChunk(txSet, chunks[i])));
+            }
+            REQUIRE(assembler.isComplete());
+            auto frame = assembler.assemble();
+            REQUIRE(frame);
+            REQUIRE(frame->getContentsHash() ==
+                    applicable->getContentsHash());
+        }
+        SECTION("bad chunk rejected")
+        {
+            TxSetChunkAssembler assembler(*manifest);
+            REQUIRE(!assembler.addChunk(0, getTxSetChunk(txSet, chunks[1])));
+            REQUIRE(!assembler.addChunk(chunks.size(),
+                                        getTxSetChunk(txSet, chunks[0])));
+            REQUIRE(assembler.getMissingChunks() ==
+                    std::vector<size_t>{0, 1, 2, 3});
+            REQUIRE(assembler.addChunk(0, getTxSetChunk(txSet, chunks[0])));
+            REQUIRE(assembler.getMissingChunks() ==
+                    std::vector<size_t>{1, 2, 3});
+        }
+        SECTION("bad manifest detected on assembly")
+        {
+            auto bad = *manifest;
+            bad.mSkeleton.v1TxSet()
+                .phases[0]
+                .v0Components()[0]
+                .txsMaybeDiscountedFee()
+                .baseFee.activate() = 101;
+            TxSetChunkAssembler assembler(bad);
+            for (size_t i = 0; i < chunks.size(); ++i)
+            {
+                REQUIRE(assembler.addChunk(i, getTxSetChunk(txSet, chunks[i])));
+            }
+            REQUIRE(!assembler.assemble());
+        }
+        SECTION("malformed manifest rejected")
+        {
+            auto bad = *manifest;
+            std::swap(bad.mChunks[0], bad.mChunks[1]);
+            REQUIRE_THROWS_AS(TxSetChunkAssembler(bad), std::invalid_argument);
+        }
+    }
+}
+
+TEST_CASE("compact tx sets", "[txset]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    cfg.TESTING_UPGRADE_LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto root = TestAccount::createRoot(*app);
+
+    std::vector<TransactionFrameBasePtr> txs;
+    for (int i = 0; i < 4; ++i)
+    {
+        auto source = root.create("source " + std::to_string(i),
+                                  app->getLedgerManager().getLastMinBalance(2));
+        txs.emplace_back(transactionFromOperations(
+            *app, source.getSecretKey(), source.nextSequenceNumber(),
+            {createAccount(getAccount(std::to_string(i)).getPublicKey(), 1)},
+            200));
+    }
+    auto [_, applicable] = testtxset::makeNonValidatedGeneralizedTxSet(
+        {{std::make_pair(100LL, txs)}, {}}, *app,
+        app->getLedgerManager().getLastClosedLedgerHeader().hash);
+    GeneralizedTransactionSet txSet;
+    applicable->toWireTxSetFrame()->toXDR(txSet);
+
+    auto compact = makeCompactTxSet(txSet);
+    REQUIRE(compact);
+    REQUIRE(compact->mTxSetHash == applicable->getContentsHash());
+    REQUIRE(compact->mTxHashes.size() == 1);
+    REQUIRE(compact->mTxHashes[0].size() == txs.size());
+
+    // Stands in for the transaction queues, missing the first transaction
+    UnorderedMap<Hash, TransactionFrameBaseConstPtr> queue;
+    for (size_t i = 1; i < txs.size(); ++i)
+    {
+        queue.emplace(txs[i]->getFullHash(), txs[i]);
+    }
+    auto lookup = [&](Hash const& hash) -> TransactionFrameBaseConstPtr {
+        auto it = queue.find(hash);
+        return it == queue.end() ? nullptr : it->second;
+    };
+
+    SECTION("missing transactions are reported")
+    {
+        auto res = reconstructTxSet(*compact, lookup);
+        REQUIRE(!res.mTxSet);
+        REQUIRE(res.mMissingTxs == std::vector<Hash>{txs[0]->getFullHash()});
+
+        queue.emplace(txs[0]->getFullHash(), txs[0]);
+        res = reconstructTxSet(*compact, lookup);
+        REQUIRE(res.mMissingTxs.empty());
+        REQUIRE(res.mTxSet);
+        REQUIRE(res.mTxSet->getContentsHash() == compact->mTxSetHash);
+    }
+    SECTION("bad compact tx set")
+    {
+        queue.emplace(txs[0]->getFullHash(), txs[0]);
+        std::swap(compact->mTxHashes[0][0], compact->mTxHashes[0][1]);
+        auto res = reconstructTxSet(*compact, lookup);
+        REQUIRE(!res.mTxSet);
+        REQUIRE(res.mMissingTxs.empty());
+    }
+}
+
 TEST_CASE("generalized tx set fees", "[txset][soroban]")
 {
     VirtualClock clock;
@@ -912,6 +1178,36 @@ TEST_CASE("generalized tx set fees", "[txset][soroban]")
                                 std::nullopt, std::nullopt, 500, 500, 1000,
                                 1000, 1000});
         }
+
+        // The prepared fee table matches the fees computed on the fly
+        auto const& lcl =
+            app->getLedgerManager().getLastClosedLedgerHeader().header;
+        auto totalFees = txSet->getTotalFees(lcl);
+        txSet->prepareApplyFees(*app, lcl);
+        REQUIRE(txSet->getTotalFees(lcl) == totalFees);
+        auto const& sorobanCfg =
+            app->getLedgerManager().getSorobanNetworkConfig();
+        for (auto i = 0; i < static_cast<size_t>(TxSetPhase::PHASE_COUNT); ++i)
+        {
+            for (auto const& tx :
+                 txSet->getTxsForPhase(static_cast<TxSetPhase>(i)))
+            {
+                auto const& txFees = txSet->getTxApplyFees(tx);
+                REQUIRE(txFees.mBaseFee == txSet->getTxBaseFee(tx, lcl));
+                REQUIRE(txFees.mFee == tx->getFee(lcl, txFees.mBaseFee, true));
+                REQUIRE(txFees.mSorobanResourceFee.has_value() ==
+                        tx->isSoroban());
+                if (tx->isSoroban())
+                {
+                    auto fee = tx->computePreApplySorobanResourceFee(
+                        lcl.ledgerVersion, sorobanCfg, app->getConfig());
+                    REQUIRE(txFees.mSorobanResourceFee->non_refundable_fee ==
+                            fee.non_refundable_fee);
+                    REQUIRE(txFees.mSorobanResourceFee->refundable_fee ==
+                            fee.refundable_fee);
+                }
+            }
+        }
     }
     SECTION("tx with too low discounted fee")
     {
@@ -978,5 +1274,69 @@ TEST_CASE("generalized tx set fees", "[txset][soroban]")
     }
 }
 
+TEST_CASE("tx set apply stages", "[txset][soroban]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    cfg.TESTING_UPGRADE_LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    Application::pointer app = createTestApplication(clock, cfg);
+    overrideSorobanNetworkConfigForTest(*app);
+
+    auto root = TestAccount::createRoot(*app);
+    auto minBalance = app->getLedgerManager().getLastMinBalance(2);
+    std::vector<TestAccount> accounts;
+    for (int i = 0; i < 4; ++i)
+    {
+        accounts.emplace_back(root.create("a" + std::to_string(i), minBalance));
+    }
+
+    std::vector<LedgerKey> keys;
+    for (int i = 0; i < 3; ++i)
+    {
+        LedgerKey key;
+        key.type(CONTRACT_CODE);
+        key.contractCode().hash = sha256("code" + std::to_string(i));
+        keys.emplace_back(key);
+    }
+    auto sorobanTx = [&](TestAccount& source, xdr::xvector<LedgerKey> ro,
+                         xdr::xvector<LedgerKey> rw) {
+        SorobanResources resources;
+        resources.footprint.readOnly = ro;
+        resources.footprint.readWrite = rw;
+        return std::static_pointer_cast<TransactionFrameBase>(
+            createUploadWasmTx(*app, source, 100, DEFAULT_TEST_RESOURCE_FEE,
+                               resources));
+    };
+    auto classicTx = [&](TestAccount& source) {
+        return std::static_pointer_cast<TransactionFrameBase>(
+            source.tx({payment(root, 1)}));
+    };
+
+    TxSetTransactions txs{
+        classicTx(accounts[0]),
+        classicTx(accounts[1]),
+        sorobanTx(accounts[0], {}, {keys[0]}),
+        sorobanTx(accounts[1], {keys[1]}, {}),
+        // Reads an entry written by the first Soroban tx
+        sorobanTx(accounts[2], {keys[0]}, {}),
+        sorobanTx(accounts[3], {}, {keys[2]}),
+        // Shares its source account with the previous tx and a read-only
+        // entry with the second Soroban tx
+        sorobanTx(accounts[3], {keys[1]}, {}),
+        classicTx(accounts[2]),
+    };
+
+    auto stages = TxSetUtils::buildApplyStages(txs);
+    REQUIRE(stages.size() == 3);
+    REQUIRE(stages[0] == TxApplyStage{{0, 1}});
+    REQUIRE(stages[1] == TxApplyStage{{2, 4}, {3, 5, 6}});
+    REQUIRE(stages[2] == TxApplyStage{{7}});
+
+    REQUIRE(TxSetUtils::buildApplyStages({}).empty());
+}
+
 } // namespace
 } // namespace stellar
@@ -862,6 +862,41 @@ TEST_CASE("config upgrades applied to ledger", "[soroban][upgrades]")
         REQUIRE(sorobanConfig.maxContractSizeBytes() == 32768);
     }
 
+    SECTION("network config snapshot")
+    {
+        auto& lm = app->getLedgerManager();
+        auto before = lm.getSorobanNetworkConfigSnapshot();
+        REQUIRE(before);
+        REQUIRE(before->mConfig.maxContractSizeBytes() ==
+                InitialSorobanNetworkConfig::MAX_CONTRACT_SIZE);
+
+        // Closing a ledger without upgrades only publishes a new snapshot
+        // when the bucket list size window is sampled
+        closeLedger(*app);
+        auto samplePeriod =
+            sorobanConfig.stateArchivalSettings().bucketListWindowSamplePeriod;
+        if (lm.getLastClosedLedgerNum() % samplePeriod != 0)
+        {
+            REQUIRE(lm.getSorobanNetworkConfigSnapshot() == before);
+        }
+
+        ConfigUpgradeSetFrameConstPtr configUpgradeSet;
+        {
+            LedgerTxn ltx2(app->getLedgerTxnRoot());
+            configUpgradeSet = makeMaxContractSizeBytesTestUpgrade(ltx2, 32768);
+            ltx2.commit();
+        }
+        executeUpgrade(*app, makeConfigUpgrade(*configUpgradeSet));
+
+        auto after = lm.getSorobanNetworkConfigSnapshot();
+        REQUIRE(after != before);
+        REQUIRE(after->mLedgerSeq == lm.getLastClosedLedgerNum());
+        REQUIRE(after->mConfig.maxContractSizeBytes() == 32768);
+        // Readers holding the old snapshot still see the old config
+        REQUIRE(before->mConfig.maxContractSizeBytes() ==
+                InitialSorobanNetworkConfig::MAX_CONTRACT_SIZE);
+    }
+
     SECTION("modify BucketListSizeWindowSampleSize")
     {
         auto populateValuesAndUpgradeSize = [&](uint32_t size) {
@@ -3,7 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "FileTransferInfo.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <thread>
 
 namespace stellar
@@ -20,9 +20,10 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <cereal/archives/json.hpp>
 #include <cereal/cereal.hpp>
 #include <cereal/types/vector.hpp>
@@ -40,6 +41,21 @@ namespace stellar
 
 unsigned const HistoryArchiveState::HISTORY_ARCHIVE_STATE_VERSION = 1;
 
+Hash const&
+HistoryStateBucket::getLevelHash() const
+{
+    if (!mLevelHash || mLevelHashCurr != curr || mLevelHashSnap != snap)
+    {
+        SHA256 levelHash;
+        levelHash.add(hexToBin(curr));
+        levelHash.add(hexToBin(snap));
+        mLevelHash = levelHash.finish();
+        mLevelHashCurr = curr;
+        mLevelHashSnap = snap;
+    }
+    return *mLevelHash;
+}
+
 template <typename... Tokens>
 std::string
 formatString(std::string const& templateString, Tokens const&... tokens)
@@ -216,10 +232,7 @@ HistoryArchiveState::getBucketListHash() const
     SHA256 totalHash;
     for (auto const& level : currentBuckets)
     {
-        SHA256 levelHash;
-        levelHash.add(hexToBin(level.curr));
-        levelHash.add(hexToBin(level.snap));
-        totalHash.add(levelHash.finish());
+        totalHash.add(level.getLevelHash());
     }
     return totalHash.finish();
 }
@@ -469,6 +482,12 @@ HistoryArchive::hasPutCmd() const
     return !mConfig.mPutCmd.empty();
 }
 
+bool
+HistoryArchive::hasGetUrl() const
+{
+    return !mConfig.mGetUrl.empty();
+}
+
 bool
 HistoryArchive::hasMkdirCmd() const
 {
@@ -506,4 +525,139 @@ HistoryArchive::mkdirCmd(std::string const& remoteDir) const
         return "";
     return formatString(mConfig.mMkdirCmd, remoteDir);
 }
+
+std::string
+HistoryArchive::getFileUrl(std::string const& remote) const
+{
+    if (mConfig.mGetUrl.empty())
+        return "";
+    auto const& base = mConfig.mGetUrl;
+    return base.back() == '/' ? base + remote : base + "/" + remote;
+}
+
+void
+HistoryArchive::initDownloadConcurrency(size_t initial, size_t max)
+{
+    mMaxDownloadConcurrency = std::max<size_t>(max, 1);
+    mDownloadConcurrency = static_cast<double>(
+        std::clamp<size_t>(initial, 1, mMaxDownloadConcurrency));
+}
+
+size_t
+HistoryArchive::getDownloadConcurrency() const
+{
+    return static_cast<size_t>(mDownloadConcurrency);
+}
+
+size_t
+HistoryArchive::getDownloadsInFlight() const
+{
+    return mDownloadsInFlight;
+}
+
+double
+HistoryArchive::getDownloadThroughput() const
+{
+    return mDownloadRate * mDownloadConcurrency;
+}
+
+void
+HistoryArchive::downloadStarted()
+{
+    ++mDownloadsInFlight;
+}
+
+void
+HistoryArchive::downloadAbandoned()
+{
+    releaseAssert(mDownloadsInFlight > 0);
+    --mDownloadsInFlight;
+}
+
+void
+HistoryArchive::downloadFinished(bool success, size_t bytes,
+                                 std::chrono::steady_clock::duration elapsed)
+{
+    downloadAbandoned();
+    auto before = getDownloadConcurrency();
+    if (!success)
+    {
+        mDownloadConcurrency = std::max(1.0, mDownloadConcurrency / 2);
+    }
+    else
+    {
+        double secs =
+            std::max(std::chrono::duration<double>(elapsed).count(), 1e-3);
+        double rate = static_cast<double>(bytes) / secs;
+        // Smooth over a few files, they vary a lot in size
+        mDownloadRate =
+            mDownloadRate == 0 ? rate : 0.8 * mDownloadRate + 0.2 * rate;
+
+        // More concurrency only helps while throughput grows with it; once
+        // downloads just split the bandwidth between them, hold steady
+        auto throughput = getDownloadThroughput();
+        mBestDownloadThroughput =
+            std::max(mBestDownloadThroughput, throughput);
+        if (throughput >= 0.9 * mBestDownloadThroughput)
+        {
+            mDownloadConcurrency =
+                std::min(static_cast<double>(mMaxDownloadConcurrency),
+                         mDownloadConcurrency + 1 / mDownloadConcurrency);
+        }
+    }
+    if (getDownloadConcurrency() != before)
+    {
+        CLOG_DEBUG(History,
+                   "Archive {}: {} concurrent downloads, {:.0f} bytes/s",
+                   getName(), getDownloadConcurrency(),
+                   getDownloadThroughput());
+    }
+}
+
+void
+HistoryArchive::uploadFinished(size_t bytes,
+                               std::chrono::steady_clock::duration elapsed)
+{
+    double secs =
+        std::max(std::chrono::duration<double>(elapsed).count(), 1e-3);
+    double rate = static_cast<double>(bytes) / secs;
+    mUploadRate = mUploadRate == 0 ? rate : 0.8 * mUploadRate + 0.2 * rate;
+    CLOG_INFO(History,
+              "Archive {}: uploaded {} bytes at {:.0f} bytes/s (average "
+              "{:.0f} bytes/s)",
+              getName(), bytes, rate, mUploadRate);
+}
+
+double
+HistoryArchive::getUploadThroughput() const
+{
+    return mUploadRate;
+}
+
+HistoryArchiveDownload::HistoryArchiveDownload(
+    std::shared_ptr<HistoryArchive> archive)
+    : mArchive(archive), mStart(std::chrono::steady_clock::now())
+{
+    releaseAssert(mArchive);
+    mArchive->downloadStarted();
+}
+
+HistoryArchiveDownload::~HistoryArchiveDownload()
+{
+    if (!mFinished)
+    {
+        mArchive->downloadAbandoned();
+    }
+}
+
+void
+HistoryArchiveDownload::finish(bool success, size_t bytes)
+{
+    if (!mFinished)
+    {
+        mFinished = true;
+        mArchive->downloadFinished(success, bytes,
+                                   std::chrono::steady_clock::now() - mStart);
+    }
+}
 }
@@ -9,7 +9,9 @@
 #include "xdr/Stellar-types.h"
 
 #include <cereal/cereal.hpp>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <system_error>
 
@@ -36,6 +38,18 @@ struct HistoryStateBucket
     FutureBucket next;
     std::string snap;
 
+    // Hash of the curr bucket hash then the snap bucket hash, the same as the
+    // level hash of a BucketList. Memoized along with the curr and snap it was
+    // computed from, so that it is only recomputed once they change.
+    Hash const& getLevelHash() const;
+
+  private:
+    mutable std::optional<Hash> mLevelHash;
+    mutable std::string mLevelHashCurr;
+    mutable std::string mLevelHashSnap;
+
+  public:
+
     template <class Archive>
     void
     serialize(Archive& ar) const
@@ -99,14 +113,21 @@ struct HistoryArchiveState
     serialize(Archive& ar)
     {
         ar(CEREAL_NVP(version), CEREAL_NVP(server), CEREAL_NVP(currentLedger));
-        try
-        {
-            ar(CEREAL_NVP(networkPassphrase));
-        }
-        catch (cereal::Exception&)
+        // States written before networkPassphrase was added go straight on to
+        // currentBuckets; peeking at the next name spares throwing for each
+        // of them when scanning old checkpoints
+        char const* next = ar.getNodeName();
+        if (next == nullptr || std::string(next) != "currentBuckets")
         {
-            // networkPassphrase wasn't parsed.
-            // This is expected when the input file does not contain it.
+            try
+            {
+                ar(CEREAL_NVP(networkPassphrase));
+            }
+            catch (cereal::Exception&)
+            {
+                // networkPassphrase wasn't parsed.
+                // This is expected when the input file does not contain it.
+            }
         }
         ar(CEREAL_NVP(currentBuckets));
     }
@@ -158,6 +179,8 @@ class HistoryArchive : public std::enable_shared_from_this<HistoryArchive>
     bool hasGetCmd() const;
     bool hasPutCmd() const;
     bool hasMkdirCmd() const;
+    // Whether files can be fetched in-process, see NativeArchiveFetch
+    bool hasGetUrl() const;
     std::string const& getName() const;
 
     std::string getFileCmd(std::string const& remote,
@@ -165,8 +188,56 @@ class HistoryArchive : public std::enable_shared_from_this<HistoryArchive>
     std::string putFileCmd(std::string const& local,
                            std::string const& remote) const;
     std::string mkdirCmd(std::string const& remoteDir) const;
+    std::string getFileUrl(std::string const& remote) const;
+
+    // Downloads from an archive adapt their concurrency to it, additive
+    // increase / multiplicative decrease: every successful download adds
+    // 1/limit to the limit as long as the archive's throughput keeps up with
+    // the best seen, and every failure halves it. Only used from the main
+    // thread, through HistoryArchiveDownload.
+    void initDownloadConcurrency(size_t initial, size_t max);
+    size_t getDownloadConcurrency() const;
+    size_t getDownloadsInFlight() const;
+    // Estimated bytes per second at the current concurrency, or 0 if nothing
+    // was downloaded from this archive yet
+    double getDownloadThroughput() const;
+
+    // Records that a publish uploaded `bytes` to this archive over `elapsed`
+    void uploadFinished(size_t bytes,
+                        std::chrono::steady_clock::duration elapsed);
+    // Moving average of the upload rate of publishes, in bytes per second, or
+    // 0 if nothing was published to this archive yet
+    double getUploadThroughput() const;
 
   private:
+    friend class HistoryArchiveDownload;
+    void downloadStarted();
+    void downloadFinished(bool success, size_t bytes,
+                          std::chrono::steady_clock::duration elapsed);
+    void downloadAbandoned();
+
     HistoryArchiveConfiguration mConfig;
+
+    double mDownloadConcurrency{1};
+    size_t mMaxDownloadConcurrency{1};
+    size_t mDownloadsInFlight{0};
+    // Moving average of the rate of single downloads, in bytes per second
+    double mDownloadRate{0};
+    double mBestDownloadThroughput{0};
+    double mUploadRate{0};
+};
+
+// One download from a history archive, counted against the archive's
+// concurrency from construction until it is finished or destroyed.
+class HistoryArchiveDownload
+{
+    std::shared_ptr<HistoryArchive> const mArchive;
+    std::chrono::steady_clock::time_point const mStart;
+    bool mFinished{false};
+
+  public:
+    explicit HistoryArchiveDownload(std::shared_ptr<HistoryArchive> archive);
+    ~HistoryArchiveDownload();
+    void finish(bool success, size_t bytes);
 };
 }
@@ -16,6 +16,7 @@
 #include "work/WorkScheduler.h"
 #include "work/WorkSequence.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace stellar
@@ -26,6 +27,20 @@ HistoryArchiveManager::HistoryArchiveManager(Application& app) : mApp{app}
     for (auto const& archiveConfiguration : mApp.getConfig().HISTORY)
         mArchives.push_back(
             std::make_shared<HistoryArchive>(app, archiveConfiguration.second));
+
+    // Start out sharing the old single download limit between the archives
+    // that will be read from; each then adapts on its own
+    auto const& cfg = mApp.getConfig();
+    auto maxPerArchive = cfg.MAX_CONCURRENT_DOWNLOADS_PER_ARCHIVE == 0
+                             ? cfg.MAX_CONCURRENT_SUBPROCESSES
+                             : cfg.MAX_CONCURRENT_DOWNLOADS_PER_ARCHIVE;
+    auto readable = getReadableHistoryArchives();
+    for (auto const& archive : mArchives)
+    {
+        auto n = std::max<size_t>(readable.size(), 1);
+        archive->initDownloadConcurrency(
+            (cfg.MAX_CONCURRENT_SUBPROCESSES + n - 1) / n, maxPerArchive);
+    }
 }
 
 bool
@@ -126,8 +141,8 @@ HistoryArchiveManager::checkSensibleConfig() const
     return true;
 }
 
-std::shared_ptr<HistoryArchive>
-HistoryArchiveManager::selectRandomReadableHistoryArchive() const
+std::vector<std::shared_ptr<HistoryArchive>>
+HistoryArchiveManager::getReadableHistoryArchives() const
 {
     std::vector<std::shared_ptr<HistoryArchive>> archives;
 
@@ -148,7 +163,13 @@ HistoryArchiveManager::selectRandomReadableHistoryArchive() const
                          return x->hasGetCmd();
                      });
     }
+    return archives;
+}
 
+std::shared_ptr<HistoryArchive>
+HistoryArchiveManager::selectRandomReadableHistoryArchive() const
+{
+    auto archives = getReadableHistoryArchives();
     if (archives.size() == 0)
     {
         throw std::runtime_error("No GET-enabled history archive in config");
@@ -169,6 +190,97 @@ HistoryArchiveManager::selectRandomReadableHistoryArchive() const
     }
 }
 
+std::shared_ptr<HistoryArchive>
+HistoryArchiveManager::selectHistoryArchiveForDownload() const
+{
+    auto archives = getReadableHistoryArchives();
+    if (archives.size() <= 1)
+    {
+        return selectRandomReadableHistoryArchive();
+    }
+
+    // Archives nothing was downloaded from yet count as average ones, so
+    // that they get measured too
+    double measured = 0;
+    size_t nMeasured = 0;
+    for (auto const& archive : archives)
+    {
+        if (archive->getDownloadThroughput() > 0)
+        {
+            measured += archive->getDownloadThroughput();
+            ++nMeasured;
+        }
+    }
+    double unmeasured = nMeasured == 0 ? 1 : measured / nMeasured;
+
+    std::vector<std::shared_ptr<HistoryArchive>> free;
+    std::vector<double> weights;
+    for (auto const& archive : archives)
+    {
+        if (archive->getDownloadsInFlight() < archive->getDownloadConcurrency())
+        {
+            auto throughput = archive->getDownloadThroughput();
+            free.push_back(archive);
+            weights.push_back(throughput > 0 ? throughput : unmeasured);
+        }
+    }
+
+    if (free.empty())
+    {
+        return *std::min_element(
+            archives.begin(), archives.end(),
+            [](std::shared_ptr<HistoryArchive> const& a,
+               std::shared_ptr<HistoryArchive> const& b) {
+                return a->getDownloadsInFlight() * b->getDownloadConcurrency() <
+                       b->getDownloadsInFlight() * a->getDownloadConcurrency();
+            });
+    }
+
+    double total = 0;
+    for (auto w : weights)
+    {
+        total += w;
+    }
+    double r = rand_fraction() * total;
+    size_t i = 0;
+    while (i + 1 < free.size() && r >= weights[i])
+    {
+        r -= weights[i++];
+    }
+    auto const& archive = free.at(i);
+    CLOG_DEBUG(History, "Fetching from history archive '{}' ({} of {} busy)",
+               archive->getName(), archive->getDownloadsInFlight(),
+               archive->getDownloadConcurrency());
+    return archive;
+}
+
+size_t
+HistoryArchiveManager::getDownloadConcurrency() const
+{
+    size_t res = 0;
+    for (auto const& archive : getReadableHistoryArchives())
+    {
+        res += archive->getDownloadConcurrency();
+    }
+    return std::max<size_t>(res, 1);
+}
+
+Json::Value
+HistoryArchiveManager::getJsonDownloadInfo() const
+{
+    Json::Value res(Json::objectValue);
+    for (auto const& archive : getReadableHistoryArchives())
+    {
+        auto& info = res[archive->getName()];
+        info["bytes_per_second"] = archive->getDownloadThroughput();
+        info["concurrency"] =
+            static_cast<Json::UInt64>(archive->getDownloadConcurrency());
+        info["in_flight"] =
+            static_cast<Json::UInt64>(archive->getDownloadsInFlight());
+    }
+    return res;
+}
+
 std::shared_ptr<BasicWork>
 HistoryArchiveManager::getHistoryArchiveReportWork() const
 {
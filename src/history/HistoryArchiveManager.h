@@ -4,6 +4,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "lib/json/json.h"
 #include <memory>
 #include <string>
 #include <vector>
@@ -29,6 +30,20 @@ class HistoryArchiveManager
     // select one at random.
     std::shared_ptr<HistoryArchive> selectRandomReadableHistoryArchive() const;
 
+    // Select a readable history archive to download a file from, spreading
+    // downloads over all of them: among archives with download slots free
+    // (see HistoryArchive::getDownloadConcurrency), pick one at random
+    // weighted by measured throughput; if none has a slot free, pick the
+    // least loaded.
+    std::shared_ptr<HistoryArchive> selectHistoryArchiveForDownload() const;
+
+    // Number of downloads to run at once across all readable archives.
+    size_t getDownloadConcurrency() const;
+
+    // Download throughput, concurrency and downloads in flight per readable
+    // archive, by name.
+    Json::Value getJsonDownloadInfo() const;
+
     // Returns a work that reports the last-published checkpoint on each
     // archive.
     std::shared_ptr<BasicWork> getHistoryArchiveReportWork() const;
@@ -57,5 +72,8 @@ class HistoryArchiveManager
   private:
     Application& mApp;
     std::vector<std::shared_ptr<HistoryArchive>> mArchives;
+
+    std::vector<std::shared_ptr<HistoryArchive>>
+    getReadableHistoryArchives() const;
 };
 }
@@ -28,15 +28,16 @@
 #include "medida/metrics_registry.h"
 #include "overlay/StellarXDR.h"
 #include "process/ProcessManager.h"
+#include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/StatusManager.h"
 #include "util/TmpDir.h"
+#include "util/Tracing.h"
 #include "work/ConditionalWork.h"
 #include "work/WorkScheduler.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 #include <fstream>
@@ -69,7 +70,6 @@ HistoryManager::create(Application& app)
 HistoryManagerImpl::HistoryManagerImpl(Application& app)
     : mApp(app)
     , mWorkDir(nullptr)
-    , mPublishWork(nullptr)
     , mPublishSuccess(
           app.getMetrics().NewMeter({"history", "publish", "success"}, "event"))
     , mPublishFailure(
@@ -100,13 +100,18 @@ void
 HistoryManagerImpl::logAndUpdatePublishStatus()
 {
     std::stringstream stateStr;
-    if (mPublishWork)
+    if (!mPublishWorks.empty())
     {
         auto qlen = publishQueueLength();
         stateStr << "Publishing " << qlen << " queued checkpoints"
                  << " [" << getMinLedgerQueuedToPublish() << "-"
                  << getMaxLedgerQueuedToPublish() << "]"
-                 << ": " << mPublishWork->getStatus();
+                 << ": " << mPublishWorks.begin()->second->getStatus();
+        if (mPublishWorks.size() > 1)
+        {
+            stateStr << " (" << mPublishWorks.size() - 1
+                     << " more in progress)";
+        }
 
         auto current = stateStr.str();
         auto existing = mApp.getStatusManager().getStatusMessage(
@@ -232,6 +237,9 @@ HistoryManagerImpl::queueCurrentHistory()
     CLOG_DEBUG(History, "Queueing publish state for ledger {}", ledger);
     mEnqueueTimes.emplace(ledger, std::chrono::steady_clock::now());
 
+    // As in LedgerManagerImpl::storeCurrentLedger, the buckets of a queued
+    // HAS must be durable before it is
+    fs::syncDeferredRenames();
     auto state = has.toString();
     auto prep = mApp.getDatabase().getPreparedStatement(
         "INSERT INTO publishqueue (ledger, state) VALUES (:lg, :st);");
@@ -260,7 +268,7 @@ void
 HistoryManagerImpl::takeSnapshotAndPublish(HistoryArchiveState const& has)
 {
     ZoneScoped;
-    if (mPublishWork)
+    if (mPublishWorks.find(has.currentLedger) != mPublishWorks.end())
     {
         return;
     }
@@ -280,11 +288,22 @@ HistoryManagerImpl::takeSnapshotAndPublish(HistoryArchiveState const& has)
     auto resolveFutures = std::make_shared<ResolveSnapshotWork>(mApp, snap);
     // Phase 2: write snapshot files
     auto writeSnap = std::make_shared<WriteSnapshotWork>(mApp, snap);
-    // Phase 3: update archives
+    // Phase 3: update archives, once every earlier checkpoint is in them.
+    // Checkpoints are only removed from the queue once published, so this
+    // waits for this checkpoint to be the oldest one queued. This also keeps
+    // the archive states this checkpoint is compared against up to date, and
+    // keeps checkpoints from gzipping and uploading the same buckets at once.
     auto putSnap = std::make_shared<PutSnapshotFilesWork>(mApp, snap);
+    ConditionFn previousPublished = [ledgerSeq](Application& app) {
+        return app.getHistoryManager().getMinLedgerQueuedToPublish() ==
+               ledgerSeq;
+    };
+    auto putSnapInOrder = std::make_shared<ConditionalWork>(
+        mApp, fmt::format(FMT_STRING("wait-publish-{:08x}"), ledgerSeq),
+        previousPublished, putSnap);
 
     std::vector<std::shared_ptr<BasicWork>> seq{resolveFutures, writeSnap,
-                                                putSnap};
+                                                putSnapInOrder};
 
     auto start = mApp.getClock().now();
     ConditionFn delayTimeout = [start](Application& app) {
@@ -305,8 +324,12 @@ HistoryManagerImpl::takeSnapshotAndPublish(HistoryArchiveState const& has)
     auto publishWork =
         std::make_shared<PublishWork>(mApp, snap, seq, allBucketsFromHAS);
 
-    mPublishWork = mApp.getWorkScheduler().scheduleWork<ConditionalWork>(
+    auto work = mApp.getWorkScheduler().scheduleWork<ConditionalWork>(
         "delay-publishing-to-archive", delayTimeout, publishWork);
+    if (work)
+    {
+        mPublishWorks.emplace(ledgerSeq, work);
+    }
 }
 
 size_t
@@ -327,24 +350,49 @@ HistoryManagerImpl::publishQueuedHistory()
 #endif
 
     ZoneScoped;
-    std::string state;
+    auto maxPublishes = mApp.getConfig().MAX_CONCURRENT_CHECKPOINT_PUBLISHES;
+    if (mPublishWorks.size() >= maxPublishes)
+    {
+        return 0;
+    }
 
-    auto prep = mApp.getDatabase().getPreparedStatement(
-        "SELECT state FROM publishqueue"
-        " ORDER BY ledger ASC LIMIT 1;");
-    auto& st = prep.statement();
-    soci::indicator stateIndicator;
-    st.exchange(soci::into(state, stateIndicator));
-    st.define_and_bind();
-    st.execute(true);
-    if (st.got_data() && stateIndicator == soci::indicator::i_ok)
+    // The oldest queued checkpoints, some of which may already be publishing
+    std::vector<std::string> states;
+    {
+        std::string state;
+        uint32_t limit = static_cast<uint32_t>(maxPublishes);
+        auto prep = mApp.getDatabase().getPreparedStatement(
+            "SELECT state FROM publishqueue"
+            " ORDER BY ledger ASC LIMIT :lim;");
+        auto& st = prep.statement();
+        soci::indicator stateIndicator;
+        st.exchange(soci::into(state, stateIndicator));
+        st.exchange(soci::use(limit));
+        st.define_and_bind();
+        st.execute(true);
+        while (st.got_data())
+        {
+            if (stateIndicator == soci::indicator::i_ok)
+            {
+                states.emplace_back(state);
+            }
+            st.fetch();
+        }
+    }
+
+    size_t started = 0;
+    for (auto const& state : states)
     {
         HistoryArchiveState has;
         has.fromString(state);
-        takeSnapshotAndPublish(has);
-        return 1;
+        if (mPublishWorks.size() < maxPublishes &&
+            mPublishWorks.find(has.currentLedger) == mPublishWorks.end())
+        {
+            takeSnapshotAndPublish(has);
+            ++started;
+        }
     }
-    return 0;
+    return started;
 }
 
 std::vector<HistoryArchiveState>
@@ -456,7 +504,7 @@ HistoryManagerImpl::historyPublished(
     {
         this->mPublishFailure.Mark();
     }
-    mPublishWork.reset();
+    mPublishWorks.erase(ledgerSeq);
     mApp.postOnMainThread([this]() { this->publishQueuedHistory(); },
                           "HistoryManagerImpl: publishQueuedHistory");
 }
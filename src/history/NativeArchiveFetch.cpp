@@ -0,0 +1,222 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "history/NativeArchiveFetch.h"
+#include "util/Tracing.h"
+#include <fmt/format.h>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+#ifdef USE_CURL
+#include <curl/curl.h>
+#include <mutex>
+#include <zlib.h>
+#endif
+
+namespace stellar
+{
+namespace NativeArchiveFetch
+{
+
+#ifdef USE_CURL
+namespace
+{
+// Gives up on transfers slower than this many bytes per second over
+// LOW_SPEED_TIME seconds, so that a stalled server fails the work (which is
+// then retried, possibly against another archive) instead of hanging it
+constexpr long LOW_SPEED_LIMIT = 1024;
+constexpr long LOW_SPEED_TIME = 30;
+constexpr long CONNECT_TIMEOUT = 30;
+
+struct CurlDeleter
+{
+    void
+    operator()(CURL* curl) const
+    {
+        curl_easy_cleanup(curl);
+    }
+};
+
+// Easy handles keep their connections open between transfers, so keep one per
+// thread rather than one per file
+CURL*
+getHandle()
+{
+    static std::once_flag initFlag;
+    std::call_once(initFlag, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+    thread_local std::unique_ptr<CURL, CurlDeleter> curl(curl_easy_init());
+    return curl.get();
+}
+
+struct Transfer
+{
+    std::ofstream mOut;
+    bool mGunzip{false};
+    z_stream mZs{};
+    bool mStreamEnd{false};
+    size_t mBytesReceived{0};
+    std::string mError;
+
+    ~Transfer()
+    {
+        if (mGunzip)
+        {
+            inflateEnd(&mZs);
+        }
+    }
+
+    bool
+    write(char const* data, size_t size)
+    {
+        mBytesReceived += size;
+        if (!mGunzip)
+        {
+            mOut.write(data, size);
+            return static_cast<bool>(mOut);
+        }
+
+        char buf[64 * 1024];
+        mZs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        mZs.avail_in = static_cast<uInt>(size);
+        // Keep inflating while there is input left, or while the output
+        // buffer filled up and zlib may be holding more output back
+        do
+        {
+            if (mStreamEnd && mZs.avail_in > 0)
+            {
+                // Like gunzip, accept several concatenated gzip members
+                if (inflateReset(&mZs) != Z_OK)
+                {
+                    mError = "inflateReset failed";
+                    return false;
+                }
+                mStreamEnd = false;
+            }
+            mZs.next_out = reinterpret_cast<Bytef*>(buf);
+            mZs.avail_out = sizeof(buf);
+            int res = inflate(&mZs, Z_NO_FLUSH);
+            if (res == Z_STREAM_END)
+            {
+                mStreamEnd = true;
+            }
+            else if (res != Z_OK && res != Z_BUF_ERROR)
+            {
+                mError = fmt::format(FMT_STRING("invalid gzip data: {}"),
+                                     mZs.msg ? mZs.msg : "unknown error");
+                return false;
+            }
+            mOut.write(buf, sizeof(buf) - mZs.avail_out);
+            if (!mOut)
+            {
+                return false;
+            }
+            if (res == Z_BUF_ERROR)
+            {
+                // No progress possible until more input arrives
+                break;
+            }
+        } while (mZs.avail_in > 0 || (mZs.avail_out == 0 && !mStreamEnd));
+        return true;
+    }
+};
+
+size_t
+onData(char* data, size_t size, size_t nmemb, void* userdata)
+{
+    auto transfer = static_cast<Transfer*>(userdata);
+    // Returning anything but the size given aborts the transfer
+    return transfer->write(data, size * nmemb) ? size * nmemb : 0;
+}
+
+int
+onProgress(void* userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+{
+    auto cancel = static_cast<std::atomic<bool> const*>(userdata);
+    return cancel->load() ? 1 : 0;
+}
+}
+#endif
+
+bool
+isSupported()
+{
+#ifdef USE_CURL
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t
+fetch(std::string const& url, std::string const& local, bool gunzip,
+      std::atomic<bool> const& cancel)
+{
+    ZoneScoped;
+#ifdef USE_CURL
+    auto curl = getHandle();
+    if (!curl)
+    {
+        throw std::runtime_error("curl_easy_init failed");
+    }
+
+    Transfer transfer;
+    transfer.mOut.open(local, std::ofstream::binary | std::ofstream::trunc);
+    if (!transfer.mOut)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error opening file {}"), local));
+    }
+    if (gunzip)
+    {
+        // 16 + MAX_WBITS expects a gzip header and trailer
+        if (inflateInit2(&transfer.mZs, 16 + MAX_WBITS) != Z_OK)
+        {
+            throw std::runtime_error("inflateInit2 failed");
+        }
+        transfer.mGunzip = true;
+    }
+
+    curl_easy_reset(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, LOW_SPEED_LIMIT);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, LOW_SPEED_TIME);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, onData);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, onProgress);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &cancel);
+
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK)
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("Error fetching {}: {}"), url,
+            transfer.mError.empty() ? curl_easy_strerror(res)
+                                    : transfer.mError));
+    }
+    if (gunzip && !transfer.mStreamEnd)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Truncated gzip data from {}"), url));
+    }
+    transfer.mOut.close();
+    if (!transfer.mOut)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error writing file {}"), local));
+    }
+    return transfer.mBytesReceived;
+#else
+    throw std::runtime_error("native archive fetching is not supported");
+#endif
+}
+}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace stellar
+{
+
+// In-process download of history archive files over HTTP(S), for archives
+// configured with a `url` (see HistoryArchive::hasGetUrl). This saves the
+// process spawns of the archive's `get` command and of gunzip for every file.
+//
+// Each thread keeps its own connection, so files fetched one after another
+// from the same host reuse it, over HTTP/2 where the server offers it.
+namespace NativeArchiveFetch
+{
+// Whether this build can fetch files natively at all
+bool isSupported();
+
+// Downloads `url` into the file `local`, decompressing it on the fly if
+// `gunzip` is set. Returns the number of bytes received. Throws
+// std::runtime_error if the download fails, is cancelled through `cancel`, or
+// does not decompress; `local` may then hold a partial file.
+size_t fetch(std::string const& url, std::string const& local, bool gunzip,
+             std::atomic<bool> const& cancel);
+}
+}
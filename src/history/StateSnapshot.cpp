@@ -18,8 +18,8 @@
 #include "transactions/TransactionSQL.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/XDRStream.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -51,12 +51,17 @@ bool
 StateSnapshot::writeHistoryBlocks() const
 {
     ZoneScoped;
-    std::unique_ptr<soci::session> snapSess(
+    std::unique_ptr<PooledSession> snapSess(
         mApp.getDatabase().canUsePool()
-            ? std::make_unique<soci::session>(mApp.getDatabase().getPool())
+            ? std::make_unique<PooledSession>(mApp.getDatabase())
             : nullptr);
-    soci::session& sess(snapSess ? *snapSess : mApp.getDatabase().getSession());
+    soci::session& sess(snapSess ? snapSess->session()
+                                 : mApp.getDatabase().getSession());
     soci::transaction tx(sess);
+    if (snapSess)
+    {
+        snapSess->setCurrentTransactionReadOnly();
+    }
 
     // The current "history block" is stored in _four_ files, one just ledger
     // headers, one TransactionHistoryEntry (which contain txSets),
@@ -7,6 +7,7 @@
 #include "catchup/CatchupManagerImpl.h"
 #include "catchup/test/CatchupWorkTests.h"
 #include "history/FileTransferInfo.h"
+#include "history/HistoryArchive.h"
 #include "history/HistoryArchiveManager.h"
 #include "history/HistoryManager.h"
 #include "history/test/HistoryTestsUtils.h"
@@ -14,6 +15,7 @@
 #include "historywork/GunzipFileWork.h"
 #include "historywork/GzipFileWork.h"
 #include "historywork/PutHistoryArchiveStateWork.h"
+#include "ledger/LedgerHeaderUtils.h"
 #include "ledger/LedgerManager.h"
 #include "main/ExternalQueue.h"
 #include "main/PersistentState.h"
@@ -32,6 +34,10 @@
 #include "historywork/VerifyTxResultsWork.h"
 #include <fmt/format.h>
 #include <lib/catch.hpp>
+#include <medida/counter.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
 
 using namespace stellar;
 using namespace historytestutils;
@@ -104,6 +110,81 @@ TEST_CASE("HistoryManager compress", "[history]")
     REQUIRE(!fs::exists(compressed));
 }
 
+TEST_CASE("HistoryManager compress file spanning many blocks", "[history]")
+{
+    CatchupSimulation catchupSimulation{};
+
+    // Several megabytes of compressible but not repetitive data, so that the
+    // in-process compression splits it into blocks on several threads
+    std::string s;
+    for (uint32_t i = 0; s.size() < 5 * 1024 * 1024 + 17; ++i)
+    {
+        s += fmt::format(FMT_STRING("line {} of {}\n"), i, i * 2654435761u);
+    }
+    HistoryManager& hm = catchupSimulation.getApp().getHistoryManager();
+    std::string fname = hm.localFilename("compressme-big");
+    {
+        std::ofstream out;
+        out.exceptions(std::ios::failbit | std::ios::badbit);
+        out.open(fname, std::ofstream::binary);
+        out.write(s.data(), s.size());
+    }
+    std::string compressed = fname + ".gz";
+    auto& wm = catchupSimulation.getApp().getWorkScheduler();
+    auto g = wm.executeWork<GzipFileWork>(fname, true);
+    REQUIRE(g->getState() == BasicWork::State::WORK_SUCCESS);
+    REQUIRE(fs::exists(fname));
+    REQUIRE(fs::exists(compressed));
+    REQUIRE(fs::size(compressed) < s.size() / 2);
+
+    std::remove(fname.c_str());
+    auto u = wm.executeWork<GunzipFileWork>(compressed);
+    REQUIRE(u->getState() == BasicWork::State::WORK_SUCCESS);
+    std::ifstream in(fname, std::ifstream::binary);
+    std::string roundTrip((std::istreambuf_iterator<char>(in)),
+                          std::istreambuf_iterator<char>());
+    REQUIRE(roundTrip == s);
+}
+
+TEST_CASE("history archive download concurrency adapts", "[history]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    HistoryArchiveConfiguration hac;
+    hac.mName = "adaptive";
+    hac.mGetCmd = "cp {0} {1}";
+    auto archive = std::make_shared<HistoryArchive>(*app, hac);
+    archive->initDownloadConcurrency(4, 8);
+    REQUIRE(archive->getDownloadConcurrency() == 4);
+    REQUIRE(archive->getDownloadThroughput() == 0);
+
+    // Abandoned downloads only free their slot
+    {
+        HistoryArchiveDownload download(archive);
+        REQUIRE(archive->getDownloadsInFlight() == 1);
+    }
+    REQUIRE(archive->getDownloadsInFlight() == 0);
+    REQUIRE(archive->getDownloadConcurrency() == 4);
+
+    // Successful downloads raise the limit up to its cap
+    for (int i = 0; i < 100; ++i)
+    {
+        HistoryArchiveDownload download(archive);
+        download.finish(true, 1 << 20);
+    }
+    REQUIRE(archive->getDownloadsInFlight() == 0);
+    REQUIRE(archive->getDownloadConcurrency() == 8);
+    REQUIRE(archive->getDownloadThroughput() > 0);
+
+    // Failures halve it, down to 1
+    for (size_t expected : {4, 2, 1, 1})
+    {
+        HistoryArchiveDownload download(archive);
+        download.finish(false, 0);
+        REQUIRE(archive->getDownloadConcurrency() == expected);
+    }
+}
+
 TEST_CASE("HistoryArchiveState get_put", "[history]")
 {
     CatchupSimulation catchupSimulation{};
@@ -507,6 +588,53 @@ TEST_CASE("History catchup with extra validation", "[history][publish]")
     REQUIRE(catchupSimulation.catchupOffline(app, checkpointLedger, true));
 }
 
+TEST_CASE("History catchup with trusted replay", "[history][catchup]")
+{
+    CatchupSimulation catchupSimulation{};
+    auto checkpointLedger = catchupSimulation.getLastCheckpointLedger(3);
+    catchupSimulation.ensureOfflineCatchupPossible(checkpointLedger);
+
+    auto app = catchupSimulation.createCatchupApplication(
+        std::numeric_limits<uint32_t>::max(), Config::TESTDB_ON_DISK_SQLITE,
+        "app", false, false, std::nullopt, true);
+    REQUIRE(catchupSimulation.catchupOffline(app, checkpointLedger));
+
+    // The simulation's payments all succeed, so none of their signatures
+    // needed checking
+    auto& metrics = app->getMetrics();
+    auto trusted =
+        metrics.NewCounter({"ledger", "apply", "trusted-signatures"}).count();
+    CHECK(trusted > 0);
+    CHECK(trusted ==
+          metrics.NewCounter({"ledger", "apply", "success"}).count());
+}
+
+TEST_CASE("History catchup times each phase", "[history][catchup]")
+{
+    CatchupSimulation catchupSimulation{};
+    auto checkpointLedger = catchupSimulation.getLastCheckpointLedger(2);
+    catchupSimulation.ensureOfflineCatchupPossible(checkpointLedger);
+
+    auto app = catchupSimulation.createCatchupApplication(
+        std::numeric_limits<uint32_t>::max(), Config::TESTDB_ON_DISK_SQLITE,
+        "app");
+    REQUIRE(catchupSimulation.catchupOffline(app, checkpointLedger));
+
+    auto phaseCount = [&](CatchupWork::Phase phase) {
+        return app->getMetrics()
+            .NewTimer({"catchup", "phase", CatchupWork::getPhaseName(phase)})
+            .count();
+    };
+    CHECK(phaseCount(CatchupWork::Phase::GET_ARCHIVE_STATE) == 1);
+    CHECK(phaseCount(CatchupWork::Phase::REPLAY) == 1);
+    CHECK(app->getMetrics()
+              .NewMeter({"catchup", "replay", "ledgers"}, "ledger")
+              .count() > 0);
+
+    // Progress is only reported while catching up
+    CHECK(app->getCatchupManager().getJsonProgress().isNull());
+}
+
 TEST_CASE("Publish works correctly post shadow removal", "[history]")
 {
     // Given a HAS, verify that appropriate levels have "next" cleared, while
@@ -1308,6 +1436,85 @@ TEST_CASE("persist publish queue", "[history][publish][acceptance]")
     }
 }
 
+TEST_CASE("budgeted maintenance trims history", "[history]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+    cfg.AUTOMATIC_MAINTENANCE_PERIOD = std::chrono::seconds{1};
+    cfg.AUTOMATIC_MAINTENANCE_COUNT = 1;
+    cfg.AUTOMATIC_MAINTENANCE_TIME_BUDGET = std::chrono::seconds{10};
+    auto app = createTestApplication(clock, cfg);
+    auto freq = app->getHistoryManager().getCheckpointFrequency();
+    while (app->getLedgerManager().getLastClosedLedgerNum() < 4 * freq)
+    {
+        txtest::closeLedger(*app);
+    }
+
+    auto& chunks =
+        app->getMetrics().NewTimer({"history", "maintenance", "chunk"});
+    auto oldest = [&]() {
+        return LedgerHeaderUtils::getOldestLedgerSeq(
+            app->getDatabase().getSession());
+    };
+    auto maxLedger = ExternalQueue(*app).getMaxLedgerToDelete();
+    REQUIRE(maxLedger > freq);
+    REQUIRE(oldest() <= maxLedger);
+    auto deadline = clock.now() + std::chrono::seconds{30};
+    while (oldest() <= maxLedger && clock.now() < deadline)
+    {
+        clock.crank(true);
+    }
+    REQUIRE(oldest() == maxLedger + 1);
+
+    // Chunks started at a single ledger and grew from there
+    REQUIRE(chunks.count() > 1);
+    REQUIRE(chunks.count() < maxLedger);
+    REQUIRE(app->getMetrics()
+                .NewCounter({"history", "maintenance", "backlog"})
+                .count() == 0);
+}
+
+TEST_CASE("publish backlog in order", "[history][publish]")
+{
+    Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+    cfg.MANUAL_CLOSE = false;
+    cfg.ARTIFICIALLY_ACCELERATE_TIME_FOR_TESTING = true;
+    cfg.MAX_CONCURRENT_CHECKPOINT_PUBLISHES = 3;
+    TmpDirHistoryConfigurator tcfg;
+    cfg = tcfg.configure(cfg, true);
+
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    app->getHistoryArchiveManager().initializeHistoryArchive(
+        tcfg.getArchiveDirName());
+    auto& hm = app->getHistoryManager();
+    hm.setPublicationEnabled(false);
+    while (hm.getPublishQueueCount() < 5)
+    {
+        clock.crank(true);
+    }
+    REQUIRE(hm.getPublishSuccessCount() == 0);
+
+    hm.setPublicationEnabled(true);
+    REQUIRE(hm.publishQueuedHistory() == 3);
+    // Publishes already in progress are not started again
+    REQUIRE(hm.publishQueuedHistory() == 0);
+
+    while (hm.getPublishSuccessCount() < 5)
+    {
+        auto minQueued = hm.getMinLedgerQueuedToPublish();
+        auto published = hm.getPublishSuccessCount();
+        clock.crank(true);
+        // Only the oldest queued checkpoint is ever done publishing
+        if (hm.getPublishSuccessCount() != published)
+        {
+            REQUIRE(hm.getPublishSuccessCount() == published + 1);
+            REQUIRE(hm.getMinLedgerQueuedToPublish() != minQueued);
+        }
+    }
+    REQUIRE(hm.getPublishFailureCount() == 0);
+}
+
 // The idea with this test is that we join a network and somehow get a gap
 // in the SCP voting sequence while we're trying to catchup. This will let
 // system catchup just before the gap.
@@ -710,7 +710,8 @@ CatchupSimulation::crankUntil(Application::pointer app,
 Application::pointer
 CatchupSimulation::createCatchupApplication(
     uint32_t count, Config::TestDbMode dbMode, std::string const& appName,
-    bool publish, bool useBucketListDB, std::optional<uint32_t> ledgerVersion)
+    bool publish, bool useBucketListDB, std::optional<uint32_t> ledgerVersion,
+    bool trustedReplay)
 {
     CLOG_INFO(History, "****");
     CLOG_INFO(History, "**** Create app for catchup: '{}'", appName);
@@ -722,6 +723,7 @@ CatchupSimulation::createCatchupApplication(
         count == std::numeric_limits<uint32_t>::max();
     mCfgs.back().CATCHUP_RECENT = count;
     mCfgs.back().DEPRECATED_SQL_LEDGER_STATE = !useBucketListDB;
+    mCfgs.back().CATCHUP_TRUSTED_REPLAY = trustedReplay;
     if (ledgerVersion)
     {
         mCfgs.back().TESTING_UPGRADE_LEDGER_PROTOCOL_VERSION = *ledgerVersion;
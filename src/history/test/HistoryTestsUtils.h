@@ -260,7 +260,8 @@ class CatchupSimulation
     Application::pointer createCatchupApplication(
         uint32_t count, Config::TestDbMode dbMode, std::string const& appName,
         bool publish = false, bool useBucketListDB = false,
-        std::optional<uint32_t> ledgerVersion = std::nullopt);
+        std::optional<uint32_t> ledgerVersion = std::nullopt,
+        bool trustedReplay = false);
     bool catchupOffline(Application::pointer app, uint32_t toLedger,
                         bool extraValidation = false);
     bool catchupOnline(Application::pointer app, uint32_t initLedger,
@@ -40,3 +40,20 @@ TEST_CASE("Serialization round trip", "[history]")
         }
     }
 }
+
+TEST_CASE("Bucket list hash of archive state", "[history]")
+{
+    HistoryArchiveState has;
+    has.load("testdata/stellar-history.livenet.15686975.json");
+    auto hash = has.getBucketListHash();
+    REQUIRE(hash == has.getBucketListHash());
+
+    // Memoized level hashes follow changes to the buckets of their level
+    std::swap(has.currentBuckets[3].curr, has.currentBuckets[3].snap);
+    auto changed = has.getBucketListHash();
+    REQUIRE(changed != hash);
+
+    HistoryArchiveState reloaded;
+    reloaded.fromString(has.toString());
+    REQUIRE(reloaded.getBucketListHash() == changed);
+}
@@ -5,11 +5,12 @@
 #include "historywork/BatchDownloadWork.h"
 #include "catchup/CatchupManager.h"
 #include "history/HistoryArchive.h"
+#include "history/HistoryArchiveManager.h"
 #include "history/HistoryManager.h"
 #include "historywork/GetAndUnzipRemoteFileWork.h"
 #include "historywork/Progress.h"
 #include "main/Application.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -73,4 +74,13 @@ BatchDownloadWork::resetIter()
 {
     mNext = mRange.mFirst;
 }
+
+size_t
+BatchDownloadWork::getBatchWidth() const
+{
+    // Follow the adaptive download concurrency of the archive(s) we fetch
+    // from rather than a fixed width
+    return mArchive ? mArchive->getDownloadConcurrency()
+                    : mApp.getHistoryArchiveManager().getDownloadConcurrency();
+}
 }
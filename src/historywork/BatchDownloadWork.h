@@ -37,5 +37,6 @@ class BatchDownloadWork : public BatchWork
     bool hasNext() const override;
     std::shared_ptr<BasicWork> yieldMoreWork() override;
     void resetIter() override;
+    size_t getBatchWidth() const override;
 };
 }
@@ -4,13 +4,15 @@
 
 #include "historywork/DownloadBucketsWork.h"
 #include "bucket/BucketManager.h"
+#include "bucket/SharedBucketStore.h"
 #include "catchup/CatchupManager.h"
 #include "history/FileTransferInfo.h"
 #include "history/HistoryArchive.h"
+#include "history/HistoryArchiveManager.h"
 #include "historywork/GetAndUnzipRemoteFileWork.h"
 #include "historywork/VerifyBucketWork.h"
+#include "util/Tracing.h"
 #include "work/WorkWithCallback.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 namespace stellar
@@ -71,6 +73,32 @@ DownloadBucketsWork::yieldMoreWork()
     }
 
     auto hash = *mNextBucketIter;
+    std::weak_ptr<DownloadBucketsWork> weak(
+        std::static_pointer_cast<DownloadBucketsWork>(shared_from_this()));
+
+    // Another instance on this host may have the bucket already
+    auto store = mApp.getBucketManager().getSharedBucketStore();
+    if (store && store->hasBucket(hexToBin256(hash)))
+    {
+        auto adoptCb = [weak, hash](Application& app) -> bool {
+            auto self = weak.lock();
+            if (self)
+            {
+                auto b = app.getBucketManager().adoptBucketFromSharedStore(
+                    hexToBin256(hash));
+                if (!b)
+                {
+                    return false;
+                }
+                self->mBuckets[hash] = b;
+            }
+            return true;
+        };
+        ++mNextBucketIter;
+        return std::make_shared<WorkWithCallback>(
+            mApp, "adopt-shared-bucket-" + hash, adoptCb);
+    }
+
     FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_BUCKET, hash);
     auto w1 = std::make_shared<GetAndUnzipRemoteFileWork>(mApp, ft, mArchive);
 
@@ -87,8 +115,6 @@ DownloadBucketsWork::yieldMoreWork()
             }
         }
     };
-    std::weak_ptr<DownloadBucketsWork> weak(
-        std::static_pointer_cast<DownloadBucketsWork>(shared_from_this()));
     auto successCb = [weak, ft, hash](Application& app) -> bool {
         auto self = weak.lock();
         if (self)
@@ -113,4 +139,13 @@ DownloadBucketsWork::yieldMoreWork()
     ++mNextBucketIter;
     return w4;
 }
+
+size_t
+DownloadBucketsWork::getBatchWidth() const
+{
+    // Follow the adaptive download concurrency of the archive(s) we fetch
+    // from rather than a fixed width
+    return mArchive ? mArchive->getDownloadConcurrency()
+                    : mApp.getHistoryArchiveManager().getDownloadConcurrency();
+}
 }
@@ -36,5 +36,6 @@ class DownloadBucketsWork : public BatchWork
     bool hasNext() const override;
     std::shared_ptr<BasicWork> yieldMoreWork() override;
     void resetIter() override;
+    size_t getBatchWidth() const override;
 };
 }
@@ -11,8 +11,8 @@
 #include "main/ErrorMessages.h"
 #include "util/FileSystemException.h"
 #include "util/TmpDir.h"
+#include "util/Tracing.h"
 #include "util/XDRStream.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -0,0 +1,139 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "historywork/FetchRemoteFileWork.h"
+#include "history/HistoryArchive.h"
+#include "history/NativeArchiveFetch.h"
+#include "main/Application.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/Tracing.h"
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+
+namespace stellar
+{
+
+FetchRemoteFileWork::FetchRemoteFileWork(
+    Application& app, std::string const& remote, std::string const& local,
+    bool gunzip, std::shared_ptr<HistoryArchive> archive, size_t maxRetries)
+    : BasicWork(app, std::string("fetch-remote-file ") + remote, maxRetries)
+    , mRemote(remote)
+    , mLocal(local)
+    , mGunzip(gunzip)
+    , mArchive(archive)
+    , mCancel(std::make_shared<std::atomic<bool>>(false))
+    , mFailuresPerSecond(
+          app.getMetrics().NewMeter({"history", "get", "failure"}, "failure"))
+    , mBytesPerSecond(
+          app.getMetrics().NewMeter({"history", "get", "throughput"}, "bytes"))
+{
+    releaseAssert(mArchive);
+    releaseAssert(mArchive->hasGetUrl());
+}
+
+FetchRemoteFileWork::~FetchRemoteFileWork()
+{
+}
+
+BasicWork::State
+FetchRemoteFileWork::onRun()
+{
+    ZoneScoped;
+    if (mDone)
+    {
+        return mFailed ? State::WORK_FAILURE : State::WORK_SUCCESS;
+    }
+
+    spawnFetch();
+    return State::WORK_WAITING;
+}
+
+void
+FetchRemoteFileWork::spawnFetch()
+{
+    auto url = mArchive->getFileUrl(mRemote);
+    auto local = mLocal;
+    auto gunzip = mGunzip;
+    auto cancel = mCancel;
+    Application& app = mApp;
+    std::weak_ptr<FetchRemoteFileWork> weak(
+        std::static_pointer_cast<FetchRemoteFileWork>(shared_from_this()));
+    mFetching = true;
+    mDownload = std::make_unique<HistoryArchiveDownload>(mArchive);
+    app.postOnBackgroundThread(
+        [&app, url, local, gunzip, cancel, weak]() {
+            bool failed = false;
+            size_t bytes = 0;
+            try
+            {
+                ZoneNamedN(fetchZone, "fetch remote file", true);
+                bytes = NativeArchiveFetch::fetch(url, local, gunzip, *cancel);
+            }
+            catch (std::exception const& e)
+            {
+                CLOG_WARNING(History, "{}", e.what());
+                failed = true;
+            }
+
+            // BasicWork's state is only touched from the main thread
+            app.postOnMainThread(
+                [weak, failed, bytes]() {
+                    auto self = weak.lock();
+                    if (self)
+                    {
+                        self->mFetching = false;
+                        self->mFailed = failed;
+                        self->mBytesReceived = bytes;
+                        self->mDone = true;
+                        self->wakeUpAndRun();
+                    }
+                },
+                "FetchRemoteFile: finish");
+        },
+        "FetchRemoteFile: start in background");
+}
+
+bool
+FetchRemoteFileWork::onAbort()
+{
+    // The background fetch still owns the local file until it returns
+    mCancel->store(true);
+    return !mFetching;
+}
+
+void
+FetchRemoteFileWork::onReset()
+{
+    std::remove(mLocal.c_str());
+    mDownload.reset();
+    mDone = false;
+    mFailed = false;
+    mBytesReceived = 0;
+    mCancel = std::make_shared<std::atomic<bool>>(false);
+}
+
+void
+FetchRemoteFileWork::onSuccess()
+{
+    mBytesPerSecond.Mark(mBytesReceived);
+    if (mDownload)
+    {
+        mDownload->finish(true, mBytesReceived);
+    }
+}
+
+void
+FetchRemoteFileWork::onFailureRaise()
+{
+    mFailuresPerSecond.Mark(1);
+    if (mDownload)
+    {
+        mDownload->finish(false, 0);
+    }
+    CLOG_ERROR(History,
+               "Could not download file: archive {} maybe missing file {}",
+               mArchive->getName(), mRemote);
+}
+}
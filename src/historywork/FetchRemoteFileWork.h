@@ -0,0 +1,58 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "work/BasicWork.h"
+#include <atomic>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+
+class HistoryArchive;
+class HistoryArchiveDownload;
+
+// Downloads a file from a history archive with a `url` in-process, on a
+// background thread, rather than by running the archive's get command (see
+// NativeArchiveFetch). If `gunzip` is set, the file is decompressed as it
+// arrives, so `local` receives the uncompressed contents.
+class FetchRemoteFileWork : public BasicWork
+{
+    std::string const mRemote;
+    std::string const mLocal;
+    bool const mGunzip;
+    std::shared_ptr<HistoryArchive> const mArchive;
+
+    bool mFetching{false};
+    bool mDone{false};
+    bool mFailed{false};
+    size_t mBytesReceived{0};
+    std::shared_ptr<std::atomic<bool>> mCancel;
+    std::unique_ptr<HistoryArchiveDownload> mDownload;
+
+    medida::Meter& mFailuresPerSecond;
+    medida::Meter& mBytesPerSecond;
+
+    void spawnFetch();
+
+  public:
+    FetchRemoteFileWork(Application& app, std::string const& remote,
+                        std::string const& local, bool gunzip,
+                        std::shared_ptr<HistoryArchive> archive,
+                        size_t maxRetries = BasicWork::RETRY_NEVER);
+    ~FetchRemoteFileWork();
+
+  protected:
+    State onRun() override;
+    bool onAbort() override;
+    void onReset() override;
+    void onSuccess() override;
+    void onFailureRaise() override;
+};
+}
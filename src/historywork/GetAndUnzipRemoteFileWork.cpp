@@ -5,11 +5,14 @@
 #include "historywork/GetAndUnzipRemoteFileWork.h"
 #include "catchup/CatchupManager.h"
 #include "history/HistoryArchive.h"
+#include "history/HistoryArchiveManager.h"
+#include "historywork/FetchRemoteFileWork.h"
 #include "historywork/GetRemoteFileWork.h"
 #include "historywork/GunzipFileWork.h"
+#include "main/Application.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -28,7 +31,11 @@ GetAndUnzipRemoteFileWork::GetAndUnzipRemoteFileWork(
 std::string
 GetAndUnzipRemoteFileWork::getStatus() const
 {
-    if (mGunzipFileWork)
+    if (mFetchRemoteFileWork)
+    {
+        return mFetchRemoteFileWork->getStatus();
+    }
+    else if (mGunzipFileWork)
     {
         return mGunzipFileWork->getStatus();
     }
@@ -45,8 +52,11 @@ GetAndUnzipRemoteFileWork::doReset()
     std::remove(mFt.localPath_nogz().c_str());
     std::remove(mFt.localPath_gz().c_str());
     std::remove(mFt.localPath_gz_tmp().c_str());
+    std::remove(localPath_fetch_tmp().c_str());
     mGetRemoteFileWork.reset();
     mGunzipFileWork.reset();
+    mFetchRemoteFileWork.reset();
+    mFetchArchive.reset();
 }
 
 void
@@ -73,7 +83,25 @@ BasicWork::State
 GetAndUnzipRemoteFileWork::doWork()
 {
     ZoneScoped;
-    if (mGunzipFileWork)
+    if (mFetchRemoteFileWork)
+    {
+        auto state = mFetchRemoteFileWork->getState();
+        if (state == State::WORK_SUCCESS)
+        {
+            // The file was unzipped as it was downloaded
+            if (std::rename(localPath_fetch_tmp().c_str(),
+                            mFt.localPath_nogz().c_str()))
+            {
+                CLOG_ERROR(History,
+                           "Downloading and unzipping {}: failed to rename "
+                           "fetched file to .xdr",
+                           mFt.remoteName());
+                return State::WORK_FAILURE;
+            }
+        }
+        return state;
+    }
+    else if (mGunzipFileWork)
     {
         // Download completed, unzipping started
         releaseAssert(mGetRemoteFileWork);
@@ -106,9 +134,23 @@ GetAndUnzipRemoteFileWork::doWork()
     else
     {
         CLOG_DEBUG(History, "Downloading and unzipping {}", mFt.remoteName());
+        auto archive = mArchive;
+        if (!archive)
+        {
+            archive = mApp.getHistoryArchiveManager()
+                          .selectHistoryArchiveForDownload();
+        }
+        if (archive->hasGetUrl())
+        {
+            mFetchArchive = archive;
+            mFetchRemoteFileWork = addWork<FetchRemoteFileWork>(
+                mFt.remoteName(), localPath_fetch_tmp(), /* gunzip */ true,
+                archive, BasicWork::RETRY_NEVER);
+            return State::WORK_RUNNING;
+        }
         mGetRemoteFileWork =
             addWork<GetRemoteFileWork>(mFt.remoteName(), mFt.localPath_gz_tmp(),
-                                       mArchive, BasicWork::RETRY_NEVER);
+                                       archive, BasicWork::RETRY_NEVER);
         return State::WORK_RUNNING;
     }
 }
@@ -157,9 +199,20 @@ GetAndUnzipRemoteFileWork::validateFile()
     return true;
 }
 
+std::string
+GetAndUnzipRemoteFileWork::localPath_fetch_tmp() const
+{
+    return mFt.localPath_nogz() + ".tmp";
+}
+
 std::shared_ptr<HistoryArchive>
 GetAndUnzipRemoteFileWork::getArchive() const
 {
+    if (mFetchRemoteFileWork &&
+        mFetchRemoteFileWork->getState() == BasicWork::State::WORK_SUCCESS)
+    {
+        return mFetchArchive;
+    }
     if (mGetRemoteFileWork &&
         mGetRemoteFileWork->getState() == BasicWork::State::WORK_SUCCESS)
     {
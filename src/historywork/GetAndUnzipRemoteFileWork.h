@@ -12,16 +12,21 @@ namespace stellar
 
 class HistoryArchive;
 class GetRemoteFileWork;
+class FetchRemoteFileWork;
 
 class GetAndUnzipRemoteFileWork : public Work
 {
     std::shared_ptr<GetRemoteFileWork> mGetRemoteFileWork;
     std::shared_ptr<BasicWork> mGunzipFileWork;
+    // Used instead of the two works above for archives with a `url`
+    std::shared_ptr<FetchRemoteFileWork> mFetchRemoteFileWork;
+    std::shared_ptr<HistoryArchive> mFetchArchive;
 
     FileTransferInfo mFt;
     std::shared_ptr<HistoryArchive> const mArchive;
 
     bool validateFile();
+    std::string localPath_fetch_tmp() const;
 
   public:
     // Passing `nullptr` for the archive argument will cause the work to
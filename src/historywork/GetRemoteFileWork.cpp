@@ -30,6 +30,10 @@ GetRemoteFileWork::GetRemoteFileWork(Application& app,
 {
 }
 
+GetRemoteFileWork::~GetRemoteFileWork()
+{
+}
+
 CommandInfo
 GetRemoteFileWork::getCommand()
 {
@@ -42,6 +46,7 @@ GetRemoteFileWork::getCommand()
     releaseAssert(mCurrentArchive);
     releaseAssert(mCurrentArchive->hasGetCmd());
     auto cmdLine = mCurrentArchive->getFileCmd(mRemote, mLocal);
+    mDownload = std::make_unique<HistoryArchiveDownload>(mCurrentArchive);
 
     return CommandInfo{cmdLine, std::string()};
 }
@@ -50,6 +55,7 @@ void
 GetRemoteFileWork::onReset()
 {
     std::remove(mLocal.c_str());
+    mDownload.reset();
     RunCommandWork::onReset();
 }
 
@@ -57,15 +63,34 @@ void
 GetRemoteFileWork::onSuccess()
 {
     releaseAssert(mCurrentArchive);
-    mBytesPerSecond.Mark(fs::size(mLocal));
+    auto size = fs::size(mLocal);
+    mBytesPerSecond.Mark(size);
+    if (mDownload)
+    {
+        mDownload->finish(true, size);
+    }
     RunCommandWork::onSuccess();
 }
 
+void
+GetRemoteFileWork::onFailureRetry()
+{
+    if (mDownload)
+    {
+        mDownload->finish(false, 0);
+    }
+    RunCommandWork::onFailureRetry();
+}
+
 void
 GetRemoteFileWork::onFailureRaise()
 {
     releaseAssert(mCurrentArchive);
     mFailuresPerSecond.Mark(1);
+    if (mDownload)
+    {
+        mDownload->finish(false, 0);
+    }
     CLOG_ERROR(History,
                "Could not download file: archive {} maybe missing file {}",
                mCurrentArchive->getName(), mRemote);
@@ -11,6 +11,7 @@ namespace stellar
 {
 
 class HistoryArchive;
+class HistoryArchiveDownload;
 
 class GetRemoteFileWork : public RunCommandWork
 {
@@ -18,6 +19,7 @@ class GetRemoteFileWork : public RunCommandWork
     std::string const mLocal;
     std::shared_ptr<HistoryArchive> const mArchive;
     std::shared_ptr<HistoryArchive> mCurrentArchive;
+    std::unique_ptr<HistoryArchiveDownload> mDownload;
     CommandInfo getCommand() override;
     medida::Meter& mFailuresPerSecond;
     medida::Meter& mBytesPerSecond;
@@ -30,12 +32,13 @@ class GetRemoteFileWork : public RunCommandWork
                       std::string const& local,
                       std::shared_ptr<HistoryArchive> archive = nullptr,
                       size_t maxRetries = BasicWork::RETRY_A_LOT);
-    ~GetRemoteFileWork() = default;
+    ~GetRemoteFileWork();
     std::shared_ptr<HistoryArchive> getCurrentArchive() const;
 
   protected:
     void onReset() override;
     void onSuccess() override;
+    void onFailureRetry() override;
     void onFailureRaise() override;
 };
 }
@@ -3,7 +3,11 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "historywork/GzipFileWork.h"
+#include "main/Application.h"
 #include "util/Fs.h"
+#include "util/Logging.h"
+#include "util/ParallelGzip.h"
+#include "util/Tracing.h"
 
 namespace stellar
 {
@@ -14,15 +18,100 @@ GzipFileWork::GzipFileWork(Application& app, std::string const& filenameNoGz,
                      BasicWork::RETRY_A_LOT)
     , mFilenameNoGz(filenameNoGz)
     , mKeepExisting(keepExisting)
+    , mCancel(std::make_shared<std::atomic<bool>>(false))
 {
     fs::checkNoGzipSuffix(mFilenameNoGz);
 }
 
+BasicWork::State
+GzipFileWork::onRun()
+{
+    ZoneScoped;
+    if (!ParallelGzip::isSupported())
+    {
+        return RunCommandWork::onRun();
+    }
+
+    if (mDone)
+    {
+        return mFailed ? State::WORK_FAILURE : State::WORK_SUCCESS;
+    }
+
+    spawnCompress();
+    return State::WORK_WAITING;
+}
+
+void
+GzipFileWork::spawnCompress()
+{
+    auto in = mFilenameNoGz;
+    auto keepExisting = mKeepExisting;
+    auto cancel = mCancel;
+    // Each file may use all worker threads; several files are usually
+    // compressed at once, so they share the cores between them
+    auto threads =
+        static_cast<size_t>(std::max(1, mApp.getConfig().WORKER_THREADS));
+    Application& app = mApp;
+    std::weak_ptr<GzipFileWork> weak(
+        std::static_pointer_cast<GzipFileWork>(shared_from_this()));
+    mCompressing = true;
+    app.postOnBackgroundThread(
+        [&app, in, keepExisting, cancel, threads, weak]() {
+            bool failed = false;
+            try
+            {
+                ParallelGzip::compressFile(in, in + ".gz", threads, *cancel);
+                // Like gzip without -c, replace the file with its .gz
+                if (!keepExisting)
+                {
+                    std::remove(in.c_str());
+                }
+            }
+            catch (std::exception const& e)
+            {
+                CLOG_WARNING(History, "{}", e.what());
+                failed = true;
+            }
+
+            // BasicWork's state is only touched from the main thread
+            app.postOnMainThread(
+                [weak, failed]() {
+                    auto self = weak.lock();
+                    if (self && self->mCompressing)
+                    {
+                        self->mCompressing = false;
+                        self->mFailed = failed;
+                        self->mDone = true;
+                        self->wakeUpAndRun();
+                    }
+                },
+                "GzipFile: finish");
+        },
+        "GzipFile: start in background");
+}
+
+bool
+GzipFileWork::onAbort()
+{
+    if (!ParallelGzip::isSupported())
+    {
+        return RunCommandWork::onAbort();
+    }
+    // The background compression still owns the .gz file until it returns
+    mCancel->store(true);
+    return !mCompressing;
+}
+
 void
 GzipFileWork::onReset()
 {
+    RunCommandWork::onReset();
     std::string filenameGz = mFilenameNoGz + ".gz";
     std::remove(filenameGz.c_str());
+    mCancel = std::make_shared<std::atomic<bool>>(false);
+    mCompressing = false;
+    mDone = false;
+    mFailed = false;
 }
 
 CommandInfo
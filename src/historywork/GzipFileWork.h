@@ -5,22 +5,35 @@
 #pragma once
 
 #include "historywork/RunCommandWork.h"
+#include <atomic>
 
 namespace stellar
 {
 
+// Compresses a file to <file>.gz. Where the build has zlib this happens
+// in-process on a background thread, spreading large files over several
+// threads (see ParallelGzip); otherwise it runs `gzip`.
 class GzipFileWork : public RunCommandWork
 {
     std::string const mFilenameNoGz;
     bool const mKeepExisting;
     CommandInfo getCommand() override;
 
+    std::shared_ptr<std::atomic<bool>> mCancel;
+    bool mCompressing{false};
+    bool mDone{false};
+    bool mFailed{false};
+
+    void spawnCompress();
+
   public:
     GzipFileWork(Application& app, std::string const& filenameNoGz,
                  bool keepExisting = false);
     ~GzipFileWork() = default;
 
   protected:
+    State onRun() override;
+    bool onAbort() override;
     void onReset() override;
 };
 }
@@ -8,7 +8,7 @@
 #include "history/StateSnapshot.h"
 #include "main/Application.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -7,8 +7,12 @@
 #include "historywork/GzipFileWork.h"
 #include "historywork/MakeRemoteDirWork.h"
 #include "historywork/PutRemoteFileWork.h"
+#include "main/Application.h"
+#include "util/Fs.h"
+#include "util/Tracing.h"
 #include "work/WorkSequence.h"
-#include <Tracy.hpp>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
 
 namespace stellar
 {
@@ -32,8 +36,11 @@ PutFilesWork::doWork()
     ZoneScoped;
     if (!mChildrenSpawned)
     {
+        mBytes = 0;
+        mStart = std::chrono::steady_clock::now();
         for (auto const& f : mSnapshot->differingHASFiles(mRemoteState))
         {
+            mBytes += fs::size(f->localPath_gz());
             auto mkdir = std::make_shared<MakeRemoteDirWork>(
                 mApp, f->remoteDir(), mArchive);
             auto putFile = std::make_shared<PutRemoteFileWork>(
@@ -59,4 +66,14 @@ PutFilesWork::doReset()
 {
     mChildrenSpawned = false;
 }
+
+void
+PutFilesWork::onSuccess()
+{
+    auto elapsed = std::chrono::steady_clock::now() - mStart;
+    mApp.getMetrics()
+        .NewMeter({"history", "publish", "throughput"}, "bytes")
+        .Mark(mBytes);
+    mArchive->uploadFinished(mBytes, elapsed);
+}
 }
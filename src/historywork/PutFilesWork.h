@@ -8,6 +8,7 @@
 #include "history/HistoryArchive.h"
 #include "history/StateSnapshot.h"
 #include "work/Work.h"
+#include <chrono>
 
 namespace stellar
 {
@@ -18,6 +19,10 @@ class PutFilesWork : public Work
     HistoryArchiveState const& mRemoteState;
 
     bool mChildrenSpawned{false};
+    // Total size of the files uploaded and when uploads started, to report
+    // the archive's upload throughput
+    size_t mBytes{0};
+    std::chrono::steady_clock::time_point mStart;
 
   public:
     PutFilesWork(Application& app, std::shared_ptr<HistoryArchive> archive,
@@ -28,5 +33,6 @@ class PutFilesWork : public Work
   protected:
     void doReset() override;
     State doWork() override;
+    void onSuccess() override;
 };
 }
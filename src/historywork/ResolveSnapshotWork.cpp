@@ -7,7 +7,7 @@
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
 #include "util/GlobalChecks.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
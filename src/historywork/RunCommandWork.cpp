@@ -5,7 +5,7 @@
 #include "historywork/RunCommandWork.h"
 #include "main/Application.h"
 #include "process/ProcessManager.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
@@ -46,7 +46,7 @@ RunCommandWork::onRun()
                 {
                     self->mEc = ec;
                     self->mDone = true;
-                    self->wakeUp();
+                    self->wakeUpAndRun();
                 }
             });
             return State::WORK_WAITING;
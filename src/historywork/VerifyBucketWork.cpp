@@ -4,128 +4,81 @@
 
 #include "historywork/VerifyBucketWork.h"
 #include "crypto/Hex.h"
-#include "crypto/SHA.h"
+#include "crypto/PipelinedSHA256.h"
 #include "main/Application.h"
 #include "main/ErrorMessages.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
 #include <fmt/format.h>
 
-#include <Tracy.hpp>
-#include <medida/meter.h>
+#include "util/Tracing.h"
 #include <medida/metrics_registry.h>
+#include <medida/timer.h>
 
 #include <fstream>
+#include <vector>
 
 namespace stellar
 {
 
+static size_t const VERIFY_READ_CHUNK_SIZE = 256 * 1024;
+static size_t const VERIFY_HASH_BATCH_SIZE = 1024 * 1024;
+
 VerifyBucketWork::VerifyBucketWork(Application& app,
                                    std::string const& bucketFile,
                                    uint256 const& hash,
                                    OnFailureCallback failureCb)
-    : BasicWork(app, "verify-bucket-hash-" + bucketFile, BasicWork::RETRY_NEVER)
+    : BackgroundWork(app, "verify-bucket-hash-" + bucketFile,
+                     BasicWork::RETRY_NEVER)
     , mBucketFile(bucketFile)
     , mHash(hash)
+    , mVerifyTime(
+          app.getMetrics().NewTimer({"history", "verify-bucket", "time"}))
     , mOnFailure(failureCb)
 {
 }
 
 BasicWork::State
-VerifyBucketWork::onRun()
+VerifyBucketWork::runInBackground()
 {
     ZoneScoped;
-    if (mDone)
+    CLOG_INFO(History, "Verifying bucket {}", binToHex(mHash));
+    auto timer = mVerifyTime.TimeScope();
+
+    std::ifstream in(mBucketFile, std::ifstream::binary);
+    if (!in)
     {
-        if (mEc)
-        {
-            return State::WORK_FAILURE;
-        }
-        return State::WORK_SUCCESS;
+        CLOG_WARNING(History, "Failed verification : Error opening file {}",
+                     mBucketFile);
+        return State::WORK_FAILURE;
     }
+    in.exceptions(std::ios::badbit);
 
-    spawnVerifier();
-    return State::WORK_WAITING;
-}
-
-void
-VerifyBucketWork::spawnVerifier()
-{
-    std::string filename = mBucketFile;
-    uint256 hash = mHash;
-    Application& app = this->mApp;
-    std::weak_ptr<VerifyBucketWork> weak(
-        std::static_pointer_cast<VerifyBucketWork>(shared_from_this()));
-    app.postOnBackgroundThread(
-        [&app, filename, weak, hash]() {
-            SHA256 hasher;
-            asio::error_code ec;
-
-            // No point in verifying buckets if things are shutting down
-            auto self = weak.lock();
-            if (!self || self->isAborting())
-            {
-                return;
-            }
-
-            try
-            {
-                ZoneNamedN(verifyZone, "bucket verify", true);
-                CLOG_INFO(History, "Verifying bucket {}", binToHex(hash));
-
-                // ensure that the stream gets its own scope to avoid race with
-                // main thread
-                std::ifstream in(filename, std::ifstream::binary);
-                if (!in)
-                {
-                    throw std::runtime_error(fmt::format(
-                        FMT_STRING("Error opening file {}"), filename));
-                }
-                in.exceptions(std::ios::badbit);
-                char buf[4096];
-                while (in)
-                {
-                    in.read(buf, sizeof(buf));
-                    hasher.add(ByteSlice(buf, in.gcount()));
-                }
-                uint256 vHash = hasher.finish();
-                if (vHash == hash)
-                {
-                    CLOG_DEBUG(History, "Verified hash ({}) for {}",
-                               hexAbbrev(hash), filename);
-                }
-                else
-                {
-                    CLOG_WARNING(History, "FAILED verifying hash for {}",
-                                 filename);
-                    CLOG_WARNING(History, "expected hash: {}", binToHex(hash));
-                    CLOG_WARNING(History, "computed hash: {}", binToHex(vHash));
-                    CLOG_WARNING(History, "{}", POSSIBLY_CORRUPTED_HISTORY);
-                    ec = std::make_error_code(std::errc::io_error);
-                }
-            }
-            catch (std::exception const& e)
-            {
-                CLOG_WARNING(History, "Failed verification : {}", e.what());
-                ec = std::make_error_code(std::errc::io_error);
-            }
-
-            // Not ideal, but needed to prevent race conditions with
-            // main thread, since BasicWork's state is not thread-safe. This is
-            // a temporary workaround, as a cleaner solution is needed.
-            app.postOnMainThread(
-                [weak, ec]() {
-                    auto self = weak.lock();
-                    if (self)
-                    {
-                        self->mEc = ec;
-                        self->mDone = true;
-                        self->wakeUp();
-                    }
-                },
-                "VerifyBucket: finish");
-        },
-        "VerifyBucket: start in background");
+    // Batches are hashed by jobs on the worker threads, so reading the next
+    // chunk of the file overlaps with hashing the previous ones.
+    PipelinedSHA256 hasher(VERIFY_HASH_BATCH_SIZE,
+                           [&app = mApp](std::function<void()>&& f) {
+                               app.postOnBackgroundThread(
+                                   std::move(f), "VerifyBucketWork: hashing");
+                           });
+    std::vector<char> buf(VERIFY_READ_CHUNK_SIZE);
+    while (in)
+    {
+        in.read(buf.data(), buf.size());
+        hasher.add(ByteSlice(buf.data(), in.gcount()));
+    }
+    uint256 vHash = hasher.finish();
+    if (vHash != mHash)
+    {
+        CLOG_WARNING(History, "FAILED verifying hash for {}", mBucketFile);
+        CLOG_WARNING(History, "expected hash: {}", binToHex(mHash));
+        CLOG_WARNING(History, "computed hash: {}", binToHex(vHash));
+        CLOG_WARNING(History, "{}", POSSIBLY_CORRUPTED_HISTORY);
+        return State::WORK_FAILURE;
+    }
+    CLOG_DEBUG(History, "Verified hash ({}) for {}", hexAbbrev(mHash),
+               mBucketFile);
+    return State::WORK_SUCCESS;
 }
 
 void
@@ -4,12 +4,13 @@
 
 #pragma once
 
+#include "work/BackgroundWork.h"
 #include "work/Work.h"
 #include "xdr/Stellar-types.h"
 
 namespace medida
 {
-class Meter;
+class Timer;
 }
 
 namespace stellar
@@ -17,14 +18,11 @@ namespace stellar
 
 class Bucket;
 
-class VerifyBucketWork : public BasicWork
+class VerifyBucketWork : public BackgroundWork
 {
     std::string mBucketFile;
     uint256 mHash;
-    bool mDone{false};
-    std::error_code mEc;
-
-    void spawnVerifier();
+    medida::Timer& mVerifyTime;
 
     OnFailureCallback mOnFailure;
 
@@ -34,12 +32,7 @@ class VerifyBucketWork : public BasicWork
     ~VerifyBucketWork() = default;
 
   protected:
-    BasicWork::State onRun() override;
-    bool
-    onAbort() override
-    {
-        return true;
-    };
+    State runInBackground() override;
     void onFailureRaise() override;
 };
 }
@@ -9,7 +9,7 @@
 #include "util/FileSystemException.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -18,8 +18,8 @@ namespace stellar
 VerifyTxResultsWork::VerifyTxResultsWork(Application& app,
                                          TmpDir const& downloadDir,
                                          uint32_t checkpoint)
-    : BasicWork(app, "verify-results-" + std::to_string(checkpoint),
-                RETRY_NEVER)
+    : BackgroundWork(app, "verify-results-" + std::to_string(checkpoint),
+                     RETRY_NEVER)
     , mDownloadDir(downloadDir)
     , mCheckpoint(checkpoint)
 {
@@ -28,59 +28,24 @@ VerifyTxResultsWork::VerifyTxResultsWork(Application& app,
 void
 VerifyTxResultsWork::onReset()
 {
+    BackgroundWork::onReset();
     mHdrIn.close();
     mResIn.close();
     mTxResultEntry = {};
-    mDone = false;
-    mEc = asio::error_code();
     mLastSeenLedger = 0;
 }
 
 BasicWork::State
-VerifyTxResultsWork::onRun()
+VerifyTxResultsWork::runInBackground()
 {
-    if (mDone)
-    {
-        return mEc ? State::WORK_FAILURE : State::WORK_SUCCESS;
-    }
-
-    std::weak_ptr<VerifyTxResultsWork> weak(
-        std::static_pointer_cast<VerifyTxResultsWork>(shared_from_this()));
-    auto verify = [weak, checkpoint = mCheckpoint]() {
-        auto self = weak.lock();
-        if (self && !self->isAborting())
-        {
-            ZoneScoped;
-            asio::error_code ec;
-            auto verified = self->verifyTxResultsOfCheckpoint();
-            CLOG_TRACE(History,
-                       "Transaction results verification for checkpoint {}{}",
-                       checkpoint,
-                       (verified ? " successful"
-                                 : (" failed: " +
-                                    std::string(POSSIBLY_CORRUPTED_HISTORY))));
-            if (!verified)
-            {
-                ec = std::make_error_code(std::errc::io_error);
-            }
-
-            // Wake up call is posted back on the main thread
-            self->mApp.postOnMainThread(
-                [weak, ec]() {
-                    auto self = weak.lock();
-                    if (self)
-                    {
-                        self->mEc = ec;
-                        self->mDone = true;
-                        self->wakeUp();
-                    }
-                },
-                "VerifyTxResults: finish");
-        }
-    };
-
-    mApp.postOnBackgroundThread(verify, "VerifyTxResults: start in background");
-    return State::WORK_WAITING;
+    ZoneScoped;
+    auto verified = verifyTxResultsOfCheckpoint();
+    CLOG_TRACE(History, "Transaction results verification for checkpoint {}{}",
+               mCheckpoint,
+               (verified ? " successful"
+                         : (" failed: " +
+                            std::string(POSSIBLY_CORRUPTED_HISTORY))));
+    return verified ? State::WORK_SUCCESS : State::WORK_FAILURE;
 }
 
 bool
@@ -101,8 +66,7 @@ VerifyTxResultsWork::verifyTxResultsOfCheckpoint()
         {
             auto ledgerSeq = curr.header.ledgerSeq;
             auto txResultEntry = getCurrentTxResultSet(ledgerSeq);
-            auto resultSetHash =
-                sha256(xdr::xdr_to_opaque(txResultEntry.txResultSet));
+            auto resultSetHash = xdrSha256(txResultEntry.txResultSet);
             auto genesis = ledgerSeq == LedgerManager::GENESIS_LEDGER_SEQ &&
                            txResultEntry.txResultSet.results.empty();
 
@@ -6,7 +6,7 @@
 
 #include "util/TmpDir.h"
 #include "util/XDRStream.h"
-#include "work/BasicWork.h"
+#include "work/BackgroundWork.h"
 #include "xdr/Stellar-types.h"
 
 namespace stellar
@@ -15,15 +15,13 @@ namespace stellar
  * Verify transaction results for a checkpoint. This work requires
  * downloaded ledger header and transaction result files.
  * */
-class VerifyTxResultsWork : public BasicWork
+class VerifyTxResultsWork : public BackgroundWork
 {
     TmpDir const& mDownloadDir;
     uint32_t const mCheckpoint;
     TransactionHistoryResultEntry mTxResultEntry;
     XDRInputFileStream mHdrIn;
     XDRInputFileStream mResIn;
-    bool mDone{false};
-    asio::error_code mEc;
     uint32_t mLastSeenLedger;
 
     TransactionHistoryResultEntry getCurrentTxResultSet(uint32_t ledger);
@@ -34,13 +32,7 @@ class VerifyTxResultsWork : public BasicWork
                         uint32_t checkpoint);
 
   protected:
-    BasicWork::State onRun() override;
+    State runInBackground() override;
     void onReset() override;
-
-    bool
-    onAbort() override
-    {
-        return true;
-    };
 };
 }
@@ -4,18 +4,16 @@
 
 #pragma once
 
-#include "work/Work.h"
+#include "work/BackgroundWork.h"
 
 namespace stellar
 {
 
 struct StateSnapshot;
 
-class WriteSnapshotWork : public BasicWork
+class WriteSnapshotWork : public BackgroundWork
 {
     std::shared_ptr<StateSnapshot> mSnapshot;
-    bool mDone{false};
-    bool mSuccess{true};
 
   public:
     WriteSnapshotWork(Application& app,
@@ -23,11 +21,7 @@ class WriteSnapshotWork : public BasicWork
     ~WriteSnapshotWork() = default;
 
   protected:
-    State onRun() override;
-    bool
-    onAbort() override
-    {
-        return true;
-    };
+    State runInBackground() override;
+    bool canRunInBackground() const override;
 };
 }
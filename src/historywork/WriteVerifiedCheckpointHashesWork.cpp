@@ -11,9 +11,10 @@
 #include "main/Application.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "work/ConditionalWork.h"
-#include <Tracy.hpp>
 #include <algorithm>
+#include <cstdio>
 #include <fmt/format.h>
 
 namespace stellar
@@ -22,6 +23,15 @@ namespace stellar
 Hash
 WriteVerifiedCheckpointHashesWork::loadHashFromJsonOutput(
     uint32_t seq, std::string const& filename)
+{
+    auto hashes = loadHashesFromJsonOutput(filename);
+    auto it = hashes.find(seq);
+    return it == hashes.end() ? Hash{} : it->second;
+}
+
+std::map<uint32_t, Hash>
+WriteVerifiedCheckpointHashesWork::loadHashesFromJsonOutput(
+    std::string const& filename)
 {
     std::ifstream in(filename);
     if (!in)
@@ -38,6 +48,7 @@ WriteVerifiedCheckpointHashesWork::loadHashFromJsonOutput(
     {
         throw std::runtime_error("expected top-level array in " + filename);
     }
+    std::map<uint32_t, Hash> hashes;
     for (auto const& jpair : root)
     {
         if (!jpair.isArray() || (jpair.size() != 2))
@@ -45,17 +56,20 @@ WriteVerifiedCheckpointHashesWork::loadHashFromJsonOutput(
             throw std::runtime_error("expecting 2-element sub-array in " +
                                      filename);
         }
-        if (jpair[0].asUInt() == seq)
+        // Skip the [0, ""] entry ending the array
+        if (jpair[0].asUInt() != 0)
         {
-            return hexToBin256(jpair[1].asString());
+            hashes.emplace(jpair[0].asUInt(),
+                           hexToBin256(jpair[1].asString()));
         }
     }
-    return Hash{};
+    return hashes;
 }
 
 WriteVerifiedCheckpointHashesWork::WriteVerifiedCheckpointHashesWork(
     Application& app, LedgerNumHashPair rangeEnd, std::string const& outputFile,
-    uint32_t nestedBatchSize, std::shared_ptr<HistoryArchive> archive)
+    uint32_t nestedBatchSize, std::shared_ptr<HistoryArchive> archive,
+    std::optional<std::string> const& trustedHashFile)
     : BatchWork(app, "write-verified-checkpoint-hashes")
     , mNestedBatchSize(nestedBatchSize)
     , mRangeEnd(rangeEnd)
@@ -64,24 +78,59 @@ WriteVerifiedCheckpointHashesWork::WriteVerifiedCheckpointHashesWork(
     , mCurrCheckpoint(rangeEnd.first)
     , mArchive(archive)
     , mOutputFileName(outputFile)
+    , mTmpOutputFileName(outputFile + ".tmp")
 {
     mRangeEndPromise.set_value(mRangeEnd);
     if (mArchive)
     {
         CLOG_INFO(History, "selected archive {}", mArchive->getName());
     }
+    if (trustedHashFile)
+    {
+        mTrustedHashes = loadHashesFromJsonOutput(*trustedHashFile);
+        if (mTrustedHashes.empty())
+        {
+            throw std::runtime_error("no hashes in " + *trustedHashFile);
+        }
+        auto const& newest = *mTrustedHashes.rbegin();
+        if (!mApp.getHistoryManager().isLastLedgerInCheckpoint(newest.first))
+        {
+            throw std::runtime_error(
+                fmt::format(FMT_STRING("{} ends at ledger {}, which does not "
+                                       "end a checkpoint"),
+                            *trustedHashFile, newest.first));
+        }
+        if (newest.first >= mRangeEnd.first)
+        {
+            throw std::runtime_error(fmt::format(
+                FMT_STRING("{} already goes up to ledger {}, nothing to verify "
+                           "up to {}"),
+                *trustedHashFile, newest.first, mRangeEnd.first));
+        }
+        mExtendedFrom = LedgerNumHashPair(newest.first, newest.second);
+        CLOG_INFO(History, "Extending {} hashes up to ledger {} from {}",
+                  mTrustedHashes.size(), newest.first, *trustedHashFile);
+    }
     startOutputFile();
 }
 
 WriteVerifiedCheckpointHashesWork::~WriteVerifiedCheckpointHashesWork()
 {
     endOutputFile();
+    std::remove(mTmpOutputFileName.c_str());
+}
+
+uint32_t
+WriteVerifiedCheckpointHashesWork::getStopLedger() const
+{
+    return mExtendedFrom ? mExtendedFrom->first
+                         : LedgerManager::GENESIS_LEDGER_SEQ;
 }
 
 bool
 WriteVerifiedCheckpointHashesWork::hasNext() const
 {
-    return mCurrCheckpoint != LedgerManager::GENESIS_LEDGER_SEQ;
+    return mCurrCheckpoint != getStopLedger();
 }
 
 std::shared_ptr<BasicWork>
@@ -96,14 +145,23 @@ WriteVerifiedCheckpointHashesWork::yieldMoreWork()
     auto const& hm = mApp.getHistoryManager();
     uint32_t const freq = hm.getCheckpointFrequency();
 
+    // When extending a file, verifying the ledger after the newest hash in it
+    // against that hash links the new hashes to it, the same way as ledgers
+    // after the LCL are linked to it
     auto const lclHe = mApp.getLedgerManager().getLastClosedLedgerHeader();
-    LedgerNumHashPair const lcl(lclHe.header.ledgerSeq,
-                                std::make_optional<Hash>(lclHe.hash));
+    LedgerNumHashPair const lcl =
+        mExtendedFrom ? *mExtendedFrom
+                      : LedgerNumHashPair(lclHe.header.ledgerSeq,
+                                          std::make_optional<Hash>(lclHe.hash));
     uint32_t const span = mNestedBatchSize * freq;
     uint32_t const last = mCurrCheckpoint;
-    uint32_t const first =
+    uint32_t first =
         last <= span ? LedgerManager::GENESIS_LEDGER_SEQ
                      : hm.firstLedgerInCheckpointContaining(last - span);
+    if (mExtendedFrom)
+    {
+        first = std::max(first, mExtendedFrom->first + 1);
+    }
 
     LedgerRange const ledgerRange = LedgerRange::inclusive(first, last);
     CheckpointRange const checkpointRange(ledgerRange, hm);
@@ -158,7 +216,7 @@ WriteVerifiedCheckpointHashesWork::yieldMoreWork()
 
     mTmpDirs.emplace_back(workSeq, tmpDir);
     releaseAssert(first >= 1);
-    mCurrCheckpoint = std::max(LedgerManager::GENESIS_LEDGER_SEQ, first - 1);
+    mCurrCheckpoint = std::max(getStopLedger(), first - 1);
     mPrevVerifyWork = currWork;
     return workSeq;
 }
@@ -168,11 +226,11 @@ WriteVerifiedCheckpointHashesWork::startOutputFile()
 {
     releaseAssert(!mOutputFile);
     auto mode = std::ios::out | std::ios::trunc;
-    mOutputFile = std::make_shared<std::ofstream>(mOutputFileName, mode);
+    mOutputFile = std::make_shared<std::ofstream>(mTmpOutputFileName, mode);
     if (!*mOutputFile)
     {
         throw std::runtime_error("error opening output file " +
-                                 mOutputFileName);
+                                 mTmpOutputFileName);
     }
     (*mOutputFile) << "[";
 }
@@ -182,6 +240,14 @@ WriteVerifiedCheckpointHashesWork::endOutputFile()
 {
     if (mOutputFile && mOutputFile->is_open())
     {
+        // Hashes of the file being extended are all older than the verified
+        // ones, so they go last to keep the file in descending ledger order
+        for (auto it = mTrustedHashes.rbegin(); it != mTrustedHashes.rend();
+             ++it)
+        {
+            (*mOutputFile) << "\n[" << it->first << ", \""
+                           << binToHex(it->second) << "\"],";
+        }
         // Each line of output made by a VerifyLedgerChainWork has a trailing
         // comma, and trailing commas are not a valid end of a JSON array; so we
         // terminate the array here with an entry that does _not_ have a
@@ -205,5 +271,10 @@ void
 WriteVerifiedCheckpointHashesWork::onSuccess()
 {
     endOutputFile();
+    if (std::rename(mTmpOutputFileName.c_str(), mOutputFileName.c_str()) != 0)
+    {
+        throw std::runtime_error("error renaming output file to " +
+                                 mOutputFileName);
+    }
 }
 }
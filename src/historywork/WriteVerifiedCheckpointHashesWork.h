@@ -8,6 +8,8 @@
 #include "work/BatchWork.h"
 #include <future>
 #include <iosfwd>
+#include <map>
+#include <optional>
 
 namespace stellar
 {
@@ -25,29 +27,36 @@ class WriteVerifiedCheckpointHashesWork : public BatchWork
     void resetIter() override;
 
   public:
+    // This class is a batch work, but it also creates a conditional dependency
+    // chain among its batch elements (for trusted ledger propagation): this
+    // dependency chain can in turn cause the BatchWork logic to stall, failing
+    // to saturate the parallel subprocess-execution system. So to keep the
+    // latter busy we introduce an inner level of fully-parallelizable batching
+    // of downloads. Empirically this seems to work well at a fixed size.
+    static constexpr uint32_t NESTED_DOWNLOAD_BATCH_SIZE = 64;
+
     WriteVerifiedCheckpointHashesWork(
         Application& app, LedgerNumHashPair rangeEnd,
         std::string const& outputFile,
         uint32_t nestedBatchSize = NESTED_DOWNLOAD_BATCH_SIZE,
-        std::shared_ptr<HistoryArchive> archive = nullptr);
+        std::shared_ptr<HistoryArchive> archive = nullptr,
+        std::optional<std::string> const& trustedHashFile = std::nullopt);
     ~WriteVerifiedCheckpointHashesWork();
 
     // Helper to load a hash back from a file produced by this class.
     static Hash loadHashFromJsonOutput(uint32_t seq,
                                        std::string const& filename);
 
+    // Helper to load all the hashes of a file produced by this class, by
+    // ledger number.
+    static std::map<uint32_t, Hash>
+    loadHashesFromJsonOutput(std::string const& filename);
+
     void onSuccess() override;
 
   private:
-    // This class is a batch work, but it also creates a conditional dependency
-    // chain among its batch elements (for trusted ledger propagation): this
-    // dependency chain can in turn cause the BatchWork logic to stall, failing
-    // to saturate the parallel subprocess-execution system. So to keep the
-    // latter busy we introduce an inner level of fully-parallelizable batching
-    // of downloads. Empirically this seems to work well at a fixed size.
-    static constexpr uint32_t NESTED_DOWNLOAD_BATCH_SIZE = 64;
-
-    // For testing purposes we'd like to be able to change this, however.
+    // For testing purposes we'd like to be able to change
+    // NESTED_DOWNLOAD_BATCH_SIZE, however.
     uint32_t const mNestedBatchSize;
 
     // We make a TmpDir for each inner WorkSequence we run, but delete them on
@@ -58,18 +67,26 @@ class WriteVerifiedCheckpointHashesWork : public BatchWork
         std::pair<std::shared_ptr<WorkSequence>, std::shared_ptr<TmpDir>>>
         mTmpDirs;
 
-    // Total range to verify is implicitly 1 .. mRangeEnd.first
+    // Total range to verify is implicitly 1 .. mRangeEnd.first, or
+    // mExtendedFrom->first + 1 .. mRangeEnd.first when extending a file
     LedgerNumHashPair const mRangeEnd;
 
+    // Hashes of an earlier run that this one extends, which are written back
+    // out after the newly verified ones, and the newest of them, which the
+    // oldest newly verified ledger must link to
+    std::map<uint32_t, Hash> mTrustedHashes;
+    std::optional<LedgerNumHashPair> mExtendedFrom;
+
     // We form a promise and an associated shared_future that hold a copy
     // of mRangeEnd so that we can provide it to the work that we yield
     // for the first entry in the verification chain.
     std::promise<LedgerNumHashPair> mRangeEndPromise;
     std::shared_future<LedgerNumHashPair> mRangeEndFuture;
 
-    // mCurrCheckpoint == LedgerManager::GENESIS_LEDGER_SEQ if we're done, or
-    // else some checkpoint-boundary ledger >= 63
+    // mCurrCheckpoint == getStopLedger() if we're done, or else some
+    // checkpoint-boundary ledger >= 63
     uint32_t mCurrCheckpoint;
+    uint32_t getStopLedger() const;
 
     std::shared_ptr<VerifyLedgerChainWork> mPrevVerifyWork;
 
@@ -79,5 +96,8 @@ class WriteVerifiedCheckpointHashesWork : public BatchWork
     void endOutputFile();
     std::shared_ptr<std::ofstream> mOutputFile;
     std::string mOutputFileName;
+    // The output is written here and only renamed to mOutputFileName once
+    // complete, so that a file can be extended in place
+    std::string mTmpOutputFileName;
 };
 }
@@ -2,6 +2,8 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/Hex.h"
+#include "crypto/SecretKey.h"
 #include "history/HistoryArchiveManager.h"
 #include "history/test/HistoryTestsUtils.h"
 #include "historywork/CheckSingleLedgerHeaderWork.h"
@@ -11,6 +13,7 @@
 #include "util/Logging.h"
 #include "util/Timer.h"
 #include "work/WorkScheduler.h"
+#include <fstream>
 #include <lib/catch.hpp>
 #include <lib/json/json.h>
 
@@ -49,6 +52,68 @@ TEST_CASE("write verified checkpoint hashes", "[historywork]")
     }
 }
 
+TEST_CASE("extend verified checkpoint hashes", "[historywork]")
+{
+    CatchupSimulation catchupSimulation{};
+    uint32_t nestedBatchSize = 4;
+    auto checkpointLedger =
+        catchupSimulation.getLastCheckpointLedger(5 * nestedBatchSize);
+    catchupSimulation.ensureOnlineCatchupPossible(checkpointLedger,
+                                                  5 * nestedBatchSize);
+
+    std::vector<LedgerNumHashPair> pairs =
+        catchupSimulation.getAllPublishedCheckpoints();
+    REQUIRE(pairs.size() > 3);
+    LedgerNumHashPair middle = pairs[pairs.size() / 2];
+    auto tmpDir = catchupSimulation.getApp().getTmpDirManager().tmpDir(
+        "extend-checkpoint-hashes-test");
+    auto file = tmpDir.getName() + "/verified-ledgers.json";
+    auto& wm = catchupSimulation.getApp().getWorkScheduler();
+    {
+        auto w = wm.executeWork<WriteVerifiedCheckpointHashesWork>(
+            middle, file, nestedBatchSize);
+        REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+    }
+    REQUIRE(WriteVerifiedCheckpointHashesWork::loadHashesFromJsonOutput(file)
+                .rbegin()
+                ->first == middle.first);
+
+    SECTION("extend in place")
+    {
+        auto w = wm.executeWork<WriteVerifiedCheckpointHashesWork>(
+            pairs.back(), file, nestedBatchSize, nullptr,
+            std::make_optional(file));
+        REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+
+        auto hashes =
+            WriteVerifiedCheckpointHashesWork::loadHashesFromJsonOutput(file);
+        REQUIRE(hashes.size() == pairs.size());
+        for (auto const& p : pairs)
+        {
+            REQUIRE(hashes.at(p.first) == *p.second);
+        }
+    }
+
+    SECTION("extending a file that disagrees with the archive fails")
+    {
+        auto badFile = tmpDir.getName() + "/bad-ledgers.json";
+        {
+            std::ofstream out(badFile);
+            out << "[\n[" << middle.first << ", \""
+                << binToHex(HashUtils::random()) << "\"],\n[0, \"\"]\n]\n";
+        }
+        auto w = wm.executeWork<WriteVerifiedCheckpointHashesWork>(
+            pairs.back(), file, nestedBatchSize, nullptr,
+            std::make_optional(badFile));
+        REQUIRE(w->getState() == BasicWork::State::WORK_FAILURE);
+        // The earlier output is left as it was
+        REQUIRE(WriteVerifiedCheckpointHashesWork::loadHashesFromJsonOutput(
+                    file)
+                    .rbegin()
+                    ->first == middle.first);
+    }
+}
+
 TEST_CASE("check single ledger header work", "[historywork]")
 {
     CatchupSimulation catchupSimulation{};
@@ -15,10 +15,9 @@
 #include "ledger/LedgerTxnEntry.h"
 #include "main/Application.h"
 #include "main/PersistentState.h"
-#include "medida/timer.h"
+#include "util/UnorderedSet.h"
 #include "util/XDRCereal.h"
 #include <chrono>
-#include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <map>
 
@@ -180,48 +179,161 @@ struct EntryCounts
     }
 };
 
+// Logs how far checkEntireBucketlist got every so many entries
+class ConsistencyCheckProgress
+{
+    size_t const mTotal;
+    size_t mChecked{0};
+    std::chrono::steady_clock::time_point const mStart{
+        std::chrono::steady_clock::now()};
+
+  public:
+    explicit ConsistencyCheckProgress(size_t total) : mTotal(total)
+    {
+    }
+
+    void
+    advance()
+    {
+        if ((++mChecked & 0x7ffff) != 0 && mChecked != mTotal)
+        {
+            return;
+        }
+        using namespace std::chrono;
+        auto elapsed = duration_cast<duration<double>>(steady_clock::now() -
+                                                       mStart);
+        CLOG_INFO(Ledger,
+                  "Checked bucket-vs-DB consistency for {} of {} entries "
+                  "({:.1f}%, {:.0f} entries/s)",
+                  mChecked, mTotal, 100.0 * mChecked / mTotal,
+                  elapsed.count() > 0 ? mChecked / elapsed.count() : 0.0);
+    }
+};
+
 void
 BucketListIsConsistentWithDatabase::checkEntireBucketlist()
 {
     auto& lm = mApp.getLedgerManager();
     auto& bm = mApp.getBucketManager();
+    auto& ltxRoot = mApp.getLedgerTxnRoot();
     HistoryArchiveState has = lm.getLastClosedLedgerHAS();
     std::map<LedgerKey, LedgerEntry> bucketLedgerMap =
         bm.loadCompleteLedgerState(has);
     EntryCounts counts;
-    medida::Timer timer(std::chrono::microseconds(1));
 
+    // If BucketListDB enabled, only types not supported by BucketListDB
+    // should be in SQL DB, and none with IN_MEMORY_OFFERS
+    std::function<bool(LedgerEntryType)> filter;
+    if (mApp.getConfig().isUsingInMemoryOffers())
     {
-        LedgerTxn ltx(mApp.getLedgerTxnRoot());
-        for (auto const& pair : bucketLedgerMap)
+        filter = [](LedgerEntryType) { return false; };
+    }
+    else if (mApp.getConfig().isUsingBucketListDB())
+    {
+        filter = BucketIndex::typeNotSupported;
+    }
+    else
+    {
+        filter = [](LedgerEntryType) { return true; };
+    }
+
+    // Offers, the only entries left in SQL with BucketListDB, are all read
+    // with a single query and merge-joined against the sorted bucket list
+    // state, instead of being looked up one by one.
+    bool const joinOffers = filter(OFFER) && !mApp.getConfig().isInMemoryMode();
+    std::map<LedgerKey, LedgerEntry> dbOffers;
+    if (joinOffers)
+    {
+        for (auto& kv : ltxRoot.getAllOffers())
         {
-            // Don't check entry types in BucketListDB when enabled
-            if (mApp.getConfig().isUsingBucketListDB() &&
-                !BucketIndex::typeNotSupported(pair.first.type()))
-            {
-                continue;
-            }
+            dbOffers.emplace(kv.first, std::move(kv.second));
+        }
+    }
+    auto dbOffer = dbOffers.begin();
 
-            counts.countLiveEntry(pair.second);
-            std::string s;
-            timer.Time([&]() { s = checkAgainstDatabase(ltx, pair.second); });
+    size_t total = 0;
+    for (auto const& pair : bucketLedgerMap)
+    {
+        total += filter(pair.first.type()) ? 1 : 0;
+    }
+    ConsistencyCheckProgress progress(total);
+
+    // Other entries are prefetched from SQL in batches before being compared
+    std::vector<LedgerEntry const*> batch;
+    auto checkBatch = [&]() {
+        UnorderedSet<LedgerKey> keys;
+        for (auto le : batch)
+        {
+            keys.emplace(LedgerEntryKey(*le));
+        }
+        ltxRoot.prefetch(keys);
+
+        LedgerTxn ltx(ltxRoot);
+        for (auto le : batch)
+        {
+            auto s = checkAgainstDatabase(ltx, *le);
             if (!s.empty())
             {
                 throw std::runtime_error(s);
             }
-            auto i = counts.totalEntries();
-            if ((i & 0x7ffff) == 0)
+            progress.advance();
+        }
+        batch.clear();
+    };
+
+    for (auto const& pair : bucketLedgerMap)
+    {
+        // Don't check entry types in BucketListDB when enabled
+        if (!filter(pair.first.type()))
+        {
+            continue;
+        }
+        counts.countLiveEntry(pair.second);
+
+        if (!joinOffers || pair.first.type() != OFFER)
+        {
+            batch.emplace_back(&pair.second);
+            if (batch.size() >= mApp.getConfig().PREFETCH_BATCH_SIZE)
             {
-                using namespace std::chrono;
-                nanoseconds ns = timer.duration_unit() *
-                                 static_cast<nanoseconds::rep>(timer.mean());
-                microseconds us = duration_cast<microseconds>(ns);
-                CLOG_INFO(Ledger,
-                          "Checked bucket-vs-DB consistency for "
-                          "{} entries (mean {}/entry)",
-                          i, us);
+                checkBatch();
             }
+            continue;
         }
+
+        // Both maps have the same order, so any database offer ordered before
+        // this one is missing from the bucket list
+        if (dbOffer != dbOffers.end() && dbOffer->first < pair.first)
+        {
+            std::string s = "Entry not in BucketList found in database ";
+            s += xdrToCerealString(dbOffer->second, "db");
+            throw std::runtime_error(s);
+        }
+        if (dbOffer == dbOffers.end() || pair.first < dbOffer->first)
+        {
+            std::string s{"Inconsistent state between objects (not found in "
+                          "database): "};
+            s += xdrToCerealString(pair.second, "live");
+            throw std::runtime_error(s);
+        }
+        if (!(dbOffer->second == pair.second))
+        {
+            std::string s{"Inconsistent state between objects: "};
+            s += xdrToCerealString(dbOffer->second, "db");
+            s += xdrToCerealString(pair.second, "live");
+            throw std::runtime_error(s);
+        }
+        ++dbOffer;
+        progress.advance();
+    }
+    if (!batch.empty())
+    {
+        checkBatch();
+    }
+    if (dbOffer != dbOffers.end())
+    {
+        std::string s = "Entry not in BucketList found in database ";
+        s += xdrToCerealString(dbOffer->second, "db");
+        throw std::runtime_error(s);
     }
 
     // Count functionality does not support in-memory LedgerTxn
@@ -229,19 +341,6 @@ BucketListIsConsistentWithDatabase::checkEntireBucketlist()
     {
         auto range = LedgerRange::inclusive(LedgerManager::GENESIS_LEDGER_SEQ,
                                             has.currentLedger);
-
-        // If BucketListDB enabled, only types not supported by BucketListDB
-        // should be in SQL DB
-        std::function<bool(LedgerEntryType)> filter;
-        if (mApp.getConfig().isUsingBucketListDB())
-        {
-            filter = BucketIndex::typeNotSupported;
-        }
-        else
-        {
-            filter = [](LedgerEntryType) { return true; };
-        }
-
         auto s = counts.checkDbEntryCounts(mApp, range, filter);
         if (!s.empty())
         {
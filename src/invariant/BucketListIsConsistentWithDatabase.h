@@ -40,6 +40,8 @@ class BucketListIsConsistentWithDatabase : public Invariant
 
     // Secondary entrypoint to database-vs-bucket consistency checking, designed
     // to be run offline via self-check. Throws an exception on any error.
+    // Offers are read in one query and merge-joined against the bucket list
+    // state; other SQL entries are prefetched in PREFETCH_BATCH_SIZE batches.
     void checkEntireBucketlist();
 
   private:
@@ -6,6 +6,7 @@
 
 #include "herder/TxSetFrame.h"
 #include "lib/json/json.h"
+#include <chrono>
 #include <memory>
 
 namespace stellar
@@ -44,10 +45,32 @@ class InvariantManager
                                        OperationResult const& opres,
                                        LedgerTxnDelta const& ltxDelta) = 0;
 
+    // From then on, checkOnOperationApply only copies the operation and its
+    // delta, which are checked in order on a worker thread. Failures are
+    // reported on the main thread once found; they only halt the node if
+    // haltOnFailure is set and the invariant is strict.
+    virtual void enableAsyncOperationChecks(Application& app,
+                                            bool haltOnFailure) = 0;
+
+    // Blocks until every operation queued for an asynchronous check has been
+    // checked. Failures found are still reported through the main thread.
+    virtual void waitForAsyncOperationChecks() = 0;
+
+    // Total time checkOnOperationApply took on the thread applying
+    // operations, including copying the operations checked asynchronously
+    virtual std::chrono::nanoseconds getOperationCheckTime() const = 0;
+
     virtual void registerInvariant(std::shared_ptr<Invariant> invariant) = 0;
 
     virtual void enableInvariant(std::string const& name) = 0;
 
+    // Has the enabled invariant `name` check the operations of only one
+    // ledger in every ledgerInterval, and skip its checks for the rest of a
+    // ledger once they took ledgerBudget in it (no limit if zero).
+    virtual void
+    setOperationSampling(std::string const& name, uint32_t ledgerInterval,
+                         std::chrono::milliseconds ledgerBudget) = 0;
+
 #ifdef BUILD_TESTS
     virtual void snapshotForFuzzer() = 0;
     virtual void resetForFuzzer() = 0;
@@ -12,13 +12,18 @@
 #include "ledger/LedgerTxn.h"
 #include "main/Application.h"
 #include "main/ErrorMessages.h"
+#include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/XDRCereal.h"
+#include <fmt/chrono.h>
 #include <fmt/format.h>
 
 #include "medida/counter.h"
+#include "medida/meter.h"
 #include "medida/metrics_registry.h"
+#include "medida/timer.h"
 
 #include <memory>
 #include <numeric>
@@ -34,8 +39,13 @@ InvariantManager::create(Application& app)
 }
 
 InvariantManagerImpl::InvariantManagerImpl(medida::MetricsRegistry& registry)
-    : mInvariantFailureCount(
+    : mMetrics(registry)
+    , mInvariantFailureCount(
           registry.NewCounter({"ledger", "invariant", "failure"}))
+    , mAsyncBacklog(
+          registry.NewCounter({"ledger", "invariant", "async-backlog"}))
+    , mAsyncStall(registry.NewMeter({"ledger", "invariant", "async-stall"},
+                                    "operation"))
 {
 }
 
@@ -98,6 +108,53 @@ InvariantManagerImpl::checkOnBucketApply(
     }
 }
 
+std::vector<std::pair<std::shared_ptr<Invariant>, std::string>>
+InvariantManagerImpl::checkOperation(Operation const& operation,
+                                     OperationResult const& opres,
+                                     LedgerTxnDelta const& ltxDelta)
+{
+    std::vector<std::pair<std::shared_ptr<Invariant>, std::string>> failures;
+    auto ledgerSeq = ltxDelta.header.current.ledgerSeq;
+    for (size_t i = 0; i < mEnabled.size(); ++i)
+    {
+        auto const& invariant = mEnabled[i];
+        auto& sampling = mOperationSampling[i];
+        if (sampling.mLedger != ledgerSeq)
+        {
+            sampling.mLedger = ledgerSeq;
+            sampling.mSpentInLedger = std::chrono::nanoseconds::zero();
+        }
+        // Offset by i so that invariants sampled at the same interval do not
+        // all check the same ledgers
+        if ((ledgerSeq + i) % sampling.mLedgerInterval != 0 ||
+            (sampling.mLedgerBudget.count() != 0 &&
+             sampling.mSpentInLedger >= sampling.mLedgerBudget))
+        {
+            sampling.mSkipped.Mark();
+            continue;
+        }
+        sampling.mSampled.Mark();
+
+        auto start = std::chrono::steady_clock::now();
+        auto result =
+            invariant->checkOnOperationApply(operation, opres, ltxDelta);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        sampling.mSpentInLedger += elapsed;
+        sampling.mTime.Update(elapsed);
+        if (result.empty())
+        {
+            continue;
+        }
+
+        auto message = fmt::format(
+            FMT_STRING(R"(Invariant "{}" does not hold on operation: {}{}{})"),
+            invariant->getName(), result, "\n",
+            xdrToCerealString(operation, "Operation"));
+        failures.emplace_back(invariant, std::move(message));
+    }
+    return failures;
+}
+
 void
 InvariantManagerImpl::checkOnOperationApply(Operation const& operation,
                                             OperationResult const& opres,
@@ -109,22 +166,137 @@ InvariantManagerImpl::checkOnOperationApply(Operation const& operation,
         return;
     }
 
-    for (auto invariant : mEnabled)
+    auto start = std::chrono::steady_clock::now();
+    checkOrQueueOperation(operation, opres, ltxDelta);
+    mOperationCheckTime += std::chrono::steady_clock::now() - start;
+}
+
+std::chrono::nanoseconds
+InvariantManagerImpl::getOperationCheckTime() const
+{
+    return mOperationCheckTime;
+}
+
+void
+InvariantManagerImpl::checkOrQueueOperation(Operation const& operation,
+                                            OperationResult const& opres,
+                                            LedgerTxnDelta const& ltxDelta)
+{
+    if (!mAsyncApp)
     {
-        auto result =
-            invariant->checkOnOperationApply(operation, opres, ltxDelta);
-        if (result.empty())
+        for (auto const& [invariant, message] :
+             checkOperation(operation, opres, ltxDelta))
         {
-            continue;
+            onInvariantFailure(invariant, message,
+                               ltxDelta.header.current.ledgerSeq);
         }
+        return;
+    }
 
-        auto message = fmt::format(
-            FMT_STRING(R"(Invariant "{}" does not hold on operation: {}{}{})"),
-            invariant->getName(), result, "\n",
-            xdrToCerealString(operation, "Operation"));
-        onInvariantFailure(invariant, message,
-                           ltxDelta.header.current.ledgerSeq);
+    ZoneScoped;
+    PendingOperationCheck check{operation, opres, {}};
+    check.mDelta.header = ltxDelta.header;
+    check.mDelta.entry.reserve(ltxDelta.entry.size());
+    for (auto const& [key, delta] : ltxDelta.entry)
+    {
+        auto& copy = check.mDelta.entry[key];
+        if (delta.current)
+        {
+            copy.current =
+                std::make_shared<InternalLedgerEntry const>(*delta.current);
+        }
+        if (delta.previous)
+        {
+            copy.previous =
+                std::make_shared<InternalLedgerEntry const>(*delta.previous);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mAsyncMutex);
+    if (mAsyncQueue.size() >= MAX_ASYNC_QUEUED_OPERATIONS)
+    {
+        mAsyncStall.Mark();
+        mAsyncCond.wait(lock, [this]() {
+            return mAsyncQueue.size() < MAX_ASYNC_QUEUED_OPERATIONS;
+        });
+    }
+    mAsyncQueue.emplace_back(std::move(check));
+    mAsyncBacklog.set_count(mAsyncQueue.size());
+    if (!mAsyncJobRunning)
+    {
+        mAsyncJobRunning = true;
+        mAsyncApp->postOnBackgroundThread(
+            [this]() { drainAsyncOperationChecks(); }, "invariant checks");
+    }
+}
+
+void
+InvariantManagerImpl::enableAsyncOperationChecks(Application& app,
+                                                 bool haltOnFailure)
+{
+    releaseAssert(threadIsMain());
+    mAsyncApp = &app;
+    mHaltOnAsyncFailure = haltOnFailure;
+    CLOG_INFO(Invariant, "Checking operation invariants asynchronously");
+}
+
+void
+InvariantManagerImpl::drainAsyncOperationChecks()
+{
+    ZoneScoped;
+    std::unique_lock<std::mutex> lock(mAsyncMutex);
+    while (!mAsyncQueue.empty())
+    {
+        auto check = std::move(mAsyncQueue.front());
+        mAsyncQueue.pop_front();
+        mAsyncBacklog.set_count(mAsyncQueue.size());
+        lock.unlock();
+        mAsyncCond.notify_all();
+
+        auto failures =
+            checkOperation(check.mOperation, check.mResult, check.mDelta);
+        auto ledger = check.mDelta.header.current.ledgerSeq;
+        for (auto& [invariant, message] : failures)
+        {
+            std::weak_ptr<bool> alive = mAliveToken;
+            mAsyncApp->postOnMainThread(
+                [this, alive, invariant = invariant,
+                 message = std::move(message), ledger]() {
+                    if (alive.lock())
+                    {
+                        onAsyncInvariantFailure(invariant, message, ledger);
+                    }
+                },
+                "invariant failure");
+        }
+        lock.lock();
     }
+    mAsyncJobRunning = false;
+    mAsyncCond.notify_all();
+}
+
+void
+InvariantManagerImpl::waitForAsyncOperationChecks()
+{
+    std::unique_lock<std::mutex> lock(mAsyncMutex);
+    mAsyncCond.wait(lock, [this]() { return !mAsyncJobRunning; });
+}
+
+void
+InvariantManagerImpl::onAsyncInvariantFailure(
+    std::shared_ptr<Invariant> invariant, std::string const& message,
+    uint32_t ledger)
+{
+    if (mHaltOnAsyncFailure)
+    {
+        onInvariantFailure(invariant, message, ledger);
+        return;
+    }
+    // Already applied and possibly externalized: only report it
+    mInvariantFailureCount.inc();
+    mFailureInformation[invariant->getName()] = {ledger, message};
+    CLOG_ERROR(Invariant, "{}", message);
+    CLOG_ERROR(Invariant, "{}", REPORT_INTERNAL_BUG);
 }
 
 void
@@ -174,6 +346,14 @@ InvariantManagerImpl::enableInvariant(std::string const& invPattern)
             {
                 enabledSome = true;
                 mEnabled.push_back(inv.second);
+                mOperationSampling.push_back(
+                    {1, std::chrono::nanoseconds::zero(), 0,
+                     std::chrono::nanoseconds::zero(),
+                     mMetrics.NewTimer({"invariant", name, "time"}),
+                     mMetrics.NewMeter({"invariant", name, "sampled"},
+                                       "operation"),
+                     mMetrics.NewMeter({"invariant", name, "skipped"},
+                                       "operation")});
                 CLOG_INFO(Invariant, "Enabled invariant '{}'", name);
             }
             else
@@ -207,6 +387,33 @@ InvariantManagerImpl::enableInvariant(std::string const& invPattern)
     }
 }
 
+void
+InvariantManagerImpl::setOperationSampling(
+    std::string const& name, uint32_t ledgerInterval,
+    std::chrono::milliseconds ledgerBudget)
+{
+    if (ledgerInterval == 0)
+    {
+        throw std::invalid_argument("Invariant ledger interval must be > 0");
+    }
+    auto it = std::find_if(
+        mEnabled.begin(), mEnabled.end(),
+        [&](auto const& inv) { return inv->getName() == name; });
+    if (it == mEnabled.end())
+    {
+        throw std::invalid_argument(fmt::format(
+            FMT_STRING("Cannot sample invariant '{}', it is not enabled"),
+            name));
+    }
+    auto& sampling = mOperationSampling[it - mEnabled.begin()];
+    sampling.mLedgerInterval = ledgerInterval;
+    sampling.mLedgerBudget = ledgerBudget;
+    CLOG_INFO(Invariant,
+              "Invariant '{}' checks operations of one ledger in {}, for at "
+              "most {} per ledger",
+              name, ledgerInterval, ledgerBudget);
+}
+
 void
 InvariantManagerImpl::onInvariantFailure(std::shared_ptr<Invariant> invariant,
                                          std::string const& message,
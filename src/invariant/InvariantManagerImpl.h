@@ -5,13 +5,19 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "invariant/InvariantManager.h"
+#include "ledger/LedgerTxn.h"
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace medida
 {
 class MetricsRegistry;
 class Counter;
+class Meter;
+class Timer;
 }
 
 namespace stellar
@@ -21,8 +27,23 @@ class InvariantManagerImpl : public InvariantManager
 {
     std::map<std::string, std::shared_ptr<Invariant>> mInvariants;
     std::vector<std::shared_ptr<Invariant>> mEnabled;
+    medida::MetricsRegistry& mMetrics;
     medida::Counter& mInvariantFailureCount;
 
+    // Which operations an enabled invariant checks, and what checking them
+    // cost, indexed like mEnabled
+    struct OperationSampling
+    {
+        uint32_t mLedgerInterval{1};
+        std::chrono::nanoseconds mLedgerBudget{0};
+        uint32_t mLedger{0};
+        std::chrono::nanoseconds mSpentInLedger{0};
+        medida::Timer& mTime;
+        medida::Meter& mSampled;
+        medida::Meter& mSkipped;
+    };
+    std::vector<OperationSampling> mOperationSampling;
+
     struct InvariantFailureInformation
     {
         uint32_t lastFailedOnLedger;
@@ -30,6 +51,35 @@ class InvariantManagerImpl : public InvariantManager
     };
     std::map<std::string, InvariantFailureInformation> mFailureInformation;
 
+    // Operations waiting for an asynchronous check, with deep copies of their
+    // delta since the LedgerTxn entries may change once the operation is
+    // committed. A single job at a time drains the queue, so that invariants
+    // see the operations in apply order.
+    struct PendingOperationCheck
+    {
+        Operation mOperation;
+        OperationResult mResult;
+        LedgerTxnDelta mDelta;
+    };
+    Application* mAsyncApp{nullptr};
+    bool mHaltOnAsyncFailure{false};
+    std::mutex mAsyncMutex;
+    std::condition_variable mAsyncCond;
+    std::deque<PendingOperationCheck> mAsyncQueue;
+    bool mAsyncJobRunning{false};
+    // Expires with this object, for failures posted to the main thread
+    std::shared_ptr<bool> mAliveToken{std::make_shared<bool>(true)};
+    medida::Counter& mAsyncBacklog;
+    medida::Meter& mAsyncStall;
+    std::chrono::nanoseconds mOperationCheckTime{0};
+
+    // Past this many queued operations, apply waits for the checks to catch up
+    static size_t const MAX_ASYNC_QUEUED_OPERATIONS = 10000;
+
+    void drainAsyncOperationChecks();
+    void onAsyncInvariantFailure(std::shared_ptr<Invariant> invariant,
+                                 std::string const& message, uint32_t ledger);
+
   public:
     InvariantManagerImpl(medida::MetricsRegistry& registry);
 
@@ -41,6 +91,13 @@ class InvariantManagerImpl : public InvariantManager
                                        OperationResult const& opres,
                                        LedgerTxnDelta const& ltxDelta) override;
 
+    virtual void enableAsyncOperationChecks(Application& app,
+                                            bool haltOnFailure) override;
+
+    virtual void waitForAsyncOperationChecks() override;
+
+    virtual std::chrono::nanoseconds getOperationCheckTime() const override;
+
     virtual void checkOnBucketApply(
         std::shared_ptr<Bucket const> bucket, uint32_t ledger, uint32_t level,
         bool isCurr,
@@ -51,12 +108,26 @@ class InvariantManagerImpl : public InvariantManager
 
     virtual void enableInvariant(std::string const& name) override;
 
+    virtual void
+    setOperationSampling(std::string const& name, uint32_t ledgerInterval,
+                         std::chrono::milliseconds ledgerBudget) override;
+
 #ifdef BUILD_TESTS
     void snapshotForFuzzer() override;
     void resetForFuzzer() override;
 #endif // BUILD_TESTS
 
   private:
+    // Returns the message of every sampled invariant ltxDelta breaks
+    std::vector<std::pair<std::shared_ptr<Invariant>, std::string>>
+    checkOperation(Operation const& operation, OperationResult const& opres,
+                   LedgerTxnDelta const& ltxDelta);
+
+    // Checks the operation, or queues it if checks are asynchronous
+    void checkOrQueueOperation(Operation const& operation,
+                               OperationResult const& opres,
+                               LedgerTxnDelta const& ltxDelta);
+
     void onInvariantFailure(std::shared_ptr<Invariant> invariant,
                             std::string const& message, uint32_t ledger);
 
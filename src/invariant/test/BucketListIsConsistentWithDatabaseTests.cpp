@@ -6,6 +6,7 @@
 #include "bucket/BucketManager.h"
 #include "bucket/BucketOutputIterator.h"
 #include "catchup/ApplyBucketsWork.h"
+#include "invariant/BucketListIsConsistentWithDatabase.h"
 #include "ledger/LedgerHashUtils.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
@@ -14,6 +15,7 @@
 #include "lib/catch.hpp"
 #include "lib/util/stdrandom.h"
 #include "main/Application.h"
+#include "main/PersistentState.h"
 #include "test/TestUtils.h"
 #include "test/test.h"
 #include "transactions/TransactionUtils.h"
@@ -367,6 +369,39 @@ class ApplyBucketsWorkAddEntry : public ApplyBucketsWork
     }
 };
 
+class ApplyBucketsWorkInterrupted : public ApplyBucketsWork
+{
+  private:
+    uint32_t mCheckpointsLeft;
+
+  public:
+    ApplyBucketsWorkInterrupted(
+        Application& app,
+        std::map<std::string, std::shared_ptr<Bucket>> const& buckets,
+        HistoryArchiveState const& applyState, uint32_t maxProtocolVersion,
+        uint32_t interruptAfter)
+        : ApplyBucketsWork(app, buckets, applyState, maxProtocolVersion)
+        , mCheckpointsLeft(interruptAfter)
+    {
+        // Commit tiny batches so that buckets are checkpointed mid-file
+        setBatchSizeForTesting(1);
+    }
+
+    BasicWork::State
+    doWork() override
+    {
+        auto r = ApplyBucketsWork::doWork();
+        auto progress = mApp.getPersistentState().getState(
+            PersistentState::kBucketApplyProgress);
+        if (r == State::WORK_RUNNING && !progress.empty() &&
+            --mCheckpointsLeft == 0)
+        {
+            return State::WORK_FAILURE;
+        }
+        return r;
+    }
+};
+
 class ApplyBucketsWorkDeleteEntry : public ApplyBucketsWork
 {
   private:
@@ -892,6 +927,48 @@ TEST_CASE("BucketListIsConsistentWithDatabase bucket bounds",
     }
 }
 
+TEST_CASE("BucketListIsConsistentWithDatabase resumes interrupted apply",
+          "[invariant][bucketlistconsistent]")
+{
+    auto test = [](Config const& cfg) {
+        BucketListGenerator blg;
+        blg.generateLedgers(100);
+
+        VirtualClock clock;
+        Application::pointer app = createTestApplication(clock, cfg);
+        auto& ps = app->getPersistentState();
+        auto& wm = app->getWorkScheduler();
+        auto has = blg.getHistoryArchiveState(app);
+        auto vers = app->getConfig().LEDGER_PROTOCOL_VERSION;
+        auto all = [](LedgerEntryType) { return true; };
+        std::map<std::string, std::shared_ptr<Bucket>> buckets;
+
+        auto interrupted = wm.executeWork<ApplyBucketsWorkInterrupted>(
+            buckets, has, vers, 5);
+        REQUIRE(interrupted->getState() == BasicWork::State::WORK_FAILURE);
+        REQUIRE(!ps.getState(PersistentState::kBucketApplyProgress).empty());
+        REQUIRE(ApplyBucketsWork::hasResumableProgress(*app, has, all));
+
+        // Bucket application invariants check every bucket against the
+        // database, including the entries committed before the interruption
+        auto resumed = wm.executeWork<ApplyBucketsWork>(buckets, has, vers);
+        REQUIRE(resumed->getState() == BasicWork::State::WORK_SUCCESS);
+        REQUIRE(ps.getState(PersistentState::kBucketApplyProgress).empty());
+        REQUIRE(!ApplyBucketsWork::hasResumableProgress(*app, has, all));
+    };
+
+    SECTION("sql")
+    {
+        test(getTestConfig(1));
+    }
+    SECTION("bucketlistdb")
+    {
+        auto cfg = getTestConfig(1);
+        cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+        test(cfg);
+    }
+}
+
 TEST_CASE("BucketListIsConsistentWithDatabase merged LIVEENTRY and DEADENTRY",
           "[invariant][bucketlistconsistent][acceptance]")
 {
@@ -992,3 +1069,20 @@ TEST_CASE("BucketListIsConsistentWithDatabase merged LIVEENTRY and DEADENTRY",
         }
     }
 }
+
+TEST_CASE("BucketListIsConsistentWithDatabase check entire bucketlist",
+          "[invariant][bucketlistconsistent]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    BucketListIsConsistentWithDatabase blc(*app);
+    REQUIRE_NOTHROW(blc.checkEntireBucketlist());
+
+    SECTION("offer only in database")
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        ltx.create(LedgerTestUtils::generateValidLedgerEntryOfType(OFFER));
+        ltx.commit();
+        REQUIRE_THROWS_AS(blc.checkEntireBucketlist(), std::runtime_error);
+    }
+}
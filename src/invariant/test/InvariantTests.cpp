@@ -18,6 +18,8 @@
 #include "test/test.h"
 
 #include <fmt/format.h>
+#include <medida/counter.h>
+#include <medida/metrics_registry.h>
 
 using namespace stellar;
 
@@ -216,3 +218,101 @@ TEST_CASE("onOperationApply fail succeed", "[invariant]")
             {}, res, ltx.getDelta()));
     }
 }
+
+TEST_CASE("onOperationApply async checks", "[invariant]")
+{
+    VirtualClock clock;
+    Config cfg = getTestConfig();
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& im = app->getInvariantManager();
+    auto& failures =
+        app->getMetrics().NewCounter({"ledger", "invariant", "failure"});
+
+    im.registerInvariant<TestInvariant>(0, true);
+    im.enableInvariant(TestInvariant::toString(0, true));
+
+    OperationResult res;
+    auto checkAndWait = [&]() {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE_NOTHROW(im.checkOnOperationApply({}, res, ltx.getDelta()));
+        im.waitForAsyncOperationChecks();
+    };
+
+    SECTION("report")
+    {
+        im.enableAsyncOperationChecks(*app, false);
+        auto before = failures.count();
+        checkAndWait();
+        while (failures.count() == before)
+        {
+            clock.crank(false);
+        }
+        REQUIRE(failures.count() == before + 1);
+        REQUIRE(im.getJsonInfo().isMember(TestInvariant::toString(0, true)));
+    }
+    SECTION("halt")
+    {
+        im.enableAsyncOperationChecks(*app, true);
+        checkAndWait();
+        REQUIRE_THROWS_AS(
+            [&]() {
+                for (;;)
+                {
+                    clock.crank(false);
+                }
+            }(),
+            InvariantDoesNotHold);
+    }
+}
+
+TEST_CASE("onOperationApply sampling", "[invariant]")
+{
+    VirtualClock clock;
+    Config cfg = getTestConfig();
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& im = app->getInvariantManager();
+    im.registerInvariant<TestInvariant>(0, true);
+    im.registerInvariant<TestInvariant>(1, false);
+
+    REQUIRE_THROWS_AS(im.setOperationSampling(TestInvariant::toString(0, true),
+                                              3, std::chrono::milliseconds(0)),
+                      std::invalid_argument);
+    im.enableInvariant(TestInvariant::toString(0, true));
+    im.enableInvariant(TestInvariant::toString(1, false));
+    im.setOperationSampling(TestInvariant::toString(0, true), 3,
+                            std::chrono::milliseconds(0));
+    im.setOperationSampling(TestInvariant::toString(1, false), 4,
+                            std::chrono::milliseconds(0));
+
+    OperationResult res;
+    LedgerTxnDelta delta;
+    delta.header.current.ledgerVersion =
+        Config::CURRENT_LEDGER_PROTOCOL_VERSION;
+    int failures = 0;
+    for (uint32_t ledger = 1; ledger <= 12; ++ledger)
+    {
+        delta.header.current.ledgerSeq = ledger;
+        for (int op = 0; op < 2; ++op)
+        {
+            try
+            {
+                im.checkOnOperationApply({}, res, delta);
+            }
+            catch (InvariantDoesNotHold&)
+            {
+                ++failures;
+            }
+        }
+    }
+    // Ledgers 3, 6, 9 and 12
+    REQUIRE(failures == 8);
+
+    auto meter = [&](std::string const& name, std::string const& type) {
+        return app->getMetrics()
+            .NewMeter({"invariant", name, type}, "operation")
+            .count();
+    };
+    // Ledgers 3, 7 and 11
+    REQUIRE(meter(TestInvariant::toString(1, false), "sampled") == 6);
+    REQUIRE(meter(TestInvariant::toString(1, false), "skipped") == 18);
+}
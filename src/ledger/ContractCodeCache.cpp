@@ -0,0 +1,66 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/ContractCodeCache.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+#include "util/GlobalChecks.h"
+#include <xdrpp/marshal.h>
+
+namespace stellar
+{
+
+namespace
+{
+std::shared_ptr<std::vector<uint8_t> const>
+encode(LedgerEntry const& le)
+{
+    return std::make_shared<std::vector<uint8_t> const>(
+        xdr::xdr_to_opaque(le));
+}
+}
+
+ContractCodeCache::ContractCodeCache(medida::MetricsRegistry& metrics)
+    : mCache(CACHE_SIZE)
+    , mHit(metrics.NewMeter({"soroban", "code-cache", "hit"}, "entry"))
+    , mMiss(metrics.NewMeter({"soroban", "code-cache", "miss"}, "entry"))
+    , mReusedInstantiation(metrics.NewTimer(
+          {"soroban", "code-cache", "reused-vm-instantiation"}))
+{
+}
+
+std::shared_ptr<std::vector<uint8_t> const>
+ContractCodeCache::getEncoded(LedgerEntry const& le, bool& hit)
+{
+    releaseAssert(le.data.type() == CONTRACT_CODE);
+    auto const& hash = le.data.contractCode().hash;
+    auto cached = mCache.maybeGet(hash);
+    hit = cached && cached->mLastModifiedLedgerSeq == le.lastModifiedLedgerSeq;
+    if (hit)
+    {
+        mHit.Mark();
+        return cached->mEncoded;
+    }
+
+    mMiss.Mark();
+    auto encoded = encode(le);
+    mCache.put(hash, CachedCode{le.lastModifiedLedgerSeq, encoded});
+    return encoded;
+}
+
+void
+ContractCodeCache::put(LedgerEntry const& le)
+{
+    releaseAssert(le.data.type() == CONTRACT_CODE);
+    mCache.put(le.data.contractCode().hash,
+               CachedCode{le.lastModifiedLedgerSeq, encode(le)});
+}
+
+void
+ContractCodeCache::noteReusedInstantiation(std::chrono::nanoseconds time)
+{
+    mReusedInstantiation.Update(time);
+}
+}
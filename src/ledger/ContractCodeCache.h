@@ -0,0 +1,63 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/RandomEvictionCache.h"
+#include "xdr/Stellar-ledger-entries.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+class MetricsRegistry;
+class Timer;
+}
+
+namespace stellar
+{
+
+// Keeps the XDR encoding of recently invoked ContractCode entries, so that
+// calling a popular contract does not re-encode its WASM for the host on
+// every invocation.
+//
+// The code stored under a hash never changes, so an entry is identified by
+// its hash and lastModifiedLedgerSeq; a cached encoding is only ever handed
+// out for that exact entry. Code whose TTL expired is never loaded for an
+// invocation, so it simply ages out of the (bounded) cache.
+class ContractCodeCache
+{
+  public:
+    static constexpr size_t CACHE_SIZE = 256;
+
+    explicit ContractCodeCache(medida::MetricsRegistry& metrics);
+
+    // Returns the encoding of the ContractCode entry `le`, from the cache if
+    // possible. `hit` is set to whether it was.
+    std::shared_ptr<std::vector<uint8_t> const>
+    getEncoded(LedgerEntry const& le, bool& hit);
+
+    // Caches a ContractCode entry that is being created
+    void put(LedgerEntry const& le);
+
+    // Records the VM instantiation time of an invocation whose code was
+    // cached: the part of its cost a module cache in the host would save
+    void noteReusedInstantiation(std::chrono::nanoseconds time);
+
+  private:
+    struct CachedCode
+    {
+        uint32_t mLastModifiedLedgerSeq;
+        std::shared_ptr<std::vector<uint8_t> const> mEncoded;
+    };
+
+    RandomEvictionCache<Hash, CachedCode> mCache;
+    medida::Meter& mHit;
+    medida::Meter& mMiss;
+    medida::Timer& mReusedInstantiation;
+};
+}
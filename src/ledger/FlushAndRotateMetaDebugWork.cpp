@@ -4,10 +4,14 @@
 
 #include "ledger/FlushAndRotateMetaDebugWork.h"
 #include "bucket/BucketManager.h"
+#include "main/Application.h"
 #include "util/DebugMetaUtils.h"
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
+#include "util/Logging.h"
 #include <filesystem>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
 #include <memory>
 #include <regex>
 #include <stdexcept>
@@ -18,16 +22,90 @@ namespace stellar
 
 using namespace metautils;
 
+namespace
+{
+// Deletes the oldest meta-debug files, gzipped or not -- non-gzipped ones are
+// left behind when users kill or restart core processes.
+void
+trimMetaDebugFiles(std::filesystem::path const& bucketDir,
+                   uint32_t ledgersToKeep)
+{
+    auto dir = getMetaDebugDirPath(bucketDir);
+    auto files = listMetaDebugFiles(bucketDir);
+    auto keep = getNumberOfDebugFilesToKeep(ledgersToKeep);
+    if (files.size() > keep)
+    {
+        // Forget about the most-recent (highest-sorting) keep files -- they get
+        // to survive.
+        files.resize(files.size() - keep);
+
+        // Delete all (size()-keep) younger (lower-sorting) files not forgotten
+        // above.
+        for (auto const& file : files)
+        {
+            releaseAssert(
+                std::regex_match(file.string(), META_DEBUG_FILE_REGEX));
+            auto f = dir / file;
+            CLOG_DEBUG(Ledger, "trimming old meta-debug file {}", f.string());
+            std::error_code ec;
+            std::filesystem::remove(f, ec);
+            // Ignore errors: there's nothing we can do to "try harder" and
+            // failing the work is not helpful. We'll just try again.
+        }
+    }
+}
+}
+
 FlushAndRotateMetaDebugWork::FlushAndRotateMetaDebugWork(
     Application& app, std::filesystem::path const& metaDebugPath,
-    std::unique_ptr<XDROutputFileStream> metaDebugFile, uint32_t ledgersToKeep)
+    std::unique_ptr<XDROutputFileStream> metaDebugFile, uint32_t ledgersToKeep,
+    std::weak_ptr<BasicWork> previous)
     : Work(app, "flush and rotate meta-debug", BasicWork::RETRY_NEVER)
     , mMetaDebugPath(metaDebugPath)
     , mMetaDebugFile(std::move(metaDebugFile))
+    , mPrevious(previous)
     , mLedgersToKeep(ledgersToKeep)
+    , mStart(app.getClock().now())
+    , mRotateTime(
+          app.getMetrics().NewTimer({"ledger", "metadebug", "rotate"}))
 {
 }
 
+void
+FlushAndRotateMetaDebugWork::postToBackgroundAndWakeUp(
+    std::function<void()> f, std::function<void()> onMain,
+    std::string const& name)
+{
+    std::weak_ptr<FlushAndRotateMetaDebugWork> weak =
+        std::static_pointer_cast<FlushAndRotateMetaDebugWork>(
+            shared_from_this());
+    mApp.postOnBackgroundThread(
+        [weak, f, onMain, name]() {
+            auto self = weak.lock();
+            if (!self || self->isAborting())
+            {
+                return;
+            }
+            f();
+
+            // Then post back to main thread.
+            self->mApp.postOnMainThread(
+                [weak, onMain]() {
+                    auto self = weak.lock();
+                    if (self)
+                    {
+                        if (onMain)
+                        {
+                            onMain();
+                        }
+                        self->wakeUpAndRun();
+                    }
+                },
+                "wake up " + name);
+        },
+        std::string(name), BackgroundPriority::LOW);
+}
+
 BasicWork::State
 FlushAndRotateMetaDebugWork::doWork()
 {
@@ -37,10 +115,6 @@ FlushAndRotateMetaDebugWork::doWork()
     // gzip'ing and rotating.
     if (mMetaDebugFile)
     {
-        std::weak_ptr<FlushAndRotateMetaDebugWork> weak =
-            std::static_pointer_cast<FlushAndRotateMetaDebugWork>(
-                shared_from_this());
-
         // This is a little silly, but we have ownership of a non-copyable
         // unique_ptr here, and we want to transfer that ownership into a
         // closure held by a std::function -- which unfortunately requires
@@ -48,17 +122,12 @@ FlushAndRotateMetaDebugWork::doWork()
         // something copy-constructble: a shared_ptr<unique_ptr<...>>.
         using OwnedStream = std::unique_ptr<XDROutputFileStream>;
         auto file = std::make_shared<OwnedStream>(std::move(mMetaDebugFile));
-        mApp.postOnBackgroundThread(
-            [weak, file]() {
-                auto self = weak.lock();
-                if (!self || self->isAborting())
-                {
-                    return;
-                }
-
+        auto path = mMetaDebugPath;
+        postToBackgroundAndWakeUp(
+            [file, path]() {
                 // First close() here, which will call fsync(), which blocks.
                 CLOG_DEBUG(Ledger, "closing meta-debug file {}",
-                           self->mMetaDebugPath.string());
+                           path.string());
                 try
                 {
                     (*file)->close();
@@ -73,25 +142,23 @@ FlushAndRotateMetaDebugWork::doWork()
                                  "Failed to close debug metadata stream: {}",
                                  e.what());
                 }
-
-                // Then post back to main thread.
-                self->mApp.postOnMainThread(
-                    [weak]() {
-                        auto self = weak.lock();
-                        if (self)
-                        {
-                            self->wakeUp();
-                        }
-                    },
-                    "wake up gzip and rotate meta-debug");
             },
-            "close and fsync meta-debug");
+            nullptr, "close and fsync meta-debug");
         return BasicWork::State::WORK_WAITING;
     }
 
-    // Step 2: wait for the creation and completion of mGzipFileWork.
+    // Step 2: once the previous rotation is done, wait for the creation and
+    // completion of mGzipFileWork.
     if (!mGzipFileWork)
     {
+        auto previous = mPrevious.lock();
+        if (previous && !previous->isDone())
+        {
+            setupWaitingCallback(std::chrono::milliseconds(100));
+            return State::WORK_WAITING;
+        }
+        mPrevious.reset();
+
         CLOG_DEBUG(Ledger, "compressing meta-debug file {}",
                    mMetaDebugPath.string());
         mGzipFileWork = addWork<GzipFileWork>(mMetaDebugPath.string());
@@ -113,33 +180,35 @@ FlushAndRotateMetaDebugWork::doWork()
         return State::WORK_FAILURE;
     }
 
-    // Step 3: synchronously rotate the meta files in the directory, whether
-    // gzipped or not -- non-gzipped ones are left behind when users kill or
-    // restart core processes.
-    auto bucketDir = mApp.getBucketManager().getBucketDir();
-    auto dir = getMetaDebugDirPath(bucketDir);
-    auto files = listMetaDebugFiles(bucketDir);
-    auto keep = getNumberOfDebugFilesToKeep(mLedgersToKeep);
-    if (files.size() > keep)
+    // Step 3: rotate the meta files in the directory on a background thread,
+    // deleting files can take a while.
+    if (!mTrimStarted)
     {
-        // Forget about the most-recent (highest-sorting) keep files -- they get
-        // to survive.
-        files.resize(files.size() - keep);
-
-        // Delete all (size()-keep) younger (lower-sorting) files not forgotten
-        // above.
-        for (auto const& file : files)
-        {
-            releaseAssert(
-                std::regex_match(file.string(), META_DEBUG_FILE_REGEX));
-            auto f = dir / file;
-            CLOG_DEBUG(Ledger, "trimming old meta-debug file {}", f.string());
-            std::error_code ec;
-            std::filesystem::remove(f, ec);
-            // Ignore errors: there's nothing we can do to "try harder" and
-            // failing the work is not helpful. We'll just try again.
-        }
+        mTrimStarted = true;
+        std::filesystem::path bucketDir =
+            mApp.getBucketManager().getBucketDir();
+        auto ledgersToKeep = mLedgersToKeep;
+        std::weak_ptr<FlushAndRotateMetaDebugWork> weak =
+            std::static_pointer_cast<FlushAndRotateMetaDebugWork>(
+                shared_from_this());
+        postToBackgroundAndWakeUp(
+            [bucketDir, ledgersToKeep]() {
+                trimMetaDebugFiles(bucketDir, ledgersToKeep);
+            },
+            [weak]() {
+                if (auto self = weak.lock())
+                {
+                    self->mTrimmed = true;
+                }
+            },
+            "trim meta-debug");
+        return State::WORK_WAITING;
+    }
+    if (!mTrimmed)
+    {
+        return State::WORK_WAITING;
     }
+    mRotateTime.Update(mApp.getClock().now() - mStart);
     return State::WORK_SUCCESS;
 }
 
@@ -5,24 +5,44 @@
 #pragma once
 
 #include "historywork/GzipFileWork.h"
+#include "util/Timer.h"
 #include "util/XDRStream.h"
 #include <filesystem>
 
+namespace medida
+{
+class Timer;
+}
+
 namespace stellar
 {
 
+// Closes (with fsync), compresses and trims a finished meta-debug file, with
+// all the file system work off the main thread. Rotations of consecutive
+// files may overlap: each one closes its file right away, but compresses and
+// trims only once the previous one is done, so that it doesn't trim a file
+// still being compressed.
 class FlushAndRotateMetaDebugWork : public Work
 {
     std::filesystem::path mMetaDebugPath;
     std::unique_ptr<XDROutputFileStream> mMetaDebugFile;
+    std::weak_ptr<BasicWork> mPrevious;
     std::shared_ptr<GzipFileWork> mGzipFileWork;
     uint32_t mLedgersToKeep;
+    bool mTrimStarted{false};
+    bool mTrimmed{false};
+    VirtualClock::time_point const mStart;
+    medida::Timer& mRotateTime;
+
+    void postToBackgroundAndWakeUp(std::function<void()> f,
+                                   std::function<void()> onMain,
+                                   std::string const& name);
 
   public:
     FlushAndRotateMetaDebugWork(
         Application& app, std::filesystem::path const& metaDebugPath,
         std::unique_ptr<XDROutputFileStream> metaDebugFile,
-        uint32_t ledgersToKeep);
+        uint32_t ledgersToKeep, std::weak_ptr<BasicWork> previous = {});
     ~FlushAndRotateMetaDebugWork() = default;
 
   protected:
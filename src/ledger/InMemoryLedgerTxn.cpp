@@ -251,6 +251,12 @@ InMemoryLedgerTxn::loadWithoutRecord(InternalLedgerKey const& key)
     throw std::runtime_error("called loadWithoutRecord on InMemoryLedgerTxn");
 }
 
+std::vector<LedgerTxnEntry>
+InMemoryLedgerTxn::loadBatch(std::vector<InternalLedgerKey> const& keys)
+{
+    throw std::runtime_error("called loadBatch on InMemoryLedgerTxn");
+}
+
 UnorderedMap<LedgerKey, LedgerEntry>
 InMemoryLedgerTxn::getOffersByAccountAndAsset(AccountID const& account,
                                               Asset const& asset)
@@ -92,6 +92,8 @@ class InMemoryLedgerTxn : public LedgerTxn
     LedgerTxnEntry load(InternalLedgerKey const& key) override;
     ConstLedgerTxnEntry
     loadWithoutRecord(InternalLedgerKey const& key) override;
+    std::vector<LedgerTxnEntry>
+    loadBatch(std::vector<InternalLedgerKey> const& keys) override;
 
     UnorderedMap<LedgerKey, LedgerEntry>
     getOffersByAccountAndAsset(AccountID const& account,
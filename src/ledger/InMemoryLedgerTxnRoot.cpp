@@ -96,6 +96,19 @@ InMemoryLedgerTxnRoot::getNewestVersion(InternalLedgerKey const& key) const
     return nullptr;
 }
 
+UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+InMemoryLedgerTxnRoot::getNewestVersions(
+    UnorderedSet<InternalLedgerKey> const& keys) const
+{
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+        res;
+    for (auto const& key : keys)
+    {
+        res.emplace(key, nullptr);
+    }
+    return res;
+}
+
 uint64_t
 InMemoryLedgerTxnRoot::countObjects(LedgerEntryType let) const
 {
@@ -165,6 +178,16 @@ InMemoryLedgerTxnRoot::dropTTL(bool)
 {
 }
 
+void
+InMemoryLedgerTxnRoot::beginBulkPopulate(bool)
+{
+}
+
+void
+InMemoryLedgerTxnRoot::endBulkPopulate()
+{
+}
+
 double
 InMemoryLedgerTxnRoot::getPrefetchHitRate() const
 {
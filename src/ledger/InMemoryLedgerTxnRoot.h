@@ -63,6 +63,9 @@ class InMemoryLedgerTxnRoot : public AbstractLedgerTxnParent
 
     std::shared_ptr<InternalLedgerEntry const>
     getNewestVersion(InternalLedgerKey const& key) const override;
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+    getNewestVersions(
+        UnorderedSet<InternalLedgerKey> const& keys) const override;
 
     uint64_t countObjects(LedgerEntryType let) const override;
     uint64_t countObjects(LedgerEntryType let,
@@ -80,6 +83,8 @@ class InMemoryLedgerTxnRoot : public AbstractLedgerTxnParent
     void dropContractCode(bool rebuild) override;
     void dropConfigSettings(bool rebuild) override;
     void dropTTL(bool rebuild) override;
+    void beginBulkPopulate(bool entriesAreUnique) override;
+    void endBulkPopulate() override;
     double getPrefetchHitRate() const override;
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
     void prepareNewObjects(size_t s) override;
@@ -73,15 +73,17 @@ LedgerCloseMetaFrame::pushTxProcessingEntry()
 
 void
 LedgerCloseMetaFrame::setLastTxProcessingFeeProcessingChanges(
-    LedgerEntryChanges const& changes)
+    LedgerEntryChanges&& changes)
 {
     switch (mVersion)
     {
     case 0:
-        mLedgerCloseMeta.v0().txProcessing.back().feeProcessing = changes;
+        mLedgerCloseMeta.v0().txProcessing.back().feeProcessing =
+            std::move(changes);
         break;
     case 1:
-        mLedgerCloseMeta.v1().txProcessing.back().feeProcessing = changes;
+        mLedgerCloseMeta.v1().txProcessing.back().feeProcessing =
+            std::move(changes);
         break;
     default:
         releaseAssert(false);
@@ -90,21 +92,21 @@ LedgerCloseMetaFrame::setLastTxProcessingFeeProcessingChanges(
 
 void
 LedgerCloseMetaFrame::setTxProcessingMetaAndResultPair(
-    TransactionMeta const& tm, TransactionResultPair&& rp, int index)
+    TransactionMeta&& tm, TransactionResultPair&& rp, int index)
 {
     switch (mVersion)
     {
     case 0:
     {
         auto& txp = mLedgerCloseMeta.v0().txProcessing.at(index);
-        txp.txApplyProcessing = tm;
+        txp.txApplyProcessing = std::move(tm);
         txp.result = std::move(rp);
     }
     break;
     case 1:
     {
         auto& txp = mLedgerCloseMeta.v1().txProcessing.at(index);
-        txp.txApplyProcessing = tm;
+        txp.txApplyProcessing = std::move(tm);
         txp.result = std::move(rp);
     }
     break;
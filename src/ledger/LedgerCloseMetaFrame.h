@@ -20,9 +20,8 @@ class LedgerCloseMetaFrame
     LedgerHeaderHistoryEntry& ledgerHeader();
     void reserveTxProcessing(size_t n);
     void pushTxProcessingEntry();
-    void
-    setLastTxProcessingFeeProcessingChanges(LedgerEntryChanges const& changes);
-    void setTxProcessingMetaAndResultPair(TransactionMeta const& tm,
+    void setLastTxProcessingFeeProcessingChanges(LedgerEntryChanges&& changes);
+    void setTxProcessingMetaAndResultPair(TransactionMeta&& tm,
                                           TransactionResultPair&& rp,
                                           int index);
 
@@ -0,0 +1,148 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerHashUtils.h"
+#include <cstring>
+
+namespace stellar
+{
+namespace
+{
+// Encoding of the fields of a key other than contract data, which fits on the
+// stack: at most the type, an account ID and a 64 byte data name
+class KeyBytes
+{
+    unsigned char mBuf[1 + 32 + 64];
+    size_t mLen{0};
+
+  public:
+    void
+    add(void const* bytes, size_t len)
+    {
+        std::memcpy(mBuf + mLen, bytes, len);
+        mLen += len;
+    }
+
+    void
+    add(uint8_t byte)
+    {
+        mBuf[mLen++] = byte;
+    }
+
+    void
+    add(uint256 const& bytes)
+    {
+        add(bytes.data(), bytes.size());
+    }
+
+    uint64_t
+    hash() const
+    {
+        return shortHash::computeHash(ByteSlice(mBuf, mLen));
+    }
+};
+
+void
+addAsset(KeyBytes& kb, TrustLineAsset const& asset)
+{
+    kb.add(static_cast<uint8_t>(asset.type()));
+    switch (asset.type())
+    {
+    case ASSET_TYPE_NATIVE:
+        break;
+    case ASSET_TYPE_CREDIT_ALPHANUM4:
+        kb.add(asset.alphaNum4().assetCode.data(),
+               asset.alphaNum4().assetCode.size());
+        kb.add(asset.alphaNum4().issuer.ed25519());
+        break;
+    case ASSET_TYPE_CREDIT_ALPHANUM12:
+        kb.add(asset.alphaNum12().assetCode.data(),
+               asset.alphaNum12().assetCode.size());
+        kb.add(asset.alphaNum12().issuer.ed25519());
+        break;
+    case ASSET_TYPE_POOL_SHARE:
+        kb.add(asset.liquidityPoolID());
+        break;
+    default:
+        throw std::runtime_error("unknown Asset type");
+    }
+}
+
+uint64_t
+getContractDataShortHash(LedgerKey const& lk)
+{
+    auto const& cd = lk.contractData();
+    shortHash::XDRShortHasher hasher;
+    unsigned char prefix[] = {static_cast<unsigned char>(lk.type()),
+                              static_cast<unsigned char>(cd.contract.type()),
+                              static_cast<unsigned char>(cd.durability)};
+    hasher.queueOrHash(prefix, sizeof(prefix));
+    switch (cd.contract.type())
+    {
+    case SC_ADDRESS_TYPE_ACCOUNT:
+        hasher.queueOrHash(cd.contract.accountId().ed25519().data(),
+                           cd.contract.accountId().ed25519().size());
+        break;
+    case SC_ADDRESS_TYPE_CONTRACT:
+        hasher.queueOrHash(cd.contract.contractId().data(),
+                           cd.contract.contractId().size());
+        break;
+    }
+    xdr::xdr_argpack_archive(hasher, cd.key);
+    hasher.flush();
+    return hasher.state.digest();
+}
+}
+
+size_t
+getLedgerKeyShortHash(LedgerKey const& lk)
+{
+    if (lk.type() == CONTRACT_DATA)
+    {
+        return getContractDataShortHash(lk);
+    }
+
+    KeyBytes kb;
+    kb.add(static_cast<uint8_t>(lk.type()));
+    switch (lk.type())
+    {
+    case ACCOUNT:
+        kb.add(lk.account().accountID.ed25519());
+        break;
+    case TRUSTLINE:
+        kb.add(lk.trustLine().accountID.ed25519());
+        addAsset(kb, lk.trustLine().asset);
+        break;
+    case DATA:
+        kb.add(lk.data().accountID.ed25519());
+        kb.add(lk.data().dataName.data(), lk.data().dataName.size());
+        break;
+    case OFFER:
+        // As in getLedgerKeyFieldHash, offer IDs alone tell offers apart
+        kb.add(&lk.offer().offerID, sizeof(lk.offer().offerID));
+        break;
+    case CLAIMABLE_BALANCE:
+        kb.add(lk.claimableBalance().balanceID.v0());
+        break;
+    case LIQUIDITY_POOL:
+        kb.add(lk.liquidityPool().liquidityPoolID);
+        break;
+    case CONTRACT_CODE:
+        kb.add(lk.contractCode().hash);
+        break;
+    case CONFIG_SETTING:
+    {
+        int32_t id = lk.configSetting().configSettingID;
+        kb.add(&id, sizeof(id));
+        break;
+    }
+    case TTL:
+        kb.add(lk.ttl().keyHash);
+        break;
+    default:
+        abort();
+    }
+    return kb.hash();
+}
+}
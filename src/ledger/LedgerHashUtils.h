@@ -74,6 +74,78 @@ getAssetHash(T const& asset)
     return res;
 }
 
+// Hashes `lk` by mixing the hashes of each of its fields
+static inline size_t
+getLedgerKeyFieldHash(LedgerKey const& lk)
+{
+    size_t res = lk.type();
+    switch (lk.type())
+    {
+    case ACCOUNT:
+        hashMix(res, std::hash<uint256>()(lk.account().accountID.ed25519()));
+        break;
+    case TRUSTLINE:
+    {
+        auto& tl = lk.trustLine();
+        hashMix(res, std::hash<uint256>()(tl.accountID.ed25519()));
+        hashMix(res, getAssetHash<TrustLineAsset>(tl.asset));
+        break;
+    }
+    case DATA:
+        hashMix(res, std::hash<uint256>()(lk.data().accountID.ed25519()));
+        hashMix(res,
+                shortHash::computeHash(ByteSlice(lk.data().dataName.data(),
+                                                 lk.data().dataName.size())));
+        break;
+    case OFFER:
+        hashMix(res, shortHash::computeHash(ByteSlice(
+                         &lk.offer().offerID, sizeof(lk.offer().offerID))));
+        break;
+    case CLAIMABLE_BALANCE:
+        hashMix(res,
+                std::hash<uint256>()(lk.claimableBalance().balanceID.v0()));
+        break;
+    case LIQUIDITY_POOL:
+        hashMix(res,
+                std::hash<uint256>()(lk.liquidityPool().liquidityPoolID));
+        break;
+    case CONTRACT_DATA:
+        switch (lk.contractData().contract.type())
+        {
+        case SC_ADDRESS_TYPE_ACCOUNT:
+            hashMix(res,
+                    std::hash<uint256>()(
+                        lk.contractData().contract.accountId().ed25519()));
+            break;
+        case SC_ADDRESS_TYPE_CONTRACT:
+            hashMix(res, std::hash<uint256>()(
+                             lk.contractData().contract.contractId()));
+            break;
+        }
+        hashMix(res, shortHash::xdrComputeHash(lk.contractData().key));
+        hashMix(res, std::hash<int32_t>()(lk.contractData().durability));
+        break;
+    case CONTRACT_CODE:
+        hashMix(res, std::hash<uint256>()(lk.contractCode().hash));
+        break;
+    case CONFIG_SETTING:
+        hashMix(res,
+                std::hash<int32_t>()(lk.configSetting().configSettingID));
+        break;
+    case TTL:
+        hashMix(res, std::hash<uint256>()(lk.ttl().keyHash));
+        break;
+    default:
+        abort();
+    }
+    return res;
+}
+
+// Hashes `lk` with a single shortHash pass over a compact encoding of its
+// fields: the key type followed by the raw bytes of the fields that identify
+// the entry, and the XDR of the key of contract data. Selected as the hash of
+// LedgerKey by building with --enable-ledger-key-short-hash.
+size_t getLedgerKeyShortHash(LedgerKey const& lk);
 }
 
 // implements a default hasher for "LedgerKey"
@@ -105,77 +177,11 @@ template <> class hash<stellar::LedgerKey>
     size_t
     operator()(stellar::LedgerKey const& lk) const
     {
-        size_t res = lk.type();
-        switch (lk.type())
-        {
-        case stellar::ACCOUNT:
-            stellar::hashMix(res, std::hash<stellar::uint256>()(
-                                      lk.account().accountID.ed25519()));
-            break;
-        case stellar::TRUSTLINE:
-        {
-            auto& tl = lk.trustLine();
-            stellar::hashMix(
-                res, std::hash<stellar::uint256>()(tl.accountID.ed25519()));
-            stellar::hashMix(res, hash<stellar::TrustLineAsset>()(tl.asset));
-            break;
-        }
-        case stellar::DATA:
-            stellar::hashMix(res, std::hash<stellar::uint256>()(
-                                      lk.data().accountID.ed25519()));
-            stellar::hashMix(
-                res,
-                stellar::shortHash::computeHash(stellar::ByteSlice(
-                    lk.data().dataName.data(), lk.data().dataName.size())));
-            break;
-        case stellar::OFFER:
-            stellar::hashMix(
-                res, stellar::shortHash::computeHash(stellar::ByteSlice(
-                         &lk.offer().offerID, sizeof(lk.offer().offerID))));
-            break;
-        case stellar::CLAIMABLE_BALANCE:
-            stellar::hashMix(res, std::hash<stellar::uint256>()(
-                                      lk.claimableBalance().balanceID.v0()));
-            break;
-        case stellar::LIQUIDITY_POOL:
-            stellar::hashMix(res, std::hash<stellar::uint256>()(
-                                      lk.liquidityPool().liquidityPoolID));
-            break;
-        case stellar::CONTRACT_DATA:
-            switch (lk.contractData().contract.type())
-            {
-            case stellar::SC_ADDRESS_TYPE_ACCOUNT:
-                stellar::hashMix(
-                    res, std::hash<stellar::uint256>()(
-                             lk.contractData().contract.accountId().ed25519()));
-                break;
-            case stellar::SC_ADDRESS_TYPE_CONTRACT:
-                stellar::hashMix(res,
-                                 std::hash<stellar::uint256>()(
-                                     lk.contractData().contract.contractId()));
-                break;
-            }
-            stellar::hashMix(
-                res, stellar::shortHash::xdrComputeHash(lk.contractData().key));
-            stellar::hashMix(
-                res, std::hash<int32_t>()(lk.contractData().durability));
-            break;
-        case stellar::CONTRACT_CODE:
-            stellar::hashMix(
-                res, std::hash<stellar::uint256>()(lk.contractCode().hash));
-            break;
-        case stellar::CONFIG_SETTING:
-            stellar::hashMix(
-                res, std::hash<int32_t>()(lk.configSetting().configSettingID));
-            break;
-        case stellar::TTL:
-            stellar::hashMix(res,
-                             std::hash<stellar::uint256>()(lk.ttl().keyHash));
-            break;
-        default:
-            abort();
-        }
-        return res;
+#ifdef USE_LEDGER_KEY_SHORT_HASH
+        return stellar::getLedgerKeyShortHash(lk);
+#else
+        return stellar::getLedgerKeyFieldHash(lk);
+#endif
     }
 };
 
@@ -14,7 +14,7 @@
 #include "util/types.h"
 #include "xdrpp/marshal.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 #include <util/basen.h>
 
@@ -167,11 +167,22 @@ loadBySequence(Database& db, soci::session& sess, uint32_t seq)
     return lhPtr;
 }
 
+uint32_t
+getOldestLedgerSeq(soci::session& sess)
+{
+    ZoneScoped;
+    uint32_t oldest = 0;
+    soci::indicator gotOldest;
+    sess << "SELECT MIN(ledgerseq) FROM ledgerheaders",
+        soci::into(oldest, gotOldest);
+    return gotOldest == soci::i_ok ? oldest : 0;
+}
+
 void
-deleteOldEntries(Database& db, uint32_t ledgerSeq, uint32_t count)
+deleteOldEntries(soci::session& sess, uint32_t ledgerSeq, uint32_t count)
 {
     ZoneScoped;
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
+    DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
                                           "ledgerheaders", "ledgerseq");
 }
 
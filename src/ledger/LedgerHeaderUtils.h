@@ -27,7 +27,10 @@ std::shared_ptr<LedgerHeader> loadByHash(Database& db, Hash const& hash);
 std::shared_ptr<LedgerHeader> loadBySequence(Database& db, soci::session& sess,
                                              uint32_t seq);
 
-void deleteOldEntries(Database& db, uint32_t ledgerSeq, uint32_t count);
+// Oldest ledger number in ledgerheaders, or 0 if it is empty
+uint32_t getOldestLedgerSeq(soci::session& sess);
+
+void deleteOldEntries(soci::session& sess, uint32_t ledgerSeq, uint32_t count);
 void deleteNewerEntries(Database& db, uint32_t ledgerSeq);
 
 size_t copyToStream(Database& db, soci::session& sess, uint32_t ledgerSeq,
@@ -7,14 +7,56 @@
 #include "catchup/CatchupManager.h"
 #include "history/HistoryManager.h"
 #include "ledger/NetworkConfig.h"
+#include "util/NonCopyable.h"
 #include <memory>
 
+namespace medida
+{
+class Timer;
+}
+
+namespace soci
+{
+class session;
+}
+
 namespace stellar
 {
 
+class ApplicableTxSetFrame;
 class LedgerCloseData;
 class Database;
 class SorobanMetrics;
+class ContractCodeCache;
+class SorobanContractProfiler;
+
+// Immutable copy of the Soroban network config, shared with readers on other
+// threads (e.g. overlay). A new one is published whenever the config changes;
+// the eviction iterator in it is not kept current.
+struct SorobanNetworkConfigSnapshot
+{
+    // Ledger at which the config last changed
+    uint32_t mLedgerSeq;
+    SorobanNetworkConfig mConfig;
+};
+
+// While alive, LedgerManager::getSorobanNetworkConfig returns the config of
+// the snapshot on the thread that created this, so that code reading the
+// config through LedgerManager (e.g. TransactionFrame::checkValid) can run on
+// worker threads.
+class ScopedSorobanNetworkConfig : public NonMovableOrCopyable
+{
+    std::shared_ptr<SorobanNetworkConfigSnapshot const> const mSnapshot;
+    SorobanNetworkConfig const* const mPrevious;
+
+  public:
+    explicit ScopedSorobanNetworkConfig(
+        std::shared_ptr<SorobanNetworkConfigSnapshot const> snapshot);
+    ~ScopedSorobanNetworkConfig();
+
+    // The config set on this thread, if any
+    static SorobanNetworkConfig const* current();
+};
 
 /**
  * LedgerManager maintains, in memory, a logical pair of ledgers:
@@ -130,6 +172,9 @@ class LedgerManager
     // used most of the time.
     virtual SorobanNetworkConfig const& getSorobanNetworkConfig() = 0;
     virtual bool hasSorobanNetworkConfig() const = 0;
+    // Thread-safe. Returns nullptr before the config is first loaded.
+    virtual std::shared_ptr<SorobanNetworkConfigSnapshot const>
+    getSorobanNetworkConfigSnapshot() const = 0;
 
 #ifdef BUILD_TESTS
     virtual SorobanNetworkConfig& getMutableSorobanNetworkConfig() = 0;
@@ -178,9 +223,40 @@ class LedgerManager
     // permit testing.
     virtual void closeLedger(LedgerCloseData const& ledgerData) = 0;
 
+    // Closes the ledger after the LCL by applying the ledger entry changes
+    // recorded in its meta `lcm` instead of its transactions, and throws if
+    // the resulting ledger does not have the hash recorded in `lcm`. Used to
+    // replay a node's own debug meta quickly; meta is not emitted for these
+    // ledgers.
+    virtual void closeLedgerFromMeta(LedgerCloseMeta const& lcm) = 0;
+
+    // Between these calls closeLedger skips the housekeeping it does after
+    // each commit (bucket GC, publish status, WAL checkpoint), and ending the
+    // batch does it once. Used to apply runs of buffered ledgers back to back
+    // when catching up.
+    virtual void beginLedgerCloseBatch() = 0;
+    virtual void endLedgerCloseBatch() = 0;
+
+    // Schedules background loads of the ledger entries that applying txSet
+    // on top of the last closed ledger will read, so that they are already in
+    // memory if txSet externalizes. This is a best effort hint that does not
+    // affect the result of applying txSet. No-op unless BucketListDB and its
+    // entry cache are enabled.
+    virtual void prefetchTxSetAsync(ApplicableTxSetFrame const& txSet) = 0;
+
+    // Verifies the signatures of txSet on a background thread, so that the
+    // signature verification cache already has them if txSet externalizes.
+    // Like prefetchTxSetAsync, a best effort hint.
+    virtual void
+    verifyTxSetSignaturesAsync(ApplicableTxSetFrame const& txSet) = 0;
+
     // deletes old entries stored in the database
     virtual void deleteOldEntries(Database& db, uint32_t ledgerSeq,
                                   uint32_t count) = 0;
+    // Same, in a transaction of `sess`, which may be a session of the
+    // database pool used off the main thread
+    virtual void deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                                  uint32_t count) = 0;
 
     // cleans historical data newer than ledgerSeq
     // as this is used when applying buckets, the data is deleted such that:
@@ -194,6 +270,13 @@ class LedgerManager
     virtual void manuallyAdvanceLedgerHeader(LedgerHeader const& header) = 0;
 
     virtual SorobanMetrics& getSorobanMetrics() = 0;
+    virtual ContractCodeCache& getContractCodeCache() = 0;
+    virtual SorobanContractProfiler& getSorobanContractProfiler() = 0;
+    // Times applying operations of the given type
+    virtual medida::Timer& getOperationApplyTimer(OperationType type) = 0;
+    // Returns where the time of closing each of the last `limit` ledgers
+    // closed by closeLedger went, by ledger sequence number
+    virtual Json::Value getJsonCloseTimingInfo(size_t limit) const = 0;
 
     virtual ~LedgerManager()
     {
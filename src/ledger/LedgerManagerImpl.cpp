@@ -5,6 +5,7 @@
 #include "ledger/LedgerManagerImpl.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
 #include "catchup/AssumeStateWork.h"
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
@@ -15,18 +16,22 @@
 #include "herder/HerderPersistence.h"
 #include "herder/LedgerCloseData.h"
 #include "herder/TxSetFrame.h"
+#include "herder/TxSetUtils.h"
 #include "herder/Upgrades.h"
 #include "history/HistoryManager.h"
+#include "invariant/InvariantManager.h"
 #include "ledger/FlushAndRotateMetaDebugWork.h"
 #include "ledger/LedgerHeaderUtils.h"
 #include "ledger/LedgerRange.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/LedgerTypeUtils.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "main/ErrorMessages.h"
 #include "overlay/OverlayManager.h"
+#include "transactions/InvokeHostFunctionOpFrame.h"
 #include "transactions/OperationFrame.h"
 #include "transactions/TransactionFrameBase.h"
 #include "transactions/TransactionMetaFrame.h"
@@ -37,7 +42,10 @@
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/MetaUtils.h"
+#include "util/ParallelFor.h"
 #include "util/ProtocolVersion.h"
+#include "util/UnorderedSet.h"
 #include "util/XDRCereal.h"
 #include "util/XDROperators.h"
 #include "util/XDRStream.h"
@@ -54,9 +62,12 @@
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <mutex>
 #include <numeric>
 #include <regex>
 #include <sstream>
@@ -85,6 +96,74 @@ using namespace std;
 namespace stellar
 {
 
+namespace
+{
+// Soroban PRNG seed of the n-th transaction applied with seed, or of the n-th
+// operation of a transaction applied with seed
+Hash
+subSeed(Hash const& seed, uint64_t n)
+{
+    return xdrSha256(seed, n);
+}
+
+// Applies the changes to ledger entries recorded in meta, in order
+void
+applyLedgerEntryChanges(AbstractLedgerTxn& ltx,
+                        LedgerEntryChanges const& changes)
+{
+    for (auto const& change : changes)
+    {
+        switch (change.type())
+        {
+        case LEDGER_ENTRY_CREATED:
+            ltx.create(change.created());
+            break;
+        case LEDGER_ENTRY_UPDATED:
+        {
+            auto entry = ltx.load(LedgerEntryKey(change.updated()));
+            if (!entry)
+            {
+                throw std::runtime_error("meta updates a missing entry");
+            }
+            entry.current() = change.updated();
+            break;
+        }
+        case LEDGER_ENTRY_REMOVED:
+            ltx.erase(change.removed());
+            break;
+        case LEDGER_ENTRY_STATE:
+            break;
+        }
+    }
+}
+
+// Adds the real time from its construction to its destruction to a total
+class CloseTimeScope
+{
+    std::chrono::nanoseconds& mTotal;
+    std::chrono::steady_clock::time_point const mStart;
+
+  public:
+    explicit CloseTimeScope(std::chrono::nanoseconds& total)
+        : mTotal(total), mStart(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~CloseTimeScope()
+    {
+        mTotal += std::chrono::steady_clock::now() - mStart;
+    }
+};
+
+double
+toMilliseconds(std::chrono::nanoseconds d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+}
+
+size_t const LedgerManagerImpl::MAX_CLOSE_TIMINGS = 100;
+
 const uint32_t LedgerManager::GENESIS_LEDGER_SEQ = 1;
 const uint32_t LedgerManager::GENESIS_LEDGER_VERSION = 0;
 const uint32_t LedgerManager::GENESIS_LEDGER_BASE_FEE = 100;
@@ -127,6 +206,7 @@ LedgerManager::ledgerAbbrev(LedgerHeaderHistoryEntry const& he)
 LedgerManagerImpl::LedgerManagerImpl(Application& app)
     : mApp(app)
     , mSorobanMetrics(app.getMetrics())
+    , mContractCodeCache(app.getMetrics())
     , mTransactionApply(
           app.getMetrics().NewTimer({"ledger", "transaction", "apply"}))
     , mTransactionCount(
@@ -136,6 +216,11 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
     , mPrefetchHitRate(
           app.getMetrics().NewHistogram({"ledger", "prefetch", "hit-rate"}))
     , mLedgerClose(app.getMetrics().NewTimer({"ledger", "ledger", "close"}))
+    , mLedgerCloseFeesSeqNums(
+          app.getMetrics().NewTimer({"ledger", "close", "fees-seqnums"}))
+    , mLedgerCloseApply(app.getMetrics().NewTimer({"ledger", "close", "apply"}))
+    , mLedgerCloseCommit(
+          app.getMetrics().NewTimer({"ledger", "close", "commit"}))
     , mLedgerAgeClosed(app.getMetrics().NewBuckets(
           {"ledger", "age", "closed"}, {5000.0, 7000.0, 10000.0, 20000.0}))
     , mLedgerAge(
@@ -144,6 +229,8 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
           app.getMetrics().NewCounter({"ledger", "apply", "success"}))
     , mTransactionApplyFailed(
           app.getMetrics().NewCounter({"ledger", "apply", "failure"}))
+    , mTransactionApplyTrusted(app.getMetrics().NewCounter(
+          {"ledger", "apply", "trusted-signatures"}))
     , mSorobanTransactionApplySucceeded(
           app.getMetrics().NewCounter({"ledger", "apply-soroban", "success"}))
     , mSorobanTransactionApplyFailed(
@@ -152,6 +239,14 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
           app.getMetrics().NewMeter({"ledger", "metastream", "bytes"}, "byte"))
     , mMetaStreamWriteTime(
           app.getMetrics().NewTimer({"ledger", "metastream", "write"}))
+    , mMetaStreamWaitTime(
+          app.getMetrics().NewTimer({"ledger", "metastream", "wait"}))
+    , mMetaStreamLedgerSize(app.getMetrics().NewHistogram(
+          {"ledger", "metastream", "ledger-size"}))
+    , mMetaStreamEmitTime(
+          app.getMetrics().NewTimer({"ledger", "metastream", "emit"}))
+    , mMetaStreamQueueDepth(
+          app.getMetrics().NewCounter({"ledger", "metastream", "queue-depth"}))
     , mLastClose(mApp.getClock().now())
     , mCatchupDuration(
           app.getMetrics().NewTimer({"ledger", "catchup", "duration"}))
@@ -159,6 +254,22 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
 
 {
     setupLedgerCloseMetaStream();
+
+    for (auto t : xdr::xdr_traits<OperationType>::enum_values())
+    {
+        auto type = static_cast<OperationType>(t);
+        std::string label = xdr::xdr_traits<OperationType>::enum_name(type);
+        for (auto& c : label)
+        {
+            c = c == '_' ? '-' : static_cast<char>(std::tolower(c));
+        }
+        if (mOperationApplyTimers.size() <= static_cast<size_t>(t))
+        {
+            mOperationApplyTimers.resize(t + 1, nullptr);
+        }
+        mOperationApplyTimers[t] = &app.getMetrics().NewTimer(
+            {"ledger", "operation-apply", label});
+    }
 }
 
 void
@@ -554,9 +665,37 @@ LedgerManagerImpl::getSorobanNetworkConfigInternal()
     return *mSorobanNetworkConfig;
 }
 
+namespace
+{
+thread_local SorobanNetworkConfig const* gScopedSorobanNetworkConfig{nullptr};
+}
+
+ScopedSorobanNetworkConfig::ScopedSorobanNetworkConfig(
+    std::shared_ptr<SorobanNetworkConfigSnapshot const> snapshot)
+    : mSnapshot(std::move(snapshot)), mPrevious(gScopedSorobanNetworkConfig)
+{
+    releaseAssert(mSnapshot);
+    gScopedSorobanNetworkConfig = &mSnapshot->mConfig;
+}
+
+ScopedSorobanNetworkConfig::~ScopedSorobanNetworkConfig()
+{
+    gScopedSorobanNetworkConfig = mPrevious;
+}
+
+SorobanNetworkConfig const*
+ScopedSorobanNetworkConfig::current()
+{
+    return gScopedSorobanNetworkConfig;
+}
+
 SorobanNetworkConfig const&
 LedgerManagerImpl::getSorobanNetworkConfig()
 {
+    if (auto scoped = ScopedSorobanNetworkConfig::current())
+    {
+        return *scoped;
+    }
     return getSorobanNetworkConfigInternal();
 }
 
@@ -566,10 +705,31 @@ LedgerManagerImpl::hasSorobanNetworkConfig() const
     return mSorobanNetworkConfig.has_value();
 }
 
+std::shared_ptr<SorobanNetworkConfigSnapshot const>
+LedgerManagerImpl::getSorobanNetworkConfigSnapshot() const
+{
+    std::lock_guard<std::mutex> guard(mSorobanNetworkConfigSnapshotMutex);
+    return mSorobanNetworkConfigSnapshot;
+}
+
+void
+LedgerManagerImpl::publishSorobanNetworkConfigSnapshot(uint32_t ledgerSeq)
+{
+    ZoneScoped;
+    auto snapshot = std::make_shared<SorobanNetworkConfigSnapshot const>(
+        SorobanNetworkConfigSnapshot{ledgerSeq,
+                                     getSorobanNetworkConfigInternal()});
+    std::lock_guard<std::mutex> guard(mSorobanNetworkConfigSnapshotMutex);
+    mSorobanNetworkConfigSnapshot = std::move(snapshot);
+}
+
 #ifdef BUILD_TESTS
 SorobanNetworkConfig&
 LedgerManagerImpl::getMutableSorobanNetworkConfig()
 {
+    // The caller may change the config so that it no longer matches the
+    // ledger, or write it to the ledger
+    mReloadSorobanNetworkConfig = true;
     return getSorobanNetworkConfigInternal();
 }
 #endif
@@ -580,6 +740,51 @@ LedgerManagerImpl::getSorobanMetrics()
     return mSorobanMetrics;
 }
 
+ContractCodeCache&
+LedgerManagerImpl::getContractCodeCache()
+{
+    return mContractCodeCache;
+}
+
+SorobanContractProfiler&
+LedgerManagerImpl::getSorobanContractProfiler()
+{
+    return mSorobanContractProfiler;
+}
+
+medida::Timer&
+LedgerManagerImpl::getOperationApplyTimer(OperationType type)
+{
+    auto timer = mOperationApplyTimers.at(static_cast<size_t>(type));
+    releaseAssert(timer);
+    return *timer;
+}
+
+Json::Value
+LedgerManagerImpl::getJsonCloseTimingInfo(size_t limit) const
+{
+    Json::Value ret(Json::objectValue);
+    for (auto it = mCloseTimings.rbegin();
+         it != mCloseTimings.rend() && limit > 0; ++it, --limit)
+    {
+        auto& t = ret[std::to_string(it->mLedgerSeq)];
+        t["txs"] = static_cast<Json::UInt64>(it->mTxCount);
+        t["ops"] = static_cast<Json::UInt64>(it->mOpCount);
+        t["total_ms"] = toMilliseconds(it->mTotal);
+        t["prepare_ms"] = toMilliseconds(it->mPrepare);
+        t["fees_seqnums_ms"] = toMilliseconds(it->mFeesSeqNums);
+        t["classic_apply_ms"] = toMilliseconds(it->mClassicApply);
+        t["soroban_apply_ms"] = toMilliseconds(it->mSorobanApply);
+        t["invariants_ms"] = toMilliseconds(it->mInvariants);
+        t["commit_ms"] = toMilliseconds(it->mCommit);
+        t["add_batch_ms"] = toMilliseconds(it->mAddBatch);
+        t["merge_wait_ms"] = toMilliseconds(it->mMergeWait);
+        t["meta_ms"] = toMilliseconds(it->mMeta);
+        t["history_ms"] = toMilliseconds(it->mHistory);
+    }
+    return ret;
+}
+
 void
 LedgerManagerImpl::publishSorobanMetrics()
 {
@@ -758,27 +963,116 @@ LedgerManagerImpl::emitNextMeta()
     ZoneScoped;
 
     releaseAssert(mNextMetaToEmit);
-    releaseAssert(mMetaStream || mMetaDebugStream);
+    releaseAssert(mMetaStream || mMetaRingBuffer || mMetaDebugStream);
+    auto const& cfg = mApp.getConfig();
+    if (!cfg.EXPERIMENTAL_BACKGROUND_META_EMISSION)
+    {
+        writeMeta(*mNextMetaToEmit, std::chrono::steady_clock::now());
+        mNextMetaToEmit.reset();
+        return;
+    }
+
+    // Make room for this ledger's meta in the queue
+    size_t const maxQueued = cfg.METADATA_OUTPUT_QUEUE_LEDGERS;
+    waitForPendingMetaWrites(maxQueued);
+    if (mPendingMetaWrites.size() >= maxQueued)
+    {
+        if (cfg.METADATA_OUTPUT_QUEUE_FULL_ERROR)
+        {
+            throw std::runtime_error(
+                fmt::format(FMT_STRING("Meta stream is {} ledgers behind, "
+                                       "METADATA_OUTPUT_QUEUE_LEDGERS is full"),
+                            mPendingMetaWrites.size()));
+        }
+        waitForPendingMetaWrites(maxQueued - 1);
+    }
+    // Real time rather than the app clock, which is not safe to read from the
+    // meta thread
+    auto emitStart = std::chrono::steady_clock::now();
+
+    // The task owns the meta, so the next ledger can be applied (and its
+    // meta built) while this one is written
+    std::shared_ptr<LedgerCloseMetaFrame const> meta =
+        std::move(mNextMetaToEmit);
+    using task_t = std::packaged_task<void()>;
+    auto task = std::make_shared<task_t>([this, meta, emitStart]() {
+        writeMeta(*meta, emitStart);
+        mMetaStreamQueueDepth.dec();
+    });
+    mPendingMetaWrites.emplace_back(task->get_future());
+    mMetaStreamQueueDepth.inc();
+    mApp.postOnMetaThread([task]() { (*task)(); }, "emitNextMeta");
+}
+
+void
+LedgerManagerImpl::writeMeta(LedgerCloseMetaFrame const& meta,
+                             std::chrono::steady_clock::time_point emitStart)
+{
+    ZoneScoped;
     auto timer = LogSlowExecution("MetaStream write",
                                   LogSlowExecution::Mode::AUTOMATIC_RAII,
                                   "took", std::chrono::milliseconds(100));
     auto streamWrite = mMetaStreamWriteTime.TimeScope();
+    // Serialize once for both streams
+    size_t const size =
+        XDROutputFileStream::serializeRecord(meta.getXDR(), mMetaBuf);
+    mMetaStreamLedgerSize.Update(size);
+    char const* streamData = mMetaBuf.data();
+    size_t streamSize = size;
+    if (mMetaFilter && (mMetaStream || mMetaRingBuffer))
+    {
+        LedgerCloseMeta filtered = meta.getXDR();
+        filterMeta(filtered, *mMetaFilter);
+        streamSize =
+            XDROutputFileStream::serializeRecord(filtered, mFilteredMetaBuf);
+        streamData = mFilteredMetaBuf.data();
+    }
     if (mMetaStream)
     {
-        size_t written = 0;
-        mMetaStream->writeOne(mNextMetaToEmit->getXDR(), nullptr, &written);
+        mMetaStream->writeSerialized(streamData, streamSize);
         mMetaStream->flush();
-        mMetaStreamBytes.Mark(written);
+        mMetaStreamBytes.Mark(streamSize);
+    }
+    if (mMetaRingBuffer)
+    {
+        mMetaRingBuffer->writeSerialized(streamData, streamSize);
+        mMetaStreamBytes.Mark(streamSize);
     }
     if (mMetaDebugStream)
     {
-        mMetaDebugStream->writeOne(mNextMetaToEmit->getXDR());
+        mMetaDebugStream->writeSerialized(mMetaBuf.data(), size);
         // Flush debug meta in case there's a crash later in commit (in which
         // case we'd lose the data in internal buffers). This way we preserve
         // the meta for problematic ledgers that is vital for diagnostics.
         mMetaDebugStream->flush();
     }
-    mNextMetaToEmit.reset();
+    mMetaStreamEmitTime.Update(std::chrono::steady_clock::now() - emitStart);
+}
+
+void
+LedgerManagerImpl::waitForPendingMetaWrites(size_t maxPending)
+{
+    ZoneScoped;
+    // Writes finish in order on the single meta thread, so only the front of
+    // the queue needs checking
+    while (!mPendingMetaWrites.empty())
+    {
+        auto& front = mPendingMetaWrites.front();
+        if (front.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+        {
+            if (mPendingMetaWrites.size() <= maxPending)
+            {
+                return;
+            }
+            auto waitTime = mMetaStreamWaitTime.TimeScope();
+            front.wait();
+        }
+        // Pop before get() so that a failed write isn't collected twice
+        auto write = std::move(front);
+        mPendingMetaWrites.pop_front();
+        write.get();
+    }
 }
 
 /*
@@ -806,6 +1100,10 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
 
     ZoneValue(static_cast<int64_t>(header.current().ledgerSeq));
 
+    auto closeStart = std::chrono::steady_clock::now();
+    mCloseTiming = CloseTiming{};
+    mCloseTiming.mLedgerSeq = header.current().ledgerSeq;
+
     auto now = mApp.getClock().now();
     mLedgerAgeClosed.Update(now - mLastClose);
     mLastClose = now;
@@ -855,6 +1153,7 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     header.current().scpValue = sv;
 
     maybeResetLedgerCloseMetaDebugStream(header.current().ledgerSeq);
+    auto prepareStart = std::chrono::steady_clock::now();
     auto applicableTxSet = txSet->prepareForApply(mApp);
 
     if (applicableTxSet == nullptr)
@@ -867,18 +1166,23 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
         CLOG_ERROR(Ledger, "{}", POSSIBLY_CORRUPTED_QUORUM_SET);
         throw std::runtime_error("transaction set cannot be processed");
     }
+    // The fees of every transaction are needed both for fee processing and
+    // for apply
+    applicableTxSet->prepareApplyFees(mApp, header.current());
+    mCloseTiming.mPrepare = std::chrono::steady_clock::now() - prepareStart;
 
     // In addition to the _canonical_ LedgerResultSet hashed into the
     // LedgerHeader, we optionally collect an even-more-fine-grained record of
     // the ledger entries modified by each tx during tx processing in a
     // LedgerCloseMeta, for streaming to attached clients (typically: horizon).
     std::unique_ptr<LedgerCloseMetaFrame> ledgerCloseMeta;
-    if (mMetaStream || mMetaDebugStream)
+    if (mMetaStream || mMetaRingBuffer || mMetaDebugStream)
     {
         if (mNextMetaToEmit)
         {
             releaseAssert(mNextMetaToEmit->ledgerHeader().hash ==
                           getLastClosedLedgerHeader().hash);
+            CloseTimeScope metaTime(mCloseTiming.mMeta);
             emitNextMeta();
         }
         releaseAssert(!mNextMetaToEmit);
@@ -897,13 +1201,45 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     std::vector<TransactionFrameBasePtr> const txs =
         applicableTxSet->getTxsInApplyOrder();
 
+    // Transactions the trusted results record as successful had valid
+    // signatures, so replay need not verify them again; the ledger hash
+    // check after apply still catches any disagreement
+    if (ledgerData.getExpectedResults())
+    {
+        UnorderedSet<Hash> succeeded;
+        for (auto const& res : ledgerData.getExpectedResults()->results)
+        {
+            auto code = res.result.result.code();
+            if (code == txSUCCESS || code == txFEE_BUMP_INNER_SUCCESS)
+            {
+                succeeded.emplace(res.transactionHash);
+            }
+        }
+        for (auto const& tx : txs)
+        {
+            if (succeeded.find(tx->getContentsHash()) != succeeded.end())
+            {
+                tx->setSignaturesTrusted();
+                mTransactionApplyTrusted.inc();
+            }
+        }
+    }
+
     // first, prefetch source accounts for txset, then charge fees
-    prefetchTxSourceIds(txs);
-    processFeesSeqNums(txs, ltx, *applicableTxSet, ledgerCloseMeta);
+    {
+        auto feesTime = mLedgerCloseFeesSeqNums.TimeScope();
+        CloseTimeScope feesCloseTime(mCloseTiming.mFeesSeqNums);
+        prefetchTxSourceIds(txs);
+        processFeesSeqNums(txs, ltx, *applicableTxSet, ledgerCloseMeta);
+    }
 
     TransactionResultSet txResultSet;
     txResultSet.results.reserve(txs.size());
-    applyTransactions(*applicableTxSet, txs, ltx, txResultSet, ledgerCloseMeta);
+    {
+        auto applyTime = mLedgerCloseApply.TimeScope();
+        applyTransactions(*applicableTxSet, txs, ltx, txResultSet,
+                          ledgerCloseMeta);
+    }
     if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
     {
         storeTxSet(mApp.getDatabase(), ltx.loadHeader().current().ledgerSeq,
@@ -961,6 +1297,7 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
                                               static_cast<int>(i + 1));
             }
             ltxUpgrade.commit();
+            mReloadSorobanNetworkConfig = true;
         }
         catch (std::runtime_error& e)
         {
@@ -973,7 +1310,11 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     }
     auto maybeNewVersion = ltx.loadHeader().current().ledgerVersion;
     auto ledgerSeq = ltx.loadHeader().current().ledgerSeq;
-    if (protocolVersionStartsFrom(maybeNewVersion, SOROBAN_PROTOCOL_VERSION))
+    // CONFIG_SETTING entries only change through upgrades, besides the ones
+    // kept in sync in memory (the bucket list size window and the eviction
+    // iterator), so the config doesn't need reloading on other ledgers
+    if (protocolVersionStartsFrom(maybeNewVersion, SOROBAN_PROTOCOL_VERSION) &&
+        (!mSorobanNetworkConfig || mReloadSorobanNetworkConfig))
     {
         updateNetworkConfig(ltx);
     }
@@ -986,7 +1327,7 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
         throw std::runtime_error("Local node's ledger corrupted during close");
     }
 
-    if (mMetaStream || mMetaDebugStream)
+    if (mMetaStream || mMetaRingBuffer || mMetaDebugStream)
     {
         releaseAssert(ledgerCloseMeta);
         ledgerCloseMeta->ledgerHeader() = mLastClosedLedger;
@@ -1001,10 +1342,208 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
         if (!mApp.getConfig().EXPERIMENTAL_PRECAUTION_DELAY_META ||
             ledgerData.getExpectedHash())
         {
+            CloseTimeScope metaTime(mCloseTiming.mMeta);
             emitNextMeta();
         }
     }
 
+    commitClosedLedger(ltx, initialLedgerVers, ledgerSeq);
+
+    mCloseTiming.mTotal = std::chrono::steady_clock::now() - closeStart;
+    mCloseTimings.emplace_back(mCloseTiming);
+    if (mCloseTimings.size() > MAX_CLOSE_TIMINGS)
+    {
+        mCloseTimings.pop_front();
+    }
+
+    if (!mApp.getConfig().OP_APPLY_SLEEP_TIME_WEIGHT_FOR_TESTING.empty())
+    {
+        // Sleep for a parameterized amount of time in simulation mode
+        std::discrete_distribution<uint32> distribution(
+            mApp.getConfig().OP_APPLY_SLEEP_TIME_WEIGHT_FOR_TESTING.begin(),
+            mApp.getConfig().OP_APPLY_SLEEP_TIME_WEIGHT_FOR_TESTING.end());
+        std::chrono::microseconds sleepFor{0};
+        auto txSetSizeOp = applicableTxSet->sizeOpTotal();
+        for (size_t i = 0; i < txSetSizeOp; i++)
+        {
+            sleepFor +=
+                mApp.getConfig()
+                    .OP_APPLY_SLEEP_TIME_DURATION_FOR_TESTING[distribution(
+                        gRandomEngine)];
+        }
+        std::chrono::microseconds applicationTime =
+            closeLedgerTime.checkElapsedTime();
+        if (applicationTime < sleepFor)
+        {
+            sleepFor -= applicationTime;
+            CLOG_DEBUG(Perf, "Simulate application: sleep for {} microseconds",
+                       sleepFor.count());
+            std::this_thread::sleep_for(sleepFor);
+        }
+    }
+
+    std::chrono::duration<double> ledgerTimeSeconds = ledgerTime.Stop();
+    CLOG_DEBUG(Perf, "Applied ledger in {} seconds", ledgerTimeSeconds.count());
+    FrameMark;
+}
+
+void
+LedgerManagerImpl::closeLedgerFromMeta(LedgerCloseMeta const& lcm)
+{
+    ZoneScoped;
+    auto ledgerTime = mLedgerClose.TimeScope();
+
+    auto const& lhe =
+        lcm.v() == 0 ? lcm.v0().ledgerHeader : lcm.v1().ledgerHeader;
+    if (lhe.header.ledgerSeq != getLastClosedLedgerNum() + 1 ||
+        lhe.header.previousLedgerHash != mLastClosedLedger.hash)
+    {
+        CLOG_ERROR(Ledger, "Meta of ledger {} does not follow LCL {}",
+                   ledgerAbbrev(lhe), ledgerAbbrev(mLastClosedLedger));
+        throw std::runtime_error("meta does not follow LCL");
+    }
+    if (lhe.header.ledgerVersion > mApp.getConfig().LEDGER_PROTOCOL_VERSION)
+    {
+        CLOG_ERROR(Ledger, "Unknown ledger version: {}",
+                   lhe.header.ledgerVersion);
+        CLOG_ERROR(Ledger, "{}", UPGRADE_STELLAR_CORE);
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("cannot apply ledger with not supported version: {:d}"),
+            lhe.header.ledgerVersion));
+    }
+    if (mNextMetaToEmit)
+    {
+        emitNextMeta();
+    }
+
+    LedgerTxn ltx(mApp.getLedgerTxnRoot());
+    auto initialLedgerVers = ltx.loadHeader().current().ledgerVersion;
+    // The header recorded in the meta already has the outcome of the
+    // transactions and upgrades; only its bucket list hash is recomputed when
+    // the ledger is sealed, which makes the ledger hash check below a check
+    // of the state the changes lead to
+    ltx.loadHeader().current() = lhe.header;
+
+    TxSetXDRFrameConstPtr txSet =
+        lcm.v() == 0 ? TxSetXDRFrame::makeFromWire(lcm.v0().txSet)
+                     : TxSetXDRFrame::makeFromWire(lcm.v1().txSet);
+    auto const& txProcessing =
+        lcm.v() == 0 ? lcm.v0().txProcessing : lcm.v1().txProcessing;
+    auto const& upgrades = lcm.v() == 0 ? lcm.v0().upgradesProcessing
+                                        : lcm.v1().upgradesProcessing;
+
+    // Fees of all the transactions are charged before any of them is applied,
+    // as in closeLedger
+    for (auto const& trm : txProcessing)
+    {
+        applyLedgerEntryChanges(ltx, trm.feeProcessing);
+    }
+    for (auto const& trm : txProcessing)
+    {
+        auto const& tm = trm.txApplyProcessing;
+        switch (tm.v())
+        {
+        case 0:
+            for (auto const& om : tm.operations())
+            {
+                applyLedgerEntryChanges(ltx, om.changes);
+            }
+            break;
+        case 1:
+            applyLedgerEntryChanges(ltx, tm.v1().txChanges);
+            for (auto const& om : tm.v1().operations)
+            {
+                applyLedgerEntryChanges(ltx, om.changes);
+            }
+            break;
+        case 2:
+            applyLedgerEntryChanges(ltx, tm.v2().txChangesBefore);
+            for (auto const& om : tm.v2().operations)
+            {
+                applyLedgerEntryChanges(ltx, om.changes);
+            }
+            applyLedgerEntryChanges(ltx, tm.v2().txChangesAfter);
+            break;
+        case 3:
+            applyLedgerEntryChanges(ltx, tm.v3().txChangesBefore);
+            for (auto const& om : tm.v3().operations)
+            {
+                applyLedgerEntryChanges(ltx, om.changes);
+            }
+            applyLedgerEntryChanges(ltx, tm.v3().txChangesAfter);
+            break;
+        default:
+            throw std::runtime_error("unknown transaction meta version");
+        }
+    }
+    for (auto const& uem : upgrades)
+    {
+        applyLedgerEntryChanges(ltx, uem.changes);
+        mReloadSorobanNetworkConfig = true;
+    }
+
+    auto ledgerSeq = lhe.header.ledgerSeq;
+    if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
+    {
+        storeTxSet(mApp.getDatabase(), ledgerSeq, *txSet);
+        // The transactions are only needed for their history rows, in the
+        // order of the meta
+        auto applicableTxSet = txSet->prepareForApply(mApp);
+        if (!applicableTxSet)
+        {
+            throw std::runtime_error("transaction set cannot be processed");
+        }
+        auto txs = applicableTxSet->getTxsInApplyOrder();
+        releaseAssert(txs.size() == txProcessing.size());
+        TransactionHistoryWriter historyWriter(mApp.getDatabase(),
+                                               mApp.getConfig(), ledgerSeq);
+        TransactionResultSet txResultSet;
+        for (size_t i = 0; i < txs.size(); ++i)
+        {
+            historyWriter.addTransactionFee(txs[i],
+                                            txProcessing[i].feeProcessing,
+                                            static_cast<uint32_t>(i + 1));
+            txResultSet.results.emplace_back(txProcessing[i].result);
+            historyWriter.addTransaction(
+                txs[i], txProcessing[i].txApplyProcessing, txResultSet);
+        }
+        historyWriter.flush();
+        for (size_t i = 0; i < upgrades.size(); ++i)
+        {
+            Upgrades::storeUpgradeHistory(getDatabase(), ledgerSeq,
+                                          upgrades[i].upgrade,
+                                          upgrades[i].changes,
+                                          static_cast<int>(i + 1));
+        }
+    }
+
+    if (protocolVersionStartsFrom(lhe.header.ledgerVersion,
+                                  SOROBAN_PROTOCOL_VERSION) &&
+        (!mSorobanNetworkConfig || mReloadSorobanNetworkConfig))
+    {
+        updateNetworkConfig(ltx);
+    }
+
+    ledgerClosed(ltx, nullptr, initialLedgerVers);
+    if (mLastClosedLedger.hash != lhe.hash)
+    {
+        CLOG_ERROR(Ledger, "Applying meta led to {}, meta reports {}",
+                   ledgerAbbrev(mLastClosedLedger), ledgerAbbrev(lhe));
+        CLOG_ERROR(Ledger, "{}", POSSIBLY_CORRUPTED_LOCAL_DATA);
+        throw std::runtime_error("Local node's ledger disagrees with meta");
+    }
+
+    commitClosedLedger(ltx, initialLedgerVers, ledgerSeq);
+    CLOG_DEBUG(Perf, "Applied meta of ledger {} in {} seconds", ledgerSeq,
+               std::chrono::duration<double>(ledgerTime.Stop()).count());
+}
+
+void
+LedgerManagerImpl::commitClosedLedger(LedgerTxn& ltx,
+                                      uint32_t initialLedgerVers,
+                                      uint32_t ledgerSeq)
+{
+    ZoneScoped;
     // The next 5 steps happen in a relatively non-obvious, subtle order.
     // This is unfortunate and it would be nice if we could make it not
     // be so subtle, but for the time being this is where we are.
@@ -1028,10 +1567,17 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
 
     // step 1
     auto& hm = mApp.getHistoryManager();
-    hm.maybeQueueHistoryCheckpoint();
+    {
+        CloseTimeScope historyTime(mCloseTiming.mHistory);
+        hm.maybeQueueHistoryCheckpoint();
+    }
 
     // step 2
-    ltx.commit();
+    {
+        auto commitTime = mLedgerCloseCommit.TimeScope();
+        CloseTimeScope commitCloseTime(mCloseTiming.mCommit);
+        ltx.commit();
+    }
 
     // step 3
     if (protocolVersionStartsFrom(initialLedgerVers,
@@ -1042,41 +1588,44 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     }
 
     // step 4
-    hm.publishQueuedHistory();
-    hm.logAndUpdatePublishStatus();
-
-    // step 5
-    mApp.getBucketManager().forgetUnreferencedBuckets();
+    {
+        CloseTimeScope historyTime(mCloseTiming.mHistory);
+        hm.publishQueuedHistory();
+    }
 
-    if (!mApp.getConfig().OP_APPLY_SLEEP_TIME_WEIGHT_FOR_TESTING.empty())
+    // step 5, deferred to the end of a batch as keeping buckets a little
+    // longer is harmless
+    if (!mInLedgerCloseBatch)
     {
-        // Sleep for a parameterized amount of time in simulation mode
-        std::discrete_distribution<uint32> distribution(
-            mApp.getConfig().OP_APPLY_SLEEP_TIME_WEIGHT_FOR_TESTING.begin(),
-            mApp.getConfig().OP_APPLY_SLEEP_TIME_WEIGHT_FOR_TESTING.end());
-        std::chrono::microseconds sleepFor{0};
-        auto txSetSizeOp = applicableTxSet->sizeOpTotal();
-        for (size_t i = 0; i < txSetSizeOp; i++)
-        {
-            sleepFor +=
-                mApp.getConfig()
-                    .OP_APPLY_SLEEP_TIME_DURATION_FOR_TESTING[distribution(
-                        gRandomEngine)];
-        }
-        std::chrono::microseconds applicationTime =
-            closeLedgerTime.checkElapsedTime();
-        if (applicationTime < sleepFor)
-        {
-            sleepFor -= applicationTime;
-            CLOG_DEBUG(Perf, "Simulate application: sleep for {} microseconds",
-                       sleepFor.count());
-            std::this_thread::sleep_for(sleepFor);
-        }
+        afterLedgerCommitHousekeeping();
     }
+}
 
-    std::chrono::duration<double> ledgerTimeSeconds = ledgerTime.Stop();
-    CLOG_DEBUG(Perf, "Applied ledger in {} seconds", ledgerTimeSeconds.count());
-    FrameMark;
+void
+LedgerManagerImpl::afterLedgerCommitHousekeeping()
+{
+    ZoneScoped;
+    mApp.getHistoryManager().logAndUpdatePublishStatus();
+    mApp.getBucketManager().forgetUnreferencedBuckets();
+
+    // Checkpoint the SQLite WAL until the next close, if commits don't
+    mApp.getDatabase().checkpointWALInBackground();
+}
+
+void
+LedgerManagerImpl::beginLedgerCloseBatch()
+{
+    releaseAssert(!mInLedgerCloseBatch);
+    mInLedgerCloseBatch = true;
+}
+
+void
+LedgerManagerImpl::endLedgerCloseBatch()
+{
+    ZoneScoped;
+    releaseAssert(mInLedgerCloseBatch);
+    mInLedgerCloseBatch = false;
+    afterLedgerCommitHousekeeping();
 }
 
 void
@@ -1084,13 +1633,21 @@ LedgerManagerImpl::deleteOldEntries(Database& db, uint32_t ledgerSeq,
                                     uint32_t count)
 {
     ZoneScoped;
-    soci::transaction txscope(db.getSession());
     db.clearPreparedStatementCache();
-    LedgerHeaderUtils::deleteOldEntries(db, ledgerSeq, count);
-    deleteOldTransactionHistoryEntries(db, ledgerSeq, count);
-    HerderPersistence::deleteOldEntries(db, ledgerSeq, count);
-    Upgrades::deleteOldEntries(db, ledgerSeq, count);
+    deleteOldEntries(db.getSession(), ledgerSeq, count);
     db.clearPreparedStatementCache();
+}
+
+void
+LedgerManagerImpl::deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                                    uint32_t count)
+{
+    ZoneScoped;
+    soci::transaction txscope(sess);
+    LedgerHeaderUtils::deleteOldEntries(sess, ledgerSeq, count);
+    deleteOldTransactionHistoryEntries(sess, ledgerSeq, count);
+    HerderPersistence::deleteOldEntries(sess, ledgerSeq, count);
+    Upgrades::deleteOldEntries(sess, ledgerSeq, count);
     txscope.commit();
 }
 
@@ -1152,12 +1709,31 @@ LedgerManagerImpl::setupLedgerCloseMetaStream()
 {
     ZoneScoped;
 
-    if (mMetaStream)
+    if (mMetaStream || mMetaRingBuffer)
     {
         throw std::runtime_error("LedgerManagerImpl already streaming");
     }
     auto& cfg = mApp.getConfig();
-    if (cfg.METADATA_OUTPUT_STREAM != "")
+    if (!cfg.METADATA_OUTPUT_FILTER.empty())
+    {
+        mMetaFilter =
+            std::make_unique<xdrquery::XDRMatcher>(cfg.METADATA_OUTPUT_FILTER);
+        // Field paths are checked on the first match, fail on a bad filter
+        // now rather than on the first ledger
+        mMetaFilter->matchXDR(LedgerEntry{});
+    }
+    std::regex shmrx("^shm:(.+)$");
+    std::smatch shm;
+    if (std::regex_match(cfg.METADATA_OUTPUT_STREAM, shm, shmrx))
+    {
+        uint64_t capacity =
+            uint64_t(cfg.METADATA_OUTPUT_RING_BUFFER_MB) * 1024 * 1024;
+        CLOG_INFO(Ledger, "Streaming metadata to ring buffer '{}' of {} MB",
+                  shm[1].str(), cfg.METADATA_OUTPUT_RING_BUFFER_MB);
+        mMetaRingBuffer =
+            std::make_unique<MetaRingBufferWriter>(shm[1].str(), capacity);
+    }
+    else if (cfg.METADATA_OUTPUT_STREAM != "")
     {
         // We can't be sure we're writing to a stream that supports fsync;
         // pipes typically error when you try. So we don't do it.
@@ -1196,34 +1772,24 @@ LedgerManagerImpl::maybeResetLedgerCloseMetaDebugStream(uint32_t ledgerSeq)
                 return;
             }
 
-            // If we have an open stream and there is already a flush-and-rotate
-            // work _running_ (measured by the existence of a shared_ptr at the
-            // end of the weak_ptr), we're in a slightly awkward position since
-            // we can't synchronously close the stream (that would fsync) and we
-            // can't asynchronously close the stream either (that would race
-            // against the running work that is presumably flushing-and-rotating
-            // the _previous_ stream). So we just skip an iteration of launching
-            // flush-and-rotate work, and try again on the next boundary.
-            auto existing = mFlushAndRotateMetaDebugWork.lock();
-            if (existing && !existing->isDone())
-            {
-                CLOG_DEBUG(Ledger,
-                           "Skipping flush-and-rotate of {} since work already "
-                           "running",
-                           mMetaDebugPath.string());
-                return;
-            }
-
-            // If we are resetting and already have a stream, hand it off to the
-            // flush-and-rotate work to finish up with.
+            // Hand the stream off to a flush-and-rotate work to finish up
+            // with, once meta queued for it is written. If the previous one is
+            // still running, the new one closes its stream right away but
+            // waits for it before compressing and trimming.
+            waitForPendingMetaWrites(0);
             mFlushAndRotateMetaDebugWork =
                 mApp.getWorkScheduler()
                     .scheduleWork<FlushAndRotateMetaDebugWork>(
                         mMetaDebugPath, std::move(mMetaDebugStream),
-                        mApp.getConfig().METADATA_DEBUG_LEDGERS);
+                        mApp.getConfig().METADATA_DEBUG_LEDGERS,
+                        mFlushAndRotateMetaDebugWork);
             mMetaDebugPath.clear();
         }
 
+        // The meta thread reads mMetaDebugStream, so nothing may be queued
+        // while it's set
+        waitForPendingMetaWrites(0);
+
         // From here on we're starting a new stream, whether it's the first
         // such stream or a replacement for the one we just handed off to
         // flush-and-rotate. Either way, we should not have an existing one!
@@ -1300,10 +1866,12 @@ LedgerManagerImpl::updateNetworkConfig(AbstractLedgerTxn& rootLtx)
     ZoneScoped;
 
     uint32_t ledgerVersion{};
+    uint32_t ledgerSeq{};
     {
         LedgerTxn ltx(rootLtx, false,
                       TransactionMode::READ_ONLY_WITHOUT_SQL_TXN);
         ledgerVersion = ltx.loadHeader().current().ledgerVersion;
+        ledgerSeq = ltx.loadHeader().current().ledgerSeq;
     }
 
     if (protocolVersionStartsFrom(ledgerVersion, SOROBAN_PROTOCOL_VERSION))
@@ -1315,6 +1883,8 @@ LedgerManagerImpl::updateNetworkConfig(AbstractLedgerTxn& rootLtx)
         mSorobanNetworkConfig->loadFromLedger(
             rootLtx, mApp.getConfig().CURRENT_LEDGER_PROTOCOL_VERSION,
             ledgerVersion);
+        mReloadSorobanNetworkConfig = false;
+        publishSorobanNetworkConfigSnapshot(ledgerSeq);
         publishSorobanMetrics();
     }
     else
@@ -1352,16 +1922,34 @@ LedgerManagerImpl::processFeesSeqNums(
         auto header = ltx.loadHeader().current();
         auto ledgerSeq = header.ledgerSeq;
         std::map<AccountID, SequenceNumber> accToMaxSeq;
-
+        TransactionHistoryWriter historyWriter(mApp.getDatabase(),
+                                               mApp.getConfig(), ledgerSeq);
+
+        // Nothing consumes the changes unless meta is being emitted or
+        // history is stored, and a nested LedgerTxn per transaction is only
+        // needed to collect them. Otherwise fees are charged directly in
+        // `ltx`, which ends up in the same state.
+        bool const storeHistory = mApp.getConfig().MODE_STORES_HISTORY_MISC;
+        bool const collectChanges = ledgerCloseMeta || storeHistory;
         bool mergeSeen = false;
         for (auto tx : txs)
         {
-            LedgerTxn ltxTx(ltx);
-            tx->processFeeSeqNum(ltxTx, txSet.getTxBaseFee(tx, header));
+            std::optional<LedgerTxn> ltxTx;
+            if (collectChanges)
+            {
+                ltxTx.emplace(ltx);
+            }
+            AbstractLedgerTxn& ltxFee =
+                ltxTx ? static_cast<AbstractLedgerTxn&>(*ltxTx) : ltx;
+            auto const& fees = txSet.getTxApplyFees(tx);
+            tx->processFeeSeqNum(ltxFee, fees.mBaseFee);
+            if (fees.mSorobanResourceFee)
+            {
+                tx->setPreApplySorobanResourceFee(*fees.mSorobanResourceFee);
+            }
 
-            if (protocolVersionStartsFrom(
-                    ltxTx.loadHeader().current().ledgerVersion,
-                    ProtocolVersion::V_19))
+            if (protocolVersionStartsFrom(header.ledgerVersion,
+                                          ProtocolVersion::V_19))
             {
                 auto res =
                     accToMaxSeq.emplace(tx->getSourceID(), tx->getSeqNum());
@@ -1377,12 +1965,17 @@ LedgerManagerImpl::processFeesSeqNums(
                 }
             }
 
-            LedgerEntryChanges changes = ltxTx.getChanges();
+            LedgerEntryChanges changes;
+            if (ltxTx)
+            {
+                changes = ltxTx->getChanges();
+            }
             if (ledgerCloseMeta)
             {
                 ledgerCloseMeta->pushTxProcessingEntry();
                 ledgerCloseMeta->setLastTxProcessingFeeProcessingChanges(
-                    changes);
+                    storeHistory ? LedgerEntryChanges(changes)
+                                 : std::move(changes));
             }
             // Note to future: when we eliminate the txhistory and txfeehistory
             // tables, the following step can be removed.
@@ -1391,12 +1984,14 @@ LedgerManagerImpl::processFeesSeqNums(
             // txs counting from 1, not 0. We preserve this for the time being
             // in case anyone depends on it.
             ++index;
-            if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
+            if (storeHistory)
+            {
+                historyWriter.addTransactionFee(tx, changes, index);
+            }
+            if (ltxTx)
             {
-                storeTransactionFee(mApp.getDatabase(), ledgerSeq, tx, changes,
-                                    index);
+                ltxTx->commit();
             }
-            ltxTx.commit();
         }
 
         if (protocolVersionStartsFrom(ltx.loadHeader().current().ledgerVersion,
@@ -1427,6 +2022,7 @@ LedgerManagerImpl::processFeesSeqNums(
             }
         }
 
+        historyWriter.flush();
         ltx.commit();
     }
     catch (std::exception& e)
@@ -1470,6 +2066,162 @@ LedgerManagerImpl::prefetchTransactionData(
     }
 }
 
+void
+LedgerManagerImpl::prefetchTxSetAsync(ApplicableTxSetFrame const& txSet)
+{
+    ZoneScoped;
+    if (!mApp.getConfig().isUsingBucketListDB())
+    {
+        return;
+    }
+
+    auto& bsm = mApp.getBucketManager().getBucketSnapshotManager();
+    if (!bsm.isEntryCacheEnabled())
+    {
+        return;
+    }
+
+    // Same keys as prefetchTxSourceIds and prefetchTransactionData
+    UnorderedSet<LedgerKey> keys;
+    for (size_t i = 0; i < txSet.numPhases(); ++i)
+    {
+        for (auto const& tx : txSet.getTxsForPhase(static_cast<TxSetPhase>(i)))
+        {
+            tx->insertKeysForFeeProcessing(keys);
+            tx->insertKeysForTxApply(keys);
+        }
+    }
+
+    bsm.prefetchAsync(LedgerKeySet(keys.begin(), keys.end()));
+}
+
+void
+LedgerManagerImpl::verifyTxSetSignaturesAsync(ApplicableTxSetFrame const& txSet)
+{
+    ZoneScoped;
+    // Copied out of the transactions, which are not thread safe
+    auto envelopes = std::make_shared<std::vector<EnvelopeSignatures>>();
+    for (size_t i = 0; i < txSet.numPhases(); ++i)
+    {
+        for (auto const& tx : txSet.getTxsForPhase(static_cast<TxSetPhase>(i)))
+        {
+            tx->insertSignaturesToVerify(*envelopes);
+        }
+    }
+    if (envelopes->empty())
+    {
+        return;
+    }
+
+    bool loadSigners = mApp.getConfig().isUsingBucketListDB();
+    mApp.postOnBackgroundThread(
+        [this, envelopes, loadSigners]() {
+            std::shared_ptr<SearchableBucketListSnapshot> snapshot;
+            if (loadSigners)
+            {
+                snapshot = mApp.getBucketManager()
+                               .getBucketSnapshotManager()
+                               .getSearchableBucketListSnapshot();
+            }
+            try
+            {
+                preVerifySignatures(*envelopes, 0, envelopes->size(),
+                                    snapshot.get());
+            }
+            catch (std::exception const& e)
+            {
+                // Apply verifies whatever could not be verified here
+                CLOG_WARNING(Ledger, "Signature verification failed: {}",
+                             e.what());
+            }
+        },
+        "verifyTxSetSignaturesAsync");
+}
+
+void
+LedgerManagerImpl::precomputeHostInvocations(
+    std::vector<TransactionFrameBasePtr> const& txs, TxApplyStage const& stage,
+    AbstractLedgerTxn& ltx, Hash const& sorobanBasePrngSeed)
+{
+    ZoneScoped;
+
+    std::vector<size_t> indices;
+    for (auto const& cluster : stage)
+    {
+        indices.insert(indices.end(), cluster.begin(), cluster.end());
+    }
+    std::sort(indices.begin(), indices.end());
+
+    // A transaction is invoked ahead of time if no transaction before it in
+    // the stage writes an entry it reads, or reads an entry it writes. That
+    // keeps the precomputations that would be discarded anyway to a minimum,
+    // but is not relied on for correctness: doApply only uses an invocation
+    // after checking that the entries it read are still current.
+    std::vector<std::shared_ptr<InvokeHostFunctionOpFrame>> ops;
+    std::vector<std::shared_ptr<PrecomputedHostInvocation>> invocations;
+    UnorderedSet<LedgerKey> readKeys;
+    UnorderedSet<LedgerKey> writtenKeys;
+    for (auto i : indices)
+    {
+        auto const& footprint = txs[i]->sorobanResources().footprint;
+        bool independent =
+            std::none_of(footprint.readWrite.begin(), footprint.readWrite.end(),
+                         [&](LedgerKey const& k) {
+                             return readKeys.find(k) != readKeys.end();
+                         }) &&
+            std::none_of(footprint.readOnly.begin(), footprint.readOnly.end(),
+                         [&](LedgerKey const& k) {
+                             return writtenKeys.find(k) != writtenKeys.end();
+                         });
+        readKeys.insert(footprint.readOnly.begin(), footprint.readOnly.end());
+        readKeys.insert(footprint.readWrite.begin(), footprint.readWrite.end());
+        writtenKeys.insert(footprint.readWrite.begin(),
+                           footprint.readWrite.end());
+        if (!independent)
+        {
+            continue;
+        }
+
+        // Fee bump transactions are only invoked as they are applied
+        auto frame = std::dynamic_pointer_cast<TransactionFrame>(txs[i]);
+        if (!frame)
+        {
+            continue;
+        }
+        auto op = std::dynamic_pointer_cast<InvokeHostFunctionOpFrame>(
+            frame->getOperations().front());
+        if (!op)
+        {
+            continue;
+        }
+
+        // Soroban transactions have a single operation
+        auto opSeed = subSeed(subSeed(sorobanBasePrngSeed, i), 0);
+        auto invocation = op->prepareHostInvocation(mApp, ltx, opSeed);
+        if (invocation)
+        {
+            ops.emplace_back(op);
+            invocations.emplace_back(invocation);
+        }
+    }
+
+    if (invocations.size() < 2)
+    {
+        // Nothing would run in parallel
+        return;
+    }
+
+    parallelForBatches(
+        mApp, invocations.size(), 1,
+        [&](size_t, size_t i, size_t) { invocations[i]->invoke(); },
+        "LedgerManager: invoke host function", BackgroundPriority::HIGH);
+
+    for (size_t i = 0; i < ops.size(); ++i)
+    {
+        ops[i]->setPrecomputedHostInvocation(invocations[i]);
+    }
+}
+
 void
 LedgerManagerImpl::applyTransactions(
     ApplicableTxSetFrame const& txSet,
@@ -1483,6 +2235,8 @@ LedgerManagerImpl::applyTransactions(
     // Record counts
     auto numTxs = txs.size();
     auto numOps = txSet.sizeOpTotal();
+    mCloseTiming.mTxCount = numTxs;
+    mCloseTiming.mOpCount = numOps;
     if (numTxs > 0)
     {
         mTransactionCount.Update(static_cast<int64_t>(numTxs));
@@ -1496,34 +2250,65 @@ LedgerManagerImpl::applyTransactions(
 
     prefetchTransactionData(txs);
 
+    // Meta is only collected when something consumes it: the meta streams
+    // (through ledgerCloseMeta) or the txhistory table
+    bool const storeHistory = mApp.getConfig().MODE_STORES_HISTORY_MISC;
+    bool const collectMeta = ledgerCloseMeta || storeHistory;
+    TransactionHistoryWriter historyWriter(
+        mApp.getDatabase(), mApp.getConfig(),
+        ltx.loadHeader().current().ledgerSeq);
+
+    // Host invocations are precomputed a stage at a time, when the first
+    // transaction of the stage is about to be applied
+    std::vector<TxApplyStage> applyStages;
+    if (mApp.getConfig().EXPERIMENTAL_PARALLEL_SOROBAN_APPLY)
+    {
+        applyStages = TxSetUtils::buildApplyStages(txs);
+    }
+    size_t nextStage = 0;
+
     Hash sorobanBasePrngSeed = txSet.getContentsHash();
     uint64_t txNum{0};
     uint64_t txSucceeded{0};
     uint64_t txFailed{0};
     uint64_t sorobanTxSucceeded{0};
     uint64_t sorobanTxFailed{0};
+    auto& invariantManager = mApp.getInvariantManager();
+    auto invariantsStart = invariantManager.getOperationCheckTime();
     for (auto tx : txs)
     {
         ZoneNamedN(txZone, "applyTransaction", true);
+        if (nextStage < applyStages.size() &&
+            applyStages[nextStage].front().front() == txNum)
+        {
+            if (tx->isSoroban())
+            {
+                precomputeHostInvocations(txs, applyStages[nextStage], ltx,
+                                          sorobanBasePrngSeed);
+            }
+            ++nextStage;
+        }
+
         auto txTime = mTransactionApply.TimeScope();
-        TransactionMetaFrame tm(ltx.loadHeader().current().ledgerVersion);
+        CloseTimeScope txCloseTime(tx->isSoroban()
+                                       ? mCloseTiming.mSorobanApply
+                                       : mCloseTiming.mClassicApply);
+        TransactionMetaFrame tm(ltx.loadHeader().current().ledgerVersion,
+                                collectMeta);
         CLOG_DEBUG(Tx, " tx#{} = {} ops={} txseq={} (@ {})", index,
                    hexAbbrev(tx->getContentsHash()), tx->getNumOperations(),
                    tx->getSeqNum(),
                    mApp.getConfig().toShortString(tx->getSourceID()));
 
-        Hash subSeed = sorobanBasePrngSeed;
+        Hash txSeed = sorobanBasePrngSeed;
         // If tx can use the seed, we need to compute a sub-seed for it.
         if (tx->isSoroban())
         {
-            SHA256 subSeedSha;
-            subSeedSha.add(sorobanBasePrngSeed);
-            subSeedSha.add(xdr::xdr_to_opaque(txNum));
-            subSeed = subSeedSha.finish();
+            txSeed = subSeed(sorobanBasePrngSeed, txNum);
         }
         ++txNum;
 
-        tx->apply(mApp, ltx, tm, subSeed);
+        tx->apply(mApp, ltx, tm, txSeed);
         tx->processPostApply(mApp, ltx, tm);
         TransactionResultPair results;
         results.transactionHash = tx->getContentsHash();
@@ -1551,13 +2336,16 @@ LedgerManagerImpl::applyTransactions(
 
         // Then potentially add that TRP and its associated TransactionMeta
         // into the associated slot of any LedgerCloseMeta we're collecting.
+        // The meta is moved rather than copied unless it is also stored
+        // below.
         if (ledgerCloseMeta)
         {
             ledgerCloseMeta->setTxProcessingMetaAndResultPair(
-                tm.getXDR(), std::move(results), index);
+                storeHistory ? TransactionMeta(tm.getXDR()) : tm.releaseXDR(),
+                std::move(results), index);
         }
 
-        // Then finally store the results and meta into the txhistory table.
+        // Then finally queue the results and meta for the txhistory table,
         // if we're running in a mode that has one.
         //
         // Note to future: when we eliminate the txhistory and txfeehistory
@@ -1567,13 +2355,14 @@ LedgerManagerImpl::applyTransactions(
         // txs counting from 1, not 0. We preserve this for the time being
         // in case anyone depends on it.
         ++index;
-        if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
+        if (storeHistory)
         {
-            auto ledgerSeq = ltx.loadHeader().current().ledgerSeq;
-            storeTransaction(mApp.getDatabase(), ledgerSeq, tx, tm.getXDR(),
-                             txResultSet, mApp.getConfig());
+            historyWriter.addTransaction(tx, tm.getXDR(), txResultSet);
         }
     }
+    historyWriter.flush();
+    mCloseTiming.mInvariants =
+        invariantManager.getOperationCheckTime() - invariantsStart;
 
     mTransactionApplySucceeded.inc(txSucceeded);
     mTransactionApplyFailed.inc(txFailed);
@@ -1602,6 +2391,7 @@ LedgerManagerImpl::storeCurrentLedger(LedgerHeader const& header,
                                       bool storeHeader)
 {
     ZoneScoped;
+    CloseTimeScope historyTime(mCloseTiming.mHistory);
 
     Hash hash = xdrSha256(header);
     releaseAssert(!isZero(hash));
@@ -1618,6 +2408,8 @@ LedgerManagerImpl::storeCurrentLedger(LedgerHeader const& header,
     HistoryArchiveState has(header.ledgerSeq, bl,
                             mApp.getConfig().NETWORK_PASSPHRASE);
 
+    // The buckets it names must be durable before the HAS is
+    fs::syncDeferredRenames();
     mApp.getPersistentState().setState(PersistentState::kHistoryArchiveState,
                                        has.toString());
 
@@ -1670,15 +2462,22 @@ LedgerManagerImpl::transferLedgerEntriesToBucketList(
             ltxEvictions.commit();
         }
 
-        getSorobanNetworkConfigInternal().maybeSnapshotBucketListSize(
-            ledgerSeq, ltx, mApp);
+        if (getSorobanNetworkConfigInternal().maybeSnapshotBucketListSize(
+                ledgerSeq, ltx, mApp))
+        {
+            publishSorobanNetworkConfigSnapshot(ledgerSeq);
+        }
     }
 
     ltx.getAllEntries(initEntries, liveEntries, deadEntries);
     if (blEnabled)
     {
+        CloseTimeScope addBatchTime(mCloseTiming.mAddBatch);
+        auto& bl = mApp.getBucketManager().getBucketList();
+        auto mergeWaitStart = bl.getMergeWaitTime();
         mApp.getBucketManager().addBatch(mApp, ledgerSeq, currLedgerVers,
                                          initEntries, liveEntries, deadEntries);
+        mCloseTiming.mMergeWait = bl.getMergeWaitTime() - mergeWaitStart;
     }
 }
 
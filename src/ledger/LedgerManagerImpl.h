@@ -5,16 +5,25 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 #include "util/asio.h"
 
+#include "herder/TxSetFrame.h"
 #include "history/HistoryManager.h"
 #include "ledger/LedgerCloseMetaFrame.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/NetworkConfig.h"
+#include "ledger/ContractCodeCache.h"
+#include "ledger/SorobanContractProfiler.h"
 #include "ledger/SorobanMetrics.h"
 #include "main/PersistentState.h"
 #include "transactions/TransactionFrame.h"
+#include "util/MetaRingBuffer.h"
 #include "util/XDRStream.h"
+#include "util/xdrquery/XDRQuery.h"
 #include "xdr/Stellar-ledger.h"
+#include <chrono>
+#include <deque>
 #include <filesystem>
+#include <future>
+#include <mutex>
 #include <string>
 
 /*
@@ -36,6 +45,7 @@ namespace stellar
 class AbstractLedgerTxn;
 class Application;
 class Database;
+class LedgerTxn;
 class LedgerTxnHeader;
 class BasicWork;
 
@@ -44,6 +54,10 @@ class LedgerManagerImpl : public LedgerManager
   protected:
     Application& mApp;
     std::unique_ptr<XDROutputFileStream> mMetaStream;
+    // Replaces mMetaStream for a "shm:" METADATA_OUTPUT_STREAM
+    std::unique_ptr<MetaRingBufferWriter> mMetaRingBuffer;
+    // Set from METADATA_OUTPUT_FILTER
+    std::unique_ptr<xdrquery::XDRMatcher> mMetaFilter;
     std::unique_ptr<XDROutputFileStream> mMetaDebugStream;
     std::weak_ptr<BasicWork> mFlushAndRotateMetaDebugWork;
     std::filesystem::path mMetaDebugPath;
@@ -51,21 +65,42 @@ class LedgerManagerImpl : public LedgerManager
   private:
     LedgerHeaderHistoryEntry mLastClosedLedger;
     std::optional<SorobanNetworkConfig> mSorobanNetworkConfig;
+    // Set when the config may no longer match the ledger, forcing a reload
+    // at the next ledger close
+    bool mReloadSorobanNetworkConfig{false};
+    // Set between beginLedgerCloseBatch and endLedgerCloseBatch
+    bool mInLedgerCloseBatch{false};
+    mutable std::mutex mSorobanNetworkConfigSnapshotMutex;
+    std::shared_ptr<SorobanNetworkConfigSnapshot const>
+        mSorobanNetworkConfigSnapshot;
 
     SorobanMetrics mSorobanMetrics;
+    ContractCodeCache mContractCodeCache;
+    SorobanContractProfiler mSorobanContractProfiler;
     medida::Timer& mTransactionApply;
     medida::Histogram& mTransactionCount;
     medida::Histogram& mOperationCount;
     medida::Histogram& mPrefetchHitRate;
     medida::Timer& mLedgerClose;
+    // Phases of mLedgerClose
+    medida::Timer& mLedgerCloseFeesSeqNums;
+    medida::Timer& mLedgerCloseApply;
+    medida::Timer& mLedgerCloseCommit;
     medida::Buckets& mLedgerAgeClosed;
     medida::Counter& mLedgerAge;
     medida::Counter& mTransactionApplySucceeded;
     medida::Counter& mTransactionApplyFailed;
+    medida::Counter& mTransactionApplyTrusted;
     medida::Counter& mSorobanTransactionApplySucceeded;
     medida::Counter& mSorobanTransactionApplyFailed;
     medida::Meter& mMetaStreamBytes;
     medida::Timer& mMetaStreamWriteTime;
+    medida::Timer& mMetaStreamWaitTime;
+    medida::Histogram& mMetaStreamLedgerSize;
+    medida::Timer& mMetaStreamEmitTime;
+    medida::Counter& mMetaStreamQueueDepth;
+    // Indexed by OperationType
+    std::vector<medida::Timer*> mOperationApplyTimers;
     VirtualClock::time_point mLastClose;
     bool mRebuildInMemoryState{false};
 
@@ -73,6 +108,44 @@ class LedgerManagerImpl : public LedgerManager
     medida::Timer& mCatchupDuration;
 
     std::unique_ptr<LedgerCloseMetaFrame> mNextMetaToEmit;
+    // Meta handed to the meta thread and not yet collected, oldest first, at
+    // most METADATA_OUTPUT_QUEUE_LEDGERS of them; see
+    // EXPERIMENTAL_BACKGROUND_META_EMISSION
+    std::deque<std::future<void>> mPendingMetaWrites;
+    // Hold the serialized meta of the ledger being written, and its filtered
+    // version for METADATA_OUTPUT_FILTER; only touched by writeMeta
+    std::vector<char> mMetaBuf;
+    std::vector<char> mFilteredMetaBuf;
+
+    // Time spent in each phase of closing a ledger, in real time
+    struct CloseTiming
+    {
+        uint32_t mLedgerSeq{0};
+        size_t mTxCount{0};
+        size_t mOpCount{0};
+        std::chrono::nanoseconds mTotal{0};
+        // Preparing the tx set for apply
+        std::chrono::nanoseconds mPrepare{0};
+        std::chrono::nanoseconds mFeesSeqNums{0};
+        std::chrono::nanoseconds mClassicApply{0};
+        std::chrono::nanoseconds mSorobanApply{0};
+        // Checking operation invariants, as part of apply
+        std::chrono::nanoseconds mInvariants{0};
+        std::chrono::nanoseconds mCommit{0};
+        std::chrono::nanoseconds mAddBatch{0};
+        // Waiting for bucket merges to finish, as part of mAddBatch
+        std::chrono::nanoseconds mMergeWait{0};
+        // Emitting meta, or queueing it with
+        // EXPERIMENTAL_BACKGROUND_META_EMISSION
+        std::chrono::nanoseconds mMeta{0};
+        // Storing the HAS, queueing checkpoints and starting their publishing
+        std::chrono::nanoseconds mHistory{0};
+    };
+    // Of the ledger being closed by closeLedger
+    CloseTiming mCloseTiming;
+    // Of the last MAX_CLOSE_TIMINGS ledgers closed, oldest first
+    std::deque<CloseTiming> mCloseTimings;
+    static size_t const MAX_CLOSE_TIMINGS;
 
     void processFeesSeqNums(
         std::vector<TransactionFrameBasePtr> const& txs,
@@ -85,6 +158,15 @@ class LedgerManagerImpl : public LedgerManager
         TransactionResultSet& txResultSet,
         std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta);
 
+    // Invokes the host functions of the Soroban transactions of stage that do
+    // not conflict with the transactions before them in the stage, on the
+    // worker threads and on this thread, against the current state of ltx.
+    // The results are handed to the operations for their application.
+    void precomputeHostInvocations(
+        std::vector<TransactionFrameBasePtr> const& txs,
+        TxApplyStage const& stage, AbstractLedgerTxn& ltx,
+        Hash const& sorobanBasePrngSeed);
+
     // initialLedgerVers must be the ledger version at the start of the ledger.
     // On the ledger in which a protocol upgrade from vN to vN + 1 occurs,
     // initialLedgerVers must be vN.
@@ -98,13 +180,28 @@ class LedgerManagerImpl : public LedgerManager
     prefetchTransactionData(std::vector<TransactionFrameBasePtr> const& txs);
     void prefetchTxSourceIds(std::vector<TransactionFrameBasePtr> const& txs);
     void closeLedgerIf(LedgerCloseData const& ledgerData);
+    // Steps of closing a ledger from committing `ltx` on, once it is sealed
+    void commitClosedLedger(LedgerTxn& ltx, uint32_t initialLedgerVers,
+                            uint32_t ledgerSeq);
+    // Bucket GC, publish status and WAL checkpoint after a commit
+    void afterLedgerCommitHousekeeping();
 
     State mState;
     void setState(State s);
 
+    // Writes mNextMetaToEmit to the meta streams, on the meta thread if
+    // EXPERIMENTAL_BACKGROUND_META_EMISSION is set
     void emitNextMeta();
+    void writeMeta(LedgerCloseMetaFrame const& meta,
+                   std::chrono::steady_clock::time_point emitStart);
+    // Collects meta writes finished on the meta thread, rethrowing any error
+    // from writing them, and waits for the oldest ones until at most
+    // maxPending are left. The meta streams must not be touched before all
+    // writes are collected.
+    void waitForPendingMetaWrites(size_t maxPending);
 
     SorobanNetworkConfig& getSorobanNetworkConfigInternal();
+    void publishSorobanNetworkConfigSnapshot(uint32_t ledgerSeq);
 
     // Publishes soroban metrics, including select network config limits as well
     // as the actual ledger usage.
@@ -130,8 +227,8 @@ class LedgerManagerImpl : public LedgerManager
   public:
     LedgerManagerImpl(Application& app);
 
-    // Reloads the network configuration from the ledger.
-    // This needs to be called every time a ledger is closed.
+    // Reloads the network configuration from the ledger and publishes a new
+    // snapshot of it. Ledger close calls this only after upgrades.
     // This call is read-only and hence `ltx` can be read-only.
     void updateNetworkConfig(AbstractLedgerTxn& ltx) override;
     void moveToSynced() override;
@@ -150,6 +247,8 @@ class LedgerManagerImpl : public LedgerManager
     uint32_t getLastClosedLedgerNum() const override;
     SorobanNetworkConfig const& getSorobanNetworkConfig() override;
     bool hasSorobanNetworkConfig() const override;
+    std::shared_ptr<SorobanNetworkConfigSnapshot const>
+    getSorobanNetworkConfigSnapshot() const override;
 
 #ifdef BUILD_TESTS
     SorobanNetworkConfig& getMutableSorobanNetworkConfig() override;
@@ -177,8 +276,16 @@ class LedgerManagerImpl : public LedgerManager
                  std::set<std::shared_ptr<Bucket>> bucketsToRetain) override;
 
     void closeLedger(LedgerCloseData const& ledgerData) override;
+    void closeLedgerFromMeta(LedgerCloseMeta const& lcm) override;
+    void beginLedgerCloseBatch() override;
+    void endLedgerCloseBatch() override;
+    void prefetchTxSetAsync(ApplicableTxSetFrame const& txSet) override;
+    void
+    verifyTxSetSignaturesAsync(ApplicableTxSetFrame const& txSet) override;
     void deleteOldEntries(Database& db, uint32_t ledgerSeq,
                           uint32_t count) override;
+    void deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                          uint32_t count) override;
 
     void deleteNewerEntries(Database& db, uint32_t ledgerSeq) override;
 
@@ -191,5 +298,9 @@ class LedgerManagerImpl : public LedgerManager
     void maybeResetLedgerCloseMetaDebugStream(uint32_t ledgerSeq);
 
     SorobanMetrics& getSorobanMetrics() override;
+    ContractCodeCache& getContractCodeCache() override;
+    SorobanContractProfiler& getSorobanContractProfiler() override;
+    medida::Timer& getOperationApplyTimer(OperationType type) override;
+    Json::Value getJsonCloseTimingInfo(size_t limit) const override;
 };
 }
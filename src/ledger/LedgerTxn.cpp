@@ -16,20 +16,36 @@
 #include "ledger/LedgerTxnImpl.h"
 #include "ledger/LedgerTypeUtils.h"
 #include "ledger/NonSociRelatedException.h"
+#include "ledger/OrderBookIndex.h"
 #include "main/Application.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/ParallelFor.h"
+#include "util/PoolAllocator.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
 #include "util/XDRStream.h"
 #include "util/types.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <soci.h>
 
 namespace stellar
 {
 
+// Entries are created and destroyed at a high rate by the nested LedgerTxns
+// used while applying transactions, so their storage is recycled through a
+// pool instead of going back to the heap each time.
+static std::shared_ptr<InternalLedgerEntry>
+makeSharedEntry(InternalLedgerEntry const& entry)
+{
+    return std::allocate_shared<InternalLedgerEntry>(
+        PoolAllocator<InternalLedgerEntry>(), entry);
+}
+
 LedgerEntryPtr
 LedgerEntryPtr::Init(std::shared_ptr<InternalLedgerEntry> const& lePtr)
 {
@@ -287,6 +303,12 @@ EntryIterator::key() const
     return getImpl()->key();
 }
 
+size_t
+EntryIterator::sizeHint() const
+{
+    return getImpl()->sizeHint();
+}
+
 // Implementation of AbstractLedgerTxn --------------------------------------
 AbstractLedgerTxn::~AbstractLedgerTxn()
 {
@@ -422,10 +444,11 @@ LedgerTxn::commit() noexcept
 void
 LedgerTxn::Impl::commit() noexcept
 {
-    maybeUpdateLastModifiedThenInvokeThenSeal([&](EntryMap const& entries) {
-        // getEntryIterator has the strong exception safety guarantee
+    maybeUpdateLastModifiedThenInvokeThenSeal([&](EntryMap const&) {
+        // getReleasableEntryIterator has the strong exception safety guarantee
         // commitChild has the strong exception safety guarantee
-        mParent.commitChild(getEntryIterator(entries), mConsistency);
+        // mEntry is never read again once committed, so the parent may take it
+        mParent.commitChild(getReleasableEntryIterator(), mConsistency);
     });
 }
 
@@ -466,10 +489,33 @@ LedgerTxn::Impl::commitChild(EntryIterator iter,
     }
     try
     {
-        for (; (bool)iter; ++iter)
+        auto released = iter.getImpl()->releasableEntries();
+        if (released && mEntry.empty())
         {
-            updateEntry(iter.key(), /* keyHint */ nullptr, iter.entryPtr(),
-                        /* effectiveActive */ false);
+            // There is nothing to merge with, so merging would just rebuild
+            // the child's entries. Take them over instead, and only index the
+            // offers among them.
+            mEntry.swap(*released);
+            for (auto const& kv : mEntry)
+            {
+                auto const& key = kv.first;
+                if (key.type() == InternalLedgerEntryType::LEDGER_ENTRY &&
+                    key.ledgerKey().type() == OFFER && !kv.second.isDeleted())
+                {
+                    addToOrderBook(key.ledgerKey(), kv.second->ledgerEntry());
+                }
+            }
+        }
+        else
+        {
+            // Size mEntry for the child's entries up front so that the merge
+            // below is a single pass that never rehashes
+            mEntry.reserve(mEntry.size() + iter.sizeHint());
+            for (; (bool)iter; ++iter)
+            {
+                updateEntry(iter.key(), /* keyHint */ nullptr, iter.entryPtr(),
+                            /* effectiveActive */ false);
+            }
         }
 
         // We will show that the following update procedure leaves the self
@@ -579,7 +625,7 @@ LedgerTxn::Impl::create(LedgerTxn& self, InternalLedgerEntry const& entry)
         throw std::runtime_error("Key already exists");
     }
 
-    auto current = std::make_shared<InternalLedgerEntry>(entry);
+    auto current = makeSharedEntry(entry);
     auto impl = LedgerTxnEntry::makeSharedImpl(self, *current);
 
     // Set the key to active before constructing the LedgerTxnEntry, as this
@@ -623,10 +669,9 @@ LedgerTxn::Impl::createWithoutLoading(InternalLedgerEntry const& entry)
     // after this INIT entry is merged with the DELETED will be a LIVE. This is
     // because the entry would have been a LIVE before the delete. If it were an
     // INIT instead, the key would've been annihilated.
-    updateEntry(
-        key, /* keyHint */ nullptr,
-        LedgerEntryPtr::Init(std::make_shared<InternalLedgerEntry>(entry)),
-        /* effectiveActive */ false);
+    updateEntry(key, /* keyHint */ nullptr,
+                LedgerEntryPtr::Init(makeSharedEntry(entry)),
+                /* effectiveActive */ false);
 }
 
 void
@@ -648,10 +693,9 @@ LedgerTxn::Impl::updateWithoutLoading(InternalLedgerEntry const& entry)
         throw std::runtime_error("Key is already active");
     }
 
-    updateEntry(
-        key, /* keyHint */ nullptr,
-        LedgerEntryPtr::Live(std::make_shared<InternalLedgerEntry>(entry)),
-        /* effectiveActive */ false);
+    updateEntry(key, /* keyHint */ nullptr,
+                LedgerEntryPtr::Live(makeSharedEntry(entry)),
+                /* effectiveActive */ false);
 }
 
 void
@@ -910,7 +954,9 @@ LedgerTxn::Impl::getBestOffer(Asset const& buying, Asset const& selling)
 
     AssetPair const assets{buying, selling};
 
-    std::shared_ptr<LedgerEntry const> selfBest;
+    // Only copied if it turns out to be the best offer, as the parent usually
+    // has a better one
+    LedgerEntry const* selfBest = nullptr;
     auto ob = findOrderBook(buying, selling);
     if (ob)
     {
@@ -922,8 +968,7 @@ LedgerTxn::Impl::getBestOffer(Asset const& buying, Asset const& selling)
             {
                 throw std::runtime_error("invalid order book state");
             }
-            selfBest = std::make_shared<LedgerEntry const>(
-                entryIter->second->ledgerEntry());
+            selfBest = &entryIter->second->ledgerEntry();
         }
     }
 
@@ -993,7 +1038,7 @@ LedgerTxn::Impl::getBestOffer(Asset const& buying, Asset const& selling)
         parentBest =
             mParent.getBestOffer(buying, selling, {oe.price, oe.offerID});
     }
-    return selfBest;
+    return selfBest ? std::make_shared<LedgerEntry const>(*selfBest) : nullptr;
 }
 
 std::shared_ptr<LedgerEntry const>
@@ -1020,7 +1065,8 @@ LedgerTxn::Impl::getBestOffer(Asset const& buying, Asset const& selling,
 
     AssetPair const assets{buying, selling};
 
-    std::shared_ptr<LedgerEntry const> selfBest;
+    // Only copied if it turns out to be the best offer, see above
+    LedgerEntry const* selfBest = nullptr;
     auto ob = findOrderBook(buying, selling);
     if (ob)
     {
@@ -1033,8 +1079,7 @@ LedgerTxn::Impl::getBestOffer(Asset const& buying, Asset const& selling,
             {
                 throw std::runtime_error("invalid order book state");
             }
-            selfBest = std::make_shared<LedgerEntry const>(
-                entryIter->second->ledgerEntry());
+            selfBest = &entryIter->second->ledgerEntry();
         }
     }
 
@@ -1077,7 +1122,7 @@ LedgerTxn::Impl::getBestOffer(Asset const& buying, Asset const& selling,
         parentBest =
             mParent.getBestOffer(buying, selling, {oe.price, oe.offerID});
     }
-    return selfBest;
+    return selfBest ? std::make_shared<LedgerEntry const>(*selfBest) : nullptr;
 }
 
 LedgerEntryChanges
@@ -1089,9 +1134,52 @@ LedgerTxn::getChanges()
 LedgerEntryChanges
 LedgerTxn::Impl::getChanges()
 {
-    throwIfNotExactConsistency();
     LedgerEntryChanges changes;
-    changes.reserve(mEntry.size() * 2);
+    collectChanges(nullptr, &changes);
+    return changes;
+}
+
+LedgerTxnDelta
+LedgerTxn::getDelta()
+{
+    return getImpl()->getDelta();
+}
+
+LedgerTxnDelta
+LedgerTxn::Impl::getDelta()
+{
+    LedgerTxnDelta delta;
+    collectChanges(&delta, nullptr);
+    return delta;
+}
+
+std::pair<LedgerTxnDelta, LedgerEntryChanges>
+LedgerTxn::getDeltaAndChanges()
+{
+    return getImpl()->getDeltaAndChanges();
+}
+
+std::pair<LedgerTxnDelta, LedgerEntryChanges>
+LedgerTxn::Impl::getDeltaAndChanges()
+{
+    std::pair<LedgerTxnDelta, LedgerEntryChanges> res;
+    collectChanges(&res.first, &res.second);
+    return res;
+}
+
+void
+LedgerTxn::Impl::collectChanges(LedgerTxnDelta* delta,
+                                LedgerEntryChanges* changes)
+{
+    throwIfNotExactConsistency();
+    if (delta)
+    {
+        delta->entry.reserve(mEntry.size());
+    }
+    if (changes)
+    {
+        changes->reserve(mEntry.size() * 2);
+    }
     maybeUpdateLastModifiedThenInvokeThenSeal([&](EntryMap const& entries) {
         for (auto const& kv : entries)
         {
@@ -1103,75 +1191,71 @@ LedgerTxn::Impl::getChanges()
                 continue;
             }
 
+            // Created entries have no previous version to show in changes
+            std::shared_ptr<InternalLedgerEntry const> previous;
+            if (delta || !entry.isInit())
+            {
+                previous = mParent.getNewestVersion(key);
+            }
+
+            if (delta)
+            {
+                // Deep copy is not required here because collectChanges
+                // causes LedgerTxn to enter the sealed state, meaning
+                // subsequent modifications are impossible.
+                delta->entry[key] = {entry.get(), previous};
+            }
+
+            if (!changes)
+            {
+                continue;
+            }
             if (entry.isInit())
             {
-                changes.emplace_back(LEDGER_ENTRY_CREATED);
-                changes.back().created() = entry->ledgerEntry();
+                changes->emplace_back(LEDGER_ENTRY_CREATED);
+                changes->back().created() = entry->ledgerEntry();
             }
             else
             {
-                auto previous = mParent.getNewestVersion(key);
                 // entry is not init, so previous must exist. If not, then
                 // we're modifying an entry that doesn't exist.
                 releaseAssert(previous);
 
-                changes.emplace_back(LEDGER_ENTRY_STATE);
-                changes.back().state() = previous->ledgerEntry();
+                changes->emplace_back(LEDGER_ENTRY_STATE);
+                changes->back().state() = previous->ledgerEntry();
 
                 if (entry.isDeleted())
                 {
-                    changes.emplace_back(LEDGER_ENTRY_REMOVED);
-                    changes.back().removed() = key.ledgerKey();
+                    changes->emplace_back(LEDGER_ENTRY_REMOVED);
+                    changes->back().removed() = key.ledgerKey();
                 }
                 else
                 {
-                    changes.emplace_back(LEDGER_ENTRY_UPDATED);
-                    changes.back().updated() = entry->ledgerEntry();
+                    changes->emplace_back(LEDGER_ENTRY_UPDATED);
+                    changes->back().updated() = entry->ledgerEntry();
                 }
             }
         }
-    });
-    return changes;
-}
-
-LedgerTxnDelta
-LedgerTxn::getDelta()
-{
-    return getImpl()->getDelta();
-}
-
-LedgerTxnDelta
-LedgerTxn::Impl::getDelta()
-{
-    throwIfNotExactConsistency();
-    LedgerTxnDelta delta;
-    delta.entry.reserve(mEntry.size());
-    maybeUpdateLastModifiedThenInvokeThenSeal([&](EntryMap const& entries) {
-        for (auto const& kv : entries)
+        if (delta)
         {
-            auto const& key = kv.first;
-            if (key.type() != InternalLedgerEntryType::LEDGER_ENTRY)
-            {
-                continue;
-            }
-
-            auto previous = mParent.getNewestVersion(key);
-
-            // Deep copy is not required here because getDelta causes
-            // LedgerTxn to enter the sealed state, meaning subsequent
-            // modifications are impossible.
-            delta.entry[key] = {kv.second.get(), previous};
+            delta->header = {*mHeader, mParent.getHeader()};
         }
-        delta.header = {*mHeader, mParent.getHeader()};
     });
-    return delta;
 }
 
 EntryIterator
 LedgerTxn::Impl::getEntryIterator(EntryMap const& entries) const
 {
-    auto iterImpl =
-        std::make_unique<EntryIteratorImpl>(entries.cbegin(), entries.cend());
+    auto iterImpl = std::make_unique<EntryIteratorImpl>(
+        entries.cbegin(), entries.cend(), entries.size());
+    return EntryIterator(std::move(iterImpl));
+}
+
+EntryIterator
+LedgerTxn::Impl::getReleasableEntryIterator()
+{
+    auto iterImpl = std::make_unique<EntryIteratorImpl>(
+        mEntry.cbegin(), mEntry.cend(), mEntry.size(), &mEntry);
     return EntryIterator(std::move(iterImpl));
 }
 
@@ -1434,6 +1518,40 @@ LedgerTxn::Impl::getNewestVersion(InternalLedgerKey const& key) const
     return mParent.getNewestVersion(key);
 }
 
+UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+LedgerTxn::getNewestVersions(UnorderedSet<InternalLedgerKey> const& keys) const
+{
+    return getImpl()->getNewestVersions(keys);
+}
+
+UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+LedgerTxn::Impl::getNewestVersions(
+    UnorderedSet<InternalLedgerKey> const& keys) const
+{
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+        res;
+    UnorderedSet<InternalLedgerKey> fromParent;
+    for (auto const& key : keys)
+    {
+        auto iter = mEntry.find(key);
+        if (iter != mEntry.end())
+        {
+            res.emplace(key, iter->second.get());
+        }
+        else
+        {
+            fromParent.emplace(key);
+        }
+    }
+
+    if (!fromParent.empty())
+    {
+        auto parentRes = mParent.getNewestVersions(fromParent);
+        res.insert(parentRes.begin(), parentRes.end());
+    }
+    return res;
+}
+
 std::pair<std::shared_ptr<InternalLedgerEntry const>,
           LedgerTxn::Impl::EntryMap::iterator>
 LedgerTxn::Impl::getNewestVersionEntryMap(InternalLedgerKey const& key)
@@ -1567,7 +1685,75 @@ LedgerTxn::Impl::load(LedgerTxn& self, InternalLedgerKey const& key)
         throw std::runtime_error("Key is active");
     }
 
-    auto newest = getNewestVersionEntryMap(key);
+    return loadNewestVersion(self, key, getNewestVersionEntryMap(key));
+}
+
+std::vector<LedgerTxnEntry>
+LedgerTxn::loadBatch(std::vector<InternalLedgerKey> const& keys)
+{
+    return getImpl()->loadBatch(*this, keys);
+}
+
+std::vector<LedgerTxnEntry>
+LedgerTxn::Impl::loadBatch(LedgerTxn& self,
+                           std::vector<InternalLedgerKey> const& keys)
+{
+    ZoneScoped;
+    throwIfSealed();
+    throwIfChild();
+
+    UnorderedSet<InternalLedgerKey> unique;
+    UnorderedSet<InternalLedgerKey> fromParent;
+    for (auto const& key : keys)
+    {
+        if (mActive.find(key) != mActive.end())
+        {
+            throw std::runtime_error("Key is active");
+        }
+        if (!unique.emplace(key).second)
+        {
+            throw std::runtime_error("Duplicate key in loadBatch");
+        }
+        if (mEntry.find(key) == mEntry.end())
+        {
+            fromParent.emplace(key);
+        }
+    }
+
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+        parentRes;
+    if (!fromParent.empty())
+    {
+        parentRes = mParent.getNewestVersions(fromParent);
+    }
+
+    std::vector<LedgerTxnEntry> res;
+    res.reserve(keys.size());
+    for (auto const& key : keys)
+    {
+        // Look the key up again, as loading the previous keys may have
+        // inserted into mEntry and invalidated its iterators
+        auto iter = mEntry.find(key);
+        std::shared_ptr<InternalLedgerEntry const> newest;
+        if (iter != mEntry.end())
+        {
+            newest = iter->second.get();
+        }
+        else
+        {
+            newest = parentRes.at(key);
+        }
+        res.emplace_back(loadNewestVersion(self, key, {newest, iter}));
+    }
+    return res;
+}
+
+LedgerTxnEntry
+LedgerTxn::Impl::loadNewestVersion(
+    LedgerTxn& self, InternalLedgerKey const& key,
+    std::pair<std::shared_ptr<InternalLedgerEntry const>,
+              EntryMap::iterator> const& newest)
+{
     if (!newest.first)
     {
         return {};
@@ -1580,8 +1766,7 @@ LedgerTxn::Impl::load(LedgerTxn& self, InternalLedgerKey const& key)
     }
     else
     {
-        currentEntryPtr = LedgerEntryPtr::Live(
-            std::make_shared<InternalLedgerEntry>(*newest.first));
+        currentEntryPtr = LedgerEntryPtr::Live(makeSharedEntry(*newest.first));
     }
 
     releaseAssert(currentEntryPtr.has_value());
@@ -2005,6 +2190,18 @@ LedgerTxn::dropTTL(bool rebuild)
     throw std::runtime_error("called dropTTL on non-root LedgerTxn");
 }
 
+void
+LedgerTxn::beginBulkPopulate(bool entriesAreUnique)
+{
+    throw std::runtime_error("called beginBulkPopulate on non-root LedgerTxn");
+}
+
+void
+LedgerTxn::endBulkPopulate()
+{
+    throw std::runtime_error("called endBulkPopulate on non-root LedgerTxn");
+}
+
 double
 LedgerTxn::getPrefetchHitRate() const
 {
@@ -2108,6 +2305,14 @@ LedgerTxn::Impl::removeFromOrderBookIfExists(LedgerEntry const& le)
     }
 }
 
+void
+LedgerTxn::Impl::addToOrderBook(LedgerKey const& key, LedgerEntry const& le)
+{
+    auto const& oe = le.data.offer();
+    auto& ob = mMultiOrderBook[oe.buying][oe.selling];
+    ob.emplace(OfferDescriptor{oe.price, oe.offerID}, key);
+}
+
 LedgerTxn::Impl::OrderBook*
 LedgerTxn::Impl::findOrderBook(Asset const& buying, Asset const& selling)
 {
@@ -2220,10 +2425,7 @@ LedgerTxn::Impl::updateEntry(InternalLedgerKey const& key,
     // active. Otherwise, we just record the update in mEntry and return.
     if (!lePtr.isDeleted() && !effectiveActive)
     {
-        auto const& oe = lePtr->ledgerEntry().data.offer();
-
-        auto& ob = mMultiOrderBook[oe.buying][oe.selling];
-        ob.emplace(OfferDescriptor{oe.price, oe.offerID}, key.ledgerKey());
+        addToOrderBook(key.ledgerKey(), lePtr->ledgerEntry());
     }
     recordEntry();
 }
@@ -2350,8 +2552,10 @@ LedgerTxn::Impl::getOrderBook() const
 
 // Implementation of LedgerTxn::Impl::EntryIteratorImpl ---------------------
 LedgerTxn::Impl::EntryIteratorImpl::EntryIteratorImpl(IteratorType const& begin,
-                                                      IteratorType const& end)
-    : mIter(begin), mEnd(end)
+                                                      IteratorType const& end,
+                                                      size_t size,
+                                                      EntryMap* releasable)
+    : mIter(begin), mEnd(end), mSize(size), mReleasable(releasable)
 {
 }
 
@@ -2394,12 +2598,70 @@ LedgerTxn::Impl::EntryIteratorImpl::key() const
 std::unique_ptr<EntryIterator::AbstractImpl>
 LedgerTxn::Impl::EntryIteratorImpl::clone() const
 {
-    return std::make_unique<EntryIteratorImpl>(mIter, mEnd);
+    return std::make_unique<EntryIteratorImpl>(mIter, mEnd, mSize);
+}
+
+size_t
+LedgerTxn::Impl::EntryIteratorImpl::sizeHint() const
+{
+    return mSize;
+}
+
+LedgerTxn::Impl::EntryMap*
+LedgerTxn::Impl::EntryIteratorImpl::releasableEntries() const
+{
+    return mReleasable;
 }
 
 // Implementation of LedgerTxnRoot ------------------------------------------
 size_t const LedgerTxnRoot::Impl::MIN_BEST_OFFERS_BATCH_SIZE = 5;
 
+// Largest share of the entry cache that entries of type let may take. The
+// shares add up to more than one: they only stop one type from crowding out
+// the others, and every type may still use a good part of the cache when the
+// others are idle.
+static double
+entryCacheShare(LedgerEntryType let)
+{
+    switch (let)
+    {
+    case ACCOUNT:
+    case TRUSTLINE:
+        return 0.6;
+    case CONTRACT_DATA:
+    case TTL:
+        return 0.4;
+    case OFFER:
+        return 0.3;
+    case DATA:
+    case CLAIMABLE_BALANCE:
+    case LIQUIDITY_POOL:
+    case CONTRACT_CODE:
+        return 0.2;
+    default:
+        return 0.1;
+    }
+}
+
+// Sizes of the entry cache partitions, indexed by LedgerEntryType
+static std::vector<size_t>
+entryCachePartitionSizes(size_t entryCacheSize)
+{
+    std::vector<size_t> sizes;
+    for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+    {
+        auto type = static_cast<LedgerEntryType>(let);
+        auto i = static_cast<size_t>(let);
+        if (sizes.size() <= i)
+        {
+            sizes.resize(i + 1, 0);
+        }
+        sizes[i] = std::max<size_t>(
+            1, static_cast<size_t>(entryCacheSize * entryCacheShare(type)));
+    }
+    return sizes;
+}
+
 LedgerTxnRoot::LedgerTxnRoot(Application& app, size_t entryCacheSize,
                              size_t prefetchBatchSize
 #ifdef BEST_OFFER_DEBUGGING
@@ -2428,13 +2690,28 @@ LedgerTxnRoot::Impl::Impl(Application& app, size_t entryCacheSize,
                    getMaxOffersToCross()))
     , mApp(app)
     , mHeader(std::make_unique<LedgerHeader>())
-    , mEntryCache(entryCacheSize)
+    , mEntryCache(entryCacheSize, entryCachePartitionSizes(entryCacheSize))
     , mBulkLoadBatchSize(prefetchBatchSize)
     , mChild(nullptr)
 #ifdef BEST_OFFER_DEBUGGING
     , mBestOfferDebuggingEnabled(bestOfferDebuggingEnabled)
 #endif
 {
+    for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+    {
+        auto type = static_cast<LedgerEntryType>(let);
+        std::string label = xdr::xdr_traits<LedgerEntryType>::enum_name(type);
+        mEntryCacheHitMeters.emplace(
+            type, app.getMetrics().NewMeter(
+                      {"ledger", "entry-cache-hit", label}, "entry"));
+        mEntryCacheMissMeters.emplace(
+            type, app.getMetrics().NewMeter(
+                      {"ledger", "entry-cache-miss", label}, "entry"));
+        mEntryCacheEvictMeters.emplace(
+            type, app.getMetrics().NewMeter(
+                      {"ledger", "entry-cache-evict", label}, "entry"));
+        mReportedEntryCacheCounters.emplace(type, EntryCache::Counters{});
+    }
 }
 
 LedgerTxnRoot::~LedgerTxnRoot()
@@ -2455,6 +2732,7 @@ LedgerTxnRoot::Impl::resetForFuzzer()
 {
     mBestOffers.clear();
     mEntryCache.clear();
+    mOrderBookIndex.reset();
 }
 
 void
@@ -2587,122 +2865,100 @@ LedgerTxnRoot::Impl::bulkApply(BulkLedgerEntryChangeAccumulator& bleca,
                                size_t bufferThreshold,
                                LedgerTxnConsistency cons)
 {
-    auto& upsertAccounts = bleca.getAccountsToUpsert();
-    if (upsertAccounts.size() > bufferThreshold)
-    {
-        bulkUpsertAccounts(upsertAccounts);
-        upsertAccounts.clear();
-    }
-    auto& deleteAccounts = bleca.getAccountsToDelete();
-    if (deleteAccounts.size() > bufferThreshold)
-    {
-        bulkDeleteAccounts(deleteAccounts, cons);
-        deleteAccounts.clear();
-    }
-    auto& upsertTrustLines = bleca.getTrustLinesToUpsert();
-    if (upsertTrustLines.size() > bufferThreshold)
-    {
-        bulkUpsertTrustLines(upsertTrustLines);
-        upsertTrustLines.clear();
-    }
-    auto& deleteTrustLines = bleca.getTrustLinesToDelete();
-    if (deleteTrustLines.size() > bufferThreshold)
-    {
-        bulkDeleteTrustLines(deleteTrustLines, cons);
-        deleteTrustLines.clear();
-    }
-    auto& upsertOffers = bleca.getOffersToUpsert();
-    if (upsertOffers.size() > bufferThreshold)
-    {
-        bulkUpsertOffers(upsertOffers);
-        upsertOffers.clear();
-    }
-    auto& deleteOffers = bleca.getOffersToDelete();
-    if (deleteOffers.size() > bufferThreshold)
-    {
-        bulkDeleteOffers(deleteOffers, cons);
-        deleteOffers.clear();
-    }
-    auto& upsertAccountData = bleca.getAccountDataToUpsert();
-    if (upsertAccountData.size() > bufferThreshold)
-    {
-        bulkUpsertAccountData(upsertAccountData);
-        upsertAccountData.clear();
-    }
-    auto& deleteAccountData = bleca.getAccountDataToDelete();
-    if (deleteAccountData.size() > bufferThreshold)
-    {
-        bulkDeleteAccountData(deleteAccountData, cons);
-        deleteAccountData.clear();
-    }
-    auto& upsertClaimableBalance = bleca.getClaimableBalanceToUpsert();
-    if (upsertClaimableBalance.size() > bufferThreshold)
-    {
-        bulkUpsertClaimableBalance(upsertClaimableBalance);
-        upsertClaimableBalance.clear();
-    }
-    auto& deleteClaimableBalance = bleca.getClaimableBalanceToDelete();
-    if (deleteClaimableBalance.size() > bufferThreshold)
-    {
-        bulkDeleteClaimableBalance(deleteClaimableBalance, cons);
-        deleteClaimableBalance.clear();
-    }
-    auto& upsertLiquidityPool = bleca.getLiquidityPoolToUpsert();
-    if (upsertLiquidityPool.size() > bufferThreshold)
-    {
-        bulkUpsertLiquidityPool(upsertLiquidityPool);
-        upsertLiquidityPool.clear();
-    }
-    auto& deleteLiquidityPool = bleca.getLiquidityPoolToDelete();
-    if (deleteLiquidityPool.size() > bufferThreshold)
-    {
-        bulkDeleteLiquidityPool(deleteLiquidityPool, cons);
-        deleteLiquidityPool.clear();
-    }
-    auto& upsertConfigSettings = bleca.getConfigSettingsToUpsert();
-    if (upsertConfigSettings.size() > bufferThreshold)
-    {
-        bulkUpsertConfigSettings(upsertConfigSettings);
-        upsertConfigSettings.clear();
-    }
-    auto& upsertContractData = bleca.getContractDataToUpsert();
-    if (upsertContractData.size() > bufferThreshold)
-    {
-        bulkUpsertContractData(upsertContractData);
-        upsertContractData.clear();
-    }
-    auto& deleteContractData = bleca.getContractDataToDelete();
-    if (deleteContractData.size() > bufferThreshold)
-    {
-        bulkDeleteContractData(deleteContractData, cons);
-        deleteContractData.clear();
-    }
+    std::vector<BulkOperationPreparer> preparers;
+    auto queue = [&](std::vector<EntryIterator>& entries, auto prepare) {
+        if (entries.size() > bufferThreshold)
+        {
+            preparers.emplace_back([prepare, batch = std::move(entries)]() {
+                return prepare(batch);
+            });
+            entries.clear();
+        }
+    };
+    auto queueDelete = [&](std::vector<EntryIterator>& entries, auto prepare) {
+        queue(entries,
+              [this, prepare, cons](std::vector<EntryIterator> const& batch) {
+                  return (this->*prepare)(batch, cons);
+              });
+    };
+    auto queueUpsert = [&](std::vector<EntryIterator>& entries, auto prepare) {
+        queue(entries,
+              [this, prepare](std::vector<EntryIterator> const& batch) {
+                  return (this->*prepare)(batch);
+              });
+    };
 
-    auto& upsertContractCode = bleca.getContractCodeToUpsert();
-    if (upsertContractCode.size() > bufferThreshold)
-    {
-        bulkUpsertContractCode(upsertContractCode);
-        upsertContractCode.clear();
-    }
-    auto& deleteContractCode = bleca.getContractCodeToDelete();
-    if (deleteContractCode.size() > bufferThreshold)
-    {
-        bulkDeleteContractCode(deleteContractCode, cons);
-        deleteContractCode.clear();
-    }
+    queueUpsert(bleca.getAccountsToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertAccounts);
+    queueDelete(bleca.getAccountsToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteAccounts);
+    queueUpsert(bleca.getTrustLinesToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertTrustLines);
+    queueDelete(bleca.getTrustLinesToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteTrustLines);
+    queueUpsert(bleca.getOffersToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertOffers);
+    queueDelete(bleca.getOffersToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteOffers);
+    queueUpsert(bleca.getAccountDataToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertAccountData);
+    queueDelete(bleca.getAccountDataToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteAccountData);
+    queueUpsert(bleca.getClaimableBalanceToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertClaimableBalance);
+    queueDelete(bleca.getClaimableBalanceToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteClaimableBalance);
+    queueUpsert(bleca.getLiquidityPoolToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertLiquidityPool);
+    queueDelete(bleca.getLiquidityPoolToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteLiquidityPool);
+    queueUpsert(bleca.getConfigSettingsToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertConfigSettings);
+    queueUpsert(bleca.getContractDataToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertContractData);
+    queueDelete(bleca.getContractDataToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteContractData);
+    queueUpsert(bleca.getContractCodeToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertContractCode);
+    queueDelete(bleca.getContractCodeToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteContractCode);
+    queueUpsert(bleca.getTTLToUpsert(),
+                &LedgerTxnRoot::Impl::prepareBulkUpsertTTL);
+    queueDelete(bleca.getTTLToDelete(),
+                &LedgerTxnRoot::Impl::prepareBulkDeleteTTL);
+
+    runBulkOperations(preparers);
+}
 
-    auto& upsertTTL = bleca.getTTLToUpsert();
-    if (upsertTTL.size() > bufferThreshold)
-    {
-        bulkUpsertTTL(upsertTTL);
-        upsertTTL.clear();
+void
+LedgerTxnRoot::Impl::runBulkOperations(
+    std::vector<BulkOperationPreparer>& preparers)
+{
+    ZoneScoped;
+    auto& db = mApp.getDatabase();
+    auto const& cfg = mApp.getConfig();
+    size_t workers =
+        cfg.WORKER_THREADS > 0 ? static_cast<size_t>(cfg.WORKER_THREADS) : 0;
+    if (!cfg.PARALLEL_LEDGER_COMMIT_ENCODING || preparers.size() < 2 ||
+        workers == 0)
+    {
+        for (auto const& prepare : preparers)
+        {
+            auto op = prepare();
+            db.doDatabaseTypeSpecificOperation(*op);
+        }
+        return;
     }
 
-    auto& deleteTTL = bleca.getTTLToDelete();
-    if (deleteTTL.size() > bufferThreshold)
+    std::vector<BulkOperationPtr> ops(preparers.size());
+    parallelForBatches(
+        mApp, preparers.size(), 1,
+        [&](size_t, size_t i, size_t) { ops[i] = preparers[i](); },
+        "LedgerTxnRoot: prepare bulk write", BackgroundPriority::HIGH);
+
+    for (auto const& op : ops)
     {
-        bulkDeleteTTL(deleteTTL, cons);
-        deleteTTL.clear();
+        db.doDatabaseTypeSpecificOperation(*op);
     }
 }
 
@@ -2726,13 +2982,31 @@ LedgerTxnRoot::Impl::commitChild(EntryIterator iter,
     auto childHeader = std::make_unique<LedgerHeader>(mChild->getHeader());
 
     auto bucketListDBEnabled = mApp.getConfig().isUsingBucketListDB();
+    auto offersInMemory = mApp.getConfig().isUsingInMemoryOffers();
     auto bleca = BulkLedgerEntryChangeAccumulator();
+    // Offer changes to apply to mOrderBookIndex once the commit succeeds, with
+    // nullptr for erased offers. With IN_MEMORY_OFFERS they are not written to
+    // SQL at all.
+    std::vector<std::pair<int64_t, std::shared_ptr<LedgerEntry const>>>
+        offerChanges;
     [[maybe_unused]] int64_t counter{0};
     try
     {
         while ((bool)iter)
         {
-            if (bleca.accumulate(iter, bucketListDBEnabled))
+            bool isOffer =
+                iter.key().type() == InternalLedgerEntryType::LEDGER_ENTRY &&
+                iter.key().ledgerKey().type() == OFFER;
+            if (isOffer && (mOrderBookIndex || offersInMemory))
+            {
+                offerChanges.emplace_back(
+                    iter.key().ledgerKey().offer().offerID,
+                    iter.entryExists() ? std::make_shared<LedgerEntry const>(
+                                             iter.entry().ledgerEntry())
+                                       : nullptr);
+            }
+            if (!(isOffer && offersInMemory) &&
+                bleca.accumulate(iter, bucketListDBEnabled))
             {
                 ++counter;
             }
@@ -2765,20 +3039,52 @@ LedgerTxnRoot::Impl::commitChild(EntryIterator iter,
             "unknown fatal error during commit to LedgerTxnRoot");
     }
 
-    // Clearing the cache does not throw
-    mBestOffers.clear();
-    mEntryCache.clear();
-
-    // std::unique_ptr<...>::reset does not throw
-    mTransaction.reset();
-
-    // std::unique_ptr<...>::swap does not throw
-    mHeader.swap(childHeader);
-    mChild = nullptr;
-
-    mPrefetchHits = 0;
-    mPrefetchMisses = 0;
-}
+    // With IN_MEMORY_OFFERS the index is the only store of offers, so it is
+    // loaded before applying the changes. The BucketList already has them
+    // when the index is loaded from it, which upsert and erase tolerate.
+    if (offersInMemory && !offerChanges.empty())
+    {
+        getOrderBookIndex();
+    }
+    if (mOrderBookIndex)
+    {
+        try
+        {
+            for (auto const& change : offerChanges)
+            {
+                if (change.second)
+                {
+                    mOrderBookIndex->upsert(change.second);
+                }
+                else
+                {
+                    mOrderBookIndex->erase(change.first);
+                }
+            }
+        }
+        catch (...)
+        {
+            // The index is reloaded from the database (or the BucketList) on
+            // next use
+            mOrderBookIndex.reset();
+        }
+    }
+
+    // Marking meters and clearing the cache do not throw
+    reportEntryCacheMetrics();
+    mBestOffers.clear();
+    mEntryCache.clear();
+
+    // std::unique_ptr<...>::reset does not throw
+    mTransaction.reset();
+
+    // std::unique_ptr<...>::swap does not throw
+    mHeader.swap(childHeader);
+    mChild = nullptr;
+
+    mPrefetchHits = 0;
+    mPrefetchMisses = 0;
+}
 
 std::string
 LedgerTxnRoot::Impl::tableFromLedgerEntryType(LedgerEntryType let)
@@ -2822,6 +3128,11 @@ LedgerTxnRoot::Impl::countObjects(LedgerEntryType let) const
     using namespace soci;
     throwIfChild();
 
+    if (let == OFFER && mApp.getConfig().isUsingInMemoryOffers())
+    {
+        return getOrderBookIndex()->size();
+    }
+
     std::string query =
         "SELECT COUNT(*) FROM " + tableFromLedgerEntryType(let) + ";";
     uint64_t count = 0;
@@ -2867,6 +3178,7 @@ LedgerTxnRoot::Impl::deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const
     throwIfChild();
     mEntryCache.clear();
     mBestOffers.clear();
+    mOrderBookIndex.reset();
 
     for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
     {
@@ -2937,6 +3249,18 @@ LedgerTxnRoot::dropTTL(bool rebuild)
     mImpl->dropTTL(rebuild);
 }
 
+void
+LedgerTxnRoot::beginBulkPopulate(bool entriesAreUnique)
+{
+    mImpl->beginBulkPopulate(entriesAreUnique);
+}
+
+void
+LedgerTxnRoot::endBulkPopulate()
+{
+    mImpl->endBulkPopulate();
+}
+
 uint32_t
 LedgerTxnRoot::prefetch(UnorderedSet<LedgerKey> const& keys)
 {
@@ -2969,127 +3293,153 @@ LedgerTxnRoot::Impl::prefetch(UnorderedSet<LedgerKey> const& keys)
     if (mApp.getConfig().isUsingBucketListDB())
     {
         LedgerKeySet keysToSearch;
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> offers;
         for (auto const& key : keys)
         {
-            insertIfNotLoaded(keysToSearch, key);
+            if (key.type() == OFFER &&
+                mApp.getConfig().isUsingInMemoryOffers())
+            {
+                if (!mEntryCache.exists(key, false))
+                {
+                    offers.emplace(key, loadOfferFromIndex(key));
+                }
+            }
+            else
+            {
+                insertIfNotLoaded(keysToSearch, key);
+            }
         }
+        cacheResult(offers);
 
         auto blLoad = getSearchableBucketListSnapshot().loadKeys(keysToSearch);
         cacheResult(populateLoadedEntries(keysToSearch, blLoad));
     }
     else
     {
-        UnorderedSet<LedgerKey> accounts;
-        UnorderedSet<LedgerKey> offers;
-        UnorderedSet<LedgerKey> trustlines;
-        UnorderedSet<LedgerKey> data;
-        UnorderedSet<LedgerKey> claimablebalance;
-        UnorderedSet<LedgerKey> liquiditypool;
-        UnorderedSet<LedgerKey> contractdata;
-        UnorderedSet<LedgerKey> configSettings;
-        UnorderedSet<LedgerKey> contractCode;
-        UnorderedSet<LedgerKey> ttl;
-
+        UnorderedSet<LedgerKey> keysToLoad;
         for (auto const& key : keys)
         {
-            switch (key.type())
+            insertIfNotLoaded(keysToLoad, key);
+        }
+        bulkLoadFromDatabase(keysToLoad, cacheResult);
+    }
+
+    return total;
+}
+
+void
+LedgerTxnRoot::Impl::bulkLoadFromDatabase(UnorderedSet<LedgerKey> const& keys,
+                                          BulkLoadHandler const& onLoad) const
+{
+    ZoneScoped;
+    UnorderedSet<LedgerKey> accounts;
+    UnorderedSet<LedgerKey> offers;
+    UnorderedSet<LedgerKey> trustlines;
+    UnorderedSet<LedgerKey> data;
+    UnorderedSet<LedgerKey> claimablebalance;
+    UnorderedSet<LedgerKey> liquiditypool;
+    UnorderedSet<LedgerKey> contractdata;
+    UnorderedSet<LedgerKey> configSettings;
+    UnorderedSet<LedgerKey> contractCode;
+    UnorderedSet<LedgerKey> ttl;
+
+    for (auto const& key : keys)
+    {
+        switch (key.type())
+        {
+        case ACCOUNT:
+            accounts.insert(key);
+            if (accounts.size() == mBulkLoadBatchSize)
             {
-            case ACCOUNT:
-                insertIfNotLoaded(accounts, key);
-                if (accounts.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadAccounts(accounts));
-                    accounts.clear();
-                }
-                break;
-            case OFFER:
-                insertIfNotLoaded(offers, key);
-                if (offers.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadOffers(offers));
-                    offers.clear();
-                }
-                break;
-            case TRUSTLINE:
-                insertIfNotLoaded(trustlines, key);
-                if (trustlines.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadTrustLines(trustlines));
-                    trustlines.clear();
-                }
-                break;
-            case DATA:
-                insertIfNotLoaded(data, key);
-                if (data.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadData(data));
-                    data.clear();
-                }
-                break;
-            case CLAIMABLE_BALANCE:
-                insertIfNotLoaded(claimablebalance, key);
-                if (claimablebalance.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadClaimableBalance(claimablebalance));
-                    claimablebalance.clear();
-                }
-                break;
-            case LIQUIDITY_POOL:
-                insertIfNotLoaded(liquiditypool, key);
-                if (liquiditypool.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadLiquidityPool(liquiditypool));
-                    liquiditypool.clear();
-                }
-                break;
-            case CONTRACT_DATA:
-                insertIfNotLoaded(contractdata, key);
-                if (contractdata.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadContractData(contractdata));
-                    contractdata.clear();
-                }
-                break;
-            case CONTRACT_CODE:
-                insertIfNotLoaded(contractCode, key);
-                if (contractCode.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadContractCode(contractCode));
-                    contractCode.clear();
-                }
-                break;
-            case CONFIG_SETTING:
-                insertIfNotLoaded(configSettings, key);
-                if (configSettings.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadConfigSettings(configSettings));
-                    configSettings.clear();
-                }
-                break;
-            case TTL:
-                insertIfNotLoaded(ttl, key);
-                if (ttl.size() == mBulkLoadBatchSize)
-                {
-                    cacheResult(bulkLoadTTL(ttl));
-                    ttl.clear();
-                }
+                onLoad(bulkLoadAccounts(accounts));
+                accounts.clear();
+            }
+            break;
+        case OFFER:
+            offers.insert(key);
+            if (offers.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadOffers(offers));
+                offers.clear();
+            }
+            break;
+        case TRUSTLINE:
+            trustlines.insert(key);
+            if (trustlines.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadTrustLines(trustlines));
+                trustlines.clear();
+            }
+            break;
+        case DATA:
+            data.insert(key);
+            if (data.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadData(data));
+                data.clear();
+            }
+            break;
+        case CLAIMABLE_BALANCE:
+            claimablebalance.insert(key);
+            if (claimablebalance.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadClaimableBalance(claimablebalance));
+                claimablebalance.clear();
+            }
+            break;
+        case LIQUIDITY_POOL:
+            liquiditypool.insert(key);
+            if (liquiditypool.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadLiquidityPool(liquiditypool));
+                liquiditypool.clear();
+            }
+            break;
+        case CONTRACT_DATA:
+            contractdata.insert(key);
+            if (contractdata.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadContractData(contractdata));
+                contractdata.clear();
+            }
+            break;
+        case CONTRACT_CODE:
+            contractCode.insert(key);
+            if (contractCode.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadContractCode(contractCode));
+                contractCode.clear();
+            }
+            break;
+        case CONFIG_SETTING:
+            configSettings.insert(key);
+            if (configSettings.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadConfigSettings(configSettings));
+                configSettings.clear();
+            }
+            break;
+        case TTL:
+            ttl.insert(key);
+            if (ttl.size() == mBulkLoadBatchSize)
+            {
+                onLoad(bulkLoadTTL(ttl));
+                ttl.clear();
             }
         }
-
-        //  Prefetch whatever is remaining
-        cacheResult(bulkLoadAccounts(accounts));
-        cacheResult(bulkLoadOffers(offers));
-        cacheResult(bulkLoadTrustLines(trustlines));
-        cacheResult(bulkLoadData(data));
-        cacheResult(bulkLoadClaimableBalance(claimablebalance));
-        cacheResult(bulkLoadLiquidityPool(liquiditypool));
-        cacheResult(bulkLoadConfigSettings(configSettings));
-        cacheResult(bulkLoadContractData(contractdata));
-        cacheResult(bulkLoadContractCode(contractCode));
-        cacheResult(bulkLoadTTL(ttl));
     }
 
-    return total;
+    // Load whatever is remaining
+    onLoad(bulkLoadAccounts(accounts));
+    onLoad(bulkLoadOffers(offers));
+    onLoad(bulkLoadTrustLines(trustlines));
+    onLoad(bulkLoadData(data));
+    onLoad(bulkLoadClaimableBalance(claimablebalance));
+    onLoad(bulkLoadLiquidityPool(liquiditypool));
+    onLoad(bulkLoadConfigSettings(configSettings));
+    onLoad(bulkLoadContractData(contractdata));
+    onLoad(bulkLoadContractCode(contractCode));
+    onLoad(bulkLoadTTL(ttl));
 }
 
 double
@@ -3109,6 +3459,42 @@ LedgerTxnRoot::Impl::getPrefetchHitRate() const
            (mPrefetchMisses + mPrefetchHits);
 }
 
+void
+LedgerTxnRoot::addMemoryFootprint(MemoryFootprint& footprint) const
+{
+    mImpl->addMemoryFootprint(footprint);
+}
+
+void
+LedgerTxnRoot::Impl::addMemoryFootprint(MemoryFootprint& footprint) const
+{
+    footprint["ledger.entry-cache"] =
+        mEntryCache.estimatedBytes() + mEntryCache.size() * sizeof(LedgerEntry);
+
+    // Deques know their size, so this only visits each asset pair
+    size_t offers = 0;
+    for (auto const& kv : mBestOffers)
+    {
+        offers += kv.second->bestOffers.size();
+    }
+    footprint["ledger.best-offers"] =
+        mBestOffers.size() * (nodeBytes<BestOffers::value_type>() +
+                              sizeof(BestOffersEntry)) +
+        offers * sizeof(LedgerEntry);
+}
+
+void
+LedgerTxnRoot::setEntryCacheSize(size_t size)
+{
+    mImpl->setEntryCacheSize(size);
+}
+
+void
+LedgerTxnRoot::Impl::setEntryCacheSize(size_t size)
+{
+    mEntryCache.setMaxSize(size);
+}
+
 void
 LedgerTxnRoot::prepareNewObjects(size_t s)
 {
@@ -3132,7 +3518,17 @@ LedgerTxnRoot::Impl::getAllOffers()
     std::vector<LedgerEntry> offers;
     try
     {
-        offers = loadAllOffers();
+        if (mApp.getConfig().isUsingInMemoryOffers())
+        {
+            for (auto const& offer : getOrderBookIndex()->getAllOffers())
+            {
+                offers.emplace_back(*offer);
+            }
+        }
+        else
+        {
+            offers = loadAllOffers();
+        }
     }
     catch (std::exception& e)
     {
@@ -3309,6 +3705,21 @@ LedgerTxnRoot::Impl::loadNextBestOffersIntoCache(BestOffersEntryPtr cached,
     return iter;
 }
 
+// Adds the keys of the entries needed to cross oe
+static void
+addOfferDependencies(OfferEntry const& oe, UnorderedSet<LedgerKey>& keys)
+{
+    keys.emplace(accountKey(oe.sellerID));
+    if (oe.buying.type() != ASSET_TYPE_NATIVE)
+    {
+        keys.emplace(trustlineKey(oe.sellerID, oe.buying));
+    }
+    if (oe.selling.type() != ASSET_TYPE_NATIVE)
+    {
+        keys.emplace(trustlineKey(oe.sellerID, oe.selling));
+    }
+}
+
 void
 LedgerTxnRoot::Impl::populateEntryCacheFromBestOffers(
     std::deque<LedgerEntry>::const_iterator iter,
@@ -3317,16 +3728,7 @@ LedgerTxnRoot::Impl::populateEntryCacheFromBestOffers(
     UnorderedSet<LedgerKey> toPrefetch;
     for (; iter != end; ++iter)
     {
-        auto const& oe = iter->data.offer();
-        toPrefetch.emplace(accountKey(oe.sellerID));
-        if (oe.buying.type() != ASSET_TYPE_NATIVE)
-        {
-            toPrefetch.emplace(trustlineKey(oe.sellerID, oe.buying));
-        }
-        if (oe.selling.type() != ASSET_TYPE_NATIVE)
-        {
-            toPrefetch.emplace(trustlineKey(oe.sellerID, oe.selling));
-        }
+        addOfferDependencies(iter->data.offer(), toPrefetch);
     }
     prefetch(toPrefetch);
 }
@@ -3376,6 +3778,11 @@ LedgerTxnRoot::Impl::getBestOffer(Asset const& buying, Asset const& selling,
 {
     ZoneScoped;
 
+    if (auto index = getOrderBookIndex())
+    {
+        return getBestOfferFromIndex(*index, buying, selling, worseThan);
+    }
+
     // Note: Elements of mBestOffers are properly sorted lists of the best
     // offers for a certain asset pair. This function maintaints the invariant
     // that the lists of best offers remain properly sorted. The sort order is
@@ -3446,34 +3853,48 @@ LedgerTxnRoot::Impl::getOffersByAccountAndAsset(AccountID const& account,
                                                 Asset const& asset)
 {
     ZoneScoped;
-    std::vector<LedgerEntry> offers;
-    try
+    std::vector<std::shared_ptr<LedgerEntry const>> offers;
+    if (auto index = getOrderBookIndex())
     {
-        offers = loadOffersByAccountAndAsset(account, asset);
-    }
-    catch (std::exception& e)
-    {
-        printErrorAndAbort("fatal error when getting offers by account and "
-                           "asset from LedgerTxnRoot: ",
-                           e.what());
+        offers = index->getOffersByAccountAndAsset(account, asset);
+        if (mApp.getConfig().IN_MEMORY_ORDER_BOOK_CHECKS)
+        {
+            checkIndexOffersByAccountAndAsset(account, asset, offers);
+        }
     }
-    catch (...)
+    else
     {
-        printErrorAndAbort("unknown fatal error when getting offers by account "
-                           "and asset from LedgerTxnRoot");
+        try
+        {
+            for (auto& offer : loadOffersByAccountAndAsset(account, asset))
+            {
+                offers.emplace_back(
+                    std::make_shared<LedgerEntry const>(std::move(offer)));
+            }
+        }
+        catch (std::exception& e)
+        {
+            printErrorAndAbort("fatal error when getting offers by account "
+                               "and asset from LedgerTxnRoot: ",
+                               e.what());
+        }
+        catch (...)
+        {
+            printErrorAndAbort("unknown fatal error when getting offers by "
+                               "account and asset from LedgerTxnRoot");
+        }
     }
 
     UnorderedSet<LedgerKey> toPrefetch;
     UnorderedMap<LedgerKey, LedgerEntry> res(offers.size());
     for (auto const& offer : offers)
     {
-        auto key = LedgerEntryKey(offer);
-        res.emplace(key, offer);
+        auto key = LedgerEntryKey(*offer);
+        res.emplace(key, *offer);
 
-        auto le = std::make_shared<LedgerEntry const>(offer);
-        putInEntryCache(key, le, LoadType::IMMEDIATE);
+        putInEntryCache(key, offer, LoadType::IMMEDIATE);
 
-        auto const& oe = offer.data.offer();
+        auto const& oe = offer->data.offer();
         if (oe.buying.type() != ASSET_TYPE_NATIVE)
         {
             toPrefetch.emplace(trustlineKey(oe.sellerID, oe.buying));
@@ -3488,6 +3909,143 @@ LedgerTxnRoot::Impl::getOffersByAccountAndAsset(AccountID const& account,
     return res;
 }
 
+OrderBookIndex*
+LedgerTxnRoot::Impl::getOrderBookIndex() const
+{
+    auto offersInMemory = mApp.getConfig().isUsingInMemoryOffers();
+    if (!mApp.getConfig().IN_MEMORY_ORDER_BOOK && !offersInMemory)
+    {
+        return nullptr;
+    }
+    if (!mOrderBookIndex)
+    {
+        ZoneNamedN(loadZone, "load order book index", true);
+        try
+        {
+            mOrderBookIndex = std::make_unique<OrderBookIndex>(
+                offersInMemory
+                    ? getSearchableBucketListSnapshot().loadAllOffers()
+                    : loadAllOffers());
+        }
+        catch (std::exception& e)
+        {
+            printErrorAndAbort("fatal error when loading the order book into "
+                               "LedgerTxnRoot: ",
+                               e.what());
+        }
+        catch (...)
+        {
+            printErrorAndAbort("unknown fatal error when loading the order "
+                               "book into LedgerTxnRoot");
+        }
+        CLOG_INFO(Ledger, "Loaded {} offers into the in-memory order book",
+                  mOrderBookIndex->size());
+    }
+    return mOrderBookIndex.get();
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnRoot::Impl::loadOfferFromIndex(LedgerKey const& key) const
+{
+    auto offer = getOrderBookIndex()->getOffer(key.offer().offerID);
+    if (offer && offer->data.offer().sellerID == key.offer().sellerID)
+    {
+        return offer;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnRoot::Impl::getBestOfferFromIndex(OrderBookIndex const& index,
+                                           Asset const& buying,
+                                           Asset const& selling,
+                                           OfferDescriptor const* worseThan)
+{
+    auto offers = index.getBestOffers(buying, selling, worseThan, 1);
+    auto best = offers.empty() ? nullptr : offers.front();
+    if (mApp.getConfig().IN_MEMORY_ORDER_BOOK_CHECKS)
+    {
+        checkIndexBestOffer(buying, selling, worseThan, best);
+    }
+    if (!best)
+    {
+        return nullptr;
+    }
+
+    // As when loading best offers from SQL, make sure that the entries needed
+    // to cross this offer and the ones behind it are in the cache
+    if (areEntriesMissingInCacheForOffer(best->data.offer()))
+    {
+        UnorderedSet<LedgerKey> toPrefetch;
+        for (auto const& offer : index.getBestOffers(buying, selling, worseThan,
+                                                     mMaxBestOffersBatchSize))
+        {
+            addOfferDependencies(offer->data.offer(), toPrefetch);
+        }
+        prefetch(toPrefetch);
+    }
+
+    putInEntryCache(LedgerEntryKey(*best), best, LoadType::IMMEDIATE);
+    return best;
+}
+
+void
+LedgerTxnRoot::Impl::checkIndexBestOffer(
+    Asset const& buying, Asset const& selling, OfferDescriptor const* worseThan,
+    std::shared_ptr<LedgerEntry const> const& best)
+{
+    std::deque<LedgerEntry> offers;
+    if (worseThan)
+    {
+        loadBestOffers(offers, buying, selling, *worseThan, 1);
+    }
+    else
+    {
+        loadBestOffers(offers, buying, selling, 1);
+    }
+
+    if (offers.empty() != !best)
+    {
+        printErrorAndAbort(best ? "in-memory order book has a best offer "
+                                  "that is not in the database"
+                                : "in-memory order book is missing the best "
+                                  "offer in the database");
+    }
+    if (best && offers.front() != *best)
+    {
+        printErrorAndAbort("in-memory order book best offer does not match "
+                           "the database");
+    }
+}
+
+void
+LedgerTxnRoot::Impl::checkIndexOffersByAccountAndAsset(
+    AccountID const& account, Asset const& asset,
+    std::vector<std::shared_ptr<LedgerEntry const>> const& offers)
+{
+    auto expected = loadOffersByAccountAndAsset(account, asset);
+    if (expected.size() != offers.size())
+    {
+        printErrorAndAbort("in-memory order book has the wrong number of "
+                           "offers for an account and asset");
+    }
+
+    UnorderedMap<int64_t, LedgerEntry const*> byID;
+    for (auto const& offer : offers)
+    {
+        byID.emplace(offer->data.offer().offerID, offer.get());
+    }
+    for (auto const& le : expected)
+    {
+        auto it = byID.find(le.data.offer().offerID);
+        if (it == byID.end() || *it->second != le)
+        {
+            printErrorAndAbort("in-memory order book offers for an account "
+                               "and asset do not match the database");
+        }
+    }
+}
+
 UnorderedMap<LedgerKey, LedgerEntry>
 LedgerTxnRoot::getPoolShareTrustLinesByAccountAndAsset(AccountID const& account,
                                                        Asset const& asset)
@@ -3623,7 +4181,11 @@ LedgerTxnRoot::Impl::getNewestVersion(InternalLedgerKey const& gkey) const
     std::shared_ptr<LedgerEntry const> entry;
     try
     {
-        if (mApp.getConfig().isUsingBucketListDB() && key.type() != OFFER)
+        if (key.type() == OFFER && mApp.getConfig().isUsingInMemoryOffers())
+        {
+            entry = loadOfferFromIndex(key);
+        }
+        else if (mApp.getConfig().isUsingBucketListDB() && key.type() != OFFER)
         {
             entry = getSearchableBucketListSnapshot().getLedgerEntry(key);
         }
@@ -3693,6 +4255,120 @@ LedgerTxnRoot::Impl::getNewestVersion(InternalLedgerKey const& gkey) const
     }
 }
 
+UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+LedgerTxnRoot::getNewestVersions(
+    UnorderedSet<InternalLedgerKey> const& keys) const
+{
+    return mImpl->getNewestVersions(keys);
+}
+
+UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+LedgerTxnRoot::Impl::getNewestVersions(
+    UnorderedSet<InternalLedgerKey> const& keys) const
+{
+    ZoneScoped;
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+        res;
+    UnorderedSet<LedgerKey> misses;
+    for (auto const& gkey : keys)
+    {
+        // Right now, only LEDGER_ENTRY are recorded in the SQL database
+        if (gkey.type() != InternalLedgerEntryType::LEDGER_ENTRY)
+        {
+            res.emplace(gkey, nullptr);
+        }
+        else if (mEntryCache.exists(gkey.ledgerKey()))
+        {
+            res.emplace(gkey, getFromEntryCache(gkey.ledgerKey()));
+        }
+        else
+        {
+            ++mPrefetchMisses;
+            misses.emplace(gkey.ledgerKey());
+        }
+    }
+    ZoneValue(static_cast<int64_t>(misses.size()));
+
+    auto cacheResult =
+        [&](UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+                loaded) {
+            for (auto const& item : loaded)
+            {
+                putInEntryCache(item.first, item.second, LoadType::IMMEDIATE);
+                std::shared_ptr<InternalLedgerEntry const> entry;
+                if (item.second)
+                {
+                    entry = std::make_shared<InternalLedgerEntry const>(
+                        *item.second);
+                }
+                res.emplace(item.first, entry);
+            }
+        };
+
+    try
+    {
+        if (mApp.getConfig().isUsingBucketListDB())
+        {
+            // As in getNewestVersion, offers are read from SQL, or from
+            // memory with IN_MEMORY_OFFERS
+            LedgerKeySet keysToSearch;
+            UnorderedSet<LedgerKey> offers;
+            for (auto const& key : misses)
+            {
+                if (key.type() == OFFER)
+                {
+                    offers.emplace(key);
+                }
+                else
+                {
+                    keysToSearch.emplace(key);
+                }
+            }
+
+            if (!keysToSearch.empty())
+            {
+                auto blLoad =
+                    getSearchableBucketListSnapshot().loadKeys(keysToSearch);
+                cacheResult(populateLoadedEntries(keysToSearch, blLoad));
+            }
+            if (mApp.getConfig().isUsingInMemoryOffers())
+            {
+                UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
+                    loaded;
+                for (auto const& key : offers)
+                {
+                    loaded.emplace(key, loadOfferFromIndex(key));
+                }
+                cacheResult(loaded);
+            }
+            else
+            {
+                bulkLoadFromDatabase(offers, cacheResult);
+            }
+        }
+        else
+        {
+            bulkLoadFromDatabase(misses, cacheResult);
+        }
+    }
+    catch (NonSociRelatedException&)
+    {
+        throw;
+    }
+    catch (std::exception& e)
+    {
+        printErrorAndAbort(
+            "fatal error when loading ledger entries from LedgerTxnRoot: ",
+            e.what());
+    }
+    catch (...)
+    {
+        printErrorAndAbort("unknown fatal error when loading ledger entries "
+                           "from LedgerTxnRoot");
+    }
+    return res;
+}
+
 void
 LedgerTxnRoot::rollbackChild() noexcept
 {
@@ -3754,6 +4430,24 @@ LedgerTxnRoot::Impl::getFromEntryCache(LedgerKey const& key) const
     }
 }
 
+void
+LedgerTxnRoot::Impl::reportEntryCacheMetrics() const
+{
+    for (auto& kv : mEntryCacheHitMeters)
+    {
+        auto type = kv.first;
+        auto const& counters =
+            mEntryCache.getCounters(static_cast<size_t>(type));
+        auto& reported = mReportedEntryCacheCounters.at(type);
+        kv.second.Mark(counters.mHits - reported.mHits);
+        mEntryCacheMissMeters.at(type).Mark(counters.mMisses -
+                                            reported.mMisses);
+        mEntryCacheEvictMeters.at(type).Mark(counters.mEvicts -
+                                             reported.mEvicts);
+        reported = counters;
+    }
+}
+
 void
 LedgerTxnRoot::Impl::putInEntryCache(
     LedgerKey const& key, std::shared_ptr<LedgerEntry const> const& entry,
@@ -7,6 +7,7 @@
 #include "ledger/InternalLedgerEntry.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "util/MemoryFootprint.h"
 #include "util/UnorderedMap.h"
 #include "util/UnorderedSet.h"
 #include "util/types.h"
@@ -346,6 +347,10 @@ class EntryIterator
 
     std::unique_ptr<AbstractImpl> const& getImpl() const;
 
+    // LedgerTxn inspects the implementation to take over a committing child's
+    // entries
+    friend class LedgerTxn;
+
   public:
     EntryIterator(std::unique_ptr<AbstractImpl>&& impl);
 
@@ -363,6 +368,9 @@ class EntryIterator
     bool entryExists() const;
 
     InternalLedgerKey const& key() const;
+
+    // Upper bound on the number of entries left to iterate, or 0 if unknown
+    size_t sizeHint() const;
 };
 
 void validateTrustLineKey(uint32_t ledgerVersion, LedgerKey const& key);
@@ -436,6 +444,15 @@ class AbstractLedgerTxnParent
     virtual std::shared_ptr<InternalLedgerEntry const>
     getNewestVersion(InternalLedgerKey const& key) const = 0;
 
+    // getNewestVersions is the batch form of getNewestVersion, returning the
+    // newest version (or nullptr) of every key in keys. The keys that are not
+    // stored in this AbstractLedgerTxnParent are passed to a single
+    // getNewestVersions call on its parent, so that the keys found in no
+    // LedgerTxn reach LedgerTxnRoot together and can be read in bulk.
+    virtual UnorderedMap<InternalLedgerKey,
+                         std::shared_ptr<InternalLedgerEntry const>>
+    getNewestVersions(UnorderedSet<InternalLedgerKey> const& keys) const = 0;
+
     // Return the count of the number of ledger objects of type `let`. Will
     // throw when called on anything other than a (real or stub) root LedgerTxn.
     virtual uint64_t countObjects(LedgerEntryType let) const = 0;
@@ -491,6 +508,16 @@ class AbstractLedgerTxnParent
     // anything other than a (real or stub) root LedgerTxn.
     virtual void dropTTL(bool rebuild) = 0;
 
+    // Mark the start and end of populating the database with ledger state from
+    // buckets, as done by ApplyBucketsWork. Meanwhile, committed entries may
+    // be written to the database by faster means than upserts. If
+    // entriesAreUnique, the caller promises that no entry is committed twice
+    // until endBulkPopulate, so tables that are empty when population begins
+    // can be filled with plain inserts. Will throw when called on anything
+    // other than a (real or stub) root LedgerTxn.
+    virtual void beginBulkPopulate(bool entriesAreUnique) = 0;
+    virtual void endBulkPopulate() = 0;
+
     // Return the current cache hit rate for prefetched ledger entries, as a
     // fraction from 0.0 to 1.0. Will throw when called on anything other than a
     // (real or stub) root LedgerTxn.
@@ -571,6 +598,14 @@ class AbstractLedgerTxn : public AbstractLedgerTxnParent
     //     then it will still be recorded after calling loadWithoutRecord.
     //     Throws if there is an active LedgerTxnEntry associated with this
     //     key.
+    // - loadBatch:
+    //     Equivalent to calling load on every key in keys, in order, but
+    //     looks all the keys up through the parents in a single pass so that
+    //     those not found in any AbstractLedgerTxn are loaded from the
+    //     database together. Returns one LedgerTxnEntry per key, which is
+    //     empty if load would have returned nullptr. Throws if keys contains
+    //     duplicates or if any key has an active LedgerTxnEntry, in which case
+    //     nothing is loaded.
     // All of these functions throw if the AbstractLedgerTxn is sealed or if
     // the AbstractLedgerTxn has a child.
     virtual LedgerTxnHeader loadHeader() = 0;
@@ -579,6 +614,8 @@ class AbstractLedgerTxn : public AbstractLedgerTxnParent
     virtual LedgerTxnEntry load(InternalLedgerKey const& key) = 0;
     virtual ConstLedgerTxnEntry
     loadWithoutRecord(InternalLedgerKey const& key) = 0;
+    virtual std::vector<LedgerTxnEntry>
+    loadBatch(std::vector<InternalLedgerKey> const& keys) = 0;
 
     // Somewhat unsafe, non-recommended access methods: for use only during
     // bulk-loading as in catchup from buckets. These methods set an entry
@@ -607,6 +644,10 @@ class AbstractLedgerTxn : public AbstractLedgerTxnParent
     //     to the LedgerHeader) in a format convenient for answering queries
     //     about how specific entries and the header have changed. To be used
     //     for invariants.
+    // - getDeltaAndChanges
+    //     Same as getDelta and getChanges together, with a single pass over
+    //     the entries and a single lookup of the previous version of each.
+    //     To be used when both invariants and meta need the changes.
     // - getAllEntries
     //     extracts a list of keys that were created (init), updated (live) or
     //     deleted (dead) in this AbstractLedgerTxn. All these are to be
@@ -615,6 +656,8 @@ class AbstractLedgerTxn : public AbstractLedgerTxnParent
     // All of these functions throw if the AbstractLedgerTxn has a child.
     virtual LedgerEntryChanges getChanges() = 0;
     virtual LedgerTxnDelta getDelta() = 0;
+    virtual std::pair<LedgerTxnDelta, LedgerEntryChanges>
+    getDeltaAndChanges() = 0;
     virtual void getAllEntries(std::vector<LedgerEntry>& initEntries,
                                std::vector<LedgerEntry>& liveEntries,
                                std::vector<LedgerKey>& deadEntries) = 0;
@@ -730,6 +773,9 @@ class LedgerTxn : public AbstractLedgerTxn
 
     LedgerTxnDelta getDelta() override;
 
+    std::pair<LedgerTxnDelta, LedgerEntryChanges>
+    getDeltaAndChanges() override;
+
     UnorderedMap<LedgerKey, LedgerEntry>
     getOffersByAccountAndAsset(AccountID const& account,
                                Asset const& asset) override;
@@ -754,8 +800,15 @@ class LedgerTxn : public AbstractLedgerTxn
     std::shared_ptr<InternalLedgerEntry const>
     getNewestVersion(InternalLedgerKey const& key) const override;
 
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+    getNewestVersions(
+        UnorderedSet<InternalLedgerKey> const& keys) const override;
+
     LedgerTxnEntry load(InternalLedgerKey const& key) override;
 
+    std::vector<LedgerTxnEntry>
+    loadBatch(std::vector<InternalLedgerKey> const& keys) override;
+
     void createWithoutLoading(InternalLedgerEntry const& entry) override;
     void updateWithoutLoading(InternalLedgerEntry const& entry) override;
     void eraseWithoutLoading(InternalLedgerKey const& key) override;
@@ -798,6 +851,8 @@ class LedgerTxn : public AbstractLedgerTxn
     void dropContractCode(bool rebuild) override;
     void dropConfigSettings(bool rebuild) override;
     void dropTTL(bool rebuild) override;
+    void beginBulkPopulate(bool entriesAreUnique) override;
+    void endBulkPopulate() override;
 
     double getPrefetchHitRate() const override;
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
@@ -861,6 +916,8 @@ class LedgerTxnRoot : public AbstractLedgerTxnParent
     void dropContractCode(bool rebuild) override;
     void dropConfigSettings(bool rebuild) override;
     void dropTTL(bool rebuild) override;
+    void beginBulkPopulate(bool entriesAreUnique) override;
+    void endBulkPopulate() override;
 
 #ifdef BUILD_TESTS
     void resetForFuzzer() override;
@@ -890,11 +947,23 @@ class LedgerTxnRoot : public AbstractLedgerTxnParent
     std::shared_ptr<InternalLedgerEntry const>
     getNewestVersion(InternalLedgerKey const& key) const override;
 
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+    getNewestVersions(
+        UnorderedSet<InternalLedgerKey> const& keys) const override;
+
     void rollbackChild() noexcept override;
 
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
     double getPrefetchHitRate() const override;
 
+    // Adds the estimated memory held by the entry cache and the best offers
+    // cache to `footprint`
+    void addMemoryFootprint(MemoryFootprint& footprint) const;
+
+    // Resizes the entry cache, evicting entries if it shrinks. Used to give
+    // memory back under memory pressure.
+    void setEntryCacheSize(size_t size);
+
     void prepareNewObjects(size_t s) override;
 
 #ifdef BEST_OFFER_DEBUGGING
@@ -13,10 +13,10 @@
 #include "util/Decoder.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
 #include "util/types.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -439,24 +439,24 @@ class BulkDeleteAccountsOperation : public DatabaseTypeSpecificOperation<void>
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertAccounts(
-    std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertAccounts(
+    std::vector<EntryIterator> const& entries) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertAccountsOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertAccountsOperation>(
+        mApp.getDatabase(), entries);
 }
 
-void
-LedgerTxnRoot::Impl::bulkDeleteAccounts(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteAccounts(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkDeleteAccountsOperation op(mApp.getDatabase(), cons, entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteAccountsOperation>(
+        mApp.getDatabase(), cons, entries);
 }
 
 void
@@ -229,12 +229,12 @@ class BulkDeleteClaimableBalanceOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkDeleteClaimableBalance(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteClaimableBalance(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
-    BulkDeleteClaimableBalanceOperation op(mApp.getDatabase(), cons, entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteClaimableBalanceOperation>(
+        mApp.getDatabase(), cons, entries);
 }
 
 class BulkUpsertClaimableBalanceOperation
@@ -343,12 +343,12 @@ class BulkUpsertClaimableBalanceOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertClaimableBalance(
-    std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertClaimableBalance(
+    std::vector<EntryIterator> const& entries) const
 {
-    BulkUpsertClaimableBalanceOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertClaimableBalanceOperation>(
+        mApp.getDatabase(), entries);
 }
 
 void
@@ -264,12 +264,12 @@ class bulkUpsertConfigSettingsOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertConfigSettings(
-    std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertConfigSettings(
+    std::vector<EntryIterator> const& entries) const
 {
-    bulkUpsertConfigSettingsOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<bulkUpsertConfigSettingsOperation>(
+        mApp.getDatabase(), entries);
 }
 
 void
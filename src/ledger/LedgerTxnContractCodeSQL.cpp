@@ -236,12 +236,12 @@ class BulkDeleteContractCodeOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkDeleteContractCode(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteContractCode(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
-    BulkDeleteContractCodeOperation op(mApp.getDatabase(), cons, entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteContractCodeOperation>(
+        mApp.getDatabase(), cons, entries);
 }
 
 class BulkUpsertContractCodeOperation
@@ -347,12 +347,12 @@ class BulkUpsertContractCodeOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertContractCode(
-    std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertContractCode(
+    std::vector<EntryIterator> const& entries) const
 {
-    BulkUpsertContractCodeOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertContractCodeOperation>(
+        mApp.getDatabase(), entries);
 }
 
 void
@@ -293,12 +293,12 @@ class BulkDeleteContractDataOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkDeleteContractData(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteContractData(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
-    BulkDeleteContractDataOperation op(mApp.getDatabase(), cons, entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteContractDataOperation>(
+        mApp.getDatabase(), cons, entries);
 }
 
 class BulkUpsertContractDataOperation
@@ -417,12 +417,12 @@ class BulkUpsertContractDataOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertContractData(
-    std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertContractData(
+    std::vector<EntryIterator> const& entries) const
 {
-    BulkUpsertContractDataOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertContractDataOperation>(
+        mApp.getDatabase(), entries);
 }
 
 void
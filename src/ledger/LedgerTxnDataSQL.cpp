@@ -12,8 +12,8 @@
 #include "util/Decoder.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/types.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -297,24 +297,24 @@ class BulkDeleteDataOperation : public DatabaseTypeSpecificOperation<void>
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertAccountData(
-    std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertAccountData(
+    std::vector<EntryIterator> const& entries) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertDataOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertDataOperation>(
+        mApp.getDatabase(), entries);
 }
 
-void
-LedgerTxnRoot::Impl::bulkDeleteAccountData(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteAccountData(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkDeleteDataOperation op(mApp.getDatabase(), cons, entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteDataOperation>(
+        mApp.getDatabase(), cons, entries);
 }
 
 void
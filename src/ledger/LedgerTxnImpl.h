@@ -7,21 +7,33 @@
 #include "bucket/BucketList.h"
 #include "database/Database.h"
 #include "ledger/LedgerTxn.h"
-#include "util/RandomEvictionCache.h"
+#include "util/FlatHashMap.h"
+#include "util/SegmentedLRUCache.h"
 #include <list>
 #include <optional>
 #ifdef USE_POSTGRES
+#include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <libpq-fe.h>
 #include <limits>
 #include <sstream>
+#include <type_traits>
 #endif
 
+namespace medida
+{
+class Meter;
+}
+
 namespace stellar
 {
 
+class OrderBookIndex;
 class SearchableBucketListSnapshot;
 
+typedef FlatHashMap<InternalLedgerKey, LedgerEntryPtr> LedgerTxnEntryMap;
+
 class EntryIterator::AbstractImpl
 {
   public:
@@ -42,6 +54,23 @@ class EntryIterator::AbstractImpl
     virtual InternalLedgerKey const& key() const = 0;
 
     virtual std::unique_ptr<AbstractImpl> clone() const = 0;
+
+    // Upper bound on the number of entries left to iterate, or 0 if unknown.
+    // Lets a parent size its entry map once before merging a child.
+    virtual size_t
+    sizeHint() const
+    {
+        return 0;
+    }
+
+    // Returns the entries being iterated if they belong to a LedgerTxn that is
+    // committing and will never read them again, in which case the parent may
+    // take them over instead of copying. Returns nullptr otherwise.
+    virtual LedgerTxnEntryMap*
+    releasableEntries() const
+    {
+        return nullptr;
+    }
 };
 
 // Helper struct to accumulate common cases that we can sift out of the
@@ -207,7 +236,7 @@ class LedgerTxn::Impl
 {
     class EntryIteratorImpl;
 
-    typedef UnorderedMap<InternalLedgerKey, LedgerEntryPtr> EntryMap;
+    typedef LedgerTxnEntryMap EntryMap;
 
     AbstractLedgerTxnParent& mParent;
     AbstractLedgerTxn* mChild;
@@ -415,10 +444,18 @@ class LedgerTxn::Impl
     // getEntryIterator has the strong exception safety guarantee
     EntryIterator getEntryIterator(EntryMap const& entries) const;
 
+    // Like getEntryIterator over mEntry, but also allows the parent to take
+    // mEntry over; only valid while committing
+    EntryIterator getReleasableEntryIterator();
+
     void maybeUpdateLastModified() noexcept;
 
     // f should not throw
     // C++ doesn't support "std::function<void(EntryMap const&) nothrow>" yet
+    // Fills delta and changes, either of which may be null, as getDelta and
+    // getChanges would, in a single pass over the entries
+    void collectChanges(LedgerTxnDelta* delta, LedgerEntryChanges* changes);
+
     void maybeUpdateLastModifiedThenInvokeThenSeal(
         std::function<void(EntryMap const&)> f) noexcept;
 
@@ -429,6 +466,9 @@ class LedgerTxn::Impl
     // removeFromOrderBookIfExists has the strong exception safety guarantee
     void removeFromOrderBookIfExists(LedgerEntry const& le);
 
+    // addToOrderBook has the strong exception safety guarantee
+    void addToOrderBook(LedgerKey const& key, LedgerEntry const& le);
+
     // updateEntryIfRecorded and updateEntry have the strong exception safety
     // guarantee
     void updateEntryIfRecorded(InternalLedgerKey const& key,
@@ -445,6 +485,13 @@ class LedgerTxn::Impl
     std::pair<std::shared_ptr<InternalLedgerEntry const>, EntryMap::iterator>
     getNewestVersionEntryMap(InternalLedgerKey const& key);
 
+    // Activates and records the entry for key, given its newest version as
+    // returned by getNewestVersionEntryMap. Shared by load and loadBatch.
+    LedgerTxnEntry loadNewestVersion(
+        LedgerTxn& self, InternalLedgerKey const& key,
+        std::pair<std::shared_ptr<InternalLedgerEntry const>,
+                  EntryMap::iterator> const& newest);
+
   public:
     // Constructor has the strong exception safety guarantee
     Impl(LedgerTxn& self, AbstractLedgerTxnParent& parent,
@@ -513,6 +560,13 @@ class LedgerTxn::Impl
     // - the entry cache may be, but is not guaranteed to be, cleared.
     LedgerTxnDelta getDelta();
 
+    // getDeltaAndChanges has the basic exception safety guarantee. If it
+    // throws an exception, then
+    // - the prepared statement cache may be, but is not guaranteed to be,
+    //   modified
+    // - the entry cache may be, but is not guaranteed to be, cleared.
+    std::pair<LedgerTxnDelta, LedgerEntryChanges> getDeltaAndChanges();
+
     // getOffersByAccountAndAsset has the basic exception safety guarantee. If
     // it throws an exception, then
     // - the prepared statement cache may be, but is not guaranteed to be,
@@ -561,6 +615,11 @@ class LedgerTxn::Impl
     std::shared_ptr<InternalLedgerEntry const>
     getNewestVersion(InternalLedgerKey const& key) const;
 
+    // getNewestVersions has the same exception safety guarantee as
+    // getNewestVersion
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+    getNewestVersions(UnorderedSet<InternalLedgerKey> const& keys) const;
+
     // load has the basic exception safety guarantee. If it throws an exception,
     // then
     // - the prepared statement cache may be, but is not guaranteed to be,
@@ -568,6 +627,13 @@ class LedgerTxn::Impl
     // - the entry cache may be, but is not guaranteed to be, cleared.
     LedgerTxnEntry load(LedgerTxn& self, InternalLedgerKey const& key);
 
+    // loadBatch has the basic exception safety guarantee. If it throws an
+    // exception, then in addition to the effects of load
+    // - some of the keys may have been recorded as if loaded (but none of
+    //   them are left active).
+    std::vector<LedgerTxnEntry>
+    loadBatch(LedgerTxn& self, std::vector<InternalLedgerKey> const& keys);
+
     // createWithoutLoading has the strong exception safety guarantee.
     // If it throws an exception, then the current LedgerTxn::Impl is unchanged.
     void createWithoutLoading(InternalLedgerEntry const& entry);
@@ -669,9 +735,12 @@ class LedgerTxn::Impl::EntryIteratorImpl : public EntryIterator::AbstractImpl
     typedef LedgerTxn::Impl::EntryMap::const_iterator IteratorType;
     IteratorType mIter;
     IteratorType const mEnd;
+    size_t const mSize;
+    EntryMap* const mReleasable;
 
   public:
-    EntryIteratorImpl(IteratorType const& begin, IteratorType const& end);
+    EntryIteratorImpl(IteratorType const& begin, IteratorType const& end,
+                      size_t size, EntryMap* releasable = nullptr);
 
     void advance() override;
 
@@ -686,6 +755,23 @@ class LedgerTxn::Impl::EntryIteratorImpl : public EntryIterator::AbstractImpl
     InternalLedgerKey const& key() const override;
 
     std::unique_ptr<EntryIterator::AbstractImpl> clone() const override;
+
+    size_t sizeHint() const override;
+
+    EntryMap* releasableEntries() const override;
+};
+
+// How a bulk upsert of offers is written to PostgreSQL. SQLite always uses
+// UPSERT.
+enum class BulkOfferWrite
+{
+    // Upsert from arrays of parameters
+    UPSERT,
+    // COPY into a staging table, then merge that into the offers table
+    COPY_AND_MERGE,
+    // COPY straight into the offers table, which must not hold any of the
+    // offers yet
+    COPY
 };
 
 // Many functions in LedgerTxnRoot::Impl provide a basic exception safety
@@ -712,7 +798,20 @@ class LedgerTxnRoot::Impl
         LoadType type;
     };
 
-    typedef RandomEvictionCache<LedgerKey, CacheEntry> EntryCache;
+    // The entry cache keeps every entry type in its own partition, so that a
+    // burst of loads of one type cannot evict every entry of the others
+    struct EntryCachePartition
+    {
+        size_t
+        operator()(LedgerKey const& key) const
+        {
+            return static_cast<size_t>(key.type());
+        }
+    };
+
+    typedef SegmentedLRUCache<LedgerKey, CacheEntry, std::hash<LedgerKey>,
+                              EntryCachePartition>
+        EntryCache;
 
     typedef AssetPair BestOffersKey;
 
@@ -732,16 +831,30 @@ class LedgerTxnRoot::Impl
     Application& mApp;
     std::unique_ptr<LedgerHeader> mHeader;
     mutable EntryCache mEntryCache;
+    // Entry cache counters already reported to the meters below
+    mutable UnorderedMap<LedgerEntryType, EntryCache::Counters>
+        mReportedEntryCacheCounters;
+    UnorderedMap<LedgerEntryType, medida::Meter&> mEntryCacheHitMeters;
+    UnorderedMap<LedgerEntryType, medida::Meter&> mEntryCacheMissMeters;
+    UnorderedMap<LedgerEntryType, medida::Meter&> mEntryCacheEvictMeters;
     mutable BestOffers mBestOffers;
     mutable uint64_t mPrefetchHits{0};
     mutable uint64_t mPrefetchMisses{0};
     mutable std::shared_ptr<SearchableBucketListSnapshot>
         mSearchableBucketListSnapshot{};
+    // Loaded on first use when IN_MEMORY_ORDER_BOOK or IN_MEMORY_OFFERS is
+    // set, and discarded whenever the offers table (or with IN_MEMORY_OFFERS,
+    // the BucketList) is changed other than by commitChild
+    mutable std::unique_ptr<OrderBookIndex> mOrderBookIndex;
 
     size_t mBulkLoadBatchSize;
     std::unique_ptr<soci::transaction> mTransaction;
     AbstractLedgerTxn* mChild;
 
+    // How upserted offers are written while the database is populated from
+    // buckets, see beginBulkPopulate
+    BulkOfferWrite mBulkOfferWrite{BulkOfferWrite::UPSERT};
+
 #ifdef BEST_OFFER_DEBUGGING
     bool const mBestOfferDebuggingEnabled;
 #endif
@@ -784,36 +897,67 @@ class LedgerTxnRoot::Impl
     loadConfigSetting(LedgerKey const& key) const;
     std::shared_ptr<LedgerEntry const> loadTTL(LedgerKey const& key) const;
 
+    // A bulk write whose SQL parameters have been encoded, ready to run on
+    // the database session
+    typedef std::unique_ptr<DatabaseTypeSpecificOperation<void>>
+        BulkOperationPtr;
+    typedef std::function<BulkOperationPtr()> BulkOperationPreparer;
+
     void bulkApply(BulkLedgerEntryChangeAccumulator& bleca,
                    size_t bufferThreshold, LedgerTxnConsistency cons);
-    void bulkUpsertAccounts(std::vector<EntryIterator> const& entries);
-    void bulkDeleteAccounts(std::vector<EntryIterator> const& entries,
-                            LedgerTxnConsistency cons);
-    void bulkUpsertTrustLines(std::vector<EntryIterator> const& entries);
-    void bulkDeleteTrustLines(std::vector<EntryIterator> const& entries,
-                              LedgerTxnConsistency cons);
-    void bulkUpsertOffers(std::vector<EntryIterator> const& entries);
-    void bulkDeleteOffers(std::vector<EntryIterator> const& entries,
-                          LedgerTxnConsistency cons);
-    void bulkUpsertAccountData(std::vector<EntryIterator> const& entries);
-    void bulkDeleteAccountData(std::vector<EntryIterator> const& entries,
-                               LedgerTxnConsistency cons);
-    void bulkUpsertClaimableBalance(std::vector<EntryIterator> const& entries);
-    void bulkDeleteClaimableBalance(std::vector<EntryIterator> const& entries,
-                                    LedgerTxnConsistency cons);
-    void bulkUpsertLiquidityPool(std::vector<EntryIterator> const& entries);
-    void bulkDeleteLiquidityPool(std::vector<EntryIterator> const& entries,
-                                 LedgerTxnConsistency cons);
-    void bulkUpsertContractData(std::vector<EntryIterator> const& entries);
-    void bulkDeleteContractData(std::vector<EntryIterator> const& entries,
-                                LedgerTxnConsistency cons);
-    void bulkUpsertContractCode(std::vector<EntryIterator> const& entries);
-    void bulkDeleteContractCode(std::vector<EntryIterator> const& entries,
-                                LedgerTxnConsistency cons);
-    void bulkUpsertConfigSettings(std::vector<EntryIterator> const& entries);
-    void bulkUpsertTTL(std::vector<EntryIterator> const& entries);
-    void bulkDeleteTTL(std::vector<EntryIterator> const& entries,
-                       LedgerTxnConsistency cons);
+    // Prepares every operation, concurrently when
+    // PARALLEL_LEDGER_COMMIT_ENCODING is set, then runs them in order
+    void runBulkOperations(std::vector<BulkOperationPreparer>& preparers);
+
+    // The prepareBulk* functions only encode entries and do not touch the
+    // database session, so they are safe to call from background threads
+    BulkOperationPtr
+    prepareBulkUpsertAccounts(std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteAccounts(std::vector<EntryIterator> const& entries,
+                              LedgerTxnConsistency cons) const;
+    BulkOperationPtr prepareBulkUpsertTrustLines(
+        std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteTrustLines(std::vector<EntryIterator> const& entries,
+                                LedgerTxnConsistency cons) const;
+    BulkOperationPtr
+    prepareBulkUpsertOffers(std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteOffers(std::vector<EntryIterator> const& entries,
+                            LedgerTxnConsistency cons) const;
+    BulkOperationPtr prepareBulkUpsertAccountData(
+        std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteAccountData(std::vector<EntryIterator> const& entries,
+                                 LedgerTxnConsistency cons) const;
+    BulkOperationPtr prepareBulkUpsertClaimableBalance(
+        std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteClaimableBalance(std::vector<EntryIterator> const& entries,
+                                      LedgerTxnConsistency cons) const;
+    BulkOperationPtr prepareBulkUpsertLiquidityPool(
+        std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteLiquidityPool(std::vector<EntryIterator> const& entries,
+                                   LedgerTxnConsistency cons) const;
+    BulkOperationPtr prepareBulkUpsertContractData(
+        std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteContractData(std::vector<EntryIterator> const& entries,
+                                  LedgerTxnConsistency cons) const;
+    BulkOperationPtr prepareBulkUpsertContractCode(
+        std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteContractCode(std::vector<EntryIterator> const& entries,
+                                  LedgerTxnConsistency cons) const;
+    BulkOperationPtr prepareBulkUpsertConfigSettings(
+        std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkUpsertTTL(std::vector<EntryIterator> const& entries) const;
+    BulkOperationPtr
+    prepareBulkDeleteTTL(std::vector<EntryIterator> const& entries,
+                         LedgerTxnConsistency cons) const;
 
     static std::string tableFromLedgerEntryType(LedgerEntryType let);
 
@@ -832,6 +976,8 @@ class LedgerTxnRoot::Impl
     //    image of a subset of the database.
     std::shared_ptr<InternalLedgerEntry const>
     getFromEntryCache(LedgerKey const& key) const;
+    // Marks the entry cache meters with the activity since the last call
+    void reportEntryCacheMetrics() const;
     void putInEntryCache(LedgerKey const& key,
                          std::shared_ptr<LedgerEntry const> const& entry,
                          LoadType type) const;
@@ -860,6 +1006,15 @@ class LedgerTxnRoot::Impl
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
     bulkLoadTTL(UnorderedSet<LedgerKey> const& keys) const;
 
+    // Loads keys from the SQL database with the bulkLoad functions above, in
+    // batches of at most mBulkLoadBatchSize keys of one type, passing the
+    // result of every batch to onLoad.
+    typedef std::function<void(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&)>
+        BulkLoadHandler;
+    void bulkLoadFromDatabase(UnorderedSet<LedgerKey> const& keys,
+                              BulkLoadHandler const& onLoad) const;
+
     std::deque<LedgerEntry>::const_iterator
     loadNextBestOffersIntoCache(BestOffersEntryPtr cached, Asset const& buying,
                                 Asset const& selling);
@@ -869,6 +1024,26 @@ class LedgerTxnRoot::Impl
 
     bool areEntriesMissingInCacheForOffer(OfferEntry const& oe);
 
+    // Returns nullptr unless IN_MEMORY_ORDER_BOOK or IN_MEMORY_OFFERS is set,
+    // loading the index from the database (or with IN_MEMORY_OFFERS, from the
+    // BucketList) if needed
+    OrderBookIndex* getOrderBookIndex() const;
+    // Loads the offer key from the index, with IN_MEMORY_OFFERS only
+    std::shared_ptr<LedgerEntry const>
+    loadOfferFromIndex(LedgerKey const& key) const;
+    std::shared_ptr<LedgerEntry const>
+    getBestOfferFromIndex(OrderBookIndex const& index, Asset const& buying,
+                          Asset const& selling,
+                          OfferDescriptor const* worseThan);
+    // With IN_MEMORY_ORDER_BOOK_CHECKS, these abort unless SQL gives the same
+    // answer as the index
+    void checkIndexBestOffer(Asset const& buying, Asset const& selling,
+                             OfferDescriptor const* worseThan,
+                             std::shared_ptr<LedgerEntry const> const& best);
+    void checkIndexOffersByAccountAndAsset(
+        AccountID const& account, Asset const& asset,
+        std::vector<std::shared_ptr<LedgerEntry const>> const& offers);
+
     SearchableBucketListSnapshot& getSearchableBucketListSnapshot() const;
 
   public:
@@ -908,6 +1083,11 @@ class LedgerTxnRoot::Impl
     void dropConfigSettings(bool rebuild);
     void dropTTL(bool rebuild);
 
+    // beginBulkPopulate and endBulkPopulate have no exception safety
+    // guarantees.
+    void beginBulkPopulate(bool entriesAreUnique);
+    void endBulkPopulate();
+
 #ifdef BUILD_TESTS
     void resetForFuzzer();
 #endif // BUILD_TESTS
@@ -963,6 +1143,12 @@ class LedgerTxnRoot::Impl
     std::shared_ptr<InternalLedgerEntry const>
     getNewestVersion(InternalLedgerKey const& key) const;
 
+    // getNewestVersions has the same exception safety guarantee as
+    // getNewestVersion. Every key that is not in the entry cache is loaded
+    // from the database in bulk and then cached.
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+    getNewestVersions(UnorderedSet<InternalLedgerKey> const& keys) const;
+
     void rollbackChild() noexcept;
 
     // Prefetch some or all of given keys in batches. Note that no prefetching
@@ -972,6 +1158,10 @@ class LedgerTxnRoot::Impl
 
     double getPrefetchHitRate() const;
 
+    void addMemoryFootprint(MemoryFootprint& footprint) const;
+
+    void setEntryCacheSize(size_t size);
+
     void prepareNewObjects(size_t s);
 
 #ifdef BEST_OFFER_DEBUGGING
@@ -1060,5 +1250,141 @@ marshalToPGArray(PGconn* conn, std::string& out, const std::vector<T>& v,
     oss << '}';
     out = oss.str();
 }
+
+// Rows encoded in PostgreSQL's binary COPY format. Each row starts with
+// beginRow, followed by one add per column in the order named by the COPY
+// statement. Values must match the column types exactly: int32_t for INT,
+// int64_t for BIGINT, double for DOUBLE PRECISION and std::string for TEXT
+// and VARCHAR.
+class PGBinaryCopyBuffer
+{
+    std::string mBuf;
+
+    template <typename T>
+    void
+    putBigEndian(T v)
+    {
+        auto u = static_cast<std::make_unsigned_t<T>>(v);
+        for (int shift = 8 * (sizeof(T) - 1); shift >= 0; shift -= 8)
+        {
+            mBuf.push_back(static_cast<char>((u >> shift) & 0xff));
+        }
+    }
+
+  public:
+    PGBinaryCopyBuffer()
+    {
+        // Signature, then empty flags and header extension
+        static char const SIGNATURE[] = "PGCOPY\n\377\r\n";
+        mBuf.append(SIGNATURE, sizeof(SIGNATURE));
+        putBigEndian<int32_t>(0);
+        putBigEndian<int32_t>(0);
+    }
+
+    void
+    beginRow(int16_t numColumns)
+    {
+        putBigEndian(numColumns);
+    }
+
+    void
+    add(int32_t v)
+    {
+        putBigEndian<int32_t>(sizeof(v));
+        putBigEndian(v);
+    }
+
+    void
+    add(int64_t v)
+    {
+        putBigEndian<int32_t>(sizeof(v));
+        putBigEndian(v);
+    }
+
+    void
+    add(double v)
+    {
+        static_assert(sizeof(double) == sizeof(int64_t));
+        int64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        putBigEndian<int32_t>(sizeof(bits));
+        putBigEndian(bits);
+    }
+
+    void
+    add(std::string const& v)
+    {
+        if (v.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+        {
+            throw std::runtime_error("Value too large for COPY");
+        }
+        putBigEndian(static_cast<int32_t>(v.size()));
+        mBuf.append(v);
+    }
+
+    // Appends the trailer and returns the encoded data. No rows may be added
+    // afterwards.
+    std::string const&
+    finish()
+    {
+        putBigEndian<int16_t>(-1);
+        return mBuf;
+    }
+};
+
+// Runs copySql, a "COPY ... FROM STDIN (FORMAT binary)" statement, with the
+// rows in buf and returns the number of rows copied
+inline size_t
+copyToPG(PGconn* conn, std::string const& copySql, PGBinaryCopyBuffer& buf)
+{
+    PGresult* res = PQexec(conn, copySql.c_str());
+    bool started = PQresultStatus(res) == PGRES_COPY_IN;
+    PQclear(res);
+    if (!started)
+    {
+        throw std::runtime_error(std::string("Could not start COPY: ") +
+                                 PQerrorMessage(conn));
+    }
+
+    // PQputCopyData takes an int length, so send the data in pieces
+    size_t const CHUNK_SIZE = 1 << 20;
+    auto const& data = buf.finish();
+    char const* error = nullptr;
+    for (size_t off = 0; off < data.size() && !error; off += CHUNK_SIZE)
+    {
+        auto len = std::min(CHUNK_SIZE, data.size() - off);
+        if (PQputCopyData(conn, data.data() + off, static_cast<int>(len)) != 1)
+        {
+            error = "could not send COPY data";
+        }
+    }
+    // On error, ending the COPY with a message makes the server abort it
+    if (PQputCopyEnd(conn, error) != 1 && !error)
+    {
+        error = "could not end COPY";
+    }
+
+    size_t rows = 0;
+    std::string serverError;
+    while ((res = PQgetResult(conn)) != nullptr)
+    {
+        if (PQresultStatus(res) == PGRES_COMMAND_OK)
+        {
+            rows = std::strtoull(PQcmdTuples(res), nullptr, 10);
+        }
+        else if (serverError.empty())
+        {
+            serverError = PQresultErrorMessage(res);
+        }
+        PQclear(res);
+    }
+    if (error || !serverError.empty())
+    {
+        throw std::runtime_error(
+            std::string("COPY failed: ") +
+            (serverError.empty() ? std::string(error) : serverError));
+    }
+    return rows;
+}
 #endif
 }
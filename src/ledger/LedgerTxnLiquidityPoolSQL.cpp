@@ -248,12 +248,12 @@ class BulkDeleteLiquidityPoolOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkDeleteLiquidityPool(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteLiquidityPool(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
-    BulkDeleteLiquidityPoolOperation op(mApp.getDatabase(), cons, entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteLiquidityPoolOperation>(
+        mApp.getDatabase(), cons, entries);
 }
 
 class BulkUpsertLiquidityPoolOperation
@@ -379,12 +379,12 @@ class BulkUpsertLiquidityPoolOperation
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertLiquidityPool(
-    std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertLiquidityPool(
+    std::vector<EntryIterator> const& entries) const
 {
-    BulkUpsertLiquidityPoolOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertLiquidityPoolOperation>(
+        mApp.getDatabase(), entries);
 }
 
 void
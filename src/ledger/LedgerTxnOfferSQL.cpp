@@ -8,16 +8,17 @@
 #include "database/DatabaseTypeSpecificOperation.h"
 #include "ledger/LedgerTxnImpl.h"
 #include "ledger/LedgerTypeUtils.h"
+#include "ledger/OrderBookIndex.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "transactions/TransactionUtils.h"
 #include "util/Decoder.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
 #include "util/types.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -327,6 +328,7 @@ LedgerTxnRoot::Impl::loadOffers(StatementContext& prep) const
 class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDB;
+    BulkOfferWrite const mWrite;
     std::vector<std::string> mSellerIDs;
     std::vector<int64_t> mOfferIDs;
     std::vector<std::string> mSellingAssets;
@@ -372,7 +374,7 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
   public:
     BulkUpsertOffersOperation(Database& DB,
                               std::vector<LedgerEntry> const& entries)
-        : mDB(DB)
+        : mDB(DB), mWrite(BulkOfferWrite::UPSERT)
     {
         mSellerIDs.reserve(entries.size());
         mOfferIDs.reserve(entries.size());
@@ -394,8 +396,9 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
     }
 
     BulkUpsertOffersOperation(Database& DB,
-                              std::vector<EntryIterator> const& entries)
-        : mDB(DB)
+                              std::vector<EntryIterator> const& entries,
+                              BulkOfferWrite write)
+        : mDB(DB), mWrite(write)
     {
         mSellerIDs.reserve(entries.size());
         mOfferIDs.reserve(entries.size());
@@ -473,9 +476,89 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
     }
 
 #ifdef USE_POSTGRES
+    void
+    copyToPostgres(PGconn* conn)
+    {
+        static std::string const COLUMNS =
+            "sellerid, offerid, sellingasset, buyingasset, amount, pricen, "
+            "priced, price, flags, lastmodified, extension, ledgerext";
+
+        PGBinaryCopyBuffer buf;
+        for (size_t i = 0; i < mOfferIDs.size(); ++i)
+        {
+            buf.beginRow(12);
+            buf.add(mSellerIDs[i]);
+            buf.add(mOfferIDs[i]);
+            buf.add(mSellingAssets[i]);
+            buf.add(mBuyingAssets[i]);
+            buf.add(mAmounts[i]);
+            buf.add(mPriceNs[i]);
+            buf.add(mPriceDs[i]);
+            buf.add(mPrices[i]);
+            buf.add(mFlags[i]);
+            buf.add(mLastModifieds[i]);
+            buf.add(mExtensions[i]);
+            buf.add(mLedgerExtensions[i]);
+        }
+
+        auto timer = mDB.getUpsertTimer("offer");
+        if (mWrite == BulkOfferWrite::COPY)
+        {
+            auto rows = copyToPG(conn,
+                                 "COPY offers (" + COLUMNS +
+                                     ") FROM STDIN (FORMAT binary)",
+                                 buf);
+            if (rows != mOfferIDs.size())
+            {
+                throw std::runtime_error("Could not update data in SQL");
+            }
+            return;
+        }
+
+        // offers_staging is created by beginBulkPopulate
+        mDB.getSession() << "TRUNCATE offers_staging";
+        auto rows = copyToPG(conn,
+                             "COPY offers_staging (" + COLUMNS +
+                                 ") FROM STDIN (FORMAT binary)",
+                             buf);
+        if (rows != mOfferIDs.size())
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+
+        std::string sql =
+            "INSERT INTO offers (" + COLUMNS + ") SELECT " + COLUMNS +
+            " FROM offers_staging "
+            "ON CONFLICT (offerid) DO UPDATE SET "
+            "sellerid = excluded.sellerid, "
+            "sellingasset = excluded.sellingasset, "
+            "buyingasset = excluded.buyingasset, "
+            "amount = excluded.amount, "
+            "pricen = excluded.pricen, "
+            "priced = excluded.priced, "
+            "price = excluded.price, "
+            "flags = excluded.flags, "
+            "lastmodified = excluded.lastmodified, "
+            "extension = excluded.extension, "
+            "ledgerext = excluded.ledgerext";
+        auto prep = mDB.getPreparedStatement(sql);
+        soci::statement& st = prep.statement();
+        st.define_and_bind();
+        st.execute(true);
+        if (static_cast<size_t>(st.get_affected_rows()) != mOfferIDs.size())
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+    }
+
     void
     doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override
     {
+        if (mWrite != BulkOfferWrite::UPSERT)
+        {
+            copyToPostgres(pg->conn_);
+            return;
+        }
 
         std::string strSellerIDs, strOfferIDs, strSellingAssets,
             strBuyingAssets, strAmounts, strPriceNs, strPriceDs, strPrices,
@@ -632,23 +715,24 @@ class BulkDeleteOffersOperation : public DatabaseTypeSpecificOperation<void>
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertOffers(std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertOffers(
+    std::vector<EntryIterator> const& entries) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertOffersOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertOffersOperation>(
+        mApp.getDatabase(), entries, mBulkOfferWrite);
 }
 
-void
-LedgerTxnRoot::Impl::bulkDeleteOffers(std::vector<EntryIterator> const& entries,
-                                      LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteOffers(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkDeleteOffersOperation op(mApp.getDatabase(), cons, entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteOffersOperation>(
+        mApp.getDatabase(), cons, entries);
 }
 
 void
@@ -657,6 +741,7 @@ LedgerTxnRoot::Impl::dropOffers(bool rebuild)
     throwIfChild();
     mEntryCache.clear();
     mBestOffers.clear();
+    mOrderBookIndex.reset();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS offers;";
 
@@ -701,6 +786,53 @@ LedgerTxnRoot::Impl::dropOffers(bool rebuild)
     }
 }
 
+void
+LedgerTxnRoot::Impl::beginBulkPopulate(bool entriesAreUnique)
+{
+    throwIfChild();
+    auto& db = mApp.getDatabase();
+    mBulkOfferWrite = BulkOfferWrite::UPSERT;
+    if (db.isSqlite())
+    {
+        return;
+    }
+
+    // Offers can go straight into the table if none of them can already be
+    // there. Otherwise they are staged and merged, which is still much
+    // faster than unpacking arrays of parameters.
+    bool tableEmpty = false;
+    if (entriesAreUnique)
+    {
+        int64_t offerID = 0;
+        soci::statement st =
+            (db.getSession().prepare << "SELECT offerid FROM offers LIMIT 1",
+             soci::into(offerID));
+        st.execute(true);
+        tableEmpty = !st.got_data();
+    }
+    if (tableEmpty)
+    {
+        mBulkOfferWrite = BulkOfferWrite::COPY;
+    }
+    else
+    {
+        db.getSession() << "CREATE TEMP TABLE IF NOT EXISTS offers_staging "
+                           "(LIKE offers INCLUDING DEFAULTS) "
+                           "ON COMMIT DELETE ROWS";
+        mBulkOfferWrite = BulkOfferWrite::COPY_AND_MERGE;
+    }
+    CLOG_INFO(Ledger, "Populating offers table with {}",
+              tableEmpty ? "COPY" : "COPY and merge");
+}
+
+void
+LedgerTxnRoot::Impl::endBulkPopulate()
+{
+    // offers_staging is left empty, and goes away with the session
+    throwIfChild();
+    mBulkOfferWrite = BulkOfferWrite::UPSERT;
+}
+
 class BulkLoadOffersOperation
     : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
 {
@@ -233,12 +233,12 @@ class BulkDeleteTTLOperation : public DatabaseTypeSpecificOperation<void>
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkDeleteTTL(std::vector<EntryIterator> const& entries,
-                                   LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteTTL(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
-    BulkDeleteTTLOperation op(mApp.getDatabase(), cons, entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteTTLOperation>(
+        mApp.getDatabase(), cons, entries);
 }
 
 class BulkUpsertTTLOperation : public DatabaseTypeSpecificOperation<void>
@@ -343,11 +343,12 @@ class BulkUpsertTTLOperation : public DatabaseTypeSpecificOperation<void>
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertTTL(std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertTTL(
+    std::vector<EntryIterator> const& entries) const
 {
-    BulkUpsertTTLOperation op(mApp.getDatabase(), entries);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertTTLOperation>(
+        mApp.getDatabase(), entries);
 }
 
 void
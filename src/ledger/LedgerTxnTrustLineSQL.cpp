@@ -12,9 +12,9 @@
 #include "main/Application.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
 #include "util/types.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -326,26 +326,24 @@ class BulkDeleteTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
 #endif
 };
 
-void
-LedgerTxnRoot::Impl::bulkUpsertTrustLines(
-    std::vector<EntryIterator> const& entries)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkUpsertTrustLines(
+    std::vector<EntryIterator> const& entries) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertTrustLinesOperation op(mApp.getDatabase(), entries,
-                                     mHeader->ledgerVersion);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkUpsertTrustLinesOperation>(
+        mApp.getDatabase(), entries, mHeader->ledgerVersion);
 }
 
-void
-LedgerTxnRoot::Impl::bulkDeleteTrustLines(
-    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
+LedgerTxnRoot::Impl::BulkOperationPtr
+LedgerTxnRoot::Impl::prepareBulkDeleteTrustLines(
+    std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons) const
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkDeleteTrustLinesOperation op(mApp.getDatabase(), cons, entries,
-                                     mHeader->ledgerVersion);
-    mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
+    return std::make_unique<BulkDeleteTrustLinesOperation>(
+        mApp.getDatabase(), cons, entries, mHeader->ledgerVersion);
 }
 
 void
@@ -18,6 +18,12 @@ bool isLive(LedgerEntry const& e, uint32_t cutoffLedger);
 LedgerKey getTTLKey(LedgerEntry const& e);
 LedgerKey getTTLKey(LedgerKey const& e);
 
+// Inserts `keys` into `out` along with the TTL keys of the Soroban ones, so
+// that the TTL entries always loaded with them are prefetched in the same
+// pass over the bucket list
+void insertKeysWithTTL(xdr::xvector<LedgerKey> const& keys,
+                       UnorderedSet<LedgerKey>& out);
+
 // Precondition: The keys associated with entries are unique and constitute a
 // subset of keys
 template <typename KeySetT>
@@ -0,0 +1,124 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/OrderBookIndex.h"
+#include "util/GlobalChecks.h"
+#include "util/Tracing.h"
+#include "util/XDROperators.h"
+
+namespace stellar
+{
+
+OrderBookIndex::OrderBookIndex(std::vector<LedgerEntry> const& offers)
+{
+    ZoneScoped;
+    mOffers.reserve(offers.size());
+    for (auto const& le : offers)
+    {
+        upsert(std::make_shared<LedgerEntry const>(le));
+    }
+}
+
+void
+OrderBookIndex::upsert(OfferPtr const& offer)
+{
+    auto const& oe = offer->data.offer();
+    erase(oe.offerID);
+    mOrderBooks[{oe.buying, oe.selling}].emplace(
+        OfferDescriptor{oe.price, oe.offerID}, offer);
+    mOffersBySeller[oe.sellerID].emplace(oe.offerID);
+    mOffers.emplace(oe.offerID, offer);
+}
+
+void
+OrderBookIndex::erase(int64_t offerID) noexcept
+{
+    auto it = mOffers.find(offerID);
+    if (it == mOffers.end())
+    {
+        return;
+    }
+
+    auto const& oe = it->second->data.offer();
+    auto book = mOrderBooks.find({oe.buying, oe.selling});
+    releaseAssert(book != mOrderBooks.end());
+    book->second.erase({oe.price, oe.offerID});
+    if (book->second.empty())
+    {
+        mOrderBooks.erase(book);
+    }
+
+    auto seller = mOffersBySeller.find(oe.sellerID);
+    releaseAssert(seller != mOffersBySeller.end());
+    seller->second.erase(offerID);
+    if (seller->second.empty())
+    {
+        mOffersBySeller.erase(seller);
+    }
+
+    mOffers.erase(it);
+}
+
+std::vector<OrderBookIndex::OfferPtr>
+OrderBookIndex::getBestOffers(Asset const& buying, Asset const& selling,
+                              OfferDescriptor const* worseThan, size_t n) const
+{
+    std::vector<OfferPtr> res;
+    auto book = mOrderBooks.find({buying, selling});
+    if (book == mOrderBooks.end())
+    {
+        return res;
+    }
+
+    auto const& offers = book->second;
+    auto it = worseThan ? offers.upper_bound(*worseThan) : offers.begin();
+    for (; it != offers.end() && res.size() < n; ++it)
+    {
+        res.emplace_back(it->second);
+    }
+    return res;
+}
+
+std::vector<OrderBookIndex::OfferPtr>
+OrderBookIndex::getOffersByAccountAndAsset(AccountID const& account,
+                                           Asset const& asset) const
+{
+    std::vector<OfferPtr> res;
+    auto seller = mOffersBySeller.find(account);
+    if (seller == mOffersBySeller.end())
+    {
+        return res;
+    }
+
+    for (auto offerID : seller->second)
+    {
+        auto const& offer = mOffers.at(offerID);
+        auto const& oe = offer->data.offer();
+        if (oe.buying == asset || oe.selling == asset)
+        {
+            res.emplace_back(offer);
+        }
+    }
+    return res;
+}
+
+OrderBookIndex::OfferPtr
+OrderBookIndex::getOffer(int64_t offerID) const
+{
+    auto it = mOffers.find(offerID);
+    return it == mOffers.end() ? nullptr : it->second;
+}
+
+std::vector<OrderBookIndex::OfferPtr>
+OrderBookIndex::getAllOffers() const
+{
+    std::vector<OfferPtr> res;
+    res.reserve(mOffers.size());
+    for (auto const& offer : mOffers)
+    {
+        res.emplace_back(offer.second);
+    }
+    return res;
+}
+}
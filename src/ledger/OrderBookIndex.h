@@ -0,0 +1,69 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerTxn.h"
+#include "util/UnorderedMap.h"
+#include "util/UnorderedSet.h"
+#include "xdr/Stellar-ledger-entries.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace stellar
+{
+
+// In-memory index of every offer in the database, answering the offer
+// queries LedgerTxnRoot would otherwise send to SQL: the best offers for an
+// asset pair, and the offers of an account that buy or sell an asset. It is
+// loaded from the database once and then kept up to date with every offer
+// committed to LedgerTxnRoot. With IN_MEMORY_OFFERS it is loaded from the
+// BucketList instead and is the only store of offers LedgerTxnRoot has.
+//
+// Entries are shared immutably, so the results can be handed out (and put in
+// the LedgerTxnRoot entry cache) without copying.
+class OrderBookIndex
+{
+    typedef std::shared_ptr<LedgerEntry const> OfferPtr;
+    typedef std::map<OfferDescriptor, OfferPtr, IsBetterOfferComparator>
+        OrderBook;
+
+    UnorderedMap<AssetPair, OrderBook, AssetPairHash> mOrderBooks;
+    UnorderedMap<int64_t, OfferPtr> mOffers;
+    UnorderedMap<AccountID, UnorderedSet<int64_t>> mOffersBySeller;
+
+  public:
+    explicit OrderBookIndex(std::vector<LedgerEntry> const& offers);
+
+    // Inserts offer, replacing any offer with the same id. If this throws, the
+    // index may be left inconsistent and must be discarded.
+    void upsert(OfferPtr const& offer);
+
+    // Removes the offer with id offerID, if any. Does not throw.
+    void erase(int64_t offerID) noexcept;
+
+    // Returns up to n of the best offers for the asset pair, best first. If
+    // worseThan is set, only offers worse than it are returned.
+    std::vector<OfferPtr> getBestOffers(Asset const& buying,
+                                        Asset const& selling,
+                                        OfferDescriptor const* worseThan,
+                                        size_t n) const;
+
+    // Returns every offer owned by account that buys or sells asset
+    std::vector<OfferPtr> getOffersByAccountAndAsset(AccountID const& account,
+                                                     Asset const& asset) const;
+
+    // Returns the offer with id offerID, or nullptr if there is none
+    OfferPtr getOffer(int64_t offerID) const;
+
+    std::vector<OfferPtr> getAllOffers() const;
+
+    size_t
+    size() const
+    {
+        return mOffers.size();
+    }
+};
+}
@@ -0,0 +1,262 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/SnapshotLedgerTxnRoot.h"
+#include "bucket/BucketListSnapshot.h"
+#include "bucket/LedgerCmp.h"
+#include "ledger/LedgerRange.h"
+#include "util/GlobalChecks.h"
+#include <set>
+
+namespace stellar
+{
+
+namespace
+{
+[[noreturn]] void
+throwUnsupported(char const* what)
+{
+    throw std::runtime_error(
+        std::string("SnapshotLedgerTxnRoot does not support ") + what);
+}
+}
+
+SnapshotLedgerTxnRoot::SnapshotLedgerTxnRoot(
+    SearchableBucketListSnapshot& snapshot, LedgerHeader const& header)
+    : mSnapshot(snapshot), mHeader(header)
+{
+}
+
+void
+SnapshotLedgerTxnRoot::addChild(AbstractLedgerTxn& child, TransactionMode mode)
+{
+}
+
+void
+SnapshotLedgerTxnRoot::commitChild(EntryIterator iter,
+                                   LedgerTxnConsistency cons) noexcept
+{
+    printErrorAndAbort("committing to read-only SnapshotLedgerTxnRoot");
+}
+
+void
+SnapshotLedgerTxnRoot::rollbackChild() noexcept
+{
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+SnapshotLedgerTxnRoot::getAllOffers()
+{
+    throwUnsupported("offer queries");
+}
+
+std::shared_ptr<LedgerEntry const>
+SnapshotLedgerTxnRoot::getBestOffer(Asset const& buying, Asset const& selling)
+{
+    throwUnsupported("offer queries");
+}
+
+std::shared_ptr<LedgerEntry const>
+SnapshotLedgerTxnRoot::getBestOffer(Asset const& buying, Asset const& selling,
+                                    OfferDescriptor const& worseThan)
+{
+    throwUnsupported("offer queries");
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+SnapshotLedgerTxnRoot::getOffersByAccountAndAsset(AccountID const& account,
+                                                  Asset const& asset)
+{
+    throwUnsupported("offer queries");
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+SnapshotLedgerTxnRoot::getPoolShareTrustLinesByAccountAndAsset(
+    AccountID const& account, Asset const& asset)
+{
+    throwUnsupported("pool share trustline queries");
+}
+
+LedgerHeader const&
+SnapshotLedgerTxnRoot::getHeader() const
+{
+    return mHeader;
+}
+
+std::vector<InflationWinner>
+SnapshotLedgerTxnRoot::getInflationWinners(size_t maxWinners,
+                                           int64_t minBalance)
+{
+    throwUnsupported("inflation winners");
+}
+
+std::shared_ptr<InternalLedgerEntry const>
+SnapshotLedgerTxnRoot::getNewestVersion(InternalLedgerKey const& key) const
+{
+    // Sponsorship entries only exist within a LedgerTxn
+    if (key.type() != InternalLedgerEntryType::LEDGER_ENTRY)
+    {
+        return nullptr;
+    }
+
+    std::set<LedgerKey, LedgerEntryIdCmp> keys{key.ledgerKey()};
+    auto entries = mSnapshot.loadKeysFromLedger(keys, mHeader.ledgerSeq);
+    if (!entries)
+    {
+        throw StaleSnapshot("bucket list snapshot no longer retains ledger " +
+                            std::to_string(mHeader.ledgerSeq));
+    }
+    if (entries->empty())
+    {
+        return nullptr;
+    }
+    return std::make_shared<InternalLedgerEntry const>(entries->front());
+}
+
+UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+SnapshotLedgerTxnRoot::getNewestVersions(
+    UnorderedSet<InternalLedgerKey> const& keys) const
+{
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+        res;
+    for (auto const& key : keys)
+    {
+        res.emplace(key, getNewestVersion(key));
+    }
+    return res;
+}
+
+uint64_t
+SnapshotLedgerTxnRoot::countObjects(LedgerEntryType let) const
+{
+    throwUnsupported("counting objects");
+}
+
+uint64_t
+SnapshotLedgerTxnRoot::countObjects(LedgerEntryType let,
+                                    LedgerRange const& ledgers) const
+{
+    throwUnsupported("counting objects");
+}
+
+void
+SnapshotLedgerTxnRoot::deleteObjectsModifiedOnOrAfterLedger(
+    uint32_t ledger) const
+{
+    throwUnsupported("deleting objects");
+}
+
+void
+SnapshotLedgerTxnRoot::dropAccounts(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropData(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropOffers(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropTrustLines(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropClaimableBalances(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropLiquidityPools(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropContractData(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropContractCode(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropConfigSettings(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::dropTTL(bool)
+{
+    throwUnsupported("dropping entries");
+}
+
+void
+SnapshotLedgerTxnRoot::beginBulkPopulate(bool)
+{
+    throwUnsupported("bulk populating");
+}
+
+void
+SnapshotLedgerTxnRoot::endBulkPopulate()
+{
+    throwUnsupported("bulk populating");
+}
+
+double
+SnapshotLedgerTxnRoot::getPrefetchHitRate() const
+{
+    return 0.0;
+}
+
+uint32_t
+SnapshotLedgerTxnRoot::prefetch(UnorderedSet<LedgerKey> const&)
+{
+    return 0;
+}
+
+void SnapshotLedgerTxnRoot::prepareNewObjects(size_t)
+{
+}
+
+#ifdef BUILD_TESTS
+void
+SnapshotLedgerTxnRoot::resetForFuzzer()
+{
+    abort();
+}
+#endif // BUILD_TESTS
+
+#ifdef BEST_OFFER_DEBUGGING
+bool
+SnapshotLedgerTxnRoot::bestOfferDebuggingEnabled() const
+{
+    return false;
+}
+
+std::shared_ptr<LedgerEntry const>
+SnapshotLedgerTxnRoot::getBestOfferSlow(Asset const& buying,
+                                        Asset const& selling,
+                                        OfferDescriptor const* worseThan,
+                                        std::unordered_set<int64_t>& exclude)
+{
+    throwUnsupported("offer queries");
+}
+#endif
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/InternalLedgerEntry.h"
+#include "ledger/LedgerTxn.h"
+#include "util/UnorderedMap.h"
+#include "xdr/Stellar-ledger-entries.h"
+#include <stdexcept>
+#include <vector>
+
+// A read-only "root" AbstractLedgerTxnParent that loads ledger entries from a
+// bucket list snapshot, as of the ledger of the header it is given, instead
+// of from LedgerTxnRoot. Unlike LedgerTxnRoot it can be used on any thread,
+// so that LedgerTxns on top of it can run read-only checks such as
+// TransactionFrame::checkValid on worker threads.
+//
+// Only point loads are supported: queries such as best offers or inflation
+// winners throw, and so does committing to it.
+
+namespace stellar
+{
+
+class SearchableBucketListSnapshot;
+
+class SnapshotLedgerTxnRoot : public AbstractLedgerTxnParent
+{
+    SearchableBucketListSnapshot& mSnapshot;
+    LedgerHeader const mHeader;
+
+  public:
+    // Thrown by loads once the snapshot no longer retains the ledger of the
+    // header
+    class StaleSnapshot : public std::runtime_error
+    {
+      public:
+        using std::runtime_error::runtime_error;
+    };
+
+    SnapshotLedgerTxnRoot(SearchableBucketListSnapshot& snapshot,
+                          LedgerHeader const& header);
+
+    void addChild(AbstractLedgerTxn& child, TransactionMode mode) override;
+    void commitChild(EntryIterator iter,
+                     LedgerTxnConsistency cons) noexcept override;
+    void rollbackChild() noexcept override;
+
+    UnorderedMap<LedgerKey, LedgerEntry> getAllOffers() override;
+    std::shared_ptr<LedgerEntry const>
+    getBestOffer(Asset const& buying, Asset const& selling) override;
+    std::shared_ptr<LedgerEntry const>
+    getBestOffer(Asset const& buying, Asset const& selling,
+                 OfferDescriptor const& worseThan) override;
+    UnorderedMap<LedgerKey, LedgerEntry>
+    getOffersByAccountAndAsset(AccountID const& account,
+                               Asset const& asset) override;
+
+    UnorderedMap<LedgerKey, LedgerEntry>
+    getPoolShareTrustLinesByAccountAndAsset(AccountID const& account,
+                                            Asset const& asset) override;
+
+    LedgerHeader const& getHeader() const override;
+
+    std::vector<InflationWinner>
+    getInflationWinners(size_t maxWinners, int64_t minBalance) override;
+
+    std::shared_ptr<InternalLedgerEntry const>
+    getNewestVersion(InternalLedgerKey const& key) const override;
+    UnorderedMap<InternalLedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+    getNewestVersions(
+        UnorderedSet<InternalLedgerKey> const& keys) const override;
+
+    uint64_t countObjects(LedgerEntryType let) const override;
+    uint64_t countObjects(LedgerEntryType let,
+                          LedgerRange const& ledgers) const override;
+
+    void deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const override;
+
+    void dropAccounts(bool rebuild) override;
+    void dropData(bool rebuild) override;
+    void dropOffers(bool rebuild) override;
+    void dropTrustLines(bool rebuild) override;
+    void dropClaimableBalances(bool rebuild) override;
+    void dropLiquidityPools(bool rebuild) override;
+    void dropContractData(bool rebuild) override;
+    void dropContractCode(bool rebuild) override;
+    void dropConfigSettings(bool rebuild) override;
+    void dropTTL(bool rebuild) override;
+    void beginBulkPopulate(bool entriesAreUnique) override;
+    void endBulkPopulate() override;
+    double getPrefetchHitRate() const override;
+    uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
+    void prepareNewObjects(size_t s) override;
+
+#ifdef BUILD_TESTS
+    void resetForFuzzer() override;
+#endif // BUILD_TESTS
+
+#ifdef BEST_OFFER_DEBUGGING
+    bool bestOfferDebuggingEnabled() const override;
+
+    std::shared_ptr<LedgerEntry const>
+    getBestOfferSlow(Asset const& buying, Asset const& selling,
+                     OfferDescriptor const* worseThan,
+                     std::unordered_set<int64_t>& exclude) override;
+#endif
+};
+}
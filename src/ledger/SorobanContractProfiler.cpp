@@ -0,0 +1,134 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/SorobanContractProfiler.h"
+#include "crypto/StrKey.h"
+#include <algorithm>
+#include <json/json.h>
+#include <vector>
+
+namespace stellar
+{
+
+namespace
+{
+void
+usageToJson(SorobanContractProfiler::Usage const& usage, Json::Value& res)
+{
+    res["invocations"] = static_cast<Json::UInt64>(usage.mInvocations);
+    res["cpu_insns"] = static_cast<Json::UInt64>(usage.mCpuInsn);
+    res["invoke_time_nsecs"] =
+        static_cast<Json::UInt64>(usage.mInvokeTimeNsecs);
+    res["mem_bytes"] = static_cast<Json::UInt64>(usage.mMemByte);
+    res["read_entries"] = static_cast<Json::UInt64>(usage.mReadEntry);
+    res["write_entries"] = static_cast<Json::UInt64>(usage.mWriteEntry);
+    res["read_bytes"] = static_cast<Json::UInt64>(usage.mReadByte);
+    res["write_bytes"] = static_cast<Json::UInt64>(usage.mWriteByte);
+    res["resource_fee"] = static_cast<Json::Int64>(usage.mResourceFee);
+}
+}
+
+void
+SorobanContractProfiler::Usage::add(Usage const& other)
+{
+    mInvocations += other.mInvocations;
+    mCpuInsn += other.mCpuInsn;
+    mInvokeTimeNsecs += other.mInvokeTimeNsecs;
+    mMemByte += other.mMemByte;
+    mReadEntry += other.mReadEntry;
+    mWriteEntry += other.mWriteEntry;
+    mReadByte += other.mReadByte;
+    mWriteByte += other.mWriteByte;
+    mResourceFee += other.mResourceFee;
+}
+
+void
+SorobanContractProfiler::noteInvocation(Hash const& contractID,
+                                        std::string const& function,
+                                        Usage const& usage)
+{
+    auto key = std::make_pair(contractID, function);
+    auto it = mTracked.find(key);
+    if (it == mTracked.end())
+    {
+        Tracked tracked;
+        if (mTracked.size() >= MAX_TRACKED)
+        {
+            auto lightest = std::min_element(
+                mTracked.begin(), mTracked.end(),
+                [](auto const& a, auto const& b) {
+                    return a.second.mUsage.mCpuInsn + a.second.mCpuInsnError <
+                           b.second.mUsage.mCpuInsn + b.second.mCpuInsnError;
+                });
+            tracked.mCpuInsnError = lightest->second.mUsage.mCpuInsn +
+                                    lightest->second.mCpuInsnError;
+            mTracked.erase(lightest);
+        }
+        it = mTracked.emplace(key, tracked).first;
+    }
+    it->second.mUsage.add(usage);
+}
+
+Json::Value
+SorobanContractProfiler::getJsonInfo(size_t limit) const
+{
+    // Entries of the same contract are adjacent in the map
+    struct ContractUsage
+    {
+        Hash const* mContractID;
+        Usage mUsage;
+        uint64_t mCpuInsnError{0};
+        std::vector<std::pair<std::string const*, Tracked const*>> mFunctions;
+    };
+    std::vector<ContractUsage> contracts;
+    for (auto const& [key, tracked] : mTracked)
+    {
+        if (contracts.empty() || *contracts.back().mContractID != key.first)
+        {
+            contracts.emplace_back();
+            contracts.back().mContractID = &key.first;
+        }
+        auto& contract = contracts.back();
+        contract.mUsage.add(tracked.mUsage);
+        contract.mCpuInsnError += tracked.mCpuInsnError;
+        contract.mFunctions.emplace_back(&key.second, &tracked);
+    }
+
+    std::sort(contracts.begin(), contracts.end(),
+              [](ContractUsage const& a, ContractUsage const& b) {
+                  return a.mUsage.mCpuInsn > b.mUsage.mCpuInsn;
+              });
+
+    Json::Value res;
+    res["tracked_functions"] = static_cast<Json::UInt64>(mTracked.size());
+    auto& resContracts = res["contracts"];
+    resContracts = Json::arrayValue;
+    for (size_t i = 0; i < std::min(limit, contracts.size()); ++i)
+    {
+        auto const& contract = contracts[i];
+        Json::Value c;
+        c["contract_id"] =
+            strKey::toStrKey(strKey::STRKEY_CONTRACT, *contract.mContractID)
+                .value;
+        usageToJson(contract.mUsage, c);
+        c["cpu_insns_error"] =
+            static_cast<Json::UInt64>(contract.mCpuInsnError);
+        for (auto const& [function, tracked] : contract.mFunctions)
+        {
+            auto& f = c["functions"][*function];
+            usageToJson(tracked->mUsage, f);
+            f["cpu_insns_error"] =
+                static_cast<Json::UInt64>(tracked->mCpuInsnError);
+        }
+        resContracts.append(c);
+    }
+    return res;
+}
+
+void
+SorobanContractProfiler::clear()
+{
+    mTracked.clear();
+}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "xdr/Stellar-types.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace Json
+{
+class Value;
+}
+
+namespace stellar
+{
+
+// Aggregates the resources used by Soroban invocations per contract and
+// function, to find the contracts that dominate apply time.
+//
+// Only the MAX_TRACKED heaviest contract functions (by cpu instructions) are
+// kept, using the space-saving algorithm: once full, a new function replaces
+// the lightest one and inherits its instruction count as an error bound, so
+// a function invoked often enough is guaranteed to be tracked.
+class SorobanContractProfiler
+{
+  public:
+    static constexpr size_t MAX_TRACKED = 1000;
+
+    struct Usage
+    {
+        uint64_t mInvocations{0};
+        uint64_t mCpuInsn{0};
+        uint64_t mInvokeTimeNsecs{0};
+        uint64_t mMemByte{0};
+        uint64_t mReadEntry{0};
+        uint64_t mWriteEntry{0};
+        uint64_t mReadByte{0};
+        uint64_t mWriteByte{0};
+        int64_t mResourceFee{0};
+
+        void add(Usage const& other);
+    };
+
+    void noteInvocation(Hash const& contractID, std::string const& function,
+                        Usage const& usage);
+
+    // Returns the `limit` contracts that used the most cpu instructions, with
+    // a breakdown per function
+    Json::Value getJsonInfo(size_t limit) const;
+
+    void clear();
+
+  private:
+    struct Tracked
+    {
+        Usage mUsage;
+        // Instructions of the functions this one replaced
+        uint64_t mCpuInsnError{0};
+    };
+
+    std::map<std::pair<Hash, std::string>, Tracked> mTracked;
+};
+}
@@ -74,6 +74,10 @@ SorobanMetrics::SorobanMetrics(medida::MetricsRegistry& metrics)
           metrics.NewMeter({"soroban", "host-fn-op", "success"}, "call"))
     , mHostFnOpFailure(
           metrics.NewMeter({"soroban", "host-fn-op", "failure"}, "call"))
+    , mHostFnOpPrecomputed(
+          metrics.NewMeter({"soroban", "host-fn-op", "precomputed"}, "call"))
+    , mHostFnOpStellarAssetInvokeTimeNsecs(metrics.NewTimer(
+          {"soroban", "host-fn-op", "sac-invoke-time-nsecs"}))
     , mHostFnOpExec(metrics.NewTimer({"soroban", "host-fn-op", "exec"}))
     /* ExtendFootprintTTLOp metrics */
     , mExtFpTtlOpReadLedgerByte(metrics.NewMeter(
@@ -71,6 +71,8 @@ class SorobanMetrics
     medida::Meter& mHostFnOpMaxEmitEventByte;
     medida::Meter& mHostFnOpSuccess;
     medida::Meter& mHostFnOpFailure;
+    medida::Meter& mHostFnOpPrecomputed;
+    medida::Timer& mHostFnOpStellarAssetInvokeTimeNsecs;
     medida::Timer& mHostFnOpExec;
 
     // `ExtendFootprintTTLOp` metrics
@@ -7,7 +7,9 @@
 #include "bucket/test/BucketTestUtils.h"
 #include "catchup/ReplayDebugMetaWork.h"
 #include "crypto/Hex.h"
+#include "crypto/KeyUtils.h"
 #include "crypto/Random.h"
+#include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
 #include "history/HistoryArchiveManager.h"
 #include "history/test/HistoryTestsUtils.h"
@@ -24,16 +26,20 @@
 #include "transactions/test/SorobanTxTestUtils.h"
 #include "util/DebugMetaUtils.h"
 #include "util/Logging.h"
+#include "util/MetaRingBuffer.h"
 #include "util/MetaUtils.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDRCereal.h"
 #include "util/XDRStream.h"
+#include "util/xdrquery/XDRQuery.h"
 #include "work/WorkScheduler.h"
 #include "xdr/Stellar-ledger.h"
 #include "xdr/Stellar-transaction.h"
 #include <fmt/format.h>
 #include <fstream>
 #include <iterator>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
 
 using namespace stellar;
 
@@ -281,6 +287,8 @@ TEST_CASE("LedgerCloseMetaStream file descriptor - REPLAY_IN_MEMORY",
 #endif
 
     bool const delayMeta = GENERATE(true, false);
+    bool const backgroundMeta = GENERATE(true, false);
+    uint32_t const metaQueueLedgers = GENERATE(1u, 4u);
 
     // Step 3: pass it to an application and have it catch up to the generated
     // history, streaming ledgerCloseMeta to the file descriptor.
@@ -292,6 +300,8 @@ TEST_CASE("LedgerCloseMetaStream file descriptor - REPLAY_IN_MEMORY",
         cfg.RUN_STANDALONE = true;
         cfg.setInMemoryMode();
         cfg.EXPERIMENTAL_PRECAUTION_DELAY_META = delayMeta;
+        cfg.EXPERIMENTAL_BACKGROUND_META_EMISSION = backgroundMeta;
+        cfg.METADATA_OUTPUT_QUEUE_LEDGERS = metaQueueLedgers;
         VirtualClock clock;
         auto app = createTestApplication(clock, cfg, /*newdb=*/false);
 
@@ -398,6 +408,108 @@ TEST_CASE("EXPERIMENTAL_PRECAUTION_DELAY_META configuration",
     }
 }
 
+#ifndef _WIN32
+TEST_CASE("LedgerCloseMetaStream shared memory ring buffer",
+          "[ledgerclosemetastreamlive]")
+{
+    TmpDirManager tdm(std::string("streamtmp-") + binToHex(randomBytes(8)));
+    TmpDir td = tdm.tmpDir("streams");
+    std::string ringPath = td.getName() + "/meta.ring";
+
+    VirtualClock clock;
+    Config cfg = getTestConfig();
+    cfg.METADATA_OUTPUT_STREAM = "shm:" + ringPath;
+    cfg.METADATA_OUTPUT_RING_BUFFER_MB = 1;
+    cfg.EXPERIMENTAL_BACKGROUND_META_EMISSION = GENERATE(false, true);
+    auto app = createTestApplication(clock, cfg);
+    MetaRingBufferReader reader(ringPath);
+    REQUIRE(reader.capacity() == 1024 * 1024);
+
+    auto& lm = app->getLedgerManager();
+    // Each ledger's meta is in the ring once it has closed and the meta
+    // thread (if any) has written it
+    LedgerCloseMeta lcm;
+    for (int i = 0; i < 10; ++i)
+    {
+        txtest::closeLedger(*app);
+        // Wait for the meta thread, if any
+        while (!reader.readOne(lcm))
+        {
+            clock.crank(false);
+        }
+        auto const& header = lcm.v() == 0 ? lcm.v0().ledgerHeader
+                                          : lcm.v1().ledgerHeader;
+        REQUIRE(header.hash == lm.getLastClosedLedgerHeader().hash);
+        REQUIRE(!reader.readOne(lcm));
+    }
+}
+#endif
+
+TEST_CASE("meta filter keeps changes to matching entries",
+          "[ledgerclosemeta]")
+{
+    auto accountA = LedgerTestUtils::generateValidLedgerEntryOfType(ACCOUNT);
+    auto accountB = LedgerTestUtils::generateValidLedgerEntryOfType(ACCOUNT);
+    auto dataA = LedgerTestUtils::generateValidLedgerEntryOfType(DATA);
+    dataA.data.data().accountID = accountA.data.account().accountID;
+    auto makeChange = [](LedgerEntryChangeType type, LedgerEntry const& le) {
+        LedgerEntryChange change;
+        change.type(type);
+        switch (type)
+        {
+        case LEDGER_ENTRY_STATE:
+            change.state() = le;
+            break;
+        case LEDGER_ENTRY_UPDATED:
+            change.updated() = le;
+            break;
+        default:
+            change.removed() = LedgerEntryKey(le);
+        }
+        return change;
+    };
+
+    LedgerCloseMeta lcm;
+    lcm.v(1);
+    auto& txs = lcm.v1().txProcessing;
+    // A's fee, a change to B and the removal of A's data
+    txs.emplace_back();
+    txs.back().result.transactionHash = sha256("A");
+    txs.back().feeProcessing = {makeChange(LEDGER_ENTRY_STATE, accountA),
+                                makeChange(LEDGER_ENTRY_UPDATED, accountA)};
+    txs.back().txApplyProcessing.v(2);
+    auto& metaA = txs.back().txApplyProcessing.v2();
+    metaA.txChangesBefore = {makeChange(LEDGER_ENTRY_STATE, accountB),
+                             makeChange(LEDGER_ENTRY_UPDATED, accountB)};
+    metaA.operations.emplace_back();
+    metaA.operations.back().changes = {
+        makeChange(LEDGER_ENTRY_STATE, dataA),
+        makeChange(LEDGER_ENTRY_REMOVED, dataA)};
+    // Only B's fee
+    txs.emplace_back();
+    txs.back().feeProcessing = {makeChange(LEDGER_ENTRY_STATE, accountB),
+                                makeChange(LEDGER_ENTRY_UPDATED, accountB)};
+    txs.back().txApplyProcessing.v(2);
+
+    auto accountIDA = KeyUtils::toStrKey(accountA.data.account().accountID);
+    xdrquery::XDRMatcher filter(
+        fmt::format("data.account.accountID == '{}' || "
+                    "data.data.accountID == '{}'",
+                    accountIDA, accountIDA));
+    auto const hashA = txs.front().result.transactionHash;
+    filterMeta(lcm, filter);
+
+    REQUIRE(txs.size() == 1);
+    REQUIRE(txs[0].result.transactionHash == hashA);
+    REQUIRE(txs[0].feeProcessing.size() == 2);
+    auto const& filteredA = txs[0].txApplyProcessing.v2();
+    REQUIRE(filteredA.txChangesBefore.empty());
+    REQUIRE(filteredA.operations.size() == 1);
+    REQUIRE(filteredA.operations[0].changes.size() == 2);
+    REQUIRE(filteredA.operations[0].changes[1].removed() ==
+            LedgerEntryKey(dataA));
+}
+
 TEST_CASE("METADATA_DEBUG_LEDGERS works", "[metadebug]")
 {
     VirtualClock clock;
@@ -445,9 +557,14 @@ TEST_CASE("METADATA_DEBUG_LEDGERS works", "[metadebug]")
     SECTION("meta zipped and garbage collected")
     {
         closeLedgers(2 * cfg.METADATA_DEBUG_LEDGERS);
+        // No rotation was skipped
+        auto segments = 2 * cfg.METADATA_DEBUG_LEDGERS /
+                        metautils::META_DEBUG_LEDGER_SEGMENT_SIZE;
+        REQUIRE(app->getMetrics()
+                    .NewTimer({"ledger", "metadebug", "rotate"})
+                    .count() >= segments - 1);
     }
-    SECTION("meta replayed")
-    {
+    auto replayMeta = [&](bool applyChanges) {
         // Generate just enough meta to not triggers garbage collection
         closeLedgers(cfg.METADATA_DEBUG_LEDGERS);
         app->gracefulStop();
@@ -472,10 +589,19 @@ TEST_CASE("METADATA_DEBUG_LEDGERS works", "[metadebug]")
 
         auto replayWork =
             replayApp->getWorkScheduler().executeWork<ReplayDebugMetaWork>(
-                lm.getLastClosedLedgerNum(), bucketDir);
+                lm.getLastClosedLedgerNum(), bucketDir, applyChanges);
         REQUIRE(replayWork->getState() == BasicWork::State::WORK_SUCCESS);
-        REQUIRE(replayApp->getLedgerManager().getLastClosedLedgerNum() ==
-                lm.getLastClosedLedgerNum());
+        auto const& replayLcl =
+            replayApp->getLedgerManager().getLastClosedLedgerHeader();
+        REQUIRE(replayLcl.hash == lm.getLastClosedLedgerHeader().hash);
+    };
+    SECTION("meta replayed")
+    {
+        replayMeta(false);
+    }
+    SECTION("meta replayed from ledger entry changes")
+    {
+        replayMeta(true);
     }
 }
 
@@ -6,9 +6,14 @@
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
 #include "main/Application.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
 #include "test/test.h"
 
 #include <lib/catch.hpp>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
 
 using namespace stellar;
 
@@ -45,3 +50,107 @@ TEST_CASE("cannot close ledger with unsupported ledger version", "[ledger]")
     }
     REQUIRE_THROWS_AS(applyEmptyLedger(), std::runtime_error);
 }
+
+TEST_CASE("fees are charged the same whether or not changes are collected",
+          "[ledger]")
+{
+    // Returns the header of the ledger charging the fees
+    auto closeLedgerWithFees = [](Config cfg) {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, cfg);
+        auto root = TestAccount::createRoot(*app);
+        auto minBalance = app->getLedgerManager().getLastMinBalance(2);
+        auto a = root.create("A", minBalance * 10);
+        auto b = root.create("B", minBalance * 10);
+        auto c = root.create("C", minBalance * 10);
+
+        // Two transactions from the same account, and a fee bump whose fee
+        // source has a transaction of its own
+        auto dest = root.getPublicKey();
+        std::vector<TransactionFrameBasePtr> txs = {
+            a.tx({txtest::payment(dest, 1)}), a.tx({txtest::payment(dest, 2)}),
+            c.tx({txtest::payment(dest, 3)}),
+            txtest::feeBump(*app, c, b.tx({txtest::payment(dest, 4)}), 400)};
+        auto ledgerSeq = app->getLedgerManager().getLastClosedLedgerNum() + 1;
+        txtest::closeLedgerOn(*app, ledgerSeq, 2, 1, 2016, txs);
+        return app->getLedgerManager().getLastClosedLedgerHeader().header;
+    };
+
+    auto cfg1 = getTestConfig(0);
+    auto cfg2 = getTestConfig(1);
+    cfg2.MODE_STORES_HISTORY_MISC = false;
+    auto withChanges = closeLedgerWithFees(cfg1);
+    auto withoutChanges = closeLedgerWithFees(cfg2);
+    REQUIRE(withChanges.ledgerSeq == withoutChanges.ledgerSeq);
+    REQUIRE(withChanges.feePool == withoutChanges.feePool);
+    REQUIRE(withChanges.txSetResultHash == withoutChanges.txSetResultHash);
+    REQUIRE(withChanges.bucketListHash == withoutChanges.bucketListHash);
+}
+
+TEST_CASE("ledger close batch defers housekeeping", "[ledger]")
+{
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, getTestConfig(0));
+    app->start();
+
+    auto& lm = app->getLedgerManager();
+    auto& gcTimer = app->getMetrics().NewTimer({"bucket", "gc", "forget"});
+    auto applyEmptyLedger = [&]() {
+        auto const& lcl = lm.getLastClosedLedgerHeader();
+        auto txSet = TxSetXDRFrame::makeEmpty(lcl);
+        StellarValue sv = app->getHerder().makeStellarValue(
+            txSet->getContentsHash(), 1, emptyUpgradeSteps,
+            app->getConfig().NODE_SEED);
+
+        LedgerCloseData ledgerData(lcl.header.ledgerSeq + 1, txSet, sv);
+        lm.closeLedger(ledgerData);
+    };
+
+    auto gcCount = gcTimer.count();
+    applyEmptyLedger();
+    REQUIRE(gcTimer.count() == gcCount + 1);
+
+    auto lcl = lm.getLastClosedLedgerNum();
+    lm.beginLedgerCloseBatch();
+    for (int i = 0; i < 5; ++i)
+    {
+        applyEmptyLedger();
+    }
+    REQUIRE(lm.getLastClosedLedgerNum() == lcl + 5);
+    REQUIRE(gcTimer.count() == gcCount + 1);
+    lm.endLedgerCloseBatch();
+    REQUIRE(gcTimer.count() == gcCount + 2);
+}
+
+TEST_CASE("close timing reports recent ledgers", "[ledger]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig(0));
+    auto& lm = app->getLedgerManager();
+    auto root = TestAccount::createRoot(*app);
+    auto minBalance = lm.getLastMinBalance(2);
+    auto a = root.create("A", minBalance * 10);
+
+    auto dest = root.getPublicKey();
+    std::vector<TransactionFrameBasePtr> txs = {
+        a.tx({txtest::payment(dest, 1)}), a.tx({txtest::payment(dest, 2)})};
+    auto ledgerSeq = lm.getLastClosedLedgerNum() + 1;
+    txtest::closeLedgerOn(*app, ledgerSeq, 2, 1, 2016, txs);
+
+    auto timing = lm.getJsonCloseTimingInfo(5);
+    REQUIRE(timing.size() <= 5);
+    auto const& t = timing[std::to_string(ledgerSeq)];
+    REQUIRE(t["txs"].asUInt64() == 2);
+    REQUIRE(t["ops"].asUInt64() == 2);
+    REQUIRE(t["soroban_apply_ms"].asDouble() == 0);
+    double phases = 0;
+    for (auto const& phase :
+         {"prepare_ms", "fees_seqnums_ms", "classic_apply_ms", "commit_ms",
+          "add_batch_ms", "meta_ms", "history_ms"})
+    {
+        phases += t[phase].asDouble();
+    }
+    REQUIRE(phases <= t["total_ms"].asDouble());
+    REQUIRE(t["merge_wait_ms"].asDouble() <= t["add_batch_ms"].asDouble());
+    REQUIRE(lm.getJsonCloseTimingInfo(1).size() == 1);
+}
@@ -2,6 +2,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "bucket/test/BucketTestUtils.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
@@ -18,6 +19,7 @@
 #include "util/Math.h"
 #include "util/XDROperators.h"
 #include <algorithm>
+#include <chrono>
 #include <fmt/format.h>
 #include <functional>
 #include <map>
@@ -475,6 +477,26 @@ TEST_CASE("LedgerTxn round trip", "[ledgertxn]")
 
                 runTest(app->getLedgerTxnRoot());
             }
+
+            SECTION("with parallel commit encoding")
+            {
+                VirtualClock clock;
+                auto cfg = getTestConfig(0, mode);
+                cfg.PARALLEL_LEDGER_COMMIT_ENCODING = true;
+                auto app = createTestApplication(clock, cfg);
+
+                runTest(app->getLedgerTxnRoot());
+            }
+
+            SECTION("while bulk populating")
+            {
+                VirtualClock clock;
+                auto app = createTestApplication(clock, getTestConfig(0, mode));
+
+                app->getLedgerTxnRoot().beginBulkPopulate(false);
+                runTest(app->getLedgerTxnRoot());
+                app->getLedgerTxnRoot().endBulkPopulate();
+            }
         }
     };
 
@@ -491,6 +513,61 @@ TEST_CASE("LedgerTxn round trip", "[ledgertxn]")
 #endif
 }
 
+TEST_CASE("LedgerTxnRoot bulk populate", "[ledgertxn]")
+{
+    auto runTest = [&](Config::TestDbMode mode) {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, getTestConfig(0, mode));
+        auto& root = app->getLedgerTxnRoot();
+
+        SECTION("fails on non-root LedgerTxn")
+        {
+            LedgerTxn ltx(root);
+            REQUIRE_THROWS_AS(ltx.beginBulkPopulate(true), std::runtime_error);
+            REQUIRE_THROWS_AS(ltx.endBulkPopulate(), std::runtime_error);
+        }
+
+        SECTION("unique offers into empty table")
+        {
+            auto offers =
+                LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+                    {OFFER}, 300);
+            root.beginBulkPopulate(true);
+            for (size_t i = 0; i < offers.size(); i += 100)
+            {
+                LedgerTxn ltx(root);
+                for (size_t j = i; j < i + 100; ++j)
+                {
+                    ltx.createWithoutLoading(offers[j]);
+                }
+                ltx.commit();
+            }
+            root.endBulkPopulate();
+
+            LedgerTxn ltx(root);
+            for (auto const& le : offers)
+            {
+                auto ltxe = ltx.load(LedgerEntryKey(le));
+                REQUIRE(ltxe);
+                REQUIRE(ltxe.current() == le);
+            }
+            REQUIRE(ltx.getAllOffers().size() == offers.size());
+        }
+    };
+
+    SECTION("default")
+    {
+        runTest(Config::TESTDB_DEFAULT);
+    }
+
+#ifdef USE_POSTGRES
+    SECTION("postgresql")
+    {
+        runTest(Config::TESTDB_POSTGRESQL);
+    }
+#endif
+}
+
 TEST_CASE("LedgerTxn rollback and commit deactivate", "[ledgertxn]")
 {
     VirtualClock clock;
@@ -790,6 +867,71 @@ TEST_CASE("LedgerTxn erase", "[ledgertxn]")
 #endif
 }
 
+TEST_CASE("LedgerTxn getDeltaAndChanges", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+
+    auto entries = LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+        {ACCOUNT}, 3);
+    for (auto& le : entries)
+    {
+        le.lastModifiedLedgerSeq = 1;
+    }
+
+    LedgerTxn ltx1(app->getLedgerTxnRoot());
+    REQUIRE(ltx1.create(entries[0]));
+    REQUIRE(ltx1.create(entries[1]));
+
+    // Creates, updates and erases an entry
+    auto modify = [&](LedgerTxn& ltx) {
+        REQUIRE(ltx.create(entries[2]));
+        REQUIRE(ltx.load(LedgerEntryKey(entries[0])));
+        ltx.erase(LedgerEntryKey(entries[1]));
+    };
+
+    std::pair<LedgerTxnDelta, LedgerEntryChanges> combined;
+    {
+        LedgerTxn ltx2(ltx1);
+        modify(ltx2);
+        combined = ltx2.getDeltaAndChanges();
+        REQUIRE_THROWS_AS(ltx2.create(entries[1]), std::runtime_error);
+    }
+    LedgerEntryChanges changes;
+    {
+        LedgerTxn ltx2(ltx1);
+        modify(ltx2);
+        changes = ltx2.getChanges();
+    }
+    LedgerTxnDelta delta;
+    {
+        LedgerTxn ltx2(ltx1);
+        modify(ltx2);
+        delta = ltx2.getDelta();
+    }
+
+    REQUIRE(changes.size() == 5);
+    REQUIRE(combined.second == changes);
+    REQUIRE(combined.first.entry.size() == delta.entry.size());
+    for (auto const& kv : delta.entry)
+    {
+        auto it = combined.first.entry.find(kv.first);
+        REQUIRE(it != combined.first.entry.end());
+        REQUIRE((bool)it->second.current == (bool)kv.second.current);
+        if (kv.second.current)
+        {
+            REQUIRE(*it->second.current == *kv.second.current);
+        }
+        REQUIRE((bool)it->second.previous == (bool)kv.second.previous);
+        if (kv.second.previous)
+        {
+            REQUIRE(*it->second.previous == *kv.second.previous);
+        }
+    }
+    REQUIRE(combined.first.header.current == delta.header.current);
+    REQUIRE(combined.first.header.previous == delta.header.previous);
+}
+
 TEST_CASE("LedgerTxn eraseWithoutLoading", "[ledgertxn]")
 {
     auto runTest = [&](Config::TestDbMode mode) {
@@ -1697,6 +1839,136 @@ testAllOffers(
     }
 }
 
+TEST_CASE("LedgerTxn loadBatch", "[ledgertxn]")
+{
+    auto runTest = [&](Config::TestDbMode mode) {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, getTestConfig(0, mode));
+        auto& root = app->getLedgerTxnRoot();
+
+        auto entries =
+            LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+                {ACCOUNT, TRUSTLINE, DATA, CLAIMABLE_BALANCE}, 5);
+        std::vector<InternalLedgerKey> keys;
+        for (auto& le : entries)
+        {
+            le.lastModifiedLedgerSeq = 1;
+            keys.emplace_back(LedgerEntryKey(le));
+        }
+
+        // entries[0..2] are in the database, entries[3] is created in ltx1
+        // where entries[0] is erased, and entries[4] exists nowhere
+        {
+            LedgerTxn ltx(root);
+            for (size_t i = 0; i < 3; ++i)
+            {
+                ltx.createWithoutLoading(entries[i]);
+            }
+            ltx.commit();
+        }
+        LedgerTxn ltx1(root);
+        REQUIRE(ltx1.create(entries[3]));
+        ltx1.erase(keys[0]);
+
+        // Load through a grandchild so that keys pass through two LedgerTxns
+        LedgerTxn ltx2(ltx1);
+        LedgerTxn ltx3(ltx2);
+
+        SECTION("matches load")
+        {
+            UnorderedMap<LedgerKey, LedgerTxnDelta::EntryDelta> expected;
+            {
+                LedgerTxn ltxLoad(ltx3);
+                for (auto const& key : keys)
+                {
+                    ltxLoad.load(key);
+                }
+                expected = ltxLoad.getDelta().entry;
+            }
+
+            {
+                auto loaded = ltx3.loadBatch(keys);
+                REQUIRE(loaded.size() == keys.size());
+                REQUIRE(!loaded[0]);
+                REQUIRE(!loaded[4]);
+                for (size_t i = 1; i < 4; ++i)
+                {
+                    REQUIRE(loaded[i]);
+                    REQUIRE(loaded[i].current() == entries[i]);
+                }
+
+                // Entries are active until released
+                REQUIRE_THROWS_AS(ltx3.load(keys[1]), std::runtime_error);
+            }
+
+            auto delta = ltx3.getDelta();
+            REQUIRE(delta.entry.size() == expected.size());
+            for (auto const& kv : expected)
+            {
+                auto iter = delta.entry.find(kv.first);
+                REQUIRE(iter != delta.entry.end());
+                REQUIRE((bool)iter->second.current == (bool)kv.second.current);
+                REQUIRE(*iter->second.current == *kv.second.current);
+                REQUIRE((bool)iter->second.previous ==
+                        (bool)kv.second.previous);
+                if (kv.second.previous)
+                {
+                    REQUIRE(*iter->second.previous == *kv.second.previous);
+                }
+            }
+        }
+
+        SECTION("keys already in the LedgerTxn")
+        {
+            {
+                auto ltxe = ltx3.load(keys[2]);
+                ltxe.current().lastModifiedLedgerSeq = 2;
+            }
+            auto loaded = ltx3.loadBatch({keys[2], keys[1]});
+            REQUIRE(loaded[0].current().lastModifiedLedgerSeq == 2);
+            REQUIRE(loaded[1].current() == entries[1]);
+        }
+
+        SECTION("fails with duplicate keys")
+        {
+            REQUIRE_THROWS_AS(ltx3.loadBatch({keys[1], keys[2], keys[1]}),
+                              std::runtime_error);
+            REQUIRE(ltx3.getDelta().entry.empty());
+        }
+
+        SECTION("fails if a key is active")
+        {
+            auto ltxe = ltx3.load(keys[2]);
+            REQUIRE_THROWS_AS(ltx3.loadBatch({keys[1], keys[2]}),
+                              std::runtime_error);
+        }
+
+        SECTION("fails with children")
+        {
+            LedgerTxn ltx4(ltx3);
+            REQUIRE_THROWS_AS(ltx3.loadBatch({keys[1]}), std::runtime_error);
+        }
+
+        SECTION("fails if sealed")
+        {
+            ltx3.getDelta();
+            REQUIRE_THROWS_AS(ltx3.loadBatch({keys[1]}), std::runtime_error);
+        }
+    };
+
+    SECTION("default")
+    {
+        runTest(Config::TESTDB_DEFAULT);
+    }
+
+#ifdef USE_POSTGRES
+    SECTION("postgresql")
+    {
+        runTest(Config::TESTDB_POSTGRESQL);
+    }
+#endif
+}
+
 TEST_CASE("LedgerTxn loadAllOffers", "[ledgertxn]")
 {
     auto runTest = [&](Config::TestDbMode mode) {
@@ -1964,6 +2236,20 @@ testBestOffer(
         testAtRoot(*app);
     }
 
+    // first changes are in LedgerTxnRoot with the in-memory order book, which
+    // is loaded before they are committed
+    if (updates.size() > 1)
+    {
+        VirtualClock clock;
+        auto cfg = getTestConfig(0, mode);
+        cfg.IN_MEMORY_ORDER_BOOK = true;
+        cfg.IN_MEMORY_ORDER_BOOK_CHECKS = true;
+        auto app = createTestApplication(clock, cfg);
+        app->getLedgerTxnRoot().getBestOffer(buying, selling);
+
+        testAtRoot(*app);
+    }
+
     // first changes are in child of LedgerTxnRoot
     {
         VirtualClock clock;
@@ -2347,6 +2633,20 @@ testOffersByAccountAndAsset(
         testAtRoot(*app);
     }
 
+    // first changes are in LedgerTxnRoot with the in-memory order book, which
+    // is loaded before they are committed
+    if (updates.size() > 1)
+    {
+        VirtualClock clock;
+        auto cfg = getTestConfig();
+        cfg.IN_MEMORY_ORDER_BOOK = true;
+        cfg.IN_MEMORY_ORDER_BOOK_CHECKS = true;
+        auto app = createTestApplication(clock, cfg);
+        app->getLedgerTxnRoot().getOffersByAccountAndAsset(accountID, asset);
+
+        testAtRoot(*app);
+    }
+
     // first changes are in child of LedgerTxnRoot
     {
         VirtualClock clock;
@@ -2804,6 +3104,59 @@ TEST_CASE("Erase performance benchmark", "[!hide][erasebench]")
 #endif
 }
 
+TEST_CASE("Nested commit performance benchmark", "[!hide][nestedcommitbench]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0, Config::TESTDB_DEFAULT));
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    size_t const n = 0xfff, depth = 8, rounds = 0x40;
+    auto entries = LedgerTestUtils::generateValidLedgerEntries(n * rounds);
+
+    LedgerTxn ltxRoot(app->getLedgerTxnRoot());
+    auto it = entries.begin();
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        // Each round creates n entries at the deepest of depth nested
+        // LedgerTxns and commits them level by level. Every commit but the
+        // last lands in an empty parent; the last one merges into ltxRoot,
+        // which keeps growing across rounds.
+        std::vector<std::unique_ptr<LedgerTxn>> ltxs;
+        for (size_t d = 0; d < depth; ++d)
+        {
+            ltxs.emplace_back(std::make_unique<LedgerTxn>(
+                d == 0 ? static_cast<AbstractLedgerTxnParent&>(ltxRoot)
+                       : *ltxs.back()));
+        }
+        for (size_t i = 0; i < n; ++i, ++it)
+        {
+            ltxs.back()->createWithoutLoading(*it);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        while (ltxs.size() > 1)
+        {
+            ltxs.back()->commit();
+            ltxs.pop_back();
+        }
+        auto mid = std::chrono::steady_clock::now();
+        ltxs.back()->commit();
+        auto end = std::chrono::steady_clock::now();
+
+        CLOG_INFO(Ledger,
+                  "benchmark nested commit: {} entries x {} levels in {}us, "
+                  "merge into {} entries in {}us",
+                  n, depth - 1,
+                  std::chrono::duration_cast<std::chrono::microseconds>(
+                      mid - start)
+                      .count(),
+                  r * n,
+                  std::chrono::duration_cast<std::chrono::microseconds>(
+                      end - mid)
+                      .count());
+    }
+}
+
 TEST_CASE("Bulk load batch size benchmark", "[!hide][bulkbatchsizebench]")
 {
     size_t floor = 1000;
@@ -3590,6 +3943,37 @@ TEST_CASE("LedgerTxn in memory order book", "[ledgertxn]")
                 }
             }
         }
+
+        SECTION("child committed into empty parent")
+        {
+            LedgerEntry le1;
+            le1.data.type(OFFER);
+            le1.data.offer() = LedgerTestUtils::generateValidOfferEntry();
+            LedgerEntry le2 = generateOfferWithSameAssets(le1);
+            LedgerEntry le3 = generateOfferWithSameAssets(le1);
+            AssetPair assets{le1.data.offer().buying,
+                             le1.data.offer().selling};
+
+            LedgerTxn ltx(app->getLedgerTxnRoot());
+            {
+                LedgerTxn ltxChild(ltx);
+                ltxChild.create(le1);
+                ltxChild.create(le2);
+                ltxChild.commit();
+            }
+            checkOrderBook(ltx, {{assets, {le1, le2}}});
+            REQUIRE(ltx.load(LedgerEntryKey(le1)));
+
+            // Committing into the now non-empty parent merges as usual
+            {
+                LedgerTxn ltxChild(ltx);
+                ltxChild.erase(LedgerEntryKey(le1));
+                ltxChild.create(le3);
+                ltxChild.commit();
+            }
+            checkOrderBook(ltx, {{assets, {le2, le3}}});
+            REQUIRE(!ltx.load(LedgerEntryKey(le1)));
+        }
     };
 
     SECTION("default")
@@ -3826,6 +4210,246 @@ TEST_CASE("LedgerTxn generalized ledger entries", "[ledgertxn]")
     }
 }
 
+TEST_CASE("LedgerTxnRoot in-memory order book", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.IN_MEMORY_ORDER_BOOK = true;
+    cfg.IN_MEMORY_ORDER_BOOK_CHECKS = true;
+    auto app = createTestApplication(clock, cfg);
+    auto& root = app->getLedgerTxnRoot();
+
+    Asset a = LedgerTestUtils::generateValidOfferEntry().buying;
+    Asset b = LedgerTestUtils::generateValidOfferEntry().selling;
+    REQUIRE(!(a == b));
+    std::vector<AccountID> sellers;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        sellers.emplace_back(
+            LedgerTestUtils::generateValidAccountEntry().accountID);
+    }
+
+    // Offers committed so far, by offer id
+    std::map<int64_t, OfferEntry> expected;
+
+    // The seller is part of the key, so it is only chosen on creation
+    auto randomizeOffer = [&](OfferEntry& oe) {
+        bool aForB = rand_flip();
+        oe.buying = aForB ? a : b;
+        oe.selling = aForB ? b : a;
+        oe.price.n = rand_uniform<int32_t>(1, 5);
+        oe.price.d = rand_uniform<int32_t>(1, 5);
+        oe.amount = rand_uniform<int64_t>(1, 1000);
+    };
+
+    auto checkBook = [&](Asset const& buying, Asset const& selling) {
+        std::vector<OfferEntry> book;
+        for (auto const& kv : expected)
+        {
+            if (kv.second.buying == buying && kv.second.selling == selling)
+            {
+                book.emplace_back(kv.second);
+            }
+        }
+        std::sort(book.begin(), book.end(),
+                  [](OfferEntry const& lhs, OfferEntry const& rhs) {
+                      return isBetterOffer({lhs.price, lhs.offerID},
+                                           {rhs.price, rhs.offerID});
+                  });
+
+        auto le = root.getBestOffer(buying, selling);
+        for (auto const& oe : book)
+        {
+            REQUIRE(le);
+            REQUIRE(le->data.offer() == oe);
+            le = root.getBestOffer(buying, selling, {oe.price, oe.offerID});
+        }
+        REQUIRE(!le);
+    };
+
+    auto checkSellers = [&]() {
+        for (auto const& seller : sellers)
+        {
+            size_t count = 0;
+            for (auto const& kv : expected)
+            {
+                count += kv.second.sellerID == seller ? 1 : 0;
+            }
+            auto offers = root.getOffersByAccountAndAsset(seller, a);
+            REQUIRE(offers.size() == count);
+            for (auto const& kv : offers)
+            {
+                auto const& oe = kv.second.data.offer();
+                REQUIRE(expected.at(oe.offerID) == oe);
+            }
+        }
+    };
+
+    // Load the order book before anything is committed
+    checkBook(a, b);
+
+    int64_t nextOfferID = 1;
+    for (size_t ledger = 0; ledger < 20; ++ledger)
+    {
+        LedgerTxn ltx(root);
+        auto updated = expected;
+        for (size_t i = 0; i < 20; ++i)
+        {
+            auto op = updated.empty() ? 0 : rand_uniform<int>(0, 2);
+            if (op == 0)
+            {
+                auto le =
+                    LedgerTestUtils::generateValidLedgerEntryOfType(OFFER);
+                auto& oe = le.data.offer();
+                oe.offerID = nextOfferID++;
+                oe.sellerID = rand_element(sellers);
+                randomizeOffer(oe);
+                REQUIRE(ltx.create(le));
+                updated.emplace(oe.offerID, oe);
+                continue;
+            }
+
+            auto it = updated.begin();
+            std::advance(it, rand_uniform<size_t>(0, updated.size() - 1));
+            auto ltxe = ltx.load(offerKey(it->second.sellerID, it->first));
+            REQUIRE(ltxe);
+            if (op == 1)
+            {
+                auto& oe = ltxe.current().data.offer();
+                randomizeOffer(oe);
+                it->second = oe;
+            }
+            else
+            {
+                ltxe.erase();
+                updated.erase(it);
+            }
+        }
+
+        if (rand_flip())
+        {
+            ltx.commit();
+            expected = updated;
+        }
+        else
+        {
+            ltx.rollback();
+        }
+        checkBook(a, b);
+        checkBook(b, a);
+        checkSellers();
+    }
+}
+
+TEST_CASE("LedgerTxnRoot in-memory offers", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.IN_MEMORY_OFFERS = true;
+    auto app = createTestApplication<BucketTestUtils::BucketTestApplication>(
+        clock, cfg);
+    auto& lm = static_cast<BucketTestUtils::LedgerManagerForBucketTests&>(
+        app->getLedgerManager());
+    auto& root = app->getLedgerTxnRoot();
+
+    Asset a = LedgerTestUtils::generateValidOfferEntry().buying;
+    Asset b = LedgerTestUtils::generateValidOfferEntry().selling;
+    REQUIRE(!(a == b));
+    auto seller = LedgerTestUtils::generateValidAccountEntry().accountID;
+
+    int64_t nextOfferID = 1;
+    auto makeOffer = [&](bool aForB) {
+        auto le = LedgerTestUtils::generateValidLedgerEntryOfType(OFFER);
+        auto& oe = le.data.offer();
+        oe.offerID = nextOfferID++;
+        oe.sellerID = seller;
+        oe.buying = aForB ? a : b;
+        oe.selling = aForB ? b : a;
+        oe.price.n = rand_uniform<int32_t>(1, 5);
+        oe.price.d = rand_uniform<int32_t>(1, 5);
+        return le;
+    };
+
+    // Offers expected in the root, by offer id. Only the offers themselves
+    // are compared, as committing sets lastModifiedLedgerSeq.
+    std::map<int64_t, LedgerEntry> expected;
+    auto check = [&]() {
+        REQUIRE(root.countObjects(OFFER) == expected.size());
+        auto all = root.getAllOffers();
+        REQUIRE(all.size() == expected.size());
+        LedgerEntry const* best = nullptr;
+        for (auto const& kv : expected)
+        {
+            auto const& oe = kv.second.data.offer();
+            REQUIRE(all.at(LedgerEntryKey(kv.second)).data.offer() == oe);
+            if (oe.buying == a &&
+                (!best || isBetterOffer(kv.second, *best)))
+            {
+                best = &kv.second;
+            }
+        }
+        REQUIRE(best);
+        auto le = root.getBestOffer(a, b);
+        REQUIRE(le);
+        REQUIRE(le->data.offer() == best->data.offer());
+        REQUIRE(root.getOffersByAccountAndAsset(seller, a).size() ==
+                expected.size());
+
+        LedgerTxn ltx(root);
+        for (auto const& kv : expected)
+        {
+            auto ltxe = ltx.load(LedgerEntryKey(kv.second));
+            REQUIRE(ltxe);
+            REQUIRE(ltxe.current().data.offer() == kv.second.data.offer());
+        }
+        REQUIRE(!ltx.load(offerKey(seller, nextOfferID)));
+    };
+
+    // The offers only get to the BucketList, as from catchup
+    std::vector<LedgerEntry> init;
+    for (size_t i = 0; i < 20; ++i)
+    {
+        init.emplace_back(makeOffer(i % 2 == 0));
+        expected.emplace(nextOfferID - 1, init.back());
+    }
+    lm.setNextLedgerEntryBatchForBucketTesting(init, {}, {});
+    BucketTestUtils::closeLedger(*app);
+    check();
+
+    // Changes committed to the root go to memory only
+    std::vector<LedgerEntry> live;
+    std::vector<LedgerKey> dead;
+    {
+        LedgerTxn ltx(root);
+        auto created = makeOffer(true);
+        REQUIRE(ltx.create(created));
+        init = {created};
+
+        auto updated = ltx.load(LedgerEntryKey(expected.begin()->second));
+        auto& amount = updated.current().data.offer().amount;
+        amount = amount == 1 ? 2 : 1;
+        live = {updated.current()};
+
+        auto erasedID = expected.rbegin()->first;
+        dead = {LedgerEntryKey(expected.at(erasedID))};
+        ltx.erase(dead.front());
+        ltx.commit();
+
+        expected.erase(erasedID);
+        expected.begin()->second = live.front();
+        expected.emplace(created.data.offer().offerID, created);
+    }
+    check();
+
+    // Once the BucketList has the changes too, the offers reloaded from it
+    // are the same
+    lm.setNextLedgerEntryBatchForBucketTesting(init, live, dead);
+    BucketTestUtils::closeLedger(*app);
+    root.dropOffers(false);
+    check();
+}
+
 TEST_CASE("LedgerTxn best offers cache eviction", "[ledgertxn]")
 {
     VirtualClock clock;
@@ -0,0 +1,72 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/SHA.h"
+#include "ledger/SorobanContractProfiler.h"
+#include "lib/catch.hpp"
+#include <json/json.h>
+
+using namespace stellar;
+
+namespace
+{
+SorobanContractProfiler::Usage
+makeUsage(uint64_t cpuInsn)
+{
+    SorobanContractProfiler::Usage usage;
+    usage.mInvocations = 1;
+    usage.mCpuInsn = cpuInsn;
+    usage.mReadEntry = 2;
+    return usage;
+}
+}
+
+TEST_CASE("soroban contract profiler", "[ledger][soroban]")
+{
+    SorobanContractProfiler profiler;
+    auto light = sha256("light");
+    auto heavy = sha256("heavy");
+
+    SECTION("aggregates per contract and function")
+    {
+        profiler.noteInvocation(heavy, "transfer", makeUsage(100));
+        profiler.noteInvocation(heavy, "transfer", makeUsage(100));
+        profiler.noteInvocation(heavy, "mint", makeUsage(50));
+        profiler.noteInvocation(light, "get", makeUsage(10));
+
+        auto info = profiler.getJsonInfo(10);
+        REQUIRE(info["tracked_functions"].asUInt64() == 3);
+        auto const& contracts = info["contracts"];
+        REQUIRE(contracts.size() == 2);
+
+        auto const& top = contracts[0];
+        REQUIRE(top["cpu_insns"].asUInt64() == 250);
+        REQUIRE(top["invocations"].asUInt64() == 3);
+        REQUIRE(top["read_entries"].asUInt64() == 6);
+        REQUIRE(top["functions"]["transfer"]["cpu_insns"].asUInt64() == 200);
+        REQUIRE(top["functions"]["mint"]["invocations"].asUInt64() == 1);
+        REQUIRE(contracts[1]["cpu_insns"].asUInt64() == 10);
+
+        REQUIRE(profiler.getJsonInfo(1)["contracts"].size() == 1);
+    }
+
+    SECTION("keeps the heaviest functions when full")
+    {
+        for (size_t i = 0; i < SorobanContractProfiler::MAX_TRACKED; ++i)
+        {
+            profiler.noteInvocation(light, std::to_string(i),
+                                    makeUsage(i == 0 ? 1 : 1000));
+        }
+        profiler.noteInvocation(heavy, "heavy", makeUsage(5000));
+
+        auto info = profiler.getJsonInfo(10);
+        REQUIRE(info["tracked_functions"].asUInt64() ==
+                SorobanContractProfiler::MAX_TRACKED);
+        auto const& heavyInfo = info["contracts"][1]["functions"]["heavy"];
+        // The lightest function made room for the new one
+        REQUIRE(heavyInfo["cpu_insns"].asUInt64() == 5000);
+        REQUIRE(heavyInfo["cpu_insns_error"].asUInt64() == 1);
+        REQUIRE(!info["contracts"][0]["functions"].isMember("0"));
+    }
+}
@@ -5,6 +5,8 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "main/Config.h"
+#include "util/BackgroundPriority.h"
+#include "util/MemoryFootprint.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include "xdr/Stellar-types.h"
 #include <lib/json/json.h>
@@ -31,6 +33,7 @@ class CatchupManager;
 class HistoryArchiveManager;
 class HistoryManager;
 class Maintainer;
+class MemoryBudget;
 class ProcessManager;
 class Herder;
 class HerderPersistence;
@@ -199,6 +202,11 @@ class Application
     // Call syncOwnMetrics on self and syncMetrics all objects owned by App.
     virtual void syncAllMetrics() = 0;
 
+    // Estimate the memory held by the major in-memory structures of the
+    // application. syncOwnMetrics reports the same estimates as `memory.*`
+    // counters.
+    virtual MemoryFootprint getMemoryFootprint() = 0;
+
     // Clear all metrics
     virtual void clearMetrics(std::string const& domain) = 0;
 
@@ -210,6 +218,7 @@ class Application
     virtual HistoryArchiveManager& getHistoryArchiveManager() = 0;
     virtual HistoryManager& getHistoryManager() = 0;
     virtual Maintainer& getMaintainer() = 0;
+    virtual MemoryBudget& getMemoryBudget() = 0;
     virtual ProcessManager& getProcessManager() = 0;
     virtual Herder& getHerder() = 0;
     virtual HerderPersistence& getHerderPersistence() = 0;
@@ -234,13 +243,19 @@ class Application
         Scheduler::ActionType type = Scheduler::ActionType::NORMAL_ACTION) = 0;
 
     // While both are lower priority than the main thread, eviction threads have
-    // more priority than regular worker background threads
-    virtual void postOnBackgroundThread(std::function<void()>&& f,
-                                        std::string jobName) = 0;
+    // more priority than regular worker background threads. Among themselves,
+    // worker jobs run in order of `priority`, see BackgroundExecutor.
+    virtual void postOnBackgroundThread(
+        std::function<void()>&& f, std::string jobName,
+        BackgroundPriority priority = BackgroundPriority::NORMAL) = 0;
     virtual void postOnEvictionBackgroundThread(std::function<void()>&& f,
                                                 std::string jobName) = 0;
     virtual void postOnOverlayThread(std::function<void()>&& f,
                                      std::string jobName) = 0;
+    // Only available when EXPERIMENTAL_BACKGROUND_META_EMISSION is set. Jobs
+    // run one at a time, in the order they were posted.
+    virtual void postOnMetaThread(std::function<void()>&& f,
+                                  std::string jobName) = 0;
 
     // Perform actions necessary to transition from BOOTING_STATE to other
     // states. In particular: either reload or reinitialize the database, and
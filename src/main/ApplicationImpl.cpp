@@ -43,6 +43,8 @@
 #include "main/CommandHandler.h"
 #include "main/ExternalQueue.h"
 #include "main/Maintainer.h"
+#include "main/MemoryBudget.h"
+#include "main/QueryServer.h"
 #include "main/StellarCoreVersion.h"
 #include "medida/counter.h"
 #include "medida/meter.h"
@@ -58,6 +60,7 @@
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/SpanRecorder.h"
 #include "util/StatusManager.h"
 #include "util/Thread.h"
 #include "util/TmpDir.h"
@@ -68,7 +71,7 @@
 #include "simulation/LoadGenerator.h"
 #endif
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 #include <optional>
 #include <set>
@@ -82,10 +85,7 @@ namespace stellar
 ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
     : mVirtualClock(clock)
     , mConfig(cfg)
-    // Allocate one worker to eviction when background eviction enabled
-    , mWorkerIOContext(mConfig.EXPERIMENTAL_BACKGROUND_EVICTION_SCAN
-                           ? mConfig.WORKER_THREADS - 1
-                           : mConfig.WORKER_THREADS)
+    , mWorkerIOContext(1)
     , mEvictionIOContext(mConfig.EXPERIMENTAL_BACKGROUND_EVICTION_SCAN
                              ? std::make_unique<asio::io_context>(1)
                              : nullptr)
@@ -100,6 +100,12 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
     , mOverlayWork(mOverlayIOContext ? std::make_unique<asio::io_context::work>(
                                            *mOverlayIOContext)
                                      : nullptr)
+    , mMetaIOContext(mConfig.EXPERIMENTAL_BACKGROUND_META_EMISSION
+                         ? std::make_unique<asio::io_context>(1)
+                         : nullptr)
+    , mMetaWork(mMetaIOContext ? std::make_unique<asio::io_context::work>(
+                                     *mMetaIOContext)
+                               : nullptr)
     , mWorkerThreads()
     , mEvictionThread()
     , mStopSignals(clock.getIOContext(), SIGINT)
@@ -153,9 +159,24 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
         }
     });
 
+    // Tests may run several applications on one clock; the first one reports
+    // on the action queues
+    if (!mVirtualClock.getActionScheduler().getMetrics())
+    {
+        mVirtualClock.setActionSchedulerMetrics(mMetrics.get());
+    }
+
     auto t = mConfig.WORKER_THREADS;
     LOG_DEBUG(DEFAULT_LOG, "Application constructing (worker threads: {})", t);
 
+    PubKeyUtils::setVerifySigCacheSize(mConfig.SIGNATURE_CACHE_SIZE);
+
+    // Set on this thread first, for the threads started below to inherit
+    if (mConfig.NUMA_MEMORY_POLICY == "interleave")
+    {
+        interleaveMemoryOverNumaNodes();
+    }
+
     if (mConfig.EXPERIMENTAL_BACKGROUND_EVICTION_SCAN)
     {
         releaseAssert(mConfig.WORKER_THREADS > 0);
@@ -163,6 +184,8 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
 
         // Allocate one thread for Eviction scan
         mEvictionThread = std::thread{[this]() {
+            SpanRecorder::setThreadName("eviction");
+            setCurrentThreadRole("eviction", mConfig.EVICTION_THREAD_CPUS);
             runCurrentThreadWithMediumPriority();
             mEvictionIOContext->run();
         }};
@@ -170,20 +193,39 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
         --t;
     }
 
-    while (t--)
+    mBackgroundExecutor = std::make_unique<BackgroundExecutor>(
+        t, *mMetrics, mConfig.WORKER_THREAD_CPUS);
+
+    // Background jobs go to mBackgroundExecutor; this thread only serves asio
+    // objects bound to the worker io_context, like signal sets
+    mWorkerThreads.emplace_back([this]() {
+        setCurrentThreadRole("worker", mConfig.WORKER_THREAD_CPUS);
+        runCurrentThreadWithLowPriority();
+        mWorkerIOContext.run();
+    });
+
+    if (mConfig.EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING)
     {
-        auto thread = std::thread{[this]() {
-            runCurrentThreadWithLowPriority();
-            mWorkerIOContext.run();
+        // Keep priority unchanged as overlay processes time-sensitive tasks
+        mOverlayThread = std::thread{[this]() {
+            SpanRecorder::setThreadName("overlay");
+            setCurrentThreadRole("overlay", mConfig.OVERLAY_THREAD_CPUS);
+            mOverlayIOContext->run();
         }};
-        mWorkerThreads.emplace_back(std::move(thread));
     }
 
-    if (mConfig.EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING)
+    if (mConfig.EXPERIMENTAL_BACKGROUND_META_EMISSION)
     {
-        // Keep priority unchanged as overlay processes time-sensitive tasks
-        mOverlayThread = std::thread{[this]() { mOverlayIOContext->run(); }};
+        // Keep priority unchanged as the next ledger close waits for it
+        mMetaThread = std::thread{[this]() {
+            SpanRecorder::setThreadName("meta");
+            setCurrentThreadRole("meta", mConfig.META_THREAD_CPUS);
+            mMetaIOContext->run();
+        }};
     }
+
+    // Last, as threads inherit the CPUs of the thread starting them
+    setCurrentThreadRole("main", mConfig.MAIN_THREAD_CPUS);
 }
 
 static void
@@ -193,13 +235,20 @@ maybeRebuildLedger(Application& app, bool applyBuckets)
     std::set<LedgerEntryType> toRebuild;
     auto& ps = app.getPersistentState();
     auto bucketListDBEnabled = app.getConfig().isUsingBucketListDB();
+    auto offersInMemory = app.getConfig().isUsingInMemoryOffers();
     for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
     {
-        // If BucketListDB is enabled, drop all tables except for offers
+        // If BucketListDB is enabled, drop all tables except for offers, unless
+        // offers are kept in memory too
         LedgerEntryType t = static_cast<LedgerEntryType>(let);
-        if (let != OFFER && bucketListDBEnabled)
+        if ((let != OFFER || offersInMemory) && bucketListDBEnabled)
         {
             toDrop.emplace(t);
+            if (let == OFFER)
+            {
+                // Bring the table back if IN_MEMORY_OFFERS is turned off
+                ps.setRebuildForType(t);
+            }
             continue;
         }
 
@@ -265,7 +314,24 @@ maybeRebuildLedger(Application& app, bool applyBuckets)
             }
         };
 
-        loopEntries(toRebuild, true);
+        // If a previous rebuild of the same state was interrupted part way
+        // through, keep the tables it partially rebuilt so that applying
+        // buckets resumes from its checkpoint instead of starting over.
+        auto rebuildFilter = [&toRebuild](LedgerEntryType t) {
+            return toRebuild.find(t) != toRebuild.end();
+        };
+        if (applyBuckets && !toRebuild.empty() &&
+            ApplyBucketsWork::hasResumableProgress(
+                app, app.getLedgerManager().getLastClosedLedgerHAS(),
+                rebuildFilter))
+        {
+            LOG_INFO(DEFAULT_LOG, "Resuming interrupted ledger rebuild");
+        }
+        else
+        {
+            loopEntries(toRebuild, true);
+            ps.setState(PersistentState::kBucketApplyProgress, "");
+        }
         loopEntries(toDrop, false);
         tx.commit();
 
@@ -283,10 +349,7 @@ maybeRebuildLedger(Application& app, bool applyBuckets)
         {
             LOG_INFO(DEFAULT_LOG,
                      "Rebuilding ledger tables by applying buckets");
-            auto filter = [&toRebuild](LedgerEntryType t) {
-                return toRebuild.find(t) != toRebuild.end();
-            };
-            if (!applyBucketsForLCL(app, filter))
+            if (!applyBucketsForLCL(app, rebuildFilter))
             {
                 throw std::runtime_error("Could not rebuild ledger tables");
             }
@@ -326,6 +389,7 @@ ApplicationImpl::initialize(bool createNewDB, bool forceRebuild)
     mHistoryManager = HistoryManager::create(*this);
     mInvariantManager = createInvariantManager();
     mMaintainer = std::make_unique<Maintainer>(*this);
+    mMemoryBudget = std::make_unique<MemoryBudget>(*this);
     mWorkScheduler = WorkScheduler::create(*this);
     mBanManager = BanManager::create(*this);
     mStatusManager = std::make_unique<StatusManager>();
@@ -362,14 +426,16 @@ ApplicationImpl::initialize(bool createNewDB, bool forceRebuild)
     ConstantProductInvariant::registerInvariant(*this);
     enableInvariantsFromConfig();
 
-    if (initNewDB)
-    {
-        newDB();
-    }
-    else
-    {
-        upgradeToCurrentSchemaAndMaybeRebuildLedger(true, forceRebuild);
-    }
+    timeStartupPhase("database", [&]() {
+        if (initNewDB)
+        {
+            newDB();
+        }
+        else
+        {
+            upgradeToCurrentSchemaAndMaybeRebuildLedger(true, forceRebuild);
+        }
+    });
 
     // Subtle: process manager should come to existence _after_ BucketManager
     // initialization and newDB run, as it relies on tmp dir created in the
@@ -382,6 +448,20 @@ ApplicationImpl::initialize(bool createNewDB, bool forceRebuild)
     LOG_DEBUG(DEFAULT_LOG, "Application constructed");
 }
 
+void
+ApplicationImpl::timeStartupPhase(std::string const& name,
+                                  std::function<void()> const& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    LOG_INFO(DEFAULT_LOG, "Startup phase {} took {} ms", name,
+             std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                 .count());
+    mStartupPhases.emplace_back(name, elapsed);
+}
+
 void
 ApplicationImpl::resetLedgerState()
 {
@@ -504,6 +584,12 @@ ApplicationImpl::getJsonInfo(bool verbose)
     info["protocol_version"] = getConfig().LEDGER_PROTOCOL_VERSION;
     info["state"] = getStateHuman();
     info["startedOn"] = VirtualClock::systemPointToISOString(mStartedOn);
+    for (auto const& [name, elapsed] : mStartupPhases)
+    {
+        info["startup"][name] = static_cast<Json::UInt64>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                .count());
+    }
     auto const& lcl = lm.getLastClosedLedgerHeader();
     info["ledger"]["num"] = (int)lcl.header.ledgerSeq;
     info["ledger"]["hash"] = binToHex(lcl.hash);
@@ -579,6 +665,31 @@ ApplicationImpl::getJsonInfo(bool verbose)
             getConfig().NODE_SEED.getPublicKey(), true, false, ledgerSeq);
     }
 
+    auto catchup = getCatchupManager().getJsonProgress();
+    if (!catchup.isNull())
+    {
+        info["catchup"] = catchup;
+    }
+
+    // Threads of all applications in this process, of which there is one but
+    // in tests
+    for (auto const& role : getThreadRoles())
+    {
+        Json::Value thread;
+        thread["role"] = role.mRole;
+        auto& cpus = thread["cpus"];
+        cpus = Json::arrayValue;
+        for (auto cpu : role.mAllowedCpus)
+        {
+            cpus.append(cpu);
+        }
+        if (role.mLastCpu)
+        {
+            thread["last_cpu"] = *role.mLastCpu;
+        }
+        info["threads"].append(thread);
+    }
+
     auto invariantFailures = getInvariantManager().getJsonInfo();
     if (!invariantFailures.empty())
     {
@@ -668,6 +779,7 @@ ApplicationImpl::~ApplicationImpl()
     LOG_INFO(DEFAULT_LOG, "Application destructing");
     try
     {
+        mQueryServer.reset();
         shutdownWorkScheduler();
         if (mProcessManager)
         {
@@ -692,6 +804,10 @@ ApplicationImpl::~ApplicationImpl()
     reportCfgMetrics();
     shutdownMainIOContext();
     joinAllThreads();
+    if (mVirtualClock.getActionScheduler().getMetrics() == mMetrics.get())
+    {
+        mVirtualClock.setActionSchedulerMetrics(nullptr);
+    }
     LOG_INFO(DEFAULT_LOG, "Application destroyed");
 }
 
@@ -875,20 +991,24 @@ void
 ApplicationImpl::startServices()
 {
     // restores Herder's state before starting overlay
-    mHerder->start();
+    timeStartupPhase("herder", [&]() { mHerder->start(); });
     // set known cursors before starting maintenance job
     ExternalQueue ps(*this);
     ps.setInitialCursors(mConfig.KNOWN_CURSORS);
     mMaintainer->start();
+    mMemoryBudget->start();
     if (mConfig.MODE_AUTO_STARTS_OVERLAY)
     {
-        mOverlayManager->start();
-    }
-    auto npub = mHistoryManager->publishQueuedHistory();
-    if (npub != 0)
-    {
-        CLOG_INFO(Ledger, "Restarted publishing {} queued snapshots", npub);
+        timeStartupPhase("overlay", [&]() { mOverlayManager->start(); });
     }
+    timeStartupPhase("publish", [&]() {
+        auto npub = mHistoryManager->publishQueuedHistory();
+        if (npub != 0)
+        {
+            CLOG_INFO(Ledger, "Restarted publishing {} queued snapshots",
+                      npub);
+        }
+    });
     if (mConfig.FORCE_SCP)
     {
         LOG_INFO(DEFAULT_LOG, "* ");
@@ -907,6 +1027,19 @@ ApplicationImpl::startServices()
     {
         mHerder->setUpgrades(mConfig);
     }
+    // Once the bucket list snapshot reflects the last closed ledger
+    if (mConfig.HTTP_QUERY_PORT != 0)
+    {
+        if (mConfig.isUsingBucketListDB())
+        {
+            mQueryServer = std::make_unique<QueryServer>(*this);
+        }
+        else
+        {
+            LOG_WARNING(DEFAULT_LOG, "HTTP_QUERY_PORT is ignored without "
+                                     "BucketListDB");
+        }
+    }
 }
 
 void
@@ -921,8 +1054,13 @@ ApplicationImpl::start()
     CLOG_INFO(Ledger, "Starting up application");
     mStarted = true;
 
-    mLedgerManager->loadLastKnownLedger(/* restoreBucketlist */ true,
-                                        /* isLedgerStateReady */ true);
+    // Herder's persisted state doesn't depend on the bucket list, so it's
+    // decoded in the background while the bucket list is restored
+    mHerder->prefetchPersistedState();
+    timeStartupPhase("ledger", [&]() {
+        mLedgerManager->loadLastKnownLedger(/* restoreBucketlist */ true,
+                                            /* isLedgerStateReady */ true);
+    });
     startServices();
 }
 
@@ -934,6 +1072,7 @@ ApplicationImpl::gracefulStop()
         return;
     }
     mStopping = true;
+    mQueryServer.reset();
     if (mOverlayManager)
     {
         mOverlayManager->shutdown();
@@ -995,7 +1134,12 @@ ApplicationImpl::joinAllThreads()
         mOverlayWork.reset();
     }
 
-    LOG_INFO(DEFAULT_LOG, "Joining {} worker threads", mWorkerThreads.size());
+    if (mBackgroundExecutor)
+    {
+        LOG_INFO(DEFAULT_LOG, "Joining {} worker threads",
+                 mBackgroundExecutor->getNumThreads());
+        mBackgroundExecutor->shutdown();
+    }
     for (auto& w : mWorkerThreads)
     {
         w.join();
@@ -1018,7 +1162,21 @@ ApplicationImpl::joinAllThreads()
         mOverlayThread->join();
     }
 
-    LOG_INFO(DEFAULT_LOG, "Joined all {} threads", (mWorkerThreads.size() + 1));
+    // Any meta still queued is written before the thread exits
+    if (mMetaWork)
+    {
+        mMetaWork.reset();
+    }
+
+    if (mMetaThread)
+    {
+        LOG_INFO(DEFAULT_LOG, "Joining the meta thread");
+        mMetaThread->join();
+    }
+
+    LOG_INFO(DEFAULT_LOG, "Joined all {} threads",
+             (mBackgroundExecutor ? mBackgroundExecutor->getNumThreads() : 0) +
+                 mWorkerThreads.size() + 1);
 }
 
 std::string
@@ -1322,13 +1480,38 @@ ApplicationImpl::syncOwnMetrics()
     // Flush crypto pure-global-cache stats. They don't belong
     // to a single app instance but first one to flush will claim
     // them.
+    std::vector<uint64_t> shardHits, shardMisses;
+    PubKeyUtils::flushVerifySigCacheShardCounts(shardHits, shardMisses);
     uint64_t vhit = 0, vmiss = 0;
-    PubKeyUtils::flushVerifySigCacheCounts(vhit, vmiss);
+    for (size_t i = 0; i < shardHits.size(); ++i)
+    {
+        auto shard = std::to_string(i);
+        mMetrics->NewMeter({"crypto", "verify-shard-hit", shard}, "signature")
+            .Mark(shardHits[i]);
+        mMetrics->NewMeter({"crypto", "verify-shard-miss", shard}, "signature")
+            .Mark(shardMisses[i]);
+        vhit += shardHits[i];
+        vmiss += shardMisses[i];
+    }
     mMetrics->NewMeter({"crypto", "verify", "hit"}, "signature").Mark(vhit);
     mMetrics->NewMeter({"crypto", "verify", "miss"}, "signature").Mark(vmiss);
     mMetrics->NewMeter({"crypto", "verify", "total"}, "signature")
         .Mark(vhit + vmiss);
 
+    // Logging stats are global too.
+    std::vector<uint64_t> logDropped;
+    uint64_t logOverwritten = 0;
+    Logging::flushDroppedMessageCounts(logDropped, logOverwritten);
+    for (size_t i = 0; i < logDropped.size(); ++i)
+    {
+        mMetrics
+            ->NewMeter({"logging", "dropped", Logging::kPartitionNames[i]},
+                       "message")
+            .Mark(logDropped[i]);
+    }
+    mMetrics->NewMeter({"logging", "async", "overwritten"}, "message")
+        .Mark(logOverwritten);
+
     // Similarly, flush global process-table stats.
     mMetrics->NewCounter({"process", "memory", "handles"})
         .set_count(mProcessManager->getNumRunningProcesses());
@@ -1348,6 +1531,42 @@ ApplicationImpl::syncOwnMetrics()
     }
     mMetrics->NewCounter({"process", "file", "handles"})
         .set_count(fs::getOpenHandleCount());
+
+    // Update memory footprint estimates, named "<subsystem>.<structure>"
+    for (auto const& [name, bytes] : getMemoryFootprint())
+    {
+        auto dot = name.find('.');
+        releaseAssert(dot != std::string::npos);
+        mMetrics
+            ->NewCounter(
+                {"memory", name.substr(0, dot), name.substr(dot + 1)})
+            .set_count(static_cast<int64_t>(bytes));
+    }
+}
+
+MemoryFootprint
+ApplicationImpl::getMemoryFootprint()
+{
+    MemoryFootprint footprint;
+    if (mBucketManager)
+    {
+        mBucketManager->addMemoryFootprint(footprint);
+    }
+    if (auto root = dynamic_cast<LedgerTxnRoot*>(mLedgerTxnRoot.get()))
+    {
+        root->addMemoryFootprint(footprint);
+    }
+    if (mHerder)
+    {
+        mHerder->addMemoryFootprint(footprint);
+    }
+    if (mOverlayManager)
+    {
+        mOverlayManager->addMemoryFootprint(footprint);
+    }
+    footprint["crypto.verify-sig-cache"] =
+        PubKeyUtils::getVerifySigCacheBytes();
+    return footprint;
 }
 
 void
@@ -1356,6 +1575,7 @@ ApplicationImpl::syncAllMetrics()
     mHerder->syncMetrics();
     mLedgerManager->syncMetrics();
     mCatchupManager->syncMetrics();
+    mBucketManager->syncMetrics();
     syncOwnMetrics();
 }
 
@@ -1415,6 +1635,12 @@ ApplicationImpl::getMaintainer()
     return *mMaintainer;
 }
 
+MemoryBudget&
+ApplicationImpl::getMemoryBudget()
+{
+    return *mMemoryBudget;
+}
+
 ProcessManager&
 ApplicationImpl::getProcessManager()
 {
@@ -1523,14 +1749,17 @@ ApplicationImpl::postOnMainThread(std::function<void()>&& f, std::string&& name,
 
 void
 ApplicationImpl::postOnBackgroundThread(std::function<void()>&& f,
-                                        std::string jobName)
+                                        std::string jobName,
+                                        BackgroundPriority priority)
 {
-    LogSlowExecution isSlow{std::move(jobName), LogSlowExecution::Mode::MANUAL,
+    LogSlowExecution isSlow{jobName, LogSlowExecution::Mode::MANUAL,
                             "executed after"};
-    asio::post(getWorkerIOContext(), [this, f = std::move(f), isSlow]() {
-        mPostOnBackgroundThreadDelay.Update(isSlow.checkElapsedTime());
-        f();
-    });
+    mBackgroundExecutor->post(
+        [this, f = std::move(f), isSlow]() {
+            mPostOnBackgroundThreadDelay.Update(isSlow.checkElapsedTime());
+            f();
+        },
+        jobName, priority);
 }
 
 void
@@ -1558,6 +1787,19 @@ ApplicationImpl::postOnOverlayThread(std::function<void()>&& f,
     });
 }
 
+void
+ApplicationImpl::postOnMetaThread(std::function<void()>&& f,
+                                  std::string jobName)
+{
+    releaseAssert(mMetaIOContext);
+    LogSlowExecution isSlow{std::move(jobName), LogSlowExecution::Mode::MANUAL,
+                            "executed after"};
+    asio::post(*mMetaIOContext, [this, f = std::move(f), isSlow]() {
+        mPostOnBackgroundThreadDelay.Update(isSlow.checkElapsedTime());
+        f();
+    });
+}
+
 void
 ApplicationImpl::enableInvariantsFromConfig()
 {
@@ -1565,6 +1807,16 @@ ApplicationImpl::enableInvariantsFromConfig()
     {
         mInvariantManager->enableInvariant(name);
     }
+    for (auto const& [name, sampling] : mConfig.INVARIANT_SAMPLING)
+    {
+        mInvariantManager->setOperationSampling(
+            name, sampling.mLedgerInterval, sampling.mLedgerBudget);
+    }
+    if (mConfig.INVARIANT_CHECKS_ASYNC && !mConfig.INVARIANT_CHECKS.empty())
+    {
+        mInvariantManager->enableAsyncOperationChecks(
+            *this, mConfig.INVARIANT_CHECKS_ASYNC_HALT);
+    }
 }
 
 std::unique_ptr<Herder>
@@ -8,11 +8,15 @@
 #include "main/Config.h"
 #include "main/PersistentState.h"
 #include "medida/timer_context.h"
+#include "util/BackgroundExecutor.h"
 #include "util/MetricResetter.h"
 #include "util/Timer.h"
 #include "xdr/Stellar-ledger-entries.h"
+#include <chrono>
+#include <functional>
 #include <optional>
 #include <thread>
+#include <vector>
 
 namespace medida
 {
@@ -29,6 +33,7 @@ class BucketManager;
 class HistoryManager;
 class ProcessManager;
 class CommandHandler;
+class QueryServer;
 class Database;
 class LedgerTxn;
 class LedgerTxnRoot;
@@ -57,6 +62,7 @@ class ApplicationImpl : public Application
     virtual medida::MetricsRegistry& getMetrics() override;
     virtual void syncOwnMetrics() override;
     virtual void syncAllMetrics() override;
+    virtual MemoryFootprint getMemoryFootprint() override;
     virtual void clearMetrics(std::string const& domain) override;
     virtual TmpDirManager& getTmpDirManager() override;
     virtual LedgerManager& getLedgerManager() override;
@@ -65,6 +71,7 @@ class ApplicationImpl : public Application
     virtual HistoryArchiveManager& getHistoryArchiveManager() override;
     virtual HistoryManager& getHistoryManager() override;
     virtual Maintainer& getMaintainer() override;
+    virtual MemoryBudget& getMemoryBudget() override;
     virtual ProcessManager& getProcessManager() override;
     virtual Herder& getHerder() override;
     virtual HerderPersistence& getHerderPersistence() override;
@@ -83,13 +90,16 @@ class ApplicationImpl : public Application
 
     virtual void postOnMainThread(std::function<void()>&& f, std::string&& name,
                                   Scheduler::ActionType type) override;
-    virtual void postOnBackgroundThread(std::function<void()>&& f,
-                                        std::string jobName) override;
+    virtual void postOnBackgroundThread(
+        std::function<void()>&& f, std::string jobName,
+        BackgroundPriority priority = BackgroundPriority::NORMAL) override;
     virtual void postOnEvictionBackgroundThread(std::function<void()>&& f,
                                                 std::string jobName) override;
 
     virtual void postOnOverlayThread(std::function<void()>&& f,
                                      std::string jobName) override;
+    virtual void postOnMetaThread(std::function<void()>&& f,
+                                  std::string jobName) override;
     virtual void start() override;
     void startServices();
 
@@ -156,6 +166,9 @@ class ApplicationImpl : public Application
     std::unique_ptr<asio::io_context> mOverlayIOContext;
     std::unique_ptr<asio::io_context::work> mOverlayWork;
 
+    std::unique_ptr<asio::io_context> mMetaIOContext;
+    std::unique_ptr<asio::io_context::work> mMetaWork;
+
     std::unique_ptr<BucketManager> mBucketManager;
     std::unique_ptr<Database> mDatabase;
     std::unique_ptr<OverlayManager> mOverlayManager;
@@ -171,6 +184,7 @@ class ApplicationImpl : public Application
     std::unique_ptr<HistoryManager> mHistoryManager;
     std::unique_ptr<InvariantManager> mInvariantManager;
     std::unique_ptr<Maintainer> mMaintainer;
+    std::unique_ptr<MemoryBudget> mMemoryBudget;
     std::shared_ptr<ProcessManager> mProcessManager;
     std::shared_ptr<WorkScheduler> mWorkScheduler;
     std::unique_ptr<PersistentState> mPersistentState;
@@ -193,11 +207,14 @@ class ApplicationImpl : public Application
     std::unique_ptr<InMemoryLedgerTxn> mNeverCommittingLedgerTxn;
 
     std::unique_ptr<CommandHandler> mCommandHandler;
+    // Started with the services if HTTP_QUERY_PORT is set
+    std::unique_ptr<QueryServer> mQueryServer;
 
 #ifdef BUILD_TESTS
     std::unique_ptr<LoadGenerator> mLoadGenerator;
 #endif
 
+    std::unique_ptr<BackgroundExecutor> mBackgroundExecutor;
     std::vector<std::thread> mWorkerThreads;
     std::optional<std::thread> mOverlayThread;
 
@@ -207,6 +224,9 @@ class ApplicationImpl : public Application
     // thread for eviction scans.
     std::optional<std::thread> mEvictionThread;
 
+    // Writes ledger close meta, see EXPERIMENTAL_BACKGROUND_META_EMISSION
+    std::optional<std::thread> mMetaThread;
+
     asio::signal_set mStopSignals;
 
     bool mStarted;
@@ -222,6 +242,12 @@ class ApplicationImpl : public Application
 
     VirtualClock::system_time_point mStartedOn;
 
+    // How long each phase of startup took, in order, for the logs and `info`
+    std::vector<std::pair<std::string, std::chrono::microseconds>>
+        mStartupPhases;
+    void timeStartupPhase(std::string const& name,
+                          std::function<void()> const& f);
+
     Hash mNetworkID;
 
     // A handle to any running self-check, to avoid scheduling
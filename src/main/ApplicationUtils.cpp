@@ -3,14 +3,18 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "main/ApplicationUtils.h"
+#include "bucket/BlockCompressedBucket.h"
 #include "bucket/Bucket.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "catchup/ApplyBucketsWork.h"
 #include "catchup/CatchupConfiguration.h"
 #include "crypto/Hex.h"
+#include "crypto/KeyUtils.h"
+#include "crypto/StrKey.h"
 #include "database/Database.h"
 #include "herder/Herder.h"
+#include "herder/LedgerCloseData.h"
 #include "herder/QuorumIntersectionChecker.h"
 #include "history/HistoryArchive.h"
 #include "history/HistoryArchiveManager.h"
@@ -30,16 +34,23 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDRCereal.h"
+#include "util/XDRStream.h"
+#include "util/types.h"
 #include "util/xdrquery/XDRQuery.h"
 #include "work/WorkScheduler.h"
 
+#include <algorithm>
 #include <charconv>
 #include <filesystem>
 #include <lib/http/HttpClient.h>
 #include <locale>
 #include <map>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
+#include <numeric>
 #include <optional>
 #include <regex>
+#include <set>
 
 namespace stellar
 {
@@ -93,6 +104,189 @@ writeLedgerAggregationTable(
         ofs << std::endl;
     }
 }
+
+// Writes `values` as a CSV row. Missing values are left empty and strings
+// are quoted when they contain separators.
+void
+writeCSVRow(std::ofstream& ofs,
+            std::vector<xdrquery::ResultType> const& values)
+{
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i > 0)
+        {
+            ofs << ",";
+        }
+        if (!values[i])
+        {
+            continue;
+        }
+        auto value = xdrquery::resultToString(*values[i]);
+        if (value.find_first_of(",\"\n") == std::string::npos)
+        {
+            ofs << value;
+            continue;
+        }
+        ofs << '"';
+        for (char c : value)
+        {
+            if (c == '"')
+            {
+                ofs << '"';
+            }
+            ofs << c;
+        }
+        ofs << '"';
+    }
+    ofs << '\n';
+}
+
+// Returns the address in `str`, either a contract ('C...') or an account
+// ('G...') StrKey. Throws if `str` is neither.
+SCAddress
+strToSCAddress(std::string const& str)
+{
+    uint8_t version;
+    std::vector<uint8_t> bytes;
+    SCAddress addr;
+    if (strKey::fromStrKey(str, version, bytes) &&
+        version == strKey::STRKEY_CONTRACT &&
+        bytes.size() == addr.contractId().size())
+    {
+        addr.type(SC_ADDRESS_TYPE_CONTRACT);
+        std::copy(bytes.begin(), bytes.end(), addr.contractId().begin());
+        return addr;
+    }
+    addr.type(SC_ADDRESS_TYPE_ACCOUNT);
+    addr.accountId() = KeyUtils::fromStrKey<PublicKey>(str);
+    return addr;
+}
+
+// Returns the entries `query` can match, as far as can be told from the
+// `==` comparisons every match has to satisfy: the entry types, the
+// contracts of contract data entries and the assets of trustlines.
+LedgerEntryScanScope
+getQueryScanScope(std::string const& query)
+{
+    xdrquery::XDRMatcher matcher(query);
+    LedgerEntryScanScope scope;
+
+    // Maps `data` arm names (i.e. `offer`) to the entry type names used in
+    // `data.type` comparisons (i.e. `OFFER`)
+    auto armToType = [](std::string const& arm) -> std::optional<std::string> {
+        for (auto const c : LedgerEntry::_data_t::_xdr_case_values())
+        {
+            auto armName =
+                xdr::xdr_traits<LedgerEntry::_data_t>::union_field_name(c);
+            if (armName != nullptr && armName == arm)
+            {
+                return xdr::xdr_traits<LedgerEntryType>::enum_name(
+                    static_cast<LedgerEntryType>(c));
+            }
+        }
+        return std::nullopt;
+    };
+
+    auto typeNames = matcher.getPossibleValues(
+        xdrquery::UnionFieldInfo{{"data"}, "type", armToType});
+    if (!typeNames)
+    {
+        return scope;
+    }
+    auto& types = scope.mEntryTypes.emplace();
+    for (auto type : xdr::xdr_traits<LedgerEntryType>::enum_values())
+    {
+        auto let = static_cast<LedgerEntryType>(type);
+        if (typeNames->count(xdr::xdr_traits<LedgerEntryType>::enum_name(let)))
+        {
+            types.insert(let);
+        }
+    }
+
+    // Possible values of a field under `path`. The discriminant of a union is
+    // only narrowed by `==` comparisons with string literals, which holds for
+    // any other field once no field name is taken for a union arm.
+    auto fieldValues = [&](std::vector<std::string> path,
+                           std::string const& field) {
+        return matcher.getPossibleValues(xdrquery::UnionFieldInfo{
+            std::move(path), field,
+            [](std::string const&) -> std::optional<std::string> {
+                return std::nullopt;
+            }});
+    };
+
+    // Values that don't parse can't match any entry either, but are left for
+    // the query to reject rather than special-cased here
+    try
+    {
+        if (auto contracts = fieldValues({"data", "contractData"}, "contract"))
+        {
+            std::set<SCAddress> addrs;
+            for (auto const& contract : *contracts)
+            {
+                addrs.insert(strToSCAddress(contract));
+            }
+            scope.mContracts = addrs;
+        }
+    }
+    catch (std::exception const&)
+    {
+    }
+
+    try
+    {
+        std::vector<std::string> assetPath{"data", "trustLine", "asset"};
+        auto pools = fieldValues(assetPath, "liquidityPoolID");
+        auto codes = fieldValues(assetPath, "assetCode");
+        auto issuers = fieldValues(assetPath, "issuer");
+        if (pools)
+        {
+            std::set<TrustLineAsset> assets;
+            for (auto const& pool : *pools)
+            {
+                TrustLineAsset asset(ASSET_TYPE_POOL_SHARE);
+                asset.liquidityPoolID() = hexToBin256(pool);
+                assets.insert(asset);
+            }
+            scope.mTrustlineAssets = assets;
+        }
+        else if (codes && issuers)
+        {
+            std::set<TrustLineAsset> assets;
+            for (auto const& code : *codes)
+            {
+                for (auto const& issuer : *issuers)
+                {
+                    TrustLineAsset asset;
+                    if (code.size() <= 4)
+                    {
+                        asset.type(ASSET_TYPE_CREDIT_ALPHANUM4);
+                        strToAssetCode(asset.alphaNum4().assetCode, code);
+                        asset.alphaNum4().issuer =
+                            KeyUtils::fromStrKey<PublicKey>(issuer);
+                    }
+                    else if (code.size() <= 12)
+                    {
+                        asset.type(ASSET_TYPE_CREDIT_ALPHANUM12);
+                        strToAssetCode(asset.alphaNum12().assetCode, code);
+                        asset.alphaNum12().issuer =
+                            KeyUtils::fromStrKey<PublicKey>(issuer);
+                    }
+                    else
+                    {
+                        continue;
+                    }
+                    assets.insert(asset);
+                }
+            }
+            scope.mTrustlineAssets = assets;
+        }
+    }
+    catch (std::exception const&)
+    {
+    }
+    return scope;
+}
 } // namespace
 
 const std::string MINIMAL_DB_NAME = "minimal.db";
@@ -527,6 +721,140 @@ selfCheck(Config cfg)
     }
 }
 
+int
+benchApply(Config cfg, std::string const& metaFile, uint32_t warmupLedgers,
+           std::string const& outputFile)
+{
+    // All the ledgers are read before applying any, so that reading the meta
+    // file is not part of the measured time
+    std::vector<LedgerCloseMeta> ledgers;
+    {
+        XDRInputFileStream in;
+        in.open(metaFile);
+        LedgerCloseMeta lcm;
+        while (in.readOne(lcm))
+        {
+            ledgers.emplace_back(lcm);
+        }
+    }
+    LOG_INFO(DEFAULT_LOG, "Read {} ledgers from {}", ledgers.size(), metaFile);
+
+    VirtualClock clock(VirtualClock::REAL_TIME);
+    cfg.setNoListen();
+    cfg.RUN_STANDALONE = true;
+    cfg.AUTOMATIC_SELF_CHECK_PERIOD = std::chrono::seconds::zero();
+    cfg.HISTORY.clear();
+    auto app = Application::create(clock, cfg, false);
+    app->start();
+
+    auto& lm = app->getLedgerManager();
+    auto& metrics = app->getMetrics();
+    std::vector<std::pair<std::string, medida::Timer&>> phases{
+        {"fees-seqnums",
+         metrics.NewTimer({"ledger", "close", "fees-seqnums"})},
+        {"apply", metrics.NewTimer({"ledger", "close", "apply"})},
+        {"bucket-add-batch", metrics.NewTimer({"bucket", "batch", "addtime"})},
+        {"commit", metrics.NewTimer({"ledger", "close", "commit"})},
+        {"meta", metrics.NewTimer({"ledger", "metastream", "emit"})}};
+
+    Json::Value results;
+    auto& ledgerResults = results["ledgers"];
+    ledgerResults = Json::arrayValue;
+    std::vector<double> closeTimes;
+    uint32_t applied = 0;
+    for (auto const& lcm : ledgers)
+    {
+        auto const& lh =
+            lcm.v() == 0 ? lcm.v0().ledgerHeader : lcm.v1().ledgerHeader;
+        auto ledgerSeq = lh.header.ledgerSeq;
+        auto lcl = lm.getLastClosedLedgerNum();
+        if (ledgerSeq <= lcl)
+        {
+            continue;
+        }
+        if (ledgerSeq > lcl + 1)
+        {
+            LOG_ERROR(DEFAULT_LOG,
+                      "Ledger {} is too far (lcl={}), run `catchup {}/0` "
+                      "first",
+                      ledgerSeq, lcl, ledgerSeq - 1);
+            return 1;
+        }
+
+        auto txSet = lcm.v() == 0 ? TxSetXDRFrame::makeFromWire(lcm.v0().txSet)
+                                  : TxSetXDRFrame::makeFromWire(lcm.v1().txSet);
+        LedgerCloseData ledgerData(ledgerSeq, txSet, lh.header.scpValue,
+                                   lh.hash);
+
+        std::vector<double> phaseStart;
+        for (auto const& phase : phases)
+        {
+            phaseStart.emplace_back(phase.second.sum());
+        }
+        auto start = std::chrono::steady_clock::now();
+        lm.closeLedger(ledgerData);
+        std::chrono::duration<double, std::milli> closeTime =
+            std::chrono::steady_clock::now() - start;
+        // Runs what closing the ledger posted, outside of the measured time
+        while (clock.crank(false) > 0)
+            ;
+
+        if (applied++ < warmupLedgers)
+        {
+            continue;
+        }
+        Json::Value res;
+        res["ledger"] = ledgerSeq;
+        res["txs"] = static_cast<Json::UInt64>(txSet->sizeTxTotal());
+        res["close_ms"] = closeTime.count();
+        for (size_t i = 0; i < phases.size(); ++i)
+        {
+            res["phases_ms"][phases[i].first] =
+                phases[i].second.sum() - phaseStart[i];
+        }
+        ledgerResults.append(res);
+        closeTimes.emplace_back(closeTime.count());
+    }
+
+    if (closeTimes.empty())
+    {
+        LOG_ERROR(DEFAULT_LOG,
+                  "No ledger was measured, {} applied of which {} warmup",
+                  applied, warmupLedgers);
+        return 1;
+    }
+    std::sort(closeTimes.begin(), closeTimes.end());
+    auto percentile = [&](double p) {
+        return closeTimes[static_cast<size_t>(p * (closeTimes.size() - 1))];
+    };
+    auto& summary = results["summary"];
+    summary["ledgers"] = static_cast<Json::UInt64>(closeTimes.size());
+    summary["close_ms_mean"] =
+        std::accumulate(closeTimes.begin(), closeTimes.end(), 0.0) /
+        closeTimes.size();
+    summary["close_ms_p50"] = percentile(0.5);
+    summary["close_ms_p90"] = percentile(0.9);
+    summary["close_ms_p99"] = percentile(0.99);
+    summary["close_ms_max"] = closeTimes.back();
+
+    std::string filename = outputFile.empty() ? "-" : outputFile;
+    auto content = results.toStyledString();
+    if (filename == "-")
+    {
+        std::cout << content << std::endl;
+    }
+    else
+    {
+        std::ofstream out{};
+        out.exceptions(std::ios::failbit | std::ios::badbit);
+        out.open(filename);
+        out.write(content.c_str(), content.size());
+        out.close();
+        LOG_INFO(DEFAULT_LOG, "Wrote apply benchmark results to {}", filename);
+    }
+    return 0;
+}
+
 int
 mergeBucketList(Config cfg, std::string const& outputDir)
 {
@@ -737,17 +1065,85 @@ dumpStateArchivalStatistics(Config cfg)
     return 0;
 }
 
+int
+reportBucketCompression(Config cfg)
+{
+    ZoneScoped;
+    VirtualClock clock;
+    cfg.setNoListen();
+    Application::pointer app = Application::create(clock, cfg, false);
+    app->getLedgerManager().loadLastKnownLedger(/* restoreBucketlist */ false,
+                                                /* isLedgerStateReady */ true);
+    auto& bm = app->getBucketManager();
+    HistoryArchiveState has =
+        app->getLedgerManager().getLastClosedLedgerHAS();
+
+    auto pageSizeExp = cfg.BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT;
+    size_t blockSize = pageSizeExp == 0 ? 1UL << 14 : 1UL << pageSizeExp;
+    CLOG_INFO(Bucket, "Block-compressed BucketList with {} byte blocks",
+              blockSize);
+
+    uint64_t totalRaw = 0;
+    uint64_t totalCompressed = 0;
+    for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
+    {
+        HistoryStateBucket const& hsb = has.currentBuckets.at(i);
+        uint64_t levelRaw = 0;
+        uint64_t levelCompressed = 0;
+        for (auto const& hex : {hsb.curr, hsb.snap})
+        {
+            auto hash = hexToBin256(hex);
+            if (isZero(hash))
+            {
+                continue;
+            }
+            auto b = bm.getBucketByHash(hash);
+            if (!b)
+            {
+                throw std::runtime_error(std::string("missing bucket: ") +
+                                         hex);
+            }
+            auto tmp = Bucket::randomBucketName(bm.getTmpDir());
+            auto stats =
+                writeBlockCompressedBucket(b->getFilename(), tmp, blockSize);
+            std::filesystem::remove(tmp);
+            releaseAssertOrThrow(stats.mRawHash == hash);
+            levelRaw += stats.mRawBytes;
+            levelCompressed += stats.mCompressedBytes;
+        }
+        CLOG_INFO(Bucket, "Level {}: {} bytes, {} bytes compressed ({}% saved)",
+                  i, levelRaw, levelCompressed,
+                  levelRaw == 0 ? 0.0
+                                : 100.0 * (1.0 - double(levelCompressed) /
+                                                     double(levelRaw)));
+        totalRaw += levelRaw;
+        totalCompressed += levelCompressed;
+    }
+    CLOG_INFO(Bucket, "BucketList: {} bytes, {} bytes compressed ({}% saved)",
+              totalRaw, totalCompressed,
+              totalRaw == 0
+                  ? 0.0
+                  : 100.0 * (1.0 - double(totalCompressed) / double(totalRaw)));
+    return 0;
+}
+
 int
 dumpLedger(Config cfg, std::string const& outputFile,
            std::optional<std::string> filterQuery,
            std::optional<uint32_t> lastModifiedLedgerCount,
            std::optional<uint64_t> limit, std::optional<std::string> groupBy,
-           std::optional<std::string> aggregate)
+           std::optional<std::string> aggregate,
+           std::optional<std::string> fields, uint32_t threads)
 {
     if (groupBy && !aggregate)
     {
         LOG_FATAL(DEFAULT_LOG, "--group-by without --agg is not allowed.");
     }
+    if (fields && aggregate)
+    {
+        LOG_FATAL(DEFAULT_LOG, "--fields with --agg is not allowed.");
+        return 1;
+    }
 
     VirtualClock clock;
     cfg.setNoListen();
@@ -770,18 +1166,18 @@ dumpLedger(Config cfg, std::string const& outputFile,
             minLedger = 0;
         }
     }
-    std::optional<xdrquery::XDRMatcher> matcher;
-    if (filterQuery)
-    {
-        matcher.emplace(*filterQuery);
-    }
-
     std::optional<xdrquery::XDRFieldExtractor> groupByExtractor;
     if (groupBy)
     {
         groupByExtractor.emplace(*groupBy);
     }
 
+    std::optional<xdrquery::XDRFieldExtractor> fieldsExtractor;
+    if (fields)
+    {
+        fieldsExtractor.emplace(*fields);
+    }
+
     std::map<std::vector<xdrquery::ResultType>, xdrquery::XDRAccumulator>
         accumulators;
 
@@ -791,10 +1187,24 @@ dumpLedger(Config cfg, std::string const& outputFile,
     uint64_t entryCount = 0;
     try
     {
+        LedgerEntryScanScope scope;
+        if (filterQuery)
+        {
+            scope = getQueryScanScope(*filterQuery);
+        }
         bm.visitLedgerEntries(
-            has, minLedger,
-            [&](LedgerEntry const& entry) {
-                return !matcher || matcher->matchXDR(entry);
+            has, minLedger, scope,
+            // Matchers aren't thread-safe, so every scan gets its own
+            [&]() -> std::function<bool(LedgerEntry const&)> {
+                if (!filterQuery)
+                {
+                    return [](LedgerEntry const&) { return true; };
+                }
+                auto matcher =
+                    std::make_shared<xdrquery::XDRMatcher>(*filterQuery);
+                return [matcher](LedgerEntry const& entry) {
+                    return matcher->matchXDR(entry);
+                };
             },
             [&](LedgerEntry const& entry) {
                 if (aggregate)
@@ -814,13 +1224,27 @@ dumpLedger(Config cfg, std::string const& outputFile,
                     }
                     it->second.addEntry(entry);
                 }
+                else if (fieldsExtractor)
+                {
+                    auto values = fieldsExtractor->extractFields(entry);
+                    if (entryCount == 0)
+                    {
+                        auto names = fieldsExtractor->getFieldNames();
+                        writeCSVRow(ofs, std::vector<xdrquery::ResultType>(
+                                             names.begin(), names.end()));
+                    }
+                    writeCSVRow(ofs, values);
+                }
                 else
                 {
-                    ofs << xdrToCerealString(entry, "entry", true) << std::endl;
+                    // Flushing every entry would dominate large dumps
+                    xdrToCerealStream(ofs, entry, "entry", true);
+                    ofs << '\n';
                 }
                 ++entryCount;
                 return !limit || entryCount < *limit;
-            });
+            },
+            threads);
     }
     catch (xdrquery::XDRQueryError& e)
     {
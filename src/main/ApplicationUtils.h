@@ -23,18 +23,30 @@ void setForceSCPFlag();
 void initializeDatabase(Config cfg);
 void httpCommand(std::string const& command, unsigned short port);
 int selfCheck(Config cfg);
+// Applies the ledgers of the LedgerCloseMeta stream in `metaFile` that follow
+// the LCL of the node, and writes the time each one took to close, split by
+// phase, as JSON. The first `warmupLedgers` ledgers are applied but not
+// reported.
+int benchApply(Config cfg, std::string const& metaFile, uint32_t warmupLedgers,
+               std::string const& outputFile);
 int mergeBucketList(Config cfg, std::string const& outputDir);
 
 // Logs state archival statistics, such as the number of expired entries
 // currently in the BucketList, number of bytes of evicted entries, etc.
 int dumpStateArchivalStatistics(Config cfg);
 
+// Logs, level by level, how much disk space (and page cache) the buckets of
+// the BucketList would take in the block-compressed bucket format, with blocks
+// the size of the BucketIndex pages
+int reportBucketCompression(Config cfg);
+
 int dumpLedger(Config cfg, std::string const& outputFile,
                std::optional<std::string> filterQuery,
                std::optional<uint32_t> lastModifiedLedgerCount,
                std::optional<uint64_t> limit,
                std::optional<std::string> groupBy,
-               std::optional<std::string> aggregate);
+               std::optional<std::string> aggregate,
+               std::optional<std::string> fields, uint32_t threads);
 void showOfflineInfo(Config cfg, bool verbose);
 int reportLastHistoryCheckpoint(Config cfg, std::string const& outputFile);
 
@@ -13,6 +13,7 @@
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnImpl.h"
 #include "ledger/NetworkConfig.h"
+#include "ledger/SorobanContractProfiler.h"
 #include "lib/http/server.hpp"
 #include "lib/json/json.h"
 #include "main/Application.h"
@@ -25,11 +26,18 @@
 #include "transactions/TransactionBridge.h"
 #include "transactions/TransactionUtils.h"
 #include "util/Logging.h"
+#include "util/PrometheusReporter.h"
+#include "util/SamplingProfiler.h"
+#include "util/SpanRecorder.h"
 #include "util/StatusManager.h"
-#include <Tracy.hpp>
+#include "util/Timer.h"
+#include "util/Tracing.h"
+#include "util/types.h"
 #include <fmt/format.h>
 
+#include "medida/meter.h"
 #include "medida/reporting/json_reporter.h"
+#include "medida/timer.h"
 #include "util/Decoder.h"
 #include "util/XDRCereal.h"
 #include "util/XDROperators.h"
@@ -53,6 +61,17 @@ using std::placeholders::_2;
 
 namespace stellar
 {
+namespace
+{
+// Serializes `root` on the thread running the Renderer
+std::function<std::string()>
+styledRenderer(Json::Value&& root)
+{
+    auto shared = std::make_shared<Json::Value const>(std::move(root));
+    return [shared]() { return shared->toStyledString(); };
+}
+}
+
 CommandHandler::CommandHandler(Application& app) : mApp(app)
 {
     if (mApp.getConfig().HTTP_PORT)
@@ -96,12 +115,13 @@ CommandHandler::CommandHandler(Application& app) : mApp(app)
         addRoute("bans", &CommandHandler::bans);
         addRoute("connect", &CommandHandler::connect);
         addRoute("droppeer", &CommandHandler::dropPeer);
-        addRoute("peers", &CommandHandler::peers);
-        addRoute("quorum", &CommandHandler::quorum);
-        addRoute("scp", &CommandHandler::scpInfo);
+        addSnapshotRoute("peers", &CommandHandler::peers);
+        addSnapshotRoute("quorum", &CommandHandler::quorum);
+        addSnapshotRoute("scp", &CommandHandler::scpInfo);
+        addSnapshotRoute("scptiming", &CommandHandler::scpTiming);
         addRoute("stopsurvey", &CommandHandler::stopSurvey);
 #ifndef BUILD_TESTS
-        addRoute("getsurveyresult", &CommandHandler::getSurveyResult);
+        addSnapshotRoute("getsurveyresult", &CommandHandler::getSurveyResult);
         addRoute("surveytopology", &CommandHandler::surveyTopology);
         addRoute("startsurveycollecting",
                  &CommandHandler::startSurveyCollecting);
@@ -113,12 +133,20 @@ CommandHandler::CommandHandler(Application& app) : mApp(app)
     }
 
     addRoute("clearmetrics", &CommandHandler::clearMetrics);
-    addRoute("info", &CommandHandler::info);
+    addSnapshotRoute("closetiming", &CommandHandler::closeTiming);
+    addSnapshotRoute("info", &CommandHandler::info);
     addRoute("ll", &CommandHandler::ll);
     addRoute("logrotate", &CommandHandler::logRotate);
     addRoute("manualclose", &CommandHandler::manualClose);
-    addRoute("metrics", &CommandHandler::metrics);
+    addRoute("memory", &CommandHandler::memory);
+    addSnapshotRoute("metrics", &CommandHandler::metrics);
+    addSnapshotRoute("prometheus", &CommandHandler::prometheus);
+    mServer->setContentType("prometheus", "text/plain; version=0.0.4");
+    addRoute("profile", &CommandHandler::profile);
+    addRoute("scheduler", &CommandHandler::scheduler);
+    addRoute("tracing", &CommandHandler::tracing);
     addRoute("tx", &CommandHandler::tx);
+    addRoute("txbatch", &CommandHandler::txBatch);
     addRoute("getledgerentry", &CommandHandler::getLedgerEntry);
     addRoute("upgrades", &CommandHandler::upgrades);
     addRoute("dumpproposedsettings", &CommandHandler::dumpProposedSettings);
@@ -129,13 +157,38 @@ CommandHandler::CommandHandler(Application& app) : mApp(app)
     addRoute("generateload", &CommandHandler::generateLoad);
     addRoute("testacc", &CommandHandler::testAcc);
     addRoute("testtx", &CommandHandler::testTx);
-    addRoute("getsurveyresult", &CommandHandler::getSurveyResult);
+    addSnapshotRoute("getsurveyresult", &CommandHandler::getSurveyResult);
     addRoute("surveytopology", &CommandHandler::surveyTopology);
     addRoute("startsurveycollecting", &CommandHandler::startSurveyCollecting);
     addRoute("stopsurveycollecting", &CommandHandler::stopSurveyCollecting);
     addRoute("surveytopologytimesliced",
              &CommandHandler::surveyTopologyTimeSliced);
 #endif
+
+    if (mApp.getConfig().HTTP_COMMAND_THREAD_POOL_SIZE > 0)
+    {
+        mWork = std::make_unique<asio::io_context::work>(mWorkerIOContext);
+        for (int i = 0; i < mApp.getConfig().HTTP_COMMAND_THREAD_POOL_SIZE;
+             ++i)
+        {
+            mWorkers.emplace_back([this, i]() {
+                SpanRecorder::setThreadName(
+                    fmt::format(FMT_STRING("http-{}"), i));
+                mWorkerIOContext.run();
+            });
+        }
+    }
+}
+
+CommandHandler::~CommandHandler()
+{
+    // Replies still being rendered are dropped with their connections
+    mWork.reset();
+    mWorkerIOContext.stop();
+    for (auto& t : mWorkers)
+    {
+        t.join();
+    }
 }
 
 void
@@ -145,6 +198,54 @@ CommandHandler::addRoute(std::string const& name, HandlerRoute route)
         name, std::bind(&CommandHandler::safeRouter, this, route, _1, _2));
 }
 
+void
+CommandHandler::addSnapshotRoute(std::string const& name, SnapshotRoute route)
+{
+    mServer->addAsyncRoute(name, [this, route](
+                                     std::string const& params,
+                                     http::server::server::replyCallback done) {
+        Renderer render;
+        std::string retStr;
+        safeRouter(
+            [&](CommandHandler* self, std::string const& p, std::string&) {
+                render = route(self, p);
+            },
+            params, retStr);
+        if (!render)
+        {
+            // The snapshot failed, retStr has the exception
+            done(retStr);
+            return;
+        }
+        auto job = [render = std::move(render), done = std::move(done)]() {
+            std::string retStr;
+            try
+            {
+                ZoneNamedN(renderZone, "HTTP command render", true);
+                retStr = render();
+            }
+            catch (std::exception const& e)
+            {
+                retStr = fmt::format(FMT_STRING(R"({{"exception": "{}"}})"),
+                                     e.what());
+            }
+            catch (...)
+            {
+                retStr = R"({"exception": "generic"})";
+            }
+            done(retStr);
+        };
+        if (mWorkers.empty())
+        {
+            job();
+        }
+        else
+        {
+            asio::post(mWorkerIOContext, std::move(job));
+        }
+    });
+}
+
 void
 CommandHandler::safeRouter(CommandHandler::HandlerRoute route,
                            std::string const& params, std::string& retStr)
@@ -309,8 +410,8 @@ CommandHandler::manualClose(std::string const& params, std::string& retStr)
     retStr = mApp.manualClose(manualLedgerSeq, manualCloseTime);
 }
 
-void
-CommandHandler::peers(std::string const& params, std::string& retStr)
+CommandHandler::Renderer
+CommandHandler::peers(std::string const& params)
 {
     ZoneScoped;
     std::map<std::string, std::string> retMap;
@@ -356,17 +457,17 @@ CommandHandler::peers(std::string const& params, std::string& retStr)
     addAuthenticatedPeers(
         "inbound", mApp.getOverlayManager().getInboundAuthenticatedPeers());
 
-    retStr = root.toStyledString();
+    return styledRenderer(std::move(root));
 }
 
-void
-CommandHandler::info(std::string const& params, std::string& retStr)
+CommandHandler::Renderer
+CommandHandler::info(std::string const& params)
 {
     ZoneScoped;
     std::map<std::string, std::string> retMap;
     http::server::server::parseParams(params, retMap);
 
-    retStr = mApp.getJsonInfo(retMap["compact"] == "false").toStyledString();
+    return styledRenderer(mApp.getJsonInfo(retMap["compact"] == "false"));
 }
 
 static bool
@@ -382,8 +483,8 @@ shouldEnable(std::set<std::string> const& toEnable,
     return true;
 }
 
-void
-CommandHandler::metrics(std::string const& params, std::string& retStr)
+CommandHandler::Renderer
+CommandHandler::metrics(std::string const& params)
 {
     ZoneScoped;
 
@@ -406,30 +507,22 @@ CommandHandler::metrics(std::string const& params, std::string& retStr)
 
     mApp.syncAllMetrics();
 
-    auto reportMetrics =
-        [&](std::map<medida::MetricName,
-                     std::shared_ptr<medida::MetricInterface>> const& metrics) {
-            medida::reporting::JsonReporter jr(metrics);
-            retStr = jr.Report();
-        };
-
-    if (!toEnable.empty())
+    // Metrics can be added to the registry concurrently, so the renderer gets
+    // a copy of it. Reading the metrics themselves is thread-safe.
+    using MetricsMap =
+        std::map<medida::MetricName, std::shared_ptr<medida::MetricInterface>>;
+    auto metrics = std::make_shared<MetricsMap>();
+    for (auto const& m : mApp.getMetrics().GetAllMetrics())
     {
-        std::map<medida::MetricName, std::shared_ptr<medida::MetricInterface>>
-            metricsToReport;
-        for (auto const& m : mApp.getMetrics().GetAllMetrics())
+        if (toEnable.empty() || shouldEnable(toEnable, m.first))
         {
-            if (shouldEnable(toEnable, m.first))
-            {
-                metricsToReport.emplace(m);
-            }
+            metrics->emplace(m);
         }
-        reportMetrics(metricsToReport);
-    }
-    else
-    {
-        reportMetrics(mApp.getMetrics().GetAllMetrics());
     }
+    return [metrics]() {
+        medida::reporting::JsonReporter jr(*metrics);
+        return jr.Report();
+    };
 }
 
 void
@@ -694,8 +787,8 @@ CommandHandler::selfCheck(std::string const&, std::string& retStr)
     mApp.scheduleSelfCheck(true);
 }
 
-void
-CommandHandler::quorum(std::string const& params, std::string& retStr)
+CommandHandler::Renderer
+CommandHandler::quorum(std::string const& params)
 {
     ZoneScoped;
     std::map<std::string, std::string> retMap;
@@ -728,18 +821,267 @@ CommandHandler::quorum(std::string const& params, std::string& retStr)
         root = mApp.getHerder().getJsonQuorumInfo(
             n, retMap["compact"] == "true", retMap["fullkeys"] == "true", 0);
     }
+    return styledRenderer(std::move(root));
+}
+
+CommandHandler::Renderer
+CommandHandler::scpInfo(std::string const& params)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> retMap;
+    http::server::server::parseParams(params, retMap);
+    size_t lim = parseOptionalParamOrDefault<size_t>(retMap, "limit", 2);
+
+    return styledRenderer(
+        mApp.getHerder().getJsonInfo(lim, retMap["fullkeys"] == "true"));
+}
+
+CommandHandler::Renderer
+CommandHandler::scpTiming(std::string const& params)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> retMap;
+    http::server::server::parseParams(params, retMap);
+    size_t lim = parseOptionalParamOrDefault<size_t>(retMap, "limit", 5);
+
+    return styledRenderer(mApp.getHerder().getJsonSCPTimingInfo(lim));
+}
+
+CommandHandler::Renderer
+CommandHandler::closeTiming(std::string const& params)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> retMap;
+    http::server::server::parseParams(params, retMap);
+    size_t lim = parseOptionalParamOrDefault<size_t>(retMap, "limit", 5);
+
+    return styledRenderer(
+        mApp.getLedgerManager().getJsonCloseTimingInfo(lim));
+}
+
+void
+CommandHandler::memory(std::string const&, std::string& retStr)
+{
+    ZoneScoped;
+    Json::Value root;
+    auto& bytes = root["bytes"];
+    bytes = Json::objectValue;
+    size_t total = 0;
+    for (auto const& [name, b] : mApp.getMemoryFootprint())
+    {
+        bytes[name] = (Json::UInt64)b;
+        total += b;
+    }
+    root["total_bytes"] = (Json::UInt64)total;
+    retStr = root.toStyledString();
+}
+
+void
+CommandHandler::scheduler(std::string const&, std::string& retStr)
+{
+    ZoneScoped;
+    auto const& sched = mApp.getClock().getActionScheduler();
+    auto millis = [](std::chrono::nanoseconds d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    Json::Value root;
+    root["size"] = (Json::UInt64)sched.size();
+    root["overloaded_seconds"] =
+        (Json::Int64)sched.getOverloadedDuration().count();
+    auto const& stats = sched.stats();
+    root["overload_transitions"] = (Json::UInt64)stats.mOverloadTransitions;
+    root["actions_dropped"] = (Json::UInt64)stats.mActionsDroppedDueToOverload;
+
+    // Timings come from the metrics, which only one of several applications
+    // sharing a clock reports to
+    bool withMetrics = sched.getMetrics() == &mApp.getMetrics();
+    auto timerJson = [](medida::Timer& timer) {
+        Json::Value res;
+        auto snapshot = timer.GetSnapshot();
+        res["count"] = (Json::UInt64)timer.count();
+        res["mean_ms"] = timer.mean();
+        res["p50_ms"] = snapshot.getMedian();
+        res["p99_ms"] = snapshot.get99thPercentile();
+        res["max_ms"] = timer.max();
+        return res;
+    };
+
+    auto& queues = root["queues"];
+    queues = Json::arrayValue;
+    for (auto const& q : sched.getQueueInfo())
+    {
+        Json::Value qj;
+        qj["name"] = q.mName;
+        qj["type"] = Scheduler::getActionTypeName(q.mType);
+        qj["size"] = (Json::UInt64)q.mSize;
+        qj["total_service_ms"] = millis(q.mTotalService);
+        qj["oldest_wait_ms"] = millis(q.mOldestWait);
+        if (withMetrics)
+        {
+            auto name = toMetricName(q.mName);
+            auto& metrics = mApp.getMetrics();
+            qj["sojourn"] =
+                timerJson(metrics.NewTimer({"scheduler", "sojourn", name}));
+            qj["run"] = timerJson(metrics.NewTimer({"scheduler", "run", name}));
+            qj["dropped"] = (Json::UInt64)metrics
+                                .NewMeter({"scheduler", "dropped", name},
+                                          "action")
+                                .count();
+        }
+        queues.append(qj);
+    }
     retStr = root.toStyledString();
 }
 
+// "tracing?mode=<start|stop|dump>[&seconds=n]"
 void
-CommandHandler::scpInfo(std::string const& params, std::string& retStr)
+CommandHandler::tracing(std::string const& params, std::string& retStr)
 {
     ZoneScoped;
     std::map<std::string, std::string> retMap;
     http::server::server::parseParams(params, retMap);
-    size_t lim = parseOptionalParamOrDefault<size_t>(retMap, "limit", 2);
 
-    auto root = mApp.getHerder().getJsonInfo(lim, retMap["fullkeys"] == "true");
+    if (!SpanRecorder::isAvailable())
+    {
+        retStr = "tracing is not available in builds with Tracy";
+        return;
+    }
+
+    auto mode = retMap["mode"];
+    if (mode == "start")
+    {
+        SpanRecorder::start();
+    }
+    else if (mode == "stop")
+    {
+        SpanRecorder::stop();
+    }
+    else if (mode == "dump")
+    {
+        auto seconds =
+            parseOptionalParamOrDefault<uint32_t>(retMap, "seconds", 10);
+        retStr = SpanRecorder::dumpChromeTrace(std::chrono::seconds(seconds));
+        return;
+    }
+    else if (!mode.empty())
+    {
+        retStr = fmt::format(FMT_STRING("Unknown mode: {}"), mode);
+        return;
+    }
+
+    Json::Value root;
+    root["recording"] = SpanRecorder::isRecording();
+    retStr = root.toStyledString();
+}
+
+// "profile?[mode=start&interval=ms|mode=stop][&zones=n]"
+void
+CommandHandler::profile(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> retMap;
+    http::server::server::parseParams(params, retMap);
+
+    auto mode = retMap["mode"];
+    if (mode == "start")
+    {
+        if (!SpanRecorder::isAvailable())
+        {
+            retStr = "profiling is not available in builds with Tracy";
+            return;
+        }
+        auto interval =
+            parseOptionalParamOrDefault<uint32_t>(retMap, "interval", 10);
+        // Joins the previous sampler, if any, before starting over
+        mProfiler.reset();
+        mProfiler = std::make_unique<SamplingProfiler>(
+            std::chrono::milliseconds(interval));
+    }
+    else if (mode == "stop")
+    {
+        if (mProfiler)
+        {
+            mProfiler->stop();
+        }
+    }
+    else if (!mode.empty())
+    {
+        retStr = fmt::format(FMT_STRING("Unknown mode: {}"), mode);
+        return;
+    }
+
+    auto toMs = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+    Json::Value root;
+    root["profiling"] = false;
+    if (mProfiler)
+    {
+        auto report = mProfiler->report();
+        root["profiling"] = report.mRunning;
+        root["samples"] = static_cast<Json::UInt64>(report.mSamples);
+        root["duration_ms"] = toMs(report.mDuration.count());
+        root["cpu_ms"] = toMs(report.mTotalCpuNs);
+
+        auto& subsystems = root["subsystems"];
+        for (auto const& [name, cpuNs] : report.mCpuNsBySubsystem)
+        {
+            subsystems[name]["cpu_ms"] = toMs(cpuNs);
+            subsystems[name]["percent"] =
+                report.mTotalCpuNs == 0
+                    ? 0.0
+                    : 100.0 * static_cast<double>(cpuNs) /
+                          static_cast<double>(report.mTotalCpuNs);
+        }
+        auto& threads = root["threads"];
+        for (auto const& [name, cpuNs] : report.mCpuNsByThread)
+        {
+            threads[name]["cpu_ms"] = toMs(cpuNs);
+        }
+
+        auto maxZones =
+            parseOptionalParamOrDefault<uint32_t>(retMap, "zones", 20);
+        auto& zones = root["zones"];
+        zones = Json::arrayValue;
+        for (auto const& usage : report.mZones)
+        {
+            if (zones.size() >= maxZones)
+            {
+                break;
+            }
+            Json::Value zone;
+            if (auto const* loc = usage.mZone)
+            {
+                zone["name"] = loc->mName ? loc->mName : loc->mFunction;
+                zone["file"] = loc->mFile;
+                zone["line"] = loc->mLine;
+            }
+            else
+            {
+                zone["name"] = SamplingProfiler::UNTRACKED;
+            }
+            zone["cpu_ms"] = toMs(usage.mCpuNs);
+            zone["samples"] = static_cast<Json::UInt64>(usage.mSamples);
+            zones.append(zone);
+        }
+    }
+
+    auto memory = SamplingProfiler::memoryUsage();
+    auto& mem = root["memory"];
+    mem = Json::objectValue;
+    if (memory.mResidentBytes)
+    {
+        mem["rss_bytes"] = static_cast<Json::UInt64>(*memory.mResidentBytes);
+    }
+    if (memory.mPeakResidentBytes)
+    {
+        mem["peak_rss_bytes"] =
+            static_cast<Json::UInt64>(*memory.mPeakResidentBytes);
+    }
+    if (memory.mHeapInUseBytes)
+    {
+        mem["heap_in_use_bytes"] =
+            static_cast<Json::UInt64>(*memory.mHeapInUseBytes);
+    }
     retStr = root.toStyledString();
 }
 
@@ -754,15 +1096,16 @@ CommandHandler::sorobanInfo(std::string const& params, std::string& retStr)
         std::map<std::string, std::string> retMap;
         http::server::server::parseParams(params, retMap);
 
-        // Format is the only acceptable param, but it is optional
-        if (retMap.count("format") != retMap.size())
+        // Format is optional, limit only applies to the contracts format
+        auto format =
+            parseOptionalParamOrDefault<std::string>(retMap, "format", "basic");
+        if (retMap.count("format") + retMap.count("limit") != retMap.size() ||
+            (retMap.count("limit") && format != "contracts"))
         {
             retStr = "Invalid param";
             return;
         }
 
-        auto format =
-            parseOptionalParamOrDefault<std::string>(retMap, "format", "basic");
         if (format == "basic")
         {
             Json::Value res;
@@ -860,6 +1203,14 @@ CommandHandler::sorobanInfo(std::string const& params, std::string& retStr)
                 static_cast<Json::UInt64>(conf.getAverageBucketListSize());
             retStr = res.toStyledString();
         }
+        else if (format == "contracts")
+        {
+            auto limit =
+                parseOptionalParamOrDefault<uint32_t>(retMap, "limit", 20);
+            retStr = lm.getSorobanContractProfiler()
+                         .getJsonInfo(limit)
+                         .toStyledString();
+        }
         else if (format == "detailed")
         {
             LedgerTxn ltx(mApp.getLedgerTxnRoot(),
@@ -984,6 +1335,53 @@ CommandHandler::getLedgerEntry(std::string const& params, std::string& retStr)
     retStr = Json::FastWriter().write(root);
 }
 
+TransactionFrameBasePtr
+CommandHandler::txFromBlob(std::string const& blob)
+{
+    TransactionEnvelope envelope;
+    std::vector<uint8_t> binBlob;
+    decoder::decode_b64(blob, binBlob);
+    xdr::xdr_from_opaque(binBlob, envelope);
+
+    {
+        auto lhhe = mApp.getLedgerManager().getLastClosedLedgerHeader();
+        if (protocolVersionStartsFrom(lhhe.header.ledgerVersion,
+                                      ProtocolVersion::V_13))
+        {
+            envelope = txbridge::convertForV13(envelope);
+        }
+    }
+
+    return TransactionFrameBase::makeTransactionFromWire(mApp.getNetworkID(),
+                                                         envelope);
+}
+
+Json::Value
+CommandHandler::txStatus(TransactionFrameBasePtr const& transaction,
+                         TransactionQueue::AddResult status)
+{
+    Json::Value root;
+    root["status"] = TX_STATUS_STRING[static_cast<int>(status)];
+    if (status == TransactionQueue::AddResult::ADD_STATUS_ERROR)
+    {
+        std::string resultBase64;
+        auto resultBin = xdr::xdr_to_opaque(transaction->getResult());
+        resultBase64.reserve(decoder::encoded_size64(resultBin.size()) + 1);
+        resultBase64 = decoder::encode_b64(resultBin);
+        root["error"] = resultBase64;
+        if (mApp.getConfig().ENABLE_DIAGNOSTICS_FOR_TX_SUBMISSION &&
+            transaction->isSoroban() &&
+            !transaction->getDiagnosticEvents().empty())
+        {
+            auto diagsBin =
+                xdr::xdr_to_opaque(transaction->getDiagnosticEvents());
+            auto diagsBase64 = decoder::encode_b64(diagsBin);
+            root["diagnostic_events"] = diagsBase64;
+        }
+    }
+    return root;
+}
+
 void
 CommandHandler::tx(std::string const& params, std::string& retStr)
 {
@@ -996,47 +1394,13 @@ CommandHandler::tx(std::string const& params, std::string& retStr)
 
     if (!blob.empty())
     {
-        TransactionEnvelope envelope;
-        std::vector<uint8_t> binBlob;
-        decoder::decode_b64(blob, binBlob);
-        xdr::xdr_from_opaque(binBlob, envelope);
-
-        {
-            auto lhhe = mApp.getLedgerManager().getLastClosedLedgerHeader();
-            if (protocolVersionStartsFrom(lhhe.header.ledgerVersion,
-                                          ProtocolVersion::V_13))
-            {
-                envelope = txbridge::convertForV13(envelope);
-            }
-        }
-
-        auto transaction = TransactionFrameBase::makeTransactionFromWire(
-            mApp.getNetworkID(), envelope);
+        auto transaction = txFromBlob(blob);
         if (transaction)
         {
             // Add it to our current set and make sure it is valid.
             TransactionQueue::AddResult status =
                 mApp.getHerder().recvTransaction(transaction, true);
-
-            root["status"] = TX_STATUS_STRING[static_cast<int>(status)];
-            if (status == TransactionQueue::AddResult::ADD_STATUS_ERROR)
-            {
-                std::string resultBase64;
-                auto resultBin = xdr::xdr_to_opaque(transaction->getResult());
-                resultBase64.reserve(decoder::encoded_size64(resultBin.size()) +
-                                     1);
-                resultBase64 = decoder::encode_b64(resultBin);
-                root["error"] = resultBase64;
-                if (mApp.getConfig().ENABLE_DIAGNOSTICS_FOR_TX_SUBMISSION &&
-                    transaction->isSoroban() &&
-                    !transaction->getDiagnosticEvents().empty())
-                {
-                    auto diagsBin =
-                        xdr::xdr_to_opaque(transaction->getDiagnosticEvents());
-                    auto diagsBase64 = decoder::encode_b64(diagsBin);
-                    root["diagnostic_events"] = diagsBase64;
-                }
-            }
+            root = txStatus(transaction, status);
         }
     }
     else
@@ -1048,6 +1412,51 @@ CommandHandler::tx(std::string const& params, std::string& retStr)
     retStr = Json::FastWriter().write(root);
 }
 
+void
+CommandHandler::txBatch(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> paramMap;
+    http::server::server::parseParams(params, paramMap);
+    std::string const& blobs = paramMap["blobs"];
+    if (blobs.empty())
+    {
+        throw std::invalid_argument(
+            "Must specify tx blobs: txbatch?blobs=<tx in xdr format>,...");
+    }
+
+    // Envelopes failing to decode get their own error, and don't fail the
+    // rest of the batch
+    Json::Value root(Json::arrayValue);
+    std::vector<TransactionFrameBasePtr> txs;
+    std::vector<Json::ArrayIndex> indexes;
+    std::stringstream ss(blobs);
+    std::string blob;
+    while (std::getline(ss, blob, ','))
+    {
+        auto& res = root.append(Json::Value());
+        try
+        {
+            if (auto transaction = txFromBlob(blob))
+            {
+                txs.emplace_back(transaction);
+                indexes.emplace_back(root.size() - 1);
+            }
+        }
+        catch (std::exception const& e)
+        {
+            res["exception"] = e.what();
+        }
+    }
+
+    auto statuses = mApp.getHerder().recvTransactions(txs, true);
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        root[indexes[i]] = txStatus(txs[i], statuses[i]);
+    }
+    retStr = Json::FastWriter().write(root);
+}
+
 void
 CommandHandler::dropcursor(std::string const& params, std::string& retStr)
 {
@@ -1139,6 +1548,16 @@ CommandHandler::maintenance(std::string const& params, std::string& retStr)
     }
 }
 
+CommandHandler::Renderer
+CommandHandler::prometheus(std::string const& params)
+{
+    ZoneScoped;
+    mApp.syncAllMetrics();
+    auto const& all = mApp.getMetrics().GetAllMetrics();
+    auto metrics = std::make_shared<MetricsSnapshot>(all.begin(), all.end());
+    return [metrics]() { return PrometheusReporter().report(*metrics); };
+}
+
 void
 CommandHandler::clearMetrics(std::string const& params, std::string& retStr)
 {
@@ -1210,12 +1629,12 @@ CommandHandler::stopSurvey(std::string const&, std::string& retStr)
     retStr = "survey stopped";
 }
 
-void
-CommandHandler::getSurveyResult(std::string const&, std::string& retStr)
+CommandHandler::Renderer
+CommandHandler::getSurveyResult(std::string const&)
 {
     ZoneScoped;
     auto& surveyManager = mApp.getOverlayManager().getSurveyManager();
-    retStr = surveyManager.getJsonResults().toStyledString();
+    return styledRenderer(surveyManager.getJsonResults());
 }
 
 void
@@ -1327,6 +1746,8 @@ CommandHandler::generateLoad(std::string const& params, std::string& retStr)
             parseOptionalParam<uint32_t>(map, "maxfeerate");
         cfg.skipLowFeeTxs =
             parseOptionalParamOrDefault<bool>(map, "skiplowfeetxs", false);
+        cfg.openLoop =
+            parseOptionalParamOrDefault<bool>(map, "openloop", false);
 
         if (cfg.mode == LoadGenMode::MIXED_CLASSIC)
         {
@@ -1414,6 +1835,25 @@ CommandHandler::generateLoad(std::string const& params, std::string& retStr)
             }
         }
 
+        if (cfg.mode == LoadGenMode::MIXED_SOROBAN)
+        {
+            auto& mixCfg = cfg.getMutMixSorobanConfig();
+            mixCfg.sacTransferWeight = parseOptionalParamOrDefault<uint32_t>(
+                map, "sactransferweight", 0);
+            mixCfg.storageWeight =
+                parseOptionalParamOrDefault<uint32_t>(map, "storageweight", 0);
+            mixCfg.readWeight =
+                parseOptionalParamOrDefault<uint32_t>(map, "readweight", 0);
+            mixCfg.ttlWeight =
+                parseOptionalParamOrDefault<uint32_t>(map, "ttlweight", 0);
+            if (!(mixCfg.sacTransferWeight || mixCfg.storageWeight ||
+                  mixCfg.readWeight || mixCfg.ttlWeight))
+            {
+                retStr = "At least one mix weight must be non-zero";
+                return;
+            }
+        }
+
         if (cfg.maxGeneratedFeeRate)
         {
             auto baseFee = mApp.getLedgerManager().getLastTxFee();
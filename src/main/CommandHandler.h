@@ -4,9 +4,14 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "herder/TransactionQueue.h"
 #include "lib/http/server.hpp"
+#include "lib/json/json.h"
 #include "util/ProtocolVersion.h"
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 /*
 handler functions for the http commands this server supports
@@ -15,6 +20,7 @@ handler functions for the http commands this server supports
 namespace stellar
 {
 class Application;
+class SamplingProfiler;
 
 class CommandHandler
 {
@@ -22,10 +28,25 @@ class CommandHandler
                                std::string&)>
         HandlerRoute;
 
+    // Read-only commands run in two steps: on the main thread they take a
+    // snapshot of what they report, owned by the Renderer they return, which
+    // then renders the reply on a worker thread.
+    typedef std::function<std::string()> Renderer;
+    typedef std::function<Renderer(CommandHandler*, std::string const&)>
+        SnapshotRoute;
+
     Application& mApp;
     std::unique_ptr<http::server::server> mServer;
+    // Of the latest `profile?mode=start`, kept after it stops
+    std::unique_ptr<SamplingProfiler> mProfiler;
+
+    // HTTP_COMMAND_THREAD_POOL_SIZE threads running Renderers
+    asio::io_context mWorkerIOContext;
+    std::unique_ptr<asio::io_context::work> mWork;
+    std::vector<std::thread> mWorkers;
 
     void addRoute(std::string const& name, HandlerRoute route);
+    void addSnapshotRoute(std::string const& name, SnapshotRoute route);
     void safeRouter(HandlerRoute route, std::string const& params,
                     std::string& retStr);
 
@@ -35,8 +56,16 @@ class CommandHandler
     void ensureProtocolVersion(std::string const& errString,
                                ProtocolVersion minVer);
 
+    // Decodes a base64 TransactionEnvelope submitted to `tx` or `txbatch`.
+    // Returns null if it isn't a valid transaction.
+    TransactionFrameBasePtr txFromBlob(std::string const& blob);
+    // Reply of `tx` for `transaction`, submitted with `status`
+    Json::Value txStatus(TransactionFrameBasePtr const& transaction,
+                         TransactionQueue::AddResult status);
+
   public:
     CommandHandler(Application& app);
+    ~CommandHandler();
 
     std::string manualCmd(std::string const& cmd);
 
@@ -46,27 +75,35 @@ class CommandHandler
     void connect(std::string const& params, std::string& retStr);
     void dropcursor(std::string const& params, std::string& retStr);
     void dropPeer(std::string const& params, std::string& retStr);
-    void info(std::string const& params, std::string& retStr);
+    Renderer info(std::string const& params);
     void ll(std::string const& params, std::string& retStr);
     void logRotate(std::string const& params, std::string& retStr);
     void maintenance(std::string const& params, std::string& retStr);
     void manualClose(std::string const& params, std::string& retStr);
-    void metrics(std::string const& params, std::string& retStr);
+    void memory(std::string const& params, std::string& retStr);
+    Renderer metrics(std::string const& params);
+    Renderer prometheus(std::string const& params);
     void clearMetrics(std::string const& params, std::string& retStr);
-    void peers(std::string const& params, std::string& retStr);
+    Renderer closeTiming(std::string const& params);
+    Renderer peers(std::string const& params);
     void selfCheck(std::string const&, std::string& retStr);
-    void quorum(std::string const& params, std::string& retStr);
+    Renderer quorum(std::string const& params);
     void setcursor(std::string const& params, std::string& retStr);
     void getcursor(std::string const& params, std::string& retStr);
-    void scpInfo(std::string const& params, std::string& retStr);
+    void profile(std::string const& params, std::string& retStr);
+    Renderer scpInfo(std::string const& params);
+    Renderer scpTiming(std::string const& params);
+    void scheduler(std::string const& params, std::string& retStr);
+    void tracing(std::string const& params, std::string& retStr);
     void tx(std::string const& params, std::string& retStr);
+    void txBatch(std::string const& params, std::string& retStr);
     void getLedgerEntry(std::string const& params, std::string& retStr);
     void unban(std::string const& params, std::string& retStr);
     void upgrades(std::string const& params, std::string& retStr);
     void dumpProposedSettings(std::string const& params, std::string& retStr);
     void surveyTopology(std::string const&, std::string& retStr);
     void stopSurvey(std::string const&, std::string& retStr);
-    void getSurveyResult(std::string const&, std::string& retStr);
+    Renderer getSurveyResult(std::string const&);
     void sorobanInfo(std::string const&, std::string& retStr);
     void startSurveyCollecting(std::string const& params, std::string& retStr);
     void stopSurveyCollecting(std::string const& params, std::string& retStr);
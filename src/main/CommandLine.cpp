@@ -11,6 +11,7 @@
 #include "bucket/BucketManager.h"
 #include "catchup/CatchupConfiguration.h"
 #include "catchup/CatchupRange.h"
+#include "catchup/ParallelCatchupWork.h"
 #include "catchup/ReplayDebugMetaWork.h"
 #include "crypto/SHA.h"
 #include "herder/Herder.h"
@@ -44,10 +45,12 @@
 #include "test/test.h"
 #endif
 
+#include <filesystem>
 #include <fmt/format.h>
 #include <iostream>
 #include <lib/clara.hpp>
 #include <optional>
+#include <thread>
 
 namespace stellar
 {
@@ -450,6 +453,14 @@ aggregateParser(std::optional<std::string>& aggregate)
         "comma-separated aggregate expressions");
 }
 
+clara::Opt
+fieldsParser(std::optional<std::string>& fields)
+{
+    return clara::Opt{[&](std::string const& arg) { fields = arg; },
+                      "FIELDS-EXPR"}["--fields"](
+        "comma-separated fields to write as CSV columns instead of JSON");
+}
+
 clara::Opt
 limitParser(std::optional<std::uint64_t>& limit)
 {
@@ -592,6 +603,8 @@ CommandLine::ConfigOption::getConfig(bool logToFile) const
             Logging::setLoggingColor(true);
         }
     }
+    Logging::setAsync(config.LOG_ASYNC, config.LOG_ASYNC_QUEUE_SIZE);
+    Logging::setRateLimit(config.LOG_RATE_LIMIT_PER_SECOND);
 
     bool consoleLogging =
         !logToFile || config.LOG_FILE_PATH.empty() || mConsoleLog;
@@ -735,11 +748,17 @@ runReplayDebugMeta(CommandLineArgs const& args)
     uint32_t targetLedger = 0;
     CommandLine::ConfigOption configOption;
     std::string metaDir{"."};
+    bool applyChanges = false;
+    auto applyChangesParser = [](bool& applyChanges) {
+        return clara::Opt{applyChanges}["--apply-changes"](
+            "apply the ledger entry changes in the meta instead of running "
+            "transactions");
+    };
 
     return runWithHelp(
         args,
         {configurationParser(configOption), historyLedgerNumber(targetLedger),
-         metaDirParser(metaDir).required()},
+         metaDirParser(metaDir).required(), applyChangesParser(applyChanges)},
         [&] {
             VirtualClock clock(VirtualClock::REAL_TIME);
             auto cfg = configOption.getConfig();
@@ -755,7 +774,8 @@ runReplayDebugMeta(CommandLineArgs const& args)
             std::filesystem::path dir(metaDir);
 
             auto catchupWork =
-                wm.executeWork<ReplayDebugMetaWork>(targetLedger, dir);
+                wm.executeWork<ReplayDebugMetaWork>(targetLedger, dir,
+                                                    applyChanges);
             if (catchupWork->getState() == BasicWork::State::WORK_SUCCESS)
             {
                 LOG_INFO(DEFAULT_LOG, "Replay finished");
@@ -783,6 +803,7 @@ runCatchup(CommandLineArgs const& args)
     bool forceUntrusted = false;
     std::string hash;
     std::string stream;
+    std::string workDir;
 
     auto validateCatchupString = [&] {
         try
@@ -833,6 +854,13 @@ runCatchup(CommandLineArgs const& args)
             "historical data");
     };
 
+    auto workDirParser = [](std::string& dir) {
+        return clara::Opt{dir, "DIR-NAME"}["--work-dir"](
+            "keep buckets in DIR-NAME and do not listen on the HTTP port, so "
+            "that several catchups can run side by side (requires "
+            "--in-memory)");
+    };
+
     return runWithHelp(
         args,
         {configurationParser(configOption), catchupStringParser,
@@ -841,7 +869,8 @@ runCatchup(CommandLineArgs const& args)
          outputFileParser(outputFile), disableBucketGCParser(disableBucketGC),
          validationParser(completeValidation), inMemoryParser(inMemory),
          ledgerHashParser(hash), forceUntrustedCatchup(forceUntrusted),
-         metadataOutputStreamParser(stream), forceBackParser(forceBack)},
+         metadataOutputStreamParser(stream), forceBackParser(forceBack),
+         workDirParser(workDir)},
         [&] {
             auto config = configOption.getConfig();
             // Don't call config.setNoListen() here as we might want to
@@ -850,6 +879,17 @@ runCatchup(CommandLineArgs const& args)
             config.MANUAL_CLOSE = true;
             config.DISABLE_BUCKET_GC = disableBucketGC;
 
+            if (!workDir.empty())
+            {
+                if (!inMemory)
+                {
+                    throw std::runtime_error("--work-dir requires --in-memory");
+                }
+                config.BUCKET_DIR_PATH = workDir + "/buckets";
+                config.HTTP_PORT = 0;
+                config.setNoPublish();
+            }
+
             if (config.AUTOMATIC_MAINTENANCE_PERIOD.count() > 0 &&
                 config.AUTOMATIC_MAINTENANCE_COUNT > 0)
             {
@@ -976,6 +1016,134 @@ runCatchup(CommandLineArgs const& args)
         });
 }
 
+int
+runParallelCatchup(CommandLineArgs const& args)
+{
+    CommandLine::ConfigOption configOption;
+    std::string catchupString;
+    std::string archive;
+    std::string trustedCheckpointHashesFile;
+    std::string workDir = "parallel-catchup";
+    uint32_t segmentSize = 0;
+    uint32_t workers = std::max(1u, std::thread::hardware_concurrency());
+    bool forceUntrusted = false;
+
+    auto validateCatchupString = [&] {
+        try
+        {
+            auto cc = parseCatchup(catchupString, "", false);
+            if (cc.toLedger() == CatchupConfiguration::CURRENT)
+            {
+                return std::string{"destination ledger must be a number"};
+            }
+            return std::string{};
+        }
+        catch (std::runtime_error& e)
+        {
+            return std::string{e.what()};
+        }
+    };
+
+    auto catchupStringParser = ParserWithValidation{
+        clara::Arg(catchupString, "DESTINATION-LEDGER/LEDGER-COUNT").required(),
+        validateCatchupString};
+    auto trustedCheckpointHashesParser =
+        clara::Opt{trustedCheckpointHashesFile,
+                   "FILE-NAME"}["--trusted-checkpoint-hashes"](
+            "check the end of every segment against the trusted output of "
+            "'verify-checkpoints'");
+    auto segmentSizeParser =
+        clara::Opt{segmentSize, "LEDGER-COUNT"}["--segment-size"](
+            "ledgers to replay per segment, rounded up to whole checkpoints "
+            "(default: the range split evenly between workers)");
+    auto workersParser = clara::Opt{workers, "COUNT"}["--workers"](
+        "number of segments to replay at once (default: number of cores)");
+    auto workDirParser = clara::Opt{workDir, "DIR-NAME"}["--work-dir"](
+        "directory for the buckets and output of each segment (default "
+        "'parallel-catchup')");
+
+    return runWithHelp(
+        args,
+        {configurationParser(configOption), catchupStringParser,
+         historyArchiveParser(archive), trustedCheckpointHashesParser,
+         segmentSizeParser, workersParser, workDirParser,
+         forceUntrustedCatchup(forceUntrusted)},
+        [&] {
+            if (configOption.mConfigFile == "-")
+            {
+                throw std::runtime_error(
+                    "segments read the config file again, so it can't be "
+                    "read from STDIN");
+            }
+            if (trustedCheckpointHashesFile.empty() && !forceUntrusted)
+            {
+                throw std::runtime_error(
+                    "use --trusted-checkpoint-hashes to check segments "
+                    "against trusted hashes, or --force-untrusted-catchup");
+            }
+            if (workers == 0)
+            {
+                throw std::runtime_error("--workers must be at least 1");
+            }
+
+            auto config = configOption.getConfig();
+            config.setNoListen();
+            config.setNoPublish();
+            config.setInMemoryMode();
+            config.MODE_DOES_CATCHUP = false;
+            config.QUORUM_INTERSECTION_CHECKER = false;
+            config.BUCKET_DIR_PATH = workDir + "/buckets";
+            // BatchWork and ProcessManager both cap the segments running at
+            // once to this
+            config.MAX_CONCURRENT_SUBPROCESSES = workers;
+
+            ParallelCatchupOptions options;
+            std::error_code ec;
+            auto exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+            options.mExe = ec ? std::string{"stellar-core"} : exe.string();
+            options.mConfigFile = configOption.mConfigFile.empty()
+                                      ? std::string{"stellar-core.cfg"}
+                                      : configOption.mConfigFile;
+            options.mWorkDir = workDir;
+            options.mArchive = archive;
+            options.mTrustedCheckpointHashesFile = trustedCheckpointHashesFile;
+
+            VirtualClock clock(VirtualClock::REAL_TIME);
+            auto app = Application::create(clock, config, false);
+            auto const& hm = app->getHistoryManager();
+            auto cc = parseCatchup(catchupString, "", false);
+            if (!hm.isLastLedgerInCheckpoint(cc.toLedger()))
+            {
+                throw std::runtime_error(
+                    "destination ledger is not a checkpoint boundary");
+            }
+            auto count = std::min(cc.count(), cc.toLedger());
+            if (segmentSize == 0)
+            {
+                segmentSize = (count + workers - 1) / workers;
+            }
+            auto segments =
+                splitCatchupIntoSegments(cc.toLedger(), count, segmentSize,
+                                         hm.getCheckpointFrequency());
+            LOG_INFO(DEFAULT_LOG,
+                     "Replaying {} ledgers up to {} as {} segments, {} at a "
+                     "time",
+                     count, cc.toLedger(), segments.size(), workers);
+
+            app->start();
+            auto work =
+                app->getWorkScheduler().executeWork<ParallelCatchupWork>(
+                    options, segments);
+            auto ok = work->getState() == BasicWork::State::WORK_SUCCESS;
+            LOG_INFO(DEFAULT_LOG, "*");
+            LOG_INFO(DEFAULT_LOG, "* Parallel catchup {}.",
+                     ok ? "finished" : "failed");
+            LOG_INFO(DEFAULT_LOG, "*");
+            app->gracefulStop();
+            return ok ? 0 : 1;
+        });
+}
+
 int
 runPublish(CommandLineArgs const& args)
 {
@@ -997,11 +1165,19 @@ runWriteVerifiedCheckpointHashes(CommandLineArgs const& args)
     std::string outputFile;
     uint32_t startLedger = 0;
     std::string startHash;
+    std::optional<std::string> trustedHashFile;
     CommandLine::ConfigOption configOption;
+    auto trustedHashFileParser = [](std::optional<std::string>& file) {
+        return clara::Opt{[&](std::string const& arg) { file = arg; },
+                          "FILE-NAME"}["--trusted-hash-file"](
+            "only verify checkpoints newer than those in this earlier output "
+            "of 'verify-checkpoints', which is extended");
+    };
     return runWithHelp(
         args,
         {configurationParser(configOption), historyLedgerNumber(startLedger),
-         historyHashParser(startHash), outputFileParser(outputFile).required()},
+         historyHashParser(startHash), outputFileParser(outputFile).required(),
+         trustedHashFileParser(trustedHashFile)},
         [&] {
             VirtualClock clock(VirtualClock::REAL_TIME);
             auto cfg = configOption.getConfig();
@@ -1029,8 +1205,11 @@ runWriteVerifiedCheckpointHashes(CommandLineArgs const& args)
                 app->getOverlayManager().shutdown();
                 app->getHerder().shutdown();
                 app->getWorkScheduler()
-                    .executeWork<WriteVerifiedCheckpointHashesWork>(authPair,
-                                                                    outputFile);
+                    .executeWork<WriteVerifiedCheckpointHashesWork>(
+                        authPair, outputFile,
+                        WriteVerifiedCheckpointHashesWork::
+                            NESTED_DOWNLOAD_BATCH_SIZE,
+                        nullptr, trustedHashFile);
                 app->gracefulStop();
                 return 0;
             }
@@ -1156,6 +1335,26 @@ runSelfCheck(CommandLineArgs const& args)
                        [&] { return selfCheck(configOption.getConfig()); });
 }
 
+int
+runBenchApply(CommandLineArgs const& args)
+{
+    CommandLine::ConfigOption configOption;
+    std::string metaFile;
+    uint32_t warmupLedgers = 0;
+    std::string outputFile;
+
+    return runWithHelp(
+        args,
+        {configurationParser(configOption), fileNameParser(metaFile),
+         clara::Opt{warmupLedgers, "N"}["--warmup-ledgers"](
+             "number of ledgers to apply before measuring"),
+         outputFileParser(outputFile)},
+        [&] {
+            return benchApply(configOption.getConfig(), metaFile,
+                              warmupLedgers, outputFile);
+        });
+}
+
 int
 runMergeBucketList(CommandLineArgs const& args)
 {
@@ -1178,6 +1377,15 @@ runDumpStateArchivalStatistics(CommandLineArgs const& args)
     });
 }
 
+int
+runReportBucketCompression(CommandLineArgs const& args)
+{
+    CommandLine::ConfigOption configOption;
+    return runWithHelp(args, {configurationParser(configOption)}, [&] {
+        return reportBucketCompression(configOption.getConfig());
+    });
+}
+
 int
 runDumpLedger(CommandLineArgs const& args)
 {
@@ -1188,18 +1396,28 @@ runDumpLedger(CommandLineArgs const& args)
     std::optional<uint64_t> limit;
     std::optional<std::string> groupBy;
     std::optional<std::string> aggregate;
+    std::optional<std::string> fields;
+    uint32_t threads = 1;
+
+    auto threadsParser = [](uint32_t& threads) {
+        return clara::Opt{threads, "N"}["--threads"](
+            "number of buckets to scan in parallel (default 1)");
+    };
+
     return runWithHelp(args,
                        {configurationParser(configOption),
                         outputFileParser(outputFile).required(),
                         filterQueryParser(filterQuery),
                         lastModifiedLedgerCountParser(lastModifiedLedgerCount),
                         limitParser(limit), groupByParser(groupBy),
-                        aggregateParser(aggregate)},
+                        aggregateParser(aggregate), fieldsParser(fields),
+                        threadsParser(threads)},
                        [&] {
                            return dumpLedger(configOption.getConfig(),
                                              outputFile, filterQuery,
                                              lastModifiedLedgerCount, limit,
-                                             groupBy, aggregate);
+                                             groupBy, aggregate, fields,
+                                             threads);
                        });
 }
 
@@ -1580,7 +1798,10 @@ run(CommandLineArgs const& args)
                 // Second, setup the app with the final configuration.
                 // Note that when in in-memory mode, additional setup may be
                 // required (such as database reset, catchup, etc)
-                clock = std::make_shared<VirtualClock>(clockMode);
+                clock = std::make_shared<VirtualClock>(
+                    clockMode, cfg.EXPERIMENTAL_TIMER_WHEEL
+                                   ? VirtualClock::TIMER_WHEEL
+                                   : VirtualClock::TIMER_HEAP);
                 app = setupApp(cfg, *clock, startAtLedger, startAtHash);
                 if (!app)
                 {
@@ -1794,6 +2015,35 @@ runFuzz(CommandLineArgs const& args)
                        });
 }
 
+int
+runLibFuzz(CommandLineArgs const& args)
+{
+    LogLevel logLevel{LogLevel::LVL_FATAL};
+    std::string corpusDir;
+    std::vector<std::string> fuzzerArgs;
+    std::string outputFile;
+    int processID = 0;
+    FuzzerMode fuzzerMode{FuzzerMode::OVERLAY};
+    std::string fuzzerModeArg = "overlay";
+
+    return runWithHelp(
+        args,
+        {logLevelParser(logLevel), requiredArgParser(corpusDir, "CORPUS-DIR"),
+         clara::Opt{fuzzerArgs, "ARG"}["--fuzzer-arg"](
+             "pass ARG to libFuzzer, e.g. --fuzzer-arg=-max_total_time=60"),
+         outputFileParser(outputFile), processIDParser(processID),
+         fuzzerModeParser(fuzzerModeArg, fuzzerMode)},
+        [&] {
+            Logging::setLogLevel(logLevel, nullptr);
+            if (!outputFile.empty())
+            {
+                Logging::setLoggingToFile(outputFile);
+            }
+
+            return libFuzz(corpusDir, fuzzerArgs, processID, fuzzerMode);
+        });
+}
+
 int
 runGenFuzz(CommandLineArgs const& args)
 {
@@ -1830,6 +2080,9 @@ handleCommandLine(int argc, char* const* argv)
           "execute catchup from history archives without connecting to "
           "network",
           runCatchup},
+         {"catchup-parallel",
+          "replay a range of history as segments in parallel processes",
+          runParallelCatchup},
          {"replay-debug-meta", "apply ledgers from local debug metadata files",
           runReplayDebugMeta},
          {"verify-checkpoints", "write verified checkpoint ledger hashes",
@@ -1848,6 +2101,9 @@ handleCommandLine(int argc, char* const* argv)
          {"http-command", "send a command to local stellar-core",
           runHttpCommand},
          {"self-check", "performs diagnostic checks", runSelfCheck},
+         {"bench-apply",
+          "measure the time to apply the ledgers of a meta stream file",
+          runBenchApply},
          {"merge-bucketlist", "writes diagnostic merged bucket list",
           runMergeBucketList},
          {"dump-archival-stats",
@@ -1864,6 +2120,9 @@ handleCommandLine(int argc, char* const* argv)
           "connecting to network, may not publish last checkpoint if last "
           "closed ledger is on checkpoint boundary",
           runPublish},
+         {"report-bucket-compression",
+          "reports the disk space the BucketList would take block-compressed",
+          runReportBucketCompression},
          {"report-last-history-checkpoint",
           "report information about last checkpoint available in "
           "history archives",
@@ -1891,6 +2150,8 @@ handleCommandLine(int argc, char* const* argv)
           runRebuildLedgerFromBuckets},
          {"fuzz", "run a single fuzz input and exit", runFuzz},
          {"gen-fuzz", "generate a random fuzzer input file", runGenFuzz},
+         {"libfuzz", "run libFuzzer in-process over a corpus directory",
+          runLibFuzz},
          {"test", "execute test suite", runTest},
 #endif
          {"version", "print version information", runVersion}}};
@@ -1904,7 +2165,8 @@ handleCommandLine(int argc, char* const* argv)
         fmt::format(FMT_STRING("{0} {1}"), exeName, command->name());
     auto args = CommandLineArgs{exeName, commandName, command->description(),
                                 adjustedCommandLine.second};
-    if (command->name() == "run" || command->name() == "fuzz")
+    if (command->name() == "run" || command->name() == "fuzz" ||
+        command->name() == "libfuzz")
     {
         // run outside of catch block so that we properly capture crashes
         return command->run(args);
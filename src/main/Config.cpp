@@ -9,6 +9,7 @@
 #include "crypto/KeyUtils.h"
 #include "herder/Herder.h"
 #include "history/HistoryArchive.h"
+#include "history/NativeArchiveFetch.h"
 #include "ledger/LedgerManager.h"
 #include "main/ExternalQueue.h"
 #include "main/StellarCoreVersion.h"
@@ -152,7 +153,7 @@ Config::Config() : NODE_SEED(SecretKey::random())
     LEDGER_PROTOCOL_MIN_VERSION_INTERNAL_ERROR_REPORT = 18;
 
     OVERLAY_PROTOCOL_MIN_VERSION = 32;
-    OVERLAY_PROTOCOL_VERSION = 34;
+    OVERLAY_PROTOCOL_VERSION = 35;
 
     VERSION_STR = STELLAR_CORE_VERSION;
 
@@ -161,12 +162,35 @@ Config::Config() : NODE_SEED(SecretKey::random())
     MANUAL_CLOSE = false;
     CATCHUP_COMPLETE = false;
     CATCHUP_RECENT = 0;
+    CATCHUP_TRUSTED_REPLAY = false;
     EXPERIMENTAL_PRECAUTION_DELAY_META = false;
+    EXPERIMENTAL_BACKGROUND_META_EMISSION = false;
+    METADATA_OUTPUT_QUEUE_LEDGERS = 1;
+    METADATA_OUTPUT_QUEUE_FULL_ERROR = false;
     EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING = false;
+    EXPERIMENTAL_TIMER_WHEEL = false;
+    EXPERIMENTAL_PARALLEL_TX_SET_VALIDATION = false;
+    EXPERIMENTAL_SPECULATIVE_TX_SET_PREPARATION = false;
+    EXPERIMENTAL_BACKGROUND_TX_SET_PREPARATION = false;
+    EXPERIMENTAL_PARALLEL_SOROBAN_APPLY = false;
     DEPRECATED_SQL_LEDGER_STATE = false;
     BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT = 14; // 2^14 == 16 kb
     BUCKETLIST_DB_INDEX_CUTOFF = 20;             // 20 mb
+    BUCKETLIST_DB_INDEX_SHARD_SIZE = 0;
+    BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET = false;
+    BUCKET_MERGE_READ_BUFFER_SIZE = 0;
+    BUCKET_MERGE_PIPELINED_HASHING = false;
+    BUCKET_MERGE_DROP_PAGE_CACHE = false;
+    BUCKET_MERGE_IO_BUDGET_MB = 0;
+    BUCKET_MERGE_MAX_CONCURRENCY = 0;
+    BUCKET_APPLY_TARGET_BATCH_LATENCY_MS = 0;
     BUCKETLIST_DB_PERSIST_INDEX = true;
+    BUCKETLIST_DB_MMAP_READS = false;
+    BUCKETLIST_DB_BATCH_READS = false;
+    BUCKETLIST_DB_IN_MEMORY_LEVELS = 0;
+    BUCKETLIST_DB_PARALLEL_LOAD_MIN_KEYS = 0;
+    BUCKETLIST_DB_CACHED_ENTRIES = 0;
+    BUCKETLIST_DB_RETAINED_SNAPSHOTS = 0;
     EXPERIMENTAL_BACKGROUND_EVICTION_SCAN = false;
     PUBLISH_TO_ARCHIVE_DELAY = std::chrono::seconds{0};
     // automatic maintenance settings:
@@ -179,6 +203,7 @@ Config::Config() : NODE_SEED(SecretKey::random())
     // (30*24*3600/5) / (400 - 359/5 ) // number of periods needed to catchup
     //   * (359) / (24*3600) = 6.56 days
     AUTOMATIC_MAINTENANCE_COUNT = 400;
+    AUTOMATIC_MAINTENANCE_TIME_BUDGET = std::chrono::milliseconds::zero();
     // automatic self-check happens once every 3 hours
     AUTOMATIC_SELF_CHECK_PERIOD = std::chrono::seconds{3 * 60 * 60};
     ARTIFICIALLY_GENERATE_LOAD_FOR_TESTING = false;
@@ -207,6 +232,8 @@ Config::Config() : NODE_SEED(SecretKey::random())
                                Herder::EXP_LEDGER_TIMESPAN_SECONDS.count(),
                            CLOSETIME_DRIFT_LIMIT);
     METADATA_OUTPUT_STREAM = "";
+    METADATA_OUTPUT_RING_BUFFER_MB = 64;
+    METADATA_OUTPUT_FILTER = "";
 
     // Store at least 1 checkpoint plus a buffer worth of debug meta
     METADATA_DEBUG_LEDGERS = 100;
@@ -215,6 +242,9 @@ Config::Config() : NODE_SEED(SecretKey::random())
     BUCKET_DIR_PATH = "buckets";
 
     LOG_COLOR = false;
+    LOG_ASYNC = false;
+    LOG_ASYNC_QUEUE_SIZE = 8192;
+    LOG_RATE_LIMIT_PER_SECOND = 0;
 
     TESTING_UPGRADE_LEDGER_PROTOCOL_VERSION = LEDGER_PROTOCOL_VERSION;
     TESTING_UPGRADE_DESIRED_FEE = LedgerManager::GENESIS_LEDGER_BASE_FEE;
@@ -225,15 +255,22 @@ Config::Config() : NODE_SEED(SecretKey::random())
     HTTP_PORT = DEFAULT_PEER_PORT + 1;
     PUBLIC_HTTP_PORT = false;
     HTTP_MAX_CLIENT = 128;
+    HTTP_COMMAND_THREAD_POOL_SIZE = 1;
+    HTTP_QUERY_PORT = 0;
+    QUERY_THREAD_POOL_SIZE = 4;
+    QUERY_MAX_KEYS_PER_REQUEST = 1000;
+    QUERY_MAX_KEYS_PER_SECOND = 0;
     PEER_PORT = DEFAULT_PEER_PORT;
     TARGET_PEER_CONNECTIONS = 8;
     MAX_PENDING_CONNECTIONS = 500;
+    MAX_INBOUND_CONNECTIONS_PER_SECOND = 0;
     MAX_ADDITIONAL_PEER_CONNECTIONS = -1;
     MAX_OUTBOUND_PENDING_CONNECTIONS = 0;
     MAX_INBOUND_PENDING_CONNECTIONS = 0;
     PEER_AUTHENTICATION_TIMEOUT = 2;
     PEER_TIMEOUT = 30;
     PEER_STRAGGLER_TIMEOUT = 120;
+    PEER_TABLE_FLUSH_PERIOD_SECONDS = std::chrono::seconds(10);
 
     FLOOD_OP_RATE_PER_LEDGER = 1.0;
     FLOOD_TX_PERIOD_MS = 200;
@@ -247,9 +284,14 @@ Config::Config() : NODE_SEED(SecretKey::random())
     FLOOD_DEMAND_PERIOD_MS = std::chrono::milliseconds(200);
     FLOOD_ADVERT_PERIOD_MS = std::chrono::milliseconds(100);
     FLOOD_DEMAND_BACKOFF_DELAY_MS = std::chrono::milliseconds(500);
+    FETCH_PARALLEL_PEERS = 1;
+    OUTBOUND_PEER_ROTATION_PERIOD_SECONDS = std::chrono::seconds(0);
 
     MAX_BATCH_WRITE_COUNT = 1024;
     MAX_BATCH_WRITE_BYTES = 1 * 1024 * 1024;
+    MAX_BATCH_WRITE_DELAY_MS = std::chrono::milliseconds(0);
+    OVERLAY_COMPRESSION_LEVEL = 0;
+    ENABLE_OVERLAY_MESSAGE_TYPE_TIMING = false;
     PREFERRED_PEERS_ONLY = false;
 
     PEER_READING_CAPACITY = 200;
@@ -274,19 +316,41 @@ Config::Config() : NODE_SEED(SecretKey::random())
     //
     // Worst case = 10 concurrent merges + 1 quorum intersection calculation.
     WORKER_THREADS = 11;
+    NUMA_MEMORY_POLICY = "local";
     MAX_CONCURRENT_SUBPROCESSES = 16;
+    USE_PROCESS_SPAWNER = false;
+    MAX_CONCURRENT_DOWNLOADS_PER_ARCHIVE = 0;
+    MAX_CONCURRENT_CHECKPOINT_PUBLISHES = 4;
     NODE_IS_VALIDATOR = false;
     QUORUM_INTERSECTION_CHECKER = true;
+    INVARIANT_CHECKS_ASYNC = false;
+    INVARIANT_CHECKS_ASYNC_HALT = false;
+    QUORUM_INTERSECTION_CHECKER_THREADS = 1;
     DATABASE = SecretValue{"sqlite3://:memory:"};
+    DATABASE_POOL_SIZE = 0;
+    SQLITE_CACHE_SIZE_KB = 20000;
+    SQLITE_MMAP_SIZE_MB = 100;
+    SQLITE_MANAGED_CHECKPOINTS = false;
+    SQL_STATEMENT_METRICS = false;
+    SQL_SLOW_STATEMENT_EXPLAIN_MS = std::chrono::milliseconds(0);
+    LOG_SLOW_OPERATION_APPLY_MS = std::chrono::milliseconds(0);
 
     ENTRY_CACHE_SIZE = 100000;
     PREFETCH_BATCH_SIZE = 1000;
+    SIGNATURE_CACHE_SIZE = PubKeyUtils::DEFAULT_VERIFY_SIG_CACHE_SIZE;
+    MEMORY_LIMIT_MB = 0;
+    PARALLEL_LEDGER_COMMIT_ENCODING = false;
+    IN_MEMORY_ORDER_BOOK = false;
+    IN_MEMORY_ORDER_BOOK_CHECKS = false;
+    IN_MEMORY_OFFERS = false;
+    SOROBAN_FEE_PARITY_CHECKS = false;
 
     HISTOGRAM_WINDOW_SIZE = std::chrono::seconds(30);
 
     HALT_ON_INTERNAL_TRANSACTION_ERROR = false;
 
     MAX_DEX_TX_OPERATIONS_IN_TX_SET = std::nullopt;
+    PERSIST_TRANSACTION_QUEUE = false;
 
     ENABLE_SOROBAN_DIAGNOSTIC_EVENTS = false;
     ENABLE_DIAGNOSTICS_FOR_TX_SUBMISSION = false;
@@ -549,10 +613,36 @@ Config::loadQset(std::shared_ptr<cpptoml::table> group, SCPQuorumSet& qset,
 
 void
 Config::addHistoryArchive(std::string const& name, std::string const& get,
-                          std::string const& put, std::string const& mkdir)
+                          std::string const& put, std::string const& mkdir,
+                          std::string const& url)
 {
+    if (!url.empty())
+    {
+        if (!NativeArchiveFetch::isSupported())
+        {
+            throw std::invalid_argument(fmt::format(
+                FMT_STRING("History archive '{}' sets 'url' but this build "
+                           "cannot fetch files natively (libcurl not found)"),
+                name));
+        }
+        // The get command is still used for the few files fetched through
+        // GetRemoteFileWork, such as the archive state
+        if (get.empty())
+        {
+            throw std::invalid_argument(fmt::format(
+                FMT_STRING("History archive '{}' sets 'url' without 'get'"),
+                name));
+        }
+        if (url.rfind("http://", 0) != 0 && url.rfind("https://", 0) != 0)
+        {
+            throw std::invalid_argument(fmt::format(
+                FMT_STRING("History archive '{}' has a 'url' that is not an "
+                           "http:// or https:// URL"),
+                name));
+        }
+    }
     auto r = HISTORY.insert(std::make_pair(
-        name, HistoryArchiveConfiguration{name, get, put, mkdir}));
+        name, HistoryArchiveConfiguration{name, get, put, mkdir, url}));
     if (!r.second)
     {
         throw std::invalid_argument(
@@ -1051,10 +1141,30 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 HTTP_MAX_CLIENT = readInt<unsigned short>(item, 0);
             }
+            else if (item.first == "HTTP_COMMAND_THREAD_POOL_SIZE")
+            {
+                HTTP_COMMAND_THREAD_POOL_SIZE = readInt<int>(item, 0, 1000);
+            }
             else if (item.first == "PUBLIC_HTTP_PORT")
             {
                 PUBLIC_HTTP_PORT = readBool(item);
             }
+            else if (item.first == "HTTP_QUERY_PORT")
+            {
+                HTTP_QUERY_PORT = readInt<unsigned short>(item);
+            }
+            else if (item.first == "QUERY_THREAD_POOL_SIZE")
+            {
+                QUERY_THREAD_POOL_SIZE = readInt<int>(item, 1, 1000);
+            }
+            else if (item.first == "QUERY_MAX_KEYS_PER_REQUEST")
+            {
+                QUERY_MAX_KEYS_PER_REQUEST = readInt<uint32_t>(item, 1);
+            }
+            else if (item.first == "QUERY_MAX_KEYS_PER_SECOND")
+            {
+                QUERY_MAX_KEYS_PER_SECOND = readInt<uint32_t>(item);
+            }
             else if (item.first == "FAILURE_SAFETY")
             {
                 FAILURE_SAFETY = readInt<int32_t>(item, -1, INT32_MAX - 1);
@@ -1071,14 +1181,55 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 METADATA_OUTPUT_STREAM = readString(item);
             }
+            else if (item.first == "METADATA_OUTPUT_RING_BUFFER_MB")
+            {
+                METADATA_OUTPUT_RING_BUFFER_MB = readInt<uint32_t>(item, 1);
+            }
+            else if (item.first == "METADATA_OUTPUT_FILTER")
+            {
+                METADATA_OUTPUT_FILTER = readString(item);
+            }
             else if (item.first == "EXPERIMENTAL_PRECAUTION_DELAY_META")
             {
                 EXPERIMENTAL_PRECAUTION_DELAY_META = readBool(item);
             }
+            else if (item.first == "EXPERIMENTAL_BACKGROUND_META_EMISSION")
+            {
+                EXPERIMENTAL_BACKGROUND_META_EMISSION = readBool(item);
+            }
+            else if (item.first == "METADATA_OUTPUT_QUEUE_LEDGERS")
+            {
+                METADATA_OUTPUT_QUEUE_LEDGERS = readInt<uint32_t>(item, 1);
+            }
+            else if (item.first == "METADATA_OUTPUT_QUEUE_FULL_ERROR")
+            {
+                METADATA_OUTPUT_QUEUE_FULL_ERROR = readBool(item);
+            }
             else if (item.first == "EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING")
             {
                 EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING = readBool(item);
             }
+            else if (item.first == "EXPERIMENTAL_TIMER_WHEEL")
+            {
+                EXPERIMENTAL_TIMER_WHEEL = readBool(item);
+            }
+            else if (item.first == "EXPERIMENTAL_PARALLEL_TX_SET_VALIDATION")
+            {
+                EXPERIMENTAL_PARALLEL_TX_SET_VALIDATION = readBool(item);
+            }
+            else if (item.first ==
+                     "EXPERIMENTAL_SPECULATIVE_TX_SET_PREPARATION")
+            {
+                EXPERIMENTAL_SPECULATIVE_TX_SET_PREPARATION = readBool(item);
+            }
+            else if (item.first == "EXPERIMENTAL_BACKGROUND_TX_SET_PREPARATION")
+            {
+                EXPERIMENTAL_BACKGROUND_TX_SET_PREPARATION = readBool(item);
+            }
+            else if (item.first == "EXPERIMENTAL_PARALLEL_SOROBAN_APPLY")
+            {
+                EXPERIMENTAL_PARALLEL_SOROBAN_APPLY = readBool(item);
+            }
             else if (item.first == "EXPERIMENTAL_BACKGROUND_EVICTION_SCAN")
             {
                 EXPERIMENTAL_BACKGROUND_EVICTION_SCAN = readBool(item);
@@ -1130,10 +1281,67 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 BUCKETLIST_DB_INDEX_CUTOFF = readInt<size_t>(item);
             }
+            else if (item.first == "BUCKETLIST_DB_INDEX_SHARD_SIZE")
+            {
+                BUCKETLIST_DB_INDEX_SHARD_SIZE = readInt<size_t>(item);
+            }
+            else if (item.first == "BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET")
+            {
+                BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET = readBool(item);
+            }
+            else if (item.first == "BUCKET_MERGE_READ_BUFFER_SIZE")
+            {
+                BUCKET_MERGE_READ_BUFFER_SIZE = readInt<size_t>(item);
+            }
+            else if (item.first == "BUCKET_MERGE_PIPELINED_HASHING")
+            {
+                BUCKET_MERGE_PIPELINED_HASHING = readBool(item);
+            }
+            else if (item.first == "BUCKET_MERGE_DROP_PAGE_CACHE")
+            {
+                BUCKET_MERGE_DROP_PAGE_CACHE = readBool(item);
+            }
+            else if (item.first == "BUCKET_MERGE_IO_BUDGET_MB")
+            {
+                BUCKET_MERGE_IO_BUDGET_MB = readInt<size_t>(item);
+            }
+            else if (item.first == "BUCKET_MERGE_MAX_CONCURRENCY")
+            {
+                BUCKET_MERGE_MAX_CONCURRENCY = readInt<uint32_t>(item);
+            }
+            else if (item.first == "BUCKET_APPLY_TARGET_BATCH_LATENCY_MS")
+            {
+                BUCKET_APPLY_TARGET_BATCH_LATENCY_MS = readInt<size_t>(item);
+            }
             else if (item.first == "BUCKETLIST_DB_PERSIST_INDEX")
             {
                 BUCKETLIST_DB_PERSIST_INDEX = readBool(item);
             }
+            else if (item.first == "BUCKETLIST_DB_MMAP_READS")
+            {
+                BUCKETLIST_DB_MMAP_READS = readBool(item);
+            }
+            else if (item.first == "BUCKETLIST_DB_BATCH_READS")
+            {
+                BUCKETLIST_DB_BATCH_READS = readBool(item);
+            }
+            else if (item.first == "BUCKETLIST_DB_IN_MEMORY_LEVELS")
+            {
+                BUCKETLIST_DB_IN_MEMORY_LEVELS = readInt<uint32_t>(
+                    item, 0, BucketList::kNumLevels);
+            }
+            else if (item.first == "BUCKETLIST_DB_PARALLEL_LOAD_MIN_KEYS")
+            {
+                BUCKETLIST_DB_PARALLEL_LOAD_MIN_KEYS = readInt<size_t>(item);
+            }
+            else if (item.first == "BUCKETLIST_DB_CACHED_ENTRIES")
+            {
+                BUCKETLIST_DB_CACHED_ENTRIES = readInt<size_t>(item);
+            }
+            else if (item.first == "BUCKETLIST_DB_RETAINED_SNAPSHOTS")
+            {
+                BUCKETLIST_DB_RETAINED_SNAPSHOTS = readInt<uint32_t>(item);
+            }
             else if (item.first == "METADATA_DEBUG_LEDGERS")
             {
                 METADATA_DEBUG_LEDGERS = readInt<uint32_t>(item);
@@ -1162,6 +1370,10 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 CATCHUP_RECENT = readInt<uint32_t>(item, 0, UINT32_MAX - 1);
             }
+            else if (item.first == "CATCHUP_TRUSTED_REPLAY")
+            {
+                CATCHUP_TRUSTED_REPLAY = readBool(item);
+            }
             else if (item.first == "ARTIFICIALLY_GENERATE_LOAD_FOR_TESTING")
             {
                 ARTIFICIALLY_GENERATE_LOAD_FOR_TESTING = readBool(item);
@@ -1209,6 +1421,11 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 AUTOMATIC_MAINTENANCE_COUNT = readInt<uint32_t>(item);
             }
+            else if (item.first == "AUTOMATIC_MAINTENANCE_TIME_BUDGET")
+            {
+                AUTOMATIC_MAINTENANCE_TIME_BUDGET =
+                    std::chrono::milliseconds{readInt<uint32_t>(item)};
+            }
             else if (item.first == "AUTOMATIC_SELF_CHECK_PERIOD")
             {
                 AUTOMATIC_SELF_CHECK_PERIOD =
@@ -1226,10 +1443,26 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 LOG_COLOR = readBool(item);
             }
+            else if (item.first == "LOG_ASYNC")
+            {
+                LOG_ASYNC = readBool(item);
+            }
+            else if (item.first == "LOG_ASYNC_QUEUE_SIZE")
+            {
+                LOG_ASYNC_QUEUE_SIZE = readInt<uint32_t>(item, 1);
+            }
+            else if (item.first == "LOG_RATE_LIMIT_PER_SECOND")
+            {
+                LOG_RATE_LIMIT_PER_SECOND = readInt<uint32_t>(item);
+            }
             else if (item.first == "BUCKET_DIR_PATH")
             {
                 BUCKET_DIR_PATH = readString(item);
             }
+            else if (item.first == "SHARED_BUCKET_DIR_PATH")
+            {
+                SHARED_BUCKET_DIR_PATH = readString(item);
+            }
             else if (item.first == "NODE_NAMES")
             {
                 auto names = readArray<std::string>(item);
@@ -1266,6 +1499,11 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 MAX_PENDING_CONNECTIONS = readInt<unsigned short>(
                     item, 1, std::numeric_limits<unsigned short>::max());
             }
+            else if (item.first == "MAX_INBOUND_CONNECTIONS_PER_SECOND")
+            {
+                MAX_INBOUND_CONNECTIONS_PER_SECOND = readInt<unsigned short>(
+                    item, 0, std::numeric_limits<unsigned short>::max());
+            }
             else if (item.first == "PEER_AUTHENTICATION_TIMEOUT")
             {
                 PEER_AUTHENTICATION_TIMEOUT = readInt<unsigned short>(
@@ -1281,6 +1519,11 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 PEER_STRAGGLER_TIMEOUT = readInt<unsigned short>(
                     item, 1, std::numeric_limits<unsigned short>::max());
             }
+            else if (item.first == "PEER_TABLE_FLUSH_PERIOD_SECONDS")
+            {
+                PEER_TABLE_FLUSH_PERIOD_SECONDS =
+                    std::chrono::seconds(readInt<uint32_t>(item));
+            }
             else if (item.first == "MAX_BATCH_WRITE_COUNT")
             {
                 MAX_BATCH_WRITE_COUNT = readInt<int>(item, 1);
@@ -1289,6 +1532,27 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 MAX_BATCH_WRITE_BYTES = readInt<int>(item, 1);
             }
+            else if (item.first == "MAX_BATCH_WRITE_DELAY_MS")
+            {
+                MAX_BATCH_WRITE_DELAY_MS =
+                    std::chrono::milliseconds(readInt<int>(item, 0, 1000));
+            }
+            else if (item.first == "OVERLAY_COMPRESSION_LEVEL")
+            {
+                OVERLAY_COMPRESSION_LEVEL = readInt<int>(item, 0, 19);
+#ifndef USE_ZSTD
+                if (OVERLAY_COMPRESSION_LEVEL != 0)
+                {
+                    throw std::invalid_argument(
+                        "OVERLAY_COMPRESSION_LEVEL requires stellar-core to "
+                        "be built with zstd");
+                }
+#endif
+            }
+            else if (item.first == "ENABLE_OVERLAY_MESSAGE_TYPE_TIMING")
+            {
+                ENABLE_OVERLAY_MESSAGE_TYPE_TIMING = readBool(item);
+            }
             else if (item.first == "FLOOD_OP_RATE_PER_LEDGER")
             {
                 FLOOD_OP_RATE_PER_LEDGER = readDouble(item);
@@ -1330,6 +1594,15 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 FLOOD_DEMAND_BACKOFF_DELAY_MS =
                     std::chrono::milliseconds(readInt<int>(item, 1));
             }
+            else if (item.first == "FETCH_PARALLEL_PEERS")
+            {
+                FETCH_PARALLEL_PEERS = readInt<uint32_t>(item, 1);
+            }
+            else if (item.first == "OUTBOUND_PEER_ROTATION_PERIOD_SECONDS")
+            {
+                OUTBOUND_PEER_ROTATION_PERIOD_SECONDS =
+                    std::chrono::seconds(readInt<uint32_t>(item));
+            }
             else if (item.first == "FLOOD_ARB_TX_BASE_ALLOWANCE")
             {
                 FLOOD_ARB_TX_BASE_ALLOWANCE = readInt<int32_t>(item, -1);
@@ -1374,14 +1647,61 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 WORKER_THREADS = readInt<int>(item, 2, 1000);
             }
+            else if (item.first == "MAIN_THREAD_CPUS")
+            {
+                MAIN_THREAD_CPUS = readIntArray<uint32_t>(item, 0, 1023);
+            }
+            else if (item.first == "OVERLAY_THREAD_CPUS")
+            {
+                OVERLAY_THREAD_CPUS = readIntArray<uint32_t>(item, 0, 1023);
+            }
+            else if (item.first == "EVICTION_THREAD_CPUS")
+            {
+                EVICTION_THREAD_CPUS = readIntArray<uint32_t>(item, 0, 1023);
+            }
+            else if (item.first == "META_THREAD_CPUS")
+            {
+                META_THREAD_CPUS = readIntArray<uint32_t>(item, 0, 1023);
+            }
+            else if (item.first == "WORKER_THREAD_CPUS")
+            {
+                WORKER_THREAD_CPUS = readIntArray<uint32_t>(item, 0, 1023);
+            }
+            else if (item.first == "NUMA_MEMORY_POLICY")
+            {
+                NUMA_MEMORY_POLICY = readString(item);
+                if (NUMA_MEMORY_POLICY != "local" &&
+                    NUMA_MEMORY_POLICY != "interleave")
+                {
+                    throw std::invalid_argument(
+                        "NUMA_MEMORY_POLICY must be local or interleave");
+                }
+            }
             else if (item.first == "MAX_CONCURRENT_SUBPROCESSES")
             {
                 MAX_CONCURRENT_SUBPROCESSES = readInt<size_t>(item, 1);
             }
+            else if (item.first == "USE_PROCESS_SPAWNER")
+            {
+                USE_PROCESS_SPAWNER = readBool(item);
+            }
+            else if (item.first == "MAX_CONCURRENT_DOWNLOADS_PER_ARCHIVE")
+            {
+                MAX_CONCURRENT_DOWNLOADS_PER_ARCHIVE = readInt<size_t>(item);
+            }
+            else if (item.first == "MAX_CONCURRENT_CHECKPOINT_PUBLISHES")
+            {
+                MAX_CONCURRENT_CHECKPOINT_PUBLISHES = readInt<size_t>(item, 1);
+            }
             else if (item.first == "QUORUM_INTERSECTION_CHECKER")
             {
                 QUORUM_INTERSECTION_CHECKER = readBool(item);
             }
+            else if (item.first == "QUORUM_INTERSECTION_CHECKER_THREADS")
+            {
+                QUORUM_INTERSECTION_CHECKER_THREADS =
+                    readInt<int>(item, 1, 1000);
+            }
             else if (item.first == "HISTORY")
             {
                 auto hist = item.second->as_table();
@@ -1397,7 +1717,7 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                             throw std::invalid_argument(
                                 "malformed HISTORY config block");
                         }
-                        std::string get, put, mkdir;
+                        std::string get, put, mkdir, url;
                         for (auto const& c : *tab)
                         {
                             if (c.first == "get")
@@ -1412,6 +1732,10 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                             {
                                 mkdir = c.second->as<std::string>()->get();
                             }
+                            else if (c.first == "url")
+                            {
+                                url = c.second->as<std::string>()->get();
+                            }
                             else
                             {
                                 std::string err(
@@ -1422,7 +1746,8 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                                 throw std::invalid_argument(err);
                             }
                         }
-                        addHistoryArchive(archive.first, get, put, mkdir);
+                        addHistoryArchive(archive.first, get, put, mkdir,
+                                          url);
                     }
                 }
                 else
@@ -1434,6 +1759,36 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 DATABASE = SecretValue{readString(item)};
             }
+            else if (item.first == "DATABASE_POOL_SIZE")
+            {
+                DATABASE_POOL_SIZE = readInt<uint32_t>(item);
+            }
+            else if (item.first == "SQLITE_CACHE_SIZE_KB")
+            {
+                SQLITE_CACHE_SIZE_KB = readInt<uint32_t>(item);
+            }
+            else if (item.first == "SQLITE_MMAP_SIZE_MB")
+            {
+                SQLITE_MMAP_SIZE_MB = readInt<uint32_t>(item);
+            }
+            else if (item.first == "SQLITE_MANAGED_CHECKPOINTS")
+            {
+                SQLITE_MANAGED_CHECKPOINTS = readBool(item);
+            }
+            else if (item.first == "SQL_STATEMENT_METRICS")
+            {
+                SQL_STATEMENT_METRICS = readBool(item);
+            }
+            else if (item.first == "SQL_SLOW_STATEMENT_EXPLAIN_MS")
+            {
+                SQL_SLOW_STATEMENT_EXPLAIN_MS =
+                    std::chrono::milliseconds(readInt<int>(item, 0));
+            }
+            else if (item.first == "LOG_SLOW_OPERATION_APPLY_MS")
+            {
+                LOG_SLOW_OPERATION_APPLY_MS =
+                    std::chrono::milliseconds(readInt<int>(item, 0));
+            }
             else if (item.first == "NETWORK_PASSPHRASE")
             {
                 NETWORK_PASSPHRASE = readString(item);
@@ -1442,6 +1797,53 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 INVARIANT_CHECKS = readArray<std::string>(item);
             }
+            else if (item.first == "INVARIANT_CHECKS_ASYNC")
+            {
+                INVARIANT_CHECKS_ASYNC = readBool(item);
+            }
+            else if (item.first == "INVARIANT_CHECKS_ASYNC_HALT")
+            {
+                INVARIANT_CHECKS_ASYNC_HALT = readBool(item);
+            }
+            else if (item.first == "INVARIANT_SAMPLING")
+            {
+                auto samplings = item.second->as_table();
+                if (!samplings)
+                {
+                    throw std::invalid_argument(
+                        "malformed INVARIANT_SAMPLING config block");
+                }
+                for (auto const& inv : *samplings)
+                {
+                    auto tab = inv.second->as_table();
+                    if (!tab)
+                    {
+                        throw std::invalid_argument(
+                            "malformed INVARIANT_SAMPLING config block");
+                    }
+                    auto& sampling = INVARIANT_SAMPLING[inv.first];
+                    for (auto const& c : *tab)
+                    {
+                        if (c.first == "LEDGER_INTERVAL")
+                        {
+                            sampling.mLedgerInterval = readInt<uint32_t>(c, 1);
+                        }
+                        else if (c.first == "LEDGER_BUDGET_MS")
+                        {
+                            sampling.mLedgerBudget =
+                                std::chrono::milliseconds(readInt<uint32_t>(c));
+                        }
+                        else
+                        {
+                            throw std::invalid_argument(fmt::format(
+                                FMT_STRING("Unknown INVARIANT_SAMPLING-table "
+                                           "entry: '{}', within "
+                                           "[INVARIANT_SAMPLING.{}]"),
+                                c.first, inv.first));
+                        }
+                    }
+                }
+            }
             else if (item.first == "ENTRY_CACHE_SIZE")
             {
                 ENTRY_CACHE_SIZE = readInt<uint32_t>(item);
@@ -1450,6 +1852,34 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 PREFETCH_BATCH_SIZE = readInt<uint32_t>(item);
             }
+            else if (item.first == "SIGNATURE_CACHE_SIZE")
+            {
+                SIGNATURE_CACHE_SIZE = readInt<size_t>(item, 1);
+            }
+            else if (item.first == "MEMORY_LIMIT_MB")
+            {
+                MEMORY_LIMIT_MB = readInt<size_t>(item);
+            }
+            else if (item.first == "PARALLEL_LEDGER_COMMIT_ENCODING")
+            {
+                PARALLEL_LEDGER_COMMIT_ENCODING = readBool(item);
+            }
+            else if (item.first == "IN_MEMORY_ORDER_BOOK")
+            {
+                IN_MEMORY_ORDER_BOOK = readBool(item);
+            }
+            else if (item.first == "IN_MEMORY_ORDER_BOOK_CHECKS")
+            {
+                IN_MEMORY_ORDER_BOOK_CHECKS = readBool(item);
+            }
+            else if (item.first == "IN_MEMORY_OFFERS")
+            {
+                IN_MEMORY_OFFERS = readBool(item);
+            }
+            else if (item.first == "SOROBAN_FEE_PARITY_CHECKS")
+            {
+                SOROBAN_FEE_PARITY_CHECKS = readBool(item);
+            }
             else if (item.first == "MAXIMUM_LEDGER_CLOSETIME_DRIFT")
             {
                 MAXIMUM_LEDGER_CLOSETIME_DRIFT = readInt<int64_t>(item, 0);
@@ -1658,6 +2088,10 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 MAX_DEX_TX_OPERATIONS_IN_TX_SET =
                     value == 0 ? std::nullopt : std::make_optional(value);
             }
+            else if (item.first == "PERSIST_TRANSACTION_QUEUE")
+            {
+                PERSIST_TRANSACTION_QUEUE = readBool(item);
+            }
             else if (item.first == "EMIT_SOROBAN_TRANSACTION_META_EXT_V1")
             {
                 EMIT_SOROBAN_TRANSACTION_META_EXT_V1 = readBool(item);
@@ -1792,6 +2226,15 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             throw std::runtime_error(msg);
         }
 
+        if (IN_MEMORY_OFFERS && IN_MEMORY_ORDER_BOOK_CHECKS)
+        {
+            std::string msg =
+                "Invalid configuration: IN_MEMORY_ORDER_BOOK_CHECKS compares "
+                "the in-memory order book with the offers table, which "
+                "IN_MEMORY_OFFERS leaves empty.";
+            throw std::runtime_error(msg);
+        }
+
         // process elements that potentially depend on others
         if (t->contains("VALIDATORS"))
         {
@@ -2333,6 +2776,12 @@ Config::isPersistingBucketListDBIndexes() const
     return isUsingBucketListDB() && BUCKETLIST_DB_PERSIST_INDEX;
 }
 
+bool
+Config::isUsingInMemoryOffers() const
+{
+    return isUsingBucketListDB() && IN_MEMORY_OFFERS;
+}
+
 bool
 Config::isInMemoryModeWithoutMinimalDB() const
 {
@@ -2357,6 +2806,7 @@ Config::setNoListen()
     // prevent opening up a port for other peers
     RUN_STANDALONE = true;
     HTTP_PORT = 0;
+    HTTP_QUERY_PORT = 0;
     MANUAL_CLOSE = true;
 }
 
@@ -28,6 +28,16 @@ struct HistoryArchiveConfiguration
     std::string mGetCmd;
     std::string mPutCmd;
     std::string mMkdirCmd;
+    // Base URL files are fetched from in-process instead of through mGetCmd,
+    // see NativeArchiveFetch
+    std::string mGetUrl;
+};
+
+// How often an invariant checks operations, see [INVARIANT_SAMPLING.<name>]
+struct InvariantSamplingConfiguration
+{
+    uint32_t mLedgerInterval{1};
+    std::chrono::milliseconds mLedgerBudget{0};
 };
 
 enum class ValidationThresholdLevels : int
@@ -74,7 +84,8 @@ class Config : public std::enable_shared_from_this<Config>
     void addValidatorName(std::string const& pubKeyStr,
                           std::string const& name);
     void addHistoryArchive(std::string const& name, std::string const& get,
-                           std::string const& put, std::string const& mkdir);
+                           std::string const& put, std::string const& mkdir,
+                           std::string const& url = "");
 
     std::string toString(ValidatorQuality q) const;
     ValidatorQuality parseQuality(std::string const& q) const;
@@ -157,6 +168,11 @@ class Config : public std::enable_shared_from_this<Config>
     // If you want, say, a week of history, set this to 120000.
     uint32_t CATCHUP_RECENT;
 
+    // When replaying history during catchup, skip signature verification of
+    // transactions that the archive's results (checked against the trusted
+    // ledger header) record as successful. Default is false.
+    bool CATCHUP_TRUSTED_REPLAY;
+
     // Interval between automatic maintenance executions
     std::chrono::seconds AUTOMATIC_MAINTENANCE_PERIOD;
 
@@ -164,6 +180,12 @@ class Config : public std::enable_shared_from_this<Config>
     // maintenance run
     uint32_t AUTOMATIC_MAINTENANCE_COUNT;
 
+    // If non-zero, each maintenance run deletes chunks of rows, sized by how
+    // long previous chunks took, until it catches up or has spent this much
+    // time; on postgres it does so on a pooled connection off the main thread.
+    // AUTOMATIC_MAINTENANCE_COUNT is then the size of the first chunk.
+    std::chrono::milliseconds AUTOMATIC_MAINTENANCE_TIME_BUDGET;
+
     // Interval between automatic invocations of self-check.
     std::chrono::seconds AUTOMATIC_SELF_CHECK_PERIOD;
 
@@ -346,6 +368,18 @@ class Config : public std::enable_shared_from_this<Config>
     // configuration) to delay emitting metadata by one ledger.
     bool EXPERIMENTAL_PRECAUTION_DELAY_META;
 
+    // When set to true, ledger close meta is written to the meta streams on
+    // a dedicated thread while the main thread commits the ledger and moves
+    // on, see METADATA_OUTPUT_QUEUE_LEDGERS.
+    bool EXPERIMENTAL_BACKGROUND_META_EMISSION;
+
+    // With EXPERIMENTAL_BACKGROUND_META_EMISSION, the number of ledgers whose
+    // meta may be waiting for or being written at once. When that many are,
+    // closing the next ledger waits for the oldest one, or fails if
+    // METADATA_OUTPUT_QUEUE_FULL_ERROR is set.
+    uint32_t METADATA_OUTPUT_QUEUE_LEDGERS;
+    bool METADATA_OUTPUT_QUEUE_FULL_ERROR;
+
     // A config parameter that when set uses SQL as the primary
     // key-value store for LedgerEntry lookups instead of BucketListDB.
     bool DEPRECATED_SQL_LEDGER_STATE;
@@ -363,9 +397,74 @@ class Config : public std::enable_shared_from_this<Config>
     // index.
     size_t BUCKETLIST_DB_INDEX_CUTOFF;
 
+    // Size, in MB, of the shards a range indexed bucket file is split into so
+    // that shards can be indexed concurrently on the worker thread pool. Each
+    // concurrent shard worker temporarily allocates its own bloom filter. If
+    // set to 0, buckets are always indexed by a single sequential scan.
+    size_t BUCKETLIST_DB_INDEX_SHARD_SIZE;
+
+    // If set, BucketListDB indexes also map the asset of every trustline to
+    // the pages holding it, so that trustlines of an asset can be found
+    // without scanning every trustline (i.e. by dump-ledger and the query
+    // server). Costs index memory proportional to the number of distinct
+    // assets on each page.
+    bool BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET;
+
+    // Size, in KB, of the read buffer used for each input bucket of a merge.
+    // Buckets smaller than this are read through a buffer of their own size.
+    // If set to 0, the default file stream buffer is used.
+    size_t BUCKET_MERGE_READ_BUFFER_SIZE;
+
+    // When set to true, the output hash of a bucket merge is computed by jobs
+    // on the worker threads, overlapping with serializing and writing entries.
+    bool BUCKET_MERGE_PIPELINED_HASHING;
+
+    // When set to true, bucket merges keep the page cache as they found it:
+    // the pages of their inputs that they read in, and the pages of their
+    // output, are dropped from it once the merge is done.
+    bool BUCKET_MERGE_DROP_PAGE_CACHE;
+
+    // Budgets of the bucket merges running at once: the total size, in MB, of
+    // their inputs, and their number. Pending merges start in order of their
+    // deadlines as running ones finish. A merge always starts when no other
+    // one runs. If set to 0, the budget is unlimited.
+    size_t BUCKET_MERGE_IO_BUDGET_MB;
+    uint32_t BUCKET_MERGE_MAX_CONCURRENCY;
+
+    // Target duration, in milliseconds, of each batch of entries committed
+    // while applying buckets. The batch size is grown or shrunk after every
+    // commit to track this target. If set to 0, a fixed batch size is used.
+    size_t BUCKET_APPLY_TARGET_BATCH_LATENCY_MS;
+
     // Enable parallel processing of overlay operations (experimental)
     bool EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING;
 
+    // Keep the main clock's timers in a timer wheel rather than a heap, for
+    // the `run` command (experimental)
+    bool EXPERIMENTAL_TIMER_WHEEL;
+
+    // When set to true, large transaction sets are validated on the worker
+    // threads (see TxValidationService) before they are validated on the main
+    // thread, which then mostly confirms the results.
+    bool EXPERIMENTAL_PARALLEL_TX_SET_VALIDATION;
+
+    // When set to true, the tx set of a ballot confirmed prepared by SCP has
+    // its ledger entries loaded and its signatures verified in the background
+    // while SCP runs to externalize, as it most likely is the next ledger's.
+    bool EXPERIMENTAL_SPECULATIVE_TX_SET_PREPARATION;
+
+    // When set to true, tx sets received for upcoming ledgers are interpreted
+    // (their transaction frames built and hashed) on a worker thread, so that
+    // validating and applying them finds that work done.
+    bool EXPERIMENTAL_BACKGROUND_TX_SET_PREPARATION;
+
+    // When set to true, the host functions of Soroban transactions that do not
+    // depend on the transactions before them in the ledger are invoked on the
+    // worker threads ahead of their application. Transactions are still
+    // applied one at a time, in order, and only use the result of such an
+    // invocation if the ledger entries it read are still current.
+    bool EXPERIMENTAL_PARALLEL_SOROBAN_APPLY;
+
     // When set to true, BucketListDB indexes are persisted on-disk so that the
     // BucketList does not need to be reindexed on startup. Defaults to true.
     // This should only be set to false for testing purposes
@@ -374,6 +473,40 @@ class Config : public std::enable_shared_from_this<Config>
     // persisted.
     bool BUCKETLIST_DB_PERSIST_INDEX;
 
+    // When set to true, BucketListDB point and bulk loads read bucket files
+    // through a read-only memory mapping instead of a file stream. Bucket
+    // files are immutable once adopted, so index offsets can be decoded in
+    // place out of the page cache. Ignored on platforms without mmap.
+    bool BUCKETLIST_DB_MMAP_READS;
+
+    // When set to true, a BucketListDB bulk load first resolves the offsets of
+    // all its keys in a bucket through the index, then asks the OS to read
+    // all their pages at once before decoding them one by one, so that the
+    // reads reach the device together instead of one at a time.
+    bool BUCKETLIST_DB_BATCH_READS;
+
+    // Number of top levels of the BucketList whose buckets BucketListDB
+    // snapshots keep in memory as sorted vectors, so that lookups on these
+    // levels read no file. If set to 0, every level is read from disk.
+    uint32_t BUCKETLIST_DB_IN_MEMORY_LEVELS;
+
+    // Minimum number of keys in a main thread BucketListDB bulk load (i.e.
+    // ledger prefetch) before per-bucket lookups are fanned out to the worker
+    // thread pool. If set to 0, bulk loads always search buckets sequentially.
+    size_t BUCKETLIST_DB_PARALLEL_LOAD_MIN_KEYS;
+
+    // Maximum number of BucketListDB lookup results cached in memory across
+    // BucketList snapshots. Cached entries are only invalidated when modified
+    // by a ledger, so hot entries are not re-read from disk every ledger. If
+    // set to 0, the cache is disabled.
+    size_t BUCKETLIST_DB_CACHED_ENTRIES;
+
+    // Number of BucketList snapshots of past ledgers kept for point-in-time
+    // queries, in addition to the snapshot of the last closed ledger. Their
+    // buckets stay on disk, and their indexes in memory, until the snapshots
+    // are dropped. If set to 0, no past snapshots are kept.
+    uint32_t BUCKETLIST_DB_RETAINED_SNAPSHOTS;
+
     // When set to true, eviction scans occur on the background thread,
     // increasing performance. Requires EXPERIMENTAL_BUCKETLIST_DB.
     bool EXPERIMENTAL_BACKGROUND_EVICTION_SCAN;
@@ -443,7 +576,8 @@ class Config : public std::enable_shared_from_this<Config>
     // POSIX or a named pipe on Windows, though plain files also work) or a
     // string of the form "fd:N" for some integer N which, on POSIX, specifies
     // the existing open file descriptor N inherited by the process (for example
-    // to write to an anonymous pipe).
+    // to write to an anonymous pipe), or "shm:PATH" for a shared memory ring
+    // buffer of METADATA_OUTPUT_RING_BUFFER_MB at PATH (see MetaRingBuffer).
     //
     // As a further safety check, this option is mutually exclusive with
     // NODE_IS_VALIDATOR, as its typical use writing to a pipe with a reader
@@ -451,6 +585,13 @@ class Config : public std::enable_shared_from_this<Config>
     // delay in closing a ledger, and should not be used on a node participating
     // in consensus, only a passive "watcher" node.
     std::string METADATA_OUTPUT_STREAM;
+    uint32_t METADATA_OUTPUT_RING_BUFFER_MB;
+
+    // An xdrquery expression over LedgerEntry. When set, the meta written to
+    // METADATA_OUTPUT_STREAM only holds the changes to matching entries and
+    // the transactions that made some (see filterMeta). Debug meta is not
+    // filtered.
+    std::string METADATA_OUTPUT_FILTER;
 
     // Number of ledgers worth of transaction metadata to preserve on disk for
     // debugging purposes. These records are automatically maintained and
@@ -490,6 +631,11 @@ class Config : public std::enable_shared_from_this<Config>
     //   against each other.
     std::optional<uint32_t> MAX_DEX_TX_OPERATIONS_IN_TX_SET;
 
+    // When set, the transaction queues are saved to the database on graceful
+    // shutdown and their transactions are submitted again on startup, so they
+    // aren't lost across restarts.
+    bool PERSIST_TRANSACTION_QUEUE;
+
     // note: all versions in the range
     // [OVERLAY_PROTOCOL_MIN_VERSION, OVERLAY_PROTOCOL_VERSION] must be handled
     uint32_t OVERLAY_PROTOCOL_MIN_VERSION; // min overlay version understood
@@ -497,8 +643,23 @@ class Config : public std::enable_shared_from_this<Config>
     std::string VERSION_STR;
     std::string LOG_FILE_PATH;
     bool LOG_COLOR;
+
+    // Whether to format and write log messages on a background thread, with
+    // a queue of LOG_ASYNC_QUEUE_SIZE messages whose oldest are overwritten
+    // when full, so that logging never blocks the thread that logs.
+    bool LOG_ASYNC;
+    size_t LOG_ASYNC_QUEUE_SIZE;
+
+    // Maximum number of messages below WARNING that each log partition writes
+    // in one second, 0 for no limit. Messages over it are dropped and counted.
+    uint32_t LOG_RATE_LIMIT_PER_SECOND;
     std::string BUCKET_DIR_PATH;
 
+    // Directory of buckets and bucket indexes shared with other instances on
+    // the same host, ideally on the same filesystem as BUCKET_DIR_PATH. Empty
+    // to not share.
+    std::string SHARED_BUCKET_DIR_PATH;
+
     // Ledger protocol version for testing purposes. Defaulted to
     // LEDGER_PROTOCOL_VERSION. Used in the following scenarios: 1. to specify
     // the genesis ledger version (only when USE_CONFIG_FOR_GENESIS is true) 2.
@@ -512,6 +673,16 @@ class Config : public std::enable_shared_from_this<Config>
     unsigned short HTTP_PORT; // what port to listen for commands
     bool PUBLIC_HTTP_PORT;    // if you accept commands from not localhost
     int HTTP_MAX_CLIENT;      // maximum number of http clients, i.e backlog
+    // Threads rendering the replies of read-only commands, 0 to render them
+    // on the main thread
+    int HTTP_COMMAND_THREAD_POOL_SIZE;
+
+    // Port of the QueryServer, 0 for none, and its limits
+    unsigned short HTTP_QUERY_PORT;
+    int QUERY_THREAD_POOL_SIZE;
+    uint32_t QUERY_MAX_KEYS_PER_REQUEST;
+    // 0 for no limit
+    uint32_t QUERY_MAX_KEYS_PER_SECOND;
     std::string NETWORK_PASSPHRASE; // identifier for the network
 
     // overlay config
@@ -521,11 +692,26 @@ class Config : public std::enable_shared_from_this<Config>
     int MAX_ADDITIONAL_PEER_CONNECTIONS;
     unsigned short MAX_INBOUND_PENDING_CONNECTIONS;
     unsigned short MAX_OUTBOUND_PENDING_CONNECTIONS;
+    // Maximum rate at which inbound connections are accepted, in connections
+    // per second; 0 means unlimited
+    unsigned short MAX_INBOUND_CONNECTIONS_PER_SECOND;
     unsigned short PEER_AUTHENTICATION_TIMEOUT;
     unsigned short PEER_TIMEOUT;
     unsigned short PEER_STRAGGLER_TIMEOUT;
+    // How long changes to the peer table may stay in memory before being
+    // written to the database; 0 writes them right away
+    std::chrono::seconds PEER_TABLE_FLUSH_PERIOD_SECONDS;
     int MAX_BATCH_WRITE_COUNT;
     int MAX_BATCH_WRITE_BYTES;
+    // How long transaction flooding traffic may wait in a peer's write queue
+    // for more messages to batch into the same write; 0 disables the delay
+    std::chrono::milliseconds MAX_BATCH_WRITE_DELAY_MS;
+    // zstd level used to compress large transaction and transaction set
+    // messages for peers that support it; 0 disables compression
+    int OVERLAY_COMPRESSION_LEVEL;
+    // Time decoding, verifying, handling and sending of each overlay message
+    // type separately (overlay.cpu.* metrics)
+    bool ENABLE_OVERLAY_MESSAGE_TYPE_TIMING;
     double FLOOD_OP_RATE_PER_LEDGER;
     int FLOOD_TX_PERIOD_MS;
     double FLOOD_SOROBAN_RATE_PER_LEDGER;
@@ -536,6 +722,11 @@ class Config : public std::enable_shared_from_this<Config>
     std::chrono::milliseconds FLOOD_DEMAND_PERIOD_MS;
     std::chrono::milliseconds FLOOD_ADVERT_PERIOD_MS;
     std::chrono::milliseconds FLOOD_DEMAND_BACKOFF_DELAY_MS;
+    // Number of peers asked at once for a missing tx set or quorum set
+    uint32_t FETCH_PARALLEL_PEERS;
+    // How often the lowest scoring outbound peer is considered for
+    // replacement; 0 disables peer scoring
+    std::chrono::seconds OUTBOUND_PEER_ROTATION_PERIOD_SECONDS;
     static constexpr size_t const POSSIBLY_PREFERRED_EXTRA = 2;
     static constexpr size_t const REALLY_DEAD_NUM_FAILURES_CUTOFF = 120;
 
@@ -555,9 +746,33 @@ class Config : public std::enable_shared_from_this<Config>
     // thread-management config
     int WORKER_THREADS;
 
+    // CPUs each role of thread is restricted to; empty leaves them unpinned.
+    // Workers cover the background executor and the worker io_context.
+    std::vector<uint32_t> MAIN_THREAD_CPUS;
+    std::vector<uint32_t> OVERLAY_THREAD_CPUS;
+    std::vector<uint32_t> EVICTION_THREAD_CPUS;
+    std::vector<uint32_t> META_THREAD_CPUS;
+    std::vector<uint32_t> WORKER_THREAD_CPUS;
+
+    // Either "local", where threads allocate from the NUMA node they run on,
+    // or "interleave", where allocations are spread over all nodes
+    std::string NUMA_MEMORY_POLICY;
+
     // process-management config
     size_t MAX_CONCURRENT_SUBPROCESSES;
 
+    // Start subprocesses from a long-lived helper process, which also reaps
+    // them, instead of from this process. POSIX only.
+    bool USE_PROCESS_SPAWNER;
+
+    // Upper bound on the adaptive number of concurrent downloads from each
+    // history archive; 0 means MAX_CONCURRENT_SUBPROCESSES
+    size_t MAX_CONCURRENT_DOWNLOADS_PER_ARCHIVE;
+
+    // Number of queued checkpoints published at the same time; uploads of
+    // each still wait for the previous checkpoint to be published
+    size_t MAX_CONCURRENT_CHECKPOINT_PUBLISHES;
+
     // SCP config
     SecretKey NODE_SEED;
     bool NODE_IS_VALIDATOR;
@@ -568,9 +783,19 @@ class Config : public std::enable_shared_from_this<Config>
     // Whether to run online quorum intersection checks.
     bool QUORUM_INTERSECTION_CHECKER;
 
+    // Number of threads a quorum intersection check uses to search for
+    // disjoint quorums.
+    int QUORUM_INTERSECTION_CHECKER_THREADS;
+
     // Invariants
     std::vector<std::string> INVARIANT_CHECKS;
 
+    // Whether operation invariants are checked on a background thread rather
+    // than during apply, and whether a failure found that way still halts.
+    bool INVARIANT_CHECKS_ASYNC;
+    bool INVARIANT_CHECKS_ASYNC_HALT;
+    std::map<std::string, InvariantSamplingConfiguration> INVARIANT_SAMPLING;
+
     std::map<std::string, std::string> VALIDATOR_NAMES;
 
     // History config
@@ -579,6 +804,34 @@ class Config : public std::enable_shared_from_this<Config>
     // Database config
     SecretValue DATABASE;
 
+    // Number of connections of the pool worker threads read the database
+    // through; 0 for one per hardware thread.
+    uint32_t DATABASE_POOL_SIZE;
+
+    // SQLite page cache size of each connection, in KiB, and size of the
+    // database file mapped in memory, in MiB
+    uint32_t SQLITE_CACHE_SIZE_KB;
+    uint32_t SQLITE_MMAP_SIZE_MB;
+
+    // When set to true with an on-disk SQLite database, commits never
+    // checkpoint the WAL. Instead, a passive checkpoint runs on a connection
+    // of its own, on a background thread, after every ledger close.
+    bool SQLITE_MANAGED_CHECKPOINTS;
+
+    // When set to true, every prepared statement gets its own latency timer
+    // and row count histogram, named after its verb, table and a hash of its
+    // text. The mapping to the full query is logged when the metrics are
+    // created.
+    bool SQL_STATEMENT_METRICS;
+
+    // Prepared statements slower than this are logged along with their query
+    // plan, where the database can provide one. 0 disables this.
+    std::chrono::milliseconds SQL_SLOW_STATEMENT_EXPLAIN_MS;
+
+    // Operations that take longer than this to apply are logged along with
+    // their type, index and transaction. 0 disables this.
+    std::chrono::milliseconds LOG_SLOW_OPERATION_APPLY_MS;
+
     std::vector<std::string> COMMANDS;
     std::vector<std::string> REPORT_METRICS;
 
@@ -593,6 +846,48 @@ class Config : public std::enable_shared_from_this<Config>
     // the entry cache
     size_t PREFETCH_BATCH_SIZE;
 
+    // Maximum number of signature verification results cached, process-wide,
+    // so that signatures seen again (i.e. flooded transactions re-checked on
+    // apply) are not verified twice. Process-wide like the cache; the last
+    // application started sets it.
+    size_t SIGNATURE_CACHE_SIZE;
+
+    // Resident memory, in megabytes, the node tries to stay under. When it
+    // gets close, the BucketListDB entry cache, the signature cache and the
+    // entry cache are shrunk in that order, and grown back to their
+    // configured sizes once memory drops. If set to 0, caches keep their
+    // configured sizes.
+    size_t MEMORY_LIMIT_MB;
+
+    // When set to true, the SQL parameters for each entry type written when
+    // committing a ledger are encoded concurrently on background threads.
+    // The statements themselves still run one after another on the main
+    // database session, inside the ledger's SQL transaction.
+    bool PARALLEL_LEDGER_COMMIT_ENCODING;
+
+    // When set to true, LedgerTxnRoot keeps every offer in an in-memory order
+    // book, loaded from the database on first use and updated on every
+    // commit, and answers best offer and offers-by-account queries from it
+    // instead of SQL.
+    bool IN_MEMORY_ORDER_BOOK;
+
+    // When set to true (together with IN_MEMORY_ORDER_BOOK), every answer from
+    // the in-memory order book is checked against SQL, and stellar-core aborts
+    // on a mismatch. This is very slow and only meant for validation.
+    bool IN_MEMORY_ORDER_BOOK_CHECKS;
+
+    // When set to true with BucketListDB, offers are no longer stored in SQL.
+    // LedgerTxnRoot keeps them in the in-memory order book only, which is
+    // loaded from the BucketList on first use, and serves every offer load
+    // from it. Implies IN_MEMORY_ORDER_BOOK. Has no effect with
+    // DEPRECATED_SQL_LEDGER_STATE. The offers table is dropped, and rebuilt
+    // from the BucketList on the first start without this option.
+    bool IN_MEMORY_OFFERS;
+
+    // When set to true, every Soroban resource fee computed natively is also
+    // computed by the Soroban host, and stellar-core aborts if they differ.
+    bool SOROBAN_FEE_PARITY_CHECKS;
+
     // If set to true, the application will halt when an internal error is
     // encountered during applying a transaction. Otherwise, the
     // txINTERNAL_ERROR transaction is created but not applied.
@@ -673,6 +968,7 @@ class Config : public std::enable_shared_from_this<Config>
     bool isInMemoryModeWithoutMinimalDB() const;
     bool isUsingBucketListDB() const;
     bool isPersistingBucketListDBIndexes() const;
+    bool isUsingInMemoryOffers() const;
     bool modeStoresAllHistory() const;
     bool modeStoresAnyHistory() const;
     void logBasicInfo();
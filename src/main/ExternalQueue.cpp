@@ -9,7 +9,7 @@
 #include "ledger/LedgerManager.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <limits>
 #include <regex>
 
@@ -161,6 +161,14 @@ ExternalQueue::deleteCursor(std::string const& resid)
 
 void
 ExternalQueue::deleteOldEntries(uint32 count)
+{
+    ZoneScoped;
+    mApp.getLedgerManager().deleteOldEntries(mApp.getDatabase(),
+                                             getMaxLedgerToDelete(), count);
+}
+
+uint32
+ExternalQueue::getMaxLedgerToDelete()
 {
     ZoneScoped;
     auto& db = mApp.getDatabase();
@@ -203,8 +211,7 @@ ExternalQueue::deleteOldEntries(uint32 count)
     CLOG_INFO(History,
               "Trimming history <= ledger {} (rmin={}, qmin={}, lmin={})", cmin,
               rmin, qmin, lmin);
-
-    mApp.getLedgerManager().deleteOldEntries(mApp.getDatabase(), cmin, count);
+    return cmin;
 }
 
 void
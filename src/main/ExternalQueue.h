@@ -36,6 +36,10 @@ class ExternalQueue
     // safely delete data, maximum count entries from each table
     void deleteOldEntries(uint32 count);
 
+    // the last ledger whose data deleteOldEntries may delete, as needed
+    // neither by subscribers nor by checkpoints left to publish
+    uint32 getMaxLedgerToDelete();
+
   private:
     void checkID(std::string const& resid);
     std::string getCursor(std::string const& resid);
@@ -3,6 +3,9 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "main/Maintainer.h"
+#include "database/Database.h"
+#include "ledger/LedgerHeaderUtils.h"
+#include "ledger/LedgerManager.h"
 #include "main/Config.h"
 #include "main/ExternalQueue.h"
 #include "util/GlobalChecks.h"
@@ -10,13 +13,33 @@
 #include "util/Logging.h"
 #include "util/numeric.h"
 
-#include <Tracy.hpp>
+#include "medida/counter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+#include "util/Tracing.h"
+#include <algorithm>
 #include <fmt/format.h>
 
 namespace stellar
 {
 
-Maintainer::Maintainer(Application& app) : mApp{app}, mTimer{mApp}
+namespace
+{
+// Bounds of the number of ledgers deleted per chunk with
+// AUTOMATIC_MAINTENANCE_TIME_BUDGET
+uint32_t const MIN_CHUNK_SIZE = 1;
+uint32_t const MAX_CHUNK_SIZE = 100000;
+}
+
+Maintainer::Maintainer(Application& app)
+    : mApp{app}
+    , mTimer{mApp}
+    , mChunkSize{std::clamp(app.getConfig().AUTOMATIC_MAINTENANCE_COUNT,
+                            MIN_CHUNK_SIZE, MAX_CHUNK_SIZE)}
+    , mChunkTimer{app.getMetrics().NewTimer(
+          {"history", "maintenance", "chunk"})}
+    , mBacklog{app.getMetrics().NewCounter(
+          {"history", "maintenance", "backlog"})}
 {
 }
 
@@ -58,10 +81,102 @@ void
 Maintainer::tick()
 {
     ZoneScoped;
+    if (mApp.getConfig().AUTOMATIC_MAINTENANCE_TIME_BUDGET.count() > 0)
+    {
+        // Schedules the next run once done
+        performBudgetedMaintenance();
+        return;
+    }
     performMaintenance(mApp.getConfig().AUTOMATIC_MAINTENANCE_COUNT);
     scheduleMaintenance();
 }
 
+uint32_t
+Maintainer::deleteWithinBudget(
+    soci::session& sess, uint32_t maxLedger,
+    std::function<void(uint32_t count)> const& deleteChunk)
+{
+    ZoneScoped;
+    auto const budget = mApp.getConfig().AUTOMATIC_MAINTENANCE_TIME_BUDGET;
+    // Chunks that take about a quarter of the budget leave room for a few of
+    // them per run without overshooting the budget by much
+    auto const target = std::max<std::chrono::nanoseconds>(
+        budget / 4, std::chrono::milliseconds{1});
+    auto backlog = [&]() -> uint32_t {
+        auto oldest = LedgerHeaderUtils::getOldestLedgerSeq(sess);
+        return oldest != 0 && oldest <= maxLedger ? maxLedger - oldest + 1
+                                                  : 0;
+    };
+
+    auto const start = std::chrono::steady_clock::now();
+    uint32_t left = backlog();
+    while (left != 0 && std::chrono::steady_clock::now() - start < budget)
+    {
+        auto chunkStart = std::chrono::steady_clock::now();
+        deleteChunk(mChunkSize);
+        auto elapsed = std::chrono::steady_clock::now() - chunkStart;
+        mChunkTimer.Update(elapsed);
+        if (elapsed < target / 2)
+        {
+            mChunkSize = std::min(mChunkSize * 2, MAX_CHUNK_SIZE);
+        }
+        else if (elapsed > target)
+        {
+            mChunkSize = std::max(mChunkSize / 2, MIN_CHUNK_SIZE);
+        }
+        left = backlog();
+    }
+    return left;
+}
+
+void
+Maintainer::performBudgetedMaintenance()
+{
+    ZoneScoped;
+    auto maxLedger = ExternalQueue{mApp}.getMaxLedgerToDelete();
+    auto& db = mApp.getDatabase();
+    auto& lm = mApp.getLedgerManager();
+
+    // SQLite only has one writer at a time, so deletes on another connection
+    // would hold up ledger close all the same
+    if (db.isSqlite() || !db.canUsePool())
+    {
+        auto left = deleteWithinBudget(
+            db.getSession(), maxLedger, [&](uint32_t count) {
+                lm.deleteOldEntries(db, maxLedger, count);
+            });
+        mBacklog.set_count(left);
+        scheduleMaintenance();
+        return;
+    }
+
+    mApp.postOnBackgroundThread(
+        [this, maxLedger]() {
+            uint32_t left = 0;
+            try
+            {
+                PooledSession session(mApp.getDatabase());
+                left = deleteWithinBudget(
+                    session.session(), maxLedger, [&](uint32_t count) {
+                        mApp.getLedgerManager().deleteOldEntries(
+                            session.session(), maxLedger, count);
+                    });
+            }
+            catch (std::exception& e)
+            {
+                CLOG_WARNING(History, "Failed to perform maintenance: {}",
+                             e.what());
+            }
+            mApp.postOnMainThread(
+                [this, left]() {
+                    mBacklog.set_count(left);
+                    scheduleMaintenance();
+                },
+                "Maintainer: maintenance done");
+        },
+        "Maintainer: delete old entries");
+}
+
 void
 Maintainer::performMaintenance(uint32_t count)
 {
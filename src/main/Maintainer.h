@@ -7,6 +7,18 @@
 #include "util/Timer.h"
 
 #include <cstdint>
+#include <functional>
+
+namespace medida
+{
+class Counter;
+class Timer;
+}
+
+namespace soci
+{
+class session;
+}
 
 namespace stellar
 {
@@ -28,7 +40,22 @@ class Maintainer
     Application& mApp;
     VirtualTimer mTimer;
 
+    // Number of ledgers deleted per chunk with
+    // AUTOMATIC_MAINTENANCE_TIME_BUDGET, resized after each chunk
+    uint32_t mChunkSize;
+    medida::Timer& mChunkTimer;
+    medida::Counter& mBacklog;
+
     void scheduleMaintenance();
     void tick();
+
+    // Deletes the history of ledgers up to maxLedger in chunks, through
+    // deleteChunk, until it is gone or AUTOMATIC_MAINTENANCE_TIME_BUDGET is
+    // spent, and returns the number of ledgers left. Reads the oldest ledger
+    // left through sess. Runs on any thread, but only one at a time.
+    uint32_t
+    deleteWithinBudget(soci::session& sess, uint32_t maxLedger,
+                       std::function<void(uint32_t count)> const& deleteChunk);
+    void performBudgetedMaintenance();
 };
 }
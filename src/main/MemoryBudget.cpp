@@ -0,0 +1,154 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "main/MemoryBudget.h"
+#include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
+#include "crypto/SecretKey.h"
+#include "ledger/LedgerTxn.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/SamplingProfiler.h"
+#include "util/Tracing.h"
+
+#include <algorithm>
+#include <medida/counter.h>
+#include <medida/metrics_registry.h>
+
+namespace stellar
+{
+
+std::chrono::seconds const MemoryBudget::CHECK_PERIOD(5);
+
+MemoryBudget::MemoryBudget(Application& app)
+    : mApp(app)
+    , mLimitBytes(static_cast<uint64_t>(app.getConfig().MEMORY_LIMIT_MB) *
+                  1024 * 1024)
+    , mTimer(app)
+    , mLevelCounter(app.getMetrics().NewCounter({"memory", "budget", "level"}))
+{
+    auto const& cfg = app.getConfig();
+    // BucketListDB lookups that miss this cache mostly hit the OS page cache
+    if (cfg.isUsingBucketListDB() && cfg.BUCKETLIST_DB_CACHED_ENTRIES != 0)
+    {
+        mCaches.emplace_back(ManagedCache{
+            "bucketlistdb-cache", cfg.BUCKETLIST_DB_CACHED_ENTRIES,
+            [this](size_t size) {
+                mApp.getBucketManager()
+                    .getBucketSnapshotManager()
+                    .setEntryCacheSize(size);
+            },
+            cfg.BUCKETLIST_DB_CACHED_ENTRIES});
+    }
+    // Misses cost a signature verification
+    mCaches.emplace_back(ManagedCache{
+        "verify-sig-cache", cfg.SIGNATURE_CACHE_SIZE,
+        [](size_t size) { PubKeyUtils::setVerifySigCacheSize(size); },
+        cfg.SIGNATURE_CACHE_SIZE});
+    // Misses are loads on the ledger close path
+    if (!cfg.MODE_USES_IN_MEMORY_LEDGER)
+    {
+        mCaches.emplace_back(ManagedCache{
+            "entry-cache", cfg.ENTRY_CACHE_SIZE,
+            [this](size_t size) {
+                if (auto root = dynamic_cast<LedgerTxnRoot*>(
+                        &mApp.getLedgerTxnRoot()))
+                {
+                    root->setEntryCacheSize(size);
+                }
+            },
+            cfg.ENTRY_CACHE_SIZE});
+    }
+}
+
+void
+MemoryBudget::start()
+{
+    if (mLimitBytes != 0)
+    {
+        scheduleCheck();
+    }
+}
+
+void
+MemoryBudget::scheduleCheck()
+{
+    mTimer.expires_from_now(CHECK_PERIOD);
+    mTimer.async_wait([this]() { tick(); }, VirtualTimer::onFailureNoop);
+}
+
+void
+MemoryBudget::tick()
+{
+    ZoneScoped;
+    if (auto resident = SamplingProfiler::memoryUsage().mResidentBytes)
+    {
+        update(*resident);
+        scheduleCheck();
+    }
+    else
+    {
+        LOG_WARNING(DEFAULT_LOG, "Can't read resident memory on this "
+                                 "platform, ignoring MEMORY_LIMIT_MB");
+    }
+}
+
+void
+MemoryBudget::update(uint64_t residentBytes)
+{
+    releaseAssert(threadIsMain());
+    auto level = mLevel;
+    if (residentBytes > mLimitBytes * SHRINK_THRESHOLD &&
+        mLevel < getMaxLevel())
+    {
+        ++mLevel;
+    }
+    else if (residentBytes < mLimitBytes * GROW_THRESHOLD && mLevel > 0)
+    {
+        --mLevel;
+    }
+    if (mLevel == level)
+    {
+        return;
+    }
+
+    LOG_INFO(DEFAULT_LOG,
+             "Resident memory {} MB of {} MB limit: {} caches to level {}",
+             residentBytes / (1024 * 1024), mLimitBytes / (1024 * 1024),
+             mLevel > level ? "shrinking" : "growing", mLevel);
+    resizeCaches();
+    mLevelCounter.set_count(mLevel);
+}
+
+void
+MemoryBudget::resizeCaches()
+{
+    for (size_t i = 0; i < mCaches.size(); ++i)
+    {
+        auto& cache = mCaches[i];
+        // Cache i takes halvings i * MAX_HALVINGS + 1 to (i + 1) * MAX_HALVINGS
+        auto first = static_cast<uint32_t>(i) * MAX_HALVINGS;
+        uint32_t halvings =
+            mLevel > first ? std::min(mLevel - first, MAX_HALVINGS) : 0;
+        auto size = std::max<size_t>(1, cache.mConfiguredSize >> halvings);
+        if (size != cache.mSize)
+        {
+            cache.mResize(size);
+            cache.mSize = size;
+        }
+    }
+}
+
+size_t
+MemoryBudget::getCacheSize(std::string const& name) const
+{
+    auto it = std::find_if(
+        mCaches.begin(), mCaches.end(),
+        [&](ManagedCache const& cache) { return cache.mName == name; });
+    releaseAssert(it != mCaches.end());
+    return it->mSize;
+}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/Timer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace medida
+{
+class Counter;
+}
+
+namespace stellar
+{
+
+class Application;
+
+// Keeps the resident memory of the process under MEMORY_LIMIT_MB by shrinking
+// caches when it gets close to the limit, and growing them back once memory
+// drops. Caches are ranked from the cheapest to lose to the most expensive
+// (BucketListDB entry cache, signature cache, entry cache). Each check under
+// pressure halves one cache, the cheapest one that can still shrink, down to
+// 1/2^MAX_HALVINGS of its configured size; each check without pressure undoes
+// the last halving. The total number of halvings in effect is the level.
+class MemoryBudget
+{
+  public:
+    // Shares of the limit above which caches shrink, and below which they
+    // grow back. The gap keeps the level from flapping.
+    static constexpr double SHRINK_THRESHOLD = 0.9;
+    static constexpr double GROW_THRESHOLD = 0.75;
+    static constexpr uint32_t MAX_HALVINGS = 3;
+    static std::chrono::seconds const CHECK_PERIOD;
+
+    explicit MemoryBudget(Application& app);
+
+    // Starts periodic checks if MEMORY_LIMIT_MB is set
+    void start();
+
+    // Moves the level one step according to residentBytes and resizes the
+    // caches accordingly
+    void update(uint64_t residentBytes);
+
+    uint32_t
+    getLevel() const
+    {
+        return mLevel;
+    }
+
+    uint32_t
+    getMaxLevel() const
+    {
+        return static_cast<uint32_t>(mCaches.size()) * MAX_HALVINGS;
+    }
+
+    // Current size of the cache `name`, as set by the budget
+    size_t getCacheSize(std::string const& name) const;
+
+  private:
+    struct ManagedCache
+    {
+        std::string mName;
+        size_t mConfiguredSize;
+        std::function<void(size_t)> mResize;
+        size_t mSize;
+    };
+
+    Application& mApp;
+    uint64_t const mLimitBytes;
+    VirtualTimer mTimer;
+    // Cheapest to shrink first
+    std::vector<ManagedCache> mCaches;
+    uint32_t mLevel{0};
+    medida::Counter& mLevelCounter;
+
+    void scheduleCheck();
+    void tick();
+    void resizeCaches();
+};
+}
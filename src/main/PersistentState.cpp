@@ -11,7 +11,7 @@
 #include "ledger/LedgerManager.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
@@ -22,7 +22,7 @@ std::string PersistentState::mapping[kLastEntry] = {
     "lastclosedledger", "historyarchivestate", "lastscpdata",
     "databaseschema",   "networkpassphrase",   "ledgerupgrades",
     "rebuildledger",    "lastscpdataxdr",      "txset",
-    "dbbackend"};
+    "dbbackend",        "bucketapplyprogress", "transactionqueue"};
 
 std::string PersistentState::kSQLCreateStatement =
     "CREATE TABLE IF NOT EXISTS storestate ("
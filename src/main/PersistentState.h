@@ -29,6 +29,8 @@ class PersistentState
         kLastSCPDataXDR,
         kTxSet,
         kDBBackend,
+        kBucketApplyProgress,
+        kTransactionQueue,
         kLastEntry,
     };
 
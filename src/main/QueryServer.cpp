@@ -0,0 +1,347 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "main/QueryServer.h"
+#include "bucket/BucketListSnapshot.h"
+#include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
+#include "bucket/LedgerCmp.h"
+#include "lib/json/json.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/Decoder.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/SpanRecorder.h"
+#include "util/Tracing.h"
+#include "util/types.h"
+#include "xdrpp/marshal.h"
+#include <fmt/format.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+
+namespace stellar
+{
+
+QueryServer::QueryServer(Application& app)
+    : mSnapshotManager(app.getBucketManager().getBucketSnapshotManager())
+    , mMaxKeysPerRequest(app.getConfig().QUERY_MAX_KEYS_PER_REQUEST)
+    , mMaxKeysPerSecond(app.getConfig().QUERY_MAX_KEYS_PER_SECOND)
+    , mLatency(app.getMetrics().NewTimer(
+          {"query", "getledgerentry", "latency"}))
+    , mKeys(app.getMetrics().NewMeter({"query", "getledgerentry", "keys"},
+                                      "key"))
+    , mRateLimited(app.getMetrics().NewMeter(
+          {"query", "getledgerentry", "rate-limited"}, "request"))
+    , mKeyTokens(mMaxKeysPerSecond)
+    , mLastRefill(std::chrono::steady_clock::now())
+{
+    releaseAssert(threadIsMain());
+    releaseAssert(app.getConfig().isUsingBucketListDB());
+
+    auto const& cfg = app.getConfig();
+    if (cfg.HTTP_QUERY_PORT == 0)
+    {
+        mServer = std::make_unique<http::server::server>(mIOContext);
+    }
+    else
+    {
+        std::string ipStr = cfg.PUBLIC_HTTP_PORT ? "0.0.0.0" : "127.0.0.1";
+        LOG_INFO(DEFAULT_LOG, "Listening on {}:{} for HTTP queries", ipStr,
+                 cfg.HTTP_QUERY_PORT);
+        mServer = std::make_unique<http::server::server>(
+            mIOContext, ipStr, cfg.HTTP_QUERY_PORT, cfg.HTTP_MAX_CLIENT);
+    }
+
+    mServer->add404([](std::string const&, std::string& retStr) {
+        retStr = "Unknown query. Supported: getledgerentry, getcontractdata, "
+                 "gettrustlines";
+    });
+    addRoute("getledgerentry", &QueryServer::getLedgerEntry);
+    addRoute("getcontractdata", &QueryServer::getContractData);
+    addRoute("gettrustlines", &QueryServer::getTrustlines);
+
+    if (cfg.HTTP_QUERY_PORT != 0)
+    {
+        for (int i = 0; i < cfg.QUERY_THREAD_POOL_SIZE; ++i)
+        {
+            mThreads.emplace_back([this, i]() {
+                SpanRecorder::setThreadName(
+                    fmt::format(FMT_STRING("query-{}"), i));
+                mIOContext.run();
+            });
+        }
+    }
+}
+
+QueryServer::~QueryServer()
+{
+    // Connections are closed once no thread can be serving them
+    mIOContext.stop();
+    for (auto& t : mThreads)
+    {
+        t.join();
+    }
+    mServer.reset();
+}
+
+void
+QueryServer::addRoute(std::string const& name, HandlerRoute route)
+{
+    mServer->addRoute(name, [this, route](std::string const& params,
+                                          std::string& retStr) {
+        try
+        {
+            ZoneNamedN(queryZone, "HTTP query handler", true);
+            (this->*route)(params, retStr);
+        }
+        catch (std::exception const& e)
+        {
+            retStr =
+                fmt::format(FMT_STRING(R"({{"exception": "{}"}})"), e.what());
+        }
+        catch (...)
+        {
+            retStr = R"({"exception": "generic"})";
+        }
+    });
+}
+
+bool
+QueryServer::takeKeyTokens(size_t keys)
+{
+    if (mMaxKeysPerSecond == 0)
+    {
+        return true;
+    }
+    std::lock_guard<std::mutex> guard(mRateMutex);
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - mLastRefill;
+    mLastRefill = now;
+    // Allows bursts of up to a second's worth of keys
+    mKeyTokens = std::min<double>(
+        mMaxKeysPerSecond, mKeyTokens + elapsed.count() * mMaxKeysPerSecond);
+    if (mKeyTokens < keys)
+    {
+        return false;
+    }
+    mKeyTokens -= keys;
+    return true;
+}
+
+std::shared_ptr<SearchableBucketListSnapshot>
+QueryServer::takeSnapshot()
+{
+    {
+        std::lock_guard<std::mutex> guard(mSnapshotsMutex);
+        if (!mSnapshots.empty())
+        {
+            auto snapshot = std::move(mSnapshots.back());
+            mSnapshots.pop_back();
+            return snapshot;
+        }
+    }
+    return mSnapshotManager.getSearchableBucketListSnapshot();
+}
+
+void
+QueryServer::returnSnapshot(
+    std::shared_ptr<SearchableBucketListSnapshot> snapshot)
+{
+    std::lock_guard<std::mutex> guard(mSnapshotsMutex);
+    mSnapshots.emplace_back(std::move(snapshot));
+}
+
+void
+QueryServer::getLedgerEntry(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    auto timer = mLatency.TimeScope();
+
+    std::map<std::string, std::string> paramMap;
+    http::server::server::parseParams(params, paramMap);
+    auto keysParam = paramMap["keys"];
+    if (keysParam.empty())
+    {
+        throw std::invalid_argument(
+            "Must specify ledger keys: getledgerentry?keys=<LedgerKey in "
+            "base64 XDR format>,...");
+    }
+    // Clients may not have URL-encoded the '+' of base64, which decodes as a
+    // space; base64 has no spaces of its own
+    std::replace(keysParam.begin(), keysParam.end(), ' ', '+');
+
+    std::optional<uint32_t> ledgerSeqParam;
+    if (auto it = paramMap.find("ledgerSeq"); it != paramMap.end())
+    {
+        std::stringstream str(it->second);
+        uint32_t seq;
+        str >> seq;
+        if (str.fail() || !str.eof())
+        {
+            throw std::invalid_argument("Failed to parse 'ledgerSeq' argument");
+        }
+        ledgerSeqParam = seq;
+    }
+
+    std::vector<LedgerKey> keys;
+    size_t start = 0;
+    while (start <= keysParam.size())
+    {
+        auto end = std::min(keysParam.find(',', start), keysParam.size());
+        if (keys.size() == mMaxKeysPerRequest)
+        {
+            throw std::invalid_argument(fmt::format(
+                FMT_STRING("At most {} keys can be queried at once"),
+                mMaxKeysPerRequest));
+        }
+        std::vector<uint8_t> opaque;
+        decoder::decode_b64(keysParam.substr(start, end - start), opaque);
+        xdr::xdr_from_opaque(opaque, keys.emplace_back());
+        start = end + 1;
+    }
+
+    if (!takeKeyTokens(keys.size()))
+    {
+        mRateLimited.Mark();
+        throw std::runtime_error("Too many keys queried, retry later");
+    }
+    mKeys.Mark(keys.size());
+
+    auto snapshot = takeSnapshot();
+    std::set<LedgerKey, LedgerEntryIdCmp> keySet(keys.begin(), keys.end());
+    std::optional<std::vector<LedgerEntry>> entries;
+    uint32_t ledgerSeq = 0;
+    if (ledgerSeqParam)
+    {
+        ledgerSeq = *ledgerSeqParam;
+        entries = snapshot->loadKeysFromLedger(keySet, ledgerSeq);
+    }
+    else
+    {
+        entries = snapshot->loadKeys(keySet);
+        ledgerSeq = snapshot->getLedgerSeq();
+    }
+    returnSnapshot(std::move(snapshot));
+    if (!entries)
+    {
+        throw std::invalid_argument(fmt::format(
+            FMT_STRING("Ledger {} is not retained, see "
+                       "BUCKETLIST_DB_RETAINED_SNAPSHOTS"),
+            ledgerSeq));
+    }
+
+    std::map<LedgerKey, LedgerEntry const*, LedgerEntryIdCmp> found;
+    for (auto const& le : *entries)
+    {
+        found.emplace(LedgerEntryKey(le), &le);
+    }
+
+    Json::Value root;
+    root["ledger"] = ledgerSeq;
+    auto& results = root["entries"];
+    results = Json::arrayValue;
+    for (auto const& k : keys)
+    {
+        Json::Value res;
+        res["key"] = decoder::encode_b64(xdr::xdr_to_opaque(k));
+        auto it = found.find(k);
+        if (it != found.end())
+        {
+            res["state"] = "live";
+            res["entry"] = decoder::encode_b64(xdr::xdr_to_opaque(*it->second));
+        }
+        else
+        {
+            res["state"] = "dead";
+        }
+        results.append(res);
+    }
+    retStr = Json::FastWriter().write(root);
+}
+
+template <typename T>
+void
+QueryServer::scanEntries(
+    std::string const& params, std::string const& name,
+    std::function<std::vector<LedgerEntry>(SearchableBucketListSnapshot&,
+                                           T const&, bool&)> const& load,
+    std::string& retStr)
+{
+    std::map<std::string, std::string> paramMap;
+    http::server::server::parseParams(params, paramMap);
+    auto param = paramMap[name];
+    if (param.empty())
+    {
+        throw std::invalid_argument(
+            fmt::format(FMT_STRING("Must specify '{}' in base64 XDR format"),
+                        name));
+    }
+    // As for getledgerentry, '+' may have been decoded as a space
+    std::replace(param.begin(), param.end(), ' ', '+');
+    std::vector<uint8_t> opaque;
+    decoder::decode_b64(param, opaque);
+    T value;
+    xdr::xdr_from_opaque(opaque, value);
+
+    if (!takeKeyTokens(1))
+    {
+        mRateLimited.Mark();
+        throw std::runtime_error("Too many keys queried, retry later");
+    }
+
+    auto snapshot = takeSnapshot();
+    bool truncated = false;
+    auto entries = load(*snapshot, value, truncated);
+    uint32_t ledgerSeq = snapshot->getLedgerSeq();
+    returnSnapshot(std::move(snapshot));
+    mKeys.Mark(entries.size());
+
+    Json::Value root;
+    root["ledger"] = ledgerSeq;
+    root["truncated"] = truncated;
+    auto& results = root["entries"];
+    results = Json::arrayValue;
+    for (auto const& le : entries)
+    {
+        results.append(decoder::encode_b64(xdr::xdr_to_opaque(le)));
+    }
+    retStr = Json::FastWriter().write(root);
+}
+
+void
+QueryServer::getContractData(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    scanEntries<SCAddress>(
+        params, "contract",
+        [this](SearchableBucketListSnapshot& snapshot,
+               SCAddress const& contract, bool& truncated) {
+            return snapshot.loadContractData(contract, mMaxKeysPerRequest,
+                                             truncated);
+        },
+        retStr);
+}
+
+void
+QueryServer::getTrustlines(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    scanEntries<TrustLineAsset>(
+        params, "asset",
+        [this](SearchableBucketListSnapshot& snapshot,
+               TrustLineAsset const& asset, bool& truncated) {
+            return snapshot.loadTrustlinesByAsset(asset, mMaxKeysPerRequest,
+                                                  truncated);
+        },
+        retStr);
+}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/asio.h"
+#include "lib/http/server.hpp"
+#include "util/NonCopyable.h"
+#include "xdr/Stellar-ledger-entries.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+class Timer;
+}
+
+namespace stellar
+{
+
+class Application;
+class BucketSnapshotManager;
+class SearchableBucketListSnapshot;
+
+// Answers batched ledger entry lookups on HTTP_QUERY_PORT from a pool of
+// QUERY_THREAD_POOL_SIZE threads of its own, reading BucketListDB snapshots,
+// so that heavy query traffic does not hold up the main thread the way the
+// `getledgerentry` command of CommandHandler does.
+class QueryServer : public NonMovableOrCopyable
+{
+  public:
+    // Does not listen if HTTP_QUERY_PORT is 0, in which case requests can
+    // only be made by calling the handlers directly. Requires BucketListDB.
+    explicit QueryServer(Application& app);
+    ~QueryServer();
+
+    // "getledgerentry?keys=<LedgerKey in base64 XDR>,...[&ledgerSeq=N]"
+    void getLedgerEntry(std::string const& params, std::string& retStr);
+
+    // "getcontractdata?contract=<SCAddress in base64 XDR>"
+    // Returns up to QUERY_MAX_KEYS_PER_REQUEST live contract data entries of
+    // the contract, reading only that contract's range of every bucket.
+    void getContractData(std::string const& params, std::string& retStr);
+
+    // "gettrustlines?asset=<TrustLineAsset in base64 XDR>"
+    // Returns up to QUERY_MAX_KEYS_PER_REQUEST live trustlines of the asset.
+    // Requires BUCKETLIST_DB_INDEX_TRUSTLINES_BY_ASSET.
+    void getTrustlines(std::string const& params, std::string& retStr);
+
+  private:
+    using HandlerRoute =
+        void (QueryServer::*)(std::string const&, std::string&);
+
+    BucketSnapshotManager const& mSnapshotManager;
+    uint32_t const mMaxKeysPerRequest;
+    uint32_t const mMaxKeysPerSecond;
+
+    medida::Timer& mLatency;
+    medida::Meter& mKeys;
+    medida::Meter& mRateLimited;
+
+    // Snapshots not in use by a request; each request takes one, or a new one
+    // if none is left, and gives it back when done
+    std::mutex mSnapshotsMutex;
+    std::vector<std::shared_ptr<SearchableBucketListSnapshot>> mSnapshots;
+
+    // Token bucket of keys, refilled at mMaxKeysPerSecond
+    std::mutex mRateMutex;
+    double mKeyTokens;
+    std::chrono::steady_clock::time_point mLastRefill;
+
+    asio::io_context mIOContext;
+    std::unique_ptr<http::server::server> mServer;
+    std::vector<std::thread> mThreads;
+
+    void addRoute(std::string const& name, HandlerRoute route);
+    bool takeKeyTokens(size_t keys);
+
+    // Takes an unused snapshot, or a new one if there is none, and gives it
+    // back once the request is done with it
+    std::shared_ptr<SearchableBucketListSnapshot> takeSnapshot();
+    void returnSnapshot(std::shared_ptr<SearchableBucketListSnapshot> snapshot);
+
+    // Shared by the routes returning the entries a snapshot scan loads: takes
+    // one key token per request, decodes the XDR parameter `name` and writes
+    // the entries load returns as JSON
+    template <typename T>
+    void scanEntries(std::string const& params, std::string const& name,
+                     std::function<std::vector<LedgerEntry>(
+                         SearchableBucketListSnapshot&, T const&, bool&)> const&
+                         load,
+                     std::string& retStr);
+};
+}
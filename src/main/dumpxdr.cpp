@@ -182,7 +182,8 @@ printOneXdr(xdr::opaque_vec<> const& o, std::string const& desc, bool compact)
 {
     T tmp;
     xdr::xdr_from_opaque(o, tmp);
-    std::cout << xdrToCerealString(tmp, desc, compact) << std::endl;
+    xdrToCerealStream(std::cout, tmp, desc, compact);
+    std::cout << std::endl;
 }
 
 void
@@ -191,8 +192,8 @@ printTransactionMeta(xdr::opaque_vec<> const& o, bool compact)
     TransactionMeta tmp;
     xdr::xdr_from_opaque(o, tmp);
     normalizeMeta(tmp);
-    std::cout << xdrToCerealString(tmp, "TransactionMeta", compact)
-              << std::endl;
+    xdrToCerealStream(std::cout, tmp, "TransactionMeta", compact);
+    std::cout << std::endl;
 }
 
 void
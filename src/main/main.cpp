@@ -26,7 +26,7 @@
 #include <system_error>
 #include <xdrpp/marshal.h>
 #ifdef USE_TRACY
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <TracyC.h>
 #endif
 
@@ -2,11 +2,15 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "herder/Herder.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
+#include "lib/json/json.h"
 #include "main/Application.h"
 #include "main/CommandHandler.h"
+#include "medida/counter.h"
+#include "medida/metrics_registry.h"
 #include "test/TestAccount.h"
 #include "test/TestUtils.h"
 #include "test/TxTests.h"
@@ -543,3 +547,122 @@ TEST_CASE("manualclose", "[commandhandler]")
         }
     }
 }
+
+TEST_CASE("memory", "[commandhandler]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+
+    auto before = app->getMemoryFootprint();
+    REQUIRE(before.count("herder.tx-queue") == 1);
+    REQUIRE(before.count("overlay.floodgate") == 1);
+    REQUIRE(before.count("crypto.verify-sig-cache") == 1);
+
+    auto tx = root.tx({payment(root.getPublicKey(), 1)});
+    REQUIRE(app->getHerder().recvTransaction(tx, false) ==
+            TransactionQueue::AddResult::ADD_STATUS_PENDING);
+    auto after = app->getMemoryFootprint();
+    REQUIRE(after["herder.tx-queue"] >=
+            before["herder.tx-queue"] + xdr::xdr_size(tx->getEnvelope()));
+
+    std::string retStr;
+    app->getCommandHandler().memory("", retStr);
+    Json::Value res;
+    REQUIRE(Json::Reader().parse(retStr, res));
+    uint64_t total = 0;
+    for (auto const& name : res["bytes"].getMemberNames())
+    {
+        total += res["bytes"][name].asUInt64();
+    }
+    REQUIRE(res["bytes"].isMember("herder.tx-queue"));
+    REQUIRE(res["total_bytes"].asUInt64() == total);
+
+    app->syncOwnMetrics();
+    REQUIRE(app->getMetrics()
+                .NewCounter({"memory", "herder", "tx-queue"})
+                .count() > 0);
+}
+
+TEST_CASE("read-only commands render on workers", "[commandhandler]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    SECTION("on the main thread")
+    {
+        cfg.HTTP_COMMAND_THREAD_POOL_SIZE = 0;
+    }
+    SECTION("on workers")
+    {
+        cfg.HTTP_COMMAND_THREAD_POOL_SIZE = 2;
+    }
+    auto app = createTestApplication(clock, cfg);
+    auto& ch = app->getCommandHandler();
+
+    Json::Value info;
+    REQUIRE(Json::Reader().parse(ch.manualCmd("info"), info));
+    REQUIRE(info["info"]["ledger"]["num"].asUInt() ==
+            app->getLedgerManager().getLastClosedLedgerNum());
+
+    Json::Value metrics;
+    REQUIRE(Json::Reader().parse(ch.manualCmd("metrics?enable=ledger"),
+                                 metrics));
+    REQUIRE(metrics["metrics"].isMember("ledger.ledger.close"));
+    for (auto const& name : metrics["metrics"].getMemberNames())
+    {
+        REQUIRE(name.rfind("ledger.", 0) == 0);
+    }
+
+    REQUIRE(ch.manualCmd("prometheus")
+                .find("# TYPE stellar_core_ledger_ledger_close summary") !=
+            std::string::npos);
+}
+
+TEST_CASE("info reports the startup timeline", "[commandhandler]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+
+    Json::Value info;
+    REQUIRE(Json::Reader().parse(app->getCommandHandler().manualCmd("info"),
+                                 info));
+    auto const& startup = info["info"]["startup"];
+    for (auto const& phase : {"database", "ledger", "herder", "publish"})
+    {
+        REQUIRE(startup.isMember(phase));
+    }
+}
+
+TEST_CASE("txbatch", "[commandhandler]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto& ch = app->getCommandHandler();
+    auto root = TestAccount::createRoot(*app);
+    auto minBalance = app->getLedgerManager().getLastMinBalance(2);
+    auto a1 = root.create("a1", minBalance);
+    auto a2 = root.create("a2", minBalance);
+
+    auto blob = [](TransactionFrameBasePtr const& tx) {
+        return decoder::encode_b64(xdr::xdr_to_opaque(tx->getEnvelope()));
+    };
+    auto tx1 = a1.tx({payment(root, 1)});
+    auto tx2 = a2.tx({payment(root, 1)});
+    // Same source account as tx1
+    auto tx3 = a1.tx({payment(root, 2)});
+
+    std::string retStr;
+    ch.txBatch("?blobs=" + blob(tx1) + ",notxdr," + blob(tx2) + "," +
+                   blob(tx3) + "," + blob(tx1),
+               retStr);
+    Json::Value res;
+    REQUIRE(Json::Reader().parse(retStr, res));
+    REQUIRE(res.size() == 5);
+    REQUIRE(res[0]["status"] == "PENDING");
+    REQUIRE(res[1].isMember("exception"));
+    REQUIRE(res[2]["status"] == "PENDING");
+    REQUIRE(res[3]["status"] == "TRY_AGAIN_LATER");
+    REQUIRE(res[4]["status"] == "DUPLICATE");
+
+    REQUIRE_THROWS_AS(ch.txBatch("", retStr), std::invalid_argument);
+}
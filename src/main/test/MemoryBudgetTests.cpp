@@ -0,0 +1,80 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "main/MemoryBudget.h"
+#include "test/TestUtils.h"
+#include "test/test.h"
+#include <medida/counter.h>
+#include <medida/metrics_registry.h>
+
+using namespace stellar;
+
+TEST_CASE("memory budget shrinks and grows caches", "[memorybudget]")
+{
+    VirtualClock clock;
+    Config cfg = getTestConfig();
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.MEMORY_LIMIT_MB = 1000;
+    cfg.BUCKETLIST_DB_CACHED_ENTRIES = 4000;
+    auto app = createTestApplication(clock, cfg);
+    auto& budget = app->getMemoryBudget();
+    auto& level = app->getMetrics().NewCounter({"memory", "budget", "level"});
+
+    uint64_t const mb = 1024 * 1024;
+    uint64_t const over = 950 * mb;
+    uint64_t const between = 800 * mb;
+    uint64_t const under = 500 * mb;
+    REQUIRE(budget.getMaxLevel() == 3 * MemoryBudget::MAX_HALVINGS);
+
+    // Between the thresholds nothing moves
+    budget.update(between);
+    REQUIRE(budget.getLevel() == 0);
+
+    // The cheapest cache is halved all the way before the next one shrinks
+    for (uint32_t i = 1; i <= MemoryBudget::MAX_HALVINGS; ++i)
+    {
+        budget.update(over);
+        REQUIRE(budget.getLevel() == i);
+        REQUIRE(budget.getCacheSize("bucketlistdb-cache") == (4000u >> i));
+        REQUIRE(budget.getCacheSize("verify-sig-cache") ==
+                cfg.SIGNATURE_CACHE_SIZE);
+    }
+    budget.update(over);
+    REQUIRE(budget.getCacheSize("verify-sig-cache") ==
+            cfg.SIGNATURE_CACHE_SIZE / 2);
+    REQUIRE(budget.getCacheSize("entry-cache") == cfg.ENTRY_CACHE_SIZE);
+
+    // Shrinking stops at the floor of every cache
+    for (uint32_t i = 0; i < 2 * budget.getMaxLevel(); ++i)
+    {
+        budget.update(over);
+    }
+    REQUIRE(budget.getLevel() == budget.getMaxLevel());
+    REQUIRE(level.count() == budget.getMaxLevel());
+    REQUIRE(budget.getCacheSize("entry-cache") ==
+            (cfg.ENTRY_CACHE_SIZE >> MemoryBudget::MAX_HALVINGS));
+
+    // The most valuable cache grows back first
+    budget.update(between);
+    REQUIRE(budget.getLevel() == budget.getMaxLevel());
+    budget.update(under);
+    REQUIRE(budget.getCacheSize("entry-cache") ==
+            (cfg.ENTRY_CACHE_SIZE >> (MemoryBudget::MAX_HALVINGS - 1)));
+    REQUIRE(budget.getCacheSize("bucketlistdb-cache") ==
+            (4000u >> MemoryBudget::MAX_HALVINGS));
+
+    for (uint32_t i = 0; i < 2 * budget.getMaxLevel(); ++i)
+    {
+        budget.update(under);
+    }
+    REQUIRE(budget.getLevel() == 0);
+    REQUIRE(level.count() == 0);
+    REQUIRE(budget.getCacheSize("bucketlistdb-cache") == 4000);
+    REQUIRE(budget.getCacheSize("verify-sig-cache") ==
+            cfg.SIGNATURE_CACHE_SIZE);
+    REQUIRE(budget.getCacheSize("entry-cache") == cfg.ENTRY_CACHE_SIZE);
+}
@@ -0,0 +1,105 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "main/QueryServer.h"
+#include "ledger/LedgerManager.h"
+#include "lib/catch.hpp"
+#include "lib/json/json.h"
+#include "main/Application.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/test.h"
+#include "util/Decoder.h"
+#include "util/types.h"
+#include "xdrpp/marshal.h"
+
+using namespace stellar;
+
+namespace
+{
+LedgerKey
+accountKey(PublicKey const& pk)
+{
+    LedgerKey k(ACCOUNT);
+    k.account().accountID = pk;
+    return k;
+}
+
+std::string
+keysParam(std::vector<LedgerKey> const& keys)
+{
+    std::string res = "?keys=";
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        res += (i == 0 ? "" : ",") +
+               decoder::encode_b64(xdr::xdr_to_opaque(keys[i]));
+    }
+    return res;
+}
+}
+
+TEST_CASE("query server answers batched ledger entry queries", "[queryserver]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.QUERY_MAX_KEYS_PER_REQUEST = 3;
+
+    SECTION("looks keys up in the latest snapshot")
+    {
+        auto app = createTestApplication(clock, cfg);
+        auto root = TestAccount::createRoot(*app);
+        auto a1 =
+            root.create("A", app->getLedgerManager().getLastMinBalance(0));
+        QueryServer server(*app);
+
+        std::vector<LedgerKey> keys{
+            accountKey(a1.getPublicKey()),
+            accountKey(SecretKey::pseudoRandomForTesting().getPublicKey()),
+            accountKey(root.getPublicKey())};
+        std::string ret;
+        server.getLedgerEntry(keysParam(keys), ret);
+
+        Json::Value res;
+        REQUIRE(Json::Reader().parse(ret, res));
+        REQUIRE(res["ledger"].asUInt() ==
+                app->getLedgerManager().getLastClosedLedgerNum());
+        auto const& entries = res["entries"];
+        REQUIRE(entries.size() == keys.size());
+        for (Json::ArrayIndex i = 0; i < entries.size(); ++i)
+        {
+            REQUIRE(entries[i]["key"].asString() ==
+                    decoder::encode_b64(xdr::xdr_to_opaque(keys[i])));
+            if (i == 1)
+            {
+                REQUIRE(entries[i]["state"].asString() == "dead");
+                continue;
+            }
+            REQUIRE(entries[i]["state"].asString() == "live");
+            std::vector<uint8_t> opaque;
+            decoder::decode_b64(entries[i]["entry"].asString(), opaque);
+            LedgerEntry le;
+            xdr::xdr_from_opaque(opaque, le);
+            REQUIRE(LedgerEntryKey(le) == keys[i]);
+        }
+
+        keys.emplace_back(accountKey(a1.getPublicKey()));
+        REQUIRE_THROWS_AS(server.getLedgerEntry(keysParam(keys), ret),
+                          std::invalid_argument);
+    }
+
+    SECTION("limits the rate of keys")
+    {
+        cfg.QUERY_MAX_KEYS_PER_SECOND = 3;
+        auto app = createTestApplication(clock, cfg);
+        auto root = TestAccount::createRoot(*app);
+        QueryServer server(*app);
+
+        std::vector<LedgerKey> keys(3, accountKey(root.getPublicKey()));
+        std::string ret;
+        server.getLedgerEntry(keysParam(keys), ret);
+        REQUIRE_THROWS_AS(server.getLedgerEntry(keysParam(keys), ret),
+                          std::runtime_error);
+    }
+}
@@ -7,7 +7,7 @@
 #include "database/Database.h"
 #include "main/Application.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
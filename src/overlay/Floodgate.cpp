@@ -8,26 +8,28 @@
 #include "herder/Herder.h"
 #include "main/Application.h"
 #include "medida/counter.h"
+#include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "overlay/OverlayManager.h"
+#include "overlay/SerializedMessageCache.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/MemoryFootprint.h"
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
 {
-Floodgate::FloodRecord::FloodRecord(uint32_t ledger, Peer::pointer peer)
-    : mLedgerSeq(ledger)
-{
-    if (peer)
-        mPeersTold.insert(peer->toString());
-}
-
 Floodgate::Floodgate(Application& app)
     : mApp(app)
     , mFloodMapSize(
           app.getMetrics().NewCounter({"overlay", "memory", "flood-known"}))
+    , mFloodMapBytes(
+          app.getMetrics().NewCounter({"overlay", "memory", "flood-bytes"}))
+    , mLookups(app.getMetrics().NewMeter({"overlay", "flood", "lookup"},
+                                         "lookup"))
+    , mEvictions(app.getMetrics().NewMeter({"overlay", "flood", "evicted"},
+                                           "record"))
     , mSendFromBroadcast(app.getMetrics().NewMeter(
           {"overlay", "flood", "broadcast"}, "message"))
     , mMessagesAdvertised(app.getMetrics().NewMeter(
@@ -36,23 +38,128 @@ Floodgate::Floodgate(Application& app)
 {
 }
 
-// remove old flood records
+std::optional<size_t>
+Floodgate::getPeerSlot(Peer& peer)
+{
+    auto it = mPeerSlots.find(peer.toString());
+    if (it != mPeerSlots.end())
+    {
+        return it->second;
+    }
+
+    size_t slot;
+    if (!mFreeSlots.empty())
+    {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+    else if (mNextSlot < MAX_PEER_SLOTS)
+    {
+        slot = mNextSlot++;
+    }
+    else
+    {
+        return std::nullopt;
+    }
+    mPeerSlots.emplace(peer.toString(), slot);
+    return slot;
+}
+
 void
-Floodgate::clearBelow(uint32_t maxLedger)
+Floodgate::removePeer(Peer& peer)
 {
-    ZoneScoped;
-    for (auto it = mFloodMap.cbegin(); it != mFloodMap.cend();)
+    auto it = mPeerSlots.find(peer.toString());
+    if (it != mPeerSlots.end())
     {
-        if (it->second->mLedgerSeq < maxLedger)
-        {
-            it = mFloodMap.erase(it);
-        }
-        else
+        // Records may still have the slot's bit set, it can only be given to
+        // another peer once they are gone
+        mReleasedSlots.emplace_back(
+            it->second, mApp.getHerder().trackingConsensusLedgerIndex());
+        mPeerSlots.erase(it);
+        reuseReleasedSlots();
+    }
+}
+
+void
+Floodgate::reuseReleasedSlots()
+{
+    while (!mReleasedSlots.empty() &&
+           (mRecordsByLedger.empty() ||
+            mRecordsByLedger.begin()->first > mReleasedSlots.front().second))
+    {
+        mFreeSlots.emplace_back(mReleasedSlots.front().first);
+        mReleasedSlots.pop_front();
+    }
+}
+
+Floodgate::FloodRecord*
+Floodgate::findRecord(Hash const& msgID)
+{
+    mLookups.Mark();
+    auto it = mFloodMap.find(msgID);
+    return it == mFloodMap.end() ? nullptr : &it->second;
+}
+
+Floodgate::FloodRecord&
+Floodgate::addNewRecord(Hash const& msgID)
+{
+    auto ledger = mApp.getHerder().trackingConsensusLedgerIndex();
+    auto& record = mFloodMap[msgID];
+    record.mLedgerSeq = ledger;
+    mRecordsByLedger[ledger].emplace_back(msgID);
+    ++mIndexedRecords;
+
+    // Forget the oldest ledgers early rather than growing without bound;
+    // that only risks sending a message again to a peer that has it
+    while (mFloodMap.size() > MAX_RECORDS && mRecordsByLedger.size() > 1 &&
+           mRecordsByLedger.begin()->first < ledger)
+    {
+        auto before = mFloodMap.size();
+        clearLedger(mRecordsByLedger.begin());
+        mEvictions.Mark(before - mFloodMap.size());
+    }
+    reuseReleasedSlots();
+    updateSizeMetrics();
+    TracyPlot("overlay.memory.flood-known",
+              static_cast<int64_t>(mFloodMap.size()));
+    return mFloodMap.at(msgID);
+}
+
+void
+Floodgate::clearLedger(std::map<uint32_t, std::vector<Hash>>::iterator it)
+{
+    for (auto const& msgID : it->second)
+    {
+        auto record = mFloodMap.find(msgID);
+        if (record != mFloodMap.end() &&
+            record->second.mLedgerSeq == it->first)
         {
-            ++it;
+            mFloodMap.erase(record);
         }
     }
+    mIndexedRecords -= it->second.size();
+    mRecordsByLedger.erase(it);
+}
+
+void
+Floodgate::updateSizeMetrics()
+{
     mFloodMapSize.set_count(mFloodMap.size());
+    mFloodMapBytes.set_count(getEstimatedBytes());
+}
+
+// remove old flood records
+void
+Floodgate::clearBelow(uint32_t maxLedger)
+{
+    ZoneScoped;
+    while (!mRecordsByLedger.empty() &&
+           mRecordsByLedger.begin()->first < maxLedger)
+    {
+        clearLedger(mRecordsByLedger.begin());
+    }
+    reuseReleasedSlots();
+    updateSizeMetrics();
 }
 
 bool
@@ -60,25 +167,31 @@ Floodgate::addRecord(StellarMessage const& msg, Peer::pointer peer, Hash& index)
 {
     ZoneScoped;
     index = xdrBlake2(msg);
+    return addRecord(index, peer);
+}
+
+bool
+Floodgate::addRecord(Hash const& index, Peer::pointer peer)
+{
+    ZoneScoped;
     if (mShuttingDown)
     {
         return false;
     }
-    auto result = mFloodMap.find(index);
-    if (result == mFloodMap.end())
+    auto record = findRecord(index);
+    bool isNew = !record;
+    if (isNew)
     { // we have never seen this message
-        mFloodMap[index] = std::make_shared<FloodRecord>(
-            mApp.getHerder().trackingConsensusLedgerIndex(), peer);
-        mFloodMapSize.set_count(mFloodMap.size());
-        TracyPlot("overlay.memory.flood-known",
-                  static_cast<int64_t>(mFloodMap.size()));
-        return true;
+        record = &addNewRecord(index);
     }
-    else
+    if (peer)
     {
-        result->second->mPeersTold.insert(peer->toString());
-        return false;
+        if (auto slot = getPeerSlot(*peer))
+        {
+            record->mPeersTold.set(*slot);
+        }
     }
+    return isNew;
 }
 
 // send message to anyone you haven't gotten it from
@@ -99,26 +212,19 @@ Floodgate::broadcast(std::shared_ptr<StellarMessage const> msg,
     }
     Hash index = xdrBlake2(*msg);
 
-    FloodRecord::pointer fr;
-    auto result = mFloodMap.find(index);
-    if (result == mFloodMap.end())
+    auto record = findRecord(index);
+    if (!record)
     { // no one has sent us this message / start from scratch
-        fr = std::make_shared<FloodRecord>(
-            mApp.getHerder().trackingConsensusLedgerIndex(), Peer::pointer());
-        mFloodMap[index] = fr;
-        mFloodMapSize.set_count(mFloodMap.size());
-    }
-    else
-    {
-        fr = result->second;
+        record = &addNewRecord(index);
     }
     // send it to people that haven't sent it to us
-    auto& peersTold = fr->mPeersTold;
+    auto& peersTold = record->mPeersTold;
 
     // make a copy, in case peers gets modified
     auto peers = mApp.getOverlayManager().getAuthenticatedPeers();
 
     bool broadcasted = false;
+    bool encoded = false;
     for (auto peer : peers)
     {
         // Assert must hold since only main thread is allowed to modify
@@ -133,8 +239,14 @@ Floodgate::broadcast(std::shared_ptr<StellarMessage const> msg,
 
         bool pullMode = msg->type() == TRANSACTION;
 
-        if (peersTold.insert(peer.second->toString()).second)
+        // Peers without a slot can't be remembered, and are always sent to
+        auto slot = getPeerSlot(*peer.second);
+        if (!slot || !peersTold.test(*slot))
         {
+            if (slot)
+            {
+                peersTold.set(*slot);
+            }
             if (pullMode)
             {
                 if (peer.second->sendAdvert(hash.value()))
@@ -145,6 +257,13 @@ Floodgate::broadcast(std::shared_ptr<StellarMessage const> msg,
             else
             {
                 mSendFromBroadcast.Mark();
+                if (!encoded)
+                {
+                    // Encode once for all the peers we push to
+                    mApp.getOverlayManager().getSerializedMessageCache()->add(
+                        msg);
+                    encoded = true;
+                }
                 std::weak_ptr<Peer> weak(
                     std::static_pointer_cast<Peer>(peer.second));
                 // This is an async operation, and peer might get dropped by the
@@ -165,7 +284,7 @@ Floodgate::broadcast(std::shared_ptr<StellarMessage const> msg,
         }
     }
     CLOG_TRACE(Overlay, "broadcast {} told {}", hexAbbrev(index),
-               peersTold.size());
+               peersTold.count());
     return broadcasted;
 }
 
@@ -173,14 +292,15 @@ std::set<Peer::pointer>
 Floodgate::getPeersKnows(Hash const& h)
 {
     std::set<Peer::pointer> res;
-    auto record = mFloodMap.find(h);
-    if (record != mFloodMap.end())
+    auto record = findRecord(h);
+    if (record)
     {
-        auto& ids = record->second->mPeersTold;
         auto const& peers = mApp.getOverlayManager().getAuthenticatedPeers();
         for (auto& p : peers)
         {
-            if (ids.find(p.second->toString()) != ids.end())
+            auto slot = mPeerSlots.find(p.second->toString());
+            if (slot != mPeerSlots.end() &&
+                record->mPeersTold.test(slot->second))
             {
                 res.insert(p.second);
             }
@@ -194,11 +314,22 @@ Floodgate::shutdown()
 {
     mShuttingDown = true;
     mFloodMap.clear();
+    mRecordsByLedger.clear();
+    mIndexedRecords = 0;
+    updateSizeMetrics();
 }
 
 void
 Floodgate::forgetRecord(Hash const& h)
 {
+    // Its hash stays indexed under its ledger until the ledger is cleared
     mFloodMap.erase(h);
 }
+
+size_t
+Floodgate::getEstimatedBytes() const
+{
+    return mFloodMap.size() * nodeBytes<decltype(mFloodMap)::value_type>() +
+           mIndexedRecords * sizeof(Hash);
+}
 }
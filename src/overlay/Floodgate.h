@@ -5,7 +5,12 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "overlay/Peer.h"
+#include "util/HashOfHash.h"
+#include "util/UnorderedMap.h"
+#include <bitset>
+#include <deque>
 #include <map>
+#include <optional>
 
 /**
  * FloodGate keeps track of which peers have sent us which broadcast messages,
@@ -18,11 +23,20 @@
  * All messages are marked with the ledger sequence number to which they
  * relate, and all flood-management information for a given ledger number
  * is purged from the FloodGate when the ledger closes.
+ *
+ * To keep the cost of a record small and fixed, peers are told apart by a
+ * small integer slot, given to each peer the first time it is seen and
+ * freed once it is removed and all records that may name it are gone. The
+ * peers a message was exchanged with are then a bitset over the slots. The
+ * records of each ledger are indexed together, so that clearing a ledger
+ * doesn't walk all records, and the oldest ledgers are forgotten early when
+ * there are more than MAX_RECORDS records.
  */
 
 namespace medida
 {
 class Counter;
+class Meter;
 }
 
 namespace stellar
@@ -32,24 +46,48 @@ struct StellarMessage;
 
 class Floodgate
 {
-    class FloodRecord
-    {
-      public:
-        typedef std::shared_ptr<FloodRecord> pointer;
+  public:
+    // Most peers whose exchanges are tracked at once. Messages are sent to
+    // any further peer on each broadcast, as if it never had them.
+    static constexpr size_t MAX_PEER_SLOTS = 256;
+    static constexpr size_t MAX_RECORDS = 1 << 20;
 
+  private:
+    struct FloodRecord
+    {
         uint32_t mLedgerSeq;
-        std::set<std::string> mPeersTold;
-
-        FloodRecord(uint32_t ledger, Peer::pointer peer);
+        std::bitset<MAX_PEER_SLOTS> mPeersTold;
     };
 
-    std::map<Hash, FloodRecord::pointer> mFloodMap;
+    UnorderedMap<Hash, FloodRecord> mFloodMap;
+    // Hashes of the records created at each ledger; some may have been
+    // forgotten, or created again at a later ledger, since
+    std::map<uint32_t, std::vector<Hash>> mRecordsByLedger;
+    size_t mIndexedRecords{0};
+
+    UnorderedMap<std::string, size_t> mPeerSlots;
+    std::vector<size_t> mFreeSlots;
+    // Slots of removed peers, with the ledger they were removed at
+    std::deque<std::pair<size_t, uint32_t>> mReleasedSlots;
+    size_t mNextSlot{0};
+
     Application& mApp;
     medida::Counter& mFloodMapSize;
+    medida::Counter& mFloodMapBytes;
+    medida::Meter& mLookups;
+    medida::Meter& mEvictions;
     medida::Meter& mSendFromBroadcast;
     medida::Meter& mMessagesAdvertised;
     bool mShuttingDown;
 
+    std::optional<size_t> getPeerSlot(Peer& peer);
+    FloodRecord* findRecord(Hash const& msgID);
+    FloodRecord& addNewRecord(Hash const& msgID);
+    // forgets the records created at the ledger of `it`
+    void clearLedger(std::map<uint32_t, std::vector<Hash>>::iterator it);
+    void reuseReleasedSlots();
+    void updateSizeMetrics();
+
   public:
     Floodgate(Application& app);
     // forget data strictly older than `maxLedger`
@@ -58,6 +96,8 @@ class Floodgate
     // fills msgID with msg's hash
     bool addRecord(StellarMessage const& msg, Peer::pointer fromPeer,
                    Hash& msgID);
+    // same as above, for a message whose hash was already computed
+    bool addRecord(Hash const& msgID, Peer::pointer fromPeer);
 
     // returns true if msg was sent to at least one peer
     // The hash required for transactions
@@ -75,6 +115,12 @@ class Floodgate
     // `msgID` corresponds to a `StellarMessage`
     void forgetRecord(Hash const& msgID);
 
+    // frees the slot of `peer`, which is being dropped
+    void removePeer(Peer& peer);
+
+    // returns the estimated bytes of memory held by the flood records
+    size_t getEstimatedBytes() const;
+
     void shutdown();
 };
 }
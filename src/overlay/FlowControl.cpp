@@ -5,12 +5,15 @@
 #include "overlay/FlowControl.h"
 #include "herder/Herder.h"
 #include "main/Application.h"
+#include "medida/counter.h"
 #include "medida/meter.h"
 #include "medida/timer.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+#include "util/finally.h"
+#include "xdrpp/marshal.h"
 
 namespace stellar
 {
@@ -44,6 +47,18 @@ FlowControl::FlowControl(OverlayAppConnector& connector,
     releaseAssert(threadIsMain());
 }
 
+FlowControl::~FlowControl()
+{
+    // Whatever is still queued leaves the overlay-wide queue depth with us
+    std::lock_guard<std::mutex> guard(mFlowControlMutex);
+    std::array<size_t, 4> before = getQueueSizes(guard);
+    for (auto& queue : mOutboundQueues)
+    {
+        queue.clear();
+    }
+    updateQueueDepth(before, guard);
+}
+
 bool
 FlowControl::hasOutboundCapacity(StellarMessage const& msg,
                                  std::lock_guard<std::mutex>& lockGuard) const
@@ -110,95 +125,174 @@ FlowControl::getNextBatchToSend()
     releaseAssert(!threadIsMain() || !mUseBackgroundThread);
 
     std::lock_guard<std::mutex> guard(mFlowControlMutex);
+    auto updateDepth =
+        gsl::finally([&, before = getQueueSizes(guard)]() {
+            updateQueueDepth(before, guard);
+        });
     std::vector<std::shared_ptr<StellarMessage const>> batchToSend;
 
-    int sent = 0;
-    for (int i = 0; i < mOutboundQueues.size(); i++)
-    {
-        auto& queue = mOutboundQueues[i];
-        while (!queue.empty())
+    // Move the front of `queue` to the batch if the peer can take it; returns
+    // false (and starts the SEND_MORE timeout) if it can't
+    auto trySendFront = [&](std::deque<QueuedOutboundMessage>& queue) {
+        auto& front = queue.front();
+        auto const& msg = *(front.mMessage);
+        // Can't send _current_ message
+        if (!hasOutboundCapacity(msg, guard))
         {
-            auto& front = queue.front();
-            auto const& msg = *(front.mMessage);
-            // Can't send _current_ message
-            if (!hasOutboundCapacity(msg, guard))
-            {
-                CLOG_DEBUG(
-                    Overlay, "{}: No outbound capacity for peer {}",
-                    mAppConnector.getConfig().toShortString(
-                        mAppConnector.getConfig().NODE_SEED.getPublicKey()),
-                    mAppConnector.getConfig().toShortString(mNodeID));
-                // Start a timeout for SEND_MORE
-                mNoOutboundCapacity =
-                    std::make_optional<VirtualClock::time_point>(
-                        mAppConnector.now());
-                break;
-            }
+            CLOG_DEBUG(Overlay, "{}: No outbound capacity for peer {}",
+                       mAppConnector.getConfig().toShortString(
+                           mAppConnector.getConfig().NODE_SEED.getPublicKey()),
+                       mAppConnector.getConfig().toShortString(mNodeID));
+            // Start a timeout for SEND_MORE
+            mNoOutboundCapacity =
+                std::make_optional<VirtualClock::time_point>(
+                    mAppConnector.now());
+            return false;
+        }
 
-            batchToSend.push_back(front.mMessage);
-            ++sent;
-            auto& om = mOverlayMetrics;
+        batchToSend.push_back(front.mMessage);
+        auto& om = mOverlayMetrics;
+
+        auto const& diff = mAppConnector.now() - front.mTimeEmplaced;
+        mFlowControlCapacity->lockOutboundCapacity(msg);
+        if (mFlowControlBytesCapacity)
+        {
+            mFlowControlBytesCapacity->lockOutboundCapacity(msg);
+        }
 
-            auto const& diff = mAppConnector.now() - front.mTimeEmplaced;
-            mFlowControlCapacity->lockOutboundCapacity(msg);
+        switch (front.mMessage->type())
+        {
+        case TRANSACTION:
+        {
+            om.mOutboundQueueDelayTxs.Update(diff);
+            mMetrics.mOutboundQueueDelayTxs.Update(diff);
             if (mFlowControlBytesCapacity)
             {
-                mFlowControlBytesCapacity->lockOutboundCapacity(msg);
+                size_t s = mFlowControlBytesCapacity->getMsgResourceCount(msg);
+                releaseAssert(mTxQueueByteCount >= s);
+                mTxQueueByteCount -= s;
             }
+        }
+        break;
+        case SCP_MESSAGE:
+        {
+            om.mOutboundQueueDelaySCP.Update(diff);
+            mMetrics.mOutboundQueueDelaySCP.Update(diff);
+        }
+        break;
+        case FLOOD_DEMAND:
+        {
+            om.mOutboundQueueDelayDemand.Update(diff);
+            mMetrics.mOutboundQueueDelayDemand.Update(diff);
+            size_t s = front.mMessage->floodDemand().txHashes.size();
+            releaseAssert(mDemandQueueTxHashCount >= s);
+            mDemandQueueTxHashCount -= s;
+        }
+        break;
+        case FLOOD_ADVERT:
+        {
+            om.mOutboundQueueDelayAdvert.Update(diff);
+            mMetrics.mOutboundQueueDelayAdvert.Update(diff);
+            size_t s = front.mMessage->floodAdvert().txHashes.size();
+            releaseAssert(mAdvertQueueTxHashCount >= s);
+            mAdvertQueueTxHashCount -= s;
+        }
+        break;
+        default:
+            abort();
+        }
+        queue.pop_front();
+        return true;
+    };
 
-            switch (front.mMessage->type())
+    // SCP messages have strict priority: nothing else is sent until they are
+    // all out
+    auto& scpQueue = mOutboundQueues[0];
+    while (!scpQueue.empty() && trySendFront(scpQueue))
+    {
+    }
+
+    // The remaining queues share what capacity is left by byte-based deficit
+    // round robin: each round, a queue earns OUTBOUND_QUEUE_QUANTUM_BYTES of
+    // credit and sends messages from its front while they fit in its credit.
+    // This keeps a backlog of large transactions from starving the small
+    // demands and adverts that drive pull-mode flooding, and vice versa.
+    std::array<bool, 4> blocked{true, false, false, false};
+    auto active = [&](size_t i) {
+        return !blocked[i] && !mOutboundQueues[i].empty();
+    };
+    bool anyActive = true;
+    while (anyActive)
+    {
+        anyActive = false;
+        for (size_t i = 1; i < mOutboundQueues.size(); i++)
+        {
+            auto& queue = mOutboundQueues[i];
+            if (!active(i))
             {
-            case TRANSACTION:
+                continue;
+            }
+            mQueueDeficits[i] += OUTBOUND_QUEUE_QUANTUM_BYTES;
+            while (!queue.empty() && queue.front().mSize <= mQueueDeficits[i])
             {
-                om.mOutboundQueueDelayTxs.Update(diff);
-                mMetrics.mOutboundQueueDelayTxs.Update(diff);
-                if (mFlowControlBytesCapacity)
+                auto size = queue.front().mSize;
+                if (!trySendFront(queue))
                 {
-                    size_t s =
-                        mFlowControlBytesCapacity->getMsgResourceCount(msg);
-                    releaseAssert(mTxQueueByteCount >= s);
-                    mTxQueueByteCount -= s;
+                    // Keep just enough credit to send the message once the
+                    // peer asks for more
+                    mQueueDeficits[i] = size;
+                    blocked[i] = true;
+                    break;
                 }
+                mQueueDeficits[i] -= size;
             }
-            break;
-            case SCP_MESSAGE:
-            {
-                om.mOutboundQueueDelaySCP.Update(diff);
-                mMetrics.mOutboundQueueDelaySCP.Update(diff);
-            }
-            break;
-            case FLOOD_DEMAND:
-            {
-                om.mOutboundQueueDelayDemand.Update(diff);
-                mMetrics.mOutboundQueueDelayDemand.Update(diff);
-                size_t s = front.mMessage->floodDemand().txHashes.size();
-                releaseAssert(mDemandQueueTxHashCount >= s);
-                mDemandQueueTxHashCount -= s;
-            }
-            break;
-            case FLOOD_ADVERT:
-            {
-                om.mOutboundQueueDelayAdvert.Update(diff);
-                mMetrics.mOutboundQueueDelayAdvert.Update(diff);
-                size_t s = front.mMessage->floodAdvert().txHashes.size();
-                releaseAssert(mAdvertQueueTxHashCount >= s);
-                mAdvertQueueTxHashCount -= s;
-            }
-            break;
-            default:
-                abort();
-            }
-            queue.pop_front();
+            anyActive = anyActive || active(i);
+        }
+    }
+
+    for (size_t i = 1; i < mOutboundQueues.size(); i++)
+    {
+        // Credit does not carry over idle periods, only unfinished rounds
+        if (mOutboundQueues[i].empty())
+        {
+            mQueueDeficits[i] = 0;
         }
     }
 
     CLOG_TRACE(Overlay, "{} Peer {}: send next flood batch of {}",
                mAppConnector.getConfig().toShortString(
                    mAppConnector.getConfig().NODE_SEED.getPublicKey()),
-               mAppConnector.getConfig().toShortString(mNodeID), sent);
+               mAppConnector.getConfig().toShortString(mNodeID),
+               batchToSend.size());
     return batchToSend;
 }
 
+std::array<size_t, 4>
+FlowControl::getQueueSizes(std::lock_guard<std::mutex> const& lockGuard) const
+{
+    std::array<size_t, 4> res;
+    for (size_t i = 0; i < mOutboundQueues.size(); i++)
+    {
+        res[i] = mOutboundQueues[i].size();
+    }
+    return res;
+}
+
+void
+FlowControl::updateQueueDepth(std::array<size_t, 4> const& before,
+                              std::lock_guard<std::mutex> const& lockGuard)
+{
+    auto& om = mOverlayMetrics;
+    std::array<medida::Counter*, 4> depths{
+        &om.mOutboundQueueDepthSCP, &om.mOutboundQueueDepthTxs,
+        &om.mOutboundQueueDepthDemand, &om.mOutboundQueueDepthAdvert};
+    for (size_t i = 0; i < mOutboundQueues.size(); i++)
+    {
+        depths[i]->inc(static_cast<int64_t>(mOutboundQueues[i].size()) -
+                       static_cast<int64_t>(before[i]));
+    }
+}
+
 void
 FlowControl::handleTxSizeIncrease(uint32_t increase)
 {
@@ -359,6 +453,10 @@ FlowControl::addMsgAndMaybeTrimQueue(std::shared_ptr<StellarMessage const> msg)
     ZoneScoped;
     releaseAssert(threadIsMain());
     std::lock_guard<std::mutex> guard(mFlowControlMutex);
+    auto updateDepth =
+        gsl::finally([&, before = getQueueSizes(guard)]() {
+            updateQueueDepth(before, guard);
+        });
     releaseAssert(msg);
     auto type = msg->type();
     size_t msgQInd = 0;
@@ -406,7 +504,8 @@ FlowControl::addMsgAndMaybeTrimQueue(std::shared_ptr<StellarMessage const> msg)
     }
     auto& queue = mOutboundQueues[msgQInd];
 
-    queue.emplace_back(QueuedOutboundMessage{msg, mAppConnector.now()});
+    queue.emplace_back(QueuedOutboundMessage{msg, mAppConnector.now(),
+                                             xdr::xdr_size(*msg)});
 
     size_t dropped = 0;
 
@@ -38,6 +38,8 @@ class FlowControl
     {
         std::shared_ptr<StellarMessage const> mMessage;
         VirtualClock::time_point mTimeEmplaced;
+        // XDR size of mMessage, used to share bandwidth between queues
+        size_t mSize{0};
     };
 
   private:
@@ -70,11 +72,15 @@ class FlowControl
     bool const mUseBackgroundThread;
 
     // Outbound queues indexes by priority
-    // Priority 0 - SCP messages
+    // Priority 0 - SCP messages, always sent first
     // Priority 1 - transactions
     // Priority 2 - flood demands
     // Priority 3 - flood adverts
+    // Queues 1 to 3 share the remaining capacity by deficit round robin.
     std::array<std::deque<QueuedOutboundMessage>, 4> mOutboundQueues;
+    // Unspent round robin credit, in bytes, of each queue
+    std::array<size_t, 4> mQueueDeficits{};
+    static constexpr size_t OUTBOUND_QUEUE_QUANTUM_BYTES = 16 * 1024;
 
     // How many flood messages we received and processed since sending
     // SEND_MORE to this peer
@@ -90,10 +96,16 @@ class FlowControl
     virtual size_t
     getOutboundQueueByteLimit(std::lock_guard<std::mutex>& lockGuard) const;
     bool canRead(std::lock_guard<std::mutex> const& lockGuard) const;
+    std::array<size_t, 4>
+    getQueueSizes(std::lock_guard<std::mutex> const& lockGuard) const;
+    // Apply the change in queue sizes since `before` to the overlay-wide
+    // queue depth counters
+    void updateQueueDepth(std::array<size_t, 4> const& before,
+                          std::lock_guard<std::mutex> const& lockGuard);
 
   public:
     FlowControl(OverlayAppConnector& connector, bool useBackgoundThread);
-    virtual ~FlowControl() = default;
+    virtual ~FlowControl();
 
     void maybeReleaseCapacity(StellarMessage const& msg);
     void handleTxSizeIncrease(uint32_t increase);
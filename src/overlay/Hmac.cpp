@@ -79,6 +79,40 @@ Hmac::setAuthenticatedMessageBody(AuthenticatedMessage& aMsg,
     }
 }
 
+xdr::msg_ptr
+Hmac::authenticateSerializedMessage(StellarMessage const& msg,
+                                    xdr::opaque_vec<> const& body)
+{
+    ZoneScoped;
+    // AuthenticatedMessage is a union on `uint32 v`, whose only arm is
+    // { uint64 sequence; StellarMessage message; HmacSha256Mac mac; }, so the
+    // message body sits between a 12-byte prefix and the 32-byte MAC.
+    size_t const prefixSize = sizeof(uint32_t) + sizeof(uint64_t);
+    HmacSha256Mac mac;
+    xdr::msg_ptr res =
+        xdr::message_t::alloc(prefixSize + body.size() + mac.mac.size());
+    char* out = res->data();
+
+    LOCK_GUARD(mMutex, guard);
+    bool const authenticated = msg.type() != HELLO && msg.type() != ERROR_MSG;
+    uint64_t const seq = authenticated ? mSendMacSeq : 0;
+    auto prefix = xdr::xdr_to_opaque(static_cast<uint32_t>(0), seq);
+    releaseAssert(prefix.size() == prefixSize);
+    std::copy(prefix.begin(), prefix.end(), out);
+    std::copy(body.begin(), body.end(), out + prefixSize);
+    if (authenticated)
+    {
+        // The MAC covers the XDR of (sequence, message), which is exactly the
+        // bytes following the union discriminant
+        mac = hmacSha256(
+            mSendMacKey, ByteSlice(out + sizeof(uint32_t),
+                                   sizeof(uint64_t) + body.size()));
+        mSendMacSeq++;
+    }
+    std::copy(mac.mac.begin(), mac.mac.end(), out + prefixSize + body.size());
+    return res;
+}
+
 #ifdef BUILD_TESTS
 void
 Hmac::damageRecvMacKey()
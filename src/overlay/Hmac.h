@@ -4,9 +4,10 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
-#include "Tracy.hpp"
+#include "util/Tracing.h"
 #include "xdr/Stellar-overlay.h"
 #include "xdr/Stellar-types.h"
+#include "xdrpp/message.h"
 #include <mutex>
 
 using namespace stellar;
@@ -30,6 +31,11 @@ class Hmac
                                    std::string& errorMsg);
     void setAuthenticatedMessageBody(AuthenticatedMessage& aMsg,
                                      StellarMessage const& msg);
+    // Produces the same bytes as setAuthenticatedMessageBody followed by
+    // xdr::xdr_to_msg, from `body`, an existing XDR encoding of `msg`, without
+    // copying or re-encoding the message itself
+    xdr::msg_ptr authenticateSerializedMessage(StellarMessage const& msg,
+                                               xdr::opaque_vec<> const& body);
 #ifdef BUILD_TESTS
     void damageRecvMacKey();
 #endif
@@ -9,7 +9,8 @@
 #include "main/Application.h"
 #include "overlay/Tracker.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/MemoryFootprint.h"
+#include "util/Tracing.h"
 
 namespace stellar
 {
@@ -164,6 +165,20 @@ ItemFetcher::recv(Hash itemHash, medida::Timer& timer)
     }
 }
 
+size_t
+ItemFetcher::getEstimatedBytes() const
+{
+    size_t waiting = 0;
+    for (auto const& kv : mTrackers)
+    {
+        waiting += kv.second->size();
+    }
+    return mTrackers.size() *
+               (nodeBytes<decltype(mTrackers)::value_type>() +
+                sizeof(Tracker)) +
+           waiting * sizeof(std::pair<Hash, SCPEnvelope>);
+}
+
 #ifdef BUILD_TESTS
 std::shared_ptr<Tracker>
 ItemFetcher::getTracker(Hash const& h)
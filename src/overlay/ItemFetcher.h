@@ -88,6 +88,12 @@ class ItemFetcher : private NonMovableOrCopyable
      */
     void recv(Hash itemHash, medida::Timer& timer);
 
+    /**
+     * Return the estimated bytes of memory held by the trackers and the
+     * envelopes waiting on them.
+     */
+    size_t getEstimatedBytes() const;
+
 #ifdef BUILD_TESTS
     std::shared_ptr<Tracker> getTracker(Hash const& h);
 #endif
@@ -0,0 +1,152 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/MessageCompression.h"
+#include "util/GlobalChecks.h"
+#include "util/Tracing.h"
+#include <cstring>
+#include <memory>
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace stellar
+{
+namespace MessageCompression
+{
+
+namespace
+{
+// ZSTD_MAGICNUMBER as laid out on the wire
+constexpr uint8_t ZSTD_FRAME_MAGIC[] = {0x28, 0xB5, 0x2F, 0xFD};
+
+#ifdef USE_ZSTD
+// Contexts are expensive to set up; keep one per thread, as messages are
+// compressed on the overlay thread when background processing is enabled
+struct CCtxDeleter
+{
+    void
+    operator()(ZSTD_CCtx* ctx) const
+    {
+        ZSTD_freeCCtx(ctx);
+    }
+};
+
+struct DCtxDeleter
+{
+    void
+    operator()(ZSTD_DCtx* ctx) const
+    {
+        ZSTD_freeDCtx(ctx);
+    }
+};
+
+ZSTD_CCtx*
+getCCtx()
+{
+    thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> ctx(ZSTD_createCCtx());
+    return ctx.get();
+}
+
+ZSTD_DCtx*
+getDCtx()
+{
+    thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx(ZSTD_createDCtx());
+    return ctx.get();
+}
+#endif
+}
+
+bool
+isSupported()
+{
+#ifdef USE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool
+shouldCompress(MessageType type, size_t size)
+{
+    if (size < MIN_COMPRESSED_SIZE)
+    {
+        return false;
+    }
+    switch (type)
+    {
+    case TX_SET:
+    case GENERALIZED_TX_SET:
+    case TRANSACTION:
+    case FLOOD_ADVERT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool
+isCompressed(uint8_t const* data, size_t size)
+{
+    return size >= sizeof(ZSTD_FRAME_MAGIC) &&
+           std::memcmp(data, ZSTD_FRAME_MAGIC, sizeof(ZSTD_FRAME_MAGIC)) == 0;
+}
+
+xdr::msg_ptr
+compress(xdr::msg_ptr const& msg, int level)
+{
+    ZoneScoped;
+#ifdef USE_ZSTD
+    auto ctx = getCCtx();
+    if (!ctx)
+    {
+        return nullptr;
+    }
+    // Anything that doesn't fit in a smaller frame isn't worth sending
+    std::vector<char> out(msg->size());
+    size_t res = ZSTD_compressCCtx(ctx, out.data(), out.size(), msg->data(),
+                                   msg->size(), level);
+    if (ZSTD_isError(res) || res >= msg->size())
+    {
+        return nullptr;
+    }
+    auto compressed = xdr::message_t::alloc(res);
+    std::memcpy(compressed->data(), out.data(), res);
+    releaseAssert(isCompressed(
+        reinterpret_cast<uint8_t const*>(compressed->data()), res));
+    return compressed;
+#else
+    return nullptr;
+#endif
+}
+
+std::vector<uint8_t>
+decompress(uint8_t const* data, size_t size, size_t maxSize)
+{
+    ZoneScoped;
+#ifdef USE_ZSTD
+    auto ctx = getDCtx();
+    // Only trust the content size written by the sender to reject oversized
+    // frames early; the output buffer bounds the actual decompression
+    auto contentSize = ZSTD_getFrameContentSize(data, size);
+    if (!ctx || contentSize == ZSTD_CONTENTSIZE_ERROR ||
+        contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize > maxSize)
+    {
+        throw xdr::xdr_runtime_error("invalid compressed message");
+    }
+    std::vector<uint8_t> out(static_cast<size_t>(contentSize));
+    size_t res = ZSTD_decompressDCtx(ctx, out.data(), out.size(), data, size);
+    if (ZSTD_isError(res) || res != out.size())
+    {
+        throw xdr::xdr_runtime_error("invalid compressed message");
+    }
+    return out;
+#else
+    throw xdr::xdr_runtime_error("compressed messages are not supported");
+#endif
+}
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "xdr/Stellar-overlay.h"
+#include "xdrpp/message.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace stellar
+{
+
+// Optional zstd compression of whole AuthenticatedMessage frames, negotiated
+// per connection (see Peer::AUTH_MSG_FLAG_COMPRESSION_REQUESTED).
+//
+// A compressed frame carries a single zstd frame in place of the XDR body.
+// The two are told apart by their first bytes: an AuthenticatedMessage always
+// starts with its zero version, a zstd frame with a non-zero magic number. The
+// MAC still covers the uncompressed message, so compression is invisible to
+// everything above the framing layer, flow control included.
+namespace MessageCompression
+{
+// Messages smaller than this are not worth the CPU
+constexpr size_t MIN_COMPRESSED_SIZE = 1024;
+
+// Whether this build can compress and decompress at all
+bool isSupported();
+
+// Whether a message of type `type` whose frame body is `size` bytes should be
+// compressed
+bool shouldCompress(MessageType type, size_t size);
+
+// Whether a frame body holds a compressed message
+bool isCompressed(uint8_t const* data, size_t size);
+
+// Returns a frame holding the compressed body of `msg`, or nullptr if
+// compression fails or does not make the frame smaller.
+xdr::msg_ptr compress(xdr::msg_ptr const& msg, int level);
+
+// Returns the decompressed body of a compressed frame. Throws
+// xdr::xdr_runtime_error if the frame is invalid or would decompress to more
+// than `maxSize` bytes.
+std::vector<uint8_t> decompress(uint8_t const* data, size_t size,
+                                size_t maxSize);
+}
+}
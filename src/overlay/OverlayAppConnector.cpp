@@ -1,4 +1,6 @@
 #include "overlay/OverlayAppConnector.h"
+#include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
 #include "herder/Herder.h"
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
@@ -75,6 +77,26 @@ OverlayAppConnector::now() const
     return mApp.getClock().now();
 }
 
+std::shared_ptr<SearchableBucketListSnapshot>
+OverlayAppConnector::getSearchableBucketListSnapshot() const
+{
+    return mApp.getBucketManager()
+        .getBucketSnapshotManager()
+        .getSearchableBucketListSnapshot();
+}
+
+std::shared_ptr<SorobanNetworkConfigSnapshot const>
+OverlayAppConnector::getSorobanNetworkConfigSnapshot() const
+{
+    return mApp.getLedgerManager().getSorobanNetworkConfigSnapshot();
+}
+
+std::shared_ptr<QuorumTracker::NodeDistances const>
+OverlayAppConnector::getQuorumDistances() const
+{
+    return mApp.getHerder().getQuorumDistances();
+}
+
 bool
 OverlayAppConnector::shouldYield() const
 {
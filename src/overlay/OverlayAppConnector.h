@@ -1,5 +1,6 @@
 #pragma once
 
+#include "herder/QuorumTracker.h"
 #include "main/Config.h"
 
 namespace stellar
@@ -9,6 +10,8 @@ class OverlayManager;
 class LedgerManager;
 class Herder;
 class BanManager;
+class SearchableBucketListSnapshot;
+struct SorobanNetworkConfigSnapshot;
 
 // Helper class to isolate access to Application; all function helpers must
 // either be called from main or be thread-sade
@@ -38,5 +41,11 @@ class OverlayAppConnector
     VirtualClock::time_point now() const;
     Config const& getConfig() const;
     bool overlayShuttingDown() const;
+    std::shared_ptr<SearchableBucketListSnapshot>
+    getSearchableBucketListSnapshot() const;
+    std::shared_ptr<SorobanNetworkConfigSnapshot const>
+    getSorobanNetworkConfigSnapshot() const;
+    std::shared_ptr<QuorumTracker::NodeDistances const>
+    getQuorumDistances() const;
 };
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "overlay/Peer.h"
+#include "util/MemoryFootprint.h"
 
 /**
  * OverlayManager maintains a virtual broadcast network, consisting of a set of
@@ -48,6 +49,7 @@ namespace stellar
 class PeerAuth;
 class PeerBareAddress;
 class PeerManager;
+class SerializedMessageCache;
 class SurveyManager;
 struct StellarMessage;
 
@@ -92,6 +94,10 @@ class OverlayManager
     virtual bool recvFloodedMsgID(StellarMessage const& msg, Peer::pointer peer,
                                   Hash& msgID) = 0;
 
+    // Same as recvFloodedMsgID, for a message whose hash `msgID` was already
+    // computed (e.g. on the overlay thread)
+    virtual bool recvFloodedMsgHash(Hash const& msgID, Peer::pointer peer) = 0;
+
     bool
     recvFloodedMsg(StellarMessage const& msg, Peer::pointer peer)
     {
@@ -99,15 +105,21 @@ class OverlayManager
         return recvFloodedMsgID(msg, peer, msgID);
     }
 
-    // Process incoming transaction, pass it down to the transaction queue
-    virtual void recvTransaction(StellarMessage const& msg,
-                                 Peer::pointer peer) = 0;
+    // Process incoming transaction, pass it down to the transaction queue.
+    // `preparedTx` and `msgID`, when set, are the transaction and flood hash
+    // already built from `msg` off the main thread.
+    virtual void recvTransaction(StellarMessage const& msg, Peer::pointer peer,
+                                 TransactionFrameBasePtr preparedTx,
+                                 std::optional<Hash> const& msgID) = 0;
 
     // removes msgID from the floodgate's internal state
     // as it's not tracked anymore, calling "broadcast" with a (now forgotten)
     // message with the ID msgID will cause it to be broadcast to all peers
     virtual void forgetFloodedMsg(Hash const& msgID) = 0;
 
+    // Adds the estimated memory held by the floodgate to `footprint`
+    virtual void addMemoryFootprint(MemoryFootprint& footprint) const = 0;
+
     // Process incoming transaction demand; this might trigger sending back a
     // transaction
     virtual void recvTxDemand(FloodDemand const& dmd, Peer::pointer peer) = 0;
@@ -190,8 +202,12 @@ class OverlayManager
     // Return the persistent overlay metrics structure.
     virtual OverlayMetrics& getOverlayMetrics() = 0;
 
-    // Return the persistent p2p authentication-key cache.
-    virtual PeerAuth& getPeerAuth() = 0;
+    // Return the persistent p2p authentication-key cache, shared with peers.
+    virtual std::shared_ptr<PeerAuth> getPeerAuth() = 0;
+
+    // Return the cache of XDR-encoded broadcast messages, shared with peers.
+    virtual std::shared_ptr<SerializedMessageCache>
+    getSerializedMessageCache() = 0;
 
     // Return the persistent peer manager
     virtual PeerManager& getPeerManager() = 0;
@@ -17,6 +17,7 @@
 #include "overlay/OverlayMetrics.h"
 #include "overlay/PeerBareAddress.h"
 #include "overlay/PeerManager.h"
+#include "overlay/PeerScore.h"
 #include "overlay/RandomPeerSource.h"
 #include "overlay/SurveyDataManager.h"
 #include "overlay/TCPPeer.h"
@@ -25,8 +26,8 @@
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/Thread.h"
+#include "util/Tracing.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 #include "medida/counter.h"
@@ -44,6 +45,9 @@ using namespace std;
 constexpr std::chrono::seconds PEER_IP_RESOLVE_DELAY(600);
 constexpr std::chrono::seconds PEER_IP_RESOLVE_RETRY_DELAY(10);
 constexpr std::chrono::seconds OUT_OF_SYNC_RECONNECT_DELAY(60);
+// An outbound peer scoring below this fraction of the median score is rotated
+// out (see OUTBOUND_PEER_ROTATION_PERIOD_SECONDS)
+constexpr double LAGGING_PEER_SCORE_FRACTION = 0.5;
 constexpr uint32_t INITIAL_PEER_FLOOD_READING_CAPACITY_BYTES{300000};
 constexpr uint32_t INITIAL_FLOW_CONTROL_SEND_MORE_BATCH_SIZE_BYTES{100000};
 
@@ -305,9 +309,10 @@ OverlayManagerImpl::OverlayManagerImpl(Application& app)
     , mLiveInboundPeersCounter(make_shared<int>(0))
     , mPeerManager(app)
     , mDoor(mApp)
-    , mAuth(mApp)
+    , mAuth(std::make_shared<PeerAuth>(mApp))
     , mShuttingDown(false)
     , mOverlayMetrics(app)
+    , mSerializedMessageCache(std::make_shared<SerializedMessageCache>(app))
     , mMessageCache(0xffff)
     , mTimer(app)
     , mPeerIPTimer(app)
@@ -609,7 +614,20 @@ OverlayManagerImpl::updateTimerAndMaybeDropRandomPeer(bool shouldDrop)
                                  return !mApp.getOverlayManager().isPreferred(
                                      peer.second.get());
                              });
-                if (!nonPreferredPeers.empty())
+                auto const& cfg = mApp.getConfig();
+                if (cfg.OUTBOUND_PEER_ROTATION_PERIOD_SECONDS.count() > 0)
+                {
+                    // Drop the peer that helped the least instead
+                    auto peerToDrop =
+                        getLowestScoringOutboundPeer(std::chrono::seconds(0));
+                    if (peerToDrop)
+                    {
+                        peerToDrop->sendErrorAndDrop(
+                            ERR_LOAD, "disconnect of lowest scoring peer due "
+                                      "to out of sync");
+                    }
+                }
+                else if (!nonPreferredPeers.empty())
                 {
                     auto peerToDrop = rand_element(nonPreferredPeers);
                     peerToDrop.second->sendErrorAndDrop(
@@ -641,6 +659,89 @@ OverlayManagerImpl::updateTimerAndMaybeDropRandomPeer(bool shouldDrop)
     }
 }
 
+Peer::pointer
+OverlayManagerImpl::getLowestScoringOutboundPeer(
+    std::chrono::seconds minLifeTime, std::optional<double> maxScoreFraction)
+{
+    std::vector<Peer::pointer> peers;
+    std::vector<PeerScoreInputs> inputs;
+    for (auto const& peer : getOutboundAuthenticatedPeers())
+    {
+        peers.emplace_back(peer.second);
+        inputs.emplace_back(PeerScoreInputs::fromPeer(*peer.second));
+    }
+    auto scores = scorePeers(inputs);
+
+    Peer::pointer res;
+    double lowest = 0;
+    for (size_t i = 0; i < peers.size(); ++i)
+    {
+        if (isPreferred(peers[i].get()) || inputs[i].mLifeTime < minLifeTime)
+        {
+            continue;
+        }
+        if (!res || scores[i] < lowest)
+        {
+            res = peers[i];
+            lowest = scores[i];
+        }
+    }
+
+    if (res && maxScoreFraction)
+    {
+        auto median = scores.begin() + scores.size() / 2;
+        std::nth_element(scores.begin(), median, scores.end());
+        if (lowest >= *maxScoreFraction * *median)
+        {
+            return nullptr;
+        }
+    }
+    if (res)
+    {
+        CLOG_DEBUG(Overlay, "Lowest scoring outbound peer: {} ({})",
+                   res->toString(), lowest);
+    }
+    return res;
+}
+
+void
+OverlayManagerImpl::maybeRotateLaggingPeer()
+{
+    // Replace an outbound peer that helps this node follow the network much
+    // less than the others, to keep outbound slots for the best peers.
+    // Candidates must have been connected for a whole period, so that they
+    // are judged on enough traffic.
+    auto period = mApp.getConfig().OUTBOUND_PEER_ROTATION_PERIOD_SECONDS;
+    if (period.count() == 0 || !mApp.getHerder().isTracking())
+    {
+        return;
+    }
+    auto now = mApp.getClock().now();
+    if (!mLastPeerRotation)
+    {
+        mLastPeerRotation = std::make_optional<VirtualClock::time_point>(now);
+        return;
+    }
+    if (now - *mLastPeerRotation < period)
+    {
+        return;
+    }
+    mLastPeerRotation = std::make_optional<VirtualClock::time_point>(now);
+
+    auto peer =
+        getLowestScoringOutboundPeer(period, LAGGING_PEER_SCORE_FRACTION);
+    if (peer)
+    {
+        CLOG_INFO(Overlay, "Rotating out lagging outbound peer {}",
+                  peer->toString());
+        mOverlayMetrics.mOutboundRotate.Mark();
+        // Give other peers a chance before this one is picked again
+        mPeerManager.update(peer->getAddress(),
+                            PeerManager::BackOffUpdate::INCREASE);
+        peer->sendErrorAndDrop(ERR_LOAD, "rotating out lagging peer");
+    }
+}
+
 // called every PEER_AUTHENTICATION_TIMEOUT + 1=3 seconds
 void
 OverlayManagerImpl::tick()
@@ -750,6 +851,10 @@ OverlayManagerImpl::tick()
     bool shouldDrop =
         availableAuthenticatedSlots == 0 && availablePendingSlots > 0;
     updateTimerAndMaybeDropRandomPeer(shouldDrop);
+    if (shouldDrop)
+    {
+        maybeRotateLaggingPeer();
+    }
 
     availableAuthenticatedSlots = availableOutboundAuthenticatedSlots();
 
@@ -845,6 +950,7 @@ void
 OverlayManagerImpl::clearLedgersBelow(uint32_t ledgerSeq, uint32_t lclSeq)
 {
     mFloodGate.clearBelow(ledgerSeq);
+    mTxDemandsManager.clearBelow(lclSeq);
     mSurveyManager->clearOldLedgers(lclSeq);
     for (auto const& peer : getAuthenticatedPeers())
     {
@@ -972,6 +1078,7 @@ OverlayManagerImpl::removePeer(Peer* peer)
     releaseAssert(threadIsMain());
     ZoneScoped;
     getPeersList(peer).removePeer(peer);
+    mFloodGate.removePeer(*peer);
     getPeerManager().removePeersWithManyFailures(
         Config::REALLY_DEAD_NUM_FAILURES_CUTOFF, &peer->getAddress());
     updateSizeCounters();
@@ -1146,19 +1253,38 @@ OverlayManagerImpl::recvFloodedMsgID(StellarMessage const& msg,
     return mFloodGate.addRecord(msg, peer, msgID);
 }
 
+bool
+OverlayManagerImpl::recvFloodedMsgHash(Hash const& msgID, Peer::pointer peer)
+{
+    ZoneScoped;
+    return mFloodGate.addRecord(msgID, peer);
+}
+
 void
 OverlayManagerImpl::recvTransaction(StellarMessage const& msg,
-                                    Peer::pointer peer)
+                                    Peer::pointer peer,
+                                    TransactionFrameBasePtr preparedTx,
+                                    std::optional<Hash> const& precomputedID)
 {
     ZoneScoped;
-    auto transaction = TransactionFrameBase::makeTransactionFromWire(
-        mApp.getNetworkID(), msg.transaction());
+    auto transaction =
+        preparedTx ? preparedTx
+                   : TransactionFrameBase::makeTransactionFromWire(
+                         mApp.getNetworkID(), msg.transaction());
     if (transaction)
     {
         // record that this peer sent us this transaction
         // add it to the floodmap so that this peer gets credit for it
         Hash msgID;
-        recvFloodedMsgID(msg, peer, msgID);
+        if (precomputedID)
+        {
+            msgID = *precomputedID;
+            recvFloodedMsgHash(msgID, peer);
+        }
+        else
+        {
+            recvFloodedMsgID(msg, peer, msgID);
+        }
 
         mTxDemandsManager.recordTxPullLatency(transaction->getFullHash(), peer);
 
@@ -1203,6 +1329,12 @@ OverlayManagerImpl::forgetFloodedMsg(Hash const& msgID)
     mFloodGate.forgetRecord(msgID);
 }
 
+void
+OverlayManagerImpl::addMemoryFootprint(MemoryFootprint& footprint) const
+{
+    footprint["overlay.floodgate"] = mFloodGate.getEstimatedBytes();
+}
+
 void
 OverlayManagerImpl::recvTxDemand(FloodDemand const& dmd, Peer::pointer peer)
 {
@@ -1242,7 +1374,13 @@ OverlayManagerImpl::getOverlayMetrics()
     return mOverlayMetrics;
 }
 
-PeerAuth&
+std::shared_ptr<SerializedMessageCache>
+OverlayManagerImpl::getSerializedMessageCache()
+{
+    return mSerializedMessageCache;
+}
+
+std::shared_ptr<PeerAuth>
 OverlayManagerImpl::getPeerAuth()
 {
     return mAuth;
@@ -1280,6 +1418,8 @@ OverlayManagerImpl::shutdown()
     // Stop ticking and resolving peers
     mTimer.cancel();
     mPeerIPTimer.cancel();
+
+    mPeerManager.flush();
 }
 
 bool
@@ -1330,6 +1470,10 @@ OverlayManagerImpl::recordMessageMetric(StellarMessage const& stellarMsg,
 
             peerMetrics.mDuplicateFloodBytesRecv += size;
             ++peerMetrics.mDuplicateFloodMessageRecv;
+            if (stellarMsg.type() == SCP_MESSAGE)
+            {
+                ++peerMetrics.mDuplicateScpMessageRecv;
+            }
 
             logMessage(false, "flood");
         }
@@ -1354,6 +1498,10 @@ OverlayManagerImpl::recordMessageMetric(StellarMessage const& stellarMsg,
 
             peerMetrics.mUniqueFloodBytesRecv += size;
             ++peerMetrics.mUniqueFloodMessageRecv;
+            if (stellarMsg.type() == SCP_MESSAGE)
+            {
+                ++peerMetrics.mUniqueScpMessageRecv;
+            }
 
             logMessage(true, "flood");
         }
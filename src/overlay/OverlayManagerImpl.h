@@ -13,6 +13,7 @@
 #include "overlay/Floodgate.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
+#include "overlay/SerializedMessageCache.h"
 #include "overlay/SurveyManager.h"
 #include "overlay/TxDemandsManager.h"
 #include "util/Timer.h"
@@ -81,19 +82,28 @@ class OverlayManagerImpl : public OverlayManager
 
     PeerManager mPeerManager;
     PeerDoor mDoor;
-    PeerAuth mAuth;
+    std::shared_ptr<PeerAuth> mAuth;
     std::atomic<bool> mShuttingDown;
 
     OverlayMetrics mOverlayMetrics;
+    std::shared_ptr<SerializedMessageCache> mSerializedMessageCache;
 
     // NOTE: bool is used here as a placeholder, since no ValueType is needed.
     RandomEvictionCache<uint64_t, bool> mMessageCache;
 
     void tick();
     void updateTimerAndMaybeDropRandomPeer(bool shouldDrop);
+    // Non-preferred outbound peer connected for at least minLifeTime with the
+    // lowest score (see PeerScore.h), if any. With maxScoreFraction, only if
+    // its score is below that fraction of the median outbound score.
+    Peer::pointer getLowestScoringOutboundPeer(
+        std::chrono::seconds minLifeTime,
+        std::optional<double> maxScoreFraction = std::nullopt);
+    void maybeRotateLaggingPeer();
     VirtualTimer mTimer;
     VirtualTimer mPeerIPTimer;
     std::optional<VirtualClock::time_point> mLastOutOfSyncReconnect;
+    std::optional<VirtualClock::time_point> mLastPeerRotation;
 
     friend class OverlayManagerTests;
     friend class Simulation;
@@ -114,9 +124,12 @@ class OverlayManagerImpl : public OverlayManager
     void clearLedgersBelow(uint32_t ledgerSeq, uint32_t lclSeq) override;
     bool recvFloodedMsgID(StellarMessage const& msg, Peer::pointer peer,
                           Hash& msgID) override;
-    void recvTransaction(StellarMessage const& msg,
-                         Peer::pointer peer) override;
+    bool recvFloodedMsgHash(Hash const& msgID, Peer::pointer peer) override;
+    void recvTransaction(StellarMessage const& msg, Peer::pointer peer,
+                         TransactionFrameBasePtr preparedTx,
+                         std::optional<Hash> const& msgID) override;
     void forgetFloodedMsg(Hash const& msgID) override;
+    void addMemoryFootprint(MemoryFootprint& footprint) const override;
     void recvTxDemand(FloodDemand const& dmd, Peer::pointer peer) override;
     bool broadcastMessage(std::shared_ptr<StellarMessage const> msg,
                           std::optional<Hash> const hash = std::nullopt,
@@ -155,7 +168,9 @@ class OverlayManagerImpl : public OverlayManager
     std::set<Peer::pointer> getPeersKnows(Hash const& h) override;
 
     OverlayMetrics& getOverlayMetrics() override;
-    PeerAuth& getPeerAuth() override;
+    std::shared_ptr<PeerAuth> getPeerAuth() override;
+    std::shared_ptr<SerializedMessageCache>
+    getSerializedMessageCache() override;
 
     PeerManager& getPeerManager() override;
 
@@ -1,7 +1,11 @@
 #include "overlay/OverlayMetrics.h"
 #include "main/Application.h"
+#include "main/Config.h"
 
+#include "medida/histogram.h"
 #include "medida/metrics_registry.h"
+#include "medida/timer.h"
+#include <cctype>
 
 namespace stellar
 {
@@ -35,8 +39,13 @@ OverlayMetrics::OverlayMetrics(Application& app)
     , mConnectionFloodThrottle(app.getMetrics().NewTimer(
           {"overlay", "connection", "flood-throttle"}))
 
+    , mOutboundRotate(app.getMetrics().NewMeter(
+          {"overlay", "outbound", "rotate"}, "connection"))
+
     , mItemFetcherNextPeer(app.getMetrics().NewMeter(
           {"overlay", "item-fetcher", "next-peer"}, "item-fetcher"))
+    , mItemFetchPeerLatency(
+          app.getMetrics().NewTimer({"overlay", "fetch", "peer-latency"}))
 
     , mRecvErrorTimer(app.getMetrics().NewTimer({"overlay", "recv", "error"}))
     , mRecvHelloTimer(app.getMetrics().NewTimer({"overlay", "recv", "hello"}))
@@ -106,6 +115,14 @@ OverlayMetrics::OverlayMetrics(Application& app)
           {"overlay", "outbound-queue", "drop-advert"}, "message"))
     , mOutboundQueueDropDemand(app.getMetrics().NewMeter(
           {"overlay", "outbound-queue", "drop-demand"}, "message"))
+    , mOutboundQueueDepthSCP(app.getMetrics().NewCounter(
+          {"overlay", "outbound-queue", "depth-scp"}))
+    , mOutboundQueueDepthTxs(app.getMetrics().NewCounter(
+          {"overlay", "outbound-queue", "depth-tx"}))
+    , mOutboundQueueDepthAdvert(app.getMetrics().NewCounter(
+          {"overlay", "outbound-queue", "depth-advert"}))
+    , mOutboundQueueDepthDemand(app.getMetrics().NewCounter(
+          {"overlay", "outbound-queue", "depth-demand"}))
     , mSendErrorMeter(
           app.getMetrics().NewMeter({"overlay", "send", "error"}, "message"))
     , mSendHelloMeter(
@@ -168,6 +185,10 @@ OverlayMetrics::OverlayMetrics(Application& app)
           {"overlay", "flood", "irrelevant-txs"}, "transaction"))
     , mAbandonedDemandMeter(app.getMetrics().NewMeter(
           {"overlay", "flood", "abandoned-demands"}, "message"))
+    , mDemandTickTimer(
+          app.getMetrics().NewTimer({"overlay", "demand", "tick"}))
+    , mKnownAdvertSkip(app.getMetrics().NewMeter(
+          {"overlay", "demand", "known-skip"}, "hash"))
     , mMessagesBroadcast(app.getMetrics().NewMeter(
           {"overlay", "message", "broadcast"}, "message"))
     , mPendingPeersSize(
@@ -182,6 +203,96 @@ OverlayMetrics::OverlayMetrics(Application& app)
           {"overlay", "fetch", "unique-recv"}, "byte"))
     , mDuplicateFetchBytesRecv(app.getMetrics().NewMeter(
           {"overlay", "fetch", "duplicate-recv"}, "byte"))
+    , mRecvBatchSize(app.getMetrics().NewHistogram(
+          {"overlay", "recv-batch", "size"}))
+    , mSendChannelBatchSize(app.getMetrics().NewHistogram(
+          {"overlay", "send-channel", "batch"}))
+    , mSendChannelFull(app.getMetrics().NewMeter(
+          {"overlay", "send-channel", "full"}, "message"))
+    , mWriteBatchMessages(app.getMetrics().NewHistogram(
+          {"overlay", "write-batch", "messages"}))
+    , mWriteBatchBytes(app.getMetrics().NewHistogram(
+          {"overlay", "write-batch", "bytes"}))
+    , mCompressTimer(
+          app.getMetrics().NewTimer({"overlay", "compression", "compress"}))
+    , mDecompressTimer(
+          app.getMetrics().NewTimer({"overlay", "compression", "decompress"}))
+    , mCompressionBytesIn(app.getMetrics().NewMeter(
+          {"overlay", "compression", "uncompressed-bytes"}, "byte"))
+    , mCompressionBytesOut(app.getMetrics().NewMeter(
+          {"overlay", "compression", "compressed-bytes"}, "byte"))
+    , mCompressionRatio(app.getMetrics().NewHistogram(
+          {"overlay", "compression", "ratio"}))
+    , mMessageTypeTimingEnabled(
+          app.getConfig().ENABLE_OVERLAY_MESSAGE_TYPE_TIMING)
+{
+    if (!mMessageTypeTimingEnabled)
+    {
+        return;
+    }
+    static char const* const phaseNames[] = {"decode", "verify", "handle",
+                                             "send"};
+    for (size_t type = 0; type < MAX_TIMED_MESSAGE_TYPE; ++type)
+    {
+        auto name = xdr::xdr_traits<MessageType>::enum_name(
+            static_cast<MessageType>(type));
+        if (name == nullptr)
+        {
+            continue;
+        }
+        std::string typeName(name);
+        for (auto& c : typeName)
+        {
+            c = c == '_' ? '-' : static_cast<char>(std::tolower(c));
+        }
+        for (size_t phase = 0; phase < mMessagePhaseTimers[type].size();
+             ++phase)
+        {
+            mMessagePhaseTimers[type][phase] = &app.getMetrics().NewTimer(
+                {"overlay", "cpu", typeName + "." + phaseNames[phase]});
+        }
+    }
+}
+
+medida::Timer*
+OverlayMetrics::getMessagePhaseTimer(MessageType type,
+                                     MessagePhase phase) const
+{
+    auto index = static_cast<size_t>(type);
+    if (!mMessageTypeTimingEnabled || index >= MAX_TIMED_MESSAGE_TYPE)
+    {
+        return nullptr;
+    }
+    return mMessagePhaseTimers[index][static_cast<size_t>(phase)];
+}
+
+void
+OverlayMetrics::recordMessagePhase(MessageType type, MessagePhase phase,
+                                   std::chrono::nanoseconds duration) const
+{
+    if (auto timer = getMessagePhaseTimer(type, phase))
+    {
+        timer->Update(duration);
+    }
+}
+
+MessagePhaseTimer::MessagePhaseTimer(OverlayMetrics const& metrics,
+                                     MessageType type,
+                                     OverlayMetrics::MessagePhase phase)
+{
+    if (auto timer = metrics.getMessagePhaseTimer(type, phase))
+    {
+        mContext = std::make_unique<medida::TimerContext>(*timer);
+    }
+}
+
+MessagePhaseTimer::~MessagePhaseTimer()
+{
+}
+
+void
+MessagePhaseTimer::stop()
 {
+    mContext.reset();
 }
 }
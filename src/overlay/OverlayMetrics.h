@@ -7,11 +7,18 @@
 // This structure just exists to cache frequently-accessed, overlay-wide
 // (non-peer-specific) metrics.
 
+#include "xdr/Stellar-overlay.h"
+#include <array>
+#include <chrono>
+#include <memory>
+
 namespace medida
 {
 class Timer;
+class TimerContext;
 class Meter;
 class Counter;
+class Histogram;
 }
 
 namespace stellar
@@ -37,7 +44,10 @@ struct OverlayMetrics
     medida::Timer& mConnectionReadThrottle;
     medida::Timer& mConnectionFloodThrottle;
 
+    medida::Meter& mOutboundRotate;
+
     medida::Meter& mItemFetcherNextPeer;
+    medida::Timer& mItemFetchPeerLatency;
 
     medida::Timer& mRecvErrorTimer;
     medida::Timer& mRecvHelloTimer;
@@ -78,6 +88,10 @@ struct OverlayMetrics
     medida::Meter& mOutboundQueueDropTxs;
     medida::Meter& mOutboundQueueDropAdvert;
     medida::Meter& mOutboundQueueDropDemand;
+    medida::Counter& mOutboundQueueDepthSCP;
+    medida::Counter& mOutboundQueueDepthTxs;
+    medida::Counter& mOutboundQueueDepthAdvert;
+    medida::Counter& mOutboundQueueDepthDemand;
 
     medida::Meter& mSendErrorMeter;
     medida::Meter& mSendHelloMeter;
@@ -114,6 +128,8 @@ struct OverlayMetrics
     medida::Meter& mPulledIrrelevantTxs;
 
     medida::Meter& mAbandonedDemandMeter;
+    medida::Timer& mDemandTickTimer;
+    medida::Meter& mKnownAdvertSkip;
 
     medida::Meter& mMessagesBroadcast;
     medida::Counter& mPendingPeersSize;
@@ -123,5 +139,60 @@ struct OverlayMetrics
     medida::Meter& mDuplicateFloodBytesRecv;
     medida::Meter& mUniqueFetchBytesRecv;
     medida::Meter& mDuplicateFetchBytesRecv;
+
+    medida::Histogram& mRecvBatchSize;
+    medida::Histogram& mSendChannelBatchSize;
+    medida::Meter& mSendChannelFull;
+    medida::Histogram& mWriteBatchMessages;
+    medida::Histogram& mWriteBatchBytes;
+
+    medida::Timer& mCompressTimer;
+    medida::Timer& mDecompressTimer;
+    medida::Meter& mCompressionBytesIn;
+    medida::Meter& mCompressionBytesOut;
+    medida::Histogram& mCompressionRatio;
+
+    // Opt-in (ENABLE_OVERLAY_MESSAGE_TYPE_TIMING) breakdown of the time spent
+    // on each message type, by processing phase
+    enum class MessagePhase
+    {
+        DECODE,  // decompressing and decoding from the wire
+        VERIFY,  // checking the MAC and signatures, preparing transactions
+        HANDLE,  // processing on the main thread
+        SEND,    // encoding, MAC-ing and queueing for write
+        NUM_PHASES
+    };
+
+    bool
+    isMessageTypeTimingEnabled() const
+    {
+        return mMessageTypeTimingEnabled;
+    }
+    // Returns nullptr when timing is disabled or `type` is unknown
+    medida::Timer* getMessagePhaseTimer(MessageType type,
+                                        MessagePhase phase) const;
+    void recordMessagePhase(MessageType type, MessagePhase phase,
+                            std::chrono::nanoseconds duration) const;
+
+  private:
+    static constexpr size_t MAX_TIMED_MESSAGE_TYPE = 32;
+    bool const mMessageTypeTimingEnabled;
+    std::array<std::array<medida::Timer*,
+                          static_cast<size_t>(MessagePhase::NUM_PHASES)>,
+               MAX_TIMED_MESSAGE_TYPE>
+        mMessagePhaseTimers{};
+};
+
+// Times one phase of processing a message, when per-type timing is enabled
+class MessagePhaseTimer
+{
+    std::unique_ptr<medida::TimerContext> mContext;
+
+  public:
+    MessagePhaseTimer(OverlayMetrics const& metrics, MessageType type,
+                      OverlayMetrics::MessagePhase phase);
+    ~MessagePhaseTimer();
+    // Stop timing before going out of scope
+    void stop();
 };
 }
@@ -5,6 +5,7 @@
 #include "overlay/Peer.h"
 
 #include "BanManager.h"
+#include "crypto/BLAKE2.h"
 #include "crypto/CryptoError.h"
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
@@ -17,24 +18,30 @@
 #include "main/Application.h"
 #include "main/Config.h"
 #include "overlay/FlowControl.h"
+#include "overlay/MessageCompression.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
 #include "overlay/PeerAuth.h"
 #include "overlay/PeerManager.h"
+#include "overlay/SerializedMessageCache.h"
 #include "overlay/SurveyDataManager.h"
 #include "overlay/SurveyManager.h"
 #include "overlay/TxAdverts.h"
+#include "transactions/TransactionFrameBase.h"
+#include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
+#include "util/XDRMarshal.h"
 #include "util/finally.h"
 
+#include "medida/histogram.h"
 #include "medida/meter.h"
 #include "medida/timer.h"
 #include "xdrpp/marshal.h"
 #include <fmt/format.h>
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <soci.h>
 #include <time.h>
 
@@ -45,6 +52,10 @@ namespace stellar
 {
 
 static std::string const AUTH_ACTION_QUEUE = "AUTH";
+// SCP envelopes of nodes of the transitive quorum outside of the local quorum
+// set, and of nodes outside of the transitive quorum
+static std::string const SCP_TRANSITIVE_ACTION_QUEUE = "SCP-TRANSITIVE";
+static std::string const SCP_OTHER_ACTION_QUEUE = "SCP-OTHER";
 using namespace std;
 using namespace soci;
 
@@ -61,6 +72,9 @@ Peer::Peer(Application& app, PeerRole role)
     , mEnqueueTimeOfLastWrite(app.getClock().now())
     , mRole(role)
     , mOverlayMetrics(app.getOverlayManager().getOverlayMetrics())
+    , mSerializedMessageCache(
+          app.getOverlayManager().getSerializedMessageCache())
+    , mPeerAuth(app.getOverlayManager().getPeerAuth())
     , mPeerMetrics(app.getClock().now())
     , mState(role == WE_CALLED_REMOTE ? CONNECTING : CONNECTED)
     , mRemoteOverlayMinVersion(0)
@@ -78,8 +92,8 @@ Peer::Peer(Application& app, PeerRole role)
 }
 
 Peer::MsgCapacityTracker::MsgCapacityTracker(std::weak_ptr<Peer> peer,
-                                             StellarMessage const& msg)
-    : mWeakPeer(peer), mMsg(msg)
+                                             StellarMessage&& msg)
+    : mWeakPeer(peer), mMsg(std::move(msg))
 {
     auto self = mWeakPeer.lock();
     if (!self)
@@ -104,6 +118,26 @@ Peer::MsgCapacityTracker::getMessage()
     return mMsg;
 }
 
+void
+Peer::MsgCapacityTracker::setPrepared(TransactionFrameBasePtr tx,
+                                      std::optional<Hash> floodMsgID)
+{
+    mPreparedTx = std::move(tx);
+    mFloodMsgID = std::move(floodMsgID);
+}
+
+TransactionFrameBasePtr
+Peer::MsgCapacityTracker::getPreparedTransaction() const
+{
+    return mPreparedTx;
+}
+
+std::optional<Hash> const&
+Peer::MsgCapacityTracker::getFloodMsgID() const
+{
+    return mFloodMsgID;
+}
+
 void
 Peer::sendHello()
 {
@@ -179,7 +213,7 @@ AuthCert
 Peer::getAuthCert()
 {
     releaseAssert(threadIsMain());
-    return mAppConnector.getOverlayManager().getPeerAuth().getAuthCert();
+    return mPeerAuth->getAuthCert();
 }
 
 std::chrono::seconds
@@ -347,6 +381,8 @@ Peer::getJsonInfo(bool compact) const
             mPeerMetrics.mPullLatency.GetSnapshot().get75thPercentile());
         res["pull_mode"]["demand_timeouts"] =
             static_cast<Json::UInt64>(mPeerMetrics.mDemandTimeouts);
+        res["fetch_latency_p75"] = static_cast<Json::UInt64>(
+            mPeerMetrics.mFetchLatency.GetSnapshot().get75thPercentile());
         res["message_read"] =
             static_cast<Json::UInt64>(mPeerMetrics.mMessageRead);
         res["message_write"] =
@@ -376,6 +412,10 @@ Peer::getJsonInfo(bool compact) const
             static_cast<Json::UInt64>(mPeerMetrics.mUniqueFetchMessageRecv);
         res["duplicate_fetch_message_recv"] =
             static_cast<Json::UInt64>(mPeerMetrics.mDuplicateFetchMessageRecv);
+        res["unique_scp_message_recv"] =
+            static_cast<Json::UInt64>(mPeerMetrics.mUniqueScpMessageRecv);
+        res["duplicate_scp_message_recv"] =
+            static_cast<Json::UInt64>(mPeerMetrics.mDuplicateScpMessageRecv);
     }
 
     return res;
@@ -393,6 +433,13 @@ Peer::sendAuth()
     {
         msg.auth().flags = AUTH_MSG_FLAG_FLOW_CONTROL_BYTES_REQUESTED;
     }
+    if (shouldRequestCompression())
+    {
+        // Accept compressed messages before the remote peer can possibly
+        // send any
+        mAcceptCompressed = true;
+        msg.auth().flags |= AUTH_MSG_FLAG_COMPRESSION_REQUESTED;
+    }
     auto msgPtr = std::make_shared<StellarMessage const>(msg);
     sendMessage(msgPtr);
 }
@@ -504,6 +551,7 @@ Peer::sendGetTxSet(uint256 const& setID)
     newMsg.type(GET_TX_SET);
     newMsg.txSetHash() = setID;
 
+    recordFetchRequest(setID);
     auto msgPtr = std::make_shared<StellarMessage const>(newMsg);
     sendMessage(msgPtr);
 }
@@ -517,6 +565,7 @@ Peer::sendGetQuorumSet(uint256 const& setID)
     newMsg.type(GET_SCP_QUORUMSET);
     newMsg.qSetHash() = setID;
 
+    recordFetchRequest(setID);
     auto msgPtr = std::make_shared<StellarMessage const>(newMsg);
     sendMessage(msgPtr);
 }
@@ -814,23 +863,112 @@ Peer::sendAuthenticatedMessage(std::shared_ptr<StellarMessage const> msg)
         }
     }
 
-    auto cb = [msg](std::shared_ptr<Peer> self) {
-        // Construct an authenticated message and place it in the queue
-        // _synchronously_ This is important because we assign auth sequence to
-        // each message, which must be ordered
+    if (useBackgroundThread() && threadIsMain())
+    {
+        pushToSendChannel(std::move(msg));
+    }
+    else
+    {
+        // If we're already on the background thread (i.e. via flow control),
+        // move msg to the queue right away
+        authenticateAndSend(msg);
+    }
+}
+
+void
+Peer::authenticateAndSend(std::shared_ptr<StellarMessage const> const& msg)
+{
+    MessagePhaseTimer phaseTimer(mOverlayMetrics, msg->type(),
+                                 OverlayMetrics::MessagePhase::SEND);
+    // Construct an authenticated message and place it in the queue
+    // _synchronously_ This is important because we assign auth sequence to
+    // each message, which must be ordered
+    xdr::msg_ptr xdrBytes;
+    if (auto body = mSerializedMessageCache->maybeGet(*msg))
+    {
+        // Broadcast message already encoded once for all peers; only
+        // frame it with our own sequence number and MAC
+        xdrBytes = mHmac.authenticateSerializedMessage(*msg, *body);
+    }
+    else
+    {
         AuthenticatedMessage amsg;
-        self->mHmac.setAuthenticatedMessageBody(amsg, *msg);
-        xdr::msg_ptr xdrBytes;
-        {
-            ZoneNamedN(xdrZone, "XDR serialize", true);
-            xdrBytes = xdr::xdr_to_msg(amsg);
-        }
-        self->sendMessage(std::move(xdrBytes));
-    };
+        mHmac.setAuthenticatedMessageBody(amsg, *msg);
+        ZoneNamedN(xdrZone, "XDR serialize", true);
+        xdrBytes = xdrToMsg(amsg);
+    }
+    auto type = msg->type();
+    xdrBytes = maybeCompress(type, std::move(xdrBytes));
+    // Only transaction flooding traffic may be held back for batching;
+    // consensus and control messages go out right away
+    bool canDelay =
+        type == TRANSACTION || type == FLOOD_ADVERT || type == FLOOD_DEMAND;
+    sendMessage(std::move(xdrBytes), canDelay);
+}
+
+void
+Peer::pushToSendChannel(std::shared_ptr<StellarMessage const>&& msg)
+{
+    releaseAssert(threadIsMain());
+    // Once a send had to wait, later ones wait behind it to stay in order
+    if (!mSendOverflow.empty() || !mSendChannel.tryPush(msg))
+    {
+        mOverlayMetrics.mSendChannelFull.Mark();
+        mSendOverflow.emplace_back(std::move(msg));
+        mSendOverflowed = true;
+    }
+    postSendChannelDrain();
+}
+
+void
+Peer::postSendChannelDrain()
+{
+    if (!mSendDrainPosted.exchange(true))
+    {
+        mAppConnector.postOnOverlayThread(
+            [self = shared_from_this()]() { self->drainSendChannel(); },
+            "Peer::drainSendChannel");
+    }
+}
+
+void
+Peer::drainSendChannel()
+{
+    ZoneScoped;
+    releaseAssert(!threadIsMain());
+    // Cleared first, so that a send racing with the drain below posts another
+    // one rather than being left behind
+    mSendDrainPosted = false;
+    auto n = mSendChannel.popBatch(
+        [&](std::shared_ptr<StellarMessage const> msg) {
+            authenticateAndSend(msg);
+        });
+    if (n > 0)
+    {
+        mOverlayMetrics.mSendChannelBatchSize.Update(n);
+    }
+    if (mSendOverflowed.exchange(false))
+    {
+        mAppConnector.postOnMainThread(
+            [self = shared_from_this()]() { self->flushSendOverflow(); },
+            "Peer::flushSendOverflow");
+    }
+}
 
-    // If we're already on the background thread (i.e. via flow control), move
-    // msg to the queue right away
-    maybeExecuteInBackground("sendAuthenticatedMessage", cb);
+void
+Peer::flushSendOverflow()
+{
+    releaseAssert(threadIsMain());
+    while (!mSendOverflow.empty() &&
+           mSendChannel.tryPush(mSendOverflow.front()))
+    {
+        mSendOverflow.pop_front();
+    }
+    if (!mSendOverflow.empty())
+    {
+        mSendOverflowed = true;
+    }
+    postSendChannelDrain();
 }
 
 bool
@@ -880,6 +1018,82 @@ Peer::shouldAbort(RecursiveLockGuard const& stateGuard) const
     return mState == CLOSING || mAppConnector.overlayShuttingDown();
 }
 
+bool
+Peer::shouldRequestCompression() const
+{
+    auto const& cfg = mAppConnector.getConfig();
+    return MessageCompression::isSupported() &&
+           cfg.OVERLAY_COMPRESSION_LEVEL > 0 &&
+           cfg.OVERLAY_PROTOCOL_VERSION >=
+               FIRST_VERSION_SUPPORTING_COMPRESSION &&
+           getRemoteOverlayVersion() >= FIRST_VERSION_SUPPORTING_COMPRESSION;
+}
+
+xdr::msg_ptr
+Peer::maybeCompress(MessageType type, xdr::msg_ptr&& msg)
+{
+    int level = mCompressionLevel;
+    if (level == 0 || !MessageCompression::shouldCompress(type, msg->size()))
+    {
+        return std::move(msg);
+    }
+    xdr::msg_ptr compressed;
+    {
+        auto timer = mOverlayMetrics.mCompressTimer.TimeScope();
+        compressed = MessageCompression::compress(msg, level);
+    }
+    if (!compressed)
+    {
+        return std::move(msg);
+    }
+    mOverlayMetrics.mCompressionBytesIn.Mark(msg->size());
+    mOverlayMetrics.mCompressionBytesOut.Mark(compressed->size());
+    mOverlayMetrics.mCompressionRatio.Update(compressed->size() * 100 /
+                                             msg->size());
+    return compressed;
+}
+
+void
+Peer::decodeAuthenticatedMessage(uint8_t const* data, size_t size,
+                                 AuthenticatedMessage& am)
+{
+    ZoneScoped;
+    // The type is only known once decoded, so time by hand
+    std::optional<std::chrono::steady_clock::time_point> start;
+    if (mOverlayMetrics.isMessageTypeTimingEnabled())
+    {
+        start = std::chrono::steady_clock::now();
+    }
+
+    if (!MessageCompression::isCompressed(data, size))
+    {
+        xdr::xdr_get g(data, data + size);
+        xdr::xdr_argpack_archive(g, am);
+    }
+    else
+    {
+        if (!mAcceptCompressed)
+        {
+            throw xdr::xdr_runtime_error("unexpected compressed message");
+        }
+        std::vector<uint8_t> body;
+        {
+            auto timer = mOverlayMetrics.mDecompressTimer.TimeScope();
+            body =
+                MessageCompression::decompress(data, size, MAX_MESSAGE_SIZE);
+        }
+        xdr::xdr_get g(body.data(), body.data() + body.size());
+        xdr::xdr_argpack_archive(g, am);
+    }
+
+    if (start)
+    {
+        mOverlayMetrics.recordMessagePhase(
+            am.v0().message.type(), OverlayMetrics::MessagePhase::DECODE,
+            std::chrono::steady_clock::now() - *start);
+    }
+}
+
 bool
 Peer::recvAuthenticatedMessage(AuthenticatedMessage&& msg)
 {
@@ -892,11 +1106,14 @@ Peer::recvAuthenticatedMessage(AuthenticatedMessage&& msg)
         return false;
     }
 
+    MessagePhaseTimer verifyTimer(mOverlayMetrics, msg.v0().message.type(),
+                                  OverlayMetrics::MessagePhase::VERIFY);
     std::string errorMsg;
     if (getState(guard) >= GOT_HELLO && msg.v0().message.type() != ERROR_MSG)
     {
         if (!mHmac.checkAuthenticatedMessage(msg, errorMsg))
         {
+            flushRecvBatch();
             if (!threadIsMain())
             {
                 mAppConnector.postOnMainThread(
@@ -913,6 +1130,12 @@ Peer::recvAuthenticatedMessage(AuthenticatedMessage&& msg)
         }
     }
 
+    // Do the expensive part of the handshake when in the background
+    if (useBackgroundThread() && msg.v0().message.type() == HELLO)
+    {
+        mPeerAuth->prepareHandshake(msg.v0().message.hello(), mRole);
+    }
+
     // Verify SCP signatures when in the background
     if (useBackgroundThread() && msg.v0().message.type() == SCP_MESSAGE)
     {
@@ -922,13 +1145,33 @@ Peer::recvAuthenticatedMessage(AuthenticatedMessage&& msg)
                                                   envelope.statement));
     }
 
-    // NOTE: Additionally, we may use state snapshots to verify TRANSACTION type
-    // messages in the background.
+    // Build and verify transactions when in the background too, reading the
+    // signers of their accounts from a state snapshot, and hash flooded
+    // messages for the Floodgate. Admission to the transaction queue and
+    // Floodgate bookkeeping still happen on the main thread.
+    TransactionFrameBasePtr preparedTx;
+    std::optional<Hash> floodMsgID;
+    if (useBackgroundThread())
+    {
+        auto const& stellarMsg = msg.v0().message;
+        if (stellarMsg.type() == TRANSACTION)
+        {
+            preparedTx = prepareTransaction(stellarMsg.transaction());
+        }
+        if (stellarMsg.type() == TRANSACTION ||
+            stellarMsg.type() == SCP_MESSAGE)
+        {
+            floodMsgID = xdrBlake2(stellarMsg);
+        }
+    }
+
+    verifyTimer.stop();
 
     // Start tracking capacity here, so read throttling is applied
     // appropriately. Flow control might not be started at that time
-    auto msgTracker = std::make_shared<MsgCapacityTracker>(shared_from_this(),
-                                                           msg.v0().message);
+    auto msgTracker = std::make_shared<MsgCapacityTracker>(
+        shared_from_this(), std::move(msg.v0().message));
+    msgTracker->setPrepared(std::move(preparedTx), std::move(floodMsgID));
 
     std::string cat;
     Scheduler::ActionType type = Scheduler::ActionType::NORMAL_ACTION;
@@ -970,9 +1213,18 @@ Peer::recvAuthenticatedMessage(AuthenticatedMessage&& msg)
     case TX_SET:
     case GENERALIZED_TX_SET:
     case SCP_QUORUMSET:
-    case SCP_MESSAGE:
         cat = "SCP";
         break;
+    case SCP_MESSAGE:
+    {
+        auto distances = mAppConnector.getQuorumDistances();
+        auto queue = getSCPEnvelopeQueue(
+            msgTracker->getMessage().envelope().statement.nodeID,
+            distances.get());
+        cat = queue.first;
+        type = queue.second;
+        break;
+    }
 
     default:
         cat = "MISC";
@@ -983,22 +1235,104 @@ Peer::recvAuthenticatedMessage(AuthenticatedMessage&& msg)
     // scheduler queue
     auto queueName = isAuthenticated(guard) ? cat : AUTH_ACTION_QUEUE;
     type = isAuthenticated(guard) ? type : Scheduler::ActionType::NORMAL_ACTION;
-    // Subtle: move `msgTracker` shared_ptr into the lambda, to ensure
-    // its destructor is invoked from main thread only. Note that we can't use
-    // unique_ptr here, because std::function requires its callable
-    // to be copyable (C++23 fixes this with std::move_only_function, but we're
-    // not there yet)
-    mAppConnector.postOnMainThread(
-        [self = shared_from_this(), t = std::move(msgTracker)]() {
-            self->recvMessage(t);
-        },
-        std::move(queueName), type);
+
+    if (useBackgroundThread())
+    {
+        // Coalesce consecutive messages bound for the same queue, so a socket
+        // buffer full of small messages costs one cross-thread post instead
+        // of one per message. Ordering is preserved: a change of queue flushes
+        // whatever was accumulated first.
+        if (!mRecvBatch.mMessages.empty() &&
+            (mRecvBatch.mQueueName != queueName || mRecvBatch.mType != type ||
+             mRecvBatch.mMessages.size() >= MAX_RECV_BATCH_SIZE))
+        {
+            flushRecvBatch();
+        }
+        mRecvBatch.mQueueName = std::move(queueName);
+        mRecvBatch.mType = type;
+        mRecvBatch.mMessages.emplace_back(std::move(msgTracker));
+    }
+    else
+    {
+        // Subtle: move `msgTracker` shared_ptr into the lambda, to ensure
+        // its destructor is invoked from main thread only. Note that we can't
+        // use unique_ptr here, because std::function requires its callable
+        // to be copyable (C++23 fixes this with std::move_only_function, but
+        // we're not there yet)
+        mAppConnector.postOnMainThread(
+            [self = shared_from_this(), t = std::move(msgTracker)]() {
+                self->recvMessage(t);
+            },
+            std::move(queueName), type);
+    }
 
     // msgTracker should be null now
     releaseAssert(!msgTracker);
     return true;
 }
 
+void
+Peer::flushRecvBatch()
+{
+    ZoneScoped;
+    RECURSIVE_LOCK_GUARD(mStateMutex, guard);
+    if (mRecvBatch.mMessages.empty())
+    {
+        return;
+    }
+
+    mOverlayMetrics.mRecvBatchSize.Update(mRecvBatch.mMessages.size());
+
+    // As above, the trackers are moved into the lambda so that they are only
+    // ever destroyed on the main thread
+    std::vector<std::shared_ptr<MsgCapacityTracker>> batch;
+    batch.swap(mRecvBatch.mMessages);
+    mAppConnector.postOnMainThread(
+        [self = shared_from_this(), batch = std::move(batch)]() {
+            for (auto const& t : batch)
+            {
+                self->recvMessage(t);
+            }
+        },
+        std::move(mRecvBatch.mQueueName), mRecvBatch.mType);
+    mRecvBatch.mQueueName.clear();
+}
+
+TransactionFrameBasePtr
+Peer::prepareTransaction(TransactionEnvelope const& env)
+{
+    ZoneScoped;
+    releaseAssert(!threadIsMain());
+    TransactionFrameBasePtr tx;
+    try
+    {
+        tx = TransactionFrameBase::makeTransactionFromWire(mNetworkID, env);
+        if (!tx)
+        {
+            return nullptr;
+        }
+        // Hashes are cached on first use; compute them here rather than on
+        // the main thread
+        tx->getFullHash();
+        tx->getContentsHash();
+        std::vector<EnvelopeSignatures> envelopes;
+        tx->insertSignaturesToVerify(envelopes);
+        std::shared_ptr<SearchableBucketListSnapshot> snapshot;
+        if (mAppConnector.getConfig().isUsingBucketListDB())
+        {
+            snapshot = mAppConnector.getSearchableBucketListSnapshot();
+        }
+        preVerifySignatures(envelopes, 0, envelopes.size(), snapshot.get());
+    }
+    catch (std::exception const& e)
+    {
+        // The main thread verifies whatever could not be verified here
+        CLOG_DEBUG(Overlay, "Could not pre-verify transaction from {}: {}",
+                   toString(), e.what());
+    }
+    return tx;
+}
+
 void
 Peer::recvMessage(std::shared_ptr<MsgCapacityTracker> msgTracker)
 {
@@ -1006,6 +1340,8 @@ Peer::recvMessage(std::shared_ptr<MsgCapacityTracker> msgTracker)
     releaseAssert(threadIsMain());
 
     auto const& stellarMsg = msgTracker->getMessage();
+    MessagePhaseTimer handleTimer(mOverlayMetrics, stellarMsg.type(),
+                                  OverlayMetrics::MessagePhase::HANDLE);
 
     // No need to hold the lock for the whole duration of the function, just
     // need to check state for a potential early exit. If the peer gets dropped
@@ -1194,7 +1530,8 @@ Peer::recvRawMessage(StellarMessage const& stellarMsg)
     case TRANSACTION:
     {
         auto t = mOverlayMetrics.mRecvTransactionTimer.TimeScope();
-        recvTransaction(stellarMsg);
+        recvTransaction(stellarMsg, msgTracker->getPreparedTransaction(),
+                        msgTracker->getFloodMsgID());
     }
     break;
 
@@ -1215,7 +1552,7 @@ Peer::recvRawMessage(StellarMessage const& stellarMsg)
     case SCP_MESSAGE:
     {
         auto t = mOverlayMetrics.mRecvSCPMessageTimer.TimeScope();
-        recvSCPMessage(stellarMsg);
+        recvSCPMessage(stellarMsg, msgTracker->getFloodMsgID());
     }
     break;
 
@@ -1261,6 +1598,7 @@ Peer::recvDontHave(StellarMessage const& msg)
     ZoneScoped;
     releaseAssert(threadIsMain());
     maybeProcessPingResponse(msg.dontHave().reqHash);
+    maybeProcessFetchResponse(msg.dontHave().reqHash, false);
 
     mAppConnector.getHerder().peerDoesntHave(
         msg.dontHave().type, msg.dontHave().reqHash, shared_from_this());
@@ -1311,6 +1649,7 @@ Peer::recvTxSet(StellarMessage const& msg)
     ZoneScoped;
     releaseAssert(threadIsMain());
     auto frame = TxSetXDRFrame::makeFromWire(msg.txSet());
+    maybeProcessFetchResponse(frame->getContentsHash(), true);
     mAppConnector.getHerder().recvTxSet(frame->getContentsHash(), frame);
 }
 
@@ -1320,23 +1659,53 @@ Peer::recvGeneralizedTxSet(StellarMessage const& msg)
     ZoneScoped;
     releaseAssert(threadIsMain());
     auto frame = TxSetXDRFrame::makeFromWire(msg.generalizedTxSet());
+    maybeProcessFetchResponse(frame->getContentsHash(), true);
     mAppConnector.getHerder().recvTxSet(frame->getContentsHash(), frame);
 }
 
 void
-Peer::recvTransaction(StellarMessage const& msg)
+Peer::recvTransaction(StellarMessage const& msg,
+                      TransactionFrameBasePtr preparedTx,
+                      std::optional<Hash> const& floodMsgID)
 {
     ZoneScoped;
     releaseAssert(threadIsMain());
-    mAppConnector.getOverlayManager().recvTransaction(msg, shared_from_this());
+    mAppConnector.getOverlayManager().recvTransaction(
+        msg, shared_from_this(), std::move(preparedTx), floodMsgID);
+}
+
+std::pair<std::string, Scheduler::ActionType>
+Peer::getSCPEnvelopeQueue(NodeID const& nodeID,
+                          QuorumTracker::NodeDistances const* distances)
+{
+    // Envelopes of the local quorum set keep the "SCP" queue to themselves.
+    // Those of the rest of the transitive quorum go to a queue of their own,
+    // which the scheduler serves in turn with the others, but are never shed:
+    // federated voting needs them to find quorums. Only envelopes of nodes
+    // outside of the transitive quorum are shed while overloaded.
+    if (distances)
+    {
+        auto it = distances->find(nodeID);
+        if (it == distances->end())
+        {
+            return {SCP_OTHER_ACTION_QUEUE,
+                    Scheduler::ActionType::DROPPABLE_ACTION};
+        }
+        else if (it->second > 1)
+        {
+            return {SCP_TRANSITIVE_ACTION_QUEUE,
+                    Scheduler::ActionType::NORMAL_ACTION};
+        }
+    }
+    return {"SCP", Scheduler::ActionType::NORMAL_ACTION};
 }
 
 Hash
 Peer::pingIDfromTimePoint(VirtualClock::time_point const& tp)
 {
     releaseAssert(threadIsMain());
-    auto sh = shortHash::xdrComputeHash(
-        xdr::xdr_to_opaque(uint64_t(tp.time_since_epoch().count())));
+    auto sh =
+        shortHash::xdrComputeHash(uint64_t(tp.time_since_epoch().count()));
     Hash res;
     releaseAssert(res.size() >= sizeof(sh));
     std::memcpy(res.data(), &sh, sizeof(sh));
@@ -1379,6 +1748,43 @@ Peer::maybeProcessPingResponse(Hash const& id)
     }
 }
 
+void
+Peer::recordFetchRequest(Hash const& hash)
+{
+    releaseAssert(threadIsMain());
+    // Requests to a peer that never answers would otherwise pile up
+    if (mFetchRequestsSent.size() >= MAX_FETCH_REQUESTS_TRACKED)
+    {
+        mFetchRequestsSent.clear();
+    }
+    mFetchRequestsSent.emplace(hash, mAppConnector.now());
+}
+
+void
+Peer::maybeProcessFetchResponse(Hash const& hash, bool received)
+{
+    releaseAssert(threadIsMain());
+    auto it = mFetchRequestsSent.find(hash);
+    if (it == mFetchRequestsSent.end())
+    {
+        return;
+    }
+    if (received)
+    {
+        auto latency = mAppConnector.now() - it->second;
+        mPeerMetrics.mFetchLatency.Update(latency);
+        mOverlayMetrics.mItemFetchPeerLatency.Update(latency);
+        mAppConnector.getOverlayManager().getSurveyManager().modifyNodeData(
+            [&](CollectingNodeData& nodeData) {
+                nodeData.mHistograms.mFetchLatencyMs.update(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        latency)
+                        .count());
+            });
+    }
+    mFetchRequestsSent.erase(it);
+}
+
 std::chrono::milliseconds
 Peer::getPing() const
 {
@@ -1419,11 +1825,13 @@ Peer::recvSCPQuorumSet(StellarMessage const& msg)
     releaseAssert(threadIsMain());
     Hash hash = xdrSha256(msg.qSet());
     maybeProcessPingResponse(hash);
+    maybeProcessFetchResponse(hash, true);
     mAppConnector.getHerder().recvSCPQuorumSet(hash, msg.qSet());
 }
 
 void
-Peer::recvSCPMessage(StellarMessage const& msg)
+Peer::recvSCPMessage(StellarMessage const& msg,
+                     std::optional<Hash> const& floodMsgID)
 {
     ZoneScoped;
     releaseAssert(threadIsMain());
@@ -1460,8 +1868,17 @@ Peer::recvSCPMessage(StellarMessage const& msg)
 
     // add it to the floodmap so that this peer gets credit for it
     Hash msgID;
-    mAppConnector.getOverlayManager().recvFloodedMsgID(msg, shared_from_this(),
-                                                       msgID);
+    if (floodMsgID)
+    {
+        msgID = *floodMsgID;
+        mAppConnector.getOverlayManager().recvFloodedMsgHash(
+            msgID, shared_from_this());
+    }
+    else
+    {
+        mAppConnector.getOverlayManager().recvFloodedMsgID(
+            msg, shared_from_this(), msgID);
+    }
 
     auto res = mAppConnector.getHerder().recvSCPEnvelope(envelope);
     if (res == Herder::ENVELOPE_STATUS_DISCARDED)
@@ -1573,8 +1990,7 @@ Peer::recvHello(Hello const& elo)
         return;
     }
 
-    auto& peerAuth = mAppConnector.getOverlayManager().getPeerAuth();
-    if (!peerAuth.verifyRemoteAuthCert(elo.peerID, elo.cert))
+    if (!mPeerAuth->verifyRemoteAuthCert(elo.peerID, elo.cert))
     {
         drop("failed to verify auth cert",
              Peer::DropDirection::WE_DROPPED_REMOTE);
@@ -1592,10 +2008,10 @@ Peer::recvHello(Hello const& elo)
     mRemoteVersion = elo.versionStr;
     mPeerID = elo.peerID;
     mRecvNonce = elo.nonce;
-    mHmac.setSendMackey(peerAuth.getSendingMacKey(elo.cert.pubkey, mSendNonce,
-                                                  mRecvNonce, mRole));
-    mHmac.setRecvMackey(peerAuth.getReceivingMacKey(elo.cert.pubkey, mSendNonce,
-                                                    mRecvNonce, mRole));
+    mHmac.setSendMackey(mPeerAuth->getSendingMacKey(
+        elo.cert.pubkey, mSendNonce, mRecvNonce, mRole));
+    mHmac.setRecvMackey(mPeerAuth->getReceivingMacKey(
+        elo.cert.pubkey, mSendNonce, mRecvNonce, mRole));
 
     setState(guard, GOT_HELLO);
 
@@ -1747,9 +2163,18 @@ Peer::recvAuth(StellarMessage const& msg)
              Peer::FIRST_VERSION_SUPPORTING_FLOW_CONTROL_IN_BYTES);
     bool bothWantBytes =
         enableBytes &&
-        msg.auth().flags == AUTH_MSG_FLAG_FLOW_CONTROL_BYTES_REQUESTED &&
+        (msg.auth().flags & ~AUTH_MSG_FLAG_COMPRESSION_REQUESTED) ==
+            AUTH_MSG_FLAG_FLOW_CONTROL_BYTES_REQUESTED &&
         mAppConnector.getConfig().ENABLE_FLOW_CONTROL_BYTES;
 
+    // Both sides have now sent AUTH, so we know whether the remote peer
+    // accepts compressed messages
+    if (mAcceptCompressed &&
+        (msg.auth().flags & AUTH_MSG_FLAG_COMPRESSION_REQUESTED) != 0)
+    {
+        mCompressionLevel = mAppConnector.getConfig().OVERLAY_COMPRESSION_LEVEL;
+    }
+
     std::optional<uint32_t> fcBytes =
         bothWantBytes
             ? std::optional<uint32_t>(mAppConnector.getOverlayManager()
@@ -1920,6 +2345,9 @@ Peer::PeerMetrics::PeerMetrics(VirtualClock::time_point connectedTime)
     , mPullLatency(medida::Timer(PEER_METRICS_DURATION_UNIT,
                                  PEER_METRICS_RATE_UNIT,
                                  PEER_METRICS_WINDOW_SIZE))
+    , mFetchLatency(medida::Timer(PEER_METRICS_DURATION_UNIT,
+                                  PEER_METRICS_RATE_UNIT,
+                                  PEER_METRICS_WINDOW_SIZE))
     , mDemandTimeouts(0)
     , mUniqueFloodBytesRecv(0)
     , mDuplicateFloodBytesRecv(0)
@@ -1929,6 +2357,8 @@ Peer::PeerMetrics::PeerMetrics(VirtualClock::time_point connectedTime)
     , mDuplicateFloodMessageRecv(0)
     , mUniqueFetchMessageRecv(0)
     , mDuplicateFetchMessageRecv(0)
+    , mUniqueScpMessageRecv(0)
+    , mDuplicateScpMessageRecv(0)
     , mTxHashReceived(0)
     , mConnectedTime(connectedTime)
     , mMessagesFulfilled(0)
@@ -11,9 +11,14 @@
 #include "overlay/Hmac.h"
 #include "overlay/OverlayAppConnector.h"
 #include "overlay/PeerBareAddress.h"
+#include "transactions/TransactionFrameBase.h"
+#include "util/Channel.h"
+#include "util/HashOfHash.h"
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
+#include "util/UnorderedMap.h"
 #include "xdrpp/message.h"
+#include <deque>
 
 namespace stellar
 {
@@ -36,6 +41,8 @@ static const uint32_t MAX_CLASSIC_TX_SIZE_BYTES = 100 * 1024;
 class Application;
 class LoopbackPeer;
 struct OverlayMetrics;
+class PeerAuth;
+class SerializedMessageCache;
 class FlowControl;
 class TxAdverts;
 
@@ -74,6 +81,10 @@ class Peer : public std::enable_shared_from_this<Peer>,
     static constexpr uint32_t FIRST_VERSION_SUPPORTING_FLOW_CONTROL_IN_BYTES =
         28;
     static constexpr uint32_t FIRST_VERSION_REQUIRED_FOR_PROTOCOL_20 = 32;
+    static constexpr uint32_t FIRST_VERSION_SUPPORTING_COMPRESSION = 35;
+    // Set in AUTH flags, on top of the flow control bytes flag, by nodes that
+    // accept compressed messages (see MessageCompression.h)
+    static constexpr int32_t AUTH_MSG_FLAG_COMPRESSION_REQUESTED = 0x10000;
 
     // The reporting will be based on the previous
     // PEER_METRICS_WINDOW_SIZE-second time window.
@@ -82,6 +93,13 @@ class Peer : public std::enable_shared_from_this<Peer>,
 
     typedef std::shared_ptr<Peer> pointer;
 
+    // Scheduler queue, and action type, of the SCP envelopes of `nodeID`
+    // given the distances of nodes from the local node in the transitive
+    // quorum, if they are known
+    static std::pair<std::string, Scheduler::ActionType>
+    getSCPEnvelopeQueue(NodeID const& nodeID,
+                        QuorumTracker::NodeDistances const* distances);
+
     enum PeerState
     {
         CONNECTING = 0,
@@ -131,6 +149,8 @@ class Peer : public std::enable_shared_from_this<Peer>,
         medida::Timer mMessageDelayInAsyncWriteTimer;
         medida::Timer mAdvertQueueDelay;
         medida::Timer mPullLatency;
+        // time for this peer to send a tx set or quorum set we asked for
+        medida::Timer mFetchLatency;
 
         std::atomic<uint64_t> mDemandTimeouts;
         std::atomic<uint64_t> mUniqueFloodBytesRecv;
@@ -142,6 +162,9 @@ class Peer : public std::enable_shared_from_this<Peer>,
         std::atomic<uint64_t> mDuplicateFloodMessageRecv;
         std::atomic<uint64_t> mUniqueFetchMessageRecv;
         std::atomic<uint64_t> mDuplicateFetchMessageRecv;
+        // SCP messages this peer was, or wasn't, the first to deliver
+        std::atomic<uint64_t> mUniqueScpMessageRecv;
+        std::atomic<uint64_t> mDuplicateScpMessageRecv;
 
         std::atomic<uint64_t> mTxHashReceived;
         std::atomic<uint64_t> mTxDemandSent;
@@ -174,10 +197,20 @@ class Peer : public std::enable_shared_from_this<Peer>,
     {
         std::weak_ptr<Peer> const mWeakPeer;
         StellarMessage const mMsg;
+        // Work done on the overlay thread before handing the message to the
+        // main thread, if any
+        TransactionFrameBasePtr mPreparedTx;
+        std::optional<Hash> mFloodMsgID;
 
       public:
-        MsgCapacityTracker(std::weak_ptr<Peer> peer, StellarMessage const& msg);
+        MsgCapacityTracker(std::weak_ptr<Peer> peer, StellarMessage&& msg);
         StellarMessage const& getMessage();
+        // Must only be called before the tracker is shared with the main
+        // thread
+        void setPrepared(TransactionFrameBasePtr tx,
+                         std::optional<Hash> floodMsgID);
+        TransactionFrameBasePtr getPreparedTransaction() const;
+        std::optional<Hash> const& getFloodMsgID() const;
         ~MsgCapacityTracker();
     };
 
@@ -191,6 +224,8 @@ class Peer : public std::enable_shared_from_this<Peer>,
 
     PeerRole const mRole;
     OverlayMetrics& mOverlayMetrics;
+    std::shared_ptr<SerializedMessageCache> const mSerializedMessageCache;
+    std::shared_ptr<PeerAuth> const mPeerAuth;
     PeerMetrics mPeerMetrics;
 
     // Mutex to protect PeerState, which can be accessed and modified from
@@ -202,6 +237,36 @@ class Peer : public std::enable_shared_from_this<Peer>,
 #endif
 
     Hmac mHmac;
+
+    // Messages read in the background and not yet posted to the main thread,
+    // protected by mStateMutex
+    struct RecvBatch
+    {
+        std::string mQueueName;
+        Scheduler::ActionType mType{Scheduler::ActionType::NORMAL_ACTION};
+        std::vector<std::shared_ptr<MsgCapacityTracker>> mMessages;
+    };
+    RecvBatch mRecvBatch;
+    static constexpr size_t MAX_RECV_BATCH_SIZE = 64;
+
+    // Messages the main thread sends while writing in the background, handed
+    // to the overlay thread in batches: a send only posts to the overlay
+    // thread when no drain of the channel is pending already.
+    static constexpr size_t SEND_CHANNEL_CAPACITY = 256;
+    MPSCChannel<std::shared_ptr<StellarMessage const>> mSendChannel{
+        SEND_CHANNEL_CAPACITY};
+    std::atomic<bool> mSendDrainPosted{false};
+    // Set by the main thread when sends are waiting in mSendOverflow, for the
+    // overlay thread to call it back once it has made room
+    std::atomic<bool> mSendOverflowed{false};
+
+    // zstd level to compress outgoing messages with, 0 until both sides asked
+    // for compression in AUTH
+    std::atomic<int> mCompressionLevel{0};
+    // Whether we asked for compression in our AUTH, and so accept compressed
+    // messages from the remote peer
+    std::atomic<bool> mAcceptCompressed{false};
+
     // Does local node have capacity to read from this peer
     bool canRead() const;
     // helper method to acknowledge that some bytes were received
@@ -229,7 +294,20 @@ class Peer : public std::enable_shared_from_this<Peer>,
         return mState;
     }
 
+    // Decodes the body of a frame read from the wire, decompressing it first
+    // if needed. Throws xdr::xdr_runtime_error on malformed input.
+    void decodeAuthenticatedMessage(uint8_t const* data, size_t size,
+                                    AuthenticatedMessage& am);
     bool recvAuthenticatedMessage(AuthenticatedMessage&& msg);
+    // When reading in the background, messages that land on the same
+    // scheduler queue back to back are handed to the main thread in a single
+    // post. Subclasses must call this once they are done draining the socket,
+    // and before queueing up a drop, so that earlier messages are not lost.
+    void flushRecvBatch();
+    // Builds a transaction received in the background, computes its hashes
+    // and verifies its signatures, so that the main thread only has to admit
+    // it to the queue. Returns nullptr if the transaction can't be built.
+    TransactionFrameBasePtr prepareTransaction(TransactionEnvelope const& env);
     // These exist mostly to be overridden in TCPPeer and callable via
     // shared_ptr<Peer> as a captured shared_from_this().
     virtual void connectHandler(asio::error_code const& ec);
@@ -251,6 +329,11 @@ class Peer : public std::enable_shared_from_this<Peer>,
     // assert that they are running on the main
   private:
     PeerState mState;
+
+    // Whether to ask the remote peer for compression in our AUTH
+    bool shouldRequestCompression() const;
+    // Compresses `msg` if compression was negotiated and worth it
+    xdr::msg_ptr maybeCompress(MessageType type, xdr::msg_ptr&& msg);
     NodeID mPeerID;
     uint256 mSendNonce;
     uint256 mRecvNonce;
@@ -260,6 +343,10 @@ class Peer : public std::enable_shared_from_this<Peer>,
     uint32_t mRemoteOverlayVersion;
     PeerBareAddress mAddress;
 
+    // Sends that found mSendChannel full, in order; later sends queue up
+    // behind them until the overlay thread has made room
+    std::deque<std::shared_ptr<StellarMessage const>> mSendOverflow;
+
     VirtualClock::time_point mCreationTime;
     VirtualTimer mRecurringTimer;
     VirtualTimer mDelayedExecutionTimer;
@@ -272,6 +359,13 @@ class Peer : public std::enable_shared_from_this<Peer>,
     VirtualClock::time_point mPingSentTime;
     std::chrono::milliseconds mLastPing;
 
+    // When we asked this peer for the tx sets and quorum sets it hasn't sent
+    // yet, to measure its fetch latency. Main thread only.
+    static constexpr size_t MAX_FETCH_REQUESTS_TRACKED = 64;
+    UnorderedMap<Hash, VirtualClock::time_point> mFetchRequestsSent;
+    void recordFetchRequest(Hash const& hash);
+    void maybeProcessFetchResponse(Hash const& hash, bool received);
+
     void recvRawMessage(StellarMessage const& msg);
 
     virtual void recvError(StellarMessage const& msg);
@@ -291,10 +385,13 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void recvGetTxSet(StellarMessage const& msg);
     void recvTxSet(StellarMessage const& msg);
     void recvGeneralizedTxSet(StellarMessage const& msg);
-    void recvTransaction(StellarMessage const& msg);
+    void recvTransaction(StellarMessage const& msg,
+                         TransactionFrameBasePtr preparedTx,
+                         std::optional<Hash> const& floodMsgID);
     void recvGetSCPQuorumSet(StellarMessage const& msg);
     void recvSCPQuorumSet(StellarMessage const& msg);
-    void recvSCPMessage(StellarMessage const& msg);
+    void recvSCPMessage(StellarMessage const& msg,
+                        std::optional<Hash> const& floodMsgID);
     void recvGetSCPState(StellarMessage const& msg);
     void recvFloodAdvert(StellarMessage const& msg);
     void recvFloodDemand(StellarMessage const& msg);
@@ -315,7 +412,9 @@ class Peer : public std::enable_shared_from_this<Peer>,
     // put in a reused/non-owned buffer without having to buffer/queue
     // messages somewhere else. The async write request will point _into_
     // this owned buffer. This is really the best we can do.
-    virtual void sendMessage(xdr::msg_ptr&& xdrBytes) = 0;
+    // `canDelay` marks bulk traffic that may wait a little to share a write
+    // with later messages.
+    virtual void sendMessage(xdr::msg_ptr&& xdrBytes, bool canDelay) = 0;
     virtual void scheduleRead() = 0;
     virtual void
     connected()
@@ -330,6 +429,13 @@ class Peer : public std::enable_shared_from_this<Peer>,
     std::chrono::seconds getIOTimeout() const;
 
     void sendAuthenticatedMessage(std::shared_ptr<StellarMessage const> msg);
+    // Signs, encodes and queues `msg` for writing; runs on the thread the
+    // socket is written from
+    void authenticateAndSend(std::shared_ptr<StellarMessage const> const& msg);
+    void pushToSendChannel(std::shared_ptr<StellarMessage const>&& msg);
+    void postSendChannelDrain();
+    void drainSendChannel();
+    void flushSendOverflow();
     void beginMessageProcessing(StellarMessage const& msg);
     void endMessageProcessing(StellarMessage const& msg);
 
@@ -449,6 +555,11 @@ class Peer : public std::enable_shared_from_this<Peer>,
     bool isAuthenticatedForTesting() const;
     bool shouldAbortForTesting() const;
     bool isConnectedForTesting() const;
+    bool
+    isCompressionEnabledForTesting() const
+    {
+        return mCompressionLevel > 0;
+    }
     void
     sendAuthenticatedMessageForTesting(
         std::shared_ptr<StellarMessage const> msg)
@@ -458,7 +569,7 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void
     sendXdrMessageForTesting(xdr::msg_ptr xdrBytes)
     {
-        sendMessage(std::move(xdrBytes));
+        sendMessage(std::move(xdrBytes), false);
     }
     std::string mDropReason;
 #endif
@@ -9,7 +9,11 @@
 #include "crypto/SecretKey.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "xdrpp/marshal.h"
 
 namespace stellar
@@ -26,8 +30,8 @@ makeAuthCert(Application& app, Curve25519Public const& pub)
     cert.pubkey = pub;
     cert.expiration = app.timeNow() + expirationLimit;
 
-    auto hash = sha256(xdr::xdr_to_opaque(
-        app.getNetworkID(), ENVELOPE_TYPE_AUTH, cert.expiration, cert.pubkey));
+    auto hash = xdrSha256(app.getNetworkID(), ENVELOPE_TYPE_AUTH,
+                          cert.expiration, cert.pubkey);
     CLOG_DEBUG(Overlay, "PeerAuth signing cert hash: {}", hexAbbrev(hash));
     cert.sig = app.getConfig().NODE_SEED.sign(hash);
     return cert;
@@ -35,10 +39,19 @@ makeAuthCert(Application& app, Curve25519Public const& pub)
 
 PeerAuth::PeerAuth(Application& app)
     : mApp(app)
+    , mNetworkID(app.getNetworkID())
     , mECDHSecretKey(curve25519RandomSecret())
     , mECDHPublicKey(curve25519DerivePublic(mECDHSecretKey))
     , mCert(makeAuthCert(app, mECDHPublicKey))
-    , mSharedKeyCache(0xffff)
+    // Use a separate PRNG, as the cache is used off the main thread
+    , mSharedKeyCache(SHARED_KEY_CACHE_SIZE, true)
+    , mSharedKeyHit(app.getMetrics().NewMeter(
+          {"overlay", "auth", "shared-key-hit"}, "key"))
+    , mSharedKeyMiss(app.getMetrics().NewMeter(
+          {"overlay", "auth", "shared-key-miss"}, "key"))
+    , mSharedKeyDerive(
+          app.getMetrics().NewTimer({"overlay", "auth", "derive-shared-key"}))
+    , mCertVerify(app.getMetrics().NewTimer({"overlay", "auth", "verify-cert"}))
 {
 }
 
@@ -61,25 +74,57 @@ PeerAuth::verifyRemoteAuthCert(NodeID const& remoteNode, AuthCert const& cert)
                    cert.expiration, mApp.timeNow());
         return false;
     }
-    auto hash = sha256(xdr::xdr_to_opaque(
-        mApp.getNetworkID(), ENVELOPE_TYPE_AUTH, cert.expiration, cert.pubkey));
+    return verifyRemoteAuthCertSignature(remoteNode, cert);
+}
+
+bool
+PeerAuth::verifyRemoteAuthCertSignature(NodeID const& remoteNode,
+                                        AuthCert const& cert)
+{
+    auto timer = mCertVerify.TimeScope();
+    auto hash = xdrSha256(mNetworkID, ENVELOPE_TYPE_AUTH, cert.expiration,
+                          cert.pubkey);
 
     CLOG_DEBUG(Overlay, "PeerAuth verifying cert hash: {}", hexAbbrev(hash));
+    // Results are cached, so a signature checked in prepareHandshake is not
+    // checked again
     return PubKeyUtils::verifySig(remoteNode, cert.sig, hash);
 }
 
+void
+PeerAuth::prepareHandshake(Hello const& hello, Peer::PeerRole role)
+{
+    ZoneScoped;
+    // Expiration is checked when the HELLO is processed
+    if (verifyRemoteAuthCertSignature(hello.peerID, hello.cert))
+    {
+        getSharedKey(hello.cert.pubkey, role);
+    }
+}
+
 HmacSha256Key
 PeerAuth::getSharedKey(Curve25519Public const& remotePublic,
                        Peer::PeerRole role)
 {
     auto key = PeerSharedKeyId{remotePublic, role};
-    if (mSharedKeyCache.exists(key))
     {
-        return mSharedKeyCache.get(key);
+        std::lock_guard<std::mutex> lock(mSharedKeyCacheMutex);
+        if (auto value = mSharedKeyCache.maybeGet(key))
+        {
+            mSharedKeyHit.Mark();
+            return *value;
+        }
+    }
+    mSharedKeyMiss.Mark();
+    // Derive outside of the lock; racing derivations of the same key agree
+    HmacSha256Key value;
+    {
+        auto timer = mSharedKeyDerive.TimeScope();
+        value = curve25519DeriveSharedKey(mECDHSecretKey, mECDHPublicKey,
+                                          remotePublic,
+                                          role == Peer::WE_CALLED_REMOTE);
     }
-    auto value =
-        curve25519DeriveSharedKey(mECDHSecretKey, mECDHPublicKey, remotePublic,
-                                  role == Peer::WE_CALLED_REMOTE);
+    std::lock_guard<std::mutex> lock(mSharedKeyCacheMutex);
     mSharedKeyCache.put(key, value);
     return value;
 }
@@ -4,6 +4,13 @@
 #include "overlay/PeerSharedKeyId.h"
 #include "util/RandomEvictionCache.h"
 #include "xdr/Stellar-types.h"
+#include <mutex>
+
+namespace medida
+{
+class Meter;
+class Timer;
+}
 
 // Copyright 2015 Stellar Development Foundation and contributors. Licensed
 // under the Apache License, Version 2.0. See the COPYING file at the root
@@ -24,15 +31,36 @@ class PeerAuth
     // HKDF_expand(K{us,them}, 1 || nonce_B || nonce_A) for
     // use in a particular A-called-B p2p session.
 
+    //
+    // Shared keys only depend on the remote node's ECDH key, which it
+    // randomizes on startup, so the cache mostly serves reconnections of
+    // the same remote process. It is sized for a few times the number of
+    // connections a node may have, plus watchers churning through restarts.
+    //
+    // Except for getAuthCert, methods are safe to call from the overlay
+    // thread, so that handshake crypto can be done ahead of the main thread
+    // (see prepareHandshake).
+
+    static constexpr size_t SHARED_KEY_CACHE_SIZE = 0xffff;
+
     Application& mApp;
-    Curve25519Secret mECDHSecretKey;
-    Curve25519Public mECDHPublicKey;
+    Hash const mNetworkID;
+    Curve25519Secret const mECDHSecretKey;
+    Curve25519Public const mECDHPublicKey;
     AuthCert mCert;
 
+    std::mutex mSharedKeyCacheMutex;
     RandomEvictionCache<PeerSharedKeyId, HmacSha256Key> mSharedKeyCache;
 
+    medida::Meter& mSharedKeyHit;
+    medida::Meter& mSharedKeyMiss;
+    medida::Timer& mSharedKeyDerive;
+    medida::Timer& mCertVerify;
+
     HmacSha256Key getSharedKey(Curve25519Public const& remotePublic,
                                Peer::PeerRole role);
+    bool verifyRemoteAuthCertSignature(NodeID const& remoteNode,
+                                       AuthCert const& cert);
 
   public:
     PeerAuth(Application& app);
@@ -40,6 +68,10 @@ class PeerAuth
     AuthCert getAuthCert();
     bool verifyRemoteAuthCert(NodeID const& remoteNode, AuthCert const& cert);
 
+    // Verify the cert and derive the shared key of a HELLO ahead of time, so
+    // that processing it on the main thread only hits caches
+    void prepareHandshake(Hello const& hello, Peer::PeerRole role);
+
     HmacSha256Key getSendingMacKey(Curve25519Public const& remotePublic,
                                    uint256 const& localNonce,
                                    uint256 const& remoteNonce,
@@ -6,9 +6,12 @@
 #include "Peer.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/TCPPeer.h"
 #include "util/Logging.h"
+#include <algorithm>
 #include <memory>
 
 namespace stellar
@@ -19,7 +22,11 @@ using asio::ip::tcp;
 using namespace std;
 
 PeerDoor::PeerDoor(Application& app)
-    : mApp(app), mAcceptor(mApp.getClock().getIOContext())
+    : mApp(app)
+    , mAcceptor(mApp.getClock().getIOContext())
+    , mAcceptDelayTimer(app)
+    , mAcceptThrottled(app.getMetrics().NewMeter(
+          {"overlay", "inbound", "throttle"}, "connection"))
 {
 }
 
@@ -37,13 +44,16 @@ PeerDoor::start()
         mAcceptor.set_option(asio::ip::tcp::acceptor::reuse_address(true));
         mAcceptor.bind(endpoint);
         mAcceptor.listen(LISTEN_QUEUE_LIMIT);
-        acceptNextPeer();
+        mAcceptTokens = mApp.getConfig().MAX_INBOUND_CONNECTIONS_PER_SECOND;
+        mLastAcceptRefill = mApp.getClock().now();
+        scheduleNextAccept();
     }
 }
 
 void
 PeerDoor::close()
 {
+    mAcceptDelayTimer.cancel();
     if (mAcceptor.is_open())
     {
         asio::error_code ec;
@@ -52,6 +62,38 @@ PeerDoor::close()
     }
 }
 
+void
+PeerDoor::scheduleNextAccept()
+{
+    releaseAssert(threadIsMain());
+    double const rate = mApp.getConfig().MAX_INBOUND_CONNECTIONS_PER_SECOND;
+    if (rate == 0)
+    {
+        acceptNextPeer();
+        return;
+    }
+
+    auto now = mApp.getClock().now();
+    std::chrono::duration<double> elapsed = now - mLastAcceptRefill;
+    mLastAcceptRefill = now;
+    mAcceptTokens = std::min(rate, mAcceptTokens + elapsed.count() * rate);
+    if (mAcceptTokens >= 1)
+    {
+        mAcceptTokens -= 1;
+        acceptNextPeer();
+        return;
+    }
+
+    // Leave further connections in the listen queue until the next token
+    mAcceptThrottled.Mark();
+    std::chrono::duration<double> wait((1 - mAcceptTokens) / rate);
+    mAcceptDelayTimer.expires_from_now(
+        std::chrono::duration_cast<std::chrono::milliseconds>(wait) +
+        std::chrono::milliseconds(1));
+    mAcceptDelayTimer.async_wait([this]() { scheduleNextAccept(); },
+                                 VirtualTimer::onFailureNoop);
+}
+
 void
 PeerDoor::acceptNextPeer()
 {
@@ -101,6 +143,6 @@ PeerDoor::handleKnock(shared_ptr<TCPPeer::SocketType> socket)
                          ec.message());
         }
     }
-    acceptNextPeer();
+    scheduleNextAccept();
 }
 }
@@ -6,6 +6,7 @@
 
 #include "util/asio.h" // IWYU pragma: keep
 #include "TCPPeer.h"
+#include "util/Timer.h"
 #include <memory>
 
 /*
@@ -15,6 +16,11 @@ Accepts connections on the main thread, but then lets the overlay thread deal
 with socket operations like read and write
 */
 
+namespace medida
+{
+class Meter;
+}
+
 namespace stellar
 {
 class Application;
@@ -26,6 +32,15 @@ class PeerDoor
     Application& mApp;
     asio::ip::tcp::acceptor mAcceptor;
 
+    // Token bucket enforcing MAX_INBOUND_CONNECTIONS_PER_SECOND, holding up
+    // to one second worth of connections
+    double mAcceptTokens{0};
+    VirtualClock::time_point mLastAcceptRefill;
+    VirtualTimer mAcceptDelayTimer;
+    medida::Meter& mAcceptThrottled;
+
+    // Accept the next connection once the accept rate allows it
+    void scheduleNextAccept();
     virtual void acceptNextPeer();
     virtual void handleKnock(std::shared_ptr<TCPPeer::SocketType> pSocket);
 
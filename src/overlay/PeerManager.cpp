@@ -6,12 +6,13 @@
 #include "database/Database.h"
 #include "lib/util/stdrandom.h"
 #include "main/Application.h"
+#include "main/Config.h"
 #include "overlay/RandomPeerSource.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <algorithm>
 #include <cmath>
 #include <fmt/format.h>
@@ -85,82 +86,191 @@ PeerManager::PeerManager(Application& app)
           *this, RandomPeerSource::maxFailures(MAX_FAILURES, true)))
     , mInboundPeersToSend(std::make_unique<RandomPeerSource>(
           *this, RandomPeerSource::maxFailures(MAX_FAILURES, false)))
+    , mFlushTimer(app)
 {
 }
 
-std::vector<PeerBareAddress>
-PeerManager::loadRandomPeers(PeerQuery const& query, size_t size)
+void
+PeerManager::ensureLoaded()
 {
     ZoneScoped;
-    // BATCH_SIZE should always be bigger, so it should win anyway
-    size = std::max(size, BATCH_SIZE);
+    if (mLoaded)
+    {
+        return;
+    }
+    mLoaded = true;
 
-    // if we ever start removing peers from db, we may need to enable this
-    // soci::transaction sqltx(mApp.getDatabase().getSession());
-    // mApp.getDatabase().setCurrentTransactionReadOnly();
+    std::string sql =
+        "SELECT ip, port, nextattempt, numfailures, type FROM peers";
 
-    std::vector<std::string> conditions;
-    if (query.mUseNextAttempt)
+    try
     {
-        conditions.push_back("nextattempt <= :nextattempt");
+        std::string ip;
+        int port;
+        PeerRecord record;
+
+        auto prep = mApp.getDatabase().getPreparedStatement(sql);
+        auto& st = prep.statement();
+
+        st.exchange(into(ip));
+        st.exchange(into(port));
+        st.exchange(into(record.mNextAttempt));
+        st.exchange(into(record.mNumFailures));
+        st.exchange(into(record.mType));
+
+        st.define_and_bind();
+        {
+            auto timer = mApp.getDatabase().getSelectTimer("peer");
+            st.execute(true);
+        }
+        while (st.got_data())
+        {
+            if (!ip.empty() && port > 0)
+            {
+                PeerBareAddress pba{ip, static_cast<unsigned short>(port)};
+                mPeers[pba] = record;
+            }
+            st.fetch();
+        }
     }
-    if (query.mMaxNumFailures.has_value())
+    catch (soci_error& err)
     {
-        conditions.push_back("numfailures <= :maxFailures");
+        CLOG_ERROR(Overlay, "PeerManager::ensureLoaded error: {}", err.what());
     }
-    if (query.mTypeFilter == PeerTypeFilter::ANY_OUTBOUND)
+}
+
+void
+PeerManager::markDirty(PeerBareAddress const& address)
+{
+    mRemoved.erase(address);
+    mDirty.insert(address);
+
+    auto period = mApp.getConfig().PEER_TABLE_FLUSH_PERIOD_SECONDS;
+    if (period.count() == 0)
     {
-        conditions.push_back("type != :inboundType");
+        flush();
     }
-    else
+    else if (!mFlushScheduled)
     {
-        conditions.push_back("type = :type");
+        mFlushScheduled = true;
+        mFlushTimer.expires_from_now(period);
+        mFlushTimer.async_wait([this]() { flush(); },
+                               &VirtualTimer::onFailureNoop);
     }
-    releaseAssert(!conditions.empty());
-    std::string where = conditions[0];
-    for (size_t i = 1; i < conditions.size(); i++)
+}
+
+void
+PeerManager::flush()
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    mFlushTimer.cancel();
+    mFlushScheduled = false;
+    if (mDirty.empty() && mRemoved.empty())
     {
-        where += " AND " + conditions[i];
+        return;
     }
 
-    std::tm nextAttempt =
-        VirtualClock::systemPointToTm(mApp.getClock().system_now());
-    size_t maxNumFailures{0};
+    CLOG_TRACE(Overlay, "Flushing {} updated and {} removed peers",
+               mDirty.size(), mRemoved.size());
+    auto& db = mApp.getDatabase();
+    try
+    {
+        soci::transaction tx(db.getSession());
+        for (auto const& address : mRemoved)
+        {
+            auto prep = db.getPreparedStatement(
+                "DELETE FROM peers WHERE ip = :v1 AND port = :v2");
+            auto& st = prep.statement();
+            std::string ip = address.getIP();
+            st.exchange(use(ip));
+            int port = address.getPort();
+            st.exchange(use(port));
+            st.define_and_bind();
+            {
+                auto timer = db.getDeleteTimer("peer");
+                st.execute(true);
+            }
+        }
+        for (auto const& address : mDirty)
+        {
+            auto const& peerRecord = mPeers.at(address);
+            auto prep = db.getPreparedStatement(
+                "INSERT INTO peers "
+                "(nextattempt, numfailures, type, ip,  port) "
+                "VALUES "
+                "(:v1,         :v2,        :v3,  :v4, :v5) "
+                "ON CONFLICT (ip, port) DO UPDATE SET "
+                "nextattempt = excluded.nextattempt, "
+                "numfailures = excluded.numfailures, "
+                "type = excluded.type");
+            auto& st = prep.statement();
+            st.exchange(use(peerRecord.mNextAttempt));
+            st.exchange(use(peerRecord.mNumFailures));
+            st.exchange(use(peerRecord.mType));
+            std::string ip = address.getIP();
+            st.exchange(use(ip));
+            int port = address.getPort();
+            st.exchange(use(port));
+            st.define_and_bind();
+            {
+                auto timer = db.getUpsertTimer("peer");
+                st.execute(true);
+            }
+        }
+        tx.commit();
+    }
+    catch (soci_error& err)
+    {
+        CLOG_ERROR(Overlay, "PeerManager::flush error: {}", err.what());
+    }
+    mDirty.clear();
+    mRemoved.clear();
+}
+
+std::vector<PeerBareAddress>
+PeerManager::loadRandomPeers(PeerQuery const& query, size_t size)
+{
+    ZoneScoped;
+    ensureLoaded();
+    // BATCH_SIZE should always be bigger, so it should win anyway
+    size = std::max(size, BATCH_SIZE);
+
+    auto now = mApp.getClock().system_now();
     int exactType = static_cast<int>(query.mTypeFilter);
     int inboundType = static_cast<int>(PeerType::INBOUND);
-
-    auto bindToStatement = [&](soci::statement& st) {
-        if (query.mUseNextAttempt)
+    auto matches = [&](PeerRecord const& peer) {
+        if (query.mUseNextAttempt &&
+            VirtualClock::tmToSystemPoint(peer.mNextAttempt) > now)
         {
-            st.exchange(soci::use(nextAttempt));
+            return false;
         }
-        if (query.mMaxNumFailures.has_value())
+        if (query.mMaxNumFailures.has_value() &&
+            peer.mNumFailures > *query.mMaxNumFailures)
         {
-            maxNumFailures = *query.mMaxNumFailures;
-            st.exchange(soci::use(maxNumFailures));
+            return false;
         }
         if (query.mTypeFilter == PeerTypeFilter::ANY_OUTBOUND)
         {
-            st.exchange(soci::use(inboundType));
-        }
-        else
-        {
-            st.exchange(soci::use(exactType));
+            return peer.mType != inboundType;
         }
+        return peer.mType == exactType;
     };
 
     auto result = std::vector<PeerBareAddress>{};
-    size_t count = countPeers(where, bindToStatement);
-    if (count == 0)
+    for (auto const& peer : mPeers)
     {
-        return result;
+        if (matches(peer.second))
+        {
+            result.emplace_back(peer.first);
+        }
     }
 
-    size_t maxOffset = count > size ? count - size : 0;
-    size_t offset = rand_uniform<size_t>(0, maxOffset);
-    result = loadPeers(size, offset, where, bindToStatement);
-
     stellar::shuffle(std::begin(result), std::end(result), gRandomEngine);
+    if (result.size() > size)
+    {
+        result.resize(size);
+    }
     return result;
 }
 
@@ -170,39 +280,28 @@ PeerManager::removePeersWithManyFailures(size_t minNumFailures,
 {
     ZoneScoped;
     releaseAssert(threadIsMain());
-    try
+    ensureLoaded();
+    bool removed = false;
+    for (auto it = mPeers.begin(); it != mPeers.end();)
     {
-        auto& db = mApp.getDatabase();
-        auto sql = std::string{
-            "DELETE FROM peers WHERE numfailures >= :minNumFailures"};
-        if (address)
-        {
-            sql += " AND ip = :ip";
-        }
-
-        auto prep = db.getPreparedStatement(sql);
-        auto& st = prep.statement();
-
-        st.exchange(use(minNumFailures));
-
-        std::string ip;
-        if (address)
+        if (it->second.mNumFailures >= minNumFailures &&
+            (!address || it->first.getIP() == address->getIP()))
         {
-            ip = address->getIP();
-            st.exchange(use(ip));
+            mDirty.erase(it->first);
+            mRemoved.insert(it->first);
+            it = mPeers.erase(it);
+            removed = true;
         }
-        st.define_and_bind();
-
+        else
         {
-            auto timer = db.getDeleteTimer("peer");
-            st.execute(true);
+            ++it;
         }
     }
-    catch (soci_error& err)
+
+    if (removed)
     {
-        CLOG_ERROR(Overlay,
-                   "PeerManager::removePeersWithManyFailures error: {}",
-                   err.what());
+        // Deletions are rare, don't bother delaying them
+        flush();
     }
 }
 
@@ -230,95 +329,36 @@ std::pair<PeerRecord, bool>
 PeerManager::load(PeerBareAddress const& address)
 {
     ZoneScoped;
-    auto result = PeerRecord{};
-    auto inDatabase = false;
-
-    try
+    ensureLoaded();
+    auto it = mPeers.find(address);
+    if (it != mPeers.end())
     {
-        auto prep = mApp.getDatabase().getPreparedStatement(
-            "SELECT numfailures, nextattempt, type FROM peers "
-            "WHERE ip = :v1 AND port = :v2");
-        auto& st = prep.statement();
-        st.exchange(into(result.mNumFailures));
-        st.exchange(into(result.mNextAttempt));
-        st.exchange(into(result.mType));
-        std::string ip = address.getIP();
-        st.exchange(use(ip));
-        int port = address.getPort();
-        st.exchange(use(port));
-        st.define_and_bind();
-        {
-            auto timer = mApp.getDatabase().getSelectTimer("peer");
-            st.execute(true);
-            inDatabase = st.got_data();
-
-            if (!inDatabase)
-            {
-                result.mNextAttempt =
-                    VirtualClock::systemPointToTm(mApp.getClock().system_now());
-                result.mType = static_cast<int>(PeerType::INBOUND);
-            }
-        }
-    }
-    catch (soci_error& err)
-    {
-        CLOG_ERROR(Overlay, "PeerManager::load error: {} on {}", err.what(),
-                   address.toString());
+        return std::make_pair(it->second, true);
     }
 
-    return std::make_pair(result, inDatabase);
+    auto result = PeerRecord{};
+    result.mNextAttempt =
+        VirtualClock::systemPointToTm(mApp.getClock().system_now());
+    result.mType = static_cast<int>(PeerType::INBOUND);
+    return std::make_pair(result, false);
 }
 
 void
-PeerManager::store(PeerBareAddress const& address, PeerRecord const& peerRecord,
-                   bool inDatabase)
+PeerManager::store(PeerBareAddress const& address,
+                   PeerRecord const& peerRecord)
 {
     ZoneScoped;
-    std::string query;
-
-    if (inDatabase)
+    ensureLoaded();
+    auto res = mPeers.emplace(address, peerRecord);
+    if (!res.second)
     {
-        query = "UPDATE peers SET "
-                "nextattempt = :v1, "
-                "numfailures = :v2, "
-                "type = :v3 "
-                "WHERE ip = :v4 AND port = :v5";
-    }
-    else
-    {
-        query = "INSERT INTO peers "
-                "(nextattempt, numfailures, type, ip,  port) "
-                "VALUES "
-                "(:v1,         :v2,        :v3,  :v4, :v5)";
-    }
-
-    try
-    {
-        auto prep = mApp.getDatabase().getPreparedStatement(query);
-        auto& st = prep.statement();
-        st.exchange(use(peerRecord.mNextAttempt));
-        st.exchange(use(peerRecord.mNumFailures));
-        st.exchange(use(peerRecord.mType));
-        std::string ip = address.getIP();
-        st.exchange(use(ip));
-        int port = address.getPort();
-        st.exchange(use(port));
-        st.define_and_bind();
+        if (res.first->second == peerRecord)
         {
-            auto timer = mApp.getDatabase().getUpdateTimer("peer");
-            st.execute(true);
-            if (st.get_affected_rows() != 1)
-            {
-                CLOG_ERROR(Overlay, "PeerManager::store failed on {}",
-                           address.toString());
-            }
+            return;
         }
+        res.first->second = peerRecord;
     }
-    catch (soci_error& err)
-    {
-        CLOG_ERROR(Overlay, "PeerManager::store error: {} on {}", err.what(),
-                   address.toString());
-    }
+    markDirty(address);
 }
 
 void
@@ -410,7 +450,7 @@ PeerManager::ensureExists(PeerBareAddress const& address)
     if (!peer.second)
     {
         CLOG_TRACE(Overlay, "Learned peer {}", address.toString());
-        store(address, peer.first, peer.second);
+        store(address, peer.first);
     }
 }
 
@@ -467,7 +507,7 @@ PeerManager::update(PeerBareAddress const& address, PeerType observedType,
     TypeUpdate typeUpdate =
         getTypeUpdate(peer.first, observedType, preferredTypeKnown);
     update(peer.first, typeUpdate);
-    store(address, peer.first, peer.second);
+    store(address, peer.first);
 }
 
 void
@@ -476,7 +516,7 @@ PeerManager::update(PeerBareAddress const& address, BackOffUpdate backOff)
     ZoneScoped;
     auto peer = load(address);
     update(peer.first, backOff, mApp);
-    store(address, peer.first, peer.second);
+    store(address, peer.first);
 }
 
 void
@@ -489,82 +529,7 @@ PeerManager::update(PeerBareAddress const& address, PeerType observedType,
         getTypeUpdate(peer.first, observedType, preferredTypeKnown);
     update(peer.first, typeUpdate);
     update(peer.first, backOff, mApp);
-    store(address, peer.first, peer.second);
-}
-
-size_t
-PeerManager::countPeers(std::string const& where,
-                        std::function<void(soci::statement&)> const& bind)
-{
-    ZoneScoped;
-    size_t count = 0;
-
-    try
-    {
-        std::string sql = "SELECT COUNT(*) FROM peers WHERE " + where;
-
-        auto prep = mApp.getDatabase().getPreparedStatement(sql);
-        auto& st = prep.statement();
-
-        bind(st);
-        st.exchange(into(count));
-
-        st.define_and_bind();
-        st.execute(true);
-    }
-    catch (soci_error& err)
-    {
-        CLOG_ERROR(Overlay, "countPeers error: {}", err.what());
-    }
-
-    return count;
-}
-
-std::vector<PeerBareAddress>
-PeerManager::loadPeers(size_t limit, size_t offset, std::string const& where,
-                       std::function<void(soci::statement&)> const& bind)
-{
-    ZoneScoped;
-    auto result = std::vector<PeerBareAddress>{};
-
-    try
-    {
-        std::string sql = "SELECT ip, port "
-                          "FROM peers WHERE " +
-                          where + " LIMIT :limit OFFSET :offset";
-
-        auto prep = mApp.getDatabase().getPreparedStatement(sql);
-        auto& st = prep.statement();
-
-        bind(st);
-        st.exchange(use(limit));
-        st.exchange(use(offset));
-
-        std::string ip;
-        int lport;
-        st.exchange(into(ip));
-        st.exchange(into(lport));
-
-        st.define_and_bind();
-        {
-            auto timer = mApp.getDatabase().getSelectTimer("peer");
-            st.execute(true);
-        }
-        while (st.got_data())
-        {
-            if (!ip.empty() && lport > 0)
-            {
-                result.emplace_back(ip, static_cast<unsigned short>(lport));
-            }
-            st.fetch();
-        }
-    }
-    catch (soci_error& err)
-    {
-        CLOG_ERROR(Overlay, "loadPeers error: {}", err.what());
-    }
-
-    return result;
+    store(address, peer.first);
 }
 
 void
@@ -578,55 +543,20 @@ std::vector<std::pair<PeerBareAddress, PeerRecord>>
 PeerManager::loadAllPeers()
 {
     ZoneScoped;
-    std::vector<std::pair<PeerBareAddress, PeerRecord>> result;
-    std::string sql =
-        "SELECT ip, port, nextattempt, numfailures, type FROM peers";
-
-    try
-    {
-        std::string ip;
-        int port;
-        PeerRecord record;
-
-        auto prep = mApp.getDatabase().getPreparedStatement(sql);
-        auto& st = prep.statement();
-
-        st.exchange(into(ip));
-        st.exchange(into(port));
-        st.exchange(into(record.mNextAttempt));
-        st.exchange(into(record.mNumFailures));
-        st.exchange(into(record.mType));
-
-        st.define_and_bind();
-        {
-            auto timer = mApp.getDatabase().getSelectTimer("peer");
-            st.execute(true);
-        }
-        while (st.got_data())
-        {
-            PeerBareAddress pba{ip, static_cast<unsigned short>(port)};
-            result.emplace_back(std::make_pair(pba, record));
-            st.fetch();
-        }
-    }
-    catch (soci_error& err)
-    {
-        CLOG_ERROR(Overlay, "loadPeers error: {}", err.what());
-    }
-
-    return result;
+    ensureLoaded();
+    return {mPeers.begin(), mPeers.end()};
 }
 
 void
 PeerManager::storePeers(
     std::vector<std::pair<PeerBareAddress, PeerRecord>> peers)
 {
-    soci::transaction tx(mApp.getDatabase().getSession());
+    ensureLoaded();
     for (auto const& peer : peers)
     {
-        store(peer.first, peer.second, /* inDatabase */ false);
+        mPeers[peer.first] = peer.second;
+        markDirty(peer.first);
     }
-    tx.commit();
 }
 
 const char* PeerManager::kSQLCreateStatement =
@@ -8,11 +8,8 @@
 #include "util/Timer.h"
 
 #include <functional>
-
-namespace soci
-{
-class statement;
-}
+#include <map>
+#include <set>
 
 namespace stellar
 {
@@ -58,6 +55,12 @@ PeerAddress toXdr(PeerBareAddress const& address);
 
 /**
  * Maintain list of know peers in database.
+ *
+ * The peer table is kept in memory, loaded from the database on first use,
+ * and all queries are served from there. Changes are written back to the
+ * database in a single transaction PEER_TABLE_FLUSH_PERIOD_SECONDS after the
+ * first one, so that the many small updates made on connection outcomes and
+ * peer list gossip don't each hit the database on the main thread.
  */
 class PeerManager
 {
@@ -107,21 +110,19 @@ class PeerManager
                 bool preferredTypeKnown, BackOffUpdate backOff);
 
     /**
-     * Load PeerRecord data for peer with given address. If not available in
-     * database, create default one. Second value in pair is true when data
-     * was loaded from database, false otherwise.
+     * Load PeerRecord data for peer with given address. If not known, create
+     * default one. Second value in pair is true when the peer is known, false
+     * otherwise.
      */
     std::pair<PeerRecord, bool> load(PeerBareAddress const& address);
 
     /**
-     * Store PeerRecord data into database. If inDatabase is true, uses UPDATE
-     * query, uses INSERT otherwise.
+     * Store PeerRecord data, inserting the peer if not known yet.
      */
-    void store(PeerBareAddress const& address, PeerRecord const& PeerRecord,
-               bool inDatabase);
+    void store(PeerBareAddress const& address, PeerRecord const& PeerRecord);
 
     /**
-     * Load size random peers matching query from database.
+     * Load size random peers matching query.
      */
     std::vector<PeerBareAddress> loadRandomPeers(PeerQuery const& query,
                                                  size_t size);
@@ -140,15 +141,21 @@ class PeerManager
                                                 PeerBareAddress const& address);
 
     /**
-     * Load all peers from the database.
+     * Load all peers.
      */
     std::vector<std::pair<PeerBareAddress, PeerRecord>> loadAllPeers();
 
     /**
-     * Store peers in the database.
+     * Store peers, all of them being written to the database on next flush
+     * (even if unchanged, as the table may have been recreated).
      */
     void storePeers(std::vector<std::pair<PeerBareAddress, PeerRecord>>);
 
+    /**
+     * Write all pending changes to the database now.
+     */
+    void flush();
+
   private:
     static const char* kSQLCreateStatement;
 
@@ -156,11 +163,16 @@ class PeerManager
     std::unique_ptr<RandomPeerSource> mOutboundPeersToSend;
     std::unique_ptr<RandomPeerSource> mInboundPeersToSend;
 
-    size_t countPeers(std::string const& where,
-                      std::function<void(soci::statement&)> const& bind);
-    std::vector<PeerBareAddress>
-    loadPeers(size_t limit, size_t offset, std::string const& where,
-              std::function<void(soci::statement&)> const& bind);
+    bool mLoaded{false};
+    std::map<PeerBareAddress, PeerRecord> mPeers;
+    // Peers to write to, or delete from, the database on next flush
+    std::set<PeerBareAddress> mDirty;
+    std::set<PeerBareAddress> mRemoved;
+    VirtualTimer mFlushTimer;
+    bool mFlushScheduled{false};
+
+    void ensureLoaded();
+    void markDirty(PeerBareAddress const& address);
 
     void update(PeerRecord& peer, TypeUpdate type);
     void update(PeerRecord& peer, BackOffUpdate backOff, Application& app);
@@ -0,0 +1,78 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/PeerScore.h"
+#include "overlay/Peer.h"
+
+#include <algorithm>
+
+namespace stellar
+{
+
+namespace
+{
+double
+ratio(uint64_t part, uint64_t other)
+{
+    auto total = part + other;
+    return total == 0 ? 0.5 : static_cast<double>(part) / total;
+}
+
+double
+byteRate(PeerScoreInputs const& peer)
+{
+    auto secs = std::max<int64_t>(peer.mLifeTime.count(), 1);
+    return static_cast<double>(peer.mByteRead) / secs;
+}
+}
+
+PeerScoreInputs
+PeerScoreInputs::fromPeer(Peer const& peer)
+{
+    auto const& metrics = peer.getPeerMetrics();
+    PeerScoreInputs res;
+    res.mPing = peer.getPing();
+    res.mLifeTime = peer.getLifeTime();
+    res.mByteRead = metrics.mByteRead;
+    res.mUniqueFloodBytesRecv = metrics.mUniqueFloodBytesRecv;
+    res.mDuplicateFloodBytesRecv = metrics.mDuplicateFloodBytesRecv;
+    res.mUniqueScpMessageRecv = metrics.mUniqueScpMessageRecv;
+    res.mDuplicateScpMessageRecv = metrics.mDuplicateScpMessageRecv;
+    return res;
+}
+
+std::vector<double>
+scorePeers(std::vector<PeerScoreInputs> const& peers)
+{
+    std::vector<double> res;
+    if (peers.empty())
+    {
+        return res;
+    }
+
+    // Pings below a millisecond are as good as one
+    auto minPing = std::chrono::milliseconds(1);
+    auto bestPing = std::chrono::milliseconds::max();
+    double maxRate = 0;
+    for (auto const& peer : peers)
+    {
+        bestPing = std::min(bestPing, std::max(peer.mPing, minPing));
+        maxRate = std::max(maxRate, byteRate(peer));
+    }
+
+    res.reserve(peers.size());
+    for (auto const& peer : peers)
+    {
+        double usefulness = ratio(peer.mUniqueFloodBytesRecv,
+                                  peer.mDuplicateFloodBytesRecv);
+        double scpLead = ratio(peer.mUniqueScpMessageRecv,
+                               peer.mDuplicateScpMessageRecv);
+        double latency = static_cast<double>(bestPing.count()) /
+                         std::max(peer.mPing, minPing).count();
+        double throughput = maxRate == 0 ? 0.5 : byteRate(peer) / maxRate;
+        res.emplace_back((usefulness + scpLead + latency + throughput) / 4);
+    }
+    return res;
+}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace stellar
+{
+
+class Peer;
+
+// Scoring of connected peers by how much they help this node follow the
+// network, used to pick which outbound peer to rotate out (see
+// OUTBOUND_PEER_ROTATION_PERIOD_SECONDS).
+//
+// A score is the average of four components, each in [0, 1]:
+//  * usefulness: the share of the flooded bytes received from the peer that
+//    were new to this node rather than duplicates
+//  * SCP lead: the share of the SCP messages received from the peer that it
+//    delivered first
+//  * latency: the lowest ping among the peers scored, over the peer's own
+//  * throughput: the rate at which the peer sent bytes over its lifetime,
+//    over the highest rate among the peers scored
+// Ratios with nothing to measure yet count as 0.5, so that new peers are
+// neither favoured nor penalised. Latency and throughput being relative,
+// scores only compare peers scored together.
+struct PeerScoreInputs
+{
+    std::chrono::milliseconds mPing{0};
+    std::chrono::seconds mLifeTime{0};
+    uint64_t mByteRead{0};
+    uint64_t mUniqueFloodBytesRecv{0};
+    uint64_t mDuplicateFloodBytesRecv{0};
+    uint64_t mUniqueScpMessageRecv{0};
+    uint64_t mDuplicateScpMessageRecv{0};
+
+    static PeerScoreInputs fromPeer(Peer const& peer);
+};
+
+// Returns the score of each of `peers`, in order
+std::vector<double> scorePeers(std::vector<PeerScoreInputs> const& peers);
+}
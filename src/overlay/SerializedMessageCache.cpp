@@ -0,0 +1,46 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/SerializedMessageCache.h"
+#include "main/Application.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "util/Tracing.h"
+#include "util/XDRMarshal.h"
+
+namespace stellar
+{
+
+SerializedMessageCache::SerializedMessageCache(Application& app)
+    // Use a separate PRNG, as lookups happen off the main thread
+    : mCache(CACHE_SIZE, true)
+    , mReused(app.getMetrics().NewMeter({"overlay", "flood", "encode-reuse"},
+                                        "message"))
+{
+}
+
+void
+SerializedMessageCache::add(std::shared_ptr<StellarMessage const> const& msg)
+{
+    ZoneScoped;
+    // Encode outside of the lock, the overlay thread may be sending
+    auto body = std::make_shared<xdr::opaque_vec<> const>(
+        xdrToOpaque(*msg));
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCache.put(msg.get(), Entry{msg, std::move(body)});
+}
+
+SerializedMessageCache::Body
+SerializedMessageCache::maybeGet(StellarMessage const& msg)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto entry = mCache.maybeGet(&msg);
+    if (!entry)
+    {
+        return nullptr;
+    }
+    mReused.Mark();
+    return entry->mBody;
+}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include "util/RandomEvictionCache.h"
+#include "xdr/Stellar-overlay.h"
+
+#include <memory>
+#include <mutex>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+class Application;
+
+// Broadcasting hands the very same StellarMessage object to every peer, and
+// each peer used to encode it to XDR on its own before framing and MAC-ing
+// it. This cache holds the XDR encoding of recently broadcast messages, keyed
+// by the identity of the shared message object, so that the body is encoded
+// once and peers only add their own sequence number and MAC around it.
+//
+// Entries keep the message alive, so a cached address can never be reused by
+// a different message while it is in the cache. Only Floodgate::broadcast
+// adds entries; the send path only looks them up, and falls back to encoding
+// the message itself on a miss. Lookups may happen on the overlay thread.
+class SerializedMessageCache : private NonMovableOrCopyable
+{
+  public:
+    using Body = std::shared_ptr<xdr::opaque_vec<> const>;
+
+    explicit SerializedMessageCache(Application& app);
+
+    // Encode `msg` and remember the result.
+    void add(std::shared_ptr<StellarMessage const> const& msg);
+
+    // Return the encoding of `msg` if it was added and not yet evicted.
+    Body maybeGet(StellarMessage const& msg);
+
+  private:
+    static constexpr size_t CACHE_SIZE = 2048;
+
+    struct Entry
+    {
+        std::shared_ptr<StellarMessage const> mMessage;
+        Body mBody;
+    };
+
+    std::mutex mMutex;
+    RandomEvictionCache<StellarMessage const*, Entry> mCache;
+    medida::Meter& mReused;
+};
+}
@@ -9,8 +9,10 @@
 #include "util/Logging.h"
 #include "util/numeric.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+#include <algorithm>
 #include <chrono>
+#include <limits>
 
 using namespace std::chrono_literals;
 
@@ -66,6 +68,59 @@ initializeCollectingPeerData(
 
 } // namespace
 
+void
+SurveyHistogram::update(uint64_t value)
+{
+    size_t bucket = 0;
+    while (value > 0 && bucket < NUM_BUCKETS - 1)
+    {
+        value >>= 1;
+        ++bucket;
+    }
+    if (mCounts[bucket] < std::numeric_limits<uint32_t>::max())
+    {
+        ++mCounts[bucket];
+    }
+}
+
+void
+SurveyHistogram::merge(SurveyHistogram const& other)
+{
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+        uint64_t sum = uint64_t(mCounts[i]) + other.mCounts[i];
+        mCounts[i] = static_cast<uint32_t>(
+            std::min<uint64_t>(sum, std::numeric_limits<uint32_t>::max()));
+    }
+}
+
+Json::Value
+SurveyHistogram::getJson() const
+{
+    Json::Value res(Json::arrayValue);
+    size_t end = NUM_BUCKETS;
+    while (end > 0 && mCounts[end - 1] == 0)
+    {
+        --end;
+    }
+    for (size_t i = 0; i < end; ++i)
+    {
+        res.append(static_cast<Json::UInt>(mCounts[i]));
+    }
+    return res;
+}
+
+Json::Value
+SurveyNodeHistograms::getJson() const
+{
+    Json::Value res;
+    res["scpFirstToSelfLatencyMs"] = mSCPFirstToSelfLatencyMs.getJson();
+    res["txPullLatencyMs"] = mTxPullLatencyMs.getJson();
+    res["fetchLatencyMs"] = mFetchLatencyMs.getJson();
+    res["peerThroughputKiBps"] = mPeerThroughputKiBps.getJson();
+    return res;
+}
+
 CollectingNodeData::CollectingNodeData(uint64_t initialLostSyncCount,
                                        Application::State initialState)
     : mSCPFirstToSelfLatencyMsHistogram(
@@ -266,6 +321,16 @@ SurveyDataManager::recordDroppedPeer(Peer const& peer)
     }
 }
 
+std::optional<SurveyNodeHistograms>
+SurveyDataManager::getNodeHistograms() const
+{
+    if (mPhase != SurveyPhase::REPORTING)
+    {
+        return std::nullopt;
+    }
+    return mFinalNodeHistograms;
+}
+
 std::optional<uint32_t>
 SurveyDataManager::getNonce() const
 {
@@ -379,6 +444,7 @@ SurveyDataManager::reset()
     mCollectingInboundPeerData.clear();
     mCollectingOutboundPeerData.clear();
     mFinalNodeData.reset();
+    mFinalNodeHistograms.reset();
     mFinalInboundPeerData.clear();
     mFinalOutboundPeerData.clear();
 }
@@ -441,6 +507,19 @@ SurveyDataManager::finalizeNodeData(Config const& config)
         config.MAX_ADDITIONAL_PEER_CONNECTIONS;
     mFinalNodeData->maxOutboundPeerCount = config.TARGET_PEER_CONNECTIONS;
 
+    mFinalNodeHistograms = mCollectingNodeData->mHistograms;
+    for (auto const* peerData :
+         {&mFinalInboundPeerData, &mFinalOutboundPeerData})
+    {
+        for (auto const& peer : *peerData)
+        {
+            auto const& stats = peer.peerStats;
+            mFinalNodeHistograms->mPeerThroughputKiBps.update(
+                stats.bytesRead / 1024 /
+                std::max<uint64_t>(stats.secondsConnected, 1));
+        }
+    }
+
     // Clear collecting data
     mCollectingNodeData.reset();
 }
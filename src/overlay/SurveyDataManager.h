@@ -10,11 +10,13 @@
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
 
+#include "lib/json/json.h"
 #include "medida/histogram.h"
 #include "medida/meter.h"
 #include "xdr/Stellar-overlay.h"
 #include "xdr/Stellar-types.h"
 
+#include <array>
 #include <chrono>
 #include <mutex>
 #include <optional>
@@ -33,6 +35,36 @@ enum class SurveyPhase
     INACTIVE
 };
 
+// Compact histogram of survey samples: counts in power of two buckets,
+// [0, 1), [1, 2), [2, 4) ... and [2^14, inf). Unlike percentiles, the
+// histograms of several nodes can be summed into a network-wide one.
+struct SurveyHistogram
+{
+    static constexpr size_t NUM_BUCKETS = 16;
+    std::array<uint32_t, NUM_BUCKETS> mCounts{};
+
+    void update(uint64_t value);
+    void merge(SurveyHistogram const& other);
+    // Counts from the first bucket to the last non-empty one
+    Json::Value getJson() const;
+};
+
+// Histograms of this node's view of the network over a survey time slice
+struct SurveyNodeHistograms
+{
+    // SCP externalize delay after the first node (ms), like
+    // p75SCPFirstToSelfLatencyMs
+    SurveyHistogram mSCPFirstToSelfLatencyMs;
+    // Time to pull a flooded transaction from a peer after demanding it (ms)
+    SurveyHistogram mTxPullLatencyMs;
+    // Time for a peer to send a tx set or quorum set asked for (ms)
+    SurveyHistogram mFetchLatencyMs;
+    // Rate at which each peer sent data over the time slice (KiB/s)
+    SurveyHistogram mPeerThroughputKiBps;
+
+    Json::Value getJson() const;
+};
+
 struct CollectingNodeData
 {
     CollectingNodeData(uint64_t initialLostSyncCount,
@@ -46,6 +78,8 @@ struct CollectingNodeData
     medida::Histogram mSCPFirstToSelfLatencyMsHistogram;
     medida::Histogram mSCPSelfToOtherLatencyMsHistogram;
 
+    SurveyNodeHistograms mHistograms;
+
     // To compute how many times the node lost sync in the time slice
     uint64_t const mInitialLostSyncCount;
 
@@ -132,6 +166,9 @@ class SurveyDataManager : public NonMovableOrCopyable
     bool fillSurveyData(TimeSlicedSurveyRequestMessage const& request,
                         TopologyResponseBodyV2& response);
 
+    // Histograms of this node for the survey in the reporting phase, if any
+    std::optional<SurveyNodeHistograms> getNodeHistograms() const;
+
     // Returns `true` iff there is currently an active survey
     bool surveyIsActive() const;
 
@@ -171,6 +208,7 @@ class SurveyDataManager : public NonMovableOrCopyable
 
     // Finalized reporting phase data about this node
     std::optional<TimeSlicedNodeData> mFinalNodeData = std::nullopt;
+    std::optional<SurveyNodeHistograms> mFinalNodeHistograms = std::nullopt;
 
     // Data about peers during collecting phase
     std::unordered_map<NodeID, CollectingPeerData> mCollectingInboundPeerData;
@@ -964,6 +964,16 @@ SurveyManager::getJsonResults()
         badResponseNodes.append(KeyUtils::toStrKey(peer));
     }
 
+    // Responses have no room for histograms, only this node's are known
+    if (auto histograms = mSurveyDataManager.getNodeHistograms())
+    {
+        mResults["localHistograms"] = histograms->getJson();
+    }
+    else
+    {
+        mResults.removeMember("localHistograms");
+    }
+
     return mResults;
 }
 
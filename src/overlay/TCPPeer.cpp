@@ -8,6 +8,7 @@
 #include "main/Application.h"
 #include "main/Config.h"
 #include "main/ErrorMessages.h"
+#include "medida/histogram.h"
 #include "medida/meter.h"
 #include "overlay/FlowControl.h"
 #include "overlay/OverlayManager.h"
@@ -15,8 +16,9 @@
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
+#include "util/finally.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 using namespace soci;
@@ -37,6 +39,7 @@ TCPPeer::TCPPeer(Application& app, Peer::PeerRole role,
     , mThreadVars(useBackgroundThread())
     , mSocket(socket)
     , mIPAddress(std::move(address))
+    , mWriteDelayTimer(socket->next_layer().get_executor())
     , mLiveInboundPeersCounter(
           app.getOverlayManager().getLiveInboundPeersCounter())
 {
@@ -223,20 +226,67 @@ TCPPeer::~TCPPeer()
 }
 
 void
-TCPPeer::sendMessage(xdr::msg_ptr&& xdrBytes)
+TCPPeer::sendMessage(xdr::msg_ptr&& xdrBytes, bool canDelay)
 {
     releaseAssert(!threadIsMain() || !useBackgroundThread());
 
     TimestampedMessage msg;
     msg.mEnqueuedTime = mAppConnector.now();
+    size_t const sz = xdrBytes->raw_size();
     msg.mMessage = std::move(xdrBytes);
     mThreadVars.getWriteQueue().emplace_back(std::move(msg));
 
-    if (!mThreadVars.isWriting())
+    if (mThreadVars.isWriting())
     {
-        mThreadVars.setWriting(true);
-        messageSender();
+        // The message will go out with the next batch, once the write in
+        // flight completes
+        return;
+    }
+
+    // Bulk traffic to an idle peer may wait a little for more messages to
+    // share the same write, within the configured count and size budget
+    auto const& cfg = mAppConnector.getConfig();
+    auto& delayed = mThreadVars.getDelayedWrite();
+    if (canDelay && cfg.MAX_BATCH_WRITE_DELAY_MS.count() > 0)
+    {
+        if (!delayed)
+        {
+            delayed.emplace(0, 0);
+            auto self = static_pointer_cast<TCPPeer>(shared_from_this());
+            mWriteDelayTimer.expires_after(cfg.MAX_BATCH_WRITE_DELAY_MS);
+            mWriteDelayTimer.async_wait([self](asio::error_code const& ec) {
+                // Aborted when the write already started early
+                if (ec != asio::error::operation_aborted &&
+                    self->mThreadVars.getDelayedWrite())
+                {
+                    self->startWriting();
+                }
+            });
+        }
+        delayed->first += sz;
+        delayed->second += 1;
+        if (delayed->first < static_cast<size_t>(cfg.MAX_BATCH_WRITE_BYTES) &&
+            delayed->second < static_cast<size_t>(cfg.MAX_BATCH_WRITE_COUNT))
+        {
+            return;
+        }
+    }
+
+    startWriting();
+}
+
+void
+TCPPeer::startWriting()
+{
+    releaseAssert(!threadIsMain() || !useBackgroundThread());
+    releaseAssert(!mThreadVars.isWriting());
+    if (mThreadVars.getDelayedWrite())
+    {
+        mThreadVars.getDelayedWrite().reset();
+        mWriteDelayTimer.cancel();
     }
+    mThreadVars.setWriting(true);
+    messageSender();
 }
 
 void
@@ -277,6 +327,7 @@ TCPPeer::shutdown()
         // read/write handlers, i.e. fire them with an error
         // code indicating cancellation.
         auto self_ = std::static_pointer_cast<TCPPeer>(self);
+        self_->mWriteDelayTimer.cancel();
         asio::error_code ec2;
         self_->mSocket->close(ec2);
         if (ec2)
@@ -334,6 +385,9 @@ TCPPeer::messageSender()
     CLOG_DEBUG(Overlay, "messageSender {} - b:{} n:{}/{}", mIPAddress,
                expected_length, mThreadVars.getWriteBuffers().size(),
                mThreadVars.getWriteQueue().size());
+    mOverlayMetrics.mWriteBatchMessages.Update(
+        mThreadVars.getWriteBuffers().size());
+    mOverlayMetrics.mWriteBatchBytes.Update(expected_length);
     mOverlayMetrics.mAsyncWrite.Mark();
     mPeerMetrics.mAsyncWrite++;
     auto self = static_pointer_cast<TCPPeer>(shared_from_this());
@@ -534,6 +588,10 @@ TCPPeer::startRead()
         return;
     }
 
+    // Whichever way we leave the loop below, hand everything decoded so far
+    // to the main thread
+    auto flushBatch = gsl::finally([&]() { flushRecvBatch(); });
+
     mThreadVars.getIncomingHeader().clear();
 
     CLOG_DEBUG(Overlay, "TCPPeer::startRead {} from {}", mSocket->in_avail(),
@@ -730,7 +788,9 @@ TCPPeer::readBodyHandler(asio::error_code const& error,
     else
     {
         noteFullyReadBody(bytes_transferred);
-        if (!recvMessage())
+        bool ok = recvMessage();
+        flushRecvBatch();
+        if (!ok)
         {
             return;
         }
@@ -760,11 +820,9 @@ TCPPeer::recvMessage()
 
     try
     {
-        xdr::xdr_get g(mThreadVars.getIncomingBody().data(),
-                       mThreadVars.getIncomingBody().data() +
-                           mThreadVars.getIncomingBody().size());
+        auto const& body = mThreadVars.getIncomingBody();
         AuthenticatedMessage am;
-        xdr::xdr_argpack_archive(g, am);
+        decodeAuthenticatedMessage(body.data(), body.size(), am);
 
         valid = Peer::recvAuthenticatedMessage(std::move(am));
     }
@@ -782,6 +840,7 @@ TCPPeer::recvMessage()
 
     if (!errorMsg.empty())
     {
+        flushRecvBatch();
         auto drop = [errorMsg, self = shared_from_this()]() {
             // Queue up a drop; we may still process new messages
             // from this peer, which is harmless. Any new message processing
@@ -7,6 +7,7 @@
 #include "overlay/Peer.h"
 #include "util/Timer.h"
 #include <deque>
+#include <optional>
 
 namespace medida
 {
@@ -34,6 +35,9 @@ class TCPPeer : public Peer
         std::vector<asio::const_buffer> mWriteBuffers;
         bool const mUseBackgroundThread;
         bool mWriting{false};
+        // Bytes and messages queued since the write delay timer was armed,
+        // if it is armed
+        std::optional<std::pair<size_t, size_t>> mDelayedWrite;
         std::vector<uint8_t> mIncomingHeader;
         std::vector<uint8_t> mIncomingBody;
 
@@ -78,6 +82,12 @@ class TCPPeer : public Peer
             releaseAssert(!threadIsMain() || !mUseBackgroundThread);
             mWriting = value;
         }
+        std::optional<std::pair<size_t, size_t>>&
+        getDelayedWrite()
+        {
+            releaseAssert(!threadIsMain() || !mUseBackgroundThread);
+            return mDelayedWrite;
+        }
     };
 
     ThreadRestrictedVars mThreadVars;
@@ -87,11 +97,15 @@ class TCPPeer : public Peer
     std::atomic<bool> mDropStarted{false};
     std::shared_ptr<SocketType> mSocket;
     std::string const mIPAddress;
+    // Runs on the socket's executor, so it fires on the same thread as writes
+    asio::steady_timer mWriteDelayTimer;
 
     bool recvMessage();
-    void sendMessage(xdr::msg_ptr&& xdrBytes) override;
+    void sendMessage(xdr::msg_ptr&& xdrBytes, bool canDelay) override;
 
     void messageSender();
+    // Start writing the queue now, cancelling any pending write delay
+    void startWriting();
 
     size_t getIncomingMsgLength();
     virtual void connected() override;
@@ -9,12 +9,16 @@
 #include "crypto/Hex.h"
 #include "herder/Herder.h"
 #include "main/Application.h"
+#include "main/Config.h"
 #include "medida/meter.h"
+#include "medida/timer.h"
 #include "overlay/OverlayManager.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+
+#include <algorithm>
 
 namespace stellar
 {
@@ -72,7 +76,7 @@ Tracker::clearEnvelopesBelow(uint64 slotIndex, uint64 slotToKeep)
     }
 
     mTimer.cancel();
-    mLastAskedPeer = nullptr;
+    mPeersInFlight.clear();
 
     return false;
 }
@@ -80,26 +84,44 @@ Tracker::clearEnvelopesBelow(uint64 slotIndex, uint64 slotToKeep)
 void
 Tracker::doesntHave(Peer::pointer peer)
 {
-    if (mLastAskedPeer == peer)
+    auto it = std::find(mPeersInFlight.begin(), mPeersInFlight.end(), peer);
+    if (it != mPeersInFlight.end())
     {
         CLOG_TRACE(Overlay, "Does not have {}", hexAbbrev(mItemHash));
-        tryNextPeer();
+        mPeersInFlight.erase(it);
+        if (mPeersInFlight.empty())
+        {
+            tryNextPeer();
+        }
     }
 }
 
+std::chrono::milliseconds
+Tracker::estimateLatency(Peer::pointer const& peer)
+{
+    auto const& fetchLatency = peer->getPeerMetrics().mFetchLatency;
+    if (fetchLatency.count() > 0)
+    {
+        // in PEER_METRICS_DURATION_UNIT, which is milliseconds
+        return std::chrono::milliseconds(
+            static_cast<int64>(fetchLatency.mean()));
+    }
+    return peer->getPing();
+}
+
 void
 Tracker::tryNextPeer()
 {
     ZoneScoped;
     // will be called by some timer or when we get a
     // response saying they don't have it
-    CLOG_TRACE(Overlay, "tryNextPeer {} last: {}", hexAbbrev(mItemHash),
-               (mLastAskedPeer ? mLastAskedPeer->toString() : "<none>"));
+    CLOG_TRACE(Overlay, "tryNextPeer {} in flight: {}", hexAbbrev(mItemHash),
+               mPeersInFlight.size());
 
-    if (mLastAskedPeer)
+    if (!mPeersInFlight.empty())
     {
         mTryNextPeer.Mark();
-        mLastAskedPeer.reset();
+        mPeersInFlight.clear();
     }
 
     // canAskPeer is best effort and send happens asynchronously; in the worst
@@ -111,21 +133,19 @@ Tracker::tryNextPeer()
                 (it == mPeersAsked.end() || (peerHas && !it->second)));
     };
 
-    // Helper function to populate "candidates" with a set of peers, which we're
-    // going to randomly select a candidate from to ask for the item.
+    // Helper function to populate "candidates" with the peers we can ask,
+    // along with how near they are to us.
     //
-    // We want to bias the candidates set towards peers that are close to us in
-    // terms of network latency, so we repeatedly lower a "nearness threshold"
-    // in units of 500ms (1/3 of the MS_TO_WAIT_FOR_FETCH_REPLY) until we have a
-    // "closest peers" bucket that we have at least one peer for, and keep all
-    // the peers in that bucket, and then (later) randomly select from it.
+    // We want to bias the candidates towards peers that are close to us in
+    // terms of network latency, so we group them by latency in units of
+    // 500ms (1/3 of the MS_TO_WAIT_FOR_FETCH_REPLY), and (later) ask peers
+    // of the nearest groups first, picking randomly within a group.
     //
     // if the map of peers passed in is for peers that claim to have the data we
     // need, `peersHave` is also set to true. in this case, the candidate list
     // will also be populated with peers that we asked before but that since
     // then received the data that we need
-    std::vector<Peer::pointer> candidates;
-    int64 curBest = INT64_MAX;
+    std::vector<std::pair<int64, Peer::pointer>> candidates;
 
     auto procPeers = [&](std::map<NodeID, Peer::pointer> const& peerMap,
                          bool peersHave) {
@@ -135,17 +155,8 @@ Tracker::tryNextPeer()
             if (canAskPeer(p, peersHave))
             {
                 int64 GROUPSIZE_MS = (MS_TO_WAIT_FOR_FETCH_REPLY.count() / 3);
-                int64 plat = p->getPing().count() / GROUPSIZE_MS;
-                if (plat < curBest)
-                {
-                    candidates.clear();
-                    curBest = plat;
-                    candidates.emplace_back(p);
-                }
-                else if (curBest == plat)
-                {
-                    candidates.emplace_back(p);
-                }
+                int64 plat = estimateLatency(p).count() / GROUPSIZE_MS;
+                candidates.emplace_back(plat, p);
             }
         }
     };
@@ -179,14 +190,20 @@ Tracker::tryNextPeer()
         procPeers(outPeers, false);
     }
 
-    // pick a random element from the candidate list
-    if (!candidates.empty())
+    // pick the nearest candidates, randomly within a latency group
+    std::shuffle(candidates.begin(), candidates.end(), gRandomEngine);
+    std::stable_sort(
+        candidates.begin(), candidates.end(),
+        [](auto const& a, auto const& b) { return a.first < b.first; });
+    auto parallelPeers = std::min<size_t>(
+        candidates.size(), mApp.getConfig().FETCH_PARALLEL_PEERS);
+    for (size_t i = 0; i < parallelPeers; ++i)
     {
-        mLastAskedPeer = rand_element(candidates);
+        mPeersInFlight.emplace_back(candidates[i].second);
     }
 
     std::chrono::milliseconds nextTry;
-    if (!mLastAskedPeer)
+    if (mPeersInFlight.empty())
     {
         // we have asked all our peers, reset the list and try again after a
         // pause
@@ -201,10 +218,13 @@ Tracker::tryNextPeer()
     }
     else
     {
-        mPeersAsked[mLastAskedPeer] = peerWithEnvelopeSelected;
-        CLOG_TRACE(Overlay, "Asking for {} to {}", hexAbbrev(mItemHash),
-                   mLastAskedPeer->toString());
-        mAskPeer(mLastAskedPeer, mItemHash);
+        for (auto const& peer : mPeersInFlight)
+        {
+            mPeersAsked[peer] = peerWithEnvelopeSelected;
+            CLOG_TRACE(Overlay, "Asking for {} to {}", hexAbbrev(mItemHash),
+                       peer->toString());
+            mAskPeer(peer, mItemHash);
+        }
         nextTry = MS_TO_WAIT_FOR_FETCH_REPLY;
     }
 
@@ -12,6 +12,10 @@
  * with new set of peers (possibly overlapping, as peers may learned about
  * this data set in meantime).
  *
+ * Up to FETCH_PARALLEL_PEERS peers are asked at once, nearest first by their
+ * measured fetch latency (or ping until they have served a fetch), so that a
+ * slow peer doesn't hold up the item.
+ *
  * For asking a AskPeer delegate is used.
  *
  * Tracker keeps list of envelopes that requires given data set to be
@@ -42,7 +46,8 @@ class Tracker
   private:
     AskPeer mAskPeer;
     Application& mApp;
-    Peer::pointer mLastAskedPeer;
+    // peers asked in the current round that haven't answered yet
+    std::vector<Peer::pointer> mPeersInFlight;
     int mNumListRebuild;
     // keep track of which peer we asked, and if we thought if it had the data
     // or not at the time
@@ -54,6 +59,8 @@ class Tracker
     uint64 mLastSeenSlotIndex{0};
     LogSlowExecution mFetchTime;
 
+    static std::chrono::milliseconds estimateLatency(Peer::pointer const& peer);
+
   public:
     static std::chrono::milliseconds const MS_TO_WAIT_FOR_FETCH_REPLY;
     static int const MAX_REBUILD_FETCH_LIST;
@@ -128,7 +135,7 @@ class Tracker
 
     /**
      * Called when given @p peer informs that it does not have given data.
-     * Next peer will be tried if available.
+     * Next peers will be tried if no other asked peer is left to answer.
      */
     void doesntHave(Peer::pointer peer);
 
@@ -160,7 +167,13 @@ class Tracker
     Peer::pointer
     getLastAskedPeer()
     {
-        return mLastAskedPeer;
+        return mPeersInFlight.empty() ? nullptr : mPeersInFlight.back();
+    }
+
+    std::vector<Peer::pointer> const&
+    getPeersInFlight() const
+    {
+        return mPeersInFlight;
     }
 #endif
 };
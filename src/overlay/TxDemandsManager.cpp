@@ -6,12 +6,14 @@
 #include "crypto/Hex.h"
 #include "herder/Herder.h"
 #include "medida/meter.h"
+#include "medida/timer.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
+#include "overlay/SurveyManager.h"
 #include "overlay/TxAdverts.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/numeric.h"
-#include <Tracy.hpp>
 #include <algorithm>
 
 namespace stellar
@@ -67,12 +69,30 @@ TxDemandsManager::retryDelayDemand(int numAttemptsMade) const
     return std::min(res, std::chrono::milliseconds(MAX_DELAY_DEMAND));
 }
 
+void
+TxDemandsManager::clearBelow(uint32_t lclSeq)
+{
+    if (lclSeq != mKnownTxHashesLedger)
+    {
+        mKnownTxHashesLedger = lclSeq;
+        mPrevKnownTxHashes = std::move(mKnownTxHashes);
+        mKnownTxHashes.clear();
+    }
+}
+
 TxDemandsManager::DemandStatus
-TxDemandsManager::demandStatus(Hash const& txHash, Peer::pointer peer) const
+TxDemandsManager::demandStatus(Hash const& txHash, Peer::pointer peer)
 {
+    if (mKnownTxHashes.count(txHash) != 0 ||
+        mPrevKnownTxHashes.count(txHash) != 0)
+    {
+        mApp.getOverlayManager().getOverlayMetrics().mKnownAdvertSkip.Mark();
+        return DemandStatus::DISCARD;
+    }
     if (mApp.getHerder().isBannedTx(txHash) ||
         mApp.getHerder().getTx(txHash) != nullptr)
     {
+        mKnownTxHashes.insert(txHash);
         return DemandStatus::DISCARD;
     }
     auto it = mDemandHistoryMap.find(txHash);
@@ -103,6 +123,7 @@ TxDemandsManager::demandStatus(Hash const& txHash, Peer::pointer peer) const
             return DemandStatus::RETRY_LATER;
         }
     }
+    mKnownTxHashes.insert(txHash);
     return DemandStatus::DISCARD;
 }
 
@@ -129,6 +150,7 @@ TxDemandsManager::demand()
     auto const now = mApp.getClock().now();
 
     auto& om = mApp.getOverlayManager().getOverlayMetrics();
+    auto timer = om.mDemandTickTimer.TimeScope();
 
     // We determine that demands are obsolete after maxRetention.
     auto maxRetention = MAX_DELAY_DEMAND * MAX_RETRY_COUNT * 2;
@@ -243,6 +265,13 @@ TxDemandsManager::recordTxPullLatency(Hash const& hash,
             auto delta = now - it->second.firstDemanded;
             om.mTxPullLatency.Update(delta);
             it->second.latencyRecorded = true;
+            mApp.getOverlayManager().getSurveyManager().modifyNodeData(
+                [&](CollectingNodeData& nodeData) {
+                    nodeData.mHistograms.mTxPullLatencyMs.update(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(
+                            delta)
+                            .count());
+                });
             CLOG_DEBUG(
                 Overlay,
                 "Pulled transaction {} in {} milliseconds, asked {} peers",
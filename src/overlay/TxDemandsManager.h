@@ -6,6 +6,7 @@
 
 #include "overlay/Peer.h"
 #include "util/NonCopyable.h"
+#include "util/UnorderedSet.h"
 
 namespace medida
 {
@@ -38,6 +39,18 @@ class TxDemandsManager : private NonMovableOrCopyable
     // Stop demanding transactions from peers
     void shutdown();
 
+    // Rotate the set of known transaction hashes once per ledger
+    void clearBelow(uint32_t lclSeq);
+
+#ifdef BUILD_TESTS
+    bool
+    isKnownTxHash(Hash const& hash) const
+    {
+        return mKnownTxHashes.count(hash) != 0 ||
+               mPrevKnownTxHashes.count(hash) != 0;
+    }
+#endif
+
   private:
     // After `MAX_RETRY_COUNT` attempts with linear back-off, we assume that
     // no one has the transaction.
@@ -63,6 +76,15 @@ class TxDemandsManager : private NonMovableOrCopyable
     UnorderedMap<Hash, DemandHistory> mDemandHistoryMap;
     std::queue<Hash> mPendingDemands;
 
+    // Hashes that are never worth demanding again: we already have (or
+    // banned) the transaction, or we ran out of retries. Shared by all peers,
+    // so that a hash advertised by many peers is resolved with one lookup
+    // instead of going through the herder for each of them. Entries live for
+    // one to two ledgers.
+    UnorderedSet<Hash> mKnownTxHashes;
+    UnorderedSet<Hash> mPrevKnownTxHashes;
+    uint32_t mKnownTxHashesLedger{0};
+
     // Begin demanding on schedule
     void startDemandTimer();
 
@@ -73,7 +95,7 @@ class TxDemandsManager : private NonMovableOrCopyable
     size_t getMaxDemandSize() const;
 
     // Decide whether to demand a transaction now, retry later or discard
-    DemandStatus demandStatus(Hash const& txHash, Peer::pointer) const;
+    DemandStatus demandStatus(Hash const& txHash, Peer::pointer);
 
     // Compute delay between demand retries, with linear backoff
     std::chrono::milliseconds retryDelayDemand(int numAttemptsMade) const;
@@ -10,6 +10,7 @@
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "overlay/Floodgate.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
 #include "overlay/PeerDoor.h"
@@ -18,6 +19,7 @@
 #include "simulation/Simulation.h"
 #include "simulation/Topologies.h"
 #include "test/TestAccount.h"
+#include "test/TestUtils.h"
 #include "test/TxTests.h"
 #include "test/test.h"
 #include "util/Logging.h"
@@ -554,4 +556,39 @@ TEST_CASE("Flooding", "[flood][overlay][acceptance]")
         }
     }
 }
+
+TEST_CASE("floodgate records", "[flood][overlay]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    Floodgate floodgate(*app);
+    auto ledger = app->getHerder().trackingConsensusLedgerIndex();
+
+    auto h1 = sha256("message 1");
+    auto h2 = sha256("message 2");
+    REQUIRE(floodgate.getEstimatedBytes() == 0);
+    REQUIRE(floodgate.addRecord(h1, nullptr));
+    REQUIRE(!floodgate.addRecord(h1, nullptr));
+    REQUIRE(floodgate.addRecord(h2, nullptr));
+    REQUIRE(floodgate.getEstimatedBytes() > 0);
+    REQUIRE(floodgate.getPeersKnows(h1).empty());
+
+    SECTION("forget")
+    {
+        floodgate.forgetRecord(h1);
+        REQUIRE(floodgate.addRecord(h1, nullptr));
+        REQUIRE(!floodgate.addRecord(h2, nullptr));
+    }
+
+    SECTION("clear")
+    {
+        floodgate.clearBelow(ledger);
+        REQUIRE(!floodgate.addRecord(h1, nullptr));
+
+        floodgate.clearBelow(ledger + 1);
+        REQUIRE(floodgate.getEstimatedBytes() == 0);
+        REQUIRE(floodgate.addRecord(h1, nullptr));
+        REQUIRE(floodgate.addRecord(h2, nullptr));
+    }
+}
 }
@@ -19,6 +19,8 @@
 #include "test/test.h"
 #include "xdr/Stellar-types.h"
 
+#include <algorithm>
+
 namespace stellar
 {
 
@@ -485,4 +487,78 @@ TEST_CASE("next peer strategy", "[overlay][ItemFetcher]")
         }
     }
 }
+
+TEST_CASE("parallel fetch from nearest peers", "[overlay][ItemFetcher]")
+{
+    auto networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto sim =
+        std::make_shared<Simulation>(Simulation::OVER_LOOPBACK, networkID);
+
+    auto cfgMain = getTestConfig(1);
+    cfgMain.FETCH_PARALLEL_PEERS = 2;
+    auto cfg1 = getTestConfig(2);
+    auto cfg2 = getTestConfig(3);
+    auto cfg3 = getTestConfig(4);
+
+    SIMULATION_CREATE_NODE(Main);
+    SIMULATION_CREATE_NODE(Node1);
+    SIMULATION_CREATE_NODE(Node2);
+    SIMULATION_CREATE_NODE(Node3);
+    sim->addNode(vMainSecretKey, cfgMain.QUORUM_SET, &cfgMain);
+    sim->addNode(vNode1SecretKey, cfg1.QUORUM_SET, &cfg1);
+    sim->addNode(vNode2SecretKey, cfg2.QUORUM_SET, &cfg2);
+    sim->addNode(vNode3SecretKey, cfg3.QUORUM_SET, &cfg3);
+    sim->addPendingConnection(vMainNodeID, vNode1NodeID);
+    sim->addPendingConnection(vMainNodeID, vNode2NodeID);
+    sim->addPendingConnection(vMainNodeID, vNode3NodeID);
+    sim->startAllNodes();
+    std::vector<Peer::pointer> peers;
+    for (auto const& id : {vNode1NodeID, vNode2NodeID, vNode3NodeID})
+    {
+        peers.emplace_back(
+            sim->getLoopbackConnection(vMainNodeID, id)->getInitiator());
+    }
+    sim->crankUntil(
+        [&]() {
+            return std::all_of(peers.begin(), peers.end(), [](auto const& p) {
+                return p->isAuthenticatedForTesting();
+            });
+        },
+        std::chrono::seconds{3}, false);
+
+    // Node1 has served fetches faster than the others
+    peers[0]->getPeerMetrics().mFetchLatency.Update(
+        std::chrono::milliseconds(1));
+    for (size_t i = 1; i < peers.size(); ++i)
+    {
+        peers[i]->getPeerMetrics().mFetchLatency.Update(
+            std::chrono::seconds(10));
+    }
+
+    auto app = sim->getNode(vMainNodeID);
+    std::vector<Peer::pointer> asked;
+    ItemFetcher itemFetcher(*app,
+                            [&](Peer::pointer p, Hash) { asked.push_back(p); });
+
+    auto hundred = sha256(ByteSlice("100"));
+    itemFetcher.fetch(hundred, makeEnvelope(100));
+    auto tracker = itemFetcher.getTracker(hundred);
+    REQUIRE(tracker);
+    REQUIRE(asked.size() == 2);
+    REQUIRE(tracker->getPeersInFlight() == asked);
+    REQUIRE(std::find(asked.begin(), asked.end(), peers[0]) != asked.end());
+
+    // Another asked peer can still answer
+    itemFetcher.doesntHave(hundred, asked[0]);
+    REQUIRE(asked.size() == 2);
+    REQUIRE(tracker->getPeersInFlight().size() == 1);
+
+    // Once none can, the remaining peer is asked
+    itemFetcher.doesntHave(hundred, asked[1]);
+    REQUIRE(asked.size() == 3);
+    REQUIRE(tracker->getPeersInFlight().size() == 1);
+    std::sort(asked.begin(), asked.end());
+    std::sort(peers.begin(), peers.end());
+    REQUIRE(asked == peers);
+}
 }
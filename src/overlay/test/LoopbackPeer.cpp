@@ -12,8 +12,8 @@
 #include "overlay/StellarXDR.h"
 #include "util/Logging.h"
 #include "util/Math.h"
+#include "util/Tracing.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -24,7 +24,8 @@ using namespace std;
 // LoopbackPeer
 ///////////////////////////////////////////////////////////////////////
 
-LoopbackPeer::LoopbackPeer(Application& app, PeerRole role) : Peer(app, role)
+LoopbackPeer::LoopbackPeer(Application& app, PeerRole role)
+    : Peer(app, role), mArrivalTimer(app)
 {
     mFlowControl =
         std::make_shared<FlowControl>(mAppConnector, useBackgroundThread());
@@ -97,7 +98,7 @@ LoopbackPeer::scheduleRead()
 }
 
 void
-LoopbackPeer::sendMessage(xdr::msg_ptr&& msg)
+LoopbackPeer::sendMessage(xdr::msg_ptr&& msg, bool canDelay)
 {
     if (mRemote.expired())
     {
@@ -170,6 +171,7 @@ LoopbackPeer::drop(std::string const& reason, DropDirection direction)
     mDropReason = reason;
     mState = CLOSING;
     cancelTimers();
+    mArrivalTimer.cancel();
     mAppConnector.getOverlayManager().removePeer(this);
 
     auto remote = mRemote.lock();
@@ -264,7 +266,9 @@ LoopbackPeer::recvMessage(xdr::msg_ptr const& msg)
         AuthenticatedMessage am;
         {
             ZoneNamedN(xdrZone, "XDR deserialize", true);
-            xdr::xdr_from_msg(msg, am);
+            decodeAuthenticatedMessage(
+                reinterpret_cast<uint8_t const*>(msg->data()), msg->size(),
+                am);
         }
         recvAuthenticatedMessage(std::move(am));
     }
@@ -338,23 +342,19 @@ LoopbackPeer::deliverOne()
 
         mEnqueueTimeOfLastWrite = msg.mEnqueuedTime;
 
-        // Pass ownership of a serialized XDR message buffer to a recvMesage
-        // callback event against the remote Peer, posted on the remote
-        // Peer's io_context.
-        auto remote = mRemote.lock();
-        if (remote)
+        if (mLinkModel.delaysMessages())
+        {
+            mInFlight.emplace_back(getArrivalTime(nBytes),
+                                   std::move(msg.mMessage));
+            // Otherwise the timer is already set for an earlier message
+            if (mInFlight.size() == 1)
+            {
+                deliverArrived();
+            }
+        }
+        else
         {
-            // move msg to remote's in queue
-            remote->mInQueue.emplace(std::move(msg.mMessage));
-            remote->mAppConnector.postOnMainThread(
-                [remW = mRemote]() {
-                    auto remS = remW.lock();
-                    if (remS)
-                    {
-                        remS->processInQueue();
-                    }
-                },
-                "LoopbackPeer: processInQueue in deliverOne");
+            deliverToRemote(std::move(msg.mMessage));
         }
         mLastWrite = mAppConnector.now();
         mOverlayMetrics.mMessageWrite.Mark();
@@ -364,6 +364,89 @@ LoopbackPeer::deliverOne()
     }
 }
 
+void
+LoopbackPeer::deliverToRemote(xdr::msg_ptr&& msg)
+{
+    // Pass ownership of a serialized XDR message buffer to a recvMesage
+    // callback event against the remote Peer, posted on the remote
+    // Peer's io_context.
+    auto remote = mRemote.lock();
+    if (remote)
+    {
+        // move msg to remote's in queue
+        remote->mInQueue.emplace(std::move(msg));
+        remote->mAppConnector.postOnMainThread(
+            [remW = mRemote]() {
+                auto remS = remW.lock();
+                if (remS)
+                {
+                    remS->processInQueue();
+                }
+            },
+            "LoopbackPeer: processInQueue in deliverOne");
+    }
+}
+
+VirtualClock::time_point
+LoopbackPeer::getArrivalTime(size_t nBytes)
+{
+    auto now = mAppConnector.now();
+    auto departure = now;
+    if (mLinkModel.mBytesPerSecond != 0)
+    {
+        // The bucket goes into debt for a message larger than what it holds,
+        // which delays the message until the debt is paid back
+        double rate = static_cast<double>(mLinkModel.mBytesPerSecond);
+        std::chrono::duration<double> elapsed = now - mTokensUpdated;
+        mTokens = std::min(static_cast<double>(mLinkModel.mBurstBytes),
+                           mTokens + elapsed.count() * rate);
+        mTokensUpdated = now;
+        mTokens -= static_cast<double>(nBytes);
+        if (mTokens < 0)
+        {
+            departure += std::chrono::duration_cast<VirtualClock::duration>(
+                std::chrono::duration<double>(-mTokens / rate));
+        }
+    }
+
+    auto arrival = departure + mLinkModel.mLatency;
+    if (mLinkModel.mJitter.count() != 0)
+    {
+        std::exponential_distribution<double> jitter(
+            1.0 / static_cast<double>(mLinkModel.mJitter.count()));
+        arrival += std::chrono::microseconds(
+            static_cast<int64_t>(jitter(gRandomEngine)));
+    }
+    mLastArrival = std::max(arrival, mLastArrival);
+    return mLastArrival;
+}
+
+void
+LoopbackPeer::deliverArrived()
+{
+    auto now = mAppConnector.now();
+    while (!mInFlight.empty() && mInFlight.front().first <= now)
+    {
+        deliverToRemote(std::move(mInFlight.front().second));
+        mInFlight.pop_front();
+    }
+    if (!mInFlight.empty())
+    {
+        std::weak_ptr<LoopbackPeer> weak =
+            static_pointer_cast<LoopbackPeer>(shared_from_this());
+        mArrivalTimer.expires_at(mInFlight.front().first);
+        mArrivalTimer.async_wait(
+            [weak]() {
+                auto self = weak.lock();
+                if (self)
+                {
+                    self->deliverArrived();
+                }
+            },
+            &VirtualTimer::onFailureNoop);
+    }
+}
+
 void
 LoopbackPeer::deliverAll()
 {
@@ -419,6 +502,8 @@ LoopbackPeer::clearInAndOutQueues()
 {
     mOutQueue.clear();
     mInQueue = std::queue<xdr::msg_ptr>();
+    mInFlight.clear();
+    mArrivalTimer.cancel();
 }
 
 bool
@@ -530,6 +615,24 @@ LoopbackPeer::setReorderProbability(double d)
     mReorderProb = bernoulli_distribution(d);
 }
 
+LoopbackLinkModel const&
+LoopbackPeer::getLinkModel() const
+{
+    return mLinkModel;
+}
+
+void
+LoopbackPeer::setLinkModel(LoopbackLinkModel const& model)
+{
+    checkProbRange(model.mDropProbability);
+    checkProbRange(model.mReorderProbability);
+    mLinkModel = model;
+    mDropProb = bernoulli_distribution(model.mDropProbability);
+    mReorderProb = bernoulli_distribution(model.mReorderProbability);
+    mTokens = static_cast<double>(model.mBurstBytes);
+    mTokensUpdated = mAppConnector.now();
+}
+
 LoopbackPeerConnection::LoopbackPeerConnection(Application& initiator,
                                                Application& acceptor)
 {
@@ -6,6 +6,8 @@
 
 #include "overlay/FlowControl.h"
 #include "overlay/Peer.h"
+#include "util/Timer.h"
+#include <chrono>
 #include <deque>
 #include <random>
 
@@ -15,6 +17,31 @@ Another peer out there that we are connected to
 
 namespace stellar
 {
+// [testing] Network conditions of one direction of a loopback link. The
+// default is an ideal link, delivering every message as soon as it is sent.
+struct LoopbackLinkModel
+{
+    // One-way delay of each message: mLatency, plus a jitter drawn from an
+    // exponential distribution of mean mJitter for a long tail. Messages
+    // still arrive in the order they were sent, as over TCP.
+    std::chrono::microseconds mLatency{0};
+    std::chrono::microseconds mJitter{0};
+    // Token bucket capping the bandwidth (0 is unlimited): messages leave
+    // once the bucket, refilled at mBytesPerSecond up to mBurstBytes, holds
+    // their size
+    uint64_t mBytesPerSecond{0};
+    uint64_t mBurstBytes{0};
+    double mDropProbability{0.0};
+    double mReorderProbability{0.0};
+
+    bool
+    delaysMessages() const
+    {
+        return mLatency.count() != 0 || mJitter.count() != 0 ||
+               mBytesPerSecond != 0;
+    }
+};
+
 // [testing] Peer that communicates via byte-buffer delivery events queued in
 // in-process io_contexts.
 //
@@ -40,6 +67,14 @@ class LoopbackPeer : public Peer
     std::bernoulli_distribution mDamageProb{0.0};
     std::bernoulli_distribution mDropProb{0.0};
 
+    LoopbackLinkModel mLinkModel;
+    double mTokens{0};
+    VirtualClock::time_point mTokensUpdated;
+    VirtualClock::time_point mLastArrival;
+    // Messages on the wire, by arrival time
+    std::deque<std::pair<VirtualClock::time_point, xdr::msg_ptr>> mInFlight;
+    VirtualTimer mArrivalTimer;
+
     struct Stats
     {
         size_t messagesDuplicated{0};
@@ -53,12 +88,16 @@ class LoopbackPeer : public Peer
 
     Stats mStats;
 
-    void sendMessage(xdr::msg_ptr&& xdrBytes) override;
+    void sendMessage(xdr::msg_ptr&& xdrBytes, bool canDelay) override;
     AuthCert getAuthCert() override;
 
     void processInQueue();
     void recvMessage(xdr::msg_ptr const& xdrBytes);
 
+    VirtualClock::time_point getArrivalTime(size_t nBytes);
+    void deliverToRemote(xdr::msg_ptr&& msg);
+    void deliverArrived();
+
   public:
     virtual ~LoopbackPeer()
     {
@@ -110,6 +149,9 @@ class LoopbackPeer : public Peer
     double getReorderProbability() const;
     void setReorderProbability(double d);
 
+    LoopbackLinkModel const& getLinkModel() const;
+    void setLinkModel(LoopbackLinkModel const& model);
+
     void clearInAndOutQueues();
 
     virtual bool
@@ -12,6 +12,7 @@
 #include "overlay/FlowControlCapacity.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayManagerImpl.h"
+#include "overlay/PeerScore.h"
 #include "overlay/TxAdverts.h"
 #include "test/TestAccount.h"
 #include "test/TestUtils.h"
@@ -47,7 +48,7 @@ class PeerStub : public Peer
     {
     }
     virtual void
-    sendMessage(xdr::msg_ptr&& xdrBytes) override
+    sendMessage(xdr::msg_ptr&& xdrBytes, bool canDelay) override
     {
     }
     virtual void
@@ -165,6 +166,7 @@ class OverlayManagerTests
             pm.storeConfigPeers();
         }
 
+        pm.getPeerManager().flush();
         rowset<row> rs = app->getDatabase().getSession().prepare
                          << "SELECT ip,port,type FROM peers ORDER BY ip, port";
 
@@ -213,6 +215,7 @@ class OverlayManagerTests
         pm.mResolvedPeers.wait();
         pm.tick();
 
+        pm.getPeerManager().flush();
         rowset<row> rs = app->getDatabase().getSession().prepare
                          << "SELECT ip,port,type FROM peers ORDER BY ip, port";
 
@@ -329,4 +332,52 @@ TEST_CASE_METHOD(OverlayManagerTests, "broadcast() broadcasts", "[overlay]")
 {
     testBroadcast();
 }
+
+TEST_CASE("peer scores", "[overlay]")
+{
+    auto peer = [](uint64_t pingMs, uint64_t byteRead, uint64_t uniqueFlood,
+                   uint64_t duplicateFlood, uint64_t uniqueScp,
+                   uint64_t duplicateScp) {
+        PeerScoreInputs res;
+        res.mPing = std::chrono::milliseconds(pingMs);
+        res.mLifeTime = std::chrono::seconds(100);
+        res.mByteRead = byteRead;
+        res.mUniqueFloodBytesRecv = uniqueFlood;
+        res.mDuplicateFloodBytesRecv = duplicateFlood;
+        res.mUniqueScpMessageRecv = uniqueScp;
+        res.mDuplicateScpMessageRecv = duplicateScp;
+        return res;
+    };
+
+    SECTION("no peers")
+    {
+        REQUIRE(scorePeers({}).empty());
+    }
+
+    SECTION("best peer in every respect scores 1")
+    {
+        auto scores = scorePeers({peer(10, 1000, 100, 0, 10, 0),
+                                  peer(40, 500, 50, 50, 5, 5)});
+        REQUIRE(scores.size() == 2);
+        REQUIRE(scores[0] == Approx(1.0));
+        // (0.5 + 0.5 + 0.25 + 0.5) / 4
+        REQUIRE(scores[1] == Approx(0.4375));
+    }
+
+    SECTION("no traffic yet is neutral")
+    {
+        auto scores = scorePeers({peer(10, 0, 0, 0, 0, 0)});
+        // (0.5 + 0.5 + 1 + 0.5) / 4
+        REQUIRE(scores[0] == Approx(0.625));
+    }
+
+    SECTION("peer that only relays duplicates late scores lowest")
+    {
+        auto scores = scorePeers({peer(20, 1000, 900, 100, 9, 1),
+                                  peer(20, 1000, 0, 1000, 0, 10),
+                                  peer(20, 1000, 500, 500, 5, 5)});
+        REQUIRE(scores[1] < scores[2]);
+        REQUIRE(scores[2] < scores[0]);
+    }
+}
 }
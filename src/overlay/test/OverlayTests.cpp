@@ -8,6 +8,8 @@
 #include "main/Application.h"
 #include "main/Config.h"
 #include "overlay/BanManager.h"
+#include "overlay/Hmac.h"
+#include "overlay/MessageCompression.h"
 #include "overlay/OverlayManagerImpl.h"
 #include "overlay/Peer.h"
 #include "overlay/PeerManager.h"
@@ -23,6 +25,7 @@
 #include "util/Timer.h"
 
 #include "herder/HerderImpl.h"
+#include "medida/counter.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
@@ -114,6 +117,57 @@ TEST_CASE("loopback peer with 0 port", "[overlay][connections]")
     testutil::shutdownWorkScheduler(*app1);
 }
 
+TEST_CASE("loopback peer link model", "[overlay][connections]")
+{
+    LoopbackLinkModel model;
+    model.mLatency = std::chrono::milliseconds(200);
+    model.mJitter = std::chrono::milliseconds(10);
+    model.mBytesPerSecond = 100000;
+
+    SECTION("delays the handshake")
+    {
+        VirtualClock clock;
+        auto app1 = createTestApplication(clock, getTestConfig(0));
+        auto app2 = createTestApplication(clock, getTestConfig(1));
+
+        LoopbackPeerConnection conn(*app1, *app2);
+        conn.getInitiator()->setLinkModel(model);
+        conn.getAcceptor()->setLinkModel(model);
+        testutil::crankFor(clock, std::chrono::milliseconds(300));
+        REQUIRE(!conn.getInitiator()->isAuthenticatedForTesting());
+        testutil::crankFor(clock, std::chrono::seconds(2));
+        REQUIRE(conn.getInitiator()->isAuthenticatedForTesting());
+        REQUIRE(conn.getAcceptor()->isAuthenticatedForTesting());
+
+        testutil::shutdownWorkScheduler(*app2);
+        testutil::shutdownWorkScheduler(*app1);
+    }
+
+    SECTION("applies to simulation edges")
+    {
+        Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+        auto simulation =
+            Topologies::pair(Simulation::OVER_LOOPBACK, networkID);
+        auto nodes = simulation->getNodeIDs();
+        simulation->setDefaultLinkModel(model);
+        simulation->startAllNodes();
+
+        auto conn = simulation->getLoopbackConnection(nodes[0], nodes[1]);
+        if (!conn)
+        {
+            conn = simulation->getLoopbackConnection(nodes[1], nodes[0]);
+        }
+        REQUIRE(conn);
+        REQUIRE(conn->getInitiator()->getLinkModel().mLatency ==
+                model.mLatency);
+        REQUIRE(conn->getAcceptor()->getLinkModel().mBytesPerSecond ==
+                model.mBytesPerSecond);
+        simulation->crankUntil(
+            [&]() { return simulation->haveAllExternalized(3, 1); },
+            2 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+    }
+}
+
 TEST_CASE("loopback peer send auth before hello", "[overlay][connections]")
 {
     VirtualClock clock;
@@ -868,6 +922,197 @@ TEST_CASE("failed auth", "[overlay][connections]")
     testutil::shutdownWorkScheduler(*app1);
 }
 
+TEST_CASE("authenticate pre-serialized message", "[overlay]")
+{
+    HmacSha256Key key;
+    key.key[0] = 1;
+    Hmac regular;
+    Hmac preSerialized;
+    REQUIRE(regular.setSendMackey(key));
+    REQUIRE(preSerialized.setSendMackey(key));
+
+    auto check = [&](StellarMessage const& msg) {
+        AuthenticatedMessage amsg;
+        regular.setAuthenticatedMessageBody(amsg, msg);
+        auto expected = xdr::xdr_to_msg(amsg);
+        auto actual = preSerialized.authenticateSerializedMessage(
+            msg, xdr::xdr_to_opaque(msg));
+        REQUIRE(actual->raw_size() == expected->raw_size());
+        REQUIRE(std::equal(actual->raw_data(),
+                           actual->raw_data() + actual->raw_size(),
+                           expected->raw_data()));
+    };
+
+    StellarMessage getPeers;
+    getPeers.type(GET_PEERS);
+    StellarMessage error;
+    error.type(ERROR_MSG);
+    error.error().msg = "error";
+    StellarMessage scp;
+    scp.type(SCP_MESSAGE);
+    scp.envelope().statement.slotIndex = 7;
+
+    // Sequence numbers advance in lockstep, and unauthenticated types are
+    // left unsequenced
+    check(getPeers);
+    check(scp);
+    check(error);
+    check(scp);
+}
+
+TEST_CASE("broadcast messages are encoded once", "[overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto simulation =
+        Topologies::core(4, 1, Simulation::OVER_LOOPBACK, networkID);
+    simulation->startAllNodes();
+    simulation->crankUntil(
+        [&]() { return simulation->haveAllExternalized(3, 1); },
+        3 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+    // Every node pushes its SCP messages to 3 peers off a single encoding
+    for (auto const& node : simulation->getNodes())
+    {
+        auto& reused = node->getMetrics().NewMeter(
+            {"overlay", "flood", "encode-reuse"}, "message");
+        REQUIRE(reused.count() > 0);
+    }
+}
+
+#ifdef USE_ZSTD
+TEST_CASE("message compression", "[overlay][compression]")
+{
+    StellarMessage adv;
+    adv.type(FLOOD_ADVERT);
+    for (int i = 0; i < 100; ++i)
+    {
+        adv.floodAdvert().txHashes.push_back(sha256("tx"));
+    }
+    AuthenticatedMessage amsg;
+    amsg.v0().message = adv;
+    auto frame = xdr::xdr_to_msg(amsg);
+
+    SECTION("round trip")
+    {
+        auto compressed = MessageCompression::compress(frame, 3);
+        REQUIRE(compressed);
+        REQUIRE(compressed->size() < frame->size());
+        auto data = reinterpret_cast<uint8_t const*>(compressed->data());
+        REQUIRE(MessageCompression::isCompressed(data, compressed->size()));
+        REQUIRE(!MessageCompression::isCompressed(
+            reinterpret_cast<uint8_t const*>(frame->data()), frame->size()));
+
+        auto body =
+            MessageCompression::decompress(data, compressed->size(), 1 << 20);
+        REQUIRE(body.size() == frame->size());
+        REQUIRE(std::equal(body.begin(), body.end(),
+                           reinterpret_cast<uint8_t const*>(frame->data())));
+
+        // Refuse to inflate past the size limit
+        REQUIRE_THROWS_AS(MessageCompression::decompress(
+                              data, compressed->size(), frame->size() - 1),
+                          xdr::xdr_runtime_error);
+    }
+    SECTION("incompressible")
+    {
+        adv.floodAdvert().txHashes.clear();
+        for (int i = 0; i < 100; ++i)
+        {
+            adv.floodAdvert().txHashes.push_back(
+                sha256(fmt::format("tx{}", i)));
+        }
+        amsg.v0().message = adv;
+        REQUIRE(!MessageCompression::compress(xdr::xdr_to_msg(amsg), 3));
+    }
+    SECTION("negotiated between peers")
+    {
+        VirtualClock clock;
+        auto cfg1 = getTestConfig(0);
+        auto cfg2 = getTestConfig(1);
+        cfg1.OVERLAY_COMPRESSION_LEVEL = 3;
+        bool bothEnabled = false;
+        SECTION("both enabled")
+        {
+            cfg2.OVERLAY_COMPRESSION_LEVEL = 3;
+            bothEnabled = true;
+        }
+        SECTION("one side enabled")
+        {
+        }
+        auto app1 = createTestApplication(clock, cfg1);
+        auto app2 = createTestApplication(clock, cfg2);
+        LoopbackPeerConnection conn(*app1, *app2);
+        testutil::crankFor(clock, std::chrono::seconds(1));
+        REQUIRE(conn.getInitiator()->isAuthenticatedForTesting());
+        REQUIRE(conn.getAcceptor()->isAuthenticatedForTesting());
+        REQUIRE(conn.getInitiator()->isCompressionEnabledForTesting() ==
+                bothEnabled);
+        REQUIRE(conn.getAcceptor()->isCompressionEnabledForTesting() ==
+                bothEnabled);
+
+        auto& compressed = app1->getMetrics().NewMeter(
+            {"overlay", "compression", "compressed-bytes"}, "byte");
+        auto& recvAdvert =
+            app2->getMetrics().NewTimer({"overlay", "recv", "flood-advert"});
+        auto prevRecv = recvAdvert.count();
+        conn.getInitiator()->sendMessage(
+            std::make_shared<StellarMessage const>(adv));
+        testutil::crankFor(clock, std::chrono::seconds(1));
+
+        // The advert is delivered either way, compressed only if both sides
+        // asked for it
+        REQUIRE(recvAdvert.count() == prevRecv + 1);
+        REQUIRE(conn.getAcceptor()->isAuthenticatedForTesting());
+        REQUIRE((compressed.count() > 0) == bothEnabled);
+    }
+}
+#endif
+
+TEST_CASE("per message type timing", "[overlay]")
+{
+    VirtualClock clock;
+    auto cfg1 = getTestConfig(0);
+    auto cfg2 = getTestConfig(1);
+    bool enabled = false;
+    SECTION("enabled")
+    {
+        cfg1.ENABLE_OVERLAY_MESSAGE_TYPE_TIMING = true;
+        cfg2.ENABLE_OVERLAY_MESSAGE_TYPE_TIMING = true;
+        enabled = true;
+    }
+    SECTION("disabled")
+    {
+    }
+    auto app1 = createTestApplication(clock, cfg1);
+    auto app2 = createTestApplication(clock, cfg2);
+    LoopbackPeerConnection conn(*app1, *app2);
+    testutil::crankFor(clock, std::chrono::seconds(1));
+    REQUIRE(conn.getInitiator()->isAuthenticatedForTesting());
+
+    auto hasTimer = [](Application& app, std::string const& name) {
+        auto const& metrics = app.getMetrics().GetAllMetrics();
+        return metrics.find(medida::MetricName("overlay", "cpu", name)) !=
+               metrics.end();
+    };
+    if (enabled)
+    {
+        for (auto phase : {"decode", "verify", "handle", "send"})
+        {
+            auto& timer = app2->getMetrics().NewTimer(
+                {"overlay", "cpu", std::string("auth.") + phase});
+            REQUIRE(timer.count() > 0);
+        }
+        // Types that were never exchanged are registered but empty
+        REQUIRE(app2->getMetrics()
+                    .NewTimer({"overlay", "cpu", "generalized-tx-set.handle"})
+                    .count() == 0);
+    }
+    else
+    {
+        REQUIRE(!hasTimer(*app2, "auth.handle"));
+    }
+}
+
 TEST_CASE("outbound queue filtering", "[overlay][connections]")
 {
     auto networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
@@ -1153,6 +1398,61 @@ TEST_CASE("outbound queue filtering", "[overlay][connections]")
             }
         }
     }
+    SECTION("SCP first, then queues share capacity")
+    {
+        auto& txDepth = node->getMetrics().NewCounter(
+            {"overlay", "outbound-queue", "depth-tx"});
+        auto prevTxDepth = txDepth.count();
+
+        // Transactions large enough that the backlog spans several rounds
+        StellarMessage tx;
+        tx.type(TRANSACTION);
+        tx.transaction().type(ENVELOPE_TYPE_TX);
+        for (int i = 0; i < 50; ++i)
+        {
+            Operation op;
+            op.body.type(MANAGE_DATA);
+            op.body.manageDataOp().dataName = std::string(64, 'a');
+            op.body.manageDataOp().dataValue.activate().resize(64);
+            tx.transaction().v1().tx.operations.push_back(op);
+        }
+        size_t const numTxs = 8;
+        for (size_t i = 0; i < numTxs; ++i)
+        {
+            peer->getFlowControl()->addToQueueAndMaybeTrimForTesting(
+                std::make_shared<StellarMessage const>(tx));
+        }
+        REQUIRE(txQueue.size() == numTxs);
+        REQUIRE(txDepth.count() == prevTxDepth + numTxs);
+
+        Hash hash;
+        size_t const numAdverts = 3;
+        for (size_t i = 0; i < numAdverts; ++i)
+        {
+            StellarMessage adv;
+            adv.type(FLOOD_ADVERT);
+            adv.floodAdvert().txHashes.push_back(hash);
+            peer->getFlowControl()->addToQueueAndMaybeTrimForTesting(
+                std::make_shared<StellarMessage const>(adv));
+        }
+        peer->getFlowControl()->addToQueueAndMaybeTrimForTesting(
+            constructSCPMsg(envs.front()));
+
+        auto batch = peer->getFlowControl()->getNextBatchToSend();
+        REQUIRE(batch.size() == numTxs + numAdverts + 1);
+        REQUIRE(batch.front()->type() == SCP_MESSAGE);
+        REQUIRE(txDepth.count() == prevTxDepth);
+
+        // Adverts don't wait for the whole transaction backlog to drain
+        auto isType = [](MessageType t) {
+            return [t](auto const& m) { return m->type() == t; };
+        };
+        auto firstAdvert =
+            std::find_if(batch.begin(), batch.end(), isType(FLOOD_ADVERT));
+        auto lastTx =
+            std::find_if(batch.rbegin(), batch.rend(), isType(TRANSACTION));
+        REQUIRE(firstAdvert < lastTx.base());
+    }
 }
 
 TEST_CASE("reject non preferred peer", "[overlay][connections]")
@@ -2341,11 +2641,11 @@ TEST_CASE("database is purged at overlay start", "[overlay]")
         return PeerRecord{{}, numFailures, static_cast<int>(PeerType::INBOUND)};
     };
 
-    peerManager.store(localhost(1), record(118), false);
-    peerManager.store(localhost(2), record(119), false);
-    peerManager.store(localhost(3), record(120), false);
-    peerManager.store(localhost(4), record(121), false);
-    peerManager.store(localhost(5), record(122), false);
+    peerManager.store(localhost(1), record(118));
+    peerManager.store(localhost(2), record(119));
+    peerManager.store(localhost(3), record(120));
+    peerManager.store(localhost(4), record(121));
+    peerManager.store(localhost(5), record(122));
 
     om.start();
 
@@ -2393,7 +2693,7 @@ TEST_CASE("peer numfailures resets after good connection",
 
     auto& om = app1->getOverlayManager();
     auto& peerManager = om.getPeerManager();
-    peerManager.store(localhost(cfg2.PEER_PORT), record(119), false);
+    peerManager.store(localhost(cfg2.PEER_PORT), record(119));
     REQUIRE(peerManager.load(localhost(cfg2.PEER_PORT)).second);
 
     simulation->crankForAtLeast(std::chrono::seconds{4}, true);
@@ -2433,7 +2733,7 @@ TEST_CASE("peer is purged from database after few failures",
 
     auto& om = app1->getOverlayManager();
     auto& peerManager = om.getPeerManager();
-    peerManager.store(localhost(cfg2.PEER_PORT), record(119), false);
+    peerManager.store(localhost(cfg2.PEER_PORT), record(119));
     REQUIRE(peerManager.load(localhost(cfg2.PEER_PORT)).second);
 
     simulation->crankForAtLeast(std::chrono::seconds{5}, true);
@@ -2536,6 +2836,47 @@ TEST_CASE("disconnected topology recovery")
     }
 }
 
+TEST_CASE("SCP envelopes are queued by quorum distance", "[overlay][scp]")
+{
+    auto local = SecretKey::pseudoRandomForTesting().getPublicKey();
+    auto validator = SecretKey::pseudoRandomForTesting().getPublicKey();
+    auto transitive = SecretKey::pseudoRandomForTesting().getPublicKey();
+    auto unknown = SecretKey::pseudoRandomForTesting().getPublicKey();
+
+    QuorumTracker::NodeDistances distances;
+    distances[local] = 0;
+    distances[validator] = 1;
+    distances[transitive] = 2;
+
+    auto check = [&](NodeID const& nodeID,
+                     QuorumTracker::NodeDistances const* d,
+                     std::string const& queue, Scheduler::ActionType type) {
+        auto res = Peer::getSCPEnvelopeQueue(nodeID, d);
+        REQUIRE(res.first == queue);
+        REQUIRE(res.second == type);
+    };
+
+    SECTION("with distances")
+    {
+        check(local, &distances, "SCP", Scheduler::ActionType::NORMAL_ACTION);
+        check(validator, &distances, "SCP",
+              Scheduler::ActionType::NORMAL_ACTION);
+        // The rest of the transitive quorum is needed to find quorums, so it
+        // gets a queue of its own but is never shed
+        check(transitive, &distances, "SCP-TRANSITIVE",
+              Scheduler::ActionType::NORMAL_ACTION);
+        check(unknown, &distances, "SCP-OTHER",
+              Scheduler::ActionType::DROPPABLE_ACTION);
+    }
+    SECTION("before distances are known")
+    {
+        for (auto const& nodeID : {local, validator, transitive, unknown})
+        {
+            check(nodeID, nullptr, "SCP", Scheduler::ActionType::NORMAL_ACTION);
+        }
+    }
+}
+
 TEST_CASE("overlay pull mode", "[overlay][pullmode]")
 {
     VirtualClock clock;
@@ -2679,6 +3020,32 @@ TEST_CASE("overlay pull mode", "[overlay][pullmode]")
         }
     }
 
+    SECTION("known tx hashes are resolved once for all peers")
+    {
+        auto root = TestAccount::createRoot(*apps[2]);
+        auto tx = root.tx({txtest::createAccount(
+            txtest::getAccount("acc").getPublicKey(), 100)});
+        REQUIRE(apps[2]->getHerder().recvTransaction(tx, true) ==
+                TransactionQueue::AddResult::ADD_STATUS_PENDING);
+        auto adv =
+            createAdvert(std::vector<std::shared_ptr<StellarMessage const>>{
+                tx->toStellarMessage()});
+        auto& knownSkip = apps[2]->getMetrics().NewMeter(
+            {"overlay", "demand", "known-skip"}, "hash");
+        auto prevSkip = knownSkip.count();
+
+        // Both Node 0 and Node 1 advertise a tx Node 2 already has
+        links[0][2]->sendMessage(adv, false);
+        links[1][2]->sendMessage(adv, false);
+        testutil::crankFor(clock, apps[2]->getConfig().FLOOD_DEMAND_PERIOD_MS +
+                                      epsilon);
+
+        // The first advert is checked against the herder, the second one is
+        // skipped through the shared set of known hashes
+        REQUIRE(getSentDemandCount(apps[2]) == 0);
+        REQUIRE(knownSkip.count() == prevSkip + 1);
+    }
+
     SECTION("sanity check - demand")
     {
         auto tx0 = createTxn(0);
@@ -2974,4 +3341,55 @@ TEST_CASE("overlay pull mode with many peers",
 
     REQUIRE(getSentDemandCount(apps[0]) == maxRetry);
 }
+
+TEST_CASE("pull mode demand tick cost", "[overlay][pullmode][bench][!hide]")
+{
+    auto const numHashes = 500;
+    for (auto numPeers : {10, 50, 100})
+    {
+        VirtualClock clock;
+        std::vector<std::shared_ptr<Application>> apps;
+        for (auto i = 0; i <= numPeers; i++)
+        {
+            Config cfg = getTestConfig(i);
+            cfg.MAX_ADDITIONAL_PEER_CONNECTIONS = numPeers;
+            cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = numHashes;
+            apps.push_back(createTestApplication(clock, cfg));
+        }
+
+        std::vector<std::shared_ptr<LoopbackPeerConnection>> connections;
+        for (auto i = 1; i <= numPeers; i++)
+        {
+            connections.push_back(
+                std::make_shared<LoopbackPeerConnection>(*apps[i], *apps[0]));
+        }
+        testutil::crankFor(clock, std::chrono::seconds(5));
+
+        // Every peer advertises the same hashes to Node 0, which never gets
+        // the transactions
+        StellarMessage adv;
+        adv.type(FLOOD_ADVERT);
+        for (auto i = 0; i < numHashes; i++)
+        {
+            adv.floodAdvert().txHashes.push_back(
+                sha256(fmt::format("tx{}", i)));
+        }
+        auto& tick =
+            apps[0]->getMetrics().NewTimer({"overlay", "demand", "tick"});
+        tick.Clear();
+        for (auto& conn : connections)
+        {
+            if (conn->getInitiator()->isAuthenticatedForTesting())
+            {
+                conn->getInitiator()->sendMessage(
+                    std::make_shared<StellarMessage>(adv));
+            }
+        }
+        testutil::crankFor(clock, std::chrono::seconds(10));
+
+        LOG_INFO(DEFAULT_LOG,
+                 "{} peers: {} demand ticks, mean {:.3f}ms, max {:.3f}ms",
+                 numPeers, tick.count(), tick.mean(), tick.max());
+    }
+}
 }
@@ -53,7 +53,7 @@ TEST_CASE("toXdr", "[overlay][PeerManager]")
 
             auto storedPr = loadedPR.first;
             storedPr.mType = static_cast<int>(peerType);
-            pm.store(address, storedPr, false);
+            pm.store(address, storedPr);
 
             auto actualPR = pm.load(address);
             REQUIRE(actualPR.second);
@@ -277,7 +277,7 @@ TEST_CASE("loadRandomPeers", "[overlay][PeerManager]")
                     PeerRecord{VirtualClock::systemPointToTm(time), numFailures,
                                static_cast<int>(type)};
                 peerRecords[port] = peerRecord;
-                peerManager.store(localhost(port), peerRecord, false);
+                peerManager.store(localhost(port), peerRecord);
                 port++;
             }
         }
@@ -374,7 +374,7 @@ TEST_CASE("getPeersToSend", "[overlay][PeerManager]")
         {
             peerManager.store(
                 localhost(port++),
-                PeerRecord{{}, 11, static_cast<int>(PeerType::INBOUND)}, false);
+                PeerRecord{{}, 11, static_cast<int>(PeerType::INBOUND)});
         }
         for (auto i = 0; i < normalOutboundCount; i++)
         {
@@ -384,8 +384,7 @@ TEST_CASE("getPeersToSend", "[overlay][PeerManager]")
         {
             peerManager.store(
                 localhost(port++),
-                PeerRecord{{}, 11, static_cast<int>(PeerType::OUTBOUND)},
-                false);
+                PeerRecord{{}, 11, static_cast<int>(PeerType::OUTBOUND)});
         }
     };
 
@@ -487,17 +486,17 @@ TEST_CASE("RandomPeerSource::nextAttemptCutoff also limits maxFailures",
 
     auto now = VirtualClock::systemPointToTm(clock.system_now());
     peerManager.store(localhost(1),
-                      {now, 0, static_cast<int>(PeerType::INBOUND)}, false);
+                      {now, 0, static_cast<int>(PeerType::INBOUND)});
     peerManager.store(localhost(2),
-                      {now, 0, static_cast<int>(PeerType::OUTBOUND)}, false);
+                      {now, 0, static_cast<int>(PeerType::OUTBOUND)});
     peerManager.store(localhost(3),
-                      {now, 120, static_cast<int>(PeerType::INBOUND)}, false);
+                      {now, 120, static_cast<int>(PeerType::INBOUND)});
     peerManager.store(localhost(4),
-                      {now, 120, static_cast<int>(PeerType::OUTBOUND)}, false);
+                      {now, 120, static_cast<int>(PeerType::OUTBOUND)});
     peerManager.store(localhost(5),
-                      {now, 121, static_cast<int>(PeerType::INBOUND)}, false);
+                      {now, 121, static_cast<int>(PeerType::INBOUND)});
     peerManager.store(localhost(6),
-                      {now, 121, static_cast<int>(PeerType::OUTBOUND)}, false);
+                      {now, 121, static_cast<int>(PeerType::OUTBOUND)});
 
     auto peers = randomPeerSource.getRandomPeers(
         50, [](PeerBareAddress const&) { return true; });
@@ -517,11 +516,11 @@ TEST_CASE("purge peer table", "[overlay][PeerManager]")
         return PeerRecord{{}, numFailures, static_cast<int>(PeerType::INBOUND)};
     };
 
-    peerManager.store(localhost(1), record(1), false);
-    peerManager.store(localhost(2), record(2), false);
-    peerManager.store(localhost(3), record(3), false);
-    peerManager.store(localhost(4), record(4), false);
-    peerManager.store(localhost(5), record(5), false);
+    peerManager.store(localhost(1), record(1));
+    peerManager.store(localhost(2), record(2));
+    peerManager.store(localhost(3), record(3));
+    peerManager.store(localhost(4), record(4));
+    peerManager.store(localhost(5), record(5));
 
     peerManager.removePeersWithManyFailures(3);
     REQUIRE(peerManager.load(localhost(1)).second);
@@ -537,4 +536,61 @@ TEST_CASE("purge peer table", "[overlay][PeerManager]")
     peerManager.removePeersWithManyFailures(2, &localhost2);
     REQUIRE(!peerManager.load(localhost(2)).second);
 }
+
+TEST_CASE("peer table is written to the database in batches",
+          "[overlay][PeerManager]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.PEER_TABLE_FLUSH_PERIOD_SECONDS = std::chrono::seconds(10);
+    // Not started, so that the overlay doesn't try to connect to the peers
+    auto app = createTestApplication(clock, cfg, true, false);
+    auto& peerManager = app->getOverlayManager().getPeerManager();
+    auto& session = app->getDatabase().getSession();
+    auto countRows = [&]() {
+        int count = 0;
+        session << "SELECT COUNT(*) FROM peers", soci::into(count);
+        return count;
+    };
+    auto numFailuresInDatabase = [&](int port) {
+        int numFailures = -1;
+        session << "SELECT numfailures FROM peers WHERE port = :p",
+            soci::into(numFailures), soci::use(port);
+        return numFailures;
+    };
+    auto record = [](size_t numFailures) {
+        return PeerRecord{{}, numFailures, static_cast<int>(PeerType::INBOUND)};
+    };
+
+    peerManager.store(localhost(1), record(1));
+    peerManager.store(localhost(2), record(2));
+    peerManager.ensureExists(localhost(3));
+
+    // Served from memory before being written
+    REQUIRE(peerManager.load(localhost(1)).second);
+    REQUIRE(peerManager.loadAllPeers().size() == 3);
+    REQUIRE(countRows() == 0);
+
+    testutil::crankFor(clock, std::chrono::seconds(11));
+    REQUIRE(countRows() == 3);
+    REQUIRE(numFailuresInDatabase(1) == 1);
+
+    // Updates of known peers are batched too
+    peerManager.store(localhost(1), record(5));
+    REQUIRE(numFailuresInDatabase(1) == 1);
+    peerManager.flush();
+    REQUIRE(numFailuresInDatabase(1) == 5);
+
+    // Removals are written right away
+    peerManager.removePeersWithManyFailures(2);
+    REQUIRE(countRows() == 1);
+    REQUIRE(!peerManager.load(localhost(1)).second);
+    REQUIRE(peerManager.load(localhost(3)).second);
+
+    // Changes are written on shutdown
+    peerManager.store(localhost(4), record(0));
+    REQUIRE(countRows() == 1);
+    app->getOverlayManager().shutdown();
+    REQUIRE(countRows() == 2);
+}
 }
@@ -895,4 +895,33 @@ TEST_CASE("Time sliced dynamic topology survey", "[overlay][survey][topology]")
     // All surveys should now be inactive
     checkSurveyState(/*expectedNonce*/ std::nullopt, /*isReporting*/ false,
                      {A, B, C, D, E, F});
-}
\ No newline at end of file
+}
+
+TEST_CASE("survey histograms", "[overlay][survey]")
+{
+    SurveyHistogram h;
+    REQUIRE(h.getJson().size() == 0);
+
+    h.update(0);
+    h.update(1);
+    h.update(3);
+    h.update(3);
+    h.update(1000);
+    h.update(std::numeric_limits<uint64_t>::max());
+    REQUIRE(h.mCounts[0] == 1);
+    REQUIRE(h.mCounts[1] == 1);
+    REQUIRE(h.mCounts[2] == 2);
+    // [512, 1024)
+    REQUIRE(h.mCounts[10] == 1);
+    REQUIRE(h.mCounts[SurveyHistogram::NUM_BUCKETS - 1] == 1);
+
+    SurveyHistogram other;
+    other.update(3);
+    h.merge(other);
+    REQUIRE(h.mCounts[2] == 3);
+
+    auto json = h.getJson();
+    REQUIRE(json.size() == SurveyHistogram::NUM_BUCKETS);
+    REQUIRE(json[2].asUInt() == 3);
+    REQUIRE(other.getJson().size() == 3);
+}
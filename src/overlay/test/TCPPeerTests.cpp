@@ -2,14 +2,20 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/BLAKE2.h"
+#include "herder/Herder.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/histogram.h"
+#include "medida/timer.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/PeerBareAddress.h"
 #include "overlay/PeerDoor.h"
 #include "overlay/TCPPeer.h"
 #include "simulation/Simulation.h"
+#include "test/TestAccount.h"
+#include "test/TxTests.h"
 #include "test/test.h"
 #include "util/Logging.h"
 #include "util/Timer.h"
@@ -157,6 +163,181 @@ TEST_CASE("TCPPeer can communicate", "[overlay]")
     s->stopAllNodes();
 }
 
+TEST_CASE("TCPPeer batches background reads", "[overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    Simulation::pointer s = std::make_shared<Simulation>(
+        Simulation::OVER_TCP, networkID, [](int i) {
+            Config cfg = getTestConfig(i);
+            cfg.EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING = true;
+            return cfg;
+        });
+
+    auto v10SecretKey = SecretKey::fromSeed(sha256("v10"));
+    auto v11SecretKey = SecretKey::fromSeed(sha256("v11"));
+
+    SCPQuorumSet n0_qset;
+    n0_qset.threshold = 1;
+    n0_qset.validators.push_back(v10SecretKey.getPublicKey());
+    auto n0 = s->addNode(v10SecretKey, n0_qset);
+    auto n1 = s->addNode(v11SecretKey, n0_qset);
+    s->addPendingConnection(v10SecretKey.getPublicKey(),
+                            v11SecretKey.getPublicKey());
+    s->startAllNodes();
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    auto p0 = n0->getOverlayManager().getConnectedPeer(
+        PeerBareAddress{"127.0.0.1", n1->getConfig().PEER_PORT});
+    REQUIRE(p0);
+    REQUIRE(p0->isAuthenticatedForTesting());
+    s->stopOverlayTick();
+
+    auto& metrics = n1->getOverlayManager().getOverlayMetrics();
+    auto prevPeers = metrics.mRecvGetPeersTimer.count();
+    auto prevBatches = metrics.mRecvBatchSize.count();
+
+    // Write a burst of messages at once so that the receiver finds several
+    // of them in its socket buffer
+    int const numMessages = 20;
+    n0->postOnOverlayThread(
+        [p0, numMessages]() {
+            auto msg = std::make_shared<StellarMessage>();
+            msg->type(GET_PEERS);
+            for (int i = 0; i < numMessages; ++i)
+            {
+                p0->sendAuthenticatedMessageForTesting(msg);
+            }
+        },
+        "send");
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    // Every message is delivered exactly once, in no more posts than messages
+    REQUIRE(metrics.mRecvGetPeersTimer.count() == prevPeers + numMessages);
+    auto batches = metrics.mRecvBatchSize.count() - prevBatches;
+    REQUIRE(batches > 0);
+    REQUIRE(batches <= numMessages);
+    s->stopAllNodes();
+}
+
+TEST_CASE("TCPPeer prepares transactions in the background", "[overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    Simulation::pointer s = std::make_shared<Simulation>(
+        Simulation::OVER_TCP, networkID, [](int i) {
+            Config cfg = getTestConfig(i);
+            cfg.EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING = true;
+            return cfg;
+        });
+
+    auto v10SecretKey = SecretKey::fromSeed(sha256("v10"));
+    auto v11SecretKey = SecretKey::fromSeed(sha256("v11"));
+
+    SCPQuorumSet n0_qset;
+    n0_qset.threshold = 1;
+    n0_qset.validators.push_back(v10SecretKey.getPublicKey());
+    auto n0 = s->addNode(v10SecretKey, n0_qset);
+    auto n1 = s->addNode(v11SecretKey, n0_qset);
+    s->addPendingConnection(v10SecretKey.getPublicKey(),
+                            v11SecretKey.getPublicKey());
+    s->startAllNodes();
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    auto p0 = n0->getOverlayManager().getConnectedPeer(
+        PeerBareAddress{"127.0.0.1", n1->getConfig().PEER_PORT});
+    REQUIRE(p0);
+    REQUIRE(p0->isAuthenticatedForTesting());
+
+    auto root = TestAccount::createRoot(*n0);
+    auto tx = root.tx(
+        {txtest::createAccount(txtest::getAccount("acc").getPublicKey(), 100)});
+    auto msg = tx->toStellarMessage();
+    n0->postOnOverlayThread(
+        [p0, msg]() { p0->sendAuthenticatedMessageForTesting(msg); }, "send");
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    // The transaction built on the overlay thread made it to the queue, and
+    // the Floodgate credits the sender under the hash computed there
+    REQUIRE(n1->getHerder().getTx(tx->getFullHash()));
+    auto knows = n1->getOverlayManager().getPeersKnows(xdrBlake2(*msg));
+    REQUIRE(knows.size() == 1);
+    REQUIRE((*knows.begin())->getPeerID() == v10SecretKey.getPublicKey());
+    s->stopAllNodes();
+}
+
+TEST_CASE("TCPPeer delays flood traffic to batch writes", "[overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    Simulation::pointer s = std::make_shared<Simulation>(
+        Simulation::OVER_TCP, networkID, [](int i) {
+            Config cfg = getTestConfig(i);
+            cfg.EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING = true;
+            cfg.MAX_BATCH_WRITE_DELAY_MS = std::chrono::milliseconds(50);
+            return cfg;
+        });
+
+    auto v10SecretKey = SecretKey::fromSeed(sha256("v10"));
+    auto v11SecretKey = SecretKey::fromSeed(sha256("v11"));
+
+    SCPQuorumSet n0_qset;
+    n0_qset.threshold = 1;
+    n0_qset.validators.push_back(v10SecretKey.getPublicKey());
+    auto n0 = s->addNode(v10SecretKey, n0_qset);
+    auto n1 = s->addNode(v11SecretKey, n0_qset);
+    s->addPendingConnection(v10SecretKey.getPublicKey(),
+                            v11SecretKey.getPublicKey());
+    s->startAllNodes();
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    auto p0 = n0->getOverlayManager().getConnectedPeer(
+        PeerBareAddress{"127.0.0.1", n1->getConfig().PEER_PORT});
+    REQUIRE(p0);
+    REQUIRE(p0->isAuthenticatedForTesting());
+    s->stopOverlayTick();
+
+    auto& batchMessages =
+        n0->getOverlayManager().getOverlayMetrics().mWriteBatchMessages;
+    int const numMessages = 10;
+
+    SECTION("delayed messages share a write")
+    {
+        n0->postOnOverlayThread(
+            [p0, numMessages]() {
+                auto msg = std::make_shared<StellarMessage>();
+                msg->type(FLOOD_DEMAND);
+                for (int i = 0; i < numMessages; ++i)
+                {
+                    p0->sendAuthenticatedMessageForTesting(msg);
+                }
+            },
+            "send");
+        s->crankForAtLeast(std::chrono::seconds(1), false);
+        REQUIRE(batchMessages.max() >= numMessages);
+    }
+    SECTION("other traffic flushes delayed messages")
+    {
+        auto& recvGetPeers =
+            n1->getOverlayManager().getOverlayMetrics().mRecvGetPeersTimer;
+        auto prevPeers = recvGetPeers.count();
+        n0->postOnOverlayThread(
+            [p0, numMessages]() {
+                auto demand = std::make_shared<StellarMessage>();
+                demand->type(FLOOD_DEMAND);
+                for (int i = 0; i < numMessages - 1; ++i)
+                {
+                    p0->sendAuthenticatedMessageForTesting(demand);
+                }
+                auto getPeers = std::make_shared<StellarMessage>();
+                getPeers->type(GET_PEERS);
+                p0->sendAuthenticatedMessageForTesting(getPeers);
+            },
+            "send");
+        s->crankForAtLeast(std::chrono::seconds(1), false);
+        REQUIRE(recvGetPeers.count() == prevPeers + 1);
+        REQUIRE(batchMessages.max() >= numMessages);
+    }
+    s->stopAllNodes();
+}
+
 std::shared_ptr<StellarMessage>
 makeStellarMessage(uint32_t wasmSize)
 {
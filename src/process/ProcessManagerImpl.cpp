@@ -18,8 +18,12 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Timer.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
+#include <medida/counter.h>
+#include <medida/histogram.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
 
 #include <algorithm>
 #include <functional>
@@ -224,6 +228,10 @@ ProcessManagerImpl::~ProcessManagerImpl()
 #ifndef _WIN32
     auto ec = ABORT_ERROR_CODE;
     mSigChild.cancel(ec);
+    if (mSpawnerExits)
+    {
+        mSpawnerExits->close(ec);
+    }
 #endif
 
     // Then trigger shutdown, if we haven't yet (it's idempotent). This will ask
@@ -273,6 +281,7 @@ ProcessManagerImpl::shutdown()
             pending->mImpl->cancel(ABORT_ERROR_CODE);
         }
         mPending.clear();
+        mPendingCount.set_count(0);
 
         tryProcessShutdownAll();
     }
@@ -321,6 +330,7 @@ ProcessManagerImpl::tryProcessShutdown(std::shared_ptr<ProcessExitEvent> pe)
             CLOG_DEBUG(Process, "Cancelling pending: {}", impl->mCmdLine);
             impl->cancel(ABORT_ERROR_CODE);
             mPending.erase(pendingIt);
+            mPendingCount.set_count(mPending.size());
         }
         break;
     }
@@ -411,7 +421,15 @@ ProcessManagerImpl::ProcessManagerImpl(Application& app)
     , mSigChild(mIOContext)
     , mTmpDir(
           std::make_unique<TmpDir>(app.getTmpDirManager().tmpDir("process")))
+    , mSpawnLatency(app.getMetrics().NewTimer({"process", "spawn", "latency"}))
+    , mPendingCount(app.getMetrics().NewCounter({"process", "spawn", "queue"}))
+    , mExitBatch(app.getMetrics().NewHistogram({"process", "exit", "batch"}))
 {
+    if (app.getConfig().USE_PROCESS_SPAWNER)
+    {
+        CLOG_WARNING(Process,
+                     "USE_PROCESS_SPAWNER is not supported on Windows");
+    }
 }
 
 void
@@ -667,9 +685,32 @@ ProcessManagerImpl::ProcessManagerImpl(Application& app)
     , mSigChild(mIOContext, SIGCHLD)
     , mTmpDir(
           std::make_unique<TmpDir>(app.getTmpDirManager().tmpDir("process")))
+    , mSpawnLatency(app.getMetrics().NewTimer({"process", "spawn", "latency"}))
+    , mPendingCount(app.getMetrics().NewCounter({"process", "spawn", "queue"}))
+    , mExitBatch(app.getMetrics().NewHistogram({"process", "exit", "batch"}))
 {
     std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
     startWaitingForSignalChild();
+
+    if (app.getConfig().USE_PROCESS_SPAWNER)
+    {
+        try
+        {
+            mSpawner = std::make_unique<ProcessSpawner>();
+            mSpawnerExits = std::make_unique<asio::posix::stream_descriptor>(
+                mIOContext, ::dup(mSpawner->getExitFd()));
+            startWaitingForSpawnerExits();
+        }
+        catch (std::exception& e)
+        {
+            CLOG_ERROR(Process,
+                       "Could not start process spawner, starting processes "
+                       "directly: {}",
+                       e.what());
+            mSpawnerExits.reset();
+            mSpawner.reset();
+        }
+    }
 }
 
 void
@@ -691,21 +732,74 @@ ProcessManagerImpl::handleSignalChild()
     reapChildren();
 }
 
+void
+ProcessManagerImpl::startWaitingForSpawnerExits()
+{
+    mSpawnerExits->async_wait(
+        asio::posix::stream_descriptor::wait_read,
+        [this](asio::error_code const& ec) {
+            if (ec || isShutdown() || !mSpawner)
+            {
+                return;
+            }
+            reapChildren();
+            if (mSpawner)
+            {
+                startWaitingForSpawnerExits();
+            }
+        });
+}
+
+void
+ProcessManagerImpl::stopSpawner()
+{
+    std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
+    asio::error_code ec;
+    mSpawnerExits->close(ec);
+    mSpawnerExits.reset();
+    mSpawner.reset();
+
+    // Nothing reports the exits of what the helper started anymore, so fail
+    // those processes now and leave them to finish on their own
+    for (auto const& pair : mProcesses)
+    {
+        pair.second->mImpl->mLifecycle = ProcessLifecycle::TERMINATED;
+        pair.second->mImpl->cancel(
+            std::make_error_code(std::errc::io_error));
+    }
+    mProcesses.clear();
+}
+
 void
 ProcessManagerImpl::reapChildren()
 {
     // Store tuples (pid, status)
     std::vector<std::tuple<int, int>> signaledChildren;
     std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
-    for (auto const& pair : mProcesses)
+    bool spawnerAlive = true;
+    if (mSpawner)
     {
-        const int pid = pair.first;
-        int status = 0;
-        // If we find the child for which we received this SIGCHLD signal,
-        // store the pid and status
-        if (waitpid(pid, &status, WNOHANG) > 0)
+        // The processes are the helper's children: it reaps them and tells us
+        std::vector<ProcessSpawner::Exit> exits;
+        spawnerAlive = mSpawner->pollExits(exits);
+        for (auto const& exit : exits)
         {
-            signaledChildren.push_back(std::make_tuple(pid, status));
+            signaledChildren.push_back(
+                std::make_tuple(exit.mPid, exit.mStatus));
+        }
+    }
+    else
+    {
+        for (auto const& pair : mProcesses)
+        {
+            const int pid = pair.first;
+            int status = 0;
+            // If we find the child for which we received this SIGCHLD signal,
+            // store the pid and status
+            if (waitpid(pid, &status, WNOHANG) > 0)
+            {
+                signaledChildren.push_back(std::make_tuple(pid, status));
+            }
         }
     }
 
@@ -713,6 +807,7 @@ ProcessManagerImpl::reapChildren()
     {
         CLOG_DEBUG(Process, "found {} child processes that terminated",
                    signaledChildren.size());
+        mExitBatch.Update(signaledChildren.size());
         // Now go all over all (pid, status) and handle them
         for (auto const& pidStatus : signaledChildren)
         {
@@ -721,6 +816,14 @@ ProcessManagerImpl::reapChildren()
             handleProcessTermination(pid, status);
         }
     }
+
+    if (!spawnerAlive && mSpawner)
+    {
+        CLOG_ERROR(Process, "Process spawner exited, starting processes "
+                            "directly from now on");
+        stopSpawner();
+        maybeRunPendingProcesses();
+    }
 }
 
 bool
@@ -834,6 +937,73 @@ ProcessExitEvent::Impl::run()
     mLifecycle = ProcessLifecycle::RUNNING;
 }
 
+void
+ProcessManagerImpl::runPendingProcessesWithSpawner()
+{
+    ZoneScoped;
+    std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
+    std::vector<std::shared_ptr<ProcessExitEvent>> batch;
+    std::vector<ProcessSpawner::Command> commands;
+    while (!mPending.empty() &&
+           getNumRunningOrShuttingDownProcesses() + batch.size() <
+               mMaxProcesses)
+    {
+        auto i = mPending.front();
+        mPending.pop_front();
+        auto const& impl = i->mImpl;
+        CLOG_DEBUG(Process, "Running: {}", impl->mCmdLine);
+        if (!impl->mOutFile.empty() && fs::exists(impl->mOutFile))
+        {
+            impl->cancel(std::make_error_code(std::errc::io_error));
+            CLOG_ERROR(Process,
+                       "Error starting process: output file {} already exists",
+                       impl->mOutFile);
+            CLOG_ERROR(Process, "When running: {}", impl->mCmdLine);
+            continue;
+        }
+        batch.emplace_back(i);
+        commands.emplace_back(ProcessSpawner::Command{
+            split(impl->mCmdLine),
+            impl->mOutFile.empty() ? std::string() : impl->mTempFile});
+    }
+    if (batch.empty())
+    {
+        return;
+    }
+
+    std::vector<int> pids;
+    try
+    {
+        auto timer = mSpawnLatency.TimeScope();
+        pids = mSpawner->spawn(commands);
+    }
+    catch (std::runtime_error& e)
+    {
+        // Hand the batch back to be started directly
+        CLOG_ERROR(Process, "Process spawner failed: {}", e.what());
+        stopSpawner();
+        mPending.insert(mPending.begin(), batch.begin(), batch.end());
+        return;
+    }
+
+    for (size_t k = 0; k < batch.size(); ++k)
+    {
+        auto const& impl = batch[k]->mImpl;
+        int pid = pids[k];
+        if (pid <= 0 || mProcesses.find(pid) != mProcesses.end())
+        {
+            impl->cancel(std::make_error_code(std::errc::io_error));
+            CLOG_ERROR(Process, "Error starting process: {}",
+                       pid <= 0 ? strerror(-pid) : "pid already exists");
+            CLOG_ERROR(Process, "When running: {}", impl->mCmdLine);
+            continue;
+        }
+        impl->mProcessId = pid;
+        impl->mLifecycle = ProcessLifecycle::RUNNING;
+        mProcesses[pid] = batch[k];
+    }
+}
+
 #endif
 
 std::weak_ptr<ProcessExitEvent>
@@ -868,6 +1038,12 @@ ProcessManagerImpl::maybeRunPendingProcesses()
         return;
     }
     std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
+#ifndef _WIN32
+    if (mSpawner)
+    {
+        runPendingProcessesWithSpawner();
+    }
+#endif
     while (!mPending.empty() &&
            getNumRunningOrShuttingDownProcesses() < mMaxProcesses)
     {
@@ -884,7 +1060,10 @@ ProcessManagerImpl::maybeRunPendingProcesses()
                                 i->mImpl->mOutFile));
             }
 
-            i->mImpl->run();
+            {
+                auto timer = mSpawnLatency.TimeScope();
+                i->mImpl->run();
+            }
             auto pid = i->mImpl->getProcessId();
             if (mProcesses.find(pid) != mProcesses.end())
             {
@@ -900,6 +1079,7 @@ ProcessManagerImpl::maybeRunPendingProcesses()
             CLOG_ERROR(Process, "When running: {}", i->mImpl->mCmdLine);
         }
     }
+    mPendingCount.set_count(mPending.size());
 }
 
 void
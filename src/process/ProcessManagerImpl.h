@@ -5,12 +5,20 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "process/ProcessManager.h"
+#include "process/ProcessSpawner.h"
 #include "util/TmpDir.h"
 #include <atomic>
 #include <deque>
 #include <mutex>
 #include <vector>
 
+namespace medida
+{
+class Counter;
+class Histogram;
+class Timer;
+}
+
 namespace stellar
 {
 
@@ -34,6 +42,21 @@ class ProcessManagerImpl : public ProcessManager
     uint64_t mTempFileCount{0};
 
     std::deque<std::shared_ptr<ProcessExitEvent>> mPending;
+
+    medida::Timer& mSpawnLatency;
+    medida::Counter& mPendingCount;
+    medida::Histogram& mExitBatch;
+
+#ifndef _WIN32
+    // Set with USE_PROCESS_SPAWNER; processes are then started by, and their
+    // exits reported from, this helper rather than this process.
+    std::unique_ptr<ProcessSpawner> mSpawner;
+    std::unique_ptr<asio::posix::stream_descriptor> mSpawnerExits;
+    void startWaitingForSpawnerExits();
+    void runPendingProcessesWithSpawner();
+    void stopSpawner();
+#endif
+
     void maybeRunPendingProcesses();
     void checkInvariants();
 
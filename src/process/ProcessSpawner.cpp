@@ -0,0 +1,401 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifndef _WIN32
+
+#include "process/ProcessSpawner.h"
+#include "util/GlobalChecks.h"
+#include <fmt/format.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__APPLE__) || defined(__FreeBSD__)
+extern char** environ;
+#endif
+
+namespace stellar
+{
+
+namespace
+{
+#ifdef MSG_NOSIGNAL
+int const SEND_FLAGS = MSG_NOSIGNAL;
+#else
+int const SEND_FLAGS = 0;
+#endif
+
+// A command is sent as its payload size and argument count, followed by the
+// payload: the output file, then each argument, all NUL-terminated. The helper
+// answers with the pid or negative errno. Exits are reported as (pid, status)
+// pairs.
+size_t const MAX_COMMAND_SIZE = 1 << 20;
+size_t const EXIT_RECORD_SIZE = 2 * sizeof(int32_t);
+
+bool
+readFully(int fd, void* buf, size_t n)
+{
+    auto p = static_cast<char*>(buf);
+    while (n > 0)
+    {
+        auto r = ::read(fd, p, n);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r <= 0)
+        {
+            return false;
+        }
+        p += r;
+        n -= static_cast<size_t>(r);
+    }
+    return true;
+}
+
+bool
+writeFully(int fd, void const* buf, size_t n)
+{
+    auto p = static_cast<char const*>(buf);
+    while (n > 0)
+    {
+        auto r = ::send(fd, p, n, SEND_FLAGS);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r <= 0)
+        {
+            return false;
+        }
+        p += r;
+        n -= static_cast<size_t>(r);
+    }
+    return true;
+}
+
+void
+setCloseOnExec(int fd)
+{
+    int flags = fcntl(fd, F_GETFD);
+    if (flags != -1)
+    {
+        fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+    }
+}
+
+// Everything below runs in the helper. It was forked from a multithreaded
+// process, so it sticks to system calls and the allocator, and never logs or
+// returns to the caller of fork().
+
+int gWakeFd = -1;
+
+void
+onChildExit(int)
+{
+    int saved = errno;
+    char c = 0;
+    [[maybe_unused]] auto r = ::write(gWakeFd, &c, 1);
+    errno = saved;
+}
+
+// Same heuristic as ProcessExitEvent::Impl::run: stop after a long enough run
+// of unused descriptors
+void
+closeInheritedFds(int keep1, int keep2)
+{
+    int const maxFds = static_cast<int>(sysconf(_SC_OPEN_MAX));
+    int const maxGAP = 512;
+    for (int fd = 3, lastFd = 3; (fd < maxFds) && ((fd - lastFd) < maxGAP);
+         ++fd)
+    {
+        if (fd == keep1 || fd == keep2 || ::close(fd) == 0)
+        {
+            lastFd = fd;
+        }
+    }
+}
+
+int32_t
+spawnCommand(std::vector<char*>& strings, posix_spawnattr_t const* attr)
+{
+    char const* outFile = strings[0];
+    std::vector<char*> argv(strings.begin() + 1, strings.end());
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    if (int err = posix_spawn_file_actions_init(&actions))
+    {
+        return -err;
+    }
+    int err = 0;
+    if (*outFile)
+    {
+        err = posix_spawn_file_actions_addopen(&actions, 1, outFile,
+                                               O_RDWR | O_CREAT, 0600);
+    }
+    pid_t pid = -1;
+    if (!err)
+    {
+        err = posix_spawnp(&pid, argv[0], &actions, attr, argv.data(),
+                           environ);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return err ? -err : static_cast<int32_t>(pid);
+}
+
+// Returns false once the main process has closed its end, or sent garbage
+bool
+serveCommand(int fd, posix_spawnattr_t const* attr)
+{
+    uint32_t header[2];
+    if (!readFully(fd, header, sizeof(header)) || header[0] == 0 ||
+        header[0] > MAX_COMMAND_SIZE)
+    {
+        return false;
+    }
+    std::vector<char> payload(header[0]);
+    if (!readFully(fd, payload.data(), payload.size()) ||
+        payload.back() != '\0')
+    {
+        return false;
+    }
+
+    std::vector<char*> strings;
+    for (size_t i = 0; i < payload.size(); i += strlen(&payload[i]) + 1)
+    {
+        strings.push_back(&payload[i]);
+    }
+    if (header[1] == 0 || strings.size() != header[1] + 1)
+    {
+        return false;
+    }
+
+    int32_t result = spawnCommand(strings, attr);
+    return writeFully(fd, &result, sizeof(result));
+}
+
+[[noreturn]] void
+runHelper(int commandFd, int exitFd)
+{
+    closeInheritedFds(commandFd, exitFd);
+
+    // SIGCHLD wakes up the poll below through this pipe
+    int wake[2];
+    if (::pipe(wake) != 0)
+    {
+        _exit(1);
+    }
+    for (int fd : wake)
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        setCloseOnExec(fd);
+    }
+    gWakeFd = wake[1];
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onChildExit;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &sa, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    sigset_t none;
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, nullptr);
+
+    // Children get the default handling of the signals changed above
+    posix_spawnattr_t attr;
+    if (posix_spawnattr_init(&attr) != 0)
+    {
+        _exit(1);
+    }
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGCHLD);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setflags(&attr,
+                             POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+    std::vector<int32_t> exits;
+    for (;;)
+    {
+        struct pollfd fds[2] = {{commandFd, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0 && errno != EINTR)
+        {
+            _exit(1);
+        }
+        if (fds[1].revents)
+        {
+            char buf[64];
+            while (::read(wake[0], buf, sizeof(buf)) > 0)
+            {
+            }
+        }
+        if (fds[0].revents && !serveCommand(commandFd, &attr))
+        {
+            _exit(0);
+        }
+
+        // Report every exit since the last wake-up at once
+        exits.clear();
+        int status = 0;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            exits.push_back(static_cast<int32_t>(pid));
+            exits.push_back(static_cast<int32_t>(status));
+        }
+        if (!exits.empty() &&
+            !writeFully(exitFd, exits.data(), exits.size() * sizeof(int32_t)))
+        {
+            _exit(0);
+        }
+    }
+}
+}
+
+ProcessSpawner::ProcessSpawner()
+{
+    int commandFds[2];
+    int exitFds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, commandFds) != 0)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("socketpair() failed: {}"),
+                        strerror(errno)));
+    }
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, exitFds) != 0)
+    {
+        int err = errno;
+        ::close(commandFds[0]);
+        ::close(commandFds[1]);
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("socketpair() failed: {}"), strerror(err)));
+    }
+    for (int fd : {commandFds[0], commandFds[1], exitFds[0], exitFds[1]})
+    {
+        setCloseOnExec(fd);
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        int err = errno;
+        for (int fd : {commandFds[0], commandFds[1], exitFds[0], exitFds[1]})
+        {
+            ::close(fd);
+        }
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("fork() failed: {}"), strerror(err)));
+    }
+    if (pid == 0)
+    {
+        runHelper(commandFds[1], exitFds[1]);
+    }
+
+    ::close(commandFds[1]);
+    ::close(exitFds[1]);
+    mHelperPid = pid;
+    mCommandFd = commandFds[0];
+    mExitFd = exitFds[0];
+    fcntl(mExitFd, F_SETFL, fcntl(mExitFd, F_GETFL) | O_NONBLOCK);
+}
+
+ProcessSpawner::~ProcessSpawner()
+{
+    // The helper exits as soon as it sees its command socket close
+    ::close(mCommandFd);
+    ::close(mExitFd);
+    while (waitpid(mHelperPid, nullptr, 0) < 0 && errno == EINTR)
+    {
+    }
+}
+
+std::vector<int>
+ProcessSpawner::spawn(std::vector<Command> const& commands)
+{
+    std::string request;
+    for (auto const& command : commands)
+    {
+        releaseAssert(!command.mArgs.empty());
+        std::string payload = command.mOutFile;
+        payload.push_back('\0');
+        for (auto const& arg : command.mArgs)
+        {
+            payload += arg;
+            payload.push_back('\0');
+        }
+        if (payload.size() > MAX_COMMAND_SIZE)
+        {
+            throw std::runtime_error("command too long for process spawner");
+        }
+        uint32_t header[2] = {static_cast<uint32_t>(payload.size()),
+                              static_cast<uint32_t>(command.mArgs.size())};
+        request.append(reinterpret_cast<char const*>(header), sizeof(header));
+        request += payload;
+    }
+
+    std::vector<int32_t> results(commands.size());
+    if (!writeFully(mCommandFd, request.data(), request.size()) ||
+        !readFully(mCommandFd, results.data(),
+                   results.size() * sizeof(int32_t)))
+    {
+        throw std::runtime_error("process spawner is gone");
+    }
+    return std::vector<int>(results.begin(), results.end());
+}
+
+bool
+ProcessSpawner::pollExits(std::vector<Exit>& exits)
+{
+    bool alive = true;
+    char buf[4096];
+    for (;;)
+    {
+        auto r = ::read(mExitFd, buf, sizeof(buf));
+        if (r > 0)
+        {
+            mExitBuffer.insert(mExitBuffer.end(), buf, buf + r);
+            continue;
+        }
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        alive = r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        break;
+    }
+
+    size_t n = mExitBuffer.size() / EXIT_RECORD_SIZE;
+    for (size_t i = 0; i < n; ++i)
+    {
+        int32_t record[2];
+        memcpy(record, mExitBuffer.data() + i * EXIT_RECORD_SIZE,
+               EXIT_RECORD_SIZE);
+        exits.emplace_back(Exit{record[0], record[1]});
+    }
+    mExitBuffer.erase(mExitBuffer.begin(),
+                      mExitBuffer.begin() + n * EXIT_RECORD_SIZE);
+    return alive;
+}
+}
+
+#endif
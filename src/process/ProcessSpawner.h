@@ -0,0 +1,79 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifndef _WIN32
+
+#include "util/NonCopyable.h"
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+// A long-lived helper process that starts subprocesses on behalf of
+// ProcessManagerImpl when USE_PROCESS_SPAWNER is set.
+//
+// The helper is forked once, when the spawner is created. Commands are sent to
+// it over a socket in batches, and it answers each one with the pid of the
+// process it started. It also reaps its children itself and reports their
+// exit statuses on a second socket, several at a time, so the main process
+// neither spawns nor runs a waitpid sweep for each of them.
+//
+// The helper exits when the spawner is destroyed, leaving any processes it
+// started still running.
+class ProcessSpawner : public NonMovableOrCopyable
+{
+  public:
+    struct Command
+    {
+        std::vector<std::string> mArgs;
+        // If not empty, the process' stdout is redirected to this file
+        std::string mOutFile;
+    };
+
+    struct Exit
+    {
+        int mPid;
+        // As reported by waitpid
+        int mStatus;
+    };
+
+    // Throws if the helper could not be started
+    ProcessSpawner();
+    ~ProcessSpawner();
+
+    // Starts `commands` with a single round trip to the helper. Returns, for
+    // each command, the pid of the process that runs it, or a negative errno
+    // if it could not be started. Throws if the helper is gone.
+    std::vector<int> spawn(std::vector<Command> const& commands);
+
+    // Appends the exits the helper has reported so far, without blocking.
+    // Returns false once the helper is gone.
+    bool pollExits(std::vector<Exit>& exits);
+
+    // Becomes readable when `pollExits` has something to report
+    int
+    getExitFd() const
+    {
+        return mExitFd;
+    }
+
+    int
+    getHelperPid() const
+    {
+        return mHelperPid;
+    }
+
+  private:
+    int mHelperPid{-1};
+    int mCommandFd{-1};
+    int mExitFd{-1};
+    // Bytes of a partially received exit report
+    std::vector<char> mExitBuffer;
+};
+}
+
+#endif
@@ -14,9 +14,11 @@
 #include "util/Timer.h"
 #include "util/TmpDir.h"
 #include "xdrpp/autocheck.h"
+#include <algorithm>
 #include <chrono>
 #include <fmt/format.h>
 #include <future>
+#include <optional>
 #include <thread>
 
 using namespace stellar;
@@ -137,10 +139,10 @@ TEST_CASE("subprocess redirect to existing file", "[process]")
     CHECK(s == data);
 }
 
-TEST_CASE("subprocess storm", "[process]")
+static void
+runProcessStorm(Config const& cfg)
 {
     VirtualClock clock;
-    Config const& cfg = getTestConfig();
     Application::pointer appPtr = createTestApplication(clock, cfg);
     Application& app = *appPtr;
     TmpDir tmpDir = app.getTmpDirManager().tmpDir("process-storm");
@@ -199,6 +201,56 @@ TEST_CASE("subprocess storm", "[process]")
     }
 }
 
+TEST_CASE("subprocess storm", "[process]")
+{
+    runProcessStorm(getTestConfig());
+}
+
+TEST_CASE("subprocess via process spawner", "[process]")
+{
+    Config cfg = getTestConfig();
+    cfg.USE_PROCESS_SPAWNER = true;
+
+    SECTION("exit status")
+    {
+        VirtualClock clock;
+        Application::pointer app = createTestApplication(clock, cfg);
+        std::vector<std::string> const commands = {
+            "hostname", "hostname -xsomeinvalid", "no-such-command-exists"};
+        std::vector<std::optional<asio::error_code>> results(commands.size());
+        for (size_t i = 0; i < commands.size(); ++i)
+        {
+            auto evt =
+                app->getProcessManager().runProcess(commands[i], "").lock();
+            if (!evt)
+            {
+                // Failed to start
+                results[i] = std::make_error_code(std::errc::io_error);
+                continue;
+            }
+            evt->async_wait(
+                [&results, i](asio::error_code ec) { results[i] = ec; });
+        }
+
+        auto done = [&]() {
+            return std::all_of(results.begin(), results.end(),
+                               [](auto const& r) { return r.has_value(); });
+        };
+        while (!done() && !clock.getIOContext().stopped())
+        {
+            clock.crank(true);
+        }
+        REQUIRE(!*results[0]);
+        REQUIRE(*results[1]);
+        REQUIRE(*results[2]);
+        REQUIRE(app->getProcessManager().getNumRunningProcesses() == 0);
+    }
+    SECTION("storm")
+    {
+        runProcessStorm(cfg);
+    }
+}
+
 TEST_CASE("shutdown while process running", "[process]")
 {
     VirtualClock clock1;
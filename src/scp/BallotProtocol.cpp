@@ -11,9 +11,9 @@
 #include "scp/QuorumSetUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <functional>
 #include <numeric>
 #include <sstream>
@@ -1370,11 +1370,11 @@ statementBallotCounter(SCPStatement const& st)
 
 static bool
 hasVBlockingSubsetStrictlyAheadOf(
-    std::shared_ptr<LocalNode> localNode,
+    QuorumSetEvaluator& evaluator, std::shared_ptr<LocalNode> localNode,
     std::map<NodeID, SCPEnvelopeWrapperPtr> const& map, uint32_t n)
 {
-    return LocalNode::isVBlocking(
-        localNode->getQuorumSet(), map,
+    return evaluator.isVBlocking(
+        localNode->getQuorumSetHash(), localNode->getQuorumSet(), map,
         [&](SCPStatement const& st) { return statementBallotCounter(st) > n; });
 }
 
@@ -1406,10 +1406,11 @@ BallotProtocol::attemptBump()
         // is no v-blocking set ahead of the local node, there's nothing
         // to do, return early.
         auto localNode = getLocalNode();
+        auto& evaluator = mSlot.getSCP().getQuorumSetEvaluator();
         uint32 localCounter =
             mCurrentBallot ? mCurrentBallot->getBallot().counter : 0;
-        if (!hasVBlockingSubsetStrictlyAheadOf(localNode, mLatestEnvelopes,
-                                               localCounter))
+        if (!hasVBlockingSubsetStrictlyAheadOf(evaluator, localNode,
+                                               mLatestEnvelopes, localCounter))
         {
             return false;
         }
@@ -1429,8 +1430,8 @@ BallotProtocol::attemptBump()
         // order, starting from the smallest.
         for (uint32_t n : allCounters)
         {
-            if (!hasVBlockingSubsetStrictlyAheadOf(localNode, mLatestEnvelopes,
-                                                   n))
+            if (!hasVBlockingSubsetStrictlyAheadOf(evaluator, localNode,
+                                                   mLatestEnvelopes, n))
             {
                 // Move to n.
                 return abandonBallot(n);
@@ -1859,6 +1860,12 @@ BallotProtocol::getExternalizingState() const
     return res;
 }
 
+size_t
+BallotProtocol::getEstimatedBytes() const
+{
+    return Slot::getEstimatedBytes(mLatestEnvelopes);
+}
+
 void
 BallotProtocol::advanceSlot(SCPStatement const& hint)
 {
@@ -2195,10 +2202,10 @@ BallotProtocol::checkHeardFromQuorum()
     if (mCurrentBallot)
     {
         ZoneScoped;
-        if (LocalNode::isQuorum(
-                getLocalNode()->getQuorumSet(), mLatestEnvelopes,
-                std::bind(&Slot::getQuorumSetFromStatement, &mSlot, _1),
-                [&](SCPStatement const& st) {
+        auto localNode = getLocalNode();
+        if (mSlot.getSCP().getQuorumSetEvaluator().isQuorum(
+                localNode->getQuorumSetHash(), localNode->getQuorumSet(),
+                mLatestEnvelopes, [&](SCPStatement const& st) {
                     bool res;
                     if (st.pledges.type() == SCP_ST_PREPARE)
                     {
@@ -162,6 +162,14 @@ class BallotProtocol
 
     std::vector<SCPEnvelope> getExternalizingState() const;
 
+    bool
+    isExternalized() const
+    {
+        return mPhase == SCP_PHASE_EXTERNALIZE;
+    }
+
+    size_t getEstimatedBytes() const;
+
     // returns all values referenced by a statement
     static std::set<Value> getStatementValues(SCPStatement const& st);
 
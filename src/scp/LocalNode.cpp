@@ -10,10 +10,10 @@
 #include "scp/QuorumSetUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
 #include "util/numeric.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <algorithm>
 #include <functional>
 
@@ -11,9 +11,10 @@
 #include "scp/QuorumSetUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/MemoryFootprint.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <algorithm>
 #include <functional>
 
@@ -765,4 +766,30 @@ NominationProtocol::getLatestMessage(NodeID const& id) const
     }
     return nullptr;
 }
+
+void
+NominationProtocol::compact()
+{
+    mVotes.clear();
+    mAccepted.clear();
+    mCandidates.clear();
+    mLatestNominations.clear();
+    mRoundLeaders.clear();
+}
+
+size_t
+NominationProtocol::getEstimatedBytes() const
+{
+    size_t bytes = Slot::getEstimatedBytes(mLatestNominations) +
+                   mRoundLeaders.size() * nodeBytes<NodeID>();
+    for (auto const* values : {&mVotes, &mAccepted, &mCandidates})
+    {
+        for (auto const& v : *values)
+        {
+            bytes += nodeBytes<ValueWrapperPtr>() + sizeof(ValueWrapper) +
+                     v->getValue().size();
+        }
+    }
+    return bytes;
+}
 }
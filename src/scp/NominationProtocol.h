@@ -127,6 +127,12 @@ class NominationProtocol
     // or nullptr if not found
     SCPEnvelope const* getLatestMessage(NodeID const& id) const;
 
+    // drops the state only needed while nominating, keeping the last
+    // envelope emitted by this node
+    void compact();
+
+    size_t getEstimatedBytes() const;
+
   private:
     // The number of times the timer has expired
     // Used for the quorum endpoint.
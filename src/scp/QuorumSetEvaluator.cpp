@@ -0,0 +1,242 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "scp/QuorumSetEvaluator.h"
+#include "scp/LocalNode.h"
+#include "scp/Slot.h"
+#include "util/Tracing.h"
+#include <algorithm>
+
+namespace stellar
+{
+
+size_t const QuorumSetEvaluator::MAX_COMPILED_QUORUM_SETS = 1000;
+
+CompiledQuorumSet::CompiledQuorumSet(
+    SCPQuorumSet const& qSet,
+    std::function<size_t(NodeID const&)> const& nodeIndex)
+    : mThreshold(qSet.threshold)
+{
+    for (auto const& validator : qSet.validators)
+    {
+        auto i = nodeIndex(validator);
+        if (mValidators.get(i))
+        {
+            // Sane quorum sets have no duplicates, but those that do count
+            // each occurrence
+            mRepeatedValidators.emplace_back(i);
+        }
+        else
+        {
+            mValidators.set(i);
+        }
+    }
+    mInnerSets.reserve(qSet.innerSets.size());
+    for (auto const& inner : qSet.innerSets)
+    {
+        mInnerSets.emplace_back(inner, nodeIndex);
+    }
+}
+
+size_t
+CompiledQuorumSet::countValidators(BitSet const& nodes) const
+{
+    size_t count = mValidators.intersectionCount(nodes);
+    for (auto i : mRepeatedValidators)
+    {
+        if (nodes.get(i))
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool
+CompiledQuorumSet::isQuorumSlice(BitSet const& nodes) const
+{
+    // As in LocalNode::isQuorumSliceInternal, a threshold of 0 is never met
+    if (mThreshold == 0)
+    {
+        return false;
+    }
+
+    size_t count = countValidators(nodes);
+    for (auto const& inner : mInnerSets)
+    {
+        if (count >= mThreshold)
+        {
+            return true;
+        }
+        if (inner.isQuorumSlice(nodes))
+        {
+            ++count;
+        }
+    }
+    return count >= mThreshold;
+}
+
+bool
+CompiledQuorumSet::isVBlocking(BitSet const& nodes) const
+{
+    // There is no v-blocking set for {\empty}
+    if (mThreshold == 0)
+    {
+        return false;
+    }
+
+    // As in LocalNode::isVBlockingInternal, at least one member is needed
+    // even if the threshold is larger than the number of members
+    int64_t leftTillBlock = static_cast<int64_t>(
+        1 + mValidators.count() + mRepeatedValidators.size() +
+        mInnerSets.size()) -
+        mThreshold;
+    auto needed = static_cast<size_t>(std::max<int64_t>(leftTillBlock, 1));
+
+    size_t count = countValidators(nodes);
+    for (auto const& inner : mInnerSets)
+    {
+        if (count >= needed)
+        {
+            return true;
+        }
+        if (inner.isVBlocking(nodes))
+        {
+            ++count;
+        }
+    }
+    return count >= needed;
+}
+
+QuorumSetEvaluator::QuorumSetEvaluator(SCPDriver& driver) : mDriver(driver)
+{
+}
+
+size_t
+QuorumSetEvaluator::getNodeIndex(NodeID const& nodeID)
+{
+    return mNodeIndices.emplace(nodeID, mNodeIndices.size()).first->second;
+}
+
+void
+QuorumSetEvaluator::maybeReset()
+{
+    if (mCompiled.size() + mSingletons.size() > MAX_COMPILED_QUORUM_SETS)
+    {
+        mCompiled.clear();
+        mSingletons.clear();
+        mNodeIndices.clear();
+    }
+}
+
+CompiledQuorumSet const&
+QuorumSetEvaluator::compile(Hash const& qSetHash, SCPQuorumSet const& qSet)
+{
+    auto& compiled = mCompiled[qSetHash];
+    if (!compiled)
+    {
+        compiled = std::make_unique<CompiledQuorumSet const>(
+            qSet, [this](NodeID const& n) { return getNodeIndex(n); });
+    }
+    return *compiled;
+}
+
+CompiledQuorumSet const*
+QuorumSetEvaluator::compileFromStatement(SCPStatement const& st)
+{
+    if (st.pledges.type() == SCP_ST_EXTERNALIZE)
+    {
+        auto& compiled = mSingletons[st.nodeID];
+        if (!compiled)
+        {
+            compiled = std::make_unique<CompiledQuorumSet const>(
+                *LocalNode::getSingletonQSet(st.nodeID),
+                [this](NodeID const& n) { return getNodeIndex(n); });
+        }
+        return compiled.get();
+    }
+
+    auto h = Slot::getCompanionQuorumSetHashFromStatement(st);
+    auto it = mCompiled.find(h);
+    if (it != mCompiled.end())
+    {
+        return it->second.get();
+    }
+    auto qSet = mDriver.getQSet(h);
+    return qSet ? &compile(h, *qSet) : nullptr;
+}
+
+BitSet
+QuorumSetEvaluator::filterNodes(
+    std::map<NodeID, SCPEnvelopeWrapperPtr> const& map,
+    std::function<bool(SCPStatement const&)> const& filter,
+    std::vector<std::pair<size_t, CompiledQuorumSet const*>>* withQSets)
+{
+    BitSet nodes;
+    for (auto const& it : map)
+    {
+        auto const& st = it.second->getStatement();
+        if (filter(st))
+        {
+            auto i = getNodeIndex(it.first);
+            nodes.set(i);
+            if (withQSets)
+            {
+                withQSets->emplace_back(i, compileFromStatement(st));
+            }
+        }
+    }
+    return nodes;
+}
+
+bool
+QuorumSetEvaluator::isVBlocking(
+    Hash const& qSetHash, SCPQuorumSet const& qSet,
+    std::map<NodeID, SCPEnvelopeWrapperPtr> const& map,
+    std::function<bool(SCPStatement const&)> const& filter)
+{
+    ZoneScoped;
+    maybeReset();
+    auto const& compiled = compile(qSetHash, qSet);
+    return compiled.isVBlocking(filterNodes(map, filter, nullptr));
+}
+
+bool
+QuorumSetEvaluator::isQuorum(
+    Hash const& qSetHash, SCPQuorumSet const& qSet,
+    std::map<NodeID, SCPEnvelopeWrapperPtr> const& map,
+    std::function<bool(SCPStatement const&)> const& filter)
+{
+    ZoneScoped;
+    maybeReset();
+    auto const& compiled = compile(qSetHash, qSet);
+    std::vector<std::pair<size_t, CompiledQuorumSet const*>> candidates;
+    auto nodes = filterNodes(map, filter, &candidates);
+
+    // Removes the nodes whose quorum sets are not satisfied by the remaining
+    // ones until none are left to remove, which leaves the same set as the
+    // rounds of LocalNode::isQuorum
+    bool removed;
+    do
+    {
+        removed = false;
+        auto it = candidates.begin();
+        while (it != candidates.end())
+        {
+            if (!it->second || !it->second->isQuorumSlice(nodes))
+            {
+                nodes.unset(it->first);
+                it = candidates.erase(it);
+                removed = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    } while (removed);
+
+    return compiled.isQuorumSlice(nodes);
+}
+}
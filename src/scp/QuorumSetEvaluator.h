@@ -0,0 +1,96 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/SecretKey.h"
+#include "scp/SCPDriver.h"
+#include "util/BitSet.h"
+#include "util/HashOfHash.h"
+#include "util/NonCopyable.h"
+#include "util/UnorderedMap.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace stellar
+{
+
+// A quorum set with its validators turned into a bitset over dense node
+// indices (see QuorumSetEvaluator), so that checking it against a set of nodes
+// given as a bitset of the same indices takes one popcount per inner set.
+class CompiledQuorumSet
+{
+    uint32 mThreshold;
+    BitSet mValidators;
+    // Indices of validators listed more than once
+    std::vector<size_t> mRepeatedValidators;
+    std::vector<CompiledQuorumSet> mInnerSets;
+
+    size_t countValidators(BitSet const& nodes) const;
+
+  public:
+    CompiledQuorumSet(SCPQuorumSet const& qSet,
+                      std::function<size_t(NodeID const&)> const& nodeIndex);
+
+    // Same as LocalNode::isQuorumSlice and LocalNode::isVBlocking
+    bool isQuorumSlice(BitSet const& nodes) const;
+    bool isVBlocking(BitSet const& nodes) const;
+};
+
+// Evaluates the quorum and v-blocking checks of LocalNode on the envelopes of
+// a slot using quorum sets compiled once per quorum set hash, instead of
+// walking the quorum sets and searching node lists on every check. Owned by
+// SCP, and as such used from one thread.
+class QuorumSetEvaluator : public NonMovableOrCopyable
+{
+    SCPDriver& mDriver;
+
+    UnorderedMap<NodeID, size_t> mNodeIndices;
+    UnorderedMap<Hash, std::unique_ptr<CompiledQuorumSet const>> mCompiled;
+    // The {{X}} quorum sets of externalizing nodes
+    UnorderedMap<NodeID, std::unique_ptr<CompiledQuorumSet const>> mSingletons;
+
+    size_t getNodeIndex(NodeID const& nodeID);
+
+    // Drops every compiled quorum set, and the node indices they use, once
+    // there are too many of them. Only called at the start of a check, so
+    // that compiled quorum sets stay valid for its duration.
+    void maybeReset();
+
+    CompiledQuorumSet const& compile(Hash const& qSetHash,
+                                     SCPQuorumSet const& qSet);
+
+    // The compiled quorum set of the node of `st`, as
+    // Slot::getQuorumSetFromStatement, or nullptr if it is unknown
+    CompiledQuorumSet const* compileFromStatement(SCPStatement const& st);
+
+    // The nodes of `map` whose statements pass `filter`, with the compiled
+    // quorum sets of those nodes if `withQSets`
+    BitSet
+    filterNodes(std::map<NodeID, SCPEnvelopeWrapperPtr> const& map,
+                std::function<bool(SCPStatement const&)> const& filter,
+                std::vector<std::pair<size_t, CompiledQuorumSet const*>>*
+                    withQSets);
+
+  public:
+    static size_t const MAX_COMPILED_QUORUM_SETS;
+
+    explicit QuorumSetEvaluator(SCPDriver& driver);
+
+    // Same as LocalNode::isVBlocking, for the quorum set `qSet` of hash
+    // `qSetHash`
+    bool isVBlocking(Hash const& qSetHash, SCPQuorumSet const& qSet,
+                     std::map<NodeID, SCPEnvelopeWrapperPtr> const& map,
+                     std::function<bool(SCPStatement const&)> const& filter);
+
+    // Same as LocalNode::isQuorum, for the quorum set `qSet` of hash
+    // `qSetHash`, with the quorum sets of the nodes of `map` taken from their
+    // statements as Slot::getQuorumSetFromStatement does
+    bool isQuorum(Hash const& qSetHash, SCPQuorumSet const& qSet,
+                  std::map<NodeID, SCPEnvelopeWrapperPtr> const& map,
+                  std::function<bool(SCPStatement const&)> const& filter);
+};
+}
@@ -20,7 +20,7 @@ namespace stellar
 
 SCP::SCP(SCPDriver& driver, NodeID const& nodeID, bool isValidator,
          SCPQuorumSet const& qSetLocal)
-    : mDriver(driver)
+    : mDriver(driver), mQuorumSetEvaluator(driver)
 {
     mLocalNode =
         std::make_shared<LocalNode>(nodeID, isValidator, qSetLocal, driver);
@@ -86,6 +86,31 @@ SCP::purgeSlots(uint64 maxSlotIndex, uint64 slotToKeep)
     }
 }
 
+void
+SCP::compactSlots(uint64 maxSlotIndex)
+{
+    for (auto it = mKnownSlots.begin();
+         it != mKnownSlots.end() && it->first < maxSlotIndex; ++it)
+    {
+        auto& slot = it->second;
+        if (!slot->isCompacted() && slot->isExternalized())
+        {
+            slot->compact();
+        }
+    }
+}
+
+size_t
+SCP::getEstimatedBytes() const
+{
+    size_t bytes = 0;
+    for (auto const& s : mKnownSlots)
+    {
+        bytes += s.second->getEstimatedBytes();
+    }
+    return bytes;
+}
+
 std::shared_ptr<LocalNode>
 SCP::getLocalNode()
 {
@@ -11,6 +11,7 @@
 #include <set>
 
 #include "lib/json/json-forwards.h"
+#include "scp/QuorumSetEvaluator.h"
 #include "scp/SCPDriver.h"
 
 namespace stellar
@@ -23,6 +24,7 @@ typedef std::shared_ptr<SCPQuorumSet> SCPQuorumSetPtr;
 class SCP
 {
     SCPDriver& mDriver;
+    QuorumSetEvaluator mQuorumSetEvaluator;
 
   public:
     SCP(SCPDriver& driver, NodeID const& nodeID, bool isValidator,
@@ -38,6 +40,11 @@ class SCP
     {
         return mDriver;
     }
+    QuorumSetEvaluator&
+    getQuorumSetEvaluator()
+    {
+        return mQuorumSetEvaluator;
+    }
 
     enum EnvelopeState
     {
@@ -89,6 +96,13 @@ class SCP
     // than the specified `maxSlotIndex` except for slotToKeep slot.
     void purgeSlots(uint64 maxSlotIndex, uint64 slotToKeep);
 
+    // Compacts (see Slot::compact) the externalized slots whose slotIndex is
+    // smaller than the specified `maxSlotIndex`
+    void compactSlots(uint64 maxSlotIndex);
+
+    // Returns the estimated bytes held by all the slots
+    size_t getEstimatedBytes() const;
+
     // Returns whether the local node is a validator.
     bool isValidator();
 
@@ -11,6 +11,7 @@
 #include "scp/QuorumSetUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/MemoryFootprint.h"
 #include "util/XDROperators.h"
 #include "xdrpp/marshal.h"
 #include <ctime>
@@ -149,8 +150,12 @@ Slot::getExternalizingState() const
 void
 Slot::recordStatement(SCPStatement const& st)
 {
-    mStatementsHistory.emplace_back(
-        HistoricalStatement{std::time(nullptr), st, mFullyValidated});
+    if (!mCompacted)
+    {
+        mStatementsHistory.emplace_back(
+            HistoricalStatement{std::time(nullptr), st, mFullyValidated});
+        mStatementsBytes += sizeof(HistoricalStatement) + xdr::xdr_size(st);
+    }
     CLOG_DEBUG(SCP, "new statement:  i: {} st: {} validated: {}",
                getSlotIndex(), mSCP.envToStr(st, false),
                (mFullyValidated ? "true" : "false"));
@@ -335,6 +340,38 @@ Slot::getQuorumSetFromStatement(SCPStatement const& st)
     return res;
 }
 
+void
+Slot::compact()
+{
+    releaseAssert(isExternalized());
+    // Frees the memory, unlike clear()
+    std::vector<HistoricalStatement>().swap(mStatementsHistory);
+    mStatementsBytes = 0;
+    mNominationProtocol.compact();
+    mCompacted = true;
+}
+
+size_t
+Slot::getEstimatedBytes() const
+{
+    return sizeof(Slot) + mStatementsBytes +
+           mNominationProtocol.getEstimatedBytes() +
+           mBallotProtocol.getEstimatedBytes();
+}
+
+size_t
+Slot::getEstimatedBytes(std::map<NodeID, SCPEnvelopeWrapperPtr> const& envs)
+{
+    size_t bytes = 0;
+    for (auto const& kv : envs)
+    {
+        bytes += nodeBytes<std::pair<NodeID, SCPEnvelopeWrapperPtr>>() +
+                 sizeof(SCPEnvelopeWrapper) +
+                 xdr::xdr_size(kv.second->getEnvelope());
+    }
+    return bytes;
+}
+
 Json::Value
 Slot::getJsonInfo(bool fullKeys)
 {
@@ -365,6 +402,8 @@ Slot::getJsonInfo(bool fullKeys)
     }
 
     ret["validated"] = mFullyValidated;
+    ret["compacted"] = mCompacted;
+    ret["estimatedBytes"] = static_cast<Json::UInt64>(getEstimatedBytes());
     ret["nomination"] = mNominationProtocol.getJsonInfo();
     ret["ballotProtocol"] = mBallotProtocol.getJsonInfo();
 
@@ -399,7 +438,10 @@ Slot::federatedAccept(StatementPredicate voted, StatementPredicate accepted,
 {
     // Checks if the nodes that claimed to accept the statement form a
     // v-blocking set
-    if (LocalNode::isVBlocking(getLocalNode()->getQuorumSet(), envs, accepted))
+    auto localNode = getLocalNode();
+    auto& evaluator = mSCP.getQuorumSetEvaluator();
+    if (evaluator.isVBlocking(localNode->getQuorumSetHash(),
+                              localNode->getQuorumSet(), envs, accepted))
     {
         return true;
     }
@@ -412,10 +454,8 @@ Slot::federatedAccept(StatementPredicate voted, StatementPredicate accepted,
         return res;
     };
 
-    if (LocalNode::isQuorum(
-            getLocalNode()->getQuorumSet(), envs,
-            std::bind(&Slot::getQuorumSetFromStatement, this, _1),
-            ratifyFilter))
+    if (evaluator.isQuorum(localNode->getQuorumSetHash(),
+                           localNode->getQuorumSet(), envs, ratifyFilter))
     {
         return true;
     }
@@ -427,9 +467,9 @@ bool
 Slot::federatedRatify(StatementPredicate voted,
                       std::map<NodeID, SCPEnvelopeWrapperPtr> const& envs)
 {
-    return LocalNode::isQuorum(
-        getLocalNode()->getQuorumSet(), envs,
-        std::bind(&Slot::getQuorumSetFromStatement, this, _1), voted);
+    auto localNode = getLocalNode();
+    return mSCP.getQuorumSetEvaluator().isQuorum(
+        localNode->getQuorumSetHash(), localNode->getQuorumSet(), envs, voted);
 }
 
 std::shared_ptr<LocalNode>
@@ -41,6 +41,11 @@ class Slot : public std::enable_shared_from_this<Slot>
     };
 
     std::vector<HistoricalStatement> mStatementsHistory;
+    // estimated bytes held by mStatementsHistory
+    size_t mStatementsBytes{0};
+
+    // true once the Slot was compacted (see `compact`)
+    bool mCompacted{false};
 
     // true if the Slot was fully validated
     bool mFullyValidated;
@@ -136,6 +141,32 @@ class Slot : public std::enable_shared_from_this<Slot>
     bool isFullyValidated() const;
     void setFullyValidated(bool fullyValidated);
 
+    bool
+    isExternalized() const
+    {
+        return mBallotProtocol.isExternalized();
+    }
+
+    // Drops the statement history and the nomination state of an
+    // externalized slot, keeping the latest ballot messages: what is needed
+    // to respond to peers (processCurrentState, getExternalizingState) and
+    // the messages this node emitted. The latest nominations of other nodes
+    // are no longer part of the current state of a compacted slot.
+    void compact();
+
+    bool
+    isCompacted() const
+    {
+        return mCompacted;
+    }
+
+    // estimated bytes held by this slot
+    size_t getEstimatedBytes() const;
+
+    // estimated bytes held by a map of latest envelopes by node
+    static size_t
+    getEstimatedBytes(std::map<NodeID, SCPEnvelopeWrapperPtr> const& envs);
+
     // ** status methods
 
     size_t
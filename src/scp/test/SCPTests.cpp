@@ -882,6 +882,19 @@ TEST_CASE("ballot protocol core5", "[scp][ballotprotocol]")
                                             1);
                                         REQUIRE(scp.mExternalizedValues[0] ==
                                                 aValue);
+
+                                        SECTION("compact")
+                                        {
+                                            auto& s = scp.mSCP;
+                                            auto state =
+                                                s.getExternalizingState(0);
+                                            auto bytes = s.getEstimatedBytes();
+                                            s.compactSlots(1);
+                                            REQUIRE(s.getEstimatedBytes() <
+                                                    bytes);
+                                            REQUIRE(s.getExternalizingState(
+                                                        0) == state);
+                                        }
                                     }
                                 }
                                 SECTION("v-blocking accept more A3")
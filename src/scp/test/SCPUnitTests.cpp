@@ -1,10 +1,15 @@
+#include "crypto/SHA.h"
+#include "crypto/SecretKey.h"
 #include "lib/catch.hpp"
 #include "scp/LocalNode.h"
+#include "scp/QuorumSetEvaluator.h"
 #include "scp/SCP.h"
 #include "scp/Slot.h"
 #include "simulation/Simulation.h"
 #include "util/Logging.h"
+#include "util/Math.h"
 #include "xdrpp/marshal.h"
+#include <chrono>
 
 namespace stellar
 {
@@ -431,4 +436,163 @@ TEST_CASE("nomination two nodes win stats", "[scp][!hide]")
         }
     }
 }
+
+// Quorum set of `orgs` organizations of 3 validators each, configured as on
+// mainnet: 2 of the 3 validators of an organization, and 2/3 of the
+// organizations
+static SCPQuorumSet
+makeTieredQSet(std::vector<NodeID> const& nodeIDs, int orgs)
+{
+    SCPQuorumSet qSet;
+    qSet.threshold = orgs - (orgs - 1) / 3;
+    for (int i = 0; i < orgs; i++)
+    {
+        qSet.innerSets.emplace_back(makeQSet(nodeIDs, 2, 3, i * 3));
+    }
+    return qSet;
+}
+
+static std::vector<NodeID>
+makeNodeIDs(int n)
+{
+    std::vector<NodeID> nodeIDs;
+    for (int i = 0; i < n; i++)
+    {
+        auto seed = sha256("NODE_SEED_" + std::to_string(i));
+        nodeIDs.emplace_back(SecretKey::fromSeed(seed).getPublicKey());
+    }
+    return nodeIDs;
+}
+
+static SCPEnvelopeWrapperPtr
+makePrepare(SCPDriver& driver, NodeID const& nodeID, Hash const& qSetHash,
+            uint32 counter)
+{
+    SCPEnvelope env;
+    env.statement.nodeID = nodeID;
+    env.statement.pledges.type(SCP_ST_PREPARE);
+    env.statement.pledges.prepare().quorumSetHash = qSetHash;
+    env.statement.pledges.prepare().ballot.counter = counter;
+    return driver.wrapEnvelope(env);
+}
+
+static SCPEnvelopeWrapperPtr
+makeExternalize(SCPDriver& driver, NodeID const& nodeID, Hash const& qSetHash)
+{
+    SCPEnvelope env;
+    env.statement.nodeID = nodeID;
+    env.statement.pledges.type(SCP_ST_EXTERNALIZE);
+    env.statement.pledges.externalize().commitQuorumSetHash = qSetHash;
+    return driver.wrapEnvelope(env);
+}
+
+TEST_CASE("quorum set evaluator agrees with LocalNode", "[scp]")
+{
+    auto nodeIDs = makeNodeIDs(21);
+    auto qSet = makeTieredQSet(nodeIDs, 7);
+    TestNominationSCP driver(nodeIDs[0], qSet);
+    auto qSetHash = sha256(xdr::xdr_to_opaque(qSet));
+    // Some nodes trust fewer organizations, or nest them differently
+    auto smallQSet = std::make_shared<SCPQuorumSet>(makeTieredQSet(nodeIDs, 4));
+    driver.storeQuorumSet(smallQSet);
+    auto flatQSet =
+        std::make_shared<SCPQuorumSet>(makeQSet(nodeIDs, 11, 15, 3));
+    driver.storeQuorumSet(flatQSet);
+    std::vector<Hash> qSetHashes = {qSetHash,
+                                    sha256(xdr::xdr_to_opaque(*smallQSet)),
+                                    sha256(xdr::xdr_to_opaque(*flatQSet)),
+                                    sha256("unknown quorum set")};
+
+    QuorumSetEvaluator evaluator(driver);
+    auto qfun = [&](SCPStatement const& st) {
+        return st.pledges.type() == SCP_ST_EXTERNALIZE
+                   ? LocalNode::getSingletonQSet(st.nodeID)
+                   : driver.getQSet(
+                         Slot::getCompanionQuorumSetHashFromStatement(st));
+    };
+    auto filter = [](SCPStatement const& st) {
+        return st.pledges.type() == SCP_ST_EXTERNALIZE ||
+               st.pledges.prepare().ballot.counter > 0;
+    };
+
+    size_t quorums = 0;
+    size_t vBlocking = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        std::map<NodeID, SCPEnvelopeWrapperPtr> envs;
+        for (auto const& nodeID : nodeIDs)
+        {
+            auto r = rand_uniform<int>(0, 9);
+            if (r < 2)
+            {
+                continue;
+            }
+            auto const& h = r == 2 ? rand_element(qSetHashes) : qSetHash;
+            auto counter = rand_uniform<uint32>(0, 3);
+            envs[nodeID] = rand_uniform<int>(0, 19) == 0
+                               ? makeExternalize(driver, nodeID, h)
+                               : makePrepare(driver, nodeID, h, counter);
+        }
+
+        bool isQuorum = LocalNode::isQuorum(qSet, envs, qfun, filter);
+        REQUIRE(evaluator.isQuorum(qSetHash, qSet, envs, filter) == isQuorum);
+        bool isVBlocking = LocalNode::isVBlocking(qSet, envs, filter);
+        REQUIRE(evaluator.isVBlocking(qSetHash, qSet, envs, filter) ==
+                isVBlocking);
+        quorums += isQuorum;
+        vBlocking += isVBlocking;
+    }
+    // Both outcomes were covered
+    REQUIRE(quorums > 0);
+    REQUIRE(quorums < 2000);
+    REQUIRE(vBlocking > 0);
+    REQUIRE(vBlocking < 2000);
+}
+
+TEST_CASE("quorum set evaluator bench", "[scp][bench][!hide]")
+{
+    for (int orgs : {7, 12, 20})
+    {
+        auto nodeIDs = makeNodeIDs(orgs * 3);
+        auto qSet = makeTieredQSet(nodeIDs, orgs);
+        TestNominationSCP driver(nodeIDs[0], qSet);
+        auto qSetHash = sha256(xdr::xdr_to_opaque(qSet));
+        QuorumSetEvaluator evaluator(driver);
+
+        // Every node but one per organization is ahead
+        std::map<NodeID, SCPEnvelopeWrapperPtr> envs;
+        for (size_t i = 0; i < nodeIDs.size(); i++)
+        {
+            envs[nodeIDs[i]] =
+                makePrepare(driver, nodeIDs[i], qSetHash, i % 3 == 0 ? 1 : 2);
+        }
+        auto qfun = [&](SCPStatement const& st) {
+            return driver.getQSet(st.pledges.prepare().quorumSetHash);
+        };
+        auto filter = [](SCPStatement const& st) {
+            return st.pledges.prepare().ballot.counter > 1;
+        };
+
+        size_t const n = 10000;
+        size_t quorums = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n; i++)
+        {
+            quorums += LocalNode::isQuorum(qSet, envs, qfun, filter);
+            quorums += LocalNode::isVBlocking(qSet, envs, filter);
+        }
+        auto step1 = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n; i++)
+        {
+            quorums += evaluator.isQuorum(qSetHash, qSet, envs, filter);
+            quorums += evaluator.isVBlocking(qSetHash, qSet, envs, filter);
+        }
+        auto step2 = std::chrono::high_resolution_clock::now();
+        REQUIRE(quorums == 4 * n);
+        LOG_INFO(DEFAULT_LOG,
+                 "{} organizations: LocalNode {} per check, compiled {} per "
+                 "check",
+                 orgs, (step1 - start) / (2 * n), (step2 - step1) / (2 * n));
+    }
+}
 }
@@ -15,7 +15,10 @@
 #include "lib/catch.hpp"
 #include "lib/util/stdrandom.h"
 #include "main/Application.h"
+#include "medida/meter.h"
 #include "medida/stats/snapshot.h"
+#include "medida/timer.h"
+#include "overlay/OverlayManager.h"
 #include "overlay/StellarXDR.h"
 #include "simulation/Topologies.h"
 #include "test/test.h"
@@ -136,6 +139,61 @@ TEST_CASE("asymmetric topology report cost", "[simulation][!hide]")
     }
 }
 
+TEST_CASE("connect storm", "[simulation][!hide]")
+{
+    // Many nodes connect to a single node at once; reports how long it takes
+    // the target to authenticate all of them and where its time went
+    int const nConnecting = 64;
+
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto simulation = Topologies::separate(
+        nConnecting + 1, 0.5, Simulation::OVER_TCP, networkID, 0,
+        [&](int i) {
+            auto cfg = getTestConfig(i);
+            if (i == 0)
+            {
+                cfg.TARGET_PEER_CONNECTIONS = nConnecting;
+                cfg.MAX_ADDITIONAL_PEER_CONNECTIONS = nConnecting;
+                cfg.MAX_INBOUND_PENDING_CONNECTIONS = nConnecting;
+            }
+            return cfg;
+        });
+
+    auto nodes = simulation->getNodeIDs();
+    for (size_t i = 1; i < nodes.size(); ++i)
+    {
+        simulation->addPendingConnection(nodes[i], nodes[0]);
+    }
+
+    auto target = simulation->getNode(nodes[0]);
+    auto tBegin = std::chrono::system_clock::now();
+    simulation->startAllNodes();
+    simulation->crankUntil(
+        [&]() {
+            return target->getOverlayManager().getAuthenticatedPeersCount() ==
+                   nConnecting;
+        },
+        std::chrono::seconds(60), false);
+    auto t = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now() - tBegin);
+
+    auto& metrics = target->getMetrics();
+    auto& derive = metrics.NewTimer({"overlay", "auth", "derive-shared-key"});
+    auto& verify = metrics.NewTimer({"overlay", "auth", "verify-cert"});
+    auto& throttled = metrics.NewMeter({"overlay", "inbound", "throttle"},
+                                       "connection");
+    LOG_INFO(DEFAULT_LOG,
+             "Authenticated {} of {} connecting nodes in {} ms; derived {} "
+             "shared keys (mean {} ms), verified {} certs (mean {} ms), "
+             "throttled {} accepts",
+             target->getOverlayManager().getAuthenticatedPeersCount(),
+             nConnecting, t.count(), derive.count(), derive.mean(),
+             verify.count(), verify.mean(), throttled.count());
+
+    REQUIRE(target->getOverlayManager().getAuthenticatedPeersCount() ==
+            nConnecting);
+}
+
 TEST_CASE("core topology 4 ledgers at scales 2 to 4",
           "[simulation][acceptance]")
 {
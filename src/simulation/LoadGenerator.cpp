@@ -30,7 +30,8 @@
 #include "medida/metrics_registry.h"
 
 #include "ledger/test/LedgerTestUtils.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+#include <algorithm>
 #include <cmath>
 #include <crypto/SHA.h>
 #include <fmt/format.h>
@@ -52,6 +53,8 @@ constexpr uint32_t DEFAULT_NUM_DATA_ENTRIES = 2;
 constexpr uint32_t DEFAULT_IO_KILOBYTES = 1;
 constexpr uint32_t DEFAULT_TX_SIZE_BYTES = 256;
 constexpr uint64_t DEFAULT_INSTRUCTIONS = 28'000'000;
+// Approximate size of a contract data entry besides its value
+constexpr uint32_t DATA_ENTRY_OVERHEAD_BYTES = 100;
 
 // Sample from a discrete distribution of `values` with weights `weights`.
 // Returns `defaultValue` if `values` is empty.
@@ -69,6 +72,41 @@ sampleDiscrete(std::vector<T> const& values,
                                                       weights.end());
     return values.at(distribution(gRandomEngine));
 }
+
+// "TRY_AGAIN_LATER" -> "try-again-later", "txBAD_SEQ" -> "bad-seq"
+std::string
+toMetricName(std::string name)
+{
+    if (name.rfind("tx", 0) == 0)
+    {
+        name = name.substr(2);
+    }
+    for (auto& c : name)
+    {
+        c = c == '_' ? '-' : static_cast<char>(std::tolower(c));
+    }
+    return name;
+}
+
+// Invocation of `do_work` on the loadgen contract, which runs the given number
+// of guest and host cycles and then writes `numEntries` persistent entries
+// keyed by 0 to `numEntries - 1`, of `kiloBytesPerEntry` each
+Operation
+makeDoWorkOp(SCAddress const& contractID, uint64_t guestCycles,
+             uint64_t hostCycles, uint32_t numEntries,
+             uint32_t kiloBytesPerEntry)
+{
+    Operation op;
+    op.body.type(INVOKE_HOST_FUNCTION);
+    auto& ihf = op.body.invokeHostFunctionOp().hostFunction;
+    ihf.type(HOST_FUNCTION_TYPE_INVOKE_CONTRACT);
+    ihf.invokeContract().contractAddress = contractID;
+    ihf.invokeContract().functionName = "do_work";
+    ihf.invokeContract().args = {makeU64(guestCycles), makeU64(hostCycles),
+                                 makeU32(numEntries),
+                                 makeU32(kiloBytesPerEntry)};
+    return op;
+}
 } // namespace
 
 // Units of load are scheduled at 100ms intervals.
@@ -91,6 +129,10 @@ const uint32_t LoadGenerator::COMPLETION_TIMEOUT_WITHOUT_CHECKS = 4;
 // buffer in case loadgen is unstable and needs more accounts)
 const uint32_t LoadGenerator::MIN_UNIQUE_ACCOUNT_MULTIPLIER = 3;
 
+// Open-loop transactions are handed to background threads for signing in
+// batches of this size
+const uint32_t LoadGenerator::OPEN_LOOP_SIGN_BATCH_SIZE = 100;
+
 LoadGenerator::LoadGenerator(Application& app)
     : mMinBalance(0)
     , mLastSecond(0)
@@ -150,6 +192,10 @@ LoadGenerator::getMode(std::string const& mode)
     {
         return LoadGenMode::MIXED_CLASSIC_SOROBAN;
     }
+    else if (mode == "mixed_soroban")
+    {
+        return LoadGenMode::MIXED_SOROBAN;
+    }
     else
     {
         throw std::runtime_error(
@@ -268,7 +314,8 @@ LoadGenerator::cleanupAccounts()
     {
         auto accIt = mAccounts.find(*it);
         releaseAssert(accIt != mAccounts.end());
-        if (!mApp.getHerder().sourceAccountPending(
+        if (mOpenLoopAccounts.find(*it) == mOpenLoopAccounts.end() &&
+            !mApp.getHerder().sourceAccountPending(
                 accIt->second->getPublicKey()))
         {
             mAccountsAvailable.insert(*it);
@@ -289,6 +336,10 @@ LoadGenerator::reset()
     mAccountsInUse.clear();
     mAccountsAvailable.clear();
     mCreationSourceAccounts.clear();
+    mOpenLoopSigned.clear();
+    mOpenLoopAccounts.clear();
+    mOpenLoopSigning = 0;
+    mOpenLoopToken = std::make_shared<bool>();
     mContractInstances.clear();
     mLoadTimer.reset();
     mRoot.reset();
@@ -310,6 +361,7 @@ LoadGenerator::resetSorobanState()
     mContractInstanceKeys.clear();
     mCodeKey.reset();
     mContactOverheadBytes = 0;
+    mWrittenData.clear();
 }
 
 void
@@ -451,6 +503,12 @@ LoadGenerator::scheduleLoadGeneration(GeneratedLoadConfig cfg)
             MIN_UNIQUE_ACCOUNT_MULTIPLIER);
     }
 
+    if (cfg.openLoop && cfg.mode != LoadGenMode::PAY &&
+        cfg.mode != LoadGenMode::PRETEND)
+    {
+        errorMsg = "Open-loop load generation supports modes pay and pretend";
+    }
+
     if (cfg.isSoroban() &&
         protocolVersionIsBefore(mApp.getLedgerManager()
                                     .getLastClosedLedgerHeader()
@@ -483,6 +541,14 @@ LoadGenerator::scheduleLoadGeneration(GeneratedLoadConfig cfg)
         }
     }
 
+    if (cfg.mode == LoadGenMode::MIXED_SOROBAN &&
+        cfg.getMixSorobanConfig().sacTransferWeight != 0 &&
+        !nativeAssetContractDeployed())
+    {
+        errorMsg = "must run SOROBAN_INVOKE_SETUP to deploy the native asset "
+                   "contract";
+    }
+
     if (errorMsg)
     {
         CLOG_ERROR(LoadGen, "{}", *errorMsg);
@@ -565,6 +631,9 @@ GeneratedLoadConfig::getStatus() const
     case LoadGenMode::MIXED_CLASSIC_SOROBAN:
         modeStr = "mixed_classic_soroban";
         break;
+    case LoadGenMode::MIXED_SOROBAN:
+        modeStr = "mixed_soroban";
+        break;
     }
 
     ret["mode"] = modeStr;
@@ -601,6 +670,14 @@ GeneratedLoadConfig::getStatus() const
         ret["soroban_upload_weight"] = blendCfg.sorobanUploadWeight;
         ret["soroban_invoke_weight"] = blendCfg.sorobanInvokeWeight;
     }
+    else if (mode == LoadGenMode::MIXED_SOROBAN)
+    {
+        auto const& mixCfg = getMixSorobanConfig();
+        ret["sac_transfer_weight"] = mixCfg.sacTransferWeight;
+        ret["storage_weight"] = mixCfg.storageWeight;
+        ret["read_weight"] = mixCfg.readWeight;
+        ret["ttl_weight"] = mixCfg.ttlWeight;
+    }
 
     if (isSoroban())
     {
@@ -625,11 +702,11 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
     if (!cfg.areTxsRemaining())
     {
         // Done submitting the load, now ensure it propagates to the DB.
-        if (!cfg.isCreate() && cfg.skipLowFeeTxs)
+        if (!cfg.isCreate() && (cfg.skipLowFeeTxs || cfg.openLoop))
         {
-            // skipLowFeeTxs allows triggering tx queue limiter, which
-            // makes it hard to track the final seq nums. Hence just
-            // wait unconditionally.
+            // skipLowFeeTxs allows triggering tx queue limiter, and open-loop
+            // load doesn't retry rejected txs, which makes it hard to track
+            // the final seq nums. Hence just wait unconditionally.
             waitTillCompleteWithoutChecks();
         }
         else
@@ -641,6 +718,12 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
 
     updateMinBalance();
 
+    if (cfg.openLoop)
+    {
+        generateOpenLoopLoad(cfg);
+        return;
+    }
+
     auto txPerStep = getTxPerStep(cfg.txRate, cfg.spikeInterval, cfg.spikeSize);
     if (cfg.mode == LoadGenMode::CREATE)
     {
@@ -753,12 +836,17 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
                         return createUploadWasmTransaction(
                             ledgerNum, sourceAccountId, cfg);
                     }
-                    else
+                    else if (sorobanCfg.nInstances != 0)
                     {
                         --sorobanCfg.nInstances;
                         return createContractTransaction(ledgerNum,
                                                          sourceAccountId, cfg);
                     }
+                    else
+                    {
+                        return createNativeAssetContractTransaction(
+                            ledgerNum, sourceAccountId, cfg);
+                    }
                 };
                 break;
             case LoadGenMode::SOROBAN_INVOKE:
@@ -779,6 +867,12 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
                         ledgerNum, sourceAccountId, cfg);
                 };
                 break;
+            case LoadGenMode::MIXED_SOROBAN:
+                generateTx = [&]() {
+                    return createMixedSorobanTransaction(ledgerNum,
+                                                         sourceAccountId, cfg);
+                };
+                break;
             }
 
             if (submitTx(cfg, generateTx))
@@ -812,6 +906,136 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
     scheduleLoadGeneration(cfg);
 }
 
+void
+LoadGenerator::generateOpenLoopLoad(GeneratedLoadConfig cfg)
+{
+    ZoneScoped;
+    auto& m = mApp.getMetrics();
+    auto& submitTimer = m.NewTimer({"loadgen", "step", "submit"});
+    auto submitScope = submitTimer.TimeScope();
+
+    uint64_t now = mApp.timeNow();
+    if (now != mLastSecond)
+    {
+        cleanupAccounts();
+    }
+
+    // Arrivals of a Poisson process at txRate during one step
+    std::poisson_distribution<uint32_t> arrivalDist(
+        static_cast<double>(cfg.txRate) * STEP_MSECS / 1000);
+    auto arrivals = std::min<uint32_t>(arrivalDist(gRandomEngine), cfg.nTxs);
+
+    auto& latency = m.NewTimer({"loadgen", "submit", "latency"});
+    for (uint32_t i = 0; i < arrivals; ++i)
+    {
+        if (mOpenLoopSigned.empty())
+        {
+            // Signing does not keep up with the rate, or there are not
+            // enough accounts; these arrivals are lost
+            m.NewMeter({"loadgen", "submit", "starved"}, "txn")
+                .Mark(arrivals - i);
+            break;
+        }
+        auto next = std::move(mOpenLoopSigned.front());
+        mOpenLoopSigned.pop_front();
+        mOpenLoopAccounts.erase(next.mAccountId);
+
+        TransactionResultCode code = txSUCCESS;
+        TransactionQueue::AddResult status;
+        {
+            auto latencyScope = latency.TimeScope();
+            status = execute(next.mTx, cfg.mode, code, /* logRejected */ false);
+        }
+        m.NewMeter({"loadgen", "submit",
+                    toMetricName(TX_STATUS_STRING[static_cast<int>(status)])},
+                   "txn")
+            .Mark();
+        if (status == TransactionQueue::AddResult::ADD_STATUS_ERROR)
+        {
+            m.NewMeter({"loadgen", "submit-error",
+                        toMetricName(xdr::xdr_traits<TransactionResultCode>::
+                                         enum_name(code))},
+                       "txn")
+                .Mark();
+            maybeHandleFailedTx(next.mTx, next.mFrom, status, code);
+        }
+        --cfg.nTxs;
+    }
+
+    uint32_t ledgerNum = mApp.getLedgerManager().getLastClosedLedgerNum() + 1;
+    signOpenLoopTxs(cfg, ledgerNum);
+
+    auto submit = submitScope.Stop();
+    if (now != mLastSecond)
+    {
+        logProgress(submit, cfg);
+    }
+    mLastSecond = now;
+    scheduleLoadGeneration(cfg);
+}
+
+void
+LoadGenerator::signOpenLoopTxs(GeneratedLoadConfig const& cfg,
+                               uint32_t ledgerNum)
+{
+    ZoneScoped;
+    // About a second of load is kept signed or being signed ahead of
+    // submission
+    size_t target =
+        std::min<size_t>(std::max(cfg.txRate, OPEN_LOOP_SIGN_BATCH_SIZE),
+                         cfg.nTxs);
+    while (mOpenLoopSigned.size() + mOpenLoopSigning < target &&
+           !mAccountsAvailable.empty())
+    {
+        auto batch = std::make_shared<std::vector<OpenLoopTx>>();
+        mDeferSigning = true;
+        while (batch->size() < OPEN_LOOP_SIGN_BATCH_SIZE &&
+               mOpenLoopSigned.size() + mOpenLoopSigning + batch->size() <
+                   target &&
+               !mAccountsAvailable.empty())
+        {
+            auto accountId = getNextAvailableAccount();
+            auto [from, tx] =
+                cfg.mode == LoadGenMode::PAY
+                    ? paymentTransaction(cfg.nAccounts, cfg.offset, ledgerNum,
+                                         accountId, 1, cfg.maxGeneratedFeeRate)
+                    : pretendTransaction(cfg.nAccounts, cfg.offset, ledgerNum,
+                                         accountId,
+                                         chooseOpCount(mApp.getConfig()),
+                                         cfg.maxGeneratedFeeRate);
+            mOpenLoopAccounts.insert(accountId);
+            batch->emplace_back(OpenLoopTx{accountId, from, tx});
+        }
+        mDeferSigning = false;
+
+        mOpenLoopSigning += batch->size();
+        std::weak_ptr<bool> token = mOpenLoopToken;
+        mApp.postOnBackgroundThread(
+            [this, batch, token]() {
+                // Each transaction and its source account's secret key are
+                // only used by this job until it posts them back
+                for (auto& t : *batch)
+                {
+                    t.mTx->addSignature(t.mFrom->getSecretKey());
+                }
+                mApp.postOnMainThread(
+                    [this, batch, token]() {
+                        if (!token.lock())
+                        {
+                            return;
+                        }
+                        mOpenLoopSigning -= batch->size();
+                        for (auto& t : *batch)
+                        {
+                            mOpenLoopSigned.emplace_back(std::move(t));
+                        }
+                    },
+                    "LoadGenerator: signed open-loop txs");
+            },
+            "LoadGenerator: sign open-loop txs");
+    }
+}
+
 uint32_t
 LoadGenerator::submitCreationTx(uint32_t nAccounts, uint32_t offset,
                                 uint32_t ledgerNum)
@@ -1254,6 +1478,43 @@ LoadGenerator::createContractTransaction(uint32_t ledgerNum, uint64_t accountId,
     return std::make_pair(account, tx);
 }
 
+std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+LoadGenerator::createNativeAssetContractTransaction(
+    uint32_t ledgerNum, uint64_t accountId, GeneratedLoadConfig const& cfg)
+{
+    releaseAssert(cfg.modeSetsUpInvoke());
+
+    auto account = findAccount(accountId, ledgerNum);
+    SorobanResources createResources{};
+    createResources.instructions = 400'000;
+    createResources.readBytes = 1000;
+    createResources.writeBytes = 1000;
+
+    auto native = makeNativeAsset();
+    auto tx =
+        std::dynamic_pointer_cast<TransactionFrame>(makeSorobanCreateContractTx(
+            mApp, *account, makeContractIDPreimage(native),
+            makeAssetExecutable(native), createResources,
+            generateFee(cfg.maxGeneratedFeeRate, mApp,
+                        /* opsCnt */ 1)));
+    return std::make_pair(account, tx);
+}
+
+LedgerKey
+LoadGenerator::nativeAssetContractKey() const
+{
+    auto contractID = xdrSha256(makeFullContractIdPreimage(
+        mApp.getNetworkID(), makeContractIDPreimage(makeNativeAsset())));
+    return makeContractInstanceKey(makeContractAddress(contractID));
+}
+
+bool
+LoadGenerator::nativeAssetContractDeployed()
+{
+    LedgerTxn ltx(mApp.getLedgerTxnRoot());
+    return static_cast<bool>(ltx.loadWithoutRecord(nativeAssetContractKey()));
+}
+
 std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
 LoadGenerator::invokeSorobanLoadTransaction(uint32_t ledgerNum,
                                             uint64_t accountId,
@@ -1340,19 +1601,9 @@ LoadGenerator::invokeSorobanLoadTransaction(uint32_t ledgerNum,
         }
     }
 
-    auto guestCyclesU64 = makeU64(guestCycles);
-    auto hostCyclesU64 = makeU64(hostCycles);
-    auto numEntriesU32 = makeU32(numEntries);
-    auto kiloBytesPerEntryU32 = makeU32(kiloBytesPerEntry);
-
-    Operation op;
-    op.body.type(INVOKE_HOST_FUNCTION);
-    auto& ihf = op.body.invokeHostFunctionOp().hostFunction;
-    ihf.type(HOST_FUNCTION_TYPE_INVOKE_CONTRACT);
-    ihf.invokeContract().contractAddress = instance.contractID;
-    ihf.invokeContract().functionName = "do_work";
-    ihf.invokeContract().args = {guestCyclesU64, hostCyclesU64, numEntriesU32,
-                                 kiloBytesPerEntryU32};
+    auto op = makeDoWorkOp(instance.contractID, guestCycles, hostCycles,
+                           numEntries, kiloBytesPerEntry);
+    recordDataWrites(instance, numEntries, kiloBytesPerEntry);
 
     // baseInstructionCount is a very rough estimate and may be a significant
     // underestimation based on the IO load used, so use max instructions
@@ -1786,6 +2037,289 @@ LoadGenerator::createMixedClassicSorobanTransaction(
     }
 }
 
+std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+LoadGenerator::createMixedSorobanTransaction(uint32_t ledgerNum,
+                                             uint64_t sourceAccountId,
+                                             GeneratedLoadConfig const& cfg)
+{
+    auto const& mixCfg = cfg.getMixSorobanConfig();
+    std::discrete_distribution<uint32_t> dist(
+        {mixCfg.sacTransferWeight, mixCfg.storageWeight, mixCfg.readWeight,
+         mixCfg.ttlWeight});
+    switch (dist(gRandomEngine))
+    {
+    case 0:
+        mLastSorobanMixKind = SorobanMixKind::SAC_TRANSFER;
+        return sacTransferTransaction(ledgerNum, sourceAccountId, cfg);
+    case 1:
+        mLastSorobanMixKind = SorobanMixKind::STORAGE;
+        return storageHeavyTransaction(ledgerNum, sourceAccountId, cfg);
+    case 2:
+        mLastSorobanMixKind = SorobanMixKind::READ;
+        return readHeavyTransaction(ledgerNum, sourceAccountId, cfg);
+    case 3:
+        mLastSorobanMixKind = SorobanMixKind::TTL;
+        return ttlTransaction(ledgerNum, sourceAccountId, cfg);
+    default:
+        releaseAssert(false);
+    }
+}
+
+std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+LoadGenerator::sacTransferTransaction(uint32_t ledgerNum, uint64_t accountId,
+                                      GeneratedLoadConfig const& cfg)
+{
+    auto [from, to] =
+        pickAccountPair(cfg.nAccounts, cfg.offset, ledgerNum, accountId);
+    // A transfer to the source itself would repeat its key in the footprint
+    if (from == to)
+    {
+        to = mRoot;
+    }
+
+    SCVal fromVal(SCV_ADDRESS);
+    fromVal.address() = makeAccountAddress(from->getPublicKey());
+    SCVal toVal(SCV_ADDRESS);
+    toVal.address() = makeAccountAddress(to->getPublicKey());
+
+    auto sacKey = nativeAssetContractKey();
+    Operation op;
+    op.body.type(INVOKE_HOST_FUNCTION);
+    auto& ihf = op.body.invokeHostFunctionOp().hostFunction;
+    ihf.type(HOST_FUNCTION_TYPE_INVOKE_CONTRACT);
+    ihf.invokeContract().contractAddress = sacKey.contractData().contract;
+    ihf.invokeContract().functionName = "transfer";
+    ihf.invokeContract().args = {fromVal, toVal,
+                                 makeI128(rand_uniform<uint64_t>(1, 1000))};
+
+    // The source account authorizes the transfer of its own balance
+    SorobanAuthorizationEntry auth;
+    auth.credentials.type(SOROBAN_CREDENTIALS_SOURCE_ACCOUNT);
+    auth.rootInvocation.function.type(
+        SOROBAN_AUTHORIZED_FUNCTION_TYPE_CONTRACT_FN);
+    auth.rootInvocation.function.contractFn() = ihf.invokeContract();
+    op.body.invokeHostFunctionOp().auth = {auth};
+
+    // Native balances are in the account entries
+    SorobanResources resources;
+    resources.footprint.readOnly = {sacKey};
+    resources.footprint.readWrite = {accountKey(from->getPublicKey()),
+                                     accountKey(to->getPublicKey())};
+    resources.instructions = 3'000'000;
+    resources.readBytes = 2000;
+    resources.writeBytes = 2000;
+
+    auto resourceFee = sorobanResourceFee(mApp, resources, 1000, 400);
+    resourceFee += 1'000'000;
+
+    auto tx = std::dynamic_pointer_cast<TransactionFrame>(
+        sorobanTransactionFrameFromOps(
+            mApp.getNetworkID(), *from, {op}, {}, resources,
+            generateFee(cfg.maxGeneratedFeeRate, mApp,
+                        /* opsCnt */ 1),
+            resourceFee));
+    return std::make_pair(from, tx);
+}
+
+std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+LoadGenerator::storageHeavyTransaction(uint32_t ledgerNum, uint64_t accountId,
+                                       GeneratedLoadConfig const& cfg)
+{
+    auto const& appCfg = mApp.getConfig();
+    auto const& networkCfg = mApp.getLedgerManager().getSorobanNetworkConfig();
+
+    auto account = findAccount(accountId, ledgerNum);
+    auto const& instance = mContractInstances.at(accountId);
+
+    // Same distributions as SOROBAN_INVOKE, but without guest and host cycles
+    // the whole transaction goes to writing persistent entries
+    uint32_t numEntries = std::clamp<uint32_t>(
+        sampleDiscrete(appCfg.LOADGEN_NUM_DATA_ENTRIES_FOR_TESTING,
+                       appCfg.LOADGEN_NUM_DATA_ENTRIES_DISTRIBUTION_FOR_TESTING,
+                       DEFAULT_NUM_DATA_ENTRIES),
+        1, networkCfg.txMaxWriteLedgerEntries());
+    uint32_t totalKiloBytes = std::min<uint32_t>(
+        sampleDiscrete(appCfg.LOADGEN_IO_KILOBYTES_FOR_TESTING,
+                       appCfg.LOADGEN_IO_KILOBYTES_DISTRIBUTION_FOR_TESTING,
+                       DEFAULT_IO_KILOBYTES),
+        networkCfg.txMaxWriteBytes() / 1024);
+    uint32_t kiloBytesPerEntry =
+        std::max<uint32_t>(totalKiloBytes / numEntries, 1);
+
+    SorobanResources resources;
+    resources.footprint.readOnly = instance.readOnlyKeys;
+    for (uint32_t i = 0; i < numEntries; ++i)
+    {
+        resources.footprint.readWrite.emplace_back(
+            contractDataKey(instance.contractID, makeU32(i),
+                            ContractDataDurability::PERSISTENT));
+    }
+
+    // Overwritten entries are read first, and earlier invocations may have
+    // written them larger
+    auto writtenBytes = getWrittenData(accountId, numEntries).second;
+    uint32_t writeBytes =
+        numEntries * (kiloBytesPerEntry * 1024 + DATA_ENTRY_OVERHEAD_BYTES);
+    resources.readBytes =
+        std::min<uint32_t>(networkCfg.txMaxReadBytes(),
+                           mContactOverheadBytes + writtenBytes + writeBytes);
+    resources.writeBytes = std::min(networkCfg.txMaxWriteBytes(), writeBytes);
+    // Rough estimate of instantiating the contract plus serializing the
+    // entries
+    resources.instructions =
+        std::min<int64_t>(networkCfg.txMaxInstructions(),
+                          3'000'000 + 100 * static_cast<int64_t>(writeBytes));
+
+    auto op = makeDoWorkOp(instance.contractID, 0, 0, numEntries,
+                           kiloBytesPerEntry);
+    recordDataWrites(instance, numEntries, kiloBytesPerEntry);
+
+    auto resourceFee = sorobanResourceFee(
+        mApp, resources, 300 + xdr::xdr_size(resources), 40);
+    resourceFee += 1'000'000;
+
+    auto tx = std::dynamic_pointer_cast<TransactionFrame>(
+        sorobanTransactionFrameFromOps(
+            mApp.getNetworkID(), *account, {op}, {}, resources,
+            generateFee(cfg.maxGeneratedFeeRate, mApp,
+                        /* opsCnt */ 1),
+            resourceFee));
+    return std::make_pair(account, tx);
+}
+
+std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+LoadGenerator::readHeavyTransaction(uint32_t ledgerNum, uint64_t accountId,
+                                    GeneratedLoadConfig const& cfg)
+{
+    auto const& networkCfg = mApp.getLedgerManager().getSorobanNetworkConfig();
+
+    auto account = findAccount(accountId, ledgerNum);
+    auto const& instance = mContractInstances.at(accountId);
+
+    // Everything written to the instance so far goes in the read-only
+    // footprint, next to the contract code and instance
+    auto [keys, keysBytes] = getWrittenData(
+        accountId, networkCfg.txMaxReadLedgerEntries() -
+                       static_cast<uint32_t>(instance.readOnlyKeys.size()));
+    SorobanResources resources;
+    resources.footprint.readOnly = instance.readOnlyKeys;
+    resources.footprint.readOnly.insert(resources.footprint.readOnly.end(),
+                                        keys.begin(), keys.end());
+    resources.readBytes = std::min<uint32_t>(
+        networkCfg.txMaxReadBytes(), mContactOverheadBytes + keysBytes);
+    resources.writeBytes = 0;
+    // Rough estimate of instantiating the contract plus deserializing the
+    // entries
+    resources.instructions = std::min<int64_t>(
+        networkCfg.txMaxInstructions(),
+        3'000'000 + 100 * static_cast<int64_t>(resources.readBytes));
+
+    auto op = makeDoWorkOp(instance.contractID, 0, 0, 0, 0);
+
+    auto resourceFee = sorobanResourceFee(
+        mApp, resources, 300 + xdr::xdr_size(resources), 40);
+    resourceFee += 1'000'000;
+
+    auto tx = std::dynamic_pointer_cast<TransactionFrame>(
+        sorobanTransactionFrameFromOps(
+            mApp.getNetworkID(), *account, {op}, {}, resources,
+            generateFee(cfg.maxGeneratedFeeRate, mApp,
+                        /* opsCnt */ 1),
+            resourceFee));
+    return std::make_pair(account, tx);
+}
+
+std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+LoadGenerator::ttlTransaction(uint32_t ledgerNum, uint64_t accountId,
+                              GeneratedLoadConfig const& cfg)
+{
+    auto const& networkCfg = mApp.getLedgerManager().getSorobanNetworkConfig();
+
+    auto account = findAccount(accountId, ledgerNum);
+    auto const& instance = mContractInstances.at(accountId);
+
+    Operation op;
+    SorobanResources resources;
+    auto [restoreKeys, restoreBytes] =
+        getWrittenData(accountId, networkCfg.txMaxWriteLedgerEntries());
+    // Only persistent contract data written by earlier invocations can have
+    // been archived since
+    if (!restoreKeys.empty() && rand_flip())
+    {
+        op.body.type(RESTORE_FOOTPRINT);
+        resources.footprint.readWrite = restoreKeys;
+        resources.readBytes =
+            std::min(networkCfg.txMaxReadBytes(), restoreBytes);
+        resources.writeBytes =
+            std::min(networkCfg.txMaxWriteBytes(), restoreBytes);
+    }
+    else
+    {
+        // Extend the contract code and instance along with their data
+        auto const& archivalSettings = networkCfg.stateArchivalSettings();
+        uint32_t maxExtendTo = archivalSettings.maxEntryTTL - 1;
+        uint32_t minExtendTo =
+            std::min(archivalSettings.minPersistentTTL, maxExtendTo);
+        op.body.type(EXTEND_FOOTPRINT_TTL);
+        op.body.extendFootprintTTLOp().extendTo = rand_uniform<uint32_t>(
+            minExtendTo, std::min(maxExtendTo, 2 * minExtendTo));
+
+        auto [keys, keysBytes] = getWrittenData(
+            accountId, networkCfg.txMaxReadLedgerEntries() -
+                           static_cast<uint32_t>(instance.readOnlyKeys.size()));
+        resources.footprint.readOnly = instance.readOnlyKeys;
+        resources.footprint.readOnly.insert(resources.footprint.readOnly.end(),
+                                            keys.begin(), keys.end());
+        resources.readBytes = std::min<uint32_t>(
+            networkCfg.txMaxReadBytes(), mContactOverheadBytes + keysBytes);
+    }
+
+    auto resourceFee = sorobanResourceFee(
+        mApp, resources, 300 + xdr::xdr_size(resources), 0);
+    // Roughly cover the rent fee.
+    resourceFee += 10'000'000;
+
+    auto tx = std::dynamic_pointer_cast<TransactionFrame>(
+        sorobanTransactionFrameFromOps(
+            mApp.getNetworkID(), *account, {op}, {}, resources,
+            generateFee(cfg.maxGeneratedFeeRate, mApp,
+                        /* opsCnt */ 1),
+            resourceFee));
+    return std::make_pair(account, tx);
+}
+
+void
+LoadGenerator::recordDataWrites(ContractInstance const& instance,
+                                uint32_t numEntries, uint32_t kiloBytesPerEntry)
+{
+    // readOnlyKeys are [wasm, instance]
+    auto& written = mWrittenData[instance.readOnlyKeys.back()];
+    written.mNumEntries = std::max(written.mNumEntries, numEntries);
+    written.mMaxEntryBytes =
+        std::max(written.mMaxEntryBytes,
+                 kiloBytesPerEntry * 1024 + DATA_ENTRY_OVERHEAD_BYTES);
+}
+
+std::pair<xdr::xvector<LedgerKey>, uint32_t>
+LoadGenerator::getWrittenData(uint64_t accountId, uint32_t maxEntries) const
+{
+    auto const& instance = mContractInstances.at(accountId);
+    auto it = mWrittenData.find(instance.readOnlyKeys.back());
+    if (it == mWrittenData.end())
+    {
+        return {};
+    }
+
+    auto numEntries = std::min(it->second.mNumEntries, maxEntries);
+    xdr::xvector<LedgerKey> keys;
+    for (uint32_t i = 0; i < numEntries; ++i)
+    {
+        keys.emplace_back(contractDataKey(instance.contractID, makeU32(i),
+                                          ContractDataDurability::PERSISTENT));
+    }
+    return std::make_pair(keys, numEntries * it->second.mMaxEntryBytes);
+}
+
 void
 LoadGenerator::maybeHandleFailedTx(TransactionFramePtr tx,
                                    TestAccountPtr sourceAccount,
@@ -1842,6 +2376,16 @@ LoadGenerator::checkSorobanStateSynced(Application& app,
         result.emplace_back(*mCodeKey);
     }
 
+    // The native asset contract is deployed after all the instances
+    if (cfg.modeSetsUpInvoke() && cfg.getSorobanConfig().nInstances == 0)
+    {
+        auto sacKey = nativeAssetContractKey();
+        if (!ltx.loadWithoutRecord(sacKey))
+        {
+            result.emplace_back(sacKey);
+        }
+    }
+
     return result;
 }
 
@@ -1971,8 +2515,13 @@ LoadGenerator::waitTillComplete(GeneratedLoadConfig cfg)
         // All Wasms should be deployed
         releaseAssert(cfg.getSorobanConfig().nWasms == 0);
 
-        // 1 deploy TX per instance
+        // 1 deploy TX per instance, plus one for the native asset contract
+        // used by MIXED_SOROBAN unless an earlier setup deployed it
         cfg.nTxs = cfg.getSorobanConfig().nInstances;
+        if (cfg.modeSetsUpInvoke() && !nativeAssetContractDeployed())
+        {
+            ++cfg.nTxs;
+        }
         scheduleLoadGeneration(cfg);
     }
 }
@@ -2030,6 +2579,11 @@ LoadGenerator::TxMetrics::TxMetrics(medida::MetricsRegistry& m)
     , mSorobanInvokeTxs(m.NewMeter({"loadgen", "soroban", "invoke"}, "txn"))
     , mSorobanCreateUpgradeTxs(
           m.NewMeter({"loadgen", "soroban", "create_upgrade"}, "txn"))
+    , mSorobanSACTransferTxs(
+          m.NewMeter({"loadgen", "soroban", "sac_transfer"}, "txn"))
+    , mSorobanStorageTxs(m.NewMeter({"loadgen", "soroban", "storage"}, "txn"))
+    , mSorobanReadTxs(m.NewMeter({"loadgen", "soroban", "read"}, "txn"))
+    , mSorobanTTLTxs(m.NewMeter({"loadgen", "soroban", "ttl"}, "txn"))
     , mTxnAttempted(m.NewMeter({"loadgen", "txn", "attempted"}, "txn"))
     , mTxnRejected(m.NewMeter({"loadgen", "txn", "rejected"}, "txn"))
     , mTxnBytes(m.NewMeter({"loadgen", "txn", "bytes"}, "txn"))
@@ -2041,17 +2595,21 @@ LoadGenerator::TxMetrics::report()
 {
     CLOG_DEBUG(LoadGen,
                "Counts: {} tx, {} rj, {} by, {} ac, {} na, {} pr, {} dex, {} "
-               "su, {} ssi, {} ssu, {} si, {} scu",
+               "su, {} ssi, {} ssu, {} si, {} scu, {} sac, {} sst, {} srd, {} "
+               "sttl",
                mTxnAttempted.count(), mTxnRejected.count(), mTxnBytes.count(),
                mAccountCreated.count(), mNativePayment.count(),
                mPretendOps.count(), mManageOfferOps.count(),
                mSorobanUploadTxs.count(), mSorobanSetupInvokeTxs.count(),
                mSorobanSetupUpgradeTxs.count(), mSorobanInvokeTxs.count(),
-               mSorobanCreateUpgradeTxs.count());
+               mSorobanCreateUpgradeTxs.count(),
+               mSorobanSACTransferTxs.count(), mSorobanStorageTxs.count(),
+               mSorobanReadTxs.count(), mSorobanTTLTxs.count());
 
     CLOG_DEBUG(LoadGen,
                "Rates/sec (1m EWMA): {} tx, {} rj, {} by, {} ac, {} na, {} pr, "
-               "{} dex, {} su, {} ssi, {} ssu, {} si, {} scu",
+               "{} dex, {} su, {} ssi, {} ssu, {} si, {} scu, {} sac, {} sst, "
+               "{} srd, {} sttl",
                mTxnAttempted.one_minute_rate(), mTxnRejected.one_minute_rate(),
                mTxnBytes.one_minute_rate(), mAccountCreated.one_minute_rate(),
                mNativePayment.one_minute_rate(), mPretendOps.one_minute_rate(),
@@ -2060,7 +2618,11 @@ LoadGenerator::TxMetrics::report()
                mSorobanSetupInvokeTxs.one_minute_rate(),
                mSorobanSetupUpgradeTxs.one_minute_rate(),
                mSorobanInvokeTxs.one_minute_rate(),
-               mSorobanCreateUpgradeTxs.one_minute_rate());
+               mSorobanCreateUpgradeTxs.one_minute_rate(),
+               mSorobanSACTransferTxs.one_minute_rate(),
+               mSorobanStorageTxs.one_minute_rate(),
+               mSorobanReadTxs.one_minute_rate(),
+               mSorobanTTLTxs.one_minute_rate());
 }
 
 TransactionFramePtr
@@ -2069,8 +2631,8 @@ LoadGenerator::createTransactionFramePtr(
     std::optional<uint32_t> maxGeneratedFeeRate)
 {
 
-    auto txf = transactionFromOperations(
-        mApp, from->getSecretKey(), from->nextSequenceNumber(), ops,
+    auto txf = unsignedTransactionFromOperations(
+        mApp, from->getPublicKey(), from->nextSequenceNumber(), ops,
         generateFee(maxGeneratedFeeRate, mApp, ops.size()));
     if (mode == LoadGenMode::PRETEND)
     {
@@ -2082,14 +2644,16 @@ LoadGenerator::createTransactionFramePtr(
         txbridge::setMaxTime(txf, UINT64_MAX);
     }
 
-    txbridge::getSignatures(txf).clear();
-    txf->addSignature(from->getSecretKey());
+    if (!mDeferSigning)
+    {
+        txf->addSignature(from->getSecretKey());
+    }
     return txf;
 }
 
 TransactionQueue::AddResult
 LoadGenerator::execute(TransactionFramePtr& txf, LoadGenMode mode,
-                       TransactionResultCode& code)
+                       TransactionResultCode& code, bool logRejected)
 {
     TxMetrics txm(mApp.getMetrics());
 
@@ -2146,6 +2710,23 @@ LoadGenerator::execute(TransactionFramePtr& txf, LoadGenMode mode,
             releaseAssert(false);
         }
         break;
+    case LoadGenMode::MIXED_SOROBAN:
+        switch (mLastSorobanMixKind)
+        {
+        case SorobanMixKind::SAC_TRANSFER:
+            txm.mSorobanSACTransferTxs.Mark();
+            break;
+        case SorobanMixKind::STORAGE:
+            txm.mSorobanStorageTxs.Mark();
+            break;
+        case SorobanMixKind::READ:
+            txm.mSorobanReadTxs.Mark();
+            break;
+        case SorobanMixKind::TTL:
+            txm.mSorobanTTLTxs.Mark();
+            break;
+        }
+        break;
     }
 
     txm.mTxnAttempted.Mark();
@@ -2156,12 +2737,16 @@ LoadGenerator::execute(TransactionFramePtr& txf, LoadGenMode mode,
     auto status = mApp.getHerder().recvTransaction(txf, true);
     if (status != TransactionQueue::AddResult::ADD_STATUS_PENDING)
     {
-        CLOG_INFO(LoadGen, "tx rejected '{}': ===> {}, {}",
-                  TX_STATUS_STRING[static_cast<int>(status)],
-                  txf->isSoroban() ? "soroban"
-                                   : xdrToCerealString(txf->getEnvelope(),
-                                                       "TransactionEnvelope"),
-                  xdrToCerealString(txf->getResult(), "TransactionResult"));
+        if (logRejected)
+        {
+            CLOG_INFO(
+                LoadGen, "tx rejected '{}': ===> {}, {}",
+                TX_STATUS_STRING[static_cast<int>(status)],
+                txf->isSoroban() ? "soroban"
+                                 : xdrToCerealString(txf->getEnvelope(),
+                                                     "TransactionEnvelope"),
+                xdrToCerealString(txf->getResult(), "TransactionResult"));
+        }
         if (status == TransactionQueue::AddResult::ADD_STATUS_ERROR)
         {
             code = txf->getResultCode();
@@ -2267,6 +2852,20 @@ GeneratedLoadConfig::getMixClassicSorobanConfig() const
     return mixClassicSorobanConfig;
 }
 
+GeneratedLoadConfig::MixSorobanConfig&
+GeneratedLoadConfig::getMutMixSorobanConfig()
+{
+    releaseAssert(mode == LoadGenMode::MIXED_SOROBAN);
+    return mixSorobanConfig;
+}
+
+GeneratedLoadConfig::MixSorobanConfig const&
+GeneratedLoadConfig::getMixSorobanConfig() const
+{
+    releaseAssert(mode == LoadGenMode::MIXED_SOROBAN);
+    return mixSorobanConfig;
+}
+
 uint32_t&
 GeneratedLoadConfig::getMutDexTxPercent()
 {
@@ -2313,7 +2912,8 @@ GeneratedLoadConfig::isSoroban() const
            mode == LoadGenMode::SOROBAN_UPLOAD ||
            mode == LoadGenMode::SOROBAN_UPGRADE_SETUP ||
            mode == LoadGenMode::SOROBAN_CREATE_UPGRADE ||
-           mode == LoadGenMode::MIXED_CLASSIC_SOROBAN;
+           mode == LoadGenMode::MIXED_CLASSIC_SOROBAN ||
+           mode == LoadGenMode::MIXED_SOROBAN;
 }
 
 bool
@@ -2331,14 +2931,16 @@ GeneratedLoadConfig::isLoad() const
            mode == LoadGenMode::SOROBAN_UPLOAD ||
            mode == LoadGenMode::SOROBAN_INVOKE ||
            mode == LoadGenMode::SOROBAN_CREATE_UPGRADE ||
-           mode == LoadGenMode::MIXED_CLASSIC_SOROBAN;
+           mode == LoadGenMode::MIXED_CLASSIC_SOROBAN ||
+           mode == LoadGenMode::MIXED_SOROBAN;
 }
 
 bool
 GeneratedLoadConfig::modeInvokes() const
 {
     return mode == LoadGenMode::SOROBAN_INVOKE ||
-           mode == LoadGenMode::MIXED_CLASSIC_SOROBAN;
+           mode == LoadGenMode::MIXED_CLASSIC_SOROBAN ||
+           mode == LoadGenMode::MIXED_SOROBAN;
 }
 
 bool
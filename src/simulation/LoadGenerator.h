@@ -10,6 +10,7 @@
 #include "test/TestAccount.h"
 #include "test/TxTests.h"
 #include "xdr/Stellar-types.h"
+#include <deque>
 #include <vector>
 
 namespace medida
@@ -44,13 +45,17 @@ enum class LoadGenMode
     // Create upgrade entry
     SOROBAN_CREATE_UPGRADE,
     // Blend classic and soroban transactions. Mix of pay, upload, and invoke.
-    MIXED_CLASSIC_SOROBAN
+    MIXED_CLASSIC_SOROBAN,
+    // Mix of SAC transfers, storage-heavy and read-heavy invocations and TTL
+    // extensions or restores, must run SOROBAN_INVOKE_SETUP first
+    MIXED_SOROBAN
 };
 
 struct GeneratedLoadConfig
 {
     // Config parameters for SOROBAN_INVOKE_SETUP, SOROBAN_INVOKE,
-    // SOROBAN_UPGRADE_SETUP, SOROBAN_CREATE_UPGRADE, and MIXED_CLASSIC_SOROBAN
+    // SOROBAN_UPGRADE_SETUP, SOROBAN_CREATE_UPGRADE, MIXED_CLASSIC_SOROBAN and
+    // MIXED_SOROBAN
     struct SorobanConfig
     {
         uint32_t nInstances = 0;
@@ -107,6 +112,21 @@ struct GeneratedLoadConfig
         double sorobanInvokeWeight = 0;
     };
 
+    // Config settings for MIXED_SOROBAN
+    struct MixSorobanConfig
+    {
+        // Weights determining the distribution of:
+        // - native asset contract (SAC) transfers between the accounts;
+        // - invocations writing all of their IO budget to persistent contract
+        //   data, with little compute;
+        // - invocations only reading contract data written earlier;
+        // - TTL extensions and restores of that contract data.
+        double sacTransferWeight = 0;
+        double storageWeight = 0;
+        double readWeight = 0;
+        double ttlWeight = 0;
+    };
+
     static GeneratedLoadConfig createAccountsLoad(uint32_t nAccounts,
                                                   uint32_t txRate);
 
@@ -126,6 +146,8 @@ struct GeneratedLoadConfig
     SorobanUpgradeConfig const& getSorobanUpgradeConfig() const;
     MixClassicSorobanConfig& getMutMixClassicSorobanConfig();
     MixClassicSorobanConfig const& getMixClassicSorobanConfig() const;
+    MixSorobanConfig& getMutMixSorobanConfig();
+    MixSorobanConfig const& getMixSorobanConfig() const;
     uint32_t& getMutDexTxPercent();
     uint32_t const& getDexTxPercent() const;
     uint32_t getMinSorobanPercentSuccess() const;
@@ -170,11 +192,18 @@ struct GeneratedLoadConfig
     // the load generation will fail after a couple of retries.
     // Does not affect account creation.
     bool skipLowFeeTxs = false;
+    // When true (PAY and PRETEND only), transactions are built ahead of time,
+    // signed on background threads and submitted at txRate with Poisson
+    // arrivals whatever happened to earlier ones: rejections are counted in
+    // the loadgen.submit metrics instead of being retried or failing the run.
+    // Meant for finding the rate at which the node saturates.
+    bool openLoop = false;
 
   private:
     SorobanConfig sorobanConfig;
     SorobanUpgradeConfig sorobanUpgradeConfig;
     MixClassicSorobanConfig mixClassicSorobanConfig;
+    MixSorobanConfig mixSorobanConfig;
 
     // Percentage (from 0 to 100) of DEX transactions
     uint32_t dexTxPercent = 0;
@@ -258,6 +287,10 @@ class LoadGenerator
         medida::Meter& mSorobanSetupUpgradeTxs;
         medida::Meter& mSorobanInvokeTxs;
         medida::Meter& mSorobanCreateUpgradeTxs;
+        medida::Meter& mSorobanSACTransferTxs;
+        medida::Meter& mSorobanStorageTxs;
+        medida::Meter& mSorobanReadTxs;
+        medida::Meter& mSorobanTTLTxs;
         medida::Meter& mTxnAttempted;
         medida::Meter& mTxnRejected;
         medida::Meter& mTxnBytes;
@@ -278,7 +311,8 @@ class LoadGenerator
     // sufficient balances etc.
     TransactionQueue::AddResult execute(TransactionFramePtr& txf,
                                         LoadGenMode mode,
-                                        TransactionResultCode& code);
+                                        TransactionResultCode& code,
+                                        bool logRejected = true);
     TransactionFramePtr
     createTransactionFramePtr(TestAccountPtr from, std::vector<Operation> ops,
                               LoadGenMode mode,
@@ -289,6 +323,7 @@ class LoadGenerator
     static const uint32_t TIMEOUT_NUM_LEDGERS;
     static const uint32_t COMPLETION_TIMEOUT_WITHOUT_CHECKS;
     static const uint32_t MIN_UNIQUE_ACCOUNT_MULTIPLIER;
+    static const uint32_t OPEN_LOOP_SIGN_BATCH_SIZE;
 
     std::unique_ptr<VirtualTimer> mLoadTimer;
     int64 mMinBalance;
@@ -313,6 +348,24 @@ class LoadGenerator
     // collisions.
     std::unordered_map<uint64_t, TestAccountPtr> mCreationSourceAccounts;
 
+    // Open-loop transactions, signed and waiting to be submitted. Their source
+    // accounts stay in use, even though not pending in the tx queue yet.
+    struct OpenLoopTx
+    {
+        uint64_t mAccountId;
+        TestAccountPtr mFrom;
+        TransactionFramePtr mTx;
+    };
+    std::deque<OpenLoopTx> mOpenLoopSigned;
+    std::unordered_set<uint64_t> mOpenLoopAccounts;
+    // Number of transactions being signed on background threads
+    size_t mOpenLoopSigning{0};
+    // Replaced on reset, so that transactions signed for an earlier run are
+    // dropped
+    std::shared_ptr<bool> mOpenLoopToken{std::make_shared<bool>()};
+    // Set while building transactions that are signed later
+    bool mDeferSigning{false};
+
     medida::Meter& mLoadgenComplete;
     medida::Meter& mLoadgenFail;
 
@@ -339,6 +392,15 @@ class LoadGenerator
     inline static UnorderedSet<LedgerKey> mContractInstanceKeys = {};
     inline static std::optional<LedgerKey> mCodeKey = std::nullopt;
     inline static uint64_t mContactOverheadBytes = 0;
+    // Data entries that invocations wrote to a contract instance: keys 0 to
+    // mNumEntries - 1, of at most mMaxEntryBytes each. MIXED_SOROBAN reads,
+    // extends and restores these.
+    struct WrittenData
+    {
+        uint32_t mNumEntries{0};
+        uint32_t mMaxEntryBytes{0};
+    };
+    inline static UnorderedMap<LedgerKey, WrittenData> mWrittenData = {};
 
     // Maps account ID to it's contract instance, where each account has a
     // unique instance
@@ -347,6 +409,16 @@ class LoadGenerator
     // Mode used for last mixed transaction in MIX_CLASSIC_SOROBAN mode
     LoadGenMode mLastMixedMode;
 
+    enum class SorobanMixKind
+    {
+        SAC_TRANSFER,
+        STORAGE,
+        READ,
+        TTL
+    };
+    // Kind of the last transaction in MIXED_SOROBAN mode
+    SorobanMixKind mLastSorobanMixKind;
+
     void reset();
     void resetSorobanState();
     void createRootAccount();
@@ -394,6 +466,10 @@ class LoadGenerator
     invokeSorobanLoadTransaction(uint32_t ledgerNum, uint64_t accountId,
                                  GeneratedLoadConfig const& cfg);
     std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+    createNativeAssetContractTransaction(uint32_t ledgerNum,
+                                         uint64_t accountId,
+                                         GeneratedLoadConfig const& cfg);
+    std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
     invokeSorobanCreateUpgradeTransaction(uint32_t ledgerNum,
                                           uint64_t accountId,
                                           GeneratedLoadConfig const& cfg);
@@ -406,6 +482,30 @@ class LoadGenerator
     createMixedClassicSorobanTransaction(uint32_t ledgerNum,
                                          uint64_t sourceAccountId,
                                          GeneratedLoadConfig const& cfg);
+    // Create a transaction in MIXED_SOROBAN mode
+    std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+    createMixedSorobanTransaction(uint32_t ledgerNum, uint64_t sourceAccountId,
+                                  GeneratedLoadConfig const& cfg);
+    std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+    sacTransferTransaction(uint32_t ledgerNum, uint64_t accountId,
+                           GeneratedLoadConfig const& cfg);
+    std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+    storageHeavyTransaction(uint32_t ledgerNum, uint64_t accountId,
+                            GeneratedLoadConfig const& cfg);
+    std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+    readHeavyTransaction(uint32_t ledgerNum, uint64_t accountId,
+                         GeneratedLoadConfig const& cfg);
+    std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>
+    ttlTransaction(uint32_t ledgerNum, uint64_t accountId,
+                   GeneratedLoadConfig const& cfg);
+    void recordDataWrites(ContractInstance const& instance,
+                          uint32_t numEntries, uint32_t kiloBytesPerEntry);
+    // Keys of at most `maxEntries` data entries written to the instance used
+    // by `accountId`, and an upper bound of their total size
+    std::pair<xdr::xvector<LedgerKey>, uint32_t>
+    getWrittenData(uint64_t accountId, uint32_t maxEntries) const;
+    LedgerKey nativeAssetContractKey() const;
+    bool nativeAssetContractDeployed();
     // Samples a random wasm size from the `LOADGEN_WASM_BYTES_FOR_TESTING`
     // distribution. Returns a pair containing the appropriate resources for a
     // wasm of that size as well as the size itself.
@@ -426,6 +526,10 @@ class LoadGenerator
                   std::function<std::pair<LoadGenerator::TestAccountPtr,
                                           TransactionFramePtr>()>
                       generateTx);
+    // Submits the open-loop arrivals of one step, then tops up the signed
+    // transactions (see GeneratedLoadConfig::openLoop)
+    void generateOpenLoopLoad(GeneratedLoadConfig cfg);
+    void signOpenLoopTxs(GeneratedLoadConfig const& cfg, uint32_t ledgerNum);
     void waitTillComplete(GeneratedLoadConfig cfg);
     void waitTillCompleteWithoutChecks();
 
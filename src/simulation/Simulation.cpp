@@ -4,6 +4,7 @@
 
 #include "Simulation.h"
 
+#include "crypto/KeyUtils.h"
 #include "herder/Herder.h"
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
@@ -12,6 +13,7 @@
 #include "scp/LocalNode.h"
 #include "test/TestUtils.h"
 #include "test/test.h"
+#include "util/Fs.h"
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/finally.h"
@@ -19,10 +21,15 @@
 
 #include <fmt/format.h>
 
+#include "lib/http/HttpClient.h"
 #include "main/ApplicationUtils.h"
 #include "medida/medida.h"
 #include "medida/reporting/console_reporter.h"
 
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <set>
 #include <thread>
 
 namespace stellar
@@ -30,9 +37,73 @@ namespace stellar
 
 using namespace std;
 
+namespace
+{
+bool
+isLocalHost(std::string const& host)
+{
+    return host == "127.0.0.1" || host == "localhost";
+}
+
+std::string
+tomlString(std::string const& s)
+{
+    std::string res = "\"";
+    for (auto c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            res += '\\';
+        }
+        res += c;
+    }
+    return res + "\"";
+}
+
+void
+writeQuorumSet(std::ostream& out, std::string const& name,
+               SCPQuorumSet const& qSet)
+{
+    // The config only takes a percentage, of which it rounds
+    // n * percent / 100 up: pick the smallest one giving the threshold
+    auto n = qSet.validators.size() + qSet.innerSets.size();
+    auto percent = 100 * (qSet.threshold - 1) / n + 1;
+    if (1 + (n * percent - 1) / 100 != qSet.threshold)
+    {
+        LOG_WARNING(DEFAULT_LOG,
+                    "Threshold {} of {} can't be set as a percentage, "
+                    "{}% is used for {}",
+                    qSet.threshold, n, percent, name);
+    }
+    out << "\n[" << name << "]\nTHRESHOLD_PERCENT=" << percent << "\n";
+    if (!qSet.validators.empty())
+    {
+        out << "VALIDATORS=[";
+        for (size_t i = 0; i < qSet.validators.size(); ++i)
+        {
+            out << (i == 0 ? "" : ", ")
+                << tomlString(KeyUtils::toStrKey(qSet.validators[i]));
+        }
+        out << "]\n";
+    }
+    for (size_t i = 0; i < qSet.innerSets.size(); ++i)
+    {
+        writeQuorumSet(out, name + ".INNER_" + std::to_string(i),
+                       qSet.innerSets[i]);
+    }
+}
+
+// Nearest-rank percentile of sorted values
+double
+percentile(std::vector<double> const& sorted, double p)
+{
+    return sorted[static_cast<size_t>(p * (sorted.size() - 1) + 0.5)];
+}
+}
+
 Simulation::Simulation(Mode mode, Hash const& networkID, ConfigGen confGen,
                        QuorumSetAdjuster qSetAdjust)
-    : mVirtualClockMode(mode != OVER_TCP)
+    : mVirtualClockMode(mode == OVER_LOOPBACK)
     , mClock(mVirtualClockMode ? VirtualClock::VIRTUAL_TIME
                                : VirtualClock::REAL_TIME)
     , mMode(mode)
@@ -43,6 +114,12 @@ Simulation::Simulation(Mode mode, Hash const& networkID, ConfigGen confGen,
     auto cfg = newConfig();
     auto& parallel = cfg.EXPERIMENTAL_BACKGROUND_OVERLAY_PROCESSING;
     parallel = parallel && mVirtualClockMode == VirtualClock::REAL_TIME;
+    if (mode == OVER_PROCESSES)
+    {
+        // Nodes run for the whole simulation: none may wait for another to
+        // exit before it starts
+        cfg.MAX_CONCURRENT_SUBPROCESSES = std::numeric_limits<size_t>::max();
+    }
     mIdleApp = Application::create(mClock, cfg);
     mPeerMap.emplace(mIdleApp->getConfig().PEER_PORT, mIdleApp);
 }
@@ -111,11 +188,17 @@ Simulation::addNode(SecretKey nodeKey, SCPQuorumSet qSet, Config const* cfg2,
         cfg->QUORUM_SET = qSet;
     }
 
-    if (mMode == OVER_TCP)
+    if (mMode != OVER_LOOPBACK)
     {
         cfg->RUN_STANDALONE = false;
     }
 
+    if (mMode == OVER_PROCESSES)
+    {
+        mProcessNodes.emplace(nodeKey.getPublicKey(), ProcessNode{*cfg});
+        return nullptr;
+    }
+
     auto clock =
         make_shared<VirtualClock>(mVirtualClockMode ? VirtualClock::VIRTUAL_TIME
                                                     : VirtualClock::REAL_TIME);
@@ -153,11 +236,13 @@ Simulation::addNode(SecretKey nodeKey, SCPQuorumSet qSet, Config const* cfg2,
 Application::pointer
 Simulation::getNode(NodeID nodeID)
 {
+    releaseAssert(mMode != OVER_PROCESSES);
     return mNodes[nodeID].mApp;
 }
 vector<Application::pointer>
 Simulation::getNodes()
 {
+    releaseAssert(mMode != OVER_PROCESSES);
     vector<Application::pointer> result;
     for (auto const& p : mNodes)
         result.push_back(p.second.mApp);
@@ -169,6 +254,8 @@ Simulation::getNodeIDs()
     vector<NodeID> result;
     for (auto const& p : mNodes)
         result.push_back(p.first);
+    for (auto const& p : mProcessNodes)
+        result.push_back(p.first);
     return result;
 }
 
@@ -282,10 +369,40 @@ Simulation::addLoopbackConnection(NodeID initiator, NodeID acceptor)
     {
         auto conn = std::make_shared<LoopbackPeerConnection>(
             *getNode(initiator), *getNode(acceptor));
+        applyLinkModels(*conn->getInitiator(), *conn->getAcceptor());
         mLoopbackConnections.push_back(conn);
     }
 }
 
+void
+Simulation::setLinkModel(NodeID const& a, NodeID const& b,
+                         LoopbackLinkModel const& model)
+{
+    releaseAssert(mMode == OVER_LOOPBACK);
+    mLinkModels[std::make_pair(a, b)] = model;
+    mLinkModels[std::make_pair(b, a)] = model;
+}
+
+void
+Simulation::setDefaultLinkModel(LoopbackLinkModel const& model)
+{
+    releaseAssert(mMode == OVER_LOOPBACK);
+    mDefaultLinkModel = model;
+}
+
+void
+Simulation::applyLinkModels(LoopbackPeer& initiator, LoopbackPeer& acceptor)
+{
+    auto from = initiator.getConfig().NODE_SEED.getPublicKey();
+    auto to = acceptor.getConfig().NODE_SEED.getPublicKey();
+    auto modelOf = [&](NodeID const& a, NodeID const& b) {
+        auto it = mLinkModels.find(std::make_pair(a, b));
+        return it == mLinkModels.end() ? mDefaultLinkModel : it->second;
+    };
+    initiator.setLinkModel(modelOf(from, to));
+    acceptor.setLinkModel(modelOf(to, from));
+}
+
 std::shared_ptr<LoopbackPeerConnection>
 Simulation::getLoopbackConnection(NodeID const& initiator,
                                   NodeID const& acceptor)
@@ -353,6 +470,12 @@ Simulation::stopOverlayTick()
 void
 Simulation::startAllNodes()
 {
+    if (mMode == OVER_PROCESSES)
+    {
+        startProcessNodes();
+        return;
+    }
+
     for (auto const& it : mNodes)
     {
         auto app = it.second.mApp;
@@ -369,9 +492,113 @@ Simulation::startAllNodes()
     mPendingConnections.clear();
 }
 
+void
+Simulation::startProcessNodes()
+{
+    // Nodes only connect to their neighbours in the topology, whichever side
+    // initiated the connection
+    std::map<NodeID, std::set<NodeID>> neighbours;
+    for (auto const& pair : mPendingConnections)
+    {
+        neighbours[pair.first].insert(pair.second);
+        neighbours[pair.second].insert(pair.first);
+    }
+    mPendingConnections.clear();
+
+    bool allLocal = true;
+    size_t i = 0;
+    for (auto& p : mProcessNodes)
+    {
+        p.second.mHost = mProcessHosts.empty()
+                             ? std::string{"127.0.0.1"}
+                             : mProcessHosts[i++ % mProcessHosts.size()];
+        allLocal = allLocal && isLocalHost(p.second.mHost);
+    }
+
+    if (!mProcessDir)
+    {
+        mProcessDir = std::make_unique<TmpDir>(
+            mIdleApp->getTmpDirManager().tmpDir("simulation"));
+    }
+    std::error_code ec;
+    auto exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+    auto exePath = ec ? std::string{"stellar-core"} : exe.string();
+
+    for (auto& p : mProcessNodes)
+    {
+        auto& node = p.second;
+        if (!node.mExit.expired())
+        {
+            continue;
+        }
+        auto const& cfg = node.mConfig;
+        auto dir = fmt::format("{}/node-{}", mProcessDir->getName(),
+                               cfg.PEER_PORT);
+        fs::mkpath(dir);
+        auto cfgFile = dir + "/stellar-core.cfg";
+
+        std::ofstream out(cfgFile);
+        out << std::boolalpha
+            << "NETWORK_PASSPHRASE=" << tomlString(cfg.NETWORK_PASSPHRASE)
+            << "\nNODE_SEED=" << tomlString(cfg.NODE_SEED.getStrKeySeed().value)
+            << "\nNODE_IS_VALIDATOR=" << cfg.NODE_IS_VALIDATOR
+            << "\nRUN_STANDALONE=false"
+            << "\nDATABASE=\"sqlite3://:memory:\""
+            << "\nBUCKET_DIR_PATH=" << tomlString(dir + "/buckets")
+            << "\nLOG_FILE_PATH=" << tomlString(dir + "/stellar-core.log")
+            << "\nPEER_PORT=" << cfg.PEER_PORT
+            << "\nHTTP_PORT=" << cfg.HTTP_PORT
+            << "\nPUBLIC_HTTP_PORT=" << !allLocal
+            << "\nALLOW_LOCALHOST_FOR_TESTING=" << allLocal
+            << "\nARTIFICIALLY_ACCELERATE_TIME_FOR_TESTING="
+            << cfg.ARTIFICIALLY_ACCELERATE_TIME_FOR_TESTING
+            << "\nUNSAFE_QUORUM=true\nFAILURE_SAFETY=0";
+
+        // Inbound slots default to a multiple of the target, so they fit
+        // all the neighbours as well
+        auto const& peers = neighbours[p.first];
+        out << "\nTARGET_PEER_CONNECTIONS="
+            << std::max<size_t>(peers.size(), cfg.TARGET_PEER_CONNECTIONS)
+            << "\nPREFERRED_PEERS_ONLY=true\nPREFERRED_PEERS=[";
+        for (auto it = peers.begin(); it != peers.end(); ++it)
+        {
+            auto const& peer = mProcessNodes.at(*it);
+            out << (it == peers.begin() ? "" : ", ")
+                << tomlString(fmt::format("{}:{}", peer.mHost,
+                                          peer.mConfig.PEER_PORT));
+        }
+        out << "]\n";
+        writeQuorumSet(out, "QUORUM_SET", cfg.QUORUM_SET);
+        out.close();
+
+        auto cmdLine = fmt::format("{} run --conf {}", exePath, cfgFile);
+        if (isLocalHost(node.mHost))
+        {
+            node.mExit = mIdleApp->getProcessManager().runProcess(cmdLine, "");
+        }
+        else
+        {
+            LOG_INFO(DEFAULT_LOG, "Start node {} on {} with: {}",
+                     cfg.toShortString(p.first), node.mHost, cmdLine);
+        }
+    }
+}
+
 void
 Simulation::stopAllNodes()
 {
+    if (mMode == OVER_PROCESSES)
+    {
+        for (auto& p : mProcessNodes)
+        {
+            if (auto exit = p.second.mExit.lock())
+            {
+                mIdleApp->getProcessManager().tryProcessShutdown(exit);
+            }
+        }
+        return;
+    }
+
     for (auto& n : mNodes)
     {
         auto app = n.second.mApp;
@@ -538,7 +765,7 @@ bool
 Simulation::haveAllExternalized(uint32 num, uint32 maxSpread,
                                 bool validatorsOnly)
 {
-    uint32_t min = UINT32_MAX, max = 0;
+    std::vector<uint32_t> ledgers;
     for (auto it = mNodes.begin(); it != mNodes.end(); ++it)
     {
         auto app = it->second.mApp;
@@ -546,7 +773,24 @@ Simulation::haveAllExternalized(uint32 num, uint32 maxSpread,
         {
             continue;
         }
-        auto n = app->getLedgerManager().getLastClosedLedgerNum();
+        ledgers.emplace_back(app->getLedgerManager().getLastClosedLedgerNum());
+    }
+    for (auto const& p : mProcessNodes)
+    {
+        if (validatorsOnly && !p.second.mConfig.NODE_IS_VALIDATOR)
+        {
+            continue;
+        }
+        // A node that doesn't answer yet is still at genesis
+        Json::Value info;
+        ledgers.emplace_back(queryProcessNode(p.second, "info", info)
+                                 ? info["info"]["ledger"]["num"].asUInt()
+                                 : LedgerManager::GENESIS_LEDGER_SEQ);
+    }
+
+    uint32_t min = UINT32_MAX, max = 0;
+    for (auto n : ledgers)
+    {
         if (n < min)
             min = n;
         if (n > max)
@@ -773,6 +1017,82 @@ Simulation::metricsSummary(string domain)
     return out.str();
 }
 
+void
+Simulation::setProcessHosts(std::vector<std::string> const& hosts)
+{
+    releaseAssert(mMode == OVER_PROCESSES);
+    mProcessHosts = hosts;
+}
+
+bool
+Simulation::queryProcessNode(ProcessNode const& node,
+                             std::string const& command, Json::Value& res)
+{
+    std::string ret;
+    if (http_request(node.mHost, "/" + command, node.mConfig.HTTP_PORT,
+                     ret) != 200)
+    {
+        return false;
+    }
+    Json::Reader reader;
+    return reader.parse(ret, res);
+}
+
+Json::Value
+Simulation::consensusLatencySummary()
+{
+    releaseAssert(mMode == OVER_PROCESSES);
+    static std::vector<std::string> const timers = {
+        "scp.timing.nominated", "scp.timing.externalized",
+        "scp.timing.first-to-self-externalize-lag",
+        "scp.timing.self-to-others-externalize-lag", "ledger.ledger.close"};
+    static std::vector<std::string> const stats = {"median", "99%"};
+
+    // timer -> stat -> value of each node
+    std::map<std::string, std::map<std::string, std::vector<double>>> values;
+    Json::UInt reporting = 0;
+    for (auto const& p : mProcessNodes)
+    {
+        Json::Value res;
+        if (!queryProcessNode(p.second, "metrics", res))
+        {
+            continue;
+        }
+        ++reporting;
+        Json::Value const& metrics = res["metrics"];
+        for (auto const& timer : timers)
+        {
+            auto const& m = metrics[timer];
+            if (m.isObject() && m["count"].asUInt64() != 0)
+            {
+                for (auto const& stat : stats)
+                {
+                    values[timer][stat].emplace_back(m[stat].asDouble());
+                }
+            }
+        }
+    }
+
+    Json::Value summary;
+    summary["nodes"] = static_cast<Json::UInt>(mProcessNodes.size());
+    summary["reporting"] = reporting;
+    for (auto& t : values)
+    {
+        for (auto& s : t.second)
+        {
+            auto& v = s.second;
+            std::sort(v.begin(), v.end());
+            auto& res = summary["timers_ms"][t.first][s.first];
+            res["nodes"] = static_cast<Json::UInt>(v.size());
+            res["p50"] = percentile(v, 0.5);
+            res["p90"] = percentile(v, 0.9);
+            res["p99"] = percentile(v, 0.99);
+            res["max"] = v.back();
+        }
+    }
+    return summary;
+}
+
 bool
 LoopbackOverlayManager::connectToImpl(PeerBareAddress const& address,
                                       bool forceoutbound)
@@ -798,6 +1118,7 @@ LoopbackOverlayManager::connectToImpl(PeerBareAddress const& address,
             return false;
         }
         auto res = LoopbackPeer::initiate(mApp, *otherApp);
+        app.getSim().applyLinkModels(*res.first, *res.second);
         return res.first->isConnectedForTesting();
     }
     else
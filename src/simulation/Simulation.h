@@ -6,16 +6,19 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "crypto/SHA.h"
+#include "lib/json/json.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "medida/medida.h"
 #include "overlay/OverlayManagerImpl.h"
 #include "overlay/StellarXDR.h"
 #include "overlay/test/LoopbackPeer.h"
+#include "process/ProcessManager.h"
 #include "simulation/LoadGenerator.h"
 #include "test/TestUtils.h"
 #include "test/TxTests.h"
 #include "util/Timer.h"
+#include "util/TmpDir.h"
 #include "util/XDROperators.h"
 #include "xdr/Stellar-types.h"
 
@@ -32,7 +35,12 @@ class Simulation
     enum Mode
     {
         OVER_TCP,
-        OVER_LOOPBACK
+        OVER_LOOPBACK,
+        // Each node is a separate stellar-core process, started with a config
+        // generated from its Config, quorum set and connections. Nodes have
+        // no Application in this process: getNode and getNodes can't be
+        // used, and nodes are only observed through their HTTP endpoints.
+        OVER_PROCESSES
     };
 
     using pointer = std::shared_ptr<Simulation>;
@@ -56,6 +64,14 @@ class Simulation
     std::vector<NodeID> getNodeIDs();
 
     void addPendingConnection(NodeID const& initiator, NodeID const& acceptor);
+    // OVER_LOOPBACK: network conditions of the links between a and b, in
+    // both directions, and of links without a model of their own. They apply
+    // to the connections made from then on.
+    void setLinkModel(NodeID const& a, NodeID const& b,
+                      LoopbackLinkModel const& model);
+    void setDefaultLinkModel(LoopbackLinkModel const& model);
+    // Sets the link models of a new loopback connection
+    void applyLinkModels(LoopbackPeer& initiator, LoopbackPeer& acceptor);
     // Returns LoopbackPeerConnection given initiator, acceptor pair or nullptr
     std::shared_ptr<LoopbackPeerConnection>
     getLoopbackConnection(NodeID const& initiator, NodeID const& acceptor);
@@ -80,6 +96,16 @@ class Simulation
     void crankUntil(VirtualClock::system_time_point timePoint, bool finalCrank);
     std::string metricsSummary(std::string domain = "");
 
+    // OVER_PROCESSES: hosts the nodes are spread over, round-robin, when they
+    // are started (default: all on 127.0.0.1). Nodes on other hosts only get
+    // their config written; they have to be started there with the logged
+    // command line, from a copy of the simulation directory at the same path.
+    void setProcessHosts(std::vector<std::string> const& hosts);
+    // OVER_PROCESSES: percentiles over all nodes of the median and 99th
+    // percentile of the consensus timers of each node, as reported by its
+    // `metrics` endpoint
+    Json::Value consensusLatencySummary();
+
     void addConnection(NodeID initiator, NodeID acceptor);
     void dropConnection(NodeID initiator, NodeID acceptor);
     Config newConfig(); // generates a new config
@@ -92,6 +118,18 @@ class Simulation
     void addTCPConnection(NodeID initiator, NodeID acception);
     void dropAllConnections(NodeID const& id);
 
+    struct ProcessNode
+    {
+        Config mConfig;
+        std::string mHost;
+        std::weak_ptr<ProcessExitEvent> mExit;
+    };
+    void startProcessNodes();
+    // Runs an HTTP command on a process node, returning false if the node
+    // didn't answer with JSON
+    bool queryProcessNode(ProcessNode const& node, std::string const& command,
+                          Json::Value& res);
+
     bool mVirtualClockMode;
     VirtualClock mClock;
     Mode mMode;
@@ -112,6 +150,12 @@ class Simulation
     std::map<NodeID, Node> mNodes;
     std::vector<std::pair<NodeID, NodeID>> mPendingConnections;
     std::vector<std::shared_ptr<LoopbackPeerConnection>> mLoopbackConnections;
+    std::map<std::pair<NodeID, NodeID>, LoopbackLinkModel> mLinkModels;
+    LoopbackLinkModel mDefaultLinkModel;
+
+    std::map<NodeID, ProcessNode> mProcessNodes;
+    std::vector<std::string> mProcessHosts;
+    std::unique_ptr<TmpDir> mProcessDir;
 
     ConfigGen mConfigGen; // config generator
 
@@ -89,6 +89,41 @@ TEST_CASE("generate load with unique accounts", "[loadgen]")
             },
             10 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
     }
+    SECTION("open loop")
+    {
+        loadGen.generateLoad(GeneratedLoadConfig::createAccountsLoad(
+            /* nAccounts */ 1000,
+            /* txRate */ 1));
+        simulation->crankUntil(
+            [&]() {
+                return app.getMetrics()
+                           .NewMeter({"loadgen", "run", "complete"}, "run")
+                           .count() == 1;
+            },
+            100 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+        auto cfg = GeneratedLoadConfig::txLoad(LoadGenMode::PAY,
+                                               /* nAccounts */ 1000,
+                                               /* nTxs */ 500,
+                                               /* txRate */ 20);
+        cfg.openLoop = true;
+        loadGen.generateLoad(cfg);
+        simulation->crankUntil(
+            [&]() {
+                return app.getMetrics()
+                           .NewMeter({"loadgen", "run", "complete"}, "run")
+                           .count() == 2;
+            },
+            100 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+        // Every submission is accounted for by its status
+        auto& m = app.getMetrics();
+        auto submitted = m.NewTimer({"loadgen", "submit", "latency"}).count();
+        REQUIRE(submitted == 500);
+        REQUIRE(m.NewMeter({"loadgen", "submit", "pending"}, "txn").count() >
+                0);
+        REQUIRE(m.NewMeter({"loadgen", "run", "failed"}, "run").count() == 0);
+    }
 }
 
 TEST_CASE("generate soroban load", "[loadgen][soroban]")
@@ -393,8 +428,8 @@ TEST_CASE("generate soroban load", "[loadgen][soroban]")
             {"ledger", "apply-soroban", "failure"});
 
         // Should be 1 upload wasm TX followed by one instance deploy TX per
-        // account
-        REQUIRE(txsSucceeded.count() == numTxsBefore + numInstances + 1);
+        // account and one native asset contract deploy TX
+        REQUIRE(txsSucceeded.count() == numTxsBefore + numInstances + 2);
         REQUIRE(txsFailed.count() == 0);
     }
 
@@ -550,6 +585,41 @@ TEST_CASE("generate soroban load", "[loadgen][soroban]")
         }
     }
 
+    // Test MIXED_SOROBAN mode
+    SECTION("Soroban mix")
+    {
+        constexpr uint32_t numMixedTxs = 100;
+        auto mixLoadCfg = GeneratedLoadConfig::txLoad(
+            LoadGenMode::MIXED_SOROBAN, nAccounts, numMixedTxs,
+            /* txRate */ 1);
+        mixLoadCfg.getMutSorobanConfig().nInstances = numInstances;
+
+        auto& mixCfg = mixLoadCfg.getMutMixSorobanConfig();
+        mixCfg.sacTransferWeight = 40;
+        mixCfg.storageWeight = 20;
+        mixCfg.readWeight = 20;
+        mixCfg.ttlWeight = 20;
+        mixLoadCfg.setMinSorobanPercentSuccess(100 - maxInvokeFail);
+
+        auto& metrics = app.getMetrics();
+        auto numSuccessBefore = getSuccessfulTxCount();
+        loadGen.generateLoad(mixLoadCfg);
+        simulation->crankUntil(
+            [&]() {
+                return metrics.NewMeter({"loadgen", "run", "complete"}, "run")
+                           .count() == 6;
+            },
+            300 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+        REQUIRE(getSuccessfulTxCount() >
+                numSuccessBefore + numMixedTxs - maxInvokeFail);
+        for (auto const& kind : {"sac_transfer", "storage", "read", "ttl"})
+        {
+            REQUIRE(metrics.NewMeter({"loadgen", "soroban", kind}, "txn")
+                        .count() > 0);
+        }
+    }
+
     // Test minimum percent success with too many transactions that fail to
     // apply by requiring a 100% success rate for SOROBAN_UPLOAD mode
     SECTION("Too many failed transactions")
@@ -0,0 +1,35 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/SHA.h"
+#include "herder/Herder.h"
+#include "lib/catch.hpp"
+#include "simulation/Topologies.h"
+#include "test/test.h"
+#include "util/Logging.h"
+
+using namespace stellar;
+
+// Runs a 10 validator core and 100 outer validators, each in its own
+// stellar-core process, and reports how long consensus takes across them
+TEST_CASE("hierarchical topology over processes",
+          "[simulation][process][!hide]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto simulation = Topologies::hierarchicalQuorumSimplified(
+        10, 100, Simulation::OVER_PROCESSES, networkID, nullptr, 2);
+    REQUIRE(simulation->getNodeIDs().size() == 110);
+
+    simulation->startAllNodes();
+    simulation->crankUntil(
+        [&]() { return simulation->haveAllExternalized(20, 5); },
+        60 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+    auto summary = simulation->consensusLatencySummary();
+    LOG_INFO(DEFAULT_LOG, "Consensus latency: {}",
+             Json::StyledWriter().write(summary));
+    REQUIRE(summary["reporting"].asUInt() == 110);
+    REQUIRE(summary["timers_ms"].isMember("scp.timing.externalized"));
+    simulation->stopAllNodes();
+}
@@ -0,0 +1,128 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "test/Benchmark.h"
+#include "main/StellarCoreVersion.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace stellar
+{
+
+namespace
+{
+std::string gBenchmarkOutput;
+// By name, so a benchmark run twice keeps its last result
+std::map<std::string, BenchmarkResult> gBenchmarkResults;
+
+uint64_t
+percentile(std::vector<uint64_t> const& sorted, double p)
+{
+    auto i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+}
+
+Json::Value
+BenchmarkResult::toJson() const
+{
+    Json::Value res;
+    res["name"] = mName;
+    res["repetitions"] = static_cast<Json::UInt64>(mRepetitions);
+    res["items"] = static_cast<Json::UInt64>(mItems);
+    auto& ns = res["ns_per_item"];
+    ns["mean"] = mMean;
+    ns["min"] = static_cast<Json::UInt64>(mMin);
+    ns["p50"] = static_cast<Json::UInt64>(mP50);
+    ns["p90"] = static_cast<Json::UInt64>(mP90);
+    ns["p99"] = static_cast<Json::UInt64>(mP99);
+    ns["max"] = static_cast<Json::UInt64>(mMax);
+    return res;
+}
+
+BenchmarkResult
+runBenchmark(std::string const& name, std::function<void()> const& fn,
+             size_t items, size_t warmup, size_t repetitions)
+{
+    releaseAssert(items != 0 && repetitions != 0);
+    for (size_t i = 0; i < warmup; ++i)
+    {
+        fn();
+    }
+
+    std::vector<uint64_t> times;
+    times.reserve(repetitions);
+    for (size_t i = 0; i < repetitions; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+        times.emplace_back(static_cast<uint64_t>(elapsed.count()) / items);
+    }
+    std::sort(times.begin(), times.end());
+
+    BenchmarkResult res;
+    res.mName = name;
+    res.mRepetitions = repetitions;
+    res.mItems = items;
+    res.mMean = std::accumulate(times.begin(), times.end(), 0.0) /
+                static_cast<double>(times.size());
+    res.mMin = times.front();
+    res.mP50 = percentile(times, 0.5);
+    res.mP90 = percentile(times, 0.9);
+    res.mP99 = percentile(times, 0.99);
+    res.mMax = times.back();
+
+    LOG_INFO(DEFAULT_LOG,
+             "benchmark {}: {} x {} items, ns per item mean {:.0f} min {} "
+             "p50 {} p90 {} p99 {} max {}",
+             name, repetitions, items, res.mMean, res.mMin, res.mP50, res.mP90,
+             res.mP99, res.mMax);
+    gBenchmarkResults[name] = res;
+    return res;
+}
+
+void
+setBenchmarkOutput(std::string const& path)
+{
+    gBenchmarkOutput = path;
+}
+
+void
+writeBenchmarkResults()
+{
+    if (gBenchmarkOutput.empty())
+    {
+        return;
+    }
+    Json::Value root;
+    root["version"] = STELLAR_CORE_VERSION;
+    auto& benchmarks = root["benchmarks"];
+    benchmarks = Json::arrayValue;
+    for (auto const& kv : gBenchmarkResults)
+    {
+        benchmarks.append(kv.second.toJson());
+    }
+
+    std::ofstream out(gBenchmarkOutput);
+    if (!out)
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("Can't open benchmark output {}"), gBenchmarkOutput));
+    }
+    out << Json::StyledWriter().write(root);
+    LOG_INFO(DEFAULT_LOG, "Wrote {} benchmark results to {}",
+             gBenchmarkResults.size(), gBenchmarkOutput);
+}
+}
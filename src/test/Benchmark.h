@@ -0,0 +1,46 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/json/json.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace stellar
+{
+
+// Timings of one benchmark, in nanoseconds per item over all repetitions
+struct BenchmarkResult
+{
+    std::string mName;
+    size_t mRepetitions{0};
+    size_t mItems{0};
+    double mMean{0};
+    uint64_t mMin{0};
+    uint64_t mP50{0};
+    uint64_t mP90{0};
+    uint64_t mP99{0};
+    uint64_t mMax{0};
+
+    Json::Value toJson() const;
+};
+
+// Runs `fn`, which processes `items` items per call, `warmup` times untimed
+// and then `repetitions` times timed. The result is logged and kept for
+// writeBenchmarkResults.
+BenchmarkResult runBenchmark(std::string const& name,
+                             std::function<void()> const& fn, size_t items = 1,
+                             size_t warmup = 3, size_t repetitions = 30);
+
+// Sets the file writeBenchmarkResults writes to; results are only logged if
+// it is not set
+void setBenchmarkOutput(std::string const& path);
+
+// Writes all the results of runBenchmark so far as JSON, sorted by name so
+// that runs can be diffed
+void writeBenchmarkResults();
+}
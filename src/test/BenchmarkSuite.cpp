@@ -0,0 +1,319 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// Benchmarks of the hot paths of the node, run with `make bench` (or
+// `stellar-core test '[benchsuite]' --bench-output FILE`) so that results of
+// different builds can be compared with the JSON written by Benchmark.h.
+
+#include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
+#include "bucket/BucketManager.h"
+#include "crypto/SecretKey.h"
+#include "herder/TxSetFrame.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/test/LedgerTestUtils.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "overlay/Hmac.h"
+#include "test/Benchmark.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "transactions/OfferExchange.h"
+#include "util/Math.h"
+#include "util/XDRMarshal.h"
+#include "util/numeric128.h"
+#include "xdrpp/marshal.h"
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+TEST_CASE("bucket merge and index lookup benchmarks",
+          "[benchsuite][bench][!hide]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    auto app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+    auto vers = getAppLedgerVersion(app);
+
+    size_t const n = 10000;
+    auto entries = LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+        {ACCOUNT, TRUSTLINE, CONTRACT_DATA}, n + n / 2);
+    // The newer bucket updates half of the entries of the older one
+    std::vector<LedgerEntry> oldEntries(entries.begin(), entries.begin() + n);
+    std::vector<LedgerEntry> newEntries(entries.begin() + n / 2, entries.end());
+    auto oldBucket = Bucket::fresh(bm, vers, {}, oldEntries, {},
+                                   /*countMergeEvents=*/false,
+                                   clock.getIOContext(), /*doFsync=*/false);
+    auto newBucket = Bucket::fresh(bm, vers, {}, newEntries, {},
+                                   /*countMergeEvents=*/false,
+                                   clock.getIOContext(), /*doFsync=*/false);
+
+    runBenchmark(
+        "bucket.merge",
+        [&]() {
+            Bucket::merge(bm, vers, oldBucket, newBucket, /*shadows=*/{},
+                          /*keepDeadEntries=*/true,
+                          /*countMergeEvents=*/false, clock.getIOContext(),
+                          /*doFsync=*/false);
+        },
+        oldEntries.size() + newEntries.size(), 1, 10);
+
+    auto index = BucketIndex::createIndex(bm, oldBucket->getFilename(),
+                                          oldBucket->getHash());
+    std::vector<LedgerKey> keys;
+    for (auto const& le : oldEntries)
+    {
+        keys.emplace_back(LedgerEntryKey(le));
+    }
+    runBenchmark(
+        "bucket.index.lookup",
+        [&]() {
+            for (auto const& k : keys)
+            {
+                REQUIRE(index->lookup(k));
+            }
+        },
+        keys.size());
+}
+
+TEST_CASE("ledger txn nested commit benchmark", "[benchsuite][bench][!hide]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+
+    size_t const n = 1000, depth = 4;
+    auto entries = LedgerTestUtils::generateValidUniqueLedgerEntries(n);
+    runBenchmark(
+        "ledgertxn.nested-commit",
+        [&]() {
+            LedgerTxn ltxRoot(app->getLedgerTxnRoot());
+            std::vector<std::unique_ptr<LedgerTxn>> ltxs;
+            for (size_t d = 0; d < depth; ++d)
+            {
+                ltxs.emplace_back(std::make_unique<LedgerTxn>(
+                    d == 0 ? static_cast<AbstractLedgerTxnParent&>(ltxRoot)
+                           : *ltxs.back()));
+            }
+            for (auto const& le : entries)
+            {
+                ltxs.back()->createWithoutLoading(le);
+            }
+            while (!ltxs.empty())
+            {
+                ltxs.back()->commit();
+                ltxs.pop_back();
+            }
+        },
+        n * depth);
+}
+
+TEST_CASE("transaction benchmarks", "[benchsuite][bench][!hide]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+    auto dest = SecretKey::pseudoRandomForTesting().getPublicKey();
+
+    size_t const n = 100;
+    TxSetTransactions txs;
+    for (size_t i = 0; i < n; ++i)
+    {
+        txs.emplace_back(root.tx({payment(dest, 1000)}));
+    }
+
+    runBenchmark(
+        "tx.check-valid",
+        [&]() {
+            LedgerTxn ltx(app->getLedgerTxnRoot());
+            REQUIRE(txs.front()->checkValid(*app, ltx, 0, 0, 0));
+        },
+        1, 3, 300);
+
+    std::vector<std::pair<PublicKey, Signature>> sigs;
+    auto payload = xdr::xdr_to_opaque(txs.front()->getEnvelope());
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto sk = SecretKey::pseudoRandomForTesting();
+        sigs.emplace_back(sk.getPublicKey(), sk.sign(payload));
+    }
+    runBenchmark(
+        "crypto.verify-sig",
+        [&]() {
+            // Without the cache every call verifies
+            PubKeyUtils::clearVerifySigCache();
+            for (auto const& sig : sigs)
+            {
+                REQUIRE(PubKeyUtils::verifySig(sig.first, sig.second,
+                                               payload));
+            }
+        },
+        sigs.size());
+
+    runBenchmark(
+        "herder.build-tx-set",
+        [&]() {
+            auto txSet = makeTxSetFromTransactions(txs, *app, 0, 0);
+            REQUIRE(txSet.second->sizeTxTotal() == n);
+        },
+        n, 3, 10);
+}
+
+TEST_CASE("overlay framing benchmark", "[benchsuite][bench][!hide]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+    auto dest = SecretKey::pseudoRandomForTesting().getPublicKey();
+
+    HmacSha256Key key;
+    key.key[0] = 1;
+    Hmac sender;
+    Hmac receiver;
+    REQUIRE(sender.setSendMackey(key));
+    REQUIRE(receiver.setRecvMackey(key));
+
+    std::vector<StellarMessage> msgs(100);
+    for (auto& msg : msgs)
+    {
+        msg.type(TRANSACTION);
+        msg.transaction() = root.tx({payment(dest, 1000)})->getEnvelope();
+    }
+
+    runBenchmark(
+        "overlay.frame",
+        [&]() {
+            for (auto const& msg : msgs)
+            {
+                AuthenticatedMessage amsg;
+                sender.setAuthenticatedMessageBody(amsg, msg);
+                auto bytes = xdrToMsg(amsg);
+
+                AuthenticatedMessage received;
+                xdr::xdr_from_msg(bytes, received);
+                std::string error;
+                REQUIRE(receiver.checkAuthenticatedMessage(received, error));
+            }
+        },
+        msgs.size());
+}
+
+TEST_CASE("dex arithmetic benchmarks", "[benchsuite][bench][!hide]")
+{
+    size_t const n = 10000;
+    struct Crossing
+    {
+        Price price;
+        int64_t maxWheatSend;
+        int64_t maxSheepReceive;
+    };
+    std::vector<Crossing> crossings;
+    for (size_t i = 0; i < n; ++i)
+    {
+        crossings.emplace_back(
+            Crossing{Price{rand_uniform<int32_t>(1, INT32_MAX),
+                           rand_uniform<int32_t>(1, INT32_MAX)},
+                     rand_uniform<int64_t>(1, INT64_MAX),
+                     rand_uniform<int64_t>(1, INT64_MAX)});
+    }
+
+    runBenchmark(
+        "dex.exchange-v10",
+        [&]() {
+            for (auto const& c : crossings)
+            {
+                exchangeV10(c.price, c.maxWheatSend, INT64_MAX, INT64_MAX,
+                            c.maxSheepReceive, RoundingType::NORMAL);
+            }
+        },
+        n);
+
+    runBenchmark(
+        "dex.adjust-offer",
+        [&]() {
+            for (auto const& c : crossings)
+            {
+                adjustOffer(c.price, c.maxWheatSend, c.maxSheepReceive);
+            }
+        },
+        n);
+
+    runBenchmark(
+        "dex.exchange-with-pool",
+        [&]() {
+            for (auto const& c : crossings)
+            {
+                int64_t toPool = 0;
+                int64_t fromPool = 0;
+                exchangeWithPool(c.maxWheatSend, c.maxSheepReceive / 1000,
+                                 toPool, c.maxSheepReceive, INT64_MAX, fromPool,
+                                 30, RoundingType::PATH_PAYMENT_STRICT_SEND);
+            }
+        },
+        n);
+
+    runBenchmark(
+        "numeric.big-divide",
+        [&]() {
+            for (auto const& c : crossings)
+            {
+                int64_t res;
+                bigDivide(res, c.maxWheatSend, c.price.n, c.maxSheepReceive,
+                          ROUND_UP);
+            }
+        },
+        n);
+
+    runBenchmark(
+        "numeric.big-square-root",
+        [&]() {
+            for (auto const& c : crossings)
+            {
+                bigSquareRoot(c.maxWheatSend, c.maxSheepReceive);
+            }
+        },
+        n);
+
+    // Moved from "uint128_t bench": the arithmetic of uint128_t, whichever
+    // way it is compiled, against that of the compiler's own 128-bit type
+    std::vector<uint128_t> lib;
+    for (auto const& c : crossings)
+    {
+        // Nonzero, as these are divisors
+        lib.emplace_back(
+            bigMultiplyUnsigned(c.maxWheatSend, c.maxSheepReceive));
+        lib.back() |= uint128_t(1u);
+    }
+    uint128_t libRes{0ul};
+    runBenchmark(
+        "uint128.library",
+        [&]() {
+            for (auto k : lib)
+            {
+                libRes = libRes + (k * (k + k)) / k;
+            }
+        },
+        n);
+#if defined(__SIZEOF_INT128__) || defined(_GLIBCXX_USE_INT128)
+    std::vector<unsigned __int128> native;
+    for (auto k : lib)
+    {
+        native.emplace_back(static_cast<unsigned __int128>(k));
+    }
+    unsigned __int128 nativeRes{0};
+    runBenchmark(
+        "uint128.native",
+        [&]() {
+            for (auto k : native)
+            {
+                nativeRes = nativeRes + (k * (k + k)) / k;
+            }
+        },
+        n);
+    REQUIRE(static_cast<unsigned __int128>(libRes) == nativeRes);
+#endif
+}
@@ -4,6 +4,8 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace stellar
@@ -25,6 +27,9 @@ class Fuzzer
     // i.e. apply a transaction in the case of a TransactionFuzzer or send a
     // message in case of an OverlayFuzzer
     virtual void inject(std::string const& filename) = 0;
+    // injectBytes is inject for an input already in memory, as handed over by
+    // in-process fuzzing engines such as libFuzzer
+    virtual void injectBytes(uint8_t const* data, size_t size) = 0;
     virtual void initialize() = 0;
     virtual void shutdown() = 0;
     // genFuzz randomly generates an XDR input for the given fuzzer. For the
@@ -877,6 +877,21 @@ getFuzzConfig(int instanceNumber)
     return cfg;
 }
 
+// Reads at most `limit` bytes of a fuzzed input file, so that a file of
+// exactly `limit` bytes or more is as good as too large
+static std::vector<char>
+readFuzzerInput(std::string const& filename, int limit)
+{
+    std::ifstream in;
+    in.exceptions(std::ios::badbit);
+    in.open(filename, std::ios::binary);
+
+    std::vector<char> bins(limit);
+    in.read(bins.data(), bins.size());
+    bins.resize(in.gcount());
+    return bins;
+}
+
 static void
 resetTxInternalState(Application& app)
 {
@@ -1514,6 +1529,24 @@ TransactionFuzzer::initialize()
 #ifdef BUILD_TESTS
     mApp->getInvariantManager().snapshotForFuzzer();
 #endif // BUILD_TESTS
+
+    openSnapshot();
+}
+
+void
+TransactionFuzzer::openSnapshot()
+{
+    mSnapshot = std::make_unique<LedgerTxn>(mApp->getLedgerTxnRoot());
+    // Loading the entries through mSnapshot records them in it, so that its
+    // children find them there; keys without an entry are still left to the
+    // root. Unvalidated keys are skipped as they may not be loadable.
+    mSnapshot->load(accountKey(mSourceAccountID));
+    auto validatedEnd =
+        mStoredLedgerKeys.end() - FuzzUtils::NUM_UNVALIDATED_LEDGER_KEYS;
+    for (auto it = mStoredLedgerKeys.begin(); it != validatedEnd; ++it)
+    {
+        mSnapshot->load(*it);
+    }
 }
 
 void
@@ -1925,28 +1958,29 @@ TransactionFuzzer::reduceTrustLineLimitsAfterSetup(AbstractLedgerTxn& ltxOuter)
 void
 TransactionFuzzer::shutdown()
 {
+    mSnapshot.reset();
     exit(1);
 }
 
 void
 TransactionFuzzer::inject(std::string const& filename)
 {
-    std::ifstream in;
-    in.exceptions(std::ios::badbit);
-    in.open(filename, std::ios::binary);
+    auto bins = readFuzzerInput(filename, xdrSizeLimit());
+    injectBytes(reinterpret_cast<uint8_t const*>(bins.data()), bins.size());
+}
 
-    xdr::xvector<Operation> ops;
-    std::vector<char> bins(xdrSizeLimit());
-    in.read(bins.data(), bins.size());
-    auto actual = in.gcount();
+void
+TransactionFuzzer::injectBytes(uint8_t const* data, size_t size)
+{
     // stop if either
-    // we could read the whole buffer (too much data was generated by the
-    // fuzzer), or got a short read
-    if (actual == xdrSizeLimit() || actual == 0)
+    // the input fills the whole buffer (too much data was generated by the
+    // fuzzer), or is empty
+    if (size >= static_cast<size_t>(xdrSizeLimit()) || size == 0)
     {
         return;
     }
-    bins.resize(actual);
+    xdr::xvector<Operation> ops;
+    std::vector<char> bins(data, data + size);
     try
     {
         xdr::xdr_from_fuzzer_opaque(mStoredLedgerKeys, mStoredPoolIDs, bins,
@@ -1972,7 +2006,8 @@ TransactionFuzzer::inject(std::string const& filename)
     LOG_TRACE(DEFAULT_LOG, "{}",
               xdrToCerealString(ops, fmt::format("Fuzz ops ({})", ops.size())));
 
-    LedgerTxn ltx(mApp->getLedgerTxnRoot());
+    // Rolled back when it goes out of scope, leaving mSnapshot as it was
+    LedgerTxn ltx(*mSnapshot);
     applyFuzzOperations(ltx, mSourceAccountID, ops.begin(), ops.end(), *mApp);
 }
 
@@ -2072,20 +2107,20 @@ OverlayFuzzer::initialize()
 void
 OverlayFuzzer::inject(std::string const& filename)
 {
-    std::ifstream in;
-    in.exceptions(std::ios::badbit);
-    in.open(filename, std::ios::binary);
+    auto bins = readFuzzerInput(filename, xdrSizeLimit());
+    injectBytes(reinterpret_cast<uint8_t const*>(bins.data()), bins.size());
+}
 
-    StellarMessage msg;
-    std::vector<char> bins(xdrSizeLimit());
-    in.read(bins.data(), bins.size());
-    auto actual = in.gcount();
-    // if we could read the whole buffer, or got a short read, stop
-    if (in || actual == 0)
+void
+OverlayFuzzer::injectBytes(uint8_t const* data, size_t size)
+{
+    // if the input fills the whole buffer, or is empty, stop
+    if (size >= static_cast<size_t>(xdrSizeLimit()) || size == 0)
     {
         return;
     }
-    bins.resize(actual);
+    StellarMessage msg;
+    std::vector<char> bins(data, data + size);
     try
     {
         xdr::xdr_from_fuzzer_opaque(mStoredLedgerKeys, mStoredPoolIDs, bins,
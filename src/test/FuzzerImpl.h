@@ -39,6 +39,7 @@ class TransactionFuzzer : public Fuzzer
     {
     }
     void inject(std::string const& filename) override;
+    void injectBytes(uint8_t const* data, size_t size) override;
     void initialize() override;
     void shutdown() override;
     void genFuzz(std::string const& filename) override;
@@ -56,8 +57,15 @@ class TransactionFuzzer : public Fuzzer
     void reduceNativeBalancesAfterSetup(AbstractLedgerTxn& ltxOuter);
     void adjustTrustLineBalancesAfterSetup(AbstractLedgerTxn& ltxOuter);
     void reduceTrustLineLimitsAfterSetup(AbstractLedgerTxn& ltxOuter);
+    // Opens mSnapshot on the setup state committed to the database
+    void openSnapshot();
     VirtualClock mClock;
     std::shared_ptr<Application> mApp;
+    // Child of the root holding every setup entry in memory, under which each
+    // input is applied and rolled back, so that inputs don't go to the
+    // database for the entries they touch. Declared after mApp so that it is
+    // destroyed first.
+    std::unique_ptr<LedgerTxn> mSnapshot;
     PublicKey mSourceAccountID;
     FuzzUtils::StoredLedgerKeys mStoredLedgerKeys;
     FuzzUtils::StoredPoolIDs mStoredPoolIDs;
@@ -73,6 +81,8 @@ class OverlayFuzzer : public Fuzzer
     {
     }
     void inject(std::string const& filename) override;
+    void injectBytes(uint8_t const* data, size_t size) override;
+    void injectBytes(uint8_t const* data, size_t size) override;
     void initialize() override;
     void shutdown() override;
     void genFuzz(std::string const& filename) override;
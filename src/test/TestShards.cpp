@@ -0,0 +1,331 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "test/TestShards.h"
+#include "lib/json/json.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/TmpDir.h"
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace stellar
+{
+
+namespace
+{
+// Instance numbers, and therefore ports and databases, reserved for the tests
+// of each worker; as in selftest-parallel
+int const INSTANCES_PER_SHARD = 50;
+// Number of slowest tests reported after a run
+size_t const SLOWEST_TESTS_REPORTED = 10;
+
+struct TestResult
+{
+    double mSeconds{0};
+    bool mPassed{false};
+};
+
+std::string gTestResultsOutput;
+std::map<std::string, TestResult> gTestResults;
+
+std::string
+quoteArg(std::string const& arg)
+{
+    if (arg.find('"') != std::string::npos)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Can't pass {} to a test worker"), arg));
+    }
+    return "\"" + arg + "\"";
+}
+
+std::map<std::string, TestResult>
+loadTestResults(std::string const& path)
+{
+    std::map<std::string, TestResult> results;
+    std::ifstream in(path);
+    Json::Value root;
+    if (!in || !Json::Reader().parse(in, root))
+    {
+        return results;
+    }
+    for (auto const& r : root["tests"])
+    {
+        results[r["name"].asString()] =
+            TestResult{r["seconds"].asDouble(), r["passed"].asBool()};
+    }
+    return results;
+}
+
+void
+printFile(std::string const& path)
+{
+    std::ifstream in(path);
+    std::cerr << in.rdbuf() << std::endl;
+}
+}
+
+TestDurations
+loadTestDurations(std::string const& path)
+{
+    TestDurations durations;
+    std::ifstream in(path);
+    if (!in)
+    {
+        return durations;
+    }
+    Json::Value root;
+    if (!Json::Reader().parse(in, root))
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Can't parse test durations {}"), path));
+    }
+    for (auto const& name : root.getMemberNames())
+    {
+        durations[name] = root[name].asDouble();
+    }
+    return durations;
+}
+
+void
+saveTestDurations(std::string const& path, TestDurations const& durations)
+{
+    Json::Value root(Json::objectValue);
+    for (auto const& kv : durations)
+    {
+        root[kv.first] = kv.second;
+    }
+    std::ofstream out(path);
+    if (!out)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Can't open test durations {}"), path));
+    }
+    out << Json::StyledWriter().write(root);
+}
+
+std::vector<std::vector<std::string>>
+shardTests(std::vector<std::string> const& tests,
+           TestDurations const& durations, size_t numShards)
+{
+    releaseAssert(numShards != 0);
+
+    std::vector<double> known;
+    for (auto const& kv : durations)
+    {
+        known.emplace_back(kv.second);
+    }
+    double defaultDuration = 1;
+    if (!known.empty())
+    {
+        std::nth_element(known.begin(), known.begin() + known.size() / 2,
+                         known.end());
+        defaultDuration = known[known.size() / 2];
+    }
+
+    std::vector<std::pair<double, std::string>> sorted;
+    for (auto const& t : tests)
+    {
+        auto it = durations.find(t);
+        sorted.emplace_back(it == durations.end() ? defaultDuration
+                                                  : it->second,
+                            t);
+    }
+    // Longest first, by name among equal ones so that shards are stable
+    std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+
+    std::vector<std::vector<std::string>> shards(
+        std::min(numShards, tests.size()));
+    // Shards by total duration, smallest first
+    using Load = std::pair<double, size_t>;
+    std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        loads.emplace(0, i);
+    }
+    for (auto const& t : sorted)
+    {
+        auto load = loads.top();
+        loads.pop();
+        shards[load.second].emplace_back(t.second);
+        loads.emplace(load.first + t.first, load.second);
+    }
+    return shards;
+}
+
+int
+runTestShards(TestShardOptions const& options,
+              std::vector<std::string> const& tests)
+{
+    TestDurations durations;
+    if (!options.mDurationsPath.empty())
+    {
+        durations = loadTestDurations(options.mDurationsPath);
+    }
+    auto shards = shardTests(tests, durations, options.mJobs);
+    LOG_INFO(DEFAULT_LOG, "Running {} tests in {} workers ({} with known "
+                          "durations)",
+             tests.size(), shards.size(),
+             std::count_if(tests.begin(), tests.end(), [&](auto const& t) {
+                 return durations.find(t) != durations.end();
+             }));
+
+    TmpDir dir("stellar-core-test-shards");
+    auto shardPath = [&](size_t i, std::string const& what) {
+        return fmt::format("{}/shard-{}.{}", dir.getName(), i, what);
+    };
+
+    std::vector<int> exitCodes(shards.size(), 0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        {
+            // Catch reads each line of an input file as a test name
+            std::ofstream names(shardPath(i, "tests"));
+            for (auto const& t : shards[i])
+            {
+                names << t << "\n";
+            }
+        }
+
+        std::ostringstream cmd;
+        cmd << quoteArg(options.mExeName) << " test";
+        for (auto const& arg : options.mWorkerArgs)
+        {
+            cmd << " " << quoteArg(arg);
+        }
+        cmd << " --base-instance "
+            << options.mBaseInstance + static_cast<int>(i) * INSTANCES_PER_SHARD
+            << " --input-file " << quoteArg(shardPath(i, "tests"))
+            << " --shard-results " << quoteArg(shardPath(i, "json")) << " > "
+            << quoteArg(shardPath(i, "out")) << " 2>&1";
+        LOG_DEBUG(DEFAULT_LOG, "Test worker {}: {}", i, cmd.str());
+
+        workers.emplace_back([&exitCodes, i, cmd = cmd.str()]() {
+            exitCodes[i] = std::system(cmd.c_str());
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+
+    std::map<std::string, TestResult> results;
+    std::vector<std::string> failed;
+    std::vector<std::string> unfinished;
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        auto shardResults = loadTestResults(shardPath(i, "json"));
+        for (auto const& t : shards[i])
+        {
+            auto it = shardResults.find(t);
+            if (it == shardResults.end())
+            {
+                unfinished.emplace_back(t);
+                continue;
+            }
+            results.emplace(*it);
+            if (!it->second.mPassed)
+            {
+                failed.emplace_back(t);
+            }
+        }
+        if (exitCodes[i] != 0)
+        {
+            std::cerr << fmt::format("Test worker {} exited with {}:", i,
+                                     exitCodes[i])
+                      << std::endl;
+            printFile(shardPath(i, "out"));
+        }
+    }
+
+    std::vector<std::pair<double, std::string>> slowest;
+    for (auto const& kv : results)
+    {
+        slowest.emplace_back(kv.second.mSeconds, kv.first);
+        durations[kv.first] = kv.second.mSeconds;
+    }
+    std::sort(slowest.rbegin(), slowest.rend());
+    slowest.resize(std::min(slowest.size(), SLOWEST_TESTS_REPORTED));
+    for (auto const& s : slowest)
+    {
+        LOG_INFO(DEFAULT_LOG, "Slow test: {:.1f}s {}", s.first, s.second);
+    }
+    if (!options.mDurationsPath.empty())
+    {
+        saveTestDurations(options.mDurationsPath, durations);
+    }
+
+    for (auto const& t : failed)
+    {
+        LOG_ERROR(DEFAULT_LOG, "Failed test: {}", t);
+    }
+    for (auto const& t : unfinished)
+    {
+        LOG_ERROR(DEFAULT_LOG, "Unfinished test: {}", t);
+    }
+    LOG_INFO(DEFAULT_LOG, "{} tests passed, {} failed, {} did not finish",
+             results.size() - failed.size(), failed.size(), unfinished.size());
+
+    bool ok = failed.empty() && unfinished.empty() &&
+              std::all_of(exitCodes.begin(), exitCodes.end(),
+                          [](int c) { return c == 0; });
+    return ok ? 0 : 1;
+}
+
+void
+setTestResultsOutput(std::string const& path)
+{
+    gTestResultsOutput = path;
+}
+
+void
+recordTestResult(std::string const& name, double seconds, bool passed)
+{
+    if (!gTestResultsOutput.empty())
+    {
+        gTestResults[name] = TestResult{seconds, passed};
+    }
+}
+
+void
+writeTestResults()
+{
+    if (gTestResultsOutput.empty())
+    {
+        return;
+    }
+    Json::Value root;
+    auto& tests = root["tests"];
+    tests = Json::arrayValue;
+    for (auto const& kv : gTestResults)
+    {
+        Json::Value r;
+        r["name"] = kv.first;
+        r["seconds"] = kv.second.mSeconds;
+        r["passed"] = kv.second.mPassed;
+        tests.append(r);
+    }
+
+    std::ofstream out(gTestResultsOutput);
+    if (!out)
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("Can't open test results {}"), gTestResultsOutput));
+    }
+    out << Json::StyledWriter().write(root);
+}
+}
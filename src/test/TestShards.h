@@ -0,0 +1,63 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// Runs the tests of `stellar-core test --jobs N` in N worker processes of the
+// same binary. Tests are spread over the workers by their expected durations,
+// read from and written back to the file given with --test-durations. Each
+// worker gets its own range of instance numbers (see --base-instance), hence
+// its own ports, temporary directories and test databases, and reports the
+// result and duration of each of its tests (see setTestResultsOutput), which
+// are merged once all workers are done.
+
+namespace stellar
+{
+
+// Durations of tests in seconds, by test name
+using TestDurations = std::map<std::string, double>;
+
+// Returns no durations if `path` does not exist
+TestDurations loadTestDurations(std::string const& path);
+void saveTestDurations(std::string const& path,
+                       TestDurations const& durations);
+
+// Splits `tests` into at most `numShards` non-empty shards of about the same
+// total duration, assigning the longest tests first each to the shard with
+// the smallest total so far. Tests without a known duration are assumed to
+// take the median of the known ones.
+std::vector<std::vector<std::string>>
+shardTests(std::vector<std::string> const& tests,
+           TestDurations const& durations, size_t numShards);
+
+struct TestShardOptions
+{
+    std::string mExeName;
+    // Arguments of `stellar-core test` passed to every worker
+    std::vector<std::string> mWorkerArgs;
+    size_t mJobs{1};
+    // Empty if durations are neither loaded nor saved
+    std::string mDurationsPath;
+    int mBaseInstance{0};
+};
+
+// Runs `tests` in worker processes and returns 0 if they all passed
+int runTestShards(TestShardOptions const& options,
+                  std::vector<std::string> const& tests);
+
+// Sets the file writeTestResults writes to; results are not recorded if it is
+// not set
+void setTestResultsOutput(std::string const& path);
+
+// Records the outcome of a test case run by this process
+void recordTestResult(std::string const& name, double seconds, bool passed);
+
+// Writes all the results of recordTestResult so far as JSON
+void writeTestResults();
+}
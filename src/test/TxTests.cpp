@@ -709,6 +709,45 @@ transactionFromOperations(Application& app, SecretKey const& from,
     return transactionFromOperationsV1(app, from, seq, ops, fee);
 }
 
+TransactionFramePtr
+unsignedTransactionFromOperations(Application& app, PublicKey const& from,
+                                  SequenceNumber seq,
+                                  std::vector<Operation> const& ops,
+                                  uint32_t fee)
+{
+    if (fee == 0)
+    {
+        fee = static_cast<uint32_t>(
+            (ops.size() * app.getLedgerManager().getLastTxFee()) & UINT32_MAX);
+    }
+
+    TransactionEnvelope e;
+    auto ledgerVersion = app.getLedgerManager()
+                             .getLastClosedLedgerHeader()
+                             .header.ledgerVersion;
+    if (protocolVersionIsBefore(ledgerVersion, ProtocolVersion::V_13))
+    {
+        e.type(ENVELOPE_TYPE_TX_V0);
+        e.v0().tx.sourceAccountEd25519 = from.ed25519();
+        e.v0().tx.fee = fee;
+        e.v0().tx.seqNum = seq;
+        std::copy(std::begin(ops), std::end(ops),
+                  std::back_inserter(e.v0().tx.operations));
+    }
+    else
+    {
+        e.type(ENVELOPE_TYPE_TX);
+        e.v1().tx.sourceAccount = toMuxedAccount(from);
+        e.v1().tx.fee = fee;
+        e.v1().tx.seqNum = seq;
+        std::copy(std::begin(ops), std::end(ops),
+                  std::back_inserter(e.v1().tx.operations));
+    }
+
+    return std::static_pointer_cast<TransactionFrame>(
+        TransactionFrameBase::makeTransactionFromWire(app.getNetworkID(), e));
+}
+
 TransactionFramePtr
 transactionWithV2Precondition(Application& app, TestAccount& account,
                               int64_t sequenceDelta, uint32_t fee,
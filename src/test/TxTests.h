@@ -138,6 +138,12 @@ TransactionFramePtr transactionFromOperations(Application& app,
                                               SequenceNumber seq,
                                               std::vector<Operation> const& ops,
                                               uint32_t fee = 0);
+// Same as transactionFromOperations for the protocol version of the last
+// closed ledger, but does not sign the transaction or open a LedgerTxn, for
+// generating transactions in bulk
+TransactionFramePtr unsignedTransactionFromOperations(
+    Application& app, PublicKey const& from, SequenceNumber seq,
+    std::vector<Operation> const& ops, uint32_t fee = 0);
 TransactionFramePtr transactionWithV2Precondition(Application& app,
                                                   TestAccount& account,
                                                   int64_t sequenceDelta,
@@ -8,6 +8,9 @@
 #include "util/XDRStream.h"
 #include "util/types.h"
 
+#include <cstdint>
+#include <fmt/format.h>
+#include <stdexcept>
 #include <xdrpp/autocheck.h>
 /**
  * This is a very simple fuzzer _stub_. It's intended to be run under an
@@ -25,8 +28,20 @@
  *     input. This is the mode the external fuzzer will run its mutant inputs
  *     through.
  *
+ * In builds configured with --enable-libfuzzer there is also libfuzz mode,
+ * where libFuzzer runs in-process and hands its inputs to a fuzzer that is
+ * only initialized once.
+ *
  */
 
+#ifdef LIBFUZZER_MODE
+// Entry point of libFuzzer for programs with their own main, see
+// https://llvm.org/docs/LibFuzzer.html#using-libfuzzer-as-a-library
+extern "C" int LLVMFuzzerRunDriver(int* argc, char*** argv,
+                                   int (*userCb)(uint8_t const* data,
+                                                 size_t size));
+#endif // LIBFUZZER_MODE
+
 namespace stellar
 {
 namespace FuzzUtils
@@ -47,6 +62,21 @@ createFuzzer(int processID, FuzzerMode fuzzerMode)
 }
 }
 
+#ifdef LIBFUZZER_MODE
+namespace
+{
+// The fuzzer of libFuzz, as libFuzzer only takes a plain function
+Fuzzer* gLibFuzzerTarget = nullptr;
+
+int
+injectLibFuzzerInput(uint8_t const* data, size_t size)
+{
+    gLibFuzzerTarget->injectBytes(data, size);
+    return 0;
+}
+}
+#endif // LIBFUZZER_MODE
+
 #define PERSIST_MAX 1000000
 void
 fuzz(std::string const& filename, std::vector<std::string> const& metrics,
@@ -67,4 +97,43 @@ fuzz(std::string const& filename, std::vector<std::string> const& metrics,
     cleanupTmpDirs();
     fuzzer->shutdown();
 }
+
+int
+libFuzz(std::string const& corpusDir,
+        std::vector<std::string> const& fuzzerArgs, int processID,
+        FuzzerMode fuzzerMode)
+{
+#ifdef LIBFUZZER_MODE
+    auto fuzzer = FuzzUtils::createFuzzer(processID, fuzzerMode);
+    fuzzer->initialize();
+
+    // Inputs as large as xdrSizeLimit() are rejected anyway; later arguments
+    // take precedence, so `fuzzerArgs` may still override this
+    std::vector<std::string> args{
+        "stellar-core",
+        fmt::format("-max_len={}", fuzzer->xdrSizeLimit() - 1)};
+    args.insert(args.end(), fuzzerArgs.begin(), fuzzerArgs.end());
+    args.emplace_back(corpusDir);
+
+    std::vector<char*> argv;
+    for (auto& arg : args)
+    {
+        argv.emplace_back(arg.data());
+    }
+    argv.emplace_back(nullptr);
+    int argc = static_cast<int>(args.size());
+    char** argvPtr = argv.data();
+
+    gLibFuzzerTarget = fuzzer.get();
+    int res = LLVMFuzzerRunDriver(&argc, &argvPtr, injectLibFuzzerInput);
+    gLibFuzzerTarget = nullptr;
+
+    cleanupTmpDirs();
+    fuzzer->shutdown();
+    return res;
+#else
+    throw std::runtime_error(
+        "libfuzz requires a build configured with --enable-libfuzzer");
+#endif // LIBFUZZER_MODE
+}
 }
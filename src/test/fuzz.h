@@ -26,4 +26,12 @@ std::unique_ptr<Fuzzer> createFuzzer(int processID, FuzzerMode fuzzerMode);
 
 void fuzz(std::string const& filename, std::vector<std::string> const& metrics,
           int processID, FuzzerMode fuzzerMode);
+
+// Runs libFuzzer's in-process loop over the inputs of `corpusDir`, injecting
+// each input into a single fuzzer initialized once, and returns libFuzzer's
+// exit code. `fuzzerArgs` are passed to libFuzzer as they are. Only available
+// in builds configured with --enable-libfuzzer.
+int libFuzz(std::string const& corpusDir,
+            std::vector<std::string> const& fuzzerArgs, int processID,
+            FuzzerMode fuzzerMode);
 }
@@ -19,6 +19,8 @@
 #include "main/StellarCoreVersion.h"
 #include "main/dumpxdr.h"
 #include "test.h"
+#include "test/Benchmark.h"
+#include "test/TestShards.h"
 #include "test/TestUtils.h"
 #include "util/Logging.h"
 #include "util/Math.h"
@@ -26,6 +28,7 @@
 #include "util/TmpDir.h"
 #include "util/XDRCereal.h"
 
+#include <chrono>
 #include <cstdlib>
 #include <fmt/format.h>
 #include <numeric>
@@ -134,6 +137,31 @@ struct TestContextListener : Catch::TestEventListenerBase
 
 CATCH_REGISTER_LISTENER(TestContextListener)
 
+// A Catch event-listener records the duration and outcome of every test case
+// for the parent process of a sharded run (see TestShards.h)
+struct TestResultListener : Catch::TestEventListenerBase
+{
+    using TestEventListenerBase::TestEventListenerBase;
+    std::chrono::steady_clock::time_point mStart;
+
+    void
+    testCaseStarting(Catch::TestCaseInfo const& testInfo) override
+    {
+        mStart = std::chrono::steady_clock::now();
+    }
+    void
+    testCaseEnded(Catch::TestCaseStats const& testCaseStats) override
+    {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - mStart;
+        recordTestResult(testCaseStats.testInfo.name, elapsed.count(),
+                         testCaseStats.totals.assertions.failed == 0 &&
+                             testCaseStats.totals.testCases.failed == 0);
+    }
+};
+
+CATCH_REGISTER_LISTENER(TestResultListener)
+
 namespace stdfs = std::filesystem;
 std::optional<Catch::TestCaseInfo> TestContextListener::sTestCtx;
 std::vector<Catch::SectionInfo> TestContextListener::sSectCtx;
@@ -230,6 +258,7 @@ getTestConfig(int instanceNumber, Config::TestDbMode mode)
         thisConfig.BUCKET_DIR_PATH = rootDir + "bucket";
 
         thisConfig.INVARIANT_CHECKS = {".*"};
+        thisConfig.SOROBAN_FEE_PARITY_CHECKS = true;
 
         thisConfig.ALLOW_LOCALHOST_FOR_TESTING = true;
 
@@ -334,11 +363,17 @@ runTest(CommandLineArgs const& args)
     std::string recordTestTxMeta;
     std::string checkTestTxMeta;
     std::string debugTestTxMeta;
+    std::string benchOutput;
+    std::string logLevelArg;
+    size_t jobs = 1;
+    std::string testDurations;
+    std::string shardResults;
 
     auto parser = session.cli();
     parser |= Catch::clara::Opt(
         [&](std::string const& arg) {
             logLevel = Logging::getLLfromString(arg);
+            logLevelArg = arg;
         },
         "LEVEL")["--ll"]("set the log level");
     parser |= Catch::clara::Opt(gTestMetrics, "METRIC-NAME")["--metric"](
@@ -359,6 +394,15 @@ runTest(CommandLineArgs const& args)
     parser |=
         Catch::clara::Opt(debugTestTxMeta, "FILENAME")["--debug-test-tx-meta"](
             "dump full TxMeta from all tests to FILENAME");
+    parser |= Catch::clara::Opt(benchOutput, "FILENAME")["--bench-output"](
+        "write benchmark results as JSON to FILENAME");
+    parser |= Catch::clara::Opt(jobs, "N")["--jobs"](
+        "run the matching tests in N worker processes");
+    parser |= Catch::clara::Opt(testDurations, "FILENAME")["--test-durations"](
+        "with --jobs, balance workers by the test durations in FILENAME and "
+        "update them");
+    parser |= Catch::clara::Opt(shardResults, "FILENAME")["--shard-results"](
+        "write the duration and outcome of each test as JSON to FILENAME");
 
     session.cli(parser);
 
@@ -420,6 +464,8 @@ runTest(CommandLineArgs const& args)
         gDebugTestTxMeta.emplace(debugTestTxMeta);
         releaseAssert(gDebugTestTxMeta.value().good());
     }
+    setBenchmarkOutput(benchOutput);
+    setTestResultsOutput(shardResults);
 
     // Note: Have to setLogLevel twice here to ensure --list-test-names-only is
     // not mixed with stellar-core logging.
@@ -435,6 +481,48 @@ runTest(CommandLineArgs const& args)
     LOG_INFO(DEFAULT_LOG, "Testing stellar-core {}", STELLAR_CORE_VERSION);
     LOG_INFO(DEFAULT_LOG, "Logging to {}", logFile);
 
+    if (jobs > 1)
+    {
+        if (gTestTxMetaMode != TestTxMetaMode::META_TEST_IGNORE ||
+            gDebugTestTxMeta)
+        {
+            LOG_ERROR(DEFAULT_LOG,
+                      "Option --jobs can't be combined with TxMeta options");
+            return 1;
+        }
+
+        TestShardOptions options;
+        options.mExeName = args.mExeName;
+        options.mJobs = jobs;
+        options.mDurationsPath = testDurations;
+        options.mBaseInstance = gBaseInstance;
+        auto& workerArgs = options.mWorkerArgs;
+        workerArgs = {"--rng-seed", std::to_string(seed)};
+        if (!logLevelArg.empty())
+        {
+            workerArgs.insert(workerArgs.end(), {"--ll", logLevelArg});
+        }
+        for (auto v : gVersionsToTest)
+        {
+            workerArgs.insert(workerArgs.end(),
+                              {"--version", std::to_string(v)});
+        }
+        for (auto const& m : gTestMetrics)
+        {
+            workerArgs.insert(workerArgs.end(), {"--metric", m});
+        }
+
+        auto const& config = session.config();
+        std::vector<std::string> tests;
+        for (auto const& tc : Catch::filterTests(
+                 Catch::getAllTestCasesSorted(config), config.testSpec(),
+                 config))
+        {
+            tests.emplace_back(tc.name);
+        }
+        return runTestShards(options, tests);
+    }
+
     auto r = session.run();
     // In the 'list' modes Catch returns the number of tests listed. We don't
     // want to treat this value as and error code.
@@ -459,6 +547,8 @@ runTest(CommandLineArgs const& args)
     {
         reportTestTxMeta();
     }
+    writeBenchmarkResults();
+    writeTestResults();
     return r;
 }
 
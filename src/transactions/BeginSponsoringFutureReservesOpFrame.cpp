@@ -8,7 +8,7 @@
 #include "ledger/LedgerTxnEntry.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
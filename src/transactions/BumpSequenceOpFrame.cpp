@@ -9,8 +9,8 @@
 #include "transactions/TransactionFrame.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
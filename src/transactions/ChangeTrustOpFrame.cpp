@@ -13,7 +13,7 @@
 #include "transactions/SponsorshipUtils.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
@@ -46,36 +46,30 @@ ChangeTrustOpFrame::managePoolOnDeletedTrustLine(AbstractLedgerTxn& ltx,
 }
 
 bool
-ChangeTrustOpFrame::tryIncrementPoolUseCount(AbstractLedgerTxn& ltx,
-                                             Asset const& asset)
+ChangeTrustOpFrame::tryIncrementPoolUseCount(LedgerTxnEntry& assetTrustLine)
 {
-    if (!isIssuer(getSourceID(), asset) && asset.type() != ASSET_TYPE_NATIVE)
+    if (!assetTrustLine)
     {
-        auto assetTrustLine = ltx.load(trustlineKey(getSourceID(), asset));
-        if (!assetTrustLine)
-        {
-            innerResult().code(CHANGE_TRUST_TRUST_LINE_MISSING);
-            return false;
-        }
-
-        if (!isAuthorizedToMaintainLiabilities(assetTrustLine))
-        {
-            innerResult().code(CHANGE_TRUST_NOT_AUTH_MAINTAIN_LIABILITIES);
-            return false;
-        }
+        innerResult().code(CHANGE_TRUST_TRUST_LINE_MISSING);
+        return false;
+    }
 
-        if (prepareTrustLineEntryExtensionV2(
-                assetTrustLine.current().data.trustLine())
-                .liquidityPoolUseCount == INT32_MAX)
-        {
-            throw std::runtime_error("liquidityPoolUseCount is INT32_MAX");
-        }
+    if (!isAuthorizedToMaintainLiabilities(assetTrustLine))
+    {
+        innerResult().code(CHANGE_TRUST_NOT_AUTH_MAINTAIN_LIABILITIES);
+        return false;
+    }
 
-        ++prepareTrustLineEntryExtensionV2(
-              assetTrustLine.current().data.trustLine())
-              .liquidityPoolUseCount;
+    if (prepareTrustLineEntryExtensionV2(
+            assetTrustLine.current().data.trustLine())
+            .liquidityPoolUseCount == INT32_MAX)
+    {
+        throw std::runtime_error("liquidityPoolUseCount is INT32_MAX");
     }
 
+    ++prepareTrustLineEntryExtensionV2(
+          assetTrustLine.current().data.trustLine())
+          .liquidityPoolUseCount;
     return true;
 }
 
@@ -90,14 +84,30 @@ ChangeTrustOpFrame::tryManagePoolOnNewTrustLine(AbstractLedgerTxn& ltx,
         return true;
     }
 
+    // Load the trust lines of the pool's assets (the source has none for a
+    // native asset or one it issues) together with the pool itself
     auto const& cpParams = mChangeTrust.line.liquidityPool().constantProduct();
-    if (!tryIncrementPoolUseCount(ltxInner, cpParams.assetA) ||
-        !tryIncrementPoolUseCount(ltxInner, cpParams.assetB))
+    std::vector<InternalLedgerKey> keys;
+    for (auto const* asset : {&cpParams.assetA, &cpParams.assetB})
     {
-        return false;
+        if (!isIssuer(getSourceID(), *asset) &&
+            asset->type() != ASSET_TYPE_NATIVE)
+        {
+            keys.emplace_back(trustlineKey(getSourceID(), *asset));
+        }
     }
+    keys.emplace_back(liquidityPoolKey(tlAsset.liquidityPoolID()));
+    auto entries = ltxInner.loadBatch(keys);
 
-    auto poolLtxEntry = loadLiquidityPool(ltxInner, tlAsset.liquidityPoolID());
+    for (size_t i = 0; i + 1 < entries.size(); ++i)
+    {
+        if (!tryIncrementPoolUseCount(entries[i]))
+        {
+            return false;
+        }
+    }
+
+    auto& poolLtxEntry = entries.back();
     if (poolLtxEntry)
     {
         auto& cp =
@@ -17,7 +17,7 @@ class ChangeTrustOpFrame : public OperationFrame
     }
     ChangeTrustOp const& mChangeTrust;
 
-    bool tryIncrementPoolUseCount(AbstractLedgerTxn& ltx, Asset const& asset);
+    bool tryIncrementPoolUseCount(LedgerTxnEntry& assetTrustLine);
 
     bool tryManagePoolOnNewTrustLine(AbstractLedgerTxn& ltx,
                                      TrustLineAsset const& tlAsset);
@@ -6,7 +6,7 @@
 #include "TransactionUtils.h"
 #include "ledger/LedgerManagerImpl.h"
 #include "ledger/LedgerTypeUtils.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
@@ -217,6 +217,7 @@ void
 ExtendFootprintTTLOpFrame::insertLedgerKeysToPrefetch(
     UnorderedSet<LedgerKey>& keys) const
 {
+    insertKeysWithTTL(mParentTx.sorobanResources().footprint.readOnly, keys);
 }
 
 bool
@@ -116,7 +116,10 @@ FeeBumpTransactionFrame::apply(Application& app, AbstractLedgerTxn& ltx,
     {
         LedgerTxn ltxTx(ltx);
         removeOneTimeSignerKeyFromFeeSource(ltxTx);
-        meta.pushTxChangesBefore(ltxTx.getChanges());
+        if (meta.isEnabled())
+        {
+            meta.pushTxChangesBefore(ltxTx.getChanges());
+        }
         ltxTx.commit();
     }
     catch (std::exception& e)
@@ -411,8 +414,8 @@ FeeBumpTransactionFrame::getContentsHash() const
 {
     if (isZero(mContentsHash))
     {
-        mContentsHash = sha256(xdr::xdr_to_opaque(
-            mNetworkID, ENVELOPE_TYPE_TX_FEE_BUMP, mEnvelope.feeBump().tx));
+        mContentsHash = xdrSha256(mNetworkID, ENVELOPE_TYPE_TX_FEE_BUMP,
+                                  mEnvelope.feeBump().tx);
     }
     return mContentsHash;
 }
@@ -422,7 +425,7 @@ FeeBumpTransactionFrame::getFullHash() const
 {
     if (isZero(mFullHash))
     {
-        mFullHash = sha256(xdr::xdr_to_opaque(mEnvelope));
+        mFullHash = xdrSha256(mEnvelope);
     }
     return mFullHash;
 }
@@ -509,6 +512,39 @@ FeeBumpTransactionFrame::insertKeysForFeeProcessing(
     mInnerTx->insertKeysForFeeProcessing(keys);
 }
 
+void
+FeeBumpTransactionFrame::insertSignaturesToVerify(
+    std::vector<EnvelopeSignatures>& sigs) const
+{
+    auto& res = sigs.emplace_back();
+    res.mContentsHash = getContentsHash();
+    res.mSignatures = mEnvelope.feeBump().signatures;
+    res.mAccounts.emplace_back(getFeeSourceID());
+    mInnerTx->insertSignaturesToVerify(sigs);
+}
+
+void
+FeeBumpTransactionFrame::setSignaturesTrusted()
+{
+    // Only the inner transaction's signatures are checked on apply
+    mInnerTx->setSignaturesTrusted();
+}
+
+FeePair
+FeeBumpTransactionFrame::computePreApplySorobanResourceFee(
+    uint32_t protocolVersion, SorobanNetworkConfig const& sorobanConfig,
+    Config const& cfg) const
+{
+    return mInnerTx->computePreApplySorobanResourceFee(protocolVersion,
+                                                       sorobanConfig, cfg);
+}
+
+void
+FeeBumpTransactionFrame::setPreApplySorobanResourceFee(FeePair const& fee)
+{
+    mInnerTx->setPreApplySorobanResourceFee(fee);
+}
+
 void
 FeeBumpTransactionFrame::insertKeysForTxApply(
     UnorderedSet<LedgerKey>& keys) const
@@ -98,6 +98,9 @@ class FeeBumpTransactionFrame : public TransactionFrameBase
 
     void
     insertKeysForFeeProcessing(UnorderedSet<LedgerKey>& keys) const override;
+    void insertSignaturesToVerify(
+        std::vector<EnvelopeSignatures>& sigs) const override;
+    void setSignaturesTrusted() override;
     void insertKeysForTxApply(UnorderedSet<LedgerKey>& keys) const override;
 
     void processFeeSeqNum(AbstractLedgerTxn& ltx,
@@ -115,5 +118,10 @@ class FeeBumpTransactionFrame : public TransactionFrameBase
     xdr::xvector<DiagnosticEvent> const& getDiagnosticEvents() const override;
     virtual int64 declaredSorobanResourceFee() const override;
     virtual bool XDRProvidesValidFee() const override;
+
+    FeePair computePreApplySorobanResourceFee(
+        uint32_t protocolVersion, SorobanNetworkConfig const& sorobanConfig,
+        Config const& cfg) const override;
+    void setPreApplySorobanResourceFee(FeePair const& fee) override;
 };
 }
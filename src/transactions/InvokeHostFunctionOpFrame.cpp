@@ -15,9 +15,12 @@
 #include "rust/RustVecXdrMarshal.h"
 // clang-format on
 
+#include "ledger/ContractCodeCache.h"
+#include "ledger/SorobanContractProfiler.h"
 #include "ledger/LedgerTxnImpl.h"
 #include "rust/CppShims.h"
 #include "xdr/Stellar-transaction.h"
+#include <algorithm>
 #include <stdexcept>
 #include <xdrpp/xdrpp/printer.h>
 
@@ -27,7 +30,7 @@
 #include "ledger/LedgerTypeUtils.h"
 #include "rust/RustBridge.h"
 #include "transactions/InvokeHostFunctionOpFrame.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <crypto/SHA.h>
 
 namespace stellar
@@ -54,6 +57,57 @@ toCxxBuf(T const& t)
     return CxxBuf{std::make_unique<std::vector<uint8_t>>(toVec(t))};
 }
 
+// ContractCode entries are taken from the code cache, which saves encoding
+// the WASM of frequently invoked contracts again for every invocation
+CxxBuf
+toLedgerEntryCxxBuf(LedgerEntry const& le, ContractCodeCache& codeCache,
+                    bool& codeCached)
+{
+    if (le.data.type() != CONTRACT_CODE)
+    {
+        return toCxxBuf(le);
+    }
+    bool hit = false;
+    auto encoded = codeCache.getEncoded(le, hit);
+    codeCached = codeCached || hit;
+    return CxxBuf{std::make_unique<std::vector<uint8_t>>(*encoded)};
+}
+
+// Whether `le` is the instance of the built-in Stellar Asset Contract at
+// `contract`
+bool
+isStellarAssetContractInstance(LedgerEntry const& le, SCAddress const& contract)
+{
+    if (le.data.type() != CONTRACT_DATA)
+    {
+        return false;
+    }
+    auto const& cd = le.data.contractData();
+    return cd.contract == contract &&
+           cd.key.type() == SCV_LEDGER_KEY_CONTRACT_INSTANCE &&
+           cd.val.type() == SCV_CONTRACT_INSTANCE &&
+           cd.val.instance().executable.type() ==
+               CONTRACT_EXECUTABLE_STELLAR_ASSET;
+}
+
+// Returns the key of the footprint entry that the host returned exactly as
+// it was passed in, if any. Such entries don't need to be decoded again.
+LedgerKey const*
+findUnchangedEntry(RustBuf const& buf, rust::Vec<CxxBuf> const& readBufs,
+                   std::vector<LedgerKey const*> const& readKeys)
+{
+    for (size_t i = 0; i < readBufs.size(); ++i)
+    {
+        auto const& data = *readBufs[i].data;
+        if (data.size() == buf.data.size() &&
+            std::equal(data.begin(), data.end(), buf.data.begin()))
+        {
+            return readKeys[i];
+        }
+    }
+    return nullptr;
+}
+
 CxxLedgerInfo
 getLedgerInfo(AbstractLedgerTxn& ltx, Application& app,
               SorobanNetworkConfig const& sorobanConfig)
@@ -86,6 +140,15 @@ getLedgerInfo(AbstractLedgerTxn& ltx, Application& app,
     return info;
 }
 
+bool
+sameCxxBufs(rust::Vec<CxxBuf> const& a, rust::Vec<CxxBuf> const& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](CxxBuf const& x, CxxBuf const& y) {
+                          return *x.data == *y.data;
+                      });
+}
+
 DiagnosticEvent
 metricsEvent(bool success, std::string&& topic, uint64_t value)
 {
@@ -140,6 +203,15 @@ struct HostFunctionMetrics
 
     bool mSuccess{false};
 
+    // Set for direct calls to a built-in Stellar Asset Contract
+    bool mStellarAssetCall{false};
+
+    // Set for contract calls, which are also profiled per contract
+    SorobanContractProfiler* mProfiler{nullptr};
+    Hash mContractID;
+    std::string mFunction;
+    int64_t mResourceFee{0};
+
     HostFunctionMetrics(SorobanMetrics& metrics) : mMetrics(metrics)
     {
     }
@@ -207,6 +279,11 @@ struct HostFunctionMetrics
         mMetrics.mHostFnOpCpuInsnExclVm.Mark(mCpuInsnExclVm);
         mMetrics.mHostFnOpInvokeTimeNsecsExclVm.Update(
             std::chrono::nanoseconds(mInvokeTimeNsecsExclVm));
+        if (mStellarAssetCall)
+        {
+            mMetrics.mHostFnOpStellarAssetInvokeTimeNsecs.Update(
+                std::chrono::nanoseconds(mInvokeTimeNsecs));
+        }
         mMetrics.mHostFnOpInvokeTimeFsecsCpuInsnRatio.Update(
             mInvokeTimeNsecs * 1000000 / std::max(mCpuInsn, uint64_t(1)));
         mMetrics.mHostFnOpInvokeTimeFsecsCpuInsnRatioExclVm.Update(
@@ -218,6 +295,21 @@ struct HostFunctionMetrics
         mMetrics.mHostFnOpMaxRwCodeByte.Mark(mMaxReadWriteCodeByte);
         mMetrics.mHostFnOpMaxEmitEventByte.Mark(mMaxEmitEventByte);
 
+        if (mProfiler)
+        {
+            SorobanContractProfiler::Usage usage;
+            usage.mInvocations = 1;
+            usage.mCpuInsn = mCpuInsn;
+            usage.mInvokeTimeNsecs = mInvokeTimeNsecs;
+            usage.mMemByte = mMemByte;
+            usage.mReadEntry = mReadEntry;
+            usage.mWriteEntry = mWriteEntry;
+            usage.mReadByte = mLedgerReadByte;
+            usage.mWriteByte = mLedgerWriteByte;
+            usage.mResourceFee = mResourceFee;
+            mProfiler->noteInvocation(mContractID, mFunction, usage);
+        }
+
         if (mSuccess)
         {
             mMetrics.mHostFnOpSuccess.Mark();
@@ -242,12 +334,119 @@ InvokeHostFunctionOpFrame::InvokeHostFunctionOpFrame(Operation const& op,
 {
 }
 
+void
+PrecomputedHostInvocation::invoke()
+{
+    ZoneScoped;
+    try
+    {
+        mOutput = rust_bridge::invoke_host_function(
+            mProtocolVersion, mEnableDiagnostics, mInstructions,
+            mHostFunctionBuf, mResourcesBuf, mSourceAccountBuf,
+            mAuthEntryCxxBufs, std::move(mLedgerInfo), mLedgerEntryCxxBufs,
+            mTtlEntryCxxBufs, mBasePrngSeedBuf, mRentFeeConfiguration);
+        mInvoked = true;
+    }
+    catch (std::exception& e)
+    {
+        // doApply invokes the host again and handles the error
+        CLOG_DEBUG(Tx, "Exception caught while precomputing host fn: {}",
+                   e.what());
+    }
+}
+
 bool
 InvokeHostFunctionOpFrame::isOpSupported(LedgerHeader const& header) const
 {
     return header.ledgerVersion >= 20;
 }
 
+std::shared_ptr<PrecomputedHostInvocation>
+InvokeHostFunctionOpFrame::prepareHostInvocation(
+    Application& app, AbstractLedgerTxn& ltx,
+    Hash const& sorobanBasePrngSeed) const
+{
+    ZoneScoped;
+    Config const& appConfig = app.getConfig();
+    auto const& sorobanConfig =
+        app.getLedgerManager().getSorobanNetworkConfig();
+    auto const& resources = mParentTx.sorobanResources();
+    auto const& footprint = resources.footprint;
+    auto ledgerSeq = ltx.getHeader().ledgerSeq;
+    auto& codeCache = app.getLedgerManager().getContractCodeCache();
+    bool codeCached = false;
+
+    auto res = std::make_shared<PrecomputedHostInvocation>();
+    res->mLedgerEntryCxxBufs.reserve(footprint.readOnly.size() +
+                                     footprint.readWrite.size());
+    res->mTtlEntryCxxBufs.reserve(footprint.readOnly.size() +
+                                  footprint.readWrite.size());
+
+    // Same reads as in doApply, which also checks them against the resource
+    // limits before using the invocation
+    for (auto const* keys : {&footprint.readOnly, &footprint.readWrite})
+    {
+        for (auto const& lk : *keys)
+        {
+            std::optional<TTLEntry> ttlEntry;
+            if (isSorobanEntry(lk))
+            {
+                auto ttlLtxe = ltx.loadWithoutRecord(getTTLKey(lk));
+                if (!ttlLtxe)
+                {
+                    continue;
+                }
+                if (!isLive(ttlLtxe.current(), ledgerSeq))
+                {
+                    if (!isTemporaryEntry(lk))
+                    {
+                        return nullptr;
+                    }
+                    continue;
+                }
+                ttlEntry = ttlLtxe.current().data.ttl();
+            }
+
+            auto ltxe = ltx.loadWithoutRecord(lk);
+            if (ltxe)
+            {
+                res->mLedgerEntryCxxBufs.emplace_back(toLedgerEntryCxxBuf(
+                    ltxe.current(), codeCache, codeCached));
+                res->mTtlEntryCxxBufs.emplace_back(
+                    ttlEntry
+                        ? toCxxBuf(*ttlEntry)
+                        : CxxBuf{std::make_unique<std::vector<uint8_t>>()});
+            }
+        }
+    }
+
+    res->mAuthEntryCxxBufs.reserve(mInvokeHostFunction.auth.size());
+    for (auto const& authEntry : mInvokeHostFunction.auth)
+    {
+        res->mAuthEntryCxxBufs.emplace_back(toCxxBuf(authEntry));
+    }
+    res->mHostFunctionBuf = toCxxBuf(mInvokeHostFunction.hostFunction);
+    res->mResourcesBuf = toCxxBuf(resources);
+    res->mSourceAccountBuf = toCxxBuf(getSourceID());
+    res->mBasePrngSeed = sorobanBasePrngSeed;
+    res->mBasePrngSeedBuf.data = std::make_unique<std::vector<uint8_t>>(
+        sorobanBasePrngSeed.begin(), sorobanBasePrngSeed.end());
+    res->mLedgerInfo = getLedgerInfo(ltx, app, sorobanConfig);
+    res->mRentFeeConfiguration =
+        sorobanConfig.rustBridgeRentFeeConfiguration();
+    res->mProtocolVersion = appConfig.CURRENT_LEDGER_PROTOCOL_VERSION;
+    res->mEnableDiagnostics = appConfig.ENABLE_SOROBAN_DIAGNOSTIC_EVENTS;
+    res->mInstructions = resources.instructions;
+    return res;
+}
+
+void
+InvokeHostFunctionOpFrame::setPrecomputedHostInvocation(
+    std::shared_ptr<PrecomputedHostInvocation> invocation)
+{
+    mPrecomputedHostInvocation = std::move(invocation);
+}
+
 bool
 InvokeHostFunctionOpFrame::doApply(AbstractLedgerTxn& ltx)
 {
@@ -333,10 +532,27 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
     auto timeScope = metrics.getExecTimer();
     auto const& sorobanConfig =
         app.getLedgerManager().getSorobanNetworkConfig();
+    auto& codeCache = app.getLedgerManager().getContractCodeCache();
+    bool codeCached = false;
+
+    auto const& hostFn = mInvokeHostFunction.hostFunction;
+    if (hostFn.type() == HOST_FUNCTION_TYPE_INVOKE_CONTRACT &&
+        hostFn.invokeContract().contractAddress.type() ==
+            SC_ADDRESS_TYPE_CONTRACT)
+    {
+        metrics.mProfiler =
+            &app.getLedgerManager().getSorobanContractProfiler();
+        metrics.mContractID =
+            hostFn.invokeContract().contractAddress.contractId();
+        metrics.mFunction = hostFn.invokeContract().functionName;
+        metrics.mResourceFee = mParentTx.declaredSorobanResourceFee();
+    }
 
     // Get the entries for the footprint
     rust::Vec<CxxBuf> ledgerEntryCxxBufs;
     rust::Vec<CxxBuf> ttlEntryCxxBufs;
+    // Key of each entry in ledgerEntryCxxBufs
+    std::vector<LedgerKey const*> ledgerEntryKeys;
 
     auto const& resources = mParentTx.sorobanResources();
     auto const& footprint = resources.footprint;
@@ -345,10 +561,11 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
 
     ledgerEntryCxxBufs.reserve(footprintLength);
     ttlEntryCxxBufs.reserve(footprintLength);
+    ledgerEntryKeys.reserve(footprintLength);
 
-    auto addReads = [&ledgerEntryCxxBufs, &ttlEntryCxxBufs, &ltx, &metrics,
-                     &resources, &sorobanConfig, &appConfig,
-                     this](auto const& keys) -> bool {
+    auto addReads = [&ledgerEntryCxxBufs, &ttlEntryCxxBufs, &ledgerEntryKeys,
+                     &ltx, &metrics, &resources, &sorobanConfig, &appConfig,
+                     &codeCache, &codeCached, this](auto const& keys) -> bool {
         for (auto const& lk : keys)
         {
             uint32_t keySize = static_cast<uint32_t>(xdr::xdr_size(lk));
@@ -409,7 +626,16 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
                 auto ltxe = ltx.loadWithoutRecord(lk);
                 if (ltxe)
                 {
-                    auto leBuf = toCxxBuf(ltxe.current());
+                    auto leBuf = toLedgerEntryCxxBuf(ltxe.current(),
+                                                     codeCache, codeCached);
+                    if (metrics.mProfiler &&
+                        isStellarAssetContractInstance(
+                            ltxe.current(), mInvokeHostFunction.hostFunction
+                                                .invokeContract()
+                                                .contractAddress))
+                    {
+                        metrics.mStellarAssetCall = true;
+                    }
                     entrySize = static_cast<uint32_t>(leBuf.data->size());
 
                     // For entry types that don't have an ttlEntry (i.e.
@@ -423,6 +649,7 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
 
                     ledgerEntryCxxBufs.emplace_back(std::move(leBuf));
                     ttlEntryCxxBufs.emplace_back(std::move(ttlBuf));
+                    ledgerEntryKeys.emplace_back(&lk);
                 }
                 else if (isSorobanEntry(lk))
                 {
@@ -474,29 +701,56 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
         authEntryCxxBufs.emplace_back(toCxxBuf(authEntry));
     }
 
+    // Everything but the footprint entries is the same for the whole ledger,
+    // so a precomputed invocation only needs to have read the same entries
+    auto precomputed = std::move(mPrecomputedHostInvocation);
+    bool usePrecomputed =
+        precomputed && precomputed->mInvoked &&
+        precomputed->mBasePrngSeed == sorobanBasePrngSeed &&
+        sameCxxBufs(precomputed->mLedgerEntryCxxBufs, ledgerEntryCxxBufs) &&
+        sameCxxBufs(precomputed->mTtlEntryCxxBufs, ttlEntryCxxBufs);
+    if (precomputed && !usePrecomputed)
+    {
+        CLOG_DEBUG(Tx, "Discarding precomputed host invocation");
+    }
+
     InvokeHostFunctionOutput out{};
     out.success = false;
     try
     {
-        CxxBuf basePrngSeedBuf{};
-        basePrngSeedBuf.data = std::make_unique<std::vector<uint8_t>>();
-        basePrngSeedBuf.data->assign(sorobanBasePrngSeed.begin(),
-                                     sorobanBasePrngSeed.end());
-
-        out = rust_bridge::invoke_host_function(
-            appConfig.CURRENT_LEDGER_PROTOCOL_VERSION,
-            appConfig.ENABLE_SOROBAN_DIAGNOSTIC_EVENTS, resources.instructions,
-            toCxxBuf(mInvokeHostFunction.hostFunction), toCxxBuf(resources),
-            toCxxBuf(getSourceID()), authEntryCxxBufs,
-            getLedgerInfo(ltx, app, sorobanConfig), ledgerEntryCxxBufs,
-            ttlEntryCxxBufs, basePrngSeedBuf,
-            sorobanConfig.rustBridgeRentFeeConfiguration());
+        if (usePrecomputed)
+        {
+            out = std::move(precomputed->mOutput);
+            metrics.mMetrics.mHostFnOpPrecomputed.Mark();
+        }
+        else
+        {
+            CxxBuf basePrngSeedBuf{};
+            basePrngSeedBuf.data = std::make_unique<std::vector<uint8_t>>();
+            basePrngSeedBuf.data->assign(sorobanBasePrngSeed.begin(),
+                                         sorobanBasePrngSeed.end());
+
+            out = rust_bridge::invoke_host_function(
+                appConfig.CURRENT_LEDGER_PROTOCOL_VERSION,
+                appConfig.ENABLE_SOROBAN_DIAGNOSTIC_EVENTS,
+                resources.instructions,
+                toCxxBuf(mInvokeHostFunction.hostFunction),
+                toCxxBuf(resources), toCxxBuf(getSourceID()),
+                authEntryCxxBufs, getLedgerInfo(ltx, app, sorobanConfig),
+                ledgerEntryCxxBufs, ttlEntryCxxBufs, basePrngSeedBuf,
+                sorobanConfig.rustBridgeRentFeeConfiguration());
+        }
         metrics.mCpuInsn = out.cpu_insns;
         metrics.mMemByte = out.mem_bytes;
         metrics.mInvokeTimeNsecs = out.time_nsecs;
         metrics.mCpuInsnExclVm = out.cpu_insns_excluding_vm_instantiation;
         metrics.mInvokeTimeNsecsExclVm =
             out.time_nsecs_excluding_vm_instantiation;
+        if (codeCached)
+        {
+            codeCache.noteReusedInstantiation(std::chrono::nanoseconds(
+                out.time_nsecs - out.time_nsecs_excluding_vm_instantiation));
+        }
         if (!out.success)
         {
             maybePopulateDiagnosticEvents(appConfig, out, metrics);
@@ -547,16 +801,28 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
     UnorderedSet<LedgerKey> createdKeys;
     for (auto const& buf : out.modified_ledger_entries)
     {
+        // Read-write entries the host left as they were are returned too;
+        // recognize them by their encoding rather than decoding them
+        auto unchangedKey =
+            findUnchangedEntry(buf, ledgerEntryCxxBufs, ledgerEntryKeys);
         LedgerEntry le;
-        xdr::xdr_from_opaque(buf.data, le);
-        if (!validateContractLedgerEntry(LedgerEntryKey(le), buf.data.size(),
-                                         sorobanConfig, appConfig, mParentTx))
+        LedgerKey lk;
+        if (unchangedKey)
+        {
+            lk = *unchangedKey;
+        }
+        else
+        {
+            xdr::xdr_from_opaque(buf.data, le);
+            lk = LedgerEntryKey(le);
+        }
+        if (!validateContractLedgerEntry(lk, buf.data.size(), sorobanConfig,
+                                         appConfig, mParentTx))
         {
             innerResult().code(INVOKE_HOST_FUNCTION_RESOURCE_LIMIT_EXCEEDED);
             return false;
         }
 
-        auto lk = LedgerEntryKey(le);
         createdAndModifiedKeys.insert(lk);
 
         uint32_t keySize = static_cast<uint32_t>(xdr::xdr_size(lk));
@@ -580,15 +846,27 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
             }
         }
 
+        // Unchanged entries are still loaded, so they are recorded as written
+        // just like before
         auto ltxe = ltx.load(lk);
         if (ltxe)
         {
-            ltxe.current() = le;
+            if (!unchangedKey)
+            {
+                ltxe.current() = le;
+            }
         }
         else
         {
+            releaseAssertOrThrow(!unchangedKey);
             ltx.create(le);
             createdKeys.insert(lk);
+            if (lk.type() == CONTRACT_CODE)
+            {
+                // The entry is stamped with this ledger when committed
+                le.lastModifiedLedgerSeq = ltx.getHeader().ledgerSeq;
+                codeCache.put(le);
+            }
         }
     }
 
@@ -732,6 +1010,9 @@ void
 InvokeHostFunctionOpFrame::insertLedgerKeysToPrefetch(
     UnorderedSet<LedgerKey>& keys) const
 {
+    auto const& footprint = mParentTx.sorobanResources().footprint;
+    insertKeysWithTTL(footprint.readOnly, keys);
+    insertKeysWithTTL(footprint.readWrite, keys);
 }
 
 bool
@@ -8,6 +8,7 @@
 #include "transactions/OperationFrame.h"
 #include "xdr/Stellar-transaction.h"
 #include <medida/metrics_registry.h>
+#include <memory>
 
 namespace stellar
 {
@@ -16,6 +17,35 @@ class AbstractLedgerTxn;
 static constexpr ContractDataDurability CONTRACT_INSTANCE_ENTRY_DURABILITY =
     ContractDataDurability::PERSISTENT;
 
+// Host function invocation run ahead of the application of its operation,
+// possibly on another thread. The host is a pure function of its inputs, so
+// the output can stand in for invoking the host at application time as long
+// as the footprint entries read then are the ones gathered here.
+struct PrecomputedHostInvocation
+{
+    Hash mBasePrngSeed;
+    rust::Vec<CxxBuf> mLedgerEntryCxxBufs;
+    rust::Vec<CxxBuf> mTtlEntryCxxBufs;
+    rust::Vec<CxxBuf> mAuthEntryCxxBufs;
+    CxxBuf mHostFunctionBuf;
+    CxxBuf mResourcesBuf;
+    CxxBuf mSourceAccountBuf;
+    CxxBuf mBasePrngSeedBuf;
+    CxxLedgerInfo mLedgerInfo;
+    CxxRentFeeConfiguration mRentFeeConfiguration;
+    uint32_t mProtocolVersion{0};
+    bool mEnableDiagnostics{false};
+    uint32_t mInstructions{0};
+
+    // Only set once invoke() has succeeded
+    InvokeHostFunctionOutput mOutput;
+    bool mInvoked{false};
+
+    // Invokes the host on the inputs above. This does not touch the ledger
+    // and can be called from any thread.
+    void invoke();
+};
+
 class InvokeHostFunctionOpFrame : public OperationFrame
 {
     InvokeHostFunctionResult&
@@ -29,6 +59,7 @@ class InvokeHostFunctionOpFrame : public OperationFrame
                                        HostFunctionMetrics const& metrics);
 
     InvokeHostFunctionOp const& mInvokeHostFunction;
+    std::shared_ptr<PrecomputedHostInvocation> mPrecomputedHostInvocation;
 
   public:
     InvokeHostFunctionOpFrame(Operation const& op, OperationResult& res,
@@ -40,6 +71,18 @@ class InvokeHostFunctionOpFrame : public OperationFrame
     bool doApply(Application& app, AbstractLedgerTxn& ltx,
                  Hash const& sorobanBasePrngSeed) override;
 
+    // Gathers the inputs of the host invocation this operation would make if
+    // it were applied to ltx now. Returns nullptr if the footprint has archived
+    // entries, which doApply reports.
+    std::shared_ptr<PrecomputedHostInvocation>
+    prepareHostInvocation(Application& app, AbstractLedgerTxn& ltx,
+                          Hash const& sorobanBasePrngSeed) const;
+
+    // Lets the next doApply use invocation instead of invoking the host, if
+    // it was invoked on the same inputs
+    void setPrecomputedHostInvocation(
+        std::shared_ptr<PrecomputedHostInvocation> invocation);
+
     bool doCheckValid(SorobanNetworkConfig const& config,
                       Config const& appConfig, uint32_t ledgerVersion) override;
     bool doCheckValid(uint32_t ledgerVersion) override;
@@ -8,8 +8,8 @@
 #include "ledger/TrustLineWrapper.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/numeric128.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -193,17 +193,19 @@ LiquidityPoolDepositOpFrame::doApply(AbstractLedgerTxn& ltx)
     ZoneNamedN(applyZone, "LiquidityPoolDepositOpFrame apply", true);
 
     // Don't need TrustLineWrapper here because pool share trust lines cannot be
-    // issuer trust lines.
-    auto tlPool = loadPoolShareTrustLine(ltx, getSourceID(),
-                                         mLiquidityPoolDeposit.liquidityPoolID);
+    // issuer trust lines. lp must exist if tlPool exists, so load both at once.
+    auto poolEntries = ltx.loadBatch(
+        {poolShareTrustLineKey(getSourceID(),
+                               mLiquidityPoolDeposit.liquidityPoolID),
+         liquidityPoolKey(mLiquidityPoolDeposit.liquidityPoolID)});
+    auto& tlPool = poolEntries[0];
     if (!tlPool)
     {
         innerResult().code(LIQUIDITY_POOL_DEPOSIT_NO_TRUST);
         return false;
     }
 
-    // lp must exist if tlPool exists
-    auto lp = loadLiquidityPool(ltx, mLiquidityPoolDeposit.liquidityPoolID);
+    auto& lp = poolEntries[1];
     auto cp = [&lp]() -> LiquidityPoolConstantProduct& {
         return lp.current().data.liquidityPool().body.constantProduct();
     };
@@ -216,8 +218,43 @@ LiquidityPoolDepositOpFrame::doApply(AbstractLedgerTxn& ltx)
         throw std::runtime_error("Depositing to invalid liquidity pool");
     }
 
-    auto tlA = loadTrustLineIfNotNative(ltx, getSourceID(), cpp().assetA);
-    auto tlB = loadTrustLineIfNotNative(ltx, getSourceID(), cpp().assetB);
+    // Load the trust lines for both assets, and the source account if one of
+    // them is native, at once. The source has no trust line for an asset that
+    // it issues.
+    auto hasTrustLine = [&](Asset const& asset) {
+        return asset.type() != ASSET_TYPE_NATIVE &&
+               !isIssuer(getSourceID(), asset);
+    };
+    bool const needsSource = cpp().assetA.type() == ASSET_TYPE_NATIVE ||
+                             cpp().assetB.type() == ASSET_TYPE_NATIVE;
+    std::vector<InternalLedgerKey> keys;
+    for (auto const* asset : {&cpp().assetA, &cpp().assetB})
+    {
+        if (hasTrustLine(*asset))
+        {
+            keys.emplace_back(trustlineKey(getSourceID(), *asset));
+        }
+    }
+    if (needsSource)
+    {
+        keys.emplace_back(accountKey(getSourceID()));
+    }
+    auto entries = ltx.loadBatch(keys);
+
+    size_t next = 0;
+    auto toTrustLine = [&](Asset const& asset) -> TrustLineWrapper {
+        if (asset.type() == ASSET_TYPE_NATIVE)
+        {
+            return {};
+        }
+        if (hasTrustLine(asset))
+        {
+            return TrustLineWrapper(std::move(entries[next++]));
+        }
+        return TrustLineWrapper(ltx, getSourceID(), asset);
+    };
+    auto tlA = toTrustLine(cpp().assetA);
+    auto tlB = toTrustLine(cpp().assetB);
     if ((cpp().assetA.type() != ASSET_TYPE_NATIVE && !tlA) ||
         (cpp().assetB.type() != ASSET_TYPE_NATIVE && !tlB))
     {
@@ -231,12 +268,11 @@ LiquidityPoolDepositOpFrame::doApply(AbstractLedgerTxn& ltx)
 
     // If one of the assets is native, we'll also need the source account
     LedgerTxnEntry source;
-    if (cpp().assetA.type() == ASSET_TYPE_NATIVE ||
-        cpp().assetB.type() == ASSET_TYPE_NATIVE)
+    if (needsSource)
     {
         // No need to check if it exists, the source account must exist at this
         // point
-        source = loadAccount(ltx, getSourceID());
+        source = std::move(entries[next++]);
     }
 
     auto header = ltx.loadHeader();
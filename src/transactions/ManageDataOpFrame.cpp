@@ -15,7 +15,7 @@
 #include "util/ProtocolVersion.h"
 #include "util/XDROperators.h"
 #include "util/types.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
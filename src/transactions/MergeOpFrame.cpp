@@ -12,8 +12,8 @@
 #include "transactions/TransactionUtils.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
 
 using namespace soci;
 
@@ -15,8 +15,8 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/numeric128.h"
-#include <Tracy.hpp>
 
 struct ExchangedQuantities
 {
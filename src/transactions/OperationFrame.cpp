@@ -34,8 +34,8 @@
 #include "transactions/TransactionUtils.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/XDRCereal.h"
-#include <Tracy.hpp>
 #include <medida/metrics_registry.h>
 
 namespace stellar
@@ -7,6 +7,7 @@
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
 #include "ledger/TrustLineWrapper.h"
+#include "transactions/OfferExchange.h"
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/ProtocolVersion.h"
@@ -31,6 +32,34 @@ PathPaymentOpFrameBase::getDestID() const
 void
 PathPaymentOpFrameBase::insertLedgerKeysToPrefetch(
     UnorderedSet<LedgerKey>& keys) const
+{
+    insertEndpointKeys(keys);
+
+    // Every hop may exchange with the pool for its pair. Offers are not
+    // listed here: LedgerTxnRoot loads the best offers of a pair in batches,
+    // together with the accounts and trustlines they depend on, the first
+    // time the pair is crossed.
+    if (isDexOperation())
+    {
+        Asset const* prev = &getSourceAsset();
+        auto insertPoolKey = [&](Asset const& next) {
+            if (!(*prev == next))
+            {
+                keys.emplace(liquidityPoolKey(
+                    getPoolID(*prev, next, LIQUIDITY_POOL_FEE_V18)));
+            }
+            prev = &next;
+        };
+        for (auto const& asset : getPath())
+        {
+            insertPoolKey(asset);
+        }
+        insertPoolKey(getDestAsset());
+    }
+}
+
+void
+PathPaymentOpFrameBase::insertEndpointKeys(UnorderedSet<LedgerKey>& keys) const
 {
     auto destID = getDestID();
     keys.emplace(accountKey(destID));
@@ -45,6 +74,18 @@ PathPaymentOpFrameBase::insertLedgerKeysToPrefetch(
     }
 }
 
+void
+PathPaymentOpFrameBase::preloadEndpoints(AbstractLedgerTxn& ltx) const
+{
+    // The entries are loaded one at a time (and some without being recorded)
+    // around the offer crossing, which cannot run while any entry is active,
+    // so they are only looked up here rather than loaded with loadBatch
+    UnorderedSet<LedgerKey> keys;
+    insertEndpointKeys(keys);
+    ltx.getNewestVersions(
+        UnorderedSet<InternalLedgerKey>(keys.begin(), keys.end()));
+}
+
 bool
 PathPaymentOpFrameBase::isDexOperation() const
 {
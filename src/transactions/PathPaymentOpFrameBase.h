@@ -30,6 +30,15 @@ class PathPaymentOpFrameBase : public OperationFrame
 
     bool checkIssuer(AbstractLedgerTxn& ltx, Asset const& asset);
 
+    // Looks up the entries the payment reads at either end of the path in a
+    // single pass through ltx and its parents, so that those not yet loaded
+    // are read from the database together before the individual loads.
+    void preloadEndpoints(AbstractLedgerTxn& ltx) const;
+
+    // The entries read at either end of the path: the destination account
+    // and the trustlines of any non-native endpoint assets
+    void insertEndpointKeys(UnorderedSet<LedgerKey>& keys) const;
+
   public:
     PathPaymentOpFrameBase(Operation const& op, OperationResult& res,
                            TransactionFrame& parentTx);
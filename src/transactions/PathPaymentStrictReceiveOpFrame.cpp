@@ -9,8 +9,8 @@
 #include "ledger/TrustLineWrapper.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -37,6 +37,7 @@ PathPaymentStrictReceiveOpFrame::doApply(AbstractLedgerTxn& ltx)
     ZoneTextV(applyZone, pathStr.c_str(), pathStr.size());
 
     setResultSuccess();
+    preloadEndpoints(ltx);
 
     bool doesSourceAccountExist = true;
     if (protocolVersionIsBefore(ltx.loadHeader().current().ledgerVersion,
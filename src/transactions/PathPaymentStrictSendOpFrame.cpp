@@ -9,8 +9,8 @@
 #include "ledger/TrustLineWrapper.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -44,6 +44,7 @@ PathPaymentStrictSendOpFrame::doApply(AbstractLedgerTxn& ltx)
     ZoneTextV(applyZone, pathStr.c_str(), pathStr.size());
 
     setResultSuccess();
+    preloadEndpoints(ltx);
 
     bool bypassIssuerCheck = shouldBypassIssuerCheck(mPathPayment.path);
     if (!bypassIssuerCheck)
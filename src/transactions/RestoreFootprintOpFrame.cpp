@@ -6,7 +6,7 @@
 #include "TransactionUtils.h"
 #include "ledger/LedgerManagerImpl.h"
 #include "ledger/LedgerTypeUtils.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 
 namespace stellar
 {
@@ -208,6 +208,7 @@ void
 RestoreFootprintOpFrame::insertLedgerKeysToPrefetch(
     UnorderedSet<LedgerKey>& keys) const
 {
+    insertKeysWithTTL(mParentTx.sorobanResources().footprint.readWrite, keys);
 }
 
 bool
@@ -12,8 +12,8 @@
 #include "transactions/SponsorshipUtils.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -11,8 +11,8 @@
 #include "transactions/SignatureUtils.h"
 #include "util/Algorithm.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -78,7 +78,8 @@ SignatureChecker::checkSignature(std::vector<Signer> const& signersV,
             for (auto it = signers.begin(); it != signers.end(); ++it)
             {
                 auto& signerKey = *it;
-                if (verify(sig, signerKey))
+                if (verifyOnce(i, signerKey.key,
+                               [&]() { return verify(sig, signerKey); }))
                 {
                     mUsedSignatures[i] = true;
                     auto w = signerKey.weight;
@@ -111,6 +112,7 @@ SignatureChecker::checkSignature(std::vector<Signer> const& signersV,
         return true;
     }
 
+    verifyEd25519Batch(signers[SIGNER_KEY_TYPE_ED25519]);
     verified = verifyAll(
         signers[SIGNER_KEY_TYPE_ED25519],
         [&](DecoratedSignature const& sig, Signer const& signerKey) {
@@ -135,6 +137,48 @@ SignatureChecker::checkSignature(std::vector<Signer> const& signersV,
     return false;
 }
 
+bool
+SignatureChecker::verifyOnce(size_t sigIndex, SignerKey const& signerKey,
+                             std::function<bool()> const& verify)
+{
+    auto key = std::make_pair(sigIndex, signerKey);
+    auto it = mVerifiedPairs.find(key);
+    if (it == mVerifiedPairs.end())
+    {
+        it = mVerifiedPairs.emplace(std::move(key), verify()).first;
+    }
+    return it->second;
+}
+
+void
+SignatureChecker::verifyEd25519Batch(std::vector<Signer> const& signers) const
+{
+    ZoneScoped;
+    std::vector<PubKeyUtils::SignatureToVerify> batch;
+    for (size_t i = 0; i < mSignatures.size(); i++)
+    {
+        auto const& sig = mSignatures[i];
+        for (auto const& signer : signers)
+        {
+            if (mVerifiedPairs.find(std::make_pair(i, signer.key)) !=
+                mVerifiedPairs.end())
+            {
+                continue;
+            }
+            auto pubKey = KeyUtils::convertKey<PublicKey>(signer.key);
+            if (SignatureUtils::doesHintMatch(pubKey.ed25519(), sig.hint))
+            {
+                batch.push_back({pubKey, sig.signature, mContentsHash});
+            }
+        }
+    }
+    // A single signature gains nothing from batching
+    if (batch.size() > 1)
+    {
+        PubKeyUtils::verifySigs(batch);
+    }
+}
+
 bool
 SignatureChecker::checkAllSignaturesUsed() const
 {
@@ -8,8 +8,8 @@
 #include "crypto/SecretKey.h"
 #include "crypto/SignerKey.h"
 #include "util/GlobalChecks.h"
+#include "util/Tracing.h"
 #include "xdr/Stellar-transaction.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
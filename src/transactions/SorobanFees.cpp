@@ -0,0 +1,115 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/SorobanFees.h"
+
+#include <cstdint>
+#include <limits>
+
+namespace stellar
+{
+
+namespace
+{
+// Same constants as the host
+int64_t const INSTRUCTIONS_INCREMENT = 10000;
+int64_t const DATA_SIZE_1KB_INCREMENT = 1024;
+// Approximate size of the transaction result, charged as historical data
+uint32_t const TX_BASE_RESULT_SIZE = 300;
+
+int64_t
+saturatingAdd(int64_t a, int64_t b)
+{
+    if (b > 0 && a > std::numeric_limits<int64_t>::max() - b)
+    {
+        return std::numeric_limits<int64_t>::max();
+    }
+    if (b < 0 && a < std::numeric_limits<int64_t>::min() - b)
+    {
+        return std::numeric_limits<int64_t>::min();
+    }
+    return a + b;
+}
+
+int64_t
+saturatingMul(int64_t rate, uint32_t value)
+{
+    if (value == 0)
+    {
+        return 0;
+    }
+    int64_t v = value;
+    if (rate > std::numeric_limits<int64_t>::max() / v)
+    {
+        return std::numeric_limits<int64_t>::max();
+    }
+    if (rate < std::numeric_limits<int64_t>::min() / v)
+    {
+        return std::numeric_limits<int64_t>::min();
+    }
+    return rate * v;
+}
+
+uint32_t
+saturatingAdd(uint32_t a, uint32_t b)
+{
+    return a > std::numeric_limits<uint32_t>::max() - b
+               ? std::numeric_limits<uint32_t>::max()
+               : a + b;
+}
+
+// ceil(value * rate / increment), like num_integer::div_ceil
+int64_t
+computeFeePerIncrement(uint32_t value, int64_t rate, int64_t increment)
+{
+    auto n = saturatingMul(rate, value);
+    auto q = n / increment;
+    if (n % increment > 0)
+    {
+        ++q;
+    }
+    return q;
+}
+}
+
+FeePair
+computeNativeTransactionResourceFee(CxxTransactionResources const& txResources,
+                                    CxxFeeConfiguration const& feeConfig)
+{
+    auto computeFee = computeFeePerIncrement(
+        txResources.instructions, feeConfig.fee_per_instruction_increment,
+        INSTRUCTIONS_INCREMENT);
+    // Written entries have to be read too
+    auto readEntryFee = saturatingMul(
+        feeConfig.fee_per_read_entry,
+        saturatingAdd(txResources.read_entries, txResources.write_entries));
+    auto writeEntryFee =
+        saturatingMul(feeConfig.fee_per_write_entry, txResources.write_entries);
+    auto readBytesFee = computeFeePerIncrement(txResources.read_bytes,
+                                               feeConfig.fee_per_read_1kb,
+                                               DATA_SIZE_1KB_INCREMENT);
+    auto writeBytesFee = computeFeePerIncrement(txResources.write_bytes,
+                                                feeConfig.fee_per_write_1kb,
+                                                DATA_SIZE_1KB_INCREMENT);
+    auto historicalFee = computeFeePerIncrement(
+        saturatingAdd(txResources.transaction_size_bytes, TX_BASE_RESULT_SIZE),
+        feeConfig.fee_per_historical_1kb, DATA_SIZE_1KB_INCREMENT);
+    auto eventsFee = computeFeePerIncrement(
+        txResources.contract_events_size_bytes,
+        feeConfig.fee_per_contract_event_1kb, DATA_SIZE_1KB_INCREMENT);
+    auto bandwidthFee = computeFeePerIncrement(
+        txResources.transaction_size_bytes,
+        feeConfig.fee_per_transaction_size_1kb, DATA_SIZE_1KB_INCREMENT);
+
+    FeePair res{};
+    res.non_refundable_fee = computeFee;
+    for (auto fee : {readEntryFee, writeEntryFee, readBytesFee, writeBytesFee,
+                     historicalFee, bandwidthFee})
+    {
+        res.non_refundable_fee = saturatingAdd(res.non_refundable_fee, fee);
+    }
+    res.refundable_fee = eventsFee;
+    return res;
+}
+}
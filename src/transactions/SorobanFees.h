@@ -0,0 +1,39 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "rust/RustBridge.h"
+#include "util/ProtocolVersion.h"
+
+namespace stellar
+{
+
+// Last protocol version of the host that computeNativeTransactionResourceFee
+// was ported from and checked against. The host stays the source of truth:
+// fees of later protocols are computed by the host until the port is checked
+// against them and this is bumped.
+constexpr ProtocolVersion LAST_NATIVE_RESOURCE_FEE_PROTOCOL_VERSION =
+    ProtocolVersion::V_21;
+
+constexpr bool
+isNativeResourceFeeProtocol(uint32_t protocolVersion)
+{
+    return protocolVersionStartsFrom(protocolVersion,
+                                     SOROBAN_PROTOCOL_VERSION) &&
+           protocolVersion <=
+               static_cast<uint32_t>(LAST_NATIVE_RESOURCE_FEE_PROTOCOL_VERSION);
+}
+
+// Native port of soroban-env-host's compute_transaction_resource_fee, so that
+// the resource fee of every Soroban transaction admitted to the queue or
+// checked in a tx set doesn't need a call across the Rust bridge. Only valid
+// for the protocols of isNativeResourceFeeProtocol. The result must be
+// identical to the host's for all inputs (including its saturating
+// arithmetic), as it is part of consensus; SOROBAN_FEE_PARITY_CHECKS checks
+// it against the host at runtime.
+FeePair computeNativeTransactionResourceFee(
+    CxxTransactionResources const& txResources,
+    CxxFeeConfiguration const& feeConfig);
+}
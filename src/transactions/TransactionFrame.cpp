@@ -15,6 +15,7 @@
 #include "invariant/InvariantDoesNotHold.h"
 #include "invariant/InvariantManager.h"
 #include "ledger/LedgerHeaderUtils.h"
+#include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
@@ -22,12 +23,14 @@
 #include "main/Application.h"
 #include "transactions/SignatureChecker.h"
 #include "transactions/SignatureUtils.h"
+#include "transactions/SorobanFees.h"
 #include "transactions/SponsorshipUtils.h"
 #include "transactions/TransactionBridge.h"
 #include "transactions/TransactionMetaFrame.h"
 #include "transactions/TransactionUtils.h"
 #include "util/Decoder.h"
 #include "util/GlobalChecks.h"
+#include "util/LogSlowExecution.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDROperators.h"
@@ -36,15 +39,18 @@
 #include "xdr/Stellar-ledger.h"
 #include "xdrpp/marshal.h"
 #include "xdrpp/printer.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+#include <fmt/format.h>
 #include <iterator>
 #include <string>
 
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
+#include "medida/timer.h"
 
 #include <algorithm>
 #include <numeric>
+#include <optional>
 #include <xdrpp/types.h>
 
 namespace stellar
@@ -105,13 +111,13 @@ TransactionFrame::getContentsHash() const
     {
         if (mEnvelope.type() == ENVELOPE_TYPE_TX_V0)
         {
-            mContentsHash = sha256(xdr::xdr_to_opaque(
-                mNetworkID, ENVELOPE_TYPE_TX, 0, mEnvelope.v0().tx));
+            mContentsHash = xdrSha256(mNetworkID, ENVELOPE_TYPE_TX, 0,
+                                      mEnvelope.v0().tx);
         }
         else
         {
-            mContentsHash = sha256(xdr::xdr_to_opaque(
-                mNetworkID, ENVELOPE_TYPE_TX, mEnvelope.v1().tx));
+            mContentsHash =
+                xdrSha256(mNetworkID, ENVELOPE_TYPE_TX, mEnvelope.v1().tx);
         }
     }
 #ifdef _DEBUG
@@ -528,21 +534,44 @@ TransactionFrame::resetResults(LedgerHeader const& header,
 
     // pre-allocates the results for all operations
     getResult().result.code(txSUCCESS);
-    getResult().result.results().resize(static_cast<uint32_t>(ops.size()));
-
-    mOperations.clear();
+    auto& results = getResult().result.results();
+    results.resize(static_cast<uint32_t>(ops.size()));
 
-    // bind operations to the results
-    for (size_t i = 0; i < ops.size(); i++)
+    // The operations only need to be bound to the results again if these
+    // were reallocated, which only happens when the result code last switched
+    // to one without operation results. Otherwise the frames are kept, so
+    // validating and applying a transaction does not recreate them each time.
+    bool bound = mOperations.size() == ops.size();
+    for (size_t i = 0; bound && i < ops.size(); i++)
     {
-        mOperations.push_back(
-            makeOperation(ops[i], getResult().result.results()[i], i));
+        bound = &mOperations[i]->getResult() == &results[i];
+    }
+    if (!bound)
+    {
+        mOperations.clear();
+        for (size_t i = 0; i < ops.size(); i++)
+        {
+            mOperations.push_back(makeOperation(ops[i], results[i], i));
+        }
+    }
+    else
+    {
+        // Kept results still hold what the last validation or apply wrote,
+        // and some paths only write the results of failing operations, so
+        // reset them as new frames would
+        for (size_t i = 0; i < ops.size(); i++)
+        {
+            results[i].code(opINNER);
+            results[i].tr().type(ops[i].body.type());
+        }
     }
 
     // feeCharged is updated accordingly to represent the cost of the
     // transaction regardless of the failure modes.
     getResult().feeCharged = getFee(header, baseFee, applying);
 
+    mValidityDigest.reset();
+
     // resets Soroban related fields
     mSorobanExtension.reset();
     if (isSoroban())
@@ -878,10 +907,34 @@ TransactionFrame::computeSorobanResourceFee(
     cxxResources.transaction_size_bytes = txSize;
     cxxResources.contract_events_size_bytes = eventsSize;
 
-    // This may throw, but only in case of the Core version misconfiguration.
-    return rust_bridge::compute_transaction_resource_fee(
-        cfg.CURRENT_LEDGER_PROTOCOL_VERSION, protocolVersion, cxxResources,
-        sorobanConfig.rustBridgeFeeConfiguration());
+    auto feeConfig = sorobanConfig.rustBridgeFeeConfiguration();
+    // The host calls below may throw, but only in case of the Core version
+    // misconfiguration.
+    if (!isNativeResourceFeeProtocol(protocolVersion))
+    {
+        return rust_bridge::compute_transaction_resource_fee(
+            cfg.CURRENT_LEDGER_PROTOCOL_VERSION, protocolVersion, cxxResources,
+            feeConfig);
+    }
+    auto fee = computeNativeTransactionResourceFee(cxxResources, feeConfig);
+    if (cfg.SOROBAN_FEE_PARITY_CHECKS)
+    {
+        auto hostFee = rust_bridge::compute_transaction_resource_fee(
+            cfg.CURRENT_LEDGER_PROTOCOL_VERSION, protocolVersion, cxxResources,
+            feeConfig);
+        if (hostFee.non_refundable_fee != fee.non_refundable_fee ||
+            hostFee.refundable_fee != fee.refundable_fee)
+        {
+            printErrorAndAbort(
+                "native Soroban resource fee doesn't match the host's: ",
+                fmt::format(FMT_STRING("({}, {}) != ({}, {})"),
+                            fee.non_refundable_fee, fee.refundable_fee,
+                            hostFee.non_refundable_fee,
+                            hostFee.refundable_fee)
+                    .c_str());
+        }
+    }
+    return fee;
 }
 
 int64
@@ -894,7 +947,7 @@ TransactionFrame::declaredSorobanResourceFee() const
 FeePair
 TransactionFrame::computePreApplySorobanResourceFee(
     uint32_t protocolVersion, SorobanNetworkConfig const& sorobanConfig,
-    Config const& cfg)
+    Config const& cfg) const
 {
     ZoneScoped;
     releaseAssertOrThrow(isSoroban());
@@ -908,6 +961,27 @@ TransactionFrame::computePreApplySorobanResourceFee(
         0, sorobanConfig, cfg);
 }
 
+void
+TransactionFrame::setPreApplySorobanResourceFee(FeePair const& fee)
+{
+    releaseAssertOrThrow(mSorobanExtension);
+    mSorobanExtension->mPreApplyResourceFee = fee;
+}
+
+FeePair
+TransactionFrame::getPreApplySorobanResourceFee(Application& app,
+                                                uint32_t protocolVersion) const
+{
+    releaseAssertOrThrow(mSorobanExtension);
+    if (mSorobanExtension->mPreApplyResourceFee)
+    {
+        return *mSorobanExtension->mPreApplyResourceFee;
+    }
+    return computePreApplySorobanResourceFee(
+        protocolVersion, app.getLedgerManager().getSorobanNetworkConfig(),
+        app.getConfig());
+}
+
 bool
 TransactionFrame::consumeRefundableSorobanResources(
     uint32_t contractEventSizeBytes, int64_t rentFee, uint32_t protocolVersion,
@@ -1560,6 +1634,22 @@ TransactionFrame::checkValidWithOptionallyChargedFee(
     }
 
     LedgerTxn ltx(ltxOuter);
+    // Soroban transactions also depend on the network config, which tests
+    // can change in place, so they are always validated again
+    std::optional<Hash> digest;
+    if (!isSoroban())
+    {
+        digest = computeValidityDigest(ltx, current, chargeFee,
+                                       lowerBoundCloseTimeOffset,
+                                       upperBoundCloseTimeOffset);
+        if (mValidityDigest == digest)
+        {
+            // Nothing has reset the results of the last successful
+            // validation since
+            return true;
+        }
+    }
+
     int64_t minBaseFee = ltx.loadHeader().current().baseFee;
     if (!chargeFee)
     {
@@ -1604,9 +1694,45 @@ TransactionFrame::checkValidWithOptionallyChargedFee(
             getResult().result.code(txBAD_AUTH_EXTRA);
         }
     }
+    if (res)
+    {
+        mValidityDigest = digest;
+    }
     return res;
 }
 
+Hash
+TransactionFrame::computeValidityDigest(
+    AbstractLedgerTxn& ltx, SequenceNumber current, bool chargeFee,
+    uint64_t lowerBoundCloseTimeOffset,
+    uint64_t upperBoundCloseTimeOffset) const
+{
+    ZoneScoped;
+    SHA256 hasher;
+    // Covers the signatures, which can be added to the frame
+    hasher.add(getFullHash());
+    hasher.add(xdr::xdr_to_opaque(ltx.loadHeader().current()));
+    hasher.add(xdr::xdr_to_opaque(current, chargeFee, lowerBoundCloseTimeOffset,
+                                  upperBoundCloseTimeOffset));
+    auto addAccount = [&](AccountID const& accountID) {
+        auto entry = ltx.loadWithoutRecord(accountKey(accountID));
+        hasher.add(xdr::xdr_to_opaque(static_cast<bool>(entry)));
+        if (entry)
+        {
+            hasher.add(xdr::xdr_to_opaque(entry.current()));
+        }
+    };
+    addAccount(getSourceID());
+    for (auto const& op : getRawOperations())
+    {
+        if (op.sourceAccount)
+        {
+            addAccount(toAccountID(*op.sourceAccount));
+        }
+    }
+    return hasher.finish();
+}
+
 bool
 TransactionFrame::checkValid(Application& app, AbstractLedgerTxn& ltxOuter,
                              SequenceNumber current,
@@ -1640,6 +1766,33 @@ TransactionFrame::insertKeysForFeeProcessing(
     keys.emplace(accountKey(getSourceID()));
 }
 
+void
+TransactionFrame::insertSignaturesToVerify(
+    std::vector<EnvelopeSignatures>& sigs) const
+{
+    auto& res = sigs.emplace_back();
+    res.mContentsHash = getContentsHash();
+    res.mSignatures = mEnvelope.type() == ENVELOPE_TYPE_TX_V0
+                          ? mEnvelope.v0().signatures
+                          : mEnvelope.v1().signatures;
+    res.mAccounts.emplace_back(getSourceID());
+    for (auto const& op : mOperations)
+    {
+        auto opSource = op->getSourceID();
+        if (std::find(res.mAccounts.begin(), res.mAccounts.end(), opSource) ==
+            res.mAccounts.end())
+        {
+            res.mAccounts.emplace_back(opSource);
+        }
+    }
+}
+
+void
+TransactionFrame::setSignaturesTrusted()
+{
+    mSignaturesTrusted = true;
+}
+
 void
 TransactionFrame::insertKeysForTxApply(UnorderedSet<LedgerKey>& keys) const
 {
@@ -1699,21 +1852,34 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
             app.getConfig().LEDGER_PROTOCOL_MIN_VERSION_INTERNAL_ERROR_REPORT;
         auto& opTimer =
             app.getMetrics().NewTimer({"ledger", "operation", "apply"});
+        auto& lm = app.getLedgerManager();
+        auto slowOpThreshold = app.getConfig().LOG_SLOW_OPERATION_APPLY_MS;
 
         uint64_t opNum{0};
         for (auto& op : mOperations)
         {
+            auto opType = op->getOperation().body.type();
             auto time = opTimer.TimeScope();
+            auto typeTime = lm.getOperationApplyTimer(opType).TimeScope();
+            std::optional<LogSlowExecution> slowOp;
+            if (slowOpThreshold.count() > 0)
+            {
+                slowOp.emplace(
+                    fmt::format(FMT_STRING("Operation {:d} ({:s}) of tx {:s}"),
+                                opNum,
+                                xdr::xdr_traits<OperationType>::enum_name(
+                                    opType),
+                                hexAbbrev(getContentsHash())),
+                    LogSlowExecution::Mode::AUTOMATIC_RAII, "took",
+                    slowOpThreshold);
+            }
             LedgerTxn ltxOp(ltxTx);
 
             Hash subSeed = sorobanBasePrngSeed;
             // If op can use the seed, we need to compute a sub-seed for it.
             if (op->isSoroban())
             {
-                SHA256 subSeedSha;
-                subSeedSha.add(sorobanBasePrngSeed);
-                subSeedSha.add(xdr::xdr_to_opaque(opNum));
-                subSeed = subSeedSha.finish();
+                subSeed = xdrSha256(sorobanBasePrngSeed, opNum);
             }
             ++opNum;
 
@@ -1725,13 +1891,22 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
             }
             if (success)
             {
-                app.getInvariantManager().checkOnOperationApply(
-                    op->getOperation(), op->getResult(), ltxOp.getDelta());
-
                 // The operation meta will be empty if the transaction
                 // doesn't succeed so we may as well not do any work in that
                 // case
-                operationMetas.emplace_back(ltxOp.getChanges());
+                if (outerMeta.isEnabled())
+                {
+                    auto [delta, changes] = ltxOp.getDeltaAndChanges();
+                    app.getInvariantManager().checkOnOperationApply(
+                        op->getOperation(), op->getResult(), delta);
+                    operationMetas.emplace_back(std::move(changes));
+                }
+                else
+                {
+                    app.getInvariantManager().checkOnOperationApply(
+                        op->getOperation(), op->getResult(),
+                        ltxOp.getDelta());
+                }
             }
 
             if (txRes ||
@@ -1759,7 +1934,10 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
                 // owner to remove that signer
                 LedgerTxn ltxAfter(ltxTx);
                 removeOneTimeSignerFromAllSourceAccounts(ltxAfter);
-                changesAfter = ltxAfter.getChanges();
+                if (outerMeta.isEnabled())
+                {
+                    changesAfter = ltxAfter.getChanges();
+                }
                 ltxAfter.commit();
             }
             else if (protocolVersionStartsFrom(ledgerVersion,
@@ -1804,11 +1982,8 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
             {
                 // If transaction fails, we don't charge for any
                 // refundable resources.
-                releaseAssertOrThrow(mSorobanExtension);
-                auto preApplyFee = computePreApplySorobanResourceFee(
-                    ledgerVersion,
-                    app.getLedgerManager().getSorobanNetworkConfig(),
-                    app.getConfig());
+                auto preApplyFee =
+                    getPreApplySorobanResourceFee(app, ledgerVersion);
                 mSorobanExtension->mFeeRefund = declaredSorobanResourceFee() -
                                                 preApplyFee.non_refundable_fee;
                 outerMeta.pushDiagnosticEvents(
@@ -1901,8 +2076,18 @@ TransactionFrame::apply(Application& app, AbstractLedgerTxn& ltx,
     {
         mCachedAccount.reset();
         uint32_t ledgerVersion = ltx.loadHeader().current().ledgerVersion;
-        SignatureChecker signatureChecker{ledgerVersion, getContentsHash(),
-                                          getSignatures(mEnvelope)};
+        std::unique_ptr<SignatureChecker> checker;
+        if (mSignaturesTrusted)
+        {
+            checker = std::make_unique<AlwaysValidSignatureChecker>(
+                ledgerVersion, getContentsHash(), getSignatures(mEnvelope));
+        }
+        else
+        {
+            checker = std::make_unique<SignatureChecker>(
+                ledgerVersion, getContentsHash(), getSignatures(mEnvelope));
+        }
+        SignatureChecker& signatureChecker = *checker;
 
         //  when applying, a failure during tx validation means that
         //  we'll skip trying to apply operations but we'll still
@@ -1912,10 +2097,8 @@ TransactionFrame::apply(Application& app, AbstractLedgerTxn& ltx,
                                       SOROBAN_PROTOCOL_VERSION) &&
             isSoroban())
         {
-            releaseAssertOrThrow(mSorobanExtension);
-            sorobanResourceFee = computePreApplySorobanResourceFee(
-                ledgerVersion, app.getLedgerManager().getSorobanNetworkConfig(),
-                app.getConfig());
+            sorobanResourceFee =
+                getPreApplySorobanResourceFee(app, ledgerVersion);
             mSorobanExtension->mConsumedNonRefundableFee =
                 sorobanResourceFee->non_refundable_fee;
             mSorobanExtension->mFeeRefund =
@@ -1932,7 +2115,10 @@ TransactionFrame::apply(Application& app, AbstractLedgerTxn& ltx,
 
         bool signaturesValid = processSignatures(cv, signatureChecker, ltxTx);
 
-        meta.pushTxChangesBefore(ltxTx.getChanges());
+        if (meta.isEnabled())
+        {
+            meta.pushTxChangesBefore(ltxTx.getChanges());
+        }
         ltxTx.commit();
 
         bool ok = signaturesValid && cv == ValidationType::kMaybeValid;
@@ -2009,7 +2195,10 @@ TransactionFrame::processRefund(Application& app, AbstractLedgerTxn& ltxOuter,
     // transaction success).
     LedgerTxn ltx(ltxOuter);
     int64_t refund = refundSorobanFee(ltx, feeSource);
-    meta.pushTxChangesAfter(ltx.getChanges());
+    if (meta.isEnabled())
+    {
+        meta.pushTxChangesAfter(ltx.getChanges());
+    }
     ltx.commit();
 
     return refund;
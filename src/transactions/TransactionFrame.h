@@ -65,6 +65,8 @@ class TransactionFrame : public TransactionFrameBase
         int64_t mConsumedNonRefundableFee{};
         int64_t mConsumedRentFee{};
         int64_t mConsumedRefundableFee{};
+        // Set by `setPreApplySorobanResourceFee`
+        std::optional<FeePair> mPreApplyResourceFee;
         SorobanData()
         {
         }
@@ -72,6 +74,11 @@ class TransactionFrame : public TransactionFrameBase
     std::optional<SorobanData> mSorobanExtension;
 
     std::shared_ptr<InternalLedgerEntry const> mCachedAccount;
+    bool mSignaturesTrusted{false};
+    // Digest of everything the last successful validation depended on (see
+    // `computeValidityDigest`), set until the results are reset, so that
+    // validating again against the same state can be skipped
+    std::optional<Hash> mValidityDigest;
 
     Hash const& mNetworkID;     // used to change the way we compute signatures
     mutable Hash mContentsHash; // the hash of the contents
@@ -150,13 +157,16 @@ class TransactionFrame : public TransactionFrameBase
     int64_t refundSorobanFee(AbstractLedgerTxn& ltx,
                              AccountID const& feeSource);
     void updateSorobanMetrics(Application& app);
-#ifdef BUILD_TESTS
-  public:
-#endif
-    FeePair
-    computePreApplySorobanResourceFee(uint32_t protocolVersion,
-                                      SorobanNetworkConfig const& sorobanConfig,
-                                      Config const& cfg);
+    // Hashes the transaction with its signatures, the ledger header, the
+    // validation parameters and the accounts whose state validation depends
+    // on: the source account and the operation source accounts
+    Hash computeValidityDigest(AbstractLedgerTxn& ltx, SequenceNumber current,
+                               bool chargeFee,
+                               uint64_t lowerBoundCloseTimeOffset,
+                               uint64_t upperBoundCloseTimeOffset) const;
+    // Returns the fee set by `setPreApplySorobanResourceFee`, or computes it
+    FeePair getPreApplySorobanResourceFee(Application& app,
+                                          uint32_t protocolVersion) const;
 
     void pushSimpleDiagnosticError(Config const& cfg, SCErrorType ty,
                                    SCErrorCode code, std::string&& message,
@@ -264,6 +274,13 @@ class TransactionFrame : public TransactionFrameBase
 
     void
     insertKeysForFeeProcessing(UnorderedSet<LedgerKey>& keys) const override;
+    void insertSignaturesToVerify(
+        std::vector<EnvelopeSignatures>& sigs) const override;
+    void setSignaturesTrusted() override;
+    FeePair computePreApplySorobanResourceFee(
+        uint32_t protocolVersion, SorobanNetworkConfig const& sorobanConfig,
+        Config const& cfg) const override;
+    void setPreApplySorobanResourceFee(FeePair const& fee) override;
     void insertKeysForTxApply(UnorderedSet<LedgerKey>& keys) const override;
 
     // collect fee, consume sequence number
@@ -23,6 +23,15 @@ class Application;
 class Database;
 class OperationFrame;
 
+// Signatures of a transaction envelope, the hash they sign and the accounts
+// whose signers they may belong to
+struct EnvelopeSignatures
+{
+    Hash mContentsHash;
+    xdr::xvector<DecoratedSignature, 20> mSignatures;
+    std::vector<AccountID> mAccounts;
+};
+
 class TransactionFrameBase;
 using TransactionFrameBasePtr = std::shared_ptr<TransactionFrameBase>;
 using TransactionFrameBaseConstPtr =
@@ -80,6 +89,15 @@ class TransactionFrameBase
     insertKeysForFeeProcessing(UnorderedSet<LedgerKey>& keys) const = 0;
     virtual void insertKeysForTxApply(UnorderedSet<LedgerKey>& keys) const = 0;
 
+    // Adds the signatures of every envelope of this transaction to sigs, so
+    // that they can be verified ahead of checkValid
+    virtual void
+    insertSignaturesToVerify(std::vector<EnvelopeSignatures>& sigs) const = 0;
+
+    // Makes apply accept the signatures of this transaction without verifying
+    // them, for replaying a transaction known to have succeeded
+    virtual void setSignaturesTrusted() = 0;
+
     virtual void processFeeSeqNum(AbstractLedgerTxn& ltx,
                                   std::optional<int64_t> baseFee) = 0;
 
@@ -96,5 +114,16 @@ class TransactionFrameBase
     getDiagnosticEvents() const = 0;
     virtual int64 declaredSorobanResourceFee() const = 0;
     virtual bool XDRProvidesValidFee() const = 0;
+
+    // Resource fee of a Soroban transaction charged before apply, computed
+    // from its declared resources
+    virtual FeePair
+    computePreApplySorobanResourceFee(uint32_t protocolVersion,
+                                      SorobanNetworkConfig const& sorobanConfig,
+                                      Config const& cfg) const = 0;
+    // Makes the next `apply` use `fee` as the result of
+    // `computePreApplySorobanResourceFee` instead of computing it again. Must
+    // be called after `processFeeSeqNum`, which forgets it.
+    virtual void setPreApplySorobanResourceFee(FeePair const& fee) = 0;
 };
 }
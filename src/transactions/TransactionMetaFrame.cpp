@@ -13,7 +13,9 @@
 
 namespace stellar
 {
-TransactionMetaFrame::TransactionMetaFrame(uint32_t protocolVersion)
+TransactionMetaFrame::TransactionMetaFrame(uint32_t protocolVersion,
+                                           bool enabled)
+    : mEnabled(enabled)
 {
     // The TransactionMeta v() switch can be in 4 positions 0, 1, 2, 3. We
     // do not support 0 or 1 at all -- core does not produce it anymore and we
@@ -79,6 +81,10 @@ TransactionMetaFrame::getChangesAfter() const
 void
 TransactionMetaFrame::pushTxChangesBefore(LedgerEntryChanges&& changes)
 {
+    if (!mEnabled)
+    {
+        return;
+    }
     switch (mTransactionMeta.v())
     {
     case 2:
@@ -111,6 +117,10 @@ TransactionMetaFrame::clearOperationMetas()
 void
 TransactionMetaFrame::pushOperationMetas(xdr::xvector<OperationMeta>&& opMetas)
 {
+    if (!mEnabled)
+    {
+        return;
+    }
     switch (mTransactionMeta.v())
     {
     case 2:
@@ -141,6 +151,10 @@ TransactionMetaFrame::getNumOperations() const
 void
 TransactionMetaFrame::pushTxChangesAfter(LedgerEntryChanges&& changes)
 {
+    if (!mEnabled)
+    {
+        return;
+    }
     switch (mTransactionMeta.v())
     {
     case 2:
@@ -173,6 +187,10 @@ TransactionMetaFrame::clearTxChangesAfter()
 void
 TransactionMetaFrame::pushContractEvents(xdr::xvector<ContractEvent>&& events)
 {
+    if (!mEnabled)
+    {
+        return;
+    }
     switch (mTransactionMeta.v())
     {
     case 2:
@@ -190,6 +208,10 @@ void
 TransactionMetaFrame::pushDiagnosticEvents(
     xdr::xvector<DiagnosticEvent>&& events)
 {
+    if (!mEnabled)
+    {
+        return;
+    }
     switch (mTransactionMeta.v())
     {
     case 2:
@@ -207,6 +229,10 @@ TransactionMetaFrame::pushDiagnosticEvents(
 void
 TransactionMetaFrame::setReturnValue(SCVal&& returnValue)
 {
+    if (!mEnabled)
+    {
+        return;
+    }
     switch (mTransactionMeta.v())
     {
     case 2:
@@ -226,6 +252,10 @@ TransactionMetaFrame::setSorobanFeeInfo(int64_t nonRefundableFeeSpent,
                                         int64_t totalRefundableFeeSpent,
                                         int64_t rentFeeCharged)
 {
+    if (!mEnabled)
+    {
+        return;
+    }
     switch (mTransactionMeta.v())
     {
     case 2:
@@ -246,9 +276,21 @@ TransactionMetaFrame::setSorobanFeeInfo(int64_t nonRefundableFeeSpent,
     }
 }
 
+bool
+TransactionMetaFrame::isEnabled() const
+{
+    return mEnabled;
+}
+
 TransactionMeta const&
 TransactionMetaFrame::getXDR() const
 {
     return mTransactionMeta;
 }
+
+TransactionMeta
+TransactionMetaFrame::releaseXDR()
+{
+    return std::move(mTransactionMeta);
+}
 }
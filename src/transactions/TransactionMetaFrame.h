@@ -11,10 +11,16 @@ namespace stellar
 
 // Wrapper around TransactionMeta XDR that provides mutable access to fields
 // in the proper version of meta.
+//
+// A disabled frame drops everything pushed into it, so that nothing is
+// collected for transactions whose meta nobody consumes. Callers should also
+// check isEnabled() before computing the changes they would push.
 class TransactionMetaFrame
 {
   public:
-    TransactionMetaFrame(uint32_t protocolVersion);
+    TransactionMetaFrame(uint32_t protocolVersion, bool enabled = true);
+
+    bool isEnabled() const;
 
     void pushTxChangesBefore(LedgerEntryChanges&& changes);
     size_t getNumChangesBefore() const;
@@ -27,6 +33,8 @@ class TransactionMetaFrame
     void clearTxChangesAfter();
 
     TransactionMeta const& getXDR() const;
+    // Moves the meta out of the frame, which must not be used afterwards
+    TransactionMeta releaseXDR();
 
     void pushContractEvents(xdr::xvector<ContractEvent>&& events);
     void pushDiagnosticEvents(xdr::xvector<DiagnosticEvent>&& events);
@@ -38,6 +46,7 @@ class TransactionMetaFrame
   private:
     TransactionMeta mTransactionMeta;
     int mVersion;
+    bool mEnabled;
 };
 
 }
@@ -11,10 +11,10 @@
 #include "main/Application.h"
 #include "util/Decoder.h"
 #include "util/GlobalChecks.h"
+#include "util/Tracing.h"
 #include "util/XDRStream.h"
 #include "xdrpp/marshal.h"
 #include "xdrpp/message.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -347,58 +347,117 @@ writeTxSetToStream(
 
 } // namespace
 
+TransactionHistoryWriter::TransactionHistoryWriter(Database& db,
+                                                   Config const& cfg,
+                                                   uint32_t ledgerSeq)
+    : mDb(db), mConfig(cfg), mLedgerSeq(ledgerSeq)
+{
+}
+
 void
-storeTransaction(Database& db, uint32_t ledgerSeq,
-                 TransactionFrameBasePtr const& tx, TransactionMeta const& tm,
-                 TransactionResultSet const& resultSet, Config const& cfg)
+TransactionHistoryWriter::addTransaction(TransactionFrameBasePtr const& tx,
+                                         TransactionMeta const& tm,
+                                         TransactionResultSet const& resultSet)
 {
     ZoneScoped;
-    std::string txBody =
-        decoder::encode_b64(xdr::xdr_to_opaque(tx->getEnvelope()));
-    std::string txResult =
-        decoder::encode_b64(xdr::xdr_to_opaque(resultSet.results.back()));
-    std::string meta = decoder::encode_b64(xdr::xdr_to_opaque(tm));
-
-    std::string txIDString = binToHex(tx->getContentsHash());
-    uint32_t txIndex = static_cast<uint32_t>(resultSet.results.size());
-
-    std::string sqlStr;
-    if (cfg.isUsingBucketListDB())
-    {
-        sqlStr = "INSERT INTO txhistory "
-                 "( txid, ledgerseq, txindex,  txbody, txresult) VALUES "
-                 "(:id,  :seq,      :txindex, :txb,   :txres)";
-    }
-    else
+    mTxIDs.emplace_back(binToHex(tx->getContentsHash()));
+    mTxIndexes.emplace_back(static_cast<uint32_t>(resultSet.results.size()));
+    mTxBodies.emplace_back(
+        decoder::encode_b64(xdr::xdr_to_opaque(tx->getEnvelope())));
+    mTxResults.emplace_back(
+        decoder::encode_b64(xdr::xdr_to_opaque(resultSet.results.back())));
+    if (!mConfig.isUsingBucketListDB())
     {
-        sqlStr =
-            "INSERT INTO txhistory "
-            "( txid, ledgerseq, txindex,  txbody, txresult, txmeta) VALUES "
-            "(:id,  :seq,      :txindex, :txb,   :txres,   :meta)";
+        mTxMetas.emplace_back(decoder::encode_b64(xdr::xdr_to_opaque(tm)));
     }
+}
 
-    auto prep = db.getPreparedStatement(sqlStr);
-    auto& st = prep.statement();
-    st.exchange(soci::use(txIDString));
-    st.exchange(soci::use(ledgerSeq));
-    st.exchange(soci::use(txIndex));
-    st.exchange(soci::use(txBody));
-    st.exchange(soci::use(txResult));
+void
+TransactionHistoryWriter::addTransactionFee(TransactionFrameBasePtr const& tx,
+                                            LedgerEntryChanges const& changes,
+                                            uint32_t txIndex)
+{
+    ZoneScoped;
+    mFeeTxIDs.emplace_back(binToHex(tx->getContentsHash()));
+    mFeeTxIndexes.emplace_back(txIndex);
+    mFeeChanges.emplace_back(decoder::encode_b64(xdr::xdr_to_opaque(changes)));
+}
 
-    if (!cfg.isUsingBucketListDB())
+void
+TransactionHistoryWriter::flush()
+{
+    ZoneScoped;
+    if (!mTxIDs.empty())
     {
-        st.exchange(soci::use(meta));
-    }
+        std::vector<uint32_t> seqs(mTxIDs.size(), mLedgerSeq);
+        std::string sqlStr;
+        if (mConfig.isUsingBucketListDB())
+        {
+            sqlStr = "INSERT INTO txhistory "
+                     "( txid, ledgerseq, txindex,  txbody, txresult) VALUES "
+                     "(:id,  :seq,      :txindex, :txb,   :txres)";
+        }
+        else
+        {
+            sqlStr =
+                "INSERT INTO txhistory "
+                "( txid, ledgerseq, txindex,  txbody, txresult, txmeta) VALUES "
+                "(:id,  :seq,      :txindex, :txb,   :txres,   :meta)";
+        }
 
-    st.define_and_bind();
-    {
-        auto timer = db.getInsertTimer("txhistory");
-        st.execute(true);
-    }
+        auto prep = mDb.getPreparedStatement(sqlStr);
+        auto& st = prep.statement();
+        st.exchange(soci::use(mTxIDs, "id"));
+        st.exchange(soci::use(seqs, "seq"));
+        st.exchange(soci::use(mTxIndexes, "txindex"));
+        st.exchange(soci::use(mTxBodies, "txb"));
+        st.exchange(soci::use(mTxResults, "txres"));
+        if (!mConfig.isUsingBucketListDB())
+        {
+            st.exchange(soci::use(mTxMetas, "meta"));
+        }
+        st.define_and_bind();
+        {
+            auto timer = mDb.getInsertTimer("txhistory");
+            st.execute(true);
+        }
+        if (st.get_affected_rows() != mTxIDs.size())
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
 
-    if (st.get_affected_rows() != 1)
-    {
-        throw std::runtime_error("Could not update data in SQL");
+        mTxIDs.clear();
+        mTxIndexes.clear();
+        mTxBodies.clear();
+        mTxResults.clear();
+        mTxMetas.clear();
+    }
+
+    if (!mFeeTxIDs.empty())
+    {
+        std::vector<uint32_t> seqs(mFeeTxIDs.size(), mLedgerSeq);
+        auto prep = mDb.getPreparedStatement(
+            "INSERT INTO txfeehistory "
+            "( txid, ledgerseq, txindex,  txchanges) VALUES "
+            "(:id,  :seq,      :txindex, :txchanges)");
+        auto& st = prep.statement();
+        st.exchange(soci::use(mFeeTxIDs, "id"));
+        st.exchange(soci::use(seqs, "seq"));
+        st.exchange(soci::use(mFeeTxIndexes, "txindex"));
+        st.exchange(soci::use(mFeeChanges, "txchanges"));
+        st.define_and_bind();
+        {
+            auto timer = mDb.getInsertTimer("txfeehistory");
+            st.execute(true);
+        }
+        if (st.get_affected_rows() != mFeeTxIDs.size())
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+
+        mFeeTxIDs.clear();
+        mFeeTxIndexes.clear();
+        mFeeChanges.clear();
     }
 }
 
@@ -435,38 +494,6 @@ storeTxSet(Database& db, uint32_t ledgerSeq, TxSetXDRFrame const& txSet)
     }
 }
 
-void
-storeTransactionFee(Database& db, uint32_t ledgerSeq,
-                    TransactionFrameBasePtr const& tx,
-                    LedgerEntryChanges const& changes, uint32_t txIndex)
-{
-    ZoneScoped;
-    std::string txChanges = decoder::encode_b64(xdr::xdr_to_opaque(changes));
-
-    std::string txIDString = binToHex(tx->getContentsHash());
-
-    auto prep = db.getPreparedStatement(
-        "INSERT INTO txfeehistory "
-        "( txid, ledgerseq, txindex,  txchanges) VALUES "
-        "(:id,  :seq,      :txindex, :txchanges)");
-
-    auto& st = prep.statement();
-    st.exchange(soci::use(txIDString));
-    st.exchange(soci::use(ledgerSeq));
-    st.exchange(soci::use(txIndex));
-    st.exchange(soci::use(txChanges));
-    st.define_and_bind();
-    {
-        auto timer = db.getInsertTimer("txfeehistory");
-        st.execute(true);
-    }
-
-    if (st.get_affected_rows() != 1)
-    {
-        throw std::runtime_error("Could not update data in SQL");
-    }
-}
-
 TransactionResultSet
 getTransactionHistoryResults(Database& db, uint32 ledgerSeq)
 {
@@ -667,15 +694,15 @@ dropTransactionHistory(Database& db, Config const& cfg)
 }
 
 void
-deleteOldTransactionHistoryEntries(Database& db, uint32_t ledgerSeq,
+deleteOldTransactionHistoryEntries(soci::session& sess, uint32_t ledgerSeq,
                                    uint32_t count)
 {
     ZoneScoped;
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "txhistory", "ledgerseq");
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
+    DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count, "txhistory",
+                                          "ledgerseq");
+    DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
                                           "txsethistory", "ledgerseq");
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
+    DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
                                           "txfeehistory", "ledgerseq");
 }
 
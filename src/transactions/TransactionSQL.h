@@ -8,22 +8,53 @@
 #include "herder/TxSetFrame.h"
 #include "overlay/StellarXDR.h"
 #include "transactions/TransactionFrameBase.h"
+#include "util/NonCopyable.h"
+#include <string>
+#include <vector>
 
 namespace stellar
 {
 class Application;
 class XDROutputFileStream;
 
-void storeTransaction(Database& db, uint32_t ledgerSeq,
-                      TransactionFrameBasePtr const& tx,
-                      TransactionMeta const& tm,
-                      TransactionResultSet const& resultSet, Config const& cfg);
+// Accumulates the txhistory and txfeehistory rows of the transactions of a
+// ledger, and inserts them with one bulk statement per table on flush instead
+// of one statement per transaction. Rows are written on the main session, in
+// the ledger close transaction, so that they commit atomically with the
+// ledger they belong to.
+class TransactionHistoryWriter : NonMovableOrCopyable
+{
+    Database& mDb;
+    Config const& mConfig;
+    uint32_t const mLedgerSeq;
 
-void storeTxSet(Database& db, uint32_t ledgerSeq, TxSetXDRFrame const& txSet);
+    std::vector<std::string> mTxIDs;
+    std::vector<uint32_t> mTxIndexes;
+    std::vector<std::string> mTxBodies;
+    std::vector<std::string> mTxResults;
+    std::vector<std::string> mTxMetas;
+
+    std::vector<std::string> mFeeTxIDs;
+    std::vector<uint32_t> mFeeTxIndexes;
+    std::vector<std::string> mFeeChanges;
+
+  public:
+    TransactionHistoryWriter(Database& db, Config const& cfg,
+                             uint32_t ledgerSeq);
 
-void storeTransactionFee(Database& db, uint32_t ledgerSeq,
-                         TransactionFrameBasePtr const& tx,
-                         LedgerEntryChanges const& changes, uint32_t txIndex);
+    // Adds the txhistory row of the last transaction of resultSet
+    void addTransaction(TransactionFrameBasePtr const& tx,
+                        TransactionMeta const& tm,
+                        TransactionResultSet const& resultSet);
+
+    void addTransactionFee(TransactionFrameBasePtr const& tx,
+                           LedgerEntryChanges const& changes, uint32_t txIndex);
+
+    // Inserts the rows added so far
+    void flush();
+};
+
+void storeTxSet(Database& db, uint32_t ledgerSeq, TxSetXDRFrame const& txSet);
 
 TransactionResultSet getTransactionHistoryResults(Database& db,
                                                   uint32 ledgerSeq);
@@ -40,8 +71,8 @@ void createTxSetHistoryTable(Database& db);
 
 void dropTransactionHistory(Database& db, Config const& cfg);
 
-void deleteOldTransactionHistoryEntries(Database& db, uint32_t ledgerSeq,
-                                        uint32_t count);
+void deleteOldTransactionHistoryEntries(soci::session& sess,
+                                        uint32_t ledgerSeq, uint32_t count);
 
 void deleteNewerTransactionHistoryEntries(Database& db, uint32_t ledgerSeq);
 }
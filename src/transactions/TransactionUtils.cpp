@@ -3,6 +3,9 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "transactions/TransactionUtils.h"
+#include "bucket/BucketListSnapshot.h"
+#include "bucket/LedgerCmp.h"
+#include "crypto/KeyUtils.h"
 #include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
 #include "ledger/InternalLedgerEntry.h"
@@ -11,13 +14,17 @@
 #include "ledger/LedgerTxnHeader.h"
 #include "ledger/TrustLineWrapper.h"
 #include "transactions/OfferExchange.h"
+#include "transactions/SignatureUtils.h"
 #include "transactions/SponsorshipUtils.h"
+#include "transactions/TransactionFrameBase.h"
+#include "util/GlobalChecks.h"
 #include "util/ProtocolVersion.h"
+#include "util/Tracing.h"
+#include "util/UnorderedMap.h"
 #include "util/XDROperators.h"
 #include "util/types.h"
 #include "xdr/Stellar-contract.h"
 #include "xdr/Stellar-ledger-entries.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -1860,6 +1867,67 @@ validateContractLedgerEntry(LedgerKey const& lk, size_t entrySize,
     return true;
 }
 
+void
+preVerifySignatures(std::vector<EnvelopeSignatures> const& envelopes,
+                    size_t begin, size_t end,
+                    SearchableBucketListSnapshot* snapshot)
+{
+    ZoneScoped;
+    releaseAssert(begin <= end && end <= envelopes.size());
+
+    UnorderedMap<AccountID, std::vector<PublicKey>> signers;
+    std::set<LedgerKey, LedgerEntryIdCmp> keys;
+    for (auto i = begin; i < end; ++i)
+    {
+        for (auto const& id : envelopes[i].mAccounts)
+        {
+            auto res = signers.try_emplace(id);
+            if (res.second)
+            {
+                res.first->second.emplace_back(id);
+                keys.emplace(accountKey(id));
+            }
+        }
+    }
+    if (snapshot)
+    {
+        for (auto const& le : snapshot->loadKeys(keys))
+        {
+            auto const& ae = le.data.account();
+            auto& keysOfAccount = signers[ae.accountID];
+            for (auto const& signer : ae.signers)
+            {
+                if (signer.key.type() == SIGNER_KEY_TYPE_ED25519)
+                {
+                    keysOfAccount.emplace_back(
+                        KeyUtils::convertKey<PublicKey>(signer.key));
+                }
+            }
+        }
+    }
+
+    std::vector<PubKeyUtils::SignatureToVerify> toVerify;
+    for (auto i = begin; i < end; ++i)
+    {
+        auto const& env = envelopes[i];
+        for (auto const& sig : env.mSignatures)
+        {
+            for (auto const& id : env.mAccounts)
+            {
+                for (auto const& key : signers[id])
+                {
+                    if (SignatureUtils::doesHintMatch(key.ed25519(), sig.hint))
+                    {
+                        toVerify.push_back(
+                            {key, sig.signature, env.mContentsHash});
+                    }
+                }
+            }
+        }
+    }
+    PubKeyUtils::verifySigs(toVerify);
+}
+
 LumenContractInfo
 getLumenContractInfo(Hash const& networkID)
 {
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <optional>
+#include <vector>
 
 namespace stellar
 {
@@ -28,7 +29,9 @@ class InternalLedgerKey;
 class SorobanNetworkConfig;
 class TransactionFrame;
 class TransactionFrameBase;
+class SearchableBucketListSnapshot;
 struct ClaimAtom;
+struct EnvelopeSignatures;
 struct LedgerHeader;
 struct LedgerKey;
 struct TransactionEnvelope;
@@ -310,6 +313,15 @@ bool validateContractLedgerEntry(LedgerKey const& lk, size_t entrySize,
                                  Config const& appConfig,
                                  TransactionFrame& parentTx);
 
+// Verifies the signatures of envelopes[begin, end) against the master keys of
+// the accounts they may belong to and, if snapshot is set, against the other
+// ed25519 signers of those accounts as loaded from it. Results only fill the
+// signature verification cache, so this can run on any thread ahead of
+// checkValid.
+void preVerifySignatures(std::vector<EnvelopeSignatures> const& envelopes,
+                         size_t begin, size_t end,
+                         SearchableBucketListSnapshot* snapshot);
+
 struct LumenContractInfo
 {
     Hash mLumenContractID;
@@ -317,10 +317,14 @@ TEST_CASE("Native stellar asset contract",
         checkSponsorship(ltx, root.getPublicKey(), 0, nullptr, 0, 2, 2, 0);
     }
 
+    auto& sacTimer = app.getMetrics().NewTimer(
+        {"soroban", "host-fn-op", "sac-invoke-time-nsecs"});
     AssetContractTestClient client(test, txtest::makeNativeAsset());
     // transfer 10 XLM from a1 to contractID
     auto contractAddr = makeContractAddress(sha256("contract"));
+    auto sacCallsBefore = sacTimer.count();
     REQUIRE(client.transfer(a1, contractAddr, 10));
+    REQUIRE(sacTimer.count() == sacCallsBefore + 1);
 
     auto a2Addr = makeAccountAddress(a2);
     // Now do an account to account transfer
@@ -348,6 +352,7 @@ TEST_CASE("Native stellar asset contract",
         client.makeBalanceKey(transferContract.getAddress());
 
     // Contract -> Contract
+    sacCallsBefore = sacTimer.count();
     auto contractToContractSpec = invocationSpec.extendReadWriteFootprint(
         {fromBalanceKey, client.makeBalanceKey(contractAddr)});
     REQUIRE(transferContract
@@ -360,6 +365,8 @@ TEST_CASE("Native stellar asset contract",
 
     REQUIRE(client.getBalance(transferContract.getAddress()) == 9);
     REQUIRE(client.getBalance(contractAddr) == 11);
+    // Calls into the asset contract from another contract are not counted
+    REQUIRE(sacTimer.count() == sacCallsBefore);
 
     // Contract -> Account
     auto a2BalanceSnapshot = a2.getBalance();
@@ -1334,6 +1341,70 @@ TEST_CASE("buying liabilities plus refund is greater than INT64_MAX",
     REQUIRE(a1PreBalance - feeChargedBeforeRefund == a1.getBalance());
 }
 
+TEST_CASE("parallel soroban apply", "[tx][soroban]")
+{
+    auto cfg = getTestConfig();
+    cfg.EXPERIMENTAL_PARALLEL_SOROBAN_APPLY = true;
+    SorobanTest test(cfg);
+    ContractStorageTestClient client(test);
+    auto& precomputedMeter = test.getApp().getMetrics().NewMeter(
+        {"soroban", "host-fn-op", "precomputed"}, "call");
+
+    const int64_t startingBalance =
+        test.getApp().getLedgerManager().getLastMinBalance(50);
+    auto a1 = test.getRoot().create("A", startingBalance);
+    auto b1 = test.getRoot().create("B", startingBalance);
+    auto c1 = test.getRoot().create("C", startingBalance);
+
+    auto putTx = [&](std::string const& key, uint64_t val,
+                     TestAccount& source) {
+        auto invocation = client.getContract().prepareInvocation(
+            "put_persistent", {makeSymbolSCVal(key), makeU64SCVal(val)},
+            client.writeKeySpec(key, ContractDataDurability::PERSISTENT));
+        return invocation.withExactNonRefundableResourceFee().createTx(
+            &source);
+    };
+    auto checkAllSucceeded = [](TxSetResultMeta& r) {
+        for (size_t i = 0; i < r.size(); ++i)
+        {
+            checkTx(static_cast<int>(i), r, txSUCCESS);
+        }
+    };
+
+    SECTION("independent transactions")
+    {
+        auto before = precomputedMeter.count();
+        auto r = closeLedger(test.getApp(), {putTx("key1", 1, a1),
+                                             putTx("key2", 2, b1),
+                                             putTx("key3", 3, c1)});
+        checkAllSucceeded(r);
+        REQUIRE(precomputedMeter.count() - before == 3);
+
+        REQUIRE(client.get("key1", ContractDataDurability::PERSISTENT, 1) ==
+                INVOKE_HOST_FUNCTION_SUCCESS);
+        REQUIRE(client.get("key2", ContractDataDurability::PERSISTENT, 2) ==
+                INVOKE_HOST_FUNCTION_SUCCESS);
+        REQUIRE(client.get("key3", ContractDataDurability::PERSISTENT, 3) ==
+                INVOKE_HOST_FUNCTION_SUCCESS);
+    }
+    SECTION("conflicting transactions")
+    {
+        // Only the first write of key1 in apply order is precomputed, the
+        // second one has to see its result
+        auto before = precomputedMeter.count();
+        auto r = closeLedger(test.getApp(), {putTx("key1", 1, a1),
+                                             putTx("key1", 2, b1),
+                                             putTx("key2", 3, c1)});
+        checkAllSucceeded(r);
+        REQUIRE(precomputedMeter.count() - before == 2);
+
+        REQUIRE(client.get("key2", ContractDataDurability::PERSISTENT, 3) ==
+                INVOKE_HOST_FUNCTION_SUCCESS);
+        REQUIRE(client.has("key1", ContractDataDurability::PERSISTENT, true) ==
+                INVOKE_HOST_FUNCTION_SUCCESS);
+    }
+}
+
 TEST_CASE("failure diagnostics", "[tx][soroban]")
 {
     auto cfg = getTestConfig();
@@ -4182,6 +4253,31 @@ TEST_CASE("Module cache", "[tx][soroban]")
     REQUIRE(invocation(4'000'000));
 }
 
+TEST_CASE("contract code cache", "[tx][soroban]")
+{
+    SorobanTest test;
+    ContractStorageTestClient client(test);
+    auto& metrics = test.getApp().getMetrics();
+    auto& hitMeter =
+        metrics.NewMeter({"soroban", "code-cache", "hit"}, "entry");
+    auto& reusedTimer = metrics.NewTimer(
+        {"soroban", "code-cache", "reused-vm-instantiation"});
+
+    REQUIRE(client.put("key", ContractDataDurability::PERSISTENT, 1) ==
+            INVOKE_HOST_FUNCTION_SUCCESS);
+
+    // The code is now cached, so further calls reuse its encoding
+    auto hitsBefore = hitMeter.count();
+    auto reusedBefore = reusedTimer.count();
+    for (uint64_t i = 0; i < 3; ++i)
+    {
+        REQUIRE(client.get("key", ContractDataDurability::PERSISTENT, 1) ==
+                INVOKE_HOST_FUNCTION_SUCCESS);
+    }
+    REQUIRE(hitMeter.count() - hitsBefore == 3);
+    REQUIRE(reusedTimer.count() - reusedBefore == 3);
+}
+
 TEST_CASE("Vm instantiation tightening", "[tx][soroban]")
 {
     VirtualClock clock;
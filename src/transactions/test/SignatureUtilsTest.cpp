@@ -8,6 +8,8 @@
 #include "crypto/SignerKey.h"
 #include "crypto/SignerKeyUtils.h"
 #include "lib/catch.hpp"
+#include "main/Config.h"
+#include "transactions/SignatureChecker.h"
 #include "xdr/Stellar-transaction.h"
 
 using namespace stellar;
@@ -46,3 +48,46 @@ TEST_CASE("Hash(x) signature", "[signature]")
         REQUIRE_THROWS_AS(SignatureUtils::signHashX(s), xdr::xdr_overflow);
     }
 }
+
+TEST_CASE("SignatureChecker across several checks", "[signature]")
+{
+    auto hash = sha256("CONTENTS");
+    auto a = SecretKey::pseudoRandomForTesting();
+    auto b = SecretKey::pseudoRandomForTesting();
+    auto c = SecretKey::pseudoRandomForTesting();
+    auto signerOf = [](SecretKey const& k, uint32_t weight) {
+        return Signer{KeyUtils::convertKey<SignerKey>(k.getPublicKey()),
+                      weight};
+    };
+    auto preimage = std::string("PREIMAGE");
+
+    xdr::xvector<DecoratedSignature, 20> signatures;
+    signatures.emplace_back(SignatureUtils::sign(a, hash));
+    // Signed by b, but not for these contents
+    signatures.emplace_back(SignatureUtils::sign(b, sha256("OTHER")));
+    signatures.emplace_back(SignatureUtils::signHashX(preimage));
+    signatures.emplace_back(SignatureUtils::sign(c, hash));
+
+    SignatureChecker checker(Config::CURRENT_LEDGER_PROTOCOL_VERSION, hash,
+                             signatures);
+    std::vector<Signer> signers{
+        signerOf(a, 1), signerOf(b, 10), signerOf(c, 2),
+        Signer{SignerKeyUtils::hashXKey(preimage), 4}};
+
+    // The same signers checked several times, as for a transaction and its
+    // operations, give the same result each time
+    for (int i = 0; i < 3; ++i)
+    {
+        REQUIRE(checker.checkSignature(signers, 7));
+        REQUIRE(!checker.checkSignature(signers, 8));
+    }
+    REQUIRE(!checker.checkAllSignaturesUsed());
+
+    // b's signature can't count for any signer
+    std::vector<Signer> onlyB{signerOf(b, 1)};
+    REQUIRE(!checker.checkSignature(onlyB, 1));
+    REQUIRE(!checker.checkAllSignaturesUsed());
+
+    std::vector<Signer> onlyA{signerOf(a, 1)};
+    REQUIRE(checker.checkSignature(onlyA, 1));
+}
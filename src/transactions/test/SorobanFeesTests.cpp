@@ -0,0 +1,121 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/SorobanFees.h"
+#include "lib/catch.hpp"
+#include "main/Config.h"
+#include "util/Math.h"
+#include "util/ProtocolVersion.h"
+
+#include <limits>
+
+using namespace stellar;
+
+namespace
+{
+// Checks against the host of every protocol the port is used for
+void
+checkParity(CxxTransactionResources const& resources,
+            CxxFeeConfiguration const& feeConfig)
+{
+    auto fee = computeNativeTransactionResourceFee(resources, feeConfig);
+    for (uint32_t v = static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+         v <= Config::CURRENT_LEDGER_PROTOCOL_VERSION; ++v)
+    {
+        if (!isNativeResourceFeeProtocol(v))
+        {
+            continue;
+        }
+        auto hostFee = rust_bridge::compute_transaction_resource_fee(
+            Config::CURRENT_LEDGER_PROTOCOL_VERSION, v, resources, feeConfig);
+        REQUIRE(fee.non_refundable_fee == hostFee.non_refundable_fee);
+        REQUIRE(fee.refundable_fee == hostFee.refundable_fee);
+    }
+}
+
+uint32_t
+randomValue(uint32_t max)
+{
+    // Favor the edges, where rounding and saturation happen
+    switch (rand_uniform<int>(0, 3))
+    {
+    case 0:
+        return 0;
+    case 1:
+        return max;
+    default:
+        return rand_uniform<uint32_t>(0, max);
+    }
+}
+
+int64_t
+randomRate()
+{
+    switch (rand_uniform<int>(0, 3))
+    {
+    case 0:
+        return 0;
+    case 1:
+        return std::numeric_limits<int64_t>::max();
+    default:
+        return rand_uniform<int64_t>(0, 1'000'000'000);
+    }
+}
+}
+
+TEST_CASE("native soroban resource fee matches the host", "[soroban][fees]")
+{
+    if (protocolVersionIsBefore(Config::CURRENT_LEDGER_PROTOCOL_VERSION,
+                                SOROBAN_PROTOCOL_VERSION))
+    {
+        return;
+    }
+
+    SECTION("only used for the protocols it was checked against")
+    {
+        REQUIRE(!isNativeResourceFeeProtocol(
+            static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION) - 1));
+        REQUIRE(isNativeResourceFeeProtocol(
+            static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION)));
+        REQUIRE(isNativeResourceFeeProtocol(
+            static_cast<uint32_t>(LAST_NATIVE_RESOURCE_FEE_PROTOCOL_VERSION)));
+        REQUIRE(!isNativeResourceFeeProtocol(
+            static_cast<uint32_t>(LAST_NATIVE_RESOURCE_FEE_PROTOCOL_VERSION) +
+            1));
+    }
+
+    SECTION("no resources")
+    {
+        CxxFeeConfiguration feeConfig{};
+        feeConfig.fee_per_historical_1kb = 16235;
+        checkParity(CxxTransactionResources{}, feeConfig);
+    }
+
+    SECTION("random resources and rates")
+    {
+        for (int i = 0; i < 10000; ++i)
+        {
+            auto const maxValue = std::numeric_limits<uint32_t>::max();
+            CxxTransactionResources resources{};
+            resources.instructions = randomValue(maxValue);
+            resources.read_entries = randomValue(maxValue);
+            resources.write_entries = randomValue(maxValue);
+            resources.read_bytes = randomValue(maxValue);
+            resources.write_bytes = randomValue(maxValue);
+            resources.contract_events_size_bytes = randomValue(maxValue);
+            resources.transaction_size_bytes = randomValue(maxValue);
+
+            CxxFeeConfiguration feeConfig{};
+            feeConfig.fee_per_instruction_increment = randomRate();
+            feeConfig.fee_per_read_entry = randomRate();
+            feeConfig.fee_per_write_entry = randomRate();
+            feeConfig.fee_per_read_1kb = randomRate();
+            feeConfig.fee_per_write_1kb = randomRate();
+            feeConfig.fee_per_historical_1kb = randomRate();
+            feeConfig.fee_per_contract_event_1kb = randomRate();
+            feeConfig.fee_per_transaction_size_1kb = randomRate();
+            checkParity(resources, feeConfig);
+        }
+    }
+}
@@ -2833,3 +2833,121 @@ TEST_CASE("soroban transaction validation", "[tx][envelope][soroban]")
         }
     }
 }
+
+TEST_CASE("operation frames are kept across validation", "[tx][envelope]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+    auto a1 = root.create("a1", app->getLedgerManager().getLastMinBalance(0));
+
+    auto txBase = transactionFrameFromOps(
+        app->getNetworkID(), root, {payment(a1, 100), payment(a1, 200)}, {});
+    auto tx = std::static_pointer_cast<TransactionFrame>(txBase);
+
+    auto requireBound = [&]() {
+        auto const& ops = tx->getOperations();
+        auto const& results = tx->getResult().result.results();
+        REQUIRE(ops.size() == results.size());
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            REQUIRE(&ops[i]->getResult() == &results[i]);
+        }
+    };
+
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+        requireBound();
+        auto ops = tx->getOperations();
+
+        REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+        requireBound();
+        REQUIRE(tx->getOperations() == ops);
+
+        // A result code without operation results drops the results, so the
+        // frames have to be bound again
+        REQUIRE(!tx->checkValid(*app, ltx, 1, 0, 0));
+        REQUIRE(tx->getResultCode() == txBAD_SEQ);
+        REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+        requireBound();
+    }
+
+    SECTION("kept results are reset")
+    {
+        // The operation of b2 fails for lack of its signature, then the
+        // operation of b1 fails before the one of b2 is checked again
+        auto balance = app->getLedgerManager().getLastMinBalance(0) + 1000;
+        auto b1 = root.create("b1", balance);
+        auto b2 = root.create("b2", balance);
+        auto txBase2 = transactionFrameFromOps(
+            app->getNetworkID(), root,
+            {b1.op(payment(root, 1)), b2.op(payment(root, 1))}, {b1});
+        auto tx2 = std::static_pointer_cast<TransactionFrame>(txBase2);
+        {
+            LedgerTxn ltx(app->getLedgerTxnRoot());
+            REQUIRE(!tx2->checkValid(*app, ltx, 0, 0, 0));
+            auto const& results = tx2->getResult().result.results();
+            REQUIRE(results[0].code() == opINNER);
+            REQUIRE(results[1].code() == opBAD_AUTH);
+        }
+
+        b1.setOptions(setMasterWeight(0));
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(!tx2->checkValid(*app, ltx, 0, 0, 0));
+        auto const& results = tx2->getResult().result.results();
+        REQUIRE(results[0].code() == opBAD_AUTH);
+        REQUIRE(results[1].code() == opINNER);
+        REQUIRE(results[1].tr().type() == PAYMENT);
+    }
+}
+
+TEST_CASE("validation is skipped while its inputs are unchanged",
+          "[tx][envelope]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+    auto a1 = root.create("a1", app->getLedgerManager().getLastMinBalance(0));
+    auto tx = root.tx({payment(a1, 100)});
+
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+        REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+        REQUIRE(tx->getResultCode() == txSUCCESS);
+
+        // Different parameters are validated again
+        REQUIRE(!tx->checkValid(*app, ltx, tx->getSeqNum(), 0, 0));
+        REQUIRE(tx->getResultCode() == txBAD_SEQ);
+        REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+    }
+
+    SECTION("source account changed")
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        auto account = stellar::loadAccount(ltx, root.getPublicKey());
+        account.current().data.account().seqNum = tx->getSeqNum();
+        REQUIRE(!tx->checkValid(*app, ltx, 0, 0, 0));
+        REQUIRE(tx->getResultCode() == txBAD_SEQ);
+    }
+    SECTION("operation source account changed")
+    {
+        auto opTx = root.tx({a1.op(payment(root, 100))});
+        opTx->addSignature(a1.getSecretKey());
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(opTx->checkValid(*app, ltx, 0, 0, 0));
+        {
+            auto account = stellar::loadAccount(ltx, a1.getPublicKey());
+            account.current().data.account().thresholds[THRESHOLD_MED] = 100;
+        }
+        REQUIRE(!opTx->checkValid(*app, ltx, 0, 0, 0));
+        REQUIRE(opTx->getResultCode() == txFAILED);
+    }
+    SECTION("ledger closed")
+    {
+        closeLedger(*app);
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+    }
+}
@@ -0,0 +1,231 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/BackgroundExecutor.h"
+#include "util/GlobalChecks.h"
+#include "util/SpanRecorder.h"
+#include "util/Thread.h"
+#include "util/Tracing.h"
+#include "util/types.h"
+#include <fmt/format.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
+
+namespace stellar
+{
+
+namespace
+{
+// The executor and worker index of the current thread, if it is a worker
+thread_local BackgroundExecutor const* tExecutor = nullptr;
+thread_local size_t tWorker = 0;
+}
+
+BackgroundExecutor::BackgroundExecutor(size_t threads,
+                                       medida::MetricsRegistry& metrics,
+                                       std::vector<uint32_t> const& cpus)
+    : mMetrics(metrics)
+{
+    releaseAssert(threads > 0);
+    for (size_t i = 0; i < NUM_PRIORITIES; ++i)
+    {
+        mPriorityWait[i] = &mMetrics.NewTimer(
+            {"app", "background-wait",
+             getPriorityName(static_cast<BackgroundPriority>(i))});
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        mWorkers.emplace_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        mThreads.emplace_back([this, i, cpus]() {
+            SpanRecorder::setThreadName(
+                fmt::format(FMT_STRING("background-{}"), i));
+            setCurrentThreadRole("worker", cpus);
+            runCurrentThreadWithLowPriority();
+            tExecutor = this;
+            tWorker = i;
+            run(i);
+        });
+    }
+}
+
+BackgroundExecutor::~BackgroundExecutor()
+{
+    shutdown();
+}
+
+std::string
+BackgroundExecutor::getPriorityName(BackgroundPriority priority)
+{
+    switch (priority)
+    {
+    case BackgroundPriority::HIGH:
+        return "high";
+    case BackgroundPriority::NORMAL:
+        return "normal";
+    case BackgroundPriority::LOW:
+        return "low";
+    default:
+        throw std::runtime_error("Unknown background priority");
+    }
+}
+
+medida::Timer&
+BackgroundExecutor::getJobWaitTimer(std::string const& jobName)
+{
+    std::lock_guard<std::mutex> lock(mJobWaitMutex);
+    auto it = mJobWait.find(jobName);
+    if (it == mJobWait.end())
+    {
+        auto& timer = mMetrics.NewTimer(
+            {"app", "background-job-wait", toMetricName(jobName)});
+        it = mJobWait.emplace(jobName, &timer).first;
+    }
+    return *it->second;
+}
+
+void
+BackgroundExecutor::post(std::function<void()>&& f, std::string const& jobName,
+                         BackgroundPriority priority,
+                         std::optional<size_t> affinity)
+{
+    auto p = static_cast<size_t>(priority);
+    releaseAssert(p < NUM_PRIORITIES);
+    Job job{std::move(f), Clock::now(), p, &getJobWaitTimer(jobName)};
+
+    // Jobs posted by a job stay on its worker, where their inputs are likely
+    // still in cache, unless another worker is idle and steals them
+    size_t w;
+    if (affinity)
+    {
+        w = *affinity % mWorkers.size();
+    }
+    else if (tExecutor == this)
+    {
+        w = tWorker;
+    }
+    else
+    {
+        w = mNextWorker++ % mWorkers.size();
+    }
+
+    auto& worker = *mWorkers[w];
+    {
+        std::lock_guard<std::mutex> lock(worker.mMutex);
+        if (affinity)
+        {
+            worker.mPinnedJobs[p].emplace_back(std::move(job));
+            ++worker.mPinned;
+        }
+        else
+        {
+            worker.mJobs[p].emplace_back(std::move(job));
+            ++mStealable;
+        }
+    }
+
+    // Taking the lock orders this with a worker checking for jobs before it
+    // sleeps, so the wake-up cannot be lost
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    if (affinity)
+    {
+        mWake.notify_all();
+    }
+    else
+    {
+        mWake.notify_one();
+    }
+}
+
+bool
+BackgroundExecutor::takeJob(size_t w, Job& job)
+{
+    auto& own = *mWorkers[w];
+    for (size_t p = 0; p < NUM_PRIORITIES; ++p)
+    {
+        {
+            std::lock_guard<std::mutex> lock(own.mMutex);
+            if (!own.mPinnedJobs[p].empty())
+            {
+                job = std::move(own.mPinnedJobs[p].front());
+                own.mPinnedJobs[p].pop_front();
+                --own.mPinned;
+                return true;
+            }
+            if (!own.mJobs[p].empty())
+            {
+                job = std::move(own.mJobs[p].front());
+                own.mJobs[p].pop_front();
+                --mStealable;
+                return true;
+            }
+        }
+
+        // Steal the oldest job of this class before settling for a less
+        // urgent one of our own
+        for (size_t i = 1; i < mWorkers.size() && mStealable > 0; ++i)
+        {
+            auto& victim = *mWorkers[(w + i) % mWorkers.size()];
+            std::lock_guard<std::mutex> lock(victim.mMutex);
+            if (!victim.mJobs[p].empty())
+            {
+                job = std::move(victim.mJobs[p].front());
+                victim.mJobs[p].pop_front();
+                --mStealable;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void
+BackgroundExecutor::run(size_t w)
+{
+    auto& own = *mWorkers[w];
+    for (;;)
+    {
+        Job job;
+        if (takeJob(w, job))
+        {
+            auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - job.mPosted);
+            mPriorityWait[job.mPriority]->Update(waited);
+            job.mJobWait->Update(waited);
+            ZoneScopedN("background job");
+            job.mFn();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        if (mStopping && mStealable == 0 && own.mPinned == 0)
+        {
+            return;
+        }
+        mWake.wait(lock, [&]() {
+            return mStopping || mStealable > 0 || own.mPinned > 0;
+        });
+    }
+}
+
+void
+BackgroundExecutor::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        if (mStopping)
+        {
+            return;
+        }
+        mStopping = true;
+        mWake.notify_all();
+    }
+    for (auto& t : mThreads)
+    {
+        t.join();
+    }
+}
+}
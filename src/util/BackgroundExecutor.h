@@ -0,0 +1,110 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/BackgroundPriority.h"
+#include "util/NonCopyable.h"
+#include "util/UnorderedMap.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace medida
+{
+class MetricsRegistry;
+class Timer;
+}
+
+namespace stellar
+{
+
+// The pool of low-priority worker threads behind
+// Application::postOnBackgroundThread.
+//
+// Each worker has its own queue per priority class. Jobs posted from a worker
+// go to that worker's queue, other jobs are spread round-robin, and a worker
+// that runs out of jobs of a class steals the oldest one from another worker
+// before it looks at a less urgent class. Jobs posted with an affinity run
+// only on that worker, in order, and are never stolen.
+//
+// The time each job waits in the queues is recorded per priority class and
+// per job name.
+class BackgroundExecutor : public NonMovableOrCopyable
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Job
+    {
+        std::function<void()> mFn;
+        Clock::time_point mPosted;
+        size_t mPriority{0};
+        medida::Timer* mJobWait{nullptr};
+    };
+
+    static constexpr size_t NUM_PRIORITIES =
+        static_cast<size_t>(BackgroundPriority::NUM_PRIORITIES);
+
+    struct Worker
+    {
+        std::mutex mMutex;
+        std::array<std::deque<Job>, NUM_PRIORITIES> mJobs;
+        std::array<std::deque<Job>, NUM_PRIORITIES> mPinnedJobs;
+        std::atomic<size_t> mPinned{0};
+    };
+
+    medida::MetricsRegistry& mMetrics;
+    std::array<medida::Timer*, NUM_PRIORITIES> mPriorityWait;
+
+    std::mutex mJobWaitMutex;
+    UnorderedMap<std::string, medida::Timer*> mJobWait;
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+    std::atomic<size_t> mNextWorker{0};
+    std::atomic<size_t> mStealable{0};
+
+    std::mutex mSleepMutex;
+    std::condition_variable mWake;
+    bool mStopping{false};
+
+    medida::Timer& getJobWaitTimer(std::string const& jobName);
+    bool takeJob(size_t worker, Job& job);
+    void run(size_t worker);
+
+  public:
+    // Workers are restricted to `cpus` unless empty
+    BackgroundExecutor(size_t threads, medida::MetricsRegistry& metrics,
+                       std::vector<uint32_t> const& cpus = {});
+    ~BackgroundExecutor();
+
+    size_t
+    getNumThreads() const
+    {
+        return mWorkers.size();
+    }
+
+    // Queues `f` to run on a worker thread. With an affinity, it runs on
+    // worker `*affinity % getNumThreads()`, after any job posted earlier with
+    // the same affinity and priority.
+    void post(std::function<void()>&& f, std::string const& jobName,
+              BackgroundPriority priority = BackgroundPriority::NORMAL,
+              std::optional<size_t> affinity = std::nullopt);
+
+    // Runs every job already queued, and any they post in turn, then joins
+    // the worker threads. Jobs posted after that are dropped.
+    void shutdown();
+
+    static std::string getPriorityName(BackgroundPriority priority);
+};
+}
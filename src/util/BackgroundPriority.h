@@ -0,0 +1,24 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+namespace stellar
+{
+
+// Priority classes of background jobs, most urgent first. A worker always
+// takes the most urgent job it can find, so jobs of a class only run while no
+// job of a more urgent class is waiting.
+enum class BackgroundPriority
+{
+    // Needed to close the next ledger: bucket merges, signature verification
+    // and other work that apply waits on
+    HIGH,
+    // Everything else, notably catchup downloads, verification and hashing
+    NORMAL,
+    // Diagnostics that nothing waits on, like quorum intersection checks
+    LOW,
+    NUM_PRIORITIES
+};
+}
@@ -0,0 +1,164 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "util/GlobalChecks.h"
+#include "util/NonCopyable.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+
+namespace stellar
+{
+
+// A bounded, lock-free queue handing items from any number of producer
+// threads to a single consumer thread, in push order per producer.
+//
+// Each slot carries a sequence number telling whether it is free for the
+// producer of a given position or holds the item for the consumer of that
+// position (the bounded queue of D. Vyukov). Producers claim positions with a
+// compare-and-swap on the tail; the consumer never contends with them, and
+// takes items in batches.
+//
+// Counts of pushes refused because the channel was full and of retries lost to
+// other producers are kept for metrics.
+template <typename T> class MPSCChannel : public NonMovableOrCopyable
+{
+    struct Slot
+    {
+        std::atomic<size_t> mSequence;
+        std::optional<T> mItem;
+    };
+
+    size_t const mMask;
+    std::unique_ptr<Slot[]> mSlots;
+
+    // Producers and the consumer each get a cache line
+    alignas(64) std::atomic<size_t> mTail{0};
+    alignas(64) size_t mHead{0};
+    alignas(64) std::atomic<uint64_t> mFull{0};
+    std::atomic<uint64_t> mContended{0};
+
+    static size_t
+    roundUpCapacity(size_t capacity)
+    {
+        releaseAssert(capacity > 0);
+        size_t n = 1;
+        while (n < capacity)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+
+  public:
+    // The capacity is rounded up to a power of two
+    explicit MPSCChannel(size_t capacity)
+        : mMask(roundUpCapacity(capacity) - 1)
+        , mSlots(std::make_unique<Slot[]>(mMask + 1))
+    {
+        for (size_t i = 0; i <= mMask; ++i)
+        {
+            mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t
+    capacity() const
+    {
+        return mMask + 1;
+    }
+
+    // Moves `item` into the channel. Returns false, leaving `item` untouched,
+    // if the channel is full.
+    bool
+    tryPush(T& item)
+    {
+        size_t pos = mTail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& slot = mSlots[pos & mMask];
+            size_t seq = slot.mSequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (mTail.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+                {
+                    slot.mItem.emplace(std::move(item));
+                    slot.mSequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                mContended.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (diff < 0)
+            {
+                mFull.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = mTail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool
+    tryPush(T&& item)
+    {
+        return tryPush(item);
+    }
+
+    // Consumer only. Passes up to `max` items to `f`, oldest first, and
+    // returns how many. `f` may push to the channel.
+    template <typename F>
+    size_t
+    popBatch(F&& f, size_t max = std::numeric_limits<size_t>::max())
+    {
+        size_t n = 0;
+        while (n < max)
+        {
+            auto& slot = mSlots[mHead & mMask];
+            size_t seq = slot.mSequence.load(std::memory_order_acquire);
+            if (seq != mHead + 1)
+            {
+                break;
+            }
+            T item = std::move(*slot.mItem);
+            slot.mItem.reset();
+            slot.mSequence.store(mHead + mMask + 1, std::memory_order_release);
+            ++mHead;
+            ++n;
+            f(std::move(item));
+        }
+        return n;
+    }
+
+    // Consumer only
+    bool
+    empty() const
+    {
+        return mSlots[mHead & mMask].mSequence.load(
+                   std::memory_order_acquire) != mHead + 1;
+    }
+
+    // Number of pushes refused because the channel was full
+    uint64_t
+    getFullCount() const
+    {
+        return mFull.load(std::memory_order_relaxed);
+    }
+
+    // Number of times a producer lost a slot to another and had to retry
+    uint64_t
+    getContendedCount() const
+    {
+        return mContended.load(std::memory_order_relaxed);
+    }
+};
+}
@@ -4,6 +4,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include <cstdint>
 #include <iterator>
 #include <lib/util/basen.h>
 #include <string>
@@ -30,7 +31,29 @@ encode_b32(T const& v)
 {
     std::string res;
     res.reserve(encoded_size32(v.size() * sizeof(typename T::value_type)) + 1);
-    bn::encode_b32(v.begin(), v.end(), std::back_inserter(res));
+    if constexpr (sizeof(typename T::value_type) == 1)
+    {
+        // Encodes whole groups of 5 bytes into 8 characters at a time, which
+        // leaves bn::encode_b32 at a group boundary for the remaining bytes
+        static char const alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+        auto p = reinterpret_cast<unsigned char const*>(v.data());
+        auto end = p + v.size();
+        for (; end - p >= 5; p += 5)
+        {
+            uint64_t group = (uint64_t(p[0]) << 32) | (uint64_t(p[1]) << 24) |
+                             (uint64_t(p[2]) << 16) | (uint64_t(p[3]) << 8) |
+                             uint64_t(p[4]);
+            for (int shift = 35; shift >= 0; shift -= 5)
+            {
+                res.push_back(alphabet[(group >> shift) & 0x1F]);
+            }
+        }
+        bn::encode_b32(p, end, std::back_inserter(res));
+    }
+    else
+    {
+        bn::encode_b32(v.begin(), v.end(), std::back_inserter(res));
+    }
     return res;
 }
 
@@ -0,0 +1,554 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+#include "util/GlobalChecks.h"
+#include "util/RandHasher.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace stellar
+{
+
+// Hash map that stores its elements in a single array and resolves collisions
+// by linear probing, so lookups touch a few adjacent slots rather than chasing
+// bucket and node pointers. The full hash of every element is kept next to
+// it: probes compare hashes before comparing keys, and growing the table
+// never hashes a key again.
+//
+// The interface is the subset of std::unordered_map that LedgerTxn needs.
+// Unlike std::unordered_map, any insertion may move elements and invalidates
+// every iterator and reference into the map. Erasing only invalidates
+// iterators and references to the erased element.
+template <class KeyT, class ValT, class Hasher = RandHasher<KeyT>,
+          class KeyEqual = std::equal_to<KeyT>>
+class FlatHashMap
+{
+  public:
+    typedef KeyT key_type;
+    typedef ValT mapped_type;
+    typedef std::pair<KeyT const, ValT> value_type;
+
+  private:
+    // Slot markers; hashes that collide with these are remapped by fixHash
+    static constexpr size_t EMPTY = 0;
+    static constexpr size_t ERASED = 1;
+    static constexpr size_t MIN_CAPACITY = 8;
+
+    // Elements are stored with a mutable key, so that growing the table moves
+    // them rather than copying every key. They are only handed out as
+    // value_type, whose key is const, as std::unordered_map does.
+    typedef std::pair<KeyT, ValT> slot_type;
+    static_assert(sizeof(slot_type) == sizeof(value_type) &&
+                      alignof(slot_type) == alignof(value_type),
+                  "slot_type must have the layout of value_type");
+
+    // mHashes[i] describes mValues[i], which only holds a live value when
+    // mHashes[i] is neither EMPTY nor ERASED. The capacity is always zero or a
+    // power of two.
+    std::vector<size_t> mHashes;
+    slot_type* mValues{nullptr};
+    size_t mSize{0};
+    size_t mErased{0};
+
+    value_type&
+    element(size_t i)
+    {
+        return *reinterpret_cast<value_type*>(&mValues[i]);
+    }
+
+    value_type const&
+    element(size_t i) const
+    {
+        return *reinterpret_cast<value_type const*>(&mValues[i]);
+    }
+
+    static size_t
+    fixHash(size_t h)
+    {
+        return h <= ERASED ? h + 2 : h;
+    }
+
+    static bool
+    isFull(size_t h)
+    {
+        return h > ERASED;
+    }
+
+    size_t
+    capacity() const
+    {
+        return mHashes.size();
+    }
+
+    // Keep the table at most 3/4 full, counting erased slots
+    static bool
+    fits(size_t used, size_t cap)
+    {
+        return used * 4 <= cap * 3;
+    }
+
+    // Returns the slot holding key, or capacity() if there is none
+    size_t
+    findSlot(KeyT const& key, size_t h) const
+    {
+        auto cap = capacity();
+        if (mSize == 0)
+        {
+            return cap;
+        }
+        auto mask = cap - 1;
+        for (auto i = h & mask;; i = (i + 1) & mask)
+        {
+            auto slotHash = mHashes[i];
+            if (slotHash == EMPTY)
+            {
+                return cap;
+            }
+            if (slotHash == h && KeyEqual()(mValues[i].first, key))
+            {
+                return i;
+            }
+        }
+    }
+
+    // Returns the first free slot on h's probe sequence. Only valid once
+    // findSlot has established that the key is absent.
+    size_t
+    findFree(size_t h) const
+    {
+        auto mask = capacity() - 1;
+        auto i = h & mask;
+        while (isFull(mHashes[i]))
+        {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void
+    destroyValues() noexcept
+    {
+        for (size_t i = 0; i < capacity(); ++i)
+        {
+            if (isFull(mHashes[i]))
+            {
+                mValues[i].~slot_type();
+            }
+        }
+    }
+
+    void
+    release() noexcept
+    {
+        if (mValues)
+        {
+            destroyValues();
+            std::allocator<slot_type>().deallocate(mValues, capacity());
+            mValues = nullptr;
+        }
+        mHashes.clear();
+        mSize = 0;
+        mErased = 0;
+    }
+
+    // Moves every element to a table of newCap slots. Only allocating the
+    // table may fail: moving an element is not expected to throw, and if it
+    // does the process terminates rather than lose the elements moved so far.
+    void
+    rehash(size_t newCap)
+    {
+        std::vector<size_t> hashes(newCap, EMPTY);
+        auto values = std::allocator<slot_type>().allocate(newCap);
+        moveSlots(hashes, values);
+
+        auto size = mSize;
+        release();
+        mHashes.swap(hashes);
+        mValues = values;
+        mSize = size;
+    }
+
+    // Moves every element into the table of hashes and values, whose
+    // capacity is a power of two greater than mSize
+    void
+    moveSlots(std::vector<size_t>& hashes, slot_type* values) noexcept
+    {
+        auto mask = hashes.size() - 1;
+        for (size_t i = 0; i < capacity(); ++i)
+        {
+            auto h = mHashes[i];
+            if (isFull(h))
+            {
+                auto j = h & mask;
+                while (hashes[j] != EMPTY)
+                {
+                    j = (j + 1) & mask;
+                }
+                new (&values[j]) slot_type(std::move(mValues[i]));
+                hashes[j] = h;
+            }
+        }
+    }
+
+    // Copies other's table slot for slot into this map, which must be empty
+    // and unallocated
+    void
+    copySlots(FlatHashMap const& other)
+    {
+        if (!other.mValues)
+        {
+            return;
+        }
+        auto cap = other.capacity();
+        mValues = std::allocator<slot_type>().allocate(cap);
+        mHashes.assign(cap, EMPTY);
+        for (size_t i = 0; i < cap; ++i)
+        {
+            auto h = other.mHashes[i];
+            if (isFull(h))
+            {
+                // On failure the destructor cleans up the copied slots
+                new (&mValues[i]) slot_type(other.mValues[i]);
+                ++mSize;
+            }
+            else if (h == ERASED)
+            {
+                ++mErased;
+            }
+            mHashes[i] = h;
+        }
+    }
+
+    // Makes room to insert one more element
+    void
+    growIfNeeded()
+    {
+        auto cap = capacity();
+        if (cap != 0 && fits(mSize + mErased + 1, cap))
+        {
+            return;
+        }
+        auto newCap = cap == 0 ? MIN_CAPACITY : cap;
+        // Only grow if the table is full of live elements; otherwise
+        // rehashing in place is enough to discard erased slots
+        while (!fits(mSize + 1, newCap) || (newCap == cap && mSize * 2 > cap))
+        {
+            newCap *= 2;
+        }
+        rehash(newCap);
+    }
+
+    template <bool IsConst> class Iter
+    {
+        typedef std::conditional_t<IsConst, FlatHashMap const, FlatHashMap>
+            MapT;
+        MapT* mMap{nullptr};
+        size_t mIndex{0};
+
+        void
+        skipFree()
+        {
+            while (mIndex < mMap->capacity() && !isFull(mMap->mHashes[mIndex]))
+            {
+                ++mIndex;
+            }
+        }
+
+        friend class FlatHashMap;
+        template <bool> friend class Iter;
+
+        Iter(MapT* map, size_t index) : mMap(map), mIndex(index)
+        {
+        }
+
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef FlatHashMap::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::conditional_t<IsConst, value_type const, value_type>*
+            pointer;
+        typedef std::conditional_t<IsConst, value_type const, value_type>&
+            reference;
+
+        Iter() = default;
+
+        // iterator converts to const_iterator
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        Iter(Iter<false> const& other) : mMap(other.mMap), mIndex(other.mIndex)
+        {
+        }
+
+        reference
+        operator*() const
+        {
+            return mMap->element(mIndex);
+        }
+
+        pointer
+        operator->() const
+        {
+            return &mMap->element(mIndex);
+        }
+
+        Iter&
+        operator++()
+        {
+            ++mIndex;
+            skipFree();
+            return *this;
+        }
+
+        Iter
+        operator++(int)
+        {
+            auto res = *this;
+            ++(*this);
+            return res;
+        }
+
+        bool
+        operator==(Iter const& other) const
+        {
+            return mIndex == other.mIndex && mMap == other.mMap;
+        }
+
+        bool
+        operator!=(Iter const& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+  public:
+    typedef Iter<false> iterator;
+    typedef Iter<true> const_iterator;
+
+    FlatHashMap() = default;
+
+    FlatHashMap(FlatHashMap const& other)
+    {
+        *this = other;
+    }
+
+    FlatHashMap(FlatHashMap&& other) noexcept
+    {
+        swap(other);
+    }
+
+    ~FlatHashMap()
+    {
+        release();
+    }
+
+    FlatHashMap&
+    operator=(FlatHashMap const& other)
+    {
+        if (this != &other)
+        {
+            // Copy into a temporary so that a failure leaves *this untouched
+            FlatHashMap tmp;
+            tmp.copySlots(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    FlatHashMap&
+    operator=(FlatHashMap&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    void
+    swap(FlatHashMap& other) noexcept
+    {
+        mHashes.swap(other.mHashes);
+        std::swap(mValues, other.mValues);
+        std::swap(mSize, other.mSize);
+        std::swap(mErased, other.mErased);
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+
+    bool
+    empty() const
+    {
+        return mSize == 0;
+    }
+
+    iterator
+    begin()
+    {
+        iterator it(this, 0);
+        it.skipFree();
+        return it;
+    }
+
+    iterator
+    end()
+    {
+        return iterator(this, capacity());
+    }
+
+    const_iterator
+    begin() const
+    {
+        const_iterator it(this, 0);
+        it.skipFree();
+        return it;
+    }
+
+    const_iterator
+    end() const
+    {
+        return const_iterator(this, capacity());
+    }
+
+    const_iterator
+    cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator
+    cend() const
+    {
+        return end();
+    }
+
+    iterator
+    find(KeyT const& key)
+    {
+        return iterator(this, findSlot(key, fixHash(Hasher()(key))));
+    }
+
+    const_iterator
+    find(KeyT const& key) const
+    {
+        return const_iterator(this, findSlot(key, fixHash(Hasher()(key))));
+    }
+
+    size_t
+    count(KeyT const& key) const
+    {
+        return find(key) == end() ? 0 : 1;
+    }
+
+    // Inserts (key, value) unless key is already present. Either way, returns
+    // the element for key and whether it was inserted.
+    template <class K, class V>
+    std::pair<iterator, bool>
+    emplace(K&& key, V&& value)
+    {
+        auto h = fixHash(Hasher()(key));
+        auto i = findSlot(key, h);
+        if (i != capacity())
+        {
+            return {iterator(this, i), false};
+        }
+
+        growIfNeeded();
+        i = findFree(h);
+        new (&mValues[i])
+            slot_type(std::forward<K>(key), std::forward<V>(value));
+        if (mHashes[i] == ERASED)
+        {
+            --mErased;
+        }
+        mHashes[i] = h;
+        ++mSize;
+        return {iterator(this, i), true};
+    }
+
+    void
+    erase(const_iterator it)
+    {
+        releaseAssert(it.mMap == this && it.mIndex < capacity() &&
+                      isFull(mHashes[it.mIndex]));
+        auto i = it.mIndex;
+        mValues[i].~slot_type();
+        --mSize;
+
+        // A slot followed by an empty one ends every probe sequence through
+        // it, so it and any erased slots before it can be marked empty
+        auto mask = capacity() - 1;
+        if (mHashes[(i + 1) & mask] != EMPTY)
+        {
+            mHashes[i] = ERASED;
+            ++mErased;
+            return;
+        }
+        mHashes[i] = EMPTY;
+        for (i = (i - 1) & mask; mHashes[i] == ERASED; i = (i - 1) & mask)
+        {
+            mHashes[i] = EMPTY;
+            --mErased;
+        }
+    }
+
+    size_t
+    erase(KeyT const& key)
+    {
+        auto it = find(key);
+        if (it == end())
+        {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    // Removes every element but keeps the table allocated
+    void
+    clear() noexcept
+    {
+        if (mValues)
+        {
+            destroyValues();
+        }
+        std::fill(mHashes.begin(), mHashes.end(), EMPTY);
+        mSize = 0;
+        mErased = 0;
+    }
+
+    // Makes room for n elements without further rehashing
+    void
+    reserve(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / 8)
+        {
+            throw std::length_error("FlatHashMap::reserve");
+        }
+        auto cap = capacity() == 0 ? MIN_CAPACITY : capacity();
+        if (fits(n + mErased, cap) && capacity() != 0)
+        {
+            return;
+        }
+        while (!fits(n, cap))
+        {
+            cap *= 2;
+        }
+        rehash(cap);
+    }
+};
+}
@@ -7,13 +7,16 @@
 #include "util/FileSystemException.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <fmt/format.h>
 
 #include <map>
+#include <mutex>
 #include <regex>
+#include <set>
 #include <sstream>
 
 #ifdef _WIN32
@@ -32,6 +35,7 @@
 #include <io.h>
 #else
 #include <dirent.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
 #endif
@@ -161,6 +165,18 @@ durableRename(std::string const& src, std::string const& dst,
     return true;
 }
 
+bool
+deferredDurableRename(std::string const& src, std::string const& dst,
+                      std::string const& dir)
+{
+    return durableRename(src, dst, dir);
+}
+
+void
+syncDeferredRenames()
+{
+}
+
 #else
 #include <cerrno>
 #include <fcntl.h>
@@ -252,15 +268,10 @@ openFileToWrite(std::string const& path)
     return fd;
 }
 
-bool
-durableRename(std::string const& src, std::string const& dst,
-              std::string const& dir)
+static void
+syncDir(std::string const& dir)
 {
     ZoneScoped;
-    if (rename(src.c_str(), dst.c_str()) != 0)
-    {
-        return false;
-    }
     int dfd;
     while ((dfd = open(dir.c_str(), O_RDONLY)) == -1)
     {
@@ -289,8 +300,206 @@ durableRename(std::string const& src, std::string const& dst,
         FileSystemException::failWithErrno(
             std::string("Failed to close directory ") + dir + " :");
     }
+}
+
+bool
+durableRename(std::string const& src, std::string const& dst,
+              std::string const& dir)
+{
+    ZoneScoped;
+    if (rename(src.c_str(), dst.c_str()) != 0)
+    {
+        return false;
+    }
+    syncDir(dir);
     return true;
 }
+
+// Directories renamed into by deferredDurableRename and not yet synced
+static std::mutex gDeferredDirsMutex;
+static std::set<std::string> gDeferredDirs;
+// Held for the whole of syncDeferredRenames, so that a call does not return
+// while another one is still syncing directories it has taken
+static std::mutex gDeferredSyncMutex;
+
+bool
+deferredDurableRename(std::string const& src, std::string const& dst,
+                      std::string const& dir)
+{
+    ZoneScoped;
+    if (rename(src.c_str(), dst.c_str()) != 0)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(gDeferredDirsMutex);
+    gDeferredDirs.emplace(dir);
+    return true;
+}
+
+void
+syncDeferredRenames()
+{
+    ZoneScoped;
+    std::lock_guard<std::mutex> syncLock(gDeferredSyncMutex);
+    std::set<std::string> dirs;
+    {
+        std::lock_guard<std::mutex> lock(gDeferredDirsMutex);
+        dirs.swap(gDeferredDirs);
+    }
+    // Renames made from here on are left for the next call
+    for (auto it = dirs.begin(); it != dirs.end(); ++it)
+    {
+        try
+        {
+            // Such as the bucket directory of an application since destroyed
+            if (!exists(*it))
+            {
+                continue;
+            }
+            syncDir(*it);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(gDeferredDirsMutex);
+            gDeferredDirs.insert(it, dirs.end());
+            throw;
+        }
+    }
+}
+#endif
+
+#ifdef POSIX_FADV_DONTNEED
+static size_t
+osPageSize()
+{
+    static size_t const pageSize =
+        static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return pageSize;
+}
+
+std::vector<bool>
+getPageCacheResidency(std::string const& path)
+{
+    ZoneScoped;
+    std::vector<bool> res;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return res;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        auto len = static_cast<size_t>(st.st_size);
+        // Mapping the file doesn't read it in
+        void* addr = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr != MAP_FAILED)
+        {
+            std::vector<unsigned char> pages((len + osPageSize() - 1) /
+                                             osPageSize());
+            if (::mincore(addr, len, pages.data()) == 0)
+            {
+                res.reserve(pages.size());
+                for (auto p : pages)
+                {
+                    res.push_back(p & 1);
+                }
+            }
+            ::munmap(addr, len);
+        }
+    }
+    ::close(fd);
+    return res;
+}
+
+size_t
+dropFromPageCache(std::string const& path, std::vector<bool> const& keep)
+{
+    ZoneScoped;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return 0;
+    }
+    size_t dropped = 0;
+    struct stat st;
+    if (::fstat(fd, &st) == 0)
+    {
+        auto size = static_cast<size_t>(st.st_size);
+        auto pageSize = osPageSize();
+        size_t pages = (size + pageSize - 1) / pageSize;
+        auto kept = [&](size_t page) {
+            return page < keep.size() && keep[page];
+        };
+        for (size_t page = 0; page < pages;)
+        {
+            if (kept(page))
+            {
+                ++page;
+                continue;
+            }
+            size_t end = page;
+            while (end < pages && !kept(end))
+            {
+                ++end;
+            }
+            auto offset = page * pageSize;
+            auto len = std::min(end * pageSize, size) - offset;
+            if (::posix_fadvise(fd, static_cast<off_t>(offset),
+                                static_cast<off_t>(len),
+                                POSIX_FADV_DONTNEED) == 0)
+            {
+                dropped += len;
+            }
+            page = end;
+        }
+    }
+    ::close(fd);
+    return dropped;
+}
+
+size_t
+adviseWillNeed(std::string const& path,
+               std::vector<std::pair<size_t, size_t>> const& ranges)
+{
+    ZoneScoped;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return 0;
+    }
+    size_t advised = 0;
+    for (auto const& range : ranges)
+    {
+        if (::posix_fadvise(fd, static_cast<off_t>(range.first),
+                            static_cast<off_t>(range.second),
+                            POSIX_FADV_WILLNEED) == 0)
+        {
+            ++advised;
+        }
+    }
+    ::close(fd);
+    return advised;
+}
+#else
+std::vector<bool>
+getPageCacheResidency(std::string const& path)
+{
+    return {};
+}
+
+size_t
+dropFromPageCache(std::string const& path, std::vector<bool> const& keep)
+{
+    return 0;
+}
+
+size_t
+adviseWillNeed(std::string const& path,
+               std::vector<std::pair<size_t, size_t>> const& ranges)
+{
+    return 0;
+}
 #endif
 
 namespace stdfs = std::filesystem;
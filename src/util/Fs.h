@@ -59,6 +59,18 @@ FILE* fdOpen(native_handle_t h);
 bool durableRename(std::string const& src, std::string const& dst,
                    std::string const& dir);
 
+// Same as durableRename, except that on POSIX the fsync() of dir is left for
+// the next syncDeferredRenames, which syncs each pending directory once
+// however many renames were made into it. Callers must call
+// syncDeferredRenames before persisting anything that relies on the renamed
+// files surviving a crash.
+bool deferredDurableRename(std::string const& src, std::string const& dst,
+                           std::string const& dir);
+
+// Syncs the directories of all deferredDurableRename calls that returned
+// before this call, from any thread.
+void syncDeferredRenames();
+
 // Return whether a path exists.
 bool exists(std::string const& path);
 
@@ -83,6 +95,24 @@ size_t size(std::ifstream& ifs);
 
 size_t size(std::string const& path);
 
+// Returns whether each OS page of the file at `path` is in the page cache, or
+// an empty vector where this can't be told
+std::vector<bool> getPageCacheResidency(std::string const& path);
+
+// Asks the OS to drop the pages of the file at `path` from the page cache,
+// except the ones set in `keep` (as returned by getPageCacheResidency). Dirty
+// pages are only dropped once written back. Returns the number of bytes asked
+// to be dropped, 0 where this isn't supported.
+size_t dropFromPageCache(std::string const& path,
+                         std::vector<bool> const& keep = {});
+
+// Asks the OS to start reading the byte ranges <offset, length> of the file at
+// `path` into the page cache without waiting for them, so that the reads are
+// queued to the device together. Returns the number of ranges submitted, 0
+// where this isn't supported.
+size_t adviseWillNeed(std::string const& path,
+                      std::vector<std::pair<size_t, size_t>> const& ranges);
+
 ////
 // Utility functions for constructing path names
 ////
@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <mutex>
 
 namespace stellar
@@ -10,6 +10,7 @@
 #include <chrono>
 #include <fmt/chrono.h>
 #include <fstream>
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/stdout_sinks.h>
@@ -36,6 +37,10 @@ bool Logging::mColor = false;
 std::string Logging::mLastPattern;
 std::string Logging::mLastFilenamePattern;
 bool Logging::mLogToConsole = true;
+uint32_t Logging::mRateLimitPerSecond = 0;
+std::shared_ptr<spdlog::details::thread_pool> Logging::mThreadPool;
+uint64_t Logging::mReportedOverwritten = 0;
+std::array<std::atomic<uint64_t>, 14> Logging::mDroppedMessages{};
 #endif
 
 // Right now this is hard-coded to log messages at least as important as INFO
@@ -81,6 +86,61 @@ convert_loglevel(LogLevel level)
     }
     return slev;
 }
+
+namespace
+{
+// Logger dropping the messages below WARNING logged in one second beyond the
+// first `limit`. The count of a second is reset by the first message of the
+// next one, which also logs how many messages were dropped.
+template <typename Base> class RateLimitedLogger : public Base
+{
+    uint32_t const mLimit;
+    std::atomic<uint64_t>& mDropped;
+    std::atomic<int64_t> mSecond{0};
+    std::atomic<uint32_t> mCountInSecond{0};
+    std::atomic<uint64_t> mDroppedInSecond{0};
+
+  public:
+    template <typename... Args>
+    RateLimitedLogger(uint32_t limit, std::atomic<uint64_t>& dropped,
+                      Args&&... args)
+        : Base(std::forward<Args>(args)...), mLimit(limit), mDropped(dropped)
+    {
+    }
+
+  protected:
+    void
+    sink_it_(spdlog::details::log_msg const& msg) override
+    {
+        if (msg.level < spdlog::level::warn)
+        {
+            int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+                                 msg.time.time_since_epoch())
+                                 .count();
+            if (mSecond.exchange(second) != second)
+            {
+                mCountInSecond = 0;
+                if (auto dropped = mDroppedInSecond.exchange(0))
+                {
+                    auto notice = fmt::format(
+                        FMT_STRING("Dropped {} messages over the limit of {} "
+                                   "a second"),
+                        dropped, mLimit);
+                    Base::sink_it_(spdlog::details::log_msg(
+                        this->name(), spdlog::level::warn, notice));
+                }
+            }
+            if (++mCountInSecond > mLimit)
+            {
+                ++mDroppedInSecond;
+                ++mDropped;
+                return;
+            }
+        }
+        Base::sink_it_(msg);
+    }
+};
+}
 #endif
 
 void
@@ -166,18 +226,47 @@ Logging::init(bool truncate)
                 make_shared<basic_file_sink_mt>(filename, /*truncate=*/false));
         }
 
+        // Partitions get a drop counter for their rate limit, the default
+        // logger isn't limited
         auto makeLogger =
-            [&](std::string const& name) -> shared_ptr<spdlog::logger> {
-            auto logger =
-                make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
+            [&](std::string const& name,
+                std::atomic<uint64_t>* dropped) -> shared_ptr<spdlog::logger> {
+            using spdlog::async_logger;
+            using spdlog::async_overflow_policy;
+            shared_ptr<spdlog::logger> logger;
+            bool limited = dropped && mRateLimitPerSecond != 0;
+            if (mThreadPool && limited)
+            {
+                logger = make_shared<RateLimitedLogger<async_logger>>(
+                    mRateLimitPerSecond, *dropped, name, sinks.begin(),
+                    sinks.end(), mThreadPool,
+                    async_overflow_policy::overrun_oldest);
+            }
+            else if (mThreadPool)
+            {
+                logger = make_shared<async_logger>(
+                    name, sinks.begin(), sinks.end(), mThreadPool,
+                    async_overflow_policy::overrun_oldest);
+            }
+            else if (limited)
+            {
+                logger = make_shared<RateLimitedLogger<spdlog::logger>>(
+                    mRateLimitPerSecond, *dropped, name, sinks.begin(),
+                    sinks.end());
+            }
+            else
+            {
+                logger = make_shared<spdlog::logger>(name, sinks.begin(),
+                                                     sinks.end());
+            }
             spdlog::register_logger(logger);
             return logger;
         };
 
-        spdlog::set_default_logger(makeLogger("default"));
-        for (auto const& partition : stellar::Logging::kPartitionNames)
+        spdlog::set_default_logger(makeLogger("default", nullptr));
+        for (size_t i = 0; i < kPartitionNames.size(); ++i)
         {
-            makeLogger(partition);
+            makeLogger(kPartitionNames[i], &mDroppedMessages[i]);
         }
         if (mLastPattern.empty())
         {
@@ -277,6 +366,56 @@ Logging::setLoggingColor(bool color)
 #endif
 }
 
+void
+Logging::setAsync(bool async, size_t queueSize)
+{
+#if defined(USE_SPDLOG)
+    std::lock_guard<std::recursive_mutex> guard(mLogMutex);
+    deinit();
+    // Destroying the previous pool writes out the messages it still queues
+    mThreadPool.reset();
+    mReportedOverwritten = 0;
+    if (async)
+    {
+        mThreadPool = std::make_shared<spdlog::details::thread_pool>(
+            queueSize, /*threads_n=*/1);
+    }
+    init();
+#endif
+}
+
+void
+Logging::setRateLimit(uint32_t messagesPerSecond)
+{
+#if defined(USE_SPDLOG)
+    std::lock_guard<std::recursive_mutex> guard(mLogMutex);
+    mRateLimitPerSecond = messagesPerSecond;
+    deinit();
+    init();
+#endif
+}
+
+void
+Logging::flushDroppedMessageCounts(std::vector<uint64_t>& dropped,
+                                   uint64_t& overwritten)
+{
+    dropped.assign(kPartitionNames.size(), 0);
+    overwritten = 0;
+#if defined(USE_SPDLOG)
+    for (size_t i = 0; i < dropped.size(); ++i)
+    {
+        dropped[i] = mDroppedMessages[i].exchange(0);
+    }
+    std::lock_guard<std::recursive_mutex> guard(mLogMutex);
+    if (mThreadPool)
+    {
+        uint64_t total = mThreadPool->overrun_counter();
+        overwritten = total - mReportedOverwritten;
+        mReportedOverwritten = total;
+    }
+#endif
+}
+
 void
 Logging::setLogLevel(LogLevel level, const char* partition)
 {
@@ -9,6 +9,7 @@
 #include <filesystem>
 #include <iostream>
 #include <map>
+#include <vector>
 
 // Provide support for fmt-strings formatting objects that have
 // an overloaded operator<< defined on them.
@@ -19,9 +20,15 @@
 // Must include this _before_ spdlog.h
 #include "util/SpdlogTweaks.h"
 
+#include <atomic>
 #include <memory>
 #include <spdlog/spdlog.h>
 
+namespace spdlog::details
+{
+class thread_pool;
+}
+
 #define LOG_CHECK(logger, level, action) \
     do \
     { \
@@ -168,6 +175,11 @@ class Logging
     static std::string mLastPattern;
     static std::string mLastFilenamePattern;
     static bool mLogToConsole;
+    static uint32_t mRateLimitPerSecond;
+    // Set in async mode only
+    static std::shared_ptr<spdlog::details::thread_pool> mThreadPool;
+    static uint64_t mReportedOverwritten;
+    static std::array<std::atomic<uint64_t>, 14> mDroppedMessages;
 #define LOG_PARTITION(name) static LogPtr name##LogPtr;
 #include "util/LogPartitions.def"
 #undef LOG_PARTITION
@@ -180,6 +192,19 @@ class Logging
     static void setLoggingToFile(std::string const& filename);
     static void setLoggingToConsole(bool console);
     static void setLoggingColor(bool color);
+    // Formats and writes messages on a background thread, queueing up to
+    // `queueSize` of them. When the queue is full the oldest queued messages
+    // are overwritten rather than blocking the logging thread. Messages still
+    // queued are lost if the process aborts.
+    static void setAsync(bool async, size_t queueSize);
+    // Drops the messages below WARNING that a partition logs in one second
+    // beyond the first `messagesPerSecond`, 0 for no limit.
+    static void setRateLimit(uint32_t messagesPerSecond);
+    // Returns and resets the number of messages dropped by rate limits, per
+    // partition of kPartitionNames, and of queued messages overwritten in
+    // async mode.
+    static void flushDroppedMessageCounts(std::vector<uint64_t>& dropped,
+                                          uint64_t& overwritten);
     static void setLogLevel(LogLevel level, const char* partition);
     static LogLevel getLLfromString(std::string const& levelName);
     static LogLevel getLogLevel(std::string const& partition);
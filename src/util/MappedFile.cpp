@@ -0,0 +1,158 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/MappedFile.h"
+#include "util/FileSystemException.h"
+#include "util/Logging.h"
+#include "util/Tracing.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace stellar
+{
+
+#ifdef _WIN32
+
+bool
+MappedFile::isSupported()
+{
+    return false;
+}
+
+uint64_t
+MappedFile::getThreadPageFaults()
+{
+    return 0;
+}
+
+MappedFile::MappedFile(std::string const& filename) : mFilename(filename)
+{
+    throw FileSystemException("memory mapped files are not supported on "
+                              "this platform");
+}
+
+MappedFile::~MappedFile()
+{
+}
+
+void
+MappedFile::adviseRandom() const
+{
+}
+
+void
+MappedFile::adviseWillNeed(size_t offset, size_t len) const
+{
+}
+
+#else
+
+bool
+MappedFile::isSupported()
+{
+    return true;
+}
+
+uint64_t
+MappedFile::getThreadPageFaults()
+{
+#ifdef RUSAGE_THREAD
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) == 0)
+    {
+        return static_cast<uint64_t>(usage.ru_minflt) +
+               static_cast<uint64_t>(usage.ru_majflt);
+    }
+#endif
+    return 0;
+}
+
+MappedFile::MappedFile(std::string const& filename) : mFilename(filename)
+{
+    ZoneScoped;
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        FileSystemException::failWithErrno("MappedFile failed to open " +
+                                           filename + ": ");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        auto err = errno;
+        ::close(fd);
+        errno = err;
+        FileSystemException::failWithErrno("MappedFile failed to stat " +
+                                           filename + ": ");
+    }
+
+    mSize = static_cast<size_t>(st.st_size);
+
+    // mmap of a zero length region fails, leave mData null for empty files
+    if (mSize != 0)
+    {
+        void* addr = ::mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            auto err = errno;
+            ::close(fd);
+            errno = err;
+            FileSystemException::failWithErrno("MappedFile failed to map " +
+                                               filename + ": ");
+        }
+        mData = static_cast<char const*>(addr);
+    }
+
+    // The mapping holds its own reference to the file
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData && ::munmap(const_cast<char*>(mData), mSize) != 0)
+    {
+        CLOG_ERROR(Fs, "MappedFile failed to unmap {}: {}", mFilename,
+                   std::strerror(errno));
+    }
+}
+
+void
+MappedFile::adviseRandom() const
+{
+    if (mData)
+    {
+        ::madvise(const_cast<char*>(mData), mSize, MADV_RANDOM);
+    }
+}
+
+void
+MappedFile::adviseWillNeed(size_t offset, size_t len) const
+{
+    if (!mData || offset >= mSize)
+    {
+        return;
+    }
+
+    // madvise requires a page aligned start address
+    static size_t const osPageSize =
+        static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t alignedOffset = offset - (offset % osPageSize);
+    size_t alignedLen = std::min(offset + len, mSize) - alignedOffset;
+    ::madvise(const_cast<char*>(mData) + alignedOffset, alignedLen,
+              MADV_WILLNEED);
+}
+
+#endif
+}
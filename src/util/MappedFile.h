@@ -0,0 +1,56 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace stellar
+{
+
+// Read-only memory mapping of a file that is never modified while mapped (i.e.
+// an adopted bucket file). Memory mapping is only supported on POSIX
+// platforms; on other platforms the constructor throws, so callers should
+// check isSupported() first.
+class MappedFile : public NonMovableOrCopyable
+{
+    std::string const mFilename;
+    char const* mData{nullptr};
+    size_t mSize{0};
+
+  public:
+    static bool isSupported();
+
+    // Returns the number of page faults (minor and major) taken by the
+    // calling thread so far, or 0 if the platform does not track per-thread
+    // faults.
+    static uint64_t getThreadPageFaults();
+
+    explicit MappedFile(std::string const& filename);
+    ~MappedFile();
+
+    char const*
+    data() const
+    {
+        return mData;
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+
+    // Reads through a MappedFile are directed by an index, so kernel readahead
+    // of the whole file is wasted IO. Callers should disable readahead with
+    // adviseRandom() and instead prefetch the region they are about to read
+    // with adviseWillNeed().
+    void adviseRandom() const;
+    void adviseWillNeed(size_t offset, size_t len) const;
+};
+}
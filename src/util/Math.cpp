@@ -6,8 +6,8 @@
 #include "crypto/SecretKey.h"
 #include "crypto/ShortHash.h"
 #include "util/GlobalChecks.h"
+#include "util/Tracing.h"
 #include "util/UnorderedMap.h"
-#include <Tracy.hpp>
 #include <algorithm>
 #include <autocheck/generator.hpp>
 #include <catch.hpp>
@@ -0,0 +1,28 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace stellar
+{
+
+// Estimated bytes held by the major in-memory structures of an application,
+// keyed by "<subsystem>.<structure>", e.g. "herder.tx-queue". Estimates come
+// from element counts and sizes the structures keep as they change, so they
+// are cheap to collect, but do not count every heap allocation.
+using MemoryFootprint = std::map<std::string, size_t>;
+
+// Estimated bytes of a node based container element, including the
+// allocator's bookkeeping and the container's links to the node
+template <typename T>
+constexpr size_t
+nodeBytes()
+{
+    return sizeof(T) + 4 * sizeof(void*);
+}
+}
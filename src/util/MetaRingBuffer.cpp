@@ -0,0 +1,215 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/MetaRingBuffer.h"
+#include "util/FileSystemException.h"
+#include "util/GlobalChecks.h"
+#include "util/Tracing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fmt/format.h>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stellar
+{
+
+#ifdef _WIN32
+
+MetaRingBuffer::MetaRingBuffer(std::string const& path, uint64_t capacity,
+                               bool create)
+{
+    throw std::runtime_error("Shared memory meta streams are not supported "
+                             "on Windows");
+}
+
+MetaRingBuffer::~MetaRingBuffer()
+{
+}
+
+#else
+
+namespace
+{
+void
+closeAndFailWithErrno(int fd, std::string const& msg)
+{
+    auto err = errno;
+    ::close(fd);
+    FileSystemException::failWith(msg + std::strerror(err));
+}
+}
+
+MetaRingBuffer::MetaRingBuffer(std::string const& path, uint64_t capacity,
+                               bool create)
+{
+    mFd = ::open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR,
+                 0644);
+    if (mFd == -1)
+    {
+        FileSystemException::failWithErrno(
+            fmt::format("Failed to open meta ring buffer '{}': ", path));
+    }
+
+    if (create)
+    {
+        if (capacity == 0)
+        {
+            ::close(mFd);
+            throw std::runtime_error("Meta ring buffer capacity must be > 0");
+        }
+        mMapSize = sizeof(Header) + capacity;
+        if (::ftruncate(mFd, static_cast<off_t>(mMapSize)) != 0)
+        {
+            closeAndFailWithErrno(
+                mFd,
+                fmt::format("Failed to size meta ring buffer '{}': ", path));
+        }
+    }
+    else
+    {
+        struct stat st;
+        if (::fstat(mFd, &st) != 0 ||
+            static_cast<size_t>(st.st_size) < sizeof(Header))
+        {
+            ::close(mFd);
+            throw std::runtime_error(fmt::format(
+                "'{}' is too small to be a meta ring buffer", path));
+        }
+        mMapSize = static_cast<size_t>(st.st_size);
+    }
+
+    void* addr =
+        ::mmap(nullptr, mMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (addr == MAP_FAILED)
+    {
+        closeAndFailWithErrno(
+            mFd, fmt::format("Failed to map meta ring buffer '{}': ", path));
+    }
+    mHeader = static_cast<Header*>(addr);
+    mData = static_cast<char*>(addr) + sizeof(Header);
+
+    if (create)
+    {
+        // The file was just truncated, so everything else is already zero
+        mHeader->magic = MAGIC;
+        mHeader->version = VERSION;
+        mHeader->capacity = capacity;
+        mHeader->writePos.store(0, std::memory_order_relaxed);
+        mHeader->readPos.store(0, std::memory_order_release);
+    }
+    else if (mHeader->magic != MAGIC || mHeader->version != VERSION ||
+             mHeader->capacity != mMapSize - sizeof(Header))
+    {
+        ::munmap(addr, mMapSize);
+        ::close(mFd);
+        throw std::runtime_error(fmt::format(
+            "'{}' is not a version {} meta ring buffer", path, VERSION));
+    }
+    mCapacity = mHeader->capacity;
+}
+
+MetaRingBuffer::~MetaRingBuffer()
+{
+    if (mHeader)
+    {
+        ::munmap(mHeader, mMapSize);
+    }
+    if (mFd != -1)
+    {
+        ::close(mFd);
+    }
+}
+
+#endif
+
+void
+MetaRingBuffer::copyIn(uint64_t pos, char const* src, size_t size)
+{
+    auto offset = static_cast<size_t>(pos % mCapacity);
+    auto first = std::min<size_t>(size, mCapacity - offset);
+    std::memcpy(mData + offset, src, first);
+    std::memcpy(mData, src + first, size - first);
+}
+
+void
+MetaRingBuffer::copyOut(uint64_t pos, char* dst, size_t size) const
+{
+    auto offset = static_cast<size_t>(pos % mCapacity);
+    auto first = std::min<size_t>(size, mCapacity - offset);
+    std::memcpy(dst, mData + offset, first);
+    std::memcpy(dst + first, mData, size - first);
+}
+
+MetaRingBufferWriter::MetaRingBufferWriter(std::string const& path,
+                                           uint64_t capacity)
+    : MetaRingBuffer(path, capacity, /*create=*/true)
+{
+}
+
+void
+MetaRingBufferWriter::writeSerialized(char const* data, size_t size)
+{
+    ZoneScoped;
+    if (size > mCapacity)
+    {
+        throw std::runtime_error(
+            fmt::format("Meta record of {} bytes doesn't fit in a meta ring "
+                        "buffer of {} bytes",
+                        size, mCapacity));
+    }
+
+    // Only this side moves writePos
+    auto writePos = mHeader->writePos.load(std::memory_order_relaxed);
+    while (mCapacity -
+               (writePos - mHeader->readPos.load(std::memory_order_acquire)) <
+           size)
+    {
+        // Like a full pipe, a reader that doesn't keep up holds the writer
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    copyIn(writePos, data, size);
+    mHeader->writePos.store(writePos + size, std::memory_order_release);
+}
+
+MetaRingBufferReader::MetaRingBufferReader(std::string const& path)
+    : MetaRingBuffer(path, 0, /*create=*/false)
+{
+}
+
+bool
+MetaRingBufferReader::readRecord(std::vector<char>& payload)
+{
+    // Only this side moves readPos
+    auto readPos = mHeader->readPos.load(std::memory_order_relaxed);
+    auto writePos = mHeader->writePos.load(std::memory_order_acquire);
+    if (readPos == writePos)
+    {
+        return false;
+    }
+    releaseAssertOrThrow(writePos - readPos >= 4);
+
+    unsigned char mark[4];
+    copyOut(readPos, reinterpret_cast<char*>(mark), sizeof(mark));
+    releaseAssertOrThrow(mark[0] & 0x80);
+    uint32_t size = (static_cast<uint32_t>(mark[0] & 0x7f) << 24) |
+                    (static_cast<uint32_t>(mark[1]) << 16) |
+                    (static_cast<uint32_t>(mark[2]) << 8) |
+                    static_cast<uint32_t>(mark[3]);
+    releaseAssertOrThrow(writePos - readPos >= 4 + uint64_t(size));
+
+    payload.resize(size);
+    copyOut(readPos + 4, payload.data(), size);
+    mHeader->readPos.store(readPos + 4 + size, std::memory_order_release);
+    return true;
+}
+}
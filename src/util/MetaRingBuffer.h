@@ -0,0 +1,118 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "xdrpp/marshal.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+// A single-producer single-consumer ring buffer in a memory-mapped file
+// (typically under /dev/shm), through which a consumer on the same host reads
+// ledger close meta without it going through a pipe. Selected with
+// METADATA_OUTPUT_STREAM="shm:PATH"; POSIX only.
+//
+// The file starts with a Header, followed by `capacity` bytes of data. All
+// integers are in host byte order. Records are framed as in meta files and
+// pipes: a 4-byte big-endian XDR record mark (length with the high bit set)
+// followed by the XDR of a LedgerCloseMeta. Records are written one after the
+// other and wrap around the end of the data. writePos and readPos count bytes
+// since the start, so the next record starts at readPos % capacity and the
+// buffer holds writePos - readPos bytes.
+//
+// The writer copies a record in, then publishes it by storing writePos with
+// release ordering; it waits while the record doesn't fit. The reader loads
+// writePos with acquire ordering, copies records out and stores readPos with
+// release ordering once it's done with them. stellar-core creates (and
+// truncates) the file at startup, so the consumer opens it afterwards.
+class MetaRingBuffer
+{
+  public:
+    // "SCMETARB" in a little-endian file
+    static constexpr uint64_t MAGIC = 0x42524154454d4353ull;
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t capacity;
+        // On their own cache lines, as each side writes one of them
+        alignas(64) std::atomic<uint64_t> writePos;
+        alignas(64) std::atomic<uint64_t> readPos;
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "ring positions must be lock-free to be shared");
+
+    MetaRingBuffer(MetaRingBuffer const&) = delete;
+    MetaRingBuffer& operator=(MetaRingBuffer const&) = delete;
+    ~MetaRingBuffer();
+
+    uint64_t
+    capacity() const
+    {
+        return mCapacity;
+    }
+
+  protected:
+    // Maps the file at `path`, creating it with `capacity` bytes of data if
+    // `create`, or checking the header of an existing one otherwise
+    MetaRingBuffer(std::string const& path, uint64_t capacity, bool create);
+
+    Header* mHeader{nullptr};
+    char* mData{nullptr};
+    uint64_t mCapacity{0};
+
+    // Copy `size` bytes to and from the data at position `pos`, wrapping
+    void copyIn(uint64_t pos, char const* src, size_t size);
+    void copyOut(uint64_t pos, char* dst, size_t size) const;
+
+  private:
+    int mFd{-1};
+    size_t mMapSize{0};
+};
+
+class MetaRingBufferWriter : public MetaRingBuffer
+{
+  public:
+    MetaRingBufferWriter(std::string const& path, uint64_t capacity);
+
+    // Writes a record produced by XDROutputFileStream::serializeRecord,
+    // waiting for the reader to make room if needed. Throws if the record
+    // can never fit.
+    void writeSerialized(char const* data, size_t size);
+};
+
+class MetaRingBufferReader : public MetaRingBuffer
+{
+  public:
+    explicit MetaRingBufferReader(std::string const& path);
+
+    // Takes the XDR of the next record, without its record mark, into
+    // `payload`. Returns false without waiting if there is none.
+    bool readRecord(std::vector<char>& payload);
+
+    template <typename T>
+    bool
+    readOne(T& out)
+    {
+        if (!readRecord(mBuf))
+        {
+            return false;
+        }
+        xdr::xdr_from_opaque(mBuf, out);
+        return true;
+    }
+
+  private:
+    std::vector<char> mBuf;
+};
+}
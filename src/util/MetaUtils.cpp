@@ -8,7 +8,9 @@
 #include "util/GlobalChecks.h"
 #include "util/XDROperators.h"
 #include "util/types.h"
+#include "util/xdrquery/XDRQuery.h"
 #include <algorithm>
+#include <set>
 
 namespace
 {
@@ -73,6 +75,117 @@ normalizeOps(xdr::xvector<OperationMeta>& oms)
         sortChanges(om.changes);
     }
 }
+
+// Returns whether any change is left
+bool
+filterChanges(LedgerEntryChanges& changes, xdrquery::XDRMatcher& filter)
+{
+    if (changes.empty())
+    {
+        return false;
+    }
+    // Removals only carry the key, they go with the matching entry (in the
+    // STATE change preceding them)
+    std::vector<bool> keep(changes.size(), false);
+    std::set<LedgerKey> matchedKeys;
+    for (size_t i = 0; i < changes.size(); ++i)
+    {
+        auto const& change = changes[i];
+        LedgerEntry const* entry = nullptr;
+        switch (change.type())
+        {
+        case LEDGER_ENTRY_STATE:
+            entry = &change.state();
+            break;
+        case LEDGER_ENTRY_CREATED:
+            entry = &change.created();
+            break;
+        case LEDGER_ENTRY_UPDATED:
+            entry = &change.updated();
+            break;
+        case LEDGER_ENTRY_REMOVED:
+            continue;
+        }
+        if (filter.matchXDR(*entry))
+        {
+            keep[i] = true;
+            matchedKeys.emplace(LedgerEntryKey(*entry));
+        }
+    }
+
+    LedgerEntryChanges kept;
+    for (size_t i = 0; i < changes.size(); ++i)
+    {
+        if (keep[i] || (changes[i].type() == LEDGER_ENTRY_REMOVED &&
+                        matchedKeys.count(changes[i].removed()) != 0))
+        {
+            kept.emplace_back(std::move(changes[i]));
+        }
+    }
+    changes = std::move(kept);
+    return !changes.empty();
+}
+
+bool
+filterOps(xdr::xvector<OperationMeta>& oms, xdrquery::XDRMatcher& filter)
+{
+    bool anyKept = false;
+    for (auto& om : oms)
+    {
+        anyKept |= filterChanges(om.changes, filter);
+    }
+    return anyKept;
+}
+
+bool
+filterTxMeta(TransactionMeta& m, xdrquery::XDRMatcher& filter)
+{
+    bool anyKept = false;
+    switch (m.v())
+    {
+    case 0:
+        anyKept |= filterOps(m.operations(), filter);
+        break;
+    case 1:
+        anyKept |= filterChanges(m.v1().txChanges, filter);
+        anyKept |= filterOps(m.v1().operations, filter);
+        break;
+    case 2:
+        anyKept |= filterChanges(m.v2().txChangesBefore, filter);
+        anyKept |= filterChanges(m.v2().txChangesAfter, filter);
+        anyKept |= filterOps(m.v2().operations, filter);
+        break;
+    case 3:
+        anyKept |= filterChanges(m.v3().txChangesBefore, filter);
+        anyKept |= filterChanges(m.v3().txChangesAfter, filter);
+        anyKept |= filterOps(m.v3().operations, filter);
+        break;
+    default:
+        releaseAssert(false);
+    }
+    return anyKept;
+}
+
+template <typename LedgerCloseMetaV>
+void
+filterLedgerCloseMeta(LedgerCloseMetaV& v, xdrquery::XDRMatcher& filter)
+{
+    for (auto& u : v.upgradesProcessing)
+    {
+        filterChanges(u.changes, filter);
+    }
+    xdr::xvector<TransactionResultMeta> kept;
+    for (auto& tx : v.txProcessing)
+    {
+        bool anyKept = filterChanges(tx.feeProcessing, filter);
+        anyKept |= filterTxMeta(tx.txApplyProcessing, filter);
+        if (anyKept)
+        {
+            kept.emplace_back(std::move(tx));
+        }
+    }
+    v.txProcessing = std::move(kept);
+}
 }
 
 namespace stellar
@@ -142,4 +255,20 @@ normalizeMeta(LedgerCloseMeta& lcm)
         abort();
     }
 }
+
+void
+filterMeta(LedgerCloseMeta& lcm, xdrquery::XDRMatcher& filter)
+{
+    switch (lcm.v())
+    {
+    case 0:
+        filterLedgerCloseMeta(lcm.v0(), filter);
+        break;
+    case 1:
+        filterLedgerCloseMeta(lcm.v1(), filter);
+        break;
+    default:
+        abort();
+    }
+}
 }
@@ -4,6 +4,11 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+namespace xdrquery
+{
+class XDRMatcher;
+}
+
 namespace stellar
 {
 struct TransactionMeta;
@@ -12,4 +17,10 @@ void normalizeMeta(TransactionMeta& m);
 struct LedgerCloseMeta;
 
 void normalizeMeta(LedgerCloseMeta& lcm);
+
+// Drops the ledger entry changes of lcm to entries that don't match `filter`
+// (removals are kept when the removed entry matches), then the transactions
+// left without changes. Operation meta is kept, possibly empty, so that it
+// still lines up with the operations. See METADATA_OUTPUT_FILTER.
+void filterMeta(LedgerCloseMeta& lcm, xdrquery::XDRMatcher& filter);
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/ParallelFor.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/Tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace stellar
+{
+
+namespace
+{
+// Shared between the calling thread and helpers, which may still reference it
+// after parallelForBatches returns
+struct ParallelForState
+{
+    std::function<void(size_t, size_t, size_t)> fn;
+    size_t n{0};
+    size_t batchSize{0};
+    size_t numBatches{0};
+
+    std::atomic<size_t> nextBatch{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t completed{0};
+    std::exception_ptr error{};
+};
+
+// Claims and runs batches until none are left
+void
+runBatches(ParallelForState& s, size_t worker)
+{
+    for (size_t i = s.nextBatch++; i < s.numBatches; i = s.nextBatch++)
+    {
+        std::exception_ptr error{};
+        try
+        {
+            auto begin = i * s.batchSize;
+            s.fn(worker, begin, std::min(begin + s.batchSize, s.n));
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (error && !s.error)
+            {
+                s.error = error;
+            }
+            ++s.completed;
+        }
+        s.cv.notify_one();
+    }
+}
+}
+
+void
+parallelForBatches(
+    size_t n, size_t batchSize, size_t maxHelpers,
+    std::function<void(std::function<void()>&&)> const& postHelper,
+    std::function<void(size_t worker, size_t begin, size_t end)> const& fn)
+{
+    ZoneScoped;
+    if (n == 0)
+    {
+        return;
+    }
+    batchSize = std::max<size_t>(batchSize, 1);
+
+    auto state = std::make_shared<ParallelForState>();
+    state->fn = fn;
+    state->n = n;
+    state->batchSize = batchSize;
+    state->numBatches = (n + batchSize - 1) / batchSize;
+
+    auto numHelpers = std::min(maxHelpers, state->numBatches - 1);
+    for (size_t i = 1; i <= numHelpers; ++i)
+    {
+        postHelper([state, i]() { runBatches(*state, i); });
+    }
+
+    runBatches(*state, 0);
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock,
+                       [&] { return state->completed == state->numBatches; });
+    }
+
+    if (state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void
+parallelForBatches(
+    Application& app, size_t n, size_t batchSize,
+    std::function<void(size_t worker, size_t begin, size_t end)> const& fn,
+    std::string const& jobName, BackgroundPriority priority)
+{
+    auto workers =
+        static_cast<size_t>(std::max(app.getConfig().WORKER_THREADS, 0));
+    parallelForBatches(
+        n, batchSize, workers,
+        [&](std::function<void()>&& f) {
+            app.postOnBackgroundThread(std::move(f), jobName, priority);
+        },
+        fn);
+}
+}
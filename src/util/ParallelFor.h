@@ -0,0 +1,41 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/BackgroundPriority.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace stellar
+{
+
+class Application;
+
+// Calls `fn(worker, begin, end)` for the consecutive batches [begin, end) of
+// at most `batchSize` of the items [0, n), and returns once every batch is
+// done. Batches are claimed one at a time by the calling thread, which is
+// worker 0, and by up to `maxHelpers` helper tasks, which are workers 1 to
+// `maxHelpers`, posted with `postHelper`. As the calling thread takes batches
+// too, it never waits on helpers queued behind other background work, only
+// on batches a helper has already claimed.
+//
+// `fn` must be safe to call from several threads at once, but is only called
+// while the calling thread waits, so it may reference the caller's stack:
+// helpers that only start running after every batch has been claimed return
+// without calling it. Once all batches are done, the first exception `fn`
+// threw, if any, is rethrown.
+void parallelForBatches(
+    size_t n, size_t batchSize, size_t maxHelpers,
+    std::function<void(std::function<void()>&&)> const& postHelper,
+    std::function<void(size_t worker, size_t begin, size_t end)> const& fn);
+
+// Same, with helpers posted to the worker threads of `app` as `jobName`
+void parallelForBatches(
+    Application& app, size_t n, size_t batchSize,
+    std::function<void(size_t worker, size_t begin, size_t end)> const& fn,
+    std::string const& jobName,
+    BackgroundPriority priority = BackgroundPriority::NORMAL);
+}
@@ -0,0 +1,219 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/ParallelGzip.h"
+#include "util/Tracing.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace stellar
+{
+namespace ParallelGzip
+{
+
+#ifdef USE_ZLIB
+namespace
+{
+// Big enough that the sync-flush marker ending each block costs nothing, small
+// enough to keep a few of them per thread in memory
+constexpr size_t BLOCK_SIZE = 256 * 1024;
+// The deflate window: a block primed with this much of the data before it
+// compresses as well as if it had not been cut off
+constexpr size_t DICT_SIZE = 32 * 1024;
+
+struct Block
+{
+    std::string mIn;
+    std::string mOut;
+    uLong mCrc{0};
+};
+
+// Deflates `block` as raw deflate data that continues the stream: ended with a
+// sync flush so that the next block starts on a byte boundary, or with the
+// final block marker if `last`.
+void
+compressBlock(Block& block, std::string const& dict, bool last)
+{
+    ZoneScoped;
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+    if (!dict.empty() &&
+        deflateSetDictionary(&zs,
+                             reinterpret_cast<Bytef const*>(dict.data()),
+                             static_cast<uInt>(dict.size())) != Z_OK)
+    {
+        deflateEnd(&zs);
+        throw std::runtime_error("deflateSetDictionary failed");
+    }
+
+    zs.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(block.mIn.data()));
+    zs.avail_in = static_cast<uInt>(block.mIn.size());
+    block.mOut.resize(deflateBound(&zs, zs.avail_in) + 16);
+    size_t produced = 0;
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    for (;;)
+    {
+        zs.next_out = reinterpret_cast<Bytef*>(block.mOut.data() + produced);
+        zs.avail_out = static_cast<uInt>(block.mOut.size() - produced);
+        int res = deflate(&zs, flush);
+        produced = block.mOut.size() - zs.avail_out;
+        // A sync flush is complete once deflate stops filling the buffer
+        if (res == Z_STREAM_END || (!last && res == Z_OK && zs.avail_out != 0))
+        {
+            break;
+        }
+        if (res != Z_OK && res != Z_BUF_ERROR)
+        {
+            deflateEnd(&zs);
+            throw std::runtime_error("deflate failed");
+        }
+        block.mOut.resize(block.mOut.size() * 2);
+    }
+    deflateEnd(&zs);
+    block.mOut.resize(produced);
+
+    block.mCrc = crc32(0L, Z_NULL, 0);
+    block.mCrc = crc32(block.mCrc,
+                       reinterpret_cast<Bytef const*>(block.mIn.data()),
+                       static_cast<uInt>(block.mIn.size()));
+}
+
+std::string
+tail(std::string const& prev, std::string const& data)
+{
+    if (data.size() >= DICT_SIZE)
+    {
+        return data.substr(data.size() - DICT_SIZE);
+    }
+    auto joined = prev + data;
+    return joined.substr(joined.size() - std::min(joined.size(), DICT_SIZE));
+}
+
+void
+writeLE32(std::ofstream& out, uint32_t v)
+{
+    char bytes[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        bytes[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+    }
+    out.write(bytes, sizeof(bytes));
+}
+}
+#endif
+
+bool
+isSupported()
+{
+#ifdef USE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+compressFile(std::string const& in, std::string const& out, size_t threads,
+             std::atomic<bool> const& cancel)
+{
+    ZoneScoped;
+#ifdef USE_ZLIB
+    threads = std::max<size_t>(1, threads);
+    std::ifstream input(in, std::ifstream::binary);
+    if (!input)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error opening file {}"), in));
+    }
+    std::ofstream output(out, std::ofstream::binary | std::ofstream::trunc);
+    if (!output)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error opening file {}"), out));
+    }
+
+    // Minimal gzip header: deflate, no name or mtime, unix
+    char const header[] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3};
+    output.write(header, sizeof(header));
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    uint64_t total = 0;
+    std::string dict;
+    bool done = false;
+    while (!done)
+    {
+        if (cancel)
+        {
+            throw std::runtime_error(
+                fmt::format(FMT_STRING("Compression of {} cancelled"), in));
+        }
+
+        // Read a block per thread, then deflate them all at once
+        std::vector<Block> blocks;
+        while (!done && blocks.size() < threads)
+        {
+            Block block;
+            block.mIn.resize(BLOCK_SIZE);
+            input.read(block.mIn.data(), BLOCK_SIZE);
+            if (input.bad())
+            {
+                throw std::runtime_error(
+                    fmt::format(FMT_STRING("Error reading file {}"), in));
+            }
+            block.mIn.resize(input.gcount());
+            done = input.peek() == std::ifstream::traits_type::eof();
+            blocks.emplace_back(std::move(block));
+        }
+
+        std::vector<std::future<void>> futures;
+        for (size_t i = 1; i < blocks.size(); ++i)
+        {
+            futures.emplace_back(std::async(std::launch::async, [&, i]() {
+                compressBlock(blocks[i], tail("", blocks[i - 1].mIn),
+                              done && i + 1 == blocks.size());
+            }));
+        }
+        compressBlock(blocks[0], dict, done && blocks.size() == 1);
+        for (auto& f : futures)
+        {
+            f.get();
+        }
+
+        for (auto const& block : blocks)
+        {
+            output.write(block.mOut.data(), block.mOut.size());
+            crc = crc32_combine(crc, block.mCrc,
+                                static_cast<z_off_t>(block.mIn.size()));
+            total += block.mIn.size();
+        }
+        dict = tail(dict, blocks.back().mIn);
+    }
+
+    writeLE32(output, static_cast<uint32_t>(crc));
+    writeLE32(output, static_cast<uint32_t>(total));
+    output.close();
+    if (!output)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error writing file {}"), out));
+    }
+#else
+    throw std::runtime_error("In-process gzip is not supported in this build");
+#endif
+}
+}
+}
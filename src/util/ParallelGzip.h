@@ -0,0 +1,30 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace stellar
+{
+
+// In-process gzip compression of a file, pigz-style: the input is cut into
+// blocks that are deflated on several threads at once, each primed with the
+// tail of the block before it, and stitched back into a single gzip member
+// that any gunzip reads. This saves spawning a `gzip` process per file and
+// uses more than one core on large buckets.
+namespace ParallelGzip
+{
+// Whether this build can compress files in-process at all
+bool isSupported();
+
+// Compresses the file `in` into the file `out` using up to `threads` threads.
+// Throws std::runtime_error if reading or writing fails or if cancelled
+// through `cancel`; `out` may then hold a partial file.
+void compressFile(std::string const& in, std::string const& out,
+                  size_t threads, std::atomic<bool> const& cancel);
+}
+}
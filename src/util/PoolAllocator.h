@@ -0,0 +1,171 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace stellar
+{
+
+namespace poolallocator
+{
+// Maximum number of free blocks of each size kept per thread. Blocks freed
+// beyond this are returned to the heap.
+static constexpr size_t MAX_FREE_BLOCKS = 0x10000;
+
+// Thread-local list of free blocks of a single size. The list itself is
+// trivially destructible so that it stays usable after the thread's Reaper
+// has run; from then on blocks bypass the list.
+template <size_t Size, size_t Align> class FreeList
+{
+    struct Node
+    {
+        Node* next;
+    };
+
+    static constexpr size_t BLOCK_SIZE = std::max(Size, sizeof(Node));
+    static constexpr std::align_val_t BLOCK_ALIGN{
+        std::max(Align, alignof(Node))};
+
+    struct State
+    {
+        Node* head;
+        size_t size;
+        bool reaped;
+    };
+
+    // Returns the free blocks to the heap when the thread exits
+    struct Reaper
+    {
+        ~Reaper()
+        {
+            auto& s = state();
+            while (s.head)
+            {
+                auto next = s.head->next;
+                ::operator delete(s.head, BLOCK_ALIGN);
+                s.head = next;
+            }
+            s.size = 0;
+            s.reaped = true;
+        }
+    };
+
+    static State&
+    state()
+    {
+        static thread_local State s{nullptr, 0, false};
+        return s;
+    }
+
+  public:
+    static void*
+    allocate()
+    {
+        auto& s = state();
+        if (s.head)
+        {
+            auto n = s.head;
+            s.head = n->next;
+            --s.size;
+            return n;
+        }
+        return ::operator new(BLOCK_SIZE, BLOCK_ALIGN);
+    }
+
+    static void
+    deallocate(void* p) noexcept
+    {
+        auto& s = state();
+        if (s.reaped || s.size >= MAX_FREE_BLOCKS)
+        {
+            ::operator delete(p, BLOCK_ALIGN);
+            return;
+        }
+        // Blocks can be cached by a thread that never allocated them, so the
+        // Reaper is registered on first use of the list
+        static thread_local Reaper reaper;
+        auto n = static_cast<Node*>(p);
+        n->next = s.head;
+        s.head = n;
+        ++s.size;
+    }
+
+    static size_t
+    freeBlocks()
+    {
+        return state().size;
+    }
+};
+}
+
+// Allocator that recycles single-object allocations through a thread-local
+// free list per object size instead of returning them to the heap. It suits
+// the many short-lived, same-sized objects that nested LedgerTxns create and
+// destroy while transactions apply, such as entries and hash map nodes.
+// Multi-object allocations (i.e. hash table bucket arrays) go straight to the
+// heap. A block may be freed on a different thread than the one that
+// allocated it.
+template <typename T> class PoolAllocator
+{
+    using List = poolallocator::FreeList<sizeof(T), alignof(T)>;
+
+  public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U> PoolAllocator(PoolAllocator<U> const&) noexcept
+    {
+    }
+
+    T*
+    allocate(size_t n)
+    {
+        if (n == 1)
+        {
+            return static_cast<T*>(List::allocate());
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void
+    deallocate(T* p, size_t n) noexcept
+    {
+        if (n == 1)
+        {
+            List::deallocate(p);
+        }
+        else
+        {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    // Number of free blocks of T's size cached by the calling thread
+    static size_t
+    freeBlocks()
+    {
+        return List::freeBlocks();
+    }
+
+    template <typename U>
+    bool
+    operator==(PoolAllocator<U> const&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool
+    operator!=(PoolAllocator<U> const&) const noexcept
+    {
+        return false;
+    }
+};
+}
@@ -0,0 +1,105 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/PrometheusReporter.h"
+#include "util/Tracing.h"
+
+#include <chrono>
+#include <fmt/format.h>
+#include <iterator>
+
+namespace stellar
+{
+
+namespace
+{
+double const QUANTILES[] = {0.5, 0.75, 0.95, 0.99, 0.999};
+}
+
+std::string
+PrometheusReporter::sanitize(std::string const& name)
+{
+    std::string res = "stellar_core_";
+    res.reserve(res.size() + name.size());
+    for (char c : name)
+    {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c >= '0' && c <= '9') || c == '_';
+        res.push_back(ok ? c : '_');
+    }
+    return res;
+}
+
+void
+PrometheusReporter::header(char const* type)
+{
+    fmt::format_to(std::back_inserter(mOut), "# TYPE {} {}\n", mName, type);
+}
+
+void
+PrometheusReporter::Process(medida::Counter& counter)
+{
+    header("gauge");
+    fmt::format_to(std::back_inserter(mOut), "{} {}\n", mName,
+                   counter.count());
+}
+
+void
+PrometheusReporter::Process(medida::Meter& meter)
+{
+    header("counter");
+    fmt::format_to(std::back_inserter(mOut), "{}_total {}\n", mName,
+                   meter.count());
+}
+
+void
+PrometheusReporter::Process(medida::Histogram& histogram)
+{
+    header("summary");
+    auto snapshot = histogram.GetSnapshot();
+    for (auto q : QUANTILES)
+    {
+        fmt::format_to(std::back_inserter(mOut), "{}{{quantile=\"{}\"}} {}\n",
+                       mName, q, snapshot.getValue(q));
+    }
+    fmt::format_to(std::back_inserter(mOut), "{}_sum {}\n{}_count {}\n",
+                   mName, histogram.sum(), mName, histogram.count());
+}
+
+void
+PrometheusReporter::Process(medida::Timer& timer)
+{
+    header("summary");
+    double toSeconds =
+        std::chrono::duration<double>(timer.duration_unit()).count();
+    auto snapshot = timer.GetSnapshot();
+    for (auto q : QUANTILES)
+    {
+        fmt::format_to(std::back_inserter(mOut), "{}{{quantile=\"{}\"}} {}\n",
+                       mName, q, snapshot.getValue(q) * toSeconds);
+    }
+    fmt::format_to(std::back_inserter(mOut), "{}_sum {}\n{}_count {}\n",
+                   mName, timer.sum() * toSeconds, mName, timer.count());
+}
+
+void
+PrometheusReporter::Process(medida::Buckets& buckets)
+{
+    // Bucketed timers have no direct equivalent, they are only in the JSON
+    // metrics
+}
+
+std::string
+PrometheusReporter::report(MetricsSnapshot const& metrics)
+{
+    ZoneScoped;
+    mOut.clear();
+    for (auto const& [name, metric] : metrics)
+    {
+        mName = sanitize(name.ToString());
+        metric->Process(*this);
+    }
+    return std::move(mOut);
+}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "medida/metrics_registry.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stellar
+{
+
+using MetricsSnapshot = std::vector<
+    std::pair<medida::MetricName, std::shared_ptr<medida::MetricInterface>>>;
+
+// Renders metrics in the Prometheus text exposition format. Metric names are
+// prefixed with "stellar_core_" and have every character Prometheus doesn't
+// allow replaced with '_'. Counters are gauges, meters are counters of their
+// count, and histograms and timers are summaries, timers in seconds.
+//
+// Reading medida metrics is thread-safe, so a snapshot of the registry taken
+// on the main thread can be rendered on any thread.
+class PrometheusReporter : public medida::MetricProcessor
+{
+    std::string mOut;
+    std::string mName;
+
+    void header(char const* type);
+
+  public:
+    ~PrometheusReporter() override = default;
+    void Process(medida::Counter& counter) override;
+    void Process(medida::Meter& meter) override;
+    void Process(medida::Histogram& histogram) override;
+    void Process(medida::Timer& timer) override;
+    void Process(medida::Buckets& buckets) override;
+
+    std::string report(MetricsSnapshot const& metrics);
+
+    static std::string sanitize(std::string const& name);
+};
+}
@@ -4,6 +4,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "util/Math.h"
+#include "util/MemoryFootprint.h"
 #include "util/NonCopyable.h"
 
 #include <optional>
@@ -28,6 +29,7 @@ class RandomEvictionCache : public NonMovableOrCopyable
         uint64_t mInserts{0};
         uint64_t mUpdates{0};
         uint64_t mEvicts{0};
+        uint64_t mErases{0};
     };
 
   private:
@@ -41,6 +43,9 @@ class RandomEvictionCache : public NonMovableOrCopyable
     {
         uint64_t mLastAccess;
         V mValue;
+
+        // Position of this element in mValuePtrs
+        size_t mPtrIndex{0};
     };
 
     // Cache itself is stored in a hashmap.
@@ -81,12 +86,23 @@ class RandomEvictionCache : public NonMovableOrCopyable
         MapValueType*& vp2 = mValuePtrs.at(getRandIndex());
         MapValueType*& victim =
             (vp1->second.mLastAccess < vp2->second.mLastAccess ? vp1 : vp2);
-        mValueMap.erase(victim->first);
-        std::swap(victim, mValuePtrs.back());
-        mValuePtrs.pop_back();
+        removeAt(victim->second.mPtrIndex);
         ++mCounters.mEvicts;
     }
 
+    // Removes the element at position i of mValuePtrs from the cache, moving
+    // the last element of mValuePtrs into its place.
+    void
+    removeAt(size_t i)
+    {
+        MapValueType* victim = mValuePtrs.at(i);
+        MapValueType* last = mValuePtrs.back();
+        mValuePtrs[i] = last;
+        last->second.mPtrIndex = i;
+        mValuePtrs.pop_back();
+        mValueMap.erase(victim->first);
+    }
+
   public:
     explicit RandomEvictionCache(size_t maxSize)
         : mMaxSize(maxSize), mSeparatePRNG(false)
@@ -117,12 +133,34 @@ class RandomEvictionCache : public NonMovableOrCopyable
         return mMaxSize;
     }
 
+    // Changes the size of the cache, evicting entries until it fits. Memory
+    // reserved for a larger cache is kept, so that growing back is cheap.
+    void
+    setMaxSize(size_t maxSize)
+    {
+        mMaxSize = maxSize;
+        while (mValuePtrs.size() > mMaxSize)
+        {
+            evictOne();
+        }
+    }
+
     size_t
     size() const
     {
         return mValueMap.size();
     }
 
+    // Estimated bytes held by the cache, not counting heap memory owned by the
+    // keys and values
+    size_t
+    estimatedBytes() const
+    {
+        return mValueMap.size() * nodeBytes<MapValueType>() +
+               mValueMap.bucket_count() * sizeof(void*) +
+               mValuePtrs.capacity() * sizeof(MapValueType*);
+    }
+
     Counters const&
     getCounters() const
     {
@@ -136,7 +174,7 @@ class RandomEvictionCache : public NonMovableOrCopyable
     put(K const& k, V const& v)
     {
         ++mGeneration;
-        CacheValue newValue{mGeneration, v};
+        CacheValue newValue{mGeneration, v, mValuePtrs.size()};
         auto pair = mValueMap.insert(std::make_pair(k, newValue));
         if (pair.second)
         {
@@ -157,7 +195,8 @@ class RandomEvictionCache : public NonMovableOrCopyable
         {
             // No insertion happened, was already an entry: update its value.
             CacheValue& existing = pair.first->second;
-            existing = newValue;
+            existing.mLastAccess = newValue.mLastAccess;
+            existing.mValue = v;
             ++mCounters.mUpdates;
         }
     }
@@ -195,21 +234,34 @@ class RandomEvictionCache : public NonMovableOrCopyable
     {
         for (size_t i = 0; i < mValuePtrs.size(); ++i)
         {
-            MapValueType*& vp = mValuePtrs.at(i);
-            while (mValuePtrs.size() != i && f(vp->second.mValue))
+            while (mValuePtrs.size() != i && f(mValuePtrs[i]->second.mValue))
             {
                 // - `erase(k)` does not throw an exception unless that
                 // exception is thrown by the container’s Hash or Pred object
                 // (if any)
-                // - `std::swap` does not throw
+                // - pointer assignment does not throw
                 // - `std::unordered_map::pop_back` does not throw
-                mValueMap.erase(vp->first);
-                std::swap(vp, mValuePtrs.back());
-                mValuePtrs.pop_back();
+                removeAt(i);
             }
         }
     }
 
+    // `erase` offers basic exception safety guarantee. Removes k from the
+    // cache if present, returns true if an element was removed.
+    bool
+    erase(K const& k)
+    {
+        auto it = mValueMap.find(k);
+        if (it == mValueMap.end())
+        {
+            return false;
+        }
+
+        removeAt(it->second.mPtrIndex);
+        ++mCounters.mErases;
+        return true;
+    }
+
     // `maybeGet` offers basic exception safety guarantee.
     // Returns a pointer to the value if the key exists,
     // and returns a nullptr otherwise.
@@ -0,0 +1,169 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/SamplingProfiler.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <fstream>
+#include <malloc.h>
+#include <unistd.h>
+#endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace stellar
+{
+
+SamplingProfiler::SamplingProfiler(std::chrono::milliseconds interval)
+    : mInterval(std::max(interval, std::chrono::milliseconds(1)))
+    , mStartTime(std::chrono::steady_clock::now())
+{
+    SpanRecorder::trackCurrentZones(true);
+    mThread = std::thread([this]() { run(); });
+}
+
+SamplingProfiler::~SamplingProfiler()
+{
+    stop();
+}
+
+void
+SamplingProfiler::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        if (mStopping)
+        {
+            return;
+        }
+        mStopping = true;
+        mStopTime = std::chrono::steady_clock::now();
+    }
+    mWake.notify_all();
+    mThread.join();
+    SpanRecorder::trackCurrentZones(false);
+}
+
+void
+SamplingProfiler::run()
+{
+    SpanRecorder::setThreadName("profiler");
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mWake.wait_for(lock, mInterval, [this]() { return mStopping; }))
+    {
+        lock.unlock();
+        sample();
+        lock.lock();
+    }
+}
+
+void
+SamplingProfiler::sample()
+{
+    auto threads = SpanRecorder::sampleThreads();
+
+    std::lock_guard<std::mutex> guard(mMutex);
+    ++mSamples;
+    std::unordered_map<uint64_t, uint64_t> cpuNs;
+    for (auto const& t : threads)
+    {
+        if (!t.mCpuNs)
+        {
+            continue;
+        }
+        cpuNs.emplace(t.mThreadId, *t.mCpuNs);
+        auto last = mLastCpuNs.find(t.mThreadId);
+        if (last == mLastCpuNs.end() || *t.mCpuNs < last->second)
+        {
+            // First seen: its CPU time so far is not ours to attribute
+            continue;
+        }
+        uint64_t delta = *t.mCpuNs - last->second;
+        auto& zone = mZones[t.mZone];
+        zone.mZone = t.mZone;
+        zone.mCpuNs += delta;
+        ++zone.mSamples;
+        mCpuNsByThread[t.mThreadName] += delta;
+        mTotalCpuNs += delta;
+    }
+    // Forgets the threads that exited
+    mLastCpuNs = std::move(cpuNs);
+}
+
+SamplingProfiler::Report
+SamplingProfiler::report() const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    Report res;
+    res.mRunning = !mStopping;
+    res.mSamples = mSamples;
+    res.mDuration = mStopTime.value_or(std::chrono::steady_clock::now()) -
+                    mStartTime;
+    res.mTotalCpuNs = mTotalCpuNs;
+    res.mCpuNsByThread = mCpuNsByThread;
+    for (auto const& [loc, usage] : mZones)
+    {
+        auto subsystem = loc ? subsystemOf(loc->mFile) : UNTRACKED;
+        res.mCpuNsBySubsystem[subsystem] += usage.mCpuNs;
+        res.mZones.emplace_back(usage);
+    }
+    std::sort(res.mZones.begin(), res.mZones.end(),
+              [](ZoneUsage const& a, ZoneUsage const& b) {
+                  return a.mCpuNs > b.mCpuNs;
+              });
+    return res;
+}
+
+SamplingProfiler::MemoryUsage
+SamplingProfiler::memoryUsage()
+{
+    MemoryUsage res;
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    uint64_t sizePages, residentPages;
+    if (statm >> sizePages >> residentPages)
+    {
+        res.mResidentBytes = residentPages * sysconf(_SC_PAGESIZE);
+    }
+#endif
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        res.mPeakResidentBytes = usage.ru_maxrss;
+#else
+        // In kilobytes
+        res.mPeakResidentBytes = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    res.mHeapInUseBytes = mallinfo2().uordblks;
+#endif
+    return res;
+}
+
+std::string
+SamplingProfiler::subsystemOf(char const* file)
+{
+    std::string path(file);
+    std::replace(path.begin(), path.end(), '\\', '/');
+    auto src = path.rfind("src/");
+    if (src != std::string::npos)
+    {
+        path.erase(0, src + std::strlen("src/"));
+    }
+    auto slash = path.find('/');
+    if (slash == std::string::npos || slash == 0)
+    {
+        return "other";
+    }
+    return path.substr(0, slash);
+}
+}
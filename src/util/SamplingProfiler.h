@@ -0,0 +1,97 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include "util/SpanRecorder.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+// Attributes the CPU time of each thread to the zone (ZoneScoped or
+// ZoneNamedN) it is in, by sampling every thread's CPU clock and innermost
+// zone from a thread of its own, and to the subsystem, the directory under
+// src/, holding that zone. CPU used outside of any zone is put down to
+// UNTRACKED.
+//
+// Zones are only tracked in builds without Tracy, and CPU clocks only read on
+// Linux: elsewhere the profile stays empty.
+class SamplingProfiler : public NonMovableOrCopyable
+{
+  public:
+    static constexpr char const* UNTRACKED = "untracked";
+
+    struct ZoneUsage
+    {
+        SpanLocation const* mZone;
+        uint64_t mCpuNs{0};
+        uint64_t mSamples{0};
+    };
+
+    struct Report
+    {
+        bool mRunning;
+        uint64_t mSamples;
+        std::chrono::nanoseconds mDuration;
+        uint64_t mTotalCpuNs;
+        std::map<std::string, uint64_t> mCpuNsBySubsystem;
+        std::map<std::string, uint64_t> mCpuNsByThread;
+        // Most CPU first
+        std::vector<ZoneUsage> mZones;
+    };
+
+    struct MemoryUsage
+    {
+        std::optional<uint64_t> mResidentBytes;
+        std::optional<uint64_t> mPeakResidentBytes;
+        // Bytes allocated from the heap and not yet freed, as malloc counts
+        std::optional<uint64_t> mHeapInUseBytes;
+    };
+
+    // Starts sampling
+    explicit SamplingProfiler(std::chrono::milliseconds interval);
+    ~SamplingProfiler();
+
+    // Stops sampling, keeping what was gathered
+    void stop();
+
+    Report report() const;
+
+    static MemoryUsage memoryUsage();
+
+    // Directory under src/ of `file`, as given by __FILE__
+    static std::string subsystemOf(char const* file);
+
+  private:
+    std::chrono::milliseconds const mInterval;
+    std::chrono::steady_clock::time_point const mStartTime;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mWake;
+    bool mStopping{false};
+    std::optional<std::chrono::steady_clock::time_point> mStopTime;
+    uint64_t mSamples{0};
+    uint64_t mTotalCpuNs{0};
+    // CPU time of each thread at the previous sample, by thread id
+    std::unordered_map<uint64_t, uint64_t> mLastCpuNs;
+    std::map<std::string, uint64_t> mCpuNsByThread;
+    // By zone, nullptr being UNTRACKED
+    std::unordered_map<SpanLocation const*, ZoneUsage> mZones;
+
+    std::thread mThread;
+
+    void run();
+    void sample();
+};
+}
@@ -6,7 +6,13 @@
 #include "lib/util/finally.h"
 #include "util/GlobalChecks.h"
 #include "util/Timer.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
+#include "util/types.h"
+#include <medida/counter.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
+#include <stdexcept>
 
 namespace stellar
 {
@@ -38,6 +44,8 @@ class Scheduler::ActionQueue
     std::list<Qptr>& mIdleList;
     std::list<Qptr>::iterator mIdlePosition;
 
+    QueueMetrics* mMetrics{nullptr};
+
   public:
     ActionQueue(std::string const& name, ActionType type,
                 std::list<Qptr>& idleList)
@@ -109,6 +117,27 @@ class Scheduler::ActionQueue
         return mActions.empty();
     }
 
+    void
+    setMetrics(QueueMetrics* metrics)
+    {
+        mMetrics = metrics;
+        if (mMetrics)
+        {
+            mMetrics->addQueued(static_cast<int64_t>(mActions.size()));
+        }
+    }
+
+    nsecs
+    oldestWait(VirtualClock::time_point now) const
+    {
+        if (mActions.empty())
+        {
+            return nsecs{0};
+        }
+        return std::chrono::duration_cast<nsecs>(now -
+                                                 mActions.front().mEnqueueTime);
+    }
+
     bool
     isOverloaded(nsecs latencyWindow, VirtualClock::time_point now) const
     {
@@ -130,6 +159,11 @@ class Scheduler::ActionQueue
             mActions.pop_front();
             n++;
         }
+        if (mMetrics && n > 0)
+        {
+            mMetrics->addQueued(-static_cast<int64_t>(n));
+            mMetrics->mDropped.Mark(n);
+        }
         return n;
     }
 
@@ -138,6 +172,10 @@ class Scheduler::ActionQueue
     {
         auto elt = Element(clock, std::move(action));
         mActions.emplace_back(std::move(elt));
+        if (mMetrics)
+        {
+            mMetrics->addQueued(1);
+        }
     }
 
     void
@@ -146,14 +184,25 @@ class Scheduler::ActionQueue
         ZoneScoped;
         ZoneText(mName.c_str(), mName.size());
         auto before = clock.now();
+        auto enqueueTime = mActions.front().mEnqueueTime;
         Action action = std::move(mActions.front().mAction);
         mActions.pop_front();
+        if (mMetrics)
+        {
+            mMetrics->addQueued(-1);
+            mMetrics->mSojourn.Update(
+                std::chrono::duration_cast<nsecs>(before - enqueueTime));
+        }
 
         auto fini = gsl::finally([&]() {
             auto after = clock.now();
             nsecs duration = std::chrono::duration_cast<nsecs>(after - before);
             mTotalService = std::max(mTotalService + duration, minTotalService);
             mLastService = after;
+            if (mMetrics)
+            {
+                mMetrics->mRun.Update(duration);
+            }
         });
 
         action();
@@ -206,6 +255,94 @@ Scheduler::shutdown()
             std::priority_queue<Qptr, std::vector<Qptr>,
                                 std::function<bool(Qptr, Qptr)>>();
         mIdleActionQueues.clear();
+        for (auto& qm : mQueueMetrics)
+        {
+            qm.second.addQueued(-qm.second.mQueued);
+        }
+    }
+}
+
+void
+Scheduler::QueueMetrics::addQueued(int64_t n)
+{
+    mQueued += n;
+    mDepth.set_count(mQueued);
+}
+
+Scheduler::QueueMetrics*
+Scheduler::getQueueMetrics(std::string const& name)
+{
+    if (!mMetrics)
+    {
+        return nullptr;
+    }
+    auto it = mQueueMetrics.find(name);
+    if (it == mQueueMetrics.end())
+    {
+        auto metricName = toMetricName(name);
+        QueueMetrics qm{
+            mMetrics->NewCounter({"scheduler", "queue-depth", metricName}),
+            mMetrics->NewTimer({"scheduler", "sojourn", metricName}),
+            mMetrics->NewTimer({"scheduler", "run", metricName}),
+            mMetrics->NewMeter({"scheduler", "dropped", metricName},
+                               "action")};
+        // The registry may remember a count from an earlier scheduler
+        qm.addQueued(0);
+        it = mQueueMetrics.emplace(name, qm).first;
+    }
+    return &it->second;
+}
+
+void
+Scheduler::setMetrics(medida::MetricsRegistry* metrics)
+{
+    for (auto& qm : mQueueMetrics)
+    {
+        qm.second.addQueued(-qm.second.mQueued);
+    }
+    mQueueMetrics.clear();
+    mMetrics = metrics;
+    mOverloadStartMeter = nullptr;
+    mOverloadDurationTimer = nullptr;
+    if (mMetrics)
+    {
+        mOverloadStartMeter =
+            &mMetrics->NewMeter({"scheduler", "overload", "start"}, "event");
+        mOverloadDurationTimer =
+            &mMetrics->NewTimer({"scheduler", "overload", "duration"});
+    }
+    for (auto const& q : mAllActionQueues)
+    {
+        q.second->setMetrics(getQueueMetrics(q.first.first));
+    }
+}
+
+std::vector<Scheduler::QueueInfo>
+Scheduler::getQueueInfo() const
+{
+    auto now = mClock.now();
+    std::vector<QueueInfo> res;
+    res.reserve(mAllActionQueues.size());
+    for (auto const& q : mAllActionQueues)
+    {
+        res.emplace_back(QueueInfo{q.second->name(), q.second->type(),
+                                   q.second->size(), q.second->totalService(),
+                                   q.second->oldestWait(now)});
+    }
+    return res;
+}
+
+std::string
+Scheduler::getActionTypeName(ActionType type)
+{
+    switch (type)
+    {
+    case ActionType::NORMAL_ACTION:
+        return "normal";
+    case ActionType::DROPPABLE_ACTION:
+        return "droppable";
+    default:
+        throw std::runtime_error("Unknown action type");
     }
 }
 
@@ -215,9 +352,20 @@ Scheduler::setOverloaded(bool overloaded)
     if (overloaded)
     {
         mOverloadedStart = mClock.now();
+        mStats.mOverloadTransitions++;
+        if (mOverloadStartMeter)
+        {
+            mOverloadStartMeter->Mark();
+        }
     }
     else
     {
+        if (mOverloadDurationTimer &&
+            mOverloadedStart != std::chrono::steady_clock::time_point::max())
+        {
+            mOverloadDurationTimer->Update(std::chrono::duration_cast<nsecs>(
+                mClock.now() - mOverloadedStart));
+        }
         mOverloadedStart = std::chrono::steady_clock::time_point::max();
     }
 }
@@ -236,6 +384,7 @@ Scheduler::enqueue(std::string&& name, Action&& action, ActionType type)
     {
         mStats.mQueuesActivatedFromFresh++;
         auto q = std::make_shared<ActionQueue>(name, type, mIdleActionQueues);
+        q->setMetrics(getQueueMetrics(name));
         qi = mAllActionQueues.emplace(key, q).first;
         mRunnableActionQueues.push(qi->second);
     }
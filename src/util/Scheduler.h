@@ -12,6 +12,15 @@
 #include <queue>
 #include <set>
 #include <string>
+#include <vector>
+
+namespace medida
+{
+class Counter;
+class Meter;
+class MetricsRegistry;
+class Timer;
+}
 
 // This class implements a multi-queue scheduler for "actions" (deferred-work
 // callbacks that some subsystem wants to run "soon" on the main thread),
@@ -99,6 +108,11 @@
 //
 //   - We record the enqueue time and "droppability" of an action, to allow us
 //     to measure load level and perform load shedding.
+//
+// When given a metrics registry, the scheduler also reports, per queue name,
+// the number of queued actions, the time actions wait in the queue (their
+// "sojourn time") and run for, and the actions dropped; and, overall, each
+// transition into the overloaded state and how long it lasted.
 
 namespace stellar
 {
@@ -123,12 +137,46 @@ class Scheduler
         size_t mQueuesActivatedFromFresh{0};
         size_t mQueuesActivatedFromIdle{0};
         size_t mQueuesSuspended{0};
+        size_t mOverloadTransitions{0};
+    };
+
+    // A snapshot of one ActionQueue, runnable or idle
+    struct QueueInfo
+    {
+        std::string mName;
+        ActionType mType;
+        size_t mSize;
+        std::chrono::nanoseconds mTotalService;
+        // How long the action at the front of the queue has waited so far
+        std::chrono::nanoseconds mOldestWait;
     };
 
   private:
     class ActionQueue;
     using Qptr = std::shared_ptr<ActionQueue>;
 
+    struct QueueMetrics
+    {
+        medida::Counter& mDepth;
+        medida::Timer& mSojourn;
+        medida::Timer& mRun;
+        medida::Meter& mDropped;
+        // Actions queued under this name; mDepth is set from this rather than
+        // adjusted, so that it recovers from a clearmetrics
+        int64_t mQueued{0};
+
+        void addQueued(int64_t n);
+    };
+
+    // Metrics are per queue name, shared by the queues of both action types
+    // and kept after an idle queue is forgotten. Empty with no registry.
+    medida::MetricsRegistry* mMetrics{nullptr};
+    std::map<std::string, QueueMetrics> mQueueMetrics;
+    medida::Meter* mOverloadStartMeter{nullptr};
+    medida::Timer* mOverloadDurationTimer{nullptr};
+
+    QueueMetrics* getQueueMetrics(std::string const& name);
+
     // Stores all ActionQueues by name+type, either runnable or idle.
     std::map<std::pair<std::string, ActionType>, Qptr> mAllActionQueues;
 
@@ -201,7 +249,8 @@ class Scheduler
 
     // records the time the scheduler transitioned to the overloaded or max if
     // not
-    std::chrono::steady_clock::time_point mOverloadedStart;
+    std::chrono::steady_clock::time_point mOverloadedStart{
+        std::chrono::steady_clock::time_point::max()};
 
     // Records the currently-executing action type, or NORMAL_ACTION when no
     // action is running. This can be retrieved through currentActionType().
@@ -242,6 +291,20 @@ class Scheduler
         return mStats;
     }
 
+    std::vector<QueueInfo> getQueueInfo() const;
+
+    // Starts (or, with nullptr, stops) reporting metrics to `metrics`, which
+    // must outlive the scheduler or be detached first.
+    void setMetrics(medida::MetricsRegistry* metrics);
+
+    medida::MetricsRegistry*
+    getMetrics() const
+    {
+        return mMetrics;
+    }
+
+    static std::string getActionTypeName(ActionType type);
+
     void shutdown();
 
 #ifdef BUILD_TESTS
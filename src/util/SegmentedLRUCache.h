@@ -0,0 +1,439 @@
+#pragma once
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/GlobalChecks.h"
+#include "util/MemoryFootprint.h"
+#include "util/NonCopyable.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+// Puts every key of a SegmentedLRUCache in the same partition
+template <typename K> struct SinglePartition
+{
+    size_t
+    operator()(K const&) const
+    {
+        return 0;
+    }
+};
+
+// Implements a fixed-size segmented LRU cache, which resists scans: new
+// entries go into a probationary segment and only move to a protected segment
+// when they are read again. Eviction takes the least recently used
+// probationary entry, so a burst of entries that are only used once (a large
+// prefetch, say) cannot push out entries that are read over and over.
+//
+// Keys can further be split into partitions, each with its own segments and a
+// quota on the number of entries it may hold. A partition over its quota
+// evicts one of its own entries; otherwise the cache evicts the least recently
+// used probationary entry of any partition (or, if there is none, the least
+// recently used protected one). The quotas may add up to more than the size of
+// the cache: they only bound how much of it each partition can take.
+//
+// The interface matches RandomEvictionCache, with counters kept both for the
+// whole cache and for every partition.
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename Partition = SinglePartition<K>>
+class SegmentedLRUCache : public NonMovableOrCopyable
+{
+  public:
+    struct Counters
+    {
+        uint64_t mHits{0};
+        uint64_t mMisses{0};
+        uint64_t mInserts{0};
+        uint64_t mUpdates{0};
+        uint64_t mEvicts{0};
+        uint64_t mErases{0};
+        uint64_t mPromotions{0};
+    };
+
+    // Share of every partition that its protected segment may take
+    static constexpr double DEFAULT_PROTECTED_RATIO = 0.8;
+
+  private:
+    // Entries are stamped with a generation counter on every access, so that
+    // the least recently used entries of different partitions can be
+    // compared. Every segment is ordered from most to least recently used.
+    struct Node
+    {
+        K mKey;
+        V mValue;
+        uint64_t mLastAccess;
+        bool mProtected;
+    };
+    using List = std::list<Node>;
+    using ListIter = typename List::iterator;
+
+    struct Segments
+    {
+        List mProbation;
+        List mProtected;
+        // Quota the partition was created with, scaled by setMaxSize
+        size_t mQuota;
+        size_t mMaxSize;
+        size_t mMaxProtected;
+        Counters mCounters;
+
+        size_t
+        size() const
+        {
+            return mProbation.size() + mProtected.size();
+        }
+    };
+
+    // Cache will evict entries once it exceeds this size.
+    size_t mMaxSize;
+    size_t const mInitialMaxSize;
+    double const mProtectedRatio;
+    uint64_t mGeneration{0};
+    std::vector<Segments> mPartitions;
+    std::unordered_map<K, ListIter, Hash> mIndex;
+    Counters mCounters;
+
+    Segments&
+    partitionOf(K const& k)
+    {
+        auto i = Partition()(k);
+        releaseAssert(i < mPartitions.size());
+        return mPartitions[i];
+    }
+
+    // Marks the entry at it as the most recently used of its partition,
+    // promoting it to the protected segment if it was probationary. Does not
+    // throw.
+    void
+    access(Segments& seg, ListIter it)
+    {
+        it->mLastAccess = ++mGeneration;
+        if (it->mProtected)
+        {
+            seg.mProtected.splice(seg.mProtected.begin(), seg.mProtected, it);
+            return;
+        }
+
+        it->mProtected = true;
+        seg.mProtected.splice(seg.mProtected.begin(), seg.mProbation, it);
+        ++seg.mCounters.mPromotions;
+        ++mCounters.mPromotions;
+        demoteOverflow(seg);
+    }
+
+    // Demoted entries get another chance at the head of the probationary
+    // segment. Does not throw.
+    void
+    demoteOverflow(Segments& seg)
+    {
+        while (seg.mProtected.size() > seg.mMaxProtected)
+        {
+            auto demoted = std::prev(seg.mProtected.end());
+            demoted->mProtected = false;
+            demoted->mLastAccess = ++mGeneration;
+            seg.mProbation.splice(seg.mProbation.begin(), seg.mProtected,
+                                  demoted);
+        }
+    }
+
+    void
+    setPartitionMaxSize(Segments& seg, size_t maxSize)
+    {
+        seg.mMaxSize = std::min(maxSize, mMaxSize);
+        seg.mMaxProtected =
+            static_cast<size_t>(seg.mMaxSize * mProtectedRatio);
+    }
+
+    void
+    remove(Segments& seg, ListIter it)
+    {
+        mIndex.erase(it->mKey);
+        (it->mProtected ? seg.mProtected : seg.mProbation).erase(it);
+    }
+
+    void
+    evictFrom(Segments& seg)
+    {
+        auto& list = seg.mProbation.empty() ? seg.mProtected : seg.mProbation;
+        if (list.empty())
+        {
+            return;
+        }
+        remove(seg, std::prev(list.end()));
+        ++seg.mCounters.mEvicts;
+        ++mCounters.mEvicts;
+    }
+
+    // Evicts the least recently used entry, preferring probationary ones
+    void
+    evictOne()
+    {
+        Segments* victim = nullptr;
+        for (bool prot : {false, true})
+        {
+            uint64_t oldest = std::numeric_limits<uint64_t>::max();
+            for (auto& seg : mPartitions)
+            {
+                auto const& list = prot ? seg.mProtected : seg.mProbation;
+                if (!list.empty() && list.back().mLastAccess < oldest)
+                {
+                    oldest = list.back().mLastAccess;
+                    victim = &seg;
+                }
+            }
+            if (victim)
+            {
+                break;
+            }
+        }
+        if (victim)
+        {
+            evictFrom(*victim);
+        }
+    }
+
+  public:
+    explicit SegmentedLRUCache(size_t maxSize)
+        : SegmentedLRUCache(maxSize, std::vector<size_t>{maxSize})
+    {
+    }
+
+    // partitionMaxSizes has the quota of every partition that Partition can
+    // return
+    SegmentedLRUCache(size_t maxSize,
+                      std::vector<size_t> const& partitionMaxSizes,
+                      double protectedRatio = DEFAULT_PROTECTED_RATIO)
+        : mMaxSize(maxSize)
+        , mInitialMaxSize(maxSize)
+        , mProtectedRatio(protectedRatio)
+    {
+        releaseAssert(protectedRatio >= 0 && protectedRatio < 1);
+        mPartitions.resize(partitionMaxSizes.size());
+        for (size_t i = 0; i < partitionMaxSizes.size(); ++i)
+        {
+            auto& seg = mPartitions[i];
+            seg.mQuota = partitionMaxSizes[i];
+            setPartitionMaxSize(seg, seg.mQuota);
+        }
+        mIndex.reserve(maxSize + 1);
+    }
+
+    size_t
+    maxSize() const
+    {
+        return mMaxSize;
+    }
+
+    // Changes the size of the cache, scaling the quota of every partition by
+    // the same factor (but keeping at least one entry per partition). Entries
+    // over the new limits are evicted, least recently used first. Memory
+    // reserved for a larger cache is kept, so that growing back is cheap.
+    void
+    setMaxSize(size_t maxSize)
+    {
+        mMaxSize = maxSize;
+        double scale = mInitialMaxSize == 0
+                           ? 1.0
+                           : static_cast<double>(maxSize) / mInitialMaxSize;
+        for (auto& seg : mPartitions)
+        {
+            auto quota = static_cast<size_t>(seg.mQuota * scale);
+            setPartitionMaxSize(seg, std::max<size_t>(1, quota));
+            demoteOverflow(seg);
+            while (seg.size() > seg.mMaxSize)
+            {
+                evictFrom(seg);
+            }
+        }
+        while (mIndex.size() > mMaxSize)
+        {
+            evictOne();
+        }
+    }
+
+    size_t
+    size() const
+    {
+        return mIndex.size();
+    }
+
+    // Estimated bytes held by the cache, not counting heap memory owned by the
+    // keys and values
+    size_t
+    estimatedBytes() const
+    {
+        return mIndex.size() * (nodeBytes<Node>() +
+                                nodeBytes<std::pair<K const, ListIter>>()) +
+               mIndex.bucket_count() * sizeof(void*);
+    }
+
+    size_t
+    numPartitions() const
+    {
+        return mPartitions.size();
+    }
+
+    Counters const&
+    getCounters() const
+    {
+        return mCounters;
+    }
+
+    Counters const&
+    getCounters(size_t partition) const
+    {
+        return mPartitions.at(partition).mCounters;
+    }
+
+    // `put` does not offer exception safety. If it throws an exception,
+    // cache may be in an inconsistent state. It is, therefore,
+    // client's responsibility to handle failures correctly.
+    //
+    // Putting a key that is already cached replaces its value and marks it
+    // as recently used, but does not promote it.
+    void
+    put(K const& k, V const& v)
+    {
+        auto& seg = partitionOf(k);
+        auto found = mIndex.find(k);
+        if (found != mIndex.end())
+        {
+            auto it = found->second;
+            it->mValue = v;
+            it->mLastAccess = ++mGeneration;
+            auto& list = it->mProtected ? seg.mProtected : seg.mProbation;
+            list.splice(list.begin(), list, it);
+            ++seg.mCounters.mUpdates;
+            ++mCounters.mUpdates;
+            return;
+        }
+
+        seg.mProbation.push_front(Node{k, v, ++mGeneration, false});
+        mIndex.emplace(k, seg.mProbation.begin());
+        ++seg.mCounters.mInserts;
+        ++mCounters.mInserts;
+
+        // We may have just grown over a size limit. Fix that.
+        if (seg.size() > seg.mMaxSize)
+        {
+            evictFrom(seg);
+        }
+        else if (mIndex.size() > mMaxSize)
+        {
+            evictOne();
+        }
+    }
+
+    // `exists` offers strong exception safety guarantee.
+    bool
+    exists(K const& k, bool countMisses = true)
+    {
+        bool miss = (mIndex.find(k) == mIndex.end());
+        // As with RandomEvictionCache, exists() is typically used as a guard
+        // followed by a get(), so it counts misses but not hits, and does not
+        // count as an access. Pass `false` for countMisses otherwise.
+        if (miss && countMisses)
+        {
+            ++partitionOf(k).mCounters.mMisses;
+            ++mCounters.mMisses;
+        }
+        return !miss;
+    }
+
+    // `clear` does not throw. Counters are kept.
+    void
+    clear()
+    {
+        mIndex.clear();
+        for (auto& seg : mPartitions)
+        {
+            seg.mProbation.clear();
+            seg.mProtected.clear();
+        }
+    }
+
+    // `erase_if` offers basic exception safety guarantee. If it throws an
+    // exception, then the cache may or may not be modified.
+    void
+    erase_if(std::function<bool(V const&)> const& f)
+    {
+        for (auto& seg : mPartitions)
+        {
+            for (auto* list : {&seg.mProbation, &seg.mProtected})
+            {
+                for (auto it = list->begin(); it != list->end();)
+                {
+                    auto next = std::next(it);
+                    if (f(it->mValue))
+                    {
+                        remove(seg, it);
+                    }
+                    it = next;
+                }
+            }
+        }
+    }
+
+    // `erase` offers basic exception safety guarantee. Removes k from the
+    // cache if present, returns true if an element was removed.
+    bool
+    erase(K const& k)
+    {
+        auto found = mIndex.find(k);
+        if (found == mIndex.end())
+        {
+            return false;
+        }
+
+        auto& seg = partitionOf(k);
+        remove(seg, found->second);
+        ++seg.mCounters.mErases;
+        ++mCounters.mErases;
+        return true;
+    }
+
+    // `maybeGet` offers basic exception safety guarantee.
+    // Returns a pointer to the value if the key exists,
+    // and returns a nullptr otherwise.
+    V*
+    maybeGet(K const& k)
+    {
+        auto& seg = partitionOf(k);
+        auto found = mIndex.find(k);
+        if (found == mIndex.end())
+        {
+            ++seg.mCounters.mMisses;
+            ++mCounters.mMisses;
+            return nullptr;
+        }
+
+        ++seg.mCounters.mHits;
+        ++mCounters.mHits;
+        access(seg, found->second);
+        return &found->second->mValue;
+    }
+
+    // `get` offers basic exception safety guarantee.
+    V&
+    get(K const& k)
+    {
+        V* result = maybeGet(k);
+        if (result == nullptr)
+        {
+            throw std::range_error("There is no such key in cache");
+        }
+        return *result;
+    }
+};
+}
@@ -0,0 +1,348 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/SpanRecorder.h"
+#include "util/GlobalChecks.h"
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <time.h>
+#endif
+
+namespace stellar
+{
+
+std::atomic<uint32_t> SpanRecorder::gFlags{0};
+
+namespace
+{
+// An entry is only read if its sequence number is the same, and even, before
+// and after reading it: the writer makes it odd while it is rewriting it
+struct Entry
+{
+    std::atomic<uint64_t> mSeq{0};
+    std::atomic<SpanLocation const*> mLoc{nullptr};
+    std::atomic<uint64_t> mStart{0};
+    std::atomic<uint64_t> mEnd{0};
+};
+
+struct ThreadBuffer
+{
+    uint64_t const mId;
+    // Allocated by the owning thread before its first span; others only look
+    // at it once mWritten is non-zero
+    std::unique_ptr<Entry[]> mEntries;
+    // Written by the owning thread only
+    std::atomic<uint64_t> mWritten{0};
+    // Innermost tracked zone the owning thread is in
+    std::atomic<SpanLocation const*> mCurrent{nullptr};
+    // Guarded by gMutex
+    std::string mName;
+#ifdef __linux__
+    clockid_t mCpuClock;
+    bool mHasCpuClock;
+#endif
+
+    explicit ThreadBuffer(uint64_t id) : mId(id)
+    {
+#ifdef __linux__
+        mHasCpuClock = pthread_getcpuclockid(pthread_self(), &mCpuClock) == 0;
+#endif
+    }
+};
+
+struct Span
+{
+    SpanLocation const* mLoc;
+    uint64_t mStart;
+    uint64_t mEnd;
+};
+
+std::mutex gMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> gBuffers;
+uint64_t gNextId{1};
+
+// Unregisters the thread's buffer when it exits
+struct ThreadSlot
+{
+    std::shared_ptr<ThreadBuffer> mBuffer;
+    std::string mName;
+
+    ~ThreadSlot()
+    {
+        if (mBuffer)
+        {
+            std::lock_guard<std::mutex> guard(gMutex);
+            gBuffers.erase(
+                std::remove(gBuffers.begin(), gBuffers.end(), mBuffer),
+                gBuffers.end());
+        }
+    }
+};
+
+thread_local ThreadSlot tSlot;
+
+ThreadBuffer&
+getThreadBuffer()
+{
+    if (!tSlot.mBuffer)
+    {
+        std::lock_guard<std::mutex> guard(gMutex);
+        auto buffer = std::make_shared<ThreadBuffer>(gNextId++);
+        buffer->mName = tSlot.mName;
+        if (buffer->mName.empty())
+        {
+            buffer->mName = threadIsMain()
+                                ? std::string("main")
+                                : fmt::format(FMT_STRING("thread-{}"),
+                                              buffer->mId);
+        }
+        gBuffers.emplace_back(buffer);
+        tSlot.mBuffer = std::move(buffer);
+    }
+    return *tSlot.mBuffer;
+}
+
+// Copies the spans of `buffer` that ended at or after `since`, skipping any
+// the owning thread overwrites meanwhile
+void
+collectSpans(ThreadBuffer const& buffer, uint64_t since,
+             std::vector<Span>& spans)
+{
+    uint64_t const capacity = SpanRecorder::SPANS_PER_THREAD;
+    uint64_t written = buffer.mWritten.load(std::memory_order_acquire);
+    if (written == 0)
+    {
+        return;
+    }
+    uint64_t first = written > capacity ? written - capacity : 0;
+    for (uint64_t i = first; i < written; ++i)
+    {
+        auto const& e = buffer.mEntries[i % capacity];
+        uint64_t seq = e.mSeq.load(std::memory_order_acquire);
+        Span span{e.mLoc.load(std::memory_order_relaxed),
+                  e.mStart.load(std::memory_order_relaxed),
+                  e.mEnd.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq != 2 * i + 2 ||
+            e.mSeq.load(std::memory_order_relaxed) != seq || span.mEnd < since)
+        {
+            continue;
+        }
+        spans.emplace_back(span);
+    }
+}
+
+void
+appendJsonString(std::string& out, char const* s)
+{
+    out.push_back('"');
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            out.push_back('\\');
+            out.push_back(*s);
+        }
+        else if (static_cast<unsigned char>(*s) < 0x20)
+        {
+            out += fmt::format(FMT_STRING("\\u{:04x}"),
+                               static_cast<int>(*s));
+        }
+        else
+        {
+            out.push_back(*s);
+        }
+    }
+    out.push_back('"');
+}
+}
+
+bool
+SpanRecorder::isAvailable()
+{
+#ifdef USE_TRACY
+    return false;
+#else
+    return true;
+#endif
+}
+
+void
+SpanRecorder::start()
+{
+    gFlags.fetch_or(RECORDING, std::memory_order_relaxed);
+}
+
+void
+SpanRecorder::stop()
+{
+    gFlags.fetch_and(~RECORDING, std::memory_order_relaxed);
+}
+
+void
+SpanRecorder::trackCurrentZones(bool track)
+{
+    if (track)
+    {
+        gFlags.fetch_or(TRACKING, std::memory_order_relaxed);
+    }
+    else
+    {
+        gFlags.fetch_and(~TRACKING, std::memory_order_relaxed);
+    }
+}
+
+std::vector<SpanRecorder::ThreadSample>
+SpanRecorder::sampleThreads()
+{
+    std::vector<ThreadSample> res;
+    // Held while reading CPU clocks: a thread cannot exit, and its clock go
+    // stale, before it has unregistered
+    std::lock_guard<std::mutex> guard(gMutex);
+    res.reserve(gBuffers.size());
+    for (auto const& b : gBuffers)
+    {
+        ThreadSample sample{b->mId, b->mName,
+                            b->mCurrent.load(std::memory_order_relaxed),
+                            std::nullopt};
+#ifdef __linux__
+        timespec ts;
+        if (b->mHasCpuClock && clock_gettime(b->mCpuClock, &ts) == 0)
+        {
+            sample.mCpuNs = static_cast<uint64_t>(ts.tv_sec) * 1000000000 +
+                            static_cast<uint64_t>(ts.tv_nsec);
+        }
+#endif
+        res.emplace_back(std::move(sample));
+    }
+    return res;
+}
+
+void
+SpanRecorder::setThreadName(std::string const& name)
+{
+    tSlot.mName = name;
+    if (tSlot.mBuffer)
+    {
+        std::lock_guard<std::mutex> guard(gMutex);
+        tSlot.mBuffer->mName = name;
+    }
+}
+
+void
+SpanRecorder::record(SpanLocation const* loc, uint64_t startNs, uint64_t endNs)
+{
+    auto& buffer = getThreadBuffer();
+    if (!buffer.mEntries)
+    {
+        buffer.mEntries = std::make_unique<Entry[]>(SPANS_PER_THREAD);
+    }
+    uint64_t i = buffer.mWritten.load(std::memory_order_relaxed);
+    auto& e = buffer.mEntries[i % SPANS_PER_THREAD];
+    e.mSeq.store(2 * i + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.mLoc.store(loc, std::memory_order_relaxed);
+    e.mStart.store(startNs, std::memory_order_relaxed);
+    e.mEnd.store(endNs, std::memory_order_relaxed);
+    e.mSeq.store(2 * i + 2, std::memory_order_release);
+    buffer.mWritten.store(i + 1, std::memory_order_release);
+}
+
+void
+SpanRecorder::enter(SpanScope& scope)
+{
+    uint32_t const flags = gFlags.load(std::memory_order_relaxed);
+    if (flags & RECORDING)
+    {
+        scope.mStart = now();
+    }
+    if (flags & TRACKING)
+    {
+        auto& current = getThreadBuffer().mCurrent;
+        scope.mOuter = current.load(std::memory_order_relaxed);
+        current.store(scope.mLoc, std::memory_order_relaxed);
+        scope.mTracked = true;
+    }
+}
+
+void
+SpanRecorder::exit(SpanScope& scope)
+{
+    if (scope.mStart != 0)
+    {
+        record(scope.mLoc, scope.mStart, now());
+    }
+    if (scope.mTracked)
+    {
+        getThreadBuffer().mCurrent.store(scope.mOuter,
+                                         std::memory_order_relaxed);
+    }
+}
+
+std::string
+SpanRecorder::dumpChromeTrace(std::chrono::microseconds window)
+{
+    uint64_t const nowNs = now();
+    uint64_t const windowNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(window).count();
+    uint64_t const since = nowNs > windowNs ? nowNs - windowNs : 0;
+
+    std::vector<std::pair<std::shared_ptr<ThreadBuffer>, std::string>> buffers;
+    {
+        std::lock_guard<std::mutex> guard(gMutex);
+        for (auto const& b : gBuffers)
+        {
+            buffers.emplace_back(b, b->mName);
+        }
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&]() {
+        if (!first)
+        {
+            out.push_back(',');
+        }
+        first = false;
+    };
+
+    std::vector<Span> spans;
+    for (auto const& [buffer, name] : buffers)
+    {
+        separate();
+        out += fmt::format(
+            FMT_STRING("{{\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                       "\"name\":\"thread_name\",\"args\":{{\"name\":"),
+            buffer->mId);
+        appendJsonString(out, name.c_str());
+        out += "}}";
+
+        spans.clear();
+        collectSpans(*buffer, since, spans);
+        for (auto const& span : spans)
+        {
+            auto const* loc = span.mLoc;
+            separate();
+            out += "{\"ph\":\"X\",\"pid\":1,\"name\":";
+            appendJsonString(out, loc->mName ? loc->mName : loc->mFunction);
+            out += fmt::format(
+                FMT_STRING(",\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},"
+                           "\"args\":{{\"line\":{},\"file\":"),
+                buffer->mId, span.mStart / 1000.0,
+                (span.mEnd - span.mStart) / 1000.0, loc->mLine);
+            appendJsonString(out, loc->mFile);
+            out += "}}";
+        }
+    }
+    out += "]}";
+    return out;
+}
+}
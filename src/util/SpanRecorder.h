@@ -0,0 +1,151 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// This header is included by util/Tracing.h, itself included almost
+// everywhere: keep it free of other stellar-core headers.
+
+namespace stellar
+{
+
+// Where a span was opened. Instances are static, one per ZoneScoped or
+// ZoneNamedN site.
+struct SpanLocation
+{
+    // Name given to ZoneNamedN, or nullptr for ZoneScoped
+    char const* mName;
+    char const* mFunction;
+    char const* mFile;
+    uint32_t mLine;
+};
+
+// Records the zones marked by ZoneScoped and ZoneNamedN in builds without
+// Tracy, so that a trace of the last few seconds can be captured from a
+// running node (see the `tracing` HTTP command).
+//
+// Each thread writes the spans it closes into its own ring buffer of
+// SPANS_PER_THREAD entries, which is only allocated once the thread records
+// something. Nothing is recorded, and a span costs a relaxed load, until
+// `start` is called.
+//
+// Independently, each thread's innermost open zone can be tracked for the
+// SamplingProfiler to read.
+class SpanScope;
+class SpanRecorder
+{
+  public:
+    static constexpr size_t SPANS_PER_THREAD = 1 << 15;
+
+    // False in Tracy builds, where the zone macros belong to Tracy
+    static bool isAvailable();
+
+    static void start();
+    static void stop();
+
+    static bool
+    isRecording()
+    {
+        return (gFlags.load(std::memory_order_relaxed) & RECORDING) != 0;
+    }
+
+    // Turns tracking of the innermost open zone of each thread on or off
+    static void trackCurrentZones(bool track);
+
+    struct ThreadSample
+    {
+        uint64_t mThreadId;
+        std::string mThreadName;
+        // Innermost zone open when sampled, if any
+        SpanLocation const* mZone;
+        // CPU time the thread has used, where the platform tells
+        std::optional<uint64_t> mCpuNs;
+    };
+
+    // Samples the threads that have opened a zone while tracking, or recorded
+    // a span
+    static std::vector<ThreadSample> sampleThreads();
+
+    // Names the calling thread in dumps
+    static void setThreadName(std::string const& name);
+
+    // Returns the spans that ended in the last `window`, as a JSON object in
+    // the Chrome trace event format (which Perfetto also reads)
+    static std::string dumpChromeTrace(std::chrono::microseconds window);
+
+    static uint64_t
+    now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static void record(SpanLocation const* loc, uint64_t startNs,
+                       uint64_t endNs);
+
+  private:
+    friend class SpanScope;
+    static constexpr uint32_t RECORDING = 1;
+    static constexpr uint32_t TRACKING = 2;
+    static std::atomic<uint32_t> gFlags;
+
+    static bool
+    isActive()
+    {
+        return gFlags.load(std::memory_order_relaxed) != 0;
+    }
+
+    static void enter(SpanScope& scope);
+    static void exit(SpanScope& scope);
+};
+
+class SpanScope
+{
+    friend class SpanRecorder;
+    SpanLocation const* const mLoc;
+    // 0 when not recording this span
+    uint64_t mStart{0};
+    // Whether this zone is the thread's current one, and the one it hides
+    bool mTracked{false};
+    SpanLocation const* mOuter{nullptr};
+
+  public:
+    SpanScope(SpanLocation const* loc, bool active) : mLoc(loc)
+    {
+        if (active && SpanRecorder::isActive())
+        {
+            SpanRecorder::enter(*this);
+        }
+    }
+
+    ~SpanScope()
+    {
+        if (mStart != 0 || mTracked)
+        {
+            SpanRecorder::exit(*this);
+        }
+    }
+
+    SpanScope(SpanScope const&) = delete;
+    SpanScope& operator=(SpanScope const&) = delete;
+};
+}
+
+#define STELLAR_SPAN_CONCAT_(a, b) a##b
+#define STELLAR_SPAN_CONCAT(a, b) STELLAR_SPAN_CONCAT_(a, b)
+
+#define STELLAR_SPAN(varname, name, active) \
+    static constexpr ::stellar::SpanLocation STELLAR_SPAN_CONCAT( \
+        __stellar_span_location, __LINE__){name, __FUNCTION__, __FILE__, \
+                                           __LINE__}; \
+    ::stellar::SpanScope varname( \
+        &STELLAR_SPAN_CONCAT(__stellar_span_location, __LINE__), active)
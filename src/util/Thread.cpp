@@ -4,6 +4,11 @@
 
 #include "util/Thread.h"
 #include "util/Logging.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <memory>
+#include <mutex>
+#include <sstream>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -13,10 +18,186 @@
 #if defined(__APPLE__)
 #include <pthread.h>
 #endif
+#ifdef __linux__
+#include <cerrno>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
 
 namespace stellar
 {
 
+namespace
+{
+struct ThreadRole
+{
+    std::string mRole;
+#ifdef __linux__
+    pid_t mTid;
+#endif
+};
+
+std::mutex gThreadRolesMutex;
+std::vector<std::shared_ptr<ThreadRole>> gThreadRoles;
+
+// Unregisters the thread's role when it exits
+struct ThreadRoleSlot
+{
+    std::shared_ptr<ThreadRole> mRole;
+
+    ~ThreadRoleSlot()
+    {
+        if (mRole)
+        {
+            std::lock_guard<std::mutex> guard(gThreadRolesMutex);
+            gThreadRoles.erase(
+                std::remove(gThreadRoles.begin(), gThreadRoles.end(), mRole),
+                gThreadRoles.end());
+        }
+    }
+};
+
+thread_local ThreadRoleSlot tThreadRole;
+
+#ifdef __linux__
+// Field 39 of /proc/self/task/<tid>/stat, past the parenthesized command name
+// which may itself hold spaces
+std::optional<uint32_t>
+readLastCpu(pid_t tid)
+{
+    std::ifstream in("/proc/self/task/" + std::to_string(tid) + "/stat");
+    std::string stat;
+    if (!std::getline(in, stat))
+    {
+        return std::nullopt;
+    }
+    auto pos = stat.rfind(')');
+    if (pos == std::string::npos)
+    {
+        return std::nullopt;
+    }
+    std::istringstream fields(stat.substr(pos + 1));
+    std::string field;
+    for (int i = 3; i <= 39; ++i)
+    {
+        if (!(fields >> field))
+        {
+            return std::nullopt;
+        }
+    }
+    try
+    {
+        return static_cast<uint32_t>(std::stoul(field));
+    }
+    catch (std::exception const&)
+    {
+        return std::nullopt;
+    }
+}
+#endif
+}
+
+void
+setCurrentThreadRole(std::string const& role,
+                     std::vector<uint32_t> const& cpus)
+{
+    if (!cpus.empty())
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto cpu : cpus)
+        {
+            if (cpu < CPU_SETSIZE)
+            {
+                CPU_SET(cpu, &set);
+            }
+        }
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (ret != 0)
+        {
+            LOG_WARNING(DEFAULT_LOG, "Unable to pin {} thread to CPUs {}: {}",
+                        role, fmt::join(cpus, ","), ret);
+        }
+#else
+        LOG_WARNING(DEFAULT_LOG,
+                    "Pinning threads to CPUs is not supported on this "
+                    "platform, {} thread left unpinned",
+                    role);
+#endif
+    }
+
+    std::lock_guard<std::mutex> guard(gThreadRolesMutex);
+    if (!tThreadRole.mRole)
+    {
+        tThreadRole.mRole = std::make_shared<ThreadRole>();
+#ifdef __linux__
+        tThreadRole.mRole->mTid = static_cast<pid_t>(syscall(SYS_gettid));
+#endif
+        gThreadRoles.emplace_back(tThreadRole.mRole);
+    }
+    tThreadRole.mRole->mRole = role;
+}
+
+std::vector<ThreadRoleInfo>
+getThreadRoles()
+{
+    std::vector<ThreadRoleInfo> res;
+    // Held while looking the threads up, so that none exits meanwhile and has
+    // its id reused
+    std::lock_guard<std::mutex> guard(gThreadRolesMutex);
+    for (auto const& r : gThreadRoles)
+    {
+        ThreadRoleInfo info;
+        info.mRole = r->mRole;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(r->mTid, sizeof(set), &set) == 0)
+        {
+            for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    info.mAllowedCpus.emplace_back(cpu);
+                }
+            }
+        }
+        info.mLastCpu = readLastCpu(r->mTid);
+#endif
+        res.emplace_back(std::move(info));
+    }
+    return res;
+}
+
+bool
+interleaveMemoryOverNumaNodes()
+{
+#ifdef __linux__
+    // MPOL_INTERLEAVE from <linux/mempolicy.h>; the kernel keeps only the
+    // nodes of the mask that have memory
+    constexpr int MPOL_INTERLEAVE_MODE = 3;
+    constexpr unsigned long MAX_NODES = 1024;
+    std::vector<unsigned long> mask(MAX_NODES / (8 * sizeof(unsigned long)),
+                                    ~0UL);
+    if (syscall(SYS_set_mempolicy, MPOL_INTERLEAVE_MODE, mask.data(),
+                MAX_NODES) != 0)
+    {
+        LOG_WARNING(DEFAULT_LOG, "Unable to interleave memory over NUMA "
+                                 "nodes: {}",
+                    errno);
+        return false;
+    }
+    return true;
+#else
+    LOG_WARNING(DEFAULT_LOG, "NUMA memory policies are not supported on this "
+                             "platform");
+    return false;
+#endif
+}
+
 #if defined(_WIN32)
 
 static void
@@ -5,8 +5,12 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include <chrono>
+#include <cstdint>
 #include <future>
+#include <optional>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace stellar
 {
@@ -14,6 +18,29 @@ namespace stellar
 void runCurrentThreadWithLowPriority();
 void runCurrentThreadWithMediumPriority();
 
+// Records the calling thread as one running `role`, for getThreadRoles, and
+// restricts it to the CPUs `cpus` unless empty. Restricting threads is only
+// supported on Linux; elsewhere it is logged and ignored.
+void setCurrentThreadRole(std::string const& role,
+                          std::vector<uint32_t> const& cpus);
+
+struct ThreadRoleInfo
+{
+    std::string mRole;
+    // CPUs the thread may run on, if known
+    std::vector<uint32_t> mAllowedCpus;
+    // CPU the thread last ran on, if known
+    std::optional<uint32_t> mLastCpu;
+};
+
+// The running threads that called setCurrentThreadRole
+std::vector<ThreadRoleInfo> getThreadRoles();
+
+// Spreads the pages the calling thread, and the threads it starts from then
+// on, allocate over all NUMA nodes instead of the node they run on. Only
+// supported on Linux: returns false if it could not be done.
+bool interleaveMemoryOverNumaNodes();
+
 template <typename T>
 bool
 futureIsReady(std::future<T> const& fut)
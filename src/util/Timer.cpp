@@ -7,7 +7,8 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Scheduler.h"
-#include <Tracy.hpp>
+#include "util/TimerWheel.h"
+#include "util/Tracing.h"
 #include <chrono>
 #include <cstdio>
 #include <thread>
@@ -21,10 +22,11 @@ static const std::chrono::milliseconds CRANK_TIME_SLICE(500);
 static const size_t CRANK_EVENT_SLICE = 100;
 const std::chrono::seconds SCHEDULER_LATENCY_WINDOW(5);
 
-VirtualClock::VirtualClock(Mode mode)
+VirtualClock::VirtualClock(Mode mode, TimerBackend timers)
     : mMode(mode)
     , mActionScheduler(
           std::make_unique<Scheduler>(*this, SCHEDULER_LATENCY_WINDOW))
+    , mWheel(timers == TIMER_WHEEL ? std::make_unique<TimerWheel>() : nullptr)
     , mRealTimer(mIOContext)
 {
 }
@@ -92,6 +94,10 @@ VirtualClock::time_point
 VirtualClock::next() const
 {
     releaseAssert(threadIsMain());
+    if (mWheel)
+    {
+        return mWheel->next();
+    }
     VirtualClock::time_point least = time_point::max();
     if (!mEvents.empty())
     {
@@ -197,15 +203,38 @@ VirtualClock::enqueue(shared_ptr<VirtualClockEvent> ve)
         return;
     }
     releaseAssert(threadIsMain());
-    mEvents.emplace(ve);
+    if (mWheel)
+    {
+        mWheel->insert(ve, now());
+    }
+    else
+    {
+        mEvents.emplace(ve);
+    }
     maybeSetRealtimer();
 }
 
+void
+VirtualClock::dequeue(VirtualClockEvent& ve)
+{
+    if (mWheel && !mDestructing)
+    {
+        releaseAssert(threadIsMain());
+        mWheel->erase(ve);
+    }
+}
+
+bool
+VirtualClock::hasEvents() const
+{
+    return mWheel ? !mWheel->empty() : !mEvents.empty();
+}
+
 void
 VirtualClock::flushCancelledEvents()
 {
     ZoneScoped;
-    if (mDestructing)
+    if (mDestructing || mWheel)
     {
         return;
     }
@@ -244,6 +273,16 @@ VirtualClock::cancelAllEvents()
     ZoneScoped;
     releaseAssert(threadIsMain());
 
+    if (mWheel)
+    {
+        auto events = mWheel->clear();
+        for (auto& ev : events)
+        {
+            ev->cancel();
+        }
+        return !events.empty();
+    }
+
     bool wasEmpty = mEvents.empty();
     while (!mEvents.empty())
     {
@@ -489,6 +528,18 @@ VirtualClock::currentSchedulerActionType() const
     return mActionScheduler->currentActionType();
 }
 
+Scheduler const&
+VirtualClock::getActionScheduler() const
+{
+    return *mActionScheduler;
+}
+
+void
+VirtualClock::setActionSchedulerMetrics(medida::MetricsRegistry* metrics)
+{
+    mActionScheduler->setMetrics(metrics);
+}
+
 asio::io_context&
 VirtualClock::getIOContext()
 {
@@ -513,6 +564,10 @@ VirtualClock::advanceToNow()
 
     auto n = now();
     vector<shared_ptr<VirtualClockEvent>> toDispatch;
+    if (mWheel)
+    {
+        mWheel->popDue(n, toDispatch);
+    }
     while (!mEvents.empty())
     {
         if (mEvents.top()->mWhen > n)
@@ -540,7 +595,7 @@ VirtualClock::advanceToNext()
     }
     releaseAssert(mMode == VIRTUAL_TIME);
     releaseAssert(threadIsMain());
-    if (mEvents.empty())
+    if (!hasEvents())
     {
         return 0;
     }
@@ -628,6 +683,7 @@ VirtualTimer::cancel()
         mCancelled = true;
         for (auto ev : mEvents)
         {
+            mClock.dequeue(*ev);
             ev->cancel();
         }
         mClock.flushCancelledEvents();
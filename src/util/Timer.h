@@ -14,6 +14,7 @@
 #include <chrono>
 #include <ctime>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -54,6 +55,7 @@ using RealSteadyTimer = asio::steady_timer;
 class VirtualTimer;
 class Application;
 class VirtualClockEvent;
+class TimerWheel;
 class VirtualClockEventCompare
 {
   public:
@@ -119,6 +121,15 @@ class VirtualClock
         VIRTUAL_TIME
     };
 
+    // How pending timer events are kept: in a heap, where cancelled events
+    // stay until flushed in batches, or in a TimerWheel, where arming and
+    // cancelling are O(1)
+    enum TimerBackend
+    {
+        TIMER_HEAP,
+        TIMER_WHEEL
+    };
+
     // Call this in any loop that should continue for up-to a single
     // real-time-quantum of scheduling. NB: In VIRTUAL_TIME mode this will
     // always return true, to improve test determinism. This means you should
@@ -148,9 +159,10 @@ class VirtualClock
     // thread will dequeue (immediately re-enqueueing into the Scheduler for
     // further time-slicing / load-shedding).
     //
-    // The third is a priority queue of VirtualClockEvents, which is the part of
-    // the VirtualClock that manages the progress of virtual time and the
-    // dispatch of timers as virtual time advances past them.
+    // The third is a priority queue of VirtualClockEvents (or a timer wheel,
+    // with TIMER_WHEEL), which is the part of the VirtualClock that manages the
+    // progress of virtual time and the dispatch of timers as virtual time
+    // advances past them.
     std::chrono::steady_clock::time_point mLastDispatchStart;
     std::unique_ptr<Scheduler> mActionScheduler;
 
@@ -165,10 +177,13 @@ class VirtualClock
                             VirtualClockEventCompare>;
     PrQueue mEvents;
     size_t mFlushesIgnored = 0;
+    // Replaces mEvents with TIMER_WHEEL
+    std::unique_ptr<TimerWheel> mWheel;
 
     bool mDestructing{false};
 
     void maybeSetRealtimer();
+    bool hasEvents() const;
     size_t advanceToNext();
     size_t advanceToNow();
 
@@ -181,7 +196,7 @@ class VirtualClock
     // mode it processes IO events until IO is idle then advances to the time of
     // the next virtual event instantly.
 
-    VirtualClock(Mode mode = VIRTUAL_TIME);
+    VirtualClock(Mode mode = VIRTUAL_TIME, TimerBackend timers = TIMER_HEAP);
     ~VirtualClock();
     size_t crank(bool block = true);
     asio::io_context& getIOContext();
@@ -198,6 +213,9 @@ class VirtualClock
     system_time_point system_now() const noexcept;
 
     void enqueue(std::shared_ptr<VirtualClockEvent> ve);
+    // Takes a cancelled event out of the timer wheel; the heap drops cancelled
+    // events in flushCancelledEvents instead
+    void dequeue(VirtualClockEvent& ve);
     void flushCancelledEvents();
     bool cancelAllEvents();
 
@@ -220,6 +238,10 @@ class VirtualClock
     size_t getActionQueueSize() const;
     bool actionQueueIsOverloaded() const;
     Scheduler::ActionType currentSchedulerActionType() const;
+
+    // Like the Scheduler itself, these may only be used on the main thread.
+    Scheduler const& getActionScheduler() const;
+    void setActionSchedulerMetrics(medida::MetricsRegistry* metrics);
 };
 
 class VirtualClockEvent : public NonMovableOrCopyable
@@ -227,6 +249,12 @@ class VirtualClockEvent : public NonMovableOrCopyable
     std::function<void(asio::error_code)> mCallback;
     bool mTriggered;
 
+    // Position in the clock's TimerWheel, if any
+    friend class TimerWheel;
+    static constexpr size_t NOT_IN_WHEEL = std::numeric_limits<size_t>::max();
+    size_t mWheelSlot{NOT_IN_WHEEL};
+    size_t mWheelIndex{0};
+
   public:
     VirtualClock::time_point mWhen;
     size_t mSeq;
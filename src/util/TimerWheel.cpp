@@ -0,0 +1,304 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/TimerWheel.h"
+#include "util/GlobalChecks.h"
+#include "util/Timer.h"
+#include <algorithm>
+
+namespace stellar
+{
+
+namespace
+{
+size_t
+digit(uint64_t tick, size_t level)
+{
+    return (tick >> (level * TimerWheel::SLOT_BITS)) & (TimerWheel::SLOTS - 1);
+}
+
+// Level of the highest bit set in `diff`, which may be LEVELS or more
+size_t
+levelOf(uint64_t diff)
+{
+    size_t level = 0;
+    while ((diff >>= TimerWheel::SLOT_BITS) != 0)
+    {
+        ++level;
+    }
+    return level;
+}
+
+size_t
+lowestBit(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    size_t n = 0;
+    for (; (word & 1) == 0; word >>= 1)
+    {
+        ++n;
+    }
+    return n;
+#endif
+}
+}
+
+uint64_t
+TimerWheel::toTick(time_point t)
+{
+    auto ticks = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     t.time_since_epoch())
+                     .count() /
+                 TICK.count();
+    return ticks > 0 ? static_cast<uint64_t>(ticks) : 0;
+}
+
+void
+TimerWheel::markOccupied(size_t slot, bool occupied)
+{
+    if (slot == OVERFLOW_SLOT)
+    {
+        return;
+    }
+    auto& word = mOccupied[slot / SLOTS][(slot % SLOTS) / 64];
+    uint64_t bit = uint64_t(1) << (slot % 64);
+    word = occupied ? (word | bit) : (word & ~bit);
+}
+
+size_t
+TimerWheel::findSlot(size_t level, size_t from) const
+{
+    auto const& words = mOccupied[level];
+    for (size_t w = from / 64; w < words.size(); ++w)
+    {
+        uint64_t word = words[w];
+        if (w == from / 64)
+        {
+            word &= ~uint64_t(0) << (from % 64);
+        }
+        if (word != 0)
+        {
+            return w * 64 + lowestBit(word);
+        }
+    }
+    return SLOTS;
+}
+
+std::optional<std::pair<size_t, uint64_t>>
+TimerWheel::findEarliest() const
+{
+    // Events due in the current tick are in level 0 at its own digit; at
+    // higher levels they are always after the current digit
+    for (size_t level = 0; level < LEVELS; ++level)
+    {
+        size_t from = digit(mCurrentTick, level) + (level == 0 ? 0 : 1);
+        if (from >= SLOTS)
+        {
+            continue;
+        }
+        size_t s = findSlot(level, from);
+        if (s < SLOTS)
+        {
+            size_t shift = level * SLOT_BITS;
+            uint64_t above = mCurrentTick >> (shift + SLOT_BITS)
+                                                << (shift + SLOT_BITS);
+            return std::make_pair(level * SLOTS + s,
+                                  above | (uint64_t(s) << shift));
+        }
+    }
+    auto const& overflow = mSlots[OVERFLOW_SLOT];
+    if (overflow.empty())
+    {
+        return std::nullopt;
+    }
+    uint64_t first = UINT64_MAX;
+    for (auto const& ev : overflow)
+    {
+        first = std::min(first, toTick(ev->mWhen));
+    }
+    return std::make_pair(OVERFLOW_SLOT, first);
+}
+
+void
+TimerWheel::place(EventPtr ev)
+{
+    uint64_t tick = std::max(toTick(ev->mWhen), mCurrentTick);
+    size_t level = levelOf(tick ^ mCurrentTick);
+    size_t slot =
+        level < LEVELS ? level * SLOTS + digit(tick, level) : OVERFLOW_SLOT;
+    auto& events = mSlots[slot];
+    ev->mWheelSlot = slot;
+    ev->mWheelIndex = events.size();
+    events.emplace_back(std::move(ev));
+    markOccupied(slot, true);
+}
+
+void
+TimerWheel::removeAt(size_t slot, size_t index)
+{
+    auto& events = mSlots[slot];
+    releaseAssert(index < events.size());
+    events[index]->mWheelSlot = VirtualClockEvent::NOT_IN_WHEEL;
+    if (index + 1 != events.size())
+    {
+        events[index] = std::move(events.back());
+        events[index]->mWheelIndex = index;
+    }
+    events.pop_back();
+    if (events.empty())
+    {
+        markOccupied(slot, false);
+    }
+    --mSize;
+}
+
+void
+TimerWheel::insert(EventPtr ev, time_point now)
+{
+    releaseAssert(ev->mWheelSlot == VirtualClockEvent::NOT_IN_WHEEL);
+    if (mSize == 0)
+    {
+        // Nothing is filed relative to the current tick: skip ahead
+        mCurrentTick = std::max(mCurrentTick, toTick(now));
+    }
+    if (mNext && ev->mWhen < *mNext)
+    {
+        mNext = ev->mWhen;
+    }
+    place(std::move(ev));
+    ++mSize;
+}
+
+void
+TimerWheel::erase(VirtualClockEvent& ev)
+{
+    if (ev.mWheelSlot == VirtualClockEvent::NOT_IN_WHEEL)
+    {
+        return;
+    }
+    if (mNext && ev.mWhen == *mNext)
+    {
+        mNext.reset();
+    }
+    removeAt(ev.mWheelSlot, ev.mWheelIndex);
+}
+
+TimerWheel::time_point
+TimerWheel::next()
+{
+    if (mSize == 0)
+    {
+        return time_point::max();
+    }
+    if (!mNext)
+    {
+        auto earliest = findEarliest();
+        releaseAssert(earliest);
+        auto first = time_point::max();
+        for (auto const& ev : mSlots[earliest->first])
+        {
+            first = std::min(first, ev->mWhen);
+        }
+        mNext = first;
+    }
+    return *mNext;
+}
+
+void
+TimerWheel::advanceTo(uint64_t tick)
+{
+    if (tick <= mCurrentTick)
+    {
+        return;
+    }
+    size_t top = levelOf(tick ^ mCurrentTick);
+    mCurrentTick = tick;
+
+    auto refile = [&](size_t slot) {
+        auto events = std::move(mSlots[slot]);
+        mSlots[slot].clear();
+        markOccupied(slot, false);
+        for (auto& ev : events)
+        {
+            place(std::move(ev));
+        }
+    };
+    if (top >= LEVELS)
+    {
+        refile(OVERFLOW_SLOT);
+        top = LEVELS - 1;
+    }
+    for (size_t level = top; level >= 1; --level)
+    {
+        refile(level * SLOTS + digit(tick, level));
+    }
+}
+
+void
+TimerWheel::popDue(time_point now, std::vector<EventPtr>& due)
+{
+    size_t const firstDue = due.size();
+    uint64_t const nowTick = std::max(toTick(now), mCurrentTick);
+    while (auto earliest = findEarliest())
+    {
+        auto [slot, tick] = *earliest;
+        if (tick > nowTick)
+        {
+            break;
+        }
+        advanceTo(tick);
+        if (slot >= SLOTS)
+        {
+            // Its events were filed lower down
+            continue;
+        }
+
+        // A level 0 slot, for a single tick: all of it is due unless that
+        // tick is the current one
+        auto& events = mSlots[slot];
+        for (size_t i = events.size(); i-- > 0;)
+        {
+            if (events[i]->mWhen <= now)
+            {
+                due.emplace_back(events[i]);
+                removeAt(slot, i);
+            }
+        }
+        if (!events.empty())
+        {
+            break;
+        }
+    }
+    advanceTo(nowTick);
+
+    if (due.size() != firstDue)
+    {
+        mNext.reset();
+        std::sort(due.begin() + firstDue, due.end(),
+                  [](EventPtr const& a, EventPtr const& b) { return *b < *a; });
+    }
+}
+
+std::vector<TimerWheel::EventPtr>
+TimerWheel::clear()
+{
+    std::vector<EventPtr> res;
+    res.reserve(mSize);
+    for (size_t slot = 0; slot < NUM_SLOTS; ++slot)
+    {
+        for (auto& ev : mSlots[slot])
+        {
+            ev->mWheelSlot = VirtualClockEvent::NOT_IN_WHEEL;
+            res.emplace_back(std::move(ev));
+        }
+        mSlots[slot].clear();
+    }
+    mOccupied = {};
+    mSize = 0;
+    mNext.reset();
+    return res;
+}
+}
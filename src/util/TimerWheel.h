@@ -0,0 +1,91 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace stellar
+{
+
+class VirtualClockEvent;
+
+// The pending events of a VirtualClock created with TIMER_WHEEL: a
+// hierarchical timer wheel where arming and cancelling an event are O(1),
+// unlike the heap VirtualClock uses otherwise, where cancelled events linger
+// until the next batched flush.
+//
+// Events are filed by their expiry in ticks of TICK. An event due within the
+// 256 ticks after the current one sits in a level 0 slot for its tick; later
+// ones sit in coarser levels, each covering 256 times the span of the level
+// below, and move down as the wheel turns. The handful of events due more
+// than ~49 days ahead are kept unsorted in an overflow slot.
+class TimerWheel : public NonMovableOrCopyable
+{
+  public:
+    using time_point = std::chrono::steady_clock::time_point;
+    using EventPtr = std::shared_ptr<VirtualClockEvent>;
+
+    static constexpr std::chrono::milliseconds TICK{1};
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOTS = 1 << SLOT_BITS;
+
+    void insert(EventPtr ev, time_point now);
+    // Does nothing if `ev` is not in the wheel
+    void erase(VirtualClockEvent& ev);
+
+    bool
+    empty() const
+    {
+        return mSize == 0;
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+
+    // Expiry of the earliest event, or time_point::max() if there is none
+    time_point next();
+
+    // Moves the events due at `now` to `due`, in the order the heap would
+    // dispatch them
+    void popDue(time_point now, std::vector<EventPtr>& due);
+
+    // Empties the wheel, returning the events it held
+    std::vector<EventPtr> clear();
+
+  private:
+    static constexpr size_t OVERFLOW_SLOT = LEVELS * SLOTS;
+    static constexpr size_t NUM_SLOTS = OVERFLOW_SLOT + 1;
+
+    std::array<std::vector<EventPtr>, NUM_SLOTS> mSlots;
+    // Non-empty slots of each level, to find the next one quickly
+    std::array<std::array<uint64_t, SLOTS / 64>, LEVELS> mOccupied{};
+    uint64_t mCurrentTick{0};
+    size_t mSize{0};
+    // Cached result of next(), reset when that event leaves
+    std::optional<time_point> mNext;
+
+    static uint64_t toTick(time_point t);
+    void place(EventPtr ev);
+    void removeAt(size_t slot, size_t index);
+    void markOccupied(size_t slot, bool occupied);
+    // First non-empty slot of `level` at or after `from`, or SLOTS
+    size_t findSlot(size_t level, size_t from) const;
+    // First non-empty slot overall and the first tick it covers
+    std::optional<std::pair<size_t, uint64_t>> findEarliest() const;
+    // Moves the current tick forward, filing the events of the slots it
+    // enters at each level into the levels below
+    void advanceTo(uint64_t tick);
+};
+}
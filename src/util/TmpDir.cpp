@@ -10,7 +10,7 @@
 #include "util/Fs.h"
 #include "util/Logging.h"
 
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
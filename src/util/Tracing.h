@@ -0,0 +1,22 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// Include this rather than Tracy.hpp. In Tracy builds the zone macros are
+// Tracy's; otherwise ZoneScoped, ZoneScopedN and ZoneNamedN feed the
+// SpanRecorder instead of compiling to nothing. The other Tracy macros stay
+// no-ops.
+
+#include "util/SpanRecorder.h"
+#include <Tracy.hpp>
+
+#ifndef USE_TRACY
+#undef ZoneNamedN
+#undef ZoneScoped
+#undef ZoneScopedN
+#define ZoneNamedN(varname, name, active) STELLAR_SPAN(varname, name, active)
+#define ZoneScoped STELLAR_SPAN(___tracy_scoped_zone, nullptr, true)
+#define ZoneScopedN(name) STELLAR_SPAN(___tracy_scoped_zone, name, true)
+#endif
@@ -186,21 +186,29 @@ cereal_override(cereal::JSONOutputArchive& ar, const xdr::pointer<T>& t,
 
 namespace stellar
 {
+// Writes the same JSON as xdrToCerealString straight to os, without building
+// it as a string first. If compact = true, the output will not contain any
+// indentation.
+template <typename T>
+void
+xdrToCerealStream(std::ostream& os, const T& t, std::string const& name,
+                  bool compact = false)
+{
+    // Archives are designed to be used in an RAII manner and are guaranteed to
+    // flush their contents only on destruction.
+    cereal::JSONOutputArchive ar(
+        os, compact ? cereal::JSONOutputArchive::Options::NoIndent()
+                    : cereal::JSONOutputArchive::Options::Default());
+    xdr::archive(ar, t, name.c_str());
+}
+
 // If compact = true, the output string will not contain any indentation.
 template <typename T>
 std::string
 xdrToCerealString(const T& t, std::string const& name, bool compact = false)
 {
     std::stringstream os;
-
-    // Archives are designed to be used in an RAII manner and are guaranteed to
-    // flush their contents only on destruction.
-    {
-        cereal::JSONOutputArchive ar(
-            os, compact ? cereal::JSONOutputArchive::Options::NoIndent()
-                        : cereal::JSONOutputArchive::Options::Default());
-        xdr::archive(ar, t, name.c_str());
-    }
+    xdrToCerealStream(os, t, name, compact);
     return os.str();
 }
 }
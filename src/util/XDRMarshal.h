@@ -0,0 +1,176 @@
+#pragma once
+
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/GlobalChecks.h"
+#include <xdrpp/endian.h>
+#include <xdrpp/marshal.h>
+#include <xdrpp/message.h>
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace stellar
+{
+
+// True for the xvector and xarray types holding 32- or 64-bit integers (i.e.
+// int64 sequences such as the bucket list size window), whose encoding is a
+// plain run of big-endian words that can be byte-swapped in a single loop.
+template <typename T, typename = void>
+struct IsXDRIntegerContainer : std::false_type
+{
+};
+
+template <typename T>
+struct IsXDRIntegerContainer<
+    T, std::enable_if_t<xdr::xdr_traits<T>::is_container,
+                        std::void_t<typename T::value_type,
+                                    decltype(std::declval<T const&>().data())>>>
+    : std::bool_constant<
+          std::is_integral<typename T::value_type>::value &&
+          !std::is_same<typename T::value_type, bool>::value &&
+          (sizeof(typename T::value_type) == 4 ||
+           sizeof(typename T::value_type) == 8)>
+{
+};
+
+// Writes n integers to out, unaligned, in XDR (big-endian) byte order. The
+// loop has no dependency between iterations so that compilers turn it into
+// vector byte shuffles.
+template <typename Int>
+inline void
+xdrPutIntegers(Int const* in, size_t n, unsigned char* out)
+{
+    using UInt = std::make_unsigned_t<Int>;
+    for (size_t i = 0; i < n; ++i)
+    {
+        UInt u;
+        if constexpr (sizeof(UInt) == 4)
+        {
+            u = xdr::swap32le(static_cast<UInt>(in[i]));
+        }
+        else
+        {
+            u = xdr::swap64le(static_cast<UInt>(in[i]));
+        }
+        std::memcpy(out + i * sizeof(UInt), &u, sizeof(UInt));
+    }
+}
+
+// xdrpp-compatible archive serializing into a buffer that was sized with
+// xdr::xdr_argpack_size for the very values written. Where xdr::xdr_put
+// checks the space left before every field, this only checks once everything
+// is written, and it writes containers of integers in bulk.
+class XDRUncheckedPut
+{
+    unsigned char* mPos;
+    unsigned char const* const mEnd;
+
+    void
+    putBytes(void const* data, size_t len)
+    {
+        std::memcpy(mPos, data, len);
+        mPos += len;
+    }
+
+  public:
+    XDRUncheckedPut(void* start, void const* end)
+        : mPos(static_cast<unsigned char*>(start))
+        , mEnd(static_cast<unsigned char const*>(end))
+    {
+    }
+
+    // Asserts the values written filled the buffer exactly
+    void
+    done() const
+    {
+        releaseAssert(mPos == mEnd);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_same<
+        std::uint32_t, typename xdr::xdr_traits<T>::uint_type>::value>::type
+    operator()(T t)
+    {
+        auto u = xdr::swap32le(xdr::xdr_traits<T>::to_uint(t));
+        putBytes(&u, sizeof(u));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_same<
+        std::uint64_t, typename xdr::xdr_traits<T>::uint_type>::value>::type
+    operator()(T t)
+    {
+        auto u = xdr::swap64le(xdr::xdr_traits<T>::to_uint(t));
+        putBytes(&u, sizeof(u));
+    }
+
+    template <typename T>
+    typename std::enable_if<xdr::xdr_traits<T>::is_bytes>::type
+    operator()(T const& t)
+    {
+        size_t len = t.size();
+        if (xdr::xdr_traits<T>::variable_nelem)
+        {
+            (*this)(static_cast<uint32_t>(len));
+        }
+        if (len != 0)
+        {
+            putBytes(t.data(), len);
+            if (len & 3)
+            {
+                static unsigned char const pad[3] = {0};
+                putBytes(pad, 4 - (len & 3));
+            }
+        }
+    }
+
+    template <typename T>
+    typename std::enable_if<IsXDRIntegerContainer<T>::value>::type
+    operator()(T const& t)
+    {
+        if (xdr::xdr_traits<T>::variable_nelem)
+        {
+            (*this)(static_cast<uint32_t>(t.size()));
+        }
+        xdrPutIntegers(t.data(), t.size(), mPos);
+        mPos += t.size() * sizeof(typename T::value_type);
+    }
+
+    template <typename T>
+    typename std::enable_if<xdr::xdr_traits<T>::is_class ||
+                            (xdr::xdr_traits<T>::is_container &&
+                             !IsXDRIntegerContainer<T>::value)>::type
+    operator()(T const& t)
+    {
+        xdr::xdr_traits<T>::save(*this, t);
+    }
+};
+
+// Same output as xdr::xdr_to_opaque, written with XDRUncheckedPut
+template <typename... Args>
+xdr::opaque_vec<>
+xdrToOpaque(Args const&... args)
+{
+    xdr::opaque_vec<> res(xdr::xdr_argpack_size(args...));
+    XDRUncheckedPut p(res.data(), res.data() + res.size());
+    xdr::xdr_argpack_archive(p, args...);
+    p.done();
+    return res;
+}
+
+// Same output as xdr::xdr_to_msg, written with XDRUncheckedPut
+template <typename... Args>
+xdr::msg_ptr
+xdrToMsg(Args const&... args)
+{
+    xdr::msg_ptr res = xdr::message_t::alloc(xdr::xdr_argpack_size(args...));
+    XDRUncheckedPut p(res->data(), res->data() + res->size());
+    xdr::xdr_argpack_archive(p, args...);
+    p.done();
+    return res;
+}
+}
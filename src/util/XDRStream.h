@@ -5,15 +5,20 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "crypto/ByteSlice.h"
+#include "crypto/PipelinedSHA256.h"
 #include "crypto/SHA.h"
 #include "util/FileSystemException.h"
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/MappedFile.h"
+#include "util/Tracing.h"
+#include "util/XDRMarshal.h"
 #include "util/types.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <string>
@@ -31,10 +36,13 @@ namespace stellar
  */
 class XDRInputFileStream
 {
+    // Declared before mIn, which may use it as its file buffer
+    std::vector<char> mReadBuf;
     std::ifstream mIn;
     std::vector<char> mBuf;
     size_t mSizeLimit;
     size_t mSize;
+    size_t mBytesRead{0};
 
   public:
     XDRInputFileStream(unsigned int sizeLimit = 0)
@@ -49,6 +57,17 @@ class XDRInputFileStream
         mIn.close();
     }
 
+    // Replaces the file buffer of the underlying stream with one of
+    // bufferSize bytes, so long sequential scans issue fewer, larger reads.
+    // Must be called before open.
+    void
+    setReadBufferSize(size_t bufferSize)
+    {
+        releaseAssertOrThrow(!mIn.is_open());
+        mReadBuf.resize(bufferSize);
+        mIn.rdbuf()->pubsetbuf(mReadBuf.data(), mReadBuf.size());
+    }
+
     void
     open(std::string const& filename)
     {
@@ -84,6 +103,13 @@ class XDRInputFileStream
         return mSize;
     }
 
+    // Number of bytes readOne and readPage read from the file so far
+    size_t
+    bytesRead() const
+    {
+        return mBytesRead;
+    }
+
     std::streamoff
     pos()
     {
@@ -133,6 +159,7 @@ class XDRInputFileStream
                 throw xdr::xdr_runtime_error("IO failure in readOne");
             }
         }
+        mBytesRead += 4;
 
         auto sz = getXDRSize(szBuf);
         if (mSizeLimit != 0 && sz > mSizeLimit)
@@ -148,12 +175,44 @@ class XDRInputFileStream
             throw xdr::xdr_runtime_error(
                 "malformed XDR file or IO failure in readOne");
         }
+        mBytesRead += sz;
 
         xdr::xdr_get g(mBuf.data(), mBuf.data() + sz);
         xdr::xdr_argpack_archive(g, out);
         return true;
     }
 
+    // Advances the stream past the next record without decoding it. Returns
+    // false on EOF.
+    bool
+    skipOne()
+    {
+        ZoneScoped;
+        char szBuf[4];
+        if (!mIn.read(szBuf, 4))
+        {
+            if (mIn.eof() && mIn.gcount() == 0)
+            {
+                mIn.clear(std::ios_base::eofbit);
+                return false;
+            }
+            else
+            {
+                throw xdr::xdr_runtime_error("IO failure in skipOne");
+            }
+        }
+
+        auto sz = getXDRSize(szBuf);
+        if (static_cast<size_t>(mIn.tellg()) + sz > mSize)
+        {
+            throw xdr::xdr_runtime_error(
+                "malformed XDR file or IO failure in skipOne");
+        }
+
+        mIn.seekg(sz, std::ios_base::cur);
+        return true;
+    }
+
     // `readPage` reads records of XDR type `T` from the stream into output
     // variable `out`, until it has exceeded `pageSize` bytes or until it finds
     // an `out` value for which `getBucketLedgerKey(out) == key`. It returns
@@ -183,6 +242,7 @@ class XDRInputFileStream
                 throw xdr::xdr_runtime_error("IO failure in readPage");
             }
         }
+        mBytesRead += mBuf.size();
 
         size_t xdrStart = 0;
         while (xdrStart + 4 <= mBuf.size())
@@ -205,6 +265,7 @@ class XDRInputFileStream
                     throw xdr::xdr_runtime_error(
                         "malformed XDR file or IO failure in readPage");
                 }
+                mBytesRead += extraSz;
             }
 
             ZoneNamedN(__unpack, "xdr_unpack_entry", true);
@@ -224,6 +285,105 @@ class XDRInputFileStream
     }
 };
 
+/**
+ * Helper for loading XDR objects at arbitrary offsets of an immutable file via
+ * a read-only memory mapping. Unlike XDRInputFileStream, objects are decoded
+ * directly out of the page cache without an intermediate copy, and the reader
+ * is stateless so there is no stream position to seek.
+ */
+class XDRInputMappedFile
+{
+    MappedFile mFile;
+
+    uint32_t
+    getXDRSizeAt(size_t pos) const
+    {
+        char szBuf[4];
+        std::memcpy(szBuf, mFile.data() + pos, 4);
+        return XDRInputFileStream::getXDRSize(szBuf);
+    }
+
+  public:
+    explicit XDRInputMappedFile(std::filesystem::path const& filename)
+        : mFile(filename.string())
+    {
+        mFile.adviseRandom();
+    }
+
+    size_t
+    size() const
+    {
+        return mFile.size();
+    }
+
+    // Decodes the XDR record starting at pos into out. Returns false if pos is
+    // at EOF. bytesTouched is incremented by the number of mapped bytes read.
+    template <typename T>
+    bool
+    readOneAt(size_t pos, T& out, size_t& bytesTouched) const
+    {
+        ZoneScoped;
+        if (pos + 4 > mFile.size())
+        {
+            if (pos == mFile.size())
+            {
+                return false;
+            }
+            throw xdr::xdr_runtime_error("malformed XDR file in readOneAt");
+        }
+
+        size_t const xdrStart = pos + 4;
+        size_t const xdrEnd = xdrStart + getXDRSizeAt(pos);
+        if (xdrEnd > mFile.size())
+        {
+            throw xdr::xdr_runtime_error("malformed XDR file in readOneAt");
+        }
+
+        xdr::xdr_get g(mFile.data() + xdrStart, mFile.data() + xdrEnd);
+        xdr::xdr_argpack_archive(g, out);
+        bytesTouched += xdrEnd - pos;
+        return true;
+    }
+
+    // Equivalent to XDRInputFileStream::readPage starting at offset pos:
+    // decodes records until it has passed pageSize bytes or finds a record for
+    // which `getBucketLedgerKey(out) == key`, in which case it returns true.
+    // bytesTouched is incremented by the number of mapped bytes read.
+    template <typename T>
+    bool
+    readPageAt(size_t pos, T& out, LedgerKey const& key, size_t pageSize,
+               size_t& bytesTouched) const
+    {
+        ZoneScoped;
+        size_t const pageEnd = std::min(pos + pageSize, mFile.size());
+        mFile.adviseWillNeed(pos, pageEnd - pos);
+
+        size_t xdrStart = pos;
+        while (xdrStart + 4 <= pageEnd)
+        {
+            size_t const xdrEnd = xdrStart + 4 + getXDRSizeAt(xdrStart);
+            if (xdrEnd > mFile.size())
+            {
+                throw xdr::xdr_runtime_error(
+                    "malformed XDR file in readPageAt");
+            }
+
+            ZoneNamedN(__unpack, "xdr_unpack_entry", true);
+            xdr::xdr_get g(mFile.data() + xdrStart + 4, mFile.data() + xdrEnd);
+            xdr::xdr_argpack_archive(g, out);
+            bytesTouched += xdrEnd - xdrStart;
+            if (getBucketLedgerKey(out) == key)
+            {
+                return true;
+            }
+
+            xdrStart = xdrEnd;
+        }
+
+        return false;
+    }
+};
+
 // XDROutputFileStream needs access to a file descriptor to do fsync, so we use
 // asio's synchronous stream types here rather than fstreams.
 class XDROutputFileStream
@@ -377,49 +537,59 @@ class XDROutputFileStream
         return isOpen();
     }
 
+    // Serializes t into buf as a single record, size prefix included, and
+    // returns the size of the record at the front of buf. The record can then
+    // be written to any number of streams with writeSerialized.
     template <typename T>
-    void
-    writeOne(T const& t, SHA256* hasher = nullptr, size_t* bytesPut = nullptr)
+    static size_t
+    serializeRecord(T const& t, std::vector<char>& buf)
     {
         ZoneScoped;
-        if (!isOpen())
-        {
-            FileSystemException::failWith(
-                "XDROutputFileStream::writeOne() on non-open stream");
-        }
-
         uint32_t sz = (uint32_t)xdr::xdr_size(t);
         releaseAssertOrThrow(sz < 0x80000000);
 
-        if (mBuf.size() < sz + 4)
+        if (buf.size() < sz + 4)
         {
-            mBuf.resize(sz + 4);
+            buf.resize(sz + 4);
         }
 
         // Write 4 bytes of size, big-endian, with XDR 'continuation' bit set on
         // high bit of high byte.
-        mBuf[0] = static_cast<char>((sz >> 24) & 0xFF) | '\x80';
-        mBuf[1] = static_cast<char>((sz >> 16) & 0xFF);
-        mBuf[2] = static_cast<char>((sz >> 8) & 0xFF);
-        mBuf[3] = static_cast<char>(sz & 0xFF);
-        xdr::xdr_put p(mBuf.data() + 4, mBuf.data() + 4 + sz);
-        xdr_argpack_archive(p, t);
-
-        size_t const to_write = sz + 4;
+        buf[0] = static_cast<char>((sz >> 24) & 0xFF) | '\x80';
+        buf[1] = static_cast<char>((sz >> 16) & 0xFF);
+        buf[2] = static_cast<char>((sz >> 8) & 0xFF);
+        buf[3] = static_cast<char>(sz & 0xFF);
+        XDRUncheckedPut p(buf.data() + 4, buf.data() + 4 + sz);
+        xdr::xdr_argpack_archive(p, t);
+        p.done();
+        return sz + 4;
+    }
+
+    // Writes a record produced by serializeRecord to the stream
+    void
+    writeSerialized(char const* data, size_t size)
+    {
+        ZoneScoped;
+        if (!isOpen())
+        {
+            FileSystemException::failWith(
+                "XDROutputFileStream::writeSerialized() on non-open stream");
+        }
+
         size_t written = 0;
-        while (written < to_write)
+        while (written < size)
         {
 #ifdef WIN32
-            auto w = fwrite(mBuf.data() + written, 1, to_write - written, mOut);
+            auto w = fwrite(data + written, 1, size - written, mOut);
             if (w == 0)
             {
-                FileSystemException::failWith(
-                    std::string("XDROutputFileStream::writeOne() failed"));
+                FileSystemException::failWith(std::string(
+                    "XDROutputFileStream::writeSerialized() failed"));
             }
             written += w;
 #else
             asio::error_code ec;
-            auto buf = asio::buffer(mBuf.data() + written, to_write - written);
+            auto buf = asio::buffer(data + written, size - written);
             written += asio::write(mBufferedWriteStream, buf, ec);
             if (ec)
             {
@@ -430,20 +600,59 @@ class XDROutputFileStream
                 else
                 {
                     FileSystemException::failWith(
-                        std::string(
-                            "XDROutputFileStream::writeOne() failed: ") +
+                        std::string("XDROutputFileStream::writeSerialized() "
+                                    "failed: ") +
                         ec.message());
                 }
             }
 #endif
         }
+    }
+
+  private:
+    // Serializes t into mBuf and writes it to the stream. Returns the number
+    // of bytes written, i.e. the size of the record at the front of mBuf.
+    template <typename T>
+    size_t
+    writeRecord(T const& t)
+    {
+        ZoneScoped;
+        if (!isOpen())
+        {
+            FileSystemException::failWith(
+                "XDROutputFileStream::writeOne() on non-open stream");
+        }
+
+        size_t const sz = serializeRecord(t, mBuf);
+        writeSerialized(mBuf.data(), sz);
+        return sz;
+    }
+
+  public:
+    template <typename T>
+    void
+    writeOne(T const& t, SHA256* hasher = nullptr, size_t* bytesPut = nullptr)
+    {
+        auto sz = writeRecord(t);
         if (hasher)
         {
-            hasher->add(ByteSlice(mBuf.data(), sz + 4));
+            hasher->add(ByteSlice(mBuf.data(), sz));
         }
         if (bytesPut)
         {
-            *bytesPut += (sz + 4);
+            *bytesPut += sz;
+        }
+    }
+
+    template <typename T>
+    void
+    writeOne(T const& t, PipelinedSHA256& hasher, size_t* bytesPut = nullptr)
+    {
+        auto sz = writeRecord(t);
+        hasher.add(ByteSlice(mBuf.data(), sz));
+        if (bytesPut)
+        {
+            *bytesPut += sz;
         }
     }
 };
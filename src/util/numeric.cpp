@@ -11,6 +11,44 @@
 
 namespace stellar
 {
+namespace
+{
+#ifdef USE_BUILTIN_UINT128
+// Divides the 128-bit value hi:lo by d, returning the quotient and setting
+// `rem` to the remainder. d must be larger than hi, so that the quotient fits
+// in 64 bits.
+inline uint64_t
+divide128By64(uint64_t hi, uint64_t lo, uint64_t d, uint64_t& rem)
+{
+#if defined(__x86_64__)
+    // A single hardware division, where dividing unsigned __int128 calls a
+    // 128 by 128-bit division routine
+    uint64_t q;
+    __asm__("divq %[d]" : "=a"(q), "=d"(rem) : [d] "rm"(d), "a"(lo), "d"(hi));
+    return q;
+#else
+    auto x = (static_cast<unsigned __int128>(hi) << 64) | lo;
+    rem = static_cast<uint64_t>(x % d);
+    return static_cast<uint64_t>(x / d);
+#endif
+}
+
+// bigDivideUnsigned128 of hi:lo by d when d is larger than hi, with the same
+// result in every case
+inline bool
+bigDivideUnsignedFast(uint64_t& result, uint64_t hi, uint64_t lo, uint64_t d,
+                      Rounding rounding)
+{
+    uint64_t rem;
+    uint64_t q = divide128By64(hi, lo, d, rem);
+    // Rounding up overflows (to 0, as the quotient truncated to 64 bits
+    // would) only if q is UINT64_MAX
+    result = q + static_cast<uint64_t>((rounding == ROUND_UP) & (rem != 0));
+    return result >= q;
+}
+#endif
+}
+
 // calculates A*B/C when A*B overflows 64bits
 bool
 bigDivide(int64_t& result, int64_t A, int64_t B, int64_t C, Rounding rounding)
@@ -34,6 +72,16 @@ bigDivideUnsigned(uint64_t& result, uint64_t A, uint64_t B, uint64_t C,
 {
     releaseAssertOrThrow(C > 0);
 
+#ifdef USE_BUILTIN_UINT128
+    auto ab = static_cast<unsigned __int128>(A) * B;
+    auto hi = static_cast<uint64_t>(ab >> 64);
+    if (hi < C)
+    {
+        return bigDivideUnsignedFast(result, hi, static_cast<uint64_t>(ab), C,
+                                     rounding);
+    }
+#endif
+
     // update when moving to (signed) int128
     uint128_t a(A);
     uint128_t b(B);
@@ -76,6 +124,17 @@ bigDivideUnsigned128(uint64_t& result, uint128_t const& a, uint64_t B,
 {
     releaseAssertOrThrow(B != 0);
 
+#ifdef USE_BUILTIN_UINT128
+    // Also skips the overflow check below, as a < B * 2^64 implies
+    // a <= UINT128_MAX - (B - 1)
+    auto hi = static_cast<uint64_t>(a >> 64);
+    if (hi < B)
+    {
+        return bigDivideUnsignedFast(result, hi, static_cast<uint64_t>(a), B,
+                                     rounding);
+    }
+#endif
+
     // update when moving to (signed) int128
     uint128_t b(B);
 
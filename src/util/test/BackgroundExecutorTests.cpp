@@ -0,0 +1,165 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/BackgroundExecutor.h"
+
+#include "lib/catch.hpp"
+#include "util/Thread.h"
+#include <chrono>
+#include <future>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
+#include <set>
+
+using namespace stellar;
+
+namespace
+{
+// Occupies a worker until the returned promise is fulfilled
+std::promise<void>
+blockWorker(BackgroundExecutor& executor, std::optional<size_t> affinity)
+{
+    std::promise<void> release;
+    std::promise<void> started;
+    auto released = release.get_future().share();
+    executor.post(
+        [&started, released]() {
+            started.set_value();
+            released.wait();
+        },
+        "test: block", BackgroundPriority::HIGH, affinity);
+    started.get_future().wait();
+    return release;
+}
+}
+
+TEST_CASE("background executor runs more urgent jobs first",
+          "[backgroundexecutor]")
+{
+    medida::MetricsRegistry metrics;
+    BackgroundExecutor executor(1, metrics);
+    auto release = blockWorker(executor, std::nullopt);
+
+    std::vector<std::string> order;
+    executor.post([&]() { order.emplace_back("low"); }, "test: low",
+                  BackgroundPriority::LOW);
+    executor.post([&]() { order.emplace_back("normal"); }, "test: normal",
+                  BackgroundPriority::NORMAL);
+    executor.post([&]() { order.emplace_back("high"); }, "test: high",
+                  BackgroundPriority::HIGH);
+    executor.post([&]() { order.emplace_back("normal 2"); }, "test: normal",
+                  BackgroundPriority::NORMAL);
+
+    release.set_value();
+    executor.shutdown();
+    REQUIRE(order == std::vector<std::string>{"high", "normal", "normal 2",
+                                              "low"});
+
+    CHECK(metrics.NewTimer({"app", "background-wait", "high"}).count() == 2);
+    CHECK(metrics.NewTimer({"app", "background-wait", "normal"}).count() ==
+          2);
+    CHECK(metrics.NewTimer({"app", "background-wait", "low"}).count() == 1);
+    CHECK(metrics.NewTimer({"app", "background-job-wait", "test-normal"})
+              .count() == 2);
+}
+
+TEST_CASE("background executor steals jobs from busy workers",
+          "[backgroundexecutor]")
+{
+    medida::MetricsRegistry metrics;
+    BackgroundExecutor executor(2, metrics);
+    auto release = blockWorker(executor, 0);
+
+    // Half of these are queued on the blocked worker
+    size_t const n = 20;
+    std::atomic<size_t> done{0};
+    for (size_t i = 0; i < n; ++i)
+    {
+        executor.post([&]() { ++done; }, "test: job");
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (done < n && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(done == n);
+
+    release.set_value();
+    executor.shutdown();
+}
+
+TEST_CASE("background executor keeps jobs on their worker",
+          "[backgroundexecutor]")
+{
+    medida::MetricsRegistry metrics;
+    BackgroundExecutor executor(4, metrics);
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        executor.post(
+            [&, i]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.emplace(std::this_thread::get_id());
+                order.emplace_back(i);
+            },
+            "test: pinned", BackgroundPriority::NORMAL, 6);
+    }
+    executor.shutdown();
+
+    CHECK(threads.size() == 1);
+    REQUIRE(order.size() == 100);
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        CHECK(order[i] == i);
+    }
+}
+
+TEST_CASE("background executor runs jobs posted by jobs before shutdown",
+          "[backgroundexecutor]")
+{
+    medida::MetricsRegistry metrics;
+    BackgroundExecutor executor(2, metrics);
+
+    std::atomic<size_t> done{0};
+    for (size_t i = 0; i < 10; ++i)
+    {
+        executor.post(
+            [&]() {
+                executor.post([&]() { ++done; }, "test: child");
+                ++done;
+            },
+            "test: parent");
+    }
+    executor.shutdown();
+    CHECK(done == 20);
+}
+
+#ifdef __linux__
+TEST_CASE("background executor pins workers to CPUs", "[backgroundexecutor]")
+{
+    medida::MetricsRegistry metrics;
+    BackgroundExecutor executor(2, metrics, {0});
+
+    std::promise<std::vector<uint32_t>> allowed;
+    executor.post(
+        [&]() {
+            for (auto const& role : getThreadRoles())
+            {
+                if (role.mRole == "worker" && role.mLastCpu)
+                {
+                    allowed.set_value(role.mAllowedCpus);
+                    return;
+                }
+            }
+            allowed.set_value({});
+        },
+        "test: roles");
+    CHECK(allowed.get_future().get() == std::vector<uint32_t>{0});
+    executor.shutdown();
+}
+#endif
@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "lib/catch.hpp"
+#include "util/Math.h"
 #include "util/numeric128.h"
 #include "util/types.h"
 #include <functional>
@@ -499,3 +500,69 @@ TEST_CASE("huge divide", "[bigdivide]")
         checkHugeFail(1 << 29, UINT128_MAX, maxC, ROUND_UP);
     }
 }
+
+TEST_CASE("bigDivide matches portable 128-bit arithmetic", "[bigdivide]")
+{
+    // The results must not depend on whether the native 128-bit division
+    // fast path is taken, so compare them with the arithmetic of uint128_t
+    // without compiler support
+    using Portable = large_int::detail_delegate<false>;
+    auto portableDivide = [](uint64_t& result, uint128_t a, uint64_t b,
+                             Rounding rounding) {
+        uint128_t x =
+            rounding == ROUND_DOWN
+                ? Portable::div(a, uint128_t(b))
+                : Portable::div(a + uint128_t(b) - 1u, uint128_t(b));
+        result = static_cast<uint64_t>(x);
+        return x <= UINT64_MAX;
+    };
+
+    std::vector<uint64_t> values{0,
+                                 1,
+                                 2,
+                                 3,
+                                 UINT32_MAX - 1ull,
+                                 UINT32_MAX,
+                                 UINT32_MAX + 1ull,
+                                 static_cast<uint64_t>(INT64_MAX) - 1,
+                                 static_cast<uint64_t>(INT64_MAX),
+                                 static_cast<uint64_t>(INT64_MAX) + 1,
+                                 UINT64_MAX - 1,
+                                 UINT64_MAX};
+    for (size_t i = 0; i < 40; ++i)
+    {
+        auto v = rand_uniform<uint64_t>(0, UINT64_MAX);
+        values.emplace_back(v >> rand_uniform<uint32_t>(0, 63));
+    }
+
+    for (auto a : values)
+    {
+        for (auto b : values)
+        {
+            auto ab = Portable::imul(uint128_t(a), uint128_t(b));
+            for (auto c : values)
+            {
+                if (c == 0)
+                {
+                    continue;
+                }
+                for (auto rounding : {ROUND_DOWN, ROUND_UP})
+                {
+                    uint64_t expected = 0;
+                    bool expectedRes =
+                        portableDivide(expected, ab, c, rounding);
+
+                    uint64_t res = 0;
+                    REQUIRE(bigDivideUnsigned(res, a, b, c, rounding) ==
+                            expectedRes);
+                    REQUIRE(res == expected);
+
+                    uint64_t res128 = 0;
+                    REQUIRE(bigDivideUnsigned128(res128, ab, c, rounding) ==
+                            expectedRes);
+                    REQUIRE(res128 == expected);
+                }
+            }
+        }
+    }
+}
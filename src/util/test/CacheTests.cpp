@@ -4,6 +4,7 @@
 
 #include "lib/catch.hpp"
 #include "util/RandomEvictionCache.h"
+#include "util/SegmentedLRUCache.h"
 #include <ctime>
 #include <map>
 
@@ -152,8 +153,9 @@ TEST_CASE("RandomEvictionCache does not thrash",
 }
 
 using RandCache = RandomEvictionCache<int, int>;
+using SLRUCache = SegmentedLRUCache<int, int>;
 
-TEMPLATE_TEST_CASE("cache empty", "[cache][template]", RandCache)
+TEMPLATE_TEST_CASE("cache empty", "[cache][template]", RandCache, SLRUCache)
 {
     TestType c{5};
 
@@ -161,7 +163,7 @@ TEMPLATE_TEST_CASE("cache empty", "[cache][template]", RandCache)
 }
 
 TEMPLATE_TEST_CASE("cache keeps most added items", "[cache][template]",
-                   RandCache)
+                   RandCache, SLRUCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -189,7 +191,7 @@ TEMPLATE_TEST_CASE("cache keeps most added items", "[cache][template]",
 }
 
 TEMPLATE_TEST_CASE("cache keeps last read items", "[cache][template]",
-                   RandCache)
+                   RandCache, SLRUCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -213,7 +215,7 @@ TEMPLATE_TEST_CASE("cache keeps last read items", "[cache][template]",
 }
 
 TEMPLATE_TEST_CASE("cache keeps last read items with maybeGet",
-                   "[cache][template]", RandCache)
+                   "[cache][template]", RandCache, SLRUCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -236,7 +238,8 @@ TEMPLATE_TEST_CASE("cache keeps last read items with maybeGet",
     REQUIRE(existing == 5);
 }
 
-TEMPLATE_TEST_CASE("cache replace element", "[cache][template]", RandCache)
+TEMPLATE_TEST_CASE("cache replace element", "[cache][template]", RandCache,
+                   SLRUCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -264,7 +267,7 @@ TEMPLATE_TEST_CASE("cache replace element", "[cache][template]", RandCache)
 }
 
 TEMPLATE_TEST_CASE("cache erase_if removes some nodes", "[cache][template]",
-                   RandCache)
+                   RandCache, SLRUCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -283,7 +286,7 @@ TEMPLATE_TEST_CASE("cache erase_if removes some nodes", "[cache][template]",
 }
 
 TEMPLATE_TEST_CASE("cache erase_if removes no nodes", "[cache][template]",
-                   RandCache)
+                   RandCache, SLRUCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -302,7 +305,7 @@ TEMPLATE_TEST_CASE("cache erase_if removes no nodes", "[cache][template]",
 }
 
 TEMPLATE_TEST_CASE("cache erase_if removes all nodes", "[cache][template]",
-                   RandCache)
+                   RandCache, SLRUCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -319,3 +322,201 @@ TEMPLATE_TEST_CASE("cache erase_if removes all nodes", "[cache][template]",
     REQUIRE(!c.exists(3));
     REQUIRE(!c.exists(4));
 }
+
+TEMPLATE_TEST_CASE("cache erase removes single nodes", "[cache][template]",
+                   RandCache, SLRUCache)
+{
+    TestType c{5};
+    c.put(0, 0);
+    c.put(1, 1);
+    c.put(2, 2);
+    c.put(3, 3);
+    c.put(4, 4);
+
+    REQUIRE(c.erase(0));
+    REQUIRE(!c.erase(0));
+    REQUIRE(c.erase(3));
+    REQUIRE(!c.erase(5));
+
+    REQUIRE(c.size() == 3);
+    REQUIRE(!c.exists(0));
+    REQUIRE(c.exists(1));
+    REQUIRE(c.exists(2));
+    REQUIRE(!c.exists(3));
+    REQUIRE(c.exists(4));
+
+    // Cache keeps working after erasing and evicting
+    uint64_t erased = 2;
+    for (int i = 5; i < 20; ++i)
+    {
+        c.put(i, i);
+        if (i % 3 == 0 && c.erase(i))
+        {
+            ++erased;
+            REQUIRE(!c.exists(i));
+        }
+    }
+    REQUIRE(c.size() <= 5);
+    REQUIRE(c.getCounters().mErases == erased);
+}
+
+TEST_CASE("SegmentedLRUCache resists scans", "[segmentedlrucache]")
+{
+    size_t sz = 100;
+    SegmentedLRUCache<int, int> cache(sz);
+    auto const& ctrs = cache.getCounters();
+
+    // Read a hot set twice so that it is protected
+    int hot = 50;
+    for (int i = 0; i < hot; ++i)
+    {
+        cache.put(i, i);
+        REQUIRE(cache.get(i) == i);
+    }
+    REQUIRE(ctrs.mPromotions == static_cast<uint64_t>(hot));
+
+    // A scan of many more entries than fit, each used once, only cycles
+    // through the probationary segment
+    for (int i = 1000; i < 2000; ++i)
+    {
+        cache.put(i, i);
+    }
+    REQUIRE(cache.size() == sz);
+    for (int i = 0; i < hot; ++i)
+    {
+        REQUIRE(cache.exists(i));
+    }
+    REQUIRE(ctrs.mEvicts == 1000 + hot - sz);
+}
+
+TEST_CASE("SegmentedLRUCache protected segment demotes", "[segmentedlrucache]")
+{
+    // 10 entries, at most 5 protected
+    SegmentedLRUCache<int, int> cache(10, {10}, 0.5);
+    for (int i = 0; i < 10; ++i)
+    {
+        cache.put(i, i);
+        cache.get(i);
+    }
+
+    // 0 to 4 were demoted back to probation when 5 to 9 were promoted, so
+    // they are the first to go
+    for (int i = 10; i < 15; ++i)
+    {
+        cache.put(i, i);
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        REQUIRE(!cache.exists(i, false));
+    }
+    for (int i = 5; i < 15; ++i)
+    {
+        REQUIRE(cache.exists(i, false));
+    }
+}
+
+namespace
+{
+struct ParityPartition
+{
+    size_t
+    operator()(int k) const
+    {
+        return static_cast<size_t>(k % 2);
+    }
+};
+}
+
+TEST_CASE("SegmentedLRUCache partition quotas", "[segmentedlrucache]")
+{
+    // Even keys may take the whole cache, odd keys only a fifth of it
+    SegmentedLRUCache<int, int, std::hash<int>, ParityPartition> cache(
+        100, {100, 20});
+    for (int i = 0; i < 100; i += 2)
+    {
+        cache.put(i, i);
+    }
+
+    // Odd keys evict each other once they reach their quota
+    for (int i = 1; i < 1000; i += 2)
+    {
+        cache.put(i, i);
+    }
+    REQUIRE(cache.size() == 70);
+    REQUIRE(cache.getCounters(0).mEvicts == 0);
+    REQUIRE(cache.getCounters(1).mEvicts == 500 - 20);
+    for (int i = 0; i < 100; i += 2)
+    {
+        REQUIRE(cache.exists(i));
+    }
+    for (int i = 1000 - 2 * 20 + 1; i < 1000; i += 2)
+    {
+        REQUIRE(cache.exists(i));
+    }
+
+    // Once the cache is full, the least recently used probationary entry of
+    // any partition goes
+    for (int i = 100; i < 160; i += 2)
+    {
+        cache.put(i, i);
+    }
+    REQUIRE(cache.size() == 100);
+    REQUIRE(cache.getCounters(0).mEvicts == 0);
+    cache.put(160, 160);
+    REQUIRE(cache.size() == 100);
+    REQUIRE(!cache.exists(0, false));
+    REQUIRE(cache.getCounters(0).mEvicts == 1);
+    REQUIRE(cache.getCounters().mEvicts == 500 - 20 + 1);
+}
+
+TEMPLATE_TEST_CASE("cache resizes", "[cache][template]", RandCache, SLRUCache)
+{
+    TestType c{100};
+    for (int i = 0; i < 100; ++i)
+    {
+        c.put(i, i);
+    }
+
+    c.setMaxSize(10);
+    REQUIRE(c.maxSize() == 10);
+    REQUIRE(c.size() == 10);
+    REQUIRE(c.getCounters().mEvicts == 90);
+    c.put(100, 100);
+    REQUIRE(c.size() == 10);
+
+    // Growing back keeps what is cached and makes room for more
+    c.setMaxSize(100);
+    for (int i = 200; i < 290; ++i)
+    {
+        c.put(i, i);
+    }
+    REQUIRE(c.size() == 100);
+    REQUIRE(c.exists(100));
+}
+
+TEST_CASE("SegmentedLRUCache resize scales partition quotas",
+          "[segmentedlrucache]")
+{
+    SegmentedLRUCache<int, int, std::hash<int>, ParityPartition> cache(
+        100, {100, 20});
+    cache.setMaxSize(50);
+
+    // Odd keys now get a fifth of the smaller cache
+    for (int i = 1; i < 100; i += 2)
+    {
+        cache.put(i, i);
+    }
+    REQUIRE(cache.size() == 10);
+    for (int i = 0; i < 100; i += 2)
+    {
+        cache.put(i, i);
+    }
+    REQUIRE(cache.size() == 50);
+
+    cache.setMaxSize(100);
+    for (int i = 101; i < 200; i += 2)
+    {
+        cache.put(i, i);
+    }
+    REQUIRE(cache.size() == 70);
+}
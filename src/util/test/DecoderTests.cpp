@@ -63,6 +63,21 @@ TEST_CASE("encode_b32", "[decoder]")
     }
 }
 
+TEST_CASE("base32 basen identity", "[decoder]")
+{
+    autocheck::generator<std::vector<uint8_t>> input;
+    for (int s = 0; s < 100; s++)
+    {
+        std::vector<uint8_t> in(input(s));
+
+        std::string encoded = decoder::encode_b32(in);
+        std::string bnEncoded;
+        bn::encode_b32(in.begin(), in.end(), std::back_inserter(bnEncoded));
+
+        REQUIRE(encoded == bnEncoded);
+    }
+}
+
 TEST_CASE("encode_b64", "[decoder]")
 {
     for (auto const& item : b64_data)
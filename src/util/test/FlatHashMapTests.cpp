@@ -0,0 +1,204 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "util/FlatHashMap.h"
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using namespace stellar;
+
+namespace
+{
+// Maps keys onto a handful of hashes to force long probe sequences
+struct CollidingHash
+{
+    size_t
+    operator()(int k) const
+    {
+        return static_cast<size_t>(k % 7);
+    }
+};
+
+// Key that counts how often keys are copied
+struct CountedKey
+{
+    static size_t copies;
+    int k;
+
+    CountedKey(int k) : k(k)
+    {
+    }
+
+    CountedKey(CountedKey const& other) : k(other.k)
+    {
+        ++copies;
+    }
+
+    CountedKey(CountedKey&&) = default;
+
+    bool
+    operator==(CountedKey const& other) const
+    {
+        return k == other.k;
+    }
+};
+size_t CountedKey::copies = 0;
+
+struct CountedKeyHash
+{
+    size_t
+    operator()(CountedKey const& key) const
+    {
+        return std::hash<int>()(key.k);
+    }
+};
+
+template <class Map>
+void
+checkSame(Map const& map, std::unordered_map<int, std::string> const& ref)
+{
+    REQUIRE(map.size() == ref.size());
+    size_t seen = 0;
+    for (auto const& kv : map)
+    {
+        auto it = ref.find(kv.first);
+        REQUIRE(it != ref.end());
+        REQUIRE(it->second == kv.second);
+        ++seen;
+    }
+    REQUIRE(seen == ref.size());
+    for (auto const& kv : ref)
+    {
+        auto it = map.find(kv.first);
+        REQUIRE(it != map.end());
+        REQUIRE(it->second == kv.second);
+    }
+}
+
+template <class Map>
+void
+randomOps(size_t keySpace)
+{
+    Map map;
+    std::unordered_map<int, std::string> ref;
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> keys(0, static_cast<int>(keySpace));
+    std::uniform_int_distribution<int> ops(0, 9);
+
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        auto k = keys(gen);
+        auto op = ops(gen);
+        if (op < 5)
+        {
+            auto v = std::to_string(i);
+            auto res = map.emplace(k, v);
+            auto refRes = ref.emplace(k, v);
+            REQUIRE(res.second == refRes.second);
+            REQUIRE(res.first->second == refRes.first->second);
+        }
+        else if (op < 8)
+        {
+            REQUIRE(map.erase(k) == ref.erase(k));
+        }
+        else if (op < 9)
+        {
+            auto it = map.find(k);
+            auto refIt = ref.find(k);
+            REQUIRE((it == map.end()) == (refIt == ref.end()));
+            if (it != map.end())
+            {
+                it->second += "x";
+                refIt->second += "x";
+            }
+        }
+        else
+        {
+            REQUIRE(map.count(k) == ref.count(k));
+        }
+    }
+    checkSame(map, ref);
+
+    auto copy = map;
+    checkSame(copy, ref);
+    copy.clear();
+    REQUIRE(copy.empty());
+    REQUIRE(copy.begin() == copy.end());
+    checkSame(map, ref);
+
+    copy.swap(map);
+    REQUIRE(map.empty());
+    checkSame(copy, ref);
+}
+}
+
+TEST_CASE("FlatHashMap matches std::unordered_map", "[flathashmap]")
+{
+    SECTION("well distributed hashes")
+    {
+        randomOps<FlatHashMap<int, std::string, std::hash<int>>>(2000);
+    }
+    SECTION("colliding hashes")
+    {
+        randomOps<FlatHashMap<int, std::string, CollidingHash>>(300);
+    }
+}
+
+TEST_CASE("FlatHashMap reserve and erase", "[flathashmap]")
+{
+    FlatHashMap<int, int, std::hash<int>> map;
+    map.reserve(1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(map.emplace(i, i).second);
+    }
+
+    // Erase through iterators while walking the map
+    for (auto it = map.begin(); it != map.end();)
+    {
+        if (it->first % 2 == 0)
+        {
+            map.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    REQUIRE(map.size() == 500);
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(map.count(i) == static_cast<size_t>(i % 2));
+    }
+
+    // Reinserting reuses erased slots
+    for (int i = 0; i < 1000; i += 2)
+    {
+        REQUIRE(map.emplace(i, -i).second);
+    }
+    REQUIRE(map.size() == 1000);
+    REQUIRE(map.find(10)->second == -10);
+    REQUIRE(map.find(11)->second == 11);
+}
+
+TEST_CASE("FlatHashMap moves its keys when growing", "[flathashmap]")
+{
+    FlatHashMap<CountedKey, int, CountedKeyHash> map;
+    CountedKey::copies = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(map.emplace(CountedKey(i), i).second);
+    }
+    REQUIRE(CountedKey::copies == 0);
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(map.find(CountedKey(i))->second == i);
+    }
+
+    auto copy = map;
+    REQUIRE(CountedKey::copies == 1000);
+    REQUIRE(copy.size() == 1000);
+}
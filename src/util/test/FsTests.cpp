@@ -43,6 +43,35 @@ TEST_CASE("filesystem durable rename", "[fs]")
     REQUIRE(fs::exists(fileB.string()));
 }
 
+TEST_CASE("filesystem deferred durable rename", "[fs]")
+{
+    stdfs::path fileB;
+    {
+        TmpDir tmp("fstests");
+        stdfs::path root(tmp.getName());
+        stdfs::path fileA = root / "fileA.txt";
+        fileB = root / "fileB.txt";
+        {
+            std::ofstream out(fileA.string());
+            out << "hi";
+        }
+        REQUIRE(fs::deferredDurableRename(fileA.string(), fileB.string(),
+                                          root.string()));
+        REQUIRE(!fs::exists(fileA.string()));
+        REQUIRE(fs::exists(fileB.string()));
+        REQUIRE(!fs::deferredDurableRename(fileA.string(), fileB.string(),
+                                           root.string()));
+        fs::syncDeferredRenames();
+        fs::syncDeferredRenames();
+
+        // A directory removed before it is synced is skipped
+        REQUIRE(fs::deferredDurableRename(fileB.string(), fileA.string(),
+                                          root.string()));
+    }
+    REQUIRE(!fs::exists(fileB.parent_path().string()));
+    fs::syncDeferredRenames();
+}
+
 TEST_CASE("filesystem findfiles", "[fs]")
 {
     TmpDir tmp("fstests");
@@ -63,6 +92,41 @@ TEST_CASE("filesystem findfiles", "[fs]")
     REQUIRE(files == std::vector<std::string>{docFile.filename().string()});
 }
 
+TEST_CASE("filesystem page cache", "[fs]")
+{
+    TmpDir tmp("fstests");
+    stdfs::path file = stdfs::path(tmp.getName()) / "file.bin";
+    size_t const size = 100000;
+    {
+        std::ofstream out(file.string(), std::ios::binary);
+        out << std::string(size, 'x');
+    }
+
+    auto residency = fs::getPageCacheResidency(file.string());
+    if (residency.empty())
+    {
+        // Not supported on this platform
+        REQUIRE(fs::dropFromPageCache(file.string()) == 0);
+        return;
+    }
+    REQUIRE(residency.size() > 1);
+    std::vector<bool> keepAll(residency.size(), true);
+    REQUIRE(fs::dropFromPageCache(file.string(), keepAll) == 0);
+    REQUIRE(fs::dropFromPageCache(file.string()) == size);
+
+    // Keeping the first page drops the rest
+    std::vector<bool> keepFirst{true};
+    auto dropped = fs::dropFromPageCache(file.string(), keepFirst);
+    REQUIRE(dropped > 0);
+    REQUIRE(dropped < size);
+
+    REQUIRE(fs::getPageCacheResidency((stdfs::path(tmp.getName()) / "none")
+                                          .string())
+                .empty());
+    REQUIRE(fs::dropFromPageCache(
+                (stdfs::path(tmp.getName()) / "none").string()) == 0);
+}
+
 TEST_CASE("filesystem remoteName", "[fs]")
 {
     REQUIRE(fs::remoteName(HISTORY_FILE_TYPE_LEDGER, fs::hexStr(0x0abbccdd),
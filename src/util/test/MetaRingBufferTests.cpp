@@ -0,0 +1,68 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/Hex.h"
+#include "crypto/Random.h"
+#include "ledger/test/LedgerTestUtils.h"
+#include "lib/catch.hpp"
+#include "test/test.h"
+#include "util/MetaRingBuffer.h"
+#include "util/TmpDir.h"
+#include "util/XDRStream.h"
+
+#include <fstream>
+
+using namespace stellar;
+
+#ifndef _WIN32
+TEST_CASE("meta ring buffer", "[metaringbuffer]")
+{
+    TmpDirManager tdm(std::string("ringtmp-") + binToHex(randomBytes(8)));
+    TmpDir td = tdm.tmpDir("ring");
+    std::string path = td.getName() + "/meta.ring";
+
+    std::vector<char> buf;
+    SECTION("records round trip as the buffer wraps")
+    {
+        auto entries = LedgerTestUtils::generateValidLedgerEntries(50);
+        size_t largest = 0;
+        for (auto const& le : entries)
+        {
+            largest = std::max(
+                largest, XDROutputFileStream::serializeRecord(le, buf));
+        }
+        // Room for a couple of records, so most of them wrap at some point
+        MetaRingBufferWriter writer(path, 2 * largest + 1);
+        MetaRingBufferReader reader(path);
+        REQUIRE(reader.capacity() == writer.capacity());
+
+        LedgerEntry read;
+        REQUIRE(!reader.readOne(read));
+        for (auto const& le : entries)
+        {
+            auto size = XDROutputFileStream::serializeRecord(le, buf);
+            writer.writeSerialized(buf.data(), size);
+            REQUIRE(reader.readOne(read));
+            REQUIRE(read == le);
+            REQUIRE(!reader.readOne(read));
+        }
+    }
+
+    SECTION("oversized record throws")
+    {
+        MetaRingBufferWriter writer(path, 16);
+        auto le = LedgerTestUtils::generateValidLedgerEntry();
+        auto size = XDROutputFileStream::serializeRecord(le, buf);
+        REQUIRE(size > 16);
+        REQUIRE_THROWS_AS(writer.writeSerialized(buf.data(), size),
+                          std::runtime_error);
+    }
+
+    SECTION("reader rejects other files")
+    {
+        std::ofstream(path) << std::string(4096, 'x');
+        REQUIRE_THROWS_AS(MetaRingBufferReader(path), std::runtime_error);
+    }
+}
+#endif
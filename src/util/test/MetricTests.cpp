@@ -5,11 +5,14 @@
 #include "lib/catch.hpp"
 #include "lib/util/stdrandom.h"
 #include "medida/histogram.h"
+#include "medida/metrics_registry.h"
 #include "medida/stats/ckms_sample.h"
 #include "medida/stats/sliding_window_sample.h"
 #include "medida/stats/snapshot.h"
 #include "util/Logging.h"
 #include "util/Math.h"
+#include "util/PrometheusReporter.h"
+#include "util/ShardedCounter.h"
 #include <deque>
 #include <fmt/format.h>
 #include <iostream>
@@ -648,3 +651,49 @@ TEST_CASE("CKMSSample gamma distribution", "[medida_math]")
     testCKMSSample<gamma_dbl>(10000, 4, 100);
     testCKMSSample<gamma_dbl>(20000, 20, 20);
 }
+
+TEST_CASE("sharded counter", "[metrics]")
+{
+    stellar::ShardedCounter counter;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 20; ++i)
+    {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 1000; ++j)
+            {
+                counter.add(2);
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    REQUIRE(counter.flush() == 40000);
+    REQUIRE(counter.flush() == 0);
+}
+
+TEST_CASE("prometheus exposition", "[metrics]")
+{
+    medida::MetricsRegistry registry;
+    registry.NewCounter({"ledger", "memory", "queued-ledgers"}).set_count(3);
+    registry.NewMeter({"overlay", "byte", "read"}, "byte").Mark(42);
+    registry.NewTimer({"ledger", "ledger", "close"})
+        .Update(std::chrono::milliseconds(500));
+
+    auto const& all = registry.GetAllMetrics();
+    stellar::MetricsSnapshot metrics(all.begin(), all.end());
+    auto text = stellar::PrometheusReporter().report(metrics);
+
+    REQUIRE(text.find("# TYPE stellar_core_ledger_memory_queued_ledgers "
+                      "gauge\nstellar_core_ledger_memory_queued_ledgers 3\n") !=
+            std::string::npos);
+    REQUIRE(text.find("stellar_core_overlay_byte_read_total 42\n") !=
+            std::string::npos);
+    REQUIRE(text.find("# TYPE stellar_core_ledger_ledger_close summary\n") !=
+            std::string::npos);
+    REQUIRE(text.find("stellar_core_ledger_ledger_close_sum 0.5\n") !=
+            std::string::npos);
+    REQUIRE(text.find("stellar_core_ledger_ledger_close_count 1\n") !=
+            std::string::npos);
+}
@@ -0,0 +1,99 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "util/ParallelFor.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace stellar;
+
+namespace
+{
+// Runs helpers on threads of their own, joined by the destructor
+struct ThreadPoster
+{
+    std::vector<std::thread> threads;
+
+    std::function<void(std::function<void()>&&)>
+    poster()
+    {
+        return [this](std::function<void()>&& f) {
+            threads.emplace_back(std::move(f));
+        };
+    }
+
+    ~ThreadPoster()
+    {
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+};
+}
+
+TEST_CASE("parallelForBatches covers every item once", "[parallelfor]")
+{
+    size_t const n = 1000;
+    size_t const maxHelpers = 3;
+    // Catch assertions are not thread safe, so helpers only record
+    std::vector<std::atomic<int>> calls(n);
+    std::atomic<bool> badBatch{false};
+    ThreadPoster poster;
+    parallelForBatches(n, 7, maxHelpers, poster.poster(),
+                       [&](size_t worker, size_t begin, size_t end) {
+                           if (worker > maxHelpers || end - begin > 7)
+                           {
+                               badBatch = true;
+                           }
+                           for (auto i = begin; i < end; ++i)
+                           {
+                               ++calls[i];
+                           }
+                       });
+    REQUIRE(!badBatch);
+    for (auto const& c : calls)
+    {
+        REQUIRE(c == 1);
+    }
+    REQUIRE(poster.threads.size() == maxHelpers);
+}
+
+TEST_CASE("parallelForBatches runs small inputs inline", "[parallelfor]")
+{
+    ThreadPoster poster;
+    size_t calls = 0;
+    parallelForBatches(0, 4, 3, poster.poster(),
+                       [&](size_t, size_t, size_t) { ++calls; });
+    parallelForBatches(4, 4, 3, poster.poster(),
+                       [&](size_t worker, size_t begin, size_t end) {
+                           REQUIRE(worker == 0);
+                           REQUIRE(begin == 0);
+                           REQUIRE(end == 4);
+                           ++calls;
+                       });
+    REQUIRE(calls == 1);
+    REQUIRE(poster.threads.empty());
+}
+
+TEST_CASE("parallelForBatches rethrows after every batch is done",
+          "[parallelfor]")
+{
+    std::atomic<size_t> done{0};
+    ThreadPoster poster;
+    REQUIRE_THROWS_AS(parallelForBatches(100, 1, 2, poster.poster(),
+                                         [&](size_t, size_t i, size_t) {
+                                             ++done;
+                                             if (i == 10)
+                                             {
+                                                 throw std::runtime_error(
+                                                     "batch failed");
+                                             }
+                                         }),
+                      std::runtime_error);
+    REQUIRE(done == 100);
+}
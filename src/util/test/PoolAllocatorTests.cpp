@@ -0,0 +1,85 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "util/PoolAllocator.h"
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace stellar;
+
+namespace
+{
+// Sized so that no other type in this test shares its free list
+struct PoolTestEntry
+{
+    std::array<uint8_t, 136> data;
+};
+}
+
+TEST_CASE("PoolAllocator recycles single allocations", "[poolallocator]")
+{
+    PoolAllocator<PoolTestEntry> alloc;
+    std::vector<PoolTestEntry*> ptrs;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        ptrs.emplace_back(alloc.allocate(1));
+    }
+    auto baseline = PoolAllocator<PoolTestEntry>::freeBlocks();
+    for (auto p : ptrs)
+    {
+        alloc.deallocate(p, 1);
+    }
+    REQUIRE(PoolAllocator<PoolTestEntry>::freeBlocks() == baseline + 100);
+
+    // Freed blocks are handed out again before new memory is requested
+    auto p = alloc.allocate(1);
+    REQUIRE(std::find(ptrs.begin(), ptrs.end(), p) != ptrs.end());
+    REQUIRE(PoolAllocator<PoolTestEntry>::freeBlocks() == baseline + 99);
+    alloc.deallocate(p, 1);
+
+    SECTION("array allocations bypass the pool")
+    {
+        auto arr = alloc.allocate(4);
+        REQUIRE(PoolAllocator<PoolTestEntry>::freeBlocks() == baseline + 100);
+        alloc.deallocate(arr, 4);
+        REQUIRE(PoolAllocator<PoolTestEntry>::freeBlocks() == baseline + 100);
+    }
+
+    SECTION("blocks freed on another thread are cached there")
+    {
+        auto q = alloc.allocate(1);
+        size_t otherThreadBlocks = 0;
+        std::thread t([&]() {
+            PoolAllocator<PoolTestEntry>().deallocate(q, 1);
+            otherThreadBlocks = PoolAllocator<PoolTestEntry>::freeBlocks();
+        });
+        t.join();
+        REQUIRE(otherThreadBlocks == 1);
+        REQUIRE(PoolAllocator<PoolTestEntry>::freeBlocks() == baseline + 99);
+    }
+}
+
+TEST_CASE("PoolAllocator backs a node-based map", "[poolallocator]")
+{
+    using Map = std::unordered_map<
+        int, PoolTestEntry, std::hash<int>, std::equal_to<int>,
+        PoolAllocator<std::pair<int const, PoolTestEntry>>>;
+
+    Map m;
+    for (int i = 0; i < 1000; ++i)
+    {
+        m[i].data.fill(static_cast<uint8_t>(i));
+    }
+    auto copy = m;
+    m.clear();
+    REQUIRE(copy.size() == 1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(copy.at(i).data[0] == static_cast<uint8_t>(i));
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/SamplingProfiler.h"
+
+#include "lib/catch.hpp"
+#include "util/Tracing.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using namespace stellar;
+
+namespace
+{
+void
+samplingProfilerTestSpin(std::chrono::milliseconds duration)
+{
+    ZoneNamedN(spinZone, "sampling profiler test spin", true);
+    auto end = std::chrono::steady_clock::now() + duration;
+    volatile uint64_t n = 0;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        n = n + 1;
+    }
+}
+}
+
+TEST_CASE("sampling profiler subsystems", "[profile]")
+{
+    REQUIRE(SamplingProfiler::subsystemOf("ledger/LedgerManagerImpl.cpp") ==
+            "ledger");
+    REQUIRE(SamplingProfiler::subsystemOf(
+                "/build/stellar-core/src/overlay/Peer.cpp") == "overlay");
+    REQUIRE(SamplingProfiler::subsystemOf("src/util/test/TimerTests.cpp") ==
+            "util");
+    REQUIRE(SamplingProfiler::subsystemOf("main.cpp") == "other");
+}
+
+#ifdef __linux__
+TEST_CASE("sampling profiler attributes CPU to zones", "[profile]")
+{
+    if (!SpanRecorder::isAvailable())
+    {
+        return;
+    }
+
+    SamplingProfiler profiler(std::chrono::milliseconds(2));
+    std::thread([]() {
+        SpanRecorder::setThreadName("profile-test");
+        samplingProfilerTestSpin(std::chrono::milliseconds(300));
+    }).join();
+    profiler.stop();
+
+    auto report = profiler.report();
+    REQUIRE(!report.mRunning);
+    REQUIRE(report.mSamples > 0);
+
+    auto zone = std::find_if(
+        report.mZones.begin(), report.mZones.end(), [](auto const& usage) {
+            return usage.mZone && usage.mZone->mName &&
+                   std::strcmp(usage.mZone->mName,
+                               "sampling profiler test spin") == 0;
+        });
+    REQUIRE(zone != report.mZones.end());
+    REQUIRE(zone->mCpuNs > 0);
+    REQUIRE(report.mCpuNsByThread["profile-test"] >= zone->mCpuNs);
+    REQUIRE(report.mCpuNsBySubsystem["util"] >= zone->mCpuNs);
+
+    // Stopping keeps the profile as it was
+    auto samples = report.mSamples;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(profiler.report().mSamples == samples);
+}
+#endif
@@ -8,6 +8,10 @@
 #include "util/Logging.h"
 #include "util/Timer.h"
 #include <chrono>
+#include <medida/counter.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
 
 using namespace stellar;
 
@@ -125,3 +129,94 @@ TEST_CASE("scheduler load shedding -- overload", "[scheduler]")
                sched.stats().mActionsDroppedDueToOverload;
     CHECK(sched.stats().mActionsEnqueued == tot);
 }
+
+TEST_CASE("scheduler reports per-queue metrics", "[scheduler]")
+{
+    std::chrono::microseconds window(100);
+    VirtualClock clock;
+    Scheduler sched(clock, window);
+    medida::MetricsRegistry metrics;
+
+    std::string TX("TX flood"), SCP("SCP");
+    auto microsleep = [&] { clock.sleep_for(std::chrono::microseconds(1)); };
+
+    // Queued before metrics are attached still counts
+    sched.enqueue(std::string(SCP), microsleep,
+                  Scheduler::ActionType::NORMAL_ACTION);
+    sched.setMetrics(&metrics);
+    auto& scpDepth = metrics.NewCounter({"scheduler", "queue-depth", "scp"});
+    auto& txDepth =
+        metrics.NewCounter({"scheduler", "queue-depth", "tx-flood"});
+    CHECK(scpDepth.count() == 1);
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        sched.enqueue(std::string(TX), microsleep,
+                      Scheduler::ActionType::DROPPABLE_ACTION);
+        sched.enqueue(std::string(TX), microsleep,
+                      Scheduler::ActionType::DROPPABLE_ACTION);
+        sched.enqueue(std::string(SCP), microsleep,
+                      Scheduler::ActionType::NORMAL_ACTION);
+        sched.enqueue(std::string(SCP), microsleep,
+                      Scheduler::ActionType::NORMAL_ACTION);
+        sched.runOne();
+        sched.runOne();
+    }
+    CHECK(sched.getOverloadedDuration().count() != 0);
+    CHECK(scpDepth.count() == static_cast<int64_t>(sched.queueLength(SCP)));
+    CHECK(txDepth.count() ==
+          static_cast<int64_t>(sched.queueLength(
+              TX, Scheduler::ActionType::DROPPABLE_ACTION)));
+
+    // The depth survives a reset of the metrics
+    txDepth.clear();
+    sched.enqueue(std::string(TX), microsleep,
+                  Scheduler::ActionType::DROPPABLE_ACTION);
+    CHECK(txDepth.count() ==
+          static_cast<int64_t>(sched.queueLength(
+              TX, Scheduler::ActionType::DROPPABLE_ACTION)));
+
+    auto info = sched.getQueueInfo();
+    REQUIRE(info.size() == 2);
+    for (auto const& q : info)
+    {
+        CHECK(q.mSize == sched.queueLength(q.mName, q.mType));
+        CHECK(q.mTotalService == sched.totalService(q.mName, q.mType));
+    }
+
+    while (sched.size() != 0)
+    {
+        sched.runOne();
+    }
+    CHECK(scpDepth.count() == 0);
+    CHECK(txDepth.count() == 0);
+
+    auto const& stats = sched.stats();
+    auto& txDropped =
+        metrics.NewMeter({"scheduler", "dropped", "tx-flood"}, "action");
+    auto& scpDropped =
+        metrics.NewMeter({"scheduler", "dropped", "scp"}, "action");
+    CHECK(txDropped.count() > 0);
+    CHECK(scpDropped.count() == 0);
+    CHECK(txDropped.count() == stats.mActionsDroppedDueToOverload);
+
+    auto& txSojourn = metrics.NewTimer({"scheduler", "sojourn", "tx-flood"});
+    auto& scpSojourn = metrics.NewTimer({"scheduler", "sojourn", "scp"});
+    auto& scpRun = metrics.NewTimer({"scheduler", "run", "scp"});
+    CHECK(scpSojourn.count() == 601);
+    CHECK(scpRun.count() == 601);
+    CHECK(txSojourn.count() + scpSojourn.count() == stats.mActionsDequeued);
+
+    // Every overload has ended by now
+    CHECK(sched.getOverloadedDuration().count() == 0);
+    CHECK(stats.mOverloadTransitions > 0);
+    CHECK(metrics.NewMeter({"scheduler", "overload", "start"}, "event")
+              .count() == stats.mOverloadTransitions);
+    CHECK(metrics.NewTimer({"scheduler", "overload", "duration"}).count() ==
+          stats.mOverloadTransitions);
+
+    sched.setMetrics(nullptr);
+    sched.enqueue(std::string(SCP), microsleep,
+                  Scheduler::ActionType::NORMAL_ACTION);
+    CHECK(scpDepth.count() == 0);
+}
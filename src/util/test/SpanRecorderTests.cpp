@@ -0,0 +1,131 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/SpanRecorder.h"
+
+#include "lib/catch.hpp"
+#include "lib/json/json.h"
+#include "util/Tracing.h"
+#include <map>
+#include <string>
+#include <thread>
+
+using namespace stellar;
+
+namespace
+{
+void
+spanRecorderTestOuter()
+{
+    ZoneScoped;
+    ZoneNamedN(innerZone, "span recorder test inner", true);
+}
+
+Json::Value
+parseTrace(std::string const& trace)
+{
+    Json::Value root;
+    Json::Reader reader;
+    REQUIRE(reader.parse(trace, root));
+    return root;
+}
+
+Json::Value
+dumpTrace()
+{
+    return parseTrace(SpanRecorder::dumpChromeTrace(std::chrono::seconds(60)));
+}
+
+// Spans of the test zones above, per thread name
+std::map<std::string, std::vector<Json::Value>>
+testSpansByThread(Json::Value const& root)
+{
+    std::map<Json::UInt64, std::string> threadNames;
+    for (auto const& e : root["traceEvents"])
+    {
+        if (e["ph"].asString() == "M")
+        {
+            threadNames[e["tid"].asUInt64()] = e["args"]["name"].asString();
+        }
+    }
+    std::map<std::string, std::vector<Json::Value>> res;
+    for (auto const& e : root["traceEvents"])
+    {
+        auto name = e["name"].asString();
+        if (e["ph"].asString() == "X" &&
+            (name == "spanRecorderTestOuter" ||
+             name == "span recorder test inner"))
+        {
+            res[threadNames.at(e["tid"].asUInt64())].emplace_back(e);
+        }
+    }
+    return res;
+}
+}
+
+TEST_CASE("span recorder", "[tracing]")
+{
+    if (!SpanRecorder::isAvailable())
+    {
+        return;
+    }
+
+    SECTION("records nothing until started")
+    {
+        SpanRecorder::stop();
+        spanRecorderTestOuter();
+        auto before = testSpansByThread(dumpTrace());
+        spanRecorderTestOuter();
+        REQUIRE(testSpansByThread(dumpTrace()) == before);
+    }
+
+    SECTION("records nested spans per thread")
+    {
+        SpanRecorder::start();
+        spanRecorderTestOuter();
+        std::thread([]() {
+            SpanRecorder::setThreadName("span-test");
+            spanRecorderTestOuter();
+            spanRecorderTestOuter();
+        }).join();
+        SpanRecorder::stop();
+
+        // The thread's buffer went away with it
+        auto spans = testSpansByThread(dumpTrace());
+        REQUIRE(spans.count("span-test") == 0);
+        REQUIRE(spans.count("main") == 1);
+        auto const& mainSpans = spans["main"];
+        REQUIRE(mainSpans.size() >= 2);
+
+        // Spans are written as they close: inner before outer
+        auto const& inner = mainSpans[mainSpans.size() - 2];
+        auto const& outer = mainSpans.back();
+        REQUIRE(inner["name"].asString() == "span recorder test inner");
+        REQUIRE(outer["name"].asString() == "spanRecorderTestOuter");
+        REQUIRE(inner["ts"].asDouble() >= outer["ts"].asDouble());
+        REQUIRE(inner["ts"].asDouble() + inner["dur"].asDouble() <=
+                outer["ts"].asDouble() + outer["dur"].asDouble());
+        REQUIRE(outer["args"]["file"].asString().find(
+                    "SpanRecorderTests.cpp") != std::string::npos);
+    }
+
+    SECTION("keeps the latest spans of a thread")
+    {
+        size_t const n = SpanRecorder::SPANS_PER_THREAD + 100;
+        std::string trace;
+        std::thread([&]() {
+            SpanRecorder::setThreadName("span-test");
+            SpanRecorder::start();
+            for (size_t i = 0; i < n; ++i)
+            {
+                ZoneNamedN(loopZone, "span recorder test inner", true);
+            }
+            SpanRecorder::stop();
+            trace = SpanRecorder::dumpChromeTrace(std::chrono::seconds(60));
+        }).join();
+
+        auto spans = testSpansByThread(parseTrace(trace));
+        REQUIRE(spans["span-test"].size() == SpanRecorder::SPANS_PER_THREAD);
+    }
+}
@@ -14,6 +14,7 @@
 #include "test/test.h"
 #include "util/Logging.h"
 #include <chrono>
+#include <random>
 
 using namespace stellar;
 
@@ -252,3 +253,152 @@ TEST_CASE("timer cancels", "[timer]")
     REQUIRE(timerFired == 8);
     REQUIRE(timerCancelled == 2);
 }
+
+namespace
+{
+struct TimerRecord
+{
+    size_t mTimer;
+    VirtualClock::time_point mExpiry;
+    bool mCancelled;
+
+    bool
+    operator==(TimerRecord const& other) const
+    {
+        return mTimer == other.mTimer && mExpiry == other.mExpiry &&
+               mCancelled == other.mCancelled;
+    }
+};
+
+// Arms and cancels timers at random, then lets them fire, re-arming and
+// cancelling more from their callbacks; returns what fired or was cancelled,
+// in order.
+//
+// Expiries are absolute, as the heap may move virtual time to that of a
+// cancelled event when idle. They are in nanoseconds so that no two timers
+// expire at the same time, which the backends may order differently.
+std::vector<TimerRecord>
+churnTimers(VirtualClock::TimerBackend backend, uint32_t seed)
+{
+    VirtualClock clock(VirtualClock::VIRTUAL_TIME, backend);
+    std::mt19937 rng(seed);
+    std::vector<TimerRecord> records;
+    std::vector<std::unique_ptr<VirtualTimer>> timers;
+    for (size_t i = 0; i < 50; ++i)
+    {
+        timers.emplace_back(std::make_unique<VirtualTimer>(clock));
+    }
+
+    std::function<void(size_t, VirtualClock::time_point)> arm =
+        [&](size_t i, VirtualClock::time_point from) {
+            // Up to 10s, or a year now and then
+            std::chrono::nanoseconds delay(1 + rng() % 10'000'000'000ULL);
+            if (rng() % 20 == 0)
+            {
+                delay *= 3'153'600;
+            }
+            auto expiry = from + delay;
+            timers[i]->expires_at(expiry);
+            timers[i]->async_wait([&, i, expiry](asio::error_code const& ec) {
+                records.emplace_back(TimerRecord{i, expiry, bool(ec)});
+                if (ec)
+                {
+                    return;
+                }
+                if (rng() % 4 == 0)
+                {
+                    timers[rng() % timers.size()]->cancel();
+                }
+                if (rng() % 2 == 0)
+                {
+                    arm(rng() % timers.size(), expiry);
+                }
+            });
+        };
+
+    for (size_t step = 0; step < 2000; ++step)
+    {
+        auto i = rng() % timers.size();
+        if (rng() % 4 == 0)
+        {
+            timers[i]->cancel();
+        }
+        else
+        {
+            arm(i, clock.now());
+        }
+    }
+    while (clock.crank(false) > 0)
+        ;
+    return records;
+}
+}
+
+TEST_CASE("timer wheel dispatches like the heap", "[timer]")
+{
+    for (uint32_t seed = 0; seed < 10; ++seed)
+    {
+        auto heap = churnTimers(VirtualClock::TIMER_HEAP, seed);
+        auto wheel = churnTimers(VirtualClock::TIMER_WHEEL, seed);
+        REQUIRE(heap.size() > 1000);
+        REQUIRE(heap == wheel);
+    }
+}
+
+TEST_CASE("timer backends under peer churn", "[timer][bench][!hide]")
+{
+    // Each peer has an idle, a straggler, a ping and a flow control timer;
+    // every message re-arms one of them
+    size_t const peers = 200;
+    size_t const timersPerPeer = 4;
+    size_t const messages = 2'000'000;
+    std::chrono::seconds const delays[timersPerPeer] = {
+        std::chrono::seconds(30), std::chrono::seconds(120),
+        std::chrono::seconds(5), std::chrono::seconds(1)};
+
+    for (auto backend : {VirtualClock::TIMER_HEAP, VirtualClock::TIMER_WHEEL})
+    {
+        VirtualClock clock(VirtualClock::VIRTUAL_TIME, backend);
+        std::vector<std::unique_ptr<VirtualTimer>> timers;
+        for (size_t i = 0; i < peers * timersPerPeer; ++i)
+        {
+            timers.emplace_back(std::make_unique<VirtualTimer>(clock));
+        }
+        std::mt19937 rng(1);
+        size_t fired = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t m = 0; m < messages; ++m)
+        {
+            auto i = rng() % timers.size();
+            timers[i]->expires_from_now(delays[i % timersPerPeer]);
+            timers[i]->async_wait([&](asio::error_code const& ec) {
+                if (!ec)
+                {
+                    ++fired;
+                }
+            });
+            // Some peers drop and reconnect
+            if (m % 1000 == 0)
+            {
+                auto peer = rng() % peers;
+                for (size_t t = 0; t < timersPerPeer; ++t)
+                {
+                    timers[peer * timersPerPeer + t]->cancel();
+                }
+            }
+            if (m % 100 == 0)
+            {
+                clock.sleep_for(std::chrono::milliseconds(1));
+                clock.crank(false);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        LOG_INFO(DEFAULT_LOG, "{}: {:.1f} ns per message, {} timers fired",
+                 backend == VirtualClock::TIMER_HEAP ? "heap" : "wheel",
+                 std::chrono::duration<double, std::nano>(elapsed).count() /
+                     messages,
+                 fired);
+    }
+}
@@ -0,0 +1,120 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/XDRMarshal.h"
+#include "crypto/SHA.h"
+#include "ledger/test/LedgerTestUtils.h"
+#include "lib/catch.hpp"
+#include "util/Logging.h"
+#include "util/Math.h"
+#include "xdr/Stellar-ledger-entries.h"
+
+#include <chrono>
+#include <limits>
+
+using namespace stellar;
+
+namespace
+{
+xdr::xvector<int64>
+randomInt64s(size_t n)
+{
+    xdr::xvector<int64> res;
+    for (size_t i = 0; i < n; ++i)
+    {
+        res.emplace_back(static_cast<int64>(rand_uniform<uint64_t>(
+            0, std::numeric_limits<uint64_t>::max())));
+    }
+    return res;
+}
+
+template <typename T>
+void
+checkSameEncoding(T const& t)
+{
+    auto expected = xdr::xdr_to_opaque(t);
+    REQUIRE(xdrToOpaque(t) == expected);
+    auto msg = xdrToMsg(t);
+    REQUIRE(msg->size() == expected.size());
+    REQUIRE(std::equal(expected.begin(), expected.end(), msg->data()));
+    REQUIRE(xdrSha256(t) == sha256(expected));
+}
+
+template <typename F>
+std::chrono::nanoseconds
+timeEncodes(size_t iterations, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        bytes += f().size();
+    }
+    REQUIRE(bytes != 0);
+    return std::chrono::steady_clock::now() - start;
+}
+}
+
+TEST_CASE("unchecked XDR encoding matches xdrpp", "[xdrmarshal]")
+{
+    SECTION("ledger entries")
+    {
+        for (auto const& le : LedgerTestUtils::generateValidLedgerEntries(200))
+        {
+            checkSameEncoding(le);
+        }
+    }
+
+    SECTION("integer containers")
+    {
+        for (size_t n : {0, 1, 7, 33, 1000})
+        {
+            checkSameEncoding(randomInt64s(n));
+        }
+
+        xdr::xarray<uint32, 5> words;
+        for (auto& w : words)
+        {
+            w = rand_uniform<uint32_t>(0, std::numeric_limits<uint32_t>::max());
+        }
+        checkSameEncoding(words);
+
+        ConfigSettingEntry window(CONFIG_SETTING_BUCKETLIST_SIZE_WINDOW);
+        for (auto v : randomInt64s(30))
+        {
+            window.bucketListSizeWindow().emplace_back(v);
+        }
+        checkSameEncoding(window);
+    }
+
+    SECTION("several values")
+    {
+        auto le = LedgerTestUtils::generateValidLedgerEntry();
+        REQUIRE(xdrToOpaque(uint32_t(7), le, randomInt64s(3)).size() ==
+                xdr::xdr_argpack_size(uint32_t(7), le, randomInt64s(3)));
+    }
+}
+
+TEST_CASE("unchecked XDR encoding bench", "[xdrmarshal][bench][!hide]")
+{
+    auto entries = LedgerTestUtils::generateValidLedgerEntries(1000);
+    auto ints = randomInt64s(1000);
+    size_t const iterations = 2000;
+
+    auto generic = timeEncodes(iterations, [&]() {
+        return xdr::xdr_to_opaque(entries[rand_uniform<size_t>(0, 999)]);
+    });
+    auto unchecked = timeEncodes(iterations, [&]() {
+        return xdrToOpaque(entries[rand_uniform<size_t>(0, 999)]);
+    });
+    LOG_INFO(DEFAULT_LOG, "ledger entries: xdrpp {} per entry, unchecked {}",
+             generic / iterations, unchecked / iterations);
+
+    generic =
+        timeEncodes(iterations, [&]() { return xdr::xdr_to_opaque(ints); });
+    unchecked = timeEncodes(iterations, [&]() { return xdrToOpaque(ints); });
+    LOG_INFO(DEFAULT_LOG,
+             "1000 int64s: xdrpp {} per vector, unchecked and bulk swapped {}",
+             generic / iterations, unchecked / iterations);
+}
@@ -11,6 +11,7 @@
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <cctype>
 #include <limits>
 #include <locale>
 
@@ -273,6 +274,29 @@ formatSize(size_t size)
     return fmt::format("{:.2f}{}", dsize, suffixes[i]);
 }
 
+std::string
+toMetricName(std::string const& name)
+{
+    std::string res;
+    for (char c : name)
+    {
+        if (std::isalnum(static_cast<unsigned char>(c)))
+        {
+            res.push_back(static_cast<char>(
+                std::tolower(static_cast<unsigned char>(c))));
+        }
+        else if (!res.empty() && res.back() != '-')
+        {
+            res.push_back('-');
+        }
+    }
+    while (!res.empty() && res.back() == '-')
+    {
+        res.pop_back();
+    }
+    return res.empty() ? "unnamed" : res;
+}
+
 bool
 addBalance(int64_t& balance, int64_t delta, int64_t maxBalance)
 {
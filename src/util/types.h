@@ -42,6 +42,10 @@ int64_t unsignedToSigned(uint64_t v);
 
 std::string formatSize(size_t size);
 
+// Turns a free-form name like "FutureBucket: merge" into one usable as part
+// of a metric name: lowercase words joined by dashes, as "futurebucket-merge".
+std::string toMetricName(std::string const& name);
+
 // returns true if the asset is well formed for the specified protocol version
 template <typename T> bool isAssetValid(T const& cur, uint32_t ledgerVersion);
 
@@ -10,6 +10,30 @@ XDRMatcher::XDRMatcher(std::string const& query) : mQuery(query)
 {
 }
 
+DiscriminantValues
+XDRMatcher::getPossibleValues(UnionFieldInfo const& unionField)
+{
+    return getEvalRoot().getPossibleValues(unionField);
+}
+
+BoolEvalNode const&
+XDRMatcher::getEvalRoot()
+{
+    // Lazily parse the query in order to simplify exception handling as we
+    // might throw XDRQueryError both during query parsing and query
+    // execution against XDR.
+    if (mEvalRoot == nullptr)
+    {
+        auto statement = parseXDRQuery(mQuery);
+        if (!std::holds_alternative<std::shared_ptr<BoolEvalNode>>(statement))
+        {
+            throw XDRQueryError("The query doesn't evaluate to bool.");
+        }
+        mEvalRoot = std::get<std::shared_ptr<BoolEvalNode>>(statement);
+    }
+    return *mEvalRoot;
+}
+
 XDRFieldExtractor::XDRFieldExtractor(std::string const& query) : mQuery(query)
 {
 }
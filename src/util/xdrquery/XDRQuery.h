@@ -42,27 +42,25 @@ class XDRMatcher
     bool
     matchXDR(T const& xdrMessage)
     {
-        // Lazily parse the query in order to simplify exception handling as we
-        // might throw XDRQueryError both during query parsing and query
-        // execution against XDR.
-        bool firstEval = false;
-        if (mEvalRoot == nullptr)
-        {
-            firstEval = true;
-            auto statement = parseXDRQuery(mQuery);
-            if (!std::holds_alternative<std::shared_ptr<BoolEvalNode>>(
-                    statement))
-            {
-                throw XDRQueryError("The query doesn't evaluate to bool.");
-            }
-            mEvalRoot = std::get<std::shared_ptr<BoolEvalNode>>(statement);
-        }
-        return mEvalRoot->evalBool(createFieldResolver(xdrMessage, firstEval));
+        // Field paths are validated against the first message only
+        bool firstEval = !mEvaluated;
+        mEvaluated = true;
+        return getEvalRoot().evalBool(
+            createFieldResolver(xdrMessage, firstEval));
     }
 
+    // Returns the values the discriminant of `unionField` may have in the
+    // messages that match the query, or std::nullopt if it may have any. This
+    // lets callers skip messages that can't match without evaluating the
+    // query, i.e. the ledger entries of other types.
+    DiscriminantValues getPossibleValues(UnionFieldInfo const& unionField);
+
   private:
+    BoolEvalNode const& getEvalRoot();
+
     std::string const mQuery;
     std::shared_ptr<BoolEvalNode> mEvalRoot;
+    bool mEvaluated{false};
 };
 
 // Helper to extract leaf fields from multiple XDR messages using the provided
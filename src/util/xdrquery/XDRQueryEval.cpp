@@ -6,6 +6,9 @@
 #include "fmt/format.h"
 #include "util/xdrquery/XDRQueryError.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace xdrquery
 {
 bool
@@ -174,6 +177,34 @@ BoolOpNode::getType() const
     return EvalNodeType();
 }
 
+DiscriminantValues
+BoolOpNode::getPossibleValues(UnionFieldInfo const& unionField) const
+{
+    auto left = mLeft->getPossibleValues(unionField);
+    auto right = mRight->getPossibleValues(unionField);
+    switch (mType)
+    {
+    case BoolOpNodeType::AND:
+    {
+        if (!left || !right)
+        {
+            return left ? left : right;
+        }
+        std::set<std::string> both;
+        std::set_intersection(left->begin(), left->end(), right->begin(),
+                              right->end(), std::inserter(both, both.end()));
+        return both;
+    }
+    case BoolOpNodeType::OR:
+        if (!left || !right)
+        {
+            return std::nullopt;
+        }
+        left->insert(right->begin(), right->end());
+        return left;
+    }
+}
+
 ComparisonNode::ComparisonNode(ComparisonNodeType nodeType,
                                std::shared_ptr<EvalNode> left,
                                std::shared_ptr<EvalNode> right)
@@ -273,6 +304,42 @@ ComparisonNode::getType() const
     return EvalNodeType::COMPARISON_OP;
 }
 
+DiscriminantValues
+ComparisonNode::getPossibleValues(UnionFieldInfo const& unionField) const
+{
+    // A field, if there is one, has been moved to the left
+    if (mLeft->getType() != EvalNodeType::FIELD)
+    {
+        return std::nullopt;
+    }
+    auto const& path = static_cast<FieldNode const*>(mLeft.get())->mFieldPath;
+    auto const& unionPath = unionField.mPath;
+    if (path.size() <= unionPath.size() ||
+        !std::equal(unionPath.begin(), unionPath.end(), path.begin()))
+    {
+        return std::nullopt;
+    }
+
+    auto const& next = path[unionPath.size()];
+    if (next == unionField.mDiscriminant)
+    {
+        // The discriminant is always set, so only `== 'VALUE'` narrows it
+        auto* lit = static_cast<LiteralNode const*>(mRight.get());
+        if (mType == ComparisonNodeType::EQ &&
+            mRight->getType() == EvalNodeType::LITERAL &&
+            lit->mType == LiteralNodeType::STR)
+        {
+            return std::set<std::string>{std::get<std::string>(*lit->mValue)};
+        }
+        return std::nullopt;
+    }
+    if (auto value = unionField.mArmValue(next))
+    {
+        return std::set<std::string>{*value};
+    }
+    return std::nullopt;
+}
+
 bool
 ComparisonNode::compareNullFields(bool leftIsNull, bool rightIsNull) const
 {
@@ -7,6 +7,7 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <variant>
@@ -47,6 +48,20 @@ using FieldResolver =
 
 std::string resultToString(ResultValueType const& result);
 
+// Describes a union in the queried XDR for static analysis of queries: the
+// path to the union field, the name of its discriminant, and a function
+// returning the name of the discriminant value that selects a union arm,
+// given the arm's field name (or std::nullopt if there is no such arm).
+struct UnionFieldInfo
+{
+    std::vector<std::string> mPath;
+    std::string mDiscriminant;
+    std::function<std::optional<std::string>(std::string const&)> mArmValue;
+};
+
+// Names of discriminant values; std::nullopt stands for every value.
+using DiscriminantValues = std::optional<std::set<std::string>>;
+
 enum class EvalNodeType
 {
     LITERAL,
@@ -108,6 +123,13 @@ struct BoolEvalNode : public EvalNode
     ResultType eval(FieldResolver const& fieldResolver) const override;
 
     virtual bool evalBool(FieldResolver const& fieldResolver) const = 0;
+
+    // Returns the values the discriminant of `unionField` may have in any
+    // message this node evaluates to `true` for. Comparisons are false when a
+    // field resolves to a union arm that is not selected, so a comparison of
+    // a field under an arm requires that arm.
+    virtual DiscriminantValues
+    getPossibleValues(UnionFieldInfo const& unionField) const = 0;
 };
 
 enum class BoolOpNodeType
@@ -126,6 +148,9 @@ struct BoolOpNode : public BoolEvalNode
 
     EvalNodeType getType() const override;
 
+    DiscriminantValues
+    getPossibleValues(UnionFieldInfo const& unionField) const override;
+
   private:
     BoolOpNodeType mType;
     std::shared_ptr<BoolEvalNode> mLeft;
@@ -152,6 +177,9 @@ struct ComparisonNode : public BoolEvalNode
 
     EvalNodeType getType() const override;
 
+    DiscriminantValues
+    getPossibleValues(UnionFieldInfo const& unionField) const override;
+
   private:
     bool compareNullFields(bool leftIsNull, bool rightIsNull) const;
 
@@ -452,6 +452,54 @@ TEST_CASE("XDR matcher", "[xdrquery]")
     }
 }
 
+TEST_CASE("XDR matcher possible union values", "[xdrquery]")
+{
+    UnionFieldInfo dataField{
+        {"data"}, "type", [](std::string const& arm) {
+            std::optional<std::string> value;
+            if (arm == "account")
+            {
+                value = "ACCOUNT";
+            }
+            else if (arm == "trustLine")
+            {
+                value = "TRUSTLINE";
+            }
+            return value;
+        }};
+    auto possibleValues = [&](std::string const& query) {
+        return XDRMatcher(query).getPossibleValues(dataField);
+    };
+    using Values = std::set<std::string>;
+
+    SECTION("discriminant comparison")
+    {
+        REQUIRE(possibleValues("data.type == 'OFFER'") == Values{"OFFER"});
+        REQUIRE(!possibleValues("data.type != 'OFFER'"));
+    }
+
+    SECTION("arm fields")
+    {
+        REQUIRE(possibleValues("data.account.balance > 0") ==
+                Values{"ACCOUNT"});
+        REQUIRE(possibleValues("data.account.balance > 0 || "
+                               "data.trustLine.balance > 0") ==
+                (Values{"ACCOUNT", "TRUSTLINE"}));
+        REQUIRE(possibleValues("data.account.balance > 0 && "
+                               "data.trustLine.balance > 0") == Values{});
+    }
+
+    SECTION("fields outside the union")
+    {
+        REQUIRE(!possibleValues("lastModifiedLedgerSeq > 1"));
+        REQUIRE(!possibleValues("data.account.balance > 0 || "
+                                "lastModifiedLedgerSeq > 1"));
+        REQUIRE(possibleValues("data.account.balance > 0 && "
+                               "lastModifiedLedgerSeq > 1") ==
+                Values{"ACCOUNT"});
+    }
+}
+
 TEST_CASE("XDR field extractor", "[xdrquery]")
 {
     std::vector<LedgerEntry> entries = {makeAccountEntry(100),
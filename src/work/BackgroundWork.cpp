@@ -0,0 +1,111 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "work/BackgroundWork.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/Tracing.h"
+
+namespace stellar
+{
+
+BackgroundWork::BackgroundWork(Application& app, std::string name,
+                               size_t maxRetries, BackgroundPriority priority)
+    : BasicWork(app, std::move(name), maxRetries), mPriority(priority)
+{
+}
+
+BasicWork::State
+BackgroundWork::onBackgroundStepDone(State result)
+{
+    return result;
+}
+
+BasicWork::State
+BackgroundWork::onRun()
+{
+    if (mResult)
+    {
+        auto result = *mResult;
+        mResult.reset();
+        return onBackgroundStepDone(result);
+    }
+
+    if (!mInFlight)
+    {
+        spawnStep();
+    }
+    return State::WORK_WAITING;
+}
+
+void
+BackgroundWork::spawnStep()
+{
+    std::weak_ptr<BackgroundWork> weak(
+        std::static_pointer_cast<BackgroundWork>(shared_from_this()));
+    auto step = [weak]() {
+        auto self = weak.lock();
+        if (!self)
+        {
+            return;
+        }
+
+        // No point in starting a step if things are shutting down
+        auto result = State::WORK_FAILURE;
+        if (!self->isAborting())
+        {
+            ZoneNamedN(stepZone, "background work step", true);
+            try
+            {
+                result = self->runInBackground();
+            }
+            catch (std::exception const& e)
+            {
+                CLOG_ERROR(Work, "{} failed: {}", self->getName(), e.what());
+                result = State::WORK_FAILURE;
+            }
+        }
+
+        // BasicWork's state is only touched from the main thread
+        self->mApp.postOnMainThread(
+            [weak, result]() {
+                auto self = weak.lock();
+                if (self)
+                {
+                    releaseAssert(self->mInFlight);
+                    releaseAssert(result == State::WORK_SUCCESS ||
+                                  result == State::WORK_FAILURE ||
+                                  result == State::WORK_RUNNING);
+                    self->mInFlight = false;
+                    self->mResult = result;
+                    self->wakeUpAndRun();
+                }
+            },
+            "BackgroundWork: finish");
+    };
+
+    mInFlight = true;
+    if (canRunInBackground())
+    {
+        mApp.postOnBackgroundThread(step, "BackgroundWork: step", mPriority);
+    }
+    else
+    {
+        mApp.postOnMainThread(step, "BackgroundWork: step");
+    }
+}
+
+bool
+BackgroundWork::onAbort()
+{
+    return !mInFlight;
+}
+
+void
+BackgroundWork::onReset()
+{
+    releaseAssert(!mInFlight);
+    mResult.reset();
+}
+}
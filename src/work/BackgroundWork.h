@@ -0,0 +1,70 @@
+// Copyright 2026 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+#pragma once
+
+#include "util/BackgroundPriority.h"
+#include "work/BasicWork.h"
+#include <optional>
+
+namespace stellar
+{
+
+/**
+ * BackgroundWork is a BasicWork whose `onRun` body runs on the background
+ * executor instead of the main thread, for CPU- or IO-heavy steps like hashing
+ * or decoding files.
+ *
+ * Each time the work is cranked, `runInBackground` is posted to a background
+ * thread and the work waits. Once the step returns, its result is handed to
+ * `onBackgroundStepDone` on the main thread, which decides the next state:
+ * WORK_RUNNING runs another step, and success and failure go through the
+ * usual BasicWork transitions, including retries.
+ *
+ * While a step runs, the main thread leaves the work alone: it is WAITING, and
+ * a shutdown keeps it ABORTING until the step has returned, so `onReset` never
+ * overlaps a step. Steps may therefore use the work's own members freely, but
+ * nothing else that the main thread owns. A long step can poll `isAborting` to
+ * stop early.
+ */
+class BackgroundWork : public BasicWork
+{
+    BackgroundPriority const mPriority;
+    bool mInFlight{false};
+    std::optional<State> mResult;
+
+    void spawnStep();
+
+  public:
+    BackgroundWork(Application& app, std::string name, size_t maxRetries,
+                   BackgroundPriority priority = BackgroundPriority::NORMAL);
+
+  protected:
+    // Runs one step on a background thread. Returns WORK_SUCCESS, WORK_FAILURE
+    // or WORK_RUNNING to have another step run. An exception counts as
+    // WORK_FAILURE.
+    virtual State runInBackground() = 0;
+
+    // Called on the main thread with the result of each step; may publish what
+    // the step produced and return a different state. Returns `result` by
+    // default.
+    virtual State onBackgroundStepDone(State result);
+
+    // Whether steps should run on a background thread at all. When this
+    // returns false, for example because the step needs a resource only the
+    // main thread may use in this configuration, steps are posted to the main
+    // thread instead, with the same semantics.
+    virtual bool
+    canRunInBackground() const
+    {
+        return true;
+    }
+
+    State onRun() final;
+
+    // Done aborting once no step is running. Implementers overriding
+    // `onAbort` or `onReset` must call these.
+    bool onAbort() override;
+    void onReset() override;
+};
+}
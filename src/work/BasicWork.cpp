@@ -6,7 +6,7 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -329,6 +329,29 @@ BasicWork::wakeUp(std::function<void()> innerCallback)
     }
 }
 
+void
+BasicWork::wakeUpAndRun()
+{
+    ZoneScoped;
+    if (mState != InternalState::WAITING)
+    {
+        return;
+    }
+
+    CLOG_TRACE(Work, "Waking up and running: {}", getName());
+    setState(InternalState::RUNNING);
+    resetWaitingTimer();
+
+    // The step may finish the work, wait again or schedule a retry; either
+    // way, the scheduler learns about the new state below
+    crankWork();
+
+    if (mNotifyCallback)
+    {
+        mNotifyCallback();
+    }
+}
+
 std::function<void()>
 BasicWork::wakeSelfUpCallback(std::function<void()> innerCallback)
 {
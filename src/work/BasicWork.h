@@ -91,12 +91,14 @@ class Application;
  * _batches_
  *  - WorkSequence: BasicWork that allows sequential execution of children
  * works.
+ *  - BackgroundWork: BasicWork whose steps run on a background thread.
  *
  * BasicWork is _not_ thread-safe, and therefore should not be used by threads.
  * The only acceptable use case if when we need to spawn an independent work in
  * the background (read from a file, download a file, etc), and post back to the
- * main thread at the end, so Work can finish. In this case, only const
- * functions querying Work's state are thread-safe.
+ * main thread at the end, so Work can finish; BackgroundWork does this for its
+ * subclasses. In this case, only const functions querying Work's state are
+ * thread-safe.
  */
 
 class BasicWork : public std::enable_shared_from_this<BasicWork>,
@@ -198,6 +200,15 @@ class BasicWork : public std::enable_shared_from_this<BasicWork>,
     // process to exit, with a call to `wakeUp` upon completion.
     virtual void wakeUp(std::function<void()> innerCallback = nullptr);
 
+    // Like `wakeUp`, but also runs the work's next step right away instead of
+    // waiting for the scheduler to reach it on a later crank. Meant for
+    // completion handlers of asynchronous operations (a process exiting, a
+    // download or a background job finishing) that already run on the main
+    // thread: the step that consumes the result runs in the same callback.
+    // Abort and retry behave exactly as with `wakeUp`: a work that is no
+    // longer WAITING, e.g. because it is aborting, is left alone.
+    void wakeUpAndRun();
+
     // Default wakeUp callback that implementers can use
     std::function<void()>
     wakeSelfUpCallback(std::function<void()> innerCallback = nullptr);
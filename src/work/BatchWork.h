@@ -41,5 +41,9 @@ class BatchWork : public Work
     virtual bool hasNext() const = 0;
     virtual std::shared_ptr<BasicWork> yieldMoreWork() = 0;
     virtual void resetIter() = 0;
+
+    // Number of children to run at once, MAX_CONCURRENT_SUBPROCESSES unless
+    // the implementer knows better
+    virtual size_t getBatchWidth() const;
 };
 }
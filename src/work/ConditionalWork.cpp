@@ -4,7 +4,7 @@
 
 #include "ConditionalWork.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Tracing.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -4,8 +4,8 @@
 
 #include "WorkSequence.h"
 #include "util/GlobalChecks.h"
+#include "util/Tracing.h"
 #include "work/Work.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -11,9 +11,13 @@
 #include <fmt/format.h>
 
 #include "historywork/RunCommandWork.h"
+#include "work/BackgroundWork.h"
 #include "work/BatchWork.h"
 #include "work/ConditionalWork.h"
 
+#include <future>
+#include <mutex>
+#include <set>
 #include <thread>
 
 using namespace stellar;
@@ -1024,3 +1028,273 @@ TEST_CASE("ConditionalWork test", "[work]")
         REQUIRE(testBatch->getState() == TestBasicWork::State::WORK_SUCCESS);
     }
 }
+
+class TestBackgroundWork : public BackgroundWork
+{
+    size_t const mNumSteps;
+    size_t mCount;
+
+  public:
+    std::mutex mMutex;
+    std::set<std::thread::id> mStepThreads;
+    std::set<std::thread::id> mDoneThreads;
+    size_t mStepCount{0};
+    size_t mRetryCount{0};
+    bool mFailOnce{false};
+    bool mThrow{false};
+    std::atomic<bool> mStarted{false};
+    std::shared_future<void> mBlocker;
+
+    TestBackgroundWork(Application& app, std::string name, size_t steps = 3,
+                       size_t retries = BasicWork::RETRY_ONCE)
+        : BackgroundWork(app, std::move(name), retries)
+        , mNumSteps(steps)
+        , mCount(steps)
+    {
+    }
+
+  protected:
+    State
+    runInBackground() override
+    {
+        mStarted = true;
+        if (mBlocker.valid())
+        {
+            mBlocker.wait();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStepThreads.emplace(std::this_thread::get_id());
+        }
+        ++mStepCount;
+        if (mThrow)
+        {
+            throw std::runtime_error("step failed");
+        }
+        if (mFailOnce)
+        {
+            mFailOnce = false;
+            return State::WORK_FAILURE;
+        }
+        return --mCount > 0 ? State::WORK_RUNNING : State::WORK_SUCCESS;
+    }
+
+    State
+    onBackgroundStepDone(State result) override
+    {
+        mDoneThreads.emplace(std::this_thread::get_id());
+        return result;
+    }
+
+    void
+    onFailureRetry() override
+    {
+        ++mRetryCount;
+    }
+
+    void
+    onReset() override
+    {
+        BackgroundWork::onReset();
+        mCount = mNumSteps;
+    }
+};
+
+TEST_CASE("BackgroundWork test", "[work][backgroundwork]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer appPtr = createTestApplication(clock, cfg);
+    auto& wm = appPtr->getWorkScheduler();
+    auto mainThread = std::this_thread::get_id();
+
+    SECTION("steps run in the background")
+    {
+        auto w = wm.scheduleWork<TestBackgroundWork>("test-bg-work");
+        while (!wm.allChildrenDone())
+        {
+            clock.crank();
+        }
+        REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+        REQUIRE(w->mStepCount == 3);
+        REQUIRE(w->mStepThreads.count(mainThread) == 0);
+        REQUIRE(w->mDoneThreads == std::set<std::thread::id>{mainThread});
+    }
+    SECTION("failed step is retried")
+    {
+        auto w = wm.scheduleWork<TestBackgroundWork>("test-bg-work");
+        w->mFailOnce = true;
+        while (!wm.allChildrenDone())
+        {
+            clock.crank();
+        }
+        REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+        REQUIRE(w->mRetryCount == 1);
+        REQUIRE(w->mStepCount == 4);
+    }
+    SECTION("exception fails the work")
+    {
+        auto w = wm.scheduleWork<TestBackgroundWork>(
+            "test-bg-work", 3, BasicWork::RETRY_NEVER);
+        w->mThrow = true;
+        while (!wm.allChildrenDone())
+        {
+            clock.crank();
+        }
+        REQUIRE(w->getState() == BasicWork::State::WORK_FAILURE);
+        REQUIRE(w->mStepCount == 1);
+    }
+    SECTION("shutdown waits for the running step")
+    {
+        std::promise<void> release;
+        auto w = wm.scheduleWork<TestBackgroundWork>("test-bg-work");
+        w->mBlocker = release.get_future().share();
+        while (!w->mStarted)
+        {
+            clock.crank(false);
+        }
+
+        wm.shutdown();
+        for (size_t i = 0; i < 10; ++i)
+        {
+            clock.crank(false);
+        }
+        REQUIRE(w->isAborting());
+
+        release.set_value();
+        while (wm.getState() != BasicWork::State::WORK_ABORTED)
+        {
+            clock.crank();
+        }
+        REQUIRE(w->getState() == BasicWork::State::WORK_ABORTED);
+        REQUIRE(w->mStepCount == 1);
+    }
+}
+
+class TestResumingWork : public BasicWork
+{
+    void
+    complete()
+    {
+        std::weak_ptr<TestResumingWork> weak(
+            std::static_pointer_cast<TestResumingWork>(shared_from_this()));
+        auto completion = [weak]() {
+            auto self = weak.lock();
+            if (self)
+            {
+                self->mInCompletion = true;
+                self->wakeUpAndRun();
+                self->mInCompletion = false;
+            }
+        };
+        if (mHoldCompletion)
+        {
+            mCompletion = completion;
+        }
+        else
+        {
+            mApp.postOnMainThread(completion, "TestResumingWork: complete");
+        }
+    }
+
+  public:
+    size_t mStepCount{0};
+    size_t mResumedCount{0};
+    size_t mRetryCount{0};
+    bool mFailOnce{false};
+    bool mInCompletion{false};
+    bool mHoldCompletion{false};
+    std::function<void()> mCompletion;
+
+    TestResumingWork(Application& app, std::string name)
+        : BasicWork(app, std::move(name), BasicWork::RETRY_ONCE)
+    {
+    }
+
+  protected:
+    State
+    onRun() override
+    {
+        ++mStepCount;
+        if (mInCompletion)
+        {
+            ++mResumedCount;
+            if (mFailOnce)
+            {
+                mFailOnce = false;
+                return State::WORK_FAILURE;
+            }
+            if (mResumedCount % 2 == 0)
+            {
+                return State::WORK_SUCCESS;
+            }
+        }
+        complete();
+        return State::WORK_WAITING;
+    }
+
+    bool
+    onAbort() override
+    {
+        return true;
+    }
+
+    void
+    onFailureRetry() override
+    {
+        ++mRetryCount;
+    }
+};
+
+TEST_CASE("wakeUpAndRun test", "[work][basicwork]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer appPtr = createTestApplication(clock, cfg);
+    auto& wm = appPtr->getWorkScheduler();
+
+    SECTION("steps run from the completion handler")
+    {
+        auto w = wm.scheduleWork<TestResumingWork>("test-resuming-work");
+        while (!wm.allChildrenDone())
+        {
+            clock.crank();
+        }
+        REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+        REQUIRE(w->mStepCount == 3);
+        REQUIRE(w->mResumedCount == 2);
+    }
+    SECTION("failed step is retried")
+    {
+        auto w = wm.scheduleWork<TestResumingWork>("test-resuming-work");
+        w->mFailOnce = true;
+        while (!wm.allChildrenDone())
+        {
+            clock.crank();
+        }
+        REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+        REQUIRE(w->mRetryCount == 1);
+        REQUIRE(w->mStepCount == 4);
+        REQUIRE(w->mResumedCount == 2);
+    }
+    SECTION("aborting work is not resumed")
+    {
+        auto w = wm.scheduleWork<TestResumingWork>("test-resuming-work");
+        w->mHoldCompletion = true;
+        while (!w->mCompletion)
+        {
+            clock.crank();
+        }
+        wm.shutdown();
+        while (wm.getState() != BasicWork::State::WORK_ABORTED)
+        {
+            clock.crank();
+        }
+
+        // The operation completes after the work was aborted
+        w->mCompletion();
+        REQUIRE(w->getState() == BasicWork::State::WORK_ABORTED);
+        REQUIRE(w->mStepCount == 1);
+        REQUIRE(w->mResumedCount == 0);
+    }
+}